@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2018 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "PothosUtil.hpp"
@@ -74,7 +74,7 @@ protected:
             .argument("pluginPath", false/*optional*/)
             .callback(Poco::Util::OptionCallback<PothosUtil>(this, &PothosUtil::printPluginTree)));
 
-        options.addOption(Poco::Util::Option("proxy-server", "", "run the proxy server, tcp://bindHost:bindPort")
+        options.addOption(Poco::Util::Option("proxy-server", "", "run the proxy server, tcp://bindHost:bindPort or unix:///path")
             .required(false)
             .repeatable(false)
             .argument("URI", false/*optional*/)
@@ -86,6 +86,22 @@ protected:
             .argument("modulePath")
             .callback(Poco::Util::OptionCallback<PothosUtil>(this, &PothosUtil::loadModule)));
 
+        options.addOption(Poco::Util::Option("probe-modules", "",
+            "Test load the library modules listed on stdin, one path per line.\n"
+            "The modules are loaded in order, and each result is printed.")
+            .required(false)
+            .repeatable(false)
+            .callback(Poco::Util::OptionCallback<PothosUtil>(this, &PothosUtil::probeModules)));
+
+        options.addOption(Poco::Util::Option("startup-profile", "",
+            "Initialize the library and print the wall time of each step:\n"
+            "the module loads, static blocks, conf files, event handlers,\n"
+            "managed class commits, and safe load probes.\n"
+            "Set POTHOS_STARTUP_PROFILE to profile the init of other applications.")
+            .required(false)
+            .repeatable(false)
+            .callback(Poco::Util::OptionCallback<PothosUtil>(this, &PothosUtil::startupProfile)));
+
         options.addOption(Poco::Util::Option("run-topology", "", "run a topology from a JSON description")
             .required(false)
             .repeatable(false)
@@ -108,6 +124,26 @@ protected:
             .argument("idleTime")
             .binding("idleTime"));
 
+        options.addOption(Poco::Util::Option("run-to-completion", "",
+            "Run the topology as an offline batch job until its sources end.\n"
+            "The topology runs with spinning threads and large buffers, "
+            "and exits once the data of the sources has drained through the design. "
+            "Use this option with --run-duration to specify a timeout for the job. "
+            "PothosUtil will return an error code if the timeout is reached before completion.")
+            .required(false)
+            .repeatable(false)
+            .binding("runToCompletion"));
+
+        options.addOption(Poco::Util::Option("monitor", "",
+            "Print a live view of the topology once per period.\n"
+            "Use with --run-topology, the optional period defaults to 1 second. "
+            "Blocks are sorted by utilization (work time over wall time), "
+            "with the throughput and queue of each port and the top stall reason.")
+            .required(false)
+            .repeatable(false)
+            .argument("monitorPeriod", false/*optional*/)
+            .binding("monitorPeriod"));
+
         options.addOption(Poco::Util::Option("var", "",
             "Specify an arbitrary keyword + value variable\n"
             "using the format --var=name:value\n"
@@ -137,6 +173,35 @@ protected:
             .validator(new Poco::Util::IntValidator(1, 255))
             .binding("numTrials"));
 
+        options.addOption(Poco::Util::Option("jobs", "j", "how many self tests to run in parallel (default 1)")
+            .required(false)
+            .repeatable(false)
+            .argument("numJobs")
+            .validator(new Poco::Util::IntValidator(1, 1024))
+            .binding("numJobs"));
+
+        options.addOption(Poco::Util::Option("bench", "", "run all plugin micro-benchmarks")
+            .required(false)
+            .repeatable(false)
+            .argument("pluginPath", false/*optional*/)
+            .callback(Poco::Util::OptionCallback<PothosUtil>(this, &PothosUtil::benchmarks)));
+
+        options.addOption(Poco::Util::Option("bench-topology", "",
+            "Run a sweep of synthetic topologies to characterize the scheduler.\n"
+            "Specify an optional sweep: all, chain, fanout, buffer, threads, yield, affinity, or mode.")
+            .required(false)
+            .repeatable(false)
+            .argument("sweep", false/*optional*/)
+            .callback(Poco::Util::OptionCallback<PothosUtil>(this, &PothosUtil::benchTopology)));
+
+        options.addOption(Poco::Util::Option("bench-time", "",
+            "The minimum duration of each benchmark in seconds.\n"
+            "Use with --bench-topology for the duration of each sweep point.")
+            .required(false)
+            .repeatable(false)
+            .argument("benchTime")
+            .binding("benchTime"));
+
         options.addOption(Poco::Util::Option("success-code", "", "the success status return code (default 0)")
             .required(false)
             .repeatable(false)
@@ -149,9 +214,20 @@ protected:
             .repeatable(false)
             .binding("requireActive"));
 
+        options.addOption(Poco::Util::Option("server-pool", "",
+            "Keep a number of spawned proxy servers ready to hand out.\n"
+            "Use with --proxy-server, see Pothos/RemoteServerPool spawn().")
+            .required(false)
+            .repeatable(false)
+            .argument("serverPool")
+            .validator(new Poco::Util::IntValidator(1, 1024))
+            .binding("serverPool"));
+
         options.addOption(Poco::Util::Option("output", "",
             "Specify an output file (used by various options)\n"
-            "Use with --run-topology to dump JSON statistics.")
+            "Use with --run-topology to dump JSON statistics.\n"
+            "Use with --bench and --bench-topology to dump JSON benchmark results.\n"
+            "Use with --self-tests to dump the test times, as a JUnit report for a .xml file or JSON otherwise.")
             .required(false)
             .repeatable(false)
             .argument("outputFile")
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2018 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #pragma once
@@ -18,8 +18,12 @@ public:
     void printPluginTree(const std::string &, const std::string &);
     void selfTests(const std::string &, const std::string &);
     void selfTestOne(const std::string &, const std::string &);
+    void benchmarks(const std::string &, const std::string &);
+    void benchTopology(const std::string &, const std::string &);
     void proxyServer(const std::string &, const std::string &);
     void loadModule(const std::string &, const std::string &);
+    void probeModules(const std::string &, const std::string &);
+    void startupProfile(const std::string &, const std::string &);
     void runTopology(void);
     void docParse(const std::vector<std::string> &);
     void listModules(const std::string &, const std::string &);
@@ -0,0 +1,247 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PothosUtil.hpp"
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Exception.hpp>
+#include <Poco/Path.h>
+#include <Poco/Format.h>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <utility> //pair
+#include <algorithm> //min/find
+#include <json.hpp>
+
+using json = nlohmann::json;
+
+/***********************************************************************
+ * One point in the topology benchmark sweep
+ **********************************************************************/
+struct TopologyBenchConfig
+{
+    TopologyBenchConfig(void):
+        chainLength(2),
+        fanOut(1),
+        bufferBytes(8192),
+        packetMode(false)
+    {
+        return;
+    }
+
+    size_t chainLength;
+    size_t fanOut;
+    size_t bufferBytes;
+    bool packetMode;
+    Pothos::ThreadPoolArgs threadPoolArgs;
+};
+
+static json configToJSON(const TopologyBenchConfig &config)
+{
+    json configObj;
+    configObj["chainLength"] = config.chainLength;
+    configObj["fanOut"] = config.fanOut;
+    configObj["bufferBytes"] = config.bufferBytes;
+    configObj["packetMode"] = config.packetMode;
+    configObj["numThreads"] = config.threadPoolArgs.numThreads;
+    configObj["yieldMode"] = config.threadPoolArgs.yieldMode;
+    configObj["affinityMode"] = config.threadPoolArgs.affinityMode;
+    configObj["affinity"] = config.threadPoolArgs.affinity;
+    return configObj;
+}
+
+/***********************************************************************
+ * Run a synthetic topology and measure the rates and latency:
+ * source -> [fan-out] -> chain of forwarders (per branch) -> [fan-in] -> sink
+ **********************************************************************/
+static json runTopologyBench(const TopologyBenchConfig &config, const double duration)
+{
+    Pothos::Topology topology;
+    topology.setThreadPool(Pothos::ThreadPool(config.threadPoolArgs));
+
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", config.bufferBytes, config.packetMode);
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+    std::vector<Pothos::Proxy> blocks;
+
+    const bool fanning = config.fanOut > 1;
+    Pothos::Proxy fanOut, fanIn;
+    if (fanning)
+    {
+        fanOut = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), config.fanOut);
+        fanIn = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", config.fanOut, size_t(1));
+        topology.connect(source, 0, fanOut, 0);
+        topology.connect(fanIn, 0, sink, 0);
+    }
+
+    for (size_t branch = 0; branch < config.fanOut; branch++)
+    {
+        auto last = fanning?fanOut:source;
+        size_t lastPort = fanning?branch:0;
+        for (size_t i = 0; i < config.chainLength; i++)
+        {
+            blocks.push_back(Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1)));
+            topology.connect(last, lastPort, blocks.back(), 0);
+            last = blocks.back();
+            lastPort = 0;
+        }
+        if (fanning) topology.connect(last, lastPort, fanIn, branch);
+        else topology.connect(last, lastPort, sink, 0);
+    }
+    const size_t numHops = config.chainLength + (fanning?3:1);
+
+    //warm up, then measure the counters over the duration
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(long(std::min(duration/4, 0.2)*1000)));
+    sink.call("resetLatency");
+    const unsigned long long sourceBuffers0 = source.call("getNumBuffers");
+    const unsigned long long sinkBytes0 = sink.call("getNumBytes");
+    const auto t0 = std::chrono::high_resolution_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(long(duration*1000)));
+    const unsigned long long sourceBuffers1 = source.call("getNumBuffers");
+    const unsigned long long sinkBytes1 = sink.call("getNumBytes");
+    const auto t1 = std::chrono::high_resolution_clock::now();
+    const double elapsed = std::chrono::duration<double>(t1-t0).count();
+
+    json resultObj;
+    resultObj["config"] = configToJSON(config);
+    resultObj["seconds"] = elapsed;
+    resultObj["numHops"] = numHops;
+    resultObj["buffersPerSec"] = double(sourceBuffers1-sourceBuffers0)/elapsed;
+    resultObj["bytesPerSec"] = double(sinkBytes1-sinkBytes0)/elapsed;
+
+    //the end-to-end latency is split evenly across the hops
+    json latencyObj;
+    const unsigned long long latencyCount = sink.call("getLatencyCount");
+    latencyObj["count"] = latencyCount;
+    static const std::vector<std::pair<std::string, double>> percentiles{
+        {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p999", 99.9}};
+    for (const auto &percentile : percentiles)
+    {
+        const unsigned long long latencyNs = sink.call("getLatency", percentile.second);
+        latencyObj[percentile.first] = double(latencyNs)/numHops;
+    }
+    resultObj["hopLatencyNs"] = latencyObj;
+
+    topology.disconnectAll();
+    topology.commit();
+    return resultObj;
+}
+
+/***********************************************************************
+ * Sweep each parameter in turn around the baseline configuration
+ **********************************************************************/
+static std::vector<TopologyBenchConfig> makeSweep(const std::string &sweep)
+{
+    static const std::vector<std::string> sweeps{"chain", "fanout", "buffer", "threads", "yield", "affinity", "mode"};
+    if (not sweep.empty() and sweep != "all" and std::find(sweeps.begin(), sweeps.end(), sweep) == sweeps.end())
+    {
+        throw Pothos::InvalidArgumentException("PothosUtil --bench-topology", "unknown sweep " + sweep +
+            ", expected all, chain, fanout, buffer, threads, yield, affinity, or mode");
+    }
+    const auto enabled = [&sweep](const std::string &name){return sweep.empty() or sweep == "all" or sweep == name;};
+
+    const TopologyBenchConfig baseline;
+    std::vector<TopologyBenchConfig> configs;
+    if (enabled("chain")) for (const size_t chainLength : {0, 1, 2, 4, 8, 16})
+    {
+        auto config = baseline;
+        config.chainLength = chainLength;
+        configs.push_back(config);
+    }
+    if (enabled("fanout")) for (const size_t fanOut : {1, 2, 4, 8})
+    {
+        auto config = baseline;
+        config.fanOut = fanOut;
+        configs.push_back(config);
+    }
+    if (enabled("buffer")) for (const size_t bufferBytes : {512, 4096, 32768, 262144})
+    {
+        auto config = baseline;
+        config.bufferBytes = bufferBytes;
+        configs.push_back(config);
+    }
+    if (enabled("threads")) for (const size_t numThreads : {0, 1, 2, 4})
+    {
+        auto config = baseline;
+        config.threadPoolArgs.numThreads = numThreads;
+        configs.push_back(config);
+    }
+    if (enabled("yield")) for (const auto &yieldMode : {"CONDITION", "HYBRID", "SPIN"})
+    {
+        auto config = baseline;
+        config.threadPoolArgs.yieldMode = yieldMode;
+        configs.push_back(config);
+    }
+    if (enabled("affinity"))
+    {
+        auto config = baseline;
+        config.threadPoolArgs.affinityMode = "ALL";
+        configs.push_back(config);
+        config.threadPoolArgs.affinityMode = "CPU";
+        config.threadPoolArgs.affinity = {0};
+        configs.push_back(config);
+        config.threadPoolArgs.affinityMode = "NUMA";
+        config.threadPoolArgs.affinity = {0};
+        configs.push_back(config);
+    }
+    if (enabled("mode")) for (const bool packetMode : {false, true})
+    {
+        auto config = baseline;
+        config.packetMode = packetMode;
+        configs.push_back(config);
+    }
+    return configs;
+}
+
+void PothosUtilBase::benchTopology(const std::string &, const std::string &sweep)
+{
+    Pothos::ScopedInit init;
+
+    const auto duration = this->config().getDouble("benchTime", 1.0);
+    if (duration <= 0.0) throw Pothos::InvalidArgumentException(
+        "PothosUtil::benchTopology()", "--bench-time must be positive");
+
+    json results(json::array());
+    for (const auto &config : makeSweep(sweep))
+    {
+        std::cout << "Benchmark topology " << configToJSON(config).dump() << "... " << std::flush;
+        try
+        {
+            const auto resultObj = runTopologyBench(config, duration);
+            std::cout << Poco::format("%.0f buffers/s, %.3f GB/s, %.0f ns/hop (p50)",
+                resultObj["buffersPerSec"].get<double>(),
+                resultObj["bytesPerSec"].get<double>()/1e9,
+                resultObj["hopLatencyNs"]["p50"].get<double>()) << std::endl;
+            results.push_back(resultObj);
+        }
+        catch (const Pothos::Exception &ex)
+        {
+            //unsupported configurations such as NUMA affinity are reported and skipped
+            std::cout << "FAIL: " << ex.displayText() << std::endl;
+            json resultObj;
+            resultObj["config"] = configToJSON(config);
+            resultObj["error"] = ex.displayText();
+            results.push_back(resultObj);
+        }
+    }
+    std::cout << std::endl;
+
+    //dump the results to file if specified, otherwise to stdout
+    json topObj;
+    topObj["topologyBenchmarks"] = results;
+    if (this->config().has("outputFile"))
+    {
+        const auto resultsFile = this->config().getString("outputFile");
+        std::cout << ">>> Dumping results: " << resultsFile << std::endl;
+        std::ofstream ofs(Poco::Path::expand(resultsFile));
+        ofs << topObj.dump(4) << std::endl;
+    }
+    else
+    {
+        std::cout << topObj.dump(4) << std::endl;
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "PothosUtil.hpp"
+#include <Pothos/Benchmark.hpp>
+#include <Pothos/Exception.hpp>
+#include <Poco/Path.h>
+#include <Poco/Glob.h>
+#include <Poco/Format.h>
+#include <fstream>
+#include <iostream>
+#include <json.hpp>
+
+using json = nlohmann::json;
+
+static void runPluginBenchmarksR(const Pothos::PluginPath &path, Poco::Glob &glob, const double minTime, json &results)
+{
+    //run the benchmark found at path
+    if (not Pothos::PluginRegistry::empty(path) and glob.match(path.toString()))
+    {
+        auto plugin = Pothos::PluginRegistry::get(path);
+        if (plugin.getObject().type() == typeid(std::shared_ptr<Pothos::BenchmarkBase>))
+        {
+            std::cout << "Benchmark " << path.toString() << "... " << std::flush;
+            auto bench = plugin.getObject().extract<std::shared_ptr<Pothos::BenchmarkBase>>();
+            const auto result = bench->run(minTime);
+
+            std::cout << Poco::format("%.1f ns/op", result.nsPerOp);
+            if (result.bytesPerSecond > 0.0) std::cout << Poco::format(", %.3f GB/s", result.bytesPerSecond/1e9);
+            std::cout << " (" << result.iterations << " iterations)" << std::endl;
+
+            json resultObj;
+            resultObj["name"] = path.toString();
+            resultObj["iterations"] = result.iterations;
+            resultObj["seconds"] = result.seconds;
+            resultObj["nsPerOp"] = result.nsPerOp;
+            resultObj["gbPerSec"] = result.bytesPerSecond/1e9;
+            results.push_back(resultObj);
+        }
+    }
+
+    //iterate on the subtree stuff
+    for (const auto &node : Pothos::PluginRegistry::list(path))
+    {
+        runPluginBenchmarksR(path.join(node), glob, minTime, results);
+    }
+}
+
+void PothosUtilBase::benchmarks(const std::string &, const std::string &path)
+{
+    Pothos::ScopedInit init;
+
+    const auto minTime = this->config().getDouble("benchTime", 0.5);
+    if (minTime <= 0.0) throw Pothos::InvalidArgumentException(
+        "PothosUtil::benchmarks()", "--bench-time must be positive");
+
+    json results(json::array());
+    if (path.find('*') == std::string::npos)
+    {
+        Poco::Glob glob("*"); //not globing, match all
+        runPluginBenchmarksR(path.empty()? "/" : path, glob, minTime, results);
+    }
+    else
+    {
+        Poco::Glob glob(path); //path is a glob rule
+        runPluginBenchmarksR("/", glob, minTime, results);
+    }
+    std::cout << std::endl;
+    std::cout << "Ran " << results.size() << " benchmarks" << std::endl;
+
+    //dump the results to file if specified, otherwise to stdout
+    json topObj;
+    topObj["benchmarks"] = results;
+    if (this->config().has("outputFile"))
+    {
+        const auto resultsFile = this->config().getString("outputFile");
+        std::cout << ">>> Dumping results: " << resultsFile << std::endl;
+        std::ofstream ofs(Poco::Path::expand(resultsFile));
+        ofs << topObj.dump(4) << std::endl;
+    }
+    else
+    {
+        std::cout << topObj.dump(4) << std::endl;
+    }
+    std::cout << std::endl;
+}
@@ -1,10 +1,15 @@
-// Copyright (c) 2013-2015 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "PothosUtil.hpp"
+#include <Pothos/Init.hpp>
 #include <Pothos/Plugin/Module.hpp>
+#include <Pothos/Exception.hpp>
+#include <Poco/Environment.h>
 #include <iostream>
 #include <cstdlib>
+#include <string>
+#include <vector>
 
 //remove outer quotes if they exist
 static std::string unquote(const std::string &s)
@@ -25,3 +30,42 @@ void PothosUtilBase::loadModule(const std::string &, const std::string &path)
     }
     std::cout << "success!" << std::endl;
 }
+
+void PothosUtilBase::probeModules(const std::string &, const std::string &)
+{
+    //read the whole list first, so the writer never blocks on a full pipe
+    std::vector<std::string> paths;
+    std::string path;
+    while (std::getline(std::cin, path))
+    {
+        if (not path.empty() and path.back() == '\r') path.pop_back();
+        if (not path.empty()) paths.push_back(path);
+    }
+
+    //the parent reads each result as it happens, a crash ends the output
+    //after the "Loading" line of the module that caused the crash
+    for (const auto &modulePath : paths)
+    {
+        std::cout << "Loading: " << modulePath << std::endl;
+        try
+        {
+            Pothos::PluginModule module(modulePath);
+        }
+        catch (const Pothos::Exception &)
+        {
+            std::cout << "Failure: " << modulePath << std::endl;
+            continue;
+        }
+        std::cout << "Success: " << modulePath << std::endl;
+    }
+}
+
+void PothosUtilBase::startupProfile(const std::string &, const std::string &)
+{
+    //the report prints when the init completes, see POTHOS_STARTUP_PROFILE
+    if (not Poco::Environment::has("POTHOS_STARTUP_PROFILE"))
+    {
+        Poco::Environment::set("POTHOS_STARTUP_PROFILE", "stdout");
+    }
+    Pothos::ScopedInit init;
+}
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "PothosUtil.hpp"
@@ -6,11 +6,12 @@
 #include <Pothos/Remote.hpp>
 #include <Pothos/Util/Network.hpp>
 #include <Poco/Net/ServerSocket.h>
-#include <Poco/Net/SocketStream.h>
 #include <Poco/Net/TCPServer.h>
 #include <Poco/Process.h>
+#include <Poco/File.h>
 #include <Poco/URI.h>
 #include <mutex>
+#include <string>
 #include <cassert>
 #include <iostream>
 
@@ -20,16 +21,35 @@
  *  - monitor connection start and stop
  *  - kill process in require active mode
  **********************************************************************/
+struct MySocketOptions
+{
+    MySocketOptions(void):
+        isLocal(false),
+        sendBufferSize(0),
+        recvBufferSize(0),
+        streamBufferSize(65536)
+    {
+        return;
+    }
+    bool isLocal; //a unix domain socket
+    int sendBufferSize; //zero for the system default
+    int recvBufferSize; //zero for the system default
+    size_t streamBufferSize;
+};
+
 class MyTCPServerConnectionFactory : public Poco::Net::TCPServerConnectionFactory
 {
 public:
-    MyTCPServerConnectionFactory(const bool requireActive):
+    MyTCPServerConnectionFactory(const bool requireActive, const MySocketOptions &opts):
+        opts(opts),
         _numConnections(0),
         _requireActive(requireActive)
     {
         return;
     }
 
+    const MySocketOptions opts;
+
     Poco::Net::TCPServerConnection *createConnection(const Poco::Net::StreamSocket &socket);
 
     void connectionStart(void)
@@ -67,7 +87,7 @@ public:
     MyTCPServerConnection(MyTCPServerConnectionFactory &factory, const Poco::Net::StreamSocket &socket):
         Poco::Net::TCPServerConnection(socket),
         _factory(factory),
-        _handler(Pothos::RemoteHandler(socket.peerAddress().host().toString()))
+        _handler(Pothos::RemoteHandler(factory.opts.isLocal?"127.0.0.1":socket.peerAddress().host().toString()))
     {
         _factory.connectionStart();
     }
@@ -79,8 +99,12 @@ public:
 
     void run(void)
     {
-        this->socket().setNoDelay(true);
-        Poco::Net::SocketStream socketStream(this->socket());
+        const auto &opts = _factory.opts;
+        if (not opts.isLocal) this->socket().setNoDelay(true);
+        if (opts.sendBufferSize != 0) this->socket().setSendBufferSize(opts.sendBufferSize);
+        if (opts.recvBufferSize != 0) this->socket().setReceiveBufferSize(opts.recvBufferSize);
+        Pothos::RemoteSocketStream socketStream(
+            Pothos::RemoteSocketStream::NativeSocket(this->socket().impl()->sockfd()), opts.streamBufferSize);
         _handler.runHandler(socketStream, socketStream);
     }
 
@@ -123,23 +147,64 @@ void PothosUtilBase::proxyServer(const std::string &, const std::string &uriStr)
     Poco::URI uri(uriStr.empty()?defaultUri:uriStr);
     const std::string &host = uri.getHost();
     const std::string &port = std::to_string(uri.getPort());
+    MySocketOptions opts;
+    opts.isLocal = uri.getScheme() == "unix";
+    #ifdef POCO_OS_FAMILY_UNIX
+    if (uri.getScheme() != "tcp" and not opts.isLocal)
+    #else
     if (uri.getScheme() != "tcp")
+    #endif
     {
         throw Pothos::Exception("PothosUtil::proxyServer("+uriStr+")", "unsupported URI scheme");
     }
 
-    //create server socket
-    Poco::Net::SocketAddress sa(host, port);
+    //the socket options from the URI query
+    for (const auto &param : uri.getQueryParameters())
+    {
+        int value(-1);
+        try {value = std::stoi(param.second);}
+        catch (const std::exception &){}
+        if (value < 0) throw Pothos::Exception("PothosUtil::proxyServer("+uriStr+")", param.first+" = "+param.second);
+        if (param.first == "sendBufferSize") opts.sendBufferSize = value;
+        else if (param.first == "recvBufferSize") opts.recvBufferSize = value;
+        else if (param.first == "streamBufferSize") opts.streamBufferSize = size_t(value);
+        else throw Pothos::Exception("PothosUtil::proxyServer("+uriStr+")", "unknown URI option "+param.first);
+    }
+
+    //create server socket, a unix domain socket replaces a stale socket file
+    Poco::Net::SocketAddress sa;
+    #ifdef POCO_OS_FAMILY_UNIX
+    if (opts.isLocal)
+    {
+        Poco::File socketFile(uri.getPath());
+        if (socketFile.exists()) socketFile.remove();
+        sa = Poco::Net::SocketAddress(Poco::Net::SocketAddress::UNIX_LOCAL, uri.getPath());
+    }
+    else
+    #endif
+    sa = Poco::Net::SocketAddress(host, port);
     Poco::Net::ServerSocket serverSocket(sa);
     Poco::Net::TCPServerConnectionFactory::Ptr factory;
-    factory = new MyTCPServerConnectionFactory(this->config().hasOption("requireActive"));
+    factory = new MyTCPServerConnectionFactory(this->config().hasOption("requireActive"), opts);
     Poco::Net::TCPServer tcpServer(factory, serverSocket);
 
+    //keep a pool of servers ready for clients of this resident server
+    if (this->config().hasOption("serverPool"))
+    {
+        const auto poolUri = "tcp://"+Pothos::Util::getWildcardAddr();
+        Pothos::RemoteServerPool::setDefault(Pothos::RemoteServerPool(poolUri, this->config().getUInt("serverPool")));
+    }
+
     //start the server
     tcpServer.start();
-    std::cout << "Host: " << serverSocket.address().host().toString() << std::endl;
-    std::cout << "Port: " << serverSocket.address().port() << std::endl;
+    if (opts.isLocal) std::cout << "Path: " << uri.getPath() << std::endl;
+    else
+    {
+        std::cout << "Host: " << serverSocket.address().host().toString() << std::endl;
+        std::cout << "Port: " << serverSocket.address().port() << std::endl;
+    }
 
     //wait here until the term signal is received
     this->waitForTerminationRequest();
+    Pothos::RemoteServerPool::setDefault(Pothos::RemoteServerPool());
 }
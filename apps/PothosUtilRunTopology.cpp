@@ -1,17 +1,188 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "PothosUtil.hpp"
 #include <Pothos/Framework.hpp>
 #include <Pothos/Exception.hpp>
 #include <Poco/Path.h>
+#include <condition_variable>
+#include <algorithm> //sort
 #include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <thread>
+#include <mutex>
 #include <iostream>
+#include <cstdio> //fileno
 #include <json.hpp>
 
+#ifdef _MSC_VER
+#include <io.h>
+#define isatty _isatty
+#else
+#include <unistd.h> //isatty
+#endif
+
 using json = nlohmann::json;
 
+/***********************************************************************
+ * Live monitor prints deltas of the work stats once per period
+ **********************************************************************/
+static unsigned long long counterDelta(const json &stats0, const json &stats1, const std::string &key)
+{
+    const auto v0 = stats0.value<unsigned long long>(key, 0);
+    const auto v1 = stats1.value<unsigned long long>(key, 0);
+    return (v1 > v0)?(v1 - v0):0;
+}
+
+static std::string formatRate(const double rate)
+{
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(1);
+    if (rate >= 1e9) os << rate/1e9 << "G";
+    else if (rate >= 1e6) os << rate/1e6 << "M";
+    else if (rate >= 1e3) os << rate/1e3 << "k";
+    else os << rate;
+    return os.str();
+}
+
+struct MonitorRow
+{
+    double utilization;
+    std::string text;
+};
+
+static MonitorRow makeMonitorRow(const json &stats0, const json &stats1)
+{
+    const auto num = stats1.value<double>("tickRatioNum", 1.0);
+    const auto den = stats1.value<double>("tickRatioDen", 1e9);
+    const auto wallTicks = stats1.value<double>("timeStatsQuery", 0.0) - stats0.value<double>("timeStatsQuery", 0.0);
+    const auto wallTime = wallTicks*num/den;
+
+    MonitorRow row;
+    row.utilization = (wallTicks > 0.0)?std::min(counterDelta(stats0, stats1, "totalTimeWork")/wallTicks, 1.0):0.0;
+
+    //the most frequent stall reason over the period
+    static const std::vector<std::pair<std::string, std::string>> stallKeys{
+        {"stallPrepare", "prepare"},
+        {"stallNoTokens", "noTokens"},
+        {"stallMessagesFull", "messagesFull"},
+        {"stallNoOutputBuffer", "noOutputBuffer"},
+        {"stallReserve", "reserve"}};
+    std::string stallReason("-");
+    unsigned long long maxStalls(0);
+    for (const auto &stallKey : stallKeys)
+    {
+        const auto stalls = counterDelta(stats0, stats1, stallKey.first);
+        if (stalls <= maxStalls) continue;
+        maxStalls = stalls;
+        stallReason = stallKey.second;
+    }
+
+    std::ostringstream os;
+    os << std::left << std::setw(32) << stats1.value<std::string>("blockName", "")
+       << std::right << std::fixed << std::setprecision(1) << std::setw(7) << row.utilization*100 << "%"
+       << std::setw(12) << formatRate((wallTime > 0.0)?(counterDelta(stats0, stats1, "numWorkCalls")/wallTime):0.0)
+       << "  " << stallReason << "\n";
+
+    //one line per stream port with the rates and the input queue
+    for (const auto &direction : {"inputStats", "outputStats"})
+    {
+        if (stats1.count(direction) == 0 or stats0.count(direction) == 0) continue;
+        const auto &ports0 = stats0[direction];
+        const auto &ports1 = stats1[direction];
+        for (size_t i = 0; i < ports1.size() and i < ports0.size(); i++)
+        {
+            const auto elements = counterDelta(ports0[i], ports1[i], "totalElements");
+            const auto dtypeSize = ports1[i].value<double>("dtypeSize", 1.0);
+            const auto elemRate = (wallTime > 0.0)?(elements/wallTime):0.0;
+            os << "    " << std::left << std::setw(28)
+               << ((std::string(direction) == "inputStats")?"in ":"out ") + ports1[i].value<std::string>("portName", "")
+               << std::right << std::setw(20) << formatRate(elemRate) + " elem/s"
+               << std::setw(16) << formatRate(elemRate*dtypeSize) + "B/s";
+            if (ports1[i].count("enqueuedBytes") != 0)
+            {
+                os << std::setw(16) << formatRate(ports1[i].value<double>("enqueuedBytes", 0.0)) + "B queued";
+            }
+            os << "\n";
+        }
+    }
+    row.text = os.str();
+    return row;
+}
+
+class TopologyMonitor
+{
+public:
+    TopologyMonitor(Pothos::Topology &topology, const double period):
+        _topology(topology),
+        _period(std::chrono::nanoseconds((long long)(period*1e9))),
+        _clearScreen(isatty(fileno(stdout)) != 0),
+        _done(false)
+    {
+        _thread = std::thread(&TopologyMonitor::run, this);
+    }
+
+    ~TopologyMonitor(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done = true;
+        }
+        _cond.notify_one();
+        _thread.join();
+    }
+
+private:
+    void run(void)
+    {
+        try
+        {
+            this->monitorLoop();
+        }
+        catch (const Pothos::Exception &ex)
+        {
+            std::cerr << "Monitor stopped: " << ex.displayText() << std::endl;
+        }
+    }
+
+    void monitorLoop(void)
+    {
+        auto stats0 = json::parse(_topology.queryJSONStats());
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (not _cond.wait_for(lock, _period, [this]{return _done;}))
+        {
+            const auto stats1 = json::parse(_topology.queryJSONStats());
+            std::vector<MonitorRow> rows;
+            for (auto it = stats1.begin(); it != stats1.end(); ++it)
+            {
+                const auto it0 = stats0.find(it.key());
+                if (it0 != stats0.end()) rows.push_back(makeMonitorRow(*it0, it.value()));
+            }
+            std::stable_sort(rows.begin(), rows.end(), [](const MonitorRow &a, const MonitorRow &b)
+            {
+                return a.utilization > b.utilization;
+            });
+
+            std::ostringstream os;
+            if (_clearScreen) os << "\033[H\033[2J";
+            os << std::left << std::setw(32) << "BLOCK" << std::right << std::setw(8) << "CPU"
+               << std::setw(12) << "WORK/s" << "  STALL\n";
+            for (const auto &row : rows) os << row.text;
+            std::cout << os.str() << std::endl;
+            stats0 = stats1;
+        }
+    }
+
+    Pothos::Topology &_topology;
+    const std::chrono::nanoseconds _period;
+    const bool _clearScreen;
+    bool _done;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::thread _thread;
+};
+
 void PothosUtilBase::runTopology(void)
 {
     Pothos::ScopedInit init;
@@ -69,8 +240,35 @@ void PothosUtilBase::runTopology(void)
     std::cout << ">>> Create Topology: " << path << std::endl;
     auto topology = Pothos::Topology::make(topObj.dump());
 
+    //the monitor runs from the commit until the topology stops
+    std::unique_ptr<TopologyMonitor> monitor;
+    auto startMonitor = [&](void)
+    {
+        if (not this->config().has("monitorPeriod")) return;
+        const auto periodStr = this->config().getString("monitorPeriod");
+        const double period = periodStr.empty()?1.0:std::stod(periodStr);
+        if (period <= 0.0) throw Pothos::InvalidArgumentException("--monitor="+periodStr, "period must be positive");
+        monitor.reset(new TopologyMonitor(*topology, period));
+    };
+
     //commit the topology and wait for specified time for CTRL+C
-    if (this->config().has("idleTime"))
+    if (this->config().has("runToCompletion"))
+    {
+        double timeout = 0.0;
+        std::string timeoutMsg = "no timeout";
+        if (this->config().has("runDuration"))
+        {
+            timeout = this->config().getDouble("runDuration");
+            timeoutMsg = "timeout " + std::to_string(timeout) + " seconds";
+        }
+        std::cout << ">>> Running topology to completion with " << timeoutMsg << std::endl;
+        startMonitor();
+        if (not topology->runToCompletion(timeout))
+        {
+            throw Pothos::RuntimeException("Topology::runToCompletion() reached timeout");
+        }
+    }
+    else if (this->config().has("idleTime"))
     {
         const auto idleTime = this->config().getDouble("idleTime");
         double timeout = 0.0;
@@ -82,6 +280,7 @@ void PothosUtilBase::runTopology(void)
         }
         std::cout << ">>> Running topology until idle with " << timeoutMsg << std::endl;
         topology->commit();
+        startMonitor();
         if (not topology->waitInactive(idleTime, timeout))
         {
             throw Pothos::RuntimeException("Topology::waitInactive() reached timeout");
@@ -92,14 +291,17 @@ void PothosUtilBase::runTopology(void)
         const auto runDuration = this->config().getDouble("runDuration");
         std::cout << ">>> Running topology for " << runDuration << " seconds" << std::endl;
         topology->commit();
+        startMonitor();
         std::this_thread::sleep_for(std::chrono::milliseconds(long(runDuration*1000)));
     }
     else
     {
         std::cout << ">>> Running topology, press CTRL+C to exit" << std::endl;
         topology->commit();
+        startMonitor();
         this->waitForTerminationRequest();
     }
+    monitor.reset();
 
     //dump the stats to file if specified
     if (this->config().has("outputFile"))
@@ -11,22 +11,43 @@
 #include <Poco/PipeStream.h>
 #include <Poco/String.h>
 #include <Poco/Glob.h>
+#include <Poco/Path.h>
+#include <Poco/Format.h>
+#include <json.hpp>
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <vector>
 #include <future>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <ctime> //clock
+#include <cstdlib> //strtod
 #include <cctype>
 #include <algorithm> //max
 
-struct SelfTestResults
+using json = nlohmann::json;
+
+//the child process reports its cpu time on this line of the output
+static const std::string cpuTimeMarker("Self test cpu time: ");
+
+struct SelfTestResult
 {
-    std::vector<std::string> testsPassed;
-    std::vector<std::string> testsFailed;
+    SelfTestResult(void):
+        ok(false),
+        wallSeconds(0.0),
+        cpuSeconds(0.0){}
+    std::string path;
+    bool ok;
+    double wallSeconds;
+    double cpuSeconds;
+    std::string failure; //the output of the failed trials
 };
 
-static std::string collectVerbose(const Poco::Pipe &pipe)
+static std::vector<std::string> collectLines(const Poco::Pipe &pipe)
 {
-    size_t maxLen = 0;
     Poco::PipeInputStream is(pipe);
     std::vector<std::string> lines;
     try
@@ -40,11 +61,17 @@ static std::string collectVerbose(const Poco::Pipe &pipe)
                 line.pop_back();
             }
             if (line.empty()) continue;
-            maxLen = std::max(maxLen, line.length());
             lines.push_back(line);
         }
     }
     catch (...){}
+    return lines;
+}
+
+static std::string formatVerbose(const std::vector<std::string> &lines)
+{
+    size_t maxLen = 0;
+    for (const auto &line : lines) maxLen = std::max(maxLen, line.length());
     std::ostringstream ss;
     ss << " +-" << std::string(maxLen, '-') << "-+" << std::endl;
     for (const auto &line : lines)
@@ -56,14 +83,22 @@ static std::string collectVerbose(const Poco::Pipe &pipe)
     return ss.str();
 }
 
-static bool spawnSelfTestOneProcess(const std::string &path, size_t numTrials)
+static std::string formatTimes(const SelfTestResult &result)
+{
+    return Poco::format(" (wall %.3f s, cpu %.3f s)", result.wallSeconds, result.cpuSeconds);
+}
+
+static SelfTestResult spawnSelfTestOneProcess(const std::string &path, size_t numTrials, const bool progressive, std::mutex &printMutex)
 {
     const bool multipleTrials = (numTrials > 1);
     const int success = 200;
 
-    std::cout << "Testing " << path << "... ";
-    if(multipleTrials) std::cout << std::endl;
-    else std::cout << std::flush;
+    //parallel runs print the complete report of a test when it finishes
+    std::ostringstream report;
+    std::ostream &os = progressive?std::cout:report;
+    os << "Testing " << path << "... ";
+    if(multipleTrials) os << std::endl;
+    else os << std::flush;
 
     //create args
     Poco::Process::Args args;
@@ -74,59 +109,125 @@ static bool spawnSelfTestOneProcess(const std::string &path, size_t numTrials)
     args.push_back("--num-trials");
     args.push_back(std::to_string(numTrials));
 
-    std::vector<bool> okVec;
+    SelfTestResult result;
+    result.path = path;
 
     for(size_t trialNum = 0; trialNum < numTrials; ++trialNum)
     {
         //launch
+        const auto startTime = std::chrono::high_resolution_clock::now();
         Poco::Process::Env env;
         Poco::Pipe outPipe; //no fwd stdio
         Poco::ProcessHandle ph(Poco::Process::launch(
             Pothos::System::getPothosUtilExecutablePath(),
             args, nullptr, &outPipe, &outPipe, env));
 
-        std::future<std::string> verboseFuture(std::async(std::launch::async, &collectVerbose, outPipe));
+        std::future<std::vector<std::string>> linesFuture(std::async(std::launch::async, &collectLines, outPipe));
         const bool ok = (ph.wait() == success);
+        result.wallSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
         if(multipleTrials)
         {
-            std::cout << " * Trial " << (trialNum+1) << ": " << std::flush;
+            os << " * Trial " << (trialNum+1) << ": " << std::flush;
         }
-        std::cout << ((ok)? "success!" : "FAIL!") << std::endl;
+        os << ((ok)? "success!" : "FAIL!") << std::endl;
 
         outPipe.close();
-        verboseFuture.wait();
-        if (not ok) std::cout << verboseFuture.get();
+        const auto lines = linesFuture.get();
+        for (const auto &line : lines)
+        {
+            if (line.compare(0, cpuTimeMarker.size(), cpuTimeMarker) != 0) continue;
+            result.cpuSeconds += std::strtod(line.c_str()+cpuTimeMarker.size(), nullptr);
+        }
+        if (not ok)
+        {
+            const auto verbose = formatVerbose(lines);
+            os << verbose;
+            result.failure += verbose;
+        }
 
-        okVec.emplace_back(ok);
+        result.ok = result.ok or ok;
     }
 
-    return std::any_of(okVec.begin(), okVec.end(), [](bool ok){return ok;});
+    std::lock_guard<std::mutex> lock(printMutex);
+    if (progressive) std::cout << " *" << formatTimes(result) << std::endl;
+    else std::cout << report.str() << " *" << formatTimes(result) << std::endl;
+    return result;
 }
 
-static void runPluginSelfTestsR(const Pothos::PluginPath &path, SelfTestResults &results, Poco::Glob &glob, size_t numTrials)
+static void findPluginSelfTestsR(const Pothos::PluginPath &path, std::vector<std::string> &tests, Poco::Glob &glob)
 {
-    //run the test found at path
+    //the test found at path
     if (not Pothos::PluginRegistry::empty(path) and glob.match(path.toString()))
     {
         auto plugin = Pothos::PluginRegistry::get(path);
         if (plugin.getObject().type() == typeid(std::shared_ptr<Pothos::TestingBase>))
         {
-            if (spawnSelfTestOneProcess(path.toString(), numTrials))
-            {
-                results.testsPassed.push_back(path.toString());
-            }
-            else
-            {
-                results.testsFailed.push_back(path.toString());
-            }
+            tests.push_back(path.toString());
         }
     }
     //iterate on the subtree stuff
     auto nodes = Pothos::PluginRegistry::list(path);
     for (auto it = nodes.begin(); it != nodes.end(); it++)
     {
-        runPluginSelfTestsR(path.join(*it), results, glob, numTrials);
+        findPluginSelfTestsR(path.join(*it), tests, glob);
+    }
+}
+
+static std::string escapeXml(const std::string &in)
+{
+    std::string out;
+    for (const char ch : in)
+    {
+        if (ch == '&') out += "&amp;";
+        else if (ch == '<') out += "&lt;";
+        else if (ch == '>') out += "&gt;";
+        else if (ch == '"') out += "&quot;";
+        else out.push_back(ch);
+    }
+    return out;
+}
+
+//write a JUnit report when the file ends in .xml, otherwise a JSON report
+static void dumpSelfTestReport(const std::string &resultsFile, const std::vector<SelfTestResult> &results, const double wallSeconds)
+{
+    std::cout << ">>> Dumping results: " << resultsFile << std::endl;
+    std::ofstream ofs(Poco::Path::expand(resultsFile));
+
+    size_t numFailed = 0;
+    for (const auto &result : results) if (not result.ok) numFailed++;
+
+    if (Poco::icompare(Poco::Path(resultsFile).getExtension(), "xml") == 0)
+    {
+        ofs << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl;
+        ofs << Poco::format("<testsuite name=\"Pothos\" tests=\"%z\" failures=\"%z\" time=\"%.3f\">",
+            results.size(), numFailed, wallSeconds) << std::endl;
+        for (const auto &result : results)
+        {
+            const auto pos = result.path.find_last_of('/');
+            ofs << Poco::format("  <testcase classname=\"%s\" name=\"%s\" time=\"%.3f\">",
+                escapeXml(result.path.substr(0, pos)), escapeXml(result.path.substr(pos+1)), result.wallSeconds) << std::endl;
+            if (not result.ok) ofs << "    <failure message=\"FAIL\">" << escapeXml(result.failure) << "</failure>" << std::endl;
+            ofs << "  </testcase>" << std::endl;
+        }
+        ofs << "</testsuite>" << std::endl;
+        return;
+    }
+
+    json tests(json::array());
+    for (const auto &result : results)
+    {
+        json test;
+        test["path"] = result.path;
+        test["success"] = result.ok;
+        test["wallTime"] = result.wallSeconds;
+        test["cpuTime"] = result.cpuSeconds;
+        tests.push_back(test);
     }
+    json topObj;
+    topObj["tests"] = tests;
+    topObj["failures"] = numFailed;
+    topObj["wallTime"] = wallSeconds;
+    ofs << topObj.dump(4) << std::endl;
 }
 
 void PothosUtilBase::selfTestOne(const std::string &, const std::string &path)
@@ -158,6 +259,7 @@ void PothosUtilBase::selfTestOne(const std::string &, const std::string &path)
             test->runTests();
             std::cout << "success!" << std::endl;
         }
+        std::cout << cpuTimeMarker << double(std::clock())/CLOCKS_PER_SEC << std::endl;
     }
     catch(...)
     {
@@ -170,29 +272,56 @@ void PothosUtilBase::selfTests(const std::string &, const std::string &path)
     Pothos::ScopedInit init;
 
     const auto numTrials = this->config().getUInt("numTrials", 1);
+    const auto numJobs = this->config().getUInt("numJobs", 1);
 
-    SelfTestResults results;
+    std::vector<std::string> tests;
     if (path.find('*') == std::string::npos)
     {
         Poco::Glob glob("*"); //not globing, match all
-        runPluginSelfTestsR(path.empty()? "/" : path, results, glob, numTrials);
+        findPluginSelfTestsR(path.empty()? "/" : path, tests, glob);
     }
     else
     {
         Poco::Glob glob(path); //path is a glob rule
-        runPluginSelfTestsR("/", results, glob, numTrials);
+        findPluginSelfTestsR("/", tests, glob);
     }
+
+    //each job takes the next test in order until all are done
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<SelfTestResult> results(tests.size());
+    std::atomic<size_t> nextTest(0);
+    std::mutex printMutex;
+    const bool progressive = (numJobs == 1);
+    auto runJob = [&](void)
+    {
+        for (size_t i = nextTest++; i < tests.size(); i = nextTest++)
+        {
+            results[i] = spawnSelfTestOneProcess(tests[i], numTrials, progressive, printMutex);
+        }
+    };
+    std::vector<std::thread> jobs;
+    for (size_t i = 1; i < std::min<size_t>(numJobs, tests.size()); i++) jobs.emplace_back(runJob);
+    runJob();
+    for (auto &job : jobs) job.join();
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
     std::cout << std::endl;
 
-    const size_t totalTests = results.testsPassed.size() + results.testsFailed.size();
-    if (results.testsFailed.empty())
+    if (this->config().has("outputFile"))
+    {
+        dumpSelfTestReport(this->config().getString("outputFile"), results, wallSeconds);
+    }
+
+    std::vector<std::string> testsFailed;
+    for (const auto &result : results) if (not result.ok) testsFailed.push_back(result.path);
+    const size_t totalTests = results.size();
+    if (testsFailed.empty())
     {
-        std::cout << "All " << totalTests << " tests passed!" << std::endl;
+        std::cout << "All " << totalTests << " tests passed!" << Poco::format(" (%.3f s)", wallSeconds) << std::endl;
     }
     else
     {
-        std::cout << "Failed " << results.testsFailed.size() << " out of " << totalTests << " tests" << std::endl;
-        for (auto it = results.testsFailed.begin(); it != results.testsFailed.end(); it++)
+        std::cout << "Failed " << testsFailed.size() << " out of " << totalTests << " tests" << std::endl;
+        for (auto it = testsFailed.begin(); it != testsFailed.end(); it++)
         {
             std::cout << "  FAIL: " << *it << std::endl;
         }
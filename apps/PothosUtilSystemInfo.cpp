@@ -4,6 +4,7 @@
 
 #include "PothosUtil.hpp"
 #include <Pothos/System.hpp>
+#include <Pothos/Framework/MemoryAccount.hpp>
 #include <iostream>
 
 void PothosUtilBase::printSystemInfo(const std::string &, const std::string &)
@@ -24,4 +25,8 @@ void PothosUtilBase::printSystemInfo(const std::string &, const std::string &)
     {
         std::cout << " * " << searchPath << std::endl;
     }
+    std::cout << "CPU Features:";
+    for (const auto &name : Pothos::System::CpuFeatures::get().names()) std::cout << " " << name;
+    std::cout << std::endl;
+    std::cout << "Shared Buffer Memory: " << Pothos::MemoryAccount::global()->toJSON() << std::endl;
 }
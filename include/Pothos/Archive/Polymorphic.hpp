@@ -4,7 +4,7 @@
 /// Polymorphic pointer support for serialization.
 ///
 /// \copyright
-/// Copyright (c) 2016 Josh Blum
+/// Copyright (c) 2016-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -22,8 +22,7 @@ template <typename Archive, typename T>
 typename std::enable_if<std::is_polymorphic<T>::value>::type
 save(Archive &ar, const T* const &t, const unsigned int)
 {
-    const auto &entry = Pothos::Archive::ArchiveEntry::find(typeid(*t));
-    ar << entry.getHash();
+    const auto &entry = ar.writeEntry(typeid(*t));
     entry.save(ar, t);
 }
 
@@ -31,9 +30,7 @@ template <typename Archive, typename T>
 typename std::enable_if<std::is_polymorphic<T>::value>::type
 load(Archive &ar, T* &t, const unsigned int)
 {
-    unsigned long long idHash;
-    ar >> idHash;
-    const auto &entry = Pothos::Archive::ArchiveEntry::find(idHash);
+    const auto &entry = ar.readEntry();
     delete t; //delete previous pointer or its null
     t = static_cast<T*>(entry.load(ar));
 }
@@ -2,9 +2,11 @@
 /// \file Archive/StreamArchiver.hpp
 ///
 /// Archive implementation on top of streaming interfaces.
+/// The archivers can also read and write contiguous memory directly,
+/// which avoids the per-primitive virtual calls of the streams.
 ///
 /// \copyright
-/// Copyright (c) 2016-2017 Josh Blum
+/// Copyright (c) 2016-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -12,11 +14,18 @@
 #include <Pothos/Config.hpp>
 #include <type_traits>
 #include <iosfwd>
+#include <memory> //shared_ptr
+#include <unordered_map>
+#include <typeinfo>
+#include <vector>
 #include <cstddef> //size_t
+#include <cstring> //memcpy
 
 namespace Pothos {
 namespace Archive {
 
+class ArchiveEntry;
+
 /*!
  * The output stream archiver serializes types to an output stream.
  */
@@ -29,6 +38,14 @@ public:
      */
     OStreamArchiver(std::ostream &os);
 
+    /*!
+     * Create an output archiver that appends to a memory buffer.
+     * The bytes are written straight into the growable buffer,
+     * so reserve the buffer or reuse it to avoid reallocations.
+     * \param buffer the buffer to append to
+     */
+    OStreamArchiver(std::vector<char> &buffer);
+
     //! Tell the invoker that this archiver saves
     typedef std::true_type isSave;
 
@@ -47,14 +64,42 @@ public:
     void operator<<(const T &value);
 
     /*!
-     * Directly write an array of bytes to the output stream
+     * Directly write an array of bytes to the output stream or buffer
      */
     void writeBytes(const void *buff, const size_t len);
 
+    /*!
+     * Set the alignment of large binary payloads (such as BufferChunk).
+     * The payloads are padded to start at a multiple of the alignment
+     * from the start of the archive, so a memory mapped reader can
+     * return page aligned views of the payloads (default 0, no padding).
+     */
+    void setPayloadAlignment(const size_t alignment);
+
+    /*!
+     * Write the padding before a payload for the payload alignment.
+     * The padding is always preceded by its length in the archive.
+     */
+    void writePadding(void);
+
+    /*!
+     * Write the archive entry for a polymorphic type.
+     * The first use of an entry in the archive writes the entry hash,
+     * later uses write a compact index into the table of the archive.
+     * \throws ArchiveException when the type has no entry
+     * \return the entry to save the type with
+     */
+    const ArchiveEntry &writeEntry(const std::type_info &type);
+
 private:
+    void writeStream(const void *buff, const size_t len);
 
-    std::ostream &os;
+    std::ostream *os;
+    std::vector<char> *buffer;
     unsigned int ver;
+    unsigned long long offset;
+    size_t alignment;
+    std::unordered_map<size_t, std::pair<const ArchiveEntry *, unsigned long long>> entries;
 };
 
 /*!
@@ -69,6 +114,27 @@ public:
      */
     IStreamArchiver(std::istream &is);
 
+    /*!
+     * Create an input stream archiver over memory mapped archive data.
+     * Large binary payloads are returned as views into the mapped memory
+     * rather than being copied out of the stream (see readView()).
+     * \param is the stream to read from over the same memory
+     * \param mapped the address of the start of the archive in memory
+     * \param owner keeps the mapped memory valid while views are in use
+     */
+    IStreamArchiver(std::istream &is, const void *mapped, const std::shared_ptr<void> &owner);
+
+    /*!
+     * Create an input archiver over archive data in contiguous memory.
+     * Reading past the end of the memory throws an ArchiveException.
+     * When an owner is given, large binary payloads are returned as views
+     * into the memory rather than copies, as with the mapped archiver.
+     * \param data the address of the start of the archive in memory
+     * \param length the number of bytes of archive data
+     * \param owner keeps the memory valid while views are in use (optional)
+     */
+    IStreamArchiver(const void *data, const size_t length, const std::shared_ptr<void> &owner = std::shared_ptr<void>());
+
     //! Tell the invoker that this archiver loads
     typedef std::false_type isSave;
 
@@ -87,14 +153,44 @@ public:
     void operator>>(T &value);
 
     /*!
-     * Directly read an array of bytes from the input stream
+     * Directly read an array of bytes from the input stream or memory
      */
     void readBytes(void *buff, const size_t len);
 
+    //! The number of bytes read from the start of the archive
+    unsigned long long bytesRead(void) const;
+
+    //! Skip the padding written by OStreamArchiver::writePadding()
+    void readPadding(void);
+
+    /*!
+     * Skip over bytes in the stream and return their address in the mapped memory.
+     * \param len the number of bytes to skip
+     * \return the address of the bytes, or nullptr when not mapped
+     */
+    const void *readView(const size_t len);
+
+    /*!
+     * Read the archive entry for a polymorphic type.
+     * \throws ArchiveException when the entry is not registered
+     * \return the entry to load the type with
+     */
+    const ArchiveEntry &readEntry(void);
+
+    //! The owner of the mapped memory, or null when not mapped
+    const std::shared_ptr<void> &getMappedOwner(void) const;
+
 private:
+    void readStream(void *buff, const size_t len);
 
-    std::istream &is;
+    std::istream *is;
+    const char *data;
+    size_t length;
     unsigned int ver;
+    unsigned long long offset;
+    const char *mapped;
+    std::shared_ptr<void> owner;
+    std::vector<const ArchiveEntry *> entries;
 };
 
 } //namespace Archive
@@ -116,6 +212,14 @@ void Pothos::Archive::OStreamArchiver::operator<<(const T &value)
     *this & value;
 }
 
+inline void Pothos::Archive::OStreamArchiver::writeBytes(const void *buff, const size_t len)
+{
+    if (buffer == nullptr) return this->writeStream(buff, len);
+    const auto bytes = reinterpret_cast<const char *>(buff);
+    buffer->insert(buffer->end(), bytes, bytes+len);
+    offset += len;
+}
+
 template <typename T>
 void Pothos::Archive::IStreamArchiver::operator&(T &value)
 {
@@ -128,4 +232,17 @@ void Pothos::Archive::IStreamArchiver::operator>>(T &value)
     *this & value;
 }
 
+inline void Pothos::Archive::IStreamArchiver::readBytes(void *buff, const size_t len)
+{
+    //the stream path also reports reads past the end of the memory
+    if (data == nullptr or len > length - offset) return this->readStream(buff, len);
+    if (len != 0) std::memcpy(buff, data + offset, len);
+    offset += len;
+}
+
+inline unsigned long long Pothos::Archive::IStreamArchiver::bytesRead(void) const
+{
+    return offset;
+}
+
 //! \endcond
@@ -3,8 +3,12 @@
 ///
 /// Vector support for serialization.
 ///
+/// Vectors of fixed size numbers and complex numbers are serialized
+/// as a single block of little endian words (archive version 3 and later),
+/// rather than through the variable length encoding for each element.
+///
 /// \copyright
-/// Copyright (c) 2016-2019 Josh Blum
+/// Copyright (c) 2016-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -12,7 +16,12 @@
 #include <Pothos/Config.hpp>
 #include <Pothos/Archive/Invoke.hpp>
 #include <Pothos/Archive/Numbers.hpp>
+#include <Pothos/Archive/BinaryObject.hpp>
+#include <type_traits>
+#include <algorithm> //min/reverse
 #include <utility> //move
+#include <complex>
+#include <cstring> //memcpy
 #include <vector>
 
 namespace Pothos {
@@ -43,9 +52,59 @@ void load(Archive &ar, std::vector<bool, Allocator> &t, const unsigned int)
     }
 }
 
-//------------ a vector of any type --------------//
+namespace Detail {
+
+//! Element types with a fixed size on all platforms are written as a block
+template <typename T>
+struct isVectorBlockType : std::integral_constant<bool,
+    std::is_same<T, char>::value or
+    std::is_same<T, signed char>::value or
+    std::is_same<T, unsigned char>::value or
+    std::is_same<T, signed short>::value or
+    std::is_same<T, unsigned short>::value or
+    std::is_same<T, signed int>::value or
+    std::is_same<T, unsigned int>::value or
+    std::is_same<T, signed long long>::value or
+    std::is_same<T, unsigned long long>::value or
+    std::is_same<T, float>::value or
+    std::is_same<T, double>::value>
+{};
+
+template <typename T>
+struct isVectorBlockType<std::complex<T>> : isVectorBlockType<T>
+{};
+
+//! The word size of the element type for byte ordering
+template <typename T>
+struct vectorBlockWordSize : std::integral_constant<size_t, sizeof(T)>
+{};
+
+template <typename T>
+struct vectorBlockWordSize<std::complex<T>> : std::integral_constant<size_t, sizeof(T)>
+{};
+
+//! The archive version which introduced the vector block format
+static const unsigned int vectorBlockVersion = 3;
+
+inline bool isLittleEndian(void)
+{
+    const unsigned short one(1);
+    return *reinterpret_cast<const unsigned char *>(&one) == 1;
+}
+
+//! Reverse the bytes of each word in the buffer (big endian hosts)
+template <size_t WordSize>
+void byteswapWords(unsigned char *buff, const size_t numBytes)
+{
+    if (WordSize == 1) return;
+    for (size_t i = 0; i < numBytes; i += WordSize)
+    {
+        std::reverse(buff+i, buff+i+WordSize);
+    }
+}
+
 template<typename Archive, typename T, typename Allocator>
-void save(Archive &ar, const std::vector<T, Allocator> &t, const unsigned int)
+void saveElements(Archive &ar, const std::vector<T, Allocator> &t)
 {
     ar << unsigned(t.size());
     for (const auto &elem : t)
@@ -55,7 +114,7 @@ void save(Archive &ar, const std::vector<T, Allocator> &t, const unsigned int)
 }
 
 template<typename Archive, typename T, typename Allocator>
-void load(Archive &ar, std::vector<T, Allocator> &t, const unsigned int)
+void loadElements(Archive &ar, std::vector<T, Allocator> &t)
 {
     unsigned size(0);
     ar >> size;
@@ -69,6 +128,70 @@ void load(Archive &ar, std::vector<T, Allocator> &t, const unsigned int)
     }
 }
 
+} //namespace Detail
+
+//------------ a vector of fixed size numbers --------------//
+template<typename Archive, typename T, typename Allocator>
+typename std::enable_if<Detail::isVectorBlockType<T>::value>::type
+save(Archive &ar, const std::vector<T, Allocator> &t, const unsigned int ver)
+{
+    if (ver < Detail::vectorBlockVersion) return Detail::saveElements(ar, t);
+    ar << unsigned(t.size());
+    const size_t numBytes = t.size()*sizeof(T);
+
+    //little endian hosts write the vector memory directly
+    if (Detail::isLittleEndian())
+    {
+        BinaryObject bo(t.data(), numBytes);
+        ar << bo;
+        return;
+    }
+
+    //otherwise swap through a small buffer
+    unsigned char buff[4096];
+    const auto data = reinterpret_cast<const unsigned char *>(t.data());
+    for (size_t offset = 0; offset < numBytes; offset += sizeof(buff))
+    {
+        const size_t len = std::min(numBytes-offset, sizeof(buff));
+        std::memcpy(buff, data+offset, len);
+        Detail::byteswapWords<Detail::vectorBlockWordSize<T>::value>(buff, len);
+        BinaryObject bo(buff, len);
+        ar << bo;
+    }
+}
+
+template<typename Archive, typename T, typename Allocator>
+typename std::enable_if<Detail::isVectorBlockType<T>::value>::type
+load(Archive &ar, std::vector<T, Allocator> &t, const unsigned int ver)
+{
+    if (ver < Detail::vectorBlockVersion) return Detail::loadElements(ar, t);
+    unsigned size(0);
+    ar >> size;
+    t.resize(size);
+    const size_t numBytes = t.size()*sizeof(T);
+    BinaryObject bo(t.data(), numBytes);
+    ar >> bo;
+    if (not Detail::isLittleEndian())
+    {
+        Detail::byteswapWords<Detail::vectorBlockWordSize<T>::value>(reinterpret_cast<unsigned char *>(t.data()), numBytes);
+    }
+}
+
+//------------ a vector of any type --------------//
+template<typename Archive, typename T, typename Allocator>
+typename std::enable_if<not Detail::isVectorBlockType<T>::value>::type
+save(Archive &ar, const std::vector<T, Allocator> &t, const unsigned int)
+{
+    Detail::saveElements(ar, t);
+}
+
+template<typename Archive, typename T, typename Allocator>
+typename std::enable_if<not Detail::isVectorBlockType<T>::value>::type
+load(Archive &ar, std::vector<T, Allocator> &t, const unsigned int)
+{
+    Detail::loadElements(ar, t);
+}
+
 template <typename Archive, typename T, typename Allocator>
 void serialize(Archive &ar, std::vector<T, Allocator> &t, const unsigned int ver)
 {
@@ -0,0 +1,166 @@
+///
+/// \file Benchmark.hpp
+///
+/// Macros for creating micro-benchmark plugins.
+/// Benchmarks are installed into the registry and executed at runtime.
+/// The benchmark macros mirror the self-test macros in Testing.hpp.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Object.hpp>
+#include <Pothos/Plugin.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+
+/*!
+ * Declare a micro-benchmark block of code inside a plugin.
+ *
+ * The benchmark will be installed into /path/name in the PluginRegistry.
+ * Once installed, this benchmark can be run with PothosUtil --bench.
+ * The body must run the operation under test state.iterations() times.
+ *
+ * \param path a valid PluginPath
+ * \param name a valid function name
+ *
+ * Example usage:
+ * \code
+ * POTHOS_BENCH_BLOCK("/sys/foo/bench", bench_bar)
+ * {
+ *     state.setBytesPerIteration(1024);
+ *     for (size_t i = 0; i < state.iterations(); i++)
+ *     {
+ *         Pothos::BenchmarkState::doNotOptimize(etc...);
+ *     }
+ * }
+ * \endcode
+ */
+#define POTHOS_BENCH_BLOCK(path, name) \
+    POTHOS_STATIC_FIXTURE_DECL void name ## Runner(Pothos::BenchmarkState &); \
+    template <void (*runner)(Pothos::BenchmarkState &)> \
+    struct name : Pothos::BenchmarkBase \
+    { \
+        void runBenchmarkImpl(Pothos::BenchmarkState &state) \
+        { \
+            runner(state); \
+        } \
+    }; \
+    pothos_static_block(name) \
+    { \
+        std::shared_ptr<Pothos::BenchmarkBase> benchObj(new name<name ## Runner>()); \
+        Pothos::PluginRegistry::add(Pothos::Plugin( \
+            Pothos::PluginPath(path).join(#name), Pothos::Object(benchObj))); \
+    } \
+    POTHOS_STATIC_FIXTURE_DECL void name ## Runner(Pothos::BenchmarkState &state)
+
+namespace Pothos {
+
+/*!
+ * The state passed into a benchmark body for a single timed run.
+ * The state tracks the elapsed time, excluding paused sections.
+ */
+class POTHOS_API BenchmarkState
+{
+public:
+    //! Create a state for the specified number of iterations
+    BenchmarkState(const size_t iterations);
+
+    //! The number of times the benchmark body should run the operation
+    size_t iterations(void) const;
+
+    /*!
+     * Set the number of bytes processed by each iteration.
+     * When non-zero, the result reports a throughput in bytes per second.
+     */
+    void setBytesPerIteration(const size_t numBytes);
+
+    //! Get the number of bytes processed by each iteration
+    size_t bytesPerIteration(void) const;
+
+    //! Stop the timer to exclude setup code from the measurement
+    void pauseTiming(void);
+
+    //! Restart the timer after a call to pauseTiming()
+    void resumeTiming(void);
+
+    //! The timed duration in seconds, excluding paused sections
+    double elapsed(void) const;
+
+    /*!
+     * Prevent the compiler from optimizing away a computed value.
+     * Pass the result of the operation under test into this call.
+     */
+    template <typename T>
+    static void doNotOptimize(const T &value);
+
+private:
+    static void doNotOptimizeSink(const void *);
+    const size_t _iterations;
+    size_t _bytesPerIteration;
+    bool _paused;
+    std::chrono::high_resolution_clock::time_point _startTime;
+    std::chrono::high_resolution_clock::duration _elapsed;
+};
+
+/*!
+ * The measured result of a benchmark run.
+ */
+struct POTHOS_API BenchmarkResult
+{
+    BenchmarkResult(void);
+
+    //! The number of iterations in the final timed run
+    size_t iterations;
+
+    //! The timed duration of the final run in seconds
+    double seconds;
+
+    //! The average time per iteration in nanoseconds
+    double nsPerOp;
+
+    //! The throughput in bytes per second or 0 when unspecified
+    double bytesPerSecond;
+};
+
+struct POTHOS_API BenchmarkBase
+{
+    BenchmarkBase(void);
+    virtual ~BenchmarkBase(void);
+
+    /*!
+     * Run the benchmark with an increasing number of iterations
+     * until a single run takes at least the minimum duration.
+     * \param minTime the minimum timed duration in seconds
+     * \return the measurement from the final timed run
+     */
+    BenchmarkResult run(const double minTime = 0.5);
+
+    virtual void runBenchmarkImpl(BenchmarkState &state) = 0;
+};
+
+} //namespace Pothos
+
+inline size_t Pothos::BenchmarkState::iterations(void) const
+{
+    return _iterations;
+}
+
+inline size_t Pothos::BenchmarkState::bytesPerIteration(void) const
+{
+    return _bytesPerIteration;
+}
+
+template <typename T>
+void Pothos::BenchmarkState::doNotOptimize(const T &value)
+{
+    #if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+    #else
+    doNotOptimizeSink(&value);
+    #endif
+}
@@ -4,13 +4,14 @@
 /// Top level include wrapper for Framework classes.
 ///
 /// \copyright
-/// Copyright (c) 2014-2016 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
 #pragma once
 #include <Pothos/Config.hpp>
 #include <Pothos/Framework/Packet.hpp>
+#include <Pothos/Framework/PacketMetadata.hpp>
 #include <Pothos/Framework/WorkInfo.hpp>
 #include <Pothos/Framework/DType.hpp>
 #include <Pothos/Framework/Label.hpp>
@@ -18,6 +19,7 @@
 #include <Pothos/Framework/InputPortImpl.hpp>
 #include <Pothos/Framework/OutputPort.hpp>
 #include <Pothos/Framework/OutputPortImpl.hpp>
+#include <Pothos/Framework/SignalHandle.hpp>
 #include <Pothos/Framework/Connectable.hpp>
 #include <Pothos/Framework/ConnectableImpl.hpp>
 #include <Pothos/Framework/ThreadPool.hpp>
@@ -28,9 +30,14 @@
 #include <Pothos/Framework/BlockRegistry.hpp>
 #include <Pothos/Framework/BlockRegistryImpl.hpp>
 #include <Pothos/Framework/BufferManager.hpp>
+#include <Pothos/Framework/ExternalBufferManager.hpp>
 #include <Pothos/Framework/BufferAccumulator.hpp>
 #include <Pothos/Framework/BufferPool.hpp>
 #include <Pothos/Framework/BufferChunk.hpp>
+#include <Pothos/Framework/BufferChunkList.hpp>
+#include <Pothos/Framework/BufferConvert.hpp>
 #include <Pothos/Framework/SharedBuffer.hpp>
+#include <Pothos/Framework/MemoryAccount.hpp>
 #include <Pothos/Framework/ManagedBuffer.hpp>
+#include <Pothos/Framework/AsyncIO.hpp>
 #include <Pothos/Framework/Exception.hpp>
@@ -0,0 +1,175 @@
+///
+/// \file Framework/AsyncIO.hpp
+///
+/// Asynchronous file and socket transfers for use inside work().
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
+#include <Pothos/Framework/BufferChunkList.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace Pothos {
+
+class Block;
+
+/*!
+ * AsyncIO submits reads and writes on buffers from the work() of a block,
+ * and wakes the block when the transfers complete.
+ * A blocking transfer holds one thread of a small framework I/O pool
+ * instead of the thread pool of the block, so I/O blocks no longer
+ * stall the compute blocks which share their worker threads.
+ *
+ * The transfers of one AsyncIO object run in submission order,
+ * so stream handles such as sockets and pipes keep their byte order,
+ * and the completions are popped in submission order as well.
+ * Other blocking operations, such as a driver call that waits on hardware,
+ * are submitted as a job, which runs on the I/O pool in the same order.
+ * A submitted buffer is held until its completion is popped,
+ * so a managed buffer remains checked out of its manager
+ * and its memory is transferred in place without a copy.
+ *
+ * Example replay source, reading into the output buffers:
+ * \code
+ * void work(void)
+ * {
+ *     auto out = this->output(0);
+ *     Pothos::AsyncIO::Completion c;
+ *     while (_io.pop(c))
+ *     {
+ *         if (c.result > 0) out->postBuffer(std::move(c.buffer));
+ *     }
+ *     while (not _io.full()) _io.read(_fd, out->getBuffer(4096));
+ * }
+ * \endcode
+ */
+class POTHOS_API AsyncIO
+{
+public:
+
+    /*!
+     * A platform handle for the transfers:
+     * a file descriptor or socket on unix,
+     * a file HANDLE or SOCKET on windows.
+     */
+    typedef intptr_t Handle;
+
+    //! The result of a completed transfer
+    struct POTHOS_API Completion
+    {
+        Completion(void);
+
+        /*!
+         * The buffer of the transfer.
+         * The length is the number of bytes transferred.
+         */
+        BufferChunk buffer;
+
+        //! The buffers of a gather write (the buffer is null)
+        BufferChunkList buffers;
+
+        /*!
+         * The number of bytes transferred,
+         * 0 for the end of a file or a closed stream,
+         * or a negative platform error code (-errno or -GetLastError()).
+         */
+        long long result;
+
+        //! True for a write transfer, false for a read
+        bool isWrite;
+    };
+
+    /*!
+     * A blocking job which runs on the I/O pool.
+     * \return the result of the completion, by convention the number
+     * of bytes in the buffer or a negative platform error code
+     */
+    typedef std::function<long long(void)> Job;
+
+    //! Create a null AsyncIO
+    AsyncIO(void);
+
+    /*!
+     * Create an AsyncIO which wakes the block on completion.
+     * \param block the block which calls work() to pop completions
+     * \param maxPending the number of transfers in flight at once
+     */
+    AsyncIO(Block *block, const size_t maxPending = 4);
+
+    /*!
+     * Wait on the transfer in progress and discard the others.
+     * A stream read in progress is cancelled, since it may never complete.
+     */
+    ~AsyncIO(void);
+
+    //! Is this a null AsyncIO?
+    explicit operator bool(void) const;
+
+    //! Are maxPending transfers submitted and not yet popped?
+    bool full(void) const;
+
+    //! The number of transfers submitted and not yet popped
+    size_t pending(void) const;
+
+    /*!
+     * Submit a read into the buffer.
+     * \param handle the platform handle to read from
+     * \param buffer the destination memory, the length is the maximum to read
+     * \param offset the position in the file, or -1 for a stream
+     * \return false when the AsyncIO is full and the transfer was not submitted
+     */
+    bool read(const Handle handle, const BufferChunk &buffer, const long long offset = -1);
+
+    /*!
+     * Submit a write from the buffer.
+     * A write transfers the entire buffer, unless an error occurs.
+     * \param handle the platform handle to write to
+     * \param buffer the source memory and length to write
+     * \param offset the position in the file, or -1 for a stream
+     * \return false when the AsyncIO is full and the transfer was not submitted
+     */
+    bool write(const Handle handle, const BufferChunk &buffer, const long long offset = -1);
+
+    /*!
+     * Submit a gather write from a list of buffers, such as the pieces of a frame.
+     * A stream writes the list with one system call (writev on unix),
+     * a file writes the buffers one after another from the offset.
+     * \param handle the platform handle to write to
+     * \param buffers the list of buffers to write in order
+     * \param offset the position in the file, or -1 for a stream
+     * \return false when the AsyncIO is full and the transfer was not submitted
+     */
+    bool write(const Handle handle, const BufferChunkList &buffers, const long long offset = -1);
+
+    /*!
+     * Submit a blocking job, the block is woken when the job returns.
+     * A job in progress is not cancelled by the destructor,
+     * so a job that may never return must wait with a timeout.
+     * \param job the blocking operation which produces the result
+     * \param buffer an optional buffer returned with the completion
+     * \return false when the AsyncIO is full and the job was not submitted
+     */
+    bool submit(const Job &job, const BufferChunk &buffer = BufferChunk());
+
+    /*!
+     * Pop the oldest transfer once it completes.
+     * \param [out] completion the result of the transfer
+     * \return true when a completion was popped
+     */
+    bool pop(Completion &completion);
+
+    struct Impl;
+private:
+    std::shared_ptr<Impl> _impl;
+    AsyncIO(const AsyncIO &) = delete;
+    AsyncIO &operator=(const AsyncIO &) = delete;
+};
+
+} //namespace Pothos
@@ -4,7 +4,7 @@
 /// This file contains the interface for creating custom Blocks.
 ///
 /// \copyright
-/// Copyright (c) 2014-2019 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -14,11 +14,15 @@
 #include <Pothos/Framework/WorkInfo.hpp>
 #include <Pothos/Framework/InputPort.hpp>
 #include <Pothos/Framework/OutputPort.hpp>
+#include <Pothos/Framework/SignalHandle.hpp>
 #include <Pothos/Framework/ThreadPool.hpp>
+#include <Pothos/Util/MonotonicArena.hpp>
 #include <memory>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 namespace Pothos {
 
@@ -49,6 +53,20 @@ public:
     //! Get the thread pool used by this block
     const ThreadPool &getThreadPool(void) const;
 
+    /*!
+     * Set the scheduling priority of this block within its thread pool.
+     * Use a high priority for latency-critical blocks such as control loops
+     * which share a thread pool with blocks that perform bulk processing.
+     * The work-stealing scheduler executes ready blocks in priority order,
+     * and round-robin pool threads visit the high priority blocks first.
+     * \param priority 1 for high, 0 for normal (default), -1 for low priority,
+     * other values are clamped to this range
+     */
+    void setSchedulingPriority(const int priority);
+
+    //! Get the scheduling priority of this block
+    int getSchedulingPriority(void) const;
+
 protected:
     /*!
      * The prepare() method allows the block to say whether it will be able to
@@ -148,6 +166,13 @@ protected:
      *   - provide a replacement downstream buffer manager (return manager)
      *   - protest the ability to interact with the domain (throw exception)
      *
+     * Device memory domains, such as the memory of a GPU or accelerator,
+     * follow the same rules: the blocks of the device domain provide managers
+     * whose shared buffers wrap the device allocations (see SharedBuffer's container),
+     * so device resident data flows between the blocks in the domain without a copy.
+     * When the crossing is protested, the topology inserts a copier block,
+     * which the toolkit of the domain can select (see BlockRegistry::findDomainCopier()).
+     *
      * \throws PortDomainError when the domain is incompatible
      * \param name the name of an output port on this block
      * \param domain the domain of the downstream blocks
@@ -179,21 +204,31 @@ public:
 
     /*!
      * Get the input port at the specified port name.
+     * The name is resolved through a hash table, its cost is one string hash.
+     * A block can also keep the returned pointer, which remains valid
+     * until the port is deleted (only automatic ports are deleted).
      */
     InputPort *input(const std::string &name) const;
 
     /*!
      * Get the input port at the specified port index.
+     * This call is a bounds-checked index into inputs(),
+     * it never looks up the port by name.
      */
     InputPort *input(const size_t index) const;
 
     /*!
      * Get the output port at the specified port name.
+     * The name is resolved through a hash table, its cost is one string hash.
+     * A block can also keep the returned pointer, which remains valid
+     * until the port is deleted (only automatic ports are deleted).
      */
     OutputPort *output(const std::string &name) const;
 
     /*!
      * Get the output port at the specified port index.
+     * This call is a bounds-checked index into outputs(),
+     * it never looks up the port by name.
      */
     OutputPort *output(const size_t index) const;
 
@@ -233,6 +268,35 @@ public:
      */
     const WorkInfo &workInfo(void) const;
 
+    /*!
+     * Process the available elements of the indexed ports in chunks.
+     * The kernel is called with typed pointers into each indexed input,
+     * followed by each indexed output, and the number of elements.
+     * The chunks are sized so the spans of all ports stay in the cache,
+     * and every chunk is a whole multiple of the chunk size in elements,
+     * except for the last chunk of the call.
+     * After the kernel calls, the ports consume and produce workInfo().minElements.
+     * Only call this method from within a call to the work() function.
+     *
+     * Example of a two input adder:
+     * \code
+     * this->forEachChunk<std::tuple<float, float>, std::tuple<float>>(
+     *     [](const float *in0, const float *in1, float *out0, const size_t n)
+     *     {
+     *         for (size_t i = 0; i < n; i++) out0[i] = in0[i] + in1[i];
+     *     });
+     * \endcode
+     *
+     * \tparam InTypes a std::tuple of the element types of the indexed inputs
+     * \tparam OutTypes a std::tuple of the element types of the indexed outputs
+     * \throws PortAccessError when the block has fewer indexed ports than types
+     * \param kernel the function called on each chunk
+     * \param chunkBytes the maximum size of a chunk in bytes for the largest type
+     * \return the number of elements consumed and produced per port
+     */
+    template <typename InTypes, typename OutTypes, typename KernelType>
+    size_t forEachChunk(KernelType &&kernel, const size_t chunkBytes = 16*1024);
+
     /*!
      * Is the block in an active state?
      * This is a thread-safe way for a block's methods
@@ -310,11 +374,19 @@ public:
      * Register that this block has a slot of the given name.
      * A slot is capable of accepting messages from a signal.
      * The name should not overlap with the name of an input port.
-     * Note: do not call the registerSlot function in C++,
+     * Note: do not call the registerSlot function in C++ to create the slot,
      * as registerCallable() automatically registers a slot.
+     * Calling registerSlot() on an automatic slot only updates latestOnly.
+     *
+     * A latestOnly slot keeps at most one pending call:
+     * a new call replaces the pending call instead of queuing behind it.
+     * Use this option for setters driven at a high rate, such as a gain
+     * controlled by a signal per packet, where only the last value matters.
+     *
      * \param name the name of the slot
+     * \param latestOnly true to replace a pending call with the latest call
      */
-    void registerSlot(const std::string &name);
+    void registerSlot(const std::string &name, const bool latestOnly = false);
 
     /*!
      * Register a probe given the name of a registered call.
@@ -335,6 +407,43 @@ public:
         const std::string &signalName="",
         const std::string &slotName="");
 
+    /*!
+     * Register a published value, such as a power or level reading.
+     * A published value is read by monitors without the thread context:
+     * the block publishes from work() and readers never stall the block,
+     * unlike a probe, which calls into the block through a slot.
+     * Only register published values in the constructor of the block.
+     * The value is 0.0 until the first call to publishValue().
+     * \param name the name of the published value
+     */
+    void registerPublishedValue(const std::string &name);
+
+    /*!
+     * Publish a new value for lock-free readers.
+     * Only call this method from the thread context of the block (such as work()).
+     * The values set during a call to work() are published together
+     * when the call returns, so readers see a consistent set of values.
+     * \throws NotFoundException when the name is not a registered value
+     * \param name the name of a registered published value
+     * \param value the new value
+     */
+    void publishValue(const std::string &name, const double value);
+
+    /*!
+     * Read the latest published value (from any thread).
+     * \throws NotFoundException when the name is not a registered value
+     * \param name the name of a registered published value
+     * \return the value from the last call to publishValue()
+     */
+    double readPublishedValue(const std::string &name) const;
+
+    /*!
+     * Read all published values at once (from any thread).
+     * The values are a consistent snapshot of the published values.
+     * \return a map of the value name to the latest value
+     */
+    std::map<std::string, double> readPublishedValues(void) const;
+
     /*!
      * Notify the scheduler that the work() method will yeild the thread context.
      * Call this method when the work() function will not produce or consume,
@@ -346,6 +455,39 @@ public:
      */
     void yield(void);
 
+    /*!
+     * Schedule a call to work() at the given time.
+     * Use this method in timed sources and pacing blocks,
+     * rather than sleeping in work() or spinning with yield().
+     * The block is flagged by the thread pool when the time is due,
+     * and work() is called once the ports are ready as usual.
+     * Each call replaces the pending wakeup of this block,
+     * and work() may also be called before the wakeup for other changes.
+     * This call has no effect when the block has no thread pool.
+     * \param timePoint the time of the wakeup, a past time wakes immediately
+     */
+    void scheduleWakeup(const std::chrono::steady_clock::time_point &timePoint);
+
+    /*!
+     * Signal that this source block has produced all of its data.
+     * The scheduler stops calling work() until the block is activated again,
+     * and the output posted by this work() call is still delivered.
+     * Topology::runToCompletion() drains the design once all sources signaled.
+     * Only call this method from within a call to the work() function.
+     */
+    void endOfStream(void);
+
+    /*!
+     * Get the arena for transient allocations of the work() call.
+     * Allocate scratch memory for the duration of a single work() call
+     * from the arena, or use Util::ArenaAllocator with standard containers.
+     * The arena is reset after each work() call and keeps its memory,
+     * so the steady state of the block does not touch the heap.
+     * Only call this method from within a call to the work() function.
+     * eturn the arena of this block
+     */
+    Util::MonotonicArena &workArena(void);
+
     /*!
      * Emit a signal to all subscribed slots.
      * \param name the name of a registered signal
@@ -354,6 +496,16 @@ public:
     template <typename... ArgsType>
     void emitSignal(const std::string &name, ArgsType&&... args);
 
+    /*!
+     * Get a typed handle to emit a signal without a lookup by name.
+     * Call after registerSignal(), such as in the constructor of the block.
+     * \throws PortAccessError if the signal does not exist
+     * \param name the name of a registered signal
+     * \return a handle which remains valid for the lifetime of the block
+     */
+    template <typename... ArgsType>
+    SignalHandle<ArgsType...> signalHandle(const std::string &name);
+
     /*!
      * Call a method on a derived instance with opaque input and return types.
      * \param name the name of the method as a string
@@ -363,6 +515,38 @@ public:
      */
     Object opaqueCallMethod(const std::string &name, const Object *inputArgs, const size_t numArgs) const;
 
+    /*!
+     * Call a registered method without waiting on the thread context of the block.
+     * The call is queued and runs on the worker thread before the next call to work(),
+     * so frequent setter calls (such as from a GUI control) never stall the block.
+     * The return value is discarded, and errors from the call are logged.
+     * Calls queued while the block is inactive are applied on activation.
+     * \throws BlockCallNotFound when the name is not a registered call
+     * \param name the name of a registered call
+     * \param inputArgs an array of input arguments
+     * \param numArgs the size of the input array
+     * \param coalesce true to replace a queued call of the same name,
+     *        so that only the latest arguments are applied
+     */
+    void opaqueAsyncCall(const std::string &name, const Object *inputArgs, const size_t numArgs, const bool coalesce = false) const;
+
+    /*!
+     * Queue an asynchronous call, see opaqueAsyncCall().
+     * \param name the name of a registered call
+     * \param args a variable number of arguments
+     */
+    template <typename... ArgsType>
+    void asyncCall(const std::string &name, ArgsType&&... args) const;
+
+    /*!
+     * Queue a coalesced asynchronous call, see opaqueAsyncCall().
+     * Only the latest arguments apply when the previous call is still queued.
+     * \param name the name of a registered call
+     * \param args a variable number of arguments
+     */
+    template <typename... ArgsType>
+    void asyncCallLatest(const std::string &name, ArgsType&&... args) const;
+
 private:
     WorkInfo _workInfo;
     std::vector<std::string> _inputPortNames;
@@ -371,9 +555,12 @@ private:
     std::vector<OutputPort*> _indexedOutputs;
     std::map<std::string, InputPort*> _namedInputs;
     std::map<std::string, OutputPort*> _namedOutputs;
+    std::unordered_map<std::string, InputPort*> _hashedInputs; //lookup copy of _namedInputs
+    std::unordered_map<std::string, OutputPort*> _hashedOutputs; //lookup copy of _namedOutputs
     std::multimap<std::string, Callable> _calls;
     std::map<std::string, std::pair<std::string, std::string>> _probes;
     ThreadPool _threadPool;
+    int _schedulingPriority;
     Block(const Block &) = delete; // non construction-copyable
     Block &operator=(const Block &) = delete; // non copyable
 public:
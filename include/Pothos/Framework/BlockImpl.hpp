@@ -4,7 +4,7 @@
 /// This file contains inline definitions for Block members.
 ///
 /// \copyright
-/// Copyright (c) 2014-2016 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -12,8 +12,14 @@
 #include <Pothos/Framework/Block.hpp>
 #include <Pothos/Framework/ConnectableImpl.hpp>
 #include <Pothos/Framework/Exception.hpp>
+#include <Pothos/Framework/InputPortImpl.hpp>
+#include <Pothos/Framework/OutputPortImpl.hpp>
 #include <Pothos/Object/Containers.hpp>
+#include <Pothos/Util/Templates.hpp>
 #include <utility> //std::forward
+#include <algorithm> //std::max/min
+#include <tuple>
+#include <array>
 
 inline const Pothos::WorkInfo &Pothos::Block::workInfo(void) const
 {
@@ -22,8 +28,8 @@ inline const Pothos::WorkInfo &Pothos::Block::workInfo(void) const
 
 inline Pothos::InputPort *Pothos::Block::input(const std::string &name) const
 {
-    auto it = _namedInputs.find(name);
-    if (it == _namedInputs.end()) throw PortAccessError(
+    auto it = _hashedInputs.find(name);
+    if (it == _hashedInputs.end()) throw PortAccessError(
         "Pothos::Block::input("+name+")", "input port name does not exist");
     return it->second;
 }
@@ -37,8 +43,8 @@ inline Pothos::InputPort *Pothos::Block::input(const size_t index) const
 
 inline Pothos::OutputPort *Pothos::Block::output(const std::string &name) const
 {
-    auto it = _namedOutputs.find(name);
-    if (it == _namedOutputs.end()) throw PortAccessError(
+    auto it = _hashedOutputs.find(name);
+    if (it == _hashedOutputs.end()) throw PortAccessError(
         "Pothos::Block::output("+name+")", "output port name does not exist");
     return it->second;
 }
@@ -73,10 +79,85 @@ inline const std::map<std::string, Pothos::OutputPort*> &Pothos::Block::allOutpu
 template <typename... ArgsType>
 void Pothos::Block::emitSignal(const std::string &name, ArgsType&&... args)
 {
-    const auto it = _namedOutputs.find(name);
-    if (it == _namedOutputs.end() or not it->second->isSignal()) throw PortAccessError(
+    const auto it = _hashedOutputs.find(name);
+    if (it == _hashedOutputs.end() or not it->second->isSignal()) throw PortAccessError(
         "Pothos::Block::emitSignal("+name+")", "signal port does not exist");
 
     const ObjectVector objArgs{{Object(std::forward<ArgsType>(args))...}};
     it->second->postMessage(std::move(objArgs));
 }
+
+template <typename... ArgsType>
+Pothos::SignalHandle<ArgsType...> Pothos::Block::signalHandle(const std::string &name)
+{
+    const auto it = _hashedOutputs.find(name);
+    if (it == _hashedOutputs.end() or not it->second->isSignal()) throw PortAccessError(
+        "Pothos::Block::signalHandle("+name+")", "signal port does not exist");
+    return SignalHandle<ArgsType...>(it->second);
+}
+
+template <typename... ArgsType>
+void Pothos::Block::asyncCall(const std::string &name, ArgsType&&... args) const
+{
+    const std::array<Object, sizeof...(ArgsType)> objArgs{{Object(std::forward<ArgsType>(args))...}};
+    this->opaqueAsyncCall(name, objArgs.data(), sizeof...(args), false);
+}
+
+template <typename... ArgsType>
+void Pothos::Block::asyncCallLatest(const std::string &name, ArgsType&&... args) const
+{
+    const std::array<Object, sizeof...(ArgsType)> objArgs{{Object(std::forward<ArgsType>(args))...}};
+    this->opaqueAsyncCall(name, objArgs.data(), sizeof...(args), true);
+}
+
+namespace Pothos {
+namespace Detail {
+
+//! The size of the largest element type in the tuple (at least 1)
+template <typename TupleType, size_t... I>
+size_t forEachChunkMaxSize(Pothos::Util::index_sequence<I...>)
+{
+    const std::array<size_t, sizeof...(I)+1> sizes{{size_t(1), sizeof(typename std::tuple_element<I, TupleType>::type)...}};
+    return *std::max_element(sizes.begin(), sizes.end());
+}
+
+//! Call the kernel with the typed pointers at the element offset
+template <typename InTypes, typename OutTypes, typename KernelType, size_t... I, size_t... O>
+void forEachChunkCall(KernelType &kernel, const WorkInfo &info, const size_t offset, const size_t num,
+    Pothos::Util::index_sequence<I...>, Pothos::Util::index_sequence<O...>)
+{
+    kernel(
+        (static_cast<const typename std::tuple_element<I, InTypes>::type *>(info.inputPointers[I])+offset)...,
+        (static_cast<typename std::tuple_element<O, OutTypes>::type *>(info.outputPointers[O])+offset)...,
+        num);
+}
+
+} //namespace Detail
+} //namespace Pothos
+
+template <typename InTypes, typename OutTypes, typename KernelType>
+size_t Pothos::Block::forEachChunk(KernelType &&kernel, const size_t chunkBytes)
+{
+    typedef Pothos::Util::make_index_sequence<std::tuple_size<InTypes>::value> InSeq;
+    typedef Pothos::Util::make_index_sequence<std::tuple_size<OutTypes>::value> OutSeq;
+    const size_t numIn = std::tuple_size<InTypes>::value;
+    const size_t numOut = std::tuple_size<OutTypes>::value;
+    if (_indexedInputs.size() < numIn or _indexedOutputs.size() < numOut) throw PortAccessError(
+        "Pothos::Block::forEachChunk()", "fewer indexed ports than kernel types");
+
+    const size_t total = _workInfo.minElements;
+    if (numIn+numOut == 0 or total == 0) return 0;
+
+    const size_t itemSize = std::max(
+        Detail::forEachChunkMaxSize<InTypes>(InSeq()),
+        Detail::forEachChunkMaxSize<OutTypes>(OutSeq()));
+    const size_t chunk = std::max<size_t>(chunkBytes/itemSize, 1);
+    for (size_t offset = 0; offset < total; offset += chunk)
+    {
+        Detail::forEachChunkCall<InTypes, OutTypes>(kernel, _workInfo, offset, std::min(chunk, total-offset), InSeq(), OutSeq());
+    }
+
+    for (size_t i = 0; i < numIn; i++) _indexedInputs[i]->consume(total);
+    for (size_t i = 0; i < numOut; i++) _indexedOutputs[i]->produce(total);
+    return total;
+}
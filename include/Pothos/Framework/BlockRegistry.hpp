@@ -12,10 +12,13 @@
 #include <Pothos/Config.hpp>
 #include <Pothos/Callable/Callable.hpp>
 #include <Pothos/Proxy/Proxy.hpp>
+#include <Pothos/Framework/DType.hpp>
 #include <string>
 
 namespace Pothos {
 
+class Block;
+
 /*!
  * The BlockRegistry class registers factories for topological elements.
  * These elements include Blocks and sub-Topologies (hierarchies of elements).
@@ -44,6 +47,24 @@ public:
      */
     BlockRegistry(const std::string &path, const Callable &factory);
 
+    /*!
+     * Register a variant of a block factory which uses an instruction set extension.
+     * The variant is registered into the plugin registry: /framework/block_variants/path/isa
+     * and make() constructs the variant with the best extension supported by the host,
+     * or the factory registered at /blocks/path when no variant is supported.
+     * Since make() runs in the process of the environment that makes the block,
+     * a block made in a remote environment selects the variant for the remote host.
+     * The factory of a variant should accept the same arguments as the base factory.
+     *
+     * Usage example (put this at the bottom of your c++ source file)
+     * static Pothos::BlockRegistry registerMyBlockAvx2("/my/factory/path", "avx2", &MyBlockAvx2::make);
+     *
+     * \param path the factory path begining with a slash ("/")
+     * \param isa the extension name, one of System::CpuFeatures::ranking()
+     * \param factory the Callable factory function
+     */
+    BlockRegistry(const std::string &path, const std::string &isa, const Callable &factory);
+
     /*!
      * Instantiate a block given the factory path and arguments.
      * \param path the factory path begining with a slash ("/")
@@ -52,6 +73,47 @@ public:
      */
     template <typename... ArgsType>
     static Proxy make(const std::string &path, ArgsType&&... args);
+
+    /*!
+     * Instantiate a block template for the element type of a DType.
+     * The block template is instantiated for each of the listed types,
+     * and the instantiation that matches the element type is constructed,
+     * so the work() of the block is specialized at compile time.
+     * The dimension of the DType is not used to select the type.
+     *
+     * Example factory for a block template MyAdder<T>:
+     * \code
+     * static Pothos::Block *makeAdder(const Pothos::DType &dtype)
+     * {
+     *     return Pothos::BlockRegistry::makeForDType<MyAdder, float, double, int>(dtype, dtype.dimension());
+     * }
+     * static Pothos::BlockRegistry registerAdder("/my/adder", &makeAdder);
+     * \endcode
+     *
+     * \tparam BlockType a block class template with one element type parameter
+     * \tparam Types the supported element types of the block
+     * \throws DTypeUnknownError when the element type is not one of the types
+     * \param dtype the data type which selects the instantiation
+     * \param args the constructor arguments of the block
+     * \return a new block instance
+     */
+    template <template <typename> class BlockType, typename... Types, typename... ArgsType>
+    static Block *makeForDType(const DType &dtype, ArgsType&&... args);
+
+    /*!
+     * Find the factory path of a copier block for a domain crossing.
+     * Toolkits which provide a memory domain, such as the device memory of an accelerator,
+     * register a selection call into the plugin registry: /framework/domain_copier/[name]
+     * The signature of the call is std::string(const std::string &srcDomain, const std::string &dstDomain),
+     * and it returns the factory path of a copier block for the crossing, or empty to decline.
+     * A domain copier can use asynchronous transfers (such as host to device copies)
+     * which overlap with the computation of the blocks on either side of the crossing.
+     * The selection calls are tried in the order of their names.
+     * \param srcDomain the domain of the upstream port (empty when unknown)
+     * \param dstDomain the domain of the downstream port (empty when unknown)
+     * \return the factory path of a copier, or "/blocks/copier" for the generic copier
+     */
+    static std::string findDomainCopier(const std::string &srcDomain, const std::string &dstDomain);
 };
 
 } //namespace Pothos
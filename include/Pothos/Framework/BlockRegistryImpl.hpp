@@ -10,9 +10,41 @@
 
 #pragma once
 #include <Pothos/Framework/BlockRegistry.hpp>
+#include <Pothos/Framework/Exception.hpp>
 #include <Pothos/Proxy.hpp>
 #include <utility> //std::forward
 
+namespace Pothos {
+namespace Detail {
+
+//! Construct the first block instantiation that matches the element type
+template <template <typename> class BlockType, typename... Types>
+struct BlockDTypeDispatch;
+
+template <template <typename> class BlockType>
+struct BlockDTypeDispatch<BlockType>
+{
+    template <typename... ArgsType>
+    static Block *make(const DType &dtype, ArgsType&&...)
+    {
+        throw DTypeUnknownError("Pothos::BlockRegistry::makeForDType("+dtype.toString()+")", "unsupported element type");
+    }
+};
+
+template <template <typename> class BlockType, typename T, typename... Types>
+struct BlockDTypeDispatch<BlockType, T, Types...>
+{
+    template <typename... ArgsType>
+    static Block *make(const DType &dtype, ArgsType&&... args)
+    {
+        if (dtype.elemType() == DType::of<T>().elemType()) return new BlockType<T>(std::forward<ArgsType>(args)...);
+        return BlockDTypeDispatch<BlockType, Types...>::make(dtype, std::forward<ArgsType>(args)...);
+    }
+};
+
+} //namespace Detail
+} //namespace Pothos
+
 template <typename... ArgsType>
 Pothos::Proxy Pothos::BlockRegistry::make(const std::string &path, ArgsType&&... args)
 {
@@ -20,3 +52,9 @@ Pothos::Proxy Pothos::BlockRegistry::make(const std::string &path, ArgsType&&...
     auto registry = env->findProxy("Pothos/BlockRegistry");
     return registry.call(path, std::forward<ArgsType>(args)...);
 }
+
+template <template <typename> class BlockType, typename... Types, typename... ArgsType>
+Pothos::Block *Pothos::BlockRegistry::makeForDType(const DType &dtype, ArgsType&&... args)
+{
+    return Detail::BlockDTypeDispatch<BlockType, Types...>::make(dtype, std::forward<ArgsType>(args)...);
+}
@@ -4,7 +4,7 @@
 /// BufferAccumulator provides an input pool of buffers.
 ///
 /// \copyright
-/// Copyright (c) 2013-2017 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -83,10 +83,33 @@ public:
      */
     size_t getUniqueManagedBufferCount(void) const;
 
+    /*!
+     * Get the total number of bytes that require() copied.
+     * The count accumulates across clear() for stats purposes.
+     * \return the number of bytes copied into pool buffers
+     */
+    unsigned long long getTotalBytesCopied(void) const;
+
+    //! Get the total number of buffers that require() allocated from the pool
+    unsigned long long getTotalPoolAllocations(void) const;
+
+    //! Get the number of bytes retained by the pool for require()
+    size_t getPooledBytes(void) const;
+
+    //! Get the largest number of buffer chunks enqueued at once
+    size_t getQueueHighWaterMark(void) const;
+
+    //! Get the total number of times that the queue capacity was grown
+    unsigned long long getTotalQueueResizes(void) const;
+
 private:
+    void growQueue(void);
     Util::RingDeque<BufferChunk> _queue;
     size_t _bytesAvailable;
     bool _inPoolBuffer;
+    unsigned long long _totalBytesCopied;
+    size_t _queueHighWaterMark;
+    unsigned long long _totalQueueResizes;
     BufferPool _pool;
 };
 
@@ -107,3 +130,28 @@ inline size_t Pothos::BufferAccumulator::getTotalBytesAvailable(void) const
 {
     return _bytesAvailable;
 }
+
+inline unsigned long long Pothos::BufferAccumulator::getTotalBytesCopied(void) const
+{
+    return _totalBytesCopied;
+}
+
+inline unsigned long long Pothos::BufferAccumulator::getTotalPoolAllocations(void) const
+{
+    return _pool.getTotalAllocations();
+}
+
+inline size_t Pothos::BufferAccumulator::getPooledBytes(void) const
+{
+    return _pool.getPooledBytes();
+}
+
+inline size_t Pothos::BufferAccumulator::getQueueHighWaterMark(void) const
+{
+    return _queueHighWaterMark;
+}
+
+inline unsigned long long Pothos::BufferAccumulator::getTotalQueueResizes(void) const
+{
+    return _totalQueueResizes;
+}
@@ -174,6 +174,16 @@ public:
      */
     size_t useCount(void) const;
 
+    /*!
+     * Assign copies of this buffer chunk to several destinations at once.
+     * The reference counts of the underlying buffers are raised once
+     * by the number of copies rather than once per copy,
+     * such as when a producer posts a buffer to many subscribers.
+     * \param copies an array of buffer chunks to overwrite
+     * \param numCopies the number of elements in the array
+     */
+    void shareInto(BufferChunk *copies, const size_t numCopies) const;
+
     /*!
      * Is this buffer chunk valid?
      * \return true when there is underlying memory
@@ -186,7 +196,14 @@ public:
      */
     void clear(void);
 
-    //! Serialization support
+    /*!
+     * Serialization support.
+     * The length is archived as a 64-bit number and the data in chunks.
+     * When loading into a buffer with at least as many bytes,
+     * such as a front buffer from a BufferManager, the data is read
+     * into that memory, and the length is set to the archived length.
+     * Otherwise, the load allocates a new buffer of the archived length.
+     */
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version);
 
@@ -231,6 +248,39 @@ public:
      */
     size_t convert(const BufferChunk &outBuff, const size_t numElems = 0) const;
 
+    /*!
+     * Convert a buffer chunk to the specified data type with scaling.
+     * Each element is multiplied by the scale factor during conversion.
+     * When saturate is true, results outside of the range of an integer
+     * output type are clamped to the minimum or maximum representable value.
+     * When the number of elements are 0, the entire buffer is converted.
+     * \throws BufferConvertError when the conversion is not possible
+     * \param dtype the data type of the result buffer
+     * \param scale the scale factor applied to each element
+     * \param saturate true to clamp to the output range
+     * \param numElems the number of elements to convert
+     * \return a new buffer chunk with converted elements
+     */
+    BufferChunk convert(const DType &dtype, const double scale, const bool saturate, const size_t numElems = 0) const;
+
+    /*!
+     * Convert a buffer chunk into the specified output buffer with scaling.
+     * Each element is multiplied by the scale factor during conversion.
+     * When saturate is true, results outside of the range of an integer
+     * output type are clamped to the minimum or maximum representable value.
+     * Example: int16 to float with a scale of 1/32768.0 for fixed-point samples,
+     * or float to int16 with a scale of 32767.0 and saturation enabled.
+     * When the number of elements are 0, the entire buffer is converted.
+     * The buffer length should be large enough to contain the entire conversion.
+     * \throws BufferConvertError when the conversion is not possible
+     * \param [out] outBuff the output buffer, also specifies the dtype
+     * \param scale the scale factor applied to each element
+     * \param saturate true to clamp to the output range
+     * \param numElems the number of elements to convert
+     * \return the number of output elements written to the buffer
+     */
+    size_t convert(const BufferChunk &outBuff, const double scale, const bool saturate, const size_t numElems = 0) const;
+
     /*!
      * Convert a buffer chunk of complex elements into two real buffers.
      * When the number of elements are 0, the entire buffer is converted.
@@ -243,6 +293,67 @@ public:
      */
     size_t convertComplex(const BufferChunk &outBuffRe, const BufferChunk &outBuffIm, const size_t numElems = 0) const;
 
+    /*!
+     * Interleave two real buffers into a buffer of complex elements.
+     * This is the reverse of convertComplex(): the real and imaginary
+     * inputs are converted to the complex data type in one pass.
+     * When the number of elements are 0, the entire real buffer is converted.
+     * \throws BufferConvertError when the conversion is not possible
+     * \param inBuffRe the real input buffer
+     * \param inBuffIm the imaginary input buffer of the same dtype
+     * \param dtype the complex data type of the result buffer
+     * \param numElems the number of elements to convert
+     * \return a new buffer chunk with complex elements
+     */
+    static BufferChunk interleave(const BufferChunk &inBuffRe, const BufferChunk &inBuffIm, const DType &dtype, const size_t numElems = 0);
+
+    /*!
+     * Interleave two real buffers into the specified complex output buffer.
+     * When the number of elements are 0, the entire real buffer is converted.
+     * The buffer length should be large enough to contain the entire conversion.
+     * \throws BufferConvertError when the conversion is not possible
+     * \param inBuffRe the real input buffer
+     * \param inBuffIm the imaginary input buffer of the same dtype
+     * \param [out] outBuff the complex output buffer, also specifies the dtype
+     * \param numElems the number of elements to convert
+     * \return the number of output elements written to the buffer
+     */
+    static size_t interleave(const BufferChunk &inBuffRe, const BufferChunk &inBuffIm, const BufferChunk &outBuff, const size_t numElems = 0);
+
+    /*!
+     * Reverse the byte order of each element into a new buffer.
+     * Complex elements swap the real and imaginary components separately.
+     * Use this to convert between the host and the wire byte order.
+     * When the number of elements are 0, the entire buffer is swapped.
+     * \param numElems the number of elements to swap
+     * \return a new buffer chunk of the same dtype with swapped elements
+     */
+    BufferChunk byteswap(const size_t numElems = 0) const;
+
+    /*!
+     * Reverse the byte order of each element into the specified output buffer.
+     * The output buffer may be this buffer to swap the elements in-place.
+     * When the number of elements are 0, the entire buffer is swapped.
+     * \throws BufferConvertError when the output dtype does not match
+     * \param [out] outBuff the output buffer of the same dtype
+     * \param numElems the number of elements to swap
+     * \return the number of output elements written to the buffer
+     */
+    size_t byteswap(const BufferChunk &outBuff, const size_t numElems = 0) const;
+
+    /*!
+     * Convert a buffer chunk of big endian elements to the specified data type.
+     * This is convert() for network byte order inputs such as VITA-49 payloads.
+     * Common wire formats like complex int16 to complex float are converted
+     * in a single vectorized pass, others are swapped and then converted.
+     * When the number of elements are 0, the entire buffer is converted.
+     * \throws BufferConvertError when the conversion is not possible
+     * \param dtype the data type of the result buffer (host byte order)
+     * \param numElems the number of elements to convert
+     * \return a new buffer chunk with converted elements
+     */
+    BufferChunk convertFromBigEndian(const DType &dtype, const size_t numElems = 0) const;
+
 private:
     friend BufferAccumulator;
     ManagedBuffer _managedBuffer;
@@ -348,6 +459,15 @@ inline Pothos::BufferChunk::~BufferChunk(void)
 
 inline Pothos::BufferChunk &Pothos::BufferChunk::operator=(const BufferChunk &other)
 {
+    //the same buffer with the same next buffers holds the same references,
+    //so only the fields change, without atomic operations on the counters
+    if (_managedBuffer == other._managedBuffer and _nextBuffers == other._nextBuffers)
+    {
+        address = other.address;
+        length = other.length;
+        dtype = other.dtype;
+        return *this;
+    }
     _decrNextBuffers();
     address = other.address;
     length = other.length;
@@ -0,0 +1,133 @@
+///
+/// \file Framework/BufferChunkList.hpp
+///
+/// A gather list of buffer chunks, such as the pieces of a frame.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
+#include <cstddef> //size_t
+#include <vector>
+
+namespace Pothos {
+
+/*!
+ * A BufferChunkList is a scatter-gather view of several buffer chunks,
+ * such as the header, payload, and CRC of a frame,
+ * or buffers borrowed from several input ports.
+ * The list holds references to the chunks and does not copy the memory.
+ *
+ * - OutputPort::postBuffer() posts the chunks in order,
+ *   the downstream input port copies only to satisfy a reserve.
+ * - AsyncIO::write() gathers the chunks in one transfer (writev on unix).
+ * - flatten() copies the chunks into contiguous memory when required.
+ *
+ * Example framer, the payload is forwarded without a copy:
+ * \code
+ * Pothos::BufferChunkList frame;
+ * frame.append(makeHeader(payload.length));
+ * frame.append(payload);
+ * frame.append(makeCrc(payload));
+ * this->output(0)->postBuffer(frame);
+ * \endcode
+ */
+class POTHOS_API BufferChunkList
+{
+public:
+    //! Create an empty list
+    BufferChunkList(void);
+
+    //! Create a list with a single chunk
+    BufferChunkList(const BufferChunk &chunk);
+
+    //! Append a chunk to the end of the list, empty chunks are skipped
+    void append(const BufferChunk &chunk);
+
+    //! Append all chunks of another list to the end of this list
+    void append(const BufferChunkList &other);
+
+    //! Remove all chunks from the list
+    void clear(void);
+
+    //! Does the list have no chunks?
+    bool empty(void) const;
+
+    //! The number of chunks in the list
+    size_t size(void) const;
+
+    //! The total length of the chunks in bytes
+    size_t length(void) const;
+
+    //! Get the chunks in order
+    const std::vector<BufferChunk> &chunks(void) const;
+
+    /*!
+     * Get the list as a contiguous buffer.
+     * A single chunk is returned as is, without a copy.
+     * Otherwise, the chunks are copied into a new buffer
+     * with the dtype of the first chunk.
+     * \return a buffer of length() bytes, or null when empty
+     */
+    BufferChunk flatten(void) const;
+
+private:
+    std::vector<BufferChunk> _chunks;
+    size_t _length;
+};
+
+} //namespace Pothos
+
+inline Pothos::BufferChunkList::BufferChunkList(void):
+    _length(0)
+{
+    return;
+}
+
+inline Pothos::BufferChunkList::BufferChunkList(const BufferChunk &chunk):
+    _length(0)
+{
+    this->append(chunk);
+}
+
+inline void Pothos::BufferChunkList::append(const BufferChunk &chunk)
+{
+    if (chunk.length == 0) return;
+    _chunks.push_back(chunk);
+    _length += chunk.length;
+}
+
+inline void Pothos::BufferChunkList::append(const BufferChunkList &other)
+{
+    for (const auto &chunk : other._chunks) this->append(chunk);
+}
+
+inline void Pothos::BufferChunkList::clear(void)
+{
+    _chunks.clear();
+    _length = 0;
+}
+
+inline bool Pothos::BufferChunkList::empty(void) const
+{
+    return _chunks.empty();
+}
+
+inline size_t Pothos::BufferChunkList::size(void) const
+{
+    return _chunks.size();
+}
+
+inline size_t Pothos::BufferChunkList::length(void) const
+{
+    return _length;
+}
+
+inline const std::vector<Pothos::BufferChunk> &Pothos::BufferChunkList::chunks(void) const
+{
+    return _chunks;
+}
@@ -0,0 +1,93 @@
+///
+/// \file Framework/BufferConvert.hpp
+///
+/// Pre-resolved conversion kernels between buffer data types.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework/DType.hpp>
+#include <cstddef>
+
+namespace Pothos {
+namespace BufferConvert {
+
+/*!
+ * A conversion kernel resolved for a particular pair of data types.
+ * BufferChunk::convert() looks up the kernel on every call;
+ * blocks that convert many small buffers can resolve the kernel
+ * once with getKernel(), for example in activate(),
+ * and then call the kernel directly in work().
+ */
+class POTHOS_API Kernel
+{
+public:
+    //! The function type of a conversion over primitive elements
+    typedef void (*Function)(const void *in, void *out, const size_t num);
+
+    //! Create a null kernel
+    Kernel(void);
+
+    //! Create a kernel from a conversion function and data types
+    Kernel(const Function fcn, const DType &inDType, const DType &outDType);
+
+    //! Does this kernel hold a conversion function?
+    explicit operator bool(void) const;
+
+    //! Get the input data type
+    const DType &inputDType(void) const;
+
+    //! Get the output data type
+    const DType &outputDType(void) const;
+
+    /*!
+     * Convert elements from the input memory into the output memory.
+     * The output must have space for the same number of primitive elements.
+     * \param in a pointer to elements of the input data type
+     * \param [out] out a pointer to memory for the output data type
+     * \param numElems the number of input elements to convert
+     */
+    void operator()(const void *in, void *out, const size_t numElems) const;
+
+private:
+    Function _fcn;
+    size_t _primsPerElem;
+    DType _inDType;
+    DType _outDType;
+};
+
+/*!
+ * Get a conversion kernel for the specified input and output types.
+ * \throws BufferConvertError when the conversion is not possible
+ * \param inDType the data type of the input elements
+ * \param outDType the data type of the output elements
+ * \return a kernel that can be called to perform the conversion
+ */
+POTHOS_API Kernel getKernel(const DType &inDType, const DType &outDType);
+
+} //namespace BufferConvert
+} //namespace Pothos
+
+inline Pothos::BufferConvert::Kernel::operator bool(void) const
+{
+    return _fcn != nullptr;
+}
+
+inline const Pothos::DType &Pothos::BufferConvert::Kernel::inputDType(void) const
+{
+    return _inDType;
+}
+
+inline const Pothos::DType &Pothos::BufferConvert::Kernel::outputDType(void) const
+{
+    return _outDType;
+}
+
+inline void Pothos::BufferConvert::Kernel::operator()(const void *in, void *out, const size_t numElems) const
+{
+    _fcn(in, out, numElems*_primsPerElem);
+}
@@ -4,7 +4,7 @@
 /// BufferManager provides an output pool of buffers.
 ///
 /// \copyright
-/// Copyright (c) 2013-2017 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -23,13 +23,42 @@ namespace Pothos {
  */
 struct POTHOS_API BufferManagerArgs
 {
+    //! Create a default BufferManagerArgs
     BufferManagerArgs(void);
 
+    /*!
+     * Create a BufferManagerArgs from a JSON description.
+     * All fields are optional and have defined defaults.
+     *
+     * Example JSON markup for a BufferManagerArgs description:
+     * \code {.json}
+     * {
+     *     "numBuffers" : 8,
+     *     "bufferSize" : 65536,
+     *     "nodeAffinity" : 0,
+     *     "hugePageSize" : 2097152,
+     *     "lockMemory" : false,
+     *     "prefaultMemory" : true,
+     *     "alignment" : 64,
+     *     "padding" : 0,
+     *     "filePath" : "/data/capture.dat",
+     *     "fileMode" : "read",
+     *     "maxBuffers" : 64,
+     *     "shrinkTimeout" : 1.0
+     * }
+     * \endcode
+     * \param json a JSON object markup string
+     */
+    BufferManagerArgs(const std::string &json);
+
     /*!
      * The number of managed buffers available from the manager.
      * Buffers are checked into and out of the manager frequently.
      * A small number of buffers are needed to allow for parallelism,
      * so buffers can be checked out while other buffers are in use.
+     * The circular manager is a byte granular ring of numBuffers*bufferSize bytes:
+     * its front buffer is the entire writable region of the ring,
+     * and numBuffers limits the number of buffers checked out at once.
      * Default: 4 buffers
      */
     size_t numBuffers;
@@ -46,6 +75,90 @@ struct POTHOS_API BufferManagerArgs
      * Default: -1 or unspecified affinity
      */
     long nodeAffinity;
+
+    /*!
+     * The huge page size in bytes for the slab allocation.
+     * Large buffers backed by huge pages (2 MiB or 1 GiB)
+     * reduce the TLB miss overhead of the data path.
+     * When huge pages are not available from the system,
+     * the allocation quietly falls back to normal pages.
+     * Default: 0 or normal pages
+     */
+    size_t hugePageSize;
+
+    /*!
+     * Lock the slab memory into physical RAM during init().
+     * Locked buffers cannot be paged out in realtime applications.
+     * When the lock fails because of system limits,
+     * a warning is logged and the memory remains unlocked.
+     * Default: false
+     */
+    bool lockMemory;
+
+    /*!
+     * Pre-fault the slab memory during init() by touching every page.
+     * This avoids first-touch page faults in the data path
+     * right after the topology is committed.
+     * Default: false
+     */
+    bool prefaultMemory;
+
+    /*!
+     * The alignment in bytes of the start of every buffer from the generic manager,
+     * such as 64 for AVX-512 loads and stores, or 4096 for DMA engines.
+     * The alignment must be a power of two, or 0 for no requirement:
+     * the buffers are then contiguous at multiples of the buffer size
+     * from the start of the slab (which is at least 64 byte aligned).
+     * Default: 0 or no alignment requirement
+     */
+    size_t alignment;
+
+    /*!
+     * The minimum number of bytes between adjacent buffers of the generic manager.
+     * Padding one cache line (64 bytes) keeps a consumer reading the end
+     * of one buffer off the cache line of the producer writing the next buffer.
+     * Buffers separated by padding or alignment gaps are not contiguous,
+     * so the downstream accumulator does not amalgamate adjacent buffers.
+     * Default: 0 bytes of padding
+     */
+    size_t padding;
+
+    /*!
+     * The path of the file for the "file" buffer manager.
+     * The buffers of the file manager are windows of the memory mapped file,
+     * so blocks read and write the file contents without a copy.
+     * This argument is not used by the other managers.
+     * Default: empty, the file manager requires a path
+     */
+    std::string filePath;
+
+    /*!
+     * The access mode of the file for the "file" buffer manager:
+     *  - "read": the buffers replay the contents of an existing file,
+     *    and the manager is empty once the end of the file is reached.
+     *  - "write": the file is created or truncated,
+     *    and the bytes popped from the manager are written to the file.
+     * Default: "read"
+     */
+    std::string fileMode;
+
+    /*!
+     * The maximum number of buffers of the "elastic" buffer manager.
+     * The elastic manager starts with numBuffers in one slab, and allocates
+     * another slab of up to numBuffers when all of its buffers are checked out,
+     * until the total reaches maxBuffers. This argument is not used by the other managers.
+     * Default: 0 or the same as numBuffers, which never grows
+     */
+    size_t maxBuffers;
+
+    /*!
+     * The seconds of low demand before the "elastic" buffer manager releases a slab.
+     * Demand is low while no more than numBuffers are checked out,
+     * after which the newest extra slab is freed as its buffers return.
+     * This argument is not used by the other managers.
+     * Default: 1.0 seconds
+     */
+    double shrinkTimeout;
 };
 
 /*!
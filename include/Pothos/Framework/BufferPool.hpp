@@ -4,22 +4,31 @@
 /// A simple buffer pool with re-usable buffers.
 ///
 /// \copyright
-/// Copyright (c) 2016-2016 Josh Blum
+/// Copyright (c) 2016-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
 #pragma once
 #include <Pothos/Config.hpp>
 #include <Pothos/Framework/BufferChunk.hpp>
+#include <utility> //pair
 #include <vector>
 
 namespace Pothos {
 
 /*!
  * The simple buffer pool holds a collection of re-usable buffers.
+ * Buffers are sorted into power-of-two size classes.
  * When the client requests a particular buffer size from the pool,
  * the pool first looks for an existing and unused buffer
- * that matches the requested size, or allocates a new buffer.
+ * in the matching size class, or allocates a new buffer.
+ *
+ * The pool retains a bounded number of buffers per size class
+ * and overall. Unused buffers that have not been requested recently
+ * are trimmed from the pool, least recently used first, so that
+ * a burst of large requests does not inflate the pool permanently.
+ * When every retained buffer is still referenced downstream,
+ * the pool hands out a new buffer without retaining it.
  */
 class POTHOS_API BufferPool
 {
@@ -38,11 +47,33 @@ public:
      * \param numBytes the size of the requested buffer in bytes
      * \return an available buffer chunk of at least numBytes size
      */
-    const Pothos::BufferChunk &get(const size_t numBytes);
+    Pothos::BufferChunk get(const size_t numBytes);
+
+    /*!
+     * Get the total number of buffers allocated by the pool.
+     * The count accumulates across clear() for stats purposes.
+     */
+    unsigned long long getTotalAllocations(void) const;
+
+    /*!
+     * Get the total number of requests served by a retained buffer.
+     * The count accumulates across clear() for stats purposes.
+     */
+    unsigned long long getTotalReuses(void) const;
+
+    //! Get the number of bytes held by the retained buffers
+    size_t getPooledBytes(void) const;
 
 private:
-    size_t _minBuffSize;
-    std::vector<Pothos::BufferChunk> _buffs;
+    void trim(void);
+    unsigned long long _ticks;
+    unsigned long long _totalAllocations;
+    unsigned long long _totalReuses;
+    size_t _numEntries;
+    size_t _pooledBytes;
+
+    //buffers per size class, paired with the tick of their last use
+    std::vector<std::vector<std::pair<Pothos::BufferChunk, unsigned long long>>> _classes;
 };
 
 } //namespace Pothos
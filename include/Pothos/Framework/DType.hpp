@@ -4,17 +4,53 @@
 /// This file contains the definition for the DType object.
 ///
 /// \copyright
-/// Copyright (c) 2014-2017 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 ///                    2019 Nicholas Corgan
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
 #pragma once
 #include <Pothos/Config.hpp>
+#include <type_traits>
 #include <typeinfo>
+#include <complex>
 #include <string>
 
 namespace Pothos {
+namespace Detail {
+
+/*!
+ * Compile-time element type codes for DType::of<T>().
+ * The codes match the element type table in lib/Framework/DType.cpp:
+ * signed=2, integer=4, float=8, complex=16, log2(bytes) << 5.
+ * The packed flag 128 is only used by the packed sample types.
+ */
+template <typename T>
+struct DTypeElemCode
+{
+    static_assert(std::is_arithmetic<T>::value and not std::is_same<T, bool>::value,
+        "DType::of<T>() requires an integer, floating point, or complex type");
+    static_assert(sizeof(T) == 1 or sizeof(T) == 2 or sizeof(T) == 4 or sizeof(T) == 8,
+        "DType::of<T>() requires a 1, 2, 4, or 8 byte element type");
+    static constexpr unsigned char code(void)
+    {
+        //plain char is always the signed int8 type, as in the alias table
+        return (((std::is_signed<T>::value or std::is_same<T, char>::value) and std::is_integral<T>::value)?2:0) |
+            (std::is_integral<T>::value?4:8) |
+            ((sizeof(T) == 1)?0:(sizeof(T) == 2)?(1 << 5):(sizeof(T) == 4)?(2 << 5):(3 << 5));
+    }
+};
+
+template <typename T>
+struct DTypeElemCode<std::complex<T>>
+{
+    static constexpr unsigned char code(void)
+    {
+        return 16 | DTypeElemCode<T>::code();
+    }
+};
+
+} //namespace Detail
 
 /*!
  * DType provides meta-information about a data type.
@@ -31,6 +67,16 @@ namespace Pothos {
  *  - float, double, float32, float64
  *  - complex_[known_type]
  *  - complex64, complex128
+ *  - sc8, sc16 for complex_int8, complex_int16
+ *
+ * Packed sample types for wire formats:
+ *  - complex_int12 or sc12: 3 bytes per sample, a little endian 24-bit word
+ *    with the real part in the low 12 bits and the imaginary in the high 12 bits
+ *  - complex_int4 or sc4: 1 byte per sample, the real part in the low nibble
+ *    and the imaginary part in the high nibble
+ *
+ * Packed samples are not C++ types: use BufferChunk::convert()
+ * to unpack them into complex integers or floats where needed.
  *
  * Special name strings:
  *  - empty string for an unspecified size-zero data type
@@ -88,6 +134,22 @@ public:
      */
     static DType fromDType(const DType &dtype, const size_t dimension);
 
+    /*!
+     * Create a DType for a compile-time known element type.
+     * The element type and size are resolved at compile time,
+     * so this avoids the type table lookups of DType(typeid(T)).
+     * Supported types are the primitive integer and floating point types
+     * and std::complex of those types; others fail to compile.
+     * The result can be passed to any API that takes a DType:
+     * \code
+     * this->setupInput(0, Pothos::DType::of<std::complex<float>>());
+     * \endcode
+     * \tparam T a primitive numeric type or std::complex of one
+     * \param dimension the number of elements per type
+     */
+    template <typename T>
+    static constexpr DType of(const size_t dimension = 1);
+
     /*!
      * Get a name that describes an element.
      * Example: int32, uint16, complex_float32, etc...
@@ -95,16 +157,16 @@ public:
     const std::string &name(void) const;
 
     //! Get the element type descriptor
-    unsigned char elemType(void) const;
+    constexpr unsigned char elemType(void) const;
 
     //! Get the size of a single element in bytes
-    unsigned char elemSize(void) const;
+    constexpr unsigned char elemSize(void) const;
 
     //! Get the dimensionality of this type
-    size_t dimension(void) const;
+    constexpr size_t dimension(void) const;
 
     //! Get the size of this DType in bytes
-    size_t size(void) const;
+    constexpr size_t size(void) const;
 
     //! Create a printable string representation
     std::string toString(void) const;
@@ -151,11 +213,18 @@ public:
      */
     bool isComplex(void) const;
 
+    /*!
+     * Does this dtype represent packed samples?
+     * \return true for the sub-byte and 12-bit packed types like sc12
+     */
+    bool isPacked(void) const;
+
     //! Serialization support
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version);
 
 private:
+    constexpr DType(const unsigned char elemType, const unsigned char elemSize, const size_t dimension);
     size_t _dimension;
     unsigned char _elemType;
     unsigned char _elemSize;
@@ -189,22 +258,35 @@ inline Pothos::DType::DType(void):
     return;
 }
 
-inline unsigned char Pothos::DType::elemType(void) const
+inline constexpr Pothos::DType::DType(const unsigned char elemType, const unsigned char elemSize, const size_t dimension):
+    _dimension(dimension),
+    _elemType(elemType),
+    _elemSize(elemSize)
+{
+}
+
+template <typename T>
+constexpr Pothos::DType Pothos::DType::of(const size_t dimension)
+{
+    return DType(Detail::DTypeElemCode<T>::code(), static_cast<unsigned char>(sizeof(T)), dimension);
+}
+
+inline constexpr unsigned char Pothos::DType::elemType(void) const
 {
     return _elemType;
 }
 
-inline unsigned char Pothos::DType::elemSize(void) const
+inline constexpr unsigned char Pothos::DType::elemSize(void) const
 {
     return _elemSize;
 }
 
-inline size_t Pothos::DType::dimension(void) const
+inline constexpr size_t Pothos::DType::dimension(void) const
 {
     return _dimension;
 }
 
-inline size_t Pothos::DType::size(void) const
+inline constexpr size_t Pothos::DType::size(void) const
 {
     return _elemSize*_dimension;
 }
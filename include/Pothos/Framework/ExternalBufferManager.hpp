@@ -0,0 +1,136 @@
+///
+/// \file Framework/ExternalBufferManager.hpp
+///
+/// A buffer manager for externally owned memory such as DMA buffers.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework/BufferManager.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <map>
+
+namespace Pothos {
+
+/*!
+ * ExternalBuffer describes memory owned by a device driver or library.
+ */
+struct POTHOS_API ExternalBuffer
+{
+    //! Create a null ExternalBuffer
+    ExternalBuffer(void);
+
+    //! Create an ExternalBuffer from a memory region and a driver handle
+    ExternalBuffer(const size_t address, const size_t length, const size_t handle);
+
+    //! The address of the first byte of the memory
+    size_t address;
+
+    //! The length of the memory in bytes
+    size_t length;
+
+    //! The identifier of the memory in the driver (such as a DMA buffer index)
+    size_t handle;
+};
+
+/*!
+ * ExternalBufferManager hands out a pool of externally owned buffers,
+ * so memory from a device (such as DMA buffers or GPU pinned memory)
+ * flows through ManagedBuffer to downstream blocks without a copy.
+ * A driver block typically creates the manager and provides it
+ * through Block::getOutputBufferManager(), the framework calls init().
+ * The manager is also registered under the factory name "external",
+ * the callbacks and buffers must be configured before init() in that case.
+ *
+ * The buffer cycle has two callbacks:
+ *  - Acquire: the manager asks the driver for the handle of the next buffer,
+ *    such as a receive buffer that the device has filled.
+ *    The callback is polled while the manager has no front buffer,
+ *    which happens before each call to work() of the driver block.
+ *    A driver that waits on its device should yield() in work().
+ *    Without an acquire callback, every released buffer is ready again,
+ *    in the order that the buffers are released.
+ *  - Release: the downstream blocks released the buffer,
+ *    the driver can return the buffer to the device.
+ *    The number of bytes is the amount that was popped from the manager.
+ *
+ * The entire front buffer is checked out on each pop,
+ * since a device buffer cannot be shared by two transfers.
+ */
+class POTHOS_API ExternalBufferManager :
+    public BufferManager,
+    public std::enable_shared_from_this<ExternalBufferManager>
+{
+public:
+    typedef std::shared_ptr<ExternalBufferManager> Sptr;
+
+    /*!
+     * The acquire callback sets the handle of the next buffer.
+     * \return true when a buffer was acquired, false to retry later
+     */
+    typedef std::function<bool(size_t &handle)> AcquireFcn;
+
+    //! The release callback receives the handle and the number of bytes popped
+    typedef std::function<void(const size_t handle, const size_t numBytes)> ReleaseFcn;
+
+    /*!
+     * Make a new external buffer manager.
+     * \param buffers the pool of external buffers, each with a unique handle
+     * \param release the callback when a buffer is released (may be empty)
+     * \param acquire the callback to acquire the next buffer (may be empty)
+     * \param owner an optional object kept alive while the buffers are in use
+     * \return a new uninitialized buffer manager
+     */
+    static Sptr make(
+        const std::vector<ExternalBuffer> &buffers,
+        const ReleaseFcn &release = ReleaseFcn(),
+        const AcquireFcn &acquire = AcquireFcn(),
+        const std::shared_ptr<void> &owner = std::shared_ptr<void>());
+
+    //! Create an unconfigured manager, use the setters before init()
+    ExternalBufferManager(void);
+
+    //! Set the pool of buffers and an optional owner object
+    void setBuffers(const std::vector<ExternalBuffer> &buffers, const std::shared_ptr<void> &owner = std::shared_ptr<void>());
+
+    //! Set the callback to acquire the next buffer
+    void setAcquireCallback(const AcquireFcn &acquire);
+
+    //! Set the callback when a buffer is released
+    void setReleaseCallback(const ReleaseFcn &release);
+
+    /*!
+     * Wrap the buffers, the arguments are not used.
+     * \throws BufferManagerFactoryError for duplicate handles
+     */
+    void init(const BufferManagerArgs &args);
+
+    //! Empty when no buffer is acquired, polls the acquire callback
+    bool empty(void) const;
+
+    void pop(const size_t numBytes);
+
+    void push(const ManagedBuffer &buff);
+
+private:
+    bool acquireFront(void);
+
+    std::vector<ExternalBuffer> _buffers;
+    std::shared_ptr<void> _owner;
+    AcquireFcn _acquire;
+    ReleaseFcn _release;
+    std::map<size_t, size_t> _handleToIndex;
+    std::vector<ManagedBuffer> _idleBuffs; //by index, buffers not checked out
+    std::vector<size_t> _poppedBytes; //by index
+    std::deque<size_t> _readyIndexes; //released order without acquire
+    ManagedBuffer _frontBuff;
+};
+
+} //namespace Pothos
@@ -4,7 +4,7 @@
 /// This file provides an interface for a worker's input port.
 ///
 /// \copyright
-/// Copyright (c) 2014-2017 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -17,7 +17,12 @@
 #include <Pothos/Framework/BufferAccumulator.hpp>
 #include <Pothos/Util/RingDeque.hpp>
 #include <Pothos/Util/SpinLock.hpp>
+#include <Pothos/Util/SPSCQueue.hpp>
+#include <Pothos/Util/LatencyHistogram.hpp>
 #include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
 
 namespace Pothos {
 
@@ -163,10 +168,67 @@ public:
      * Note that work() may still be called when the reserve is not met,
      * because the scheduler will only prevent work() from being called
      * when all ports fail to meet their respective reserve requirements.
+     * When the reserve is set before the topology commit, an upstream
+     * port without a custom buffer manager is given a circular manager,
+     * so that the reserve is met in place rather than copied together.
      * \param numElements the number of elements to require
      */
     void setReserve(const size_t numElements);
 
+    /*!
+     * Declare the fixed number of elements consumed by each call to work().
+     * A fused group whose inner connections declare fixed rates on both ends
+     * runs a static schedule, see Topology::setFusedGroup().
+     * By default, the rate is zero elements, a dynamic rate.
+     * \param numElements the elements consumed per work() call or 0 for dynamic
+     */
+    void setStaticRate(const size_t numElements);
+
+    //! Get the declared elements per work() call (0 for dynamic)
+    size_t staticRate(void) const;
+
+    /*!
+     * Set a minimum batch on this input port to avoid tiny calls to work().
+     * The scheduler holds off calling work() for this port until the port
+     * has at least the batch number of elements across its queued buffers,
+     * or until the oldest held elements have waited for the latency budget.
+     * Unlike the reserve, the batch does not need to be contiguous,
+     * so the batch causes no copies to present the elements in one buffer,
+     * and work() may see the batch over several calls as the buffers allow.
+     * The wait uses the block's scheduled wakeup rather than a timer thread,
+     * and replaces a wakeup that the block scheduled itself with scheduleWakeup().
+     * Like the reserve, work() is still called when another port is ready,
+     * and when the port has an input message.
+     * By default, the batch is zero elements and the port is not batched.
+     * \param numElements the batch size in elements or 0 to disable batching
+     * \param latencyUs the maximum wait in microseconds, 0 to wait for the full batch
+     */
+    void setMinBatch(const size_t numElements, const unsigned long long latencyUs);
+
+    /*!
+     * Set the capacity of the message and slot call queues on this port.
+     * Upstream blocks that post messages to this port stall their work()
+     * while the queue holds this many entries, so that messages wait upstream
+     * for resources rather than overflowing the queue and being dropped.
+     * Messages posted in a single call to work() may exceed the capacity.
+     * By default, each input port has a capacity of 1024 messages.
+     * \param numMessages the number of enqueued messages before stalling
+     */
+    void setMessageCapacity(const size_t numMessages);
+
+    /*!
+     * Make this port a lossy reader that never throttles its producers.
+     * When the port holds more than the given number of posted buffers,
+     * the oldest buffers are dropped by the producer as new buffers arrive,
+     * which returns the memory to the upstream buffer manager right away.
+     * Use a lossy reader for monitoring consumers like plotters and probes
+     * so that a slow subscriber of a fan-out does not stall the data path.
+     * Labels on the dropped bytes are dropped with them.
+     * By default, the depth is zero and the port is lossless.
+     * \param numBuffers the maximum number of held buffers or 0 for lossless
+     */
+    void setLossyDepth(const size_t numBuffers);
+
     /*!
      * Is this port used for signal handling in a signals + slots paradigm?
      */
@@ -206,6 +268,7 @@ private:
 
     //port configuration
     bool _isSlot;
+    bool _slotLatestOnly;
     int _index;
     std::string _name;
     std::string _alias;
@@ -227,9 +290,23 @@ private:
     size_t _pendingElements;
     size_t _reserveElements;
 
+    //minimum batch policy, the deadline for the held elements,
+    //and the consumed element count at the end of the released batch
+    size_t _minBatchElements;
+    std::chrono::microseconds _batchLatency;
+    bool _batchPending;
+    std::chrono::steady_clock::time_point _batchDeadline;
+    unsigned long long _batchReleaseEnd;
+
+    //declared elements per work() call for static schedules
+    size_t _staticRate;
+
     //counts work actions which we will use to establish activity
     size_t _workEvents;
 
+    //message queue size that stalls the upstream producers
+    std::atomic<size_t> _messageCapacity;
+
     Util::SpinLock _asyncMessagesLock;
     Util::RingDeque<std::pair<Object, BufferChunk>> _asyncMessages;
 
@@ -242,6 +319,26 @@ private:
     Util::SpinLock _bufferAccumulatorLock;
     BufferAccumulator _bufferAccumulator;
 
+    //lock-free buffer handoff in front of the accumulator:
+    //a producer that wins the flag pushes without the accumulator lock,
+    //and the ring is drained into the accumulator while holding that lock,
+    //the ring is made by the first locked push, so ports without stream buffers never make one
+    typedef Util::SPSCQueue<std::pair<BufferChunk, unsigned long long>> BufferHandoff;
+    std::atomic_flag _bufferHandoffProducer;
+    std::atomic<BufferHandoff *> _bufferHandoff;
+
+    //buffer residency tracking: arrival stamps keyed by the end byte offset
+    //of each posted buffer, recorded into the histogram once fully consumed
+    unsigned long long _totalBytesPushed;
+    unsigned long long _totalBytesPopped;
+    Util::RingDeque<std::pair<unsigned long long, unsigned long long>> _residencyStamps;
+    std::unique_ptr<Util::LatencyHistogram> _residencyHistogram; //made upon the first stamped buffer
+
+    //lossy reader: end byte offsets of the held buffers, oldest first
+    std::atomic<size_t> _lossyDepth;
+    Util::RingDeque<unsigned long long> _lossyBufferEnds;
+    unsigned long long _totalBytesDropped;
+
     std::vector<OutputPort *> _subscribers;
 
     /////// async message interface /////////
@@ -251,6 +348,10 @@ private:
     Object asyncMessagesPeek(void);
     void asyncMessagesClear(void);
 
+    /////// message backpressure interface /////////
+    bool messageQueuesFull(void);
+    void messageCapacityReleased(void);
+
     /////// slot call interface /////////
     void slotCallsPush(const Object &args, const BufferChunk &token);
     bool slotCallsEmpty(void);
@@ -264,14 +365,18 @@ private:
     /////// input buffer interface /////////
     void bufferAccumulatorFront(BufferChunk &);
     void bufferAccumulatorPush(const BufferChunk &buffer);
-    void bufferAccumulatorPushNoLock(BufferChunk &&buffer);
+    void bufferAccumulatorPushNoLock(BufferChunk &&buffer, const unsigned long long stamp = 0);
     void bufferAccumulatorPop(const size_t numBytes);
     void bufferAccumulatorRequire(const size_t numBytes);
     void bufferAccumulatorClear(void);
+    void bufferHandoffDrainNoLock(void);
+    void bufferAccumulatorDropNoLock(const size_t numBytes);
 
     /////// combined label association push /////////
+    //the buffers are always moved in, the labels are moved only when requested,
+    //the caller flags the actor after pushing to all of its subscribers
     void bufferLabelPush(
-        const bool enableMove,
+        const bool moveLabels,
         std::vector<Label> &postedLabels,
         Util::RingDeque<BufferChunk> &postedBuffers);
 
@@ -10,7 +10,9 @@
 
 #pragma once
 #include <Pothos/Framework/InputPort.hpp>
+#include <algorithm> //max
 #include <mutex> //lock_guard
+#include <initializer_list>
 
 inline int Pothos::InputPort::index(void) const
 {
@@ -115,6 +117,16 @@ inline void Pothos::InputPort::removeLabel(const Label &label)
     }
 }
 
+inline void Pothos::InputPort::setStaticRate(const size_t numElements)
+{
+    _staticRate = numElements;
+}
+
+inline size_t Pothos::InputPort::staticRate(void) const
+{
+    return _staticRate;
+}
+
 inline void Pothos::InputPort::setReserve(const size_t numElements)
 {
     //only mark this change when setting a larger reserve
@@ -123,6 +135,23 @@ inline void Pothos::InputPort::setReserve(const size_t numElements)
     _reserveElements = numElements;
 }
 
+inline void Pothos::InputPort::setMinBatch(const size_t numElements, const unsigned long long latencyUs)
+{
+    //a smaller batch may release the held elements
+    if (numElements < _minBatchElements) _workEvents++;
+
+    _minBatchElements = numElements;
+    _batchLatency = std::chrono::microseconds(latencyUs);
+    _batchPending = false;
+    _batchReleaseEnd = _totalElements;
+}
+
+inline void Pothos::InputPort::setMessageCapacity(const size_t numMessages)
+{
+    _messageCapacity.store(std::max<size_t>(numMessages, 1), std::memory_order_relaxed);
+    this->messageCapacityReleased();
+}
+
 inline bool Pothos::InputPort::asyncMessagesEmpty(void)
 {
     std::lock_guard<Util::SpinLock> lock(_asyncMessagesLock);
@@ -131,10 +160,16 @@ inline bool Pothos::InputPort::asyncMessagesEmpty(void)
 
 inline Pothos::Object Pothos::InputPort::asyncMessagesPop(void)
 {
-    std::lock_guard<Util::SpinLock> lock(_asyncMessagesLock);
-    if (_asyncMessages.empty()) return Pothos::Object();
-    auto msg = std::move(_asyncMessages.front().first);
-    _asyncMessages.pop_front();
+    Pothos::Object msg;
+    bool wasFull = false;
+    {
+        std::lock_guard<Util::SpinLock> lock(_asyncMessagesLock);
+        if (_asyncMessages.empty()) return Pothos::Object();
+        wasFull = _asyncMessages.size() >= _messageCapacity.load(std::memory_order_relaxed);
+        msg = std::move(_asyncMessages.front().first);
+        _asyncMessages.pop_front();
+    }
+    if (wasFull) this->messageCapacityReleased();
     return msg;
 }
 
@@ -150,6 +185,7 @@ inline void Pothos::InputPort::inlineMessagesPush(const Pothos::Label &label)
     std::lock_guard<Util::SpinLock> lock(_bufferAccumulatorLock);
     if (_inputInlineMessages.full()) _inputInlineMessages.set_capacity(_inputInlineMessages.capacity()*2);
     _inputInlineMessages.push_back(label);
+    _inputInlineMessages.back().index += _totalBytesPopped; //absolute byte offset
 }
 
 inline void Pothos::InputPort::inlineMessagesClear(void)
@@ -162,11 +198,22 @@ inline void Pothos::InputPort::inlineMessagesClear(void)
 inline void Pothos::InputPort::bufferAccumulatorFront(Pothos::BufferChunk &buff)
 {
     std::lock_guard<Util::SpinLock> lock(_bufferAccumulatorLock);
-    while (not _inputInlineMessages.empty())
+    this->bufferHandoffDrainNoLock();
+    if (not _inputInlineMessages.empty())
     {
-        _inlineMessages.push_back(std::move(_inputInlineMessages.front()));
-        _inlineMessages.back().adjust(1, this->dtype().size());
-        _inputInlineMessages.pop_front();
+        //convert the absolute byte offsets into element indexes for the front buffer
+        _inlineMessages.reserve(_inlineMessages.size() + _inputInlineMessages.size());
+        const size_t elemSize = this->dtype().size();
+        for (const auto &span : {_inputInlineMessages.front_span(), _inputInlineMessages.back_span()})
+        {
+            for (auto &label : span)
+            {
+                _inlineMessages.push_back(std::move(label));
+                _inlineMessages.back().index -= _totalBytesPopped;
+                _inlineMessages.back().adjust(1, elemSize);
+            }
+        }
+        _inputInlineMessages.clear();
     }
     buff = _bufferAccumulator.front();
 }
@@ -174,17 +221,23 @@ inline void Pothos::InputPort::bufferAccumulatorFront(Pothos::BufferChunk &buff)
 inline void Pothos::InputPort::bufferAccumulatorPush(const BufferChunk &buffer)
 {
     std::lock_guard<Util::SpinLock> lock(_bufferAccumulatorLock);
+    this->bufferHandoffDrainNoLock();
     this->bufferAccumulatorPushNoLock(BufferChunk(buffer));
 }
 
 inline void Pothos::InputPort::bufferAccumulatorRequire(const size_t numBytes)
 {
     std::lock_guard<Util::SpinLock> lock(_bufferAccumulatorLock);
+    this->bufferHandoffDrainNoLock();
     _bufferAccumulator.require(numBytes);
 }
 
 inline void Pothos::InputPort::bufferAccumulatorClear(void)
 {
     std::lock_guard<Util::SpinLock> lock(_bufferAccumulatorLock);
+    this->bufferHandoffDrainNoLock();
     _bufferAccumulator = BufferAccumulator();
+    _residencyStamps.clear();
+    _lossyBufferEnds.clear();
+    _totalBytesPopped = _totalBytesPushed;
 }
@@ -4,7 +4,7 @@
 /// Label and associated classes for decorating a stream of elements.
 ///
 /// \copyright
-/// Copyright (c) 2014-2015 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 ///                    2019 Nicholas Corgan
 /// SPDX-License-Identifier: BSL-1.0
 ///
@@ -12,6 +12,7 @@
 #pragma once
 #include <Pothos/Config.hpp>
 #include <Pothos/Object/Object.hpp>
+#include <Pothos/Util/Atom.hpp>
 #include <string>
 
 namespace Pothos {
@@ -31,6 +32,14 @@ public:
     template <typename ValueType>
     Label(const std::string &id, ValueType &&data, const unsigned long long index, const size_t width = 1);
 
+    //! Create a label with specified data of ValueType and index
+    template <typename ValueType>
+    Label(const char *id, ValueType &&data, const unsigned long long index, const size_t width = 1);
+
+    //! Create a label with an interned identifier, data of ValueType, and index
+    template <typename ValueType>
+    Label(const Util::Atom &id, ValueType &&data, const unsigned long long index, const size_t width = 1);
+
     /*!
      * Create a new label with an adjusted index and width.
      * Example convert bytes to elements: newLbl = lbl.toAdjusted(1, elemSize);
@@ -59,6 +68,22 @@ public:
      */
     std::string id;
 
+    /*!
+     * Get the identifier as an interned atom.
+     * Atoms compare and hash as integers, so hot loops can match labels
+     * against a set of static atoms or dispatch on them with a table lookup:
+     * \code
+     * static const Pothos::Util::Atom rxTime("rxTime");
+     * for (const auto &label : inPort->labels())
+     * {
+     *     if (label.atom() == rxTime) ...
+     * }
+     * \endcode
+     * The atom is cached with the label, and it is interned again
+     * when the id string was assigned since the last call.
+     */
+    const Util::Atom &atom(void) const;
+
     /*!
      * The data can be anything that can be held by Object.
      */
@@ -84,6 +109,9 @@ public:
     //! Serialization support
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version);
+
+private:
+    mutable Util::Atom _atom;
 };
 
 //! Are these two labels equivalent? all fields must be equal
@@ -137,6 +165,30 @@ Pothos::Label::Label(const std::string &id, ValueType &&data, const unsigned lon
     return;
 }
 
+template <typename ValueType>
+Pothos::Label::Label(const char *id, ValueType &&data, const unsigned long long index, const size_t width):
+    Label(std::string(id), std::forward<ValueType>(data), index, width)
+{
+    return;
+}
+
+template <typename ValueType>
+Pothos::Label::Label(const Util::Atom &id, ValueType &&data, const unsigned long long index, const size_t width):
+    id(id.str()),
+    data(Object(std::forward<ValueType>(data))),
+    index(index),
+    width(width),
+    _atom(id)
+{
+    return;
+}
+
+inline const Pothos::Util::Atom &Pothos::Label::atom(void) const
+{
+    if (_atom.str() != id) _atom = Util::Atom(id);
+    return _atom;
+}
+
 template <typename MultType, typename DivType>
 Pothos::Label Pothos::Label::toAdjusted(const MultType &mult, const DivType &div) const
 {
@@ -149,6 +149,8 @@ struct Pothos::ManagedBuffer::Impl
 {
     Impl(void);
 
+    static Impl *make(void);
+
     std::atomic<int> counter;
     std::weak_ptr<BufferManager> weakManager;
     SharedBuffer buffer;
@@ -221,6 +223,8 @@ inline Pothos::ManagedBuffer::ManagedBuffer(ManagedBuffer &&obj) noexcept:
 
 inline Pothos::ManagedBuffer &Pothos::ManagedBuffer::operator=(const ManagedBuffer &obj)
 {
+    //re-assigning the same buffer (such as a front buffer each work call) is free
+    if (_impl == obj._impl) return *this;
     if (_impl != nullptr) _impl->decr();
     this->_impl = obj._impl;
     if (_impl != nullptr) _impl->incr();
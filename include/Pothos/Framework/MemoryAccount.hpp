@@ -0,0 +1,124 @@
+///
+/// \file Framework/MemoryAccount.hpp
+///
+/// Accounting and budgets for the memory of shared buffers.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <memory>
+#include <string>
+#include <map>
+
+namespace Pothos {
+
+struct MemoryAccountCharge;
+
+/*!
+ * A MemoryAccount tracks the bytes held by SharedBuffer allocations,
+ * such as the slabs of buffer managers, BufferPool and BufferAccumulator
+ * pool buffers, and buffers that blocks allocate in work().
+ * The allocations are charged to the account of the calling thread,
+ * and to each parent account up to the global account of the process.
+ * The worker charges the allocations of a block to the account of the block,
+ * and the account of a block is a child of its topology's account.
+ *
+ * An account with a budget throws SharedBufferError on an allocation
+ * that would exceed the budget, so a buffer manager fails to initialize,
+ * and a pool that grows behind a stalled consumer fails in work()
+ * rather than exhausting the memory of the machine.
+ */
+class POTHOS_API MemoryAccount
+{
+public:
+    typedef std::shared_ptr<MemoryAccount> Sptr;
+
+    //! The account of every shared buffer in this process
+    static const Sptr &global(void);
+
+    /*!
+     * Get an account by name, the account is created under the global account.
+     * Named accounts are shared in the process, such as the account of a topology.
+     */
+    static Sptr get(const std::string &name);
+
+    /*!
+     * Make a new account, such as the account of a block.
+     * \param name the name of the account for display
+     * \param parent the parent account, also charged for every allocation
+     */
+    static Sptr make(const std::string &name, const Sptr &parent = global());
+
+    //! Get the name of this account
+    const std::string &name(void) const;
+
+    //! Set the parent for future allocations (null for the global account)
+    void setParent(const Sptr &parent);
+
+    //! Set the budget in bytes (0 for no budget)
+    void setBudget(const size_t numBytes);
+
+    //! Get the budget in bytes (0 for no budget)
+    size_t getBudget(void) const;
+
+    //! The number of bytes currently allocated
+    size_t bytes(void) const;
+
+    /*!
+     * Get the statistics of this account as a JSON object string:
+     * bytes, peakBytes, budget, numAllocations, numFailures,
+     * and the current bytes keyed by container type and NUMA node.
+     */
+    std::string toJSON(void) const;
+
+    /*!
+     * Charge an allocation to the account of the calling thread.
+     * This is used by the SharedBuffer factories.
+     * \throws SharedBufferError when the allocation exceeds a budget
+     * \param numBytes the number of bytes allocated
+     * \param type the type of container, such as "generic" or "circular"
+     * \param nodeAffinity the NUMA node of the allocation or -1
+     * \return a token which releases the allocation when deleted
+     */
+    static std::shared_ptr<void> charge(const size_t numBytes, const std::string &type, const long nodeAffinity);
+
+    /*!
+     * Scope charges the allocations of the calling thread to an account.
+     * The previous account of the thread is restored when the scope exits.
+     */
+    class POTHOS_API Scope
+    {
+    public:
+        //! Charge allocations in this thread to the account
+        Scope(const Sptr &account);
+
+        //! Restore the previous account
+        ~Scope(void);
+
+    private:
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+        Sptr _previous;
+    };
+
+    //! Create an account, use make() or get()
+    MemoryAccount(const std::string &name, const Sptr &parent);
+
+private:
+    friend struct MemoryAccountCharge;
+    const std::string _name;
+    Sptr _parent;
+    size_t _budget;
+    size_t _bytes;
+    size_t _peakBytes;
+    unsigned long long _numAllocations;
+    unsigned long long _numFailures;
+    std::map<std::string, size_t> _bytesByType;
+    std::map<long, size_t> _bytesByNode;
+};
+
+} //namespace Pothos
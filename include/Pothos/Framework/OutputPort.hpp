@@ -15,15 +15,19 @@
 #include <Pothos/Framework/Label.hpp>
 #include <Pothos/Framework/BufferPool.hpp>
 #include <Pothos/Framework/BufferChunk.hpp>
+#include <Pothos/Framework/BufferChunkList.hpp>
 #include <Pothos/Framework/BufferManager.hpp>
 #include <Pothos/Util/RingDeque.hpp>
 #include <Pothos/Util/SpinLock.hpp>
+#include <type_traits>
 #include <string>
+#include <vector>
 
 namespace Pothos {
 
 class WorkerActor;
 class InputPort;
+template <typename... ArgsType> class SignalHandle;
 
 /*!
  * OutputPort provides methods to interact with a worker's output ports.
@@ -139,6 +143,31 @@ public:
      */
     BufferChunk getBuffer(const DType &dtype, const size_t numElements);
 
+    /*!
+     * Get a packet with a payload of a specified size in elements.
+     * The payload comes from getBuffer(), so it uses the front buffer
+     * of this output port and falls back to a reusable pool.
+     * The packet is recycled from packets previously posted on this port
+     * once the downstream consumers have released them, which reuses
+     * the object container and the label storage of the packet.
+     * The returned Object holds a Packet with empty metadata and labels;
+     * fill it in with ref<Packet>() and post it with postMessage().
+     * \post buffer() has undefined behavior after this call.
+     * \param numElements the number of payload elements given the port's type
+     * \return an Object holding a Packet with the specified payload length
+     */
+    Object getPacket(const size_t numElements);
+
+    /*!
+     * Get a packet with a payload of a specified size and type.
+     * This variant provides a user specified payload type.
+     * \post buffer() has undefined behavior after this call.
+     * \param dtype the payload's type (independent of port type)
+     * \param numElements the number of payload elements of type dtype
+     * \return an Object holding a Packet with the specified payload length
+     */
+    Object getPacket(const DType &dtype, const size_t numElements);
+
     /*!
      * Post an output label to the subscribers on this port.
      * postLabel also supports move and emplacement semantics.
@@ -180,9 +209,18 @@ public:
      * Do not call produce() when using postBuffer().
      * \param buffer the buffer to post
      */
-    template <typename ValueType>
+    template <typename ValueType, typename = typename std::enable_if<
+        not std::is_same<typename std::decay<ValueType>::type, BufferChunkList>::value>::type>
     void postBuffer(ValueType &&buffer);
 
+    /*!
+     * Post the chunks of a gather list to the subscribers on this port.
+     * The chunks are posted in order as individual buffers without a copy,
+     * the downstream input port copies only when a reserve requires it.
+     * \param buffers the list of buffers to post
+     */
+    void postBuffer(const BufferChunkList &buffers);
+
     /*!
      * Set a reserve requirement on this output port.
      * The reserve size ensures that when sufficient resources are available,
@@ -197,6 +235,28 @@ public:
      */
     void setReserve(const size_t numElements);
 
+    /*!
+     * Declare the fixed number of elements produced by each call to work().
+     * A fused group whose inner connections declare fixed rates on both ends
+     * runs a static schedule, see Topology::setFusedGroup().
+     * By default, the rate is zero elements, a dynamic rate.
+     * \param numElements the elements produced per work() call or 0 for dynamic
+     */
+    void setStaticRate(const size_t numElements);
+
+    //! Get the declared elements per work() call (0 for dynamic)
+    size_t staticRate(void) const;
+
+    /*!
+     * Set the number of message tokens available to this output port.
+     * Each posted message holds a token until the subscriber pops it,
+     * and work() will not be called while downstream holds every token.
+     * A larger depth allows more messages in flight for packet producers.
+     * By default, each output port has a depth of 16 message tokens.
+     * \param numTokens the number of messages in flight
+     */
+    void setTokenDepth(const size_t numTokens);
+
     /*!
      * Is this port used for signaling in a signals + slots paradigm?
      */
@@ -215,13 +275,26 @@ public:
      *
      * When this "read before write" property is enabled,
      * and the only reference to the buffer is held by the input port,
-     * and the size of the input elements is the same as the output.
+     * and the size of the output elements is less than or equal to the input,
      * then the input buffer may be substituted for an output buffer.
+     * The output then provides one element per available input element,
+     * so that a write never passes the read of the same element,
+     * such as a block that converts complex floats to float magnitudes.
      *
-     * \param port the input port to borrow the buffer from
+     * \param port the input port to borrow the buffer from, or null to disable
      */
     void setReadBeforeWrite(InputPort *port);
 
+    /*!
+     * Add another input port candidate for read before write.
+     * The framework picks the first candidate with a buffer that can be borrowed,
+     * for example, an adder output can reuse the buffer of either input.
+     * Each input buffer is lent to at most one output port at a time,
+     * so blocks with several outputs can run several pairs in place.
+     * \param port the input port to borrow the buffer from
+     */
+    void addReadBeforeWrite(InputPort *port);
+
 private:
     WorkerActor *_actor;
 
@@ -242,6 +315,11 @@ private:
     unsigned long long _totalBuffers;
     unsigned long long _totalLabels;
     unsigned long long _totalMessages;
+    unsigned long long _tokenStarvations;
+    unsigned long long _bufferStarvations;
+
+    //declared elements per work() call for static schedules
+    size_t _staticRate;
 
     //state changes from work
     size_t _pendingElements;
@@ -249,6 +327,10 @@ private:
     std::vector<Label> _postedLabels;
     Util::RingDeque<BufferChunk> _postedBuffers;
 
+    //fan-out scratch for the subscribers before the last one
+    std::vector<Util::RingDeque<BufferChunk>> _fanoutBuffers;
+    std::vector<BufferChunk> _fanoutCopies;
+
     //counts work actions which we will use to establish activity
     size_t _workEvents;
 
@@ -256,7 +338,8 @@ private:
     BufferManager::Sptr _bufferManager;
 
     Util::SpinLock _tokenManagerLock;
-    BufferManager::Sptr _tokenManager; //used for message backpressure
+    BufferManager::Sptr _tokenManager; //used for message backpressure, made upon the first message
+    size_t _tokenDepth;
 
     /////// buffer manager /////////
     void bufferManagerSetup(const BufferManager::Sptr &manager);
@@ -264,23 +347,31 @@ private:
     void bufferManagerFront(BufferChunk &);
     void bufferManagerPop(const size_t numBytes);
     void bufferManagerPush(Pothos::Util::SpinLock *mutex, const ManagedBuffer &buff);
+    static void bufferManagerReturnsBegin(void);
+    static void bufferManagerReturnsEnd(void);
 
     /////// token manager /////////
-    void tokenManagerInit(void);
+    BufferManager::Sptr tokenManagerMake(const size_t numTokens);
     bool tokenManagerEmpty(void);
     BufferChunk tokenManagerPop(void);
     void tokenManagerPop(const size_t numBytes);
 
     std::vector<InputPort *> _subscribers;
-    InputPort *_readBeforeWritePort;
+    std::vector<InputPort *> _readBeforeWritePorts;
     bool _bufferFromManager;
     BufferPool _bufferPool;
 
+    /////// packet pool /////////
+    bool _packetPoolEnabled;
+    std::vector<Object> _packetPool;
+    void packetPoolRelease(void);
+
     OutputPort(void);
     OutputPort(const OutputPort &) = delete; // non construction-copyable
     OutputPort &operator=(const OutputPort &) = delete; // non copyable
     friend class WorkerActor;
     friend class InputPort;
+    template <typename... ArgsType> friend class SignalHandle;
     void _postMessage(const Object &message);
 };
 
@@ -72,6 +72,11 @@ inline Pothos::BufferChunk Pothos::OutputPort::getBuffer(const size_t numElement
     return this->getBuffer(_dtype, numElements);
 }
 
+inline Pothos::Object Pothos::OutputPort::getPacket(const size_t numElements)
+{
+    return this->getPacket(_dtype, numElements);
+}
+
 inline bool Pothos::OutputPort::isSignal(void) const
 {
     return _isSignal;
@@ -79,7 +84,13 @@ inline bool Pothos::OutputPort::isSignal(void) const
 
 inline void Pothos::OutputPort::setReadBeforeWrite(InputPort *port)
 {
-    _readBeforeWritePort = port;
+    _readBeforeWritePorts.clear();
+    if (port != nullptr) _readBeforeWritePorts.push_back(port);
+}
+
+inline void Pothos::OutputPort::addReadBeforeWrite(InputPort *port)
+{
+    if (port != nullptr) _readBeforeWritePorts.push_back(port);
 }
 
 template <typename ValueType>
@@ -100,7 +111,7 @@ inline void Pothos::OutputPort::popElements(const size_t numElements)
     _workEvents++;
 }
 
-template <typename ValueType>
+template <typename ValueType, typename>
 inline void Pothos::OutputPort::postBuffer(ValueType &&buffer)
 {
     auto &queue = _postedBuffers;
@@ -115,6 +126,11 @@ inline void Pothos::OutputPort::postBuffer(ValueType &&buffer)
     _workEvents++;
 }
 
+inline void Pothos::OutputPort::postBuffer(const BufferChunkList &buffers)
+{
+    for (const auto &chunk : buffers.chunks()) this->postBuffer(chunk);
+}
+
 template <typename... ValueType>
 inline void Pothos::OutputPort::postLabel(ValueType&&... label)
 {
@@ -124,6 +140,16 @@ inline void Pothos::OutputPort::postLabel(ValueType&&... label)
     _workEvents++;
 }
 
+inline void Pothos::OutputPort::setStaticRate(const size_t numElements)
+{
+    _staticRate = numElements;
+}
+
+inline size_t Pothos::OutputPort::staticRate(void) const
+{
+    return _staticRate;
+}
+
 inline void Pothos::OutputPort::setReserve(const size_t numElements)
 {
     //only mark this change when setting a larger reserve
@@ -152,13 +178,15 @@ inline void Pothos::OutputPort::bufferManagerPop(const size_t numBytes)
 
 inline bool Pothos::OutputPort::tokenManagerEmpty(void)
 {
+    //a port that never posted a message holds all of its tokens
     std::lock_guard<Util::SpinLock> lock(_tokenManagerLock);
-    return not _tokenManager or _tokenManager->empty();
+    return _tokenManager and _tokenManager->empty();
 }
 
 inline Pothos::BufferChunk Pothos::OutputPort::tokenManagerPop(void)
 {
     std::lock_guard<Util::SpinLock> lock(_tokenManagerLock);
+    if (not _tokenManager) _tokenManager = this->tokenManagerMake(_tokenDepth);
     if (_tokenManager->empty()) return Pothos::BufferChunk();
     auto tok = _tokenManager->front();
     _tokenManager->pop(0);
@@ -168,5 +196,6 @@ inline Pothos::BufferChunk Pothos::OutputPort::tokenManagerPop(void)
 inline void Pothos::OutputPort::tokenManagerPop(const size_t numBytes)
 {
     std::lock_guard<Util::SpinLock> lock(_tokenManagerLock);
+    if (not _tokenManager) return;
     return _tokenManager->pop(numBytes);
 }
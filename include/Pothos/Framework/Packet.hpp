@@ -4,13 +4,14 @@
 /// Definition for packet type found in asynchronous messages.
 ///
 /// \copyright
-/// Copyright (c) 2014-2014 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
 #pragma once
 #include <Pothos/Config.hpp>
 #include <Pothos/Object/Containers.hpp>
+#include <Pothos/Framework/PacketMetadata.hpp>
 #include <Pothos/Framework/Label.hpp>
 #include <Pothos/Framework/BufferChunk.hpp>
 #include <string>
@@ -44,8 +45,10 @@ struct POTHOS_API Packet
      * The metadata structure is a dictionary of key-value pairs,
      * where the keys for this dictionary are exclusively strings,
      * and the values are opaque Objects which can contain anything.
+     * The keys are interned, so a small set of well known keys is cheap
+     * to store and compare; see PacketMetadata for the container interface.
      */
-    ObjectKwargs metadata;
+    PacketMetadata metadata;
 
     /*!
      * Labels associated with the payload.
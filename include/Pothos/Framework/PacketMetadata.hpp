@@ -0,0 +1,229 @@
+///
+/// \file Framework/PacketMetadata.hpp
+///
+/// Flat metadata container for the packet type.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Object/Containers.hpp>
+#include <Pothos/Util/Atom.hpp>
+#include <utility> //pair
+#include <vector>
+
+namespace Pothos {
+
+/*!
+ * PacketMetadata is a flat map of keys to Objects.
+ * The entries live in a single vector sorted by the interned key ID,
+ * so small metadata sets need one allocation rather than one per key,
+ * and key lookups compare integers rather than strings.
+ * The container provides the commonly used parts of the std::map interface;
+ * entries are iterated as key-value pairs where the key is a Util::Atom.
+ * Iteration is in key interning order rather than alphabetical order.
+ * Use toKwargs() or the ObjectKwargs conversion for a sorted dictionary.
+ */
+class POTHOS_API PacketMetadata
+{
+public:
+    typedef Util::Atom key_type;
+    typedef Object mapped_type;
+    typedef std::pair<Util::Atom, Object> value_type;
+    typedef std::vector<value_type>::iterator iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+
+    //! Create empty metadata
+    PacketMetadata(void);
+
+    //! Create metadata from the entries of a dictionary
+    PacketMetadata(const ObjectKwargs &kwargs);
+
+    //! Get the metadata as a dictionary
+    ObjectKwargs toKwargs(void) const;
+
+    //! Implicit conversion to a dictionary
+    operator ObjectKwargs(void) const;
+
+    //! Is the metadata empty?
+    bool empty(void) const;
+
+    //! Get the number of entries
+    size_t size(void) const;
+
+    //! Remove all entries, the storage is kept for reuse
+    void clear(void);
+
+    //! Reserve storage for a number of entries
+    void reserve(const size_t numEntries);
+
+    //! Iterator to the first entry
+    iterator begin(void);
+
+    //! Iterator past the last entry
+    iterator end(void);
+
+    //! Const iterator to the first entry
+    const_iterator begin(void) const;
+
+    //! Const iterator past the last entry
+    const_iterator end(void) const;
+
+    //! Find an entry by key, or end() when not found
+    iterator find(const Util::Atom &key);
+
+    //! Find an entry by key, or end() when not found
+    const_iterator find(const Util::Atom &key) const;
+
+    //! Get the number of entries for a key: 0 or 1
+    size_t count(const Util::Atom &key) const;
+
+    /*!
+     * Get the value for a key.
+     * \throws std::out_of_range when the key is not found
+     */
+    Object &at(const Util::Atom &key);
+
+    /*!
+     * Get the value for a key.
+     * \throws std::out_of_range when the key is not found
+     */
+    const Object &at(const Util::Atom &key) const;
+
+    //! Get the value for a key, inserting a null Object if missing
+    Object &operator[](const Util::Atom &key);
+
+    /*!
+     * Insert the value for a key when the key is not present.
+     * \return the iterator to the entry and true if it was inserted
+     */
+    std::pair<iterator, bool> emplace(const Util::Atom &key, Object value);
+
+    //! Remove the entry for a key, return the number removed
+    size_t erase(const Util::Atom &key);
+
+    //! Remove the entry at the iterator, return the next iterator
+    iterator erase(const_iterator pos);
+
+private:
+    iterator lowerBound(const Util::Atom &key);
+    std::vector<value_type> _entries;
+};
+
+} //namespace Pothos
+
+#include <algorithm> //lower_bound
+#include <stdexcept>
+
+inline Pothos::PacketMetadata::PacketMetadata(void)
+{
+    return;
+}
+
+inline Pothos::PacketMetadata::operator ObjectKwargs(void) const
+{
+    return this->toKwargs();
+}
+
+inline bool Pothos::PacketMetadata::empty(void) const
+{
+    return _entries.empty();
+}
+
+inline size_t Pothos::PacketMetadata::size(void) const
+{
+    return _entries.size();
+}
+
+inline void Pothos::PacketMetadata::clear(void)
+{
+    _entries.clear();
+}
+
+inline void Pothos::PacketMetadata::reserve(const size_t numEntries)
+{
+    _entries.reserve(numEntries);
+}
+
+inline Pothos::PacketMetadata::iterator Pothos::PacketMetadata::begin(void)
+{
+    return _entries.begin();
+}
+
+inline Pothos::PacketMetadata::iterator Pothos::PacketMetadata::end(void)
+{
+    return _entries.end();
+}
+
+inline Pothos::PacketMetadata::const_iterator Pothos::PacketMetadata::begin(void) const
+{
+    return _entries.begin();
+}
+
+inline Pothos::PacketMetadata::const_iterator Pothos::PacketMetadata::end(void) const
+{
+    return _entries.end();
+}
+
+inline Pothos::PacketMetadata::iterator Pothos::PacketMetadata::lowerBound(const Util::Atom &key)
+{
+    return std::lower_bound(_entries.begin(), _entries.end(), key,
+        [](const value_type &entry, const Util::Atom &k){return entry.first < k;});
+}
+
+inline Pothos::PacketMetadata::iterator Pothos::PacketMetadata::find(const Util::Atom &key)
+{
+    auto it = this->lowerBound(key);
+    if (it != _entries.end() and it->first == key) return it;
+    return _entries.end();
+}
+
+inline Pothos::PacketMetadata::const_iterator Pothos::PacketMetadata::find(const Util::Atom &key) const
+{
+    return const_cast<PacketMetadata *>(this)->find(key);
+}
+
+inline size_t Pothos::PacketMetadata::count(const Util::Atom &key) const
+{
+    return (this->find(key) == _entries.end())?0:1;
+}
+
+inline Pothos::Object &Pothos::PacketMetadata::at(const Util::Atom &key)
+{
+    auto it = this->find(key);
+    if (it == _entries.end()) throw std::out_of_range("Pothos::PacketMetadata::at("+key.str()+")");
+    return it->second;
+}
+
+inline const Pothos::Object &Pothos::PacketMetadata::at(const Util::Atom &key) const
+{
+    return const_cast<PacketMetadata *>(this)->at(key);
+}
+
+inline Pothos::Object &Pothos::PacketMetadata::operator[](const Util::Atom &key)
+{
+    return this->emplace(key, Object()).first->second;
+}
+
+inline std::pair<Pothos::PacketMetadata::iterator, bool> Pothos::PacketMetadata::emplace(const Util::Atom &key, Object value)
+{
+    auto it = this->lowerBound(key);
+    if (it != _entries.end() and it->first == key) return std::make_pair(it, false);
+    return std::make_pair(_entries.emplace(it, key, std::move(value)), true);
+}
+
+inline size_t Pothos::PacketMetadata::erase(const Util::Atom &key)
+{
+    auto it = this->find(key);
+    if (it == _entries.end()) return 0;
+    _entries.erase(it);
+    return 1;
+}
+
+inline Pothos::PacketMetadata::iterator Pothos::PacketMetadata::erase(const_iterator pos)
+{
+    return _entries.erase(pos);
+}
@@ -4,7 +4,7 @@
 /// The shared buffer is an RAII buffer that automatically deallocates.
 ///
 /// \copyright
-/// Copyright (c) 2013-2017 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 ///                    2019 Nicholas Corgan
 /// SPDX-License-Identifier: BSL-1.0
 ///
@@ -12,6 +12,7 @@
 #pragma once
 #include <Pothos/Config.hpp>
 #include <memory> //shared_ptr
+#include <string>
 
 namespace Pothos {
 
@@ -34,12 +35,16 @@ public:
      * This factory allocates memory which is held by the SharedBuffer.
      * When the SharedBuffer is deleted, the memory will be freed as well.
      * The node affinity is used to allocate physical memory on a NUMA node.
+     * A non-zero huge page size requests memory backed by huge pages;
+     * when huge pages are not available, normal pages are used instead.
      *
      * \param numBytes the number of bytes to allocate in this buffer
      * \param nodeAffinity which NUMA node to allocate on (-1 for dont care)
+     * \param hugePageSize the huge page size in bytes (0 for normal pages)
+     * \throws SharedBufferError when the allocation exceeds a MemoryAccount budget
      * \return a new shared buffer object
      */
-    static SharedBuffer make(const size_t numBytes, const long nodeAffinity = -1);
+    static SharedBuffer make(const size_t numBytes, const long nodeAffinity = -1, const size_t hugePageSize = 0);
 
     /*!
      * Create a circular SharedBuffer given a length in bytes.
@@ -49,12 +54,47 @@ public:
      * This factory allocates memory which is held by the SharedBuffer.
      * When the SharedBuffer is deleted, the memory will be freed as well.
      * The node affinity is used to allocate physical memory on a NUMA node.
+     * A non-zero huge page size requests memory backed by huge pages;
+     * when huge pages are not available, normal pages are used instead.
+     * With huge pages, the length is rounded up to the huge page size.
      *
      * \param numBytes the number of bytes to allocate in this buffer
      * \param nodeAffinity which NUMA node to allocate on (-1 for dont care)
+     * \param hugePageSize the huge page size in bytes (0 for normal pages)
      * \return a new circular shared buffer object
      */
-    static SharedBuffer makeCirc(const size_t numBytes, const long nodeAffinity = -1);
+    static SharedBuffer makeCirc(const size_t numBytes, const long nodeAffinity = -1, const size_t hugePageSize = 0);
+
+    /*!
+     * Create or open a SharedBuffer backed by named shared memory.
+     * Processes on the same host which use the same name
+     * access the same physical memory through the buffer.
+     * The creator owns the name: the name is removed when the
+     * creator's buffer is deleted, but processes which already
+     * opened the memory keep access until their buffers are deleted.
+     *
+     * \throws SharedBufferError when the memory cannot be created or opened
+     * \param name a host-wide unique name for the memory (no slashes)
+     * \param numBytes the number of bytes in this buffer
+     * \param create true to create the memory, false to open existing memory
+     * \return a new shared buffer object
+     */
+    static SharedBuffer makeNamed(const std::string &name, const size_t numBytes, const bool create);
+
+    /*!
+     * Create or open a circular SharedBuffer backed by named shared memory.
+     * The buffer has the same double mapping as makeCirc() in each process,
+     * and the same naming and lifetime rules as makeNamed().
+     * The length is rounded up to the system allocation granularity,
+     * so the creator and the opener must request the same length.
+     *
+     * \throws SharedBufferError when the memory cannot be created or opened
+     * \param name a host-wide unique name for the memory (no slashes)
+     * \param numBytes the number of bytes in this buffer
+     * \param create true to create the memory, false to open existing memory
+     * \return a new circular shared buffer object
+     */
+    static SharedBuffer makeCircNamed(const std::string &name, const size_t numBytes, const bool create);
 
     /*!
      * Create a SharedBuffer from address, length, and the container.
@@ -74,6 +114,27 @@ public:
      */
     SharedBuffer(const size_t address, const size_t length, const SharedBuffer &buffer);
 
+    /*!
+     * Lock the memory of this buffer into physical RAM.
+     * Locked memory cannot be paged out, which avoids page faults
+     * in the data path of realtime applications.
+     * Both the address and alias ranges of circular buffers are locked.
+     * The memory is unlocked when the last copy of the returned buffer
+     * (and any sub-buffers made from it) is destroyed.
+     * Locking can fail because of system limits (such as RLIMIT_MEMLOCK),
+     * in which case a warning is logged and the memory remains unlocked.
+     * \return a new shared buffer that also holds the memory lock
+     */
+    SharedBuffer lockMemory(void) const;
+
+    /*!
+     * Pre-fault the memory of this buffer by touching every page.
+     * This moves the cost of first-touch page faults out of the data path.
+     * Both the address and alias ranges of circular buffers are touched.
+     * The contents of the buffer are not modified.
+     */
+    void prefaultMemory(void) const;
+
     //! Get the address of the first byte of the buffer
     size_t getAddress(void) const;
 
@@ -127,7 +188,10 @@ public:
     const std::shared_ptr<void> &getContainer(void) const;
 
 private:
-    static SharedBuffer makeCircUnprotected(const size_t numBytes, const long nodeAffinity);
+    static SharedBuffer makeUnaccounted(const size_t numBytes, const long nodeAffinity, const size_t hugePageSize);
+    static SharedBuffer makeNamedUnaccounted(const std::string &name, const size_t numBytes, const bool create);
+    static SharedBuffer makeCircUnprotected(const size_t numBytes, const long nodeAffinity, const size_t hugePageSize);
+    static SharedBuffer makeCircNamedUnprotected(const std::string &name, const size_t numBytes, const bool create);
     size_t _address;
     size_t _length;
     size_t _alias;
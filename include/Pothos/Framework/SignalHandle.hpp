@@ -0,0 +1,114 @@
+///
+/// \file Framework/SignalHandle.hpp
+///
+/// A typed handle to emit a signal without a port lookup by name.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework/OutputPort.hpp>
+#include <Pothos/Object/Containers.hpp>
+#include <cstddef> //size_t
+
+namespace Pothos {
+
+/*!
+ * SignalHandle emits a signal with a fixed argument signature.
+ * Get the handle once from Block::signalHandle() after registerSignal(),
+ * typically in the constructor, and call emit() from within work().
+ * Unlike Block::emitSignal(), the emit does not look up the port by name,
+ * the argument storage is re-used once the slots release the last emission,
+ * and the emit returns immediately when the signal has no subscribers.
+ *
+ * Example usage in a block which signals per packet:
+ * \code
+ * this->registerSignal("packetDone");
+ * _packetDone = this->signalHandle<size_t, bool>("packetDone");
+ * ...
+ * _packetDone.emit(numBytes, crcOk);
+ * \endcode
+ */
+template <typename... ArgsType>
+class SignalHandle
+{
+public:
+    //! Create a null signal handle
+    SignalHandle(void);
+
+    //! Create a handle for the signal port (see Block::signalHandle())
+    SignalHandle(OutputPort *port);
+
+    //! Is this a null signal handle?
+    explicit operator bool(void) const;
+
+    //! Does the signal have subscribers?
+    bool connected(void) const;
+
+    /*!
+     * Emit the signal to all subscribed slots.
+     * Only call emit() from the thread context of the block (such as work()).
+     * \param args the arguments passed to the slots
+     */
+    void emit(const ArgsType &... args);
+
+private:
+    template <typename T>
+    static void assign(ObjectVector &vec, size_t &index, const T &arg);
+    OutputPort *_port;
+    Object _args; //the last emitted ObjectVector
+};
+
+} //namespace Pothos
+
+template <typename... ArgsType>
+Pothos::SignalHandle<ArgsType...>::SignalHandle(void):
+    _port(nullptr)
+{
+    return;
+}
+
+template <typename... ArgsType>
+Pothos::SignalHandle<ArgsType...>::SignalHandle(OutputPort *port):
+    _port(port)
+{
+    return;
+}
+
+template <typename... ArgsType>
+Pothos::SignalHandle<ArgsType...>::operator bool(void) const
+{
+    return _port != nullptr;
+}
+
+template <typename... ArgsType>
+bool Pothos::SignalHandle<ArgsType...>::connected(void) const
+{
+    return not _port->_subscribers.empty();
+}
+
+template <typename... ArgsType>
+template <typename T>
+void Pothos::SignalHandle<ArgsType...>::assign(ObjectVector &vec, size_t &index, const T &arg)
+{
+    vec[index++] = Object(arg);
+}
+
+template <typename... ArgsType>
+void Pothos::SignalHandle<ArgsType...>::emit(const ArgsType &... args)
+{
+    if (not this->connected()) return;
+
+    //re-use the storage when the slots have released the last emission
+    if (not _args or not _args.unique()) _args = Object::emplace<ObjectVector>(sizeof...(ArgsType));
+    auto &vec = _args.ref<ObjectVector>();
+    size_t index = 0;
+    const int expand[] = {0, (assign(vec, index, args), 0)...};
+    (void)expand;
+    (void)index;
+
+    _port->_postMessage(_args);
+}
@@ -4,13 +4,14 @@
 /// Support for configuring and managing threading in the framework.
 ///
 /// \copyright
-/// Copyright (c) 2014-2016 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 ///                    2019 Nicholas Corgan
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
 #pragma once
 #include <Pothos/Config.hpp>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -40,9 +41,15 @@ public:
      * {
      *     "numThreads" : 2,
      *     "priority" : 0.5,
+     *     "realtimePolicy" : "FIFO",
+     *     "cpuDmaLatency" : 0,
      *     "affinityMode" : "CPU",
      *     "affinity" : [0, 2, 4, 6],
-     *     "yieldMode" : "SPIN"
+     *     "yieldMode" : "HYBRID",
+     *     "maxThreads" : 8,
+     *     "spinBudget" : 4096,
+     *     "schedulerMode" : "WORK_STEALING",
+     *     "taskOrder" : "STICKY"
      * }
      * \endcode
      * \param json a JSON object markup string
@@ -53,20 +60,81 @@ public:
      * The number of threads to create in this pool.
      * The default value is 0, indicating the thread-per-block mechanic.
      * Positive values for numThreads indicate the thread-pool mechanic.
+     * The number of threads can be changed with ThreadPool::setNumThreads().
      */
     size_t numThreads;
 
+    /*!
+     * The maximum number of threads when autoscaling the pool.
+     * When maxThreads is greater than numThreads, the pool measures
+     * the time that its threads spend waiting for work: a thread is added
+     * while the threads are nearly always busy, and a thread is removed
+     * (down to numThreads) when the load fits in one fewer thread.
+     * Spinning in the "SPIN" and "HYBRID" yield modes counts as busy time.
+     * The maxThreads only applies to pool-mode (numThreads > 0).
+     * The default value is 0, indicating that autoscaling is disabled.
+     */
+    size_t maxThreads;
+
+    /*!
+     * The idle timeout in seconds for the thread-per-block mechanic.
+     * When positive, a block that has not performed work for longer
+     * than the timeout gives up its dedicated thread, and a single
+     * shared thread services all of the idle blocks upon notification.
+     * A block gets a dedicated thread back once it performs work again.
+     * The idleTimeout only applies to thread-per-block mode (numThreads == 0).
+     * The default value is 0.0, indicating that idle blocks keep their threads.
+     */
+    double idleTimeout;
+
     /*!
      * Scheduling priority for all threads in the pool.
      * The value can be in range -1.0 to 1.0.
      * A value of 0.0 is the default thread scheduling.
-     * Positive values enable realtime scheduling mode.
-     * Negative values enable sub-priority scheduling.
+     * Positive values enable realtime scheduling mode,
+     * with the policy selected by the realtimePolicy.
+     * Negative values enable sub-priority scheduling:
+     * on Linux, each thread gets a nice value up to 19 for -1.0.
      *
      * The default is 0.0 (normal).
      */
     double priority;
 
+    /*!
+     * The realtime scheduling policy for positive priorities:
+     *
+     *  - "RR" - Round-robin realtime scheduling (SCHED_RR):
+     *    threads of the same priority share the CPU in time slices.
+     *  - "FIFO" - First-in first-out realtime scheduling (SCHED_FIFO):
+     *    a thread runs until it blocks or a higher priority thread is ready.
+     *  - "DEADLINE" - Earliest deadline first scheduling (SCHED_DEADLINE, Linux only):
+     *    each thread is guaranteed the deadlineRuntime within every deadlinePeriod.
+     *    The priority value is not used, and the kernel refuses the policy for threads
+     *    with a restricted CPU affinity, so the affinityMode should be "ALL".
+     *
+     * The default is "RR".
+     */
+    std::string realtimePolicy;
+
+    //! The CPU time in seconds per period for the "DEADLINE" policy
+    double deadlineRuntime;
+
+    //! The relative deadline in seconds for the "DEADLINE" policy (0.0 for the period)
+    double deadline;
+
+    //! The period in seconds for the "DEADLINE" policy
+    double deadlinePeriod;
+
+    /*!
+     * The CPU DMA latency in microseconds held while the pool exists.
+     * When non-negative, the pool opens /dev/cpu_dma_latency (Linux only)
+     * with this latency, which keeps the CPUs out of deep idle states
+     * whose exit latency is longer; 0 keeps the CPUs in the active state.
+     * The request is dropped when the thread pool is destroyed.
+     * The default is -1, indicating that the latency is not requested.
+     */
+    int cpuDmaLatency;
+
     /*!
      * The affinity mode for this thread pool.
      * The affinityMode string can have the following values:
@@ -74,6 +142,11 @@ public:
      *  - "ALL" - affinitize to all avilable CPUs
      *  - "CPU" - affinity list specifies CPUs
      *  - "NUMA" - affinity list specifies NUMA nodes
+     *  - "AUTO" - each thread is pinned to a CPU chosen by a process-wide planner:
+     *    The planner spreads the threads of all AUTO pools over the CPUs of the process
+     *    (following the cgroup cpuset and taskset), prefers isolated CPUs (isolcpus),
+     *    keeps the threads of a pool on one NUMA node, and avoids hyperthread siblings
+     *    until all physical cores are in use. The affinity list is not used.
      *
      * The default is "ALL".
      */
@@ -87,11 +160,74 @@ public:
      * 
      *  - "CONDITION" - Threads wait on condition variables when no work is available.
      *  - "HYBRID" - Threads spin for a while, then yield to other threads, when no work is available.
+     *    Once the spinning and yielding have not found work, threads wait on condition variables.
      *  - "SPIN" - Threads busy-wait, without yielding, when no work is available.
      *
      * The default is "CONDITION".
      */
     std::string yieldMode;
+
+    /*!
+     * The maximum number of spin iterations for the "HYBRID" yield mode.
+     * Idle threads spin with a CPU pause instruction for up to this many
+     * attempts before yielding and eventually waiting on a condition variable.
+     * The actual spin count adapts to the recent wake intervals:
+     * it increases when work arrives while spinning,
+     * and decreases when the thread spins without finding work.
+     *
+     * The default is 4096 iterations.
+     */
+    size_t spinBudget;
+
+    /*!
+     * The schedulerMode specifies how pool threads select blocks to execute:
+     *
+     *  - "ROUND_ROBIN" - Threads iterate through every block, checking each for a change.
+     *  - "WORK_STEALING" - Blocks are queued for execution when a change is flagged.
+     *    Each thread services its own queue and steals from other threads when idle.
+     *
+     * The schedulerMode only applies to pool-mode (numThreads > 0).
+     * The default is "ROUND_ROBIN".
+     */
+    std::string schedulerMode;
+
+    /*!
+     * The taskOrder specifies how round-robin pool threads visit the blocks:
+     *
+     *  - "TOPOLOGICAL" - Threads visit the blocks in a topological sort of the committed flows,
+     *    so that a producer is followed by its consumers while the buffer is still in cache.
+     *  - "STICKY" - In addition to the topological order, each connected group of blocks
+     *    is assigned to one thread, so that the blocks in a flow graph share one cache.
+     *    Blocks that are not in a committed topology are visited by every thread.
+     *
+     * The taskOrder only applies to the round-robin scheduler in pool-mode.
+     * The default is "TOPOLOGICAL".
+     */
+    std::string taskOrder;
+};
+
+/*!
+ * An executor runs the tasks of a ThreadPool on threads owned by the application,
+ * such as the threads of an event loop or of a task scheduling library,
+ * so that an embedded topology does not compete with its own set of threads.
+ * The thread pool posts a work item for each block task that has a change,
+ * and the work item executes the task once without waiting.
+ */
+class POTHOS_API ThreadPoolExecutor
+{
+public:
+    virtual ~ThreadPoolExecutor(void);
+
+    /*!
+     * Run the work item once on a thread of the executor.
+     * This call is made from the block threads and the pool's timer thread,
+     * and must return without waiting for the work item to run.
+     * The executor must keep running the posted work items,
+     * and release them afterwards, until the thread pool is destroyed:
+     * removing a block from the pool waits for its posted work items.
+     * \param workItem the work item to execute
+     */
+    virtual void post(const std::function<void(void)> &workItem) = 0;
 };
 
 /*!
@@ -108,8 +244,12 @@ public:
  *    dedicated thread spawned explicitly for its execution alone.
  *
  *  - Positive values for numThreads indicate pool-mode where a
- *    fixed number of threads operate on the blocks in a round-robin fashion.
+ *    fixed number of threads operate on the blocks in a round-robin fashion,
+ *    or from queues of ready blocks when the work-stealing scheduler is selected.
  *    The thread pool will never spawn more threads than there are blocks.
+ *
+ * Alternatively, a ThreadPool created with a ThreadPoolExecutor
+ * runs the blocks as work items on the threads of the executor.
  */
 class POTHOS_API ThreadPool
 {
@@ -128,6 +268,19 @@ public:
      */
     ThreadPool(const ThreadPoolArgs &args);
 
+    /*!
+     * Create a new ThreadPool backed by an external executor.
+     * The block tasks run as work items of the executor rather than
+     * on threads of the pool: the numThreads, schedulerMode, and thread
+     * configuration of the args do not apply, and the yieldMode is SPIN.
+     * The pool only owns sleeping threads: one for a periodic check
+     * of the block tasks, and a timer thread for the timed wakeups.
+     * \param args the configuration struct
+     * \param executor the executor that runs the block tasks
+     * \throws ThreadPoolError on bad values or a null executor
+     */
+    ThreadPool(const ThreadPoolArgs &args, const std::shared_ptr<ThreadPoolExecutor> &executor);
+
     /*!
      * Is this thread pool valid/non-empty?
      * \return true when the thread poll is non-null
@@ -140,6 +293,45 @@ public:
      */
     const std::shared_ptr<void> &getContainer(void) const;
 
+    /*!
+     * Change the number of threads in a pool-mode thread pool.
+     * The threads are started or stopped while the blocks keep running.
+     * When autoscaling is enabled, the number is the new minimum.
+     * \param numThreads the new number of threads (greater than 0)
+     * \throws ThreadPoolError for a null or thread-per-block pool
+     */
+    void setNumThreads(const size_t numThreads);
+
+    /*!
+     * Get the configured number of threads in this pool.
+     * The number of running threads is limited by the number of blocks.
+     * \return the number of threads or 0 for the thread-per-block mechanic
+     */
+    size_t getNumThreads(void) const;
+
+    /*!
+     * Query the scheduler overhead counters as a JSON object.
+     * The counters tell how much CPU time goes to the scheduler itself:
+     *
+     *  - "numTasks" - task calls that performed work in a block
+     *  - "numIdleScans" - task calls or ready queue polls that found no work
+     *  - "numFailedAcquires" - tasks skipped because another thread was executing them
+     *  - "numWaits" and "numWakes" - waits for work and wakeups of waiting threads
+     *  - "taskTimeNs" - time in task calls that performed work, which includes
+     *    work() and the framework overhead around it (acquire, pre/post work, calls)
+     *  - "scanTimeNs" - time in task calls that found no work without waiting
+     *  - "waitTimeNs" - time that the threads waited for work
+     *  - "elapsedNs" - time since the thread pool was created
+     *
+     * The framework overhead of the blocks is the taskTimeNs
+     * minus the totalTimeWork of the blocks in the pool.
+     * These stats are also reported by Topology::queryJSONStats()
+     * as the "threadPool" object of each block.
+     * \throws ThreadPoolError for a null thread pool
+     * \return a JSON object string
+     */
+    std::string queryStats(void) const;
+
 private:
     std::shared_ptr<void> _impl;
 };
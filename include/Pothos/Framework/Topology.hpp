@@ -4,7 +4,7 @@
 /// This file contains the interface for creating a topology of blocks.
 ///
 /// \copyright
-/// Copyright (c) 2014-2019 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -14,7 +14,9 @@
 #include <Pothos/Framework/ThreadPool.hpp>
 #include <Pothos/Object/Object.hpp>
 #include <string>
+#include <vector>
 #include <memory>
+#include <future>
 #include <iosfwd>
 
 namespace Pothos {
@@ -54,6 +56,14 @@ public:
      * The special thread pool with empty name "" will apply
      * to all blocks that do not specify the "threadPool" key.
      *
+     * <h3>Stats level</h3>
+     * The "statsLevel" field is an optional string that selects
+     * the work stats timing level, see setStatsLevel().
+     *
+     * <h3>Memory budget</h3>
+     * The "memoryBudget" field is an optional number of bytes
+     * for the shared buffers of the topology, see setMemoryBudget().
+     *
      * <h3>Global variables</h3>
      * The "globals" field is an optional JSON array
      * where each entry is an object containing a variable name
@@ -71,6 +81,26 @@ public:
      * - The "calls" is a list of ordered method calls.
      *   Each specified by the call name then arguments.
      * - The "threadPool" specifies an optional thread pool by name
+     * - The "priority" specifies an optional scheduling priority (see Block::setSchedulingPriority())
+     * - The "host" optionally pins the block to a host by name (see Hosts)
+     * - The "cost" optionally estimates the processing load of the block (see Hosts)
+     *
+     * <h3>Hosts</h3>
+     * The "hosts" field is an optional JSON array of objects,
+     * each with a "name", a remote server "uri" (empty for this process),
+     * and an optional "capacity" (the default is the number of CPUs of the host).
+     * When hosts are specified, each block is created on one of the hosts:
+     * blocks with a "host" are pinned, and the other blocks are placed
+     * to minimize the rate of data crossing between hosts,
+     * while the load of each host stays within its share of the capacity.
+     * The optional "placement" object provides hints for the planner:
+     * - "stats" the output of queryJSONStats() from a previous run,
+     *   where the work time estimates the block costs
+     *   and the bytes produced by each output port estimate the flow rates
+     * - "flowRates" an object of rates by source "blockId[portName]"
+     * - "balanceSlack" the allowed fraction of load above the share of a host (default 0.25)
+     * Without hints, every block has cost 1 and every connection rate 1.
+     * The connections between hosts become network flows (see NetworkFlowArgs).
      *
      * <h3>Connections</h3>
      * The "connections" field is an array of JSON arrays,
@@ -81,6 +111,20 @@ public:
      *  - source port
      *  - destination ID
      *  - destination port
+     *  - optional buffer arguments object (see connect() with bufferArgs)
+     *
+     * <h3>Fused groups</h3>
+     * The "fusedGroups" field is an optional JSON object
+     * where each entry is a group name and an array of block IDs
+     * in the order of the chain, see setFusedGroup().
+     *
+     * <h2>Block creation</h2>
+     *
+     * The blocks are created in parallel before any connections are made,
+     * because the blocks are independent until they are connected.
+     * The optional top level "makeThreads" field limits the number of threads
+     * used to create the blocks (the default is the number of CPUs).
+     * Use "makeThreads" : 1 for factories that cannot be called concurrently.
      *
      * <h2>Using expressions</h2>
      *
@@ -136,15 +180,32 @@ public:
      *     ],
      *     "connections", [
      *         ["self", "inputX", "id0", "in0"],
-     *         ["id0", "out0", "id1", "in0"],
+     *         ["id0", "out0", "id1", "in0", {"numBuffers" : 8, "bufferSize" : 65536}],
      *         ["id1", "out0", "self", "outputY"],
      *     ]
      * }
      * \endcode
+     * The description may also be a CBOR or MessagePack encoding of the JSON object,
+     * such as the output of dumpJSON() with the "format" option.
      * \param json a JSON formatted string
      */
     static std::shared_ptr<Topology> make(const std::string &json);
 
+    /*!
+     * Change a global variable of a topology that was made from JSON.
+     * Only the block calls with arguments that depend on the global,
+     * directly or through other global and local variables,
+     * are evaluated again and made again on the existing blocks.
+     * The blocks are not reconstructed, and the connections are unchanged.
+     * \throws InvalidArgumentException if the topology was not made from JSON
+     * or when the global variable does not exist
+     * \throws RuntimeException if constructor arguments depend on the global,
+     * then the topology is unchanged and must be made again for the new value
+     * \param name the name of an existing global variable
+     * \param value the new value, an expression like in the JSON markup
+     */
+    void setGlobalVariable(const std::string &name, const std::string &value);
+
     //! Create a new empty topology
     Topology(void);
 
@@ -160,6 +221,129 @@ public:
     //! Get the thread pool used by all blocks in this topology.
     const ThreadPool &getThreadPool(void) const;
 
+    /*!
+     * Set the work stats timing level for all blocks in this topology.
+     * The level is applied to the blocks on the next commit().
+     * - "FULL" - time each task with the high resolution clock (default)
+     * - "CYCLES" - time each task with the CPU cycle counter (lower overhead)
+     * - "NONE" - disable timing, only the call and element counters are kept
+     * - "PERF" - "FULL" timing plus the hardware performance counters of work() (Linux only):
+     *   the stats report the workCycles, workInstructions, workLLCMisses, and workBranchMisses
+     * \throws InvalidArgumentException for an unknown level
+     * \param level the stats level string
+     */
+    void setStatsLevel(const std::string &level);
+
+    //! Get the work stats timing level (empty when not set)
+    const std::string &getStatsLevel(void) const;
+
+    /*!
+     * Enable or disable the scheduler trace for all blocks in this topology.
+     * The setting is applied to the blocks on the next commit().
+     * Each thread records task begin and end, stalls with the reason,
+     * wakeups, and external calls into a fixed-size lock-free ring;
+     * the oldest events are overwritten once a ring is full.
+     * Use dumpTrace() to retrieve the trace.
+     * \param enabled true to record trace events
+     */
+    void setTraceEnabled(const bool enabled);
+
+    //! Is the scheduler trace enabled?
+    bool getTraceEnabled(void) const;
+
+    /*!
+     * Set a memory budget for the shared buffers of this topology.
+     * The budget is applied to the blocks on the next commit().
+     * The buffer managers, pools, and allocations in work() of the blocks
+     * are charged to the topology's MemoryAccount in each process.
+     * An allocation that would exceed the budget throws SharedBufferError,
+     * so the commit fails for the buffer managers, and work() fails for the pools.
+     * The "memory" field of the queryJSONStats() output reports the usage per block.
+     * \param numBytes the budget in bytes per process (0 for no budget)
+     */
+    void setMemoryBudget(const size_t numBytes);
+
+    //! Get the memory budget in bytes (0 for no budget)
+    size_t getMemoryBudget(void) const;
+
+    /*!
+     * Set the policy for network flows between processes in this topology.
+     * The arguments are a JSON object string with the following optional fields:
+     * - "coalesceBytes" - coalesce small buffers into buffers of this many bytes
+     *   before the network sink (0 disables coalescing, the default)
+     * - "coalesceLatency" - the longest time in seconds that data is held
+     *   for coalescing before the network sink (default 0.001)
+     * - "transport" - the preferred URI scheme of the network blocks,
+     *   or an array of schemes in order of preference (default "tcp").
+     *   A scheme that the network blocks reject falls back to the next one,
+     *   and "tcp" is always the last resort.
+     * - "flowTransports" - an object of transports per flow, keyed by
+     *   the source "blockName[portName]", which override "transport"
+     * - "relayFanout" - when a source port feeds several remote processes,
+     *   relay the data through a tree of the processes with this many children,
+     *   so the source process sends the data once (0 sends to each directly, the default)
+     * - "labelChannel" - carry the labels and messages of each network flow
+     *   on a second network flow in batched side frames, so a high rate of labels
+     *   does not add framing to the payload (default false)
+     * - "credits" - an object with the credit window of each network flow,
+     *   so a slow consumer bounds the data in flight rather than the socket buffers:
+     *   "bytes" the most bytes in flight (0 disables credits, the default),
+     *   "buffers" the most buffers in flight (default 16),
+     *   "adaptive" size the window from the measured round trip time and throughput,
+     *   up to "bytes" (default false), and "dropOldest" drop the oldest data
+     *   rather than apply backpressure when the window is full (default false).
+     *   The consumers return each credit when they release the buffer.
+     * - "flowCredits" - an object of credit windows per flow, keyed by
+     *   the source "blockName[portName]", whose missing fields default to "credits"
+     * - "codec" - the lossless payload codec of each network flow:
+     *   "auto" packs the flows whose source port DType has 16-bit integer
+     *   or 32-bit float components, such as complex int16 and complex float IQ,
+     *   into bit-packed blocks of the samples or their sample to sample differences,
+     *   and "none" sends the payload as-is (the default)
+     * - "flowCodecs" - an object of codecs per flow, keyed by
+     *   the source "blockName[portName]", which override "codec"
+     *
+     * The policy applies to network flows created by the next commit();
+     * connections which already have network blocks keep their policy.
+     * \throws InvalidArgumentException for malformed arguments
+     * \param args the network flow arguments as a JSON object string
+     */
+    void setNetworkFlowArgs(const std::string &args);
+
+    //! Get the network flow arguments (empty when not set)
+    const std::string &getNetworkFlowArgs(void) const;
+
+    /*!
+     * Fuse a linear chain of blocks so that one task drives the chain.
+     * On commit(), the blocks of the group are executed back to back on one thread
+     * in the order of the chain, rather than as one scheduled task per block.
+     * The connections inside the group use fewer output buffers,
+     * so the consumer reads the buffer while its still in cache.
+     *
+     * Each block in the chain must feed only the next block,
+     * and must only be fed by the previous block, the blocks must be
+     * in this process and use the same thread pool; otherwise commit() throws.
+     * The group takes effect when all of its blocks are in the flows.
+     * The buffer count applies to connections made by the next commit().
+     *
+     * When every connection inside the group declares a fixed rate on both ends
+     * with OutputPort::setStaticRate() and InputPort::setStaticRate(),
+     * the group runs a static schedule: the repetitions of the blocks are
+     * solved from the rates so that one pass of the chain is balanced,
+     * each block runs its repetitions back to back within the pass,
+     * and each connection preallocates a buffer per repetition of the producer.
+     * The rates of the connections between two neighbors must agree,
+     * otherwise commit() throws.
+     *
+     * \throws InvalidArgumentException for one block or a repeated block
+     * \param name the name of the group
+     * \param blocks the blocks from upstream to downstream, empty to remove the group
+     */
+    void setFusedGroup(const std::string &name, const std::vector<Object> &blocks);
+
+    //! Get the names of the fused groups in this topology
+    std::vector<std::string> getFusedGroups(void) const;
+
     /*!
      * Set the displayable alias for the specified input port.
      */
@@ -190,6 +374,18 @@ public:
      */
     void commit(void);
 
+    /*!
+     * Commit changes made to the topology without blocking the caller.
+     * The commit runs on a background thread, and the sub-topologies
+     * commit concurrently as they do in commit().
+     * Commits run one at a time: async commits apply in the order of the calls,
+     * and a commit() blocks while another commit is in progress.
+     * Do not change the connections of the topology until the future is ready.
+     * \return a future that is ready once the commit completes,
+     * and rethrows the TopologyConnectError of a failed commit upon get()
+     */
+    std::shared_future<void> commitAsync(void);
+
     /*!
      * Wait for a period of data flow inactivity.
      * This call blocks until all flows become inactive for at least idleDuration seconds.
@@ -202,6 +398,40 @@ public:
      */
     bool waitInactive(const double idleDuration = 0.1, const double timeout = 1.0);
 
+    /*!
+     * Stop the sources and wait for the design to consume the remaining data.
+     * The blocks without upstream flows stop calling work(),
+     * then the blocks drain in the order of the flows:
+     * each block waits until its upstream blocks drained, and until
+     * its input queues are empty of buffers, labels, and messages
+     * after a work task that did not ask to run again (such as with yield()).
+     * A network source waits until it produced what its network sink consumed.
+     * The waits are woken by the work tasks of each block rather than polling.
+     * Data held inside of a block, other than in its input queues, is not seen.
+     * The sources stay stopped until they are deactivated and activated again,
+     * so follow the drain with disconnectAll() and commit() to finish the design.
+     * Use a timeout value of 0.0 to wait forever for the design to drain.
+     * \param timeout the maximum number of seconds to wait in this call
+     * \return true if the design drained before the timeout
+     */
+    bool drain(const double timeout = 1.0);
+
+    /*!
+     * Run the design as an offline batch job until all of its data is processed.
+     * This call commits the topology for throughput rather than latency:
+     * a spinning thread pool with a thread per core, unless a pool is set,
+     * and default output buffers of at least 1 MiB for the connections.
+     * The call waits until each source signals Block::endOfStream(),
+     * then drains the data in flight with drain(), and finally
+     * disconnects and commits the topology so that the design is finished.
+     * The topology settings are restored for the next commit().
+     * A source that never signals the end of its stream runs until the timeout.
+     * Use a timeout value of 0.0 to wait forever for the design to complete.
+     * \param timeout the maximum number of seconds to wait in this call
+     * \return true if the design completed before the timeout
+     */
+    bool runToCompletion(const double timeout = 0.0);
+
     /*!
      * Create a connection between a source port and a destination port.
      * \param src the data source (local/remote block/topology)
@@ -216,6 +446,58 @@ public:
         SrcType &&src, const SrcPortType &srcPort,
         DstType &&dst, const DstPortType &dstPort);
 
+    /*!
+     * Create a connection and configure the buffer manager of the source port.
+     * The buffer arguments are a JSON object with an optional "type" field
+     * that names the buffer manager factory (default "generic"), and the
+     * remaining fields are documented by the BufferManagerArgs JSON constructor.
+     * Buffer managers belong to output ports, so the configuration applies
+     * to all flows from the source port and remains after disconnection.
+     * The arguments are also passed to the init() of uninitialized managers
+     * provided by the block itself, but in that case the "type" field is ignored.
+     * Without buffer arguments, the commit selects the manager type from the flow:
+     * a "circular" manager serves a downstream reserve that the producer's chunks
+     * would fragment, and a consumer which writes its outputs in place over this input
+     * (see OutputPort::setReadBeforeWrite()) keeps "generic" buffers with extra buffers.
+     * A "type" of "auto" applies that selection to the remaining buffer arguments.
+     * The optional "tokenDepth" field sets the number of messages in flight
+     * for the source port, see OutputPort::setTokenDepth().
+     * The optional "lossyDepth" field makes the destination port drop its
+     * oldest buffers when it holds more than the given number of buffers,
+     * so that the source never waits on this consumer, see InputPort::setLossyDepth().
+     * Like the buffer arguments, the lossy depth remains after disconnection.
+     * The optional "autoTune" field enables the buffer auto-tuner of the source port,
+     * with true for the default bounds or an object with the "maxLatency" seconds,
+     * "maxMemory" bytes in flight, "minBufferSize", "maxBufferSize", "maxBuffers",
+     * and the "interval" in seconds between updates; false disables the tuner.
+     * The tuner measures the bytes per work() call and the buffer starvations
+     * of the port, and replaces the buffer manager with a better bufferSize and
+     * numBuffers while the design runs; the tuned geometry is used by later commits
+     * and is reported by the "autoTune" entry of the output port stats.
+     *
+     * Example JSON markup for the buffer arguments:
+     * \code {.json}
+     * {
+     *     "type" : "circular",
+     *     "numBuffers" : 8,
+     *     "bufferSize" : 65536
+     * }
+     * \endcode
+     *
+     * \param src the data source (local/remote block/topology)
+     * \param srcPort an identifier for the source port (string or index)
+     * \param dst the data destination (local/remote block/topology)
+     * \param dstPort an identifier for the destination port (string or index)
+     * \param bufferArgs a JSON object string with buffer manager arguments
+     */
+    template <
+        typename SrcType, typename SrcPortType,
+        typename DstType, typename DstPortType>
+    void connect(
+        SrcType &&src, const SrcPortType &srcPort,
+        DstType &&dst, const DstPortType &dstPort,
+        const std::string &bufferArgs);
+
     /*!
      * Remove a connection between a source port and a destination port.
      * \param src the data source (local/remote block/topology)
@@ -239,16 +521,41 @@ public:
      */
     void disconnectAll(const bool recursive = false);
 
+    /*!
+     * Replace a block or sub-topology of a running design without stopping it.
+     * Every flow of the old object in this topology moves to the port
+     * of the same name on the new object, and the change is committed.
+     * The commit subscribes and activates the new object before data reaches it,
+     * then each upstream port switches from the old to the new object in one step,
+     * so the rest of the design keeps running without a gap in the stream.
+     * The old object is deactivated last, it may still hold unconsumed data.
+     * When the commit fails, the flows are restored to the old object.
+     * \param oldObj the connected block or topology to replace
+     * \param newObj the block or topology with the same port names
+     * \throws TopologyConnectError if the new object lacks a port or the commit fails
+     */
+    template <typename OldType, typename NewType>
+    void replace(OldType &&oldObj, NewType &&newObj);
+
     //! Create a connection between a source port and a destination port.
     void _connect(
         const Object &src, const std::string &srcPort,
         const Object &dst, const std::string &dstPort);
 
+    //! Create a connection and configure the buffer manager of the source port.
+    void _connect(
+        const Object &src, const std::string &srcPort,
+        const Object &dst, const std::string &dstPort,
+        const std::string &bufferArgs);
+
     //! Remove a connection between a source port and a destination port.
     void _disconnect(
         const Object &src, const std::string &srcPort,
         const Object &dst, const std::string &dstPort);
 
+    //! Replace a block or sub-topology of a running design without stopping it.
+    void _replace(const Object &oldObj, const Object &newObj);
+
     /*!
      * Export a function call on this topology to set/get parameters.
      * This call will automatically register a slot of the same name.
@@ -282,9 +589,151 @@ public:
      * }
      * \endcode
      *
+     * The stall counters stallPrepare, stallNoTokens, stallMessagesFull,
+     * stallNoOutputBuffer, and stallReserve count the tasks per block
+     * that returned without calling work() for each reason.
+     *
+     * The optional request object selects the "format" of the result,
+     * see the format options of dumpJSON().
+     *
+     * The optional "delta" request field names a stream of stats replies
+     * with only the values that changed since the last reply to the stream.
+     * The "seq" request field is the sequence number of the last reply
+     * that the caller merged (0 or missing requests the full stats).
+     * The reply object has the "seq" number of the reply,
+     * "full" when the "stats" are complete rather than a delta,
+     * and the "stats" delta, where changed keys have the new values,
+     * removed keys are null, and changed entries of the port stats arrays
+     * are keyed by the array index.
+     * The top topology polls the blocks in each remote environment
+     * as one delta stream from the sub-topology of the last commit,
+     * so only the changed counters cross the network on each query.
+     *
+     * \param request a JSON object string with key/value arguments
+     * \return a JSON formatted object string
+     */
+    std::string queryJSONStats(const std::string &request = "{}");
+
+    /*!
+     * Analyze the work stats to find the bottlenecks in the topology.
+     * The stats are sampled twice over an interval to measure
+     * the utilization of each block (the fraction of time in work()),
+     * the most frequent stall reason, and the queue depth per connection.
+     * The limiter is the busiest block that is not waiting on downstream;
+     * timing based results require a stats level other than NONE.
+     *
+     * Example request string {"interval" : 0.1}
+     *
+     * Example JSON markup for the report:
+     * \code {.json}
+     * {
+     *     "interval" : 0.1,
+     *     "limiter" : "unique_id_of_blockB",
+     *     "blocks" : [
+     *         {"uid" : "unique_id_of_blockB", "blockName" : "blockB", "utilization" : 0.97,
+     *          "stallReason" : "none", "state" : "busy", "stalls" : {...}},
+     *         {"uid" : "unique_id_of_blockA", "blockName" : "blockA", "utilization" : 0.12,
+     *          "stallReason" : "noOutputBuffer", "state" : "backpressured", "stalls" : {...}}
+     *     ],
+     *     "queues" : [
+     *         {"srcId" : "unique_id_of_blockA", "srcName" : "0", "dstId" : "unique_id_of_blockB", "dstName" : "0",
+     *          "enqueuedBytes" : 65536, "queueFill" : 1.0}
+     *     ]
+     * }
+     * \endcode
+     *
+     * Blocks are ranked by utilization and queues by the enqueued bytes.
+     * The block state is one of busy, backpressured, starved, unprepared, running, or idle.
+     *
+     * \param request a JSON object string with configuration parameters
      * \return a JSON formatted object string
      */
-    std::string queryJSONStats(void);
+    std::string queryBottlenecks(const std::string &request = "{}");
+
+    /*!
+     * Dump the scheduler trace of all blocks in this topology.
+     * The trace is a JSON object in the Chrome trace event format,
+     * which can be loaded into chrome://tracing or the Perfetto UI.
+     * Each worker thread is one row in the timeline:
+     * tasks and external calls are duration events named by the block,
+     * stalls and wakeups are instant events; the stall reason is one of
+     * prepare, noTokens, messagesFull, noOutputBuffer, or reserve.
+     * \see setTraceEnabled()
+     * \return a JSON formatted object string {"traceEvents" : [...]}
+     */
+    std::string dumpTrace(void);
+
+    /*!
+     * Start exporting work stats periodically from a background thread.
+     * Each period, one JSON object is appended to the file as a single line:
+     * {"time" : seconds, "stats" : {"uid" : {"blockName" : ..., ...}}}.
+     * Unlike queryJSONStats(), the exporter reads a lock-free snapshot
+     * that each block publishes after its work task,
+     * so the block's thread is never stalled by the export.
+     * Only blocks in this process that are part of the committed design are
+     * exported; call again after commit() to pick up design changes.
+     * \throws OpenFileException when the file cannot be opened
+     * \param path the path to the output file (appended to)
+     * \param period the time between snapshots in seconds
+     */
+    void startStatsExport(const std::string &path, const double period = 1.0);
+
+    //! Stop the stats export started by startStatsExport()
+    void stopStatsExport(void);
+
+    /*!
+     * Query the recent rate history of the work stats.
+     * A framework thread samples the lock-free snapshot of every block
+     * once per second into a fixed ring of the last 300 intervals,
+     * so the trend is available without polling and differencing
+     * the cumulative counters of queryJSONStats() externally.
+     * Only blocks in this process that are part of the committed design are reported.
+     *
+     * Each interval holds the rates per second over the interval:
+     * "taskCalls", "workCalls", "inputElements" and "outputElements"
+     * summed over the stream ports, "workTime" in seconds per second,
+     * "stalls" summed over all stall reasons, and the "queueBytes"
+     * enqueued on the stream inputs at the end of the interval.
+     *
+     * \code {.json}
+     * {"uid" : {"blockName" : "name", "history" : [{"time" : seconds, "workCalls" : rate, ...}, ...]}}
+     * \endcode
+     *
+     * \param seconds report the intervals that ended within this many seconds
+     * 
+eturn a JSON formatted object string, intervals oldest first
+     */
+    std::string queryStatsHistory(const double seconds = 60.0);
+
+    /*!
+     * Query the work stats in the OpenMetrics text format (Prometheus).
+     * Like startStatsExport(), the metrics are read from the lock-free
+     * snapshots of the blocks in this process in the committed design.
+     * Each sample is labeled with the block "uid" and "block" name,
+     * and port samples with the "direction" and "port" name:
+     *  - pothos_block_task_calls_total, pothos_block_work_calls_total
+     *  - pothos_block_stalls_total by "reason"
+     *  - pothos_block_time_seconds_total by "phase": task, work, prework, postwork
+     *  - pothos_block_memory_bytes (gauge)
+     *  - pothos_port_elements_total, pothos_port_buffers_total,
+     *    pothos_port_labels_total, pothos_port_messages_total
+     *  - pothos_port_queue_bytes for input ports (gauge)
+     * \return the metrics text terminated by "# EOF"
+     */
+    std::string queryMetrics(void);
+
+    /*!
+     * Start serving queryMetrics() over HTTP at the path "/metrics".
+     * The server reads the snapshots from its own threads upon each scrape;
+     * call again after commit() to pick up design changes.
+     * \throws IOException when the address cannot be bound
+     * \param address the bind address "host:port" (port 0 for any port)
+     * \return the bound address "host:port"
+     */
+    std::string startMetricsServer(const std::string &address);
+
+    //! Stop the metrics server started by startMetricsServer()
+    void stopMetricsServer(void);
 
     /*!
      * Dump the topology state to a JSON formatted string.
@@ -297,6 +746,11 @@ public:
      *  - "top": Only top-level blocks without hierarchy traversal.
      *  - "rendered": Flattened hierarchies with traversal blocks.
      *
+     * Format options:
+     *  - "json": A JSON formatted string (default).
+     *  - "cbor": The compact binary CBOR encoding as bytes in the string.
+     *  - "msgpack": The compact binary MessagePack encoding as bytes in the string.
+     *
      * Example JSON markup for presenting the topology:
      * \code {.json}
      * {
@@ -357,6 +811,10 @@ public:
      *  - "all" Show all available IO ports.
      *  - "connected" Show connected ports only.
      *
+     * When the "bottlenecks" option is true, the blocks are colored
+     * by utilization and the connections by queue fill from queryBottlenecks(),
+     * the request is also passed to queryBottlenecks() for the "interval".
+     *
      * \param request a JSON object string with configuration parameters
      * \return the dot markup as a string
      */
@@ -100,7 +100,7 @@ portNameToStr(const T &value)
 } //namespace Pothos
 
 /***********************************************************************
- * templated implementation for connect and disconnect
+ * templated implementation for connect, disconnect, and replace
  **********************************************************************/
 template <
     typename SrcType, typename SrcPortType,
@@ -114,6 +114,20 @@ void Pothos::Topology::connect(
         Detail::connObjToObject(dst), Detail::portNameToStr(dstPort));
 }
 
+template <
+    typename SrcType, typename SrcPortType,
+    typename DstType, typename DstPortType>
+void Pothos::Topology::connect(
+    SrcType &&src, const SrcPortType &srcPort,
+    DstType &&dst, const DstPortType &dstPort,
+    const std::string &bufferArgs)
+{
+    this->_connect(
+        Detail::connObjToObject(src), Detail::portNameToStr(srcPort),
+        Detail::connObjToObject(dst), Detail::portNameToStr(dstPort),
+        bufferArgs);
+}
+
 template <
     typename SrcType, typename SrcPortType,
     typename DstType, typename DstPortType>
@@ -125,3 +139,9 @@ void Pothos::Topology::disconnect(
         Detail::connObjToObject(src), Detail::portNameToStr(srcPort),
         Detail::connObjToObject(dst), Detail::portNameToStr(dstPort));
 }
+
+template <typename OldType, typename NewType>
+void Pothos::Topology::replace(OldType &&oldObj, NewType &&newObj)
+{
+    this->_replace(Detail::connObjToObject(oldObj), Detail::connObjToObject(newObj));
+}
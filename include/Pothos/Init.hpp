@@ -4,7 +4,7 @@
 /// Initialization calls for library
 ///
 /// \copyright
-/// Copyright (c) 2013-2016 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -21,6 +21,13 @@ namespace Pothos {
      * Also, the runtime modules will be loaded into the system.
      * This call will throw if any of the above fails.
      * Subsequent calls to init() are safe and result in NOP.
+     *
+     * Set the environment variable POTHOS_STARTUP_PROFILE=1 to print
+     * the wall time of each module load, static block, conf file,
+     * plugin event handler, managed class commit, and safe load probe
+     * to stderr when init() completes, sorted by the longest time.
+     * Use "stdout" to print to stdout, or a file path to write a file.
+     * See also PothosUtil --startup-profile.
      */
     POTHOS_API void init(void);
 
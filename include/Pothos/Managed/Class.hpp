@@ -4,7 +4,7 @@
 /// Interface definition for a ManagedClass.
 ///
 /// \copyright
-/// Copyright (c) 2013-2016 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -13,6 +13,7 @@
 #include <Pothos/Callable/Callable.hpp>
 #include <string>
 #include <memory>
+#include <functional>
 #include <typeinfo>
 
 namespace Pothos {
@@ -186,6 +187,21 @@ public:
      */
     ManagedClass &commit(const std::string &classPath);
 
+    /*!
+     * Commit this registration into the plugin tree,
+     * but defer the constructor and method registrations until first use.
+     * Register the class type up front with registerClass(),
+     * so that lookup() finds the class by type without the factory.
+     * The factory makes the complete ManagedClass the first time
+     * that a constructor or method is requested, such as for a call
+     * on a proxy from lookup() or ProxyEnvironment::findProxy().
+     * Constructors of a deferred class are not registered as conversions.
+     * \throws PluginPathError if the classPath is invalid
+     * \param classPath the namespaces and class name
+     * \param factory a function that makes the complete registration
+     */
+    ManagedClass &commitDeferred(const std::string &classPath, const std::function<ManagedClass(void)> &factory);
+
     /*!
      * Unload a managed class from the plugin tree.
      * This reverses the effect of ManagedClass::commit().
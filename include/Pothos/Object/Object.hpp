@@ -14,6 +14,7 @@
 #include <Pothos/Util/Templates.hpp>
 #include <typeinfo>
 #include <string>
+#include <vector>
 
 namespace Pothos {
 
@@ -243,6 +244,47 @@ public:
      */
     std::istream &deserialize(std::istream &is);
 
+    /*!
+     * Serialize the contents of the object into a memory buffer.
+     * The serialized data is appended to the end of the buffer.
+     * Writing to memory is faster than a stream for many small objects,
+     * and a reused buffer avoids an allocation per serialization.
+     * \throws ObjectSerializeError if the type is not registered
+     * \param buffer the buffer to append the serialized data to
+     */
+    void serialize(std::vector<char> &buffer) const;
+
+    /*!
+     * Deserialize from memory into the contents of this Object.
+     * Only make this call on a null object.
+     * \throws ObjectSerializeError if the type is not registered or the data is truncated
+     * \param data the start of the serialized data in memory
+     * \param length the number of bytes of available data
+     * \return the number of bytes consumed from the data
+     */
+    size_t deserialize(const void *data, const size_t length);
+
+    /*!
+     * Serialize the contents of the object into a file.
+     * Large binary payloads (such as BufferChunk contents) are page aligned
+     * in the file, so that deserializeFile() can map them without a copy.
+     * \throws ObjectSerializeError if the type is not registered or the write fails
+     * \param path the path of the file to create or overwrite
+     */
+    void serializeFile(const std::string &path) const;
+
+    /*!
+     * Deserialize a file from serializeFile() into the contents of this Object.
+     * Only make this call on a null object.
+     * The file is memory mapped, and the large BufferChunk payloads
+     * are copy-on-write views into the mapping rather than copies.
+     * Other types, such as vectors, are still copied out of the mapping.
+     * The mapping stays open while any of the views are in use.
+     * \throws ObjectSerializeError if the type is not registered or the file is invalid
+     * \param path the path of the file to read
+     */
+    void deserializeFile(const std::string &path);
+
     /*!
      * Returns a negative integer, zero, or a positive integer as this object is
      * less than, equal to, or greater than the specified object.
@@ -4,7 +4,7 @@
 /// Template implementation details for Object.
 ///
 /// \copyright
-/// Copyright (c) 2013-2017 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -16,6 +16,7 @@
 #include <type_traits> //std::decay
 #include <utility> //std::forward
 #include <atomic>
+#include <cstddef> //size_t
 
 namespace Pothos {
 namespace Detail {
@@ -29,6 +30,16 @@ struct POTHOS_API ObjectContainer
 
     virtual ~ObjectContainer(void);
 
+    /*!
+     * Allocate containers for small types from a per-thread pool,
+     * so that making and destroying Objects of numbers,
+     * label data, and message types does not go through malloc/free.
+     */
+    static void *operator new(const size_t size);
+
+    //! Return a container to the per-thread pool (or the heap for large types)
+    static void operator delete(void *p, const size_t size);
+
     void *internal; //!< Opaque pointer to internally held type
 
     const std::type_info &type; //!< Type info for internal type
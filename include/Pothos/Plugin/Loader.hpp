@@ -4,7 +4,7 @@
 /// The loader is responsible for loading runtime modules into the plugin registry.
 ///
 /// \copyright
-/// Copyright (c) 2013-2015 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -21,6 +21,14 @@ public:
 
     /*!
      * Load all modules in the system install paths.
+     * Modules are safe loaded in parallel by a bounded pool of threads.
+     *
+     * Set the environment variable POTHOS_LAZY_MODULES=1 to defer modules
+     * until the registry is queried for a path that they register under.
+     * The plugin paths of each module are recorded in the loader cache
+     * when it is loaded, so a module is only deferred once it has an index;
+     * modules that register different plugin paths between runs
+     * should not be used with lazy loading.
      * The caller should hold onto the module handles.
      * Releasing the handles will unload the plugins.
      * \return a list of loaded module handles
@@ -4,7 +4,7 @@
 /// Plugin path represents a UNIX-style path for the plugin hierarchy.
 ///
 /// \copyright
-/// Copyright (c) 2013-2018 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 ///                    2019 Nicholas Corgan
 /// SPDX-License-Identifier: BSL-1.0
 ///
@@ -78,9 +78,10 @@ public:
     /*!
      * List the nodes that make up the path.
      * Basically, this splits the path at the slashes.
+     * The nodes are parsed once when the path is constructed.
      * \return a vector of strings between each slash
      */
-    std::vector<std::string> listNodes(void) const;
+    const std::vector<std::string> &listNodes(void) const;
 
     /*!
      * Get the PluginPath as a string representation.
@@ -90,6 +91,7 @@ public:
 
 private:
     std::string _path;
+    std::vector<std::string> _nodes;
 };
 
 /*!
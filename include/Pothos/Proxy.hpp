@@ -4,7 +4,7 @@
 /// Top level include wrapper for Proxy classes.
 ///
 /// \copyright
-/// Copyright (c) 2013-2016 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -16,3 +16,4 @@
 #include <Pothos/Proxy/Environment.hpp>
 #include <Pothos/Proxy/Containers.hpp>
 #include <Pothos/Proxy/Exception.hpp>
+#include <Pothos/Proxy/Batch.hpp>
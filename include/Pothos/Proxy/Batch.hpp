@@ -0,0 +1,201 @@
+///
+/// \file Proxy/Batch.hpp
+///
+/// Definitions for making batches of proxy calls.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Object/ObjectImpl.hpp>
+#include <Pothos/Object/Containers.hpp>
+#include <Pothos/Proxy/Proxy.hpp>
+#include <Pothos/Exception.hpp>
+#include <utility> //std::forward
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Pothos {
+
+class ProxyEnvironment;
+
+/*!
+ * A reference to the result of an earlier call in the same batch.
+ * A reference can be used as the object of a call or as an argument.
+ */
+struct POTHOS_API ProxyBatchRef
+{
+    //! Create a reference to the result at the specified index
+    explicit ProxyBatchRef(const size_t index = 0):
+        index(index)
+    {
+        return;
+    }
+
+    //! The index of the call in the batch
+    size_t index;
+};
+
+/*!
+ * A single call in a batch of proxy calls.
+ */
+struct POTHOS_API ProxyBatchCall
+{
+    //! How the result of a call is returned
+    enum ResultMode
+    {
+        RESULT_PROXY, //!< return the result as a proxy (default)
+        RESULT_LOCAL, //!< return the result converted to a local object
+        RESULT_NONE, //!< the result is only used by later calls in the batch
+    };
+
+    //! The object to make the call on (or null to use the target)
+    Proxy proxy;
+
+    //! The index of an earlier result to call on when proxy is null
+    size_t target;
+
+    //! The name of the method to call
+    std::string name;
+
+    /*!
+     * The call arguments: each argument is either a local value
+     * which will be converted in the environment, a Proxy,
+     * or a ProxyBatchRef to the result of an earlier call.
+     */
+    ObjectVector args;
+
+    //! How the result of this call is returned
+    ResultMode resultMode;
+};
+
+/*!
+ * The result of a single call in a batch of proxy calls.
+ */
+struct POTHOS_API ProxyBatchResult
+{
+    //! The result of the call (RESULT_PROXY mode)
+    Proxy result;
+
+    //! The result of the call converted to a local object (RESULT_LOCAL mode)
+    Object local;
+
+    //! The exception thrown by the call (null on success)
+    std::shared_ptr<Exception> error;
+};
+
+/*!
+ * ProxyBatch queues calls into one environment and executes them together.
+ * A remote environment sends the entire batch in a single request and reply,
+ * rather than a round trip for each call and for each argument conversion.
+ * Calls may use the results of earlier calls as the object or as arguments,
+ * which allows chained calls like obj.call("output", name).call("domain").
+ * Results that are only needed locally can be converted in the same request,
+ * and intermediate results can be discarded to avoid releasing their handles.
+ */
+class POTHOS_API ProxyBatch
+{
+public:
+    //! Create an empty batch for the specified environment
+    ProxyBatch(const std::shared_ptr<ProxyEnvironment> &env);
+
+    //! Queue a call on a proxy and return a reference to its result
+    template <typename... ArgsType>
+    ProxyBatchRef call(const Proxy &proxy, const std::string &name, ArgsType&&... args);
+
+    //! Queue a call on the result of an earlier call
+    template <typename... ArgsType>
+    ProxyBatchRef call(const ProxyBatchRef &target, const std::string &name, ArgsType&&... args);
+
+    //! Return the result of a queued call as a local object
+    void convert(const ProxyBatchRef &ref);
+
+    /*!
+     * Discard the result of a queued call.
+     * The result may still be used by later calls in the same execute().
+     * Once executed, get() on a discarded result only checks for an error.
+     */
+    void discard(const ProxyBatchRef &ref);
+
+    //! Get the number of queued calls
+    size_t size(void) const;
+
+    /*!
+     * Execute all queued calls that have not been executed yet.
+     * This call does not throw for individual call failures,
+     * the errors are reported by get() for each result.
+     */
+    void execute(void);
+
+    /*!
+     * Get the result of an executed call.
+     * \throws Exception the error from the call when it failed
+     * \param ref a reference returned by call()
+     * \return the result of the call as a proxy
+     */
+    Proxy get(const ProxyBatchRef &ref) const;
+
+    //! Get the result of an executed call converted to the return type
+    template <typename ReturnType>
+    ReturnType get(const ProxyBatchRef &ref) const;
+
+private:
+    Object getLocal(const ProxyBatchRef &ref) const;
+    ProxyBatchRef queue(ProxyBatchCall &&call);
+    std::shared_ptr<ProxyEnvironment> _env;
+    std::vector<ProxyBatchCall> _calls;
+    std::vector<ProxyBatchResult> _results;
+};
+
+namespace Detail {
+
+inline void loadBatchArgs(ObjectVector &)
+{
+    return;
+}
+
+template <typename ArgType, typename... ArgsType>
+void loadBatchArgs(ObjectVector &objs, ArgType &&arg, ArgsType&&... args)
+{
+    objs.emplace_back(std::forward<ArgType>(arg));
+    loadBatchArgs(objs, std::forward<ArgsType>(args)...);
+}
+
+} //namespace Detail
+
+template <typename... ArgsType>
+ProxyBatchRef ProxyBatch::call(const Proxy &proxy, const std::string &name, ArgsType&&... args)
+{
+    ProxyBatchCall call;
+    call.proxy = proxy;
+    call.target = 0;
+    call.name = name;
+    call.resultMode = ProxyBatchCall::RESULT_PROXY;
+    Detail::loadBatchArgs(call.args, std::forward<ArgsType>(args)...);
+    return this->queue(std::move(call));
+}
+
+template <typename... ArgsType>
+ProxyBatchRef ProxyBatch::call(const ProxyBatchRef &target, const std::string &name, ArgsType&&... args)
+{
+    ProxyBatchCall call;
+    call.target = target.index;
+    call.name = name;
+    call.resultMode = ProxyBatchCall::RESULT_PROXY;
+    Detail::loadBatchArgs(call.args, std::forward<ArgsType>(args)...);
+    return this->queue(std::move(call));
+}
+
+template <typename ReturnType>
+ReturnType ProxyBatch::get(const ProxyBatchRef &ref) const
+{
+    const auto local = this->getLocal(ref);
+    if (local) return local.convert<ReturnType>();
+    return this->get(ref).convert<ReturnType>();
+}
+
+} //namespace Pothos
@@ -4,7 +4,7 @@
 /// Definitions for the ProxyEnvironment interface class.
 ///
 /// \copyright
-/// Copyright (c) 2013-2016 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -12,6 +12,7 @@
 #include <Pothos/Config.hpp>
 #include <Pothos/Object/Object.hpp>
 #include <Pothos/Proxy/Proxy.hpp>
+#include <Pothos/Proxy/Batch.hpp>
 #include <Pothos/Util/RefHolder.hpp>
 #include <Pothos/Callable/Callable.hpp>
 #include <utility> //std::forward
@@ -138,6 +139,18 @@ public:
      * \return a new proxy from the serialized data
      */
     virtual Proxy deserialize(std::istream &is) = 0;
+
+    /*!
+     * Make a batch of calls into this environment.
+     * The calls are made in order, and a call may reference
+     * the results of earlier calls with a ProxyBatchRef.
+     * The default implementation makes each call one at a time;
+     * remote environments send the entire batch in one round trip.
+     * Prefer the ProxyBatch class over calling this directly.
+     * \param calls a list of calls to make in order
+     * \return a list of results for each call
+     */
+    virtual std::vector<ProxyBatchResult> callBatch(const std::vector<ProxyBatchCall> &calls);
 };
 
 } //namespace Pothos
@@ -4,16 +4,18 @@
 /// Definitions for the ProxyHandle interface class.
 ///
 /// \copyright
-/// Copyright (c) 2013-2014 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
 #pragma once
 #include <Pothos/Config.hpp>
 #include <Pothos/Proxy/Proxy.hpp>
+#include <Pothos/Object/Object.hpp>
 #include <typeinfo>
 #include <string>
 #include <memory>
+#include <future>
 
 namespace Pothos {
 
@@ -55,6 +57,18 @@ public:
      */
     virtual Proxy call(const std::string &name, const Proxy *args, const size_t numArgs) = 0;
 
+    /*!
+     * Make a call on this handle without waiting for the result.
+     * The arguments are either Objects holding a Proxy or local values,
+     * so an implementation can send local values without conversion calls.
+     * The default implementation converts the arguments and calls call().
+     * \param name the name of the method
+     * \param args an array of Object arguments
+     * \param numArgs the number of arguments in the array
+     * \return a future for the Proxy result of the call
+     */
+    virtual std::future<Proxy> callAsync(const std::string &name, const Object *args, const size_t numArgs);
+
     /*!
      * Returns a negative integer, zero, or a positive integer as this object is
      * less than, equal to, or greater than the specified object.
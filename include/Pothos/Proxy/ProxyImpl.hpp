@@ -4,7 +4,7 @@
 /// Proxy template method implementations.
 ///
 /// \copyright
-/// Copyright (c) 2013-2017 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -89,6 +89,15 @@ Proxy Proxy::call(const std::string &name, ArgsType&&... args) const
     return handle->call(name, proxyArgs.data(), sizeof...(args));
 }
 
+template <typename... ArgsType>
+std::future<Proxy> Proxy::callAsync(const std::string &name, ArgsType&&... args) const
+{
+    const std::array<Object, sizeof...(ArgsType)> objArgs{{Object(std::forward<ArgsType>(args))...}};
+    auto handle = this->getHandle();
+    assert(handle);
+    return handle->callAsync(name, objArgs.data(), sizeof...(args));
+}
+
 template <typename... ArgsType>
 Proxy Proxy::callProxy(const std::string &name, ArgsType&&... args) const
 {
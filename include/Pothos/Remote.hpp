@@ -12,5 +12,7 @@
 #include <Pothos/Config.hpp>
 #include <Pothos/Remote/Client.hpp>
 #include <Pothos/Remote/Server.hpp>
+#include <Pothos/Remote/ServerPool.hpp>
 #include <Pothos/Remote/Handler.hpp>
+#include <Pothos/Remote/SocketStream.hpp>
 #include <Pothos/Remote/Exception.hpp>
@@ -4,7 +4,7 @@
 /// Remote access proxy client interface.
 ///
 /// \copyright
-/// Copyright (c) 2013-2016 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -33,6 +33,15 @@ public:
      * Make a client handle to interact with a remote server.
      * A unspecified port means use the default locator port.
      * URI format: tcp://resolvable_hostname:optional_port
+     * On unix, a server at the same host can use a domain socket: unix:///path/to/socket
+     *
+     * The URI query sets options for the connection sockets:
+     *
+     * - "sendBufferSize" the socket send buffer size in bytes (default from the system)
+     * - "recvBufferSize" the socket receive buffer size in bytes (default from the system)
+     * - "streamBufferSize" the buffer size of the transport stream (default 65536)
+     *
+     * Example: tcp://localhost:16415?sendBufferSize=4194304&recvBufferSize=4194304
      * \param uri a formatted string which specifies a server
      * \param timeoutUs the timeout to connect in microseconds
      */
@@ -52,12 +61,32 @@ public:
 
     /*!
      * Create a proxy environment that is interfaced through this remote client object.
+     *
+     * The client args are removed before the remaining args are passed to the server:
+     *
+     * - "lanes" the number of connections to the server (default 1).
+     *   The client connection is the priority lane for small requests,
+     *   and each additional lane is another socket to the same server.
+     * - "laneBytes" the request size in bytes that uses the additional lanes (default 65536).
+     *   Large requests like data uploads are spread across these lanes,
+     *   so that they do not stall small requests behind them.
+     *   Requests on different lanes are not ordered with respect to each other.
+     *
+     * \param name the name of the proxy environment on the server
+     * \param args the proxy environment args and the client args
      */
     ProxyEnvironment::Sptr makeEnvironment(const std::string &name, const ProxyEnvironmentArgs &args = ProxyEnvironmentArgs());
 
     /*!
      * Create a proxy environment that is interfaced over an iostream.
      * This allows for remote proxies that talk over pipes and sockets.
+     *
+     * The compression args are negotiated with the server:
+     *
+     * - "compression" the datagram compression: "zlib" or "none" (default none).
+     *   Compression is only used when the server supports it.
+     * - "compressBytes" the datagram size in bytes that is compressed (default 65536).
+     *   Smaller datagrams like control messages are sent uncompressed.
      */
     static ProxyEnvironment::Sptr makeEnvironment(std::istream &is, std::ostream &os,
         const std::string &name, const ProxyEnvironmentArgs &args = ProxyEnvironmentArgs());
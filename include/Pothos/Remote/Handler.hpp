@@ -4,7 +4,7 @@
 /// Proxy server instance handler.
 ///
 /// \copyright
-/// Copyright (c) 2013-2014 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -31,6 +31,8 @@ public:
     /*!
      * Run a handler for a remote proxy that is interfaced over an iostream.
      * This call blocks until the client's remote environment session destructs.
+     * Requests from different client threads execute concurrently on worker threads,
+     * while requests from the same client thread execute in the order received.
      */
     void runHandler(std::istream &is, std::ostream &os);
 
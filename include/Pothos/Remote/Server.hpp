@@ -4,7 +4,7 @@
 /// Remote access proxy server interface.
 ///
 /// \copyright
-/// Copyright (c) 2013-2016 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -59,7 +59,9 @@ public:
      * Spawn threads to read the stdout/err pipes from
      * the server process and forward to a syslog channel.
      * Only use when the server is created with closePipes false.
-     * \param addr the log destination in host:port format
+     * The server process blocks on its output when the logs back up.
+     * \param addr the log destination in host:port format,
+     * see Pothos::System::Logger::startSyslogForwarding()
      * \param source the repoted source of the log messages
      */
     void startSyslogForwarding(const std::string &addr, const std::string &source);
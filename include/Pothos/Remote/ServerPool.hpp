@@ -0,0 +1,80 @@
+///
+/// \file Remote/ServerPool.hpp
+///
+/// A pool of pre-spawned remote proxy server processes.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Remote/Server.hpp>
+#include <memory>
+#include <string>
+
+namespace Pothos {
+
+/*!
+ * A remote server pool keeps server processes spawned and initialized,
+ * so that acquiring a server does not wait on the process startup,
+ * which includes loading all of the plugin modules.
+ * A background thread replaces each server that is acquired.
+ *
+ * A resident proxy server can keep a default pool (see PothosUtil --server-pool),
+ * which a client uses through the remote environment of the resident server:
+ * \code
+ * auto server = remoteEnv->findProxy("Pothos/RemoteServerPool").call("spawn", uri);
+ * auto port = server.call<std::string>("getActualPort");
+ * \endcode
+ * The server process exits when the returned handle is deleted.
+ */
+class POTHOS_API RemoteServerPool
+{
+public:
+
+    //! Make an empty handle
+    RemoteServerPool(void);
+
+    /*!
+     * Create a pool and start spawning ready servers in the background.
+     * \param uri the server URI for each process (see RemoteServer)
+     * \param size the number of ready servers to keep
+     */
+    RemoteServerPool(const std::string &uri, const size_t size);
+
+    //! Get the server URI of the pool
+    const std::string &getUri(void) const;
+
+    //! Is this server pool active?
+    explicit operator bool(void) const;
+
+    //! The number of servers which are ready to acquire
+    size_t getNumReady(void) const;
+
+    /*!
+     * Acquire a ready server from the pool.
+     * A new server is spawned in the calling thread when none are ready.
+     * \throws RemoteServerError when the server cannot be spawned
+     */
+    RemoteServer acquire(void);
+
+    //! Set the default pool of this process (or an empty handle to clear)
+    static void setDefault(const RemoteServerPool &pool);
+
+    //! Get the default pool of this process (may be an empty handle)
+    static RemoteServerPool getDefault(void);
+
+    /*!
+     * Acquire a server from the default pool when its URI matches,
+     * otherwise spawn a new server process with the given URI.
+     */
+    static RemoteServer spawn(const std::string &uri);
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> _impl;
+};
+
+} //namespace Pothos
@@ -0,0 +1,53 @@
+///
+/// \file Remote/SocketStream.hpp
+///
+/// A buffered iostream transport over a connected socket.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <iostream>
+#include <memory>
+#include <cstdint> //intptr_t
+#include <cstddef> //size_t
+
+namespace Pothos {
+
+/*!
+ * A remote socket stream is the transport of the remote proxy connection.
+ * The stream calls send and recv directly on the native socket descriptor:
+ * writes are collected in the output buffer and sent upon flush(),
+ * and a write that does not fit is sent along with the buffered bytes
+ * in a single vectored send, so that a datagram header and a large payload
+ * leave in one system call without first copying the payload.
+ * Reads fill the input buffer with one recv of all available bytes,
+ * and large reads are received straight into the caller's memory.
+ * The stream does not own the socket, the caller keeps it open and closes it.
+ * One thread may read while another thread writes.
+ */
+class POTHOS_API RemoteSocketStream : public std::iostream
+{
+public:
+
+    //! The native socket descriptor: an int on unix, and a SOCKET on windows
+    typedef std::intptr_t NativeSocket;
+
+    /*!
+     * Create a stream over a connected stream socket.
+     * \param sock the native descriptor of the connected socket
+     * \param bufferSize the size in bytes of the input and output buffers
+     */
+    RemoteSocketStream(const NativeSocket sock, const size_t bufferSize = 65536);
+
+    //! Flush the buffered output upon destruction
+    ~RemoteSocketStream(void);
+
+private:
+    std::unique_ptr<std::streambuf> _buf;
+};
+
+} //namespace Pothos
@@ -15,4 +15,5 @@
 #include <Pothos/System/Paths.hpp>
 #include <Pothos/System/HostInfo.hpp>
 #include <Pothos/System/NumaInfo.hpp>
+#include <Pothos/System/CpuFeatures.hpp>
 #include <Pothos/System/Exception.hpp>
@@ -0,0 +1,64 @@
+///
+/// \file System/CpuFeatures.hpp
+///
+/// Support for querying the instruction set extensions of the host CPU.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <string>
+#include <vector>
+
+namespace Pothos {
+namespace System {
+
+/*!
+ * CpuFeatures lists the instruction set extensions usable on this host.
+ * An extension is only reported when both the CPU and the OS support it,
+ * for example AVX also requires the OS to save the extended registers.
+ */
+class POTHOS_API CpuFeatures
+{
+public:
+    /*!
+     * Create a CpuFeatures with no extensions
+     */
+    CpuFeatures(void);
+
+    /*!
+     * Query the features of the host CPU.
+     * The detection runs once and the result is cached.
+     */
+    static CpuFeatures get(void);
+
+    /*!
+     * The names of all known extensions, ordered from the best to the least.
+     * The names are: avx512f, avx2, avx, sse4_2, sse4_1, sve, neon
+     */
+    static std::vector<std::string> ranking(void);
+
+    /*!
+     * Is the named extension supported?
+     * \param name an extension name from ranking()
+     * \return true when supported, false for unsupported or unknown names
+     */
+    bool has(const std::string &name) const;
+
+    //! The names of the supported extensions, ordered as in ranking()
+    std::vector<std::string> names(void) const;
+
+    bool sse4_1;
+    bool sse4_2;
+    bool avx;
+    bool avx2;
+    bool avx512f;
+    bool neon;
+    bool sve;
+};
+
+} //namespace System
+} //namespace Pothos
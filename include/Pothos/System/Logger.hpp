@@ -4,7 +4,7 @@
 /// API calls for logger control.
 ///
 /// \copyright
-/// Copyright (c) 2014-2015 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -24,6 +24,7 @@ public:
     /*!
      * Start a listener for syslog messages from other processes.
      * The log messages will be forwarded to the default logger.
+     * The listener accepts TCP streams and UDP datagrams on the same port.
      * \return the port that this process is listening
      */
     static std::string startSyslogListener(void);
@@ -35,7 +36,10 @@ public:
 
     /*!
      * Start syslog forwarding to the given address.
-     * \param addr the log destination in host:port format
+     * Messages are batched over a TCP stream with back-pressure,
+     * or sent as UDP datagrams when the listener does not accept TCP.
+     * \param addr the log destination in host:port format,
+     * prefix tcp:// or udp:// to select the transport
      */
     static void startSyslogForwarding(const std::string &addr);
 
@@ -62,6 +66,7 @@ public:
      * POTHOS_LOG_LEVEL - what level to display logs (default notice)
      * POTHOS_LOG_CHANNEL - how to display the logs (default color)
      * POTHOS_LOG_FILE - log file path if POTHOS_LOG_CHANNEL=file specified
+     * POTHOS_LOG_ASYNC - log from a background thread (default true)
      */
     static void setupDefaultLogging(void);
 
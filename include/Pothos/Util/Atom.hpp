@@ -0,0 +1,170 @@
+///
+/// \file Util/Atom.hpp
+///
+/// Interned strings with integer identity.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <functional> //hash
+#include <iosfwd>
+#include <string>
+
+namespace Pothos {
+namespace Util {
+
+/*!
+ * An Atom is a string interned in a process-wide atom table.
+ * Every atom with the same string has the same integer ID,
+ * so equality, ordering, and hashing are integer operations.
+ * Construction from a string looks up the global table,
+ * so atoms used in hot loops should be constructed once and reused:
+ * \code
+ * static const Pothos::Util::Atom rxTime("rxTime");
+ * if (label.atom() == rxTime) ...
+ * \endcode
+ * The atom table only grows, so atoms are intended for a bounded
+ * set of well known keys and identifiers rather than arbitrary data.
+ */
+class POTHOS_API Atom
+{
+public:
+    //! Create the atom for the empty string (ID 0)
+    Atom(void);
+
+    //! Create an atom from a string, interning it when new
+    Atom(const std::string &str);
+
+    //! Create an atom from a C string, interning it when new
+    Atom(const char *str);
+
+    //! Get the unique integer ID of this atom
+    size_t id(void) const;
+
+    //! Get the interned string of this atom
+    const std::string &str(void) const;
+
+    //! Implicit conversion to the interned string
+    operator const std::string &(void) const;
+
+    //! Is this the atom for the empty string?
+    bool empty(void) const;
+
+private:
+    const std::string *_str;
+    size_t _id;
+};
+
+//! Atom equality compares the integer IDs
+inline bool operator==(const Atom &lhs, const Atom &rhs);
+
+//! Atom inequality compares the integer IDs
+inline bool operator!=(const Atom &lhs, const Atom &rhs);
+
+//! Atom ordering is by ID (the interning order), not the string
+inline bool operator<(const Atom &lhs, const Atom &rhs);
+
+//! Compare an atom to a string without interning the string
+inline bool operator==(const Atom &lhs, const std::string &rhs);
+
+//! Compare an atom to a string without interning the string
+inline bool operator==(const std::string &lhs, const Atom &rhs);
+
+//! Compare an atom to a string without interning the string
+inline bool operator!=(const Atom &lhs, const std::string &rhs);
+
+//! Compare an atom to a string without interning the string
+inline bool operator!=(const std::string &lhs, const Atom &rhs);
+
+//! Compare an atom to a C string without interning the string
+inline bool operator==(const Atom &lhs, const char *rhs);
+
+//! Compare an atom to a C string without interning the string
+inline bool operator!=(const Atom &lhs, const char *rhs);
+
+//! Write the interned string of an atom to a stream
+POTHOS_API std::ostream &operator<<(std::ostream &os, const Atom &atom);
+
+} //namespace Util
+} //namespace Pothos
+
+namespace std {
+    //! Hash an atom by its integer ID
+    template <>
+    struct hash<Pothos::Util::Atom>
+    {
+        size_t operator()(const Pothos::Util::Atom &atom) const
+        {
+            return std::hash<size_t>()(atom.id());
+        }
+    };
+} //namespace std
+
+inline size_t Pothos::Util::Atom::id(void) const
+{
+    return _id;
+}
+
+inline const std::string &Pothos::Util::Atom::str(void) const
+{
+    return *_str;
+}
+
+inline Pothos::Util::Atom::operator const std::string &(void) const
+{
+    return *_str;
+}
+
+inline bool Pothos::Util::Atom::empty(void) const
+{
+    return _id == 0;
+}
+
+inline bool Pothos::Util::operator==(const Atom &lhs, const Atom &rhs)
+{
+    return lhs.id() == rhs.id();
+}
+
+inline bool Pothos::Util::operator!=(const Atom &lhs, const Atom &rhs)
+{
+    return lhs.id() != rhs.id();
+}
+
+inline bool Pothos::Util::operator<(const Atom &lhs, const Atom &rhs)
+{
+    return lhs.id() < rhs.id();
+}
+
+inline bool Pothos::Util::operator==(const Atom &lhs, const std::string &rhs)
+{
+    return lhs.str() == rhs;
+}
+
+inline bool Pothos::Util::operator==(const std::string &lhs, const Atom &rhs)
+{
+    return lhs == rhs.str();
+}
+
+inline bool Pothos::Util::operator!=(const Atom &lhs, const std::string &rhs)
+{
+    return lhs.str() != rhs;
+}
+
+inline bool Pothos::Util::operator!=(const std::string &lhs, const Atom &rhs)
+{
+    return lhs != rhs.str();
+}
+
+inline bool Pothos::Util::operator==(const Atom &lhs, const char *rhs)
+{
+    return lhs.str() == rhs;
+}
+
+inline bool Pothos::Util::operator!=(const Atom &lhs, const char *rhs)
+{
+    return lhs.str() != rhs;
+}
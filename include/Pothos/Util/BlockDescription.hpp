@@ -5,7 +5,7 @@
 /// https://github.com/pothosware/pothos/wiki/BlockDescriptionMarkup
 ///
 /// \copyright
-/// Copyright (c) 2016-2017 Josh Blum
+/// Copyright (c) 2016-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -40,6 +40,8 @@ public:
 
     /*!
      * Feed the parser a source file with embedded markup.
+     * The parsed descriptions are cached in the user data directory
+     * and reused as long as the contents of the file are unchanged.
      * \param filePath the path to a source file
      * \throws SyntaxException if the parsing failed
      * \throws FileException for file access errors
@@ -4,7 +4,7 @@
 /// Compiler utilities for creating API control of various compilers.
 ///
 /// \copyright
-/// Copyright (c) 2014-2016 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -27,7 +27,10 @@ public:
     //! Create an empty compiler args
     CompilerArgs(void);
 
-    //! Create a new args with default Pothos development libraries + includes
+    /*!
+     * Create a new args with default Pothos development libraries + includes.
+     * The default precompiled headers are Pothos/Framework.hpp and Pothos/Proxy.hpp.
+     */
     static CompilerArgs defaultDevEnv(void);
 
     //! A list of source file paths
@@ -41,6 +44,13 @@ public:
 
     //! A list of compiler flags
     std::vector<std::string> flags;
+
+    /*!
+     * A list of headers to include ahead of every source, ex: "Pothos/Framework.hpp".
+     * Compilers that support it build the headers into a precompiled header
+     * once for each set of compiler inputs, and cache it across processes.
+     */
+    std::vector<std::string> precompiledHeaders;
 };
 
 /*!
@@ -71,6 +81,7 @@ public:
 
     /*!
      * Compile a set of C++ sources into a runtime loadable module.
+     * Compilers may compile multiple sources in parallel before linking.
      * \throws Exception with message when a compilation fails
      * \param args the compiler arguments (flags and sources)
      * \return the path to the output binary/loadable module
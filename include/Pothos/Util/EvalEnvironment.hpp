@@ -4,7 +4,7 @@
 /// Expression evaluation utilities.
 ///
 /// \copyright
-/// Copyright (c) 2014-2016 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -21,6 +21,12 @@ namespace Util {
  * The evaluation environment can evaluate and inspect expressions.
  * Expressions are considered to be valid C++ expressions involving
  * bools, integers, strings, floats, stl classes...
+ *
+ * The environment is thread-safe: threads may call eval() concurrently,
+ * such as to evaluate the blocks of a design in parallel.
+ * Each thread evaluates with its own parser, and the registered constants
+ * are shared by all threads; a change to the constants is seen by
+ * the evaluations that begin after the register or unregister call.
  */
 class POTHOS_API EvalEnvironment
 {
@@ -63,6 +69,24 @@ public:
      */
     void unregisterConstant(const std::string &key);
 
+    /*!
+     * Get the registered constants that an expression references by name.
+     * Names inside of string literals are not references.
+     * \param expr a string expression
+     * \return a list of constant names without duplicates
+     */
+    std::vector<std::string> getReferencedConstants(const std::string &expr) const;
+
+    /*!
+     * Get the constants that a constant depends upon.
+     * These are the constants that its expression referenced
+     * when it was registered with registerConstantExpr().
+     * Constants registered with registerConstantObj() have no dependencies.
+     * \param key the name of a registered constant
+     * \return a list of constant names without duplicates
+     */
+    std::vector<std::string> getConstantDependencies(const std::string &key) const;
+
 private:
     struct Impl; std::shared_ptr<Impl> _impl;
 
@@ -0,0 +1,162 @@
+///
+/// \file Util/LatencyHistogram.hpp
+///
+/// A fixed-size lock-free histogram for latency measurements.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <cstdlib> //size_t
+#include <atomic>
+
+namespace Pothos {
+namespace Util {
+
+/*!
+ * LatencyHistogram records values (typically nanoseconds) into
+ * logarithmic buckets with linear sub-buckets, similar to an HDR histogram.
+ * Each power of two range is split into 16 sub-buckets,
+ * so the relative error of a percentile is bounded by 1/16.
+ * Values are clamped to the largest bucket (2^40, about 18 minutes in ns).
+ *
+ * The buckets are a fixed array of atomics: one thread at a time may record
+ * and any thread may read the counts without blocking the recording thread.
+ * The counts read while recording is in progress are approximate.
+ */
+class LatencyHistogram
+{
+public:
+    //! The number of sub-bucket bits per power of two
+    static const size_t SUB_BITS = 4;
+
+    //! The maximum power of two that can be represented
+    static const size_t MAX_BITS = 40;
+
+    //! The total number of buckets in the histogram
+    static const size_t NUM_BUCKETS = (1 << SUB_BITS)*(MAX_BITS-SUB_BITS+2);
+
+    //! Create an empty histogram
+    LatencyHistogram(void)
+    {
+        this->reset();
+    }
+
+    /*!
+     * Record a value into the histogram (single recording thread).
+     * \param value the value to record
+     */
+    void record(const unsigned long long value)
+    {
+        auto &bucket = _buckets[bucketIndex(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+        _count.store(_count.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+        _sum.store(_sum.load(std::memory_order_relaxed)+value, std::memory_order_relaxed);
+        if (value < _min.load(std::memory_order_relaxed)) _min.store(value, std::memory_order_relaxed);
+        if (value > _max.load(std::memory_order_relaxed)) _max.store(value, std::memory_order_relaxed);
+    }
+
+    //! Clear all recorded values
+    void reset(void)
+    {
+        for (auto &bucket : _buckets) bucket.store(0, std::memory_order_relaxed);
+        _count.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _min.store(~0ull, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    //! Get the number of recorded values
+    unsigned long long count(void) const
+    {
+        return _count.load(std::memory_order_relaxed);
+    }
+
+    //! Get the sum of all recorded values
+    unsigned long long sum(void) const
+    {
+        return _sum.load(std::memory_order_relaxed);
+    }
+
+    //! Get the smallest recorded value (0 when empty)
+    unsigned long long min(void) const
+    {
+        return (this->count() == 0)?0:_min.load(std::memory_order_relaxed);
+    }
+
+    //! Get the largest recorded value
+    unsigned long long max(void) const
+    {
+        return _max.load(std::memory_order_relaxed);
+    }
+
+    //! Get the count in the bucket at the specified index
+    unsigned long long bucketCount(const size_t index) const
+    {
+        return _buckets[index].load(std::memory_order_relaxed);
+    }
+
+    //! Get the smallest value that maps into the bucket at the specified index
+    static unsigned long long bucketLowerBound(const size_t index)
+    {
+        const size_t subCount = 1 << SUB_BITS;
+        if (index < subCount) return index;
+        const size_t shift = index/subCount - 1;
+        return (subCount + index%subCount) << shift;
+    }
+
+    //! Get the bucket index for a value
+    static size_t bucketIndex(const unsigned long long value)
+    {
+        const size_t subCount = 1 << SUB_BITS;
+        if (value < subCount) return size_t(value);
+        size_t msb = 0;
+        for (auto v = value; v >>= 1;) msb++;
+        if (msb > MAX_BITS) return NUM_BUCKETS-1;
+        const size_t shift = msb - SUB_BITS;
+        return (shift+1)*subCount + size_t(value >> shift) - subCount;
+    }
+
+    /*!
+     * Get the value at the specified percentile.
+     * The result is the lower bound of the bucket containing the percentile,
+     * clamped to the recorded min and max values.
+     * \param percentile a number between 0.0 and 100.0
+     * \return the value or 0 when the histogram is empty
+     */
+    unsigned long long percentile(const double percentile) const
+    {
+        unsigned long long total = 0;
+        for (const auto &bucket : _buckets) total += bucket.load(std::memory_order_relaxed);
+        if (total == 0) return 0;
+
+        auto target = (unsigned long long)((percentile/100.0)*total + 0.5);
+        if (target == 0) target = 1;
+        if (target > total) target = total;
+
+        unsigned long long accum = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; i++)
+        {
+            accum += _buckets[i].load(std::memory_order_relaxed);
+            if (accum < target) continue;
+            auto value = bucketLowerBound(i);
+            if (value < this->min()) value = this->min();
+            if (value > this->max()) value = this->max();
+            return value;
+        }
+        return this->max();
+    }
+
+private:
+    std::atomic<unsigned long long> _buckets[NUM_BUCKETS];
+    std::atomic<unsigned long long> _count;
+    std::atomic<unsigned long long> _sum;
+    std::atomic<unsigned long long> _min;
+    std::atomic<unsigned long long> _max;
+};
+
+} //namespace Util
+} //namespace Pothos
@@ -0,0 +1,191 @@
+///
+/// \file Util/MonotonicArena.hpp
+///
+/// A monotonic memory arena for transient allocations.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <cstdlib> //size_t
+#include <cstddef> //max_align_t
+#include <cstdint> //uintptr_t
+#include <algorithm> //max
+#include <memory> //unique_ptr
+#include <new> //bad_alloc
+#include <vector>
+
+namespace Pothos {
+namespace Util {
+
+/*!
+ * MonotonicArena hands out memory from large chunks by bumping an offset.
+ * Individual allocations are never freed, instead reset() releases
+ * all of the allocations of a cycle at once, such as a work() call.
+ * The arena keeps its memory across resets: when a cycle overflowed
+ * into extra chunks, reset() replaces them with one chunk of the total
+ * size, so that the steady state allocates from a single chunk.
+ * The arena is not thread safe, one thread at a time may use it.
+ */
+class MonotonicArena
+{
+public:
+    /*!
+     * Create an arena, memory is allocated upon the first use.
+     * \param chunkSize the size in bytes of the first chunk
+     */
+    MonotonicArena(const size_t chunkSize = 4096):
+        _chunkSize(std::max<size_t>(chunkSize, 64)),
+        _offset(0),
+        _used(0)
+    {
+        return;
+    }
+
+    /*!
+     * Allocate memory that remains valid until the next reset().
+     * \param numBytes the number of bytes to allocate
+     * \param alignment a power of two alignment of the address
+     * \return a pointer to the uninitialized memory
+     */
+    void *allocate(const size_t numBytes, const size_t alignment = alignof(std::max_align_t))
+    {
+        if (not _chunks.empty())
+        {
+            const auto base = reinterpret_cast<std::uintptr_t>(_chunks.back().data.get());
+            const auto start = ((base + _offset + alignment - 1) & ~std::uintptr_t(alignment - 1)) - base;
+            if (start + numBytes <= _chunks.back().size)
+            {
+                _offset = start + numBytes;
+                _used += numBytes;
+                return _chunks.back().data.get() + start;
+            }
+        }
+
+        //overflow into a new chunk with room for the aligned allocation
+        const size_t size = std::max(_chunkSize, numBytes + alignment);
+        _chunks.emplace_back(size);
+        _chunkSize = std::max(_chunkSize, size);
+        _offset = 0;
+        return this->allocate(numBytes, alignment);
+    }
+
+    /*!
+     * Release all allocations at once.
+     * The destructors of objects in the arena are not called.
+     */
+    void reset(void)
+    {
+        if (_chunks.size() > 1)
+        {
+            size_t total(0);
+            for (const auto &chunk : _chunks) total += chunk.size;
+            _chunks.clear();
+            _chunks.emplace_back(total);
+            _chunkSize = total;
+        }
+        _offset = 0;
+        _used = 0;
+    }
+
+    //! The bytes allocated since the last reset
+    size_t used(void) const
+    {
+        return _used;
+    }
+
+    //! The bytes held by the arena in all chunks
+    size_t capacity(void) const
+    {
+        size_t total(0);
+        for (const auto &chunk : _chunks) total += chunk.size;
+        return total;
+    }
+
+    //! The number of chunks, one in the steady state
+    size_t numChunks(void) const
+    {
+        return _chunks.size();
+    }
+
+private:
+    struct Chunk
+    {
+        Chunk(const size_t size): data(new char[size]), size(size){}
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    size_t _chunkSize;
+    size_t _offset; //the bytes used of the last chunk
+    size_t _used;
+    std::vector<Chunk> _chunks;
+};
+
+/*!
+ * ArenaAllocator is a standard allocator that allocates from a MonotonicArena.
+ * Use it with the standard containers for transient data,
+ * and do not use the containers past the next reset() of the arena.
+ * Deallocation is a no-op, the memory is released upon the reset().
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    //! Create an allocator for the arena
+    ArenaAllocator(MonotonicArena &arena):
+        _arena(&arena)
+    {
+        return;
+    }
+
+    //! Rebind copy from an allocator of another type
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other):
+        _arena(other.arena())
+    {
+        return;
+    }
+
+    //! Allocate space for n elements of T
+    T *allocate(const size_t n)
+    {
+        if (n > size_t(-1)/sizeof(T)) throw std::bad_alloc();
+        return static_cast<T *>(_arena->allocate(n*sizeof(T), alignof(T)));
+    }
+
+    //! The memory is released upon the reset of the arena
+    void deallocate(T *, const size_t)
+    {
+        return;
+    }
+
+    //! Get the arena of this allocator
+    MonotonicArena *arena(void) const
+    {
+        return _arena;
+    }
+
+private:
+    MonotonicArena *_arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs)
+{
+    return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs)
+{
+    return lhs.arena() != rhs.arena();
+}
+
+} //namespace Util
+} //namespace Pothos
@@ -4,12 +4,15 @@
 /// Templated fixed point utilities and Q-format conversions.
 ///
 /// \copyright
-/// Copyright (c) 2015-2016 Josh Blum
+/// Copyright (c) 2015-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
+#pragma once
 #include <Pothos/Config.hpp>
 #include <type_traits>
+#include <cstdint>
+#include <cstddef>
 #include <complex>
 #include <cmath>
 
@@ -76,6 +79,51 @@ T floatToQ(const U &in, const int n);
 template <typename T, typename U>
 T floatToQ(const U &in);
 
+/*!
+ * Convert an array of floating point numbers into Q format.
+ * Unlike the scalar floatToQ(), which truncates like a C++ cast,
+ * the bulk conversion rounds to the nearest integer with ties to even.
+ * The conversion is vectorized for the instruction sets of the host CPU.
+ *
+ * \param in the input numbers
+ * \param [out] out the output numbers in Q format
+ * \param num the number of elements to convert
+ * \param n the number of fractional bits
+ * \param saturate true to clamp out of range inputs and convert NaN to zero,
+ *        otherwise the results for out of range inputs are unspecified
+ */
+POTHOS_API void floatToQ(const float *in, int16_t *out, const size_t num, const int n, const bool saturate = true);
+
+//! Convert an array of floating point numbers into Q format (32-bit output)
+POTHOS_API void floatToQ(const float *in, int32_t *out, const size_t num, const int n, const bool saturate = true);
+
+//! Convert an array of complex floating point numbers into Q format
+POTHOS_API void floatToQ(const std::complex<float> *in, std::complex<int16_t> *out, const size_t num, const int n, const bool saturate = true);
+
+//! Convert an array of complex floating point numbers into Q format (32-bit output)
+POTHOS_API void floatToQ(const std::complex<float> *in, std::complex<int32_t> *out, const size_t num, const int n, const bool saturate = true);
+
+/*!
+ * Convert an array of Q format numbers into floating point.
+ * The inputs are scaled down by the number of fractional bits.
+ * The conversion is vectorized for the instruction sets of the host CPU.
+ *
+ * \param in the input numbers in Q format
+ * \param [out] out the output numbers
+ * \param num the number of elements to convert
+ * \param n the number of fractional bits
+ */
+POTHOS_API void fromQ(const int16_t *in, float *out, const size_t num, const int n);
+
+//! Convert an array of Q format numbers into floating point (32-bit input)
+POTHOS_API void fromQ(const int32_t *in, float *out, const size_t num, const int n);
+
+//! Convert an array of complex Q format numbers into floating point
+POTHOS_API void fromQ(const std::complex<int16_t> *in, std::complex<float> *out, const size_t num, const int n);
+
+//! Convert an array of complex Q format numbers into floating point (32-bit input)
+POTHOS_API void fromQ(const std::complex<int32_t> *in, std::complex<float> *out, const size_t num, const int n);
+
 namespace Detail {
 
 template <typename T, typename U>
@@ -4,7 +4,7 @@
 /// A templated double ended queue implemented on top of a vector.
 ///
 /// \copyright
-/// Copyright (c) 2013-2017 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -12,7 +12,10 @@
 #include <Pothos/Config.hpp>
 #include <cstdlib> //size_t
 #include <utility> //forward
+#include <algorithm> //min
 #include <memory> //allocator
+#include <type_traits>
+#include <cstring> //memcpy
 #include <cassert>
 
 namespace Pothos {
@@ -91,6 +94,52 @@ public:
     //! Get a reference to the back element
     T &back(void);
 
+    //! A contiguous run of elements in the deque's storage
+    template <typename U>
+    struct Span
+    {
+        U *data; //!< pointer to the first element
+        size_t size; //!< the number of elements
+        U *begin(void) const {return data;} //!< iteration begin
+        U *end(void) const {return data+size;} //!< iteration end
+    };
+
+    typedef Span<T> span; //!< A mutable contiguous run of elements
+
+    typedef Span<const T> const_span; //!< A const contiguous run of elements
+
+    /*!
+     * Push a range of elements onto the back of the queue.
+     * The space is checked once for the entire range, and
+     * trivially copyable elements are copied with at most two memcpys.
+     * \param elems a pointer to the first element to copy
+     * \param num the number of elements to copy
+     */
+    void push_back_range(const T *elems, const size_t num);
+
+    //! Pop a number of elements from the front of the queue
+    void pop_front_n(const size_t num);
+
+    /*!
+     * Get the contiguous elements starting at the front.
+     * The span ends at the back or at the end of the storage;
+     * the remaining elements, if any, are given by back_span().
+     */
+    span front_span(void);
+
+    //! Get the contiguous elements starting at the front
+    const_span front_span(void) const;
+
+    /*!
+     * Get the contiguous elements that follow front_span().
+     * The span is empty unless the elements wrap around the storage.
+     * Together the two spans hold all elements in order.
+     */
+    span back_span(void);
+
+    //! Get the contiguous elements that follow front_span()
+    const_span back_span(void) const;
+
     //! Is the deque empty? -- no elements
     bool empty(void) const;
 
@@ -301,6 +350,66 @@ T &RingDeque<T, A>::back(void)
     return (*this)[size_t(_numElements-1)];
 }
 
+template <typename T, typename A>
+void RingDeque<T, A>::push_back_range(const T *elems, const size_t num)
+{
+    assert(_numElements + num <= _capacity);
+    if (not std::is_trivially_copyable<T>::value)
+    {
+        for (size_t i = 0; i < num; i++) this->emplace_back(elems[i]);
+        return;
+    }
+    const size_t backIndex = (_frontIndex + _numElements) & _mask;
+    const size_t first = std::min(num, _mask + 1 - backIndex);
+    std::memcpy(static_cast<void *>(_container + backIndex), elems, first*sizeof(T));
+    std::memcpy(static_cast<void *>(_container), elems + first, (num - first)*sizeof(T));
+    _numElements += num;
+}
+
+template <typename T, typename A>
+void RingDeque<T, A>::pop_front_n(const size_t num)
+{
+    assert(num <= _numElements);
+    if (not std::is_trivially_destructible<T>::value)
+    {
+        for (size_t i = 0; i < num; i++) this->pop_front();
+        return;
+    }
+    _frontIndex += num;
+    _numElements -= num;
+}
+
+template <typename T, typename A>
+typename RingDeque<T, A>::span RingDeque<T, A>::front_span(void)
+{
+    const size_t frontIndex = _frontIndex & _mask;
+    span out = {_container + frontIndex, std::min(_numElements, _mask + 1 - frontIndex)};
+    return out;
+}
+
+template <typename T, typename A>
+typename RingDeque<T, A>::const_span RingDeque<T, A>::front_span(void) const
+{
+    const auto s = const_cast<RingDeque<T, A> *>(this)->front_span();
+    const_span out = {s.data, s.size};
+    return out;
+}
+
+template <typename T, typename A>
+typename RingDeque<T, A>::span RingDeque<T, A>::back_span(void)
+{
+    span out = {_container, _numElements - this->front_span().size};
+    return out;
+}
+
+template <typename T, typename A>
+typename RingDeque<T, A>::const_span RingDeque<T, A>::back_span(void) const
+{
+    const auto s = const_cast<RingDeque<T, A> *>(this)->back_span();
+    const_span out = {s.data, s.size};
+    return out;
+}
+
 template <typename T, typename A>
 bool RingDeque<T, A>::empty(void) const
 {
@@ -341,10 +450,7 @@ void RingDeque<T, A>::set_capacity(const size_t capacity)
 template <typename T, typename A>
 void RingDeque<T, A>::clear(void)
 {
-    while (not this->empty())
-    {
-        this->pop_front();
-    }
+    this->pop_front_n(_numElements);
 }
 
 } //namespace Util
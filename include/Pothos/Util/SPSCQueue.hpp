@@ -0,0 +1,111 @@
+///
+/// \file Util/SPSCQueue.hpp
+///
+/// A bounded lock-free single-producer single-consumer queue.
+///
+/// \copyright
+/// Copyright (c) 2020-2020 Josh Blum
+/// SPDX-License-Identifier: BSL-1.0
+///
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <cstdlib> //size_t
+#include <utility> //move
+#include <vector>
+#include <atomic>
+
+namespace Pothos {
+namespace Util {
+
+/*!
+ * SPSCQueue is a bounded ring of elements with lock-free push and pop.
+ * One thread at a time may push and one thread at a time may pop;
+ * the caller is responsible for serializing multiple producers
+ * or multiple consumers, for example with a try-lock or mutex.
+ * Popped slots are reset to a default constructed element
+ * so that the queue does not hold references to old elements.
+ */
+template <typename T>
+class SPSCQueue
+{
+public:
+    /*!
+     * Construct a new queue
+     * \param capacity the maximum number of elements (rounded up to a power of 2)
+     */
+    SPSCQueue(const size_t capacity = 64):
+        _mask(roundUpPow2(capacity)-1),
+        _ring(_mask+1),
+        _head(0),
+        _tail(0)
+    {
+        return;
+    }
+
+    //! How many elements can be held in this queue?
+    size_t capacity(void) const
+    {
+        return _mask+1;
+    }
+
+    /*!
+     * Push an element into the back of the queue (producer only).
+     * \return true for success, false when the queue is full
+     */
+    template <typename U>
+    bool push(U &&elem)
+    {
+        const auto head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) > _mask) return false;
+        _ring[head & _mask] = std::forward<U>(elem);
+        _head.store(head+1, std::memory_order_release);
+        return true;
+    }
+
+    /*!
+     * Pop an element from the front of the queue (consumer only).
+     * \param [out] elem the popped element (moved out of the queue)
+     * \return true for success, false when the queue is empty
+     */
+    bool pop(T &elem)
+    {
+        const auto tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        auto &slot = _ring[tail & _mask];
+        elem = std::move(slot);
+        slot = T();
+        _tail.store(tail+1, std::memory_order_release);
+        return true;
+    }
+
+    /*!
+     * Is the queue empty? (consumer only)
+     * Producers may push at any time so the result is a snapshot.
+     */
+    bool empty(void) const
+    {
+        return _tail.load(std::memory_order_relaxed) == _head.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t roundUpPow2(const size_t n)
+    {
+        size_t r = 1;
+        while (r < n) r <<= 1;
+        return r;
+    }
+
+    const size_t _mask;
+    std::vector<T> _ring;
+
+    //keep the producer and consumer indexes on separate cache lines
+    char _pad0[64];
+    std::atomic<size_t> _head;
+    char _pad1[64];
+    std::atomic<size_t> _tail;
+    char _pad2[64];
+};
+
+} //namespace Util
+} //namespace Pothos
@@ -4,22 +4,37 @@
 /// A simple C++11 spin lock implementation.
 ///
 /// \copyright
-/// Copyright (c) 2014-2017 Josh Blum
+/// Copyright (c) 2014-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
 #pragma once
 #include <Pothos/Config.hpp>
 #include <atomic>
+#include <thread>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h> //_mm_pause
+#endif
 
 namespace Pothos {
 namespace Util {
 
+/*!
+ * Hint to the processor that the calling thread is in a spin wait loop.
+ * This lowers the power and memory ordering cost of the spin,
+ * and frees execution resources for a sibling hyper-thread.
+ */
+inline void spinPause(void) noexcept;
+
 /*!
  * A generic spin lock implementation using std::atomic.
  *
- * There are no embedded back-off or sleep conditions in this lock,
- * therefore only use this lock to protect very brief code sections.
+ * Waiters spin on a plain load of the lock (test and test-and-set),
+ * so the cache line is only written when the lock appears free.
+ * The spin uses an exponential back-off of processor pause hints,
+ * and then yields the thread to let a preempted lock holder run
+ * when the host has more runnable threads than cores.
+ * Only use this lock to protect very brief code sections.
  *
  * This lock can be used with std::lock_guard<Pothos::Util::SpinLock>
  */
@@ -40,12 +55,24 @@ public:
     void unlock(void) noexcept;
 
 private:
-    std::atomic_flag _lock;
+    enum : size_t {MAX_BACKOFF = 64};
+    std::atomic<bool> _lock;
 };
 
 } //namespace Util
 } //namespace Pothos
 
+inline void Pothos::Util::spinPause(void) noexcept
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+    __asm__ __volatile__("yield");
+#endif
+}
+
 inline Pothos::Util::SpinLock::SpinLock(void)
 {
     this->unlock();
@@ -53,15 +80,29 @@ inline Pothos::Util::SpinLock::SpinLock(void)
 
 inline bool Pothos::Util::SpinLock::try_lock(void) noexcept
 {
-    return not _lock.test_and_set(std::memory_order_acquire);
+    return not _lock.load(std::memory_order_relaxed) and
+        not _lock.exchange(true, std::memory_order_acquire);
 }
 
 inline void Pothos::Util::SpinLock::lock(void) noexcept
 {
-    while (not this->try_lock()){}
+    size_t backoff(1);
+    while (not this->try_lock())
+    {
+        //wait on the load until the lock appears free
+        while (_lock.load(std::memory_order_relaxed))
+        {
+            if (backoff > MAX_BACKOFF) std::this_thread::yield();
+            else
+            {
+                for (size_t i = 0; i < backoff; i++) spinPause();
+                backoff *= 2;
+            }
+        }
+    }
 }
 
 inline void Pothos::Util::SpinLock::unlock(void) noexcept
 {
-    _lock.clear(std::memory_order_release);
+    _lock.store(false, std::memory_order_release);
 }
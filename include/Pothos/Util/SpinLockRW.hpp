@@ -4,7 +4,7 @@
 /// A read/write spinlock implementation
 ///
 /// \copyright
-/// Copyright (c) 2017-2017 Josh Blum
+/// Copyright (c) 2017-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -46,6 +46,14 @@ private:
  * which require write locks during the plugin's loader hooks but
  * then requires almost exclusively reads during runtime operation.
  *
+ * Readers count themselves in one of several cache line sized slots,
+ * selected per thread, so concurrent readers do not contend on one atomic.
+ * The lock prefers writers: new readers wait while a writer is waiting,
+ * so writers can not be starved by a continuous stream of readers.
+ * A thread that already holds the shared lock may lock it shared again
+ * without waiting, even when a writer is waiting for the readers to drain.
+ * Waiters spin with processor pause hints and then yield.
+ *
  * - For writers, use with std::lock_guard<Pothos::Util::SpinLock>
  * - For readers, use with Pothos::Util::SpinLockRW::SharedLock
  */
@@ -78,61 +86,15 @@ public:
     void unlock(void) noexcept;
 
 private:
-    enum : unsigned {WRITER_LOCK = unsigned(~0), UNLOCKED = 0};
-    std::atomic<unsigned> _lock;
+    enum : size_t {NUM_READER_SLOTS = 16};
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<unsigned> count;
+    };
+    bool readersDrained(void) const noexcept;
+    std::atomic<bool> _writer;
+    ReaderSlot _readers[NUM_READER_SLOTS];
 };
 
 } //namespace Util
 } //namespace Pothos
-
-
-inline Pothos::Util::SpinLockRW::SpinLockRW(void)
-{
-    this->unlock();
-}
-
-inline bool Pothos::Util::SpinLockRW::try_lock_shared(void) noexcept
-{
-    //true when the expected condition is not write lock
-    //and swap in the value of expected +1 (additional reader)
-    unsigned expected = _lock.load(std::memory_order_acquire);
-    return expected != WRITER_LOCK and _lock.compare_exchange_weak(expected, expected+1, std::memory_order_acq_rel);
-}
-
-inline void Pothos::Util::SpinLockRW::lock_shared(void) noexcept
-{
-    size_t count(0);
-    while (not this->try_lock_shared())
-    {
-        if (++count > 1024) std::this_thread::yield();
-    }
-}
-
-inline void Pothos::Util::SpinLockRW::unlock_shared(void) noexcept
-{
-    //decrement the reader count by 1
-    _lock.fetch_sub(1, std::memory_order_release);
-}
-
-inline bool Pothos::Util::SpinLockRW::try_lock(void) noexcept
-{
-    //true when the expected condition is unlocked (no readers)
-    //and swap in the value of write lock (one writer)
-    unsigned expected = UNLOCKED;
-    return _lock.compare_exchange_weak(expected, WRITER_LOCK, std::memory_order_acq_rel);
-}
-
-inline void Pothos::Util::SpinLockRW::lock(void) noexcept
-{
-    size_t count(0);
-    while (not this->try_lock())
-    {
-        if (++count > 1024) std::this_thread::yield();
-    }
-}
-
-inline void Pothos::Util::SpinLockRW::unlock(void) noexcept
-{
-    //restore to unlocked (no writer, no readers)
-    _lock.store(UNLOCKED, std::memory_order_release);
-}
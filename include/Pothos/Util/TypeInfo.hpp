@@ -4,7 +4,7 @@
 /// Utility functions dealing with std::type_info
 ///
 /// \copyright
-/// Copyright (c) 2013-2014 Josh Blum
+/// Copyright (c) 2013-2020 Josh Blum
 /// SPDX-License-Identifier: BSL-1.0
 ///
 
@@ -19,6 +19,7 @@ namespace Util {
 /*!
  * Helper method to get the string representation of a type info.
  * The implementation may look up in a table or demangles type.name().
+ * The result is memoized per type, so repeated calls are a hash lookup.
  */
 POTHOS_API std::string typeInfoToString(const std::type_info &type);
 
@@ -1,10 +1,10 @@
-// Copyright (c) 2016-2017 Josh Blum
+// Copyright (c) 2016-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Archive/ArchiveEntry.hpp>
 #include <Pothos/Archive/Exception.hpp>
 #include <Pothos/Util/TypeInfo.hpp>
-#include <map>
+#include <unordered_map>
 
 /*!
  * Store both type info hashes and string ID hashes.
@@ -12,9 +12,9 @@
  * Therefore we don't protect the access with any locks.
  * Use a 64-bit number and not size_t which may be 32-bits.
  */
-static std::map<unsigned long long, Pothos::Archive::ArchiveEntry *> &getArchiveEntryMap(void)
+static std::unordered_map<unsigned long long, Pothos::Archive::ArchiveEntry *> &getArchiveEntryMap(void)
 {
-    static std::map<unsigned long long, Pothos::Archive::ArchiveEntry *> map;
+    static std::unordered_map<unsigned long long, Pothos::Archive::ArchiveEntry *> map;
     return map;
 }
 
@@ -1,32 +1,167 @@
-// Copyright (c) 2016-2018 Josh Blum
+// Copyright (c) 2016-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Archive/StreamArchiver.hpp>
 #include <Pothos/Archive/Numbers.hpp>
+#include <Pothos/Archive/Exception.hpp>
+#include <Pothos/Archive/ArchiveEntry.hpp>
 #include <iostream>
+#include <algorithm> //min
 
-#define POTHOS_ARCHIVE_VERSION 2
+#define POTHOS_ARCHIVE_VERSION 6
+
+//! The archive version which introduced the table of entries
+static const unsigned int entryTableVersion = 6;
+
+/***********************************************************************
+ * The padding length is a fixed size little endian word,
+ * so the padding can be computed before the length is written.
+ **********************************************************************/
+static const size_t paddingLengthBytes = 4;
 
 Pothos::Archive::OStreamArchiver::OStreamArchiver(std::ostream &os):
-    os(os), ver(POTHOS_ARCHIVE_VERSION)
+    os(&os), buffer(nullptr), ver(POTHOS_ARCHIVE_VERSION), offset(0), alignment(0)
+{
+    *this << ver;
+}
+
+Pothos::Archive::OStreamArchiver::OStreamArchiver(std::vector<char> &buffer):
+    os(nullptr), buffer(&buffer), ver(POTHOS_ARCHIVE_VERSION), offset(0), alignment(0)
 {
     *this << ver;
 }
 
-void Pothos::Archive::OStreamArchiver::writeBytes(const void *buff, const size_t len)
+void Pothos::Archive::OStreamArchiver::writeStream(const void *buff, const size_t len)
 {
     if (len == 0) return;
-    os.write(reinterpret_cast<const char *>(buff), len);
+    os->write(reinterpret_cast<const char *>(buff), len);
+    offset += len;
+}
+
+void Pothos::Archive::OStreamArchiver::setPayloadAlignment(const size_t alignment)
+{
+    this->alignment = alignment;
+}
+
+void Pothos::Archive::OStreamArchiver::writePadding(void)
+{
+    size_t numPad = 0;
+    if (alignment > 1)
+    {
+        const auto mod = (offset + paddingLengthBytes) % alignment;
+        if (mod != 0) numPad = alignment - size_t(mod);
+    }
+
+    unsigned char word[paddingLengthBytes];
+    for (size_t i = 0; i < paddingLengthBytes; i++) word[i] = static_cast<unsigned char>(numPad >> (8*i));
+    this->writeBytes(word, paddingLengthBytes);
+
+    const char zeros[256] = {};
+    while (numPad != 0)
+    {
+        const size_t len = std::min(numPad, sizeof(zeros));
+        this->writeBytes(zeros, len);
+        numPad -= len;
+    }
+}
+
+const Pothos::Archive::ArchiveEntry &Pothos::Archive::OStreamArchiver::writeEntry(const std::type_info &type)
+{
+    //index 0 introduces a new entry with its hash, otherwise index-1 is the table position
+    const auto it = entries.find(type.hash_code());
+    if (it != entries.end())
+    {
+        *this << it->second.second;
+        return *it->second.first;
+    }
+
+    const auto &entry = ArchiveEntry::find(type);
+    const unsigned long long index = entries.size()+1;
+    entries.emplace(type.hash_code(), std::make_pair(&entry, index));
+    *this << (unsigned long long)(0);
+    *this << entry.getHash();
+    return entry;
 }
 
 Pothos::Archive::IStreamArchiver::IStreamArchiver(std::istream &is):
-    is(is), ver(0)
+    is(&is), data(nullptr), length(0), ver(0), offset(0), mapped(nullptr)
+{
+    *this >> ver;
+}
+
+Pothos::Archive::IStreamArchiver::IStreamArchiver(std::istream &is, const void *mapped, const std::shared_ptr<void> &owner):
+    is(&is), data(nullptr), length(0), ver(0), offset(0), mapped(reinterpret_cast<const char *>(mapped)), owner(owner)
+{
+    *this >> ver;
+}
+
+Pothos::Archive::IStreamArchiver::IStreamArchiver(const void *data, const size_t length, const std::shared_ptr<void> &owner):
+    is(nullptr), data(reinterpret_cast<const char *>(data)), length(length), ver(0), offset(0),
+    mapped(owner?reinterpret_cast<const char *>(data):nullptr), owner(owner)
 {
     *this >> ver;
 }
 
-void Pothos::Archive::IStreamArchiver::readBytes(void *buff, const size_t len)
+void Pothos::Archive::IStreamArchiver::readStream(void *buff, const size_t len)
 {
+    if (data != nullptr) throw Pothos::ArchiveException(
+        "IStreamArchiver::readBytes()", "read exceeds the end of the archive");
     if (len == 0) return;
-    is.read(reinterpret_cast<char *>(buff), len);
+    is->read(reinterpret_cast<char *>(buff), len);
+    offset += len;
+}
+
+void Pothos::Archive::IStreamArchiver::readPadding(void)
+{
+    unsigned char word[paddingLengthBytes];
+    this->readBytes(word, paddingLengthBytes);
+    size_t numPad = 0;
+    for (size_t i = 0; i < paddingLengthBytes; i++) numPad |= size_t(word[i]) << (8*i);
+
+    char scratch[256];
+    while (numPad != 0)
+    {
+        const size_t len = std::min(numPad, sizeof(scratch));
+        this->readBytes(scratch, len);
+        numPad -= len;
+    }
+}
+
+const void *Pothos::Archive::IStreamArchiver::readView(const size_t len)
+{
+    if (mapped == nullptr) return nullptr;
+    if (data != nullptr and len > length - offset) throw Pothos::ArchiveException(
+        "IStreamArchiver::readView()", "view exceeds the end of the archive");
+    if (data == nullptr and not is->seekg(std::streamoff(len), std::ios_base::cur)) throw Pothos::ArchiveException(
+        "IStreamArchiver::readView()", "view exceeds the end of the archive");
+    const auto view = mapped + offset;
+    offset += len;
+    return view;
+}
+
+const Pothos::Archive::ArchiveEntry &Pothos::Archive::IStreamArchiver::readEntry(void)
+{
+    unsigned long long index(0);
+    *this >> index;
+
+    //older archives write the hash for every entry
+    if (ver < entryTableVersion) return ArchiveEntry::find(index);
+
+    if (index != 0)
+    {
+        if (index > entries.size()) throw Pothos::ArchiveException(
+            "IStreamArchiver::readEntry()", "entry index out of range: " + std::to_string(index));
+        return *entries[index-1];
+    }
+
+    unsigned long long hash(0);
+    *this >> hash;
+    const auto &entry = ArchiveEntry::find(hash);
+    entries.push_back(&entry);
+    return entry;
+}
+
+const std::shared_ptr<void> &Pothos::Archive::IStreamArchiver::getMappedOwner(void) const
+{
+    return owner;
 }
@@ -1,4 +1,4 @@
-// Copyright (c) 2016-2016 Josh Blum
+// Copyright (c) 2016-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Object.hpp>
@@ -8,6 +8,8 @@
 #include <iostream>
 #include <cmath> //pow
 #include <cstdlib> //rand
+#include <complex>
+#include <vector>
 
 static const int numIters(100);
 
@@ -186,3 +188,81 @@ POTHOS_TEST_BLOCK("/archive/tests", test_vector)
 
     POTHOS_TEST_EQUALV(x, y);
 }
+
+template <typename T>
+static void testNumericVector(const std::vector<T> &x)
+{
+    std::stringstream so;
+    Pothos::Archive::OStreamArchiver ao(so);
+    ao << x;
+
+    std::stringstream si(so.str());
+    Pothos::Archive::IStreamArchiver ai(si);
+    std::vector<T> y; ai >> y;
+
+    POTHOS_TEST_EQUALV(x, y);
+}
+
+POTHOS_TEST_BLOCK("/archive/tests", test_numeric_vector)
+{
+    std::vector<float> floats;
+    std::vector<std::complex<double>> complexes;
+    std::vector<signed short> shorts;
+    std::vector<signed long long> longs;
+    for (int i = 0; i < numIters; i++)
+    {
+        floats.push_back(float(std::rand())/RAND_MAX - 0.5f);
+        complexes.emplace_back(std::rand()*1e-3, -std::rand()*1e3);
+        shorts.push_back(static_cast<signed short>(std::rand()));
+        longs.push_back((static_cast<signed long long>(std::rand()) << 32) | std::rand());
+    }
+    testNumericVector(floats);
+    testNumericVector(complexes);
+    testNumericVector(shorts);
+    testNumericVector(longs);
+    testNumericVector(std::vector<char>());
+
+    //a block is the vector size plus the raw element bytes
+    std::stringstream so;
+    Pothos::Archive::OStreamArchiver ao(so);
+    ao << std::vector<double>(1000);
+    POTHOS_TEST_TRUE(so.str().size() < 1000*sizeof(double)+8);
+
+    //archives before the block format load element by element:
+    //version 2, size 2, and the signed LEB128 elements 1 and -1
+    std::stringstream si(std::string("\x02\x02\x01\x7f"));
+    Pothos::Archive::IStreamArchiver ai(si);
+    std::vector<int> y; ai >> y;
+    POTHOS_TEST_EQUAL(y.size(), size_t(2));
+    POTHOS_TEST_EQUAL(y[0], 1);
+    POTHOS_TEST_EQUAL(y[1], -1);
+}
+
+POTHOS_TEST_BLOCK("/archive/tests", test_memory_archiver)
+{
+    std::vector<char> buffer;
+    Pothos::Archive::OStreamArchiver ao(buffer);
+    const int x0(-12345); ao << x0;
+    const std::string x1("hello world"); ao << x1;
+    const std::vector<double> x2(100, 1.5); ao << x2;
+
+    //the memory archive matches the stream archive
+    std::stringstream so;
+    Pothos::Archive::OStreamArchiver aso(so);
+    aso << x0; aso << x1; aso << x2;
+    POTHOS_TEST_TRUE(so.str() == std::string(buffer.data(), buffer.size()));
+
+    Pothos::Archive::IStreamArchiver ai(buffer.data(), buffer.size());
+    int y0; ai >> y0;
+    std::string y1; ai >> y1;
+    std::vector<double> y2; ai >> y2;
+    POTHOS_TEST_EQUAL(x0, y0);
+    POTHOS_TEST_EQUAL(x1, y1);
+    POTHOS_TEST_EQUALV(x2, y2);
+    POTHOS_TEST_EQUAL(ai.bytesRead(), buffer.size());
+
+    //reads past the end of the memory throw
+    Pothos::Archive::IStreamArchiver at(buffer.data(), buffer.size()-1);
+    at >> y0; at >> y1;
+    POTHOS_TEST_THROWS(at >> y2, Pothos::ArchiveException);
+}
@@ -7,6 +7,7 @@
 #include <Pothos/Archive.hpp>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 namespace PothosTesting {
 
@@ -41,6 +42,7 @@ namespace serialization {
 } // namespace Pothos
 
 POTHOS_CLASS_EXPORT(PothosTesting::CustomPolyType<int>)
+POTHOS_CLASS_EXPORT(PothosTesting::CustomPolyType<double>)
 
 POTHOS_TEST_BLOCK("/archive/tests", test_polymorphic_type)
 {
@@ -64,3 +66,42 @@ POTHOS_TEST_BLOCK("/archive/tests", test_polymorphic_type)
     delete x;
     delete y;
 }
+
+POTHOS_TEST_BLOCK("/archive/tests", test_polymorphic_entry_table)
+{
+    //interleave two types, each entry hash is written once
+    std::vector<PothosTesting::CustomPolyBase *> xs;
+    for (int i = 0; i < 100; i++)
+    {
+        if (i % 2 == 0) xs.push_back(new PothosTesting::CustomPolyType<int>(i));
+        else xs.push_back(new PothosTesting::CustomPolyType<double>(i*0.5));
+    }
+
+    std::stringstream so;
+    Pothos::Archive::OStreamArchiver ao(so);
+    for (auto x : xs) ao << x;
+    //1 byte index + up to 10 byte value, and 2 hashes of up to 11 bytes
+    POTHOS_TEST_TRUE(so.str().size() < 100*11 + 2*11 + 1);
+
+    std::stringstream si(so.str());
+    Pothos::Archive::IStreamArchiver ai(si);
+    for (int i = 0; i < 100; i++)
+    {
+        PothosTesting::CustomPolyBase *y(nullptr);
+        ai >> y;
+        if (i % 2 == 0)
+        {
+            auto yInt = dynamic_cast<PothosTesting::CustomPolyType<int> *>(y);
+            POTHOS_TEST_NOT_EQUAL(yInt, nullptr);
+            POTHOS_TEST_EQUAL(yInt->value, i);
+        }
+        else
+        {
+            auto yDbl = dynamic_cast<PothosTesting::CustomPolyType<double> *>(y);
+            POTHOS_TEST_NOT_EQUAL(yDbl, nullptr);
+            POTHOS_TEST_EQUAL(yDbl->value, i*0.5);
+        }
+        delete y;
+    }
+    for (auto x : xs) delete x;
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Benchmark.hpp>
+#include <algorithm> //min/max
+#include <mutex>
+
+static std::mutex &getBenchMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+/***********************************************************************
+ * Benchmark state
+ **********************************************************************/
+Pothos::BenchmarkState::BenchmarkState(const size_t iterations):
+    _iterations(iterations),
+    _bytesPerIteration(0),
+    _paused(false),
+    _startTime(std::chrono::high_resolution_clock::now()),
+    _elapsed(std::chrono::high_resolution_clock::duration::zero())
+{
+    return;
+}
+
+void Pothos::BenchmarkState::setBytesPerIteration(const size_t numBytes)
+{
+    _bytesPerIteration = numBytes;
+}
+
+void Pothos::BenchmarkState::pauseTiming(void)
+{
+    if (_paused) return;
+    _elapsed += std::chrono::high_resolution_clock::now() - _startTime;
+    _paused = true;
+}
+
+void Pothos::BenchmarkState::resumeTiming(void)
+{
+    if (not _paused) return;
+    _startTime = std::chrono::high_resolution_clock::now();
+    _paused = false;
+}
+
+double Pothos::BenchmarkState::elapsed(void) const
+{
+    auto total = _elapsed;
+    if (not _paused) total += std::chrono::high_resolution_clock::now() - _startTime;
+    return std::chrono::duration<double>(total).count();
+}
+
+void Pothos::BenchmarkState::doNotOptimizeSink(const void *)
+{
+    return;
+}
+
+/***********************************************************************
+ * Benchmark runner
+ **********************************************************************/
+Pothos::BenchmarkResult::BenchmarkResult(void):
+    iterations(0),
+    seconds(0.0),
+    nsPerOp(0.0),
+    bytesPerSecond(0.0)
+{
+    return;
+}
+
+Pothos::BenchmarkBase::BenchmarkBase(void)
+{
+    return;
+}
+
+Pothos::BenchmarkBase::~BenchmarkBase(void)
+{
+    return;
+}
+
+Pothos::BenchmarkResult Pothos::BenchmarkBase::run(const double minTime)
+{
+    //benchmarks share the machine poorly, so only run one at a time
+    std::lock_guard<std::mutex> lock(getBenchMutex());
+
+    static const size_t maxIterations = 1000000000;
+    size_t iterations = 1;
+    while (true)
+    {
+        BenchmarkState state(iterations);
+        this->runBenchmarkImpl(state);
+        const double elapsed = state.elapsed();
+
+        if (elapsed >= minTime or iterations >= maxIterations)
+        {
+            BenchmarkResult result;
+            result.iterations = iterations;
+            result.seconds = elapsed;
+            result.nsPerOp = (elapsed*1e9)/iterations;
+            if (elapsed > 0.0) result.bytesPerSecond = (double(state.bytesPerIteration())*iterations)/elapsed;
+            return result;
+        }
+
+        //predict the iterations to fill the minimum time with some margin,
+        //but grow by at most 10x per step when the short run was too noisy
+        const double multiplier = (elapsed <= 0.0)? 10.0 :
+            std::min(10.0, std::max(1.5, (minTime*1.4)/elapsed));
+        iterations = std::min(maxIterations, size_t(iterations*multiplier)+1);
+    }
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Callable.hpp>
+#include <Pothos/Benchmark.hpp>
+#include <functional> //ref
+
+struct BenchClass
+{
+    BenchClass(void):
+        _bar(0)
+    {
+        return;
+    }
+
+    void setBar(const int bar)
+    {
+        _bar = bar;
+    }
+
+    int getBar(void)
+    {
+        return _bar;
+    }
+
+    static int add(const int a, const int b)
+    {
+        return a + b;
+    }
+
+    int _bar;
+};
+
+POTHOS_BENCH_BLOCK("/callable/bench", bench_callable_function)
+{
+    Pothos::Callable add(&BenchClass::add);
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        const int result = add.call(int(i), 1).extract<int>();
+        Pothos::BenchmarkState::doNotOptimize(result);
+    }
+}
+
+POTHOS_BENCH_BLOCK("/callable/bench", bench_callable_method)
+{
+    BenchClass bench;
+    Pothos::Callable setBar(&BenchClass::setBar);
+    Pothos::Callable getBar(&BenchClass::getBar);
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        setBar.call(std::ref(bench), int(i));
+        const int result = getBar.call<int>(std::ref(bench));
+        Pothos::BenchmarkState::doNotOptimize(result);
+    }
+}
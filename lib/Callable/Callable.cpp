@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2018 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Callable/CallableImpl.hpp>
@@ -6,6 +6,7 @@
 #include <Pothos/Object/Exception.hpp>
 #include <Pothos/Util/TypeInfo.hpp>
 #include <Poco/Format.h>
+#include <vector>
 #include <cassert>
 #include <algorithm> //min/max
 
@@ -21,15 +22,36 @@ Pothos::Object Pothos::Callable::opaqueCall(const Object *inputArgs, const size_
         throw Pothos::CallableNullError("Pothos::Callable::call()", "null Callable");
     }
 
-    //Create callArgs which is a combination of inputArgs and boundArgs
-    std::vector<Object> callArgs(_impl->getNumArgs());
+    const size_t numCallArgs = _impl->getNumArgs();
+
+    //fast path: no bindings and the input arguments are the exact types
+    if (_boundArgs.empty() and numArgs >= numCallArgs)
+    {
+        size_t i = 0;
+        while (i < numCallArgs and inputArgs[i].type() == _impl->type(int(i))) i++;
+        if (i == numCallArgs) return _impl->call(inputArgs);
+    }
+
+    //Create callArgs which is a combination of inputArgs and boundArgs,
+    //small argument counts use an inline array rather than a heap allocation
+    static const size_t NUM_INLINE_ARGS = 8;
+    Object inlineArgs[NUM_INLINE_ARGS];
+    std::vector<Object> heapArgs;
+    Object *callArgs = inlineArgs;
+    if (numCallArgs > NUM_INLINE_ARGS)
+    {
+        heapArgs.resize(numCallArgs);
+        callArgs = heapArgs.data();
+    }
+
     size_t inputArgsIndex = 0;
-    for (size_t i = 0; i < callArgs.size(); i++)
+    for (size_t i = 0; i < numCallArgs; i++)
     {
         //is there a binding? if so use it
+        const Object *arg = nullptr;
         if (_boundArgs.size() > i and _boundArgs[i])
         {
-            callArgs[i] = _boundArgs[i];
+            arg = &_boundArgs[i];
         }
 
         //otherwise, use the next available input argument
@@ -40,13 +62,21 @@ Pothos::Object Pothos::Callable::opaqueCall(const Object *inputArgs, const size_
                 throw Pothos::CallableArgumentError("Pothos::Callable::call()", Poco::format(
                     "expected input argument at %z", inputArgsIndex));
             }
-            callArgs[i] = inputArgs[inputArgsIndex++];
+            arg = &inputArgs[inputArgsIndex++];
+        }
+
+        //an Object of the exact type is used as is
+        const std::type_info &type = _impl->type(int(i));
+        if (arg->type() == type)
+        {
+            callArgs[i] = *arg;
+            continue;
         }
 
         //perform conversion on arg to get an Object of the exact type
         try
         {
-            callArgs[i] = callArgs[i].convert(_impl->type(int(i)));
+            callArgs[i] = arg->convert(type);
         }
         catch(const Pothos::ObjectConvertError &ex)
         {
@@ -55,7 +85,7 @@ Pothos::Object Pothos::Callable::opaqueCall(const Object *inputArgs, const size_
         }
     }
 
-    return _impl->call(callArgs.data());
+    return _impl->call(callArgs);
 }
 
 size_t Pothos::Callable::getNumArgs(void) const
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2019 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Callable.hpp>
@@ -292,6 +292,29 @@ POTHOS_TEST_BLOCK("/callable/tests", test_callable_bind)
     POTHOS_TEST_THROWS(addMany.type(3), Pothos::CallableArgumentError);
 }
 
+/***********************************************************************
+ * Test argument counts beyond the inline argument storage
+ **********************************************************************/
+static long sumTen(int a0, int a1, int a2, int a3, int a4, int a5, int a6, int a7, int a8, long a9)
+{
+    return a0+a1+a2+a3+a4+a5+a6+a7+a8+a9;
+}
+
+POTHOS_TEST_BLOCK("/callable/tests", test_callable_many_args)
+{
+    Pothos::Callable sum(&sumTen);
+    POTHOS_TEST_EQUAL(sum.getNumArgs(), 10);
+
+    //exact types, converted types, and bound arguments
+    POTHOS_TEST_EQUAL(55, sum.call<long>(1, 2, 3, 4, 5, 6, 7, 8, 9, long(10)));
+    POTHOS_TEST_EQUAL(55, sum.call<long>(1, 2, 3, 4, 5, 6, 7, 8, 9, 10));
+    sum.bind(int(100), 3);
+    POTHOS_TEST_EQUAL(151, sum.call<long>(1, 2, 3, 5, 6, 7, 8, 9, long(10)));
+
+    //too few arguments is still an error
+    POTHOS_TEST_THROWS(sum.call<long>(1, 2, 3), Pothos::CallableArgumentError);
+}
+
 /***********************************************************************
  * Test throwing
  **********************************************************************/
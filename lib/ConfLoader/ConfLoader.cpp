@@ -1,8 +1,9 @@
-// Copyright (c) 2016-2017 Josh Blum
+// Copyright (c) 2016-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/System.hpp>
 #include <Pothos/Plugin.hpp>
+#include "System/StartupProfile.hpp"
 #include <Poco/StringTokenizer.h>
 #include <Poco/SharedLibrary.h>
 #include <Poco/Environment.h>
@@ -28,6 +29,7 @@ std::string Pothos_FileRealPath(const std::string &path);
 static std::vector<Pothos::PluginPath> loadConfFile(const std::string &path)
 {
     poco_debug_f1(confLoaderLogger(), "loading %s", path);
+    StartupProfileTimer timer("conf", path);
 
     //parse the configuration file with the INI parser
     Poco::AutoPtr<Poco::Util::PropertyFileConfiguration> conf;
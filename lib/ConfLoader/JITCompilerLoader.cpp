@@ -1,4 +1,4 @@
-// Copyright (c) 2016-2016 Josh Blum
+// Copyright (c) 2016-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Plugin.hpp>
@@ -11,6 +11,15 @@
 #include <Poco/File.h>
 #include <Poco/StringTokenizer.h>
 #include <Poco/SharedLibrary.h>
+#include <Poco/Environment.h>
+#include <Poco/NumberFormatter.h>
+#include <condition_variable>
+#include <functional> //hash
+#include <algorithm> //max
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <cctype>
@@ -40,6 +49,8 @@ struct RegistryJITResult
 
     std::string target; //!< unique target name
 
+    std::future<void> precompile; //!< optional background compilation
+
     void removeRegistrations(void)
     {
         for (const auto &factoryPath : this->factories)
@@ -51,6 +62,7 @@ struct RegistryJITResult
 
     ~RegistryJITResult(void)
     {
+        if (precompile.valid()) precompile.wait();
         this->removeRegistrations();
     }
 };
@@ -58,24 +70,38 @@ struct RegistryJITResult
 /***********************************************************************
  * Helper to manage recompile
  **********************************************************************/
+//! Hash everything that affects the compiled output
+static std::string getCompilerInputsHash(const Pothos::Util::CompilerArgs &args)
+{
+    std::string inputs(POTHOS_ABI_VERSION);
+    inputs += "\n" + Pothos::System::getLibVersion();
+    for (const auto &source : args.sources)
+    {
+        std::ifstream file(source, std::ios::binary);
+        if (not file) throw Pothos::FileException("JITCompiler", "cannot open " + source);
+        inputs += "\nsource:" + source + "\n";
+        inputs.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    for (const auto &include : args.includes) inputs += "\ninclude:" + include;
+    for (const auto &library : args.libraries) inputs += "\nlibrary:" + library;
+    for (const auto &flag : args.flags) inputs += "\nflag:" + flag;
+    for (const auto &header : args.precompiledHeaders) inputs += "\nheader:" + header;
+    return Poco::NumberFormatter::formatHex(std::hash<std::string>()(inputs), 16);
+}
+
 static void compilationHelper(
     RegistryJITResult *handle,
     const Poco::File &outFile)
 {
-    //check if we need to recompile
-    bool recompile = false;
+    //check if we need to recompile: the hash of the inputs is stored beside the output
+    const auto hashPath = outFile.path() + ".hash";
+    const auto inputsHash = getCompilerInputsHash(handle->compilerArgs);
     if (outFile.exists() and outFile.getSize() != 0)
     {
-        const auto lastTimeCompiled = outFile.getLastModified();
-        const auto devLib = Pothos::System::getPothosDevLibraryPath();
-        if (Poco::File(devLib).getLastModified() > lastTimeCompiled) recompile = true;
-        for (const auto &source : handle->compilerArgs.sources)
-        {
-            if (Poco::File(source).getLastModified() > lastTimeCompiled) recompile = true;
-        }
+        std::string lastHash;
+        std::ifstream hashFile(hashPath);
+        if (hashFile and std::getline(hashFile, lastHash) and lastHash == inputsHash) return;
     }
-    else recompile = true;
-    if (not recompile) return;
 
     //compiler instance
     const auto compiler = Pothos::Util::Compiler::make();
@@ -84,22 +110,54 @@ static void compilationHelper(
     sourceLoaderLogger().information("Compile sources for %s...", handle->target);
     const auto tmpOutput = compiler->compileCppModule(handle->compilerArgs);
     Poco::File(tmpOutput).moveTo(outFile.path());
+    std::ofstream(hashPath) << inputsHash << std::endl;
     sourceLoaderLogger().information("Wrote %s", outFile.path());
 }
 
-/***********************************************************************
- * The JIT compiler factory compiles sources on demand
- * and replaces its plugin registration with the compiled on
- **********************************************************************/
-static Pothos::Object opaqueJITCompilerFactory(
-    RegistryJITResult *handle,
-    const Pothos::PluginPath &pluginPath,
-    const Pothos::Object *args,
-    const size_t numArgs)
+//! Limit the number of concurrent background compilations
+struct CompileSlot
 {
-    //local mutex lock for the registry
-    std::lock_guard<std::mutex> lock(handle->mutex);
+    CompileSlot(void)
+    {
+        std::unique_lock<std::mutex> lock(mutex());
+        cond().wait(lock, []{return count() < std::max<size_t>(std::thread::hardware_concurrency(), 1);});
+        count()++;
+    }
+
+    ~CompileSlot(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex());
+            count()--;
+        }
+        cond().notify_one();
+    }
+
+    static std::mutex &mutex(void)
+    {
+        static std::mutex m;
+        return m;
+    }
 
+    static std::condition_variable &cond(void)
+    {
+        static std::condition_variable c;
+        return c;
+    }
+
+    static size_t &count(void)
+    {
+        static size_t c(0);
+        return c;
+    }
+};
+
+/*!
+ * Compile the target if its inputs changed, and return the output path.
+ * The caller holds the handle mutex, a failure is saved in the handle.
+ */
+static std::string compileTarget(RegistryJITResult *handle)
+{
     //re-throw if a previous call failed
     if (handle->exception) std::rethrow_exception(handle->exception);
 
@@ -124,6 +182,24 @@ static Pothos::Object opaqueJITCompilerFactory(
         sourceLoaderLogger().error(ex.message());
         throw;
     }
+    return outPath.toString();
+}
+
+/***********************************************************************
+ * The JIT compiler factory compiles sources on demand
+ * and replaces its plugin registration with the compiled on
+ **********************************************************************/
+static Pothos::Object opaqueJITCompilerFactory(
+    RegistryJITResult *handle,
+    const Pothos::PluginPath &pluginPath,
+    const Pothos::Object *args,
+    const size_t numArgs)
+{
+    //local mutex lock for the registry
+    std::lock_guard<std::mutex> lock(handle->mutex);
+
+    //compile if changed, waits on a background compilation in progress
+    const auto outPath = compileTarget(handle);
 
     //load the module, only once for all registered entries
     if (not handle->pluginModule)
@@ -133,7 +209,7 @@ static Pothos::Object opaqueJITCompilerFactory(
 
         //load the newly compiled library with plugin module
         //the plugin module now owns the factory path entries
-        handle->pluginModule = Pothos::PluginModule(outPath.toString());
+        handle->pluginModule = Pothos::PluginModule(outPath);
     }
 
     //the actual function from the compiled module
@@ -246,6 +322,20 @@ static std::vector<Pothos::PluginPath> JITCompilerLoader(const std::map<std::str
         Pothos::PluginRegistry::addCall(pluginPath, factory);
     }
 
+    //optionally compile in the background, in parallel across targets
+    const auto precompile = Poco::Environment::get("POTHOS_JIT_PRECOMPILE", "");
+    if (precompile == "1" or precompile == "true")
+    {
+        auto rawHandle = handle.get();
+        handle->precompile = std::async(std::launch::async, [rawHandle](void)
+        {
+            CompileSlot slot;
+            std::lock_guard<std::mutex> lock(rawHandle->mutex);
+            try {compileTarget(rawHandle);}
+            catch (const Pothos::Exception &){} //saved in the handle
+        });
+    }
+
     //store the handle in the registry
     const auto pluginPath = Pothos::PluginPath("/framework/conf_loader/jit_compiler/handles").join(handle->target);
     Pothos::PluginRegistry::add(pluginPath, handle);
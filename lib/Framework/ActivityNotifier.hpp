@@ -0,0 +1,34 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <atomic>
+
+/*!
+ * An aggregate activity counter shared by all blocks in a topology.
+ * Each actor bumps the counter at most once per work task with activity,
+ * so waitInactive() can watch one counter rather than polling every block.
+ */
+struct ActivityNotifier
+{
+    ActivityNotifier(void):
+        counter(0)
+    {
+        return;
+    }
+
+    //! Signal that a block produced, consumed, or changed state
+    void notify(void)
+    {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! The current count, only changes in the value are meaningful
+    unsigned long long count(void) const
+    {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<unsigned long long> counter;
+};
@@ -1,13 +1,16 @@
-// Copyright (c) 2015-2017 Josh Blum
+// Copyright (c) 2015-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #pragma once
 #include <Pothos/Config.hpp>
 #include <Pothos/Util/SpinLock.hpp>
+#include "Framework/ThreadEnvironment.hpp"
+#include "Framework/SchedulerTrace.hpp"
 #include <atomic>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
+#include <chrono>
 
 /*!
  * The implementation of the exclusive access to the actor.
@@ -18,8 +21,12 @@ public:
 
     ActorInterface(void):
         _waitModeEnabled(true),
+        _waitTimeout(std::chrono::milliseconds(100)),
         _externalAcquired(0),
-        _aquireWaiting(false)
+        _aquireWaiting(false),
+        _wakePending(false),
+        _readyTask(nullptr),
+        _traceEnabled(false)
     {
         _changeFlagged.test_and_set();
     }
@@ -74,9 +81,49 @@ public:
         _waitModeEnabled = enb;
     }
 
+    /*!
+     * Set the maximum time that the worker thread waits for a change.
+     * Waits end as soon as a change is flagged, so the timeout is only
+     * a safety net, unless the thread must periodically check other tasks.
+     */
+    void setWaitTimeout(const std::chrono::microseconds &timeout)
+    {
+        _waitTimeout = timeout;
+    }
+
+    //! Enable or disable recording into the scheduler trace
+    void enableTrace(const bool enb)
+    {
+        _traceEnabled.store(enb, std::memory_order_relaxed);
+    }
+
+    //! Is recording into the scheduler trace enabled?
+    bool isTraceEnabled(void) const
+    {
+        return _traceEnabled.load(std::memory_order_relaxed);
+    }
+
+    //! Record a scheduler trace event for this actor when enabled
+    void traceEvent(const SchedulerTraceEvent event, const SchedulerStallReason reason = STALL_NONE)
+    {
+        if (this->isTraceEnabled()) schedulerTraceRecord(this, event, reason);
+    }
+
+    /*!
+     * Set the task used to notify a queue-driven scheduler.
+     * When set, flagged changes enqueue the task for execution.
+     * \param task the registered task data or null to disable
+     */
+    void setReadyTask(TaskData *task)
+    {
+        _readyTask.store(task, std::memory_order_release);
+    }
+
 private:
     bool _workerThreadAcquireWait(const bool waitEnabled);
     bool _inExternalCall(void);
+    void _notifyReady(void);
+    void _notifyWaiters(void);
 
     /*!
      * Allow waiting policy set in thread configuration.
@@ -84,6 +131,9 @@ private:
      */
     bool _waitModeEnabled;
 
+    //! The maximum time that the worker thread waits for a change
+    std::chrono::microseconds _waitTimeout;
+
     /*!
      * Asynchronous notification that a state change occurred.
      * The worker thread will use this to decide to perform
@@ -115,6 +165,19 @@ private:
     std::mutex _acquireMutex;
     std::condition_variable _acquireCond;
     std::atomic_bool _aquireWaiting;
+
+    /*!
+     * Set by wakeNoChange() and consumed by the next wait,
+     * so that a wakeup which arrives before the worker thread
+     * begins to wait is not lost until the timeout expires.
+     */
+    std::atomic_bool _wakePending;
+
+    //! Ready notification for queue-driven schedulers (or null)
+    std::atomic<TaskData *> _readyTask;
+
+    //! Record task, wake, and call events into the scheduler trace
+    std::atomic<bool> _traceEnabled;
 };
 
 /*!
@@ -144,25 +207,28 @@ inline bool ActorInterface::_inExternalCall(void)
 
 inline void ActorInterface::externalCallAcquire(void)
 {
-    //wait in a loop to acquire the call lock
-    //rather than assume notify will be reliable,
-    //we wait with a timeout and recheck the condition
+    //wait in a loop to acquire the call lock:
+    //the releasing thread notifies under the mutex so the wakeup is exact,
+    //the long timeout is only a safety net to recheck the condition
     std::unique_lock<std::mutex> lock(_acquireMutex);
     _externalAcquired++;
     while (not _extCallLock.try_lock())
     {
-        _acquireCond.wait_for(lock, std::chrono::milliseconds(1));
+        _acquireCond.wait_for(lock, std::chrono::milliseconds(100));
     }
+    this->traceEvent(TRACE_CALL_BEGIN);
 }
 
 inline void ActorInterface::externalCallRelease(void)
 {
     //release the lock and notify any potential waiters
     //flag a change so the worker can re-evaluate state after the call
+    this->traceEvent(TRACE_CALL_END);
     _externalAcquired--;
     _extCallLock.unlock();
     this->flagInternalChange();
-    _acquireCond.notify_all();
+    this->_notifyReady();
+    this->_notifyWaiters();
 }
 
 inline bool ActorInterface::workerThreadAcquire(const bool waitEnabled)
@@ -193,12 +259,21 @@ inline bool ActorInterface::_workerThreadAcquireWait(const bool waitEnabled)
     };
 
     //Lock and wait on external calls to complete or activity to be flagged.
+    //The waiting flag is published before the predicate is checked,
+    //and the notifier checks the flag after marking the change,
+    //so either the predicate sees the change or the notifier sees the waiter.
     if (waitEnabled)
     {
         if (isReady()) return true; //first check without locking
-        _aquireWaiting.store(true, std::memory_order_relaxed);
         std::unique_lock<std::mutex> lock(_acquireMutex);
-        bool rdy = _acquireCond.wait_for(lock, std::chrono::milliseconds(1), isReady);
+        _aquireWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool rdy = false;
+        _acquireCond.wait_for(lock, _waitTimeout, [&]
+        {
+            rdy = isReady();
+            return rdy or _wakePending.exchange(false);
+        });
         _aquireWaiting.store(false, std::memory_order_relaxed);
         return rdy;
     }
@@ -211,26 +286,49 @@ inline void ActorInterface::workerThreadRelease(void)
 {
     //release call lock and notify any enqueued callers
     _extCallLock.unlock();
-    if (_inExternalCall()) _acquireCond.notify_all();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_inExternalCall()) this->_notifyWaiters();
 }
 
 inline void ActorInterface::flagExternalChange(void)
 {
     //asynchronous indication
+    this->traceEvent(TRACE_WAKE);
     _changeFlagged.clear(std::memory_order_release);
 
+    //enqueue the actor when the scheduler is queue-driven
+    this->_notifyReady();
+
     //wake a blocked thread to process the change
-    if (_aquireWaiting.load(std::memory_order_acquire))
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_aquireWaiting.load(std::memory_order_relaxed))
     {
-        _acquireCond.notify_one();
+        this->_notifyWaiters();
     }
 }
 
+inline void ActorInterface::_notifyReady(void)
+{
+    auto task = _readyTask.load(std::memory_order_acquire);
+    if (task != nullptr) task->notifyReady();
+}
+
+inline void ActorInterface::_notifyWaiters(void)
+{
+    //Acquiring the mutex orders the notification after the predicate check
+    //of a waiting thread, which is either blocked or will see the change.
+    {
+        std::lock_guard<std::mutex> lock(_acquireMutex);
+    }
+    _acquireCond.notify_all();
+}
+
 inline void ActorInterface::wakeNoChange(void)
 {
     //called by the thread environment at cleanup time
     //to cause workerThreadAcquire() to wakeup and exit
-    _acquireCond.notify_all();
+    _wakePending.store(true);
+    this->_notifyWaiters();
 }
 
 inline void ActorInterface::flagInternalChange(void)
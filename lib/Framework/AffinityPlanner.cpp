@@ -0,0 +1,95 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Framework/AffinityPlanner.hpp"
+#include <Poco/Logger.h>
+#include <tuple>
+
+AffinityPlanner &AffinityPlanner::global(void)
+{
+    static AffinityPlanner planner;
+    return planner;
+}
+
+AffinityPlanner::AffinityPlanner(void):
+    _cpus(queryCPUTopology())
+{
+    if (_cpus.empty()) poco_warning(Poco::Logger::get("Pothos.ThreadPool"),
+        "AUTO affinity: the CPU topology is not available on this system");
+    for (const auto &info : _cpus)
+    {
+        _cpuLoad[info.cpu] = 0;
+        _coreLoad[info.core] = 0;
+    }
+}
+
+long AffinityPlanner::chooseNode(void)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::map<size_t, std::pair<size_t, size_t>> nodeLoad; //node -> (load, CPUs)
+    for (const auto &info : _cpus)
+    {
+        auto &load = nodeLoad[info.node];
+        load.first += _cpuLoad.at(info.cpu);
+        load.second++;
+    }
+
+    //compare load/CPUs without division: a/b < c/d <=> a*d < c*b
+    long best = -1;
+    std::pair<size_t, size_t> bestLoad;
+    for (const auto &pair : nodeLoad)
+    {
+        const auto &load = pair.second;
+        if (best != -1 and load.first*bestLoad.second >= bestLoad.first*load.second) continue;
+        best = long(pair.first);
+        bestLoad = load;
+    }
+    return best;
+}
+
+long AffinityPlanner::reserve(const long node)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    //the CPU with the lowest key in order of the planning preferences
+    const CPUTopologyInfo *best(nullptr);
+    std::tuple<size_t, bool, bool, size_t, size_t> bestKey;
+    for (const auto &info : _cpus)
+    {
+        const auto key = std::make_tuple(_cpuLoad.at(info.cpu), not info.isolated,
+            node != -1 and size_t(node) != info.node, _coreLoad.at(info.core), info.cpu);
+        if (best != nullptr and not (key < bestKey)) continue;
+        best = &info;
+        bestKey = key;
+    }
+    if (best == nullptr) return -1;
+
+    _cpuLoad.at(best->cpu)++;
+    _coreLoad.at(best->core)++;
+    poco_debug_f2(Poco::Logger::get("Pothos.ThreadPool"), "AUTO affinity: reserved CPU %z on node %z", best->cpu, best->node);
+    return long(best->cpu);
+}
+
+void AffinityPlanner::release(const long cpu)
+{
+    if (cpu < 0) return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto &info : _cpus)
+    {
+        if (info.cpu != size_t(cpu)) continue;
+        _cpuLoad.at(info.cpu)--;
+        _coreLoad.at(info.core)--;
+        return;
+    }
+}
+
+AffinityReservation::AffinityReservation(const long node):
+    cpu(AffinityPlanner::global().reserve(node))
+{
+    return;
+}
+
+AffinityReservation::~AffinityReservation(void)
+{
+    AffinityPlanner::global().release(cpu);
+}
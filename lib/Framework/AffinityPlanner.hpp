@@ -0,0 +1,93 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+/*!
+ * The placement of a CPU that this process may use.
+ */
+struct CPUTopologyInfo
+{
+    size_t cpu; //!< the CPU number used for the affinity
+    size_t node; //!< the NUMA node of the CPU
+    size_t core; //!< a unique id of the physical core (shared by hyperthread siblings)
+    bool isolated; //!< the CPU is isolated from the general scheduler (isolcpus)
+};
+
+/*!
+ * Query the CPUs that this process may use.
+ * The CPUs are limited by the affinity mask of the process,
+ * which follows the cgroup cpuset and the taskset of the process.
+ * Implemented in the platform specific thread config sources.
+ * \return the CPUs or an empty list when not supported
+ */
+std::vector<CPUTopologyInfo> queryCPUTopology(void);
+
+/*!
+ * The process-wide planner for the "AUTO" affinity mode.
+ * Every thread in an AUTO thread pool reserves a single CPU.
+ * The planner spreads the reservations over the CPUs so that
+ * many thread pools do not overlap until all CPUs are in use:
+ *
+ *  - A CPU with fewer reservations is always preferred.
+ *  - Isolated CPUs are preferred since no other work is scheduled there.
+ *  - CPUs on the preferred NUMA node of the pool are preferred,
+ *    so the threads of a pool and its buffers stay on one node.
+ *  - A CPU whose hyperthread siblings are free is preferred,
+ *    so that busy threads do not compete for the same core.
+ */
+class AffinityPlanner
+{
+public:
+    //! Get the planner for this process
+    static AffinityPlanner &global(void);
+
+    /*!
+     * Choose a NUMA node for a new thread pool:
+     * The node with the fewest reservations per CPU.
+     * \return the node or -1 when the CPUs are unknown
+     */
+    long chooseNode(void);
+
+    /*!
+     * Reserve a CPU for a thread.
+     * \param node the preferred NUMA node or -1
+     * \return the CPU or -1 when the CPUs are unknown
+     */
+    long reserve(const long node);
+
+    //! Release a CPU from reserve()
+    void release(const long cpu);
+
+private:
+    AffinityPlanner(void);
+    std::mutex _mutex;
+    std::vector<CPUTopologyInfo> _cpus;
+    std::map<size_t, size_t> _cpuLoad;
+    std::map<size_t, size_t> _coreLoad;
+};
+
+/*!
+ * A CPU reservation that is held for the lifetime of a thread.
+ */
+class AffinityReservation
+{
+public:
+    //! Reserve a CPU on the preferred node, see AffinityPlanner::reserve()
+    AffinityReservation(const long node);
+
+    //! Release the CPU
+    ~AffinityReservation(void);
+
+    //! The reserved CPU or -1
+    const long cpu;
+
+private:
+    AffinityReservation(const AffinityReservation &) = delete;
+    AffinityReservation &operator=(const AffinityReservation &) = delete;
+};
@@ -0,0 +1,329 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework/AsyncIO.hpp>
+#include <Pothos/Framework/Block.hpp>
+#include "Framework/WorkerActor.hpp"
+#include <Pothos/Exception.hpp>
+#include <Poco/Logger.h>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <vector>
+#include <deque>
+
+//platform specific blocking transfer: bytes transferred or a negative error code
+long long asyncIOTransfer(const Pothos::AsyncIO::Handle handle, const bool isWrite,
+    char *addr, const size_t length, const long long offset, const std::atomic<bool> &cancelled);
+
+//platform specific blocking gather write to a stream: bytes transferred or a negative error code
+long long asyncIOGatherStream(const Pothos::AsyncIO::Handle handle,
+    const std::vector<Pothos::BufferChunk> &chunks, const std::atomic<bool> &cancelled);
+
+//gather write, a file writes each chunk at its position
+static long long asyncIOGather(const Pothos::AsyncIO::Handle handle,
+    const std::vector<Pothos::BufferChunk> &chunks, const long long offset, const std::atomic<bool> &cancelled)
+{
+    if (offset < 0) return asyncIOGatherStream(handle, chunks, cancelled);
+    long long total = 0;
+    for (const auto &chunk : chunks)
+    {
+        const auto ret = asyncIOTransfer(handle, true, chunk.as<char *>(), chunk.length, offset+total, cancelled);
+        if (ret < 0) return (total != 0)?total:ret;
+        total += ret;
+        if (size_t(ret) != chunk.length) break;
+    }
+    return total;
+}
+
+/*!
+ * The number of threads in the framework I/O pool.
+ * Transfers of every AsyncIO object share the pool,
+ * a small pool is enough since most of the time is spent blocking.
+ */
+static const size_t NumPoolThreads = 4;
+
+/***********************************************************************
+ * framework I/O pool
+ **********************************************************************/
+class AsyncIOPool
+{
+public:
+    static AsyncIOPool &global(void)
+    {
+        static AsyncIOPool pool;
+        return pool;
+    }
+
+    void post(std::function<void(void)> &&job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push_back(std::move(job));
+        }
+        _cond.notify_one();
+    }
+
+private:
+    AsyncIOPool(void):
+        _running(true)
+    {
+        for (size_t i = 0; i < NumPoolThreads; i++)
+        {
+            _threads.emplace_back(&AsyncIOPool::loop, this);
+        }
+    }
+
+    ~AsyncIOPool(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _cond.notify_all();
+        for (auto &thread : _threads) thread.join();
+    }
+
+    void loop(void)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _cond.wait(lock, [this]{return not _jobs.empty() or not _running;});
+            if (_jobs.empty()) return;
+            auto job = std::move(_jobs.front());
+            _jobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<std::function<void(void)>> _jobs;
+    std::vector<std::thread> _threads;
+    bool _running;
+};
+
+/***********************************************************************
+ * async I/O implementation:
+ * At most one pool job runs the transfers of an AsyncIO object,
+ * the job performs one transfer and re-posts itself for the next one,
+ * so a busy object cannot keep the pool from the other objects.
+ **********************************************************************/
+struct Pothos::AsyncIO::Impl : std::enable_shared_from_this<Pothos::AsyncIO::Impl>
+{
+    Impl(ActorInterface *actor, const size_t maxPending):
+        actor(actor),
+        maxPending(maxPending),
+        numStarted(0),
+        scheduled(false),
+        running(false),
+        cancelled(false)
+    {
+        return;
+    }
+
+    struct Transfer
+    {
+        Handle handle;
+        long long offset;
+        bool isWrite;
+        bool done;
+        Job job; //or empty for a transfer on the handle
+        Completion completion;
+    };
+
+    bool submit(Transfer &&transfer);
+    void runNext(void);
+
+    ActorInterface *actor;
+    const size_t maxPending;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<Transfer> transfers; //in submission order
+    size_t numStarted; //transfers at the front which are done or running
+    bool scheduled; //a pool job is posted for the transfers
+    bool running; //a transfer is in progress
+    std::atomic<bool> cancelled;
+};
+
+bool Pothos::AsyncIO::Impl::submit(Transfer &&transfer)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (transfers.size() >= maxPending) return false;
+    transfers.push_back(std::move(transfer));
+
+    if (scheduled) return true;
+    scheduled = true;
+    auto self = this->shared_from_this();
+    AsyncIOPool::global().post([self]{self->runNext();});
+    return true;
+}
+
+void Pothos::AsyncIO::Impl::runNext(void)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (cancelled or numStarted >= transfers.size())
+    {
+        scheduled = false;
+        return;
+    }
+
+    //the buffer is held by the transfer until the completion is popped
+    const auto &next = transfers[numStarted++];
+    const auto job = next.job;
+    const auto handle = next.handle;
+    const auto isWrite = next.isWrite;
+    const auto offset = next.offset;
+    const auto addr = next.completion.buffer.as<char *>();
+    const auto length = next.completion.buffer.length;
+    const auto gather = next.completion.buffers.chunks();
+    running = true;
+    lock.unlock();
+
+    long long result = -1;
+    if (not gather.empty()) result = asyncIOGather(handle, gather, offset, cancelled);
+    else if (not job) result = asyncIOTransfer(handle, isWrite, addr, length, offset, cancelled);
+    else
+    {
+        POTHOS_EXCEPTION_TRY
+        {
+            result = job();
+        }
+        POTHOS_EXCEPTION_CATCH(const Exception &ex)
+        {
+            poco_error_f1(Poco::Logger::get("Pothos.AsyncIO"), "job: %s", ex.displayText());
+        }
+    }
+
+    //transfers run in order, so the running transfer is the last one started,
+    //its index shifts when the worker pops the completed transfers before it
+    lock.lock();
+    auto &transfer = transfers[numStarted-1];
+    transfer.done = true;
+    transfer.completion.result = result;
+    if (transfer.completion.buffer) transfer.completion.buffer.length = (result > 0)?size_t(result):0;
+
+    //wake the block under the lock, the destructor waits on the running transfer
+    if (not cancelled) actor->flagExternalChange();
+    running = false;
+    cond.notify_all();
+    if (cancelled or numStarted >= transfers.size())
+    {
+        scheduled = false;
+        return;
+    }
+    auto self = this->shared_from_this();
+    lock.unlock();
+    AsyncIOPool::global().post([self]{self->runNext();});
+}
+
+/***********************************************************************
+ * async I/O API
+ **********************************************************************/
+Pothos::AsyncIO::Completion::Completion(void):
+    result(0),
+    isWrite(false)
+{
+    return;
+}
+
+Pothos::AsyncIO::AsyncIO(void)
+{
+    return;
+}
+
+Pothos::AsyncIO::AsyncIO(Block *block, const size_t maxPending):
+    _impl(std::make_shared<Impl>(block->_actor.get(), std::max<size_t>(1, maxPending)))
+{
+    return;
+}
+
+Pothos::AsyncIO::~AsyncIO(void)
+{
+    if (not _impl) return;
+
+    //the pool job only touches the actor while a transfer is running,
+    //a posted job which has not started yet finds the cancelled flag
+    _impl->cancelled = true;
+    std::unique_lock<std::mutex> lock(_impl->mutex);
+    _impl->cond.wait(lock, [this]{return not _impl->running;});
+    _impl->transfers.clear();
+}
+
+Pothos::AsyncIO::operator bool(void) const
+{
+    return bool(_impl);
+}
+
+bool Pothos::AsyncIO::full(void) const
+{
+    return this->pending() >= _impl->maxPending;
+}
+
+size_t Pothos::AsyncIO::pending(void) const
+{
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    return _impl->transfers.size();
+}
+
+static Pothos::AsyncIO::Impl::Transfer makeTransfer(const Pothos::BufferChunk &buffer, const bool isWrite)
+{
+    Pothos::AsyncIO::Impl::Transfer transfer;
+    transfer.handle = 0;
+    transfer.offset = -1;
+    transfer.isWrite = isWrite;
+    transfer.done = false;
+    transfer.completion.buffer = buffer;
+    transfer.completion.isWrite = isWrite;
+    return transfer;
+}
+
+bool Pothos::AsyncIO::read(const Handle handle, const BufferChunk &buffer, const long long offset)
+{
+    auto transfer = makeTransfer(buffer, false);
+    transfer.handle = handle;
+    transfer.offset = offset;
+    return _impl->submit(std::move(transfer));
+}
+
+bool Pothos::AsyncIO::write(const Handle handle, const BufferChunk &buffer, const long long offset)
+{
+    auto transfer = makeTransfer(buffer, true);
+    transfer.handle = handle;
+    transfer.offset = offset;
+    return _impl->submit(std::move(transfer));
+}
+
+bool Pothos::AsyncIO::write(const Handle handle, const BufferChunkList &buffers, const long long offset)
+{
+    auto transfer = makeTransfer(BufferChunk(), true);
+    transfer.handle = handle;
+    transfer.offset = offset;
+    transfer.completion.buffers = buffers;
+    return _impl->submit(std::move(transfer));
+}
+
+bool Pothos::AsyncIO::submit(const Job &job, const BufferChunk &buffer)
+{
+    auto transfer = makeTransfer(buffer, false);
+    transfer.job = job;
+    return _impl->submit(std::move(transfer));
+}
+
+bool Pothos::AsyncIO::pop(Completion &completion)
+{
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    if (_impl->transfers.empty()) return false;
+    auto &front = _impl->transfers.front();
+    if (not front.done) return false;
+    completion = std::move(front.completion);
+    _impl->transfers.pop_front();
+    _impl->numStarted--;
+    return true;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework/AsyncIO.hpp>
+#include <algorithm> //min
+#include <atomic>
+#include <vector>
+#include <cerrno> //errno
+#include <climits> //IOV_MAX
+#include <unistd.h> //pread/pwrite
+#include <sys/uio.h> //writev
+#include <poll.h>
+
+/*!
+ * The poll timeout for stream transfers,
+ * a stream may never become ready so the cancel flag is checked periodically.
+ */
+static const int StreamPollTimeoutMs = 100;
+
+//wait for the stream to become ready, false when cancelled or in error
+static bool waitStreamReady(const int fd, const bool isWrite, const std::atomic<bool> &cancelled, int &error)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = isWrite?POLLOUT:POLLIN;
+    while (not cancelled)
+    {
+        pfd.revents = 0;
+        const int ret = poll(&pfd, 1, StreamPollTimeoutMs);
+        if (ret > 0) return true; //ready, or the transfer reports the error
+        if (ret < 0 and errno != EINTR)
+        {
+            error = errno;
+            return false;
+        }
+    }
+    error = ECANCELED;
+    return false;
+}
+
+long long asyncIOTransfer(const Pothos::AsyncIO::Handle handle, const bool isWrite,
+    char *addr, const size_t length, const long long offset, const std::atomic<bool> &cancelled)
+{
+    const int fd = int(handle);
+    size_t total = 0;
+    do
+    {
+        int error = 0;
+        if (offset < 0 and not waitStreamReady(fd, isWrite, cancelled, error))
+        {
+            return (total != 0)?(long long)(total):-(long long)(error);
+        }
+
+        char *ptr = addr+total;
+        const size_t num = length-total;
+        const off_t pos = off_t(offset)+off_t(total);
+        ssize_t ret = 0;
+        if (offset < 0 and isWrite) ret = ::write(fd, ptr, num);
+        else if (offset < 0) ret = ::read(fd, ptr, num);
+        else if (isWrite) ret = ::pwrite(fd, ptr, num, pos);
+        else ret = ::pread(fd, ptr, num, pos);
+        if (ret < 0 and (errno == EINTR or errno == EAGAIN or errno == EWOULDBLOCK)) continue;
+        if (ret < 0) return (total != 0)?(long long)(total):-(long long)(errno);
+        total += size_t(ret);
+
+        //a read returns what is available, a write transfers the entire buffer
+        if (not isWrite or ret == 0) break;
+    } while (total < length);
+    return (long long)(total);
+}
+
+long long asyncIOGatherStream(const Pothos::AsyncIO::Handle handle,
+    const std::vector<Pothos::BufferChunk> &chunks, const std::atomic<bool> &cancelled)
+{
+    const int fd = int(handle);
+    std::vector<struct iovec> iovs(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        iovs[i].iov_base = chunks[i].as<void *>();
+        iovs[i].iov_len = chunks[i].length;
+    }
+
+    size_t total = 0;
+    size_t index = 0;
+    while (index < iovs.size())
+    {
+        int error = 0;
+        if (not waitStreamReady(fd, true, cancelled, error))
+        {
+            return (total != 0)?(long long)(total):-(long long)(error);
+        }
+
+        const int num = int(std::min<size_t>(iovs.size()-index, IOV_MAX));
+        const ssize_t ret = ::writev(fd, iovs.data()+index, num);
+        if (ret < 0 and (errno == EINTR or errno == EAGAIN or errno == EWOULDBLOCK)) continue;
+        if (ret < 0) return (total != 0)?(long long)(total):-(long long)(errno);
+        if (ret == 0) break;
+        total += size_t(ret);
+
+        //skip the written vectors and advance into a partially written one
+        size_t remain = size_t(ret);
+        while (index < iovs.size() and remain >= iovs[index].iov_len)
+        {
+            remain -= iovs[index++].iov_len;
+        }
+        if (remain == 0) continue;
+        iovs[index].iov_base = static_cast<char *>(iovs[index].iov_base)+remain;
+        iovs[index].iov_len -= remain;
+    }
+    return (long long)(total);
+}
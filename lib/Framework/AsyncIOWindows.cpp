@@ -0,0 +1,155 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework/AsyncIO.hpp>
+#include <winsock2.h>
+#include <windows.h>
+#include <algorithm> //min
+#include <atomic>
+#include <vector>
+
+/*!
+ * The select timeout for stream transfers,
+ * a stream may never become ready so the cancel flag is checked periodically.
+ */
+static const long StreamSelectTimeoutUs = 100000;
+
+//the largest transfer of a single call, the length arguments are 32-bit
+static const size_t MaxCallBytes = size_t(1) << 30;
+
+//wait for the socket to become ready, false when cancelled or in error
+static bool waitStreamReady(const SOCKET sock, const bool isWrite, const std::atomic<bool> &cancelled, long long &error)
+{
+    while (not cancelled)
+    {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(sock, &fds);
+        timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = StreamSelectTimeoutUs;
+        const int ret = select(0, isWrite?nullptr:&fds, isWrite?&fds:nullptr, nullptr, &tv);
+        if (ret > 0) return true; //ready, or the transfer reports the error
+        if (ret == SOCKET_ERROR)
+        {
+            error = WSAGetLastError();
+            return false;
+        }
+    }
+    error = ERROR_OPERATION_ABORTED;
+    return false;
+}
+
+long long asyncIOTransfer(const Pothos::AsyncIO::Handle handle, const bool isWrite,
+    char *addr, const size_t length, const long long offset, const std::atomic<bool> &cancelled)
+{
+    size_t total = 0;
+    do
+    {
+        long long error = 0;
+        const int num = int(std::min(length-total, MaxCallBytes));
+        long long ret = 0;
+
+        //streams are sockets, the transfer waits in select to observe the cancel flag
+        if (offset < 0)
+        {
+            const SOCKET sock = SOCKET(handle);
+            if (not waitStreamReady(sock, isWrite, cancelled, error))
+            {
+                return (total != 0)?(long long)(total):-error;
+            }
+            ret = isWrite?send(sock, addr+total, num, 0):recv(sock, addr+total, num, 0);
+            if (ret == SOCKET_ERROR)
+            {
+                error = WSAGetLastError();
+                if (error == WSAEWOULDBLOCK) continue;
+                return (total != 0)?(long long)(total):-error;
+            }
+        }
+
+        //files use the position in the overlapped structure of a synchronous transfer
+        else
+        {
+            OVERLAPPED overlapped;
+            ZeroMemory(&overlapped, sizeof(overlapped));
+            const unsigned long long pos = (unsigned long long)(offset)+total;
+            overlapped.Offset = DWORD(pos & 0xffffffff);
+            overlapped.OffsetHigh = DWORD(pos >> 32);
+            DWORD numTransferred = 0;
+            const BOOL ok = isWrite?
+                WriteFile(HANDLE(handle), addr+total, DWORD(num), &numTransferred, &overlapped):
+                ReadFile(HANDLE(handle), addr+total, DWORD(num), &numTransferred, &overlapped);
+            if (not ok and GetLastError() != ERROR_HANDLE_EOF)
+            {
+                error = GetLastError();
+                return (total != 0)?(long long)(total):-error;
+            }
+            ret = numTransferred;
+        }
+        total += size_t(ret);
+
+        //a read returns what is available, a write transfers the entire buffer
+        if (not isWrite or ret == 0) break;
+    } while (total < length);
+    return (long long)(total);
+}
+
+long long asyncIOGatherStream(const Pothos::AsyncIO::Handle handle,
+    const std::vector<Pothos::BufferChunk> &chunks, const std::atomic<bool> &cancelled)
+{
+    //the buffer lengths are 32-bit, send oversized chunks one at a time
+    bool oversized = false;
+    for (const auto &chunk : chunks) oversized = oversized or chunk.length > MaxCallBytes;
+    if (oversized)
+    {
+        long long total = 0;
+        for (const auto &chunk : chunks)
+        {
+            const auto ret = asyncIOTransfer(handle, true, chunk.as<char *>(), chunk.length, -1, cancelled);
+            if (ret < 0) return (total != 0)?total:ret;
+            total += ret;
+            if (size_t(ret) != chunk.length) break;
+        }
+        return total;
+    }
+
+    const SOCKET sock = SOCKET(handle);
+    std::vector<WSABUF> bufs(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        bufs[i].buf = chunks[i].as<CHAR *>();
+        bufs[i].len = ULONG(chunks[i].length);
+    }
+
+    size_t total = 0;
+    size_t index = 0;
+    while (index < bufs.size())
+    {
+        long long error = 0;
+        if (not waitStreamReady(sock, true, cancelled, error))
+        {
+            return (total != 0)?(long long)(total):-error;
+        }
+
+        DWORD numSent = 0;
+        if (WSASend(sock, bufs.data()+index, DWORD(bufs.size()-index), &numSent, 0, nullptr, nullptr) == SOCKET_ERROR)
+        {
+            error = WSAGetLastError();
+            if (error == WSAEWOULDBLOCK) continue;
+            return (total != 0)?(long long)(total):-error;
+        }
+        if (numSent == 0) break;
+        total += numSent;
+
+        //skip the sent buffers and advance into a partially sent one
+        size_t remain = numSent;
+        while (index < bufs.size() and remain >= bufs[index].len)
+        {
+            remain -= bufs[index++].len;
+        }
+        if (remain == 0) continue;
+        bufs[index].buf += remain;
+        bufs[index].len -= ULONG(remain);
+    }
+    return (long long)(total);
+}
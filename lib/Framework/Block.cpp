@@ -21,6 +21,7 @@ void Pothos::Block::setThreadPool(const ThreadPool &newThreadPool)
     if (_threadPool)
     {
         auto threads = std::static_pointer_cast<ThreadEnvironment>(_threadPool.getContainer());
+        _actor->setReadyTask(nullptr);
         threads->unregisterTask(this);
     }
 
@@ -28,13 +29,19 @@ void Pothos::Block::setThreadPool(const ThreadPool &newThreadPool)
     if (newThreadPool)
     {
         auto threads = std::static_pointer_cast<ThreadEnvironment>(newThreadPool.getContainer());
-        threads->registerTask(this,
+        auto readyTask = threads->registerTask(this,
             std::bind(&Pothos::WorkerActor::processTask, _actor.get(), std::placeholders::_1),
             std::bind(&Pothos::WorkerActor::wakeNoChange, _actor.get()));
 
+        //the scheduler is notified by the actor upon changes
+        //which drives the ready queues and the waits of fused groups
+        _actor->setReadyTask(readyTask);
+
         //configure the actor interface based on thread pool args
         //all we support for now is the default (wait) or spin mode
         _actor->enableWaitMode(threads->isWaitingEnabled());
+        _actor->setWaitTimeout(threads->getWaitTimeout());
+        threads->setTaskPriority(this, _schedulingPriority);
     }
 
     //and save the reference to the new pool
@@ -46,10 +53,25 @@ const Pothos::ThreadPool &Pothos::Block::getThreadPool(void) const
     return _threadPool;
 }
 
+void Pothos::Block::setSchedulingPriority(const int priority)
+{
+    _schedulingPriority = std::min(std::max(priority, -1), 1);
+    if (not _threadPool) return;
+    _actor->drainRetask = true;
+    auto threads = std::static_pointer_cast<ThreadEnvironment>(_threadPool.getContainer());
+    threads->setTaskPriority(this, _schedulingPriority);
+}
+
+int Pothos::Block::getSchedulingPriority(void) const
+{
+    return _schedulingPriority;
+}
+
 /***********************************************************************
  * Block member implementation
  **********************************************************************/
 Pothos::Block::Block(void):
+    _schedulingPriority(0),
     _actor(new WorkerActor(this))
 {
     //set the default thread pool (registers)
@@ -150,13 +172,13 @@ void Pothos::Block::registerSignal(const std::string &name)
     _actor->allocateSignal(name);
 }
 
-void Pothos::Block::registerSlot(const std::string &name)
+void Pothos::Block::registerSlot(const std::string &name, const bool latestOnly)
 {
     if (name.empty()) throw PortAccessError("Pothos::Block::registerSlot()", "empty name");
-    if (_actor->automaticSlots.count(name) != 0) return; //already registered automatically, no error
-    if (_namedInputs.count(name) > 0) throw PortAccessError("Pothos::Block::registerSlot("+name+")", "already registered");
+    const bool automatic = _actor->automaticSlots.count(name) != 0; //already registered automatically, update the option
+    if (not automatic and _namedInputs.count(name) > 0) throw PortAccessError("Pothos::Block::registerSlot("+name+")", "already registered");
 
-    _actor->allocateSlot(name);
+    _actor->allocateSlot(name, latestOnly);
 }
 
 void Pothos::Block::registerProbe(
@@ -177,6 +199,35 @@ void Pothos::Block::registerProbe(
     _probes[slotName] = std::make_pair(name, signalName);
 }
 
+void Pothos::Block::registerPublishedValue(const std::string &name)
+{
+    if (name.empty()) throw PortAccessError("Pothos::Block::registerPublishedValue()", "empty name");
+    if (_actor->activeState) throw Pothos::RuntimeException("Pothos::Block::registerPublishedValue("+name+")", "block is active");
+    _actor->publishedValues.add(name);
+}
+
+void Pothos::Block::publishValue(const std::string &name, const double value)
+{
+    const auto index = _actor->publishedValues.find(name);
+    if (index < 0) throw Pothos::NotFoundException("Pothos::Block::publishValue("+name+")", "value not registered");
+    _actor->publishedValues.set(size_t(index), value);
+}
+
+double Pothos::Block::readPublishedValue(const std::string &name) const
+{
+    const auto index = _actor->publishedValues.find(name);
+    if (index < 0) throw Pothos::NotFoundException("Pothos::Block::readPublishedValue("+name+")", "value not registered");
+    return _actor->publishedValues.read()[size_t(index)];
+}
+
+std::map<std::string, double> Pothos::Block::readPublishedValues(void) const
+{
+    const auto values = _actor->publishedValues.read();
+    std::map<std::string, double> result;
+    for (const auto &pair : _actor->publishedValues.indexes()) result[pair.first] = values[pair.second];
+    return result;
+}
+
 Pothos::Object Pothos::Block::opaqueCallHandler(const std::string &name, const Pothos::Object *inputArgs, const size_t numArgs)
 {
     //check if the name is a registered call
@@ -229,11 +280,40 @@ Pothos::Object Pothos::Block::opaqueCallMethod(const std::string &name, const Po
     return const_cast<Block *>(this)->opaqueCallHandler(name, inputArgs, numArgs);
 }
 
+void Pothos::Block::opaqueAsyncCall(const std::string &name, const Pothos::Object *inputArgs, const size_t numArgs, const bool coalesce) const
+{
+    if (_calls.count(name) == 0)
+    {
+        throw Pothos::BlockCallNotFound("Pothos::Block::asyncCall("+name+")", "method does not exist in registry");
+    }
+
+    //the worker thread runs the call, no thread context is acquired here
+    _actor->asyncCallsPush(name, ObjectVector(inputArgs, inputArgs+numArgs), coalesce);
+}
+
 void Pothos::Block::yield(void)
 {
+    _actor->drainRetask = true;
     _actor->flagInternalChange();
 }
 
+void Pothos::Block::endOfStream(void)
+{
+    _actor->setEndOfStream();
+}
+
+Pothos::Util::MonotonicArena &Pothos::Block::workArena(void)
+{
+    return _actor->workArena;
+}
+
+void Pothos::Block::scheduleWakeup(const std::chrono::steady_clock::time_point &timePoint)
+{
+    if (not _threadPool) return;
+    auto threads = std::static_pointer_cast<ThreadEnvironment>(_threadPool.getContainer());
+    threads->scheduleWakeup(this, timePoint, std::bind(&Pothos::WorkerActor::flagExternalChange, _actor.get()));
+}
+
 std::shared_ptr<Pothos::BufferManager> Pothos::Block::getInputBufferManager(const std::string &, const std::string &)
 {
     return Pothos::BufferManager::Sptr(); //abdicate
@@ -291,6 +371,24 @@ static Pothos::Block *getPointer(Pothos::Block &b)
     return &b;
 }
 
+//asyncCall(name, args...) from a proxy, the first argument is the name of the call
+static Pothos::Object proxyAsyncCall(const Pothos::Block &b, const Pothos::Object *args, const size_t numArgs, const bool coalesce)
+{
+    if (numArgs == 0) throw Pothos::InvalidArgumentException("Pothos::Block::asyncCall()", "missing call name");
+    b.opaqueAsyncCall(args[0].convert<std::string>(), args+1, numArgs-1, coalesce);
+    return Pothos::Object();
+}
+
+static Pothos::Object proxyAsyncCallNormal(Pothos::Block &b, const Pothos::Object *args, const size_t numArgs)
+{
+    return proxyAsyncCall(b, args, numArgs, false);
+}
+
+static Pothos::Object proxyAsyncCallLatest(Pothos::Block &b, const Pothos::Object *args, const size_t numArgs)
+{
+    return proxyAsyncCall(b, args, numArgs, true);
+}
+
 static auto managedBlock = Pothos::ManagedClass()
     .registerClass<Pothos::Block>()
     .registerBaseClass<Pothos::Block, Pothos::Connectable>()
@@ -302,6 +400,8 @@ static auto managedBlock = Pothos::ManagedClass()
     //all of the setups with default args set
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, setThreadPool))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, getThreadPool))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, setSchedulingPriority))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, getSchedulingPriority))
     .registerMethod<Pothos::InputPort *, Pothos::Block, const std::string &, const Pothos::DType &, const std::string &>(POTHOS_FCN_TUPLE(Pothos::Block, setupInput))
     .registerMethod<Pothos::InputPort *, Pothos::Block, size_t, const Pothos::DType &, const std::string &>(POTHOS_FCN_TUPLE(Pothos::Block, setupInput))
     .registerMethod<Pothos::OutputPort *, Pothos::Block, const std::string &, const Pothos::DType &, const std::string &>(POTHOS_FCN_TUPLE(Pothos::Block, setupOutput))
@@ -319,7 +419,12 @@ static auto managedBlock = Pothos::ManagedClass()
 
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, registerSignal))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, registerSlot))
+    .registerMethod("registerSlot", Pothos::Callable(&Pothos::Block::registerSlot).bind(false, 2))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, registerProbe))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, registerPublishedValue))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, publishValue))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, readPublishedValue))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, readPublishedValues))
     .registerMethod("registerProbe", Pothos::Callable(&Pothos::Block::registerProbe).bind("", 3))
     .registerMethod("registerProbe", Pothos::Callable(&Pothos::Block::registerProbe).bind("", 3).bind("", 2))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, inputs))
@@ -331,6 +436,9 @@ static auto managedBlock = Pothos::ManagedClass()
     .registerMethod<Pothos::OutputPort *, Pothos::Block, const std::string &>(POTHOS_FCN_TUPLE(Pothos::Block, output))
     .registerMethod<Pothos::OutputPort *, Pothos::Block, size_t>(POTHOS_FCN_TUPLE(Pothos::Block, output))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, yield))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Block, endOfStream))
+    .registerOpaqueMethod("asyncCall", &proxyAsyncCallNormal)
+    .registerOpaqueMethod("asyncCallLatest", &proxyAsyncCallLatest)
     .commit("Pothos/Block");
 
 template <typename PortType>
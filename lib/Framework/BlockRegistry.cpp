@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/Block.hpp>
@@ -6,7 +6,9 @@
 #include <Pothos/Framework/BlockRegistry.hpp>
 #include <Pothos/Framework/Exception.hpp>
 #include <Pothos/Plugin.hpp>
+#include <Pothos/System/CpuFeatures.hpp>
 #include <Poco/Logger.h>
+#include <algorithm> //find
 #include <iostream>
 
 //! Helper function to check the signature of an "opaque" call
@@ -18,10 +20,19 @@ static bool isOpaqueFactory(const Pothos::Callable &factory)
         factory.type(1) == typeid(const size_t);
 }
 
-/***********************************************************************
- * Instance of BlockRegistry peforms check and plugin registration
- **********************************************************************/
-Pothos::BlockRegistry::BlockRegistry(const std::string &path, const Callable &factory)
+//! Helper function to check the return type of a block factory
+static bool isBlockFactory(const Pothos::Callable &factory)
+{
+    return
+        factory.type(-1) == typeid(Pothos::Block*) or
+        factory.type(-1) == typeid(std::shared_ptr<Pothos::Block>) or
+        factory.type(-1) == typeid(Pothos::Topology*) or
+        factory.type(-1) == typeid(std::shared_ptr<Pothos::Topology>) or
+        isOpaqueFactory(factory);
+}
+
+//! Check and register a factory under the root, errors are logged
+static void registerFactory(const std::string &root, const std::string &path, const Pothos::Callable &factory)
 {
     //check the path
     if (path.empty() or path.front() != '/')
@@ -31,31 +42,26 @@ Pothos::BlockRegistry::BlockRegistry(const std::string &path, const Callable &fa
     }
 
     //parse the path
-    PluginPath fullPath;
+    Pothos::PluginPath fullPath;
     try
     {
-        fullPath = PluginPath("/blocks", path);
+        fullPath = Pothos::PluginPath(root, path);
     }
-    catch (const PluginPathError &)
+    catch (const Pothos::PluginPathError &)
     {
         poco_error_f1(Poco::Logger::get("Pothos.BlockRegistry"), "Invalid path: %s", path);
         return;
     }
 
     //check the factory
-    if (
-        factory.type(-1) == typeid(Block*) or
-        factory.type(-1) == typeid(std::shared_ptr<Block>) or
-        factory.type(-1) == typeid(Topology*) or
-        factory.type(-1) == typeid(std::shared_ptr<Topology>) or
-        isOpaqueFactory(factory))
+    if (isBlockFactory(factory))
     {
         //register
         try
         {
-            PluginRegistry::add(fullPath, factory);
+            Pothos::PluginRegistry::add(fullPath, factory);
         }
-        catch (const PluginRegistryError &ex)
+        catch (const Pothos::PluginRegistryError &ex)
         {
             poco_error(Poco::Logger::get("Pothos.BlockRegistry"), ex.displayText());
             return;
@@ -69,12 +75,46 @@ Pothos::BlockRegistry::BlockRegistry(const std::string &path, const Callable &fa
     }
 }
 
+/***********************************************************************
+ * Instance of BlockRegistry peforms check and plugin registration
+ **********************************************************************/
+Pothos::BlockRegistry::BlockRegistry(const std::string &path, const Callable &factory)
+{
+    registerFactory("/blocks", path, factory);
+}
+
+Pothos::BlockRegistry::BlockRegistry(const std::string &path, const std::string &isa, const Callable &factory)
+{
+    const auto ranking = System::CpuFeatures::ranking();
+    if (std::find(ranking.begin(), ranking.end(), isa) == ranking.end())
+    {
+        poco_error_f2(Poco::Logger::get("Pothos.BlockRegistry"), "Unknown instruction set %s: %s", isa, path);
+        return;
+    }
+    registerFactory("/framework/block_variants", path+"/"+isa, factory);
+}
+
+//! Get the plugin path of the best variant for this host, or the base factory
+static Pothos::PluginPath blockRegistryPath(const std::string &path)
+{
+    const Pothos::PluginPath variantsPath("/framework/block_variants", path);
+    if (not Pothos::PluginRegistry::exists(variantsPath)) return Pothos::PluginPath("/blocks", path);
+
+    const auto features = Pothos::System::CpuFeatures::get();
+    const auto variants = Pothos::PluginRegistry::list(variantsPath);
+    for (const auto &isa : features.names())
+    {
+        if (std::find(variants.begin(), variants.end(), isa) != variants.end()) return variantsPath.join(isa);
+    }
+    return Pothos::PluginPath("/blocks", path);
+}
+
 /***********************************************************************
  * BlockRegistry factory - retrieve factory and instantiate with args
  **********************************************************************/
 static Pothos::Object blockRegistryMake(const std::string &path, const Pothos::Object *args, const size_t numArgs)
 {
-    const auto pluginPath = Pothos::PluginPath("/blocks", path);
+    const auto pluginPath = blockRegistryPath(path);
     const auto plugin = Pothos::PluginRegistry::get(pluginPath);
     const auto factory = plugin.getObject().extract<Pothos::Callable>();
 
@@ -126,9 +166,34 @@ static Pothos::Object blockRegistryMake(const std::string &path, const Pothos::O
     throw Pothos::IllegalStateException("Pothos::BlockRegistry::make("+path+")", factory.toString());
 }
 
+/***********************************************************************
+ * Domain copier selection from the registered domain toolkits
+ **********************************************************************/
+std::string Pothos::BlockRegistry::findDomainCopier(const std::string &srcDomain, const std::string &dstDomain)
+{
+    const PluginPath copiersPath("/framework/domain_copier");
+    for (const auto &name : PluginRegistry::list(copiersPath))
+    {
+        //a failing selection call only declines the crossing
+        try
+        {
+            const auto plugin = PluginRegistry::get(copiersPath.join(name));
+            const auto &callable = plugin.getObject().extract<Pothos::Callable>();
+            const auto path = callable.call<std::string>(srcDomain, dstDomain);
+            if (not path.empty()) return path;
+        }
+        catch (const Exception &ex)
+        {
+            poco_error_f2(Poco::Logger::get("Pothos.BlockRegistry"), "Domain copier %s: %s", name, ex.displayText());
+        }
+    }
+    return "/blocks/copier";
+}
+
 #include <Pothos/Managed.hpp>
 
 static auto managedBlockRegistry = Pothos::ManagedClass()
     .registerClass<Pothos::BlockRegistry>()
+    .registerStaticMethod(POTHOS_FCN_TUPLE(Pothos::BlockRegistry, findDomainCopier))
     .registerWildcardStaticMethod(&blockRegistryMake)
     .commit("Pothos/BlockRegistry");
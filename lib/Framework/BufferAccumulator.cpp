@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/BufferAccumulator.hpp>
@@ -14,9 +14,12 @@
  * BufferAccumulator implementation
  **********************************************************************/
 Pothos::BufferAccumulator::BufferAccumulator(void):
-    _queue(64/*arbitrary*/),
+    _queue(4/*grows with use*/),
     _bytesAvailable(0),
-    _inPoolBuffer(false)
+    _inPoolBuffer(false),
+    _totalBytesCopied(0),
+    _queueHighWaterMark(0),
+    _totalQueueResizes(0)
 {
     //never let the queue become empty -- hold an empty buffer
     if (_queue.empty()) _queue.push_front(BufferChunk());
@@ -53,10 +56,11 @@ void Pothos::BufferAccumulator::push(BufferChunk &&buffer)
 
     //Resize the queue before pushing if it full of managed buffers.
     //The implementation of set_capacity preserves the queue elements.
-    if (queue.full()) queue.set_capacity(queue.size()*2);
+    if (queue.full()) this->growQueue();
 
     //push the buffer, then perform amalgamation if possible
     queue.push_back(std::move(buffer));
+    _queueHighWaterMark = std::max(_queueHighWaterMark, queue.size());
     const size_t backIndex = queue.size() - 1;
     if (queue.size() < 2) goto restoreNextBuffers;
 
@@ -102,14 +106,21 @@ void Pothos::BufferAccumulator::push(BufferChunk &&buffer)
         mb._impl = mb._impl->nextBuffer;
         BufferChunk bnext(mb);
         bnext.length = 0;
-        if (queue.full()) queue.set_capacity(queue.size()*2);
+        if (queue.full()) this->growQueue();
         queue.push_back(std::move(bnext));
     }
+    _queueHighWaterMark = std::max(_queueHighWaterMark, queue.size());
     mb._impl = nullptr;
 
     assert(not queue.empty());
 }
 
+void Pothos::BufferAccumulator::growQueue(void)
+{
+    _queue.set_capacity(_queue.size()*2);
+    _totalQueueResizes++;
+}
+
 /***********************************************************************
  * BufferAccumulator Pop implementation
  **********************************************************************/
@@ -210,6 +221,7 @@ void Pothos::BufferAccumulator::require(const size_t numBytes)
             (void *)(f.address), copyBytes);
         newBuffBytes -= copyBytes;
         newBuffer.length += copyBytes;
+        _totalBytesCopied += copyBytes;
 
         //buffer is drained, pop from queue
         if (f.length == copyBytes)
@@ -229,6 +241,7 @@ void Pothos::BufferAccumulator::require(const size_t numBytes)
 
     //finally store the new buffer to the front
     _inPoolBuffer = true;
+    if (queue.full()) this->growQueue();
     queue.push_front(std::move(newBuffer));
 }
 
@@ -0,0 +1,185 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Exception.hpp>
+#include <Pothos/Framework/BufferManager.hpp>
+#include <json.hpp>
+#include <algorithm> //min/max
+#include <chrono>
+
+/*!
+ * The buffer auto-tuner picks the bufferSize and numBuffers of an output port
+ * from the measured flow, bounded by the in-flight latency and memory limits:
+ *  - buffers that are mostly filled by each work() call double in size,
+ *    so that high rate streams pay the per-buffer overhead less often
+ *  - buffers that are mostly empty after each work() call halve in size
+ *  - starvations of the output buffer manager add another buffer
+ *  - the bytes in flight are bounded by the memory limit, and by the bytes
+ *    that the flow moves in the latency limit at the measured rate,
+ *    which removes buffers down to double buffering and then halves their size
+ * The sizes stay powers of two between the min and max buffer sizes,
+ * and the gap between the grow and shrink thresholds keeps the result stable.
+ *
+ * Example JSON markup for the tuner configuration:
+ * \code {.json}
+ * {
+ *     "interval" : 0.5,
+ *     "maxLatency" : 0.01,
+ *     "maxMemory" : 16777216,
+ *     "minBufferSize" : 1024,
+ *     "maxBufferSize" : 4194304,
+ *     "maxBuffers" : 32
+ * }
+ * \endcode
+ */
+class BufferAutoTuner
+{
+public:
+    //! Parse the tuner configuration from the "autoTune" buffer argument
+    BufferAutoTuner(const nlohmann::json &config = nlohmann::json::object()):
+        interval(0.5),
+        maxLatency(0.0),
+        maxMemory(16*1024*1024),
+        minBufferSize(1024),
+        maxBufferSize(4*1024*1024),
+        maxBuffers(32),
+        _tuned(false),
+        _started(false),
+        _lastBytes(0),
+        _lastWorkCalls(0),
+        _lastStarvations(0)
+    {
+        if (config.is_boolean()) return; //"autoTune" : true uses the defaults
+        if (not config.is_object()) throw Pothos::InvalidArgumentException(
+            "BufferAutoTuner()", "autoTune must be a boolean or an object: " + config.dump());
+        interval = config.value("interval", interval);
+        maxLatency = config.value("maxLatency", maxLatency);
+        maxMemory = config.value("maxMemory", maxMemory);
+        minBufferSize = config.value("minBufferSize", minBufferSize);
+        maxBufferSize = config.value("maxBufferSize", maxBufferSize);
+        maxBuffers = config.value("maxBuffers", maxBuffers);
+        if (interval <= 0.0 or maxLatency < 0.0) throw Pothos::InvalidArgumentException(
+            "BufferAutoTuner()", "autoTune interval must be positive and maxLatency non-negative");
+        if (minBufferSize == 0 or minBufferSize > maxBufferSize) throw Pothos::InvalidArgumentException(
+            "BufferAutoTuner()", "autoTune needs 0 < minBufferSize <= maxBufferSize");
+        if (maxBuffers < 2 or maxMemory < 2*minBufferSize) throw Pothos::InvalidArgumentException(
+            "BufferAutoTuner()", "autoTune needs room for two buffers of minBufferSize");
+    }
+
+    //! True once the tuner has replaced the initial buffer geometry
+    bool isTuned(void) const
+    {
+        return _tuned;
+    }
+
+    //! Apply the tuned geometry to the arguments of a new buffer manager
+    void apply(Pothos::BufferManagerArgs &args) const
+    {
+        if (not _tuned) return;
+        args.bufferSize = _args.bufferSize;
+        args.numBuffers = _args.numBuffers;
+    }
+
+    //! Record the geometry of a newly installed buffer manager
+    void installed(const Pothos::BufferManagerArgs &args)
+    {
+        _args.bufferSize = args.bufferSize;
+        _args.numBuffers = args.numBuffers;
+    }
+
+    /*!
+     * Sample the port counters and update the tuned geometry once per interval.
+     * \param totalBytes the total bytes produced on the port
+     * \param numWorkCalls the total work() calls of the block
+     * \param starvations the total times the port had no buffer from the manager
+     * \return true when the geometry changed and the manager should be replaced
+     */
+    bool update(
+        const unsigned long long totalBytes,
+        const unsigned long long numWorkCalls,
+        const unsigned long long starvations)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (not _started)
+        {
+            this->mark(now, totalBytes, numWorkCalls, starvations);
+            return false;
+        }
+        const double elapsed = std::chrono::duration<double>(now-_lastTime).count();
+        if (elapsed < interval) return false;
+
+        const auto bytes = totalBytes-_lastBytes;
+        const auto calls = numWorkCalls-_lastWorkCalls;
+        const auto starved = starvations-_lastStarvations;
+        this->mark(now, totalBytes, numWorkCalls, starvations);
+        if (calls == 0 or bytes == 0) return false; //nothing to learn from an idle flow
+
+        size_t bufferSize = _args.bufferSize;
+        size_t numBuffers = _args.numBuffers;
+        const auto bytesPerCall = bytes/calls;
+        if (bytesPerCall*4 >= bufferSize*3) bufferSize *= 2;
+        else if (bytesPerCall*4 < bufferSize) bufferSize /= 2;
+        if (starved != 0) numBuffers++;
+
+        //round into the legal sizes and then fit the bytes in flight into the budget
+        size_t size = minBufferSize;
+        while (size < bufferSize and size < maxBufferSize) size *= 2;
+        bufferSize = std::min(size, maxBufferSize);
+        numBuffers = std::max<size_t>(2, std::min(numBuffers, maxBuffers));
+        double budget = double(maxMemory);
+        if (maxLatency > 0.0) budget = std::min(budget, maxLatency*bytes/elapsed);
+        while (numBuffers > 2 and double(numBuffers*bufferSize) > budget) numBuffers--;
+        while (bufferSize/2 >= minBufferSize and double(numBuffers*bufferSize) > budget) bufferSize /= 2;
+
+        if (bufferSize == _args.bufferSize and numBuffers == _args.numBuffers) return false;
+        _args.bufferSize = bufferSize;
+        _args.numBuffers = numBuffers;
+        _tuned = true;
+        return true;
+    }
+
+    //! Dump the configuration and tuned geometry for the port stats
+    nlohmann::json toJSON(void) const
+    {
+        nlohmann::json obj;
+        obj["tuned"] = _tuned;
+        if (_tuned)
+        {
+            obj["bufferSize"] = _args.bufferSize;
+            obj["numBuffers"] = _args.numBuffers;
+        }
+        obj["maxLatency"] = maxLatency;
+        obj["maxMemory"] = maxMemory;
+        return obj;
+    }
+
+    double interval; //!< seconds between the updates
+    double maxLatency; //!< seconds for the flow to drain the bytes in flight, 0 for no bound
+    size_t maxMemory; //!< maximum bytes in flight
+    size_t minBufferSize; //!< smallest tuned buffer size
+    size_t maxBufferSize; //!< largest tuned buffer size
+    size_t maxBuffers; //!< largest tuned buffer count
+
+private:
+    void mark(const std::chrono::steady_clock::time_point &now,
+        const unsigned long long totalBytes,
+        const unsigned long long numWorkCalls,
+        const unsigned long long starvations)
+    {
+        _started = true;
+        _lastTime = now;
+        _lastBytes = totalBytes;
+        _lastWorkCalls = numWorkCalls;
+        _lastStarvations = starvations;
+    }
+
+    bool _tuned;
+    bool _started;
+    Pothos::BufferManagerArgs _args; //geometry of the installed manager
+    std::chrono::steady_clock::time_point _lastTime;
+    unsigned long long _lastBytes;
+    unsigned long long _lastWorkCalls;
+    unsigned long long _lastStarvations;
+};
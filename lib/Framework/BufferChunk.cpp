@@ -44,6 +44,34 @@ void Pothos::BufferChunk::append(const BufferChunk &other)
     }
 }
 
+void Pothos::BufferChunk::shareInto(BufferChunk *copies, const size_t numCopies) const
+{
+    if (numCopies == 0) return;
+
+    //release the previous contents before aliasing without references
+    for (size_t i = 0; i < numCopies; i++)
+    {
+        auto &copy = copies[i];
+        copy = BufferChunk();
+        copy.address = this->address;
+        copy.length = this->length;
+        copy.dtype = this->dtype;
+        copy._managedBuffer._impl = _managedBuffer._impl;
+        copy._nextBuffers = _nextBuffers;
+    }
+
+    //one reference bump per buffer for all of the copies
+    auto mb = _managedBuffer._impl;
+    if (mb == nullptr) return;
+    mb->counter.fetch_add(int(numCopies), std::memory_order_relaxed);
+    for (size_t i = 0; i < _nextBuffers; i++)
+    {
+        mb = mb->nextBuffer;
+        assert(mb != nullptr);
+        mb->counter.fetch_add(int(numCopies), std::memory_order_relaxed);
+    }
+}
+
 void Pothos::BufferChunk::_incrNextBuffers(void)
 {
     _nextBuffers = 0;
@@ -99,34 +127,106 @@ static auto managedBufferChunk = Pothos::ManagedClass()
     .commit("Pothos/BufferChunk");
 
 #include <Pothos/Object/Serialize.hpp>
+#include <Pothos/Archive/Exception.hpp>
 #include <Poco/Types.h>
+#include <algorithm> //min
+#include <limits>
+#include <string>
 
 namespace Pothos { namespace serialization {
+
+//! The archive version which introduced the 64-bit chunked format
+static const unsigned int bufferChunk64Version = 4;
+
+//! The archive version which introduced padding before large payloads
+static const unsigned int bufferChunkPaddedVersion = 5;
+
+//! Payloads of at least this many bytes are padded and loaded as mapped views
+static const size_t bufferChunkPaddedBytes = 4096;
+
+//! The data is read and written in chunks of this many bytes
+static const size_t bufferChunkStreamBytes = 1 << 20;
+
+//! A view of the payload in a mapped archive, or null when not mapped
+static Pothos::BufferChunk loadView(Pothos::Archive::IStreamArchiver &ar, const size_t length)
+{
+    const auto view = ar.readView(length);
+    if (view == nullptr) return Pothos::BufferChunk();
+    return Pothos::BufferChunk(Pothos::SharedBuffer(size_t(view), length, ar.getMappedOwner()));
+}
+
 template <class Archive>
-void save(Archive & ar, const Pothos::BufferChunk &t, const unsigned int)
+void save(Archive & ar, const Pothos::BufferChunk &t, const unsigned int ver)
 {
     const bool is_null = not t;
     ar << is_null;
     if (is_null) return;
-    const Poco::UInt32 length = Poco::UInt32(t.length);
-    ar << length;
-    Pothos::serialization::BinaryObject bo(t.as<void *>(), t.length);
-    ar << bo;
+    if (ver < bufferChunk64Version)
+    {
+        ar << Poco::UInt32(t.length);
+        Pothos::serialization::BinaryObject bo(t.as<void *>(), t.length);
+        ar << bo;
+    }
+    else
+    {
+        ar << Poco::UInt64(t.length);
+        if (ver >= bufferChunkPaddedVersion and t.length >= bufferChunkPaddedBytes) ar.writePadding();
+        const auto data = t.as<const char *>();
+        for (size_t offset = 0; offset < t.length; offset += bufferChunkStreamBytes)
+        {
+            Pothos::serialization::BinaryObject bo(data+offset, std::min(t.length-offset, bufferChunkStreamBytes));
+            ar << bo;
+        }
+    }
     ar << t.dtype;
 }
 
 template <class Archive>
-void load(Archive & ar, Pothos::BufferChunk &t, const unsigned int)
+void load(Archive & ar, Pothos::BufferChunk &t, const unsigned int ver)
 {
-    t = Pothos::BufferChunk();
     bool is_null = false;
     ar >> is_null;
-    if (is_null) return;
-    Poco::UInt32 length = 0;
-    ar >> length;
-    t = Pothos::BufferChunk(size_t(length));
-    Pothos::serialization::BinaryObject bo(t.as<void *>(), t.length);
-    ar >> bo;
+    if (is_null)
+    {
+        t = Pothos::BufferChunk();
+        return;
+    }
+
+    Poco::UInt64 length = 0;
+    if (ver < bufferChunk64Version)
+    {
+        Poco::UInt32 length32 = 0;
+        ar >> length32;
+        length = length32;
+    }
+    else ar >> length;
+    if (length > std::numeric_limits<size_t>::max()) throw Pothos::ArchiveException(
+        "BufferChunk::load()", "length exceeds the address space: " + std::to_string(length));
+
+    //large payloads from a memory mapped archive are views without a copy
+    Pothos::BufferChunk view;
+    if (ver >= bufferChunkPaddedVersion and length >= bufferChunkPaddedBytes)
+    {
+        ar.readPadding();
+        view = loadView(ar, size_t(length));
+    }
+    if (view)
+    {
+        t = view;
+        ar >> t.dtype;
+        return;
+    }
+
+    //load into the memory of the provided buffer when large enough
+    if (not t or t.length < size_t(length)) t = Pothos::BufferChunk(size_t(length));
+    else t.length = size_t(length);
+
+    const auto data = t.as<char *>();
+    for (size_t offset = 0; offset < t.length; offset += bufferChunkStreamBytes)
+    {
+        Pothos::serialization::BinaryObject bo(data+offset, std::min(t.length-offset, bufferChunkStreamBytes));
+        ar >> bo;
+    }
     ar >> t.dtype;
 }
 }}
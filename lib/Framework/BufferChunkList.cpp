@@ -0,0 +1,36 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework/BufferChunkList.hpp>
+#include <cstring> //memcpy
+
+Pothos::BufferChunk Pothos::BufferChunkList::flatten(void) const
+{
+    if (_chunks.empty()) return Pothos::BufferChunk();
+    if (_chunks.size() == 1) return _chunks.front();
+
+    Pothos::BufferChunk flat(_length);
+    flat.dtype = _chunks.front().dtype;
+    size_t offset = 0;
+    for (const auto &chunk : _chunks)
+    {
+        std::memcpy(flat.as<char *>()+offset, chunk.as<const void *>(), chunk.length);
+        offset += chunk.length;
+    }
+    return flat;
+}
+
+#include <Pothos/Managed.hpp>
+
+static auto managedBufferChunkList = Pothos::ManagedClass()
+    .registerConstructor<Pothos::BufferChunkList>()
+    .registerConstructor<Pothos::BufferChunkList, const Pothos::BufferChunk &>()
+    .registerMethod<void, Pothos::BufferChunkList, const Pothos::BufferChunk &>(POTHOS_FCN_TUPLE(Pothos::BufferChunkList, append))
+    .registerMethod<void, Pothos::BufferChunkList, const Pothos::BufferChunkList &>(POTHOS_FCN_TUPLE(Pothos::BufferChunkList, append))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::BufferChunkList, clear))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::BufferChunkList, empty))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::BufferChunkList, size))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::BufferChunkList, length))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::BufferChunkList, chunks))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::BufferChunkList, flatten))
+    .commit("Pothos/BufferChunkList");
@@ -1,12 +1,17 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/BufferChunk.hpp>
+#include <Pothos/Framework/BufferConvert.hpp>
 #include <Pothos/Framework/Exception.hpp>
-#include <functional>
+#include "Framework/BufferConvertSIMD.hpp"
 #include <complex>
 #include <cstdint>
-#include <map>
+#include <limits>
+#include <type_traits>
+#include <array>
+#include <cassert>
+#include <cstring> //memmove
 
 /***********************************************************************
  * templated conversions
@@ -36,7 +41,7 @@ void rawConvertComplex(const void *in, void *out, const size_t num)
 }
 
 template <typename InType, typename OutType>
-void rawConvertComponents(const void *in, void *outRe, void *outIm, size_t num)
+void rawConvertComponents(const void *in, void *outRe, void *outIm, const size_t num)
 {
     auto inElems = reinterpret_cast<const std::complex<InType> *>(in);
     auto outElemsRe = reinterpret_cast<OutType *>(outRe);
@@ -48,26 +53,277 @@ void rawConvertComponents(const void *in, void *outRe, void *outIm, size_t num)
     }
 }
 
+template <typename InType, typename OutType>
+void rawConvertInterleave(const void *inRe, const void *inIm, void *out, const size_t num)
+{
+    auto inElemsRe = reinterpret_cast<const InType *>(inRe);
+    auto inElemsIm = reinterpret_cast<const InType *>(inIm);
+    auto outElems = reinterpret_cast<std::complex<OutType> *>(out);
+    for (size_t i = 0; i < num; i++) outElems[i] = std::complex<OutType>(OutType(inElemsRe[i]), OutType(inElemsIm[i]));
+}
+
+//reverse the bytes of each primitive, the temporary copy supports in-place swaps
+template <size_t Width>
+void rawByteswap(const void *in, void *out, const size_t num)
+{
+    auto inBytes = reinterpret_cast<const char *>(in);
+    auto outBytes = reinterpret_cast<char *>(out);
+    for (size_t i = 0; i < num; i++)
+    {
+        char tmp[Width];
+        for (size_t j = 0; j < Width; j++) tmp[j] = inBytes[i*Width+Width-1-j];
+        for (size_t j = 0; j < Width; j++) outBytes[i*Width+j] = tmp[j];
+    }
+}
+
 /***********************************************************************
- * bound conversions
+ * templated scaled conversions
  **********************************************************************/
-static int dtypeIOToHash(const Pothos::DType &in, const Pothos::DType &out)
+//scaling is computed in float when float represents both types exactly
+template <typename Type>
+struct IsExactInFloat
+{
+    static const bool value = sizeof(Type) <= 2 or std::is_same<Type, float>::value;
+};
+
+template <typename InType, typename OutType>
+struct ScaleType
+{
+    typedef typename std::conditional<
+        IsExactInFloat<InType>::value and IsExactInFloat<OutType>::value,
+        float, double>::type type;
+};
+
+//clamp to the range of integer outputs, floating point outputs are unbounded
+template <typename OutType, typename Type>
+typename std::enable_if<std::is_integral<OutType>::value, OutType>::type saturateCast(const Type x)
+{
+    if (x >= Type(std::numeric_limits<OutType>::max())) return std::numeric_limits<OutType>::max();
+    if (x <= Type(std::numeric_limits<OutType>::min())) return std::numeric_limits<OutType>::min();
+    if (x != x) return OutType(0); //NaN
+    return OutType(x);
+}
+
+template <typename OutType, typename Type>
+typename std::enable_if<not std::is_integral<OutType>::value, OutType>::type saturateCast(const Type x)
+{
+    return OutType(x);
+}
+
+template <typename InType, typename OutType>
+void rawConvertScaled(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    typedef typename ScaleType<InType, OutType>::type Type;
+    auto inElems = reinterpret_cast<const InType *>(in);
+    auto outElems = reinterpret_cast<OutType *>(out);
+    const Type s(scale);
+    if (saturate) for (size_t i = 0; i < num; i++) outElems[i] = saturateCast<OutType>(Type(inElems[i])*s);
+    else for (size_t i = 0; i < num; i++) outElems[i] = OutType(Type(inElems[i])*s);
+}
+
+template <typename InType, typename OutType>
+void rawConvertScaledRealToComplex(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    typedef typename ScaleType<InType, OutType>::type Type;
+    auto inElems = reinterpret_cast<const InType *>(in);
+    auto outElems = reinterpret_cast<std::complex<OutType> *>(out);
+    const Type s(scale);
+    if (saturate) for (size_t i = 0; i < num; i++) outElems[i] = std::complex<OutType>(saturateCast<OutType>(Type(inElems[i])*s));
+    else for (size_t i = 0; i < num; i++) outElems[i] = std::complex<OutType>(OutType(Type(inElems[i])*s));
+}
+
+template <typename InType, typename OutType>
+void rawConvertScaledComplex(const void *in, void *out, const size_t num, const double scale, const bool saturate)
 {
-    return in.elemType() | (out.elemType() << 16); //safe assumption, elem type uses only first few bits
+    //complex elements are scaled component-wise: treat as twice the primitives
+    rawConvertScaled<InType, OutType>(in, out, num*2, scale, saturate);
 }
 
+/***********************************************************************
+ * packed sample conversions (layouts documented in DType.hpp)
+ **********************************************************************/
+struct PackedSC12
+{
+    static const char *name(void){return "complex_int12";}
+    static const size_t bytes = 3;
+    static const int maxValue = 2047;
+
+    static void unpack(const unsigned char *p, int &re, int &im)
+    {
+        const uint32_t word = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+        re = int32_t(word << 20) >> 20;
+        im = int32_t(word << 8) >> 20;
+    }
+
+    static void pack(unsigned char *p, const int re, const int im)
+    {
+        const uint32_t word = (uint32_t(re) & 0xfff) | ((uint32_t(im) & 0xfff) << 12);
+        p[0] = (unsigned char)(word);
+        p[1] = (unsigned char)(word >> 8);
+        p[2] = (unsigned char)(word >> 16);
+    }
+};
+
+struct PackedSC4
+{
+    static const char *name(void){return "complex_int4";}
+    static const size_t bytes = 1;
+    static const int maxValue = 7;
+
+    static void unpack(const unsigned char *p, int &re, int &im)
+    {
+        re = int32_t(uint32_t(p[0]) << 28) >> 28;
+        im = int32_t(uint32_t(p[0]) << 24) >> 28;
+    }
+
+    static void pack(unsigned char *p, const int re, const int im)
+    {
+        p[0] = (unsigned char)((uint32_t(re) & 0xf) | ((uint32_t(im) & 0xf) << 4));
+    }
+};
+
+template <typename Packed, typename OutType>
+void rawConvertFromPacked(const void *in, void *out, const size_t num)
+{
+    auto inBytes = reinterpret_cast<const unsigned char *>(in);
+    auto outElems = reinterpret_cast<std::complex<OutType> *>(out);
+    int re, im;
+    for (size_t i = 0; i < num; i++)
+    {
+        Packed::unpack(inBytes+i*Packed::bytes, re, im);
+        outElems[i] = std::complex<OutType>(OutType(re), OutType(im));
+    }
+}
+
+template <typename InType, typename Packed>
+void rawConvertToPacked(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const std::complex<InType> *>(in);
+    auto outBytes = reinterpret_cast<unsigned char *>(out);
+    for (size_t i = 0; i < num; i++)
+    {
+        Packed::pack(outBytes+i*Packed::bytes, int(inElems[i].real()), int(inElems[i].imag()));
+    }
+}
+
+template <typename Packed, typename OutType>
+void rawConvertScaledFromPacked(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    typedef typename ScaleType<int16_t, OutType>::type Type;
+    auto inBytes = reinterpret_cast<const unsigned char *>(in);
+    auto outElems = reinterpret_cast<std::complex<OutType> *>(out);
+    const Type s(scale);
+    int re, im;
+    for (size_t i = 0; i < num; i++)
+    {
+        Packed::unpack(inBytes+i*Packed::bytes, re, im);
+        if (saturate) outElems[i] = std::complex<OutType>(saturateCast<OutType>(Type(re)*s), saturateCast<OutType>(Type(im)*s));
+        else outElems[i] = std::complex<OutType>(OutType(Type(re)*s), OutType(Type(im)*s));
+    }
+}
+
+//clamp to the range of the packed integers
+template <typename Packed, typename Type>
+int saturatePacked(const Type x)
+{
+    if (x >= Type(Packed::maxValue)) return Packed::maxValue;
+    if (x <= Type(-Packed::maxValue-1)) return -Packed::maxValue-1;
+    if (x != x) return 0; //NaN
+    return int(x);
+}
+
+template <typename InType, typename Packed>
+void rawConvertScaledToPacked(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    typedef typename ScaleType<InType, int16_t>::type Type;
+    auto inElems = reinterpret_cast<const std::complex<InType> *>(in);
+    auto outBytes = reinterpret_cast<unsigned char *>(out);
+    const Type s(scale);
+    for (size_t i = 0; i < num; i++)
+    {
+        const Type re(Type(inElems[i].real())*s), im(Type(inElems[i].imag())*s);
+        if (saturate) Packed::pack(outBytes+i*Packed::bytes, saturatePacked<Packed>(re), saturatePacked<Packed>(im));
+        else Packed::pack(outBytes+i*Packed::bytes, int(re), int(im));
+    }
+}
+
+/***********************************************************************
+ * bound conversions
+ **********************************************************************/
+//the number of supported element types (real and complex) plus the invalid index 0
+static const size_t MaxConvertTypes = 32;
+
 class BufferConvertImpl
 {
 public:
-    BufferConvertImpl(void)
+    BufferConvertImpl(void):
+        _numTypes(1) //index 0 is reserved for unsupported types
     {
+        _typeIndex.fill(0);
+        for (auto &row : _convertTable) row.fill(nullptr);
+        for (auto &row : _convertComplexTable) row.fill(nullptr);
+        for (auto &row : _convertScaledTable) row.fill(nullptr);
+        for (auto &row : _convertInterleaveTable) row.fill(nullptr);
+        for (auto &row : _convertFromBigEndianTable) row.fill(nullptr);
+        _byteswap.fill(nullptr);
         this->registerConverters();
     }
 
-    std::map<int, std::function<void(const void *, void *, const size_t)>> convertMap;
-    std::map<int, std::function<void(const void *, void *, void *, const size_t)>> convertComplexMap;
+    //constant time lookups indexed by the element types
+    BufferConvertFcn lookupConvert(const Pothos::DType &in, const Pothos::DType &out) const
+    {
+        return _convertTable[_typeIndex[in.elemType()]][_typeIndex[out.elemType()]];
+    }
+
+    BufferConvertComponentsFcn lookupConvertComplex(const Pothos::DType &in, const Pothos::DType &out) const
+    {
+        return _convertComplexTable[_typeIndex[in.elemType()]][_typeIndex[out.elemType()]];
+    }
+
+    BufferConvertScaledFcn lookupConvertScaled(const Pothos::DType &in, const Pothos::DType &out) const
+    {
+        return _convertScaledTable[_typeIndex[in.elemType()]][_typeIndex[out.elemType()]];
+    }
+
+    BufferConvertInterleaveFcn lookupConvertInterleave(const Pothos::DType &in, const Pothos::DType &out) const
+    {
+        return _convertInterleaveTable[_typeIndex[in.elemType()]][_typeIndex[out.elemType()]];
+    }
+
+    //only the vectorized kernels fuse the byte swap, nullptr otherwise
+    BufferConvertFcn lookupConvertFromBigEndian(const Pothos::DType &in, const Pothos::DType &out) const
+    {
+        return _convertFromBigEndianTable[_typeIndex[in.elemType()]][_typeIndex[out.elemType()]];
+    }
+
+    BufferConvertFcn lookupByteswap(const size_t width) const
+    {
+        return (width < _byteswap.size())?_byteswap[width]:nullptr;
+    }
 
 private:
+    //map the sparse element type enum into a dense table index
+    std::array<unsigned char, 256> _typeIndex;
+    size_t _numTypes;
+
+    std::array<std::array<BufferConvertFcn, MaxConvertTypes>, MaxConvertTypes> _convertTable;
+    std::array<std::array<BufferConvertComponentsFcn, MaxConvertTypes>, MaxConvertTypes> _convertComplexTable;
+    std::array<std::array<BufferConvertScaledFcn, MaxConvertTypes>, MaxConvertTypes> _convertScaledTable;
+    std::array<std::array<BufferConvertInterleaveFcn, MaxConvertTypes>, MaxConvertTypes> _convertInterleaveTable;
+    std::array<std::array<BufferConvertFcn, MaxConvertTypes>, MaxConvertTypes> _convertFromBigEndianTable;
+    std::array<BufferConvertFcn, 9> _byteswap; //indexed by the primitive width
+
+    size_t indexOf(const Pothos::DType &dtype)
+    {
+        auto &index = _typeIndex[dtype.elemType()];
+        if (index == 0)
+        {
+            assert(_numTypes < MaxConvertTypes);
+            index = static_cast<unsigned char>(_numTypes++);
+        }
+        return index;
+    }
+
     void registerConverters(void)
     {
         this->registerConverter<int8_t>();
@@ -80,6 +336,42 @@ private:
         this->registerConverter<uint64_t>();
         this->registerConverter<float>();
         this->registerConverter<double>();
+        this->registerPackedConverter<PackedSC12>();
+        this->registerPackedConverter<PackedSC4>();
+
+        const auto simd2 = getSimdBufferByteswap(2);
+        const auto simd4 = getSimdBufferByteswap(4);
+        const auto simd8 = getSimdBufferByteswap(8);
+        _byteswap[2] = (simd2 != nullptr)?simd2:&rawByteswap<2>;
+        _byteswap[4] = (simd4 != nullptr)?simd4:&rawByteswap<4>;
+        _byteswap[8] = (simd8 != nullptr)?simd8:&rawByteswap<8>;
+    }
+
+    template <typename Packed>
+    void registerPackedConverter(void)
+    {
+        this->registerPackedConverter<Packed, int8_t>();
+        this->registerPackedConverter<Packed, uint8_t>();
+        this->registerPackedConverter<Packed, int16_t>();
+        this->registerPackedConverter<Packed, uint16_t>();
+        this->registerPackedConverter<Packed, int32_t>();
+        this->registerPackedConverter<Packed, uint32_t>();
+        this->registerPackedConverter<Packed, int64_t>();
+        this->registerPackedConverter<Packed, uint64_t>();
+        this->registerPackedConverter<Packed, float>();
+        this->registerPackedConverter<Packed, double>();
+    }
+
+    //packed samples convert to and from the complex types only
+    template <typename Packed, typename Type>
+    void registerPackedConverter(void)
+    {
+        const Pothos::DType packed(Packed::name());
+        const auto complexType = Pothos::DType::of<std::complex<Type>>();
+        this->registerConverter(packed, complexType, BufferConvertFcn(&rawConvertFromPacked<Packed, Type>));
+        this->registerConverter(complexType, packed, BufferConvertFcn(&rawConvertToPacked<Type, Packed>));
+        this->registerConverter(packed, complexType, BufferConvertScaledFcn(&rawConvertScaledFromPacked<Packed, Type>));
+        this->registerConverter(complexType, packed, BufferConvertScaledFcn(&rawConvertScaledToPacked<Type, Packed>));
     }
 
     template <typename InType>
@@ -100,19 +392,70 @@ private:
     template <typename InType, typename OutType>
     void registerConverter(void)
     {
-        int h = 0;
+        this->registerConverter(
+            Pothos::DType::of<InType>(), Pothos::DType::of<OutType>(),
+            &rawConvert<InType, OutType>);
+
+        this->registerConverter(
+            Pothos::DType::of<InType>(), Pothos::DType::of<std::complex<OutType>>(),
+            &rawConvertRealToComplex<InType, OutType>);
+
+        this->registerConverter(
+            Pothos::DType::of<std::complex<InType>>(), Pothos::DType::of<std::complex<OutType>>(),
+            &rawConvertComplex<InType, OutType>);
+
+        this->registerConverter(
+            Pothos::DType::of<std::complex<InType>>(), Pothos::DType::of<OutType>(),
+            &rawConvertComponents<InType, OutType>);
+
+        this->registerConverter(
+            Pothos::DType::of<InType>(), Pothos::DType::of<std::complex<OutType>>(),
+            &rawConvertInterleave<InType, OutType>);
+
+        this->registerConverter(
+            Pothos::DType::of<InType>(), Pothos::DType::of<OutType>(),
+            &rawConvertScaled<InType, OutType>);
+
+        this->registerConverter(
+            Pothos::DType::of<InType>(), Pothos::DType::of<std::complex<OutType>>(),
+            &rawConvertScaledRealToComplex<InType, OutType>);
+
+        this->registerConverter(
+            Pothos::DType::of<std::complex<InType>>(), Pothos::DType::of<std::complex<OutType>>(),
+            &rawConvertScaledComplex<InType, OutType>);
+
+        this->registerFromBigEndian(Pothos::DType::of<InType>(), Pothos::DType::of<OutType>());
+        this->registerFromBigEndian(Pothos::DType::of<std::complex<InType>>(), Pothos::DType::of<std::complex<OutType>>());
+    }
+
+    //register the conversion, preferring a vectorized kernel when the CPU supports one
+    void registerConverter(const Pothos::DType &in, const Pothos::DType &out, BufferConvertFcn fcn)
+    {
+        const auto simdFcn = getSimdBufferConvert(in, out);
+        _convertTable[this->indexOf(in)][this->indexOf(out)] = (simdFcn != nullptr)?simdFcn:fcn;
+    }
 
-        h = dtypeIOToHash(Pothos::DType(typeid(InType)), Pothos::DType(typeid(OutType)));
-        convertMap[h] = std::bind(&rawConvert<InType, OutType>, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+    void registerConverter(const Pothos::DType &in, const Pothos::DType &out, BufferConvertComponentsFcn fcn)
+    {
+        const auto simdFcn = getSimdBufferConvertComponents(in, out);
+        _convertComplexTable[this->indexOf(in)][this->indexOf(out)] = (simdFcn != nullptr)?simdFcn:fcn;
+    }
 
-        h = dtypeIOToHash(Pothos::DType(typeid(InType)), Pothos::DType(typeid(std::complex<OutType>)));
-        convertMap[h] = std::bind(&rawConvertRealToComplex<InType, OutType>, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+    void registerConverter(const Pothos::DType &in, const Pothos::DType &out, BufferConvertScaledFcn fcn)
+    {
+        const auto simdFcn = getSimdBufferConvertScaled(in, out);
+        _convertScaledTable[this->indexOf(in)][this->indexOf(out)] = (simdFcn != nullptr)?simdFcn:fcn;
+    }
 
-        h = dtypeIOToHash(Pothos::DType(typeid(std::complex<InType>)), Pothos::DType(typeid(std::complex<OutType>)));
-        convertMap[h] = std::bind(&rawConvertComplex<InType, OutType>, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+    void registerConverter(const Pothos::DType &in, const Pothos::DType &out, BufferConvertInterleaveFcn fcn)
+    {
+        const auto simdFcn = getSimdBufferConvertInterleave(in, out);
+        _convertInterleaveTable[this->indexOf(in)][this->indexOf(out)] = (simdFcn != nullptr)?simdFcn:fcn;
+    }
 
-        h = dtypeIOToHash(Pothos::DType(typeid(std::complex<InType>)), Pothos::DType(typeid(OutType)));
-        convertComplexMap[h] = std::bind(&rawConvertComponents<InType, OutType>, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+    void registerFromBigEndian(const Pothos::DType &in, const Pothos::DType &out)
+    {
+        _convertFromBigEndianTable[this->indexOf(in)][this->indexOf(out)] = getSimdBufferConvertFromBigEndian(in, out);
     }
 };
 
@@ -144,12 +487,12 @@ Pothos::BufferChunk Pothos::BufferChunk::convert(const DType &outDType, const si
         return out;
     }
 
-    auto it = getBufferConvertImpl().convertMap.find(dtypeIOToHash(this->dtype, outDType));
-    if (it == getBufferConvertImpl().convertMap.end()) throw Pothos::BufferConvertError(
+    const auto fcn = getBufferConvertImpl().lookupConvert(this->dtype, outDType);
+    if (fcn == nullptr) throw Pothos::BufferConvertError(
         "Pothos::BufferChunk::convert("+dtype.toString()+")", "cant convert from " + this->dtype.toString());
     Pothos::BufferChunk out(outDType, outElems);
 
-    it->second(this->as<const void *>(), out.as<void *>(), primElems);
+    fcn(this->as<const void *>(), out.as<void *>(), primElems);
     return out;
 }
 
@@ -159,13 +502,13 @@ std::pair<Pothos::BufferChunk, Pothos::BufferChunk> Pothos::BufferChunk::convert
     const auto primElems = (numElems*this->dtype.size())/this->dtype.elemSize();
     const auto outElems = primElems*outDType.size()/outDType.elemSize();
 
-    auto it = getBufferConvertImpl().convertComplexMap.find(dtypeIOToHash(this->dtype, outDType));
-    if (it == getBufferConvertImpl().convertComplexMap.end()) throw Pothos::BufferConvertError(
+    const auto fcn = getBufferConvertImpl().lookupConvertComplex(this->dtype, outDType);
+    if (fcn == nullptr) throw Pothos::BufferConvertError(
         "Pothos::BufferChunk::convertComplex("+dtype.toString()+")", "cant convert from " + this->dtype.toString());
     Pothos::BufferChunk outRe(outDType, outElems);
     Pothos::BufferChunk outIm(outDType, outElems);
 
-    it->second(this->as<const void *>(), outRe.as<void *>(), outIm.as<void *>(), primElems);
+    fcn(this->as<const void *>(), outRe.as<void *>(), outIm.as<void *>(), primElems);
     return std::make_pair(outRe, outIm);
 }
 
@@ -178,11 +521,39 @@ size_t Pothos::BufferChunk::convert(const BufferChunk &out, const size_t numElem
     if (out.elements() < outElems) throw Pothos::BufferConvertError(
         "Pothos::BufferChunk::convert(buffer)", "insufficient input buffer");
 
-    auto it = getBufferConvertImpl().convertMap.find(dtypeIOToHash(this->dtype, out.dtype));
-    if (it == getBufferConvertImpl().convertMap.end()) throw Pothos::BufferConvertError(
+    const auto fcn = getBufferConvertImpl().lookupConvert(this->dtype, out.dtype);
+    if (fcn == nullptr) throw Pothos::BufferConvertError(
         "Pothos::BufferChunk::convert("+dtype.toString()+")", "cant convert from " + this->dtype.toString());
 
-    it->second(this->as<const void *>(), out.as<void *>(), primElems);
+    fcn(this->as<const void *>(), out.as<void *>(), primElems);
+    return outElems;
+}
+
+Pothos::BufferChunk Pothos::BufferChunk::convert(const DType &outDType, const double scale, const bool saturate, const size_t numElems_) const
+{
+    const size_t numElems = (numElems_ == 0)? this->elements() : numElems_;
+    const auto primElems = (numElems*this->dtype.size())/this->dtype.elemSize();
+    const auto outElems = primElems*outDType.size()/outDType.elemSize();
+
+    Pothos::BufferChunk out(outDType, outElems);
+    this->convert(out, scale, saturate, numElems);
+    return out;
+}
+
+size_t Pothos::BufferChunk::convert(const BufferChunk &out, const double scale, const bool saturate, const size_t numElems_) const
+{
+    const size_t numElems = (numElems_ == 0)? this->elements() : numElems_;
+    const auto primElems = (numElems*this->dtype.size())/this->dtype.elemSize();
+    const auto outElems = primElems*out.dtype.size()/out.dtype.elemSize();
+
+    if (out.elements() < outElems) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::convert(buffer, scale)", "insufficient input buffer");
+
+    const auto fcn = getBufferConvertImpl().lookupConvertScaled(this->dtype, out.dtype);
+    if (fcn == nullptr) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::convert("+dtype.toString()+", scale)", "cant convert from " + this->dtype.toString());
+
+    fcn(this->as<const void *>(), out.as<void *>(), primElems, scale, saturate);
     return outElems;
 }
 
@@ -199,10 +570,139 @@ size_t Pothos::BufferChunk::convertComplex(const BufferChunk &outRe, const Buffe
     if (outIm.elements() < outElems) throw Pothos::BufferConvertError(
         "Pothos::BufferChunk::convertComplex(bufferRe, bufferIm)", "insufficient input bufferIm");
 
-    auto it = getBufferConvertImpl().convertComplexMap.find(dtypeIOToHash(this->dtype, outRe.dtype));
-    if (it == getBufferConvertImpl().convertComplexMap.end()) throw Pothos::BufferConvertError(
+    const auto fcn = getBufferConvertImpl().lookupConvertComplex(this->dtype, outRe.dtype);
+    if (fcn == nullptr) throw Pothos::BufferConvertError(
         "Pothos::BufferChunk::convertComplex("+dtype.toString()+")", "cant convert from " + this->dtype.toString());
 
-    it->second(this->as<const void *>(), outRe.as<void *>(), outIm.as<void *>(), primElems);
+    fcn(this->as<const void *>(), outRe.as<void *>(), outIm.as<void *>(), primElems);
     return outElems;
 }
+
+/***********************************************************************
+ * interleave and byte swap implementation
+ **********************************************************************/
+static bool isHostBigEndian(void)
+{
+    const uint16_t word(1);
+    return *reinterpret_cast<const unsigned char *>(&word) == 0;
+}
+
+//the size of the primitives that are swapped: complex elements swap each component
+static size_t byteswapWidth(const Pothos::DType &dtype)
+{
+    return dtype.isComplex()?(dtype.elemSize()/2):dtype.elemSize();
+}
+
+Pothos::BufferChunk Pothos::BufferChunk::interleave(const BufferChunk &inRe, const BufferChunk &inIm, const DType &outDType, const size_t numElems_)
+{
+    const size_t numElems = (numElems_ == 0)? inRe.elements() : numElems_;
+    const auto primElems = (numElems*inRe.dtype.size())/inRe.dtype.elemSize();
+    const auto outElems = primElems*outDType.size()/outDType.elemSize();
+
+    Pothos::BufferChunk out(outDType, outElems);
+    interleave(inRe, inIm, out, numElems);
+    return out;
+}
+
+size_t Pothos::BufferChunk::interleave(const BufferChunk &inRe, const BufferChunk &inIm, const BufferChunk &out, const size_t numElems_)
+{
+    const size_t numElems = (numElems_ == 0)? inRe.elements() : numElems_;
+    const auto primElems = (numElems*inRe.dtype.size())/inRe.dtype.elemSize();
+    const auto outElems = primElems*out.dtype.size()/out.dtype.elemSize();
+
+    if (not (inRe.dtype == inIm.dtype)) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::interleave(bufferRe, bufferIm)", "buffer DType mismatch");
+    if (inRe.elements() < numElems) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::interleave(bufferRe, bufferIm)", "insufficient input bufferRe");
+    if (inIm.elements() < numElems) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::interleave(bufferRe, bufferIm)", "insufficient input bufferIm");
+    if (out.elements() < outElems) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::interleave(bufferRe, bufferIm)", "insufficient output buffer");
+
+    const auto fcn = getBufferConvertImpl().lookupConvertInterleave(inRe.dtype, out.dtype);
+    if (fcn == nullptr) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::interleave("+out.dtype.toString()+")", "cant convert from " + inRe.dtype.toString());
+
+    fcn(inRe.as<const void *>(), inIm.as<const void *>(), out.as<void *>(), primElems);
+    return outElems;
+}
+
+Pothos::BufferChunk Pothos::BufferChunk::byteswap(const size_t numElems_) const
+{
+    const size_t numElems = (numElems_ == 0)? this->elements() : numElems_;
+    Pothos::BufferChunk out(this->dtype, numElems);
+    this->byteswap(out, numElems);
+    return out;
+}
+
+size_t Pothos::BufferChunk::byteswap(const BufferChunk &out, const size_t numElems_) const
+{
+    const size_t numElems = (numElems_ == 0)? this->elements() : numElems_;
+    const auto numBytes = numElems*this->dtype.size();
+    const auto width = byteswapWidth(this->dtype);
+
+    if (not (out.dtype == this->dtype)) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::byteswap(buffer)", "buffer DType mismatch");
+    if (this->dtype.isPacked()) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::byteswap(buffer)", "cant swap packed " + this->dtype.toString());
+    if (out.length < numBytes) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::byteswap(buffer)", "insufficient output buffer");
+
+    //single byte elements have nothing to swap
+    if (width == 1)
+    {
+        if (out.address != this->address) std::memmove(out.as<void *>(), this->as<const void *>(), numBytes);
+        return numElems;
+    }
+
+    const auto fcn = getBufferConvertImpl().lookupByteswap(width);
+    if (fcn == nullptr) throw Pothos::BufferConvertError(
+        "Pothos::BufferChunk::byteswap()", "cant swap " + this->dtype.toString());
+
+    fcn(this->as<const void *>(), out.as<void *>(), numBytes/width);
+    return numElems;
+}
+
+Pothos::BufferChunk Pothos::BufferChunk::convertFromBigEndian(const DType &outDType, const size_t numElems_) const
+{
+    if (isHostBigEndian()) return this->convert(outDType, numElems_);
+
+    const size_t numElems = (numElems_ == 0)? this->elements() : numElems_;
+    const auto primElems = (numElems*this->dtype.size())/this->dtype.elemSize();
+    const auto outElems = primElems*outDType.size()/outDType.elemSize();
+
+    //one vectorized pass when a fused kernel exists, otherwise swap then convert
+    const auto fcn = getBufferConvertImpl().lookupConvertFromBigEndian(this->dtype, outDType);
+    if (fcn == nullptr) return this->byteswap(numElems).convert(outDType);
+    Pothos::BufferChunk out(outDType, outElems);
+
+    fcn(this->as<const void *>(), out.as<void *>(), primElems);
+    return out;
+}
+
+/***********************************************************************
+ * pre-resolved kernels
+ **********************************************************************/
+Pothos::BufferConvert::Kernel::Kernel(void):
+    _fcn(nullptr),
+    _primsPerElem(0)
+{
+    return;
+}
+
+Pothos::BufferConvert::Kernel::Kernel(const Function fcn, const DType &inDType, const DType &outDType):
+    _fcn(fcn),
+    _primsPerElem(inDType.size()/inDType.elemSize()),
+    _inDType(inDType),
+    _outDType(outDType)
+{
+    return;
+}
+
+Pothos::BufferConvert::Kernel Pothos::BufferConvert::getKernel(const DType &inDType, const DType &outDType)
+{
+    const auto fcn = getBufferConvertImpl().lookupConvert(inDType, outDType);
+    if (fcn == nullptr) throw Pothos::BufferConvertError(
+        "Pothos::BufferConvert::getKernel("+inDType.toString()+", "+outDType.toString()+")", "cant convert");
+    return Kernel(fcn, inDType, outDType);
+}
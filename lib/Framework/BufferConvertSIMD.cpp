@@ -0,0 +1,1355 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Framework/BufferConvertSIMD.hpp"
+#include <complex>
+#include <cstdint>
+#include <cmath> //nearbyint
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define POTHOS_CONVERT_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define POTHOS_CONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+//per-function instruction set targets so the library
+//does not need to be compiled with global arch flags
+#if defined(__GNUC__)
+#define POTHOS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define POTHOS_TARGET(isa)
+#endif
+
+/***********************************************************************
+ * The set of vectorized kernels for a particular instruction set
+ **********************************************************************/
+struct SimdKernels
+{
+    BufferConvertFcn s8ToF32;
+    BufferConvertFcn s16ToF32;
+    BufferConvertFcn s32ToF32;
+    BufferConvertFcn f32ToS16;
+    BufferConvertFcn cs8ToCF32;
+    BufferConvertFcn cs16ToCF32;
+    BufferConvertFcn cs32ToCF32;
+    BufferConvertFcn cf32ToCS16;
+    BufferConvertComponentsFcn cs16ToF32Components;
+    BufferConvertComponentsFcn cf32ToF32Components;
+    BufferConvertScaledFcn s8ToF32Scaled;
+    BufferConvertScaledFcn s16ToF32Scaled;
+    BufferConvertScaledFcn f32ToS16Scaled;
+    BufferConvertScaledFcn cs8ToCF32Scaled;
+    BufferConvertScaledFcn cs16ToCF32Scaled;
+    BufferConvertScaledFcn cf32ToCS16Scaled;
+    BufferConvertScaledFcn f32ToS16Round;
+    BufferConvertScaledFcn f32ToS32Round;
+    BufferConvertInterleaveFcn f32ToCF32Interleave;
+    BufferConvertInterleaveFcn s16ToCS16Interleave;
+    BufferConvertFcn byteswap16;
+    BufferConvertFcn byteswap32;
+    BufferConvertFcn byteswap64;
+    BufferConvertFcn bs16ToF32;
+    BufferConvertFcn cbs16ToCF32;
+};
+
+//packed sample kernels, only for instruction sets with byte shuffles
+struct SimdPackedKernels
+{
+    BufferConvertFcn sc12ToCS16;
+    BufferConvertFcn sc12ToCF32;
+    BufferConvertFcn cs16ToSC12;
+};
+
+#define POTHOS_SIMD_PACKED_KERNELS(suffix) { \
+    &convertSC12ToCS16 ## suffix, \
+    &convertSC12ToCF32 ## suffix, \
+    &convertCS16ToSC12 ## suffix}
+
+//complex to complex is the real kernel over twice the primitives
+template <BufferConvertFcn fcn>
+static void convertComplexOf(const void *in, void *out, const size_t num)
+{
+    fcn(in, out, num*2);
+}
+
+template <BufferConvertScaledFcn fcn>
+static void convertComplexScaledOf(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    fcn(in, out, num*2, scale, saturate);
+}
+
+#define POTHOS_SIMD_KERNELS(suffix) { \
+    &convertS8ToF32 ## suffix, \
+    &convertS16ToF32 ## suffix, \
+    &convertS32ToF32 ## suffix, \
+    &convertF32ToS16 ## suffix, \
+    &convertComplexOf<&convertS8ToF32 ## suffix>, \
+    &convertComplexOf<&convertS16ToF32 ## suffix>, \
+    &convertComplexOf<&convertS32ToF32 ## suffix>, \
+    &convertComplexOf<&convertF32ToS16 ## suffix>, \
+    &convertCS16ToF32Components ## suffix, \
+    &convertCF32ToF32Components ## suffix, \
+    &convertS8ToF32Scaled ## suffix, \
+    &convertS16ToF32Scaled ## suffix, \
+    &convertF32ToS16Scaled ## suffix, \
+    &convertComplexScaledOf<&convertS8ToF32Scaled ## suffix>, \
+    &convertComplexScaledOf<&convertS16ToF32Scaled ## suffix>, \
+    &convertComplexScaledOf<&convertF32ToS16Scaled ## suffix>, \
+    &convertF32ToS16Round ## suffix, \
+    &convertF32ToS32Round ## suffix, \
+    &interleaveF32ToCF32 ## suffix, \
+    &interleaveS16ToCS16 ## suffix, \
+    &byteswap ## suffix<2>, \
+    &byteswap ## suffix<4>, \
+    &byteswap ## suffix<8>, \
+    &convertBS16ToF32 ## suffix, \
+    &convertComplexOf<&convertBS16ToF32 ## suffix>}
+
+/***********************************************************************
+ * scalar tails for the scaled kernels (match BufferConvert.cpp)
+ **********************************************************************/
+template <typename InType>
+static inline void convertToF32ScaledTail(const InType *in, float *out, size_t i, const size_t num, const float scale)
+{
+    for (; i < num; i++) out[i] = float(in[i])*scale;
+}
+
+static inline void convertF32ToS16ScaledTail(const float *in, int16_t *out, size_t i, const size_t num, const float scale, const bool saturate)
+{
+    for (; i < num; i++)
+    {
+        const float x = in[i]*scale;
+        if (not saturate) out[i] = int16_t(x);
+        else if (x >= 32767.0f) out[i] = 32767;
+        else if (x <= -32768.0f) out[i] = -32768;
+        else if (x != x) out[i] = 0; //NaN
+        else out[i] = int16_t(x);
+    }
+}
+
+//scalar tail for the rounding kernels: round to nearest, ties to even
+template <typename OutType>
+static inline void convertF32ToRoundTail(const float *in, OutType *out, size_t i, const size_t num, const float scale, const bool saturate)
+{
+    static const OutType minOut = std::numeric_limits<OutType>::min();
+    static const OutType maxOut = std::numeric_limits<OutType>::max();
+    for (; i < num; i++)
+    {
+        const float x = in[i]*scale;
+        if (not saturate) out[i] = OutType((long long)(std::nearbyint(x)));
+        else if (x >= float(maxOut)) out[i] = maxOut;
+        else if (x <= float(minOut)) out[i] = minOut;
+        else if (x != x) out[i] = 0; //NaN
+        else out[i] = OutType(std::nearbyint(x));
+    }
+}
+
+/***********************************************************************
+ * scalar tails for the interleave and byte swap kernels
+ **********************************************************************/
+template <typename Type>
+static inline void interleaveTail(const Type *inRe, const Type *inIm, std::complex<Type> *out, size_t i, const size_t num)
+{
+    for (; i < num; i++) out[i] = std::complex<Type>(inRe[i], inIm[i]);
+}
+
+//the temporary copy supports in-place swaps
+template <size_t Width>
+static inline void byteswapTail(const char *in, char *out, size_t i, const size_t num)
+{
+    for (; i < num; i++)
+    {
+        char tmp[Width];
+        for (size_t j = 0; j < Width; j++) tmp[j] = in[i*Width+Width-1-j];
+        for (size_t j = 0; j < Width; j++) out[i*Width+j] = tmp[j];
+    }
+}
+
+static inline void convertBS16ToF32Tail(const int16_t *in, float *out, size_t i, const size_t num)
+{
+    for (; i < num; i++)
+    {
+        const auto x = uint16_t(in[i]);
+        out[i] = float(int16_t(uint16_t((x << 8) | (x >> 8))));
+    }
+}
+
+//scalar tails for the packed kernels (match BufferConvert.cpp)
+template <typename OutType>
+static inline void unpackSC12Tail(const unsigned char *in, std::complex<OutType> *out, size_t i, const size_t num)
+{
+    for (; i < num; i++)
+    {
+        const unsigned char *p = in+i*3;
+        const uint32_t word = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+        out[i] = std::complex<OutType>(OutType(int32_t(word << 20) >> 20), OutType(int32_t(word << 8) >> 20));
+    }
+}
+
+static inline void packSC12Tail(const std::complex<int16_t> *in, unsigned char *out, size_t i, const size_t num)
+{
+    for (; i < num; i++)
+    {
+        const uint32_t word = (uint32_t(in[i].real()) & 0xfff) | ((uint32_t(in[i].imag()) & 0xfff) << 12);
+        out[i*3+0] = (unsigned char)(word);
+        out[i*3+1] = (unsigned char)(word >> 8);
+        out[i*3+2] = (unsigned char)(word >> 16);
+    }
+}
+
+#ifdef POTHOS_CONVERT_X86
+
+/***********************************************************************
+ * SSE2 kernels
+ **********************************************************************/
+POTHOS_TARGET("sse2")
+static inline void storeS16AsF32SSE2(float *out, const __m128i v16)
+{
+    _mm_storeu_ps(out+0, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v16, v16), 16)));
+    _mm_storeu_ps(out+4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v16, v16), 16)));
+}
+
+POTHOS_TARGET("sse2")
+static void convertS8ToF32SSE2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int8_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElems+i));
+        storeS16AsF32SSE2(outElems+i+0, _mm_srai_epi16(_mm_unpacklo_epi8(v8, v8), 8));
+        storeS16AsF32SSE2(outElems+i+8, _mm_srai_epi16(_mm_unpackhi_epi8(v8, v8), 8));
+    }
+    for (; i < num; i++) outElems[i] = float(inElems[i]);
+}
+
+POTHOS_TARGET("sse2")
+static void convertS16ToF32SSE2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int16_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        storeS16AsF32SSE2(outElems+i, _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElems+i)));
+    }
+    for (; i < num; i++) outElems[i] = float(inElems[i]);
+}
+
+POTHOS_TARGET("sse2")
+static void convertS32ToF32SSE2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int32_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+4 <= num; i += 4)
+    {
+        _mm_storeu_ps(outElems+i, _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(inElems+i))));
+    }
+    for (; i < num; i++) outElems[i] = float(inElems[i]);
+}
+
+POTHOS_TARGET("sse2")
+static void convertF32ToS16SSE2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int16_t *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const __m128i lo = _mm_cvttps_epi32(_mm_loadu_ps(inElems+i+0));
+        const __m128i hi = _mm_cvttps_epi32(_mm_loadu_ps(inElems+i+4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outElems+i), _mm_packs_epi32(lo, hi));
+    }
+    for (; i < num; i++) outElems[i] = int16_t(inElems[i]);
+}
+
+POTHOS_TARGET("sse2")
+static void convertCS16ToF32ComponentsSSE2(const void *in, void *outRe, void *outIm, const size_t num)
+{
+    auto inElems = reinterpret_cast<const std::complex<int16_t> *>(in);
+    auto outElemsRe = reinterpret_cast<float *>(outRe);
+    auto outElemsIm = reinterpret_cast<float *>(outIm);
+    size_t i = 0;
+    for (; i+4 <= num; i += 4)
+    {
+        //each 32-bit lane holds one complex sample: real in the low half
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElems+i));
+        _mm_storeu_ps(outElemsRe+i, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16)));
+        _mm_storeu_ps(outElemsIm+i, _mm_cvtepi32_ps(_mm_srai_epi32(v, 16)));
+    }
+    for (; i < num; i++)
+    {
+        outElemsRe[i] = float(inElems[i].real());
+        outElemsIm[i] = float(inElems[i].imag());
+    }
+}
+
+POTHOS_TARGET("sse2")
+static void convertCF32ToF32ComponentsSSE2(const void *in, void *outRe, void *outIm, const size_t num)
+{
+    auto inElems = reinterpret_cast<const std::complex<float> *>(in);
+    auto outElemsRe = reinterpret_cast<float *>(outRe);
+    auto outElemsIm = reinterpret_cast<float *>(outIm);
+    size_t i = 0;
+    for (; i+4 <= num; i += 4)
+    {
+        const __m128 a = _mm_loadu_ps(reinterpret_cast<const float *>(inElems+i+0));
+        const __m128 b = _mm_loadu_ps(reinterpret_cast<const float *>(inElems+i+2));
+        _mm_storeu_ps(outElemsRe+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(outElemsIm+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    for (; i < num; i++)
+    {
+        outElemsRe[i] = inElems[i].real();
+        outElemsIm[i] = inElems[i].imag();
+    }
+}
+
+POTHOS_TARGET("sse2")
+static inline void storeS16AsF32ScaledSSE2(float *out, const __m128i v16, const __m128 scale)
+{
+    _mm_storeu_ps(out+0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v16, v16), 16)), scale));
+    _mm_storeu_ps(out+4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v16, v16), 16)), scale));
+}
+
+POTHOS_TARGET("sse2")
+static void convertS8ToF32ScaledSSE2(const void *in, void *out, const size_t num, const double scale, const bool)
+{
+    auto inElems = reinterpret_cast<const int8_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    const __m128 s = _mm_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElems+i));
+        storeS16AsF32ScaledSSE2(outElems+i+0, _mm_srai_epi16(_mm_unpacklo_epi8(v8, v8), 8), s);
+        storeS16AsF32ScaledSSE2(outElems+i+8, _mm_srai_epi16(_mm_unpackhi_epi8(v8, v8), 8), s);
+    }
+    convertToF32ScaledTail(inElems, outElems, i, num, float(scale));
+}
+
+POTHOS_TARGET("sse2")
+static void convertS16ToF32ScaledSSE2(const void *in, void *out, const size_t num, const double scale, const bool)
+{
+    auto inElems = reinterpret_cast<const int16_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    const __m128 s = _mm_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        storeS16AsF32ScaledSSE2(outElems+i, _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElems+i)), s);
+    }
+    convertToF32ScaledTail(inElems, outElems, i, num, float(scale));
+}
+
+POTHOS_TARGET("sse2")
+static inline __m128i convertF32ToS32ScaledSSE2(const float *in, const __m128 scale, const bool saturate)
+{
+    __m128 x = _mm_mul_ps(_mm_loadu_ps(in), scale);
+    if (saturate)
+    {
+        x = _mm_and_ps(x, _mm_cmpord_ps(x, x)); //NaN to zero
+        x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-32768.0f)), _mm_set1_ps(32767.0f));
+    }
+    return _mm_cvttps_epi32(x);
+}
+
+POTHOS_TARGET("sse2")
+static void convertF32ToS16ScaledSSE2(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int16_t *>(out);
+    const __m128 s = _mm_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const __m128i lo = convertF32ToS32ScaledSSE2(inElems+i+0, s, saturate);
+        const __m128i hi = convertF32ToS32ScaledSSE2(inElems+i+4, s, saturate);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outElems+i), _mm_packs_epi32(lo, hi));
+    }
+    convertF32ToS16ScaledTail(inElems, outElems, i, num, float(scale), saturate);
+}
+
+POTHOS_TARGET("sse2")
+static inline __m128i convertF32ToS32RoundSSE2(const float *in, const __m128 scale, const bool saturate)
+{
+    //convert uses the default rounding mode: nearest, ties to even
+    __m128 x = _mm_mul_ps(_mm_loadu_ps(in), scale);
+    if (not saturate) return _mm_cvtps_epi32(x);
+    x = _mm_and_ps(x, _mm_cmpord_ps(x, x)); //NaN to zero
+    //positive overflow converts to INT32_MIN, flip it to INT32_MAX
+    const __m128 over = _mm_cmpge_ps(x, _mm_set1_ps(2147483648.0f));
+    return _mm_xor_si128(_mm_cvtps_epi32(x), _mm_castps_si128(over));
+}
+
+POTHOS_TARGET("sse2")
+static void convertF32ToS16RoundSSE2(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int16_t *>(out);
+    const __m128 s = _mm_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const __m128i lo = convertF32ToS32RoundSSE2(inElems+i+0, s, saturate);
+        const __m128i hi = convertF32ToS32RoundSSE2(inElems+i+4, s, saturate);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outElems+i), _mm_packs_epi32(lo, hi));
+    }
+    convertF32ToRoundTail(inElems, outElems, i, num, float(scale), saturate);
+}
+
+POTHOS_TARGET("sse2")
+static void convertF32ToS32RoundSSE2(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int32_t *>(out);
+    const __m128 s = _mm_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+4 <= num; i += 4)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outElems+i), convertF32ToS32RoundSSE2(inElems+i, s, saturate));
+    }
+    convertF32ToRoundTail(inElems, outElems, i, num, float(scale), saturate);
+}
+
+POTHOS_TARGET("sse2")
+static void interleaveF32ToCF32SSE2(const void *inRe, const void *inIm, void *out, const size_t num)
+{
+    auto inElemsRe = reinterpret_cast<const float *>(inRe);
+    auto inElemsIm = reinterpret_cast<const float *>(inIm);
+    auto outElems = reinterpret_cast<std::complex<float> *>(out);
+    size_t i = 0;
+    for (; i+4 <= num; i += 4)
+    {
+        const __m128 re = _mm_loadu_ps(inElemsRe+i);
+        const __m128 im = _mm_loadu_ps(inElemsIm+i);
+        _mm_storeu_ps(reinterpret_cast<float *>(outElems+i+0), _mm_unpacklo_ps(re, im));
+        _mm_storeu_ps(reinterpret_cast<float *>(outElems+i+2), _mm_unpackhi_ps(re, im));
+    }
+    interleaveTail(inElemsRe, inElemsIm, outElems, i, num);
+}
+
+POTHOS_TARGET("sse2")
+static void interleaveS16ToCS16SSE2(const void *inRe, const void *inIm, void *out, const size_t num)
+{
+    auto inElemsRe = reinterpret_cast<const int16_t *>(inRe);
+    auto inElemsIm = reinterpret_cast<const int16_t *>(inIm);
+    auto outElems = reinterpret_cast<std::complex<int16_t> *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const __m128i re = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElemsRe+i));
+        const __m128i im = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElemsIm+i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outElems+i+0), _mm_unpacklo_epi16(re, im));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outElems+i+4), _mm_unpackhi_epi16(re, im));
+    }
+    interleaveTail(inElemsRe, inElemsIm, outElems, i, num);
+}
+
+//SSE2 has no byte shuffle: swap the bytes of each word, then reorder the words
+template <size_t Width>
+POTHOS_TARGET("sse2")
+static inline __m128i byteswapVectorSSE2(__m128i v)
+{
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    if (Width == 4) v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+    if (Width == 8) v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+    return v;
+}
+
+template <size_t Width>
+POTHOS_TARGET("sse2")
+static void byteswapSSE2(const void *in, void *out, const size_t num)
+{
+    auto inBytes = reinterpret_cast<const char *>(in);
+    auto outBytes = reinterpret_cast<char *>(out);
+    size_t i = 0;
+    for (; i*Width+16 <= num*Width; i += 16/Width)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inBytes+i*Width));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outBytes+i*Width), byteswapVectorSSE2<Width>(v));
+    }
+    byteswapTail<Width>(inBytes, outBytes, i, num);
+}
+
+POTHOS_TARGET("sse2")
+static void convertBS16ToF32SSE2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int16_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const __m128i v16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElems+i));
+        storeS16AsF32SSE2(outElems+i, byteswapVectorSSE2<2>(v16));
+    }
+    convertBS16ToF32Tail(inElems, outElems, i, num);
+}
+
+/***********************************************************************
+ * AVX2 kernels
+ **********************************************************************/
+POTHOS_TARGET("avx2")
+static void convertS8ToF32AVX2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int8_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElems+i));
+        _mm256_storeu_ps(outElems+i+0, _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(v8)));
+        _mm256_storeu_ps(outElems+i+8, _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(v8, 8))));
+    }
+    for (; i < num; i++) outElems[i] = float(inElems[i]);
+}
+
+POTHOS_TARGET("avx2")
+static void convertS16ToF32AVX2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int16_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m256i v16 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inElems+i));
+        _mm256_storeu_ps(outElems+i+0, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v16))));
+        _mm256_storeu_ps(outElems+i+8, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v16, 1))));
+    }
+    for (; i < num; i++) outElems[i] = float(inElems[i]);
+}
+
+POTHOS_TARGET("avx2")
+static void convertS32ToF32AVX2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int32_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        _mm256_storeu_ps(outElems+i, _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(inElems+i))));
+    }
+    for (; i < num; i++) outElems[i] = float(inElems[i]);
+}
+
+POTHOS_TARGET("avx2")
+static void convertF32ToS16AVX2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int16_t *>(out);
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m256i lo = _mm256_cvttps_epi32(_mm256_loadu_ps(inElems+i+0));
+        const __m256i hi = _mm256_cvttps_epi32(_mm256_loadu_ps(inElems+i+8));
+        //the pack works per 128-bit lane, permute to restore the order
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outElems+i), packed);
+    }
+    for (; i < num; i++) outElems[i] = int16_t(inElems[i]);
+}
+
+POTHOS_TARGET("avx2")
+static void convertCS16ToF32ComponentsAVX2(const void *in, void *outRe, void *outIm, const size_t num)
+{
+    auto inElems = reinterpret_cast<const std::complex<int16_t> *>(in);
+    auto outElemsRe = reinterpret_cast<float *>(outRe);
+    auto outElemsIm = reinterpret_cast<float *>(outIm);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        //each 32-bit lane holds one complex sample: real in the low half
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inElems+i));
+        _mm256_storeu_ps(outElemsRe+i, _mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16)));
+        _mm256_storeu_ps(outElemsIm+i, _mm256_cvtepi32_ps(_mm256_srai_epi32(v, 16)));
+    }
+    for (; i < num; i++)
+    {
+        outElemsRe[i] = float(inElems[i].real());
+        outElemsIm[i] = float(inElems[i].imag());
+    }
+}
+
+POTHOS_TARGET("avx2")
+static void convertCF32ToF32ComponentsAVX2(const void *in, void *outRe, void *outIm, const size_t num)
+{
+    auto inElems = reinterpret_cast<const std::complex<float> *>(in);
+    auto outElemsRe = reinterpret_cast<float *>(outRe);
+    auto outElemsIm = reinterpret_cast<float *>(outIm);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const __m256 a = _mm256_loadu_ps(reinterpret_cast<const float *>(inElems+i+0));
+        const __m256 b = _mm256_loadu_ps(reinterpret_cast<const float *>(inElems+i+4));
+        //the shuffle works per 128-bit lane, permute to restore the order
+        const __m256 re = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 im = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm256_storeu_ps(outElemsRe+i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(re), _MM_SHUFFLE(3, 1, 2, 0))));
+        _mm256_storeu_ps(outElemsIm+i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(im), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+    for (; i < num; i++)
+    {
+        outElemsRe[i] = inElems[i].real();
+        outElemsIm[i] = inElems[i].imag();
+    }
+}
+
+POTHOS_TARGET("avx2")
+static void convertS8ToF32ScaledAVX2(const void *in, void *out, const size_t num, const double scale, const bool)
+{
+    auto inElems = reinterpret_cast<const int8_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    const __m256 s = _mm256_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inElems+i));
+        _mm256_storeu_ps(outElems+i+0, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(v8)), s));
+        _mm256_storeu_ps(outElems+i+8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(v8, 8))), s));
+    }
+    convertToF32ScaledTail(inElems, outElems, i, num, float(scale));
+}
+
+POTHOS_TARGET("avx2")
+static void convertS16ToF32ScaledAVX2(const void *in, void *out, const size_t num, const double scale, const bool)
+{
+    auto inElems = reinterpret_cast<const int16_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    const __m256 s = _mm256_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m256i v16 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inElems+i));
+        _mm256_storeu_ps(outElems+i+0, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v16))), s));
+        _mm256_storeu_ps(outElems+i+8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v16, 1))), s));
+    }
+    convertToF32ScaledTail(inElems, outElems, i, num, float(scale));
+}
+
+POTHOS_TARGET("avx2")
+static inline __m256i convertF32ToS32ScaledAVX2(const float *in, const __m256 scale, const bool saturate)
+{
+    __m256 x = _mm256_mul_ps(_mm256_loadu_ps(in), scale);
+    if (saturate)
+    {
+        x = _mm256_and_ps(x, _mm256_cmp_ps(x, x, _CMP_ORD_Q)); //NaN to zero
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-32768.0f)), _mm256_set1_ps(32767.0f));
+    }
+    return _mm256_cvttps_epi32(x);
+}
+
+POTHOS_TARGET("avx2")
+static void convertF32ToS16ScaledAVX2(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int16_t *>(out);
+    const __m256 s = _mm256_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m256i lo = convertF32ToS32ScaledAVX2(inElems+i+0, s, saturate);
+        const __m256i hi = convertF32ToS32ScaledAVX2(inElems+i+8, s, saturate);
+        //the pack works per 128-bit lane, permute to restore the order
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outElems+i), packed);
+    }
+    convertF32ToS16ScaledTail(inElems, outElems, i, num, float(scale), saturate);
+}
+
+POTHOS_TARGET("avx2")
+static inline __m256i convertF32ToS32RoundAVX2(const float *in, const __m256 scale, const bool saturate)
+{
+    //convert uses the default rounding mode: nearest, ties to even
+    __m256 x = _mm256_mul_ps(_mm256_loadu_ps(in), scale);
+    if (not saturate) return _mm256_cvtps_epi32(x);
+    x = _mm256_and_ps(x, _mm256_cmp_ps(x, x, _CMP_ORD_Q)); //NaN to zero
+    //positive overflow converts to INT32_MIN, flip it to INT32_MAX
+    const __m256 over = _mm256_cmp_ps(x, _mm256_set1_ps(2147483648.0f), _CMP_GE_OQ);
+    return _mm256_xor_si256(_mm256_cvtps_epi32(x), _mm256_castps_si256(over));
+}
+
+POTHOS_TARGET("avx2")
+static void convertF32ToS16RoundAVX2(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int16_t *>(out);
+    const __m256 s = _mm256_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m256i lo = convertF32ToS32RoundAVX2(inElems+i+0, s, saturate);
+        const __m256i hi = convertF32ToS32RoundAVX2(inElems+i+8, s, saturate);
+        //the pack works per 128-bit lane, permute to restore the order
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outElems+i), packed);
+    }
+    convertF32ToRoundTail(inElems, outElems, i, num, float(scale), saturate);
+}
+
+POTHOS_TARGET("avx2")
+static void convertF32ToS32RoundAVX2(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int32_t *>(out);
+    const __m256 s = _mm256_set1_ps(float(scale));
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outElems+i), convertF32ToS32RoundAVX2(inElems+i, s, saturate));
+    }
+    convertF32ToRoundTail(inElems, outElems, i, num, float(scale), saturate);
+}
+
+POTHOS_TARGET("avx2")
+static void interleaveF32ToCF32AVX2(const void *inRe, const void *inIm, void *out, const size_t num)
+{
+    auto inElemsRe = reinterpret_cast<const float *>(inRe);
+    auto inElemsIm = reinterpret_cast<const float *>(inIm);
+    auto outElems = reinterpret_cast<std::complex<float> *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        //the unpack works per 128-bit lane, permute the lanes to restore the order
+        const __m256 re = _mm256_loadu_ps(inElemsRe+i);
+        const __m256 im = _mm256_loadu_ps(inElemsIm+i);
+        const __m256 lo = _mm256_unpacklo_ps(re, im);
+        const __m256 hi = _mm256_unpackhi_ps(re, im);
+        _mm256_storeu_ps(reinterpret_cast<float *>(outElems+i+0), _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(reinterpret_cast<float *>(outElems+i+4), _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    interleaveTail(inElemsRe, inElemsIm, outElems, i, num);
+}
+
+POTHOS_TARGET("avx2")
+static void interleaveS16ToCS16AVX2(const void *inRe, const void *inIm, void *out, const size_t num)
+{
+    auto inElemsRe = reinterpret_cast<const int16_t *>(inRe);
+    auto inElemsIm = reinterpret_cast<const int16_t *>(inIm);
+    auto outElems = reinterpret_cast<std::complex<int16_t> *>(out);
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m256i re = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inElemsRe+i));
+        const __m256i im = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inElemsIm+i));
+        const __m256i lo = _mm256_unpacklo_epi16(re, im);
+        const __m256i hi = _mm256_unpackhi_epi16(re, im);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outElems+i+0), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outElems+i+8), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleaveTail(inElemsRe, inElemsIm, outElems, i, num);
+}
+
+//the byte shuffle reverses each primitive within the 128-bit lanes
+template <size_t Width>
+POTHOS_TARGET("avx2")
+static inline __m256i byteswapMaskAVX2(void)
+{
+    alignas(32) char mask[32];
+    for (size_t j = 0; j < 32; j++) mask[j] = char(((j%16)/Width)*Width + (Width-1-j%Width));
+    return _mm256_load_si256(reinterpret_cast<const __m256i *>(mask));
+}
+
+template <size_t Width>
+POTHOS_TARGET("avx2")
+static void byteswapAVX2(const void *in, void *out, const size_t num)
+{
+    auto inBytes = reinterpret_cast<const char *>(in);
+    auto outBytes = reinterpret_cast<char *>(out);
+    const __m256i mask = byteswapMaskAVX2<Width>();
+    size_t i = 0;
+    for (; i*Width+32 <= num*Width; i += 32/Width)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inBytes+i*Width));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outBytes+i*Width), _mm256_shuffle_epi8(v, mask));
+    }
+    byteswapTail<Width>(inBytes, outBytes, i, num);
+}
+
+POTHOS_TARGET("avx2")
+static void convertBS16ToF32AVX2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int16_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    const __m256i mask = byteswapMaskAVX2<2>();
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const __m256i v16 = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(inElems+i)), mask);
+        _mm256_storeu_ps(outElems+i+0, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v16))));
+        _mm256_storeu_ps(outElems+i+8, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v16, 1))));
+    }
+    convertBS16ToF32Tail(inElems, outElems, i, num);
+}
+
+//each 128-bit lane expands 4 packed samples (12 bytes) into 4 complex int16:
+//the shuffle builds the words [b0 b1] for the real part and [b1 b2] for the imaginary part
+POTHOS_TARGET("avx2")
+static inline __m256i unpackSC12AVX2(const unsigned char *in)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+        0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11,
+        0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10, 10, 11);
+    const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in+0))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in+12)), 1);
+    const __m256i words = _mm256_shuffle_epi8(v, shuffle);
+
+    //sign extend the low 12 bits of the real words and the high 12 bits of the imaginary words
+    const __m256i re = _mm256_srai_epi16(_mm256_slli_epi16(words, 4), 4);
+    const __m256i im = _mm256_srai_epi16(words, 4);
+    return _mm256_blend_epi16(re, im, 0xaa);
+}
+
+//the loops stop two samples early: the 16 byte loads and stores reach past the 8 samples
+POTHOS_TARGET("avx2")
+static void convertSC12ToCS16AVX2(const void *in, void *out, const size_t num)
+{
+    auto inBytes = reinterpret_cast<const unsigned char *>(in);
+    auto outElems = reinterpret_cast<std::complex<int16_t> *>(out);
+    size_t i = 0;
+    for (; i+10 <= num; i += 8)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outElems+i), unpackSC12AVX2(inBytes+i*3));
+    }
+    unpackSC12Tail(inBytes, outElems, i, num);
+}
+
+POTHOS_TARGET("avx2")
+static void convertSC12ToCF32AVX2(const void *in, void *out, const size_t num)
+{
+    auto inBytes = reinterpret_cast<const unsigned char *>(in);
+    auto outElems = reinterpret_cast<std::complex<float> *>(out);
+    size_t i = 0;
+    for (; i+10 <= num; i += 8)
+    {
+        const __m256i v16 = unpackSC12AVX2(inBytes+i*3);
+        _mm256_storeu_ps(reinterpret_cast<float *>(outElems+i+0), _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v16))));
+        _mm256_storeu_ps(reinterpret_cast<float *>(outElems+i+4), _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v16, 1))));
+    }
+    unpackSC12Tail(inBytes, outElems, i, num);
+}
+
+POTHOS_TARGET("avx2")
+static void convertCS16ToSC12AVX2(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const std::complex<int16_t> *>(in);
+    auto outBytes = reinterpret_cast<unsigned char *>(out);
+    const __m256i mask = _mm256_set1_epi32(0xfff);
+    const __m256i shuffle = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i+10 <= num; i += 8)
+    {
+        //build the 24-bit word of each sample in its 32-bit lane, then compact the bytes
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inElems+i));
+        const __m256i re = _mm256_and_si256(v, mask);
+        const __m256i im = _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(v, 16), mask), 12);
+        const __m256i packed = _mm256_shuffle_epi8(_mm256_or_si256(re, im), shuffle);
+
+        //the 4 trailing bytes of each store are overwritten by the next store
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outBytes+i*3+0), _mm256_castsi256_si128(packed));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outBytes+i*3+12), _mm256_extracti128_si256(packed, 1));
+    }
+    packSC12Tail(inElems, outBytes, i, num);
+}
+
+/***********************************************************************
+ * x86 feature detection
+ **********************************************************************/
+static bool cpuHasSSE2(void)
+{
+    #ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+    #else
+    return __builtin_cpu_supports("sse2");
+    #endif
+}
+
+static bool cpuHasAVX2(void)
+{
+    #ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (not osxsave or not avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false; //OS saves the ymm state
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+    #else
+    return __builtin_cpu_supports("avx2");
+    #endif
+}
+
+#endif //POTHOS_CONVERT_X86
+
+#ifdef POTHOS_CONVERT_NEON
+
+/***********************************************************************
+ * NEON kernels
+ **********************************************************************/
+static inline void storeS16AsF32NEON(float *out, const int16x8_t v16)
+{
+    vst1q_f32(out+0, vcvtq_f32_s32(vmovl_s16(vget_low_s16(v16))));
+    vst1q_f32(out+4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(v16))));
+}
+
+static void convertS8ToF32NEON(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int8_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        storeS16AsF32NEON(outElems+i, vmovl_s8(vld1_s8(inElems+i)));
+    }
+    for (; i < num; i++) outElems[i] = float(inElems[i]);
+}
+
+static void convertS16ToF32NEON(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int16_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        storeS16AsF32NEON(outElems+i, vld1q_s16(inElems+i));
+    }
+    for (; i < num; i++) outElems[i] = float(inElems[i]);
+}
+
+static void convertS32ToF32NEON(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int32_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+4 <= num; i += 4)
+    {
+        vst1q_f32(outElems+i, vcvtq_f32_s32(vld1q_s32(inElems+i)));
+    }
+    for (; i < num; i++) outElems[i] = float(inElems[i]);
+}
+
+static void convertF32ToS16NEON(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int16_t *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const int32x4_t lo = vcvtq_s32_f32(vld1q_f32(inElems+i+0));
+        const int32x4_t hi = vcvtq_s32_f32(vld1q_f32(inElems+i+4));
+        vst1q_s16(outElems+i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    for (; i < num; i++) outElems[i] = int16_t(inElems[i]);
+}
+
+static void convertCS16ToF32ComponentsNEON(const void *in, void *outRe, void *outIm, const size_t num)
+{
+    auto inElems = reinterpret_cast<const std::complex<int16_t> *>(in);
+    auto outElemsRe = reinterpret_cast<float *>(outRe);
+    auto outElemsIm = reinterpret_cast<float *>(outIm);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const int16x8x2_t v = vld2q_s16(reinterpret_cast<const int16_t *>(inElems+i));
+        storeS16AsF32NEON(outElemsRe+i, v.val[0]);
+        storeS16AsF32NEON(outElemsIm+i, v.val[1]);
+    }
+    for (; i < num; i++)
+    {
+        outElemsRe[i] = float(inElems[i].real());
+        outElemsIm[i] = float(inElems[i].imag());
+    }
+}
+
+static void convertCF32ToF32ComponentsNEON(const void *in, void *outRe, void *outIm, const size_t num)
+{
+    auto inElems = reinterpret_cast<const std::complex<float> *>(in);
+    auto outElemsRe = reinterpret_cast<float *>(outRe);
+    auto outElemsIm = reinterpret_cast<float *>(outIm);
+    size_t i = 0;
+    for (; i+4 <= num; i += 4)
+    {
+        const float32x4x2_t v = vld2q_f32(reinterpret_cast<const float *>(inElems+i));
+        vst1q_f32(outElemsRe+i, v.val[0]);
+        vst1q_f32(outElemsIm+i, v.val[1]);
+    }
+    for (; i < num; i++)
+    {
+        outElemsRe[i] = inElems[i].real();
+        outElemsIm[i] = inElems[i].imag();
+    }
+}
+
+static void convertS8ToF32ScaledNEON(const void *in, void *out, const size_t num, const double scale, const bool)
+{
+    auto inElems = reinterpret_cast<const int8_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    const float32x4_t s = vdupq_n_f32(float(scale));
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const int16x8_t v16 = vmovl_s8(vld1_s8(inElems+i));
+        vst1q_f32(outElems+i+0, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v16))), s));
+        vst1q_f32(outElems+i+4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v16))), s));
+    }
+    convertToF32ScaledTail(inElems, outElems, i, num, float(scale));
+}
+
+static void convertS16ToF32ScaledNEON(const void *in, void *out, const size_t num, const double scale, const bool)
+{
+    auto inElems = reinterpret_cast<const int16_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    const float32x4_t s = vdupq_n_f32(float(scale));
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const int16x8_t v16 = vld1q_s16(inElems+i);
+        vst1q_f32(outElems+i+0, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v16))), s));
+        vst1q_f32(outElems+i+4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v16))), s));
+    }
+    convertToF32ScaledTail(inElems, outElems, i, num, float(scale));
+}
+
+static void convertF32ToS16ScaledNEON(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int16_t *>(out);
+    const float32x4_t s = vdupq_n_f32(float(scale));
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        //the NEON convert and narrow instructions saturate (NaN to zero)
+        const int32x4_t lo = vcvtq_s32_f32(vmulq_f32(vld1q_f32(inElems+i+0), s));
+        const int32x4_t hi = vcvtq_s32_f32(vmulq_f32(vld1q_f32(inElems+i+4), s));
+        vst1q_s16(outElems+i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    convertF32ToS16ScaledTail(inElems, outElems, i, num, float(scale), saturate);
+}
+
+//the round to nearest convert is an ARMv8 instruction, ARMv7 uses the scalar loop
+static void convertF32ToS16RoundNEON(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int16_t *>(out);
+    size_t i = 0;
+    #ifdef __aarch64__
+    const float32x4_t s = vdupq_n_f32(float(scale));
+    for (; i+8 <= num; i += 8)
+    {
+        //the NEON convert and narrow instructions saturate (NaN to zero)
+        const int32x4_t lo = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(inElems+i+0), s));
+        const int32x4_t hi = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(inElems+i+4), s));
+        vst1q_s16(outElems+i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    #endif
+    convertF32ToRoundTail(inElems, outElems, i, num, float(scale), saturate);
+}
+
+static void convertF32ToS32RoundNEON(const void *in, void *out, const size_t num, const double scale, const bool saturate)
+{
+    auto inElems = reinterpret_cast<const float *>(in);
+    auto outElems = reinterpret_cast<int32_t *>(out);
+    size_t i = 0;
+    #ifdef __aarch64__
+    const float32x4_t s = vdupq_n_f32(float(scale));
+    for (; i+4 <= num; i += 4)
+    {
+        vst1q_s32(outElems+i, vcvtnq_s32_f32(vmulq_f32(vld1q_f32(inElems+i), s)));
+    }
+    #endif
+    convertF32ToRoundTail(inElems, outElems, i, num, float(scale), saturate);
+}
+
+static void interleaveF32ToCF32NEON(const void *inRe, const void *inIm, void *out, const size_t num)
+{
+    auto inElemsRe = reinterpret_cast<const float *>(inRe);
+    auto inElemsIm = reinterpret_cast<const float *>(inIm);
+    auto outElems = reinterpret_cast<std::complex<float> *>(out);
+    size_t i = 0;
+    for (; i+4 <= num; i += 4)
+    {
+        float32x4x2_t v;
+        v.val[0] = vld1q_f32(inElemsRe+i);
+        v.val[1] = vld1q_f32(inElemsIm+i);
+        vst2q_f32(reinterpret_cast<float *>(outElems+i), v);
+    }
+    interleaveTail(inElemsRe, inElemsIm, outElems, i, num);
+}
+
+static void interleaveS16ToCS16NEON(const void *inRe, const void *inIm, void *out, const size_t num)
+{
+    auto inElemsRe = reinterpret_cast<const int16_t *>(inRe);
+    auto inElemsIm = reinterpret_cast<const int16_t *>(inIm);
+    auto outElems = reinterpret_cast<std::complex<int16_t> *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        int16x8x2_t v;
+        v.val[0] = vld1q_s16(inElemsRe+i);
+        v.val[1] = vld1q_s16(inElemsIm+i);
+        vst2q_s16(reinterpret_cast<int16_t *>(outElems+i), v);
+    }
+    interleaveTail(inElemsRe, inElemsIm, outElems, i, num);
+}
+
+template <size_t Width>
+static inline uint8x16_t byteswapVectorNEON(const uint8x16_t v)
+{
+    if (Width == 2) return vrev16q_u8(v);
+    if (Width == 4) return vrev32q_u8(v);
+    return vrev64q_u8(v);
+}
+
+template <size_t Width>
+static void byteswapNEON(const void *in, void *out, const size_t num)
+{
+    auto inBytes = reinterpret_cast<const char *>(in);
+    auto outBytes = reinterpret_cast<char *>(out);
+    size_t i = 0;
+    for (; i*Width+16 <= num*Width; i += 16/Width)
+    {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(inBytes+i*Width));
+        vst1q_u8(reinterpret_cast<uint8_t *>(outBytes+i*Width), byteswapVectorNEON<Width>(v));
+    }
+    byteswapTail<Width>(inBytes, outBytes, i, num);
+}
+
+static void convertBS16ToF32NEON(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const int16_t *>(in);
+    auto outElems = reinterpret_cast<float *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(inElems+i));
+        storeS16AsF32NEON(outElems+i, vreinterpretq_s16_u8(vrev16q_u8(v)));
+    }
+    convertBS16ToF32Tail(inElems, outElems, i, num);
+}
+
+//expand 8 packed samples from the de-interleaved bytes of vld3
+static inline void unpackSC12NEON(const uint8x8_t b0, const uint8x8_t b1, const uint8x8_t b2, int16x8_t &re, int16x8_t &im)
+{
+    //real: b0 and the low nibble of b1, imaginary: the high nibble of b1 and b2
+    const uint16x8_t re12 = vorrq_u16(vmovl_u8(b0), vshll_n_u8(vand_u8(b1, vdup_n_u8(0xf)), 8));
+    const uint16x8_t im12 = vorrq_u16(vmovl_u8(vshr_n_u8(b1, 4)), vshll_n_u8(b2, 4));
+    re = vshrq_n_s16(vshlq_n_s16(vreinterpretq_s16_u16(re12), 4), 4);
+    im = vshrq_n_s16(vshlq_n_s16(vreinterpretq_s16_u16(im12), 4), 4);
+}
+
+static void convertSC12ToCS16NEON(const void *in, void *out, const size_t num)
+{
+    auto inBytes = reinterpret_cast<const unsigned char *>(in);
+    auto outElems = reinterpret_cast<std::complex<int16_t> *>(out);
+    size_t i = 0;
+    for (; i+16 <= num; i += 16)
+    {
+        const uint8x16x3_t v = vld3q_u8(inBytes+i*3);
+        int16x8x2_t lo, hi;
+        unpackSC12NEON(vget_low_u8(v.val[0]), vget_low_u8(v.val[1]), vget_low_u8(v.val[2]), lo.val[0], lo.val[1]);
+        unpackSC12NEON(vget_high_u8(v.val[0]), vget_high_u8(v.val[1]), vget_high_u8(v.val[2]), hi.val[0], hi.val[1]);
+        vst2q_s16(reinterpret_cast<int16_t *>(outElems+i+0), lo);
+        vst2q_s16(reinterpret_cast<int16_t *>(outElems+i+8), hi);
+    }
+    unpackSC12Tail(inBytes, outElems, i, num);
+}
+
+static void convertSC12ToCF32NEON(const void *in, void *out, const size_t num)
+{
+    auto inBytes = reinterpret_cast<const unsigned char *>(in);
+    auto outElems = reinterpret_cast<std::complex<float> *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const uint8x8x3_t v = vld3_u8(inBytes+i*3);
+        int16x8_t re, im;
+        unpackSC12NEON(v.val[0], v.val[1], v.val[2], re, im);
+        float32x4x2_t lo, hi;
+        lo.val[0] = vcvtq_f32_s32(vmovl_s16(vget_low_s16(re)));
+        lo.val[1] = vcvtq_f32_s32(vmovl_s16(vget_low_s16(im)));
+        hi.val[0] = vcvtq_f32_s32(vmovl_s16(vget_high_s16(re)));
+        hi.val[1] = vcvtq_f32_s32(vmovl_s16(vget_high_s16(im)));
+        vst2q_f32(reinterpret_cast<float *>(outElems+i+0), lo);
+        vst2q_f32(reinterpret_cast<float *>(outElems+i+4), hi);
+    }
+    unpackSC12Tail(inBytes, outElems, i, num);
+}
+
+static void convertCS16ToSC12NEON(const void *in, void *out, const size_t num)
+{
+    auto inElems = reinterpret_cast<const std::complex<int16_t> *>(in);
+    auto outBytes = reinterpret_cast<unsigned char *>(out);
+    size_t i = 0;
+    for (; i+8 <= num; i += 8)
+    {
+        const int16x8x2_t v = vld2q_s16(reinterpret_cast<const int16_t *>(inElems+i));
+        const uint16x8_t re = vreinterpretq_u16_s16(v.val[0]);
+        const uint16x8_t im = vreinterpretq_u16_s16(v.val[1]);
+        uint8x8x3_t bytes;
+        bytes.val[0] = vmovn_u16(re);
+        bytes.val[1] = vmovn_u16(vorrq_u16(vandq_u16(vshrq_n_u16(re, 8), vdupq_n_u16(0xf)), vshlq_n_u16(im, 4)));
+        bytes.val[2] = vmovn_u16(vshrq_n_u16(im, 4));
+        vst3_u8(outBytes+i*3, bytes);
+    }
+    packSC12Tail(inElems, outBytes, i, num);
+}
+
+#endif //POTHOS_CONVERT_NEON
+
+/***********************************************************************
+ * runtime kernel selection
+ **********************************************************************/
+static const SimdKernels *detectSimdKernels(void)
+{
+    #ifdef POTHOS_CONVERT_X86
+    static const SimdKernels avx2Kernels = POTHOS_SIMD_KERNELS(AVX2);
+    static const SimdKernels sse2Kernels = POTHOS_SIMD_KERNELS(SSE2);
+    if (cpuHasAVX2()) return &avx2Kernels;
+    if (cpuHasSSE2()) return &sse2Kernels;
+    #endif
+
+    #ifdef POTHOS_CONVERT_NEON
+    static const SimdKernels neonKernels = POTHOS_SIMD_KERNELS(NEON);
+    return &neonKernels;
+    #endif
+
+    return nullptr;
+}
+
+static const SimdKernels *getSimdKernels(void)
+{
+    static const SimdKernels *kernels = detectSimdKernels();
+    return kernels;
+}
+
+static const SimdPackedKernels *detectSimdPackedKernels(void)
+{
+    #ifdef POTHOS_CONVERT_X86
+    static const SimdPackedKernels avx2Kernels = POTHOS_SIMD_PACKED_KERNELS(AVX2);
+    if (cpuHasAVX2()) return &avx2Kernels;
+    #endif
+
+    #ifdef POTHOS_CONVERT_NEON
+    static const SimdPackedKernels neonKernels = POTHOS_SIMD_PACKED_KERNELS(NEON);
+    return &neonKernels;
+    #endif
+
+    return nullptr;
+}
+
+static const SimdPackedKernels *getSimdPackedKernels(void)
+{
+    static const SimdPackedKernels *kernels = detectSimdPackedKernels();
+    return kernels;
+}
+
+static bool isSC12(const Pothos::DType &dtype)
+{
+    static const Pothos::DType sc12("complex_int12");
+    return dtype.elemType() == sc12.elemType();
+}
+
+template <typename Type>
+static bool isType(const Pothos::DType &dtype)
+{
+    return dtype.elemType() == Pothos::DType::of<Type>().elemType();
+}
+
+BufferConvertFcn getSimdBufferConvert(const Pothos::DType &in, const Pothos::DType &out)
+{
+    const auto packed = getSimdPackedKernels();
+    if (packed != nullptr and (in.isPacked() or out.isPacked()))
+    {
+        if (isSC12(in) and isType<std::complex<int16_t>>(out)) return packed->sc12ToCS16;
+        if (isSC12(in) and isType<std::complex<float>>(out)) return packed->sc12ToCF32;
+        if (isType<std::complex<int16_t>>(in) and isSC12(out)) return packed->cs16ToSC12;
+    }
+
+    const auto kernels = getSimdKernels();
+    if (kernels == nullptr) return nullptr;
+    if (isType<int8_t>(in) and isType<float>(out)) return kernels->s8ToF32;
+    if (isType<int16_t>(in) and isType<float>(out)) return kernels->s16ToF32;
+    if (isType<int32_t>(in) and isType<float>(out)) return kernels->s32ToF32;
+    if (isType<float>(in) and isType<int16_t>(out)) return kernels->f32ToS16;
+    if (isType<std::complex<int8_t>>(in) and isType<std::complex<float>>(out)) return kernels->cs8ToCF32;
+    if (isType<std::complex<int16_t>>(in) and isType<std::complex<float>>(out)) return kernels->cs16ToCF32;
+    if (isType<std::complex<int32_t>>(in) and isType<std::complex<float>>(out)) return kernels->cs32ToCF32;
+    if (isType<std::complex<float>>(in) and isType<std::complex<int16_t>>(out)) return kernels->cf32ToCS16;
+    return nullptr;
+}
+
+BufferConvertComponentsFcn getSimdBufferConvertComponents(const Pothos::DType &in, const Pothos::DType &out)
+{
+    const auto kernels = getSimdKernels();
+    if (kernels == nullptr) return nullptr;
+    if (isType<std::complex<int16_t>>(in) and isType<float>(out)) return kernels->cs16ToF32Components;
+    if (isType<std::complex<float>>(in) and isType<float>(out)) return kernels->cf32ToF32Components;
+    return nullptr;
+}
+
+BufferConvertInterleaveFcn getSimdBufferConvertInterleave(const Pothos::DType &in, const Pothos::DType &out)
+{
+    const auto kernels = getSimdKernels();
+    if (kernels == nullptr) return nullptr;
+    if (isType<float>(in) and isType<std::complex<float>>(out)) return kernels->f32ToCF32Interleave;
+    if (isType<int16_t>(in) and isType<std::complex<int16_t>>(out)) return kernels->s16ToCS16Interleave;
+    return nullptr;
+}
+
+BufferConvertFcn getSimdBufferByteswap(const size_t width)
+{
+    const auto kernels = getSimdKernels();
+    if (kernels == nullptr) return nullptr;
+    if (width == 2) return kernels->byteswap16;
+    if (width == 4) return kernels->byteswap32;
+    if (width == 8) return kernels->byteswap64;
+    return nullptr;
+}
+
+BufferConvertFcn getSimdBufferConvertFromBigEndian(const Pothos::DType &in, const Pothos::DType &out)
+{
+    const auto kernels = getSimdKernels();
+    if (kernels == nullptr) return nullptr;
+    if (isType<int16_t>(in) and isType<float>(out)) return kernels->bs16ToF32;
+    if (isType<std::complex<int16_t>>(in) and isType<std::complex<float>>(out)) return kernels->cbs16ToCF32;
+    return nullptr;
+}
+
+BufferConvertScaledFcn getSimdBufferConvertScaled(const Pothos::DType &in, const Pothos::DType &out)
+{
+    const auto kernels = getSimdKernels();
+    if (kernels == nullptr) return nullptr;
+    if (isType<int8_t>(in) and isType<float>(out)) return kernels->s8ToF32Scaled;
+    if (isType<int16_t>(in) and isType<float>(out)) return kernels->s16ToF32Scaled;
+    if (isType<float>(in) and isType<int16_t>(out)) return kernels->f32ToS16Scaled;
+    if (isType<std::complex<int8_t>>(in) and isType<std::complex<float>>(out)) return kernels->cs8ToCF32Scaled;
+    if (isType<std::complex<int16_t>>(in) and isType<std::complex<float>>(out)) return kernels->cs16ToCF32Scaled;
+    if (isType<std::complex<float>>(in) and isType<std::complex<int16_t>>(out)) return kernels->cf32ToCS16Scaled;
+    return nullptr;
+}
+
+BufferConvertScaledFcn getSimdBufferConvertScaledRound(const Pothos::DType &in, const Pothos::DType &out)
+{
+    const auto kernels = getSimdKernels();
+    if (kernels == nullptr) return nullptr;
+    if (isType<float>(in) and isType<int16_t>(out)) return kernels->f32ToS16Round;
+    if (isType<float>(in) and isType<int32_t>(out)) return kernels->f32ToS32Round;
+    return nullptr;
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework/DType.hpp>
+#include <cstddef>
+
+//! Convert num primitive elements from in to out
+typedef void (*BufferConvertFcn)(const void *in, void *out, const size_t num);
+
+//! Convert num primitive elements from in to out with scaling and optional saturation
+typedef void (*BufferConvertScaledFcn)(const void *in, void *out, const size_t num, const double scale, const bool saturate);
+
+//! Convert num complex elements from in to split real and imaginary outputs
+typedef void (*BufferConvertComponentsFcn)(const void *in, void *outRe, void *outIm, const size_t num);
+
+//! Convert num elements from split real and imaginary inputs to complex out
+typedef void (*BufferConvertInterleaveFcn)(const void *inRe, const void *inIm, void *out, const size_t num);
+
+/*!
+ * Get a vectorized conversion kernel for the CPU that we are running on.
+ * The kernel is selected at runtime based on the detected CPU features.
+ * \return the kernel or nullptr when there is no vectorized implementation
+ */
+BufferConvertFcn getSimdBufferConvert(const Pothos::DType &in, const Pothos::DType &out);
+
+/*!
+ * Get a vectorized complex to components kernel for the CPU we are running on.
+ * \return the kernel or nullptr when there is no vectorized implementation
+ */
+BufferConvertComponentsFcn getSimdBufferConvertComponents(const Pothos::DType &in, const Pothos::DType &out);
+
+/*!
+ * Get a vectorized components to complex kernel for the CPU we are running on.
+ * \return the kernel or nullptr when there is no vectorized implementation
+ */
+BufferConvertInterleaveFcn getSimdBufferConvertInterleave(const Pothos::DType &in, const Pothos::DType &out);
+
+/*!
+ * Get a vectorized kernel that reverses the bytes of num primitives.
+ * The kernel may be called with the same input and output for in-place swaps.
+ * \param width the size of the primitive in bytes: 2, 4, or 8
+ * \return the kernel or nullptr when there is no vectorized implementation
+ */
+BufferConvertFcn getSimdBufferByteswap(const size_t width);
+
+/*!
+ * Get a vectorized kernel that converts big endian input to native output.
+ * The byte swap is fused into the conversion, for network and file formats.
+ * \return the kernel or nullptr when there is no vectorized implementation
+ */
+BufferConvertFcn getSimdBufferConvertFromBigEndian(const Pothos::DType &in, const Pothos::DType &out);
+
+/*!
+ * Get a vectorized scaled conversion kernel for the CPU we are running on.
+ * \return the kernel or nullptr when there is no vectorized implementation
+ */
+BufferConvertScaledFcn getSimdBufferConvertScaled(const Pothos::DType &in, const Pothos::DType &out);
+
+/*!
+ * Get a vectorized scaled conversion kernel that rounds to the nearest integer.
+ * Unlike the scaled kernels, which truncate like a C++ cast, these kernels
+ * round ties to even; they back the bulk Q format conversions.
+ * \return the kernel or nullptr when there is no vectorized implementation
+ */
+BufferConvertScaledFcn getSimdBufferConvertScaledRound(const Pothos::DType &in, const Pothos::DType &out);
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/BufferManager.hpp>
@@ -6,15 +6,47 @@
 #include <Pothos/Callable.hpp>
 #include <Pothos/Plugin.hpp>
 #include <cassert>
+#include <json.hpp>
+
+using json = nlohmann::json;
 
 Pothos::BufferManagerArgs::BufferManagerArgs(void):
     numBuffers(4),
     bufferSize(8*1024),
-    nodeAffinity(-1)
+    nodeAffinity(-1),
+    hugePageSize(0),
+    lockMemory(false),
+    prefaultMemory(false),
+    alignment(0),
+    padding(0),
+    fileMode("read"),
+    maxBuffers(0),
+    shrinkTimeout(1.0)
 {
     return;
 }
 
+Pothos::BufferManagerArgs::BufferManagerArgs(const std::string &jsonStr):
+    BufferManagerArgs()
+{
+    //parse to JSON object
+    const auto topObj = json::parse(jsonStr);
+
+    //parse out the optional fields
+    this->numBuffers = topObj.value("numBuffers", this->numBuffers);
+    this->bufferSize = topObj.value("bufferSize", this->bufferSize);
+    this->nodeAffinity = topObj.value("nodeAffinity", this->nodeAffinity);
+    this->hugePageSize = topObj.value("hugePageSize", this->hugePageSize);
+    this->lockMemory = topObj.value("lockMemory", this->lockMemory);
+    this->prefaultMemory = topObj.value("prefaultMemory", this->prefaultMemory);
+    this->alignment = topObj.value("alignment", this->alignment);
+    this->padding = topObj.value("padding", this->padding);
+    this->filePath = topObj.value("filePath", this->filePath);
+    this->fileMode = topObj.value("fileMode", this->fileMode);
+    this->maxBuffers = topObj.value("maxBuffers", this->maxBuffers);
+    this->shrinkTimeout = topObj.value("shrinkTimeout", this->shrinkTimeout);
+}
+
 Pothos::BufferManager::BufferManager(void):
     _initialized(false)
 {
@@ -1,39 +1,121 @@
-// Copyright (c) 2013-2018 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/BufferPool.hpp>
 
-//! The default size of allocations until the client requests larger buffers
+//! The size of the smallest size class, smaller requests share this class
 static const size_t defaultSize = 8*1024;
 
+//! The most buffers retained in a single size class
+static const size_t maxEntriesPerClass = 16;
+
+//! The most buffers retained across all size classes
+static const size_t maxEntries = 64;
+
+//! Unused buffers are trimmed after this many requests without use
+static const unsigned long long maxIdleTicks = 4096;
+
+static size_t sizeClassIndex(const size_t numBytes)
+{
+    size_t index = 0;
+    while ((defaultSize << index) < numBytes) index++;
+    return index;
+}
+
 Pothos::BufferPool::BufferPool(void):
-    _minBuffSize(defaultSize)
+    _ticks(0),
+    _totalAllocations(0),
+    _totalReuses(0),
+    _numEntries(0),
+    _pooledBytes(0)
 {
     return;
 }
 
 void Pothos::BufferPool::clear(void)
 {
-    _minBuffSize = defaultSize;
-    _buffs.clear();
+    _classes.clear();
+    _numEntries = 0;
+    _pooledBytes = 0;
 }
 
-const Pothos::BufferChunk &Pothos::BufferPool::get(const size_t numBytes)
+Pothos::BufferChunk Pothos::BufferPool::get(const size_t numBytes)
 {
-    //user asked for a larger buffer size -- drop all entries
-    if (numBytes > _minBuffSize)
+    _ticks++;
+    const size_t index = sizeClassIndex(numBytes);
+    if (index >= _classes.size()) _classes.resize(index+1);
+    auto &entries = _classes[index];
+
+    //find the first buffer where we hold the only copy
+    for (auto &entry : entries)
     {
-        _buffs.clear();
-        _minBuffSize = numBytes;
+        if (not entry.first.unique()) continue;
+        entry.second = _ticks;
+        _totalReuses++;
+        return entry.first;
     }
 
-    //find the first buffer where we hold the only copy
-    for (size_t i = 0; i < _buffs.size(); i++)
+    //otherwise make a new buffer and retain it if there is room
+    const BufferChunk buff(defaultSize << index);
+    _totalAllocations++;
+    this->trim();
+    if (entries.size() < maxEntriesPerClass and _numEntries < maxEntries)
     {
-        if (_buffs[i].unique()) return _buffs[i];
+        entries.emplace_back(buff, _ticks);
+        _numEntries++;
+        _pooledBytes += buff.length;
     }
+    return buff;
+}
 
-    //otherwise make a new buffer
-    _buffs.emplace_back(_minBuffSize);
-    return _buffs.back();
+void Pothos::BufferPool::trim(void)
+{
+    //drop unused buffers that were idle for too long
+    for (auto &entries : _classes)
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->first.unique() and _ticks - it->second > maxIdleTicks)
+            {
+                _numEntries--;
+                _pooledBytes -= it->first.length;
+                it = entries.erase(it);
+            }
+            else it++;
+        }
+    }
+
+    //make room for a new entry by dropping the least recently used unused buffer
+    if (_numEntries < maxEntries) return;
+    std::vector<std::pair<BufferChunk, unsigned long long>> *lruEntries(nullptr);
+    size_t lruIndex = 0;
+    for (auto &entries : _classes)
+    {
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (not entries[i].first.unique()) continue;
+            if (lruEntries != nullptr and (*lruEntries)[lruIndex].second <= entries[i].second) continue;
+            lruEntries = &entries;
+            lruIndex = i;
+        }
+    }
+    if (lruEntries == nullptr) return;
+    _numEntries--;
+    _pooledBytes -= (*lruEntries)[lruIndex].first.length;
+    lruEntries->erase(lruEntries->begin() + lruIndex);
+}
+
+unsigned long long Pothos::BufferPool::getTotalAllocations(void) const
+{
+    return _totalAllocations;
+}
+
+unsigned long long Pothos::BufferPool::getTotalReuses(void) const
+{
+    return _totalReuses;
+}
+
+size_t Pothos::BufferPool::getPooledBytes(void) const
+{
+    return _pooledBytes;
 }
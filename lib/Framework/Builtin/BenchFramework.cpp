@@ -0,0 +1,162 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Benchmark.hpp>
+#include <Pothos/Framework.hpp>
+#include <cstring> //memset
+#include <complex>
+#include <future>
+#include <memory>
+
+/***********************************************************************
+ * Buffer accumulator push, require, and pop
+ **********************************************************************/
+POTHOS_BENCH_BLOCK("/framework/bench", bench_buffer_accumulator_forward)
+{
+    //contiguous pushes are forwarded without copies
+    Pothos::BufferChunk buff(8192);
+    Pothos::BufferAccumulator accum;
+    state.setBytesPerIteration(buff.length);
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        accum.push(Pothos::BufferChunk(buff));
+        Pothos::BenchmarkState::doNotOptimize(accum.front());
+        accum.pop(buff.length);
+    }
+}
+
+POTHOS_BENCH_BLOCK("/framework/bench", bench_buffer_accumulator_require)
+{
+    //separate buffers must be copied together to meet the requirement
+    Pothos::BufferChunk buff0(4096), buff1(4096);
+    std::memset(buff0.as<void *>(), 0, buff0.length);
+    std::memset(buff1.as<void *>(), 0, buff1.length);
+    Pothos::BufferAccumulator accum;
+    state.setBytesPerIteration(buff0.length + buff1.length);
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        accum.push(Pothos::BufferChunk(buff0));
+        accum.push(Pothos::BufferChunk(buff1));
+        accum.require(buff0.length + buff1.length);
+        Pothos::BenchmarkState::doNotOptimize(accum.front());
+        accum.pop(buff0.length + buff1.length);
+    }
+}
+
+/***********************************************************************
+ * Buffer chunk conversions for common dtype pairs
+ **********************************************************************/
+static void benchBufferConvert(Pothos::BenchmarkState &state, const Pothos::DType &inType, const Pothos::DType &outType)
+{
+    const size_t numElems = 4096;
+    Pothos::BufferChunk inBuff(inType, numElems);
+    Pothos::BufferChunk outBuff(outType, numElems);
+    std::memset(inBuff.as<void *>(), 0, inBuff.length);
+    state.setBytesPerIteration(inBuff.length);
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        inBuff.convert(outBuff, numElems);
+        Pothos::BenchmarkState::doNotOptimize(outBuff);
+    }
+}
+
+POTHOS_BENCH_BLOCK("/framework/bench/convert", bench_convert_float32_to_int16)
+{
+    benchBufferConvert(state, Pothos::DType::of<float>(), Pothos::DType::of<short>());
+}
+
+POTHOS_BENCH_BLOCK("/framework/bench/convert", bench_convert_int16_to_float32)
+{
+    benchBufferConvert(state, Pothos::DType::of<short>(), Pothos::DType::of<float>());
+}
+
+POTHOS_BENCH_BLOCK("/framework/bench/convert", bench_convert_int8_to_float32)
+{
+    benchBufferConvert(state, Pothos::DType::of<signed char>(), Pothos::DType::of<float>());
+}
+
+POTHOS_BENCH_BLOCK("/framework/bench/convert", bench_convert_float32_to_float64)
+{
+    benchBufferConvert(state, Pothos::DType::of<float>(), Pothos::DType::of<double>());
+}
+
+POTHOS_BENCH_BLOCK("/framework/bench/convert", bench_convert_complex_float32_to_complex_int16)
+{
+    benchBufferConvert(state, Pothos::DType::of<std::complex<float>>(), Pothos::DType::of<std::complex<short>>());
+}
+
+/***********************************************************************
+ * Actor wakeup latency as a message ping-pong between two blocks
+ **********************************************************************/
+struct BenchPinger : Pothos::Block
+{
+    BenchPinger(const size_t total):
+        total(total),
+        count(0)
+    {
+        this->setupInput(0);
+        this->setupOutput(0);
+        this->registerCall(this, POTHOS_FCN_TUPLE(BenchPinger, start));
+    }
+
+    void start(void)
+    {
+        this->output(0)->postMessage(count);
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage())
+        {
+            inPort->popMessage();
+            if (++count < total) this->output(0)->postMessage(count);
+            else done.set_value();
+        }
+    }
+
+    const size_t total;
+    size_t count;
+    std::promise<void> done;
+};
+
+struct BenchPonger : Pothos::Block
+{
+    BenchPonger(void)
+    {
+        this->setupInput(0);
+        this->setupOutput(0);
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage())
+        {
+            this->output(0)->postMessage(inPort->popMessage());
+        }
+    }
+};
+
+POTHOS_BENCH_BLOCK("/framework/bench", bench_actor_wakeup_round_trip)
+{
+    //exclude the topology setup and tear-down from the measurement
+    state.pauseTiming();
+    auto pinger = std::shared_ptr<BenchPinger>(new BenchPinger(state.iterations()));
+    auto ponger = std::shared_ptr<BenchPonger>(new BenchPonger());
+    auto doneFuture = pinger->done.get_future();
+
+    Pothos::Topology topology;
+    topology.connect(pinger, 0, ponger, 0);
+    topology.connect(ponger, 0, pinger, 0);
+    topology.commit();
+
+    //each iteration wakes up both actors once
+    state.resumeTiming();
+    pinger->call("start");
+    doneFuture.wait();
+    state.pauseTiming();
+
+    topology.disconnectAll();
+    topology.commit();
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <algorithm> //min/max
+#include <chrono>
+#include <thread>
+#include <cstring> //memcpy
+#include <vector>
+
+/***********************************************************************
+ * |PothosDoc Buffer Coalescer
+ *
+ * The buffer coalescer copies small input buffers into larger output buffers.
+ * An output buffer is posted once it holds the maximum number of bytes,
+ * or once its first byte has waited for the maximum latency.
+ * Labels are carried into the coalesced buffer at their adjusted offset,
+ * and messages flush the pending buffer to keep their order in the stream.
+ * The topology inserts this block ahead of network sinks
+ * when coalescing is enabled with Topology::setNetworkFlowArgs().
+ *
+ * |category /Network
+ * |keywords coalesce batch network
+ *
+ * |param maxBytes[Max Bytes] The size of the coalesced buffers in bytes.
+ * |default 65536
+ *
+ * |param maxLatency[Max Latency] The longest time in seconds that data waits.
+ * |default 0.001
+ *
+ * |factory /blocks/buffer_coalescer(maxBytes, maxLatency)
+ **********************************************************************/
+class BufferCoalescer : public Pothos::Block
+{
+public:
+    static Block *make(const size_t maxBytes, const double maxLatency)
+    {
+        return new BufferCoalescer(maxBytes, maxLatency);
+    }
+
+    BufferCoalescer(const size_t maxBytes, const double maxLatency):
+        _maxBytes(std::max<size_t>(maxBytes, 1)),
+        _maxLatency(std::chrono::nanoseconds((long long)(std::max(maxLatency, 0.0)*1e9))),
+        _pendingBytes(0)
+    {
+        this->setupInput(0);
+        this->setupOutput(0);
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        auto outPort = this->output(0);
+
+        //messages flush the pending buffer to keep the stream order
+        while (inPort->hasMessage())
+        {
+            this->flush(outPort);
+            outPort->postMessage(inPort->popMessage());
+        }
+
+        //the ports are generic, so elements and label indexes are bytes
+        const auto &buff = inPort->buffer();
+        if (buff.length != 0)
+        {
+            //a change of type ends the pending buffer
+            if (_pendingBytes != 0 and buff.dtype != _pending.dtype) this->flush(outPort);
+            if (_pendingBytes == 0)
+            {
+                _pending = outPort->getBuffer(buff.dtype, std::max<size_t>(_maxBytes/buff.dtype.size(), 1));
+                _pendingTime = std::chrono::high_resolution_clock::now();
+            }
+
+            const size_t numBytes = std::min(buff.length, _pending.length - _pendingBytes);
+            for (const auto &label : inPort->labels())
+            {
+                if (label.index >= numBytes) break;
+                _pendingLabels.push_back(label);
+                _pendingLabels.back().index += _pendingBytes;
+            }
+            std::memcpy(_pending.as<char *>() + _pendingBytes, buff.as<const void *>(), numBytes);
+            _pendingBytes += numBytes;
+            inPort->consume(numBytes);
+            if (_pendingBytes == _pending.length) this->flush(outPort);
+        }
+        if (_pendingBytes == 0) return;
+
+        //flush at the end of the latency window, otherwise wait within it
+        const auto remaining = (_pendingTime + _maxLatency) - std::chrono::high_resolution_clock::now();
+        if (remaining <= std::chrono::nanoseconds::zero()) return this->flush(outPort);
+        if (inPort->elements() != 0) return;
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(remaining),
+            std::chrono::nanoseconds(this->workInfo().maxTimeoutNs)));
+        this->yield();
+    }
+
+    void propagateLabels(const Pothos::InputPort *)
+    {
+        //the labels are posted with the coalesced buffer in flush()
+    }
+
+private:
+    void flush(Pothos::OutputPort *outPort)
+    {
+        if (_pendingBytes == 0) return;
+        for (const auto &label : _pendingLabels) outPort->postLabel(label);
+        _pendingLabels.clear();
+        _pending.length = _pendingBytes;
+        outPort->postBuffer(std::move(_pending));
+        _pending = Pothos::BufferChunk();
+        _pendingBytes = 0;
+    }
+
+    const size_t _maxBytes;
+    const std::chrono::nanoseconds _maxLatency;
+    Pothos::BufferChunk _pending;
+    size_t _pendingBytes;
+    std::vector<Pothos::Label> _pendingLabels;
+    std::chrono::high_resolution_clock::time_point _pendingTime;
+};
+
+static Pothos::BlockRegistry registerBufferCoalescer(
+    "/blocks/buffer_coalescer", &BufferCoalescer::make);
@@ -0,0 +1,434 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <Poco/Logger.h>
+#include <algorithm> //min
+#include <chrono>
+#include <cstring> //memcpy
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+/***********************************************************************
+ * The capture file records the traffic of one port for a replay:
+ *  - the header is the magic bytes and the dtype markup of the port
+ *  - each record is a type byte, the nanoseconds since the capture began,
+ *    and the length prefixed payload of the record:
+ *  - buffer payloads are the raw bytes of the stream
+ *  - label payloads are a serialized Label whose index is
+ *    relative to the first element of the next buffer record
+ *  - message payloads are the serialized message Object
+ * Integers are in the native byte order of the capturing host.
+ **********************************************************************/
+static const char CaptureMagic[8] = {'P', 'T', 'H', 'S', 'C', 'A', 'P', '1'};
+
+enum CaptureRecordType : uint8_t
+{
+    CAPTURE_BUFFER = 0,
+    CAPTURE_LABEL = 1,
+    CAPTURE_MESSAGE = 2,
+};
+
+static uint64_t nowNs(void)
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/***********************************************************************
+ * |PothosDoc Port Capture
+ *
+ * The port capture records the buffers, labels, and messages of its input
+ * with their arrival times into a capture file for the port replay block.
+ * Connect the capture alongside the existing consumer of an output port,
+ * so the capture tees the production traffic without changing the flow.
+ * The file is opened upon activation and written until deactivation.
+ *
+ * |category /Benchmark
+ * |keywords capture record tee file benchmark
+ *
+ * |param path[File Path] The path of the capture file to write.
+ * |default "capture.bin"
+ *
+ * |param dtype[Data Type] The data type of the captured port.
+ * An empty type captures the stream as bytes.
+ * |default ""
+ *
+ * |factory /blocks/port_capture(path, dtype)
+ **********************************************************************/
+class PortCapture : public Pothos::Block
+{
+public:
+    static Block *make(const std::string &path, const std::string &dtype)
+    {
+        return new PortCapture(path, dtype);
+    }
+
+    PortCapture(const std::string &path, const std::string &dtype):
+        _path(path),
+        _startNs(0),
+        _numRecords(0),
+        _numBytes(0)
+    {
+        this->setupInput(0, dtype);
+        this->registerCall(this, POTHOS_FCN_TUPLE(PortCapture, getNumRecords));
+        this->registerCall(this, POTHOS_FCN_TUPLE(PortCapture, getNumBytes));
+    }
+
+    unsigned long long getNumRecords(void) const
+    {
+        return _numRecords;
+    }
+
+    unsigned long long getNumBytes(void) const
+    {
+        return _numBytes;
+    }
+
+    void activate(void)
+    {
+        _file.open(_path, std::ios::binary | std::ios::trunc);
+        if (not _file) throw Pothos::OpenFileException("PortCapture::activate()", _path);
+        _file.write(CaptureMagic, sizeof(CaptureMagic));
+        this->writeString(this->input(0)->dtype().toMarkup());
+        _startNs = nowNs();
+        _numRecords = 0;
+        _numBytes = 0;
+    }
+
+    void deactivate(void)
+    {
+        _file.close();
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        const auto timeNs = nowNs()-_startNs;
+
+        while (inPort->hasMessage())
+        {
+            this->writeObject(CAPTURE_MESSAGE, timeNs, inPort->popMessage());
+        }
+
+        const size_t elems = inPort->elements();
+        if (elems == 0) return;
+
+        //the labels precede the buffer that they index into
+        for (const auto &label : inPort->labels())
+        {
+            if (label.index >= elems) break;
+            this->writeObject(CAPTURE_LABEL, timeNs, Pothos::Object(label));
+        }
+
+        const auto &buff = inPort->buffer();
+        const size_t numBytes = elems*inPort->dtype().size();
+        this->writeHeader(CAPTURE_BUFFER, timeNs, numBytes);
+        _file.write(buff.as<const char *>(), std::streamsize(numBytes));
+        inPort->consume(elems);
+        _numBytes += numBytes;
+    }
+
+    void propagateLabels(const Pothos::InputPort *)
+    {
+        //the capture has no outputs
+    }
+
+private:
+    void writeString(const std::string &s)
+    {
+        const uint32_t length(uint32_t(s.size()));
+        _file.write((const char *)&length, sizeof(length));
+        _file.write(s.data(), std::streamsize(s.size()));
+    }
+
+    void writeHeader(const CaptureRecordType type, const uint64_t timeNs, const uint64_t length)
+    {
+        _file.write((const char *)&type, sizeof(type));
+        _file.write((const char *)&timeNs, sizeof(timeNs));
+        _file.write((const char *)&length, sizeof(length));
+        if (not _file) throw Pothos::WriteFileException("PortCapture::work()", _path);
+        _numRecords++;
+    }
+
+    void writeObject(const CaptureRecordType type, const uint64_t timeNs, const Pothos::Object &obj)
+    {
+        std::ostringstream oss;
+        try
+        {
+            obj.serialize(oss);
+        }
+        catch (const Pothos::ObjectSerializeError &ex)
+        {
+            //a type without serialization support cannot be replayed
+            poco_warning_f2(Poco::Logger::get("Pothos.PortCapture"),
+                "%s: skipped record - %s", this->getName(), ex.displayText());
+            return;
+        }
+        const auto payload = oss.str();
+        this->writeHeader(type, timeNs, payload.size());
+        _file.write(payload.data(), std::streamsize(payload.size()));
+    }
+
+    const std::string _path;
+    std::ofstream _file;
+    uint64_t _startNs;
+    unsigned long long _numRecords;
+    unsigned long long _numBytes;
+};
+
+static Pothos::BlockRegistry registerPortCapture(
+    "/blocks/port_capture", &PortCapture::make);
+
+/***********************************************************************
+ * Load a capture file into memory, so the replay does not wait on the file
+ **********************************************************************/
+struct CaptureRecord
+{
+    CaptureRecordType type;
+    uint64_t timeNs;
+    Pothos::BufferChunk buffer;
+    Pothos::Object object;
+};
+
+static std::string readCaptureHeader(std::istream &file, const std::string &path)
+{
+    char magic[sizeof(CaptureMagic)];
+    file.read(magic, sizeof(magic));
+    if (not file or std::memcmp(magic, CaptureMagic, sizeof(magic)) != 0)
+    {
+        throw Pothos::DataFormatException("readCaptureHeader()", path + " is not a capture file");
+    }
+    uint32_t markupLength(0);
+    file.read((char *)&markupLength, sizeof(markupLength));
+    std::string markup(markupLength, '\0');
+    file.read(&markup[0], std::streamsize(markupLength));
+    if (not file) throw Pothos::DataFormatException("readCaptureHeader()", path + " has a truncated header");
+    return markup;
+}
+
+static void loadCaptureFile(const std::string &path, std::vector<CaptureRecord> &records)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (not file) throw Pothos::OpenFileException("loadCaptureFile()", path);
+    readCaptureHeader(file, path);
+
+    while (true)
+    {
+        CaptureRecord record;
+        uint64_t length(0);
+        file.read((char *)&record.type, sizeof(record.type));
+        file.read((char *)&record.timeNs, sizeof(record.timeNs));
+        file.read((char *)&length, sizeof(length));
+        if (not file) break; //end of file, a truncated record ends the capture
+
+        std::string payload(size_t(length), '\0');
+        file.read(&payload[0], std::streamsize(length));
+        if (not file) break;
+
+        if (record.type == CAPTURE_BUFFER)
+        {
+            record.buffer = Pothos::BufferChunk(size_t(length));
+            std::memcpy(record.buffer.as<void *>(), payload.data(), payload.size());
+        }
+        else
+        {
+            std::istringstream iss(payload);
+            record.object.deserialize(iss);
+        }
+        records.push_back(std::move(record));
+    }
+}
+
+/***********************************************************************
+ * |PothosDoc Port Replay
+ *
+ * The port replay feeds the traffic of a capture file from the port capture
+ * block into a single block, so the block can be benchmarked in isolation
+ * with production data. The capture is loaded into memory upon activation,
+ * and the output port has the data type of the captured port.
+ *
+ * In realtime mode, the records are posted at their captured times.
+ * Otherwise, the records are posted as fast as the downstream block consumes,
+ * and the throughput of the replay is the throughput of the block under test.
+ *
+ * |category /Benchmark
+ * |keywords capture replay file benchmark throughput
+ *
+ * |param path[File Path] The path of the capture file to read.
+ * |default "capture.bin"
+ *
+ * |param realtime[Realtime] Replay at the captured speed or at full speed.
+ * |default false
+ *
+ * |param repeat[Repeat] The number of passes over the capture file.
+ * A value of zero repeats the capture until deactivation.
+ * The replay signals the end of its stream after the last pass.
+ * |default 1
+ *
+ * |factory /blocks/port_replay(path, realtime)
+ * |setter setRepeat(repeat)
+ **********************************************************************/
+class PortReplay : public Pothos::Block
+{
+public:
+    static Block *make(const std::string &path, const bool realtime)
+    {
+        return new PortReplay(path, realtime);
+    }
+
+    PortReplay(const std::string &path, const bool realtime):
+        _path(path),
+        _realtime(realtime),
+        _repeat(1),
+        _numPasses(0),
+        _index(0),
+        _offset(0),
+        _passStartNs(0),
+        _firstNs(0),
+        _lastNs(0),
+        _numBytes(0)
+    {
+        //the header sets the type of the output port
+        std::ifstream file(path, std::ios::binary);
+        if (not file) throw Pothos::OpenFileException("PortReplay()", path);
+        this->setupOutput(0, readCaptureHeader(file, path));
+        this->registerCall(this, POTHOS_FCN_TUPLE(PortReplay, setRepeat));
+        this->registerCall(this, POTHOS_FCN_TUPLE(PortReplay, getRepeat));
+        this->registerCall(this, POTHOS_FCN_TUPLE(PortReplay, getNumBytes));
+        this->registerCall(this, POTHOS_FCN_TUPLE(PortReplay, getElapsed));
+        this->registerCall(this, POTHOS_FCN_TUPLE(PortReplay, getThroughput));
+    }
+
+    void setRepeat(const size_t repeat)
+    {
+        _repeat = repeat;
+    }
+
+    size_t getRepeat(void) const
+    {
+        return _repeat;
+    }
+
+    unsigned long long getNumBytes(void) const
+    {
+        return _numBytes;
+    }
+
+    //! The seconds from activation to the last posted buffer
+    double getElapsed(void) const
+    {
+        return (_lastNs-_firstNs)/1e9;
+    }
+
+    //! The replayed bytes per second
+    double getThroughput(void) const
+    {
+        const auto elapsed = this->getElapsed();
+        return (elapsed > 0.0)?(_numBytes/elapsed):0.0;
+    }
+
+    void activate(void)
+    {
+        _records.clear();
+        loadCaptureFile(_path, _records);
+        _numPasses = 0;
+        _index = 0;
+        _offset = 0;
+        _passStartNs = _firstNs = _lastNs = nowNs();
+        _numBytes = 0;
+    }
+
+    void deactivate(void)
+    {
+        _records.clear();
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+        while (true)
+        {
+            //wrap around for the next pass or end the replay
+            if (_index == _records.size())
+            {
+                if (_records.empty() or (_repeat != 0 and _numPasses+1 >= _repeat)) return this->endOfStream();
+                _numPasses++;
+                _index = 0;
+                _passStartNs = nowNs();
+            }
+
+            const auto &record = _records[_index];
+            if (_realtime)
+            {
+                const auto dueNs = _passStartNs + record.timeNs;
+                if (nowNs() < dueNs)
+                {
+                    this->scheduleWakeup(std::chrono::steady_clock::time_point(std::chrono::duration_cast<
+                        std::chrono::steady_clock::duration>(std::chrono::nanoseconds(dueNs))));
+                    return;
+                }
+            }
+
+            if (record.type == CAPTURE_MESSAGE)
+            {
+                outPort->postMessage(record.object);
+                _index++;
+                continue;
+            }
+
+            if (record.type == CAPTURE_LABEL)
+            {
+                _labels.push_back(record.object.convert<Pothos::Label>());
+                _index++;
+                continue;
+            }
+
+            //copy the buffer into the output port in pieces of the available space
+            const size_t elemSize = outPort->dtype().size();
+            const size_t remaining = (record.buffer.length-_offset)/elemSize;
+            if (remaining == 0)
+            {
+                _labels.clear();
+                _offset = 0;
+                _index++;
+                continue;
+            }
+            const size_t elems = std::min(outPort->elements(), remaining);
+            if (elems == 0) return;
+            const size_t firstElem = _offset/elemSize;
+            for (const auto &label : _labels)
+            {
+                if (label.index < firstElem or label.index >= firstElem+elems) continue;
+                auto adjusted = label;
+                adjusted.index -= firstElem;
+                outPort->postLabel(std::move(adjusted));
+            }
+            std::memcpy(outPort->buffer().as<void *>(), record.buffer.as<const char *>()+_offset, elems*elemSize);
+            outPort->produce(elems);
+            _offset += elems*elemSize;
+            _numBytes += elems*elemSize;
+            _lastNs = nowNs();
+            return;
+        }
+    }
+
+private:
+    const std::string _path;
+    const bool _realtime;
+    size_t _repeat;
+    size_t _numPasses;
+    std::vector<CaptureRecord> _records;
+    std::vector<Pothos::Label> _labels; //labels of the current buffer record
+    size_t _index; //the next record
+    size_t _offset; //bytes posted of the current buffer record
+    uint64_t _passStartNs;
+    uint64_t _firstNs;
+    uint64_t _lastNs;
+    unsigned long long _numBytes;
+};
+
+static Pothos::BlockRegistry registerPortReplay(
+    "/blocks/port_replay", &PortReplay::make);
@@ -1,13 +1,18 @@
-// Copyright (c) 2013-2016 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Plugin.hpp>
-#include <Pothos/Util/OrderedQueue.hpp>
 #include <Pothos/Framework/BufferManager.hpp>
 #include <cassert>
+#include <vector>
+#include <deque>
 
 /***********************************************************************
- * circular buffer implementation
+ * circular buffer implementation:
+ * The ring is byte granular, the front buffer is the entire contiguous
+ * writable region from the write position up to the oldest unreleased byte.
+ * Each pop hands out a managed buffer whose region is exactly the popped bytes.
+ * Managed buffers are recycled in ring order, so the next buffer chain holds.
  **********************************************************************/
 class CircularBufferManager :
     public Pothos::BufferManager,
@@ -15,9 +20,9 @@ class CircularBufferManager :
 {
 public:
     CircularBufferManager(void):
-        _frontAddress(0),
-        _bufferSize(0),
-        _bytesToPop(0)
+        _capacity(0),
+        _head(0),
+        _tail(0)
     {
         return;
     }
@@ -28,21 +33,21 @@ public:
 
         //create the circular buffer
         _circBuff = Pothos::SharedBuffer::makeCirc(
-            args.bufferSize*args.numBuffers, args.nodeAffinity);
-
-        //init the state variables
-        _frontAddress = _circBuff.getAddress();
-        _bufferSize = args.bufferSize;
+            args.bufferSize*args.numBuffers, args.nodeAffinity, args.hugePageSize);
+        if (args.lockMemory) _circBuff = _circBuff.lockMemory();
+        if (args.prefaultMemory) _circBuff.prefaultMemory();
+        _capacity = _circBuff.getLength();
 
         //size internal containers
-        _readyBuffs = Pothos::Util::OrderedQueue<Pothos::ManagedBuffer>(args.numBuffers);
+        _regionEnds.resize(args.numBuffers);
+        _released.resize(args.numBuffers);
 
         //allocate buffer token objects
         std::vector<Pothos::ManagedBuffer> managedBuffers(args.numBuffers);
         for (size_t i = 0; i < args.numBuffers; i++)
         {
             managedBuffers[i].reset(this->shared_from_this(), _circBuff, i/*slabIndex*/);
-            this->push(managedBuffers[i]);
+            _freeBuffs.push_back(managedBuffers[i]);
         }
 
         //set the next buffer pointers
@@ -51,66 +56,94 @@ public:
             managedBuffers[i].setNextBuffer(managedBuffers[i+1]);
         }
         managedBuffers.back().setNextBuffer(managedBuffers.front());
+
+        this->updateFrontBuffer();
     }
 
     bool empty(void) const
     {
-        return _readyBuffs.empty();
+        return not this->front();
     }
 
     void pop(const size_t numBytes)
     {
-        assert(not _readyBuffs.empty());
-        _bytesToPop += numBytes;
-
-        //re-use the buffer for small consumes
-        if (_bytesToPop*2 < _bufferSize)
-        {
-            auto buff = this->front();
-            buff.address += numBytes;
-            buff.length -= numBytes;
-            this->setFrontBuffer(buff);
-            return;
-        }
-
-        _readyBuffs.pop();
-
-        //increment front address and adjust for aliasing
-        assert(_bufferSize >= _bytesToPop);
-        _frontAddress += _bytesToPop;
-        _bytesToPop = 0;
-        if (_frontAddress >= _circBuff.getAddress() + _circBuff.getLength()) _frontAddress -= _circBuff.getLength();
-
-        //prepare the next buffer in the queue
-        if (_readyBuffs.empty()) this->setFrontBuffer(Pothos::BufferChunk::null());
-        else this->setCircFrontBuffer(_readyBuffs.front());
+        assert(not this->empty());
+        assert(numBytes <= _capacity - (_head - _tail));
+        if (numBytes == 0) return;
+
+        //the popped buffer covers exactly the popped bytes,
+        //and it is held until the state is updated in case its the last reference
+        const auto slabIndex = _frontBuff.getSlabIndex();
+        _frontBuff.reset(this->shared_from_this(), Pothos::SharedBuffer(this->frontAddress(), numBytes, _circBuff), slabIndex);
+        const Pothos::ManagedBuffer popped(std::move(_frontBuff));
+        _head += numBytes;
+        _regionEnds[slabIndex] = _head;
+        _inFlight.push_back(slabIndex);
+
+        this->updateFrontBuffer();
     }
 
     void push(const Pothos::ManagedBuffer &buff)
     {
-        assert(buff.getSlabIndex() < _readyBuffs.capacity());
+        const auto slabIndex = buff.getSlabIndex();
+        assert(slabIndex < _released.size());
+        _released[slabIndex] = buff;
 
-        const bool wasEmpty = _readyBuffs.empty();
-        _readyBuffs.push(buff, buff.getSlabIndex());
+        //advance the tail over the regions that are released in order,
+        //buffers released out of order wait for the older regions
+        while (not _inFlight.empty() and _released[_inFlight.front()])
+        {
+            const auto front = _inFlight.front();
+            _inFlight.pop_front();
+            _tail = _regionEnds[front];
+            _freeBuffs.push_back(std::move(_released[front]));
+        }
 
-        //prepare the next buffer in the queue
-        if (not _readyBuffs.empty() and wasEmpty) this->setCircFrontBuffer(_readyBuffs.front());
+        this->updateFrontBuffer();
     }
 
 private:
 
-    void setCircFrontBuffer(Pothos::ManagedBuffer &buff)
+    size_t frontAddress(void) const
     {
-        Pothos::SharedBuffer sbuff(_frontAddress, _bufferSize, _circBuff);
-        buff.reset(this->shared_from_this(), sbuff, buff.getSlabIndex());
-        this->setFrontBuffer(buff);
+        return _circBuff.getAddress() + size_t(_head % _capacity);
+    }
+
+    //set the front buffer to the writable region, or null when there is none
+    void updateFrontBuffer(void)
+    {
+        //the next buffer in ring order spans the rest of the ring,
+        //only a free buffer is reset since no other thread can read it
+        if (not _frontBuff and not _freeBuffs.empty())
+        {
+            _frontBuff = std::move(_freeBuffs.front());
+            _freeBuffs.pop_front();
+            _frontBuff.reset(this->shared_from_this(), Pothos::SharedBuffer(this->frontAddress(), _capacity, _circBuff), _frontBuff.getSlabIndex());
+        }
+
+        const size_t writable = size_t(_capacity - (_head - _tail));
+        if (writable == 0 or not _frontBuff)
+        {
+            this->setFrontBuffer(Pothos::BufferChunk::null());
+            return;
+        }
+
+        //the manager holds _frontBuff while the front chunk is replaced,
+        //so replacing the front chunk never releases the last reference
+        Pothos::BufferChunk frontBuff(_frontBuff);
+        frontBuff.length = writable;
+        this->setFrontBuffer(frontBuff);
     }
 
-    size_t _frontAddress;
-    size_t _bufferSize;
-    size_t _bytesToPop;
+    size_t _capacity;
+    unsigned long long _head; //total bytes popped
+    unsigned long long _tail; //total bytes released
     Pothos::SharedBuffer _circBuff;
-    Pothos::Util::OrderedQueue<Pothos::ManagedBuffer> _readyBuffs;
+    Pothos::ManagedBuffer _frontBuff;
+    std::deque<Pothos::ManagedBuffer> _freeBuffs;
+    std::deque<size_t> _inFlight; //slab indexes in ring order
+    std::vector<unsigned long long> _regionEnds;
+    std::vector<Pothos::ManagedBuffer> _released;
 };
 
 /***********************************************************************
@@ -0,0 +1,200 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Util/RingDeque.hpp>
+#include <Pothos/Framework/BufferManager.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include <algorithm> //min/max
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/***********************************************************************
+ * The elastic buffer manager rides out bursts of demand:
+ * When every buffer is checked out, another slab of buffers is allocated,
+ * up to the maxBuffers argument, so a bursty producer does not stall.
+ * After shrinkTimeout seconds of low demand, the newest extra slab retires:
+ * its ready buffers are freed at once, the rest as they are returned,
+ * and the slab memory is released with the last of its buffers.
+ * The ready buffers are handed out in the order of their return,
+ * and the buffers are not linked as contiguous with setNextBuffer().
+ **********************************************************************/
+class ElasticBufferManager :
+    public Pothos::BufferManager,
+    public std::enable_shared_from_this<ElasticBufferManager>
+{
+public:
+    ElasticBufferManager(void):
+        _bytesPopped(0),
+        _numBuffers(0)
+    {
+        return;
+    }
+
+    void init(const Pothos::BufferManagerArgs &args)
+    {
+        Pothos::BufferManager::init(args);
+        _args = args;
+        _args.maxBuffers = std::max(args.maxBuffers, args.numBuffers);
+        if (args.numBuffers == 0) throw Pothos::BufferManagerFactoryError(
+            "ElasticBufferManager::init()", "numBuffers must be positive");
+        const size_t alignment = std::max<size_t>(args.alignment, 1);
+        if ((alignment & (alignment-1)) != 0) throw Pothos::BufferManagerFactoryError(
+            "ElasticBufferManager::init()", "alignment must be a power of two: "+std::to_string(args.alignment));
+        _readyBuffs = Pothos::Util::RingDeque<Pothos::ManagedBuffer>(_args.maxBuffers);
+        _lastDemand = std::chrono::steady_clock::now();
+        this->allocateSlab(args.numBuffers);
+    }
+
+    bool empty(void) const
+    {
+        return _readyBuffs.empty();
+    }
+
+    void pop(const size_t numBytes)
+    {
+        assert(not _readyBuffs.empty());
+        _bytesPopped += numBytes;
+
+        //re-use the buffer for small consumes
+        if (_bytesPopped*2 < _args.bufferSize)
+        {
+            auto buff = this->front();
+            buff.address += numBytes;
+            buff.length -= numBytes;
+            this->setFrontBuffer(buff);
+            return;
+        }
+
+        _bytesPopped = 0;
+        _readyBuffs.pop_front();
+
+        //more buffers than the steady state are out, the demand is high
+        const size_t numOut = _numBuffers - _readyBuffs.size();
+        if (numOut > _args.numBuffers) _lastDemand = std::chrono::steady_clock::now();
+
+        //grow on a burst that took the last ready buffer
+        if (_readyBuffs.empty() and _numBuffers < _args.maxBuffers)
+        {
+            _lastDemand = std::chrono::steady_clock::now();
+            this->allocateSlab(std::min(_args.numBuffers, _args.maxBuffers - _numBuffers));
+        }
+
+        if (_readyBuffs.empty()) this->setFrontBuffer(Pothos::BufferChunk::null());
+        else this->setFrontBuffer(_readyBuffs.front());
+    }
+
+    void push(const Pothos::ManagedBuffer &buff)
+    {
+        //buffers of a retiring slab are freed rather than reused
+        auto &slab = _slabs.at(buff.getSlabIndex());
+        if (slab.retiring) return this->retireBuffer(buff);
+
+        if (_readyBuffs.empty()) this->setFrontBuffer(buff);
+        _readyBuffs.push_back(buff);
+
+        //retire the newest extra slab after a period of low demand
+        if (_slabs.size() > 1 and _bytesPopped == 0 and
+            std::chrono::steady_clock::now() - _lastDemand > std::chrono::duration<double>(_args.shrinkTimeout))
+        {
+            this->retireSlab();
+        }
+    }
+
+private:
+    struct Slab
+    {
+        Slab(void): numBuffers(0), retiring(false){}
+        size_t numBuffers; //buffers of this slab that are not yet freed
+        bool retiring;
+    };
+
+    void allocateSlab(const size_t numBuffers)
+    {
+        //reuse the entry of a slab that was entirely freed
+        size_t slabIndex = 0;
+        while (slabIndex < _slabs.size() and _slabs[slabIndex].numBuffers != 0) slabIndex++;
+        if (slabIndex == _slabs.size()) _slabs.resize(slabIndex+1);
+
+        //the buffers start at multiples of the stride from an aligned start
+        const size_t alignment = std::max<size_t>(_args.alignment, 1);
+        const size_t stride = ((_args.bufferSize + _args.padding + alignment - 1)/alignment)*alignment;
+        auto commonSlab = Pothos::SharedBuffer::make(
+            stride*numBuffers + alignment - 1, _args.nodeAffinity, _args.hugePageSize);
+        if (_args.lockMemory) commonSlab = commonSlab.lockMemory();
+        if (_args.prefaultMemory) commonSlab.prefaultMemory();
+        const size_t start = ((commonSlab.getAddress() + alignment - 1)/alignment)*alignment;
+
+        _slabs[slabIndex].numBuffers = numBuffers;
+        _slabs[slabIndex].retiring = false;
+        _numBuffers += numBuffers;
+        for (size_t i = 0; i < numBuffers; i++)
+        {
+            Pothos::SharedBuffer sharedBuff(start+(stride*i), _args.bufferSize, commonSlab);
+            Pothos::ManagedBuffer managedBuff;
+            managedBuff.reset(this->shared_from_this(), sharedBuff, slabIndex);
+            this->push(managedBuff);
+        }
+    }
+
+    void retireSlab(void)
+    {
+        //the first slab is the steady state and never retires
+        size_t slabIndex = _slabs.size()-1;
+        while (slabIndex > 0 and (_slabs[slabIndex].numBuffers == 0 or _slabs[slabIndex].retiring)) slabIndex--;
+        if (slabIndex == 0) return;
+        _slabs[slabIndex].retiring = true;
+        _lastDemand = std::chrono::steady_clock::now();
+
+        //free the ready buffers of the slab, except the current front buffer
+        const size_t numReady = _readyBuffs.size();
+        for (size_t i = 0; i < numReady; i++)
+        {
+            auto buff = _readyBuffs.front();
+            _readyBuffs.pop_front();
+            if (i != 0 and buff.getSlabIndex() == slabIndex) this->retireBuffer(buff);
+            else _readyBuffs.push_back(buff);
+        }
+        if (not _readyBuffs.empty()) this->setFrontBuffer(_readyBuffs.front());
+    }
+
+    void retireBuffer(const Pothos::ManagedBuffer &buff)
+    {
+        auto &slab = _slabs.at(buff.getSlabIndex());
+        assert(slab.numBuffers != 0);
+        slab.numBuffers--;
+        _numBuffers--;
+
+        //detach the buffer from this manager so it is deleted rather than returned,
+        //and the slab memory is freed with the last buffer that references it
+        Pothos::ManagedBuffer mb(buff);
+        mb.reset(Pothos::BufferManager::Sptr(), Pothos::SharedBuffer(), 0);
+
+        //trim the unused entries at the end of the list
+        while (_slabs.size() > 1 and _slabs.back().numBuffers == 0) _slabs.pop_back();
+    }
+
+    size_t _bytesPopped;
+    size_t _numBuffers; //total buffers of all slabs
+    Pothos::BufferManagerArgs _args;
+    std::vector<Slab> _slabs;
+    std::chrono::steady_clock::time_point _lastDemand;
+    Pothos::Util::RingDeque<Pothos::ManagedBuffer> _readyBuffs;
+};
+
+/***********************************************************************
+ * factory and registration
+ **********************************************************************/
+static Pothos::BufferManager::Sptr makeElasticBufferManager(void)
+{
+    return std::make_shared<ElasticBufferManager>();
+}
+
+pothos_static_block(pothosFrameworkRegisterElasticBufferManager)
+{
+    Pothos::PluginRegistry::addCall(
+        "/framework/buffer_manager/elastic",
+        &makeElasticBufferManager);
+}
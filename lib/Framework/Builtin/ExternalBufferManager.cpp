@@ -0,0 +1,167 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Framework/ExternalBufferManager.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include <Poco/Logger.h>
+#include <cassert>
+
+/***********************************************************************
+ * external buffer descriptor
+ **********************************************************************/
+Pothos::ExternalBuffer::ExternalBuffer(void):
+    address(0),
+    length(0),
+    handle(0)
+{
+    return;
+}
+
+Pothos::ExternalBuffer::ExternalBuffer(const size_t address, const size_t length, const size_t handle):
+    address(address),
+    length(length),
+    handle(handle)
+{
+    return;
+}
+
+/***********************************************************************
+ * external buffer implementation
+ **********************************************************************/
+Pothos::ExternalBufferManager::Sptr Pothos::ExternalBufferManager::make(
+    const std::vector<ExternalBuffer> &buffers,
+    const ReleaseFcn &release,
+    const AcquireFcn &acquire,
+    const std::shared_ptr<void> &owner)
+{
+    auto manager = std::make_shared<ExternalBufferManager>();
+    manager->setBuffers(buffers, owner);
+    manager->setReleaseCallback(release);
+    manager->setAcquireCallback(acquire);
+    return manager;
+}
+
+Pothos::ExternalBufferManager::ExternalBufferManager(void)
+{
+    return;
+}
+
+void Pothos::ExternalBufferManager::setBuffers(const std::vector<ExternalBuffer> &buffers, const std::shared_ptr<void> &owner)
+{
+    _buffers = buffers;
+    _owner = owner;
+}
+
+void Pothos::ExternalBufferManager::setAcquireCallback(const AcquireFcn &acquire)
+{
+    _acquire = acquire;
+}
+
+void Pothos::ExternalBufferManager::setReleaseCallback(const ReleaseFcn &release)
+{
+    _release = release;
+}
+
+void Pothos::ExternalBufferManager::init(const BufferManagerArgs &args)
+{
+    BufferManager::init(args);
+    _idleBuffs.resize(_buffers.size());
+    _poppedBytes.resize(_buffers.size());
+
+    //wrap the external memory, the owner is held while any buffer is in use
+    for (size_t i = 0; i < _buffers.size(); i++)
+    {
+        const auto &buffer = _buffers[i];
+        if (_handleToIndex.count(buffer.handle) != 0) throw Pothos::BufferManagerFactoryError(
+            "Pothos::ExternalBufferManager::init()", "duplicate handle " + std::to_string(buffer.handle));
+        _handleToIndex[buffer.handle] = i;
+        SharedBuffer sharedBuff(buffer.address, buffer.length, _owner);
+        _idleBuffs[i].reset(this->shared_from_this(), sharedBuff, i/*slabIndex*/);
+        if (not _acquire) _readyIndexes.push_back(i);
+    }
+
+    this->acquireFront();
+}
+
+bool Pothos::ExternalBufferManager::empty(void) const
+{
+    //polling the driver for the next buffer changes the front buffer,
+    //the callers of empty() hold the same lock as the callers of pop()
+    return not const_cast<ExternalBufferManager *>(this)->acquireFront();
+}
+
+void Pothos::ExternalBufferManager::pop(const size_t numBytes)
+{
+    assert(_frontBuff);
+    assert(numBytes <= _frontBuff.getBuffer().getLength());
+
+    //the popped buffer is held until the state is updated in case its the last reference
+    const auto index = _frontBuff.getSlabIndex();
+    _poppedBytes[index] = numBytes;
+    const ManagedBuffer popped(std::move(_frontBuff));
+    this->setFrontBuffer(BufferChunk::null());
+    this->acquireFront();
+}
+
+void Pothos::ExternalBufferManager::push(const ManagedBuffer &buff)
+{
+    const auto index = buff.getSlabIndex();
+    if (index >= _idleBuffs.size() or buff.getBufferManager().get() != this) throw Pothos::BufferPushError(
+        "Pothos::ExternalBufferManager::push()", "buffer does not belong to this manager");
+    _idleBuffs[index] = buff;
+
+    //the driver receives the buffer back, unless it was never acquired
+    if (_release) _release(_buffers[index].handle, _poppedBytes[index]);
+    _poppedBytes[index] = 0;
+    if (not _acquire) _readyIndexes.push_back(index);
+
+    this->acquireFront();
+}
+
+bool Pothos::ExternalBufferManager::acquireFront(void)
+{
+    if (_frontBuff) return true;
+
+    size_t index = 0;
+    if (_acquire)
+    {
+        size_t handle = 0;
+        if (not _acquire(handle)) return false;
+        const auto it = _handleToIndex.find(handle);
+        if (it == _handleToIndex.end() or not _idleBuffs[it->second])
+        {
+            poco_error_f1(Poco::Logger::get("Pothos.ExternalBufferManager"),
+                "acquired handle %s is unknown or already in use", std::to_string(handle));
+            return false;
+        }
+        index = it->second;
+    }
+    else
+    {
+        if (_readyIndexes.empty()) return false;
+        index = _readyIndexes.front();
+        _readyIndexes.pop_front();
+    }
+
+    //the manager holds _frontBuff while the front chunk is set,
+    //so replacing the front chunk never releases the last reference
+    _frontBuff = std::move(_idleBuffs[index]);
+    this->setFrontBuffer(BufferChunk(_frontBuff));
+    return true;
+}
+
+/***********************************************************************
+ * factory and registration
+ **********************************************************************/
+Pothos::BufferManager::Sptr makeExternalBufferManager(void)
+{
+    return std::make_shared<Pothos::ExternalBufferManager>();
+}
+
+pothos_static_block(pothosFrameworkRegisterExternalBufferManager)
+{
+    Pothos::PluginRegistry::addCall(
+        "/framework/buffer_manager/external",
+        &makeExternalBufferManager);
+}
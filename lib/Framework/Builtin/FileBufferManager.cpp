@@ -0,0 +1,151 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Framework/BufferManager.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include "Framework/MappedFile.hpp"
+#include <cassert>
+#include <deque>
+
+/***********************************************************************
+ * file buffer implementation:
+ * Each managed buffer is a window of a memory mapped file,
+ * the window at the front starts at the total number of bytes popped.
+ * A source replays a file by producing directly from the front buffer,
+ * and a block writes a file by filling the front buffer for its consumers;
+ * the data moves between the page cache and the blocks without a copy.
+ * Windows are not contiguous in memory, so buffers have no next buffer.
+ **********************************************************************/
+class FileBufferManager :
+    public Pothos::BufferManager,
+    public std::enable_shared_from_this<FileBufferManager>
+{
+public:
+    FileBufferManager(void):
+        _bufferSize(0),
+        _offset(0),
+        _windowOffset(0),
+        _bytesPopped(0)
+    {
+        return;
+    }
+
+    void init(const Pothos::BufferManagerArgs &args)
+    {
+        Pothos::BufferManager::init(args);
+        if (args.filePath.empty()) throw Pothos::BufferManagerFactoryError(
+            "FileBufferManager::init()", "filePath is required");
+        if (args.fileMode != "read" and args.fileMode != "write") throw Pothos::BufferManagerFactoryError(
+            "FileBufferManager::init()", "unknown fileMode: " + args.fileMode);
+
+        _bufferSize = args.bufferSize;
+        _file = MappedFile::open(args.filePath, args.fileMode == "write");
+
+        //allocate buffer token objects, the windows are mapped on demand
+        for (size_t i = 0; i < args.numBuffers; i++)
+        {
+            Pothos::ManagedBuffer token;
+            token.reset(this->shared_from_this(), Pothos::SharedBuffer::null(), i/*slabIndex*/);
+            _freeBuffs.push_back(token);
+        }
+
+        this->updateFrontBuffer();
+    }
+
+    bool empty(void) const
+    {
+        return not this->front();
+    }
+
+    void pop(const size_t numBytes)
+    {
+        assert(not this->empty());
+        assert(numBytes <= this->front().length);
+        _offset += numBytes;
+        _bytesPopped += numBytes;
+        _file->setFinalSize(_offset);
+
+        //re-use the window for small consumes
+        const auto &window = _frontBuff.getBuffer();
+        if (_bytesPopped*2 < _bufferSize and _offset < _windowOffset+window.getLength())
+        {
+            this->updateFrontBuffer();
+            return;
+        }
+
+        //the popped window is held until the state is updated in case its the last reference
+        const Pothos::ManagedBuffer popped(std::move(_frontBuff));
+        this->updateFrontBuffer();
+    }
+
+    void push(const Pothos::ManagedBuffer &buff)
+    {
+        //start the write back and unmap the window before the token is re-used
+        _file->flush(buff.getBuffer());
+        Pothos::ManagedBuffer token(buff);
+        token.reset(this->shared_from_this(), Pothos::SharedBuffer::null(), buff.getSlabIndex());
+        _freeBuffs.push_back(std::move(token));
+
+        this->updateFrontBuffer();
+    }
+
+private:
+
+    //set the front buffer to the window at the offset, or null when there is none
+    void updateFrontBuffer(void)
+    {
+        //map the next window from a free token, the mapping must start on an aligned offset
+        if (not _frontBuff and not _freeBuffs.empty())
+        {
+            const unsigned long long windowOffset = _offset - (_offset % MappedFile::alignment());
+            const auto window = _file->map(windowOffset, size_t(_offset-windowOffset)+_bufferSize);
+            if (window.getLength() > _offset-windowOffset)
+            {
+                _frontBuff = std::move(_freeBuffs.front());
+                _freeBuffs.pop_front();
+                _frontBuff.reset(this->shared_from_this(), window, _frontBuff.getSlabIndex());
+                _windowOffset = windowOffset;
+                _bytesPopped = 0;
+            }
+        }
+
+        //no free windows, or the reader is at the end of the file
+        if (not _frontBuff)
+        {
+            this->setFrontBuffer(Pothos::BufferChunk::null());
+            return;
+        }
+
+        //the manager holds _frontBuff while the front chunk is replaced,
+        //so replacing the front chunk never releases the last reference
+        const size_t skip = size_t(_offset-_windowOffset);
+        Pothos::BufferChunk frontBuff(_frontBuff);
+        frontBuff.address += skip;
+        frontBuff.length -= skip;
+        this->setFrontBuffer(frontBuff);
+    }
+
+    size_t _bufferSize;
+    MappedFile::Sptr _file;
+    unsigned long long _offset; //total bytes popped
+    unsigned long long _windowOffset; //file offset of the front window
+    size_t _bytesPopped; //bytes popped from the front window
+    Pothos::ManagedBuffer _frontBuff;
+    std::deque<Pothos::ManagedBuffer> _freeBuffs;
+};
+
+/***********************************************************************
+ * factory and registration
+ **********************************************************************/
+Pothos::BufferManager::Sptr makeFileBufferManager(void)
+{
+    return std::make_shared<FileBufferManager>();
+}
+
+pothos_static_block(pothosFrameworkRegisterFileBufferManager)
+{
+    Pothos::PluginRegistry::addCall(
+        "/framework/buffer_manager/file",
+        &makeFileBufferManager);
+}
@@ -0,0 +1,315 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <algorithm> //min/max
+#include <chrono>
+#include <thread>
+#include <deque>
+#include <vector>
+
+/***********************************************************************
+ * Credit flow control bounds the data in flight on a network flow.
+ * The gate in the sending process forwards a buffer when the window has credit,
+ * the return block in the receiving process forwards the buffer to the consumers,
+ * and posts one credit message with the buffer length once they release it.
+ * The credits travel back on a network flow in the reverse direction.
+ * Credits return in the order of the buffers, so the gate measures
+ * the round trip time of each buffer without a shared clock.
+ * The ports are generic, so elements and label indexes are bytes.
+ **********************************************************************/
+
+/***********************************************************************
+ * |PothosDoc Flow Credit Gate
+ *
+ * The flow credit gate forwards buffers from input port "0"
+ * while the bytes and buffers in flight are within the window,
+ * and takes back the credits on the "credits" input port.
+ * One buffer is always allowed in flight, so a large buffer cannot stall the flow.
+ * When the window is full, the gate leaves the data on its input,
+ * so the upstream blocks see the backpressure; or in drop-oldest mode,
+ * the gate keeps a window of the newest data and drops the older buffers.
+ * The adaptive window follows the bandwidth-delay product,
+ * twice the measured throughput times the round trip time,
+ * so a slow consumer keeps less stale data in flight.
+ * The topology inserts this block ahead of the network sink
+ * when credits are enabled with Topology::setNetworkFlowArgs().
+ *
+ * |category /Network
+ * |keywords credit window flow control network
+ *
+ * |param windowBytes[Window Bytes] The most bytes in flight (the upper bound when adaptive).
+ * |default 1048576
+ *
+ * |param windowBuffers[Window Buffers] The most buffers in flight.
+ * |default 16
+ *
+ * |param adaptive[Adaptive] Size the window from the round trip time and throughput.
+ * |default false
+ *
+ * |param dropOldest[Drop Oldest] Drop the oldest data rather than apply backpressure.
+ * |default false
+ *
+ * |factory /blocks/flow_credit_gate(windowBytes, windowBuffers, adaptive, dropOldest)
+ **********************************************************************/
+class FlowCreditGate : public Pothos::Block
+{
+public:
+    static Block *make(const size_t windowBytes, const size_t windowBuffers, const bool adaptive, const bool dropOldest)
+    {
+        return new FlowCreditGate(windowBytes, windowBuffers, adaptive, dropOldest);
+    }
+
+    FlowCreditGate(const size_t windowBytes, const size_t windowBuffers, const bool adaptive, const bool dropOldest):
+        _maxBytes(std::max<size_t>(windowBytes, 1)),
+        _maxBuffers(std::max<size_t>(windowBuffers, 1)),
+        _adaptive(adaptive),
+        _dropOldest(dropOldest),
+        _windowBytes(_maxBytes),
+        _flightBytes(0),
+        _heldBytes(0),
+        _numDropped(0),
+        _rtt(0.0),
+        _rate(0.0),
+        _rateBytes(0)
+    {
+        this->setupInput(0);
+        this->setupInput("credits");
+        this->setupOutput(0);
+        this->registerCall(this, POTHOS_FCN_TUPLE(FlowCreditGate, getWindowBytes));
+        this->registerCall(this, POTHOS_FCN_TUPLE(FlowCreditGate, getBytesInFlight));
+        this->registerCall(this, POTHOS_FCN_TUPLE(FlowCreditGate, getNumDropped));
+        this->registerCall(this, POTHOS_FCN_TUPLE(FlowCreditGate, getRoundTripTime));
+    }
+
+    //! The current window in bytes
+    unsigned long long getWindowBytes(void) const
+    {
+        return _windowBytes;
+    }
+
+    //! The bytes sent without a returned credit
+    unsigned long long getBytesInFlight(void) const
+    {
+        return _flightBytes;
+    }
+
+    //! The number of buffers dropped in drop-oldest mode
+    unsigned long long getNumDropped(void) const
+    {
+        return _numDropped;
+    }
+
+    //! The smoothed round trip time of a buffer in seconds
+    double getRoundTripTime(void) const
+    {
+        return _rtt;
+    }
+
+    void activate(void)
+    {
+        _rateTime = std::chrono::high_resolution_clock::now();
+    }
+
+    void deactivate(void)
+    {
+        _held.clear();
+        _heldBytes = 0;
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        auto outPort = this->output(0);
+
+        //take back the credits of the released buffers
+        auto creditsPort = this->input("credits");
+        while (creditsPort->hasMessage())
+        {
+            this->credit(creditsPort->popMessage().convert<unsigned long long>());
+        }
+
+        //messages are not windowed, they stay in order with the held data
+        while (inPort->hasMessage())
+        {
+            if (not _held.empty()) break;
+            outPort->postMessage(inPort->popMessage());
+        }
+
+        //take the input when there is credit, or always in drop-oldest mode
+        const auto &buff = inPort->buffer();
+        if (buff.length != 0 and (_dropOldest or (_held.empty() and this->hasCredit(buff.length))))
+        {
+            _held.emplace_back();
+            _held.back().buffer = buff;
+            for (const auto &label : inPort->labels())
+            {
+                if (label.index >= buff.length) break;
+                _held.back().labels.push_back(label);
+            }
+            _heldBytes += buff.length;
+            inPort->consume(buff.length);
+        }
+
+        //drop the oldest held data beyond the window
+        while (_held.size() > 1 and (_heldBytes > _windowBytes or _held.size() > _maxBuffers))
+        {
+            _heldBytes -= _held.front().buffer.length;
+            _held.pop_front();
+            _numDropped++;
+        }
+
+        //send the held data within the window
+        while (not _held.empty() and this->hasCredit(_held.front().buffer.length))
+        {
+            auto &front = _held.front();
+            for (const auto &label : front.labels) outPort->postLabel(label);
+            _flightBytes += front.buffer.length;
+            _heldBytes -= front.buffer.length;
+            _sendTimes.push_back(std::chrono::high_resolution_clock::now());
+            outPort->postBuffer(std::move(front.buffer));
+            _held.pop_front();
+        }
+    }
+
+    void propagateLabels(const Pothos::InputPort *)
+    {
+        //the labels are posted with the held buffers in work()
+    }
+
+private:
+    bool hasCredit(const size_t numBytes) const
+    {
+        if (_sendTimes.empty()) return true;
+        if (_sendTimes.size() >= _maxBuffers) return false;
+        return _flightBytes + numBytes <= _windowBytes;
+    }
+
+    void credit(const unsigned long long numBytes)
+    {
+        if (_sendTimes.empty()) return; //credit from before a restart
+        const auto now = std::chrono::high_resolution_clock::now();
+        const double rtt = std::chrono::duration<double>(now - _sendTimes.front()).count();
+        _sendTimes.pop_front();
+        _flightBytes -= std::min<unsigned long long>(numBytes, _flightBytes);
+        _rtt = (_rtt == 0.0)?rtt:(0.875*_rtt + 0.125*rtt);
+        if (not _adaptive) return;
+
+        //measure the throughput over at least one round trip
+        _rateBytes += numBytes;
+        const double elapsed = std::chrono::duration<double>(now - _rateTime).count();
+        if (elapsed < std::max(_rtt, 1e-3)) return;
+        const double rate = _rateBytes/elapsed;
+        _rate = (_rate == 0.0)?rate:(0.75*_rate + 0.25*rate);
+        _rateBytes = 0;
+        _rateTime = now;
+
+        //twice the bandwidth-delay product, so the window can grow when the flow is window limited
+        _windowBytes = std::min<unsigned long long>(_maxBytes, (unsigned long long)(2.0*_rate*_rtt));
+    }
+
+    struct HeldBuffer
+    {
+        Pothos::BufferChunk buffer;
+        std::vector<Pothos::Label> labels;
+    };
+
+    const unsigned long long _maxBytes;
+    const size_t _maxBuffers;
+    const bool _adaptive;
+    const bool _dropOldest;
+    unsigned long long _windowBytes;
+    unsigned long long _flightBytes;
+    std::deque<std::chrono::high_resolution_clock::time_point> _sendTimes; //one per buffer in flight
+    std::deque<HeldBuffer> _held;
+    unsigned long long _heldBytes;
+    unsigned long long _numDropped;
+    double _rtt;
+    double _rate; //bytes per second
+    unsigned long long _rateBytes;
+    std::chrono::high_resolution_clock::time_point _rateTime;
+};
+
+static Pothos::BlockRegistry registerFlowCreditGate(
+    "/blocks/flow_credit_gate", &FlowCreditGate::make);
+
+/***********************************************************************
+ * |PothosDoc Flow Credit Return
+ *
+ * The flow credit return forwards buffers from input port "0" to output port "0",
+ * and posts the length of each buffer on the "credits" output port
+ * once the consumers release the buffer, in the order of the buffers.
+ * The topology inserts this block after the network source
+ * when credits are enabled with Topology::setNetworkFlowArgs().
+ *
+ * |category /Network
+ * |keywords credit window flow control network
+ *
+ * |factory /blocks/flow_credit_return()
+ **********************************************************************/
+class FlowCreditReturn : public Pothos::Block
+{
+public:
+    static Block *make(void)
+    {
+        return new FlowCreditReturn();
+    }
+
+    FlowCreditReturn(void)
+    {
+        this->setupInput(0);
+        this->setupOutput(0);
+        this->setupOutput("credits");
+    }
+
+    void deactivate(void)
+    {
+        _inFlight.clear();
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        auto outPort = this->output(0);
+        while (inPort->hasMessage()) outPort->postMessage(inPort->popMessage());
+
+        const auto &buff = inPort->buffer();
+        if (buff.length != 0)
+        {
+            for (const auto &label : inPort->labels())
+            {
+                if (label.index >= buff.length) break;
+                outPort->postLabel(label);
+            }
+            _inFlight.push_back(buff);
+            outPort->postBuffer(buff);
+            inPort->consume(buff.length);
+        }
+
+        //a buffer is released when this block holds the only reference
+        auto creditsPort = this->output("credits");
+        while (not _inFlight.empty() and _inFlight.front().unique())
+        {
+            creditsPort->postMessage((unsigned long long)(_inFlight.front().length));
+            _inFlight.pop_front();
+        }
+        if (_inFlight.empty() or inPort->elements() != 0) return;
+
+        //there is no notification when the consumers release a buffer, so check again shortly
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(
+            std::chrono::microseconds(100),
+            std::chrono::nanoseconds(this->workInfo().maxTimeoutNs)));
+        this->yield();
+    }
+
+    void propagateLabels(const Pothos::InputPort *)
+    {
+        //the labels are posted with the buffers in work()
+    }
+
+private:
+    std::deque<Pothos::BufferChunk> _inFlight;
+};
+
+static Pothos::BlockRegistry registerFlowCreditReturn(
+    "/blocks/flow_credit_return", &FlowCreditReturn::make);
@@ -4,7 +4,10 @@
 #include <Pothos/Plugin.hpp>
 #include <Pothos/Util/OrderedQueue.hpp>
 #include <Pothos/Framework/BufferManager.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include <algorithm> //max
 #include <cassert>
+#include <string>
 #include <iostream>
 
 /***********************************************************************
@@ -28,22 +31,31 @@ public:
         _bufferSize = args.bufferSize;
         _readyBuffs = Pothos::Util::OrderedQueue<Pothos::ManagedBuffer>(args.numBuffers);
 
+        //the buffers start at multiples of the stride from an aligned start
+        const size_t alignment = std::max<size_t>(args.alignment, 1);
+        if ((alignment & (alignment-1)) != 0) throw Pothos::BufferManagerFactoryError(
+            "GenericBufferManager::init()", "alignment must be a power of two: "+std::to_string(args.alignment));
+        const size_t stride = ((args.bufferSize + args.padding + alignment - 1)/alignment)*alignment;
+
         //allocate one large continuous slab
         auto commonSlab = Pothos::SharedBuffer::make(
-            args.bufferSize*args.numBuffers, args.nodeAffinity);
+            stride*args.numBuffers + alignment - 1, args.nodeAffinity, args.hugePageSize);
+        if (args.lockMemory) commonSlab = commonSlab.lockMemory();
+        if (args.prefaultMemory) commonSlab.prefaultMemory();
+        const size_t start = ((commonSlab.getAddress() + alignment - 1)/alignment)*alignment;
 
         //create managed buffers based on chunks from the slab
         std::vector<Pothos::ManagedBuffer> managedBuffers(args.numBuffers);
         for (size_t i = 0; i < args.numBuffers; i++)
         {
-            const size_t addr = commonSlab.getAddress()+(args.bufferSize*i);
+            const size_t addr = start+(stride*i);
             Pothos::SharedBuffer sharedBuff(addr, args.bufferSize, commonSlab);
             managedBuffers[i].reset(this->shared_from_this(), sharedBuff, i/*slabIndex*/);
             this->push(managedBuffers[i]);
         }
 
-        //set the next buffer pointers
-        for (size_t i = 0; i < managedBuffers.size()-1; i++)
+        //set the next buffer pointers when the buffers are contiguous
+        for (size_t i = 0; i+1 < managedBuffers.size() and stride == args.bufferSize; i++)
         {
             managedBuffers[i].setNextBuffer(managedBuffers[i+1]);
         }
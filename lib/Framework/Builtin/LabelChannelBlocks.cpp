@@ -0,0 +1,178 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <algorithm> //min
+#include <deque>
+#include <utility> //pair
+
+/***********************************************************************
+ * The label channel carries the labels and messages of a stream
+ * separately from the stream payload, such as over a second network flow.
+ * The payload buffers pass through both blocks without a copy.
+ * Each side frame is a Packet without payload, whose metadata holds
+ * the byte "offset" of the frame in the stream and the "length" it covers,
+ * and whose label indexes are relative to the frame offset.
+ * A message is a Packet whose metadata holds the "message" object.
+ * The merger releases payload bytes once a frame covers them,
+ * so labels arrive at their exact offset, and messages keep their order.
+ * The ports are generic, so elements and label indexes are bytes.
+ **********************************************************************/
+
+/***********************************************************************
+ * |PothosDoc Label Channel Splitter
+ *
+ * The label channel splitter forwards the stream payload on output port "0",
+ * and one side frame per call to work() on the "labels" output port,
+ * with the labels of the forwarded bytes and the messages of the input.
+ * The topology inserts this block ahead of the network sink
+ * when the label channel is enabled with Topology::setNetworkFlowArgs().
+ *
+ * |category /Network
+ * |keywords label channel network
+ *
+ * |factory /blocks/label_channel_splitter()
+ **********************************************************************/
+class LabelChannelSplitter : public Pothos::Block
+{
+public:
+    static Block *make(void)
+    {
+        return new LabelChannelSplitter();
+    }
+
+    LabelChannelSplitter(void):
+        _offset(0)
+    {
+        this->setupInput(0);
+        this->setupOutput(0);
+        this->setupOutput("labels");
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        auto sidePort = this->output("labels");
+
+        while (inPort->hasMessage())
+        {
+            Pothos::Packet message;
+            message.metadata["message"] = inPort->popMessage();
+            sidePort->postMessage(std::move(message));
+        }
+
+        const auto &buff = inPort->buffer();
+        if (buff.length == 0) return;
+
+        //the frame precedes the payload that it covers
+        Pothos::Packet frame;
+        frame.metadata["offset"] = Pothos::Object(_offset);
+        frame.metadata["length"] = Pothos::Object((unsigned long long)(buff.length));
+        for (const auto &label : inPort->labels())
+        {
+            if (label.index >= buff.length) break;
+            frame.labels.push_back(label);
+        }
+        sidePort->postMessage(std::move(frame));
+
+        this->output(0)->postBuffer(buff);
+        inPort->consume(buff.length);
+        _offset += buff.length;
+    }
+
+    void propagateLabels(const Pothos::InputPort *)
+    {
+        //the labels travel in the side frames
+    }
+
+private:
+    unsigned long long _offset;
+};
+
+static Pothos::BlockRegistry registerLabelChannelSplitter(
+    "/blocks/label_channel_splitter", &LabelChannelSplitter::make);
+
+/***********************************************************************
+ * |PothosDoc Label Channel Merger
+ *
+ * The label channel merger forwards the stream payload from input port "0"
+ * with the labels from the side frames on the "labels" input port.
+ * Payload is held until a side frame covers it, so the labels keep their offsets.
+ *
+ * |category /Network
+ * |keywords label channel network
+ *
+ * |factory /blocks/label_channel_merger()
+ **********************************************************************/
+class LabelChannelMerger : public Pothos::Block
+{
+public:
+    static Block *make(void)
+    {
+        return new LabelChannelMerger();
+    }
+
+    LabelChannelMerger(void):
+        _offset(0),
+        _covered(0)
+    {
+        this->setupInput(0);
+        this->setupInput("labels");
+        this->setupOutput(0);
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+
+        //unpack the side frames in order
+        auto sidePort = this->input("labels");
+        while (sidePort->hasMessage())
+        {
+            auto packet = sidePort->popMessage().convert<Pothos::Packet>();
+            const auto messageIt = packet.metadata.find("message");
+            if (messageIt != packet.metadata.end())
+            {
+                outPort->postMessage(messageIt->second);
+                continue;
+            }
+            const auto offset = packet.metadata.at("offset").convert<unsigned long long>();
+            for (auto &label : packet.labels)
+            {
+                const auto index = offset + label.index;
+                _labels.emplace_back(index, std::move(label));
+            }
+            _covered = offset + packet.metadata.at("length").convert<unsigned long long>();
+        }
+
+        //forward the covered payload with the labels that fall within it
+        auto inPort = this->input(0);
+        auto buff = inPort->buffer();
+        const size_t numBytes = size_t(std::min<unsigned long long>(buff.length, _covered - _offset));
+        if (numBytes == 0) return;
+        while (not _labels.empty() and _labels.front().first < _offset + numBytes)
+        {
+            auto &label = _labels.front().second;
+            label.index = _labels.front().first - _offset;
+            outPort->postLabel(std::move(label));
+            _labels.pop_front();
+        }
+        buff.length = numBytes;
+        outPort->postBuffer(std::move(buff));
+        inPort->consume(numBytes);
+        _offset += numBytes;
+    }
+
+    void propagateLabels(const Pothos::InputPort *)
+    {
+        //the labels are posted from the side frames in work()
+    }
+
+private:
+    unsigned long long _offset; //the stream bytes forwarded
+    unsigned long long _covered; //the stream bytes covered by frames
+    std::deque<std::pair<unsigned long long, Pothos::Label>> _labels; //by stream index
+};
+
+static Pothos::BlockRegistry registerLabelChannelMerger(
+    "/blocks/label_channel_merger", &LabelChannelMerger::make);
@@ -0,0 +1,124 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Framework/BufferManager.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include <algorithm> //max
+#include <cassert>
+#include <string>
+#include <vector>
+
+/***********************************************************************
+ * The lifo buffer manager hands out the most recently returned buffer,
+ * which is likely still in the cache from the last write and read,
+ * rather than the oldest returned buffer in slab order.
+ * The buffers are never linked as contiguous with setNextBuffer(),
+ * since the order of the buffers does not follow the slab,
+ * so consumers cannot amalgamate adjacent buffers from this manager.
+ * Use the generic manager for flows that benefit from the contiguity.
+ **********************************************************************/
+class LifoBufferManager :
+    public Pothos::BufferManager,
+    public std::enable_shared_from_this<LifoBufferManager>
+{
+public:
+    LifoBufferManager(void):
+        _bufferSize(0),
+        _bytesPopped(0)
+    {
+        return;
+    }
+
+    void init(const Pothos::BufferManagerArgs &args)
+    {
+        Pothos::BufferManager::init(args);
+        _bufferSize = args.bufferSize;
+        _readyBuffs.clear();
+        _readyBuffs.reserve(args.numBuffers);
+
+        //the buffers start at multiples of the stride from an aligned start
+        const size_t alignment = std::max<size_t>(args.alignment, 1);
+        if ((alignment & (alignment-1)) != 0) throw Pothos::BufferManagerFactoryError(
+            "LifoBufferManager::init()", "alignment must be a power of two: "+std::to_string(args.alignment));
+        const size_t stride = ((args.bufferSize + args.padding + alignment - 1)/alignment)*alignment;
+
+        //allocate one large continuous slab
+        auto commonSlab = Pothos::SharedBuffer::make(
+            stride*args.numBuffers + alignment - 1, args.nodeAffinity, args.hugePageSize);
+        if (args.lockMemory) commonSlab = commonSlab.lockMemory();
+        if (args.prefaultMemory) commonSlab.prefaultMemory();
+        const size_t start = ((commonSlab.getAddress() + alignment - 1)/alignment)*alignment;
+
+        //create managed buffers based on chunks from the slab,
+        //pushed in reverse so the first buffer of the slab is handed out first
+        for (size_t i = args.numBuffers; i > 0; i--)
+        {
+            const size_t addr = start+(stride*(i-1));
+            Pothos::SharedBuffer sharedBuff(addr, args.bufferSize, commonSlab);
+            Pothos::ManagedBuffer managedBuff;
+            managedBuff.reset(this->shared_from_this(), sharedBuff, i-1/*slabIndex*/);
+            this->push(managedBuff);
+        }
+    }
+
+    bool empty(void) const
+    {
+        return _readyBuffs.empty();
+    }
+
+    void pop(const size_t numBytes)
+    {
+        assert(not _readyBuffs.empty());
+        _bytesPopped += numBytes;
+
+        //re-use the buffer for small consumes
+        if (_bytesPopped*2 < _bufferSize)
+        {
+            auto buff = this->front();
+            buff.address += numBytes;
+            buff.length -= numBytes;
+            this->setFrontBuffer(buff);
+            return;
+        }
+
+        _bytesPopped = 0;
+        _readyBuffs.pop_back();
+        if (_readyBuffs.empty()) this->setFrontBuffer(Pothos::BufferChunk::null());
+        else this->setFrontBuffer(_readyBuffs.back());
+    }
+
+    void push(const Pothos::ManagedBuffer &buff)
+    {
+        //a partially popped front buffer stays on top until it is done
+        if (_bytesPopped != 0)
+        {
+            assert(not _readyBuffs.empty());
+            _readyBuffs.insert(_readyBuffs.end()-1, buff);
+            return;
+        }
+        _readyBuffs.push_back(buff);
+        this->setFrontBuffer(buff);
+    }
+
+private:
+
+    size_t _bufferSize;
+    size_t _bytesPopped;
+    std::vector<Pothos::ManagedBuffer> _readyBuffs; //the back is the front buffer
+};
+
+/***********************************************************************
+ * factory and registration
+ **********************************************************************/
+static Pothos::BufferManager::Sptr makeLifoBufferManager(void)
+{
+    return std::make_shared<LifoBufferManager>();
+}
+
+pothos_static_block(pothosFrameworkRegisterLifoBufferManager)
+{
+    Pothos::PluginRegistry::addCall(
+        "/framework/buffer_manager/lifo",
+        &makeLifoBufferManager);
+}
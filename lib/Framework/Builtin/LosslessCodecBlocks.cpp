@@ -0,0 +1,382 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <algorithm> //min
+#include <cstring> //memcpy
+#include <cstdint>
+#include <string>
+
+/***********************************************************************
+ * The lossless codec packs streams of 16-bit integer or 32-bit float
+ * components, such as complex<int16> and complex<float> IQ samples.
+ * Each input buffer becomes one self-contained frame:
+ *  - u32 payload bytes, u32 raw bytes, u8 mode, u8 markup length,
+ *    u16 stride in components between the samples of a channel,
+ *    the markup of the buffer's DType, then the payload.
+ * The payload is made of blocks of 64 components, each block is one
+ * header byte with the bit width and the delta flag, and the components
+ * bit-packed at that width: zigzag integers or float bits, or their
+ * difference (integers) or xor (floats) from the previous sample
+ * of the same channel, whichever is narrower for the block.
+ * The trailing bytes of a partial component are copied as-is,
+ * and a frame that does not pack smaller is copied in the raw mode.
+ * All words are in the host byte order like the stream payload.
+ **********************************************************************/
+static const size_t FRAME_HEADER_BYTES = 12;
+static const size_t CODEC_BLOCK_SIZE = 64;
+
+enum LosslessCodecMode
+{
+    CODEC_RAW = 0,
+    CODEC_INT16 = 1,
+    CODEC_FLOAT32 = 2,
+};
+
+//! The codec mode for the components of the data type
+static LosslessCodecMode codecModeFor(const Pothos::DType &dtype)
+{
+    const size_t componentSize = dtype.elemSize()/(dtype.isComplex()?2:1);
+    if (dtype.isInteger() and dtype.isSigned() and componentSize == 2) return CODEC_INT16;
+    if (dtype.isFloat() and componentSize == 4) return CODEC_FLOAT32;
+    return CODEC_RAW;
+}
+
+static inline uint32_t zigzag(const int32_t x)
+{
+    return (uint32_t(x) << 1) ^ uint32_t(x >> 31);
+}
+
+static inline int32_t unzigzag(const uint32_t v)
+{
+    return int32_t(v >> 1) ^ -int32_t(v & 1);
+}
+
+static inline size_t bitWidth(uint32_t v)
+{
+    size_t width(0);
+    while (v != 0) {v >>= 1; width++;}
+    return width;
+}
+
+//! Load the component as a codec word and its predecessor in the channel
+template <typename T>
+static inline T loadComponent(const uint8_t *in, const size_t i)
+{
+    T x;
+    std::memcpy(&x, in + i*sizeof(T), sizeof(T));
+    return x;
+}
+
+//! The raw and delta words of component i for the mode
+static inline void codecWords(const LosslessCodecMode mode, const uint8_t *in, const size_t i, const size_t stride, uint32_t &raw, uint32_t &delta)
+{
+    if (mode == CODEC_INT16)
+    {
+        const int32_t x = loadComponent<int16_t>(in, i);
+        const int32_t prev = (i >= stride)?loadComponent<int16_t>(in, i-stride):0;
+        raw = zigzag(x);
+        delta = zigzag(x - prev);
+    }
+    else
+    {
+        raw = loadComponent<uint32_t>(in, i);
+        delta = raw ^ ((i >= stride)?loadComponent<uint32_t>(in, i-stride):0);
+    }
+}
+
+//! Pack the components, return the payload bytes written
+static size_t encodePayload(const LosslessCodecMode mode, const size_t stride, const uint8_t *in, const size_t rawBytes, uint8_t *out)
+{
+    const size_t wordSize = (mode == CODEC_INT16)?2:4;
+    const size_t numWords = rawBytes/wordSize;
+    uint8_t *p = out;
+    for (size_t start = 0; start < numWords; start += CODEC_BLOCK_SIZE)
+    {
+        const size_t n = std::min(CODEC_BLOCK_SIZE, numWords - start);
+        uint32_t raws[CODEC_BLOCK_SIZE], deltas[CODEC_BLOCK_SIZE];
+        uint32_t orRaw(0), orDelta(0);
+        for (size_t j = 0; j < n; j++)
+        {
+            codecWords(mode, in, start+j, stride, raws[j], deltas[j]);
+            orRaw |= raws[j];
+            orDelta |= deltas[j];
+        }
+        const size_t widthRaw = bitWidth(orRaw);
+        const size_t widthDelta = bitWidth(orDelta);
+        const bool useDelta = widthDelta < widthRaw;
+        const size_t width = useDelta?widthDelta:widthRaw;
+        const uint32_t *words = useDelta?deltas:raws;
+        *p++ = uint8_t(width | (useDelta?0x80:0));
+
+        uint64_t acc(0);
+        size_t numBits(0);
+        for (size_t j = 0; j < n; j++)
+        {
+            acc |= uint64_t(words[j]) << numBits;
+            numBits += width;
+            while (numBits >= 8)
+            {
+                *p++ = uint8_t(acc);
+                acc >>= 8;
+                numBits -= 8;
+            }
+        }
+        if (numBits != 0) *p++ = uint8_t(acc);
+    }
+
+    const size_t tail = rawBytes - numWords*wordSize;
+    std::memcpy(p, in + numWords*wordSize, tail);
+    return size_t(p - out) + tail;
+}
+
+//! Unpack the components, throw for a malformed payload
+static void decodePayload(const LosslessCodecMode mode, const size_t stride, const uint8_t *in, const size_t payloadBytes, uint8_t *out, const size_t rawBytes)
+{
+    const size_t wordSize = (mode == CODEC_INT16)?2:4;
+    const size_t numWords = rawBytes/wordSize;
+    const uint8_t *p = in;
+    const uint8_t *end = in + payloadBytes;
+    for (size_t start = 0; start < numWords; start += CODEC_BLOCK_SIZE)
+    {
+        const size_t n = std::min(CODEC_BLOCK_SIZE, numWords - start);
+        if (p == end) throw Pothos::DataFormatException("LosslessDecoder", "truncated block header");
+        const size_t width = *p & 0x3f;
+        const bool useDelta = (*p & 0x80) != 0;
+        p++;
+        if (width > 32 or size_t(end - p) < (n*width + 7)/8) throw Pothos::DataFormatException("LosslessDecoder", "malformed block");
+
+        uint64_t acc(0);
+        size_t numBits(0);
+        const uint64_t mask = (uint64_t(1) << width) - 1;
+        for (size_t j = 0; j < n; j++)
+        {
+            while (numBits < width)
+            {
+                acc |= uint64_t(*p++) << numBits;
+                numBits += 8;
+            }
+            const uint32_t v = uint32_t(acc & mask);
+            acc >>= width;
+            numBits -= width;
+
+            const size_t i = start+j;
+            if (mode == CODEC_INT16)
+            {
+                const int32_t prev = (useDelta and i >= stride)?loadComponent<int16_t>(out, i-stride):0;
+                const int16_t x = int16_t(useDelta?(prev + unzigzag(v)):unzigzag(v));
+                std::memcpy(out + i*2, &x, 2);
+            }
+            else
+            {
+                const uint32_t x = (useDelta and i >= stride)?(v ^ loadComponent<uint32_t>(out, i-stride)):v;
+                std::memcpy(out + i*4, &x, 4);
+            }
+        }
+    }
+
+    const size_t tail = rawBytes - numWords*wordSize;
+    if (size_t(end - p) != tail) throw Pothos::DataFormatException("LosslessDecoder", "payload length mismatch");
+    std::memcpy(out + numWords*wordSize, p, tail);
+}
+
+static inline void storeU32(uint8_t *p, const uint32_t v)
+{
+    for (size_t i = 0; i < 4; i++) p[i] = uint8_t(v >> (8*i));
+}
+
+static inline uint32_t loadU32(const uint8_t *p)
+{
+    uint32_t v(0);
+    for (size_t i = 0; i < 4; i++) v |= uint32_t(p[i]) << (8*i);
+    return v;
+}
+
+/***********************************************************************
+ * |PothosDoc Lossless Encoder
+ *
+ * The lossless encoder packs each input buffer into one frame on output port "0".
+ * The codec is chosen from the DType of each buffer: streams of 16-bit integers
+ * or 32-bit floats, such as complex int16 and complex float IQ samples,
+ * are bit-packed in blocks from the samples or their difference to the previous sample;
+ * other types and buffers that do not pack smaller are copied as-is.
+ * A label starts a new frame, so the decoder restores the label at its offset.
+ * The topology inserts this block ahead of the network sink
+ * when the codec is enabled with Topology::setNetworkFlowArgs().
+ *
+ * |category /Network
+ * |keywords codec compress lossless network iq
+ *
+ * |factory /blocks/lossless_encoder()
+ **********************************************************************/
+class LosslessEncoder : public Pothos::Block
+{
+public:
+    static Block *make(void)
+    {
+        return new LosslessEncoder();
+    }
+
+    LosslessEncoder(void):
+        _rawBytes(0),
+        _encodedBytes(0)
+    {
+        this->setupInput(0);
+        this->setupOutput(0);
+        this->registerCall(this, POTHOS_FCN_TUPLE(LosslessEncoder, getCompressionRatio));
+    }
+
+    //! The ratio of the input bytes to the encoded bytes so far
+    double getCompressionRatio(void) const
+    {
+        if (_encodedBytes == 0) return 1.0;
+        return double(_rawBytes)/double(_encodedBytes);
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        auto outPort = this->output(0);
+
+        while (inPort->hasMessage()) outPort->postMessage(inPort->popMessage());
+
+        //the ports are generic, so elements and label indexes are bytes
+        const auto &buff = inPort->buffer();
+        if (buff.length == 0) return;
+
+        //the frame ends ahead of the next label, labels are posted at the frame start
+        size_t rawBytes = buff.length;
+        for (const auto &label : inPort->labels())
+        {
+            if (label.index >= rawBytes) break;
+            if (label.index != 0) {rawBytes = label.index; break;}
+            auto frameLabel = label;
+            frameLabel.index = 0;
+            outPort->postLabel(std::move(frameLabel));
+        }
+
+        const auto &dtype = buff.dtype;
+        const auto markup = dtype.toMarkup().substr(0, 255);
+        const LosslessCodecMode mode = codecModeFor(dtype);
+        const size_t stride = std::max<size_t>(std::min<size_t>(dtype.size()/((mode == CODEC_INT16)?2:4), 0xffff), 1);
+        const size_t maxPayload = rawBytes + rawBytes/CODEC_BLOCK_SIZE + 1;
+        auto frame = outPort->getBuffer(Pothos::DType("uint8"), FRAME_HEADER_BYTES + markup.size() + maxPayload);
+        auto header = frame.as<uint8_t *>();
+        auto payload = header + FRAME_HEADER_BYTES + markup.size();
+        const auto in = buff.as<const uint8_t *>();
+
+        size_t payloadBytes = (mode == CODEC_RAW)?rawBytes:encodePayload(mode, stride, in, rawBytes, payload);
+        const bool packed = (mode != CODEC_RAW) and (payloadBytes < rawBytes);
+        if (not packed)
+        {
+            std::memcpy(payload, in, rawBytes);
+            payloadBytes = rawBytes;
+        }
+
+        storeU32(header+0, uint32_t(payloadBytes));
+        storeU32(header+4, uint32_t(rawBytes));
+        header[8] = uint8_t(packed?mode:CODEC_RAW);
+        header[9] = uint8_t(markup.size());
+        header[10] = uint8_t(stride);
+        header[11] = uint8_t(stride >> 8);
+        std::memcpy(header + FRAME_HEADER_BYTES, markup.data(), markup.size());
+
+        frame.length = FRAME_HEADER_BYTES + markup.size() + payloadBytes;
+        _rawBytes += rawBytes;
+        _encodedBytes += frame.length;
+        outPort->postBuffer(std::move(frame));
+        inPort->consume(rawBytes);
+    }
+
+    void propagateLabels(const Pothos::InputPort *)
+    {
+        //the labels are posted at the frame start in work()
+    }
+
+private:
+    unsigned long long _rawBytes;
+    unsigned long long _encodedBytes;
+};
+
+static Pothos::BlockRegistry registerLosslessEncoder(
+    "/blocks/lossless_encoder", &LosslessEncoder::make);
+
+/***********************************************************************
+ * |PothosDoc Lossless Decoder
+ *
+ * The lossless decoder restores the frames of the lossless encoder
+ * into buffers of the original DType on output port "0".
+ * Frames may arrive split or joined, the decoder waits for complete frames.
+ *
+ * |category /Network
+ * |keywords codec compress lossless network iq
+ *
+ * |factory /blocks/lossless_decoder()
+ **********************************************************************/
+class LosslessDecoder : public Pothos::Block
+{
+public:
+    static Block *make(void)
+    {
+        return new LosslessDecoder();
+    }
+
+    LosslessDecoder(void)
+    {
+        this->setupInput(0);
+        this->setupOutput(0);
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        auto outPort = this->output(0);
+
+        while (inPort->hasMessage()) outPort->postMessage(inPort->popMessage());
+
+        //wait for the complete frame in contiguous memory
+        const auto &buff = inPort->buffer();
+        if (buff.length < FRAME_HEADER_BYTES) return inPort->setReserve(FRAME_HEADER_BYTES);
+        const auto header = buff.as<const uint8_t *>();
+        const size_t payloadBytes = loadU32(header+0);
+        const size_t rawBytes = loadU32(header+4);
+        const size_t markupBytes = header[9];
+        const size_t frameBytes = FRAME_HEADER_BYTES + markupBytes + payloadBytes;
+        if (buff.length < frameBytes) return inPort->setReserve(frameBytes);
+        inPort->setReserve(0);
+
+        const auto mode = LosslessCodecMode(header[8]);
+        const size_t stride = size_t(header[10]) | (size_t(header[11]) << 8);
+        if (mode > CODEC_FLOAT32 or stride == 0) throw Pothos::DataFormatException("LosslessDecoder", "unknown frame mode");
+        const Pothos::DType dtype(std::string(reinterpret_cast<const char *>(header + FRAME_HEADER_BYTES), markupBytes));
+        const auto payload = header + FRAME_HEADER_BYTES + markupBytes;
+
+        auto out = outPort->getBuffer(dtype, (rawBytes + dtype.size() - 1)/dtype.size());
+        out.length = rawBytes;
+        if (mode == CODEC_RAW)
+        {
+            if (payloadBytes != rawBytes) throw Pothos::DataFormatException("LosslessDecoder", "payload length mismatch");
+            std::memcpy(out.as<void *>(), payload, rawBytes);
+        }
+        else decodePayload(mode, stride, payload, payloadBytes, out.as<uint8_t *>(), rawBytes);
+
+        //the labels of the frame return to the start of the restored buffer
+        for (const auto &label : inPort->labels())
+        {
+            if (label.index >= frameBytes) break;
+            auto outLabel = label;
+            outLabel.index = 0;
+            outPort->postLabel(std::move(outLabel));
+        }
+        outPort->postBuffer(std::move(out));
+        inPort->consume(frameBytes);
+    }
+
+    void propagateLabels(const Pothos::InputPort *)
+    {
+        //the labels are posted with the restored buffer in work()
+    }
+};
+
+static Pothos::BlockRegistry registerLosslessDecoder(
+    "/blocks/lossless_decoder", &LosslessDecoder::make);
@@ -0,0 +1,165 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <algorithm> //max
+#include <vector>
+
+/***********************************************************************
+ * Replicas run copies of a block on independent packets in parallel.
+ * Each replica is its own actor, so the thread pool runs the replicas
+ * concurrently, where a single block only runs on one thread at a time.
+ * The splitter deals packets to the replicas in round-robin order,
+ * and the merger collects the results in the same order,
+ * so the output sequence matches the input sequence.
+ * A replicated block must produce exactly one message per input message,
+ * such as a FEC decoder, a packet CRC check, or an FFT on independent frames.
+ **********************************************************************/
+
+/***********************************************************************
+ * |PothosDoc Replica Splitter
+ *
+ * The replica splitter forwards each input message or packet
+ * to the next output port in round-robin order.
+ *
+ * |category /Utility
+ * |keywords replica parallel round-robin
+ *
+ * |param numReplicas[Num Replicas] The number of output ports.
+ * |default 2
+ *
+ * |factory /blocks/replica/splitter(numReplicas)
+ **********************************************************************/
+class ReplicaSplitter : public Pothos::Block
+{
+public:
+    static Block *make(const size_t numReplicas)
+    {
+        return new ReplicaSplitter(numReplicas);
+    }
+
+    ReplicaSplitter(const size_t numReplicas):
+        _next(0)
+    {
+        this->setupInput(0);
+        for (size_t i = 0; i < std::max<size_t>(numReplicas, 1); i++) this->setupOutput(i);
+    }
+
+    void work(void)
+    {
+        //one message per replica each call, so a full replica applies backpressure
+        auto inPort = this->input(0);
+        for (size_t i = 0; i < this->outputs().size() and inPort->hasMessage(); i++)
+        {
+            this->output(_next)->postMessage(inPort->popMessage());
+            if (++_next == this->outputs().size()) _next = 0;
+        }
+    }
+
+private:
+    size_t _next;
+};
+
+static Pothos::BlockRegistry registerReplicaSplitter(
+    "/blocks/replica/splitter", &ReplicaSplitter::make);
+
+/***********************************************************************
+ * |PothosDoc Replica Merger
+ *
+ * The replica merger forwards one message from each input port in turn,
+ * which restores the order of a replica splitter.
+ * The merger waits on the port in turn, even when other ports have messages.
+ *
+ * |category /Utility
+ * |keywords replica parallel ordered merge
+ *
+ * |param numReplicas[Num Replicas] The number of input ports.
+ * |default 2
+ *
+ * |factory /blocks/replica/merger(numReplicas)
+ **********************************************************************/
+class ReplicaMerger : public Pothos::Block
+{
+public:
+    static Block *make(const size_t numReplicas)
+    {
+        return new ReplicaMerger(numReplicas);
+    }
+
+    ReplicaMerger(const size_t numReplicas):
+        _next(0)
+    {
+        for (size_t i = 0; i < std::max<size_t>(numReplicas, 1); i++) this->setupInput(i);
+        this->setupOutput(0);
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+        for (size_t i = 0; i < this->inputs().size(); i++)
+        {
+            auto inPort = this->input(_next);
+            if (not inPort->hasMessage()) return;
+            outPort->postMessage(inPort->popMessage());
+            if (++_next == this->inputs().size()) _next = 0;
+        }
+    }
+
+private:
+    size_t _next;
+};
+
+static Pothos::BlockRegistry registerReplicaMerger(
+    "/blocks/replica/merger", &ReplicaMerger::make);
+
+/***********************************************************************
+ * |PothosDoc Replicate
+ *
+ * Replicate creates a topology with copies of a block between
+ * a replica splitter and a replica merger.
+ * The remaining arguments are passed to the factory of each copy.
+ * The topology has one input port "0" and one output port "0".
+ *
+ * |category /Utility
+ * |keywords replica parallel scaling
+ *
+ * |param numReplicas[Num Replicas] The number of copies of the block.
+ * |default 2
+ *
+ * |param path[Path] The factory path of the block to replicate.
+ * |default ""
+ *
+ * |factory /blocks/replica/replicate(numReplicas, path)
+ **********************************************************************/
+static Pothos::Object makeReplicate(const Pothos::Object *args, const size_t numArgs)
+{
+    if (numArgs < 2) throw Pothos::InvalidArgumentException(
+        "/blocks/replica/replicate", "expected numReplicas, path, and factory arguments");
+    const auto numReplicas = args[0].convert<size_t>();
+    const auto path = args[1].convert<std::string>();
+    if (numReplicas == 0) throw Pothos::InvalidArgumentException(
+        "/blocks/replica/replicate", "numReplicas must be at least 1");
+
+    auto env = Pothos::ProxyEnvironment::make("managed");
+    auto registry = env->findProxy("Pothos/BlockRegistry");
+    std::vector<Pothos::Proxy> factoryArgs;
+    for (size_t i = 2; i < numArgs; i++) factoryArgs.push_back(env->convertObjectToProxy(args[i]));
+
+    auto topology = Pothos::Topology::make();
+    topology->setName("Replicate"+path);
+    auto splitter = Pothos::BlockRegistry::make("/blocks/replica/splitter", numReplicas);
+    auto merger = Pothos::BlockRegistry::make("/blocks/replica/merger", numReplicas);
+    topology->connect(topology, "0", splitter, 0);
+    topology->connect(merger, 0, topology, "0");
+    for (size_t i = 0; i < numReplicas; i++)
+    {
+        auto replica = registry.getHandle()->call(path, factoryArgs.data(), factoryArgs.size());
+        topology->connect(splitter, i, replica, 0);
+        topology->connect(replica, 0, merger, i);
+    }
+    return Pothos::Object(topology);
+}
+
+static Pothos::BlockRegistry registerReplicate(
+    "/blocks/replica/replicate", Pothos::Callable(&makeReplicate));
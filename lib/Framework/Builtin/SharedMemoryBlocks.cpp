@@ -0,0 +1,360 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Object.hpp>
+#include <Poco/Process.h>
+#include <Poco/Format.h>
+#include <algorithm> //min/max
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <sstream>
+#include <cstring> //memcpy
+#include <cstdint>
+#include <new>
+
+/***********************************************************************
+ * Shared memory layout for same-host cross-process flows:
+ * The stream data is a named circular buffer written by the sink
+ * and read by the source in another process on the same host.
+ * Labels and messages are serialized into records in a second
+ * circular buffer, and tagged with their absolute stream byte offset.
+ * Records are written before the stream data that they decorate,
+ * so stream data visible to the source has all of its records.
+ **********************************************************************/
+static const unsigned SHM_MAGIC = 0x50534d31;
+static const size_t SHM_RECORD_BYTES = 1 << 16;
+static const size_t SHM_DTYPE_BYTES = 256;
+
+//upper bound on how long work() polls the peer before yielding
+static const long long SHM_POLL_NS = 50000;
+
+struct SharedMemoryHeader
+{
+    unsigned magic;
+    unsigned long long dataBytes;
+    unsigned long long recordBytes;
+    std::atomic<unsigned long long> dataWritten;
+    std::atomic<unsigned long long> dataRead;
+    std::atomic<unsigned long long> recordsWritten;
+    std::atomic<unsigned long long> recordsRead;
+    std::atomic<bool> dtypeReady;
+    char dtype[SHM_DTYPE_BYTES];
+};
+
+static void pollPeer(Pothos::Block *block)
+{
+    const auto timeoutNs = std::min(block->workInfo().maxTimeoutNs, SHM_POLL_NS);
+    std::this_thread::sleep_for(std::chrono::nanoseconds(timeoutNs));
+    block->yield();
+}
+
+/***********************************************************************
+ * |PothosDoc Shared Memory Sink
+ *
+ * The shared memory sink writes an input stream, its labels,
+ * and its messages into named shared memory for a shared memory source
+ * in another process on the same host. The topology creates this block
+ * in place of a network sink for same-host cross-process connections.
+ *
+ * |category /Network
+ * |keywords shared memory ipc
+ *
+ * |param numBytes[Num Bytes] The size of the shared stream buffer.
+ * |default 1048576
+ *
+ * |factory /blocks/shared_memory_sink(numBytes)
+ **********************************************************************/
+class SharedMemorySink : public Pothos::Block
+{
+public:
+    static Block *make(const size_t numBytes)
+    {
+        return new SharedMemorySink(numBytes);
+    }
+
+    SharedMemorySink(const size_t numBytes):
+        _name(Poco::format("Pothos-%d-%u", int(Poco::Process::id()), nextMemoryIndex()++)),
+        _header(nullptr),
+        _recordOffset(0),
+        _dtypeReady(false)
+    {
+        this->setupInput(0);
+        this->registerCall(this, POTHOS_FCN_TUPLE(SharedMemorySink, getMemoryName));
+
+        _headerMem = Pothos::SharedBuffer::makeNamed(_name+"-hdr", sizeof(SharedMemoryHeader), true);
+        _header = new (reinterpret_cast<void *>(_headerMem.getAddress())) SharedMemoryHeader();
+        _dataMem = Pothos::SharedBuffer::makeCircNamed(_name+"-data", std::max<size_t>(numBytes, 1), true);
+        _recordMem = Pothos::SharedBuffer::makeCircNamed(_name+"-rec", SHM_RECORD_BYTES, true);
+        _header->dataBytes = _dataMem.getLength();
+        _header->recordBytes = _recordMem.getLength();
+        _header->dataWritten = 0;
+        _header->dataRead = 0;
+        _header->recordsWritten = 0;
+        _header->recordsRead = 0;
+        _header->dtypeReady = false;
+        _header->magic = SHM_MAGIC;
+    }
+
+    std::string getMemoryName(void) const
+    {
+        return _name;
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+
+        //a partially written record finishes before anything else
+        if (not this->flushRecord()) return pollPeer(this);
+
+        //messages are tagged with the current stream position
+        while (inPort->hasMessage())
+        {
+            const auto offset = _header->dataWritten.load(std::memory_order_relaxed);
+            if (not this->writeRecord('M', offset, inPort->popMessage())) return pollPeer(this);
+        }
+
+        const auto &buff = inPort->buffer();
+        if (buff.length == 0) return;
+
+        //the stream type is published once before the first data
+        if (not _dtypeReady)
+        {
+            const auto markup = buff.dtype.toMarkup();
+            if (markup.size() >= SHM_DTYPE_BYTES) throw Pothos::DTypeUnknownError(
+                "SharedMemorySink::work()", "dtype markup too long: " + markup);
+            std::memcpy(_header->dtype, markup.c_str(), markup.size()+1);
+            _header->dtypeReady.store(true, std::memory_order_release);
+            _dtypeReady = true;
+        }
+
+        //the input port is generic, so elements and label indexes are bytes
+        const auto written = _header->dataWritten.load(std::memory_order_relaxed);
+        const auto used = written - _header->dataRead.load(std::memory_order_acquire);
+        size_t numBytes = std::min<size_t>(size_t(_header->dataBytes - used), buff.length);
+        if (numBytes == 0) return pollPeer(this);
+
+        //labels go into records ahead of the data they decorate,
+        //when the record space runs out the data stops at the label
+        std::vector<Pothos::Label> labels;
+        for (const auto &label : inPort->labels())
+        {
+            if (label.index >= numBytes) break;
+            labels.push_back(label);
+        }
+        for (const auto &label : labels)
+        {
+            inPort->removeLabel(label);
+            auto absLabel = label;
+            absLabel.index += written;
+            if (this->writeRecord('L', absLabel.index, Pothos::Object(absLabel))) continue;
+            numBytes = size_t(label.index);
+            break;
+        }
+        if (numBytes == 0) return pollPeer(this);
+
+        std::memcpy(reinterpret_cast<void *>(_dataMem.getAddress() + size_t(written % _header->dataBytes)), buff.as<const void *>(), numBytes);
+        _header->dataWritten.store(written + numBytes, std::memory_order_release);
+        inPort->consume(numBytes);
+    }
+
+private:
+    static std::atomic<unsigned> &nextMemoryIndex(void)
+    {
+        static std::atomic<unsigned> index(0);
+        return index;
+    }
+
+    //serialize a record and write as much as possible
+    bool writeRecord(const char type, const unsigned long long offset, const Pothos::Object &obj)
+    {
+        std::ostringstream oss;
+        oss.write(&type, sizeof(type));
+        oss.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+        obj.serialize(oss);
+        const auto body = oss.str();
+        const uint32_t length = uint32_t(body.size());
+        _record.assign(reinterpret_cast<const char *>(&length), sizeof(length));
+        _record += body;
+        _recordOffset = 0;
+        return this->flushRecord();
+    }
+
+    //write the pending record into the free record space,
+    //records can be larger than the space, the source reads them in pieces
+    bool flushRecord(void)
+    {
+        if (_recordOffset == _record.size()) return true;
+        const auto written = _header->recordsWritten.load(std::memory_order_relaxed);
+        const auto used = written - _header->recordsRead.load(std::memory_order_acquire);
+        const size_t numBytes = std::min<size_t>(size_t(_header->recordBytes - used), _record.size() - _recordOffset);
+        std::memcpy(reinterpret_cast<void *>(_recordMem.getAddress() + size_t(written % _header->recordBytes)), _record.data() + _recordOffset, numBytes);
+        _header->recordsWritten.store(written + numBytes, std::memory_order_release);
+        _recordOffset += numBytes;
+        return _recordOffset == _record.size();
+    }
+
+    const std::string _name;
+    Pothos::SharedBuffer _headerMem;
+    Pothos::SharedBuffer _dataMem;
+    Pothos::SharedBuffer _recordMem;
+    SharedMemoryHeader *_header;
+    std::string _record;
+    size_t _recordOffset;
+    bool _dtypeReady;
+};
+
+static Pothos::BlockRegistry registerSharedMemorySink(
+    "/blocks/shared_memory_sink", &SharedMemorySink::make);
+
+/***********************************************************************
+ * |PothosDoc Shared Memory Source
+ *
+ * The shared memory source reads a stream, its labels, and its messages
+ * from the named shared memory of a shared memory sink in another process
+ * on the same host. The topology creates this block in place of
+ * a network source for same-host cross-process connections.
+ *
+ * |category /Network
+ * |keywords shared memory ipc
+ *
+ * |param name[Name] The memory name from the sink's getMemoryName().
+ * |default ""
+ *
+ * |factory /blocks/shared_memory_source(name)
+ **********************************************************************/
+class SharedMemorySource : public Pothos::Block
+{
+public:
+    static Block *make(const std::string &name)
+    {
+        return new SharedMemorySource(name);
+    }
+
+    SharedMemorySource(const std::string &name):
+        _header(nullptr),
+        _recordNeed(sizeof(uint32_t)),
+        _pendingType(0),
+        _pendingOffset(0)
+    {
+        this->setupOutput(0);
+
+        _headerMem = Pothos::SharedBuffer::makeNamed(name+"-hdr", sizeof(SharedMemoryHeader), false);
+        _header = reinterpret_cast<SharedMemoryHeader *>(_headerMem.getAddress());
+        if (_header->magic != SHM_MAGIC) throw Pothos::InvalidArgumentException(
+            "SharedMemorySource("+name+")", "bad shared memory header");
+        _dataMem = Pothos::SharedBuffer::makeCircNamed(name+"-data", size_t(_header->dataBytes), false);
+        _recordMem = Pothos::SharedBuffer::makeCircNamed(name+"-rec", size_t(_header->recordBytes), false);
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+
+        //stream data that is visible already has all of its records
+        const auto read = _header->dataRead.load(std::memory_order_relaxed);
+        const auto written = _header->dataWritten.load(std::memory_order_acquire);
+        if (written != read and not _dtype and _header->dtypeReady.load(std::memory_order_acquire))
+        {
+            _dtype = Pothos::DType(std::string(_header->dtype));
+        }
+        size_t numBytes = std::min<size_t>(size_t(written - read), outPort->elements());
+
+        //post messages up to the current position and decode labels,
+        //a message further ahead stops the data at its position
+        bool posted = false;
+        while (this->readRecord())
+        {
+            if (_pendingType == 'L')
+            {
+                _labels.push_back(_pendingObj.extract<Pothos::Label>());
+            }
+            else if (_pendingOffset <= read)
+            {
+                outPort->postMessage(_pendingObj);
+                posted = true;
+            }
+            else
+            {
+                numBytes = std::min<size_t>(numBytes, size_t(_pendingOffset - read));
+                break;
+            }
+            _pendingType = 0;
+        }
+
+        //whole elements of the stream type only
+        if (_dtype) numBytes -= numBytes % _dtype.size();
+        if (numBytes == 0)
+        {
+            if (not posted) pollPeer(this);
+            return;
+        }
+
+        auto buff = outPort->getBuffer(_dtype, numBytes/_dtype.size());
+        std::memcpy(buff.as<void *>(), reinterpret_cast<const void *>(_dataMem.getAddress() + size_t(read % _header->dataBytes)), buff.length);
+        _header->dataRead.store(read + buff.length, std::memory_order_release);
+
+        //labels are posted relative to the front of this buffer
+        while (not _labels.empty() and _labels.front().index < read + buff.length)
+        {
+            auto label = _labels.front();
+            _labels.erase(_labels.begin());
+            label.index -= std::min(label.index, read);
+            outPort->postLabel(label);
+        }
+        outPort->postBuffer(std::move(buff));
+    }
+
+private:
+    //read the next complete record into the pending record (true when pending)
+    bool readRecord(void)
+    {
+        if (_pendingType != 0) return true;
+        while (true)
+        {
+            const auto readCount = _header->recordsRead.load(std::memory_order_relaxed);
+            const auto available = _header->recordsWritten.load(std::memory_order_acquire) - readCount;
+            const size_t numBytes = std::min<size_t>(size_t(available), _recordNeed - _record.size());
+            if (numBytes == 0) return false;
+            _record.append(reinterpret_cast<const char *>(_recordMem.getAddress() + size_t(readCount % _header->recordBytes)), numBytes);
+            _header->recordsRead.store(readCount + numBytes, std::memory_order_release);
+            if (_record.size() != _recordNeed) continue;
+
+            //the length prefix sets the size of the body
+            if (_recordNeed == sizeof(uint32_t))
+            {
+                uint32_t length(0);
+                std::memcpy(&length, _record.data(), sizeof(length));
+                _recordNeed += length;
+                continue;
+            }
+
+            //decode the complete record
+            std::istringstream iss(_record.substr(sizeof(uint32_t)));
+            iss.read(&_pendingType, sizeof(_pendingType));
+            iss.read(reinterpret_cast<char *>(&_pendingOffset), sizeof(_pendingOffset));
+            _pendingObj = Pothos::Object();
+            _pendingObj.deserialize(iss);
+            _record.clear();
+            _recordNeed = sizeof(uint32_t);
+            return true;
+        }
+    }
+
+    Pothos::SharedBuffer _headerMem;
+    Pothos::SharedBuffer _dataMem;
+    Pothos::SharedBuffer _recordMem;
+    SharedMemoryHeader *_header;
+    Pothos::DType _dtype;
+    std::vector<Pothos::Label> _labels;
+    std::string _record;
+    size_t _recordNeed;
+    char _pendingType;
+    unsigned long long _pendingOffset;
+    Pothos::Object _pendingObj;
+};
+
+static Pothos::BlockRegistry registerSharedMemorySource(
+    "/blocks/shared_memory_source", &SharedMemorySource::make);
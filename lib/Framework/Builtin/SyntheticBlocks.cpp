@@ -0,0 +1,258 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Util/LatencyHistogram.hpp>
+#include <algorithm> //min/max
+#include <chrono>
+#include <cstring> //memcpy
+#include <cstdint>
+
+/***********************************************************************
+ * The synthetic blocks characterize the scheduler without DSP work.
+ * The source writes a timestamp into the first bytes of each buffer,
+ * the other blocks forward buffers and packets without copies,
+ * and the sink records the end-to-end latency of each timestamp.
+ **********************************************************************/
+static const size_t TimestampBytes = sizeof(uint64_t);
+
+static uint64_t nowNs(void)
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/***********************************************************************
+ * |PothosDoc Zero Source
+ *
+ * The zero source produces buffers of a fixed size without filling them.
+ * Only a timestamp is written into the first bytes of each buffer.
+ *
+ * |category /Benchmark
+ * |keywords synthetic benchmark source
+ *
+ * |param bufferBytes[Buffer Bytes] The size of each produced buffer in bytes.
+ * |default 8192
+ *
+ * |param packetMode[Packet Mode] Post packets rather than streaming buffers.
+ * |default false
+ *
+ * |factory /blocks/synthetic/zero_source(bufferBytes, packetMode)
+ **********************************************************************/
+class ZeroSource : public Pothos::Block
+{
+public:
+    static Block *make(const size_t bufferBytes, const bool packetMode)
+    {
+        return new ZeroSource(bufferBytes, packetMode);
+    }
+
+    ZeroSource(const size_t bufferBytes, const bool packetMode):
+        _bufferBytes(std::max(bufferBytes, TimestampBytes)),
+        _packetMode(packetMode),
+        _numBuffers(0),
+        _numBytes(0)
+    {
+        this->setupOutput(0);
+        this->registerCall(this, POTHOS_FCN_TUPLE(ZeroSource, getNumBuffers));
+        this->registerCall(this, POTHOS_FCN_TUPLE(ZeroSource, getNumBytes));
+    }
+
+    unsigned long long getNumBuffers(void) const
+    {
+        return _numBuffers;
+    }
+
+    unsigned long long getNumBytes(void) const
+    {
+        return _numBytes;
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+        const auto timestamp = nowNs();
+        if (_packetMode)
+        {
+            auto msg = outPort->getPacket(_bufferBytes);
+            std::memcpy(msg.ref<Pothos::Packet>().payload.as<void *>(), &timestamp, TimestampBytes);
+            outPort->postMessage(std::move(msg));
+            _numBytes += _bufferBytes;
+        }
+        else
+        {
+            const size_t numBytes = std::min(outPort->elements(), _bufferBytes);
+            if (numBytes < TimestampBytes) return;
+            std::memcpy(outPort->buffer().as<void *>(), &timestamp, TimestampBytes);
+            outPort->produce(numBytes);
+            _numBytes += numBytes;
+        }
+        _numBuffers++;
+    }
+
+private:
+    const size_t _bufferBytes;
+    const bool _packetMode;
+    unsigned long long _numBuffers;
+    unsigned long long _numBytes;
+};
+
+static Pothos::BlockRegistry registerZeroSource(
+    "/blocks/synthetic/zero_source", &ZeroSource::make);
+
+/***********************************************************************
+ * |PothosDoc Zero Sink
+ *
+ * The zero sink consumes all buffers and packets without reading them.
+ * Only the timestamp in the first bytes of each buffer is read,
+ * which records the latency since the buffer left the zero source.
+ * Contiguous stream buffers may be merged on the way to the sink,
+ * so the latency of the first buffer in each merged buffer is recorded.
+ *
+ * |category /Benchmark
+ * |keywords synthetic benchmark sink
+ *
+ * |factory /blocks/synthetic/zero_sink()
+ **********************************************************************/
+class ZeroSink : public Pothos::Block
+{
+public:
+    static Block *make(void)
+    {
+        return new ZeroSink();
+    }
+
+    ZeroSink(void):
+        _numBuffers(0),
+        _numBytes(0)
+    {
+        this->setupInput(0);
+        this->registerCall(this, POTHOS_FCN_TUPLE(ZeroSink, getNumBuffers));
+        this->registerCall(this, POTHOS_FCN_TUPLE(ZeroSink, getNumBytes));
+        this->registerCall(this, POTHOS_FCN_TUPLE(ZeroSink, getLatency));
+        this->registerCall(this, POTHOS_FCN_TUPLE(ZeroSink, getLatencyCount));
+        this->registerCall(this, POTHOS_FCN_TUPLE(ZeroSink, resetLatency));
+    }
+
+    unsigned long long getNumBuffers(void) const
+    {
+        return _numBuffers;
+    }
+
+    unsigned long long getNumBytes(void) const
+    {
+        return _numBytes;
+    }
+
+    //! The latency percentile in nanoseconds
+    unsigned long long getLatency(const double percentile) const
+    {
+        return _latency.percentile(percentile);
+    }
+
+    unsigned long long getLatencyCount(void) const
+    {
+        return _latency.count();
+    }
+
+    void resetLatency(void)
+    {
+        _latency.reset();
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage())
+        {
+            const auto msg = inPort->popMessage();
+            if (msg.type() != typeid(Pothos::Packet)) continue;
+            this->record(msg.extract<Pothos::Packet>().payload);
+        }
+
+        const auto &buff = inPort->buffer();
+        if (buff.length == 0) return;
+        this->record(buff);
+        inPort->consume(buff.length);
+    }
+
+private:
+    void record(const Pothos::BufferChunk &buff)
+    {
+        _numBuffers++;
+        _numBytes += buff.length;
+        if (buff.length < TimestampBytes) return;
+        uint64_t timestamp(0);
+        std::memcpy(&timestamp, buff.as<const void *>(), TimestampBytes);
+        const auto now = nowNs();
+        _latency.record((now > timestamp)?(now - timestamp):0);
+    }
+
+    unsigned long long _numBuffers;
+    unsigned long long _numBytes;
+    Pothos::Util::LatencyHistogram _latency;
+};
+
+static Pothos::BlockRegistry registerZeroSink(
+    "/blocks/synthetic/zero_sink", &ZeroSink::make);
+
+/***********************************************************************
+ * |PothosDoc Synthetic Forwarder
+ *
+ * The forwarder passes every buffer and message from its inputs
+ * to all of its outputs without copies.
+ * One input and one output is a passthrough,
+ * one input and many outputs is a fan-out,
+ * and many inputs with one output is a fan-in.
+ *
+ * |category /Benchmark
+ * |keywords synthetic benchmark passthrough fan-out fan-in
+ *
+ * |param numInputs[Num Inputs] The number of input ports.
+ * |default 1
+ *
+ * |param numOutputs[Num Outputs] The number of output ports.
+ * |default 1
+ *
+ * |factory /blocks/synthetic/forwarder(numInputs, numOutputs)
+ **********************************************************************/
+class SyntheticForwarder : public Pothos::Block
+{
+public:
+    static Block *make(const size_t numInputs, const size_t numOutputs)
+    {
+        return new SyntheticForwarder(numInputs, numOutputs);
+    }
+
+    SyntheticForwarder(const size_t numInputs, const size_t numOutputs)
+    {
+        for (size_t i = 0; i < std::max<size_t>(numInputs, 1); i++) this->setupInput(i);
+        for (size_t i = 0; i < std::max<size_t>(numOutputs, 1); i++) this->setupOutput(i);
+    }
+
+    void work(void)
+    {
+        for (auto inPort : this->inputs())
+        {
+            while (inPort->hasMessage())
+            {
+                const auto msg = inPort->popMessage();
+                for (auto outPort : this->outputs()) outPort->postMessage(msg);
+            }
+
+            const size_t numBytes = inPort->elements();
+            if (numBytes == 0) continue;
+            const auto buff = inPort->takeBuffer();
+            for (auto outPort : this->outputs()) outPort->postBuffer(Pothos::BufferChunk(buff));
+            inPort->consume(numBytes);
+        }
+    }
+
+    void propagateLabels(const Pothos::InputPort *)
+    {
+        //the source does not post labels
+    }
+};
+
+static Pothos::BlockRegistry registerSyntheticForwarder(
+    "/blocks/synthetic/forwarder", &SyntheticForwarder::make);
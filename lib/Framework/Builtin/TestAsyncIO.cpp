@@ -0,0 +1,171 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <Poco/TemporaryFile.h>
+#include <chrono>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h> //open
+#include <unistd.h> //close
+#endif
+
+static Pothos::AsyncIO::Handle openTestFile(const std::string &path)
+{
+    #ifdef _WIN32
+    return Pothos::AsyncIO::Handle(CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+        0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+    #else
+    return Pothos::AsyncIO::Handle(open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600));
+    #endif
+}
+
+static void closeTestFile(const Pothos::AsyncIO::Handle handle)
+{
+    #ifdef _WIN32
+    CloseHandle(HANDLE(handle));
+    #else
+    close(int(handle));
+    #endif
+}
+
+//pop the next completion, the transfer runs in the I/O pool
+static Pothos::AsyncIO::Completion waitCompletion(Pothos::AsyncIO &io)
+{
+    Pothos::AsyncIO::Completion completion;
+    const auto exitTime = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (not io.pop(completion) and std::chrono::steady_clock::now() < exitTime)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return completion;
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_async_io)
+{
+    Poco::TemporaryFile tempFile;
+    const auto handle = openTestFile(tempFile.path());
+    Pothos::Block block;
+    Pothos::AsyncIO io(&block, 2);
+    POTHOS_TEST_TRUE(io);
+    const size_t numBytes = 4096;
+
+    //submit two writes of a ramp at the positions in the file
+    Pothos::BufferChunk buff0(numBytes), buff1(numBytes);
+    for (size_t i = 0; i < numBytes; i++)
+    {
+        buff0.as<unsigned char *>()[i] = (unsigned char)(i);
+        buff1.as<unsigned char *>()[i] = (unsigned char)(i+numBytes);
+    }
+    POTHOS_TEST_TRUE(io.write(handle, buff0, 0));
+    POTHOS_TEST_TRUE(io.write(handle, buff1, numBytes));
+    POTHOS_TEST_TRUE(io.full());
+    POTHOS_TEST_FALSE(io.write(handle, buff1, 2*numBytes));
+
+    //completions are popped in submission order
+    auto c0 = waitCompletion(io);
+    POTHOS_TEST_TRUE(c0.isWrite);
+    POTHOS_TEST_EQUAL(c0.result, numBytes);
+    POTHOS_TEST_EQUAL(c0.buffer.address, buff0.address);
+    auto c1 = waitCompletion(io);
+    POTHOS_TEST_EQUAL(c1.result, numBytes);
+    POTHOS_TEST_EQUAL(c1.buffer.address, buff1.address);
+    POTHOS_TEST_EQUAL(io.pending(), 0);
+
+    //read back across both writes and past the end of the file
+    POTHOS_TEST_TRUE(io.read(handle, Pothos::BufferChunk(numBytes), numBytes/2));
+    POTHOS_TEST_TRUE(io.read(handle, Pothos::BufferChunk(numBytes), 2*numBytes));
+    auto c2 = waitCompletion(io);
+    POTHOS_TEST_FALSE(c2.isWrite);
+    POTHOS_TEST_EQUAL(c2.result, numBytes);
+    POTHOS_TEST_EQUAL(c2.buffer.length, numBytes);
+    size_t errors = 0;
+    for (size_t i = 0; i < numBytes; i++)
+    {
+        if (c2.buffer.as<const unsigned char *>()[i] != (unsigned char)(i+numBytes/2)) errors++;
+    }
+    POTHOS_TEST_EQUAL(errors, 0);
+    auto c3 = waitCompletion(io);
+    POTHOS_TEST_EQUAL(c3.result, 0); //end of file
+    POTHOS_TEST_EQUAL(c3.buffer.length, 0);
+
+    closeTestFile(handle);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_async_io_jobs)
+{
+    Pothos::Block block;
+    Pothos::AsyncIO io(&block, 2);
+
+    //jobs run in order on the I/O pool, and hold the optional buffer
+    const auto caller = std::this_thread::get_id();
+    std::thread::id jobThread;
+    POTHOS_TEST_TRUE(io.submit([&jobThread]
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        jobThread = std::this_thread::get_id();
+        return 42LL;
+    }));
+    Pothos::BufferChunk buff(64);
+    POTHOS_TEST_TRUE(io.submit([]{return 16LL;}, buff));
+    POTHOS_TEST_FALSE(io.submit([]{return 0LL;}));
+
+    auto c0 = waitCompletion(io);
+    POTHOS_TEST_EQUAL(c0.result, 42);
+    POTHOS_TEST_TRUE(jobThread != caller);
+    auto c1 = waitCompletion(io);
+    POTHOS_TEST_EQUAL(c1.result, 16);
+    POTHOS_TEST_EQUAL(c1.buffer.address, buff.address);
+    POTHOS_TEST_EQUAL(c1.buffer.length, 16);
+
+    //a throwing job completes with an error result
+    POTHOS_TEST_TRUE(io.submit([]() -> long long {throw Pothos::Exception("job failed");}));
+    POTHOS_TEST_TRUE(waitCompletion(io).result < 0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_async_io_gather)
+{
+    Poco::TemporaryFile tempFile;
+    const auto handle = openTestFile(tempFile.path());
+    Pothos::Block block;
+    Pothos::AsyncIO io(&block);
+
+    //a frame of header, payload, and trailer pieces
+    Pothos::BufferChunk pieces[3] = {Pothos::BufferChunk(4), Pothos::BufferChunk(100), Pothos::BufferChunk(2)};
+    Pothos::BufferChunkList frame;
+    unsigned char value = 0;
+    for (auto &piece : pieces)
+    {
+        for (size_t i = 0; i < piece.length; i++) piece.as<unsigned char *>()[i] = value++;
+        frame.append(piece);
+    }
+    frame.append(Pothos::BufferChunk()); //empty chunks are skipped
+    POTHOS_TEST_EQUAL(frame.size(), 3);
+    POTHOS_TEST_EQUAL(frame.length(), 106);
+
+    POTHOS_TEST_TRUE(io.write(handle, frame, 0));
+    auto c0 = waitCompletion(io);
+    POTHOS_TEST_TRUE(c0.isWrite);
+    POTHOS_TEST_EQUAL(c0.result, 106);
+    POTHOS_TEST_EQUAL(c0.buffers.size(), 3);
+
+    //the file holds the pieces in order, and so does the flattened list
+    POTHOS_TEST_TRUE(io.read(handle, Pothos::BufferChunk(1024), 0));
+    auto c1 = waitCompletion(io);
+    POTHOS_TEST_EQUAL(c1.result, 106);
+    const auto flat = frame.flatten();
+    POTHOS_TEST_EQUAL(flat.length, 106);
+    for (size_t i = 0; i < flat.length; i++)
+    {
+        POTHOS_TEST_EQUAL(c1.buffer.as<const unsigned char *>()[i], (unsigned char)(i));
+        POTHOS_TEST_EQUAL(flat.as<const unsigned char *>()[i], (unsigned char)(i));
+    }
+
+    //a single chunk flattens without a copy
+    POTHOS_TEST_EQUAL(Pothos::BufferChunkList(pieces[1]).flatten().address, pieces[1].address);
+
+    closeTestFile(handle);
+}
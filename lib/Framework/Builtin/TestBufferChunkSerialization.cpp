@@ -3,9 +3,13 @@
 
 #include <Pothos/Testing.hpp>
 #include <Pothos/Object.hpp>
+#include <Pothos/Object/Containers.hpp>
 #include <Pothos/Framework/BufferChunk.hpp>
+#include <Pothos/Archive.hpp>
+#include <Poco/TemporaryFile.h>
 #include <sstream>
 #include <cstdlib> //rand
+#include <cstring> //memcmp
 
 POTHOS_TEST_BLOCK("/framework/tests", test_buffer_chunk_serialization)
 {
@@ -30,3 +34,66 @@ POTHOS_TEST_BLOCK("/framework/tests", test_buffer_chunk_serialization)
         POTHOS_TEST_EQUAL(inputBuffer.as<int *>()[i], outputBuffer.as<int *>()[i]);
     }
 }
+
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_chunk_serialization_chunked)
+{
+    //larger than the chunk size and not a multiple of it
+    const size_t numBytes = (3 << 20) + 7;
+    Pothos::BufferChunk inputBuffer("uint8", numBytes);
+    for (size_t i = 0; i < numBytes; i++)
+    {
+        inputBuffer.as<unsigned char *>()[i] = (unsigned char)(i*7);
+    }
+
+    std::stringstream ss;
+    Pothos::Archive::OStreamArchiver ao(ss);
+    ao << inputBuffer;
+
+    //load into a larger caller-provided buffer without an allocation
+    Pothos::BufferChunk outputBuffer(numBytes*2);
+    const auto address = outputBuffer.address;
+    Pothos::Archive::IStreamArchiver ai(ss);
+    ai >> outputBuffer;
+    POTHOS_TEST_EQUAL(outputBuffer.address, address);
+    POTHOS_TEST_EQUAL(outputBuffer.length, numBytes);
+    POTHOS_TEST_TRUE(outputBuffer.dtype == inputBuffer.dtype);
+    POTHOS_TEST_EQUAL(std::memcmp(outputBuffer.as<const void *>(), inputBuffer.as<const void *>(), numBytes), 0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_chunk_serialize_file)
+{
+    Poco::TemporaryFile tempFile;
+    const size_t numElems = 100000;
+    Pothos::BufferChunk inputBuffer(Pothos::DType("int32"), numElems);
+    for (size_t i = 0; i < numElems; i++) inputBuffer.as<int *>()[i] = int(std::rand());
+
+    //a mixed payload with small and large buffers
+    Pothos::ObjectVector inputs;
+    inputs.emplace_back(Pothos::BufferChunk(Pothos::DType("int8"), 10));
+    inputs.emplace_back(inputBuffer);
+    inputs.emplace_back(std::string("calibration"));
+    Pothos::Object(inputs).serializeFile(tempFile.path());
+
+    Pothos::Object result;
+    result.deserializeFile(tempFile.path());
+    auto &outputs = result.ref<Pothos::ObjectVector>();
+    POTHOS_TEST_EQUAL(outputs.size(), 3);
+    POTHOS_TEST_EQUAL(outputs[0].ref<Pothos::BufferChunk>().length, 10);
+    POTHOS_TEST_EQUAL(outputs[2].ref<std::string>(), "calibration");
+
+    //the large payload is a page aligned view into the mapped file
+    const auto &outputBuffer = outputs[1].ref<Pothos::BufferChunk>();
+    const auto inputData = inputBuffer.as<const int *>();
+    POTHOS_TEST_TRUE(outputBuffer.dtype == inputBuffer.dtype);
+    POTHOS_TEST_EQUAL(outputBuffer.length, inputBuffer.length);
+    POTHOS_TEST_EQUAL(outputBuffer.address % 4096, 0);
+    const auto outputData = outputBuffer.as<int *>();
+    POTHOS_TEST_EQUALA(outputData, inputData, numElems);
+
+    //writing into the view does not change the file
+    outputData[0] = ~inputData[0];
+    Pothos::Object reloaded;
+    reloaded.deserializeFile(tempFile.path());
+    const auto &reloadedBuffer = reloaded.ref<Pothos::ObjectVector>()[1].ref<Pothos::BufferChunk>();
+    POTHOS_TEST_EQUAL(reloadedBuffer.as<const int *>()[0], inputData[0]);
+}
@@ -0,0 +1,448 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <Poco/TemporaryFile.h>
+#include <algorithm> //min
+#include <complex>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/***********************************************************************
+ * Helper blocks to feed small buffers and collect the coalesced stream
+ **********************************************************************/
+struct SmallBufferFeeder : Pothos::Block
+{
+    SmallBufferFeeder(const size_t total):
+        total(total),
+        count(0),
+        buffers(0)
+    {
+        this->setupOutput(0, "uint32");
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+        if (count == 0) outPort->postLabel("start", 123, 5);
+        if (count == total/2) outPort->postMessage(std::string("middle"));
+        const size_t n = std::min(total-count, std::min<size_t>(outPort->elements(), 10));
+        if (n == 0) return;
+        uint32_t *out = outPort->buffer();
+        for (size_t i = 0; i < n; i++) out[i] = uint32_t(count+i);
+        count += n;
+        buffers++;
+        outPort->produce(n);
+    }
+
+    size_t total;
+    size_t count;
+    size_t buffers;
+};
+
+struct CoalescedCollector : Pothos::Block
+{
+    CoalescedCollector(void):
+        buffers(0),
+        messages(0)
+    {
+        this->setupInput(0, "uint32");
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage())
+        {
+            inPort->popMessage();
+            messages++;
+        }
+        for (const auto &label : inPort->labels())
+        {
+            auto absLabel = label;
+            absLabel.index += values.size();
+            labels.push_back(absLabel);
+        }
+        if (inPort->elements() == 0) return;
+        const uint32_t *in = inPort->buffer();
+        values.insert(values.end(), in, in+inPort->elements());
+        inPort->consume(inPort->elements());
+        buffers++;
+    }
+
+    std::vector<uint32_t> values;
+    std::vector<Pothos::Label> labels;
+    size_t buffers;
+    size_t messages;
+};
+
+/***********************************************************************
+ * Coalesce a stream of small buffers with labels and messages
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_coalescer)
+{
+    const size_t total = 10000;
+    auto coalescer = Pothos::BlockRegistry::make("/blocks/buffer_coalescer", size_t(4000), 0.01);
+    auto feeder = std::shared_ptr<SmallBufferFeeder>(new SmallBufferFeeder(total));
+    auto collector = std::shared_ptr<CoalescedCollector>(new CoalescedCollector());
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, coalescer, 0);
+    topology.connect(coalescer, 0, collector, 0);
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive(0.1, 5.0));
+
+    //the data and labels keep their order, the message is forwarded
+    POTHOS_TEST_EQUAL(collector->values.size(), total);
+    for (size_t i = 0; i < collector->values.size(); i++)
+    {
+        if (collector->values[i] == uint32_t(i)) continue;
+        POTHOS_TEST_EQUAL(collector->values[i], uint32_t(i));
+    }
+    POTHOS_TEST_EQUAL(collector->labels.size(), 1);
+    POTHOS_TEST_EQUAL(collector->labels[0].id, "start");
+    POTHOS_TEST_EQUAL(collector->labels[0].index, 5);
+    POTHOS_TEST_EQUAL(collector->messages, 1);
+
+    //far fewer buffers arrive than were produced
+    std::cout << "produced " << feeder->buffers << " buffers, received " << collector->buffers << std::endl;
+    POTHOS_TEST_TRUE(collector->buffers*10 < feeder->buffers);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_network_flow_args)
+{
+    Pothos::Topology topology;
+    POTHOS_TEST_TRUE(topology.getNetworkFlowArgs().empty());
+    topology.setNetworkFlowArgs("{\"coalesceBytes\" : 65536, \"coalesceLatency\" : 0.002}");
+    POTHOS_TEST_EQUAL(topology.getNetworkFlowArgs(), "{\"coalesceBytes\" : 65536, \"coalesceLatency\" : 0.002}");
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("[1, 2]"), Pothos::InvalidArgumentException);
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{bad json"), Pothos::InvalidArgumentException);
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"coalesceBytes\" : -1}"), Pothos::InvalidArgumentException);
+
+    //transport preferences, globally and per flow
+    topology.setNetworkFlowArgs("{\"transport\" : [\"rdma\", \"tcp\"], \"flowTransports\" : {\"src[0]\" : \"rdma\"}}");
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"transport\" : 1}"), Pothos::InvalidArgumentException);
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"transport\" : [\"\"]}"), Pothos::InvalidArgumentException);
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"flowTransports\" : []}"), Pothos::InvalidArgumentException);
+
+    //relay trees for fan-out to remote processes
+    topology.setNetworkFlowArgs("{\"relayFanout\" : 2}");
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"relayFanout\" : -1}"), Pothos::InvalidArgumentException);
+
+    //side channel for labels and messages
+    topology.setNetworkFlowArgs("{\"labelChannel\" : true}");
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"labelChannel\" : \"yes\"}"), Pothos::InvalidArgumentException);
+
+    //credit windows, globally and per flow
+    topology.setNetworkFlowArgs("{\"credits\" : {\"bytes\" : 1048576, \"adaptive\" : true}, \"flowCredits\" : {\"src[0]\" : {\"dropOldest\" : true}}}");
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"credits\" : 1}"), Pothos::InvalidArgumentException);
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"credits\" : {\"bytes\" : -1}}"), Pothos::InvalidArgumentException);
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"credits\" : {\"buffers\" : 0}}"), Pothos::InvalidArgumentException);
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"flowCredits\" : []}"), Pothos::InvalidArgumentException);
+
+    //payload codecs, globally and per flow
+    topology.setNetworkFlowArgs("{\"codec\" : \"auto\", \"flowCodecs\" : {\"src[0]\" : \"none\"}}");
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"codec\" : \"zip\"}"), Pothos::InvalidArgumentException);
+    POTHOS_TEST_THROWS(topology.setNetworkFlowArgs("{\"flowCodecs\" : []}"), Pothos::InvalidArgumentException);
+}
+
+/***********************************************************************
+ * Split the labels and messages to a side channel and merge them back
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_label_channel)
+{
+    const size_t total = 10000;
+    auto splitter = Pothos::BlockRegistry::make("/blocks/label_channel_splitter");
+    auto merger = Pothos::BlockRegistry::make("/blocks/label_channel_merger");
+    auto feeder = std::shared_ptr<SmallBufferFeeder>(new SmallBufferFeeder(total));
+    auto collector = std::shared_ptr<CoalescedCollector>(new CoalescedCollector());
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, splitter, 0);
+    topology.connect(splitter, 0, merger, 0);
+    topology.connect(splitter, "labels", merger, "labels");
+    topology.connect(merger, 0, collector, 0);
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+
+    //the payload, labels, and messages arrive as sent
+    POTHOS_TEST_EQUAL(collector->values.size(), total);
+    for (size_t i = 0; i < collector->values.size(); i++)
+    {
+        if (collector->values[i] == uint32_t(i)) continue;
+        POTHOS_TEST_EQUAL(collector->values[i], uint32_t(i));
+    }
+    POTHOS_TEST_EQUAL(collector->labels.size(), 1);
+    POTHOS_TEST_EQUAL(collector->labels[0].id, "start");
+    POTHOS_TEST_EQUAL(collector->labels[0].index, 5);
+    POTHOS_TEST_EQUAL(collector->messages, 1);
+}
+
+/***********************************************************************
+ * Pack and restore a stream with the lossless codec
+ **********************************************************************/
+struct IQToneFeeder : Pothos::Block
+{
+    IQToneFeeder(const size_t total):
+        total(total),
+        count(0)
+    {
+        this->setupOutput(0, "complex_int16");
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+        if (count == total/2) outPort->postLabel("middle", 0, 0);
+        const size_t n = std::min(total-count, std::min<size_t>(outPort->elements(), 1000));
+        if (n == 0) return;
+        std::complex<int16_t> *out = outPort->buffer();
+        for (size_t i = 0; i < n; i++)
+        {
+            const double phase = (count+i)*0.01;
+            out[i] = std::complex<int16_t>(int16_t(3000*std::cos(phase)), int16_t(3000*std::sin(phase)));
+        }
+        count += n;
+        outPort->produce(n);
+    }
+
+    size_t total;
+    size_t count;
+};
+
+struct IQCollector : Pothos::Block
+{
+    IQCollector(void)
+    {
+        this->setupInput(0, "complex_int16");
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        for (const auto &label : inPort->labels()) labelIndexes.push_back(label.index + values.size());
+        if (inPort->elements() == 0) return;
+        const std::complex<int16_t> *in = inPort->buffer();
+        values.insert(values.end(), in, in+inPort->elements());
+        inPort->consume(inPort->elements());
+    }
+
+    std::vector<std::complex<int16_t>> values;
+    std::vector<unsigned long long> labelIndexes;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_lossless_codec)
+{
+    //types without a codec are copied, with the labels and messages
+    {
+        const size_t total = 10000;
+        auto encoder = Pothos::BlockRegistry::make("/blocks/lossless_encoder");
+        auto decoder = Pothos::BlockRegistry::make("/blocks/lossless_decoder");
+        auto feeder = std::shared_ptr<SmallBufferFeeder>(new SmallBufferFeeder(total));
+        auto collector = std::shared_ptr<CoalescedCollector>(new CoalescedCollector());
+
+        Pothos::Topology topology;
+        topology.connect(feeder, 0, encoder, 0);
+        topology.connect(encoder, 0, decoder, 0);
+        topology.connect(decoder, 0, collector, 0);
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+
+        POTHOS_TEST_EQUAL(collector->values.size(), total);
+        for (size_t i = 0; i < collector->values.size(); i++)
+        {
+            if (collector->values[i] == uint32_t(i)) continue;
+            POTHOS_TEST_EQUAL(collector->values[i], uint32_t(i));
+        }
+        POTHOS_TEST_EQUAL(collector->labels.size(), 1);
+        POTHOS_TEST_EQUAL(collector->labels[0].index, 5);
+        POTHOS_TEST_EQUAL(collector->messages, 1);
+    }
+
+    //complex int16 samples are packed and restored exactly
+    {
+        const size_t total = 100000;
+        auto encoder = Pothos::BlockRegistry::make("/blocks/lossless_encoder");
+        auto decoder = Pothos::BlockRegistry::make("/blocks/lossless_decoder");
+        auto feeder = std::shared_ptr<IQToneFeeder>(new IQToneFeeder(total));
+        auto collector = std::shared_ptr<IQCollector>(new IQCollector());
+
+        Pothos::Topology topology;
+        topology.connect(feeder, 0, encoder, 0);
+        topology.connect(encoder, 0, decoder, 0);
+        topology.connect(decoder, 0, collector, 0);
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+
+        POTHOS_TEST_EQUAL(collector->values.size(), total);
+        for (size_t i = 0; i < collector->values.size(); i++)
+        {
+            const double phase = i*0.01;
+            const std::complex<int16_t> expected(int16_t(3000*std::cos(phase)), int16_t(3000*std::sin(phase)));
+            if (collector->values[i] == expected) continue;
+            POTHOS_TEST_EQUAL(collector->values[i].real(), expected.real());
+            POTHOS_TEST_EQUAL(collector->values[i].imag(), expected.imag());
+        }
+        POTHOS_TEST_EQUAL(collector->labelIndexes.size(), 1);
+        POTHOS_TEST_EQUAL(collector->labelIndexes[0], total/2);
+
+        const auto ratio = encoder.call<double>("getCompressionRatio");
+        std::cout << "lossless codec ratio " << ratio << std::endl;
+        POTHOS_TEST_TRUE(ratio > 1.5);
+    }
+}
+
+/***********************************************************************
+ * Batch the small buffers at the input port of the collector
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_input_min_batch)
+{
+    //the final partial batch is released by the latency budget
+    const size_t total = 10000;
+    auto feeder = std::shared_ptr<SmallBufferFeeder>(new SmallBufferFeeder(total));
+    auto collector = std::shared_ptr<CoalescedCollector>(new CoalescedCollector());
+    collector->input(0)->setMinBatch(3000, 1000);
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, collector, 0);
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+
+    std::cout << "min batch: " << feeder->buffers << " buffers fed, "
+        << collector->buffers << " buffers collected" << std::endl;
+    POTHOS_TEST_EQUAL(collector->values.size(), total);
+    POTHOS_TEST_TRUE(collector->buffers < feeder->buffers);
+    POTHOS_TEST_EQUAL(collector->labels.size(), 1);
+    POTHOS_TEST_EQUAL(collector->messages, 1);
+}
+
+/***********************************************************************
+ * Capture a port alongside its consumer and replay it into a collector
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_port_capture_replay)
+{
+    const size_t total = 10000;
+    Poco::TemporaryFile tempFile;
+    auto feeder = std::shared_ptr<SmallBufferFeeder>(new SmallBufferFeeder(total));
+    auto collector = std::shared_ptr<CoalescedCollector>(new CoalescedCollector());
+    auto capture = Pothos::BlockRegistry::make("/blocks/port_capture", tempFile.path(), std::string("uint32"));
+
+    //deactivation closes the capture file
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, collector, 0);
+    topology.connect(feeder, 0, capture, 0);
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+    topology.disconnectAll();
+    topology.commit();
+    POTHOS_TEST_EQUAL(capture.call<unsigned long long>("getNumBytes"), total*sizeof(uint32_t));
+
+    for (const bool realtime : {false, true})
+    {
+        auto replay = Pothos::BlockRegistry::make("/blocks/port_replay", tempFile.path(), realtime);
+        auto replayed = std::shared_ptr<CoalescedCollector>(new CoalescedCollector());
+        topology.connect(replay, 0, replayed, 0);
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+        topology.disconnectAll();
+        topology.commit();
+
+        //the replay matches the traffic of the captured port
+        const double throughput = replay.call("getThroughput");
+        std::cout << "replay realtime " << realtime << ": " << throughput << " bytes/sec" << std::endl;
+        POTHOS_TEST_TRUE(replayed->values == collector->values);
+        POTHOS_TEST_EQUAL(replayed->labels.size(), 1);
+        POTHOS_TEST_EQUAL(replayed->labels[0].id, "start");
+        POTHOS_TEST_EQUAL(replayed->labels[0].index, 5);
+        POTHOS_TEST_EQUAL(replayed->messages, 1);
+        POTHOS_TEST_TRUE(throughput > 0.0);
+    }
+
+    //a batch run returns once the replay ended its stream and the data drained
+    auto replay = Pothos::BlockRegistry::make("/blocks/port_replay", tempFile.path(), false);
+    replay.call("setRepeat", size_t(3));
+    auto replayed = std::shared_ptr<CoalescedCollector>(new CoalescedCollector());
+    topology.connect(replay, 0, replayed, 0);
+    POTHOS_TEST_TRUE(topology.runToCompletion(10.0));
+    POTHOS_TEST_EQUAL(replayed->values.size(), 3*collector->values.size());
+    POTHOS_TEST_EQUAL(replayed->messages, 3);
+}
+
+/***********************************************************************
+ * Bound the buffers in flight with a credit window
+ **********************************************************************/
+struct HoldingCollector : Pothos::Block
+{
+    HoldingCollector(void):
+        numElements(0)
+    {
+        this->setupInput(0, "uint32");
+        this->registerCall(this, POTHOS_FCN_TUPLE(HoldingCollector, release));
+    }
+
+    void release(void)
+    {
+        held.clear();
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage()) inPort->popMessage();
+        if (inPort->elements() == 0) return;
+        numElements += inPort->elements();
+        held.push_back(inPort->takeBuffer());
+        inPort->consume(inPort->elements());
+    }
+
+    std::vector<Pothos::BufferChunk> held;
+    size_t numElements;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_flow_credits)
+{
+    auto feeder = std::shared_ptr<SmallBufferFeeder>(new SmallBufferFeeder(10000));
+    auto gate = Pothos::BlockRegistry::make("/blocks/flow_credit_gate", size_t(1 << 20), size_t(2), false, false);
+    auto credits = Pothos::BlockRegistry::make("/blocks/flow_credit_return");
+    auto collector = std::shared_ptr<HoldingCollector>(new HoldingCollector());
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, gate, 0);
+    topology.connect(gate, 0, credits, 0);
+    topology.connect(credits, 0, collector, 0);
+    topology.connect(credits, "credits", gate, "credits");
+    topology.commit();
+
+    //the window stops at two buffers while the consumer holds them
+    POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+    POTHOS_TEST_EQUAL(collector->held.size(), 2);
+    const unsigned long long inFlight = gate.call("getBytesInFlight");
+    POTHOS_TEST_EQUAL(inFlight, collector->numElements*sizeof(uint32_t));
+
+    //released buffers return credits for the next buffers
+    const auto numElements = collector->numElements;
+    collector->call("release");
+    POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+    POTHOS_TEST_EQUAL(collector->held.size(), 2);
+    POTHOS_TEST_TRUE(collector->numElements > numElements);
+    const double rtt = gate.call("getRoundTripTime");
+    POTHOS_TEST_TRUE(rtt > 0.0);
+    topology.disconnectAll();
+    topology.commit();
+
+    //drop-oldest keeps taking the input while the window is full
+    auto lossyGate = Pothos::BlockRegistry::make("/blocks/flow_credit_gate", size_t(1 << 20), size_t(2), false, true);
+    auto lossyFeeder = std::shared_ptr<SmallBufferFeeder>(new SmallBufferFeeder(10000));
+    collector->release();
+    topology.connect(lossyFeeder, 0, lossyGate, 0);
+    topology.connect(lossyGate, 0, credits, 0);
+    topology.connect(credits, 0, collector, 0);
+    topology.connect(credits, "credits", lossyGate, "credits");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+    POTHOS_TEST_EQUAL(collector->held.size(), 2);
+    const unsigned long long numDropped = lossyGate.call("getNumDropped");
+    POTHOS_TEST_TRUE(numDropped > 0);
+}
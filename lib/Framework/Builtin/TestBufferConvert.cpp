@@ -7,6 +7,8 @@
 #include <random>
 #include <cstdint>
 #include <complex>
+#include <algorithm>
+#include <vector>
 #include <iostream>
 
 /***********************************************************************
@@ -160,3 +162,257 @@ POTHOS_TEST_BLOCK("/framework/tests", test_buffer_convert)
     dispatchTests<long long, unsigned int>();
     dispatchTests<unsigned int, long long>();
 }
+
+/***********************************************************************
+ * vectorized conversion test cases
+ **********************************************************************/
+template <typename InType, typename OutType>
+void testBufferConvertLengths(const double range)
+{
+    std::cout << "testBufferConvertLengths: " << Pothos::DType(typeid(InType)).toString()
+        << " to " << Pothos::DType(typeid(OutType)).toString() << "...\t" << std::flush;
+
+    //vary the length to cover the vector body and the scalar tail
+    for (size_t numElems = 1; numElems < 70; numElems++)
+    {
+        Pothos::BufferChunk b0(typeid(InType), numElems);
+        for (size_t i = 0; i < numElems; i++)
+        {
+            b0.as<InType *>()[i] = InType((std::rand()/double(RAND_MAX)*2 - 1)*range);
+        }
+
+        const auto b1 = b0.convert(typeid(OutType), numElems);
+        for (size_t i = 0; i < numElems; i++)
+        {
+            const auto in = b0.as<const InType *>()[i];
+            const auto out = b1.as<const OutType *>()[i];
+            POTHOS_TEST_EQUAL(out, OutType(in));
+        }
+    }
+    std::cout << "OK" << std::endl;
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_convert_simd)
+{
+    //real pairs with vectorized kernels
+    testBufferConvertLengths<int8_t, float>(127);
+    testBufferConvertLengths<int16_t, float>(32767);
+    testBufferConvertLengths<int32_t, float>(2e9);
+    testBufferConvertLengths<float, int16_t>(32000);
+
+    //complex pairs with vectorized kernels
+    dispatchTests<int8_t, float>();
+    dispatchTests<int16_t, float>();
+    dispatchTests<float, float>();
+}
+
+/***********************************************************************
+ * scaled and saturating conversion test cases
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_convert_scaled)
+{
+    const size_t numElems = 37;
+
+    //fixed-point to float with scaling
+    Pothos::BufferChunk s16(typeid(int16_t), numElems);
+    for (size_t i = 0; i < numElems; i++) s16.as<int16_t *>()[i] = int16_t(i*1000 - 16000);
+    Pothos::BufferChunk f32(typeid(float), numElems);
+    POTHOS_TEST_EQUAL(s16.convert(f32, 1/32768.0, false), numElems);
+    for (size_t i = 0; i < numElems; i++)
+    {
+        POTHOS_TEST_EQUAL(f32.as<const float *>()[i], float(int16_t(i*1000 - 16000))/32768.0f);
+    }
+
+    //float to fixed-point with scaling and clamping
+    for (size_t i = 0; i < numElems; i++) f32.as<float *>()[i] = (float(i)-18.0f)/9.0f; //[-2.0, 2.0]
+    const auto out = f32.convert(Pothos::DType(typeid(int16_t)), 32767.0, true);
+    POTHOS_TEST_EQUAL(out.elements(), numElems);
+    for (size_t i = 0; i < numElems; i++)
+    {
+        const auto x = f32.as<const float *>()[i]*32767.0f;
+        const auto expected = (x >= 32767.0f)?int16_t(32767):((x <= -32768.0f)?int16_t(-32768):int16_t(x));
+        POTHOS_TEST_EQUAL(out.as<const int16_t *>()[i], expected);
+    }
+
+    //complex elements are scaled component-wise
+    Pothos::BufferChunk cf64(typeid(std::complex<double>), numElems);
+    for (size_t i = 0; i < numElems; i++) cf64.as<std::complex<double> *>()[i] = std::complex<double>(double(i), -double(i));
+    const auto cs8 = cf64.convert(Pothos::DType(typeid(std::complex<int8_t>)), 10.0, true);
+    for (size_t i = 0; i < numElems; i++)
+    {
+        const auto val = cs8.as<const std::complex<int8_t> *>()[i];
+        POTHOS_TEST_EQUAL(int(val.real()), int(std::min<double>(i*10.0, 127)));
+        POTHOS_TEST_EQUAL(int(val.imag()), int(std::max<double>(-(i*10.0), -128)));
+    }
+
+    //insufficient output buffer
+    Pothos::BufferChunk small(typeid(float), numElems-1);
+    POTHOS_TEST_THROWS(s16.convert(small, 1.0, false), Pothos::BufferConvertError);
+}
+
+/***********************************************************************
+ * pre-resolved kernel test cases
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_convert_kernel)
+{
+    POTHOS_TEST_TRUE(not Pothos::BufferConvert::Kernel());
+
+    //resolve once and call directly
+    const auto kernel = Pothos::BufferConvert::getKernel(typeid(std::complex<int16_t>), typeid(std::complex<float>));
+    POTHOS_TEST_TRUE(bool(kernel));
+    POTHOS_TEST_EQUAL(kernel.inputDType(), Pothos::DType(typeid(std::complex<int16_t>)));
+    POTHOS_TEST_EQUAL(kernel.outputDType(), Pothos::DType(typeid(std::complex<float>)));
+
+    const size_t numElems = 53;
+    std::vector<std::complex<int16_t>> in(numElems);
+    std::vector<std::complex<float>> out(numElems);
+    for (size_t i = 0; i < numElems; i++) in[i] = std::complex<int16_t>(int16_t(i), -int16_t(i));
+    kernel(in.data(), out.data(), numElems);
+    for (size_t i = 0; i < numElems; i++)
+    {
+        POTHOS_TEST_EQUAL(out[i].real(), float(i));
+        POTHOS_TEST_EQUAL(out[i].imag(), -float(i));
+    }
+
+    //unsupported conversions throw
+    POTHOS_TEST_THROWS(Pothos::BufferConvert::getKernel(Pothos::DType(), typeid(float)), Pothos::BufferConvertError);
+}
+
+/***********************************************************************
+ * interleave and byte swap test cases
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_convert_interleave)
+{
+    //lengths that cover the vector loops and the scalar tails
+    for (const size_t numElems : {1, 7, 16, 37})
+    {
+        Pothos::BufferChunk re(typeid(float), numElems);
+        Pothos::BufferChunk im(typeid(float), numElems);
+        for (size_t i = 0; i < numElems; i++)
+        {
+            re.as<float *>()[i] = float(i);
+            im.as<float *>()[i] = -float(i*2);
+        }
+
+        //vectorized float pair and a converting int16 pair
+        const auto cf32 = Pothos::BufferChunk::interleave(re, im, typeid(std::complex<float>));
+        const auto cs16 = Pothos::BufferChunk::interleave(re, im, typeid(std::complex<int16_t>));
+        POTHOS_TEST_EQUAL(cf32.elements(), numElems);
+        for (size_t i = 0; i < numElems; i++)
+        {
+            POTHOS_TEST_TRUE(cf32.as<const std::complex<float> *>()[i] == std::complex<float>(float(i), -float(i*2)));
+            POTHOS_TEST_TRUE(cs16.as<const std::complex<int16_t> *>()[i] == std::complex<int16_t>(int16_t(i), -int16_t(i*2)));
+        }
+
+        //the reverse of convertComplex
+        const auto split = cs16.convertComplex(typeid(int16_t));
+        const auto back = Pothos::BufferChunk::interleave(split.first, split.second, typeid(std::complex<int16_t>));
+        POTHOS_TEST_EQUALA(back.as<const int16_t *>(), cs16.as<const int16_t *>(), numElems*2);
+    }
+
+    //mismatched inputs throw
+    Pothos::BufferChunk re(typeid(float), 10);
+    Pothos::BufferChunk im(typeid(int16_t), 10);
+    POTHOS_TEST_THROWS(Pothos::BufferChunk::interleave(re, im, typeid(std::complex<float>)), Pothos::BufferConvertError);
+    Pothos::BufferChunk small(typeid(std::complex<float>), 9);
+    POTHOS_TEST_THROWS(Pothos::BufferChunk::interleave(re, re, small), Pothos::BufferConvertError);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_convert_byteswap)
+{
+    const size_t numElems = 37;
+
+    //swap each primitive, complex components swap separately
+    Pothos::BufferChunk u32(typeid(uint32_t), numElems);
+    Pothos::BufferChunk cu16(typeid(std::complex<uint16_t>), numElems);
+    for (size_t i = 0; i < numElems; i++)
+    {
+        u32.as<uint32_t *>()[i] = uint32_t(0x01020300 + i);
+        cu16.as<std::complex<uint16_t> *>()[i] = std::complex<uint16_t>(uint16_t(0x0100 + i), uint16_t(0x0200 + i));
+    }
+    const auto swapped32 = u32.byteswap();
+    const auto swapped16 = cu16.byteswap();
+    for (size_t i = 0; i < numElems; i++)
+    {
+        POTHOS_TEST_EQUAL(swapped32.as<const uint32_t *>()[i], uint32_t((i << 24) | 0x00030201));
+        POTHOS_TEST_EQUAL(swapped16.as<const std::complex<uint16_t> *>()[i].real(), uint16_t((i << 8) | 0x01));
+        POTHOS_TEST_EQUAL(swapped16.as<const std::complex<uint16_t> *>()[i].imag(), uint16_t((i << 8) | 0x02));
+    }
+
+    //swap in-place back to the original
+    POTHOS_TEST_EQUAL(swapped32.byteswap(swapped32), numElems);
+    POTHOS_TEST_EQUALA(swapped32.as<const uint32_t *>(), u32.as<const uint32_t *>(), numElems);
+    POTHOS_TEST_THROWS(u32.byteswap(Pothos::BufferChunk(typeid(float), numElems)), Pothos::BufferConvertError);
+
+    //big endian complex int16 to complex float in one pass and through the fallback
+    Pothos::BufferChunk wire(typeid(std::complex<int16_t>), numElems);
+    for (size_t i = 0; i < numElems*2; i++)
+    {
+        const auto x = uint16_t((i%2 == 0)?int16_t((i/2)*100):-int16_t((i/2)*300));
+        wire.as<uint8_t *>()[i*2+0] = uint8_t(x >> 8);
+        wire.as<uint8_t *>()[i*2+1] = uint8_t(x & 0xff);
+    }
+    const auto cf32 = wire.convertFromBigEndian(typeid(std::complex<float>));
+    const auto cf64 = wire.convertFromBigEndian(typeid(std::complex<double>));
+    for (size_t i = 0; i < numElems; i++)
+    {
+        POTHOS_TEST_TRUE(cf32.as<const std::complex<float> *>()[i] == std::complex<float>(float(i*100), -float(i*300)));
+        POTHOS_TEST_TRUE(cf64.as<const std::complex<double> *>()[i] == std::complex<double>(double(i*100), -double(i*300)));
+    }
+}
+
+/***********************************************************************
+ * packed sample test cases
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_convert_packed)
+{
+    //lengths that cover the vector loops and the scalar tails
+    for (const size_t numElems : {1, 9, 10, 33})
+    {
+        Pothos::BufferChunk cs16(typeid(std::complex<int16_t>), numElems);
+        for (size_t i = 0; i < numElems; i++)
+        {
+            const int re = int(i*123)%4096 - 2048;
+            cs16.as<std::complex<int16_t> *>()[i] = std::complex<int16_t>(int16_t(re), int16_t(-re-1));
+        }
+
+        //pack to 3 bytes per sample and back through the vectorized pairs
+        const auto sc12 = cs16.convert(Pothos::DType("sc12"));
+        POTHOS_TEST_EQUAL(sc12.elements(), numElems);
+        POTHOS_TEST_EQUAL(sc12.length, numElems*3);
+        const auto back = sc12.convert(typeid(std::complex<int16_t>));
+        POTHOS_TEST_EQUALA(back.as<const int16_t *>(), cs16.as<const int16_t *>(), numElems*2);
+        const auto cf32 = sc12.convert(typeid(std::complex<float>));
+        const auto cf64 = sc12.convert(typeid(std::complex<double>));
+        for (size_t i = 0; i < numElems; i++)
+        {
+            const auto x = cs16.as<const std::complex<int16_t> *>()[i];
+            POTHOS_TEST_TRUE(cf32.as<const std::complex<float> *>()[i] == std::complex<float>(x.real(), x.imag()));
+            POTHOS_TEST_TRUE(cf64.as<const std::complex<double> *>()[i] == std::complex<double>(x.real(), x.imag()));
+        }
+    }
+
+    //the documented layout: real in the low 12 bits of a little endian word
+    Pothos::BufferChunk one(typeid(std::complex<int16_t>), 1);
+    one.as<std::complex<int16_t> *>()[0] = std::complex<int16_t>(-2, 0x123);
+    const auto word = one.convert(Pothos::DType("sc12"));
+    POTHOS_TEST_EQUAL(int(word.as<const uint8_t *>()[0]), 0xfe);
+    POTHOS_TEST_EQUAL(int(word.as<const uint8_t *>()[1]), 0x3f);
+    POTHOS_TEST_EQUAL(int(word.as<const uint8_t *>()[2]), 0x12);
+
+    //scaled conversions with saturation into the packed range
+    Pothos::BufferChunk cf32(typeid(std::complex<float>), 3);
+    cf32.as<std::complex<float> *>()[0] = std::complex<float>(0.5f, -0.5f);
+    cf32.as<std::complex<float> *>()[1] = std::complex<float>(2.0f, -2.0f);
+    cf32.as<std::complex<float> *>()[2] = std::complex<float>(0.25f, 0.0f);
+    const auto sc4 = cf32.convert(Pothos::DType("sc4"), 8.0, true);
+    POTHOS_TEST_EQUAL(sc4.length, 3);
+    const auto unpacked = sc4.convert(typeid(std::complex<float>), 1/8.0, false);
+    POTHOS_TEST_TRUE(unpacked.as<const std::complex<float> *>()[0] == std::complex<float>(0.5f, -0.5f));
+    POTHOS_TEST_TRUE(unpacked.as<const std::complex<float> *>()[1] == std::complex<float>(7/8.0f, -1.0f));
+    POTHOS_TEST_TRUE(unpacked.as<const std::complex<float> *>()[2] == std::complex<float>(0.25f, 0.0f));
+
+    //packed samples only convert to and from complex types
+    POTHOS_TEST_THROWS(word.convert(typeid(float)), Pothos::BufferConvertError);
+    POTHOS_TEST_THROWS(word.byteswap(), Pothos::BufferConvertError);
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_pool)
+{
+    Pothos::BufferPool pool;
+
+    //unused buffers are reused within a size class
+    {
+        const auto b0 = pool.get(100);
+        POTHOS_TEST_TRUE(b0.length >= 100);
+    }
+    {
+        const auto b1 = pool.get(200);
+        POTHOS_TEST_TRUE(b1.length >= 200);
+    }
+    POTHOS_TEST_EQUAL(pool.getTotalAllocations(), 1);
+    POTHOS_TEST_EQUAL(pool.getTotalReuses(), 1);
+
+    //a large request does not inflate later allocations
+    {
+        const auto big = pool.get(1024*1024);
+        POTHOS_TEST_TRUE(big.length >= 1024*1024);
+    }
+    {
+        const auto small = pool.get(100);
+        POTHOS_TEST_TRUE(small.length < 1024*1024);
+    }
+    POTHOS_TEST_EQUAL(pool.getTotalAllocations(), 2);
+
+    //buffers held downstream are not retained without bound
+    std::vector<Pothos::BufferChunk> held;
+    for (size_t i = 0; i < 1000; i++) held.push_back(pool.get(100));
+    POTHOS_TEST_TRUE(pool.getPooledBytes() < 1000*held.front().length);
+
+    //idle buffers are trimmed when a later request allocates
+    held.clear();
+    for (size_t i = 0; i < 10000; i++) pool.get(100);
+    held.push_back(pool.get(2*1024*1024));
+    POTHOS_TEST_EQUAL(pool.getPooledBytes(), held.back().length + pool.get(100).length);
+
+    pool.clear();
+    POTHOS_TEST_EQUAL(pool.getPooledBytes(), 0);
+}
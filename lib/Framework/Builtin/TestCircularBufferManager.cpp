@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2014 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
@@ -14,33 +14,57 @@ POTHOS_TEST_BLOCK("/framework/tests", test_circular_buffer_manager)
     auto manager = Pothos::BufferManager::make("circular", args);
     POTHOS_TEST_FALSE(manager->empty());
 
+    //the front buffer is the entire writable ring
+    const size_t ringSize = manager->front().length;
+    POTHOS_TEST_TRUE(ringSize >= args.numBuffers*args.bufferSize);
+
     std::vector<Pothos::BufferChunk> buffs(2);
     buffs[0] = manager->front();
+    buffs[0].length = ringSize/2;
     manager->pop(buffs[0].length);
     POTHOS_TEST_FALSE(manager->empty());
+    POTHOS_TEST_EQUAL(manager->front().length, ringSize-ringSize/2);
+    POTHOS_TEST_EQUAL(manager->front().address, buffs[0].getEnd());
     buffs[1] = manager->front();
     manager->pop(buffs[1].length);
     POTHOS_TEST_TRUE(manager->empty());
     POTHOS_TEST_NOT_EQUAL(buffs[0].getManagedBuffer(), buffs[1].getManagedBuffer());
 
-    //causes push in wrong order
+    //causes push in wrong order, the space is restored in ring order
     buffs[1] = Pothos::BufferChunk();
+    POTHOS_TEST_TRUE(manager->empty());
     buffs[0] = Pothos::BufferChunk();
     POTHOS_TEST_FALSE(manager->empty());
+    POTHOS_TEST_EQUAL(manager->front().length, ringSize);
 
     //and do it again
     buffs[0] = manager->front();
     manager->pop(buffs[0].length);
-    buffs[1] = manager->front();
-    manager->pop(buffs[1].length);
     POTHOS_TEST_TRUE(manager->empty());
-    POTHOS_TEST_NOT_EQUAL(buffs[0].getManagedBuffer(), buffs[1].getManagedBuffer());
+    buffs[0] = Pothos::BufferChunk();
+    POTHOS_TEST_FALSE(manager->empty());
+
+    //variable sized chunks are contiguous through the wrap-around
+    size_t totalBytes = 0;
+    Pothos::BufferChunk lastBuff;
+    for (size_t i = 1; totalBytes < 2*ringSize; i++)
+    {
+        POTHOS_TEST_FALSE(manager->empty());
+        auto buff = manager->front();
+        buff.length = std::min(buff.length, i*100);
+        manager->pop(buff.length);
+        totalBytes += buff.length;
+        if (lastBuff) POTHOS_TEST_TRUE(buff.address == lastBuff.getEnd() or buff.address+ringSize == lastBuff.getEnd());
+        lastBuff = buff;
+    }
+    lastBuff = Pothos::BufferChunk();
 
     //run through the buffers to cycle through everything
     buffs.clear(); //release any claimed buffers
     for (size_t i = 0; i < 100; i++)
     {
         auto buff = manager->front();
+        buff.length = std::min<size_t>(buff.length, 1000+i);
         manager->pop(buff.length);
     }
 }
@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2014 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //               2019-2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
@@ -6,6 +6,8 @@
 #include <Pothos/Object.hpp>
 #include <Pothos/Framework/DType.hpp>
 #include <Pothos/Framework/Exception.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/System/CpuFeatures.hpp>
 #include <complex>
 #include <iostream>
 
@@ -111,3 +113,141 @@ POTHOS_TEST_BLOCK("/framework/tests", test_dtype_dimensions)
     POTHOS_TEST_TRUE(Pothos::DType(Pothos::DType("int, 42").toMarkup()) == Pothos::DType("int, 42"));
 }
 
+
+template <typename T>
+void testDTypeOf(void)
+{
+    constexpr auto dtype = Pothos::DType::of<T>();
+    POTHOS_TEST_TRUE(dtype == Pothos::DType(typeid(T)));
+    POTHOS_TEST_EQUAL(dtype.name(), Pothos::DType(typeid(T)).name());
+    POTHOS_TEST_TRUE(Pothos::DType::of<T>(3) == Pothos::DType(typeid(T), 3));
+    POTHOS_TEST_TRUE(Pothos::DType::of<std::complex<T>>() == Pothos::DType(typeid(std::complex<T>)));
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_dtype_of)
+{
+    testDTypeOf<char>();
+    testDTypeOf<signed char>();
+    testDTypeOf<unsigned char>();
+    testDTypeOf<short>();
+    testDTypeOf<unsigned short>();
+    testDTypeOf<int>();
+    testDTypeOf<unsigned int>();
+    testDTypeOf<long>();
+    testDTypeOf<unsigned long>();
+    testDTypeOf<long long>();
+    testDTypeOf<unsigned long long>();
+    testDTypeOf<float>();
+    testDTypeOf<double>();
+}
+
+/***********************************************************************
+ * Block template instantiated per element type
+ **********************************************************************/
+template <typename T>
+struct DTypeHolder : Pothos::Block
+{
+    DTypeHolder(const size_t dimension)
+    {
+        this->setupInput(0, Pothos::DType::of<T>(dimension));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DTypeHolder, elemSize));
+    }
+
+    size_t elemSize(void) const
+    {
+        return sizeof(T);
+    }
+};
+
+static Pothos::Block *makeDTypeHolder(const Pothos::DType &dtype)
+{
+    return Pothos::BlockRegistry::makeForDType<DTypeHolder, int8_t, int16_t, float, double, std::complex<float>>(dtype, dtype.dimension());
+}
+
+static Pothos::BlockRegistry registerDTypeHolder("/tests/dtype_holder", &makeDTypeHolder);
+
+POTHOS_TEST_BLOCK("/framework/tests", test_block_make_for_dtype)
+{
+    auto holder = Pothos::BlockRegistry::make("/tests/dtype_holder", Pothos::DType("float64"));
+    POTHOS_TEST_EQUAL(holder.call<size_t>("elemSize"), sizeof(double));
+    holder = Pothos::BlockRegistry::make("/tests/dtype_holder", Pothos::DType("complex_float32", 2));
+    POTHOS_TEST_EQUAL(holder.call<size_t>("elemSize"), sizeof(std::complex<float>));
+
+    //types which are not in the list throw
+    POTHOS_TEST_THROWS(makeDTypeHolder(Pothos::DType("uint32")), Pothos::DTypeUnknownError);
+    POTHOS_TEST_THROWS(Pothos::BlockRegistry::make("/tests/dtype_holder", Pothos::DType("int64")), Pothos::Exception);
+}
+
+/***********************************************************************
+ * Block variants registered per instruction set
+ **********************************************************************/
+struct IsaHolder : Pothos::Block
+{
+    IsaHolder(const std::string &isa):
+        isa(isa)
+    {
+        this->registerCall(this, POTHOS_FCN_TUPLE(IsaHolder, getIsa));
+    }
+
+    std::string getIsa(void) const
+    {
+        return isa;
+    }
+
+    const std::string isa;
+};
+
+template <int Index>
+static Pothos::Block *makeIsaHolder(void)
+{
+    return new IsaHolder((Index < 0)?"generic":Pothos::System::CpuFeatures::ranking().at(Index));
+}
+
+static Pothos::BlockRegistry registerIsaHolder("/tests/isa_holder", &makeIsaHolder<-1>);
+static Pothos::BlockRegistry registerIsaHolderAvx2("/tests/isa_holder", "avx2", &makeIsaHolder<1>);
+static Pothos::BlockRegistry registerIsaHolderSse42("/tests/isa_holder", "sse4_2", &makeIsaHolder<3>);
+static Pothos::BlockRegistry registerIsaHolderNeon("/tests/isa_holder", "neon", &makeIsaHolder<6>);
+
+POTHOS_TEST_BLOCK("/framework/tests", test_block_isa_variants)
+{
+    const auto features = Pothos::System::CpuFeatures::get();
+    std::string expected("generic");
+    for (const auto &isa : features.names())
+    {
+        if (isa != "avx2" and isa != "sse4_2" and isa != "neon") continue;
+        expected = isa;
+        break;
+    }
+
+    auto holder = Pothos::BlockRegistry::make("/tests/isa_holder");
+    POTHOS_TEST_EQUAL(holder.call<std::string>("getIsa"), expected);
+
+    //a supported extension implies its predecessors
+    if (features.avx2) POTHOS_TEST_TRUE(features.avx);
+    for (const auto &isa : features.names()) POTHOS_TEST_TRUE(features.has(isa));
+    POTHOS_TEST_TRUE(not features.has("unknown"));
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_dtype_packed)
+{
+    const Pothos::DType sc12("sc12");
+    POTHOS_TEST_EQUAL(sc12.name(), "complex_int12");
+    POTHOS_TEST_EQUAL(sc12.elemSize(), 3);
+    POTHOS_TEST_TRUE(sc12.isPacked());
+    POTHOS_TEST_TRUE(sc12.isComplex());
+    POTHOS_TEST_TRUE(sc12.isInteger());
+    POTHOS_TEST_TRUE(sc12.isSigned());
+    POTHOS_TEST_TRUE(not sc12.isCustom());
+    POTHOS_TEST_EQUAL(Pothos::DType(sc12.toMarkup()), sc12);
+    POTHOS_TEST_EQUAL(Pothos::DType("sc12, 4").size(), 12);
+
+    const Pothos::DType sc4("sc4");
+    POTHOS_TEST_EQUAL(sc4.name(), "complex_int4");
+    POTHOS_TEST_EQUAL(sc4.elemSize(), 1);
+    POTHOS_TEST_TRUE(sc4.isPacked());
+
+    //byte aligned wire format aliases
+    POTHOS_TEST_EQUAL(Pothos::DType("sc8"), Pothos::DType::of<std::complex<int8_t>>());
+    POTHOS_TEST_EQUAL(Pothos::DType("sc16"), Pothos::DType::of<std::complex<int16_t>>());
+    POTHOS_TEST_TRUE(not Pothos::DType("sc16").isPacked());
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework/ExternalBufferManager.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include <vector>
+#include <deque>
+
+POTHOS_TEST_BLOCK("/framework/tests", test_external_buffer_manager)
+{
+    //a pool of driver memory with driver specific handles
+    std::vector<char> memory(3*1024);
+    std::vector<Pothos::ExternalBuffer> buffers;
+    for (size_t i = 0; i < 3; i++)
+    {
+        buffers.emplace_back(size_t(memory.data())+i*1024, 1024, 10+i);
+    }
+
+    //the device fills buffers in its own order
+    std::deque<size_t> deviceReady;
+    std::vector<std::pair<size_t, size_t>> released;
+    auto manager = Pothos::ExternalBufferManager::make(buffers,
+        [&](const size_t handle, const size_t numBytes){released.emplace_back(handle, numBytes);},
+        [&](size_t &handle){if (deviceReady.empty()) return false; handle = deviceReady.front(); deviceReady.pop_front(); return true;});
+    manager->init(Pothos::BufferManagerArgs());
+    POTHOS_TEST_TRUE(manager->empty());
+
+    //the front buffer is the external memory of the acquired handle
+    deviceReady.push_back(12);
+    deviceReady.push_back(10);
+    POTHOS_TEST_FALSE(manager->empty());
+    POTHOS_TEST_EQUAL(manager->front().address, buffers[2].address);
+    POTHOS_TEST_EQUAL(manager->front().length, 1024);
+
+    auto b0 = manager->front();
+    manager->pop(100);
+    POTHOS_TEST_FALSE(manager->empty());
+    POTHOS_TEST_EQUAL(manager->front().address, buffers[0].address);
+    auto b1 = manager->front();
+    manager->pop(200);
+    POTHOS_TEST_TRUE(manager->empty());
+
+    //releasing returns the handle and the popped bytes to the driver
+    b0 = Pothos::BufferChunk();
+    POTHOS_TEST_EQUAL(released.size(), 1);
+    POTHOS_TEST_EQUAL(released[0].first, 12);
+    POTHOS_TEST_EQUAL(released[0].second, 100);
+    b1 = Pothos::BufferChunk();
+    POTHOS_TEST_EQUAL(released.size(), 2);
+    POTHOS_TEST_EQUAL(released[1].first, 10);
+    POTHOS_TEST_EQUAL(released[1].second, 200);
+
+    //the released buffer can be acquired again
+    deviceReady.push_back(12);
+    POTHOS_TEST_FALSE(manager->empty());
+    POTHOS_TEST_EQUAL(manager->front().address, buffers[2].address);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_external_buffer_manager_no_acquire)
+{
+    std::vector<char> memory(2*1024);
+    std::vector<Pothos::ExternalBuffer> buffers;
+    buffers.emplace_back(size_t(memory.data()), 1024, 0);
+    buffers.emplace_back(size_t(memory.data())+1024, 1024, 1);
+
+    //without an acquire callback, buffers are ready in the released order
+    auto manager = Pothos::ExternalBufferManager::make(buffers);
+    manager->init(Pothos::BufferManagerArgs());
+    auto b0 = manager->front();
+    manager->pop(b0.length);
+    auto b1 = manager->front();
+    manager->pop(b1.length);
+    POTHOS_TEST_TRUE(manager->empty());
+    b1 = Pothos::BufferChunk();
+    POTHOS_TEST_FALSE(manager->empty());
+    POTHOS_TEST_EQUAL(manager->front().address, buffers[1].address);
+
+    //handles must be unique
+    buffers[1].handle = 0;
+    POTHOS_TEST_THROWS(Pothos::ExternalBufferManager::make(buffers)->init(Pothos::BufferManagerArgs()),
+        Pothos::BufferManagerFactoryError);
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework/BufferManager.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include <Poco/TemporaryFile.h>
+#include <Poco/File.h>
+#include <algorithm>
+
+POTHOS_TEST_BLOCK("/framework/tests", test_file_buffer_manager)
+{
+    Poco::TemporaryFile tempFile;
+    const size_t numBytes = 10000;
+
+    //the buffer size is not a multiple of the page size,
+    //so windows are mapped at aligned offsets before the front
+    Pothos::BufferManagerArgs args;
+    args.numBuffers = 2;
+    args.bufferSize = 1000;
+    args.filePath = tempFile.path();
+
+    //write a ramp through the windows of the file with uneven pops
+    args.fileMode = "write";
+    {
+        auto manager = Pothos::BufferManager::make("file", args);
+        size_t total = 0;
+        while (total < numBytes)
+        {
+            POTHOS_TEST_FALSE(manager->empty());
+            auto buff = manager->front();
+            const size_t n = std::min(std::min<size_t>(buff.length, 321), numBytes-total);
+            for (size_t i = 0; i < n; i++) buff.as<unsigned char *>()[i] = (unsigned char)(total+i);
+            manager->pop(n);
+            total += n;
+        }
+    }
+
+    //the unused space of the last window is removed
+    POTHOS_TEST_EQUAL(Poco::File(tempFile.path()).getSize(), numBytes);
+
+    //replay the file until the manager is empty
+    args.fileMode = "read";
+    {
+        auto manager = Pothos::BufferManager::make("file", args);
+        size_t total = 0;
+        size_t errors = 0;
+        while (not manager->empty())
+        {
+            const auto buff = manager->front();
+            for (size_t i = 0; i < buff.length; i++)
+            {
+                if (buff.as<const unsigned char *>()[i] != (unsigned char)(total+i)) errors++;
+            }
+            manager->pop(buff.length);
+            total += buff.length;
+        }
+        POTHOS_TEST_EQUAL(total, numBytes);
+        POTHOS_TEST_EQUAL(errors, 0);
+    }
+
+    //a path is required
+    args.filePath = "";
+    POTHOS_TEST_THROWS(Pothos::BufferManager::make("file", args), Pothos::BufferManagerFactoryError);
+}
@@ -25,3 +25,108 @@ POTHOS_TEST_BLOCK("/framework/tests", test_generic_buffer_manager)
     buffs.clear();
     POTHOS_TEST_FALSE(manager->empty());
 }
+
+POTHOS_TEST_BLOCK("/framework/tests", test_generic_buffer_manager_alignment)
+{
+    Pothos::BufferManagerArgs args;
+    args.numBuffers = 4;
+    args.bufferSize = 1000; //not a multiple of the alignment
+    args.alignment = 4096;
+    args.padding = 64;
+    auto manager = Pothos::BufferManager::make("generic", args);
+
+    std::vector<Pothos::BufferChunk> buffs;
+    while (not manager->empty())
+    {
+        buffs.push_back(manager->front());
+        manager->pop(buffs.back().length);
+    }
+    POTHOS_TEST_EQUAL(buffs.size(), args.numBuffers);
+    for (const auto &buff : buffs)
+    {
+        POTHOS_TEST_EQUAL(buff.address % args.alignment, 0);
+        POTHOS_TEST_EQUAL(buff.length, args.bufferSize);
+
+        //separated buffers are not linked for amalgamation
+        POTHOS_TEST_TRUE(not buff.getManagedBuffer().getNextBuffer());
+    }
+
+    args.alignment = 48;
+    POTHOS_TEST_THROWS(Pothos::BufferManager::make("generic", args), Pothos::BufferManagerFactoryError);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_chunk_reassign)
+{
+    Pothos::BufferManagerArgs args;
+    args.numBuffers = 2;
+    auto manager = Pothos::BufferManager::make("generic", args);
+
+    //re-assigning the same buffer keeps the reference count
+    Pothos::BufferChunk front = manager->front();
+    Pothos::BufferChunk view = front;
+    const auto useCount = front.useCount();
+    view.address += 16;
+    view.length -= 16;
+    view = front;
+    POTHOS_TEST_EQUAL(view.address, front.address);
+    POTHOS_TEST_EQUAL(view.length, front.length);
+    POTHOS_TEST_EQUAL(front.useCount(), useCount);
+
+    //self assignment of the managed buffer
+    auto buff = front.getManagedBuffer();
+    buff = front.getManagedBuffer();
+    POTHOS_TEST_EQUAL(front.useCount(), useCount+1);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_lifo_buffer_manager)
+{
+    Pothos::BufferManagerArgs args;
+    args.numBuffers = 3;
+    auto manager = Pothos::BufferManager::make("lifo", args);
+
+    std::vector<Pothos::BufferChunk> buffs(3);
+    for (auto &buff : buffs)
+    {
+        buff = manager->front();
+        manager->pop(buff.length);
+    }
+    POTHOS_TEST_TRUE(manager->empty());
+    const auto addr0 = buffs[0].address;
+    const auto addr2 = buffs[2].address;
+
+    //the most recently returned buffer is handed out first
+    buffs[2] = Pothos::BufferChunk();
+    buffs[0] = Pothos::BufferChunk();
+    POTHOS_TEST_EQUAL(manager->front().address, addr0);
+    manager->pop(manager->front().length);
+    POTHOS_TEST_EQUAL(manager->front().address, addr2);
+
+    //the buffers are not linked for amalgamation
+    POTHOS_TEST_TRUE(not buffs[1].getManagedBuffer().getNextBuffer());
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_elastic_buffer_manager)
+{
+    Pothos::BufferManagerArgs args;
+    args.numBuffers = 2;
+    args.maxBuffers = 5;
+    args.shrinkTimeout = 0.0;
+    auto manager = Pothos::BufferManager::make("elastic", args);
+
+    //a burst grows the manager by slabs up to the maximum
+    for (size_t pass = 0; pass < 2; pass++)
+    {
+        std::vector<Pothos::BufferChunk> buffs;
+        while (not manager->empty())
+        {
+            buffs.push_back(manager->front());
+            manager->pop(buffs.back().length);
+        }
+        POTHOS_TEST_EQUAL(buffs.size(), args.maxBuffers);
+        for (const auto &buff : buffs) POTHOS_TEST_EQUAL(buff.length, args.bufferSize);
+
+        //the extra slabs retire as the buffers return
+        buffs.clear();
+        POTHOS_TEST_FALSE(manager->empty());
+    }
+}
@@ -1,9 +1,10 @@
-// Copyright (c) 2014-2014 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Testing.hpp>
 #include <Pothos/Framework.hpp>
 #include <iostream>
+#include <sstream>
 
 POTHOS_TEST_BLOCK("/framework/tests", test_label_constructor)
 {
@@ -27,3 +28,28 @@ POTHOS_TEST_BLOCK("/framework/tests", test_label_constructor)
     POTHOS_TEST_TRUE(label3.data.type() == typeid(std::string));
     POTHOS_TEST_EQUAL(label3.data.extract<std::string>(), "test3");
 }
+
+POTHOS_TEST_BLOCK("/framework/tests", test_label_atom)
+{
+    static const Pothos::Util::Atom rxTime("rxTime");
+
+    //labels from strings and atoms share the interned ID
+    auto label0 = Pothos::Label("rxTime", 0, 0);
+    auto label1 = Pothos::Label(rxTime, 0, 0);
+    POTHOS_TEST_TRUE(label0.atom() == rxTime);
+    POTHOS_TEST_TRUE(label1.atom() == rxTime);
+    POTHOS_TEST_EQUAL(label1.id, "rxTime");
+    POTHOS_TEST_TRUE(label0 == label1);
+
+    //assigning the id string updates the atom
+    label0.id = "txEnd";
+    POTHOS_TEST_TRUE(label0.atom() != rxTime);
+    POTHOS_TEST_TRUE(label0.atom() == Pothos::Util::Atom("txEnd"));
+
+    //serialization keeps the string format and restores the atom
+    std::stringstream ss;
+    Pothos::Object(label1).serialize(ss);
+    Pothos::Object out;
+    out.deserialize(ss);
+    POTHOS_TEST_TRUE(out.extract<Pothos::Label>().atom() == rxTime);
+}
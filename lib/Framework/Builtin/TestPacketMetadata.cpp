@@ -0,0 +1,76 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <sstream>
+#include <stdexcept>
+
+POTHOS_TEST_BLOCK("/framework/tests", test_atom_table)
+{
+    const Pothos::Util::Atom rxTime("rxTime");
+    const Pothos::Util::Atom freq(std::string("freq"));
+
+    //the same string always interns to the same ID
+    POTHOS_TEST_EQUAL(rxTime.id(), Pothos::Util::Atom("rxTime").id());
+    POTHOS_TEST_TRUE(rxTime != freq);
+    POTHOS_TEST_TRUE(rxTime == std::string("rxTime"));
+    POTHOS_TEST_TRUE(rxTime == "rxTime");
+    POTHOS_TEST_EQUAL(rxTime.str(), "rxTime");
+
+    //the empty atom is ID 0
+    POTHOS_TEST_TRUE(Pothos::Util::Atom().empty());
+    POTHOS_TEST_EQUAL(Pothos::Util::Atom("").id(), 0);
+    POTHOS_TEST_TRUE(not rxTime.empty());
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_packet_metadata)
+{
+    Pothos::PacketMetadata metadata;
+    POTHOS_TEST_TRUE(metadata.empty());
+
+    //map style insertion and lookup
+    metadata["rate"] = Pothos::Object(1e6);
+    metadata["freq"] = Pothos::Object(2.4e9);
+    metadata["rxTime"] = Pothos::Object(1234ll);
+    POTHOS_TEST_EQUAL(metadata.size(), 3);
+    POTHOS_TEST_EQUAL(metadata.count("freq"), 1);
+    POTHOS_TEST_EQUAL(metadata.count("missing"), 0);
+    POTHOS_TEST_EQUAL(metadata.at("rate").convert<double>(), 1e6);
+    POTHOS_TEST_THROWS(metadata.at("missing"), std::out_of_range);
+    POTHOS_TEST_TRUE(not metadata.emplace("rate", Pothos::Object(0.0)).second);
+    POTHOS_TEST_EQUAL(metadata.find("rxTime")->second.convert<long long>(), 1234ll);
+
+    //kwargs round trip
+    const Pothos::ObjectKwargs kwargs = metadata;
+    POTHOS_TEST_EQUAL(kwargs.size(), 3);
+    POTHOS_TEST_EQUAL(kwargs.at("freq").convert<double>(), 2.4e9);
+    const Pothos::PacketMetadata fromKwargs(kwargs);
+    POTHOS_TEST_EQUAL(fromKwargs.size(), 3);
+    POTHOS_TEST_EQUAL(fromKwargs.at("rxTime").convert<long long>(), 1234ll);
+    POTHOS_TEST_EQUAL(Pothos::Object(kwargs).convert<Pothos::PacketMetadata>().size(), 3);
+
+    //erasure
+    POTHOS_TEST_EQUAL(metadata.erase("freq"), 1);
+    POTHOS_TEST_EQUAL(metadata.erase("freq"), 0);
+    POTHOS_TEST_EQUAL(metadata.size(), 2);
+    metadata.clear();
+    POTHOS_TEST_TRUE(metadata.empty());
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_packet_metadata_serialization)
+{
+    Pothos::Packet packet;
+    packet.metadata["rxTime"] = Pothos::Object(42ll);
+    packet.metadata["name"] = Pothos::Object("test");
+
+    std::stringstream ss;
+    Pothos::Object(packet).serialize(ss);
+    Pothos::Object out;
+    out.deserialize(ss);
+
+    const auto &result = out.extract<Pothos::Packet>();
+    POTHOS_TEST_EQUAL(result.metadata.size(), 2);
+    POTHOS_TEST_EQUAL(result.metadata.at("rxTime").convert<long long>(), 42ll);
+    POTHOS_TEST_EQUAL(result.metadata.at("name").convert<std::string>(), "test");
+}
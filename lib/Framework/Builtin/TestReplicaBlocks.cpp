@@ -0,0 +1,104 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <vector>
+
+/***********************************************************************
+ * Helper blocks: a scaler with uneven processing times per message
+ **********************************************************************/
+struct ReplicaScaler : Pothos::Block
+{
+    static Pothos::Block *make(const int factor)
+    {
+        return new ReplicaScaler(factor);
+    }
+
+    ReplicaScaler(const int factor):
+        _factor(factor)
+    {
+        this->setupInput(0);
+        this->setupOutput(0);
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        if (not inPort->hasMessage()) return;
+        const int value = inPort->popMessage().convert<int>();
+
+        //later values in the same round finish first
+        std::this_thread::sleep_for(std::chrono::microseconds(100*(3-value%4)));
+        this->output(0)->postMessage(value*_factor);
+    }
+
+private:
+    const int _factor;
+};
+
+static Pothos::BlockRegistry registerReplicaScaler(
+    "/tests/replica_scaler", &ReplicaScaler::make);
+
+struct ReplicaFeeder : Pothos::Block
+{
+    ReplicaFeeder(const int total):
+        total(total),
+        count(0)
+    {
+        this->setupOutput(0);
+    }
+
+    void work(void)
+    {
+        if (count < total) this->output(0)->postMessage(count++);
+    }
+
+    const int total;
+    int count;
+};
+
+struct ReplicaCollector : Pothos::Block
+{
+    ReplicaCollector(void)
+    {
+        this->setupInput(0);
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage()) values.push_back(inPort->popMessage().convert<int>());
+    }
+
+    std::vector<int> values;
+};
+
+/***********************************************************************
+ * Run replicas of the scaler and check the order of the results
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_replica_blocks)
+{
+    const int total = 200;
+    auto feeder = std::shared_ptr<ReplicaFeeder>(new ReplicaFeeder(total));
+    auto collector = std::shared_ptr<ReplicaCollector>(new ReplicaCollector());
+    auto replicate = Pothos::BlockRegistry::make("/blocks/replica/replicate", size_t(4), "/tests/replica_scaler", 3);
+    POTHOS_TEST_THROWS(Pothos::BlockRegistry::make("/blocks/replica/replicate", size_t(0), "/tests/replica_scaler", 3), Pothos::Exception);
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, replicate, "0");
+    topology.connect(replicate, "0", collector, "0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive(0.1, 10.0));
+
+    //the results are in input order
+    POTHOS_TEST_EQUAL(int(collector->values.size()), total);
+    for (int i = 0; i < int(collector->values.size()); i++)
+    {
+        if (collector->values[i] == i*3) continue;
+        POTHOS_TEST_EQUAL(collector->values[i], i*3);
+    }
+}
@@ -1,11 +1,20 @@
-// Copyright (c) 2013-2014 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Testing.hpp>
 #include <Pothos/Framework/SharedBuffer.hpp>
+#include <Pothos/Framework/MemoryAccount.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
 #include <Pothos/Framework/Exception.hpp>
+#include "Framework/SlabAllocator.hpp"
+#include <json.hpp>
 #include <cstdlib> //rand
+#include <cstring> //memset
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
 
 POTHOS_TEST_BLOCK("/framework/tests", test_generic_shared_buffer)
 {
@@ -61,3 +70,141 @@ POTHOS_TEST_BLOCK("/framework/tests", test_circular_shared_buffer)
         POTHOS_TEST_EQUAL(p[i+alias], randNum);
     }
 }
+
+POTHOS_TEST_BLOCK("/framework/tests", test_named_shared_buffer)
+{
+    //a second mapping of the same name sees the same memory
+    auto b0 = Pothos::SharedBuffer::makeCircNamed("PothosTestNamedBuffer", 1024, true);
+    auto b1 = Pothos::SharedBuffer::makeCircNamed("PothosTestNamedBuffer", 1024, false);
+    POTHOS_TEST_NOT_EQUAL(b0.getAddress(), b1.getAddress());
+    POTHOS_TEST_EQUAL(b0.getLength(), b1.getLength());
+
+    const size_t alias = b0.getLength()/sizeof(int);
+    for (size_t i = 0; i < b0.getLength()/sizeof(int); i++)
+    {
+        int *p0 = reinterpret_cast<int *>(b0.getAddress());
+        int *p1 = reinterpret_cast<int *>(b1.getAddress());
+        const int randNum = std::rand();
+        p0[i] = randNum;
+        POTHOS_TEST_EQUAL(p1[i], randNum);
+        POTHOS_TEST_EQUAL(p1[i+alias], randNum);
+    }
+
+    //the name is taken while the creator holds the memory
+    POTHOS_TEST_THROWS(Pothos::SharedBuffer::makeNamed("PothosTestNamedBuffer2", 64, false), Pothos::SharedBufferError);
+    auto h0 = Pothos::SharedBuffer::makeNamed("PothosTestNamedBuffer2", 64, true);
+    POTHOS_TEST_THROWS(Pothos::SharedBuffer::makeNamed("PothosTestNamedBuffer2", 64, true), Pothos::SharedBufferError);
+    auto h1 = Pothos::SharedBuffer::makeNamed("PothosTestNamedBuffer2", 64, false);
+    std::memset(reinterpret_cast<void *>(h0.getAddress()), 0x5a, 64);
+    POTHOS_TEST_EQUAL(reinterpret_cast<const unsigned char *>(h1.getAddress())[63], 0x5a);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_huge_page_shared_buffer)
+{
+    //huge pages may not be configured, allocations fall back to normal pages
+    const size_t hugePageSize = 2*1024*1024;
+    auto b0 = Pothos::SharedBuffer::make(3*1024*1024, -1, hugePageSize);
+    POTHOS_TEST_NOT_EQUAL(b0.getAddress(), 0);
+    POTHOS_TEST_TRUE((b0.getAddress() & 0xf) == 0); //has alignment
+    POTHOS_TEST_EQUAL(b0.getLength(), 3*1024*1024);
+    for (size_t i = 0; i < b0.getLength()/sizeof(int); i++)
+    {
+        int *p = reinterpret_cast<int *>(b0.getAddress());
+        const int randNum = std::rand();
+        p[i] = randNum;
+        POTHOS_TEST_EQUAL(p[i], randNum);
+    }
+
+    auto b1 = Pothos::SharedBuffer::makeCirc(1024*1024, -1, hugePageSize);
+    POTHOS_TEST_NOT_EQUAL(b1.getAddress(), 0);
+    POTHOS_TEST_GE(b1.getLength(), 1024*1024);
+
+    const size_t alias = b1.getLength()/sizeof(int);
+    for (size_t i = 0; i < b1.getLength()/sizeof(int); i++)
+    {
+        int *p = reinterpret_cast<int *>(b1.getAddress());
+        const int randNum = std::rand();
+        p[i] = randNum;
+        POTHOS_TEST_EQUAL(p[i+alias], randNum);
+    }
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_locked_shared_buffer)
+{
+    //locking may fail on memory limits, the buffer remains usable
+    auto b0 = Pothos::SharedBuffer::make(1024*1024);
+    std::memset(reinterpret_cast<void *>(b0.getAddress()), 0x5a, b0.getLength());
+    auto b1 = b0.lockMemory();
+    b1.prefaultMemory();
+    POTHOS_TEST_EQUAL(b1.getAddress(), b0.getAddress());
+    POTHOS_TEST_EQUAL(b1.getLength(), b0.getLength());
+    for (size_t i = 0; i < b1.getLength(); i++)
+    {
+        POTHOS_TEST_EQUAL(reinterpret_cast<const char *>(b1.getAddress())[i], 0x5a);
+    }
+
+    //circular buffer keeps the alias through the lock
+    auto b2 = Pothos::SharedBuffer::makeCirc(1024*1024).lockMemory();
+    b2.prefaultMemory();
+    POTHOS_TEST_NOT_EQUAL(b2.getAlias(), 0);
+    int *p = reinterpret_cast<int *>(b2.getAddress());
+    const size_t alias = b2.getLength()/sizeof(int);
+    p[0] = 42;
+    POTHOS_TEST_EQUAL(p[alias], 42);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_memory_account)
+{
+    auto parent = Pothos::MemoryAccount::make("parent");
+    auto account = Pothos::MemoryAccount::make("child", parent);
+    parent->setBudget(1 << 20);
+    const auto globalBytes = Pothos::MemoryAccount::global()->bytes();
+
+    //allocations in the scope are charged to the account and its parents
+    {
+        Pothos::MemoryAccount::Scope scope(account);
+        auto buff0 = Pothos::SharedBuffer::make(1 << 19);
+        POTHOS_TEST_EQUAL(account->bytes(), size_t(1 << 19));
+        POTHOS_TEST_EQUAL(parent->bytes(), size_t(1 << 19));
+        POTHOS_TEST_TRUE(Pothos::MemoryAccount::global()->bytes() >= globalBytes + (1 << 19));
+
+        //the parent budget limits the child
+        POTHOS_TEST_THROWS(Pothos::SharedBuffer::make(1 << 20), Pothos::SharedBufferError);
+        POTHOS_TEST_EQUAL(parent->bytes(), size_t(1 << 19));
+        const auto stats = json::parse(parent->toJSON());
+        POTHOS_TEST_EQUAL(stats["numFailures"].get<int>(), 1);
+        POTHOS_TEST_EQUAL(stats["bytesByType"]["generic"].get<size_t>(), size_t(1 << 19));
+    }
+
+    //the charge is released with the memory
+    POTHOS_TEST_EQUAL(account->bytes(), 0);
+    POTHOS_TEST_EQUAL(parent->bytes(), 0);
+    POTHOS_TEST_EQUAL(json::parse(parent->toJSON())["peakBytes"].get<size_t>(), size_t(1 << 19));
+
+    //allocations outside of the scope are not charged
+    auto buff1 = Pothos::SharedBuffer::make(1 << 20);
+    POTHOS_TEST_EQUAL(account->bytes(), 0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_slab_allocator)
+{
+    //blocks are distinct and writable
+    std::vector<void *> blocks;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        blocks.push_back(slabAllocate(48));
+        std::memset(blocks.back(), int(i), 48);
+    }
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+        POTHOS_TEST_EQUAL(int(static_cast<unsigned char *>(blocks[i])[47]), int(i & 0xff));
+        slabDeallocate(blocks[i], 48);
+    }
+
+    //temporary buffers are freed on a different thread
+    std::vector<Pothos::BufferChunk> chunks;
+    for (size_t i = 0; i < 500; i++) chunks.emplace_back(64);
+    std::thread([&chunks]{chunks.clear();}).join();
+    for (size_t i = 0; i < 500; i++) chunks.emplace_back(64);
+    for (const auto &chunk : chunks) POTHOS_TEST_EQUAL(chunk.useCount(), 1);
+}
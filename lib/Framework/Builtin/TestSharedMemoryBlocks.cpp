@@ -0,0 +1,108 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <algorithm> //min
+#include <iostream>
+#include <vector>
+
+/***********************************************************************
+ * Helper blocks to feed and collect a stream with labels and messages
+ **********************************************************************/
+struct ShmFeeder : Pothos::Block
+{
+    ShmFeeder(const size_t total):
+        total(total),
+        count(0)
+    {
+        this->setupOutput(0, "uint32");
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+        if (count == 0)
+        {
+            outPort->postMessage(std::string("hello"));
+            outPort->postLabel("start", 123, 0);
+        }
+        const size_t n = std::min(total-count, std::min<size_t>(outPort->elements(), 777));
+        if (n == 0) return;
+        uint32_t *out = outPort->buffer();
+        for (size_t i = 0; i < n; i++) out[i] = uint32_t(count+i);
+        count += n;
+        outPort->produce(n);
+    }
+
+    size_t total;
+    size_t count;
+};
+
+struct ShmCollector : Pothos::Block
+{
+    ShmCollector(void)
+    {
+        this->setupInput(0, "uint32");
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage()) messages.push_back(inPort->popMessage());
+        for (const auto &label : inPort->labels())
+        {
+            auto absLabel = label;
+            absLabel.index += values.size();
+            labels.push_back(absLabel);
+        }
+        const uint32_t *in = inPort->buffer();
+        values.insert(values.end(), in, in+inPort->elements());
+        inPort->consume(inPort->elements());
+    }
+
+    std::vector<uint32_t> values;
+    std::vector<Pothos::Label> labels;
+    std::vector<Pothos::Object> messages;
+};
+
+/***********************************************************************
+ * Stream through a shared memory sink and source pair
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_shared_memory_blocks)
+{
+    //a small buffer forces the stream to wrap around
+    const size_t total = 100000;
+    auto shmSink = Pothos::BlockRegistry::make("/blocks/shared_memory_sink", size_t(4096));
+    const std::string memName = shmSink.call("getMemoryName");
+    auto shmSource = Pothos::BlockRegistry::make("/blocks/shared_memory_source", memName);
+
+    auto feeder = std::shared_ptr<ShmFeeder>(new ShmFeeder(total));
+    auto collector = std::shared_ptr<ShmCollector>(new ShmCollector());
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, shmSink, 0);
+    topology.connect(shmSource, 0, collector, 0);
+    topology.commit();
+
+    //the source polls the shared memory, so wait out the idle time
+    //and check the received stream rather than the inactive state
+    topology.waitInactive(0.1, 5.0);
+    topology.disconnectAll();
+    topology.commit();
+
+    POTHOS_TEST_EQUAL(collector->values.size(), total);
+    for (size_t i = 0; i < collector->values.size(); i++)
+    {
+        if (collector->values[i] == uint32_t(i)) continue;
+        POTHOS_TEST_EQUAL(collector->values[i], uint32_t(i));
+    }
+
+    POTHOS_TEST_EQUAL(collector->labels.size(), 1);
+    POTHOS_TEST_EQUAL(collector->labels[0].id, "start");
+    POTHOS_TEST_EQUAL(collector->labels[0].data.convert<int>(), 123);
+    POTHOS_TEST_EQUAL(collector->labels[0].index, 0);
+
+    POTHOS_TEST_EQUAL(collector->messages.size(), 1);
+    POTHOS_TEST_EQUAL(collector->messages[0].convert<std::string>(), "hello");
+}
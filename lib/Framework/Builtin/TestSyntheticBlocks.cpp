@@ -0,0 +1,446 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <json.hpp>
+
+using json = nlohmann::json;
+
+/***********************************************************************
+ * Run the synthetic blocks: source -> fan-out -> fan-in -> sink
+ **********************************************************************/
+static void testSyntheticBlocks(const bool packetMode)
+{
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), packetMode);
+    auto fanOut = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(2));
+    auto fanIn = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(2), size_t(1));
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+
+    Pothos::Topology topology;
+    topology.connect(source, 0, fanOut, 0);
+    topology.connect(fanOut, 0, fanIn, 0);
+    topology.connect(fanOut, 1, fanIn, 1);
+    topology.connect(fanIn, 0, sink, 0);
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    topology.disconnectAll();
+    topology.commit();
+
+    const unsigned long long sourceBytes = source.call("getNumBytes");
+    const unsigned long long sinkBytes = sink.call("getNumBytes");
+    const unsigned long long latencyCount = sink.call("getLatencyCount");
+    const unsigned long long latencyP50 = sink.call("getLatency", 50.0);
+    std::cout << "packetMode " << packetMode << ": source " << sourceBytes << " bytes, sink "
+        << sinkBytes << " bytes, p50 latency " << latencyP50 << " ns" << std::endl;
+
+    //the fan-out doubles the bytes, minus those in flight at disconnect
+    POTHOS_TEST_TRUE(sourceBytes > 0);
+    POTHOS_TEST_TRUE(sinkBytes > 0);
+    POTHOS_TEST_TRUE(sinkBytes <= 2*sourceBytes);
+    POTHOS_TEST_TRUE(latencyCount > 0);
+    POTHOS_TEST_TRUE(latencyP50 > 0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_synthetic_blocks)
+{
+    testSyntheticBlocks(false);
+    testSyntheticBlocks(true);
+}
+
+/***********************************************************************
+ * Analyze the bottlenecks of a running chain: source -> forwarder -> sink
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_topology_bottlenecks)
+{
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+    auto forwarder = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+
+    Pothos::Topology topology;
+    topology.connect(source, 0, forwarder, 0);
+    topology.connect(forwarder, 0, sink, 0);
+    topology.commit();
+
+    const auto report = json::parse(topology.queryBottlenecks("{\"interval\":0.05}"));
+    std::cout << report.dump(4) << std::endl;
+    POTHOS_TEST_EQUAL(report["blocks"].size(), 3);
+    POTHOS_TEST_EQUAL(report["queues"].size(), 2);
+    for (const auto &blockObj : report["blocks"])
+    {
+        const auto utilization = blockObj["utilization"].get<double>();
+        POTHOS_TEST_TRUE(utilization >= 0.0 and utilization <= 1.0);
+        POTHOS_TEST_TRUE(blockObj.count("stallReason") != 0);
+        POTHOS_TEST_TRUE(blockObj.count("state") != 0);
+    }
+
+    //the colored markup annotates the nodes and edges
+    const auto markup = topology.toDotMarkup("{\"bottlenecks\":true,\"interval\":0.05}");
+    POTHOS_TEST_TRUE(markup.find("busy") != std::string::npos);
+    POTHOS_TEST_TRUE(markup.find("penwidth") != std::string::npos);
+
+    topology.disconnectAll();
+    topology.commit();
+}
+
+/***********************************************************************
+ * Run a fused chain: source -> [forwarder -> forwarder -> sink]
+ **********************************************************************/
+static void testFusedChain(const Pothos::ThreadPoolArgs &args)
+{
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+    auto forwarder0 = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+    auto forwarder1 = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+
+    Pothos::Topology topology;
+    topology.setThreadPool(Pothos::ThreadPool(args));
+    topology.setFusedGroup("chain", {Pothos::Object(forwarder0), Pothos::Object(forwarder1), Pothos::Object(sink)});
+    POTHOS_TEST_EQUAL(topology.getFusedGroups().size(), 1);
+    topology.connect(source, 0, forwarder0, 0);
+    topology.connect(forwarder0, 0, forwarder1, 0);
+    topology.connect(forwarder1, 0, sink, 0);
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const unsigned long long sinkBytes0 = sink.call("getNumBytes");
+
+    //removing the group unfuses the blocks on the next commit
+    topology.setFusedGroup("chain", {});
+    POTHOS_TEST_EQUAL(topology.getFusedGroups().size(), 0);
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const unsigned long long sinkBytes1 = sink.call("getNumBytes");
+
+    topology.disconnectAll();
+    topology.commit();
+
+    std::cout << "fused chain numThreads " << args.numThreads << " " << args.schedulerMode
+        << ": sink " << sinkBytes0 << " bytes fused, " << sinkBytes1 << " bytes total" << std::endl;
+    POTHOS_TEST_TRUE(sinkBytes0 > 0);
+    POTHOS_TEST_TRUE(sinkBytes1 > sinkBytes0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_topology_fusion)
+{
+    Pothos::ThreadPoolArgs args;
+    testFusedChain(args);
+
+    args.numThreads = 2;
+    testFusedChain(args);
+
+    args.schedulerMode = "WORK_STEALING";
+    testFusedChain(args);
+}
+
+/***********************************************************************
+ * Run a fused chain with static rates: source -> [fan-out -> fan-in -> sink]
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_topology_static_schedule)
+{
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+    auto fanOut = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(2));
+    auto fanIn = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(2), size_t(1));
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+
+    //the fan-out runs 3 times for every 2 runs of the fan-in
+    fanOut.call("output", 0).call("setStaticRate", size_t(2048));
+    fanOut.call("output", 1).call("setStaticRate", size_t(2048));
+    fanIn.call("input", 0).call("setStaticRate", size_t(3072));
+    fanIn.call("input", 1).call("setStaticRate", size_t(3072));
+    fanIn.call("output", 0).call("setStaticRate", size_t(6144));
+    sink.call("input", 0).call("setStaticRate", size_t(4096));
+    POTHOS_TEST_EQUAL(fanIn.call("input", 1).call<size_t>("staticRate"), 3072);
+
+    Pothos::Topology topology;
+    topology.setFusedGroup("chain", {Pothos::Object(fanOut), Pothos::Object(fanIn), Pothos::Object(sink)});
+    topology.connect(source, 0, fanOut, 0);
+    topology.connect(fanOut, 0, fanIn, 0);
+    topology.connect(fanOut, 1, fanIn, 1);
+    topology.connect(fanIn, 0, sink, 0);
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const unsigned long long sinkBytes = sink.call("getNumBytes");
+    topology.disconnectAll();
+    topology.commit();
+    std::cout << "static schedule: sink " << sinkBytes << " bytes" << std::endl;
+    POTHOS_TEST_TRUE(sinkBytes > 0);
+
+    //the second connection between the neighbors does not balance the first
+    fanIn.call("input", 1).call("setStaticRate", size_t(1024));
+    topology.connect(source, 0, fanOut, 0);
+    topology.connect(fanOut, 0, fanIn, 0);
+    topology.connect(fanOut, 1, fanIn, 1);
+    topology.connect(fanIn, 0, sink, 0);
+    POTHOS_TEST_THROWS(topology.commit(), Pothos::TopologyConnectError);
+    topology.setFusedGroup("chain", {});
+    topology.disconnectAll();
+    topology.commit();
+}
+
+/***********************************************************************
+ * Run two separate chains on a pool in dataflow task order:
+ * With the sticky order, each chain is serviced by its own thread.
+ **********************************************************************/
+static void testOrderedChains(const Pothos::ThreadPoolArgs &args)
+{
+    Pothos::Topology topology;
+    topology.setThreadPool(Pothos::ThreadPool(args));
+    std::vector<Pothos::Proxy> sinks;
+    for (size_t chain = 0; chain < 2; chain++)
+    {
+        //connect the consumers first so the order is not the creation order
+        auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+        auto forwarder0 = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+        auto forwarder1 = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+        sinks.push_back(Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink"));
+        topology.connect(forwarder1, 0, sinks.back(), 0);
+        topology.connect(forwarder0, 0, forwarder1, 0);
+        topology.connect(source, 0, forwarder0, 0);
+    }
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const unsigned long long sinkBytes0 = sinks[0].call("getNumBytes");
+    const unsigned long long sinkBytes1 = sinks[1].call("getNumBytes");
+    topology.disconnectAll();
+    topology.commit();
+
+    std::cout << "ordered chains numThreads " << args.numThreads << " " << args.taskOrder
+        << ": sinks " << sinkBytes0 << " and " << sinkBytes1 << " bytes" << std::endl;
+    POTHOS_TEST_TRUE(sinkBytes0 > 0);
+    POTHOS_TEST_TRUE(sinkBytes1 > 0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_topology_task_order)
+{
+    Pothos::ThreadPoolArgs args;
+    args.numThreads = 2;
+    args.taskOrder = "TOPOLOGICAL";
+    testOrderedChains(args);
+
+    args.taskOrder = "STICKY";
+    testOrderedChains(args);
+
+    //more threads than components: the extra threads visit all tasks
+    args.numThreads = 3;
+    testOrderedChains(args);
+}
+
+/***********************************************************************
+ * Run a high and a low priority chain on one pool thread
+ **********************************************************************/
+static void testPriorityChains(const Pothos::ThreadPoolArgs &args)
+{
+    Pothos::Topology topology;
+    topology.setThreadPool(Pothos::ThreadPool(args));
+    std::vector<Pothos::Proxy> sinks;
+    for (const int priority : {1, -1})
+    {
+        auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+        auto forwarder = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+        sinks.push_back(Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink"));
+        for (auto block : {source, forwarder, sinks.back()}) block.call("setSchedulingPriority", priority);
+        topology.connect(source, 0, forwarder, 0);
+        topology.connect(forwarder, 0, sinks.back(), 0);
+    }
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const unsigned long long highBytes = sinks[0].call("getNumBytes");
+    const unsigned long long lowBytes = sinks[1].call("getNumBytes");
+    topology.disconnectAll();
+    topology.commit();
+
+    //strict priority order can starve the low priority chain on one thread
+    std::cout << "priority chains " << args.schedulerMode << ": high "
+        << highBytes << " bytes, low " << lowBytes << " bytes" << std::endl;
+    POTHOS_TEST_TRUE(highBytes > 0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_scheduling_priority)
+{
+    auto forwarder = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+    POTHOS_TEST_EQUAL(forwarder.call<int>("getSchedulingPriority"), 0);
+    forwarder.call("setSchedulingPriority", 10);
+    POTHOS_TEST_EQUAL(forwarder.call<int>("getSchedulingPriority"), 1);
+    forwarder.call("setSchedulingPriority", -10);
+    POTHOS_TEST_EQUAL(forwarder.call<int>("getSchedulingPriority"), -1);
+
+    Pothos::ThreadPoolArgs args;
+    args.numThreads = 1;
+    testPriorityChains(args);
+
+    args.schedulerMode = "WORK_STEALING";
+    testPriorityChains(args);
+}
+
+/***********************************************************************
+ * Resize the thread pool while a chain is running
+ **********************************************************************/
+static void testResizedChain(const Pothos::ThreadPoolArgs &args)
+{
+    Pothos::ThreadPool threadPool(args);
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+    auto forwarder0 = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+    auto forwarder1 = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+
+    Pothos::Topology topology;
+    topology.setThreadPool(threadPool);
+    topology.connect(source, 0, forwarder0, 0);
+    topology.connect(forwarder0, 0, forwarder1, 0);
+    topology.connect(forwarder1, 0, sink, 0);
+    topology.commit();
+
+    //grow beyond the initial thread count, then shrink to one thread
+    std::vector<unsigned long long> sinkBytes;
+    for (const size_t numThreads : {3, 1})
+    {
+        threadPool.setNumThreads(numThreads);
+        POTHOS_TEST_EQUAL(threadPool.getNumThreads(), numThreads);
+        const unsigned long long sinkBytes0 = sink.call("getNumBytes");
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const unsigned long long sinkBytes1 = sink.call("getNumBytes");
+        sinkBytes.push_back(sinkBytes1-sinkBytes0);
+    }
+
+    topology.disconnectAll();
+    topology.commit();
+
+    std::cout << "resized chain " << args.schedulerMode << ": " << sinkBytes[0]
+        << " bytes with 3 threads, " << sinkBytes[1] << " bytes with 1 thread" << std::endl;
+    POTHOS_TEST_TRUE(sinkBytes[0] > 0);
+    POTHOS_TEST_TRUE(sinkBytes[1] > 0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_set_num_threads)
+{
+    Pothos::ThreadPoolArgs args(2/*threads*/);
+    testResizedChain(args);
+
+    args.schedulerMode = "WORK_STEALING";
+    testResizedChain(args);
+
+    //the planned affinity follows the number of threads
+    args.affinityMode = "AUTO";
+    testResizedChain(args);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_autoscale)
+{
+    Pothos::ThreadPoolArgs args(1/*threads*/);
+    args.maxThreads = 4;
+    Pothos::ThreadPool threadPool(args);
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+
+    Pothos::Topology topology;
+    topology.setThreadPool(threadPool);
+    topology.connect(source, 0, sink, 0);
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const size_t busyThreads = threadPool.getNumThreads();
+    const unsigned long long sinkBytes = sink.call("getNumBytes");
+    topology.disconnectAll();
+    topology.commit();
+
+    //the count stays in range, growth depends upon the measured load
+    std::cout << "autoscale: " << busyThreads << " threads" << std::endl;
+    POTHOS_TEST_TRUE(busyThreads >= 1);
+    POTHOS_TEST_TRUE(busyThreads <= 4);
+    POTHOS_TEST_TRUE(sinkBytes > 0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_idle_timeout)
+{
+    Pothos::ThreadPoolArgs args(0/*threads*/);
+    args.idleTimeout = 0.05;
+    Pothos::ThreadPool threadPool(args);
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+    auto forwarder = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1));
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+
+    //the inactive blocks are parked on the shared idle thread
+    for (auto block : {source, forwarder, sink}) block.call("setThreadPool", threadPool);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    //the active blocks get their dedicated threads back
+    Pothos::Topology topology;
+    topology.setThreadPool(threadPool);
+    topology.connect(source, 0, forwarder, 0);
+    topology.connect(forwarder, 0, sink, 0);
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const unsigned long long sinkBytes0 = sink.call("getNumBytes");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const unsigned long long sinkBytes1 = sink.call("getNumBytes");
+
+    //the blocks park again once the flow stops
+    topology.disconnectAll();
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::cout << "idle timeout: " << (sinkBytes1-sinkBytes0) << " bytes in 50ms" << std::endl;
+    POTHOS_TEST_TRUE(sinkBytes1 > sinkBytes0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_topology_fusion_errors)
+{
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+    auto fanOut = Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(2));
+    auto sink0 = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+    auto sink1 = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+
+    Pothos::Topology topology;
+    POTHOS_TEST_THROWS(topology.setFusedGroup("one", {Pothos::Object(source)}), Pothos::InvalidArgumentException);
+    POTHOS_TEST_THROWS(topology.setFusedGroup("repeat", {Pothos::Object(source), Pothos::Object(source)}), Pothos::InvalidArgumentException);
+
+    //the fan-out leaves the chain to the other sink
+    topology.setFusedGroup("chain", {Pothos::Object(source), Pothos::Object(fanOut), Pothos::Object(sink0)});
+    topology.connect(source, 0, fanOut, 0);
+    topology.connect(fanOut, 0, sink0, 0);
+    topology.connect(fanOut, 1, sink1, 0);
+    POTHOS_TEST_THROWS(topology.commit(), Pothos::TopologyConnectError);
+
+    //without the group the topology commits
+    topology.setFusedGroup("chain", {});
+    topology.commit();
+    topology.disconnectAll();
+    topology.commit();
+}
+
+/***********************************************************************
+ * Auto-tune the buffers of a small and a large producer
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_buffer_auto_tune)
+{
+    auto smallSource = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(1024), false);
+    auto largeSource = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(1 << 20), false);
+    auto smallSink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+    auto largeSink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+
+    Pothos::Topology topology;
+    POTHOS_TEST_THROWS(topology.connect(smallSource, 0, smallSink, 0, "{\"autoTune\" : 1}"), Pothos::TopologyConnectError);
+    topology.connect(smallSource, 0, smallSink, 0, "{\"autoTune\" : {\"interval\" : 0.02}}");
+    topology.connect(largeSource, 0, largeSink, 0, "{\"autoTune\" : {\"interval\" : 0.02, \"maxMemory\" : 1048576}}");
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    const auto stats = json::parse(topology.queryJSONStats());
+    const unsigned long long smallBytes = smallSink.call("getNumBytes");
+    const unsigned long long largeBytes = largeSink.call("getNumBytes");
+    topology.disconnectAll();
+    topology.commit();
+
+    //the small producer shrinks the default buffers, the large one grows them within the memory bound
+    const auto &smallTune = stats[smallSource.call<std::string>("uid")]["outputStats"][0]["autoTune"];
+    const auto &largeTune = stats[largeSource.call<std::string>("uid")]["outputStats"][0]["autoTune"];
+    std::cout << "auto-tune small: " << smallTune.dump() << ", large: " << largeTune.dump() << std::endl;
+    POTHOS_TEST_TRUE(smallBytes > 0);
+    POTHOS_TEST_TRUE(largeBytes > 0);
+    POTHOS_TEST_TRUE(smallTune["tuned"].get<bool>());
+    POTHOS_TEST_TRUE(smallTune["bufferSize"].get<size_t>() < 8192);
+    POTHOS_TEST_TRUE(largeTune["tuned"].get<bool>());
+    POTHOS_TEST_TRUE(largeTune["bufferSize"].get<size_t>() > 8192);
+    POTHOS_TEST_TRUE(largeTune["bufferSize"].get<size_t>()*largeTune["numBuffers"].get<size_t>() <= 1048576);
+}
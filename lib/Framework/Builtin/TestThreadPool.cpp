@@ -1,9 +1,19 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Testing.hpp>
 #include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <json.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool)
 {
@@ -24,6 +34,81 @@ POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool)
     Pothos::ThreadPoolArgs args4;
     args4.priority = -1e6;
     POTHOS_TEST_THROWS(Pothos::ThreadPool tp4(args4), Pothos::ThreadPoolError);
+
+    Pothos::ThreadPoolArgs args5;
+    args5.schedulerMode = "FAIL";
+    POTHOS_TEST_THROWS(Pothos::ThreadPool tp5(args5), Pothos::ThreadPoolError);
+
+    Pothos::ThreadPoolArgs args6;
+    args6.taskOrder = "FAIL";
+    POTHOS_TEST_THROWS(Pothos::ThreadPool tp6(args6), Pothos::ThreadPoolError);
+
+    Pothos::ThreadPoolArgs autoArgs(2/*threads*/);
+    autoArgs.affinityMode = "AUTO";
+    Pothos::ThreadPool autoPool(autoArgs);
+    POTHOS_TEST_TRUE(autoPool);
+
+    Pothos::ThreadPoolArgs args7(2/*threads*/);
+    args7.maxThreads = 1;
+    POTHOS_TEST_THROWS(Pothos::ThreadPool tp7(args7), Pothos::ThreadPoolError);
+
+    Pothos::ThreadPoolArgs args8(2/*threads*/);
+    args8.idleTimeout = 1.0;
+    POTHOS_TEST_THROWS(Pothos::ThreadPool tp8(args8), Pothos::ThreadPoolError);
+
+    Pothos::ThreadPoolArgs args9;
+    args9.realtimePolicy = "FAIL";
+    POTHOS_TEST_THROWS(Pothos::ThreadPool tp9(args9), Pothos::ThreadPoolError);
+
+    Pothos::ThreadPoolArgs fifoArgs(2/*threads*/);
+    fifoArgs.realtimePolicy = "FIFO";
+    Pothos::ThreadPool fifoPool(fifoArgs);
+    POTHOS_TEST_TRUE(fifoPool);
+
+    //the deadline policy requires runtime <= deadline <= period
+    Pothos::ThreadPoolArgs args10;
+    args10.realtimePolicy = "DEADLINE";
+    POTHOS_TEST_THROWS(Pothos::ThreadPool tp10(args10), Pothos::ThreadPoolError);
+    args10.deadlineRuntime = 2e-3;
+    args10.deadlinePeriod = 1e-3;
+    POTHOS_TEST_THROWS(Pothos::ThreadPool tp10(args10), Pothos::ThreadPoolError);
+    args10.deadlinePeriod = 10e-3;
+    args10.deadline = 20e-3;
+    POTHOS_TEST_THROWS(Pothos::ThreadPool tp10(args10), Pothos::ThreadPoolError);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_resize)
+{
+    Pothos::ThreadPool tp0;
+    POTHOS_TEST_THROWS(tp0.setNumThreads(2), Pothos::ThreadPoolError);
+
+    Pothos::ThreadPool tp1((Pothos::ThreadPoolArgs()));
+    POTHOS_TEST_EQUAL(tp1.getNumThreads(), 0);
+    POTHOS_TEST_THROWS(tp1.setNumThreads(2), Pothos::ThreadPoolError);
+
+    Pothos::ThreadPool tp2(Pothos::ThreadPoolArgs(2/*threads*/));
+    POTHOS_TEST_EQUAL(tp2.getNumThreads(), 2);
+    POTHOS_TEST_THROWS(tp2.setNumThreads(0), Pothos::ThreadPoolError);
+    tp2.setNumThreads(4);
+    POTHOS_TEST_EQUAL(tp2.getNumThreads(), 4);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_registration)
+{
+    //register and unregister many blocks in every pool mode
+    for (const auto &schedulerMode : {"ROUND_ROBIN", "WORK_STEALING"})
+    {
+        Pothos::ThreadPoolArgs args(4/*threads*/);
+        args.schedulerMode = schedulerMode;
+        Pothos::ThreadPool threadPool(args);
+        std::vector<Pothos::Proxy> blocks;
+        for (size_t i = 0; i < 100; i++)
+        {
+            blocks.push_back(Pothos::BlockRegistry::make("/blocks/synthetic/forwarder", size_t(1), size_t(1)));
+            blocks.back().call("setThreadPool", threadPool);
+        }
+        for (auto &block : blocks) block.call("setThreadPool", Pothos::ThreadPool());
+    }
 }
 
 POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_args)
@@ -32,7 +117,373 @@ POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_args)
     const std::vector<size_t> expected = {0, 4};
     POTHOS_TEST_EQUALV(args.affinity, expected);
     POTHOS_TEST_EQUAL(args.numThreads, 2);
+    POTHOS_TEST_EQUAL(args.maxThreads, 0);
+    POTHOS_TEST_EQUAL(args.idleTimeout, 0.0);
     POTHOS_TEST_EQUAL(args.priority, 0.0);
     POTHOS_TEST_EQUAL(args.affinityMode, "");
     POTHOS_TEST_EQUAL(args.yieldMode, "");
+    POTHOS_TEST_EQUAL(args.schedulerMode, "");
+    POTHOS_TEST_EQUAL(args.spinBudget, 4096);
+    POTHOS_TEST_EQUAL(args.taskOrder, "");
+    POTHOS_TEST_EQUAL(args.realtimePolicy, "");
+    POTHOS_TEST_EQUAL(args.deadlineRuntime, 0.0);
+    POTHOS_TEST_EQUAL(args.deadline, 0.0);
+    POTHOS_TEST_EQUAL(args.deadlinePeriod, 0.0);
+    POTHOS_TEST_EQUAL(args.cpuDmaLatency, -1);
+
+    Pothos::ThreadPoolArgs hybridArgs("{\"yieldMode\":\"HYBRID\", \"spinBudget\":100}");
+    POTHOS_TEST_EQUAL(hybridArgs.yieldMode, "HYBRID");
+    POTHOS_TEST_EQUAL(hybridArgs.spinBudget, 100);
+
+    Pothos::ThreadPoolArgs stickyArgs("{\"numThreads\":2, \"taskOrder\":\"STICKY\"}");
+    POTHOS_TEST_EQUAL(stickyArgs.taskOrder, "STICKY");
+
+    Pothos::ThreadPoolArgs autoscaleArgs("{\"numThreads\":1, \"maxThreads\":4}");
+    POTHOS_TEST_EQUAL(autoscaleArgs.maxThreads, 4);
+
+    Pothos::ThreadPoolArgs idleArgs("{\"numThreads\":0, \"idleTimeout\":0.5}");
+    POTHOS_TEST_EQUAL(idleArgs.idleTimeout, 0.5);
+
+    Pothos::ThreadPoolArgs deadlineArgs("{\"priority\":1.0, \"realtimePolicy\":\"DEADLINE\", "
+        "\"deadlineRuntime\":0.001, \"deadline\":0.005, \"deadlinePeriod\":0.01, \"cpuDmaLatency\":0}");
+    POTHOS_TEST_EQUAL(deadlineArgs.realtimePolicy, "DEADLINE");
+    POTHOS_TEST_EQUAL(deadlineArgs.deadlineRuntime, 0.001);
+    POTHOS_TEST_EQUAL(deadlineArgs.deadline, 0.005);
+    POTHOS_TEST_EQUAL(deadlineArgs.deadlinePeriod, 0.01);
+    POTHOS_TEST_EQUAL(deadlineArgs.cpuDmaLatency, 0);
+}
+
+/***********************************************************************
+ * Helper blocks to pass a counted message through a chain
+ **********************************************************************/
+struct CountSource : Pothos::Block
+{
+    CountSource(const size_t total):
+        total(total)
+    {
+        this->setupOutput("0");
+    }
+
+    void work(void)
+    {
+        if (total == 0) return;
+        total--;
+        this->output(0)->postMessage(total);
+    }
+
+    size_t total;
+};
+
+struct CountRelay : Pothos::Block
+{
+    CountRelay(void):
+        count(0)
+    {
+        this->setupInput("0");
+        this->setupOutput("0");
+    }
+
+    void work(void)
+    {
+        auto in0 = this->input(0);
+        if (not in0->hasMessage()) return;
+        this->output(0)->postMessage(in0->popMessage());
+        count++;
+    }
+
+    size_t count;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_work_stealing)
+{
+    Pothos::ThreadPoolArgs args(2/*threads*/);
+    args.schedulerMode = "WORK_STEALING";
+    Pothos::ThreadPool threadPool(args);
+
+    //create a chain of relays all running in the work-stealing pool
+    auto source = std::make_shared<CountSource>(100);
+    source->setThreadPool(threadPool);
+    std::vector<std::shared_ptr<CountRelay>> relays;
+    for (size_t i = 0; i < 8; i++)
+    {
+        relays.push_back(std::make_shared<CountRelay>());
+        relays.back()->setThreadPool(threadPool);
+    }
+
+    Pothos::Topology topology;
+    topology.connect(source, 0, relays.front(), 0);
+    for (size_t i = 1; i < relays.size(); i++)
+    {
+        topology.connect(relays[i-1], 0, relays[i], 0);
+    }
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    //every message should have passed through every relay
+    for (const auto &relay : relays) POTHOS_TEST_EQUAL(relay->count, 100);
+}
+
+/***********************************************************************
+ * An application executor: a queue of work items serviced by its own threads
+ **********************************************************************/
+struct QueueExecutor : Pothos::ThreadPoolExecutor
+{
+    QueueExecutor(const size_t numThreads):
+        numPosted(0),
+        done(false)
+    {
+        for (size_t i = 0; i < numThreads; i++) threads.emplace_back(&QueueExecutor::run, this);
+    }
+
+    ~QueueExecutor(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        cond.notify_all();
+        for (auto &thread : threads) thread.join();
+    }
+
+    void post(const std::function<void(void)> &workItem)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push_back(workItem);
+            numPosted++;
+        }
+        cond.notify_one();
+    }
+
+    void run(void)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            cond.wait(lock, [this]{return done or not items.empty();});
+            if (items.empty()) return;
+            auto workItem = std::move(items.front());
+            items.pop_front();
+            lock.unlock();
+            workItem();
+            workItem = nullptr; //release the task before taking the lock
+            lock.lock();
+        }
+    }
+
+    std::deque<std::function<void(void)>> items;
+    size_t numPosted;
+    bool done;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<std::thread> threads;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_executor)
+{
+    POTHOS_TEST_THROWS(Pothos::ThreadPool(Pothos::ThreadPoolArgs(), nullptr), Pothos::ThreadPoolError);
+
+    //the executor outlives the pool, which waits on the posted work items
+    auto executor = std::make_shared<QueueExecutor>(2);
+    Pothos::ThreadPool threadPool(Pothos::ThreadPoolArgs(), executor);
+    POTHOS_TEST_EQUAL(threadPool.getNumThreads(), 0);
+    POTHOS_TEST_THROWS(threadPool.setNumThreads(2), Pothos::ThreadPoolError);
+
+    {
+        auto source = std::make_shared<CountSource>(100);
+        source->setThreadPool(threadPool);
+        std::vector<std::shared_ptr<CountRelay>> relays;
+        for (size_t i = 0; i < 4; i++)
+        {
+            relays.push_back(std::make_shared<CountRelay>());
+            relays.back()->setThreadPool(threadPool);
+        }
+
+        Pothos::Topology topology;
+        topology.connect(source, 0, relays.front(), 0);
+        for (size_t i = 1; i < relays.size(); i++)
+        {
+            topology.connect(relays[i-1], 0, relays[i], 0);
+        }
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive());
+        for (const auto &relay : relays) POTHOS_TEST_EQUAL(relay->count, 100);
+        topology.disconnectAll();
+        topology.commit();
+    }
+
+    std::lock_guard<std::mutex> lock(executor->mutex);
+    std::cout << "executor work items " << executor->numPosted << std::endl;
+    POTHOS_TEST_TRUE(executor->numPosted >= 100);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_stats)
+{
+    POTHOS_TEST_THROWS(Pothos::ThreadPool().queryStats(), Pothos::ThreadPoolError);
+
+    //thread-per-block, round-robin pool, and work-stealing pool
+    for (const auto &json : {
+        "{}",
+        "{\"numThreads\":2}",
+        "{\"numThreads\":2, \"schedulerMode\":\"WORK_STEALING\"}"})
+    {
+        Pothos::ThreadPool threadPool{Pothos::ThreadPoolArgs(json)};
+        auto source = std::make_shared<CountSource>(100);
+        source->setThreadPool(threadPool);
+        auto relay = std::make_shared<CountRelay>();
+        relay->setThreadPool(threadPool);
+
+        Pothos::Topology topology;
+        topology.connect(source, 0, relay, 0);
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive());
+        POTHOS_TEST_EQUAL(relay->count, 100);
+
+        //the blocks report the stats of their pool
+        const auto topStats = nlohmann::json::parse(topology.queryJSONStats());
+        const auto &poolStats = topStats[relay->uid()]["threadPool"];
+        std::cout << json << " " << poolStats.dump() << std::endl;
+        POTHOS_TEST_EQUAL(poolStats["id"], topStats[source->uid()]["threadPool"]["id"]);
+
+        //the counters are flushed when the threads exit
+        topology.disconnectAll();
+        topology.commit();
+        source->setThreadPool(Pothos::ThreadPool());
+        relay->setThreadPool(Pothos::ThreadPool());
+        const auto stats = nlohmann::json::parse(threadPool.queryStats());
+        POTHOS_TEST_TRUE(stats["numTasks"].get<unsigned long long>() >= 100);
+        POTHOS_TEST_TRUE(stats["taskTimeNs"].get<unsigned long long>() > 0);
+        POTHOS_TEST_TRUE(stats["elapsedNs"].get<unsigned long long>() > 0);
+    }
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_hybrid)
+{
+    //thread-per-block, round-robin pool, and work-stealing pool
+    for (const auto &json : {
+        "{\"yieldMode\":\"HYBRID\", \"spinBudget\":100}",
+        "{\"yieldMode\":\"HYBRID\", \"numThreads\":2}",
+        "{\"yieldMode\":\"HYBRID\", \"numThreads\":2, \"schedulerMode\":\"WORK_STEALING\"}"})
+    {
+        Pothos::ThreadPool threadPool{Pothos::ThreadPoolArgs(json)};
+
+        //create a chain of relays all running in the hybrid pool
+        auto source = std::make_shared<CountSource>(100);
+        source->setThreadPool(threadPool);
+        auto relay0 = std::make_shared<CountRelay>();
+        relay0->setThreadPool(threadPool);
+        auto relay1 = std::make_shared<CountRelay>();
+        relay1->setThreadPool(threadPool);
+
+        Pothos::Topology topology;
+        topology.connect(source, 0, relay0, 0);
+        topology.connect(relay0, 0, relay1, 0);
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive());
+        POTHOS_TEST_EQUAL(relay1->count, 100);
+    }
+}
+
+/***********************************************************************
+ * Paced source which posts at fixed intervals using timed wakeups
+ **********************************************************************/
+struct PacedSource : Pothos::Block
+{
+    PacedSource(const size_t total, const std::chrono::milliseconds &period):
+        total(total),
+        period(period),
+        numWorkCalls(0)
+    {
+        this->setupOutput("0");
+    }
+
+    void activate(void)
+    {
+        next = std::chrono::steady_clock::now();
+    }
+
+    void work(void)
+    {
+        numWorkCalls++;
+        if (total == 0) return;
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= next)
+        {
+            if (times.empty()) first = now;
+            times.push_back(now);
+            total--;
+            this->output(0)->postMessage(total);
+            next += period;
+        }
+        this->scheduleWakeup(next);
+    }
+
+    size_t total;
+    const std::chrono::milliseconds period;
+    size_t numWorkCalls;
+    std::chrono::steady_clock::time_point next, first;
+    std::vector<std::chrono::steady_clock::time_point> times;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_wakeup)
+{
+    //thread-per-block, round-robin pool, and work-stealing pool
+    for (const auto &json : {
+        "{}",
+        "{\"numThreads\":2}",
+        "{\"numThreads\":2, \"schedulerMode\":\"WORK_STEALING\"}"})
+    {
+        Pothos::ThreadPool threadPool{Pothos::ThreadPoolArgs(json)};
+        const size_t total = 20;
+        const std::chrono::milliseconds period(5);
+
+        auto source = std::make_shared<PacedSource>(total, period);
+        source->setThreadPool(threadPool);
+        auto relay = std::make_shared<CountRelay>();
+        relay->setThreadPool(threadPool);
+
+        Pothos::Topology topology;
+        topology.connect(source, 0, relay, 0);
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.1, 5.0));
+        POTHOS_TEST_EQUAL(relay->count, total);
+
+        //the messages are paced, and the source was not polled in between
+        POTHOS_TEST_TRUE(source->times.back() - source->first >= (total-1)*period);
+        std::cout << json << " work calls " << source->numWorkCalls << std::endl;
+        POTHOS_TEST_TRUE(source->numWorkCalls < 10*total);
+    }
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_thread_pool_idle_park)
+{
+    //the round-robin threads of an idle pool park without periodic wakeups
+    Pothos::ThreadPool threadPool{Pothos::ThreadPoolArgs("{\"numThreads\":2}")};
+    auto source = std::make_shared<CountSource>(100);
+    source->setThreadPool(threadPool);
+    auto relay = std::make_shared<CountRelay>();
+    relay->setThreadPool(threadPool);
+
+    Pothos::Topology topology;
+    topology.connect(source, 0, relay, 0);
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(relay->count, 100);
+
+    const auto before = nlohmann::json::parse(threadPool.queryStats());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const auto after = nlohmann::json::parse(threadPool.queryStats());
+    const auto numWaits = after["numWaits"].get<unsigned long long>() - before["numWaits"].get<unsigned long long>();
+    std::cout << "idle pool waits " << numWaits << std::endl;
+    POTHOS_TEST_TRUE(numWaits < 10);
+
+    //a flagged change still reaches the parked threads
+    auto source2 = std::make_shared<CountSource>(100);
+    source2->setThreadPool(threadPool);
+    auto relay2 = std::make_shared<CountRelay>();
+    relay2->setThreadPool(threadPool);
+    topology.connect(source2, 0, relay2, 0);
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(relay2->count, 100);
 }
@@ -1,10 +1,20 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Testing.hpp>
 #include <Pothos/Framework.hpp>
+#include "Framework/PlacementPlanner.hpp"
+#include "Framework/TopologyStatsDelta.hpp"
+#include <Poco/TemporaryFile.h>
+#include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPResponse.h>
 #include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <algorithm> //max
 #include <json.hpp>
 
 using json = nlohmann::json;
@@ -86,6 +96,25 @@ struct Passer : Pothos::Block
 size_t workCount;
 };
 
+/***********************************************************************
+ * Helper block to test the configured output buffer size
+ **********************************************************************/
+struct BufferSizer : Pothos::Block
+{
+    BufferSizer(void):
+        outputBytes(0)
+    {
+        this->setupOutput("out0", "uint8");
+    }
+
+    void work(void)
+    {
+        outputBytes = std::max(outputBytes, this->output("out0")->elements());
+    }
+
+size_t outputBytes;
+};
+
 /***********************************************************************
  * Helper method for unit tests
  **********************************************************************/
@@ -254,6 +283,47 @@ POTHOS_TEST_BLOCK("/framework/tests/topology", test_nested_passthrough)
     }
 }
 
+/***********************************************************************
+ * Test that changes within nested topologies invalidate the squash cache
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_nested_change_recommit)
+{
+    //the inner topology passes through a block
+    auto passerBlock = std::shared_ptr<Passer>(new Passer());
+    auto passer = Pothos::Topology::make();
+    passer->connect(passer, "passIn", passerBlock, "in0");
+    passer->connect(passerBlock, "out0", passer, "passOut");
+
+    auto nester = Pothos::Topology::make();
+    nester->connect(nester, "nestIn", passer, "passIn");
+    nester->connect(passer, "passOut", nester, "nestOut");
+
+    auto ping = std::shared_ptr<Ping>(new Ping());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", nester, "nestIn");
+    topology.connect(nester, "nestOut", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(pong->triggered, 1);
+    POTHOS_TEST_EQUAL(json::parse(topology.dumpJSON("{\"mode\":\"rendered\"}"))["blocks"].size(), 3);
+
+    //an unchanged commit uses the cached flows
+    topology.commit();
+    POTHOS_TEST_EQUAL(json::parse(topology.dumpJSON("{\"mode\":\"rendered\"}"))["blocks"].size(), 3);
+
+    //replace the block with a direct pass-through, two levels down
+    passer->disconnectAll();
+    passer->connect(passer, "passIn", passer, "passOut");
+    topology.commit();
+    const auto topObj = json::parse(topology.dumpJSON("{\"mode\":\"rendered\"}"));
+    POTHOS_TEST_EQUAL(topObj["blocks"].size(), 2);
+    POTHOS_TEST_TRUE(connectionsHave(topObj["connections"], ping->uid(), "out0", pong->uid(), "in0"));
+
+    topology.disconnectAll();
+    topology.commit();
+}
+
 /***********************************************************************
  * Test a pass-through topology that terminates in different layers
  **********************************************************************/
@@ -589,3 +659,731 @@ POTHOS_TEST_BLOCK("/framework/tests/topology", test_independent_passthrough)
         POTHOS_TEST_TRUE(connectionsHave(connsArray, pingInner->uid(), "out0", pongInner->uid(), "in0"));
     }
 }
+
+/***********************************************************************
+ * Test the buffer arguments on the connect call
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_connect_buffer_args)
+{
+    //create blocks
+    auto sizer = std::shared_ptr<BufferSizer>(new BufferSizer());
+    auto passer = std::shared_ptr<Passer>(new Passer());
+
+    //connect with a larger buffer size than the default
+    Pothos::Topology topology;
+    topology.connect(sizer, "out0", passer, "in1", "{\"numBuffers\" : 2, \"bufferSize\" : 65536}");
+    topology.commit();
+
+    //check that the configured buffers were used
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(sizer->outputBytes, 65536);
+
+    //bad arguments are caught before the connection is made
+    POTHOS_TEST_THROWS(topology.connect(sizer, "out0", passer, "in0", "[1, 2]"), Pothos::TopologyConnectError);
+    POTHOS_TEST_THROWS(topology.connect(sizer, "out0", passer, "in0", "{bad json"), Pothos::TopologyConnectError);
+}
+
+/***********************************************************************
+ * Test buffer arguments, flows, and stats through nested local topologies
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_nested_local_hierarchy)
+{
+    auto sizer = std::shared_ptr<BufferSizer>(new BufferSizer());
+    auto passer = std::shared_ptr<Passer>(new Passer());
+
+    //the sizer is behind a chain of nested pass-through topologies
+    auto source = Pothos::Topology::make();
+    source->connect(sizer, "out0", source, "out");
+    for (size_t i = 0; i < 10; i++)
+    {
+        auto nester = Pothos::Topology::make();
+        nester->connect(source, "out", nester, "out");
+        source = nester;
+    }
+
+    //the buffer arguments configure the block within the hierarchy
+    Pothos::Topology topology;
+    topology.connect(source, "out", passer, "in1", "{\"numBuffers\" : 2, \"bufferSize\" : 65536}");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(sizer->outputBytes, 65536);
+
+    //the flat flows reach through every level
+    const auto topObj = json::parse(topology.dumpJSON("{\"mode\":\"flat\"}"));
+    POTHOS_TEST_EQUAL(topObj["connections"].size(), 1);
+    POTHOS_TEST_TRUE(connectionsHave(topObj["connections"], sizer->uid(), "out0", passer->uid(), "in1"));
+
+    //the stats of the nested block are found through the local topologies
+    const auto stats = json::parse(topology.queryJSONStats());
+    POTHOS_TEST_TRUE(stats.count(sizer->uid()) != 0);
+    POTHOS_TEST_TRUE(stats.count(passer->uid()) != 0);
+    POTHOS_TEST_TRUE(stats[sizer->uid()]["numWorkCalls"].get<unsigned long long>() > 0);
+}
+
+/***********************************************************************
+ * Test the work stats timing levels
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_stats_level)
+{
+    Pothos::Topology topology;
+    POTHOS_TEST_THROWS(topology.setStatsLevel("BOGUS"), Pothos::InvalidArgumentException);
+
+    for (const std::string level : {"FULL", "CYCLES", "NONE", "PERF"})
+    {
+        POTHOS_TEST_CHECKPOINT();
+        auto ping = std::shared_ptr<Ping>(new Ping());
+        auto pong = std::shared_ptr<Pong>(new Pong());
+        topology.setStatsLevel(level);
+        POTHOS_TEST_EQUAL(topology.getStatsLevel(), level);
+        topology.connect(ping, "out0", pong, "in0");
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive());
+        POTHOS_TEST_EQUAL(pong->triggered, 1);
+
+        //the call counters are always kept, the timing depends on the level
+        const auto stats = json::parse(topology.queryJSONStats());
+        const auto &pingStats = stats[ping->uid()];
+        POTHOS_TEST_EQUAL(pingStats["statsLevel"].get<std::string>(), level);
+        POTHOS_TEST_TRUE(pingStats["numWorkCalls"].get<unsigned long long>() > 0);
+        if (level == "NONE")
+        {
+            POTHOS_TEST_EQUAL(pingStats["totalTimeTask"].get<long long>(), 0);
+        }
+        else
+        {
+            POTHOS_TEST_TRUE(pingStats["totalTimeTask"].get<long long>() > 0);
+        }
+
+        //the hardware counters are only kept in the PERF level (and may be unavailable)
+        if (level != "PERF")
+        {
+            POTHOS_TEST_EQUAL(pingStats["workCycles"].get<unsigned long long>(), 0);
+            POTHOS_TEST_EQUAL(pingStats["workInstructions"].get<unsigned long long>(), 0);
+        }
+        std::cout << level << " workCycles " << pingStats["workCycles"].get<unsigned long long>() << std::endl;
+
+        topology.disconnectAll();
+        topology.commit();
+    }
+}
+
+/***********************************************************************
+ * Test the stall reason counters
+ **********************************************************************/
+struct UnpreparedPong : Pong
+{
+    bool prepare(void)
+    {
+        return false;
+    }
+};
+
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_stall_counters)
+{
+    auto ping = std::shared_ptr<Ping>(new Ping());
+    auto pong = std::shared_ptr<UnpreparedPong>(new UnpreparedPong());
+
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    //the message wakes up the pong block, which is never prepared to work
+    json pongStats;
+    for (size_t i = 0; i < 100; i++)
+    {
+        pongStats = json::parse(topology.queryJSONStats())[pong->uid()];
+        if (pongStats["stallPrepare"].get<unsigned long long>() > 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    POTHOS_TEST_TRUE(pongStats["stallPrepare"].get<unsigned long long>() > 0);
+    POTHOS_TEST_EQUAL(pongStats["numWorkCalls"].get<unsigned long long>(), 0);
+    POTHOS_TEST_EQUAL(pong->triggered, 0);
+    for (const auto &key : {"stallNoTokens", "stallMessagesFull", "stallNoOutputBuffer", "stallReserve"})
+    {
+        POTHOS_TEST_TRUE(pongStats.count(key) != 0);
+    }
+
+    topology.disconnectAll();
+    topology.commit();
+}
+
+/***********************************************************************
+ * Test the binary encodings of the dump and the stats
+ **********************************************************************/
+static json decodeBinary(const std::string &data, const std::string &format)
+{
+    const std::vector<uint8_t> bytes(data.begin(), data.end());
+    if (format == "cbor") return json::from_cbor(bytes);
+    return json::from_msgpack(bytes);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_binary_encoding)
+{
+    auto ping = std::shared_ptr<Ping>(new Ping());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    const auto dumpObj = json::parse(topology.dumpJSON("{\"mode\":\"flat\"}"));
+    for (const std::string format : {"cbor", "msgpack"})
+    {
+        POTHOS_TEST_CHECKPOINT();
+        const auto binaryDump = topology.dumpJSON("{\"mode\":\"flat\", \"format\":\"" + format + "\"}");
+        POTHOS_TEST_TRUE(binaryDump.size() < dumpObj.dump(4).size());
+        POTHOS_TEST_TRUE(decodeBinary(binaryDump, format) == dumpObj);
+
+        //the block names come from the cache made at commit
+        const auto stats = decodeBinary(topology.queryJSONStats("{\"format\":\"" + format + "\"}"), format);
+        POTHOS_TEST_EQUAL(stats[ping->uid()]["blockName"].get<std::string>(), "Ping");
+        POTHOS_TEST_EQUAL(stats[pong->uid()]["blockName"].get<std::string>(), "Pong");
+    }
+    POTHOS_TEST_THROWS(topology.dumpJSON("{\"format\":\"bogus\"}"), Pothos::InvalidArgumentException);
+
+    topology.disconnectAll();
+    topology.commit();
+}
+
+/***********************************************************************
+ * Test the delta stream of the stats
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_stats_delta)
+{
+    auto ping = std::shared_ptr<Ping>(new Ping());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    //the first reply of a stream has the full stats
+    const auto reply0 = json::parse(topology.queryJSONStats("{\"delta\":\"test\"}"));
+    POTHOS_TEST_TRUE(reply0["full"].get<bool>());
+    POTHOS_TEST_EQUAL(reply0["stats"][pong->uid()]["blockName"].get<std::string>(), "Pong");
+    auto merged = reply0["stats"];
+
+    //the next reply in sequence only has the changed values
+    const auto seq0 = reply0["seq"].get<unsigned long long>();
+    const auto reply1 = json::parse(topology.queryJSONStats("{\"delta\":\"test\", \"seq\":" + std::to_string(seq0) + "}"));
+    POTHOS_TEST_TRUE(not reply1["full"].get<bool>());
+    POTHOS_TEST_EQUAL(reply1["seq"].get<unsigned long long>(), seq0+1);
+    POTHOS_TEST_TRUE(reply1["stats"].dump().size() < reply0["stats"].dump().size());
+    POTHOS_TEST_TRUE(not reply1["stats"][pong->uid()].count("blockName"));
+    applyStatsDelta(merged, reply1["stats"]);
+    POTHOS_TEST_EQUAL(merged[pong->uid()]["blockName"].get<std::string>(), "Pong");
+
+    //a caller out of sequence gets the full stats again
+    const auto reply2 = json::parse(topology.queryJSONStats("{\"delta\":\"test\", \"seq\":" + std::to_string(seq0) + "}"));
+    POTHOS_TEST_TRUE(reply2["full"].get<bool>());
+    POTHOS_TEST_EQUAL(merged[pong->uid()].size(), reply2["stats"][pong->uid()].size());
+
+    //deltas express changed, added, and removed values
+    const auto stats0 = json::parse("{\"a\":{\"n\":1, \"ports\":[{\"t\":1}, {\"t\":2}]}, \"b\":{\"n\":2}}");
+    const auto stats1 = json::parse("{\"a\":{\"n\":1, \"ports\":[{\"t\":1}, {\"t\":3}]}, \"c\":{\"n\":3}}");
+    bool full(false);
+    const auto delta = makeStatsDelta(stats0, stats1, full);
+    POTHOS_TEST_TRUE(not full);
+    POTHOS_TEST_EQUAL(delta.dump(), "{\"a\":{\"ports\":{\"1\":{\"t\":3}}},\"b\":null,\"c\":{\"n\":3}}");
+    auto base = stats0;
+    applyStatsDelta(base, delta);
+    POTHOS_TEST_TRUE(base == stats1);
+
+    topology.disconnectAll();
+    topology.commit();
+}
+
+/***********************************************************************
+ * Test the scheduler trace
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_topology_trace)
+{
+    auto ping = std::shared_ptr<Ping>(new Ping());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+
+    Pothos::Topology topology;
+    POTHOS_TEST_TRUE(not topology.getTraceEnabled());
+    topology.setTraceEnabled(true);
+    POTHOS_TEST_TRUE(topology.getTraceEnabled());
+    topology.connect(ping, "out0", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(pong->triggered, 1);
+
+    //both blocks ran a task, and the message woke up the pong block
+    const auto trace = json::parse(topology.dumpTrace());
+    size_t pingTasks(0), pongTasks(0), pongWakes(0), threadNames(0);
+    for (const auto &event : trace["traceEvents"])
+    {
+        const auto ph = event["ph"].get<std::string>();
+        const auto name = event["name"].get<std::string>();
+        if (ph == "B" and name == "Ping") pingTasks++;
+        if (ph == "B" and name == "Pong") pongTasks++;
+        if (ph == "i" and name == "wake Pong") pongWakes++;
+        if (ph == "M" and name == "thread_name") threadNames++;
+    }
+    std::cout << "trace events " << trace["traceEvents"].size() << std::endl;
+    POTHOS_TEST_TRUE(pingTasks > 0);
+    POTHOS_TEST_TRUE(pongTasks > 0);
+    POTHOS_TEST_TRUE(pongWakes > 0);
+    POTHOS_TEST_TRUE(threadNames > 0);
+
+    topology.setTraceEnabled(false);
+    POTHOS_TEST_TRUE(not topology.getTraceEnabled());
+    topology.commit();
+
+    topology.disconnectAll();
+    topology.commit();
+}
+
+/***********************************************************************
+ * Test the periodic stats export
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_stats_export)
+{
+    auto ping = std::shared_ptr<Ping>(new Ping());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    //export a few lines and check the latest counters
+    Poco::TemporaryFile tempFile;
+    topology.startStatsExport(tempFile.path(), 0.01);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    topology.stopStatsExport();
+
+    std::ifstream in(tempFile.path());
+    std::string line, lastLine;
+    size_t numLines = 0;
+    while (std::getline(in, line)) {lastLine = line; numLines++;}
+    POTHOS_TEST_TRUE(numLines > 0);
+
+    const auto lineObj = json::parse(lastLine);
+    POTHOS_TEST_TRUE(lineObj["time"].get<double>() > 0.0);
+    const auto &stats = lineObj["stats"];
+    POTHOS_TEST_EQUAL(stats[ping->uid()]["blockName"].get<std::string>(), "Ping");
+    POTHOS_TEST_TRUE(stats[ping->uid()]["numWorkCalls"].get<unsigned long long>() > 0);
+    POTHOS_TEST_TRUE(stats[pong->uid()]["numWorkCalls"].get<unsigned long long>() > 0);
+
+    //a bad path throws
+    POTHOS_TEST_THROWS(topology.startStatsExport("/no/such/dir/stats.json"), Pothos::OpenFileException);
+}
+
+/***********************************************************************
+ * Test the OpenMetrics text and server
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_stats_metrics)
+{
+    auto ping = std::shared_ptr<Ping>(new Ping());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    const auto text = topology.queryMetrics();
+    std::cout << text << std::endl;
+    POTHOS_TEST_TRUE(text.find("# TYPE pothos_block_work_calls counter") != std::string::npos);
+    POTHOS_TEST_TRUE(text.find("pothos_block_work_calls_total{uid=\""+ping->uid()+"\",block=\"Ping\"} ") != std::string::npos);
+    POTHOS_TEST_TRUE(text.find("direction=\"input\",port=\"in0\"") != std::string::npos);
+    POTHOS_TEST_TRUE(text.find("reason=\"noTokens\"") != std::string::npos);
+    POTHOS_TEST_EQUAL(text.substr(text.size()-6), "# EOF\n");
+
+    //scrape the same text over http
+    const auto address = topology.startMetricsServer("127.0.0.1:0");
+    Poco::Net::HTTPClientSession session{Poco::Net::SocketAddress(address)};
+    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, "/metrics", Poco::Net::HTTPMessage::HTTP_1_1);
+    session.sendRequest(request);
+    Poco::Net::HTTPResponse response;
+    auto &is = session.receiveResponse(response);
+    POTHOS_TEST_EQUAL(response.getStatus(), Poco::Net::HTTPResponse::HTTP_OK);
+    const std::string body((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    POTHOS_TEST_TRUE(body.find("pothos_block_work_calls_total{uid=\""+pong->uid()+"\"") != std::string::npos);
+    topology.stopMetricsServer();
+}
+
+/***********************************************************************
+ * Test the stats history rings
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_stats_history)
+{
+    auto ping = std::shared_ptr<Ping>(new Ping());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    //wait for a few sampled intervals
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    const auto stats = json::parse(topology.queryStatsHistory(10.0));
+    const auto &history = stats[pong->uid()]["history"];
+    POTHOS_TEST_EQUAL(stats[pong->uid()]["blockName"].get<std::string>(), "Pong");
+    POTHOS_TEST_TRUE(history.size() >= 2);
+    POTHOS_TEST_TRUE(history[0]["time"].get<double>() < history[1]["time"].get<double>());
+
+    //the work calls are found in the intervals
+    double workCalls(0.0);
+    for (const auto &interval : history) workCalls += interval["workCalls"].get<double>();
+    POTHOS_TEST_TRUE(workCalls > 0.0);
+
+    //nothing is older than the query
+    POTHOS_TEST_EQUAL(json::parse(topology.queryStatsHistory(0.0))[pong->uid()]["history"].size(), 0);
+}
+
+/***********************************************************************
+ * Test wait inactive with continuous activity
+ **********************************************************************/
+struct PingForever : Ping
+{
+    void work(void)
+    {
+        this->output("out0")->postMessage(42);
+    }
+};
+
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_wait_inactive)
+{
+    auto ping = std::shared_ptr<PingForever>(new PingForever());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+
+    Pothos::Topology topology;
+    POTHOS_TEST_TRUE(topology.waitInactive(0.01, 0.1)); //nothing active
+
+    //continuous activity never becomes idle
+    topology.connect(ping, "out0", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(not topology.waitInactive(0.05, 0.2));
+    POTHOS_TEST_TRUE(pong->triggered > 0);
+
+    //idle once the source is disconnected
+    topology.disconnectAll();
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive(0.05, 1.0));
+}
+
+/***********************************************************************
+ * Test the copier selection for a device domain
+ **********************************************************************/
+struct DevicePing : Pothos::Block
+{
+    DevicePing(void):
+        once(false)
+    {
+        this->setupOutput("out0", "", "test_device");
+    }
+
+    std::shared_ptr<Pothos::BufferManager> getOutputBufferManager(const std::string &, const std::string &domain)
+    {
+        if (domain == "test_device") return Pothos::BufferManager::Sptr();
+        throw Pothos::PortDomainError(domain);
+    }
+
+    void work(void)
+    {
+        if (once) return;
+        once = true;
+        this->output("out0")->postMessage(42);
+    }
+
+bool once;
+};
+
+struct DeviceStaging : Pothos::Block
+{
+    static Pothos::Block *make(void)
+    {
+        numStaging++;
+        return new DeviceStaging();
+    }
+
+    DeviceStaging(void)
+    {
+        this->setupInput("in0", "", "test_device");
+        this->setupOutput("out0");
+    }
+
+    void work(void)
+    {
+        auto in0 = this->input("in0");
+        if (in0->hasMessage()) this->output("out0")->postMessage(in0->popMessage());
+    }
+
+    static size_t numStaging;
+};
+
+size_t DeviceStaging::numStaging = 0;
+
+static Pothos::BlockRegistry registerDeviceStaging(
+    "/tests/device_staging", &DeviceStaging::make);
+
+static std::string selectDeviceCopier(const std::string &srcDomain, const std::string &)
+{
+    return (srcDomain == "test_device")?"/tests/device_staging":"";
+}
+
+pothos_static_block(registerTestDeviceDomainCopier)
+{
+    Pothos::PluginRegistry::addCall("/framework/domain_copier/test_device", &selectDeviceCopier);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_domain_copier)
+{
+    //only the registered domain selects the staging block
+    POTHOS_TEST_EQUAL(Pothos::BlockRegistry::findDomainCopier("test_device", ""), "/tests/device_staging");
+    POTHOS_TEST_EQUAL(Pothos::BlockRegistry::findDomainCopier("", "test_device"), "/blocks/copier");
+
+    auto ping = std::shared_ptr<DevicePing>(new DevicePing());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+    const auto numStaging = DeviceStaging::numStaging;
+
+    //the crossing out of the device domain uses the staging block
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", pong, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(DeviceStaging::numStaging, numStaging+1);
+    POTHOS_TEST_EQUAL(pong->triggered, 1);
+
+    //an unrelated change reuses the planned crossing and its staging block
+    auto ping2 = std::shared_ptr<Ping>(new Ping());
+    auto pong2 = std::shared_ptr<Pong>(new Pong());
+    topology.connect(ping2, "out0", pong2, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(DeviceStaging::numStaging, numStaging+1);
+    POTHOS_TEST_EQUAL(pong2->triggered, 1);
+}
+
+/***********************************************************************
+ * Test the copier sharing for a fan-out across domains
+ **********************************************************************/
+struct DevicePong : Pong
+{
+    DevicePong(void)
+    {
+        this->setupInput("dev0", "", "test_device");
+    }
+
+    void work(void)
+    {
+        auto dev0 = this->input("dev0");
+        if (dev0->hasMessage())
+        {
+            dev0->popMessage();
+            triggered++;
+        }
+    }
+};
+
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_domain_fanout)
+{
+    auto ping = std::shared_ptr<DevicePing>(new DevicePing());
+    auto pong0 = std::shared_ptr<Pong>(new Pong("0"));
+    auto pong1 = std::shared_ptr<Pong>(new Pong("1"));
+    auto devPong = std::shared_ptr<DevicePong>(new DevicePong());
+    const auto numStaging = DeviceStaging::numStaging;
+
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", pong0, "in0");
+    topology.connect(ping, "out0", pong1, "in0");
+    topology.connect(ping, "out0", devPong, "dev0");
+    topology.commit();
+
+    //the device consumer connects directly, the host consumers share one staging block
+    POTHOS_TEST_EQUAL(DeviceStaging::numStaging, numStaging+1);
+    const auto topObj = json::parse(topology.dumpJSON("{\"mode\":\"rendered\"}"));
+    const auto &connsArray = topObj["connections"];
+    POTHOS_TEST_EQUAL(connsArray.size(), 4);
+    POTHOS_TEST_TRUE(connectionsHave(connsArray, ping->uid(), "out0", devPong->uid(), "dev0"));
+    POTHOS_TEST_TRUE(not connectionsHave(connsArray, ping->uid(), "out0", pong0->uid(), "in0"));
+    POTHOS_TEST_TRUE(not connectionsHave(connsArray, ping->uid(), "out0", pong1->uid(), "in0"));
+
+    //check that the message flowed to every consumer
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(pong0->triggered, 1);
+    POTHOS_TEST_EQUAL(pong1->triggered, 1);
+    POTHOS_TEST_EQUAL(devPong->triggered, 1);
+}
+
+/***********************************************************************
+ * Test the placement planner on two clusters of heavy flows
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_placement_planner)
+{
+    //two chains of 4 blocks with a light flow between the chains
+    PlacementProblem problem;
+    problem.blockCosts.assign(8, 1.0);
+    problem.pinnedHosts.assign(8, -1);
+    problem.hostCapacities.assign(2, 4.0);
+    for (size_t i = 0; i < 3; i++)
+    {
+        PlacementProblem::Flow flow;
+        flow.rate = 100.0;
+        flow.src = i; flow.dst = i+1;
+        problem.flows.push_back(flow);
+        flow.src = i+4; flow.dst = i+5;
+        problem.flows.push_back(flow);
+    }
+    PlacementProblem::Flow light;
+    light.src = 3; light.dst = 4; light.rate = 1.0;
+    problem.flows.push_back(light);
+
+    //each chain stays on one host, only the light flow crosses
+    auto placement = planPlacement(problem);
+    POTHOS_TEST_EQUAL(placement.size(), 8);
+    for (size_t i = 1; i < 4; i++) POTHOS_TEST_EQUAL(placement[i], placement[0]);
+    for (size_t i = 5; i < 8; i++) POTHOS_TEST_EQUAL(placement[i], placement[4]);
+    POTHOS_TEST_TRUE(placement[0] != placement[4]);
+    POTHOS_TEST_EQUAL(placementCrossingRate(problem, placement), 1.0);
+
+    //a pinned block pulls its chain onto the pinned host
+    problem.pinnedHosts[0] = 1;
+    placement = planPlacement(problem);
+    for (size_t i = 0; i < 4; i++) POTHOS_TEST_EQUAL(placement[i], 1);
+    for (size_t i = 4; i < 8; i++) POTHOS_TEST_EQUAL(placement[i], 0);
+
+    //one host cannot take every block without slack
+    problem.pinnedHosts.assign(8, -1);
+    problem.flows.back().rate = 100.0;
+    problem.balanceSlack = 0.0;
+    placement = planPlacement(problem);
+    POTHOS_TEST_EQUAL(std::count(placement.begin(), placement.end(), 0), 4);
+    POTHOS_TEST_EQUAL(placementCrossingRate(problem, placement), 100.0);
+}
+
+/***********************************************************************
+ * Test replacing a block in a running design
+ **********************************************************************/
+struct PingCounter : Ping
+{
+    PingCounter(const int total):
+        total(total),
+        count(0)
+    {
+        return;
+    }
+
+    void work(void)
+    {
+        if (count == total) return;
+        this->output("out0")->postMessage(count++);
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    const int total;
+    int count;
+};
+
+struct PongCollector : Pong
+{
+    void work(void)
+    {
+        auto in0 = this->input("in0");
+        while (in0->hasMessage()) values.push_back(in0->popMessage().convert<int>());
+    }
+
+    std::vector<int> values;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_replace_block)
+{
+    const int total = 4000;
+    auto ping = std::shared_ptr<PingCounter>(new PingCounter(total));
+    auto passerA = std::shared_ptr<Passer>(new Passer("A"));
+    auto passerB = std::shared_ptr<Passer>(new Passer("B"));
+    auto pong = std::shared_ptr<PongCollector>(new PongCollector());
+
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", passerA, "in0");
+    topology.connect(passerA, "out0", pong, "in0");
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    //the new block lacks the output port, the old flows stay
+    auto pongB = std::shared_ptr<Pong>(new Pong("B"));
+    POTHOS_TEST_THROWS(topology.replace(passerA, pongB), Pothos::TopologyConnectError);
+    POTHOS_TEST_THROWS(topology.replace(passerB, passerA), Pothos::TopologyConnectError);
+
+    //swap the passer while the source is running
+    topology.replace(passerA, passerB);
+    POTHOS_TEST_TRUE(topology.waitInactive(0.05, 10.0));
+    POTHOS_TEST_TRUE(passerB->workCount > 0);
+
+    //the stream continues in order through the new block
+    POTHOS_TEST_TRUE(not pong->values.empty());
+    POTHOS_TEST_EQUAL(pong->values.back(), total-1);
+    for (size_t i = 1; i < pong->values.size(); i++)
+    {
+        if (pong->values[i] > pong->values[i-1]) continue;
+        POTHOS_TEST_TRUE(pong->values[i] > pong->values[i-1]);
+    }
+}
+
+/***********************************************************************
+ * Test draining a running design
+ **********************************************************************/
+struct PongStuck : Pong
+{
+    void work(void)
+    {
+        //never consumes the input
+    }
+};
+
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_topology_drain)
+{
+    auto ping = std::shared_ptr<PingCounter>(new PingCounter(1000000));
+    auto passer = std::shared_ptr<Passer>(new Passer());
+    auto pong = std::shared_ptr<PongCollector>(new PongCollector());
+
+    Pothos::Topology topology;
+    POTHOS_TEST_TRUE(topology.drain(0.1)); //nothing active
+    topology.connect(ping, "out0", passer, "in0");
+    topology.connect(passer, "out0", pong, "in0");
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    //the source stops and every message reaches the sink
+    POTHOS_TEST_TRUE(topology.drain(10.0));
+    POTHOS_TEST_TRUE(ping->count > 0);
+    POTHOS_TEST_EQUAL(int(pong->values.size()), ping->count);
+    topology.disconnectAll();
+    topology.commit();
+
+    //a block that leaves its input queued does not drain
+    auto ping2 = std::shared_ptr<PingCounter>(new PingCounter(10));
+    auto stuck = std::shared_ptr<PongStuck>(new PongStuck());
+    topology.connect(ping2, "out0", stuck, "in0");
+    topology.commit();
+    POTHOS_TEST_TRUE(not topology.drain(0.2));
+}
+
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_commit_async)
+{
+    auto ping = std::shared_ptr<Ping>(new Ping());
+    auto pong = std::shared_ptr<Pong>(new Pong());
+
+    Pothos::Topology topology;
+    topology.connect(ping, "out0", pong, "in0");
+    auto future = topology.commitAsync();
+    future.get(); //rethrows commit errors
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    POTHOS_TEST_EQUAL(pong->triggered, 1);
+
+    //the commits apply in order, and the destructor waits for the last one
+    topology.disconnectAll();
+    auto first = topology.commitAsync();
+    auto second = topology.commitAsync();
+    second.wait();
+    POTHOS_TEST_TRUE(first.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    POTHOS_TEST_EQUAL(topology.dumpJSON("{\"mode\":\"rendered\"}").find(pong->uid()), std::string::npos);
+}
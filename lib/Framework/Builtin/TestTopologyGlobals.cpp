@@ -0,0 +1,166 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <json.hpp>
+#include <map>
+#include <mutex>
+#include <string>
+
+using json = nlohmann::json;
+
+/***********************************************************************
+ * Helper block to record the setter calls by block name
+ **********************************************************************/
+static std::map<std::string, std::map<std::string, int>> &getSetterCalls(void)
+{
+    static std::map<std::string, std::map<std::string, int>> calls;
+    return calls;
+}
+
+//blocks are made concurrently
+static std::mutex &getSetterMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+struct GlobalsTester : Pothos::Block
+{
+    static Block *make(const int ctorValue)
+    {
+        return new GlobalsTester(ctorValue);
+    }
+
+    GlobalsTester(const int ctorValue)
+    {
+        this->registerCall(this, POTHOS_FCN_TUPLE(GlobalsTester, setValue));
+        this->registerCall(this, POTHOS_FCN_TUPLE(GlobalsTester, setOther));
+        std::lock_guard<std::mutex> lock(getSetterMutex());
+        getSetterCalls()["ctor"]["value"] = ctorValue;
+        getSetterCalls()["ctor"]["count"]++;
+    }
+
+    void setValue(const int value)
+    {
+        std::lock_guard<std::mutex> lock(getSetterMutex());
+        getSetterCalls()[this->getName()]["value"] = value;
+        getSetterCalls()[this->getName()]["setValue"]++;
+    }
+
+    void setOther(const int value)
+    {
+        std::lock_guard<std::mutex> lock(getSetterMutex());
+        getSetterCalls()[this->getName()]["other"] = value;
+        getSetterCalls()[this->getName()]["setOther"]++;
+    }
+};
+
+static Pothos::BlockRegistry registerGlobalsTester(
+    "/framework/tests/globals_tester", &GlobalsTester::make);
+
+/***********************************************************************
+ * Update globals and make only the dependent calls again
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_topology_set_global)
+{
+    getSetterCalls().clear();
+    auto topology = Pothos::Topology::make(
+        "{"
+        "    \"globals\" : ["
+        "        {\"name\" : \"a\", \"value\" : 1},"
+        "        {\"name\" : \"b\", \"value\" : \"a*2\"},"
+        "        {\"name\" : \"c\", \"value\" : 7}"
+        "    ],"
+        "    \"blocks\" : ["
+        "        {"
+        "            \"id\" : \"t0\","
+        "            \"path\" : \"/framework/tests/globals_tester\","
+        "            \"args\" : [0],"
+        "            \"locals\" : [{\"name\" : \"l\", \"value\" : \"b+1\"}],"
+        "            \"calls\" : [[\"setValue\", \"l\"], [\"setOther\", 5]]"
+        "        },"
+        "        {"
+        "            \"id\" : \"t1\","
+        "            \"path\" : \"/framework/tests/globals_tester\","
+        "            \"args\" : [\"c\"],"
+        "            \"calls\" : [[\"setOther\", \"c\"]]"
+        "        }"
+        "    ]"
+        "}");
+    auto &calls = getSetterCalls();
+    POTHOS_TEST_EQUAL(calls["t0"]["value"], 3);
+    POTHOS_TEST_EQUAL(calls["t0"]["other"], 5);
+    POTHOS_TEST_EQUAL(calls["t1"]["other"], 7);
+
+    //a change to a makes only the dependent call again, through b and l
+    topology->setGlobalVariable("a", "10");
+    POTHOS_TEST_EQUAL(calls["t0"]["value"], 21);
+    POTHOS_TEST_EQUAL(calls["t0"]["setValue"], 2);
+    POTHOS_TEST_EQUAL(calls["t0"]["setOther"], 1);
+    POTHOS_TEST_EQUAL(calls["t1"]["setOther"], 1);
+
+    //a constructor argument depends on c
+    POTHOS_TEST_THROWS(topology->setGlobalVariable("c", "8"), Pothos::RuntimeException);
+    POTHOS_TEST_EQUAL(calls["t1"]["setOther"], 1);
+
+    //an unknown global or a topology that was not made from JSON
+    POTHOS_TEST_THROWS(topology->setGlobalVariable("z", "1"), Pothos::InvalidArgumentException);
+    Pothos::Topology plain;
+    POTHOS_TEST_THROWS(plain.setGlobalVariable("a", "1"), Pothos::InvalidArgumentException);
+}
+
+/***********************************************************************
+ * Make many blocks concurrently and sequentially
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_topology_make_parallel)
+{
+    for (const size_t makeThreads : {0, 1})
+    {
+        getSetterCalls().clear();
+        json topObj;
+        topObj["makeThreads"] = makeThreads;
+        topObj["globals"] = json::array({{{"name", "offset"}, {"value", 100}}});
+        topObj["blocks"] = json::array();
+        for (int i = 0; i < 32; i++)
+        {
+            json blockObj;
+            blockObj["id"] = "b" + std::to_string(i);
+            blockObj["path"] = "/framework/tests/globals_tester";
+            blockObj["args"] = json::array({i});
+            blockObj["calls"] = json::array({json::array({"setValue", "offset+" + std::to_string(i)})});
+            topObj["blocks"].push_back(blockObj);
+        }
+
+        //the topology holds the blocks made concurrently
+        auto topology = Pothos::Topology::make(topObj.dump());
+        auto &calls = getSetterCalls();
+        POTHOS_TEST_EQUAL(calls["ctor"]["count"], 32);
+        for (int i = 0; i < 32; i++)
+        {
+            POTHOS_TEST_EQUAL(calls["b" + std::to_string(i)]["value"], 100+i);
+        }
+    }
+}
+
+/***********************************************************************
+ * Make a topology from the binary encodings of its description
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests/topology", test_topology_make_binary)
+{
+    json topObj;
+    topObj["blocks"] = json::array({{
+        {"id", "bin0"},
+        {"path", "/framework/tests/globals_tester"},
+        {"args", json::array({0})},
+        {"calls", json::array({json::array({"setValue", 42})})}}});
+
+    for (const auto &bytes : {json::to_cbor(topObj), json::to_msgpack(topObj)})
+    {
+        getSetterCalls().clear();
+        auto topology = Pothos::Topology::make(std::string(bytes.begin(), bytes.end()));
+        POTHOS_TEST_EQUAL(getSetterCalls()["bin0"]["value"], 42);
+    }
+    POTHOS_TEST_THROWS(Pothos::Topology::make(std::string("\xa1\xff")), Pothos::DataFormatException);
+}
@@ -1,11 +1,17 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Testing.hpp>
 #include <Pothos/Framework.hpp>
+#include <algorithm> //min
 #include <chrono>
 #include <thread>
 #include <iostream>
+#include <vector>
+#include <tuple>
+#include <json.hpp>
+
+using json = nlohmann::json;
 
 struct MyWorker0 : Pothos::Block
 {
@@ -125,3 +131,890 @@ POTHOS_TEST_BLOCK("/framework/tests", test_activate_throw)
         POTHOS_TEST_THROWS(t.commit(), Pothos::TopologyConnectError);
     }
 }
+
+POTHOS_TEST_BLOCK("/framework/tests", test_work_stats_histograms)
+{
+    auto w0 = std::shared_ptr<MyWorker0>(new MyWorker0());
+    auto w1 = std::shared_ptr<MyWorker1>(new MyWorker1());
+
+    Pothos::Topology t;
+    t.connect(w0, 0, w1, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+
+    const auto stats = json::parse(t.queryJSONStats());
+
+    //one work() duration recorded per work call
+    const auto &w0Stats = stats[w0->uid()];
+    const auto &workHist = w0Stats["workHistogram"];
+    POTHOS_TEST_EQUAL(workHist["count"].get<unsigned long long>(), w0Stats["numWorkCalls"].get<unsigned long long>());
+    POTHOS_TEST_TRUE(workHist["p50"].get<unsigned long long>() <= workHist["p999"].get<unsigned long long>());
+    POTHOS_TEST_TRUE(workHist["p999"].get<unsigned long long>() <= workHist["max"].get<unsigned long long>());
+
+    //the single posted buffer was consumed downstream
+    const auto &residencyHist = stats[w1->uid()]["inputStats"][0]["residencyHistogram"];
+    POTHOS_TEST_EQUAL(residencyHist["count"].get<unsigned long long>(), 1);
+    POTHOS_TEST_EQUAL(residencyHist["buckets"].size(), 1);
+
+    //the single buffer was enqueued without accumulator copies
+    const auto &inputStats = stats[w1->uid()]["inputStats"][0];
+    POTHOS_TEST_EQUAL(inputStats["totalBytesCopied"].get<unsigned long long>(), 0);
+    POTHOS_TEST_EQUAL(inputStats["totalPoolAllocations"].get<unsigned long long>(), 0);
+    POTHOS_TEST_EQUAL(inputStats["totalQueueResizes"].get<unsigned long long>(), 0);
+    POTHOS_TEST_TRUE(inputStats["queueHighWaterMark"].get<size_t>() >= 1);
+}
+
+struct OddSizeFeeder : Pothos::Block
+{
+    OddSizeFeeder(const size_t total):
+        total(total),
+        count(0)
+    {
+        this->setupOutput(0, "uint32");
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+        const size_t n = std::min(total-count, std::min<size_t>(outPort->elements(), 37));
+        if (n == 0) return;
+        uint32_t *out = outPort->buffer();
+        for (size_t i = 0; i < n; i++) out[i] = uint32_t(count+i);
+        count += n;
+        outPort->produce(n);
+    }
+
+    size_t total;
+    size_t count;
+};
+
+struct ReserveConsumer : Pothos::Block
+{
+    ReserveConsumer(const size_t reserve):
+        reserve(reserve),
+        count(0),
+        errors(0)
+    {
+        this->setupInput(0, "uint32");
+        this->input(0)->setReserve(reserve);
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        if (inPort->elements() < reserve) return;
+        const uint32_t *in = inPort->buffer();
+        for (size_t i = 0; i < reserve; i++)
+        {
+            if (in[i] != uint32_t(count+i)) errors++;
+        }
+        count += reserve;
+        inPort->consume(reserve);
+    }
+
+    size_t reserve;
+    size_t count;
+    size_t errors;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_reserve_without_copies)
+{
+    //the reserve known at commit time selects a circular upstream manager
+    const size_t total = 100000;
+    auto feeder = std::shared_ptr<OddSizeFeeder>(new OddSizeFeeder(total));
+    auto consumer = std::shared_ptr<ReserveConsumer>(new ReserveConsumer(1000));
+
+    Pothos::Topology t;
+    t.connect(feeder, 0, consumer, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+
+    POTHOS_TEST_EQUAL(consumer->count, (total/1000)*1000);
+    POTHOS_TEST_EQUAL(consumer->errors, 0);
+
+    //the reserve was always presented in place
+    const auto stats = json::parse(t.queryJSONStats());
+    const auto &inputStats = stats[consumer->uid()]["inputStats"][0];
+    std::cout << "require copied " << inputStats["totalBytesCopied"] << " bytes" << std::endl;
+    POTHOS_TEST_EQUAL(inputStats["totalBytesCopied"].get<unsigned long long>(), 0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_reserve_auto_buffer_args)
+{
+    //an "auto" type keeps the commit selection with the other buffer arguments
+    const size_t total = 100000;
+    auto feeder = std::shared_ptr<OddSizeFeeder>(new OddSizeFeeder(total));
+    auto consumer = std::shared_ptr<ReserveConsumer>(new ReserveConsumer(1000));
+
+    Pothos::Topology t;
+    t.connect(feeder, 0, consumer, 0, "{\"type\" : \"auto\", \"numBuffers\" : 8}");
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+
+    POTHOS_TEST_EQUAL(consumer->count, (total/1000)*1000);
+    POTHOS_TEST_EQUAL(consumer->errors, 0);
+    const auto stats = json::parse(t.queryJSONStats());
+    POTHOS_TEST_EQUAL(stats[consumer->uid()]["inputStats"][0]["totalBytesCopied"].get<unsigned long long>(), 0);
+}
+
+struct LabelPerBufferFeeder : OddSizeFeeder
+{
+    LabelPerBufferFeeder(const size_t total):
+        OddSizeFeeder(total)
+    {
+        return;
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+        if (count < total and outPort->elements() != 0) outPort->postLabel("start", count, 0);
+        OddSizeFeeder::work();
+    }
+};
+
+struct LabelCollector : Pothos::Block
+{
+    LabelCollector(void):
+        count(0)
+    {
+        this->setupInput(0, "uint32");
+    }
+
+    void work(void)
+    {
+        //consume in a size unrelated to the posted buffers
+        auto inPort = this->input(0);
+        const size_t n = std::min<size_t>(inPort->elements(), 50);
+        for (const auto &label : inPort->labels())
+        {
+            if (label.index >= n) break;
+            indexes.push_back(count+label.index);
+            values.push_back(label.data.convert<size_t>());
+        }
+        count += n;
+        inPort->consume(n);
+    }
+
+    size_t count;
+    std::vector<size_t> indexes;
+    std::vector<size_t> values;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_label_per_buffer)
+{
+    const size_t total = 10000;
+    auto feeder = std::shared_ptr<LabelPerBufferFeeder>(new LabelPerBufferFeeder(total));
+    auto collector = std::shared_ptr<LabelCollector>(new LabelCollector());
+
+    Pothos::Topology t;
+    t.connect(feeder, 0, collector, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+
+    //every label arrives once at the absolute position it was posted
+    POTHOS_TEST_EQUAL(collector->count, total);
+    POTHOS_TEST_TRUE(collector->indexes.size() >= (total+36)/37);
+    for (size_t i = 0; i < collector->indexes.size(); i++)
+    {
+        POTHOS_TEST_EQUAL(collector->indexes[i], collector->values[i]);
+    }
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_fanout_subscribers)
+{
+    const size_t total = 10000;
+    auto feeder = std::shared_ptr<LabelPerBufferFeeder>(new LabelPerBufferFeeder(total));
+    std::vector<std::shared_ptr<LabelCollector>> collectors;
+    for (size_t i = 0; i < 4; i++) collectors.emplace_back(new LabelCollector());
+
+    Pothos::Topology t;
+    for (const auto &collector : collectors) t.connect(feeder, 0, collector, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+
+    //every subscriber sees all of the elements and the same labels
+    for (const auto &collector : collectors)
+    {
+        POTHOS_TEST_EQUAL(collector->count, total);
+        POTHOS_TEST_EQUAL(collector->indexes.size(), collectors.front()->indexes.size());
+        for (size_t i = 0; i < collector->indexes.size(); i++)
+        {
+            POTHOS_TEST_EQUAL(collector->indexes[i], collector->values[i]);
+        }
+    }
+}
+
+struct BurstMessageFeeder : Pothos::Block
+{
+    BurstMessageFeeder(const size_t total):
+        total(total),
+        count(0)
+    {
+        this->setupOutput(0);
+    }
+
+    void work(void)
+    {
+        for (size_t i = 0; i < 100 and count < total; i++)
+        {
+            this->output(0)->postMessage(count++);
+        }
+    }
+
+    size_t total;
+    size_t count;
+};
+
+struct SlowMessageCollector : Pothos::Block
+{
+    SlowMessageCollector(const size_t capacity)
+    {
+        this->setupInput(0);
+        this->input(0)->setMessageCapacity(capacity);
+    }
+
+    void work(void)
+    {
+        //one message per call lets the queue back up
+        auto inPort = this->input(0);
+        if (inPort->hasMessage()) values.push_back(inPort->popMessage().convert<size_t>());
+    }
+
+    std::vector<size_t> values;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_message_backpressure)
+{
+    //the backlog exceeds the default capacity, nothing is dropped
+    const size_t total = 5000;
+    auto feeder = std::shared_ptr<BurstMessageFeeder>(new BurstMessageFeeder(total));
+    auto collector = std::shared_ptr<SlowMessageCollector>(new SlowMessageCollector(10));
+
+    Pothos::Topology t;
+    t.connect(feeder, 0, collector, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive(0.1, 10.0));
+
+    POTHOS_TEST_EQUAL(collector->values.size(), total);
+    for (size_t i = 0; i < collector->values.size(); i++)
+    {
+        if (collector->values[i] == i) continue;
+        POTHOS_TEST_EQUAL(collector->values[i], i);
+    }
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_message_token_depth)
+{
+    const size_t total = 5000;
+    auto feeder = std::shared_ptr<BurstMessageFeeder>(new BurstMessageFeeder(total));
+    auto collector = std::shared_ptr<SlowMessageCollector>(new SlowMessageCollector(1024));
+
+    //the token depth is configured with the connection arguments
+    Pothos::Topology t;
+    t.connect(feeder, 0, collector, 0, "{\"tokenDepth\" : 256}");
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive(0.1, 10.0));
+    POTHOS_TEST_EQUAL(collector->values.size(), total);
+
+    //starvation is reported, and never exceeds the producer's task calls
+    const auto stats = json::parse(t.queryJSONStats());
+    const auto &feederStats = stats[feeder->uid()];
+    const auto starvations = feederStats["outputStats"][0]["tokenStarvations"].get<unsigned long long>();
+    POTHOS_TEST_TRUE(starvations <= feederStats["numTaskCalls"].get<unsigned long long>());
+
+    //the token depth can also be set from the block API
+    feeder->output(0)->setTokenDepth(32);
+}
+
+/***********************************************************************
+ * Recycle packets from the output port's packet pool
+ **********************************************************************/
+struct PacketPoolFeeder : Pothos::Block
+{
+    PacketPoolFeeder(const size_t total):
+        total(total),
+        count(0)
+    {
+        this->setupOutput(0, "uint32");
+    }
+
+    void work(void)
+    {
+        auto outPort = this->output(0);
+        if (count == total) return;
+        auto msg = outPort->getPacket(10);
+        auto &packet = msg.ref<Pothos::Packet>();
+        containers.push_back(&packet);
+        uint32_t *out = packet.payload.as<uint32_t *>();
+        for (size_t i = 0; i < 10; i++) out[i] = uint32_t(count);
+        packet.metadata["count"] = Pothos::Object(count);
+        count++;
+        outPort->postMessage(msg);
+    }
+
+    size_t total;
+    size_t count;
+    std::vector<const Pothos::Packet *> containers;
+};
+
+struct PacketPoolCollector : Pothos::Block
+{
+    PacketPoolCollector(void)
+    {
+        this->setupInput(0);
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage())
+        {
+            const auto packet = inPort->popMessage().convert<Pothos::Packet>();
+            POTHOS_TEST_EQUAL(packet.metadata.size(), 1);
+            POTHOS_TEST_EQUAL(packet.payload.elements(), 10);
+            POTHOS_TEST_EQUAL(packet.payload.as<const uint32_t *>()[9],
+                packet.metadata.at("count").convert<uint32_t>());
+            values.push_back(packet.payload.as<const uint32_t *>()[0]);
+        }
+    }
+
+    std::vector<uint32_t> values;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_packet_pool)
+{
+    const size_t total = 1000;
+    auto feeder = std::shared_ptr<PacketPoolFeeder>(new PacketPoolFeeder(total));
+    auto collector = std::shared_ptr<PacketPoolCollector>(new PacketPoolCollector());
+
+    Pothos::Topology t;
+    t.connect(feeder, 0, collector, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive(0.1, 5.0));
+
+    //every packet arrives in order with its own contents
+    POTHOS_TEST_EQUAL(collector->values.size(), total);
+    for (size_t i = 0; i < collector->values.size(); i++)
+    {
+        if (collector->values[i] == uint32_t(i)) continue;
+        POTHOS_TEST_EQUAL(collector->values[i], uint32_t(i));
+    }
+
+    //the packet containers were recycled rather than allocated per packet
+    auto containers = feeder->containers;
+    std::sort(containers.begin(), containers.end());
+    containers.erase(std::unique(containers.begin(), containers.end()), containers.end());
+    std::cout << "posted " << total << " packets with " << containers.size() << " containers" << std::endl;
+    POTHOS_TEST_TRUE(containers.size() < total);
+}
+
+/***********************************************************************
+ * A lossy reader in a fan-out does not throttle the producer
+ **********************************************************************/
+struct StalledSink : Pothos::Block
+{
+    StalledSink(void)
+    {
+        this->setupInput(0);
+    }
+
+    void work(void)
+    {
+        //never consumes, the input holds on to the buffers
+        return;
+    }
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_lossy_reader)
+{
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+    auto stalled = std::shared_ptr<StalledSink>(new StalledSink());
+    stalled->input(0)->setLossyDepth(1);
+
+    Pothos::Topology t;
+    t.connect(source, 0, sink, 0);
+    t.connect(source, 0, stalled, 0);
+    t.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const unsigned long long sinkBytes0 = sink.call("getNumBytes");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const unsigned long long sinkBytes1 = sink.call("getNumBytes");
+
+    //the stalled reader holds at most one buffer, the rest are dropped
+    const auto stats = json::parse(t.queryJSONStats());
+    const auto &inputStats = stats[stalled->uid()]["inputStats"][0];
+    std::cout << "lossy reader dropped " << inputStats["totalBytesDropped"].get<unsigned long long>() << " bytes" << std::endl;
+    POTHOS_TEST_TRUE(sinkBytes1 > sinkBytes0);
+    POTHOS_TEST_TRUE(inputStats["totalBytesDropped"].get<unsigned long long>() > 0);
+    POTHOS_TEST_TRUE(inputStats["enqueuedBytes"].get<size_t>() <= 4096);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_lossy_flow)
+{
+    auto source = Pothos::BlockRegistry::make("/blocks/synthetic/zero_source", size_t(4096), false);
+    auto sink = Pothos::BlockRegistry::make("/blocks/synthetic/zero_sink");
+    auto stalled = std::shared_ptr<StalledSink>(new StalledSink());
+
+    //the lossy depth is configured with the connection arguments
+    Pothos::Topology t;
+    POTHOS_TEST_THROWS(t.connect(source, 0, stalled, 0, "{\"lossyDepth\" : -1}"), Pothos::TopologyConnectError);
+    t.connect(source, 0, sink, 0);
+    t.connect(source, 0, stalled, 0, "{\"lossyDepth\" : 2}");
+    t.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const unsigned long long sinkBytes0 = sink.call("getNumBytes");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const unsigned long long sinkBytes1 = sink.call("getNumBytes");
+
+    const auto stats = json::parse(t.queryJSONStats());
+    const auto &inputStats = stats[stalled->uid()]["inputStats"][0];
+    POTHOS_TEST_EQUAL(inputStats["lossyDepth"].get<size_t>(), 2);
+    POTHOS_TEST_TRUE(sinkBytes1 > sinkBytes0);
+    POTHOS_TEST_TRUE(inputStats["totalBytesDropped"].get<unsigned long long>() > 0);
+}
+
+struct AsyncSetter : Pothos::Block
+{
+    AsyncSetter(void):
+        value(0),
+        numSets(0),
+        setterThread(std::this_thread::get_id())
+    {
+        this->setupInput(0);
+        this->registerCall(this, POTHOS_FCN_TUPLE(AsyncSetter, setValue));
+    }
+
+    void setValue(const int v)
+    {
+        value = v;
+        numSets++;
+        setterThread = std::this_thread::get_id();
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        if (inPort->hasMessage()) inPort->popMessage();
+    }
+
+    int value;
+    size_t numSets;
+    std::thread::id setterThread;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_async_calls)
+{
+    auto feeder = std::shared_ptr<BurstMessageFeeder>(new BurstMessageFeeder(10));
+    auto setter = std::shared_ptr<AsyncSetter>(new AsyncSetter());
+    POTHOS_TEST_THROWS(setter->asyncCall("noSuchCall", 1), Pothos::BlockCallNotFound);
+
+    //coalesced calls before activation apply once with the latest value
+    for (int i = 1; i <= 5; i++) setter->asyncCallLatest("setValue", i);
+    POTHOS_TEST_EQUAL(setter->numSets, 0);
+
+    Pothos::Topology t;
+    t.connect(feeder, 0, setter, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+    POTHOS_TEST_EQUAL(setter->value, 5);
+    POTHOS_TEST_EQUAL(setter->numSets, 1);
+
+    //calls on the active block run in order on the worker thread
+    for (int i = 6; i <= 10; i++) setter->asyncCall("setValue", i);
+    POTHOS_TEST_TRUE(t.waitInactive());
+    POTHOS_TEST_EQUAL(setter->value, 10);
+    POTHOS_TEST_EQUAL(setter->numSets, 6);
+    POTHOS_TEST_TRUE(setter->setterThread != std::this_thread::get_id());
+}
+
+struct SignalEmitter : Pothos::Block
+{
+    SignalEmitter(void)
+    {
+        this->setupInput(0);
+        this->registerSignal("valueChanged");
+        valueChanged = this->signalHandle<int>("valueChanged");
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage())
+        {
+            valueChanged.emit(inPort->popMessage().convert<int>()+1);
+        }
+    }
+
+    Pothos::SignalHandle<int> valueChanged;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_signal_handle)
+{
+    auto feeder = std::shared_ptr<BurstMessageFeeder>(new BurstMessageFeeder(1000));
+    auto emitter = std::shared_ptr<SignalEmitter>(new SignalEmitter());
+    auto setter = std::shared_ptr<AsyncSetter>(new AsyncSetter());
+    POTHOS_TEST_THROWS(emitter->signalHandle<int>("noSuchSignal"), Pothos::PortAccessError);
+    POTHOS_TEST_TRUE(bool(emitter->valueChanged));
+    POTHOS_TEST_TRUE(not emitter->valueChanged.connected());
+    emitter->valueChanged.emit(-1); //no subscribers, nothing posted
+
+    Pothos::Topology t;
+    t.connect(feeder, 0, emitter, 0);
+    t.connect(emitter, "valueChanged", setter, "setValue");
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+    POTHOS_TEST_TRUE(emitter->valueChanged.connected());
+    POTHOS_TEST_EQUAL(setter->value, 1000);
+    POTHOS_TEST_EQUAL(setter->numSets, 1000);
+}
+
+struct LatestSetter : AsyncSetter
+{
+    LatestSetter(void)
+    {
+        this->registerCall(this, POTHOS_FCN_TUPLE(LatestSetter, setSlowValue));
+        this->registerSlot("setSlowValue", true);
+    }
+
+    void setSlowValue(const int v)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        this->setValue(v);
+    }
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_slot_latest_only)
+{
+    auto feeder = std::shared_ptr<BurstMessageFeeder>(new BurstMessageFeeder(1000));
+    auto emitter = std::shared_ptr<SignalEmitter>(new SignalEmitter());
+    auto setter = std::shared_ptr<LatestSetter>(new LatestSetter());
+
+    Pothos::Topology t;
+    t.connect(feeder, 0, emitter, 0);
+    t.connect(emitter, "valueChanged", setter, "setSlowValue");
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+
+    //the slow slot skips stale calls but always applies the last one
+    POTHOS_TEST_EQUAL(setter->value, 1000);
+    POTHOS_TEST_TRUE(setter->numSets < 1000);
+}
+
+struct ChunkAdder : Pothos::Block
+{
+    ChunkAdder(void):
+        numChunks(0)
+    {
+        this->setupInput(0, "uint32");
+        this->setupInput(1, "uint32");
+        this->setupOutput(0, "uint32");
+    }
+
+    void work(void)
+    {
+        //small chunks to exercise the chunk boundaries
+        this->forEachChunk<std::tuple<uint32_t, uint32_t>, std::tuple<uint32_t>>(
+            [this](const uint32_t *in0, const uint32_t *in1, uint32_t *out0, const size_t n)
+            {
+                for (size_t i = 0; i < n; i++) out0[i] = in0[i] + in1[i];
+                numChunks++;
+            }, 64);
+    }
+
+    size_t numChunks;
+};
+
+struct DoubleChecker : Pothos::Block
+{
+    DoubleChecker(void):
+        count(0),
+        errors(0)
+    {
+        this->setupInput(0, "uint32");
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        const uint32_t *in = inPort->buffer();
+        for (size_t i = 0; i < inPort->elements(); i++)
+        {
+            if (in[i] != uint32_t(2*(count+i))) errors++;
+        }
+        count += inPort->elements();
+        inPort->consume(inPort->elements());
+    }
+
+    size_t count;
+    size_t errors;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_for_each_chunk)
+{
+    const size_t total = 10000;
+    auto feeder0 = std::shared_ptr<OddSizeFeeder>(new OddSizeFeeder(total));
+    auto feeder1 = std::shared_ptr<OddSizeFeeder>(new OddSizeFeeder(total));
+    auto adder = std::shared_ptr<ChunkAdder>(new ChunkAdder());
+    auto checker = std::shared_ptr<DoubleChecker>(new DoubleChecker());
+
+    Pothos::Topology t;
+    t.connect(feeder0, 0, adder, 0);
+    t.connect(feeder1, 0, adder, 1);
+    t.connect(adder, 0, checker, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+
+    POTHOS_TEST_EQUAL(checker->count, total);
+    POTHOS_TEST_EQUAL(checker->errors, 0);
+    POTHOS_TEST_TRUE(adder->numChunks >= total/16);
+}
+
+struct LevelPublisher : Pothos::Block
+{
+    LevelPublisher(void):
+        count(0)
+    {
+        this->setupInput(0);
+        this->registerPublishedValue("count");
+        this->registerPublishedValue("level");
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        while (inPort->hasMessage())
+        {
+            inPort->popMessage();
+            count++;
+            this->publishValue("count", double(count));
+            this->publishValue("level", -double(count));
+        }
+    }
+
+    size_t count;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_published_values)
+{
+    auto feeder = std::shared_ptr<BurstMessageFeeder>(new BurstMessageFeeder(1000));
+    auto publisher = std::shared_ptr<LevelPublisher>(new LevelPublisher());
+    POTHOS_TEST_EQUAL(publisher->readPublishedValue("count"), 0.0);
+    POTHOS_TEST_THROWS(publisher->readPublishedValue("noSuchValue"), Pothos::NotFoundException);
+    POTHOS_TEST_THROWS(publisher->publishValue("noSuchValue", 1.0), Pothos::NotFoundException);
+
+    Pothos::Topology t;
+    t.connect(feeder, 0, publisher, 0);
+    t.commit();
+
+    //readers always see a consistent pair while the block runs
+    size_t inconsistent = 0;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        const auto values = publisher->readPublishedValues();
+        if (values.at("count") != -values.at("level")) inconsistent++;
+    }
+    POTHOS_TEST_EQUAL(inconsistent, 0);
+
+    POTHOS_TEST_TRUE(t.waitInactive());
+    POTHOS_TEST_EQUAL(publisher->readPublishedValue("count"), 1000.0);
+    const auto stats = json::parse(t.queryJSONStats());
+    POTHOS_TEST_EQUAL(stats[publisher->uid()]["publishedValues"]["level"].get<double>(), -1000.0);
+}
+
+POTHOS_TEST_BLOCK("/framework/tests", test_port_lookup)
+{
+    auto adder = std::shared_ptr<ChunkAdder>(new ChunkAdder());
+    POTHOS_TEST_EQUAL(adder->input("1"), adder->input(1));
+    POTHOS_TEST_EQUAL(adder->input(1), adder->inputs()[1]);
+    POTHOS_TEST_EQUAL(adder->output("0"), adder->outputs()[0]);
+    POTHOS_TEST_THROWS(adder->input("2"), Pothos::PortAccessError);
+    POTHOS_TEST_THROWS(adder->output(1), Pothos::PortAccessError);
+
+    //ports registered later are found by name as well
+    auto emitter = std::shared_ptr<SignalEmitter>(new SignalEmitter());
+    POTHOS_TEST_TRUE(emitter->output("valueChanged")->isSignal());
+}
+
+struct InPlaceNarrower : Pothos::Block
+{
+    InPlaceNarrower(void):
+        numInPlace(0)
+    {
+        this->setupInput(0, "uint32");
+        this->setupInput(1, "uint32");
+        this->setupOutput(0, "uint16");
+        this->output(0)->setReadBeforeWrite(this->input(0));
+        this->output(0)->addReadBeforeWrite(this->input(1));
+    }
+
+    void work(void)
+    {
+        auto in0 = this->input(0);
+        auto in1 = this->input(1);
+        auto outPort = this->output(0);
+        const size_t n = std::min(std::min(in0->elements(), in1->elements()), outPort->elements());
+        if (n == 0) return;
+        const uint32_t *a = in0->buffer();
+        const uint32_t *b = in1->buffer();
+        uint16_t *out = outPort->buffer();
+        if (outPort->buffer().as<const void *>() == in0->buffer().as<const void *>() or
+            outPort->buffer().as<const void *>() == in1->buffer().as<const void *>()) numInPlace++;
+        for (size_t i = 0; i < n; i++) out[i] = uint16_t(a[i] + b[i]);
+        in0->consume(n);
+        in1->consume(n);
+        outPort->produce(n);
+    }
+
+    size_t numInPlace;
+};
+
+struct NarrowChecker : Pothos::Block
+{
+    NarrowChecker(void):
+        count(0),
+        errors(0)
+    {
+        this->setupInput(0, "uint16");
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        const uint16_t *in = inPort->buffer();
+        for (size_t i = 0; i < inPort->elements(); i++)
+        {
+            if (in[i] != uint16_t(2*(count+i))) errors++;
+        }
+        count += inPort->elements();
+        inPort->consume(inPort->elements());
+    }
+
+    size_t count;
+    size_t errors;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_read_before_write_narrowing)
+{
+    const size_t total = 100000;
+    auto feeder0 = std::shared_ptr<OddSizeFeeder>(new OddSizeFeeder(total));
+    auto feeder1 = std::shared_ptr<OddSizeFeeder>(new OddSizeFeeder(total));
+    auto narrower = std::shared_ptr<InPlaceNarrower>(new InPlaceNarrower());
+    auto checker = std::shared_ptr<NarrowChecker>(new NarrowChecker());
+
+    Pothos::Topology t;
+    t.connect(feeder0, 0, narrower, 0);
+    t.connect(feeder1, 0, narrower, 1);
+    t.connect(narrower, 0, checker, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+
+    //the output is correct whether or not an input buffer was borrowed
+    POTHOS_TEST_EQUAL(checker->count, total);
+    POTHOS_TEST_EQUAL(checker->errors, 0);
+    std::cout << "in-place work calls " << narrower->numInPlace << std::endl;
+}
+
+struct FramePoster : Pothos::Block
+{
+    FramePoster(const size_t numFrames):
+        numFrames(numFrames),
+        value(0)
+    {
+        this->setupOutput(0, "uint8");
+    }
+
+    void work(void)
+    {
+        if (numFrames == 0) return;
+        numFrames--;
+
+        //a header and a payload posted as pieces of one frame
+        Pothos::BufferChunkList frame;
+        for (const size_t length : {size_t(3), size_t(29)})
+        {
+            Pothos::BufferChunk piece("uint8", length);
+            for (size_t i = 0; i < length; i++) piece.as<unsigned char *>()[i] = value++;
+            frame.append(piece);
+        }
+        this->output(0)->postBuffer(frame);
+    }
+
+    size_t numFrames;
+    unsigned char value;
+};
+
+struct ByteChecker : Pothos::Block
+{
+    ByteChecker(void):
+        count(0),
+        errors(0)
+    {
+        this->setupInput(0, "uint8");
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        const unsigned char *in = inPort->buffer();
+        for (size_t i = 0; i < inPort->elements(); i++)
+        {
+            if (in[i] != (unsigned char)(count+i)) errors++;
+        }
+        count += inPort->elements();
+        inPort->consume(inPort->elements());
+    }
+
+    size_t count;
+    size_t errors;
+};
+
+POTHOS_TEST_BLOCK("/framework/tests", test_post_buffer_list)
+{
+    auto poster = std::shared_ptr<FramePoster>(new FramePoster(100));
+    auto checker = std::shared_ptr<ByteChecker>(new ByteChecker());
+
+    Pothos::Topology t;
+    t.connect(poster, 0, checker, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+
+    POTHOS_TEST_EQUAL(checker->count, 100*32);
+    POTHOS_TEST_EQUAL(checker->errors, 0);
+}
+
+/***********************************************************************
+ * Port state is made upon use
+ **********************************************************************/
+POTHOS_TEST_BLOCK("/framework/tests", test_lazy_port_state)
+{
+    //a stream output without messages holds all of its tokens
+    auto poster = std::shared_ptr<FramePoster>(new FramePoster(100));
+    auto checker = std::shared_ptr<ByteChecker>(new ByteChecker());
+
+    Pothos::Topology t;
+    t.connect(poster, 0, checker, 0);
+    t.commit();
+    POTHOS_TEST_TRUE(t.waitInactive());
+    POTHOS_TEST_EQUAL(checker->count, 100*32);
+    const auto stats = json::parse(t.queryJSONStats());
+    POTHOS_TEST_TRUE(not stats[poster->uid()]["outputStats"][0]["tokensEmpty"].get<bool>());
+
+    //the token depth set before the first message applies to the first message
+    const size_t total = 1000;
+    auto feeder = std::shared_ptr<BurstMessageFeeder>(new BurstMessageFeeder(total));
+    auto collector = std::shared_ptr<SlowMessageCollector>(new SlowMessageCollector(1024));
+    feeder->output(0)->setTokenDepth(4);
+
+    Pothos::Topology t2;
+    t2.connect(feeder, 0, collector, 0);
+    t2.commit();
+    POTHOS_TEST_TRUE(t2.waitInactive(0.1, 10.0));
+    POTHOS_TEST_EQUAL(collector->values.size(), total);
+    for (size_t i = 0; i < collector->values.size(); i++)
+    {
+        if (collector->values[i] == i) continue;
+        POTHOS_TEST_EQUAL(collector->values[i], i);
+    }
+}
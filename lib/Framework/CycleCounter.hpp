@@ -0,0 +1,65 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <chrono>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h> //__rdtsc
+#define POTHOS_HAVE_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> //__rdtsc
+#define POTHOS_HAVE_RDTSC
+#endif
+
+/*!
+ * Read a free-running CPU cycle counter with very low overhead.
+ * The time stamp counter is used on x86 and the virtual counter on ARM64.
+ * Other architectures fall back to the high resolution clock.
+ * Use cycleCounterPeriod() to convert counts into seconds.
+ */
+static inline unsigned long long readCycleCounter(void)
+{
+#if defined(POTHOS_HAVE_RDTSC)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    unsigned long long count;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(count));
+    return count;
+#else
+    return std::chrono::high_resolution_clock::now().time_since_epoch().count();
+#endif
+}
+
+/*!
+ * Get the period of the cycle counter in seconds.
+ * The period is calibrated once on the first call (about 10 milliseconds),
+ * so the first call should be made outside of the time critical path.
+ */
+static inline double cycleCounterPeriod(void)
+{
+#if defined(__aarch64__) && !defined(POTHOS_HAVE_RDTSC)
+    static const double period = []
+    {
+        unsigned long long freq;
+        __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
+        return 1.0/freq;
+    }();
+#elif defined(POTHOS_HAVE_RDTSC)
+    static const double period = []
+    {
+        const auto t0 = std::chrono::steady_clock::now();
+        const auto c0 = readCycleCounter();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const auto t1 = std::chrono::steady_clock::now();
+        const auto c1 = readCycleCounter();
+        return std::chrono::duration<double>(t1-t0).count()/(c1-c0);
+    }();
+#else
+    static const double period = double(std::chrono::high_resolution_clock::period::num)/
+        std::chrono::high_resolution_clock::period::den;
+#endif
+    return period;
+}
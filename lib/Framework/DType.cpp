@@ -27,7 +27,8 @@ static const int Bytes1 = (0 << 5);
 static const int Bytes2 = (1 << 5);
 static const int Bytes4 = (2 << 5);
 static const int Bytes8 = (3 << 5);
-static const int Length = 128;
+static const int Packed = (1 << 7);
+static const int Length = 256;
 
 enum ElementTypes : unsigned char
 {
@@ -53,6 +54,10 @@ enum ElementTypes : unsigned char
     Float64 = Float | Bytes8,
     ComplexFloat32 = Complex | Float | Bytes4,
     ComplexFloat64 = Complex | Float | Bytes8,
+    //packed samples: the size bits only distinguish the types,
+    //the element size in bytes comes from the lookup table
+    ComplexInt12Packed = Packed | Complex | Signed | Integer | Bytes2,
+    ComplexInt4Packed = Packed | Complex | Signed | Integer | Bytes1,
 };
 
 /***********************************************************************
@@ -98,6 +103,12 @@ public:
         _aliasToElementType["double"] = Float64;
         _aliasToElementType["complex64"] = ComplexFloat32;
         _aliasToElementType["complex128"] = ComplexFloat64;
+
+        //sample formats of SDR hardware and fronthaul links
+        this->loadPackedType(ComplexInt12Packed, 3, "complex_int12", "sc12");
+        this->loadPackedType(ComplexInt4Packed, 1, "complex_int4", "sc4");
+        _aliasToElementType["sc8"] = ComplexInt8;
+        _aliasToElementType["sc16"] = ComplexInt16;
         #define declareNativeAlias(Code, Name) \
             _aliasToElementType[Name] = Code; \
             _aliasToElementType["s" Name] = Code; \
@@ -159,6 +170,14 @@ private:
         _elemTypeToElemName[elemType] = name;
     }
 
+    void loadPackedType(const ElementTypes elemType, const unsigned char elemSize, const std::string &name, const std::string &alias)
+    {
+        _aliasToElementType[name] = elemType;
+        _aliasToElementType[alias] = elemType;
+        _elemTypeToElemSize[elemType] = elemSize;
+        _elemTypeToElemName[elemType] = name;
+    }
+
     Poco::HashMap<std::string, ElementTypes> _aliasToElementType;
     std::map<size_t, ElementTypes> _typeHashToElemType;
     std::array<unsigned char, Length> _elemTypeToElemSize;
@@ -285,6 +304,11 @@ bool Pothos::DType::isComplex(void) const
     return (_elemType & Complex) != 0;
 }
 
+bool Pothos::DType::isPacked(void) const
+{
+    return (_elemType & Packed) != 0;
+}
+
 #include <Pothos/Managed.hpp>
 
 static auto managedDtype = Pothos::ManagedClass()
@@ -302,6 +326,7 @@ static auto managedDtype = Pothos::ManagedClass()
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::DType, isInteger))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::DType, isSigned))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::DType, isComplex))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::DType, isPacked))
     .registerStaticMethod<bool, const Pothos::DType &, const Pothos::DType &>("equals", &Pothos::operator==)
     .commit("Pothos/DType");
 
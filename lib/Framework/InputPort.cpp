@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
@@ -6,17 +6,22 @@
 #include "Framework/WorkerActor.hpp"
 
 /*!
- * An arbitrary bound on the queue size to detect buggy situations
- * where the downstream block is not consuming an input resource
- * and an upstream block is able to produce without back-pressure.
- * This should probably be a configurable system-wide value,
- * but for now the detection itself is more valuable to have.
+ * The default bound on the message and slot call queue size.
+ * Upstream producers stall while the queue holds this many entries.
+ * See InputPort::setMessageCapacity() to configure the bound per port.
  */
-static const size_t MaxQueueCapacity = 1024;
+static const size_t DefaultMessageCapacity = 1024;
+
+/*!
+ * The maximum number of buffers tracked for residency time.
+ * Buffers beyond this bound are still accepted but not measured.
+ */
+static const size_t MaxResidencyStamps = 1024;
 
 Pothos::InputPort::InputPort(void):
     _actor(nullptr),
     _isSlot(false),
+    _slotLatestOnly(false),
     _index(-1),
     _elements(0),
     _totalElements(0),
@@ -25,14 +30,27 @@ Pothos::InputPort::InputPort(void):
     _totalMessages(0),
     _pendingElements(0),
     _reserveElements(0),
-    _workEvents(0)
+    _minBatchElements(0),
+    _batchLatency(0),
+    _batchPending(false),
+    _batchReleaseEnd(0),
+    _staticRate(0),
+    _workEvents(0),
+    _messageCapacity(DefaultMessageCapacity),
+    _bufferHandoff(nullptr),
+    _totalBytesPushed(0),
+    _totalBytesPopped(0),
+    _residencyStamps(1),
+    _lossyDepth(0),
+    _lossyBufferEnds(1),
+    _totalBytesDropped(0)
 {
-    return;
+    _bufferHandoffProducer.clear();
 }
 
 Pothos::InputPort::~InputPort(void)
 {
-    return;
+    delete _bufferHandoff.load();
 }
 
 const std::string &Pothos::InputPort::alias(void) const
@@ -77,18 +95,10 @@ void Pothos::InputPort::clear(void)
 void Pothos::InputPort::asyncMessagesPush(const Pothos::Object &message, const Pothos::BufferChunk &token)
 {
     {
+        //the producers hold back once the capacity is reached,
+        //so the queue only grows to accept the remaining posts
         std::lock_guard<Util::SpinLock> lock(_asyncMessagesLock);
-        if (_asyncMessages.full())
-        {
-            if (_asyncMessages.size() >= MaxQueueCapacity)
-            {
-                _asyncMessages.clear();
-                poco_error_f2(Poco::Logger::get("Pothos.InputPort.messages"),
-                    "%s[%s] detected input message overflow condition",
-                    _actor->block->getName(), this->alias());
-            }
-            else _asyncMessages.set_capacity(_asyncMessages.capacity()*2);
-        }
+        if (_asyncMessages.full()) _asyncMessages.set_capacity(_asyncMessages.capacity()*2);
         _asyncMessages.emplace_back(message, token);
     }
 
@@ -106,18 +116,13 @@ void Pothos::InputPort::slotCallsPush(const Pothos::Object &args, const Pothos::
 {
     {
         std::lock_guard<Util::SpinLock> lock(_slotCallsLock);
-        if (_slotCalls.full())
+        //the queue only holds calls to this slot, so replace the pending call
+        if (_slotLatestOnly and not _slotCalls.empty()) _slotCalls.back() = std::make_pair(args, token);
+        else
         {
-            if (_slotCalls.size() >= MaxQueueCapacity)
-            {
-                _slotCalls.clear();
-                poco_error_f2(Poco::Logger::get("Pothos.InputPort.slots"),
-                    "%s[%s] detected input slot overflow condition",
-                    _actor->block->getName(), this->alias());
-            }
-            else _slotCalls.set_capacity(_slotCalls.capacity()*2);
+            if (_slotCalls.full()) _slotCalls.set_capacity(_slotCalls.capacity()*2);
+            _slotCalls.emplace_back(args, token);
         }
-        _slotCalls.emplace_back(args, token);
     }
 
     assert(_actor != nullptr);
@@ -132,135 +137,270 @@ bool Pothos::InputPort::slotCallsEmpty(void)
 
 Pothos::Object Pothos::InputPort::slotCallsPop(void)
 {
-    std::lock_guard<Util::SpinLock> lock(_slotCallsLock);
-    assert(not _slotCalls.empty());
-    auto args = std::move(_slotCalls.front().first);
-    _slotCalls.pop_front();
+    Pothos::Object args;
+    bool wasFull = false;
+    {
+        std::lock_guard<Util::SpinLock> lock(_slotCallsLock);
+        assert(not _slotCalls.empty());
+        wasFull = _slotCalls.size() >= _messageCapacity.load(std::memory_order_relaxed);
+        args = std::move(_slotCalls.front().first);
+        _slotCalls.pop_front();
+    }
+    if (wasFull) this->messageCapacityReleased();
     return args;
 }
 
+bool Pothos::InputPort::messageQueuesFull(void)
+{
+    const size_t capacity = _messageCapacity.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<Util::SpinLock> lock(_asyncMessagesLock);
+        if (_asyncMessages.size() >= capacity) return true;
+    }
+    std::lock_guard<Util::SpinLock> lock(_slotCallsLock);
+    return _slotCalls.size() >= capacity;
+}
+
+void Pothos::InputPort::messageCapacityReleased(void)
+{
+    //wake the stalled producers to re-check the capacity
+    for (auto *subscriber : _subscribers)
+    {
+        assert(subscriber->_actor != nullptr);
+        subscriber->_actor->flagExternalChange();
+    }
+}
+
 void Pothos::InputPort::slotCallsClear(void)
 {
     std::lock_guard<Util::SpinLock> lock(_slotCallsLock);
     _slotCalls.clear();
 }
 
-void Pothos::InputPort::bufferAccumulatorPushNoLock(BufferChunk &&buffer)
+void Pothos::InputPort::bufferAccumulatorPushNoLock(BufferChunk &&buffer, const unsigned long long stamp)
 {
     if (not buffer.dtype or not this->dtype() or //unspecified
         (this->dtype().size() == buffer.dtype.size())) //size match
     {
+        //record the arrival stamp for the residency histogram
+        _totalBytesPushed += buffer.length;
+        if (stamp != 0 and _residencyStamps.size() < MaxResidencyStamps)
+        {
+            if (_residencyStamps.full()) _residencyStamps.set_capacity(_residencyStamps.capacity()*2);
+            _residencyStamps.push_back(std::make_pair(_totalBytesPushed, stamp));
+        }
+
         //unspecified buffer dtype? copy it from the port
         if (not buffer.dtype) buffer.dtype = this->dtype();
         _bufferAccumulator.push(std::move(buffer));
         _totalBuffers++;
+
+        //lossy reader: drop the oldest buffers beyond the depth
+        const size_t lossyDepth = _lossyDepth.load(std::memory_order_relaxed);
+        if (lossyDepth != 0)
+        {
+            if (_lossyBufferEnds.full()) _lossyBufferEnds.set_capacity(_lossyBufferEnds.capacity()*2);
+            _lossyBufferEnds.push_back(_totalBytesPushed);
+            while (_lossyBufferEnds.size() > lossyDepth)
+            {
+                const auto dropEnd = _lossyBufferEnds.front();
+                _lossyBufferEnds.pop_front();
+                if (dropEnd > _totalBytesPopped) this->bufferAccumulatorDropNoLock(size_t(dropEnd - _totalBytesPopped));
+            }
+        }
     }
     else
     {
-        poco_error_f4(Poco::Logger::get("Pothos.Block.inputBuffer"), "%s[%s] dropped '%s', expected '%s'",
-            _actor->block->getName(), this->alias(), buffer.dtype.toString(), this->dtype().toString());
+        static auto &logger = Poco::Logger::get("Pothos.Block.inputBuffer");
+        std::string note;
+        if (_actor->logLimiter.allow("inputBuffer:"+this->name(), note))
+        {
+            poco_error(logger, Poco::format("%s[%s] dropped '%s', expected '%s'",
+                _actor->block->getName(), this->alias(), buffer.dtype.toString(), this->dtype().toString()) + note);
+        }
+    }
+}
+
+void Pothos::InputPort::setLossyDepth(const size_t numBuffers)
+{
+    std::lock_guard<Util::SpinLock> lock(_bufferAccumulatorLock);
+    _lossyDepth.store(numBuffers, std::memory_order_relaxed);
+    _lossyBufferEnds.clear();
+}
+
+void Pothos::InputPort::bufferAccumulatorDropNoLock(const size_t numBytes)
+{
+    _bufferAccumulator.pop(numBytes);
+    _totalBytesPopped += numBytes;
+    _totalBytesDropped += numBytes;
+
+    //labels and residency stamps on the dropped bytes are discarded
+    while (not _inputInlineMessages.empty() and _inputInlineMessages.front().index < _totalBytesPopped)
+    {
+        _inputInlineMessages.pop_front();
+    }
+    while (not _residencyStamps.empty() and _residencyStamps.front().first <= _totalBytesPopped)
+    {
+        _residencyStamps.pop_front();
     }
 }
 
-void Pothos::InputPort::bufferAccumulatorPop(const size_t numBytes)
+void Pothos::InputPort::bufferAccumulatorPop(size_t numBytes)
 {
     std::lock_guard<Util::SpinLock> lock(_bufferAccumulatorLock);
 
+    //a lossy reader consumes what remains after the producer dropped bytes during work()
+    if (_lossyDepth.load(std::memory_order_relaxed) != 0)
+    {
+        numBytes = std::min(numBytes, _bufferAccumulator.getTotalBytesAvailable());
+        while (not _lossyBufferEnds.empty() and _lossyBufferEnds.front() <= _totalBytesPopped + numBytes)
+        {
+            _lossyBufferEnds.pop_front();
+        }
+    }
+
     if (numBytes > _bufferAccumulator.getTotalBytesAvailable())
     {
-        poco_error_f4(Poco::Logger::get("Pothos.Block.consume"), "%s[%s] overconsumed %z bytes, %z available",
-            _actor->block->getName(), this->alias(), numBytes, _bufferAccumulator.getTotalBytesAvailable());
+        static auto &logger = Poco::Logger::get("Pothos.Block.consume");
+        std::string note;
+        if (_actor->logLimiter.allow("consume:"+this->name(), note))
+        {
+            poco_error(logger, Poco::format("%s[%s] overconsumed %z bytes, %z available",
+                _actor->block->getName(), this->alias(), numBytes, _bufferAccumulator.getTotalBytesAvailable()) + note);
+        }
         return;
     }
 
     _bufferAccumulator.pop(numBytes);
 
-    //adjust enqueued inline messages for new offset
-    for (size_t i = 0; i < _inputInlineMessages.size(); i++)
+    //enqueued inline messages are stored by absolute byte offset,
+    //so advancing the popped count is enough to account for them
+    _totalBytesPopped += numBytes;
+
+    //record the residency of fully consumed buffers
+    if (not _residencyStamps.empty() and _residencyStamps.front().first <= _totalBytesPopped)
     {
-        _inputInlineMessages[i].index -= numBytes;
+        const auto now = readCycleCounter();
+        const auto period = cycleCounterPeriod();
+        if (not _residencyHistogram) _residencyHistogram.reset(new Util::LatencyHistogram());
+        while (not _residencyStamps.empty() and _residencyStamps.front().first <= _totalBytesPopped)
+        {
+            const auto stamp = _residencyStamps.front().second;
+            const auto cycles = (now > stamp)?(now - stamp):0; //guard against counter skew
+            _residencyHistogram->record((unsigned long long)(cycles*period*1e9));
+            _residencyStamps.pop_front();
+        }
     }
 
     _workEvents++;
 }
 
+void Pothos::InputPort::bufferHandoffDrainNoLock(void)
+{
+    auto handoff = _bufferHandoff.load(std::memory_order_acquire);
+    if (handoff == nullptr) return;
+    std::pair<BufferChunk, unsigned long long> entry;
+    while (handoff->pop(entry))
+    {
+        this->bufferAccumulatorPushNoLock(std::move(entry.first), entry.second);
+    }
+}
+
 void Pothos::InputPort::bufferLabelPush(
-    const bool enableMove,
+    const bool moveLabels,
     std::vector<Pothos::Label> &postedLabels,
     Pothos::Util::RingDeque<Pothos::BufferChunk> &postedBuffers)
 {
+    size_t numHandedOff = 0;
+
+    //stamp the arrival time for the residency histogram (0 when disabled)
+    assert(_actor != nullptr);
+    const unsigned long long stamp = (_actor->statsLevel.load(std::memory_order_relaxed) == WorkerActor::STATS_NONE)?0:readCycleCounter();
+
+    //buffers without labels skip the accumulator lock when this producer
+    //is the only one pushing into the handoff ring at the moment,
+    //the consumer drains the ring into the accumulator under the lock
+    //a lossy reader always takes the locked path so the producer can drop buffers
+    auto handoff = _bufferHandoff.load(std::memory_order_acquire);
+    if (handoff != nullptr and postedLabels.empty() and _lossyDepth.load(std::memory_order_relaxed) == 0 and
+        not _bufferHandoffProducer.test_and_set(std::memory_order_acquire))
+    {
+        for (; numHandedOff < postedBuffers.size(); numHandedOff++)
+        {
+            auto &buffer = postedBuffers[numHandedOff];
+            if (not handoff->push(std::make_pair(std::move(buffer), stamp))) break; //ring is full, use the locked path for the rest
+        }
+        _bufferHandoffProducer.clear(std::memory_order_release);
+    }
+
+    if (numHandedOff < postedBuffers.size() or not postedLabels.empty())
     {
         std::lock_guard<Util::SpinLock> lock(_bufferAccumulatorLock);
 
-        const size_t currentBytes = _bufferAccumulator.getTotalBytesAvailable();
+        //drain the handoff ring first to preserve the buffer ordering
+        this->bufferHandoffDrainNoLock();
+
+        //the first stream buffers make the handoff ring for the next pushes
+        if (_bufferHandoff.load(std::memory_order_relaxed) == nullptr) _bufferHandoff.store(new BufferHandoff(), std::memory_order_release);
+
+        const unsigned long long labelOffset = _totalBytesPopped + _bufferAccumulator.getTotalBytesAvailable();
         const size_t requiredLabelSize = _inputInlineMessages.size() + postedLabels.size();
         if (_inputInlineMessages.capacity() < requiredLabelSize) _inputInlineMessages.set_capacity(requiredLabelSize);
 
-        if (enableMove)
+        //insert labels (in order) at their absolute byte offset
+        for (auto &label : postedLabels)
         {
-            //insert labels (in order) and adjust for the current offset
-            for (auto &label : postedLabels)
-            {
-                label.index += currentBytes; //increment by enqueued bytes
-                _inputInlineMessages.push_back(std::move(label));
-            }
-            postedLabels.clear();
-
-            //push all buffers into the accumulator
-            while (not postedBuffers.empty())
-            {
-                this->bufferAccumulatorPushNoLock(std::move(postedBuffers.front()));
-                postedBuffers.pop_front();
-            }
+            _inputInlineMessages.push_back(moveLabels?std::move(label):Label(label));
+            _inputInlineMessages.back().index += labelOffset;
         }
-        else
-        {
+        if (moveLabels) postedLabels.clear();
 
-            //insert labels (in order) and adjust for the current offset
-            for (auto label : postedLabels)
-            {
-                label.index += currentBytes; //increment by enqueued bytes
-                _inputInlineMessages.push_back(std::move(label));
-            }
-
-            //push all buffers into the accumulator
-            for (size_t i = 0; i < postedBuffers.size(); i++)
-            {
-                this->bufferAccumulatorPushNoLock(BufferChunk(postedBuffers[i]));
-            }
+        //push all remaining buffers into the accumulator
+        for (size_t i = numHandedOff; i < postedBuffers.size(); i++)
+        {
+            this->bufferAccumulatorPushNoLock(std::move(postedBuffers[i]), stamp);
         }
     }
-
-    assert(_actor != nullptr);
-    _actor->flagExternalChange();
+    postedBuffers.clear();
 }
 
 #include <Pothos/Managed.hpp>
 
+//the method tables are built when the class is first used by a proxy
+static Pothos::ManagedClass makeManagedInputPort(void)
+{
+    return Pothos::ManagedClass()
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, index))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, name))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, dtype))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, domain))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, buffer))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, elements))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, totalElements))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, totalMessages))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, hasMessage))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, labels))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, removeLabel))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, consume))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, takeBuffer))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, popMessage))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, peekMessage))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, setReserve))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, setMinBatch))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, setStaticRate))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, staticRate))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, setMessageCapacity))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, setLossyDepth))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, isSlot))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, pushBuffer))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, pushLabel))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, pushMessage))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, clear));
+}
+
 static auto managedInputPort = Pothos::ManagedClass()
     .registerClass<Pothos::InputPort>()
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, index))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, name))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, dtype))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, domain))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, buffer))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, elements))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, totalElements))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, totalMessages))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, hasMessage))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, labels))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, removeLabel))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, consume))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, takeBuffer))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, popMessage))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, peekMessage))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, setReserve))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, isSlot))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, pushBuffer))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, pushLabel))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, pushMessage))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::InputPort, clear))
-    .commit("Pothos/InputPort");
+    .commitDeferred("Pothos/InputPort", &makeManagedInputPort);
 
 /***********************************************************************
  * Register toString() outputs
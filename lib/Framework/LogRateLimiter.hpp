@@ -0,0 +1,76 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <map>
+
+/*!
+ * LogRateLimiter allows a log message once per interval for each key.
+ * A block that fails in every call to work() would otherwise
+ * turn its worker thread into a logging loop and flood the logs.
+ * The next allowed message reports how many repeats were suppressed.
+ */
+class LogRateLimiter
+{
+public:
+    //! The number of keys before the history is reset
+    static const size_t MaxKeys = 64;
+
+    LogRateLimiter(const std::chrono::nanoseconds interval = std::chrono::seconds(1)):
+        _interval(interval)
+    {
+        return;
+    }
+
+    /*!
+     * Check if a message with this key may be logged now.
+     * \param key the message key, for example the site and the message text
+     * \param [out] note a suffix for the message about suppressed repeats
+     * \return true when the message should be logged
+     */
+    bool allow(const std::string &key, std::string &note)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto now = std::chrono::steady_clock::now();
+        note.clear();
+
+        auto it = _entries.find(key);
+        if (it == _entries.end())
+        {
+            if (_entries.size() >= MaxKeys) _entries.clear();
+            _entries[key] = Entry(now);
+            return true;
+        }
+
+        auto &entry = it->second;
+        if (now - entry.lastLogged < _interval)
+        {
+            entry.suppressed++;
+            return false;
+        }
+        if (entry.suppressed != 0) note = " (suppressed " + std::to_string(entry.suppressed) + " repeats)";
+        entry = Entry(now);
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        Entry(const std::chrono::steady_clock::time_point &lastLogged = std::chrono::steady_clock::time_point()):
+            lastLogged(lastLogged),
+            suppressed(0)
+        {
+            return;
+        }
+        std::chrono::steady_clock::time_point lastLogged;
+        unsigned long long suppressed;
+    };
+
+    const std::chrono::nanoseconds _interval;
+    std::mutex _mutex;
+    std::map<std::string, Entry> _entries;
+};
@@ -3,6 +3,8 @@
 
 #include <Pothos/Framework/ManagedBuffer.hpp>
 #include <Pothos/Framework/BufferManager.hpp>
+#include "Framework/SlabAllocator.hpp"
+#include <new>
 
 Pothos::ManagedBuffer::Impl::Impl(void):
     counter(1),
@@ -12,6 +14,12 @@ Pothos::ManagedBuffer::Impl::Impl(void):
     return;
 }
 
+Pothos::ManagedBuffer::Impl *Pothos::ManagedBuffer::Impl::make(void)
+{
+    //the impl is allocated from the slabs for temporary buffers
+    return new (slabAllocate(sizeof(Impl))) Impl();
+}
+
 void Pothos::ManagedBuffer::Impl::cleanup(void)
 {
     //there is a manager to push to, otherwise delete
@@ -22,18 +30,22 @@ void Pothos::ManagedBuffer::Impl::cleanup(void)
         manager->pushExternal(mb);
         mb._impl = nullptr;
     }
-    else delete this;
+    else
+    {
+        this->~Impl();
+        slabDeallocate(this, sizeof(Impl));
+    }
 }
 
 Pothos::ManagedBuffer::ManagedBuffer(const SharedBuffer &buff):
-    _impl(new Impl())
+    _impl(Impl::make())
 {
     _impl->buffer = buff;
 }
 
 void Pothos::ManagedBuffer::reset(BufferManager::Sptr manager, const SharedBuffer &buff, const size_t slabIndex)
 {
-    if (_impl == nullptr) _impl = new Impl();
+    if (_impl == nullptr) _impl = Impl::make();
     _impl->buffer = buff;
     _impl->slabIndex = slabIndex;
     _impl->weakManager = manager;
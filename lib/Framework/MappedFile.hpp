@@ -0,0 +1,77 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework/SharedBuffer.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/*!
+ * MappedFile maps windows of a file into memory as shared buffers.
+ * The file stays open until the file object and all windows are deleted.
+ * The implementation is in the platform specific SharedBuffer sources.
+ *
+ * Read mode: windows are private copy-on-write mappings of the file,
+ * so consumers may modify a window in place without changing the file.
+ * Write mode: the file is created or truncated, and grows as windows are mapped;
+ * writes into a window go directly to the file pages without a copy.
+ */
+class MappedFile : public std::enable_shared_from_this<MappedFile>
+{
+public:
+    typedef std::shared_ptr<MappedFile> Sptr;
+
+    /*!
+     * Open the file for mapping.
+     * \throws Pothos::SharedBufferError when the file cannot be opened
+     * \param path the path to the file
+     * \param write true to create the file for writing, false to read it
+     */
+    static Sptr open(const std::string &path, const bool write);
+
+    //! Close the file, and truncate a written file to its final size
+    ~MappedFile(void);
+
+    //! The alignment in bytes for the offset of a window
+    static size_t alignment(void);
+
+    //! The size of the file in bytes
+    unsigned long long size(void) const;
+
+    /*!
+     * Map a window of the file into memory.
+     * In read mode, the window is clamped to the end of the file.
+     * In write mode, the file is extended to cover the window.
+     * The access pattern of the window is advised to be sequential.
+     * \throws Pothos::SharedBufferError when the window cannot be mapped
+     * \param offset the offset into the file, a multiple of alignment()
+     * \param numBytes the number of bytes in the window
+     * \return a shared buffer that unmaps the window when deleted
+     */
+    Pothos::SharedBuffer map(const unsigned long long offset, const size_t numBytes);
+
+    /*!
+     * Start writing back the modified pages of a window to the file.
+     * This call does not wait for the write and does nothing in read mode.
+     */
+    void flush(const Pothos::SharedBuffer &window);
+
+    /*!
+     * Set the size of a written file once it is closed.
+     * The mapped windows extend the file to a multiple of the window size,
+     * and the final size removes the unused space of the last window.
+     */
+    void setFinalSize(const unsigned long long finalSize);
+
+private:
+    MappedFile(const std::string &path, const bool write);
+    void errorOut(const std::string &what);
+
+    const std::string _path;
+    const bool _write;
+    intptr_t _handle;
+    unsigned long long _size;
+    unsigned long long _finalSize;
+};
@@ -0,0 +1,181 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework/MemoryAccount.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include <Poco/Format.h>
+#include <json.hpp>
+#include <algorithm> //max
+#include <mutex>
+#include <vector>
+
+using json = nlohmann::json;
+
+/***********************************************************************
+ * One mutex for every account, so a charge checks all budgets at once.
+ * Allocations are rare compared to the work in the buffers they make.
+ **********************************************************************/
+static std::mutex &getAccountingMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+//the account which is charged for allocations in this thread
+static thread_local Pothos::MemoryAccount::Sptr currentAccount;
+
+/***********************************************************************
+ * accounts
+ **********************************************************************/
+Pothos::MemoryAccount::MemoryAccount(const std::string &name, const Sptr &parent):
+    _name(name),
+    _parent(parent),
+    _budget(0),
+    _bytes(0),
+    _peakBytes(0),
+    _numAllocations(0),
+    _numFailures(0)
+{
+    return;
+}
+
+const Pothos::MemoryAccount::Sptr &Pothos::MemoryAccount::global(void)
+{
+    static const Sptr account(new MemoryAccount("global", nullptr));
+    return account;
+}
+
+Pothos::MemoryAccount::Sptr Pothos::MemoryAccount::get(const std::string &name)
+{
+    //the account lives while the accounts of its blocks refer to it
+    static std::map<std::string, std::weak_ptr<MemoryAccount>> accounts;
+    std::lock_guard<std::mutex> lock(getAccountingMutex());
+    auto &weakAccount = accounts[name];
+    auto account = weakAccount.lock();
+    if (not account) weakAccount = account = Sptr(new MemoryAccount(name, global()));
+    return account;
+}
+
+Pothos::MemoryAccount::Sptr Pothos::MemoryAccount::make(const std::string &name, const Sptr &parent)
+{
+    return Sptr(new MemoryAccount(name, parent?parent:global()));
+}
+
+const std::string &Pothos::MemoryAccount::name(void) const
+{
+    return _name;
+}
+
+void Pothos::MemoryAccount::setParent(const Sptr &parent)
+{
+    std::lock_guard<std::mutex> lock(getAccountingMutex());
+    if (this != global().get()) _parent = parent?parent:global();
+}
+
+void Pothos::MemoryAccount::setBudget(const size_t numBytes)
+{
+    std::lock_guard<std::mutex> lock(getAccountingMutex());
+    _budget = numBytes;
+}
+
+size_t Pothos::MemoryAccount::getBudget(void) const
+{
+    std::lock_guard<std::mutex> lock(getAccountingMutex());
+    return _budget;
+}
+
+size_t Pothos::MemoryAccount::bytes(void) const
+{
+    std::lock_guard<std::mutex> lock(getAccountingMutex());
+    return _bytes;
+}
+
+std::string Pothos::MemoryAccount::toJSON(void) const
+{
+    json stats;
+    std::lock_guard<std::mutex> lock(getAccountingMutex());
+    stats["name"] = _name;
+    stats["bytes"] = _bytes;
+    stats["peakBytes"] = _peakBytes;
+    stats["budget"] = _budget;
+    stats["numAllocations"] = _numAllocations;
+    stats["numFailures"] = _numFailures;
+    json byType(json::object()), byNode(json::object());
+    for (const auto &pair : _bytesByType) byType[pair.first] = pair.second;
+    for (const auto &pair : _bytesByNode) byNode[std::to_string(pair.first)] = pair.second;
+    stats["bytesByType"] = byType;
+    stats["bytesByNode"] = byNode;
+    return stats.dump();
+}
+
+/***********************************************************************
+ * charges
+ **********************************************************************/
+struct Pothos::MemoryAccountCharge
+{
+    MemoryAccountCharge(const size_t numBytes, const std::string &type, const long nodeAffinity):
+        numBytes(numBytes),
+        type(type),
+        nodeAffinity(nodeAffinity)
+    {
+        std::lock_guard<std::mutex> lock(getAccountingMutex());
+        for (auto account = currentAccount?currentAccount:MemoryAccount::global(); account; account = account->_parent)
+        {
+            accounts.push_back(account);
+        }
+
+        //check every budget before charging any account
+        for (const auto &account : accounts)
+        {
+            if (account->_budget == 0 or account->_bytes + numBytes <= account->_budget) continue;
+            account->_numFailures++;
+            throw Pothos::SharedBufferError("Pothos::MemoryAccount::charge()", Poco::format(
+                "%z bytes exceeds the budget of account %s: %z of %z bytes in use",
+                numBytes, account->_name, account->_bytes, account->_budget));
+        }
+
+        for (const auto &account : accounts)
+        {
+            account->_bytes += numBytes;
+            account->_peakBytes = std::max(account->_peakBytes, account->_bytes);
+            account->_numAllocations++;
+            account->_bytesByType[type] += numBytes;
+            account->_bytesByNode[nodeAffinity] += numBytes;
+        }
+    }
+
+    ~MemoryAccountCharge(void)
+    {
+        std::lock_guard<std::mutex> lock(getAccountingMutex());
+        for (const auto &account : accounts)
+        {
+            account->_bytes -= numBytes;
+            account->_bytesByType[type] -= numBytes;
+            account->_bytesByNode[nodeAffinity] -= numBytes;
+        }
+    }
+
+    const size_t numBytes;
+    const std::string type;
+    const long nodeAffinity;
+    std::vector<Pothos::MemoryAccount::Sptr> accounts; //the charged accounts, held until the release
+};
+
+std::shared_ptr<void> Pothos::MemoryAccount::charge(const size_t numBytes, const std::string &type, const long nodeAffinity)
+{
+    return std::make_shared<MemoryAccountCharge>(numBytes, type, nodeAffinity);
+}
+
+/***********************************************************************
+ * thread scope
+ **********************************************************************/
+Pothos::MemoryAccount::Scope::Scope(const Sptr &account):
+    _previous(currentAccount)
+{
+    currentAccount = account;
+}
+
+Pothos::MemoryAccount::Scope::~Scope(void)
+{
+    currentAccount = _previous;
+}
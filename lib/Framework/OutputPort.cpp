@@ -1,10 +1,19 @@
-// Copyright (c) 2014-2018 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/OutputPortImpl.hpp>
+#include <Pothos/Framework/Packet.hpp>
 #include "Framework/WorkerActor.hpp"
 #include <Pothos/Object/Containers.hpp>
+#include <algorithm> //find/max
+#include <vector>
+
+//! The number of messages in flight per output port by default
+static const size_t DefaultTokenDepth = 16;
+
+//! The most posted packets retained for recycling per output port
+static const size_t MaxPooledPackets = 16;
 
 Pothos::OutputPort::OutputPort(void):
     _actor(nullptr),
@@ -15,13 +24,19 @@ Pothos::OutputPort::OutputPort(void):
     _totalBuffers(0),
     _totalLabels(0),
     _totalMessages(0),
+    _tokenStarvations(0),
+    _bufferStarvations(0),
+    _staticRate(0),
     _pendingElements(0),
     _reserveElements(0),
     _workEvents(0),
-    _readBeforeWritePort(nullptr),
-    _bufferFromManager(false)
+    _tokenDepth(DefaultTokenDepth),
+    _bufferFromManager(false),
+    _packetPoolEnabled(false)
 {
-    this->tokenManagerInit();
+    //the token manager is made upon the first message,
+    //so that stream ports without messages never allocate one
+    return;
 }
 
 Pothos::OutputPort::~OutputPort(void)
@@ -63,6 +78,38 @@ Pothos::BufferChunk Pothos::OutputPort::getBuffer(const DType &dtype, const size
     return out;
 }
 
+Pothos::Object Pothos::OutputPort::getPacket(const DType &dtype, const size_t numElements)
+{
+    _packetPoolEnabled = true;
+
+    //recycle a posted packet that the consumers have released
+    Object msg;
+    for (auto &pooled : _packetPool)
+    {
+        if (not pooled.unique()) continue;
+        msg = std::move(pooled);
+        pooled = std::move(_packetPool.back());
+        _packetPool.pop_back();
+        break;
+    }
+    if (not msg) msg = Object::emplace<Packet>();
+
+    auto &packet = msg.ref<Packet>();
+    packet.metadata.clear();
+    packet.labels.clear();
+    packet.payload = this->getBuffer(dtype, numElements);
+    return msg;
+}
+
+void Pothos::OutputPort::packetPoolRelease(void)
+{
+    //released packets should not hold on to their payload buffers
+    for (auto &pooled : _packetPool)
+    {
+        if (pooled.unique()) pooled.ref<Packet>().payload = BufferChunk();
+    }
+}
+
 void Pothos::OutputPort::_postMessage(const Object &async)
 {
     const auto token = this->tokenManagerPop();
@@ -79,10 +126,82 @@ void Pothos::OutputPort::_postMessage(const Object &async)
     }
     _totalMessages++;
     _workEvents++;
+
+    //retain packets from getPacket() users to recycle after release
+    if (_packetPoolEnabled and _packetPool.size() < MaxPooledPackets and async.type() == typeid(Packet))
+    {
+        _packetPool.push_back(async);
+    }
+}
+
+/***********************************************************************
+ * Buffer returns are batched per consumer thread during post-work
+ **********************************************************************/
+struct BufferReturn
+{
+    Pothos::OutputPort *port;
+    Pothos::Util::SpinLock *mutex;
+    Pothos::ManagedBuffer buff;
+};
+
+struct BufferReturnBatch
+{
+    BufferReturnBatch(void): depth(0){}
+    size_t depth;
+    std::vector<BufferReturn> returns;
+};
+
+static thread_local BufferReturnBatch returnBatch;
+
+void Pothos::OutputPort::bufferManagerReturnsBegin(void)
+{
+    returnBatch.depth++;
+}
+
+void Pothos::OutputPort::bufferManagerReturnsEnd(void)
+{
+    assert(returnBatch.depth != 0);
+    if (--returnBatch.depth != 0) return;
+    auto &returns = returnBatch.returns;
+    if (returns.empty()) return;
+
+    //push every buffer for the same manager lock at once
+    std::vector<Pothos::Util::SpinLock *> mutexes;
+    std::vector<Pothos::OutputPort *> ports;
+    for (const auto &r : returns)
+    {
+        if (std::find(mutexes.begin(), mutexes.end(), r.mutex) != mutexes.end()) continue;
+        mutexes.push_back(r.mutex);
+        std::lock_guard<Pothos::Util::SpinLock> lock(*r.mutex);
+        for (const auto &other : returns)
+        {
+            if (other.mutex != r.mutex) continue;
+            if (auto manager = other.buff.getBufferManager()) manager->push(other.buff);
+        }
+        if (std::find(ports.begin(), ports.end(), r.port) == ports.end()) ports.push_back(r.port);
+    }
+
+    //release the batch references, then wake each producer once
+    returns.clear();
+    std::vector<Pothos::WorkerActor *> actors;
+    for (auto *port : ports)
+    {
+        assert(port->_actor != nullptr);
+        if (std::find(actors.begin(), actors.end(), port->_actor) != actors.end()) continue;
+        actors.push_back(port->_actor);
+        port->_actor->flagExternalChange();
+    }
 }
 
 void Pothos::OutputPort::bufferManagerPush(Pothos::Util::SpinLock *mutex, const Pothos::ManagedBuffer &buff)
 {
+    //defer the return while this thread is batching its returns
+    if (returnBatch.depth != 0)
+    {
+        returnBatch.returns.push_back(BufferReturn{this, mutex, buff});
+        return;
+    }
+
     {
         std::lock_guard<Pothos::Util::SpinLock> lock(*mutex);
         buff.getBufferManager()->push(buff);
@@ -99,39 +218,65 @@ void Pothos::OutputPort::bufferManagerSetup(const Pothos::BufferManager::Sptr &m
         &Pothos::OutputPort::bufferManagerPush, this, &_bufferManagerLock, std::placeholders::_1));
 }
 
-void Pothos::OutputPort::tokenManagerInit(void)
+Pothos::BufferManager::Sptr Pothos::OutputPort::tokenManagerMake(const size_t numTokens)
 {
     BufferManagerArgs tokenMgrArgs;
-    tokenMgrArgs.numBuffers = 16;
+    tokenMgrArgs.numBuffers = std::max<size_t>(numTokens, 1);
     tokenMgrArgs.bufferSize = 0;
-    _tokenManager = BufferManager::make("generic", tokenMgrArgs);
-    _tokenManager->setCallback(std::bind(
+    auto tokenManager = BufferManager::make("generic", tokenMgrArgs);
+    tokenManager->setCallback(std::bind(
         &Pothos::OutputPort::bufferManagerPush, this, &_tokenManagerLock, std::placeholders::_1));
+    return tokenManager;
+}
+
+void Pothos::OutputPort::setTokenDepth(const size_t numTokens)
+{
+    //tokens still held downstream are freed when the old manager is gone
+    {
+        std::lock_guard<Util::SpinLock> lock(_tokenManagerLock);
+        _tokenDepth = numTokens;
+        if (_tokenManager) _tokenManager = this->tokenManagerMake(_tokenDepth);
+    }
+    assert(_actor != nullptr);
+    _actor->flagExternalChange();
 }
 
 #include <Pothos/Managed.hpp>
 
+//the method tables are built when the class is first used by a proxy
+static Pothos::ManagedClass makeManagedOutputPort(void)
+{
+    return Pothos::ManagedClass()
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, index))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, name))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, dtype))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, domain))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, buffer))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, elements))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, totalElements))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, totalMessages))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, produce))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, popElements))
+        .registerMethod("getBuffer", Pothos::Callable::make<Pothos::BufferChunk, Pothos::OutputPort, size_t>(&Pothos::OutputPort::getBuffer))
+        .registerMethod("getBuffer", Pothos::Callable::make<Pothos::BufferChunk, Pothos::OutputPort, const Pothos::DType &, size_t>(&Pothos::OutputPort::getBuffer))
+        .registerMethod("getPacket", Pothos::Callable::make<Pothos::Object, Pothos::OutputPort, size_t>(&Pothos::OutputPort::getPacket))
+        .registerMethod("getPacket", Pothos::Callable::make<Pothos::Object, Pothos::OutputPort, const Pothos::DType &, size_t>(&Pothos::OutputPort::getPacket))
+        .registerMethod("postLabel", &Pothos::OutputPort::postLabel<const Pothos::Label &>)
+        .registerMethod("postMessage", &Pothos::OutputPort::postMessage<const Pothos::Object &>)
+        .registerMethod("postBuffer", &Pothos::OutputPort::postBuffer<const Pothos::BufferChunk &>)
+        .registerMethod("postBuffer", Pothos::Callable::make<void, Pothos::OutputPort, const Pothos::BufferChunkList &>(&Pothos::OutputPort::postBuffer))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, setReserve))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, setTokenDepth))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, setStaticRate))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, staticRate))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, isSignal))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, setReadBeforeWrite))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, addReadBeforeWrite));
+}
+
 static auto managedOutputPort = Pothos::ManagedClass()
     .registerClass<Pothos::OutputPort>()
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, index))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, name))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, dtype))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, domain))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, buffer))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, elements))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, totalElements))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, totalMessages))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, produce))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, popElements))
-    .registerMethod("getBuffer", Pothos::Callable::make<Pothos::BufferChunk, Pothos::OutputPort, size_t>(&Pothos::OutputPort::getBuffer))
-    .registerMethod("getBuffer", Pothos::Callable::make<Pothos::BufferChunk, Pothos::OutputPort, const Pothos::DType &, size_t>(&Pothos::OutputPort::getBuffer))
-    .registerMethod("postLabel", &Pothos::OutputPort::postLabel<const Pothos::Label &>)
-    .registerMethod("postMessage", &Pothos::OutputPort::postMessage<const Pothos::Object &>)
-    .registerMethod("postBuffer", &Pothos::OutputPort::postBuffer<const Pothos::BufferChunk &>)
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, setReserve))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, isSignal))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::OutputPort, setReadBeforeWrite))
-    .commit("Pothos/OutputPort");
+    .commitDeferred("Pothos/OutputPort", &makeManagedOutputPort);
 
 /***********************************************************************
  * Register toString() outputs
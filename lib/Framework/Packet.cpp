@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2014 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
@@ -21,6 +21,42 @@ static auto managedPacket = Pothos::ManagedClass()
 #include <Pothos/Object/Serialize.hpp>
 
 namespace Pothos { namespace serialization {
+
+//metadata uses the same archive format as ObjectKwargs
+template<class Archive>
+void save(Archive & ar, const Pothos::PacketMetadata &t, const unsigned int)
+{
+    ar << unsigned(t.size());
+    for (const auto &entry : t)
+    {
+        ar << entry.first.str();
+        ar << entry.second;
+    }
+}
+
+template<class Archive>
+void load(Archive & ar, Pothos::PacketMetadata &t, const unsigned int)
+{
+    t.clear();
+    unsigned size(0);
+    ar >> size;
+    t.reserve(size);
+    for (size_t i = 0; i < size_t(size); i++)
+    {
+        std::string key;
+        Pothos::Object value;
+        ar >> key;
+        ar >> value;
+        t[key] = std::move(value);
+    }
+}
+
+template<class Archive>
+void serialize(Archive & ar, Pothos::PacketMetadata &t, const unsigned int ver)
+{
+    Pothos::serialization::invokeSplit(ar, t, ver);
+}
+
 template<class Archive>
 void serialize(Archive & ar, Pothos::Packet &t, const unsigned int)
 {
@@ -31,6 +67,7 @@ void serialize(Archive & ar, Pothos::Packet &t, const unsigned int)
 }}
 
 POTHOS_OBJECT_SERIALIZE(Pothos::Packet)
+POTHOS_OBJECT_SERIALIZE(Pothos::PacketMetadata)
 
 #include <Pothos/Object.hpp>
 #include <Pothos/Plugin.hpp>
@@ -40,7 +77,7 @@ static std::string packetToString(const Pothos::Packet& packet)
 {
     return Poco::format("Pothos::Packet (payload: %s, metadata: %s, labels: %s)",
                         Pothos::Object(packet.payload).toString(),
-                        Pothos::Object(packet.metadata).toString(),
+                        Pothos::Object(packet.metadata.toKwargs()).toString(),
                         Pothos::Object(packet.labels).toString());
 }
 
@@ -0,0 +1,64 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework/PacketMetadata.hpp>
+
+Pothos::PacketMetadata::PacketMetadata(const ObjectKwargs &kwargs)
+{
+    _entries.reserve(kwargs.size());
+    for (const auto &pair : kwargs) (*this)[pair.first] = pair.second;
+}
+
+Pothos::ObjectKwargs Pothos::PacketMetadata::toKwargs(void) const
+{
+    ObjectKwargs kwargs;
+    for (const auto &entry : _entries) kwargs.emplace(entry.first.str(), entry.second);
+    return kwargs;
+}
+
+#include <Pothos/Managed.hpp>
+
+static size_t packetMetadataCount(const Pothos::PacketMetadata &metadata, const std::string &key)
+{
+    return metadata.count(key);
+}
+
+static Pothos::Object packetMetadataGet(const Pothos::PacketMetadata &metadata, const std::string &key)
+{
+    return metadata.at(key);
+}
+
+static void packetMetadataSet(Pothos::PacketMetadata &metadata, const std::string &key, const Pothos::Object &value)
+{
+    metadata[key] = value;
+}
+
+static auto managedPacketMetadata = Pothos::ManagedClass()
+    .registerConstructor<Pothos::PacketMetadata>()
+    .registerConstructor<Pothos::PacketMetadata, const Pothos::ObjectKwargs &>()
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::PacketMetadata, toKwargs))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::PacketMetadata, empty))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::PacketMetadata, size))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::PacketMetadata, clear))
+    .registerMethod("count", &packetMetadataCount)
+    .registerMethod("get", &packetMetadataGet)
+    .registerMethod("set", &packetMetadataSet)
+    .commit("Pothos/PacketMetadata");
+
+#include <Pothos/Plugin.hpp>
+
+static Pothos::PacketMetadata convertObjectKwargsToPacketMetadata(const Pothos::ObjectKwargs &kwargs)
+{
+    return Pothos::PacketMetadata(kwargs);
+}
+
+static Pothos::ObjectKwargs convertPacketMetadataToObjectKwargs(const Pothos::PacketMetadata &metadata)
+{
+    return metadata.toKwargs();
+}
+
+pothos_static_block(pothosRegisterPacketMetadataConversions)
+{
+    Pothos::PluginRegistry::add("/object/convert/containers/object_kwargs_to_packet_metadata", Pothos::Callable(&convertObjectKwargsToPacketMetadata));
+    Pothos::PluginRegistry::add("/object/convert/containers/packet_metadata_to_object_kwargs", Pothos::Callable(&convertPacketMetadataToObjectKwargs));
+}
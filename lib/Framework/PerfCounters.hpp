@@ -0,0 +1,116 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <cstring> //memset
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*!
+ * A group of hardware performance counters for the calling thread.
+ * The counters are opened with perf_event_open() upon the first use in a thread,
+ * and count the user-space events of the thread on any CPU, so that the delta
+ * between two reads on the same thread belongs to the code in between.
+ * The counters are unavailable on other operating systems, on hosts without
+ * hardware counters, or when the perf_event_paranoid setting denies access.
+ */
+class PerfCounters
+{
+public:
+    enum Event {CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, NUM_EVENTS};
+
+    //! The counter values indexed by event
+    struct Values
+    {
+        unsigned long long counts[NUM_EVENTS];
+    };
+
+    //! Get the counters of the calling thread (opened on the first call)
+    static PerfCounters &current(void)
+    {
+        static thread_local PerfCounters counters;
+        return counters;
+    }
+
+    //! True when at least the cycle counter was opened
+    bool available(void) const
+    {
+        return _fds[CYCLES] >= 0;
+    }
+
+    /*!
+     * Read all counters with a single call on the group leader.
+     * Events that could not be opened read as zero.
+     * \return false when the counters are unavailable
+     */
+    bool read(Values &values) const
+    {
+        std::memset(&values, 0, sizeof(values));
+        #ifdef __linux__
+        if (not this->available()) return false;
+        unsigned long long buff[1+NUM_EVENTS]; //nr followed by the values in open order
+        if (::read(_fds[CYCLES], buff, sizeof(buff)) <= 0) return false;
+        for (size_t i = 0; i < NUM_EVENTS; i++)
+        {
+            if (_slots[i] >= 0 and (unsigned long long)(_slots[i]) < buff[0]) values.counts[i] = buff[1+_slots[i]];
+        }
+        return true;
+        #else
+        return false;
+        #endif
+    }
+
+    ~PerfCounters(void)
+    {
+        #ifdef __linux__
+        for (const auto fd : _fds) if (fd >= 0) close(fd);
+        #endif
+    }
+
+private:
+    PerfCounters(void)
+    {
+        int numSlots(0);
+        for (size_t i = 0; i < NUM_EVENTS; i++)
+        {
+            _fds[i] = -1;
+            _slots[i] = -1;
+        }
+        #ifdef __linux__
+        static const unsigned long long configs[NUM_EVENTS] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES};
+        for (size_t i = 0; i < NUM_EVENTS; i++)
+        {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            //the cycle counter leads the group, the group is useless without it
+            const int groupFd = (i == CYCLES)?-1:_fds[CYCLES];
+            _fds[i] = int(syscall(SYS_perf_event_open, &attr, 0/*this thread*/, -1/*any cpu*/, groupFd, 0));
+            if (_fds[i] >= 0) _slots[i] = numSlots++;
+            else if (i == CYCLES) break;
+        }
+        #endif
+        (void)numSlots;
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    int _fds[NUM_EVENTS];
+    int _slots[NUM_EVENTS]; //position in the group read or -1
+};
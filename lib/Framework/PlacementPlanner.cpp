@@ -0,0 +1,153 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Framework/PlacementPlanner.hpp"
+#include <algorithm> //count, max
+#include <numeric> //accumulate
+
+//! Refinement passes over the blocks, each pass moves blocks with a positive gain
+static const size_t maxRefinePasses = 16;
+
+PlacementProblem::PlacementProblem(void):
+    balanceSlack(0.25)
+{
+    return;
+}
+
+double placementCrossingRate(const PlacementProblem &problem, const std::vector<size_t> &placement)
+{
+    double rate = 0.0;
+    for (const auto &flow : problem.flows)
+    {
+        if (placement.at(flow.src) != placement.at(flow.dst)) rate += flow.rate;
+    }
+    return rate;
+}
+
+std::vector<size_t> planPlacement(const PlacementProblem &problem)
+{
+    const size_t numBlocks = problem.blockCosts.size();
+    const size_t numHosts = problem.hostCapacities.size();
+    std::vector<size_t> placement(numBlocks, 0);
+    if (numHosts == 0 or numBlocks == 0) return placement;
+
+    //the flows of each block for the neighbor affinity
+    std::vector<std::vector<std::pair<size_t, double>>> neighbors(numBlocks);
+    for (const auto &flow : problem.flows)
+    {
+        if (flow.src == flow.dst) continue;
+        neighbors.at(flow.src).emplace_back(flow.dst, flow.rate);
+        neighbors.at(flow.dst).emplace_back(flow.src, flow.rate);
+    }
+
+    //the load limit of each host from its share of the total capacity,
+    //but every host can take at least the largest block
+    const double totalCost = std::accumulate(problem.blockCosts.begin(), problem.blockCosts.end(), 0.0);
+    const double totalCapacity = std::accumulate(problem.hostCapacities.begin(), problem.hostCapacities.end(), 0.0);
+    const double maxCost = *std::max_element(problem.blockCosts.begin(), problem.blockCosts.end());
+    std::vector<double> limits(numHosts), loads(numHosts, 0.0);
+    for (size_t h = 0; h < numHosts; h++)
+    {
+        const double share = (totalCapacity > 0.0)?(problem.hostCapacities[h]/totalCapacity):(1.0/numHosts);
+        limits[h] = std::max(share*totalCost*(1.0+problem.balanceSlack), maxCost);
+    }
+
+    //pinned blocks are placed first
+    std::vector<bool> placed(numBlocks, false);
+    for (size_t b = 0; b < numBlocks; b++)
+    {
+        const long pin = (b < problem.pinnedHosts.size())?problem.pinnedHosts[b]:-1;
+        if (pin < 0) continue;
+        placement[b] = size_t(pin);
+        loads[size_t(pin)] += problem.blockCosts[b];
+        placed[b] = true;
+    }
+
+    //the rate from a block to the placed blocks on each host
+    auto hostAffinity = [&](const size_t b, std::vector<double> &affinity)
+    {
+        std::fill(affinity.begin(), affinity.end(), 0.0);
+        for (const auto &n : neighbors[b])
+        {
+            if (placed[n.first]) affinity[placement[n.first]] += n.second;
+        }
+    };
+
+    //the relative load of a host after adding a cost
+    auto relativeLoad = [&](const size_t h, const double cost)
+    {
+        return (loads[h]+cost)/limits[h];
+    };
+
+    //greedy: grow the placement from the unplaced block with the best gain,
+    //the rate to placed blocks minus the rate to the other unplaced blocks,
+    //so clusters are absorbed from their edges and heavy cuts are avoided
+    auto placementGain = [&](const size_t b)
+    {
+        double gain = 0.0;
+        for (const auto &n : neighbors[b]) gain += placed[n.first]?n.second:-n.second;
+        return gain;
+    };
+    std::vector<double> affinity(numHosts);
+    for (size_t numPlaced = std::count(placed.begin(), placed.end(), true); numPlaced < numBlocks; numPlaced++)
+    {
+        size_t b = numBlocks;
+        double bestGain = 0.0;
+        for (size_t i = 0; i < numBlocks; i++)
+        {
+            if (placed[i]) continue;
+            const double gain = placementGain(i);
+            if (b == numBlocks or gain > bestGain)
+            {
+                b = i;
+                bestGain = gain;
+            }
+        }
+
+        hostAffinity(b, affinity);
+        const double cost = problem.blockCosts[b];
+        size_t best = 0;
+        bool bestFits = false;
+        for (size_t h = 0; h < numHosts; h++)
+        {
+            const bool fits = loads[h]+cost <= limits[h];
+            const bool better = (fits and not bestFits) or (fits == bestFits and
+                (affinity[h] > affinity[best] or (affinity[h] == affinity[best] and relativeLoad(h, cost) < relativeLoad(best, cost))));
+            if (h == 0 or better)
+            {
+                best = h;
+                bestFits = fits;
+            }
+        }
+        placement[b] = best;
+        loads[best] += cost;
+        placed[b] = true;
+    }
+
+    //refine: move single blocks while a move reduces the crossing rate within the limits
+    for (size_t pass = 0; pass < maxRefinePasses; pass++)
+    {
+        bool moved = false;
+        for (size_t b = 0; b < numBlocks; b++)
+        {
+            if (b < problem.pinnedHosts.size() and problem.pinnedHosts[b] >= 0) continue;
+            hostAffinity(b, affinity);
+            const size_t from = placement[b];
+            const double cost = problem.blockCosts[b];
+            size_t best = from;
+            for (size_t h = 0; h < numHosts; h++)
+            {
+                if (h == from or loads[h]+cost > limits[h]) continue;
+                if (affinity[h] > affinity[best]) best = h;
+            }
+            if (best == from) continue;
+            loads[from] -= cost;
+            loads[best] += cost;
+            placement[b] = best;
+            moved = true;
+        }
+        if (not moved) break;
+    }
+
+    return placement;
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <vector>
+#include <cstddef>
+
+/*!
+ * The graph of blocks and hosts for the placement planner.
+ * Block costs and host capacities are in any consistent unit,
+ * such as the work time of a block and the CPU count of a host.
+ * Flow rates are in any consistent unit, such as bytes per second.
+ */
+struct PlacementProblem
+{
+    PlacementProblem(void);
+
+    struct Flow
+    {
+        size_t src; //!< the index of the source block
+        size_t dst; //!< the index of the destination block
+        double rate; //!< the estimated rate of the flow
+    };
+
+    std::vector<double> blockCosts; //!< the CPU cost per block
+    std::vector<long> pinnedHosts; //!< the host per block or -1 when unpinned
+    std::vector<Flow> flows; //!< the flows between the blocks
+    std::vector<double> hostCapacities; //!< the CPU capacity per host
+
+    /*!
+     * The allowed imbalance: each host is loaded up to its share
+     * of the total cost times (1 + balanceSlack) by unpinned blocks.
+     */
+    double balanceSlack;
+};
+
+/*!
+ * Assign the blocks to hosts to minimize the rate of the flows between hosts,
+ * while keeping the CPU load of each host within its share of the capacity.
+ * The planner grows the placement greedily from the blocks with the best gain,
+ * and then moves single blocks while a move reduces the crossing rate.
+ * The result is deterministic for the same problem.
+ * \return the host index per block
+ */
+std::vector<size_t> planPlacement(const PlacementProblem &problem);
+
+//! The sum of the rates of the flows between different hosts
+double placementCrossingRate(const PlacementProblem &problem, const std::vector<size_t> &placement);
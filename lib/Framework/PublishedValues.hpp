@@ -0,0 +1,105 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <cstring> //memcpy
+#include <atomic>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+/*!
+ * A sequence lock around the values published by a block.
+ * The values are registered before the block runs,
+ * the block sets values during work(), and the worker flushes
+ * the set values as one snapshot when the work task returns.
+ * The single writer (the block thread context) never blocks,
+ * and readers retry until they copy a consistent set of values.
+ * Readers never acquire the actor or stall the work thread.
+ */
+class PublishedValues
+{
+public:
+    PublishedValues(void):
+        _seq(0),
+        _dirty(false)
+    {
+        return;
+    }
+
+    //! Add a value by name (before readers and the writer start)
+    void add(const std::string &name)
+    {
+        if (_indexes.count(name) != 0) return;
+        _indexes[name] = _words.size();
+        _words.emplace_back(toWord(0.0));
+        _pending.push_back(toWord(0.0));
+    }
+
+    //! Get the index of a value, or -1 when not registered
+    long find(const std::string &name) const
+    {
+        const auto it = _indexes.find(name);
+        if (it == _indexes.end()) return -1;
+        return long(it->second);
+    }
+
+    //! The registered names and indexes
+    const std::map<std::string, size_t> &indexes(void) const
+    {
+        return _indexes;
+    }
+
+    //! Set a new value, published upon flush() (single writer only)
+    void set(const size_t index, const double value)
+    {
+        _pending[index] = toWord(value);
+        _dirty = true;
+    }
+
+    //! Publish the set values as one snapshot (single writer only)
+    void flush(void)
+    {
+        if (not _dirty) return;
+        _dirty = false;
+        const auto seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq+1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < _pending.size(); i++) _words[i].store(_pending[i], std::memory_order_relaxed);
+        _seq.store(seq+2, std::memory_order_release);
+    }
+
+    //! Read a consistent copy of all values by index (any thread)
+    std::vector<double> read(void) const
+    {
+        std::vector<unsigned long long> words(_words.size());
+        while (true)
+        {
+            const auto seq0 = _seq.load(std::memory_order_acquire);
+            if ((seq0 & 1) != 0) continue; //write in progress
+            for (size_t i = 0; i < words.size(); i++) words[i] = _words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_seq.load(std::memory_order_relaxed) == seq0) break;
+        }
+        std::vector<double> values(words.size());
+        for (size_t i = 0; i < words.size(); i++) std::memcpy(&values[i], &words[i], sizeof(double));
+        return values;
+    }
+
+private:
+    static unsigned long long toWord(const double value)
+    {
+        unsigned long long word;
+        static_assert(sizeof(word) == sizeof(value), "double must be a 64-bit word");
+        std::memcpy(&word, &value, sizeof(word));
+        return word;
+    }
+
+    std::atomic<unsigned long long> _seq;
+    std::deque<std::atomic<unsigned long long>> _words; //stable addresses as values are added
+    std::vector<unsigned long long> _pending; //writer copy of the words
+    bool _dirty;
+    std::map<std::string, size_t> _indexes;
+};
@@ -0,0 +1,91 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <atomic>
+
+/*!
+ * A node in an intrusive ReadyTaskQueue.
+ * Queued objects inherit from this node.
+ */
+struct ReadyTaskNode
+{
+    ReadyTaskNode(void):
+        next(nullptr)
+    {
+        return;
+    }
+
+    std::atomic<ReadyTaskNode *> next;
+};
+
+/*!
+ * An intrusive lock-free multi-producer single-consumer queue.
+ * Any thread may push, but only one thread at a time may pop.
+ * The caller is responsible for serializing consumers,
+ * and for ensuring that a node is enqueued at most once.
+ */
+class ReadyTaskQueue
+{
+public:
+    ReadyTaskQueue(void):
+        _head(&_stub),
+        _tail(&_stub)
+    {
+        return;
+    }
+
+    //! Push a node into the queue (thread-safe for any producer)
+    void push(ReadyTaskNode *node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        auto prev = _head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /*!
+     * Pop a node from the queue (single consumer only).
+     * A null return may also indicate that a producer
+     * is mid-push, in which case the caller can retry later.
+     */
+    ReadyTaskNode *pop(void)
+    {
+        auto tail = _tail;
+        auto next = tail->next.load(std::memory_order_acquire);
+
+        //skip over the stub node
+        if (tail == &_stub)
+        {
+            if (next == nullptr) return nullptr;
+            _tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        //more nodes available, use the tail
+        if (next != nullptr)
+        {
+            _tail = next;
+            return tail;
+        }
+
+        //a producer is between the exchange and the link
+        if (tail != _head.load(std::memory_order_acquire)) return nullptr;
+
+        //re-insert the stub so the last node can be removed
+        this->push(&_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr)
+        {
+            _tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+private:
+    ReadyTaskNode _stub;
+    std::atomic<ReadyTaskNode *> _head;
+    ReadyTaskNode *_tail;
+};
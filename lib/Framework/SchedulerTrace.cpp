@@ -0,0 +1,163 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Framework/SchedulerTrace.hpp"
+#include <chrono>
+#include <deque>
+
+/***********************************************************************
+ * Stall reason names
+ **********************************************************************/
+const char *schedulerStallReasonName(const SchedulerStallReason reason)
+{
+    switch (reason)
+    {
+    case STALL_NONE: return "none";
+    case STALL_PREPARE: return "prepare";
+    case STALL_NO_TOKENS: return "noTokens";
+    case STALL_MESSAGES_FULL: return "messagesFull";
+    case STALL_NO_OUTPUT_BUFFER: return "noOutputBuffer";
+    case STALL_RESERVE: return "reserve";
+    case NUM_STALL_REASONS: break;
+    }
+    return "unknown";
+}
+
+/***********************************************************************
+ * Trace ring implementation
+ **********************************************************************/
+SchedulerTraceRing::SchedulerTraceRing(const size_t index):
+    index(index),
+    _slots(new Slot[CAPACITY]),
+    _head(0)
+{
+    for (size_t i = 0; i < CAPACITY; i++) _slots[i].seq.store(0, std::memory_order_relaxed);
+}
+
+std::vector<SchedulerTraceRecord> SchedulerTraceRing::snapshot(const void *actor) const
+{
+    std::vector<SchedulerTraceRecord> records;
+    const auto head = _head.load(std::memory_order_acquire);
+    const auto begin = (head > CAPACITY)?(head - CAPACITY):0;
+    for (auto i = begin; i < head; i++)
+    {
+        const auto &slot = _slots[i & (CAPACITY-1)];
+        const auto seq0 = slot.seq.load(std::memory_order_acquire);
+        if (seq0 != 2*i+2) continue; //overwritten or in progress
+        if (slot.actor.load(std::memory_order_relaxed) != actor) continue;
+        SchedulerTraceRecord record;
+        record.timeNs = slot.timeNs.load(std::memory_order_relaxed);
+        record.actor = actor;
+        const auto code = slot.code.load(std::memory_order_relaxed);
+        record.event = SchedulerTraceEvent(code >> 16);
+        record.reason = SchedulerStallReason(code & 0xffff);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq0) continue; //overwritten while reading
+        records.push_back(record);
+    }
+    return records;
+}
+
+std::string SchedulerTraceRing::name(void) const
+{
+    std::lock_guard<std::mutex> lock(_nameMutex);
+    return _name;
+}
+
+void SchedulerTraceRing::setName(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(_nameMutex);
+    _name = name;
+}
+
+uint64_t SchedulerTraceRing::nowNs(void)
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/***********************************************************************
+ * Global registry of the per-thread rings
+ **********************************************************************/
+static const size_t MaxExitedRings = 64;
+
+struct SchedulerTraceRegistry
+{
+    std::mutex mutex;
+    size_t nextIndex;
+    std::vector<std::shared_ptr<SchedulerTraceRing>> active;
+    std::deque<std::shared_ptr<SchedulerTraceRing>> exited;
+
+    SchedulerTraceRegistry(void):
+        nextIndex(0)
+    {
+        return;
+    }
+};
+
+static SchedulerTraceRegistry &getSchedulerTraceRegistry(void)
+{
+    static SchedulerTraceRegistry registry;
+    return registry;
+}
+
+/*!
+ * The calling thread's ring and name:
+ * The ring is moved to the exited list when the thread exits.
+ */
+struct SchedulerTraceThreadState
+{
+    std::shared_ptr<SchedulerTraceRing> ring;
+    std::string name;
+
+    ~SchedulerTraceThreadState(void)
+    {
+        if (not ring) return;
+        auto &registry = getSchedulerTraceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (auto it = registry.active.begin(); it != registry.active.end(); ++it)
+        {
+            if (*it != ring) continue;
+            registry.active.erase(it);
+            break;
+        }
+        registry.exited.push_back(ring);
+        if (registry.exited.size() > MaxExitedRings) registry.exited.pop_front();
+    }
+};
+
+static SchedulerTraceThreadState &getSchedulerTraceThreadState(void)
+{
+    static thread_local SchedulerTraceThreadState state;
+    return state;
+}
+
+void schedulerTraceRecord(const void *actor, const SchedulerTraceEvent event, const SchedulerStallReason reason)
+{
+    auto &state = getSchedulerTraceThreadState();
+    if (not state.ring)
+    {
+        auto &registry = getSchedulerTraceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        state.ring.reset(new SchedulerTraceRing(registry.nextIndex++));
+        state.ring->setName(state.name.empty()?("thread "+std::to_string(state.ring->index)):state.name);
+        registry.active.push_back(state.ring);
+    }
+    state.ring->record(actor, event, reason);
+}
+
+void schedulerTraceSetThreadName(const std::string &name)
+{
+    auto &state = getSchedulerTraceThreadState();
+    state.name = name;
+    if (state.ring) state.ring->setName(name);
+}
+
+std::vector<std::shared_ptr<SchedulerTraceRing>> schedulerTraceRings(void)
+{
+    auto &registry = getSchedulerTraceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<std::shared_ptr<SchedulerTraceRing>> rings(registry.exited.begin(), registry.exited.end());
+    rings.insert(rings.end(), registry.active.begin(), registry.active.end());
+    return rings;
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//! The kind of event in a scheduler trace record
+enum SchedulerTraceEvent
+{
+    TRACE_TASK_BEGIN, //!< a worker thread entered the actor's task
+    TRACE_TASK_END, //!< a worker thread left the actor's task
+    TRACE_STALL, //!< the task returned without calling work()
+    TRACE_WAKE, //!< another context flagged a change on the actor
+    TRACE_CALL_BEGIN, //!< an external call acquired the actor
+    TRACE_CALL_END, //!< an external call released the actor
+};
+
+//! The reason that a task returned without calling work()
+enum SchedulerStallReason
+{
+    STALL_NONE,
+    STALL_PREPARE, //!< the block's prepare() returned false
+    STALL_NO_TOKENS, //!< an output token manager was empty
+    STALL_MESSAGES_FULL, //!< a downstream message queue was full
+    STALL_NO_OUTPUT_BUFFER, //!< an output had no buffer from the manager
+    STALL_RESERVE, //!< no input reserve was reached and no messages
+    NUM_STALL_REASONS
+};
+
+//! Get a short name for the stall reason for display
+const char *schedulerStallReasonName(const SchedulerStallReason reason);
+
+//! A decoded scheduler trace record
+struct SchedulerTraceRecord
+{
+    uint64_t timeNs;
+    const void *actor;
+    SchedulerTraceEvent event;
+    SchedulerStallReason reason;
+};
+
+/*!
+ * A fixed-size ring of trace records written by a single thread.
+ * Each thread records into its own ring without locking,
+ * the oldest records are overwritten once the ring is full.
+ * Readers copy the records with a sequence check per slot,
+ * so a record that is overwritten while reading is skipped.
+ */
+class SchedulerTraceRing
+{
+public:
+    //! The number of records held per thread
+    static const size_t CAPACITY = 1 << 14;
+
+    SchedulerTraceRing(const size_t index);
+
+    //! Record an event (only called from the owning thread)
+    void record(const void *actor, const SchedulerTraceEvent event, const SchedulerStallReason reason)
+    {
+        const auto i = _head.load(std::memory_order_relaxed);
+        auto &slot = _slots[i & (CAPACITY-1)];
+        slot.seq.store(2*i+1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timeNs.store(nowNs(), std::memory_order_relaxed);
+        slot.actor.store(actor, std::memory_order_relaxed);
+        slot.code.store((uint32_t(event) << 16) | uint32_t(reason), std::memory_order_relaxed);
+        slot.seq.store(2*i+2, std::memory_order_release);
+        _head.store(i+1, std::memory_order_release);
+    }
+
+    //! Copy the records for an actor in the order they were recorded
+    std::vector<SchedulerTraceRecord> snapshot(const void *actor) const;
+
+    //! The index of this ring, used as the thread id in the trace
+    const size_t index;
+
+    //! Get the name of the owning thread
+    std::string name(void) const;
+
+    //! Set the name of the owning thread
+    void setName(const std::string &name);
+
+    //! The steady clock time in nanoseconds
+    static uint64_t nowNs(void);
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> timeNs;
+        std::atomic<const void *> actor;
+        std::atomic<uint32_t> code;
+    };
+    std::unique_ptr<Slot[]> _slots;
+    std::atomic<uint64_t> _head;
+    mutable std::mutex _nameMutex;
+    std::string _name;
+};
+
+/*!
+ * Record an event into the calling thread's trace ring.
+ * The ring is created when the thread records the first event.
+ */
+void schedulerTraceRecord(const void *actor, const SchedulerTraceEvent event, const SchedulerStallReason reason = STALL_NONE);
+
+/*!
+ * Set a descriptive name for the calling thread in the trace.
+ * The name is kept even when the thread never records an event.
+ */
+void schedulerTraceSetThreadName(const std::string &name);
+
+/*!
+ * Get all trace rings in this process.
+ * The rings of exited threads are kept until a limited number
+ * of exited threads accumulate, then the oldest are dropped.
+ */
+std::vector<std::shared_ptr<SchedulerTraceRing>> schedulerTraceRings(void);
@@ -1,11 +1,19 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/SharedBuffer.hpp>
+#include <Pothos/Framework/MemoryAccount.hpp>
 #include <Pothos/Framework/Exception.hpp>
+#include "Framework/SlabAllocator.hpp"
+#include <Poco/Logger.h>
 #include <algorithm> //min/max
 #include <mutex>
 
+//platform specific page locking implemented in SharedBufferUnix/Windows.cpp
+bool sharedBufferLockPages(const size_t address, const size_t length);
+void sharedBufferUnlockPages(const size_t address, const size_t length);
+size_t sharedBufferPageSize(void);
+
 /***********************************************************************
  * shared buffer implementation
  **********************************************************************/
@@ -39,6 +47,30 @@ Pothos::SharedBuffer::SharedBuffer(const size_t address, const size_t length, co
     }
 }
 
+/***********************************************************************
+ * memory accounting: the charge is released after the memory is freed
+ **********************************************************************/
+static Pothos::SharedBuffer makeAccounted(const Pothos::SharedBuffer &buff, const std::string &type, const long nodeAffinity)
+{
+    auto container = makeSlabShared<std::pair<std::shared_ptr<void>, std::shared_ptr<void>>>(
+        Pothos::MemoryAccount::charge(buff.getLength(), type, nodeAffinity),
+        buff.getContainer());
+    Pothos::SharedBuffer accounted(buff.getAddress(), buff.getLength(), container);
+    accounted.setAlias(buff.getAlias());
+    return accounted;
+}
+
+Pothos::SharedBuffer Pothos::SharedBuffer::make(const size_t numBytes, const long nodeAffinity, const size_t hugePageSize)
+{
+    return makeAccounted(SharedBuffer::makeUnaccounted(numBytes, nodeAffinity, hugePageSize),
+        (hugePageSize == 0)?"generic":"hugepage", nodeAffinity);
+}
+
+Pothos::SharedBuffer Pothos::SharedBuffer::makeNamed(const std::string &name, const size_t numBytes, const bool create)
+{
+    return makeAccounted(SharedBuffer::makeNamedUnaccounted(name, numBytes, create), "named", -1);
+}
+
 /***********************************************************************
  * circular buffer implementation
  **********************************************************************/
@@ -48,7 +80,7 @@ static std::mutex &getCircMutex(void)
     return mutex;
 }
 
-Pothos::SharedBuffer Pothos::SharedBuffer::makeCirc(const size_t numBytes, const long nodeAffinity)
+Pothos::SharedBuffer Pothos::SharedBuffer::makeCirc(const size_t numBytes, const long nodeAffinity, const size_t hugePageSize)
 {
     //circular buffer implementations form a natural race condition
     //combine a mutex with retry logic to ensure the call succeeds
@@ -56,16 +88,103 @@ Pothos::SharedBuffer Pothos::SharedBuffer::makeCirc(const size_t numBytes, const
     for (size_t i = 0; i < numRetries; i++)
     {
         std::lock_guard<std::mutex> lock(getCircMutex());
+        SharedBuffer buff;
         try
         {
-            SharedBuffer buff = SharedBuffer::makeCircUnprotected(numBytes, nodeAffinity);
+            buff = SharedBuffer::makeCircUnprotected(numBytes, nodeAffinity, hugePageSize);
             buff._alias = buff.getAddress() + buff.getLength();
-            return buff;
         }
         catch(const SharedBufferError &ex)
         {
             if (i == numRetries-1) throw ex;
+            continue;
         }
+
+        //a budget error is not retried
+        return makeAccounted(buff, "circular", nodeAffinity);
     }
     throw SharedBufferError("Pothos::SharedBuffer::makeCirc()", "invalid code path");
 }
+
+Pothos::SharedBuffer Pothos::SharedBuffer::makeCircNamed(const std::string &name, const size_t numBytes, const bool create)
+{
+    //same retry logic as makeCirc() for the double mapping
+    const size_t numRetries = 7;
+    for (size_t i = 0; i < numRetries; i++)
+    {
+        std::lock_guard<std::mutex> lock(getCircMutex());
+        SharedBuffer buff;
+        try
+        {
+            buff = SharedBuffer::makeCircNamedUnprotected(name, numBytes, create);
+            buff._alias = buff.getAddress() + buff.getLength();
+        }
+        catch(const SharedBufferError &ex)
+        {
+            if (i == numRetries-1) throw ex;
+            continue;
+        }
+
+        //a budget error is not retried
+        return makeAccounted(buff, "named", -1);
+    }
+    throw SharedBufferError("Pothos::SharedBuffer::makeCircNamed()", "invalid code path");
+}
+
+/***********************************************************************
+ * memory locking and pre-faulting
+ **********************************************************************/
+class LockedBufferContainer
+{
+public:
+    LockedBufferContainer(const Pothos::SharedBuffer &buffer):
+        _buffer(buffer),
+        _addressLocked(false),
+        _aliasLocked(false)
+    {
+        _addressLocked = sharedBufferLockPages(_buffer.getAddress(), _buffer.getLength());
+        if (_buffer.getAlias() != 0) _aliasLocked = sharedBufferLockPages(_buffer.getAlias(), _buffer.getLength());
+    }
+
+    ~LockedBufferContainer(void)
+    {
+        if (_aliasLocked) sharedBufferUnlockPages(_buffer.getAlias(), _buffer.getLength());
+        if (_addressLocked) sharedBufferUnlockPages(_buffer.getAddress(), _buffer.getLength());
+    }
+
+    bool locked(void) const
+    {
+        return _addressLocked and (_buffer.getAlias() == 0 or _aliasLocked);
+    }
+
+private:
+    const Pothos::SharedBuffer _buffer; //holds a reference to the memory
+    bool _addressLocked;
+    bool _aliasLocked;
+};
+
+Pothos::SharedBuffer Pothos::SharedBuffer::lockMemory(void) const
+{
+    std::shared_ptr<LockedBufferContainer> container(new LockedBufferContainer(*this));
+    if (not container->locked()) poco_warning_f1(Poco::Logger::get("Pothos.SharedBuffer.lockMemory"),
+        "Failed to lock %z bytes of memory - check the locked memory limits", _length);
+
+    SharedBuffer buff(_address, _length, container);
+    buff._alias = _alias;
+    return buff;
+}
+
+static void prefaultPages(const size_t address, const size_t length)
+{
+    //read and write back so the pages are faulted in as writable
+    auto p = reinterpret_cast<volatile char *>(address);
+    const size_t pageSize = sharedBufferPageSize();
+    for (size_t i = 0; i < length; i += pageSize) p[i] = p[i];
+    if (length != 0) p[length-1] = p[length-1];
+}
+
+void Pothos::SharedBuffer::prefaultMemory(void) const
+{
+    prefaultPages(_address, _length);
+    if (_alias != 0) prefaultPages(_alias, _length);
+}
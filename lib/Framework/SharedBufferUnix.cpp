@@ -1,28 +1,33 @@
-// Copyright (c) 2013-2015 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/SharedBuffer.hpp>
 #include <Pothos/Framework/Exception.hpp>
+#include "Framework/MappedFile.hpp"
+#include "Framework/SlabAllocator.hpp"
 #include <Poco/TemporaryFile.h>
 #include <Poco/Format.h>
 #include <cassert>
+#include <algorithm> //min
 #include <fcntl.h> //open
 #include <unistd.h> //close
 #include <cerrno> //errno
 #include <cstring> //strerror
 #include <sys/mman.h> //mmap
+#include <sys/stat.h> //fstat
 
 //MAP_ANON is deprecated - this supports older headers
 #ifndef MAP_ANONYMOUS
 #define MAP_ANONYMOUS MAP_ANON
 #endif
 
-#if HAVE_LIBNUMA
-#include <numa.h>
+//huge page size encoding for MAP_HUGETLB and MFD_HUGETLB flags
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
 #endif
 
-#ifdef __FreeBSD__
-#include <sys/stat.h>
+#if HAVE_LIBNUMA
+#include <numa.h>
 #endif
 
 /***********************************************************************
@@ -91,12 +96,74 @@ private:
 };
 
 /***********************************************************************
- * numa allocator for an affinitized memory slab
+ * huge page helpers
+ **********************************************************************/
+static size_t roundUpToPageSize(const size_t numBytes, const size_t pageSize)
+{
+    return ((numBytes + pageSize - 1)/pageSize)*pageSize;
+}
+
+//encode the log2 of the page size into the flags (0 for the system default)
+static int hugePageSizeFlags(const size_t hugePageSize)
+{
+    int log2 = 0;
+    while ((size_t(1) << log2) < hugePageSize) log2++;
+    if ((size_t(1) << log2) != hugePageSize) return 0;
+    return log2 << MAP_HUGE_SHIFT;
+}
+
+/***********************************************************************
+ * huge page allocator for a generic memory slab
+ **********************************************************************/
+class HugePageBufferContainer
+{
+public:
+    HugePageBufferContainer(const size_t numBytes, const long nodeAffinity, const size_t hugePageSize):
+        _mem(MAP_FAILED),
+        _len(roundUpToPageSize(numBytes, hugePageSize))
+    {
+        #ifdef MAP_HUGETLB
+        if (_len == 0) return;
+        _mem = mmap(nullptr, _len,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | hugePageSizeFlags(hugePageSize),
+            -1, off_t(0));
+        #endif
+
+        #if HAVE_LIBNUMA
+        //bind before the first touch so pages fault in on the node
+        if (_mem != MAP_FAILED and nodeAffinity >= 0 and numa_available() != -1)
+        {
+            numa_tonode_memory(_mem, _len, nodeAffinity);
+        }
+        #else
+        (void)nodeAffinity;
+        #endif
+    }
+
+    ~HugePageBufferContainer(void)
+    {
+        if (_mem != MAP_FAILED) munmap(_mem, _len);
+    }
+
+    //address is 0 when huge pages are not available
+    size_t getAddress(void) const
+    {
+        return (_mem == MAP_FAILED)?0:size_t(_mem);
+    }
+
+private:
+    void *_mem;
+    size_t _len;
+};
+
+/***********************************************************************
+ * circular allocator using a double mapping of the memory
  **********************************************************************/
 class CircularBufferContainer
 {
 public:
-    CircularBufferContainer(const size_t numBytes);
+    CircularBufferContainer(const size_t numBytes, const size_t hugePageSize, const int memFd = -1);
     ~CircularBufferContainer(void)
     {
         this->cleanup();
@@ -139,7 +206,7 @@ private:
     void *mapPtr1;
 };
 
-CircularBufferContainer::CircularBufferContainer(const size_t numBytes):
+CircularBufferContainer::CircularBufferContainer(const size_t numBytes, const size_t hugePageSize, const int memFd):
     _numBytes(numBytes),
     virtualAddr2X(nullptr),
     tmpFd(-1),
@@ -150,29 +217,56 @@ CircularBufferContainer::CircularBufferContainer(const size_t numBytes):
 
     /*******************************************************************
      * Step 1) open a temp file for physical memory
+     * (or use a copy of the caller's descriptor for named memory)
      ******************************************************************/
-    Poco::TemporaryFile tmpFile;
-    tmpFd = open(
-        tmpFile.path().c_str(),
-        O_RDWR | O_CREAT | O_EXCL,
-        S_IRUSR | S_IWUSR);
-    if (tmpFd < 0) this->errorOut("open("+ tmpFile.path() +")");
-
-    ret = ftruncate(tmpFd, numBytes*2);
-    if (ret != 0) this->errorOut("ftruncate("+ tmpFile.path() +")");
+    if (memFd >= 0)
+    {
+        tmpFd = dup(memFd);
+        if (tmpFd < 0) this->errorOut("dup()");
+    }
+    else if (hugePageSize != 0)
+    {
+        #if defined(MFD_HUGETLB)
+        tmpFd = memfd_create("PothosCircularBuffer", MFD_CLOEXEC | MFD_HUGETLB | hugePageSizeFlags(hugePageSize));
+        if (tmpFd < 0) this->errorOut("memfd_create()");
+
+        ret = ftruncate(tmpFd, numBytes);
+        if (ret != 0) this->errorOut("ftruncate(memfd)");
+        #else
+        errno = ENOTSUP;
+        this->errorOut("memfd_create()");
+        #endif
+    }
+    else
+    {
+        Poco::TemporaryFile tmpFile;
+        tmpFd = open(
+            tmpFile.path().c_str(),
+            O_RDWR | O_CREAT | O_EXCL,
+            S_IRUSR | S_IWUSR);
+        if (tmpFd < 0) this->errorOut("open("+ tmpFile.path() +")");
+
+        ret = ftruncate(tmpFd, numBytes*2);
+        if (ret != 0) this->errorOut("ftruncate("+ tmpFile.path() +")");
+    }
 
     /*******************************************************************
      * Step 2) find a 2X chunk of virtual memory
+     * huge page mappings must start on a huge page boundary,
+     * so reserve extra space to align the start of the 2X chunk
      ******************************************************************/
-    virtualAddr2X = mmap(
+    const size_t reserveBytes = numBytes*2 + hugePageSize;
+    void *reserveAddr = mmap(
         nullptr,
-        numBytes*2,
+        reserveBytes,
         PROT_NONE,
         MAP_PRIVATE | MAP_ANONYMOUS,
         -1, off_t(0));
-    if (virtualAddr2X == MAP_FAILED) this->errorOut("mmap(2x)");
+    if (reserveAddr == MAP_FAILED) this->errorOut("mmap(2x)");
+    virtualAddr2X = reserveAddr;
+    if (hugePageSize != 0) virtualAddr2X = (void *)roundUpToPageSize(size_t(reserveAddr), hugePageSize);
 
-    ret = munmap(virtualAddr2X, numBytes*2);
+    ret = munmap(reserveAddr, reserveBytes);
     if (ret != 0) this->errorOut("munmap(2x)");
 
     /*******************************************************************
@@ -193,20 +287,148 @@ CircularBufferContainer::CircularBufferContainer(const size_t numBytes):
         MAP_SHARED,
         tmpFd, off_t(0));
     if (mapPtr1 == MAP_FAILED) this->errorOut("mmap(1)");
+
+    //the address hints may not be honored when another thread maps memory
+    if (mapPtr0 != virtualAddr2X or mapPtr1 != (void *)(size_t(virtualAddr2X) + numBytes))
+    {
+        errno = EADDRINUSE;
+        this->errorOut("mmap(hint)");
+    }
 }
 
+/***********************************************************************
+ * named shared memory object for cross-process buffers
+ **********************************************************************/
+class NamedMemoryObject
+{
+public:
+    NamedMemoryObject(const std::string &name, const size_t numBytes, const bool create):
+        fd(-1),
+        _path("/"+name),
+        _linked(false)
+    {
+        fd = shm_open(_path.c_str(), create?(O_RDWR | O_CREAT | O_EXCL):O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd < 0) this->errorOut("shm_open("+_path+")");
+        _linked = create;
+
+        if (create and ftruncate(fd, numBytes) != 0) this->errorOut("ftruncate("+_path+")");
+
+        //the opener must not map past the end of the creator's memory
+        struct stat st;
+        if (fstat(fd, &st) != 0) this->errorOut("fstat("+_path+")");
+        if (size_t(st.st_size) < numBytes)
+        {
+            errno = EINVAL;
+            this->errorOut("fstat("+_path+")");
+        }
+    }
+
+    ~NamedMemoryObject(void)
+    {
+        this->cleanup();
+    }
+
+    int fd;
+
+private:
+    void errorOut(const std::string &what)
+    {
+        const int errnoSave = errno;
+        this->cleanup();
+        throw Pothos::SharedBufferError(
+            "Pothos::NamedMemoryObject::"+what,
+            Poco::format("errno %d - %s", errnoSave, std::string(strerror(errnoSave))));
+    }
+
+    void cleanup(void)
+    {
+        if (fd >= 0) close(fd);
+        fd = -1;
+
+        //only the creator removes the name
+        if (_linked) shm_unlink(_path.c_str());
+        _linked = false;
+    }
+
+    const std::string _path;
+    bool _linked;
+};
+
+class NamedBufferContainer
+{
+public:
+    NamedBufferContainer(const std::string &name, const size_t numBytes, const bool create):
+        _object(name, numBytes, create),
+        _mem(MAP_FAILED),
+        _len(numBytes)
+    {
+        if (_len == 0) return;
+        _mem = mmap(nullptr, _len, PROT_READ | PROT_WRITE, MAP_SHARED, _object.fd, off_t(0));
+        if (_mem == MAP_FAILED)
+        {
+            const int errnoSave = errno;
+            throw Pothos::SharedBufferError(
+                "Pothos::NamedBufferContainer::mmap("+name+")",
+                Poco::format("errno %d - %s", errnoSave, std::string(strerror(errnoSave))));
+        }
+    }
+
+    ~NamedBufferContainer(void)
+    {
+        if (_mem != MAP_FAILED) munmap(_mem, _len);
+    }
+
+    size_t getAddress(void) const
+    {
+        return (_mem == MAP_FAILED)?0:size_t(_mem);
+    }
+
+private:
+    NamedMemoryObject _object;
+    void *_mem;
+    size_t _len;
+};
+
+class NamedCircularBufferContainer
+{
+public:
+    NamedCircularBufferContainer(const std::string &name, const size_t numBytes, const bool create):
+        _object(name, numBytes, create),
+        _circ(numBytes, 0, _object.fd)
+    {
+        return;
+    }
+
+    size_t getAddress(void) const
+    {
+        return _circ.getAddress();
+    }
+
+private:
+    NamedMemoryObject _object;
+    CircularBufferContainer _circ;
+};
+
 /***********************************************************************
  * shared buffer implementation
  **********************************************************************/
-Pothos::SharedBuffer Pothos::SharedBuffer::make(const size_t numBytes, const long nodeAffinity)
+Pothos::SharedBuffer Pothos::SharedBuffer::makeUnaccounted(const size_t numBytes, const long nodeAffinity, const size_t hugePageSize)
 {
     size_t address = 0;
     std::shared_ptr<void> deleter;
 
+    //huge pages requested, perform allocation with huge pages
+    if (hugePageSize != 0)
+    {
+        auto sharedAlloc = makeSlabShared<HugePageBufferContainer>(numBytes, nodeAffinity, hugePageSize);
+        address = sharedAlloc->getAddress();
+        deleter = sharedAlloc;
+    }
+
     //node affinity specified, perform allocation on node
-    if (nodeAffinity >= 0)
+    if (address == 0 and nodeAffinity >= 0)
     {
-        std::shared_ptr<GenericBufferContainerNuma> sharedAlloc(new GenericBufferContainerNuma(numBytes, nodeAffinity));
+        auto sharedAlloc = makeSlabShared<GenericBufferContainerNuma>(numBytes, nodeAffinity);
         address = sharedAlloc->getAddress();
         deleter = sharedAlloc;
     }
@@ -214,7 +436,7 @@ Pothos::SharedBuffer Pothos::SharedBuffer::make(const size_t numBytes, const lon
     //address is 0 when numa alloc is not run or it fails
     if (address == 0)
     {
-        std::shared_ptr<GenericBufferContainer> sharedAlloc(new GenericBufferContainer(numBytes));
+        auto sharedAlloc = makeSlabShared<GenericBufferContainer>(numBytes);
         address = sharedAlloc->getAddress();
         deleter = sharedAlloc;
     }
@@ -222,9 +444,174 @@ Pothos::SharedBuffer Pothos::SharedBuffer::make(const size_t numBytes, const lon
     return SharedBuffer(address, numBytes, deleter);
 }
 
-Pothos::SharedBuffer Pothos::SharedBuffer::makeCircUnprotected(const size_t numBytesIn, const long)
+Pothos::SharedBuffer Pothos::SharedBuffer::makeCircUnprotected(const size_t numBytesIn, const long, const size_t hugePageSize)
 {
-    const size_t numBytes = ((numBytesIn + getpagesize() - 1)/getpagesize())*getpagesize();
-    std::shared_ptr<CircularBufferContainer> container(new CircularBufferContainer(numBytes));
+    //try huge pages first and quietly fall back to normal pages
+    if (hugePageSize != 0) try
+    {
+        const size_t numBytes = roundUpToPageSize(numBytesIn, hugePageSize);
+        std::shared_ptr<CircularBufferContainer> container(new CircularBufferContainer(numBytes, hugePageSize));
+        return SharedBuffer(container->getAddress(), numBytes, container);
+    }
+    catch (const Pothos::SharedBufferError &){}
+
+    const size_t numBytes = roundUpToPageSize(numBytesIn, getpagesize());
+    std::shared_ptr<CircularBufferContainer> container(new CircularBufferContainer(numBytes, 0));
     return SharedBuffer(container->getAddress(), numBytes, container);
 }
+
+Pothos::SharedBuffer Pothos::SharedBuffer::makeNamedUnaccounted(const std::string &name, const size_t numBytes, const bool create)
+{
+    std::shared_ptr<NamedBufferContainer> container(new NamedBufferContainer(name, numBytes, create));
+    return SharedBuffer(container->getAddress(), numBytes, container);
+}
+
+Pothos::SharedBuffer Pothos::SharedBuffer::makeCircNamedUnprotected(const std::string &name, const size_t numBytesIn, const bool create)
+{
+    const size_t numBytes = roundUpToPageSize(numBytesIn, getpagesize());
+    std::shared_ptr<NamedCircularBufferContainer> container(new NamedCircularBufferContainer(name, numBytes, create));
+    return SharedBuffer(container->getAddress(), numBytes, container);
+}
+
+/***********************************************************************
+ * memory mapped file implementation
+ **********************************************************************/
+class MappedFileWindow
+{
+public:
+    MappedFileWindow(const MappedFile::Sptr &file, void *mem, const size_t len):
+        _file(file),
+        _mem(mem),
+        _len(len)
+    {
+        return;
+    }
+
+    ~MappedFileWindow(void)
+    {
+        munmap(_mem, _len);
+    }
+
+private:
+    MappedFile::Sptr _file; //keep the file open while mapped
+    void *_mem;
+    size_t _len;
+};
+
+MappedFile::MappedFile(const std::string &path, const bool write):
+    _path(path),
+    _write(write),
+    _handle(-1),
+    _size(0),
+    _finalSize(0)
+{
+    const int fd = ::open(path.c_str(), write?(O_RDWR | O_CREAT | O_TRUNC):O_RDONLY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd < 0) this->errorOut("open("+path+")");
+    _handle = fd;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) this->errorOut("fstat("+path+")");
+    _size = (unsigned long long)(st.st_size);
+}
+
+MappedFile::~MappedFile(void)
+{
+    if (_handle < 0) return;
+
+    //remove the unused space of the last window, failure leaves a longer file
+    if (_write)
+    {
+        const int ret = ftruncate(int(_handle), off_t(_finalSize));
+        (void)ret;
+    }
+    close(int(_handle));
+}
+
+MappedFile::Sptr MappedFile::open(const std::string &path, const bool write)
+{
+    return Sptr(new MappedFile(path, write));
+}
+
+void MappedFile::errorOut(const std::string &what)
+{
+    const int errnoSave = errno;
+    if (_handle >= 0) close(int(_handle));
+    _handle = -1;
+    throw Pothos::SharedBufferError(
+        "Pothos::MappedFile::"+what,
+        Poco::format("errno %d - %s", errnoSave, std::string(strerror(errnoSave))));
+}
+
+size_t MappedFile::alignment(void)
+{
+    return getpagesize();
+}
+
+unsigned long long MappedFile::size(void) const
+{
+    return _size;
+}
+
+Pothos::SharedBuffer MappedFile::map(const unsigned long long offset, const size_t numBytesIn)
+{
+    assert(offset % alignment() == 0);
+    size_t numBytes = numBytesIn;
+
+    //pages past the end of the file cannot be accessed
+    if (not _write and offset >= _size) return Pothos::SharedBuffer::null();
+    if (not _write) numBytes = size_t(std::min<unsigned long long>(numBytes, _size-offset));
+    if (_write and offset+numBytes > _size)
+    {
+        if (ftruncate(int(_handle), off_t(offset+numBytes)) != 0) this->errorOut("ftruncate("+_path+")");
+        _size = offset+numBytes;
+    }
+    if (numBytes == 0) return Pothos::SharedBuffer::null();
+
+    //private mappings of the reader are copy-on-write and never change the file
+    void *mem = mmap(nullptr, numBytes,
+        PROT_READ | PROT_WRITE, _write?MAP_SHARED:MAP_PRIVATE,
+        int(_handle), off_t(offset));
+    if (mem == MAP_FAILED)
+    {
+        const int errnoSave = errno;
+        throw Pothos::SharedBufferError(
+            "Pothos::MappedFile::mmap("+_path+")",
+            Poco::format("errno %d - %s", errnoSave, std::string(strerror(errnoSave))));
+    }
+
+    //read ahead of the reader, and free pages behind both reader and writer
+    madvise(mem, numBytes, MADV_SEQUENTIAL);
+    if (not _write) madvise(mem, numBytes, MADV_WILLNEED);
+
+    std::shared_ptr<MappedFileWindow> container(new MappedFileWindow(this->shared_from_this(), mem, numBytes));
+    return Pothos::SharedBuffer(size_t(mem), numBytes, container);
+}
+
+void MappedFile::flush(const Pothos::SharedBuffer &window)
+{
+    if (not _write or window.getLength() == 0) return;
+    msync((void *)window.getAddress(), window.getLength(), MS_ASYNC);
+}
+
+void MappedFile::setFinalSize(const unsigned long long finalSize)
+{
+    _finalSize = finalSize;
+}
+
+/***********************************************************************
+ * page locking implementation
+ **********************************************************************/
+bool sharedBufferLockPages(const size_t address, const size_t length)
+{
+    return mlock((const void *)address, length) == 0;
+}
+
+void sharedBufferUnlockPages(const size_t address, const size_t length)
+{
+    munlock((const void *)address, length);
+}
+
+size_t sharedBufferPageSize(void)
+{
+    return getpagesize();
+}
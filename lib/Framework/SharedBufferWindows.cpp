@@ -1,16 +1,32 @@
-// Copyright (c) 2013-2015 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/SharedBuffer.hpp>
 #include <Pothos/Framework/Exception.hpp>
+#include "Framework/MappedFile.hpp"
+#include "Framework/SlabAllocator.hpp"
 #include <Poco/Format.h>
 #include <windows.h>
 #include <algorithm> //min/max
+#include <cassert>
 
 //delay loaded symbols for windows backwards compatibility
 LPVOID DL_VirtualAllocExNuma(HANDLE hProcess, LPVOID lpAddress, SIZE_T dwSize, DWORD flAllocationType, DWORD flProtect, DWORD nndPreferred);
 HANDLE DL_CreateFileMappingNuma(HANDLE hFile, LPSECURITY_ATTRIBUTES lpFileMappingAttributes, DWORD flProtect, DWORD dwMaximumSizeHigh, DWORD dwMaximumSizeLow, LPCTSTR lpName, DWORD nndPreferred);
 LPVOID DL_MapViewOfFileExNuma(HANDLE hFileMappingObject, DWORD dwDesiredAccess, DWORD dwFileOffsetHigh, DWORD dwFileOffsetLow, SIZE_T dwNumberOfBytesToMap, LPVOID lpBaseAddress, DWORD nndPreferred);
+PVOID DL_VirtualAlloc2(HANDLE Process, PVOID BaseAddress, SIZE_T Size, ULONG AllocationType, ULONG PageProtection);
+PVOID DL_MapViewOfFile3(HANDLE FileMapping, HANDLE Process, PVOID BaseAddress, ULONG64 Offset, SIZE_T ViewSize, ULONG AllocationType, ULONG PageProtection);
+
+//placeholder flags for older SDKs
+#ifndef MEM_RESERVE_PLACEHOLDER
+#define MEM_RESERVE_PLACEHOLDER 0x00040000
+#endif
+#ifndef MEM_REPLACE_PLACEHOLDER
+#define MEM_REPLACE_PLACEHOLDER 0x00004000
+#endif
+#ifndef MEM_PRESERVE_PLACEHOLDER
+#define MEM_PRESERVE_PLACEHOLDER 0x00000002
+#endif
 
 /***********************************************************************
  * GetSystemInfo configuration values
@@ -34,13 +50,45 @@ static long getregionsize (void) {
     return g_regionsize;
 }
 
+/***********************************************************************
+ * large pages require the lock memory privilege,
+ * the privilege is enabled once for the process token,
+ * the large page size is 0 when the privilege is not granted
+ **********************************************************************/
+static bool enableLockMemoryPrivilege(void)
+{
+    HANDLE hToken = nullptr;
+    if (not OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &hToken)) return false;
+
+    TOKEN_PRIVILEGES privileges;
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool ok = LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) != 0;
+    ok = ok and AdjustTokenPrivileges(hToken, FALSE, &privileges, 0, nullptr, nullptr) != 0;
+    ok = ok and GetLastError() != ERROR_NOT_ALL_ASSIGNED;
+    CloseHandle(hToken);
+    return ok;
+}
+
+static size_t getlargepagesize(void) {
+    static const size_t g_largepagesize = enableLockMemoryPrivilege()?GetLargePageMinimum():0;
+    return g_largepagesize;
+}
+
+//round up to a multiple of the page size, regions when the page size is 0
+static size_t roundUpPages(const size_t numBytes, const size_t pageSize)
+{
+    const size_t granularity = std::max<size_t>(getregionsize(), pageSize);
+    return ((numBytes + granularity - 1)/granularity)*granularity;
+}
+
 /***********************************************************************
  * generic allocation implementation
  **********************************************************************/
 class GenericBufferContainer
 {
 public:
-    GenericBufferContainer(const size_t numBytes, const long nodeAffinity):
+    GenericBufferContainer(const size_t numBytes, const long nodeAffinity, const bool largePages):
         virtualAddr(nullptr)
     {
         const DWORD nndPreferred = (nodeAffinity == -1)? NUMA_NO_PREFERRED_NODE : nodeAffinity;
@@ -49,7 +97,7 @@ public:
             GetCurrentProcess(),
             NULL,
             numBytes,
-            MEM_RESERVE | MEM_COMMIT,
+            MEM_RESERVE | MEM_COMMIT | (largePages?MEM_LARGE_PAGES:0),
             PAGE_READWRITE,
             nndPreferred
         );
@@ -74,11 +122,16 @@ private:
 
 /***********************************************************************
  * circular allocation implementation
+ * Placeholders (VirtualAlloc2 and MapViewOfFile3) reserve the 2X region
+ * and replace each half with a view, so another thread cannot take
+ * the address between the reservation and the mapping of the views.
+ * Systems without placeholders find a free 2X region, release it,
+ * and map the views into it, which can fail when the address is taken.
  **********************************************************************/
 class CircularBufferContainer
 {
 public:
-    CircularBufferContainer(const size_t numBytes, const long nodeAffinity);
+    CircularBufferContainer(const size_t numBytes, const long nodeAffinity, const std::string &name = "", const bool create = true, const size_t largePageSize = 0);
     ~CircularBufferContainer(void)
     {
         this->cleanup();
@@ -107,39 +160,126 @@ private:
         if (hMapViewOfFile0 != nullptr) UnmapViewOfFile(hMapViewOfFile0);
         hMapViewOfFile0 = nullptr;
 
+        for (auto &placeholder : placeholders)
+        {
+            if (placeholder != nullptr) VirtualFree(placeholder, 0, MEM_RELEASE);
+            placeholder = nullptr;
+        }
+
         if (hFileMappingObject != nullptr) CloseHandle(hFileMappingObject);
         hFileMappingObject = nullptr;
     }
 
+    bool mapPlaceholderViews(const size_t numBytes, const size_t largePageSize);
+    void mapReleasedViews(const size_t numBytes, const DWORD nndPreferred);
+
     LPVOID virtualAddr2X;
     HANDLE hFileMappingObject;
     LPVOID hMapViewOfFile0;
     LPVOID hMapViewOfFile1;
+    LPVOID placeholders[2]; //reserved halves which are not yet replaced by views
 };
 
-CircularBufferContainer::CircularBufferContainer(const size_t numBytes, const long nodeAffinity):
+CircularBufferContainer::CircularBufferContainer(const size_t numBytes, const long nodeAffinity, const std::string &name, const bool create, const size_t largePageSize):
     virtualAddr2X(nullptr),
     hFileMappingObject(nullptr),
     hMapViewOfFile0(nullptr),
     hMapViewOfFile1(nullptr)
 {
+    placeholders[0] = placeholders[1] = nullptr;
     const DWORD nndPreferred = (nodeAffinity == -1)? NUMA_NO_PREFERRED_NODE : nodeAffinity;
 
     /*******************************************************************
      * Step 1) get a chunk of physical memory
+     * (or open the named memory of another process)
      ******************************************************************/
-    hFileMappingObject = DL_CreateFileMappingNuma(
-        INVALID_HANDLE_VALUE,
-        nullptr, //default security descripto
-        PAGE_READWRITE, //rw mode
-        0, numBytes, //high, low size in bytes
-        nullptr, //no name
-        nndPreferred);
-    if (hFileMappingObject == nullptr) this->errorOut("CreateFileMappingNuma()");
+    if (not create)
+    {
+        hFileMappingObject = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+        if (hFileMappingObject == nullptr) this->errorOut("OpenFileMapping("+name+")");
+    }
+    else
+    {
+        hFileMappingObject = DL_CreateFileMappingNuma(
+            INVALID_HANDLE_VALUE,
+            nullptr, //default security descripto
+            PAGE_READWRITE | ((largePageSize != 0)?(SEC_COMMIT | SEC_LARGE_PAGES):0), //rw mode
+            0, numBytes, //high, low size in bytes
+            name.empty()?nullptr:name.c_str(),
+            nndPreferred);
+        if (hFileMappingObject == nullptr) this->errorOut("CreateFileMappingNuma()");
+        if (not name.empty() and GetLastError() == ERROR_ALREADY_EXISTS) this->errorOut("CreateFileMappingNuma("+name+")");
+    }
 
     /*******************************************************************
-     * Step 2) find a 2X chunk of virtual memory
+     * Step 2) reserve a 2X chunk of virtual memory and map both halves
      ******************************************************************/
+    if (this->mapPlaceholderViews(numBytes, largePageSize)) return;
+
+    //large page views require placeholders for the alignment
+    if (largePageSize != 0) this->errorOut("VirtualAlloc2(MEM_LARGE_PAGES)");
+    this->mapReleasedViews(numBytes, nndPreferred);
+}
+
+bool CircularBufferContainer::mapPlaceholderViews(const size_t numBytes, const size_t largePageSize)
+{
+    //large page views are aligned to the large page size, so over-reserve by one page
+    const size_t alignment = std::max<size_t>(getregionsize(), largePageSize);
+    const size_t extra = largePageSize;
+    const size_t total = numBytes*2 + extra;
+    auto base = DL_VirtualAlloc2(GetCurrentProcess(), nullptr, total,
+        MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS);
+    if (base == nullptr)
+    {
+        if (GetLastError() == ERROR_CALL_NOT_IMPLEMENTED) return false;
+        this->errorOut("VirtualAlloc2()");
+    }
+    placeholders[0] = base;
+
+    //split a placeholder at the offset, the second part starts at the returned address
+    auto split = [this](const size_t index, const size_t offset)
+    {
+        const auto addr = placeholders[index];
+        if (not VirtualFree(addr, offset, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER)) this->errorOut("VirtualFree(split)");
+        return LPVOID(size_t(addr) + offset);
+    };
+
+    //align the first half, trim the unused ends, and split the halves
+    const size_t lead = (alignment - (size_t(base) % alignment)) % alignment;
+    const size_t trail = total - lead - numBytes*2;
+    if (lead != 0)
+    {
+        placeholders[1] = split(0, lead);
+        VirtualFree(placeholders[0], 0, MEM_RELEASE);
+        placeholders[0] = placeholders[1];
+        placeholders[1] = nullptr;
+    }
+    placeholders[1] = split(0, numBytes);
+    if (trail != 0)
+    {
+        const auto end = split(1, numBytes);
+        VirtualFree(end, 0, MEM_RELEASE);
+    }
+    virtualAddr2X = placeholders[0];
+
+    /*******************************************************************
+     * Step 3) replace the placeholders with overlapping views
+     ******************************************************************/
+    const ULONG viewFlags = MEM_REPLACE_PLACEHOLDER | ((largePageSize != 0)?MEM_LARGE_PAGES:0);
+    hMapViewOfFile0 = DL_MapViewOfFile3(hFileMappingObject, GetCurrentProcess(),
+        placeholders[0], 0, numBytes, viewFlags, PAGE_READWRITE);
+    if (hMapViewOfFile0 == nullptr) this->errorOut("MapViewOfFile3(0)");
+    placeholders[0] = nullptr;
+
+    hMapViewOfFile1 = DL_MapViewOfFile3(hFileMappingObject, GetCurrentProcess(),
+        placeholders[1], 0, numBytes, viewFlags, PAGE_READWRITE);
+    if (hMapViewOfFile1 == nullptr) this->errorOut("MapViewOfFile3(1)");
+    placeholders[1] = nullptr;
+    return true;
+}
+
+void CircularBufferContainer::mapReleasedViews(const size_t numBytes, const DWORD nndPreferred)
+{
     virtualAddr2X = DL_VirtualAllocExNuma(
         GetCurrentProcess(),
         NULL, //determine address
@@ -178,18 +318,263 @@ CircularBufferContainer::CircularBufferContainer(const size_t numBytes, const lo
     if (hMapViewOfFile1 == nullptr) this->errorOut("MapViewOfFileExNuma(1)");
 }
 
+/***********************************************************************
+ * named allocation implementation
+ * the mapping object lives until the last handle is closed,
+ * so the name is removed when every process releases the memory
+ **********************************************************************/
+class NamedBufferContainer
+{
+public:
+    NamedBufferContainer(const std::string &name, const size_t numBytes, const bool create):
+        hFileMappingObject(nullptr),
+        hMapViewOfFile(nullptr)
+    {
+        if (create) hFileMappingObject = CreateFileMappingA(
+            INVALID_HANDLE_VALUE,
+            nullptr, //default security descriptor
+            PAGE_READWRITE, //rw mode
+            0, DWORD(numBytes), //high, low size in bytes
+            name.c_str());
+        else hFileMappingObject = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+        if (hFileMappingObject == nullptr) this->errorOut("FileMapping("+name+")");
+        if (create and GetLastError() == ERROR_ALREADY_EXISTS) this->errorOut("CreateFileMapping("+name+")");
+
+        hMapViewOfFile = MapViewOfFile(hFileMappingObject, FILE_MAP_ALL_ACCESS, 0, 0, numBytes);
+        if (hMapViewOfFile == nullptr) this->errorOut("MapViewOfFile("+name+")");
+    }
+
+    ~NamedBufferContainer(void)
+    {
+        this->cleanup();
+    }
+
+    size_t getAddress(void) const
+    {
+        return size_t(hMapViewOfFile);
+    }
+
+private:
+    void errorOut(const std::string &what)
+    {
+        DWORD errorCode = GetLastError();
+        this->cleanup();
+        throw Pothos::SharedBufferError(
+            "Pothos::NamedBufferContainer::"+what,
+            Poco::format("error code %d", int(errorCode)));
+    }
+
+    void cleanup(void)
+    {
+        if (hMapViewOfFile != nullptr) UnmapViewOfFile(hMapViewOfFile);
+        hMapViewOfFile = nullptr;
+
+        if (hFileMappingObject != nullptr) CloseHandle(hFileMappingObject);
+        hFileMappingObject = nullptr;
+    }
+
+    HANDLE hFileMappingObject;
+    LPVOID hMapViewOfFile;
+};
+
 /***********************************************************************
  * shared buffer factory functions
+ * huge pages use the large page size of the system,
+ * normal pages are used when large pages are not available
  **********************************************************************/
-Pothos::SharedBuffer Pothos::SharedBuffer::make(const size_t numBytes, const long nodeAffinity)
+Pothos::SharedBuffer Pothos::SharedBuffer::makeUnaccounted(const size_t numBytes, const long nodeAffinity, const size_t hugePageSize)
 {
-    std::shared_ptr<GenericBufferContainer> container(new GenericBufferContainer(std::max<size_t>(1, numBytes), nodeAffinity));
+    const size_t largePageSize = (hugePageSize == 0)?0:getlargepagesize();
+    if (largePageSize != 0) try
+    {
+        const size_t largeBytes = roundUpPages(std::max<size_t>(1, numBytes), largePageSize);
+        auto container = makeSlabShared<GenericBufferContainer>(largeBytes, nodeAffinity, true);
+        return SharedBuffer(container->getAddress(), numBytes, container);
+    }
+    catch (const Pothos::SharedBufferError &){}
+
+    auto container = makeSlabShared<GenericBufferContainer>(std::max<size_t>(1, numBytes), nodeAffinity, false);
     return SharedBuffer(container->getAddress(), numBytes, container);
 }
 
-Pothos::SharedBuffer Pothos::SharedBuffer::makeCircUnprotected(const size_t numBytesIn, const long nodeAffinity)
+Pothos::SharedBuffer Pothos::SharedBuffer::makeCircUnprotected(const size_t numBytesIn, const long nodeAffinity, const size_t hugePageSize)
 {
-    const size_t numBytes = ((numBytesIn + getregionsize() - 1)/getregionsize())*getregionsize();
+    const size_t largePageSize = (hugePageSize == 0)?0:getlargepagesize();
+    if (largePageSize != 0) try
+    {
+        const size_t numBytes = roundUpPages(numBytesIn, largePageSize);
+        std::shared_ptr<CircularBufferContainer> container(new CircularBufferContainer(numBytes, nodeAffinity, "", true, largePageSize));
+        return SharedBuffer(container->getAddress(), numBytes, container);
+    }
+    catch (const Pothos::SharedBufferError &){}
+
+    const size_t numBytes = roundUpPages(numBytesIn, 0);
     std::shared_ptr<CircularBufferContainer> container(new CircularBufferContainer(numBytes, nodeAffinity));
     return SharedBuffer(container->getAddress(), numBytes, container);
 }
+
+Pothos::SharedBuffer Pothos::SharedBuffer::makeNamedUnaccounted(const std::string &name, const size_t numBytes, const bool create)
+{
+    std::shared_ptr<NamedBufferContainer> container(new NamedBufferContainer(name, std::max<size_t>(1, numBytes), create));
+    return SharedBuffer(container->getAddress(), numBytes, container);
+}
+
+Pothos::SharedBuffer Pothos::SharedBuffer::makeCircNamedUnprotected(const std::string &name, const size_t numBytesIn, const bool create)
+{
+    const size_t numBytes = roundUpPages(numBytesIn, 0);
+    std::shared_ptr<CircularBufferContainer> container(new CircularBufferContainer(numBytes, -1, name, create));
+    return SharedBuffer(container->getAddress(), numBytes, container);
+}
+
+/***********************************************************************
+ * memory mapped file implementation
+ * each window has its own mapping object sized to the end of the window,
+ * the view keeps the mapping object alive after the handle is closed
+ **********************************************************************/
+class MappedFileWindow
+{
+public:
+    MappedFileWindow(const MappedFile::Sptr &file, LPVOID view):
+        _file(file),
+        _view(view)
+    {
+        return;
+    }
+
+    ~MappedFileWindow(void)
+    {
+        UnmapViewOfFile(_view);
+    }
+
+private:
+    MappedFile::Sptr _file; //keep the file open while mapped
+    LPVOID _view;
+};
+
+MappedFile::MappedFile(const std::string &path, const bool write):
+    _path(path),
+    _write(write),
+    _handle(intptr_t(INVALID_HANDLE_VALUE)),
+    _size(0),
+    _finalSize(0)
+{
+    const HANDLE hFile = CreateFileA(path.c_str(),
+        write?(GENERIC_READ | GENERIC_WRITE):GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr, //default security descriptor
+        write?CREATE_ALWAYS:OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) this->errorOut("CreateFile("+path+")");
+    _handle = intptr_t(hFile);
+
+    LARGE_INTEGER size;
+    if (not GetFileSizeEx(hFile, &size)) this->errorOut("GetFileSizeEx("+path+")");
+    _size = (unsigned long long)(size.QuadPart);
+}
+
+MappedFile::~MappedFile(void)
+{
+    const HANDLE hFile = HANDLE(_handle);
+    if (hFile == INVALID_HANDLE_VALUE) return;
+
+    //remove the unused space of the last window, failure leaves a longer file
+    if (_write)
+    {
+        LARGE_INTEGER pos;
+        pos.QuadPart = LONGLONG(_finalSize);
+        if (SetFilePointerEx(hFile, pos, nullptr, FILE_BEGIN)) SetEndOfFile(hFile);
+    }
+    CloseHandle(hFile);
+}
+
+MappedFile::Sptr MappedFile::open(const std::string &path, const bool write)
+{
+    return Sptr(new MappedFile(path, write));
+}
+
+void MappedFile::errorOut(const std::string &what)
+{
+    DWORD errorCode = GetLastError();
+    if (HANDLE(_handle) != INVALID_HANDLE_VALUE) CloseHandle(HANDLE(_handle));
+    _handle = intptr_t(INVALID_HANDLE_VALUE);
+    throw Pothos::SharedBufferError(
+        "Pothos::MappedFile::"+what,
+        Poco::format("error code %d", int(errorCode)));
+}
+
+size_t MappedFile::alignment(void)
+{
+    return getregionsize();
+}
+
+unsigned long long MappedFile::size(void) const
+{
+    return _size;
+}
+
+Pothos::SharedBuffer MappedFile::map(const unsigned long long offset, const size_t numBytesIn)
+{
+    assert(offset % alignment() == 0);
+    size_t numBytes = numBytesIn;
+
+    //views past the end of the file cannot be mapped for reading
+    if (not _write and offset >= _size) return Pothos::SharedBuffer::null();
+    if (not _write) numBytes = size_t(std::min<unsigned long long>(numBytes, _size-offset));
+    if (numBytes == 0) return Pothos::SharedBuffer::null();
+
+    //a writable mapping object extends the file to its size
+    const unsigned long long end = offset+numBytes;
+    const HANDLE hMapping = CreateFileMappingA(HANDLE(_handle),
+        nullptr, //default security descriptor
+        _write?PAGE_READWRITE:PAGE_WRITECOPY,
+        DWORD(end >> 32), DWORD(end & 0xffffffff), //high, low size in bytes
+        nullptr); //unnamed
+    if (hMapping == nullptr) this->errorOut("CreateFileMapping("+_path+")");
+    if (_write) _size = std::max(_size, end);
+
+    //copy-on-write views of the reader never change the file
+    const LPVOID view = MapViewOfFile(hMapping,
+        _write?FILE_MAP_WRITE:FILE_MAP_COPY,
+        DWORD(offset >> 32), DWORD(offset & 0xffffffff), numBytes);
+    const DWORD errorCode = GetLastError();
+    CloseHandle(hMapping);
+    if (view == nullptr) throw Pothos::SharedBufferError(
+        "Pothos::MappedFile::MapViewOfFile("+_path+")",
+        Poco::format("error code %d", int(errorCode)));
+
+    std::shared_ptr<MappedFileWindow> container(new MappedFileWindow(this->shared_from_this(), view));
+    return Pothos::SharedBuffer(size_t(view), numBytes, container);
+}
+
+void MappedFile::flush(const Pothos::SharedBuffer &window)
+{
+    //FlushViewOfFile starts the write back without waiting for the disk
+    if (not _write or window.getLength() == 0) return;
+    FlushViewOfFile(LPCVOID(window.getAddress()), window.getLength());
+}
+
+void MappedFile::setFinalSize(const unsigned long long finalSize)
+{
+    _finalSize = finalSize;
+}
+
+/***********************************************************************
+ * page locking implementation
+ **********************************************************************/
+bool sharedBufferLockPages(const size_t address, const size_t length)
+{
+    if (length == 0) return true;
+    return VirtualLock(LPVOID(address), length) != 0;
+}
+
+void sharedBufferUnlockPages(const size_t address, const size_t length)
+{
+    if (length == 0) return;
+    VirtualUnlock(LPVOID(address), length);
+}
+
+size_t sharedBufferPageSize(void)
+{
+    return getpagesize();
+}
@@ -0,0 +1,186 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Framework/SlabAllocator.hpp"
+#include <mutex>
+#include <new>
+
+//! The block sizes of each size class
+static const size_t slabClassBytes[] = {32, 64, 128, 256, 512};
+
+static const size_t numSlabClasses = sizeof(slabClassBytes)/sizeof(slabClassBytes[0]);
+
+//! The number of blocks carved out of each new slab
+static const size_t blocksPerSlab = 64;
+
+//! The most free blocks a thread caches per size class
+static const size_t maxCachedBlocks = 2*blocksPerSlab;
+
+struct SlabFreeBlock
+{
+    SlabFreeBlock *next;
+};
+
+static size_t slabClassIndex(const size_t numBytes)
+{
+    size_t index = 0;
+    while (index < numSlabClasses and slabClassBytes[index] < numBytes) index++;
+    return index;
+}
+
+/***********************************************************************
+ * The depot holds the free blocks shared by all threads.
+ * Slabs are never returned to the system, the depot is never destroyed,
+ * so that blocks freed during static destruction remain valid.
+ **********************************************************************/
+struct SlabDepot
+{
+    SlabDepot(void)
+    {
+        for (auto &head : free) head = nullptr;
+    }
+
+    //! Move up to blocksPerSlab free blocks onto the list, carve a new slab when empty
+    size_t take(const size_t index, SlabFreeBlock *&list)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (free[index] == nullptr)
+        {
+            const size_t size = slabClassBytes[index];
+            auto slab = static_cast<char *>(::operator new(size*blocksPerSlab));
+            for (size_t i = 0; i < blocksPerSlab; i++)
+            {
+                auto block = reinterpret_cast<SlabFreeBlock *>(slab + i*size);
+                block->next = list;
+                list = block;
+            }
+            return blocksPerSlab;
+        }
+        size_t count = 0;
+        while (free[index] != nullptr and count < blocksPerSlab)
+        {
+            auto block = free[index];
+            free[index] = block->next;
+            block->next = list;
+            list = block;
+            count++;
+        }
+        return count;
+    }
+
+    //! Give back a list of free blocks
+    void give(const size_t index, SlabFreeBlock *list)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (list != nullptr)
+        {
+            auto block = list;
+            list = block->next;
+            block->next = free[index];
+            free[index] = block;
+        }
+    }
+
+    std::mutex mutex;
+    SlabFreeBlock *free[numSlabClasses];
+};
+
+static SlabDepot &getSlabDepot(void)
+{
+    static SlabDepot *depot = new SlabDepot();
+    return *depot;
+}
+
+/***********************************************************************
+ * The thread cache returns its blocks to the depot on thread exit.
+ * Blocks freed after the cache is destroyed, such as from static
+ * destructors on the main thread, go directly through the depot.
+ **********************************************************************/
+static thread_local bool slabThreadCacheDone = false;
+
+struct SlabThreadCache
+{
+    SlabThreadCache(void)
+    {
+        for (size_t i = 0; i < numSlabClasses; i++)
+        {
+            free[i] = nullptr;
+            count[i] = 0;
+        }
+    }
+
+    ~SlabThreadCache(void)
+    {
+        for (size_t i = 0; i < numSlabClasses; i++) getSlabDepot().give(i, free[i]);
+        slabThreadCacheDone = true;
+    }
+
+    SlabFreeBlock *free[numSlabClasses];
+    size_t count[numSlabClasses];
+};
+
+static SlabThreadCache &getSlabThreadCache(void)
+{
+    static thread_local SlabThreadCache cache;
+    return cache;
+}
+
+/***********************************************************************
+ * slab allocator implementation
+ **********************************************************************/
+void *slabAllocate(const size_t numBytes)
+{
+    const size_t index = slabClassIndex(numBytes);
+    if (index == numSlabClasses) return ::operator new(numBytes);
+
+    if (slabThreadCacheDone)
+    {
+        SlabFreeBlock *list = nullptr;
+        getSlabDepot().take(index, list);
+        auto block = list;
+        getSlabDepot().give(index, block->next);
+        return block;
+    }
+
+    auto &cache = getSlabThreadCache();
+    if (cache.free[index] == nullptr)
+    {
+        cache.count[index] += getSlabDepot().take(index, cache.free[index]);
+    }
+    auto block = cache.free[index];
+    cache.free[index] = block->next;
+    cache.count[index]--;
+    return block;
+}
+
+void slabDeallocate(void *ptr, const size_t numBytes)
+{
+    if (ptr == nullptr) return;
+    const size_t index = slabClassIndex(numBytes);
+    if (index == numSlabClasses) return ::operator delete(ptr);
+
+    auto block = static_cast<SlabFreeBlock *>(ptr);
+    if (slabThreadCacheDone)
+    {
+        block->next = nullptr;
+        return getSlabDepot().give(index, block);
+    }
+
+    auto &cache = getSlabThreadCache();
+    block->next = cache.free[index];
+    cache.free[index] = block;
+    cache.count[index]++;
+
+    //a thread that frees more than it allocates returns half to the depot
+    if (cache.count[index] < maxCachedBlocks) return;
+    SlabFreeBlock *list = nullptr;
+    for (size_t i = 0; i < maxCachedBlocks/2; i++)
+    {
+        block = cache.free[index];
+        cache.free[index] = block->next;
+        block->next = list;
+        list = block;
+    }
+    cache.count[index] -= maxCachedBlocks/2;
+    getSlabDepot().give(index, list);
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <cstddef> //size_t
+#include <memory> //allocate_shared
+#include <utility> //forward
+
+/*!
+ * Allocate small bookkeeping objects from per size class slabs.
+ * Each thread caches free blocks, so allocations on the work threads
+ * do not hit malloc or a lock in the steady state.
+ * A block may be freed on a different thread than it was allocated on.
+ * Requests larger than the largest size class use operator new.
+ */
+void *slabAllocate(const size_t numBytes);
+
+//! Free a block from slabAllocate() with the same numBytes
+void slabDeallocate(void *ptr, const size_t numBytes);
+
+/*!
+ * A standard allocator over the slabs, for std::allocate_shared(),
+ * which puts the control block and the object into one slab block.
+ */
+template <typename T>
+struct SlabAllocator
+{
+    typedef T value_type;
+
+    SlabAllocator(void)
+    {
+        return;
+    }
+
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U> &)
+    {
+        return;
+    }
+
+    T *allocate(const size_t n)
+    {
+        return static_cast<T *>(slabAllocate(n*sizeof(T)));
+    }
+
+    void deallocate(T *p, const size_t n)
+    {
+        slabDeallocate(p, n*sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const SlabAllocator<T> &, const SlabAllocator<U> &)
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const SlabAllocator<T> &, const SlabAllocator<U> &)
+{
+    return false;
+}
+
+//! Make a shared object with the control block from the slabs
+template <typename T, typename... Args>
+std::shared_ptr<T> makeSlabShared(Args &&... args)
+{
+    return std::allocate_shared<T>(SlabAllocator<T>(), std::forward<Args>(args)...);
+}
@@ -1,15 +1,21 @@
-// Copyright (c) 2015-2015 Josh Blum
+// Copyright (c) 2015-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/ThreadEnvironment.hpp"
+#include "Framework/AffinityPlanner.hpp"
+#include <Pothos/System/NumaInfo.hpp>
 #include <Poco/Logger.h>
 #include <Poco/Environment.h>
+#include <Poco/NumberParser.h>
+#include <Poco/StringTokenizer.h>
 #include <sched.h>
 #ifdef HAVE_LIBNUMA
 #include <numa.h>
 #endif
 #include <cerrno> //errno
 #include <cstring> //strerror
+#include <fstream>
+#include <set>
 
 #ifdef __APPLE__
 #include <thread>
@@ -20,13 +26,78 @@
 #include <sys/cpuset.h>
 #endif
 
-std::string ThreadEnvironment::setPriority(const double prio)
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+#ifndef SCHED_FLAG_RESET_ON_FORK
+#define SCHED_FLAG_RESET_ON_FORK 0x01
+#endif
+
+//the sched_setattr() structure is not declared by older libc headers
+struct ThreadSchedAttr
+{
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime; //nanoseconds
+    uint64_t sched_deadline; //nanoseconds
+    uint64_t sched_period; //nanoseconds
+};
+
+static std::string setDeadlinePolicy(const Pothos::ThreadPoolArgs &args)
 {
+    #ifdef SYS_sched_setattr
+    ThreadSchedAttr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.sched_policy = SCHED_DEADLINE;
+    attr.sched_flags = SCHED_FLAG_RESET_ON_FORK;
+    attr.sched_runtime = uint64_t(args.deadlineRuntime*1e9);
+    attr.sched_period = uint64_t(args.deadlinePeriod*1e9);
+    attr.sched_deadline = (args.deadline == 0.0)?attr.sched_period:uint64_t(args.deadline*1e9);
+    if (syscall(SYS_sched_setattr, 0, &attr, 0) != 0) return strerror(errno);
+    return "";
+    #else
+    (void)args;
+    return "sched_setattr() not available";
+    #endif
+}
+#endif //__linux__
+
+std::string ThreadEnvironment::setPriority(const Pothos::ThreadPoolArgs &args)
+{
+    const double prio(args.priority);
+
+    #ifdef __linux__
+    //the deadline policy does not use the priority value
+    if (args.realtimePolicy == "DEADLINE") return setDeadlinePolicy(args);
+
+    //nice values are per-thread on linux: 0 to 19 for sub-priority
+    if (prio < 0.0)
+    {
+        const int niceValue = int(-prio*19 + 0.5);
+        if (setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), niceValue) != 0) return strerror(errno);
+        return "";
+    }
+    #else
+    if (args.realtimePolicy == "DEADLINE") return "SCHED_DEADLINE not available";
+    #endif
+
     //no negative priorities supported on this OS
     if (prio <= 0.0) return "";
 
     //determine priority bounds
-    const int policy(SCHED_RR);
+    const int policy((args.realtimePolicy == "FIFO")?SCHED_FIFO:SCHED_RR);
     const int maxPrio = sched_get_priority_max(policy);
     if (maxPrio < 0) return strerror(errno);
     const int minPrio = sched_get_priority_min(policy);
@@ -45,6 +116,28 @@ std::string ThreadEnvironment::setPriority(const double prio)
     return "";
 }
 
+std::string ThreadEnvironment::holdCPUDmaLatency(const int latency, std::shared_ptr<void> &hold)
+{
+    #ifdef __linux__
+    //the request stays in effect while the file is open
+    const int fd = open("/dev/cpu_dma_latency", O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return strerror(errno);
+    const int32_t value(latency);
+    if (write(fd, &value, sizeof(value)) != ssize_t(sizeof(value)))
+    {
+        const std::string errorMsg(strerror(errno));
+        close(fd);
+        return errorMsg;
+    }
+    hold.reset(new int(fd), [](int *p){close(*p); delete p;});
+    return "";
+    #else
+    (void)latency;
+    (void)hold;
+    return "/dev/cpu_dma_latency not available";
+    #endif
+}
+
 std::string ThreadEnvironment::setCPUAffinity(const std::vector<size_t> &affinity)
 {
     #ifdef __APPLE__
@@ -103,3 +196,84 @@ std::string ThreadEnvironment::setNodeAffinity(const std::vector<size_t> &affini
     return "numa_bind() not available";
     #endif
 }
+
+/***********************************************************************
+ * CPU topology for the AUTO affinity planner
+ **********************************************************************/
+#ifdef __linux__
+static std::string readSysFile(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+//! Parse a sysfs CPU list such as "0-3,8,10-11"
+static std::set<size_t> parseCPUList(const std::string &list)
+{
+    std::set<size_t> cpus;
+    const Poco::StringTokenizer ranges(list, ",", Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+    for (const auto &range : ranges)
+    {
+        const auto dash = range.find('-');
+        unsigned first(0), last(0);
+        if (not Poco::NumberParser::tryParseUnsigned(range.substr(0, dash), first)) continue;
+        last = first;
+        if (dash != std::string::npos and not Poco::NumberParser::tryParseUnsigned(range.substr(dash+1), last)) continue;
+        for (size_t cpu = first; cpu <= last; cpu++) cpus.insert(cpu);
+    }
+    return cpus;
+}
+#endif
+
+std::vector<CPUTopologyInfo> queryCPUTopology(void)
+{
+    std::vector<CPUTopologyInfo> cpus;
+
+    //the NUMA node of each CPU
+    std::map<size_t, size_t> cpuToNode;
+    for (const auto &info : Pothos::System::NumaInfo::get())
+    {
+        for (const auto &cpu : info.cpus) cpuToNode[cpu] = info.nodeNumber;
+    }
+
+    #ifdef __linux__
+    //the affinity mask follows the cgroup cpuset and taskset
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    if (sched_getaffinity(0, sizeof(cpuset), &cpuset) != 0) return cpus;
+    const auto isolated = parseCPUList(readSysFile("/sys/devices/system/cpu/isolated"));
+
+    for (size_t cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (not CPU_ISSET(cpu, &cpuset)) continue;
+        CPUTopologyInfo info;
+        info.cpu = cpu;
+        info.node = cpuToNode.count(cpu)?cpuToNode.at(cpu):0;
+        info.isolated = isolated.count(cpu) != 0;
+
+        //the core is unique across packages, siblings share the core
+        const auto topologyPath = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        unsigned package(0), core = unsigned(cpu);
+        Poco::NumberParser::tryParseUnsigned(readSysFile(topologyPath + "physical_package_id"), package);
+        Poco::NumberParser::tryParseUnsigned(readSysFile(topologyPath + "core_id"), core);
+        info.core = (size_t(package) << 16) | core;
+        cpus.push_back(info);
+    }
+
+    #elif !defined(__APPLE__)
+    //without topology info, treat each CPU as a separate core
+    for (size_t cpu = 0; cpu < Poco::Environment::processorCount(); cpu++)
+    {
+        CPUTopologyInfo info;
+        info.cpu = cpu;
+        info.node = cpuToNode.count(cpu)?cpuToNode.at(cpu):0;
+        info.core = cpu;
+        info.isolated = false;
+        cpus.push_back(info);
+    }
+    #endif
+
+    return cpus;
+}
@@ -1,14 +1,18 @@
-// Copyright (c) 2015-2015 Josh Blum
+// Copyright (c) 2015-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/ThreadEnvironment.hpp"
+#include "Framework/AffinityPlanner.hpp"
+#include <Pothos/System/NumaInfo.hpp>
 #include <windows.h>
 
 //delay loaded symbols for windows backwards compatibility
 BOOL DL_GetNumaNodeProcessorMaskEx(USHORT Node, PGROUP_AFFINITY ProcessorMask);
 
-std::string ThreadEnvironment::setPriority(const double prio)
+std::string ThreadEnvironment::setPriority(const Pothos::ThreadPoolArgs &args)
 {
+    const double prio(args.priority);
+    if (args.realtimePolicy == "DEADLINE") return "SCHED_DEADLINE not available";
     int nPriority(THREAD_PRIORITY_NORMAL);
 
     if (prio > 0)
@@ -30,6 +34,11 @@ std::string ThreadEnvironment::setPriority(const double prio)
     return "SetThreadPriority() fail";
 }
 
+std::string ThreadEnvironment::holdCPUDmaLatency(const int, std::shared_ptr<void> &)
+{
+    return "/dev/cpu_dma_latency not available";
+}
+
 std::string ThreadEnvironment::setCPUAffinity(const std::vector<size_t> &affinity)
 {
     KAFFINITY mask(0);
@@ -53,3 +62,50 @@ std::string ThreadEnvironment::setNodeAffinity(const std::vector<size_t> &affini
     if (SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(mask)) != 0) return "";
     return "SetThreadAffinityMask() fail";
 }
+
+std::vector<CPUTopologyInfo> queryCPUTopology(void)
+{
+    std::vector<CPUTopologyInfo> cpus;
+
+    //the affinity mask of the process limits the CPUs
+    DWORD_PTR processMask(0), systemMask(0);
+    if (not GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) return cpus;
+
+    //the NUMA node of each CPU
+    std::map<size_t, size_t> cpuToNode;
+    for (const auto &info : Pothos::System::NumaInfo::get())
+    {
+        for (const auto &cpu : info.cpus) cpuToNode[cpu] = info.nodeNumber;
+    }
+
+    //the physical core of each CPU, siblings share the core
+    std::map<size_t, size_t> cpuToCore;
+    DWORD length(0);
+    GetLogicalProcessorInformation(nullptr, &length);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(length/sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (not infos.empty() and GetLogicalProcessorInformation(infos.data(), &length))
+    {
+        size_t core(0);
+        for (const auto &info : infos)
+        {
+            if (info.Relationship != RelationProcessorCore) continue;
+            for (size_t cpu = 0; cpu < sizeof(ULONG_PTR)*8; cpu++)
+            {
+                if ((info.ProcessorMask & (ULONG_PTR(1) << cpu)) != 0) cpuToCore[cpu] = core;
+            }
+            core++;
+        }
+    }
+
+    for (size_t cpu = 0; cpu < sizeof(DWORD_PTR)*8; cpu++)
+    {
+        if ((processMask & (DWORD_PTR(1) << cpu)) == 0) continue;
+        CPUTopologyInfo info;
+        info.cpu = cpu;
+        info.node = cpuToNode.count(cpu)?cpuToNode.at(cpu):0;
+        info.core = cpuToCore.count(cpu)?cpuToCore.at(cpu):cpu;
+        info.isolated = false;
+        cpus.push_back(info);
+    }
+    return cpus;
+}
@@ -1,21 +1,143 @@
-// Copyright (c) 2015-2015 Josh Blum
+// Copyright (c) 2015-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/ThreadEnvironment.hpp"
+#include "Framework/SchedulerTrace.hpp"
+#include "Framework/CycleCounter.hpp"
+#include <Pothos/Exception.hpp>
 #include <Poco/Logger.h>
 #include <iostream>
+#include <limits>
 #include <cassert>
+#include <json.hpp>
 
-ThreadEnvironment::ThreadEnvironment(const Pothos::ThreadPoolArgs &args):
-    _args(args),
+/*!
+ * The ready queue and environment of the current pool thread.
+ * Used to push ready notifications onto the caller's local queue.
+ */
+static thread_local ThreadEnvironment *currentEnvironment(nullptr);
+static thread_local size_t currentQueueIndex(0);
+
+/*!
+ * The args of an environment with an executor:
+ * The tasks are queue driven like the work-stealing scheduler,
+ * but the pool runs no threads and the work items never wait.
+ */
+static Pothos::ThreadPoolArgs executorArgs(const Pothos::ThreadPoolArgs &args, const bool hasExecutor)
+{
+    if (not hasExecutor) return args;
+    Pothos::ThreadPoolArgs result(args);
+    result.numThreads = 1;
+    result.schedulerMode = "WORK_STEALING";
+    result.yieldMode = "SPIN";
+    return result;
+}
+
+ThreadEnvironment::ThreadEnvironment(const Pothos::ThreadPoolArgs &args, const std::shared_ptr<Pothos::ThreadPoolExecutor> &executor):
+    _args(executorArgs(args, bool(executor))),
     _waitModeEnabled(_args.yieldMode != "SPIN"),
-    _configurationSignature(0)
+    _hybridModeEnabled(_args.yieldMode == "HYBRID"),
+    _workStealingEnabled(_args.numThreads != 0 and _args.schedulerMode == "WORK_STEALING"),
+    _autoAffinityNode((_args.affinityMode == "AUTO")?AffinityPlanner::global().chooseNode():-1),
+    _stickyTasksEnabled(_args.taskOrder == "STICKY"),
+    _nextComponent(0),
+    _configurationSignature(0),
+    _taskSnapshot(new TaskSnapshot()),
+    _numReadyTasks(0),
+    _numIdleThreads(0),
+    _poolIdleEnabled(not executor and _args.numThreads != 0 and not _workStealingEnabled),
+    _poolActivity(0),
+    _numParkedThreads(0),
+    _numThreads(executor?0:_args.numThreads),
+    _minThreads(executor?0:_args.numThreads),
+    _idleTimeNs(0),
+    _numTasks(0),
+    _numIdleScans(0),
+    _numFailedAcquires(0),
+    _numWaits(0),
+    _numWakes(0),
+    _taskCycles(0),
+    _scanCycles(0),
+    _timeCreated(std::chrono::steady_clock::now()),
+    _idleTimeout(std::chrono::nanoseconds((long long)(_args.idleTimeout*1e9))),
+    _parkedReady(false),
+    _idleThreadDone(false),
+    _autoscaleDone(false),
+    _executor(executor),
+    _sweepDone(false),
+    _wakeupDone(false)
 {
-    return;
+    if (_args.cpuDmaLatency >= 0)
+    {
+        const auto errorMsg = ThreadEnvironment::holdCPUDmaLatency(_args.cpuDmaLatency, _cpuDmaLatencyHold);
+        if (not errorMsg.empty()) poco_error_f1(Poco::Logger::get("Pothos.ThreadPool"), "Failed to hold CPU DMA latency %s", errorMsg);
+    }
+
+    for (auto &numQueued : _numQueuedTasks) numQueued.store(0);
+    if (_workStealingEnabled) for (size_t i = 0; i < _args.numThreads; i++)
+    {
+        _readyQueues.emplace_back(new ReadyQueue());
+    }
+
+    if (_args.numThreads != 0 and _args.maxThreads > _args.numThreads)
+    {
+        _autoscaleThread = std::thread(&ThreadEnvironment::autoscaleLoop, this);
+    }
+
+    if (_args.numThreads == 0 and _idleTimeout.count() > 0)
+    {
+        _idleThread = std::thread(&ThreadEnvironment::idleProcessLoop, this);
+    }
+
+    if (_executor)
+    {
+        _sweepThread = std::thread(&ThreadEnvironment::executorSweepLoop, this);
+    }
 }
 
 ThreadEnvironment::~ThreadEnvironment(void)
 {
+    //stop autoscaling before the tasks are removed
+    if (_autoscaleThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_autoscaleMutex);
+            _autoscaleDone = true;
+        }
+        _autoscaleCond.notify_all();
+        _autoscaleThread.join();
+    }
+
+    //stop the executor sweep before the tasks are removed
+    if (_sweepThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_sweepMutex);
+            _sweepDone = true;
+        }
+        _sweepCond.notify_all();
+        _sweepThread.join();
+    }
+
+    //stop the timed wakeups before the tasks are removed
+    {
+        std::lock_guard<std::mutex> lock(_wakeupMutex);
+        _wakeupDone = true;
+    }
+    _wakeupCond.notify_all();
+    if (_wakeupThread.joinable()) _wakeupThread.join();
+
+    //stop the shared idle thread, the parked tasks have no other thread
+    if (_idleThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_readyMutex);
+            _idleThreadDone = true;
+        }
+        _readyCond.notify_all();
+        _idleThread.join();
+    }
+
     //tear-down all tasks if not done by caller
     while (not _handleToTask.empty())
     {
@@ -23,9 +145,10 @@ ThreadEnvironment::~ThreadEnvironment(void)
     }
 }
 
-void ThreadEnvironment::registerTask(void *handle, TaskData::Task task, TaskData::Wake wake)
+TaskData *ThreadEnvironment::registerTask(void *handle, TaskData::Task task, TaskData::Wake wake)
 {
     std::lock_guard<std::mutex> lock(_registrationMutex);
+    TaskData *data(nullptr);
 
     //disable wait mode
     bool waitModeEnabled = false;
@@ -34,8 +157,9 @@ void ThreadEnvironment::registerTask(void *handle, TaskData::Task task, TaskData
     //register the new task and bump the signature to notify threads
     {
         std::lock_guard<std::mutex> lock0(_handleUpdateMutex);
-        _handleToTask[handle].reset(new TaskData(task, wake));
-        _configurationSignature++;
+        data = new TaskData(this, task, wake, _workStealingEnabled);
+        _handleToTask[handle].reset(data);
+        this->publishTasks();
     }
 
     //single task mode: spawn a new thread for this task
@@ -45,22 +169,25 @@ void ThreadEnvironment::registerTask(void *handle, TaskData::Task task, TaskData
     }
 
     //pool mode: start a thread if the pool size is too small
-    else
-    {
-        if (_threadPool.size() < _args.numThreads)
-        {
-            size_t index = _threadPool.size();
-            _threadPool.push_back(std::thread(std::bind(&ThreadEnvironment::poolProcessLoop, this, index)));
-        }
-        assert(_threadPool.size() <= _args.numThreads);
-    }
+    else this->resizeThreadPool();
 
     //restore wait mode
     std::swap(waitModeEnabled, _waitModeEnabled);
+
+    //ready notifications are used by the work-stealing scheduler and fused groups
+    return data;
 }
 
 void ThreadEnvironment::unregisterTask(void *handle)
 {
+    //the notify of a wakeup may reference the caller
+    this->cancelWakeup(handle);
+
+    //a fused member is restored from its group before unregistering
+    const auto group = this->findFusedGroup(handle);
+    if (group != nullptr) this->unfuseTasks(group);
+    if (group == handle) return;
+
     std::lock_guard<std::mutex> lock(_registrationMutex);
     std::shared_ptr<TaskData> data;
 
@@ -69,161 +196,1138 @@ void ThreadEnvironment::unregisterTask(void *handle)
     std::swap(waitModeEnabled, _waitModeEnabled);
 
     //unregister the new task and bump the signature to notify threads
+    size_t signature(0);
     {
         std::lock_guard<std::mutex> lock0(_handleUpdateMutex);
         std::swap(data, _handleToTask[handle]);
         _handleToTask.erase(handle);
-        _configurationSignature++;
+        _taskOrders.erase(handle);
+        signature = this->publishTasks();
     }
 
+    //block further enqueuing, references are purged below
+    data->registered = false;
+
     //wake every known task to accept the new config state
     data->wake();
     for (const auto &pair : _handleToTask) pair.second->wake();
+    _readyCond.notify_all();
 
     //single task mode: stop the explicit task for this handle
+    if (_args.numThreads == 0) this->stopTaskThread(handle);
+
+    //pool mode: stop a thread if the pool size is too large
+    else this->resizeThreadPool();
+
+    //wait for all threads to relinquish the old configuration
+    //and remove references from notifications that were in-flight
+    this->waitForSignature(signature);
+    while (true)
+    {
+        this->purgeReadyTask(data);
+        if (data.unique()) break;
+        std::this_thread::yield();
+    }
+
+    //restore wait mode
+    std::swap(waitModeEnabled, _waitModeEnabled);
+}
+
+/***********************************************************************
+ * Fused task groups
+ **********************************************************************/
+void ThreadEnvironment::fuseTasks(void *handle, const std::vector<void *> &members, const std::vector<size_t> &repetitions)
+{
+    if (not repetitions.empty() and (repetitions.size() != members.size() or
+        std::count(repetitions.begin(), repetitions.end(), size_t(0)) != 0))
+    {
+        throw Pothos::InvalidArgumentException("ThreadEnvironment::fuseTasks()", "repetitions must be positive per member");
+    }
+
+    std::lock_guard<std::mutex> lock(_registrationMutex);
+
+    //the registration mutex protects the handles from changes while checking
+    std::vector<std::shared_ptr<TaskData>> tasks;
+    for (auto member : members)
+    {
+        auto it = _handleToTask.find(member);
+        if (it == _handleToTask.end() or it->second->group or
+            std::count(members.begin(), members.end(), member) != 1)
+        {
+            throw Pothos::InvalidArgumentException("ThreadEnvironment::fuseTasks()", "members must be unique registered tasks");
+        }
+        tasks.push_back(it->second);
+    }
+    if (_handleToTask.count(handle) != 0)
+    {
+        throw Pothos::InvalidArgumentException("ThreadEnvironment::fuseTasks()", "group handle already registered");
+    }
+
+    //disable wait mode
+    bool waitModeEnabled = false;
+    std::swap(waitModeEnabled, _waitModeEnabled);
+
+    //replace the member tasks with the group task and bump the signature to notify threads
+    auto group = std::make_shared<FusedTaskGroup>(tasks, this->getWaitTimeout(), repetitions);
+    std::shared_ptr<TaskData> data(new TaskData(this,
+        std::bind(&FusedTaskGroup::run, group, std::placeholders::_1),
+        std::bind(&FusedTaskGroup::wake, group), _workStealingEnabled));
+    data->group = group;
+    {
+        std::lock_guard<std::mutex> lock0(_handleUpdateMutex);
+        for (auto member : members) _handleToTask.erase(member);
+        for (const auto &task : tasks) task->fusedInto.store(data.get(), std::memory_order_release);
+        _handleToTask[handle] = data;
+        _fusedGroups[handle] = members;
+        this->updateGroupPriorities();
+        this->publishTasks();
+    }
+
+    //single task mode: the member threads exit and one thread runs the group
     if (_args.numThreads == 0)
     {
-        _handleToThread[handle].join();
-        _handleToThread.erase(handle);
+        for (size_t i = 0; i < members.size(); i++)
+        {
+            tasks[i]->wake();
+            this->stopTaskThread(members[i]);
+        }
+        _handleToThread[handle] = std::thread(std::bind(&ThreadEnvironment::singleProcessLoop, this, handle));
     }
 
-    //pool mode: stop a thread if the pool size is too large
-    else
+    //pool mode: stop threads beyond the number of tasks
+    else this->resizeThreadPool();
+
+    //check the members once for changes flagged before the fusion
+    data->notifyReady();
+
+    //restore wait mode
+    std::swap(waitModeEnabled, _waitModeEnabled);
+}
+
+void ThreadEnvironment::unfuseTasks(void *handle)
+{
+    std::lock_guard<std::mutex> lock(_registrationMutex);
+    auto groupIt = _fusedGroups.find(handle);
+    if (groupIt == _fusedGroups.end()) return;
+    const auto members = groupIt->second;
+
+    //disable wait mode
+    bool waitModeEnabled = false;
+    std::swap(waitModeEnabled, _waitModeEnabled);
+
+    //restore the member tasks and bump the signature to notify threads
+    std::shared_ptr<TaskData> data;
+    size_t signature(0);
     {
-        if (_threadPool.size() > _handleToTask.size())
+        std::lock_guard<std::mutex> lock0(_handleUpdateMutex);
+        std::swap(data, _handleToTask[handle]);
+        _handleToTask.erase(handle);
+        for (size_t i = 0; i < members.size(); i++)
         {
-            _threadPool.back().join();
-            _threadPool.resize(_handleToTask.size());
+            const auto &task = data->group->members[i];
+            task->fusedInto.store(nullptr, std::memory_order_release);
+            _handleToTask[members[i]] = task;
         }
-        assert(_threadPool.size() <= _args.numThreads);
+        _fusedGroups.erase(groupIt);
+        signature = this->publishTasks();
     }
 
-    //wait for all threads to relinquish the old configuration
-    while (not data.unique()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    //block further enqueuing and wake the group to accept the new config state
+    data->registered = false;
+    data->wake();
+    _readyCond.notify_all();
+
+    //single task mode: the group thread exits and each member gets a thread
+    if (_args.numThreads == 0)
+    {
+        this->stopTaskThread(handle);
+        for (auto member : members)
+        {
+            _handleToThread[member] = std::thread(std::bind(&ThreadEnvironment::singleProcessLoop, this, member));
+        }
+    }
+
+    //pool mode: start threads up to the number of tasks
+    else this->resizeThreadPool();
+
+    //wait for all threads to relinquish the group task
+    //and remove references from notifications that were in-flight
+    this->waitForSignature(signature);
+    while (true)
+    {
+        this->purgeReadyTask(data);
+        if (data.unique()) break;
+        std::this_thread::yield();
+    }
+
+    //changes may have been forwarded to the group while unfusing
+    for (const auto &task : data->group->members) task->notifyReady();
 
     //restore wait mode
     std::swap(waitModeEnabled, _waitModeEnabled);
 }
 
-/*!
- * Call wake on all tasks that are busy:
- * Busy tasks will fail the test and set and may be in a CV wait state.
- * Do not call wake on the caller task since that would have no effect.
- * \param tasks a map of all tasks from the caller task
- * \param self the caller task itself to avoid self-wake
- */
-template <typename TasksType>
-void wakeAllBusyTasks(const TasksType &tasks, void *self)
+void ThreadEnvironment::resizeThreadPool(void)
+{
+    const size_t numThreads = std::min(_numThreads.load(), _handleToTask.size());
+
+    //start threads up to the number of tasks
+    while (_threadPool.size() < numThreads)
+    {
+        size_t index = _threadPool.size();
+        _threadPool.push_back(std::thread(std::bind(_workStealingEnabled?
+            &ThreadEnvironment::stealingProcessLoop : &ThreadEnvironment::poolProcessLoop, this, index)));
+    }
+
+    //stop threads beyond the number of tasks, waiting threads are woken to exit
+    while (_threadPool.size() > numThreads)
+    {
+        for (const auto &pair : _handleToTask) pair.second->wake();
+        _readyCond.notify_all();
+        this->wakePoolThreads();
+        _threadPool.back().join();
+        _threadPool.pop_back();
+    }
+}
+
+/***********************************************************************
+ * Thread pool resizing
+ **********************************************************************/
+void ThreadEnvironment::setNumThreads(const size_t numThreads)
+{
+    std::lock_guard<std::mutex> lock(_registrationMutex);
+    _minThreads = numThreads;
+    this->resizeNumThreads(numThreads);
+}
+
+void ThreadEnvironment::resizeNumThreads(const size_t numThreads)
+{
+    assert(_args.numThreads != 0 and numThreads != 0);
+    if (numThreads == _numThreads.load()) return;
+
+    //work-stealing: ready queues are only added while no thread is running,
+    //the tasks in the queues are kept and serviced by the restarted threads
+    if (_workStealingEnabled and numThreads > _readyQueues.size())
+    {
+        _numThreads = 0;
+        _configurationSignature++;
+        this->resizeThreadPool();
+        while (_readyQueues.size() < numThreads) _readyQueues.emplace_back(new ReadyQueue());
+    }
+
+    //the threads beyond the new number exit upon the configuration change
+    _numThreads = numThreads;
+    _configurationSignature++;
+    this->resizeThreadPool();
+}
+
+/***********************************************************************
+ * Autoscaling:
+ * The pool threads accumulate the time spent waiting for work.
+ * Every interval, the busy time is compared to the running threads:
+ * A thread is added while the threads are nearly always busy,
+ * and a thread is removed when the busy time fits in one fewer
+ * thread with headroom, the gap prevents the count from oscillating.
+ **********************************************************************/
+static const std::chrono::milliseconds AutoscaleInterval(100);
+static const double AutoscaleGrowUtilization = 0.9;
+static const double AutoscaleShrinkUtilization = 0.7;
+
+void ThreadEnvironment::autoscaleLoop(void)
 {
-    for (const auto &task : tasks)
+    auto lastTime = std::chrono::steady_clock::now();
+    auto lastIdleNs = _idleTimeNs.load();
+    std::unique_lock<std::mutex> lock(_autoscaleMutex);
+    while (not _autoscaleCond.wait_for(lock, AutoscaleInterval, [this]{return _autoscaleDone;}))
     {
-        if (task.first == self) continue;
+        const auto time = std::chrono::steady_clock::now();
+        const auto idleNs = _idleTimeNs.load();
+        const double elapsedNs = std::chrono::duration<double, std::nano>(time-lastTime).count();
+        const double idle = double(idleNs-lastIdleNs);
+        lastTime = time;
+        lastIdleNs = idleNs;
+
+        std::lock_guard<std::mutex> lock0(_registrationMutex);
+        const size_t numRunning = _threadPool.size();
+        if (numRunning == 0) continue;
+        const size_t numThreads = _numThreads.load();
+        const size_t minThreads = _minThreads.load();
+        const size_t maxThreads = std::max(_args.maxThreads, minThreads);
+        const double busy = std::max(numRunning*elapsedNs - idle, 0.0);
 
-        //if we fail to get the lock, a thread may be waiting
-        if (task.second->flag.test_and_set(std::memory_order_acquire))
+        //grow when the running threads are not limited by the number of tasks
+        if (busy >= AutoscaleGrowUtilization*numRunning*elapsedNs)
         {
-            task.second->wake();
+            if (numRunning == numThreads and numThreads < maxThreads) this->resizeNumThreads(numThreads+1);
         }
-        //got the lock, so there is nothing to wake -> unlock
-        else
+        else if (busy < AutoscaleShrinkUtilization*(numRunning-1)*elapsedNs)
         {
-            task.second->flag.clear(std::memory_order_release);
+            const size_t target = std::max(std::min(numThreads, numRunning)-1, minThreads);
+            if (target < numThreads) this->resizeNumThreads(target);
         }
+
+        //idle time measured during the resize is not attributed to the next interval
+        lastTime = std::chrono::steady_clock::now();
+        lastIdleNs = _idleTimeNs.load();
+    }
+}
+
+/***********************************************************************
+ * Timed wakeups
+ **********************************************************************/
+void ThreadEnvironment::scheduleWakeup(void *handle, const std::chrono::steady_clock::time_point &when, const std::function<void(void)> &notify)
+{
+    {
+        std::lock_guard<std::mutex> lock(_wakeupMutex);
+        if (_wakeupDone) return;
+        auto it = _wakeupHandles.find(handle);
+        if (it != _wakeupHandles.end()) _wakeupTimes.erase(it->second);
+        _wakeupHandles[handle] = _wakeupTimes.emplace(when, std::make_pair(handle, notify));
+        if (not _wakeupThread.joinable()) _wakeupThread = std::thread(&ThreadEnvironment::wakeupLoop, this);
+    }
+    _wakeupCond.notify_all();
+}
+
+void ThreadEnvironment::cancelWakeup(void *handle)
+{
+    std::lock_guard<std::mutex> lock(_wakeupMutex);
+    auto it = _wakeupHandles.find(handle);
+    if (it == _wakeupHandles.end()) return;
+    _wakeupTimes.erase(it->second);
+    _wakeupHandles.erase(it);
+}
+
+void ThreadEnvironment::wakeupLoop(void)
+{
+    //the notify is called with the lock, so cancel waits on a notify in progress
+    std::unique_lock<std::mutex> lock(_wakeupMutex);
+    while (not _wakeupDone)
+    {
+        if (_wakeupTimes.empty())
+        {
+            _wakeupCond.wait(lock);
+            continue;
+        }
+        const auto it = _wakeupTimes.begin();
+        if (std::chrono::steady_clock::now() < it->first)
+        {
+            _wakeupCond.wait_until(lock, it->first);
+            continue;
+        }
+        it->second.second();
+        _wakeupHandles.erase(it->second.first);
+        _wakeupTimes.erase(it);
+    }
+}
+
+/***********************************************************************
+ * Scheduling priority
+ **********************************************************************/
+void ThreadEnvironment::setTaskPriority(void *handle, const int priority)
+{
+    std::lock_guard<std::mutex> lock(_handleUpdateMutex);
+
+    //the task is either registered or a member of a fused group
+    std::shared_ptr<TaskData> data;
+    const auto it = _handleToTask.find(handle);
+    if (it != _handleToTask.end()) data = it->second;
+    for (const auto &pair : _fusedGroups)
+    {
+        const auto memberIt = std::find(pair.second.begin(), pair.second.end(), handle);
+        if (memberIt == pair.second.end()) continue;
+        data = _handleToTask.at(pair.first)->group->members[memberIt-pair.second.begin()];
+    }
+    if (not data) return;
+
+    //a queued task moves to the new level when its enqueued again
+    data->priorityLevel.store(priorityToLevel(priority));
+    this->updateGroupPriorities();
+    this->publishTasks();
+}
+
+void ThreadEnvironment::updateGroupPriorities(void)
+{
+    for (const auto &pair : _fusedGroups)
+    {
+        const auto &data = _handleToTask.at(pair.first);
+        size_t level = NumPriorityLevels-1;
+        for (const auto &member : data->group->members) level = std::min(level, member->priorityLevel.load());
+        data->priorityLevel.store(level);
+    }
+}
+
+/***********************************************************************
+ * Dataflow task order
+ **********************************************************************/
+void ThreadEnvironment::setTaskOrders(const std::map<void *, TaskOrder> &orders)
+{
+    std::lock_guard<std::mutex> lock(_handleUpdateMutex);
+
+    //components are renumbered so that separate calls do not collide
+    std::map<size_t, size_t> components;
+    for (const auto &pair : orders)
+    {
+        auto it = components.find(pair.second.component);
+        if (it == components.end()) it = components.emplace(pair.second.component, _nextComponent++).first;
+        _taskOrders[pair.first] = TaskOrder{pair.second.rank, it->second};
+    }
+    this->publishTasks();
+}
+
+/***********************************************************************
+ * Published task snapshots:
+ * Writers publish an immutable snapshot upon each change,
+ * so the pool threads adopt a change by taking a reference
+ * to the snapshot rather than copying the tasks per thread.
+ * A writer that removes a task waits for every running thread
+ * to adopt the new signature, after which the old snapshots
+ * and their references to the removed task are released.
+ **********************************************************************/
+size_t ThreadEnvironment::publishTasks(void)
+{
+    std::shared_ptr<TaskSnapshot> snapshot(new TaskSnapshot());
+    snapshot->tasks = _handleToTask;
+
+    //the dataflow order is only used by round-robin pool threads
+    if (_args.numThreads != 0 and not _workStealingEnabled)
+    {
+        //a fused group has the order of its first member
+        auto orderOf = [this](void *handle) -> const TaskOrder *
+        {
+            const auto groupIt = _fusedGroups.find(handle);
+            if (groupIt != _fusedGroups.end()) handle = groupIt->second.front();
+            const auto it = _taskOrders.find(handle);
+            return (it == _taskOrders.end())?nullptr:&it->second;
+        };
+
+        //sort by priority then rank, the unordered tasks are visited last
+        auto &tasks = snapshot->ordered;
+        tasks.assign(_handleToTask.begin(), _handleToTask.end());
+        std::stable_sort(tasks.begin(), tasks.end(), [&orderOf](
+            const TaskSnapshot::Entry &a, const TaskSnapshot::Entry &b)
+        {
+            const auto levelA = a.second->priorityLevel.load();
+            const auto levelB = b.second->priorityLevel.load();
+            if (levelA != levelB) return levelA < levelB;
+            const auto orderA = orderOf(a.first);
+            const auto orderB = orderOf(b.first);
+            if (orderA == nullptr) return false;
+            if (orderB == nullptr) return true;
+            return orderA->rank < orderB->rank;
+        });
+        for (const auto &task : tasks)
+        {
+            const auto order = orderOf(task.first);
+            snapshot->components.push_back((order == nullptr)?std::string::npos:order->component);
+        }
+    }
+
+    _taskSnapshot = snapshot;
+    const size_t signature = ++_configurationSignature;
+    this->wakePoolThreads();
+    return signature;
+}
+
+std::vector<TaskSnapshot::Entry> TaskSnapshot::stickyTasks(const size_t index, const size_t numThreads) const
+{
+    //the sticky order keeps the components of this thread and the unordered tasks,
+    //a thread without a component of its own visits all tasks
+    std::vector<Entry> sticky;
+    bool hasComponent = false;
+    for (size_t i = 0; i < ordered.size(); i++)
+    {
+        const bool unordered = components[i] == std::string::npos;
+        const bool mine = not unordered and components[i] % numThreads == index;
+        if (mine) hasComponent = true;
+        if (mine or unordered) sticky.push_back(ordered[i]);
+    }
+    return hasComponent?sticky:ordered;
+}
+
+void ThreadEnvironment::adoptSignature(const size_t index, const size_t signature)
+{
+    {
+        std::lock_guard<std::mutex> lock(_signatureMutex);
+        if (_threadSignatures.size() <= index) _threadSignatures.resize(index+1, 0);
+        _threadSignatures[index] = signature;
+    }
+    _signatureCond.notify_all();
+}
+
+void ThreadEnvironment::waitForSignature(const size_t signature)
+{
+    //the number of running threads only changes with the registration mutex
+    const size_t numThreads = _threadPool.size();
+    std::unique_lock<std::mutex> lock(_signatureMutex);
+    _signatureCond.wait(lock, [&]
+    {
+        for (size_t i = 0; i < numThreads; i++)
+        {
+            if (i >= _threadSignatures.size() or _threadSignatures[i] < signature) return false;
+        }
+        return true;
+    });
+}
+
+void *ThreadEnvironment::findFusedGroup(void *handle)
+{
+    std::lock_guard<std::mutex> lock(_registrationMutex);
+    for (const auto &pair : _fusedGroups)
+    {
+        if (pair.first == handle) return handle;
+        if (std::count(pair.second.begin(), pair.second.end(), handle) != 0) return pair.first;
     }
+    return nullptr;
 }
 
 /*!
- * Thread pool wait and wake-up mechanics:
+ * Thread pool idle mechanics:
  * The goal is to ensure that when wait mode is enabled,
- * threads are not allowed to wait in a task when another
- * task is immediately capable of performing useful work.
+ * threads do not sleep while a task is capable of useful work,
+ * and that an idle pool sleeps without periodic wakeups.
  *
- * Threads are given a chance to wait in a task only after
- * failing to acquire N times, where N is the number of tasks.
- * Once a task is successfully acquired and completed,
- * or once the attempted acquisition with "wait" returns,
- * the failure count reset and the mechanism begins again.
+ * A thread samples the pool activity epoch when it begins a pass,
+ * and once it failed to execute N tasks in a row, where N is the number
+ * of tasks, the pass found no work. When the epoch is unchanged,
+ * no change was flagged on any task since the pass began,
+ * so the thread parks on the pool-wide condition without a timeout.
  *
- * After a thread successfully acquires the task context,
- * it must wake up all other potentially waiting threads.
- * This ensures that threads will be available to process
- * new tasks that are capable of performing useful work.
+ * Every flagged change and timed wakeup bumps the epoch and wakes
+ * one parked thread, which scans the tasks and executes the change.
+ * A task that was busy in another thread during the pass is not lost:
+ * the busy thread is not parked and it visits the task again.
+ * A configuration change wakes all parked threads to adopt it.
  */
 
+void ThreadEnvironment::poolIdleWait(const unsigned long long epoch, const size_t signature)
+{
+    //the parked count is published before the predicate is checked,
+    //and the notifier checks the count after bumping the epoch
+    std::unique_lock<std::mutex> lock(_poolIdleMutex);
+    _numParkedThreads++;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    _poolIdleCond.wait(lock, [&]
+    {
+        return _poolActivity.load(std::memory_order_acquire) != epoch or _configurationSignature != signature;
+    });
+    _numParkedThreads--;
+}
+
+void ThreadEnvironment::wakePoolThreads(void)
+{
+    if (not _poolIdleEnabled) return;
+    {
+        std::lock_guard<std::mutex> lock(_poolIdleMutex);
+    }
+    _poolIdleCond.notify_all();
+}
+
 void ThreadEnvironment::poolProcessLoop(size_t index)
 {
-    this->applyThreadConfig();
+    const auto reservation = this->applyThreadConfig();
+    schedulerTraceSetThreadName("pool thread " + std::to_string(index));
+    HybridSpinState spin(_args.spinBudget);
+    SchedulerCounters counters;
     size_t failAcquireCount = 0;
+    unsigned long long idleEpoch = 0;
     size_t localSignature = 0;
-    std::map<void *, std::shared_ptr<TaskData>> localTasks;
-    auto it = localTasks.end();
+    std::shared_ptr<const TaskSnapshot> snapshot;
+    std::vector<TaskSnapshot::Entry> stickyTasks;
+    const std::vector<TaskSnapshot::Entry> *localTasks(nullptr);
+    std::vector<TaskSnapshot::Entry>::const_iterator it;
 
     while (true)
     {
         //check for a configuration change and update the local state
         if (_configurationSignature != localSignature)
         {
-            std::lock_guard<std::mutex> lock(_handleUpdateMutex);
-            localTasks = _handleToTask;
-            it = localTasks.end();
-            localSignature = _configurationSignature;
+            {
+                std::lock_guard<std::mutex> lock(_handleUpdateMutex);
+                snapshot = _taskSnapshot;
+                localSignature = _configurationSignature;
+            }
             failAcquireCount = 0; //reset fail count
 
             //pool mode, index out of range
-            if (index >= localTasks.size()) return;
+            if (index >= std::min(_numThreads.load(), snapshot->tasks.size()))
+            {
+                this->flushCounters(counters);
+                snapshot.reset();
+                stickyTasks.clear();
+                this->adoptSignature(index, std::numeric_limits<size_t>::max());
+                return;
+            }
+
+            //visit the tasks in dataflow order, the sticky order keeps a subset
+            if (not _stickyTasksEnabled) localTasks = &snapshot->ordered;
+            else
+            {
+                stickyTasks = snapshot->stickyTasks(index, std::min(_numThreads.load(), snapshot->tasks.size()));
+                localTasks = &stickyTasks;
+            }
+            it = localTasks->end();
+            this->adoptSignature(index, localSignature);
         }
 
+        //a full pass without work parks the thread when nothing changed since the pass began
+        if (failAcquireCount >= localTasks->size())
+        {
+            bool park = _waitModeEnabled;
+            if (park and _hybridModeEnabled) park = spin.idle();
+            if (park and _poolActivity.load(std::memory_order_acquire) == idleEpoch)
+            {
+                _numIdleThreads++;
+                const auto waitStart = std::chrono::steady_clock::now();
+                this->poolIdleWait(idleEpoch, localSignature);
+                _idleTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-waitStart).count();
+                _numIdleThreads--;
+                counters.numWaits++;
+                this->flushCounters(counters);
+            }
+            if (park) failAcquireCount = 0; //reset fail count
+        }
+        if (failAcquireCount == 0) idleEpoch = _poolActivity.load(std::memory_order_acquire);
+
         //perform a task and increment
-        if (it == localTasks.end()) it = localTasks.begin();
+        if (it == localTasks->end()) it = localTasks->begin();
         if (not it->second->flag.test_and_set(std::memory_order_acquire))
         {
-            const bool waitOnce = _waitModeEnabled and failAcquireCount >= localTasks.size();
-            if (it->second->task(waitOnce))
+            const auto startCycles = readCycleCounter();
+            const bool executed = it->second->task(false);
+            const auto taskCycles = readCycleCounter() - startCycles;
+            if (executed)
             {
-                //the task was successfully executed, wake all other potential blockers
-                if (_waitModeEnabled) wakeAllBusyTasks(localTasks, it->first);
+                spin.busy();
+                counters.numTasks++;
+                counters.taskCycles += taskCycles;
                 failAcquireCount = 0; //reset fail count
             }
-            else failAcquireCount++;
-            if (waitOnce) failAcquireCount = 0; //reset fail count
+            else
+            {
+                counters.numIdleScans++;
+                counters.scanCycles += taskCycles;
+                failAcquireCount++;
+            }
             it->second->flag.clear(std::memory_order_release);
         }
-        else failAcquireCount++;
+        else
+        {
+            counters.numFailedAcquires++;
+            failAcquireCount++;
+        }
+        this->maybeFlushCounters(counters);
         it++;
     }
 }
 
+void ThreadEnvironment::stopTaskThread(void *handle)
+{
+    //a parked task has no thread of its own
+    _parkedHandles.erase(handle);
+    auto it = _handleToThread.find(handle);
+    if (it == _handleToThread.end()) return;
+    it->second.join();
+    _handleToThread.erase(it);
+}
+
 void ThreadEnvironment::singleProcessLoop(void *handle)
 {
-    this->applyThreadConfig();
+    const auto reservation = this->applyThreadConfig();
+    schedulerTraceSetThreadName("block thread");
+    HybridSpinState spin(_args.spinBudget);
+    SchedulerCounters counters;
+    bool waitOnce = false;
     size_t localSignature = 0;
-    std::map<void *, std::shared_ptr<TaskData>> localTasks;
-    auto it = localTasks.end();
+    std::shared_ptr<TaskData> localTask;
+    auto lastActive = std::chrono::steady_clock::now();
 
     while (true)
     {
-        //check for a configuration change and update the local state
+        //check for a configuration change and update the local state:
+        //only the task for this handle is kept from the snapshot
         if (_configurationSignature != localSignature)
         {
             std::lock_guard<std::mutex> lock(_handleUpdateMutex);
-            localTasks = _handleToTask;
-            it = localTasks.find(handle);
+            const auto it = _taskSnapshot->tasks.find(handle);
             localSignature = _configurationSignature;
 
             //handle mode, handle not in tasks
-            if (it == localTasks.end()) return;
+            if (it == _taskSnapshot->tasks.end())
+            {
+                this->flushCounters(counters);
+                return;
+            }
+            localTask = it->second;
+            localTask->parked = false;
         }
 
         //perform the task
-        it->second->task(_waitModeEnabled);
+        bool executed = false;
+        const bool waitEnabled = _waitModeEnabled and (waitOnce or not _hybridModeEnabled);
+        const auto startCycles = readCycleCounter();
+        if (not _hybridModeEnabled) executed = localTask->task(waitEnabled);
+
+        //hybrid mode: spin then yield before waiting on the task
+        else if ((executed = localTask->task(waitEnabled)))
+        {
+            spin.busy();
+            waitOnce = false;
+        }
+        else waitOnce = spin.idle();
+
+        //a task without work waited for a change when waiting was enabled
+        const auto taskCycles = readCycleCounter() - startCycles;
+        if (executed)
+        {
+            counters.numTasks++;
+            counters.taskCycles += taskCycles;
+        }
+        else if (waitEnabled)
+        {
+            counters.numWaits++;
+            _idleTimeNs.fetch_add((unsigned long long)(taskCycles*cycleCounterPeriod()*1e9), std::memory_order_relaxed);
+        }
+        else
+        {
+            counters.numIdleScans++;
+            counters.scanCycles += taskCycles;
+        }
+        this->maybeFlushCounters(counters);
+
+        //idle for longer than the timeout: park the task on the shared idle thread,
+        //which joins this thread and services the task until it performs work
+        if (_idleTimeout.count() == 0) continue;
+        const auto now = std::chrono::steady_clock::now();
+        if (executed) lastActive = now;
+        else if (now - lastActive > _idleTimeout)
+        {
+            this->flushCounters(counters);
+            localTask->parked = true;
+            {
+                std::lock_guard<std::mutex> lock(_parkMutex);
+                _parkRequests.emplace_back(handle, std::this_thread::get_id());
+            }
+            this->notifyParkedReady();
+            return;
+        }
+    }
+}
+
+void ThreadEnvironment::idleProcessLoop(void)
+{
+    schedulerTraceSetThreadName("idle block thread");
+    size_t localSignature = 0;
+    std::shared_ptr<const TaskSnapshot> snapshot;
+    std::set<void *> parkedHandles, activeHandles;
+
+    while (true)
+    {
+        //check for a configuration change and update the local state
+        if (_configurationSignature != localSignature)
+        {
+            std::lock_guard<std::mutex> lock(_handleUpdateMutex);
+            snapshot = _taskSnapshot;
+            localSignature = _configurationSignature;
+        }
+
+        //move tasks between the dedicated threads and this thread:
+        //skipped while the registration mutex is busy, since the holder
+        //may be waiting on this thread to release the old snapshot
+        std::unique_lock<std::mutex> registrationLock(_registrationMutex, std::try_to_lock);
+        if (registrationLock.owns_lock())
+        {
+            std::vector<std::pair<void *, std::thread::id>> requests;
+            {
+                std::lock_guard<std::mutex> lock(_parkMutex);
+                requests.swap(_parkRequests);
+            }
+
+            //the request is stale when the thread was replaced or stopped
+            for (const auto &request : requests)
+            {
+                auto it = _handleToThread.find(request.first);
+                if (it == _handleToThread.end() or it->second.get_id() != request.second) continue;
+                it->second.join();
+                _handleToThread.erase(it);
+                _parkedHandles.insert(request.first);
+            }
+
+            //a parked task that performed work gets a dedicated thread
+            for (auto handle : activeHandles)
+            {
+                if (_parkedHandles.erase(handle) == 0) continue;
+                _handleToThread[handle] = std::thread(std::bind(&ThreadEnvironment::singleProcessLoop, this, handle));
+            }
+            activeHandles.clear();
+            parkedHandles = _parkedHandles;
+            registrationLock.unlock();
+        }
+
+        //service the parked tasks without waiting inside of a task
+        _parkedReady = false;
+        for (auto handle : parkedHandles)
+        {
+            auto it = snapshot->tasks.find(handle);
+            if (it == snapshot->tasks.end()) continue;
+            if (it->second->task(false)) activeHandles.insert(handle);
+        }
+        if (not activeHandles.empty()) continue;
+
+        //wait for a notification from a parked task or a configuration change
+        std::unique_lock<std::mutex> lock(_readyMutex);
+        _readyCond.wait_for(lock, this->getWaitTimeout(), [&]
+        {
+            return _idleThreadDone or _parkedReady.load() or _configurationSignature != localSignature;
+        });
+        if (_idleThreadDone) break;
+    }
+}
+
+/*!
+ * Work-stealing mechanics:
+ * Rather than polling every task, an actor notifies the environment
+ * when an external change is flagged, which enqueues the task once.
+ * Notifications from a pool thread are pushed to the thread's own
+ * queue to keep the data local, while notifications from outside of
+ * the pool are pushed into a lock-free injection queue. An idle
+ * thread moves the injected tasks into its own queue in a batch.
+ *
+ * Threads service their own queue in order and steal from the other
+ * queues when their queue is empty. Tasks are never allowed to wait
+ * inside of the actor; instead the idle thread waits on behalf of all
+ * queues. A task that did execute is enqueued again to check for
+ * additional work, since the actor only flags internal changes.
+ *
+ * As a safety net for changes that are flagged without a notification,
+ * the first thread re-enqueues every task after an idle period.
+ */
+
+void ThreadEnvironment::notifyReady(TaskData *data)
+{
+    //already enqueued, the pending execution will see the change
+    if (data->queued.test_and_set(std::memory_order_acquire)) return;
+
+    if (not data->registered) return;
+
+    //executor mode: the work item runs the task, there are no pool threads
+    if (_executor) return this->postReadyTask(data);
+    _numReadyTasks++;
+
+    //pool thread: push into the caller's local queue
+    if (currentEnvironment == this)
+    {
+        auto &queue = *_readyQueues[currentQueueIndex];
+        std::lock_guard<Pothos::Util::SpinLock> lock(queue.lock);
+        this->pushReadyTask(queue, data->shared_from_this());
+    }
+
+    //external thread: push into the injection queue without locking
+    else
+    {
+        data->injectedRef = data->shared_from_this();
+        _injectedTasks.push(data);
+    }
+
+    //wake an idle thread to process the task
+    //the mutex orders the notification after the idle thread's predicate check
+    if (_numIdleThreads.load() != 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_readyMutex);
+        }
+        _readyCond.notify_one();
+        _numWakes.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ThreadEnvironment::postReadyTask(TaskData *data)
+{
+    //the work item holds a reference, so unregisterTask() waits for it
+    std::shared_ptr<TaskData> ref(data->shared_from_this());
+    _executor->post([this, ref](void){this->executeReadyTask(ref);});
+}
+
+void ThreadEnvironment::executeReadyTask(const std::shared_ptr<TaskData> &data)
+{
+    //clear the queued state so changes during execution will post again
+    data->queued.clear(std::memory_order_release);
+    if (not data->registered) return;
+
+    //busy in another work item, post to try again later
+    if (data->flag.test_and_set(std::memory_order_acquire))
+    {
+        _numFailedAcquires.fetch_add(1, std::memory_order_relaxed);
+        return this->notifyReady(data.get());
+    }
+
+    //execute without waiting and post again to check for more work
+    const auto startCycles = readCycleCounter();
+    const bool executed = data->task(false);
+    const auto taskCycles = readCycleCounter() - startCycles;
+    data->flag.clear(std::memory_order_release);
+    if (executed)
+    {
+        _numTasks.fetch_add(1, std::memory_order_relaxed);
+        _taskCycles.fetch_add(taskCycles, std::memory_order_relaxed);
+        this->notifyReady(data.get());
+    }
+    else
+    {
+        _numIdleScans.fetch_add(1, std::memory_order_relaxed);
+        _scanCycles.fetch_add(taskCycles, std::memory_order_relaxed);
+    }
+}
+
+void ThreadEnvironment::executorSweepLoop(void)
+{
+    schedulerTraceSetThreadName("executor sweep");
+    std::unique_lock<std::mutex> lock(_sweepMutex);
+    while (not _sweepCond.wait_for(lock, this->getWaitTimeout(), [this]{return _sweepDone;}))
+    {
+        std::shared_ptr<const TaskSnapshot> snapshot;
+        {
+            std::lock_guard<std::mutex> lock0(_handleUpdateMutex);
+            snapshot = _taskSnapshot;
+        }
+        for (const auto &pair : snapshot->tasks) this->notifyReady(pair.second.get());
+    }
+}
+
+void ThreadEnvironment::drainInjectedTasks(const size_t index)
+{
+    //only one consumer at a time, other threads can steal instead
+    if (not _injectedConsumerLock.try_lock()) return;
+
+    auto &queue = *_readyQueues[index];
+    ReadyTaskNode *node(nullptr);
+    while ((node = _injectedTasks.pop()) != nullptr)
+    {
+        auto data = std::move(static_cast<TaskData *>(node)->injectedRef);
+        std::lock_guard<Pothos::Util::SpinLock> lock(queue.lock);
+        this->pushReadyTask(queue, std::move(data));
+    }
+
+    _injectedConsumerLock.unlock();
+}
+
+void ThreadEnvironment::pushReadyTask(ReadyQueue &queue, std::shared_ptr<TaskData> &&data)
+{
+    const auto level = data->priorityLevel.load(std::memory_order_relaxed);
+    auto &tasks = queue.tasks[level];
+    if (tasks.full()) tasks.set_capacity(tasks.capacity()*2);
+    tasks.push_back(std::move(data));
+    _numQueuedTasks[level]++;
+}
+
+void ThreadEnvironment::purgeReadyTask(const std::shared_ptr<TaskData> &data)
+{
+    //the injection queue is drained into a temporary list,
+    //the matching task is dropped and the rest are re-injected
+    {
+        std::lock_guard<Pothos::Util::SpinLock> lock(_injectedConsumerLock);
+        std::vector<TaskData *> others;
+        ReadyTaskNode *node(nullptr);
+        while ((node = _injectedTasks.pop()) != nullptr)
+        {
+            auto task = static_cast<TaskData *>(node);
+            if (task != data.get()) others.push_back(task);
+            else
+            {
+                task->injectedRef.reset();
+                _numReadyTasks--;
+            }
+        }
+        for (auto task : others) _injectedTasks.push(task);
+    }
+
+    for (auto &queue : _readyQueues)
+    {
+        std::lock_guard<Pothos::Util::SpinLock> lock(queue->lock);
+        for (size_t level = 0; level < NumPriorityLevels; level++)
+        {
+            auto &tasks = queue->tasks[level];
+            const size_t numTasks = tasks.size();
+            for (size_t i = 0; i < numTasks; i++)
+            {
+                auto front = std::move(tasks.front());
+                tasks.pop_front();
+                if (front != data) tasks.push_back(std::move(front));
+                else
+                {
+                    _numReadyTasks--;
+                    _numQueuedTasks[level]--;
+                }
+            }
+        }
     }
 }
 
-void ThreadEnvironment::applyThreadConfig(void)
+std::shared_ptr<TaskData> ThreadEnvironment::popReadyTask(const size_t index)
+{
+    std::shared_ptr<TaskData> data;
+    if (_numReadyTasks.load() == 0) return data;
+
+    //move externally notified tasks into the local queue
+    this->drainInjectedTasks(index);
+
+    //check the levels in priority order, so a high priority task
+    //is stolen from another queue before a low priority local task;
+    //within a level, check the local queue first, then steal from the others
+    for (size_t level = 0; level < NumPriorityLevels; level++)
+    {
+        if (_numQueuedTasks[level].load() == 0) continue;
+        for (size_t i = 0; i < _readyQueues.size(); i++)
+        {
+            auto &queue = *_readyQueues[(index+i) % _readyQueues.size()];
+            std::lock_guard<Pothos::Util::SpinLock> lock(queue.lock);
+            auto &tasks = queue.tasks[level];
+            if (tasks.empty()) continue;
+            data = std::move(tasks.front());
+            tasks.pop_front();
+            _numReadyTasks--;
+            _numQueuedTasks[level]--;
+            return data;
+        }
+    }
+    return data;
+}
+
+void ThreadEnvironment::stealingProcessLoop(size_t index)
+{
+    const auto reservation = this->applyThreadConfig();
+    schedulerTraceSetThreadName("stealing thread " + std::to_string(index));
+    currentEnvironment = this;
+    currentQueueIndex = index;
+    HybridSpinState spin(_args.spinBudget);
+    SchedulerCounters counters;
+    size_t localSignature = 0;
+    std::shared_ptr<const TaskSnapshot> snapshot;
+
+    while (true)
+    {
+        //check for a configuration change and update the local state
+        if (_configurationSignature != localSignature)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_handleUpdateMutex);
+                snapshot = _taskSnapshot;
+                localSignature = _configurationSignature;
+            }
+
+            //pool mode, index out of range
+            if (index >= std::min(_numThreads.load(), snapshot->tasks.size())) break;
+            this->adoptSignature(index, localSignature);
+        }
+
+        //nothing ready: wait for a notification or re-enqueue tasks
+        auto data = this->popReadyTask(index);
+        if (not data)
+        {
+            counters.numIdleScans++;
+            this->maybeFlushCounters(counters);
+
+            //hybrid mode: spin then yield before waiting
+            if (_hybridModeEnabled and not spin.idle()) continue;
+
+            bool notified = false;
+            if (_waitModeEnabled)
+            {
+                std::unique_lock<std::mutex> lock(_readyMutex);
+                _numIdleThreads++;
+                const auto waitStart = std::chrono::steady_clock::now();
+                notified = _readyCond.wait_for(lock, std::chrono::milliseconds(1),
+                    [this]{return _numReadyTasks.load() != 0;});
+                _idleTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-waitStart).count();
+                _numIdleThreads--;
+                counters.numWaits++;
+                this->flushCounters(counters);
+            }
+            if (not notified and index == 0)
+            {
+                for (const auto &pair : snapshot->tasks) this->notifyReady(pair.second.get());
+            }
+            continue;
+        }
+
+        //clear the queued state so changes during execution will re-enqueue
+        data->queued.clear(std::memory_order_release);
+        spin.busy();
+
+        //busy in another thread, enqueue to try again later
+        if (data->flag.test_and_set(std::memory_order_acquire))
+        {
+            counters.numFailedAcquires++;
+            this->notifyReady(data.get());
+            continue;
+        }
+
+        //execute without waiting and re-enqueue to check for more work
+        const auto startCycles = readCycleCounter();
+        const bool executed = data->task(false);
+        const auto taskCycles = readCycleCounter() - startCycles;
+        data->flag.clear(std::memory_order_release);
+        if (executed)
+        {
+            counters.numTasks++;
+            counters.taskCycles += taskCycles;
+            this->notifyReady(data.get());
+        }
+        else
+        {
+            counters.numIdleScans++;
+            counters.scanCycles += taskCycles;
+        }
+        this->maybeFlushCounters(counters);
+    }
+
+    this->flushCounters(counters);
+    snapshot.reset();
+    this->adoptSignature(index, std::numeric_limits<size_t>::max());
+    currentEnvironment = nullptr;
+}
+
+/***********************************************************************
+ * Scheduler overhead counters
+ **********************************************************************/
+void ThreadEnvironment::flushCounters(SchedulerCounters &local)
+{
+    _numTasks.fetch_add(local.numTasks, std::memory_order_relaxed);
+    _numIdleScans.fetch_add(local.numIdleScans, std::memory_order_relaxed);
+    _numFailedAcquires.fetch_add(local.numFailedAcquires, std::memory_order_relaxed);
+    _numWaits.fetch_add(local.numWaits, std::memory_order_relaxed);
+    _numWakes.fetch_add(local.numWakes, std::memory_order_relaxed);
+    _taskCycles.fetch_add(local.taskCycles, std::memory_order_relaxed);
+    _scanCycles.fetch_add(local.scanCycles, std::memory_order_relaxed);
+    local = SchedulerCounters();
+}
+
+std::string ThreadEnvironment::queryStats(void) const
+{
+    const auto cyclesToNs = [](const unsigned long long cycles)
+    {
+        return (unsigned long long)(cycles*cycleCounterPeriod()*1e9);
+    };
+    nlohmann::json stats;
+    stats["id"] = std::to_string(size_t(this)); //shared by the blocks in the pool
+    stats["numThreads"] = this->getNumThreads();
+    stats["numTasks"] = _numTasks.load(std::memory_order_relaxed);
+    stats["numIdleScans"] = _numIdleScans.load(std::memory_order_relaxed);
+    stats["numFailedAcquires"] = _numFailedAcquires.load(std::memory_order_relaxed);
+    stats["numWaits"] = _numWaits.load(std::memory_order_relaxed);
+    stats["numWakes"] = _numWakes.load(std::memory_order_relaxed);
+    stats["taskTimeNs"] = cyclesToNs(_taskCycles.load(std::memory_order_relaxed));
+    stats["scanTimeNs"] = cyclesToNs(_scanCycles.load(std::memory_order_relaxed));
+    stats["waitTimeNs"] = _idleTimeNs.load(std::memory_order_relaxed);
+    stats["elapsedNs"] = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - _timeCreated).count();
+    return stats.dump();
+}
+
+std::unique_ptr<AffinityReservation> ThreadEnvironment::applyThreadConfig(void)
 {
     //set priority -- log message only on first failure
     {
-        const auto errorMsg = ThreadEnvironment::setPriority(_args.priority);
+        const auto errorMsg = ThreadEnvironment::setPriority(_args);
         static bool showErrorMsg = true;
         if (not errorMsg.empty() and showErrorMsg)
         {
@@ -255,4 +1359,20 @@ void ThreadEnvironment::applyThreadConfig(void)
             poco_error_f1(Poco::Logger::get("Pothos.ThreadPool"), "Failed to set NUMA affinity %s", errorMsg);
         }
     }
+
+    //set the planned CPU affinity -- log message only on first failure
+    std::unique_ptr<AffinityReservation> reservation;
+    if (_args.affinityMode == "AUTO")
+    {
+        reservation.reset(new AffinityReservation(_autoAffinityNode));
+        std::string errorMsg;
+        if (reservation->cpu >= 0) errorMsg = ThreadEnvironment::setCPUAffinity({size_t(reservation->cpu)});
+        static bool showErrorMsg = true;
+        if (not errorMsg.empty() and showErrorMsg)
+        {
+            showErrorMsg = false;
+            poco_error_f1(Poco::Logger::get("Pothos.ThreadPool"), "Failed to set AUTO affinity %s", errorMsg);
+        }
+    }
+    return reservation;
 }
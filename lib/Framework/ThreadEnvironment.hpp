@@ -1,36 +1,323 @@
-// Copyright (c) 2015-2015 Josh Blum
+// Copyright (c) 2015-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #pragma once
 #include <Pothos/Config.hpp>
 #include <Pothos/Framework/ThreadPool.hpp>
+#include <Pothos/Util/SpinLock.hpp>
+#include <Pothos/Util/RingDeque.hpp>
+#include "Framework/ReadyTaskQueue.hpp"
+#include "Framework/AffinityPlanner.hpp"
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <functional>
 #include <atomic>
 #include <thread>
+#include <chrono>
 #include <vector>
 #include <map>
+#include <set>
+#include <algorithm> //min/max
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h> //_mm_pause
+#endif
+
+class ThreadEnvironment;
+struct FusedTaskGroup;
+
+/*!
+ * The number of scheduling priority levels in the ready queues.
+ * Level 0 holds the high priority tasks, and the last level the low.
+ */
+static const size_t NumPriorityLevels = 3;
+
+//! Map a block scheduling priority to a ready queue level
+static inline size_t priorityToLevel(const int priority)
+{
+    return size_t(1-std::min(std::max(priority, -1), 1));
+}
 
 /*!
  * Storage container for a worker task and an atomic flag.
  * The flag is used for exclusive access in pool mode.
  */
-struct TaskData
+struct TaskData : ReadyTaskNode, std::enable_shared_from_this<TaskData>
 {
     typedef std::function<bool(bool)> Task;
     typedef std::function<void(void)> Wake;
 
-    TaskData(const Task task, const Wake wake):
+    TaskData(ThreadEnvironment *env, const Task task, const Wake wake, const bool queueDriven):
+        env(env),
         task(task),
-        wake(wake)
+        wake(wake),
+        queueDriven(queueDriven),
+        registered(true),
+        fusedInto(nullptr),
+        priorityLevel(priorityToLevel(0)),
+        parked(false)
     {
         flag.clear(std::memory_order_release);
+        queued.clear(std::memory_order_release);
     }
 
+    /*!
+     * Notify that the task has a flagged change:
+     * Enqueue this task into the environment's ready queues,
+     * or notify the group task when this task is fused.
+     */
+    void notifyReady(void);
+
+    ThreadEnvironment *env;
     Task task;
     Wake wake;
     std::atomic_flag flag;
+
+    //! True when the environment uses the ready queues
+    const bool queueDriven;
+
+    //! Set while the task is held in a ready queue
+    std::atomic_flag queued;
+
+    //! Cleared when unregistered to block further enqueuing
+    std::atomic<bool> registered;
+
+    //! Holds a reference while the task is in the injection queue
+    std::shared_ptr<TaskData> injectedRef;
+
+    //! The task that drives this task in a fused group (or null)
+    std::atomic<TaskData *> fusedInto;
+
+    //! The fused members when this task drives a group (or null)
+    std::shared_ptr<FusedTaskGroup> group;
+
+    //! The ready queue level from the scheduling priority
+    std::atomic<size_t> priorityLevel;
+
+    //! Set while the task is serviced by the shared idle thread
+    std::atomic<bool> parked;
+};
+
+/*!
+ * A fused group executes its member tasks back to back in one task,
+ * in the order of the members, so that a chain of blocks runs on one
+ * thread while the buffers between the blocks are still in cache.
+ * Members notify the group when a change is flagged on their actor,
+ * so the group task can wait once on behalf of all of its members.
+ * A static schedule repeats each member by its entry in the repetitions,
+ * so that one pass of a fixed-rate chain balances its production and
+ * consumption without a scheduler visit per work() call.
+ */
+struct FusedTaskGroup
+{
+    FusedTaskGroup(const std::vector<std::shared_ptr<TaskData>> &members, const std::chrono::microseconds &timeout,
+        const std::vector<size_t> &repetitions = std::vector<size_t>()):
+        members(members),
+        repetitions(repetitions),
+        timeout(timeout),
+        changed(false),
+        waiting(false)
+    {
+        return;
+    }
+
+    //! Run each member by its repetitions, wait for a change when none executed
+    bool run(const bool waitEnabled)
+    {
+        changed.exchange(false, std::memory_order_acquire);
+        bool executed = false;
+        for (size_t i = 0; i < members.size(); i++)
+        {
+            //a repetition that did not execute ends the member's turn early
+            const size_t reps = repetitions.empty()?1:repetitions[i];
+            for (size_t r = 0; r < reps; r++)
+            {
+                if (not members[i]->task(false)) break;
+                executed = true;
+            }
+        }
+        if (executed or not waitEnabled) return executed;
+
+        //the waiting flag is published before the predicate is checked,
+        //and the notifier checks the flag after marking the change
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cond.wait_for(lock, timeout, [this]{return changed.load(std::memory_order_acquire);});
+        waiting.store(false, std::memory_order_relaxed);
+        return false;
+    }
+
+    //! Mark a change and wake the group task when its waiting
+    void notify(void)
+    {
+        changed.store(true, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (not waiting.load(std::memory_order_relaxed)) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        cond.notify_all();
+    }
+
+    //! Wake the group and any member that waits from before the fusion
+    void wake(void)
+    {
+        for (const auto &member : members) member->wake();
+        this->notify();
+    }
+
+    const std::vector<std::shared_ptr<TaskData>> members;
+    const std::vector<size_t> repetitions; //!< empty to run each member once
+    const std::chrono::microseconds timeout;
+    std::atomic<bool> changed;
+    std::atomic<bool> waiting;
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+/*!
+ * The position of a task in the dataflow graph.
+ * Used to order the tasks visited by round-robin pool threads.
+ */
+struct TaskOrder
+{
+    size_t rank; //!< the topological rank: producers before consumers
+    size_t component; //!< the connected component of the dataflow graph
+};
+
+/*!
+ * An immutable snapshot of the registered tasks.
+ * The snapshot is published upon each configuration change,
+ * and the threads share the published snapshot without copying:
+ * a thread holds its snapshot until it adopts the next change.
+ */
+struct TaskSnapshot
+{
+    typedef std::pair<void *, std::shared_ptr<TaskData>> Entry;
+
+    //! All tasks by handle
+    std::map<void *, std::shared_ptr<TaskData>> tasks;
+
+    //! The tasks in priority and dataflow order (round-robin pool mode)
+    std::vector<Entry> ordered;
+
+    //! The component of each ordered task, or npos when unordered
+    std::vector<size_t> components;
+
+    //! Get the ordered tasks visited by one thread in the sticky order
+    std::vector<Entry> stickyTasks(const size_t index, const size_t numThreads) const;
+};
+
+/*!
+ * A queue of tasks that are ready to be executed.
+ * Used by the work-stealing scheduler: one queue per thread,
+ * with a separate list of tasks for each priority level.
+ */
+struct ReadyQueue
+{
+    Pothos::Util::SpinLock lock;
+    Pothos::Util::RingDeque<std::shared_ptr<TaskData>> tasks[NumPriorityLevels];
+};
+
+/*!
+ * Hint to the CPU that the caller is in a spin-wait loop.
+ */
+static inline void cpuRelax(void)
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/*!
+ * Adaptive spin state for the HYBRID yield mode (one per thread).
+ * An idle thread spins with a CPU pause for up to the spin budget,
+ * then yields its time slice for a few attempts, and only then waits.
+ * The budget adapts to the recent wake intervals: it doubles when work
+ * arrives during the spin phase, and halves when the thread went through
+ * both spin and yield phases without work and ends up waiting.
+ */
+class HybridSpinState
+{
+public:
+    HybridSpinState(const size_t maxBudget):
+        _maxBudget(std::max<size_t>(maxBudget, MinBudget)),
+        _budget(_maxBudget),
+        _count(0)
+    {
+        return;
+    }
+
+    /*!
+     * Called after an attempt that found no work.
+     * The call spins or yields depending upon the phase.
+     * \return true when the caller should wait for a change
+     */
+    bool idle(void)
+    {
+        _count++;
+        if (_count <= _budget)
+        {
+            cpuRelax();
+            return false;
+        }
+        if (_count <= _budget + YieldCount)
+        {
+            std::this_thread::yield();
+            return false;
+        }
+        _budget = std::max<size_t>(_budget/2, MinBudget);
+        _count = 0;
+        return true;
+    }
+
+    //! Called after an attempt that found work
+    void busy(void)
+    {
+        if (_count != 0 and _count <= _budget) _budget = std::min(_budget*2, _maxBudget);
+        _count = 0;
+    }
+
+private:
+    static const size_t MinBudget = 16;
+    static const size_t YieldCount = 16;
+    const size_t _maxBudget;
+    size_t _budget;
+    size_t _count;
+};
+
+/*!
+ * Scheduler overhead counters of one thread loop.
+ * The counters are accumulated locally without atomics,
+ * and flushed into the environment totals at a low rate.
+ */
+struct SchedulerCounters
+{
+    SchedulerCounters(void):
+        numTasks(0),
+        numIdleScans(0),
+        numFailedAcquires(0),
+        numWaits(0),
+        numWakes(0),
+        taskCycles(0),
+        scanCycles(0),
+        numPending(0)
+    {
+        return;
+    }
+
+    unsigned long long numTasks; //!< task calls that performed work
+    unsigned long long numIdleScans; //!< task calls or ready queue polls without work
+    unsigned long long numFailedAcquires; //!< tasks that were busy in another thread
+    unsigned long long numWaits; //!< waits for a change
+    unsigned long long numWakes; //!< wakeups of threads that wait for a change
+    unsigned long long taskCycles; //!< cycle counter ticks in task calls with work
+    unsigned long long scanCycles; //!< cycle counter ticks in task calls without work
+    size_t numPending; //!< loop iterations since the last flush
 };
 
 /*!
@@ -40,7 +327,8 @@ struct TaskData
 class ThreadEnvironment
 {
 public:
-    ThreadEnvironment(const Pothos::ThreadPoolArgs &args);
+    ThreadEnvironment(const Pothos::ThreadPoolArgs &args,
+        const std::shared_ptr<Pothos::ThreadPoolExecutor> &executor = std::shared_ptr<Pothos::ThreadPoolExecutor>());
 
     ~ThreadEnvironment(void);
 
@@ -49,21 +337,91 @@ public:
      * \param handle a unique handle representing the caller
      * \param task a function pointer to the handle worker task
      * \param wake a function pointer to wake a worker task
+     * \return the task data for ready notifications
      */
-    void registerTask(void *handle, TaskData::Task task, TaskData::Wake wake);
+    TaskData *registerTask(void *handle, TaskData::Task task, TaskData::Wake wake);
 
     /*!
      * Unregister the task from the thread environment.
+     * A fused member is restored from its group before unregistering,
+     * and unregistering a group handle is the same as unfuseTasks().
      * \param handle the unique handle used to register
      */
     void unregisterTask(void *handle);
 
+    /*!
+     * Replace the registered tasks of the members with one group task.
+     * The group task executes the member tasks back to back in order.
+     * Ready notifications of the members are forwarded to the group.
+     * \throws InvalidArgumentException when a member is not registered
+     * \param handle a unique handle representing the group
+     * \param members the handles of registered tasks in execution order
+     * \param repetitions the task calls per member and pass, or empty for one each
+     */
+    void fuseTasks(void *handle, const std::vector<void *> &members,
+        const std::vector<size_t> &repetitions = std::vector<size_t>());
+
+    /*!
+     * Set the dataflow order of registered tasks.
+     * Round-robin pool threads visit the tasks in rank order,
+     * so that a producer is followed by its consumers.
+     * In the sticky task order, each component is serviced by one thread.
+     * The component numbers are only compared within one call.
+     * \param orders a map of task handle to the dataflow order
+     */
+    void setTaskOrders(const std::map<void *, TaskOrder> &orders);
+
+    /*!
+     * Set the scheduling priority of a registered task.
+     * The work-stealing scheduler executes ready tasks in priority order,
+     * and round-robin pool threads visit higher priority tasks first.
+     * A fused group has the highest priority of its members.
+     * \param handle the unique handle used to register
+     * \param priority 1 for high, 0 for normal, -1 for low priority
+     */
+    void setTaskPriority(void *handle, const int priority);
+
+    /*!
+     * Restore the member tasks of a fused group and remove the group task.
+     * This call has no effect when the group is no longer fused.
+     * \param handle the unique handle used to fuse the group
+     */
+    void unfuseTasks(void *handle);
+
+    //! Do the tasks run as work items of an external executor?
+    bool hasExecutor(void) const
+    {
+        return bool(_executor);
+    }
+
     //! Query the thread pool construction args
     const Pothos::ThreadPoolArgs &getArgs(void) const
     {
         return _args;
     }
 
+    /*!
+     * Change the number of threads in pool mode.
+     * With autoscaling, the number is the new minimum.
+     * \param numThreads the new number of threads (greater than 0)
+     */
+    void setNumThreads(const size_t numThreads);
+
+    /*!
+     * The NUMA node that the threads run on for the buffer placement.
+     * \return the node in the AUTO affinity mode, otherwise -1
+     */
+    long getAutoAffinityNode(void) const
+    {
+        return _autoAffinityNode;
+    }
+
+    //! Get the current number of threads (0 in thread per task mode)
+    size_t getNumThreads(void) const
+    {
+        return _numThreads.load();
+    }
+
     /*!
      * Is waiting allowed within an task?
      */
@@ -72,7 +430,85 @@ public:
         return _waitModeEnabled;
     }
 
+    /*!
+     * The maximum time that a task should wait for a change.
+     * Waits are woken precisely when a change is flagged,
+     * but in work-stealing pool mode a thread waits on the ready queues
+     * on behalf of all tasks and periodically checks the others.
+     * Round-robin pool threads park without a timeout instead.
+     */
+    std::chrono::microseconds getWaitTimeout(void) const
+    {
+        if (_args.numThreads != 0) return std::chrono::milliseconds(1);
+        return std::chrono::milliseconds(100);
+    }
+
+    /*!
+     * Mark activity for the round-robin pool threads.
+     * A change flagged on any task ends the pool-wide idle state,
+     * and one parked thread is woken to scan the tasks again.
+     */
+    void notifyPoolActivity(void)
+    {
+        if (not _poolIdleEnabled) return;
+        _poolActivity.fetch_add(1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_numParkedThreads.load(std::memory_order_relaxed) == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(_poolIdleMutex);
+        }
+        _poolIdleCond.notify_one();
+        _numWakes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! Wake the shared idle thread to check the parked tasks
+    void notifyParkedReady(void)
+    {
+        if (_parkedReady.exchange(true)) return;
+        {
+            std::lock_guard<std::mutex> lock(_readyMutex);
+        }
+        _readyCond.notify_all();
+    }
+
+    /*!
+     * Enqueue a task that has a flagged change.
+     * Only used by the work-stealing scheduler.
+     * The task is not enqueued when its already pending.
+     */
+    void notifyReady(TaskData *data);
+
+    /*!
+     * Schedule a timed wakeup for a registered task.
+     * The notify function is called by the timer thread when due,
+     * a new wakeup replaces the pending wakeup of the same handle.
+     * The timer thread is started upon the first scheduled wakeup.
+     * \param handle the unique handle used to register
+     * \param when the time of the wakeup
+     * \param notify the function to flag the task
+     */
+    void scheduleWakeup(void *handle, const std::chrono::steady_clock::time_point &when, const std::function<void(void)> &notify);
+
+    //! Cancel the pending wakeup of the handle, no notify is in progress upon return
+    void cancelWakeup(void *handle);
+
+    /*!
+     * Query the scheduler overhead counters as a JSON object.
+     * The counters are flushed by the threads at a low rate,
+     * so the totals can lag behind by a fraction of a millisecond.
+     */
+    std::string queryStats(void) const;
+
 private:
+    //! Add the local counters into the totals and reset them
+    void flushCounters(SchedulerCounters &local);
+
+    //! Flush the local counters after a number of loop iterations
+    void maybeFlushCounters(SchedulerCounters &local)
+    {
+        if (++local.numPending >= 1024) this->flushCounters(local);
+    }
+
     /*!
      * Process loop used in thread pool mode:
      * The index specifies the thread index.
@@ -87,14 +523,96 @@ private:
      */
     void singleProcessLoop(void *handle);
 
+    /*!
+     * Process loop used in work-stealing mode:
+     * The thread services tasks from its own ready queue,
+     * and steals tasks from other queues when its empty.
+     * If the index is out of range given
+     * the number of handles, the thread exits.
+     */
+    void stealingProcessLoop(size_t index);
+
+    /*!
+     * Process loop for the idle tasks in thread per task mode:
+     * Tasks that were idle for longer than the idle timeout
+     * are parked and serviced by this single shared thread,
+     * a parked task that performs work gets its own thread back.
+     */
+    void idleProcessLoop(void);
+
+    //! Stop the thread of a task in thread per task mode, call with the registration mutex
+    void stopTaskThread(void *handle);
+
+    //! Post a work item to the executor that runs the ready task once
+    void postReadyTask(TaskData *data);
+
+    //! Execute a ready task from a work item of the executor
+    void executeReadyTask(const std::shared_ptr<TaskData> &data);
+
+    /*!
+     * Notify all tasks periodically in executor mode:
+     * The work-stealing threads check the tasks when idle,
+     * and this loop stands in for them without threads of the pool.
+     */
+    void executorSweepLoop(void);
+
+    //! Pop a ready task from the local queue or steal from another
+    std::shared_ptr<TaskData> popReadyTask(const size_t index);
+
+    //! Move injected tasks into the local queue (skipped when busy)
+    void drainInjectedTasks(const size_t index);
+
+    //! Remove all references to the task from the ready queues
+    void purgeReadyTask(const std::shared_ptr<TaskData> &data);
+
+    //! Start or stop pool threads to match the number of tasks
+    void resizeThreadPool(void);
+
+    //! Change the number of pool threads, call with the registration mutex
+    void resizeNumThreads(const size_t numThreads);
+
+    //! Add or remove threads based on the measured idle time
+    void autoscaleLoop(void);
+
+    //! Notify the tasks with timed wakeups when they are due
+    void wakeupLoop(void);
+
+    //! Publish a snapshot of the tasks and bump the signature, call with the handle update mutex
+    size_t publishTasks(void);
+
+    //! Park a round-robin pool thread until activity since the epoch or a configuration change
+    void poolIdleWait(const unsigned long long epoch, const size_t signature);
+
+    //! Wake all of the parked round-robin pool threads to check the configuration
+    void wakePoolThreads(void);
+
+    //! Record the configuration signature adopted by a pool thread
+    void adoptSignature(const size_t index, const size_t signature);
+
+    //! Wait until every running pool thread adopted the signature, call with the registration mutex
+    void waitForSignature(const size_t signature);
+
+    //! Get the group handle that holds the handle, the handle itself if a group, or null
+    void *findFusedGroup(void *handle);
+
+    //! Set the level of each group from its members, call with the handle update mutex
+    void updateGroupPriorities(void);
+
+    //! Push a ready task onto a queue in its priority level, call with the queue lock
+    void pushReadyTask(ReadyQueue &queue, std::shared_ptr<TaskData> &&data);
+
     /*!
      * Apply priority and affinity to the caller.
      * This call uses the thread config in _args.
+     * \return the CPU reservation held by the thread in the AUTO affinity mode
      */
-    void applyThreadConfig(void);
+    std::unique_ptr<AffinityReservation> applyThreadConfig(void);
 
-    //! Set thread prio - return error message
-    static std::string setPriority(const double prio);
+    //! Set thread prio and realtime policy from the args - return error message
+    static std::string setPriority(const Pothos::ThreadPoolArgs &args);
+
+    //! Request the CPU DMA latency until the hold is released - return error message
+    static std::string holdCPUDmaLatency(const int latency, std::shared_ptr<void> &hold);
 
     //! Set CPU affinity - return error message
     static std::string setCPUAffinity(const std::vector<size_t> &affinity);
@@ -108,12 +626,42 @@ private:
     //whether or not waiting is allowed based on args
     bool _waitModeEnabled;
 
+    //spin and yield before waiting when idle
+    const bool _hybridModeEnabled;
+
+    //use ready queues instead of round-robin polling
+    const bool _workStealingEnabled;
+
+    //the CPU DMA latency request held for the lifetime of the pool
+    std::shared_ptr<void> _cpuDmaLatencyHold;
+
+    //the preferred node of the AUTO affinity mode or -1
+    const long _autoAffinityNode;
+
+    //assign each dataflow component to one round-robin thread
+    const bool _stickyTasksEnabled;
+
     //map of handle handles to tasks
     std::map<void *, std::shared_ptr<TaskData>> _handleToTask;
 
+    //map of fused group handles to the member handles
+    std::map<void *, std::vector<void *>> _fusedGroups;
+
+    //dataflow order of the task handles and the next unique component
+    std::map<void *, TaskOrder> _taskOrders;
+    size_t _nextComponent;
+
     //configuration signature (changed when handle list changed)
     std::atomic<size_t> _configurationSignature;
 
+    //the published snapshot of the tasks (protected by the handle update mutex)
+    std::shared_ptr<const TaskSnapshot> _taskSnapshot;
+
+    //the signature adopted by each pool thread, and the waiters for adoption
+    std::vector<size_t> _threadSignatures;
+    std::mutex _signatureMutex;
+    std::condition_variable _signatureCond;
+
     //mutex for protecting handle registration
     std::mutex _registrationMutex;
 
@@ -125,4 +673,87 @@ private:
 
     //per-thread process loop done flags (used in thread pool mode)
     std::vector<std::thread> _threadPool;
+
+    //per-thread ready queues (used in work-stealing mode)
+    std::vector<std::unique_ptr<ReadyQueue>> _readyQueues;
+
+    //lock-free queue for notifications from outside of the pool
+    ReadyTaskQueue _injectedTasks;
+    Pothos::Util::SpinLock _injectedConsumerLock;
+    std::atomic<size_t> _numReadyTasks;
+
+    //number of queued tasks per level, the injection queue is not included
+    std::atomic<size_t> _numQueuedTasks[NumPriorityLevels];
+
+    //number of threads waiting for work (used in all pool modes)
+    std::atomic<size_t> _numIdleThreads;
+
+    //the pool-wide idle state of the round-robin threads: the threads park on one
+    //condition when a full pass found no work, and the activity epoch ends the state
+    const bool _poolIdleEnabled;
+    std::atomic<unsigned long long> _poolActivity;
+    std::atomic<size_t> _numParkedThreads;
+    std::mutex _poolIdleMutex;
+    std::condition_variable _poolIdleCond;
+    std::mutex _readyMutex;
+    std::condition_variable _readyCond;
+
+    //the current and the minimum number of pool threads
+    std::atomic<size_t> _numThreads;
+    std::atomic<size_t> _minThreads;
+
+    //accumulated time that pool threads waited for work
+    std::atomic<unsigned long long> _idleTimeNs;
+
+    //scheduler overhead totals flushed from the thread loops
+    std::atomic<unsigned long long> _numTasks;
+    std::atomic<unsigned long long> _numIdleScans;
+    std::atomic<unsigned long long> _numFailedAcquires;
+    std::atomic<unsigned long long> _numWaits;
+    std::atomic<unsigned long long> _numWakes;
+    std::atomic<unsigned long long> _taskCycles;
+    std::atomic<unsigned long long> _scanCycles;
+    const std::chrono::steady_clock::time_point _timeCreated;
+
+    //idle tasks serviced by the shared thread (used in thread per task mode)
+    const std::chrono::nanoseconds _idleTimeout;
+    std::set<void *> _parkedHandles; //protected by the registration mutex
+    std::vector<std::pair<void *, std::thread::id>> _parkRequests;
+    std::mutex _parkMutex;
+    std::atomic<bool> _parkedReady;
+    bool _idleThreadDone; //protected by the ready mutex
+    std::thread _idleThread;
+
+    //autoscaling thread (used when maxThreads is greater than numThreads)
+    bool _autoscaleDone;
+    std::mutex _autoscaleMutex;
+    std::condition_variable _autoscaleCond;
+    std::thread _autoscaleThread;
+
+    //the external executor that runs the ready tasks, and its sweep thread
+    const std::shared_ptr<Pothos::ThreadPoolExecutor> _executor;
+    bool _sweepDone;
+    std::mutex _sweepMutex;
+    std::condition_variable _sweepCond;
+    std::thread _sweepThread;
+
+    //timed wakeups ordered by time (the thread starts upon the first wakeup)
+    typedef std::multimap<std::chrono::steady_clock::time_point, std::pair<void *, std::function<void(void)>>> WakeupTimes;
+    WakeupTimes _wakeupTimes;
+    std::map<void *, WakeupTimes::iterator> _wakeupHandles;
+    bool _wakeupDone;
+    std::mutex _wakeupMutex;
+    std::condition_variable _wakeupCond;
+    std::thread _wakeupThread;
 };
+
+inline void TaskData::notifyReady(void)
+{
+    //a fused member notifies the task that drives its group
+    auto fused = fusedInto.load(std::memory_order_acquire);
+    if (fused != nullptr) return fused->notifyReady();
+    if (group) group->notify();
+    if (queueDriven) env->notifyReady(this);
+    else env->notifyPoolActivity();
+    if (parked.load(std::memory_order_acquire)) env->notifyParkedReady();
+}
@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/ThreadPool.hpp>
@@ -10,35 +10,71 @@ using json = nlohmann::json;
 
 Pothos::ThreadPoolArgs::ThreadPoolArgs(void):
     numThreads(0),
-    priority(0.0)
+    maxThreads(0),
+    idleTimeout(0.0),
+    priority(0.0),
+    deadlineRuntime(0.0),
+    deadline(0.0),
+    deadlinePeriod(0.0),
+    cpuDmaLatency(-1),
+    spinBudget(4096)
 {
     return;
 }
 
 Pothos::ThreadPoolArgs::ThreadPoolArgs(const size_t numThreads):
     numThreads(numThreads),
-    priority(0.0)
+    maxThreads(0),
+    idleTimeout(0.0),
+    priority(0.0),
+    deadlineRuntime(0.0),
+    deadline(0.0),
+    deadlinePeriod(0.0),
+    cpuDmaLatency(-1),
+    spinBudget(4096)
 {
     return;
 }
 
 Pothos::ThreadPoolArgs::ThreadPoolArgs(const std::string &jsonStr):
     numThreads(0),
-    priority(0.0)
+    maxThreads(0),
+    idleTimeout(0.0),
+    priority(0.0),
+    deadlineRuntime(0.0),
+    deadline(0.0),
+    deadlinePeriod(0.0),
+    cpuDmaLatency(-1),
+    spinBudget(4096)
 {
     //parse to JSON object
     const auto topObj = json::parse(jsonStr);
 
     //parse out the optional fields
     this->numThreads = topObj.value("numThreads", 0);
+    this->maxThreads = topObj.value("maxThreads", 0);
+    this->idleTimeout = topObj.value("idleTimeout", 0.0);
     this->priority = topObj.value("priority", 0.0);
+    this->realtimePolicy = topObj.value("realtimePolicy", "");
+    this->deadlineRuntime = topObj.value("deadlineRuntime", 0.0);
+    this->deadline = topObj.value("deadline", 0.0);
+    this->deadlinePeriod = topObj.value("deadlinePeriod", 0.0);
+    this->cpuDmaLatency = topObj.value("cpuDmaLatency", -1);
     this->affinityMode = topObj.value("affinityMode", "");
     this->yieldMode = topObj.value("yieldMode", "");
+    this->schedulerMode = topObj.value("schedulerMode", "");
+    this->taskOrder = topObj.value("taskOrder", "");
+    this->spinBudget = topObj.value("spinBudget", this->spinBudget);
 
     //parse out the affinity list
     this->affinity = topObj.value("affinity", std::vector<size_t>());
 }
 
+Pothos::ThreadPoolExecutor::~ThreadPoolExecutor(void)
+{
+    return;
+}
+
 Pothos::ThreadPool::ThreadPool(void)
 {
     return;
@@ -50,13 +86,16 @@ Pothos::ThreadPool::ThreadPool(const std::shared_ptr<void> &impl):
     return;
 }
 
-Pothos::ThreadPool::ThreadPool(const ThreadPoolArgs &args)
+static void validateThreadPoolArgs(const Pothos::ThreadPoolArgs &args)
 {
+    using Pothos::ThreadPoolError;
+
     //validate the arguments
     if (args.affinityMode.empty()){}
     else if (args.affinityMode == "ALL"){}
     else if (args.affinityMode == "CPU"){}
     else if (args.affinityMode == "NUMA"){}
+    else if (args.affinityMode == "AUTO"){}
     else throw ThreadPoolError("Pothos::ThreadPool()", "unknown affinityMode " + args.affinityMode);
 
     //validate the yield strategy
@@ -66,16 +105,88 @@ Pothos::ThreadPool::ThreadPool(const ThreadPoolArgs &args)
     else if (args.yieldMode == "SPIN"){}
     else throw ThreadPoolError("Pothos::ThreadPool()", "unknown yieldMode " + args.yieldMode);
 
+    //validate the scheduler strategy
+    if (args.schedulerMode.empty()){}
+    else if (args.schedulerMode == "ROUND_ROBIN"){}
+    else if (args.schedulerMode == "WORK_STEALING"){}
+    else throw ThreadPoolError("Pothos::ThreadPool()", "unknown schedulerMode " + args.schedulerMode);
+
+    //validate the task order
+    if (args.taskOrder.empty()){}
+    else if (args.taskOrder == "TOPOLOGICAL"){}
+    else if (args.taskOrder == "STICKY"){}
+    else throw ThreadPoolError("Pothos::ThreadPool()", "unknown taskOrder " + args.taskOrder);
+
     //validate the thread priority
     if (args.priority > +1.0 or args.priority < -1.0)
     {
         throw ThreadPoolError("Pothos::ThreadPool()", "priority out of range " + std::to_string(args.priority));
     }
 
+    //validate the realtime policy
+    if (args.realtimePolicy.empty()){}
+    else if (args.realtimePolicy == "RR"){}
+    else if (args.realtimePolicy == "FIFO"){}
+    else if (args.realtimePolicy == "DEADLINE"){}
+    else throw ThreadPoolError("Pothos::ThreadPool()", "unknown realtimePolicy " + args.realtimePolicy);
+
+    //validate the deadline parameters: runtime <= deadline <= period
+    if (args.realtimePolicy == "DEADLINE")
+    {
+        const auto deadline = (args.deadline == 0.0)?args.deadlinePeriod:args.deadline;
+        if (args.deadlineRuntime <= 0.0 or args.deadlinePeriod <= 0.0)
+        {
+            throw ThreadPoolError("Pothos::ThreadPool()", "DEADLINE requires positive deadlineRuntime and deadlinePeriod");
+        }
+        if (args.deadlineRuntime > deadline or deadline > args.deadlinePeriod)
+        {
+            throw ThreadPoolError("Pothos::ThreadPool()", "DEADLINE requires deadlineRuntime <= deadline <= deadlinePeriod");
+        }
+    }
+
+    //validate the autoscaling range
+    if (args.maxThreads != 0 and args.numThreads == 0)
+    {
+        throw ThreadPoolError("Pothos::ThreadPool()", "maxThreads requires pool-mode numThreads > 0");
+    }
+    if (args.maxThreads != 0 and args.maxThreads < args.numThreads)
+    {
+        throw ThreadPoolError("Pothos::ThreadPool()", "maxThreads less than numThreads " + std::to_string(args.maxThreads));
+    }
+
+    //validate the idle timeout
+    if (args.idleTimeout < 0.0)
+    {
+        throw ThreadPoolError("Pothos::ThreadPool()", "idleTimeout must not be negative " + std::to_string(args.idleTimeout));
+    }
+    if (args.idleTimeout > 0.0 and args.numThreads != 0)
+    {
+        throw ThreadPoolError("Pothos::ThreadPool()", "idleTimeout requires the thread-per-block numThreads = 0");
+    }
+}
+
+Pothos::ThreadPool::ThreadPool(const ThreadPoolArgs &args)
+{
+    validateThreadPoolArgs(args);
+
     //safe to create the thread environment
     _impl.reset(new ThreadEnvironment(args));
 }
 
+Pothos::ThreadPool::ThreadPool(const ThreadPoolArgs &args, const std::shared_ptr<ThreadPoolExecutor> &executor)
+{
+    if (not executor) throw ThreadPoolError("Pothos::ThreadPool()", "null executor");
+
+    //the executor owns the threads that run the tasks
+    if (args.maxThreads != 0 or args.idleTimeout != 0.0)
+    {
+        throw ThreadPoolError("Pothos::ThreadPool()", "maxThreads and idleTimeout do not apply to an executor");
+    }
+
+    validateThreadPoolArgs(args);
+    _impl.reset(new ThreadEnvironment(args, executor));
+}
+
 Pothos::ThreadPool::operator bool(void) const
 {
     return bool(_impl);
@@ -86,6 +197,31 @@ const std::shared_ptr<void> &Pothos::ThreadPool::getContainer(void) const
     return _impl;
 }
 
+void Pothos::ThreadPool::setNumThreads(const size_t numThreads)
+{
+    if (not _impl) throw ThreadPoolError("Pothos::ThreadPool::setNumThreads()", "null thread pool");
+    auto env = std::static_pointer_cast<ThreadEnvironment>(_impl);
+    if (env->getArgs().numThreads == 0) throw ThreadPoolError(
+        "Pothos::ThreadPool::setNumThreads()", "cannot resize a thread-per-block pool");
+    if (env->hasExecutor()) throw ThreadPoolError(
+        "Pothos::ThreadPool::setNumThreads()", "cannot resize a pool with an executor");
+    if (numThreads == 0) throw ThreadPoolError(
+        "Pothos::ThreadPool::setNumThreads()", "cannot change to the thread-per-block mechanic");
+    env->setNumThreads(numThreads);
+}
+
+size_t Pothos::ThreadPool::getNumThreads(void) const
+{
+    if (not _impl) throw ThreadPoolError("Pothos::ThreadPool::getNumThreads()", "null thread pool");
+    return std::static_pointer_cast<ThreadEnvironment>(_impl)->getNumThreads();
+}
+
+std::string Pothos::ThreadPool::queryStats(void) const
+{
+    if (not _impl) throw ThreadPoolError("Pothos::ThreadPool::queryStats()", "null thread pool");
+    return std::static_pointer_cast<ThreadEnvironment>(_impl)->queryStats();
+}
+
 bool Pothos::operator==(const ThreadPool &lhs, const ThreadPool &rhs)
 {
     return lhs.getContainer() == rhs.getContainer();
@@ -98,10 +234,20 @@ static auto managedThreadPoolArgs = Pothos::ManagedClass()
     .registerConstructor<Pothos::ThreadPoolArgs, const size_t>()
     .registerConstructor<Pothos::ThreadPoolArgs, const std::string &>()
     .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, numThreads))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, maxThreads))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, idleTimeout))
     .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, priority))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, realtimePolicy))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, deadlineRuntime))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, deadline))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, deadlinePeriod))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, cpuDmaLatency))
     .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, affinityMode))
     .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, affinity))
     .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, yieldMode))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, schedulerMode))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, taskOrder))
+    .registerField(POTHOS_FCN_TUPLE(Pothos::ThreadPoolArgs, spinBudget))
     .commit("Pothos/ThreadPoolArgs");
 
 static auto managedThreadPool = Pothos::ManagedClass()
@@ -109,6 +255,9 @@ static auto managedThreadPool = Pothos::ManagedClass()
     .registerConstructor<Pothos::ThreadPool, const std::shared_ptr<void> &>()
     .registerConstructor<Pothos::ThreadPool, const Pothos::ThreadPoolArgs &>()
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::ThreadPool, getContainer))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::ThreadPool, setNumThreads))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::ThreadPool, getNumThreads))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::ThreadPool, queryStats))
     .registerStaticMethod<bool, const Pothos::ThreadPool &, const Pothos::ThreadPool &>("equal", Pothos::operator==)
     .commit("Pothos/ThreadPool");
 
@@ -123,6 +272,16 @@ void serialize(Archive &ar, Pothos::ThreadPoolArgs &t, const unsigned int)
     ar & t.affinityMode;
     ar & t.affinity;
     ar & t.yieldMode;
+    ar & t.schedulerMode;
+    ar & t.spinBudget;
+    ar & t.taskOrder;
+    ar & t.maxThreads;
+    ar & t.idleTimeout;
+    ar & t.realtimePolicy;
+    ar & t.deadlineRuntime;
+    ar & t.deadline;
+    ar & t.deadlinePeriod;
+    ar & t.cpuDmaLatency;
 }
 }}
 
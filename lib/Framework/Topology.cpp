@@ -1,8 +1,9 @@
-// Copyright (c) 2014-2019 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/TopologyImpl.hpp"
+#include "Framework/WorkerActor.hpp"
 #include <Pothos/Framework/Block.hpp>
 #include <Pothos/Framework/Exception.hpp>
 #include <Pothos/Object.hpp>
@@ -12,11 +13,51 @@
 #include <Poco/Format.h>
 #include <algorithm>
 #include <cassert>
+#include <functional>
+#include <map>
 #include <set>
 #include <cctype>
 #include <chrono>
 #include <thread>
 #include <iostream>
+#include <json.hpp>
+
+using json = nlohmann::json;
+
+/***********************************************************************
+ * Connectable helpers with direct calls on objects in this process
+ **********************************************************************/
+//! Auto-allocate or auto-delete a port, on a block this may or may not change the port, on a topology this is a no-op
+static void autoPortChange(const Pothos::Proxy &obj, const std::string &name, const bool isInput, const bool allocate)
+{
+    if (getLocalTopology(obj) != nullptr) return;
+    auto local = getLocalActor(obj);
+    try
+    {
+        if (local == nullptr) obj.get("_actor").call(allocate?
+            (isInput?"autoAllocateInput":"autoAllocateOutput"):
+            (isInput?"autoDeleteInput":"autoDeleteOutput"), name);
+        else if (allocate and isInput) local->autoAllocateInput(name);
+        else if (allocate) local->autoAllocateOutput(name);
+        else if (isInput) local->autoDeleteInput(name);
+        else local->autoDeleteOutput(name);
+    }
+    catch (const Pothos::Exception &){}
+}
+
+static std::vector<std::string> getPortNames(const Pothos::Proxy &obj, const bool isInput)
+{
+    auto local = getLocalConnectable(obj);
+    if (local != nullptr) return isInput?local->inputPortNames():local->outputPortNames();
+    return obj.call(isInput?"inputPortNames":"outputPortNames");
+}
+
+static std::vector<Pothos::PortInfo> getPortInfo(const Pothos::Proxy &obj, const bool isInput)
+{
+    auto local = getLocalConnectable(obj);
+    if (local != nullptr) return isInput?local->inputPortInfo():local->outputPortInfo();
+    return obj.call<std::vector<Pothos::PortInfo>>(isInput?"inputPortInfo":"outputPortInfo");
+}
 
 /***********************************************************************
  * Topology implementation
@@ -36,6 +77,9 @@ Pothos::Topology::~Topology(void)
 {
     try
     {
+        this->stopStatsExport();
+        this->stopMetricsServer();
+        if (_impl->asyncCommit.valid()) _impl->asyncCommit.wait();
         this->disconnectAll();
         this->commit();
         assert(this->_impl->activeFlatFlows.empty());
@@ -56,8 +100,9 @@ Port Pothos::Topology::Impl::makePort(const Pothos::Proxy &obj, const std::strin
 {
     Port p;
     p.name = name;
-    p.uid = obj.call<std::string>("uid");
-    p.objName = obj.call<std::string>("getName");
+    auto local = getLocalConnectable(obj);
+    p.uid = (local != nullptr)?local->uid():obj.call<std::string>("uid");
+    p.objName = (local != nullptr)?local->getName():obj.call<std::string>("getName");
     //dont store copies of self
     if (p.uid != self->uid()) p.obj = obj;
     return p;
@@ -73,6 +118,59 @@ const Pothos::ThreadPool &Pothos::Topology::getThreadPool(void) const
     return _impl->threadPool;
 }
 
+void Pothos::Topology::setStatsLevel(const std::string &level)
+{
+    if (level != "FULL" and level != "CYCLES" and level != "NONE" and level != "PERF")
+    {
+        throw Pothos::InvalidArgumentException("Pothos::Topology::setStatsLevel("+level+")", "unknown stats level");
+    }
+    _impl->statsLevel = level;
+}
+
+const std::string &Pothos::Topology::getStatsLevel(void) const
+{
+    return _impl->statsLevel;
+}
+
+void Pothos::Topology::setTraceEnabled(const bool enabled)
+{
+    _impl->traceEnabled = enabled;
+    _impl->traceConfigured = true;
+}
+
+bool Pothos::Topology::getTraceEnabled(void) const
+{
+    return _impl->traceEnabled;
+}
+
+void Pothos::Topology::setMemoryBudget(const size_t numBytes)
+{
+    _impl->memoryBudget = numBytes;
+    _impl->memoryBudgetConfigured = true;
+}
+
+size_t Pothos::Topology::getMemoryBudget(void) const
+{
+    return _impl->memoryBudget;
+}
+
+void Pothos::Topology::setNetworkFlowArgs(const std::string &args)
+{
+    //validate the arguments before they are applied on commit
+    NetworkFlowArgs parsed;
+    try {parsed = NetworkFlowArgs(args);}
+    catch (const std::exception &ex)
+    {
+        throw Pothos::InvalidArgumentException("Pothos::Topology::setNetworkFlowArgs("+args+")", ex.what());
+    }
+    _impl->networkFlowArgs = args;
+}
+
+const std::string &Pothos::Topology::getNetworkFlowArgs(void) const
+{
+    return _impl->networkFlowArgs;
+}
+
 void Pothos::Topology::setInputAlias(const std::string &portName, const std::string &alias)
 {
     if (_impl->inputPortInfo.count(portName) == 0) throw PortAccessError(
@@ -129,20 +227,22 @@ void Pothos::Topology::_connect(
     flow.dst = _impl->makePort(dst, dstName);
 
     //perform auto-allocation, on a block this may or may not allocate, on a topology this throws
-    try{getConnectable(src).get("_actor").call("autoAllocateOutput", srcName);}catch(const Exception &){}
-    try{getConnectable(dst).get("_actor").call("autoAllocateInput", dstName);}catch(const Exception &){}
+    const auto srcConn = getConnectable(src);
+    const auto dstConn = getConnectable(dst);
+    autoPortChange(srcConn, srcName, false, true);
+    autoPortChange(dstConn, dstName, true, true);
 
     //validate that the ports exists before connection
     if (flow.src.obj)
     {
-        std::vector<std::string> outs = getConnectable(src).call("outputPortNames");
+        const auto outs = getPortNames(srcConn, false);
         if (std::find(outs.begin(), outs.end(), srcName) == outs.end())
             throw Pothos::TopologyConnectError("Pothos::Topology::connect()", flow.src.toString() + " has no output port named " + srcName);
     }
 
     if (flow.dst.obj)
     {
-        std::vector<std::string> ins = getConnectable(dst).call("inputPortNames");
+        const auto ins = getPortNames(dstConn, true);
         if (std::find(ins.begin(), ins.end(), dstName) == ins.end())
             throw Pothos::TopologyConnectError("Pothos::Topology::connect()", flow.dst.toString() + " has no input port named " + dstName);
     }
@@ -151,7 +251,7 @@ void Pothos::Topology::_connect(
     if (not flow.src.obj and flow.dst.obj)
     {
         _impl->inputPortNames.push_back(srcName);
-        for (const auto &info : getConnectable(dst).call<std::vector<PortInfo>>("inputPortInfo"))
+        for (const auto &info : getPortInfo(dstConn, true))
         {
             if (info.name == dstName)
             {
@@ -166,7 +266,7 @@ void Pothos::Topology::_connect(
     if (not flow.dst.obj and flow.src.obj)
     {
         _impl->outputPortNames.push_back(dstName);
-        for (const auto &info : getConnectable(src).call<std::vector<PortInfo>>("outputPortInfo"))
+        for (const auto &info : getPortInfo(srcConn, false))
         {
             if (info.name == srcName)
             {
@@ -192,6 +292,146 @@ void Pothos::Topology::_connect(
         Poco::format("this flow already exists in the topology(%s)", flow.toString()));
 
     _impl->flows.push_back(flow);
+    _impl->flowsRevision++;
+}
+
+static void setOutputBufferArgs(const Pothos::Proxy &obj, const std::string &portName, const std::string &bufferArgs)
+{
+    //local blocks and topologies are configured without the proxy calls
+    auto localActor = getLocalActor(obj);
+    if (localActor != nullptr)
+    {
+        localActor->setOutputBufferArgs(portName, bufferArgs);
+        return;
+    }
+    auto localTopology = getLocalTopology(obj);
+    if (localTopology != nullptr)
+    {
+        for (const auto &subPort : resolvePortsFromTopology(*localTopology, portName, true))
+        {
+            if (not subPort.obj) continue; //pass-through from outside the topology
+            setOutputBufferArgs(getInternalBlock(subPort.obj), subPort.name, bufferArgs);
+        }
+        return;
+    }
+
+    //its a block, configure the output port through the actor
+    Pothos::Proxy actor;
+    try {actor = obj.get("_actor");}
+    catch (const Pothos::Exception &){}
+    if (actor)
+    {
+        actor.call("setOutputBufferArgs", portName, bufferArgs);
+        return;
+    }
+
+    //its a topology, configure every block output port behind this port
+    auto subPorts = obj.call("resolvePorts", portName, true);
+    const size_t len = subPorts.call("size");
+    for (size_t i = 0; i < len; i++)
+    {
+        auto subPort = subPorts.call("at", i);
+        auto subObj = getInternalBlock(subPort.get("obj"));
+        if (not subObj) continue; //pass-through from outside the topology
+        setOutputBufferArgs(subObj, subPort.call<std::string>("get:name"), bufferArgs);
+    }
+}
+
+static void setInputLossyDepth(const Pothos::Proxy &obj, const std::string &portName, const size_t numBuffers)
+{
+    //local blocks and topologies are configured without the proxy calls
+    auto localActor = getLocalActor(obj);
+    if (localActor != nullptr)
+    {
+        localActor->setInputLossyDepth(portName, numBuffers);
+        return;
+    }
+    auto localTopology = getLocalTopology(obj);
+    if (localTopology != nullptr)
+    {
+        for (const auto &subPort : resolvePortsFromTopology(*localTopology, portName, false))
+        {
+            if (not subPort.obj) continue; //pass-through to outside the topology
+            setInputLossyDepth(getInternalBlock(subPort.obj), subPort.name, numBuffers);
+        }
+        return;
+    }
+
+    //its a block, configure the input port through the actor
+    Pothos::Proxy actor;
+    try {actor = obj.get("_actor");}
+    catch (const Pothos::Exception &){}
+    if (actor)
+    {
+        actor.call("setInputLossyDepth", portName, numBuffers);
+        return;
+    }
+
+    //its a topology, configure every block input port behind this port
+    auto subPorts = obj.call("resolvePorts", portName, false);
+    const size_t len = subPorts.call("size");
+    for (size_t i = 0; i < len; i++)
+    {
+        auto subPort = subPorts.call("at", i);
+        auto subObj = getInternalBlock(subPort.get("obj"));
+        if (not subObj) continue; //pass-through to outside the topology
+        setInputLossyDepth(subObj, subPort.call<std::string>("get:name"), numBuffers);
+    }
+}
+
+void Pothos::Topology::_connect(
+    const Object &src, const std::string &srcName,
+    const Object &dst, const std::string &dstName,
+    const std::string &bufferArgs)
+{
+    //validate the buffer arguments before making the connection
+    json argsObj;
+    try {argsObj = json::parse(bufferArgs);}
+    catch (const std::exception &ex)
+    {
+        throw Pothos::TopologyConnectError("Pothos::Topology::connect()",
+            "cant parse buffer arguments: " + std::string(ex.what()));
+    }
+    if (not argsObj.is_object()) throw Pothos::TopologyConnectError("Pothos::Topology::connect()",
+        "buffer arguments must be a JSON object: " + bufferArgs);
+
+    const auto srcPort = _impl->makePort(src, srcName);
+    if (not srcPort.obj) throw Pothos::TopologyConnectError("Pothos::Topology::connect()",
+        "buffer arguments cannot be applied to topology input " + srcName);
+
+    //the lossy depth configures the destination port rather than the buffer manager
+    const auto lossyIt = argsObj.find("lossyDepth");
+    const bool hasLossyDepth = lossyIt != argsObj.end();
+    size_t lossyDepth(0);
+    if (hasLossyDepth)
+    {
+        if (not lossyIt->is_number_unsigned()) throw Pothos::TopologyConnectError("Pothos::Topology::connect()",
+            "lossyDepth must be a non-negative integer: " + lossyIt->dump());
+        if (not _impl->makePort(dst, dstName).obj) throw Pothos::TopologyConnectError("Pothos::Topology::connect()",
+            "lossyDepth cannot be applied to topology output " + dstName);
+        lossyDepth = lossyIt->get<size_t>();
+        argsObj.erase(lossyIt);
+    }
+
+    //the auto-tuner configuration is checked here, before the flow is made
+    const auto tuneIt = argsObj.find("autoTune");
+    if (tuneIt != argsObj.end() and not (tuneIt->is_boolean() and not tuneIt->get<bool>()))
+    {
+        try {BufferAutoTuner tuner(*tuneIt);}
+        catch (const Pothos::Exception &ex)
+        {
+            throw Pothos::TopologyConnectError("Pothos::Topology::connect()", ex.message());
+        }
+        catch (const std::exception &ex)
+        {
+            throw Pothos::TopologyConnectError("Pothos::Topology::connect()",
+                "cant parse autoTune: " + std::string(ex.what()));
+        }
+    }
+
+    this->_connect(src, srcName, dst, dstName);
+    if (hasLossyDepth) setInputLossyDepth(getConnectable(dst), dstName, lossyDepth);
+    if (not hasLossyDepth or not argsObj.empty()) setOutputBufferArgs(getConnectable(src), srcName, argsObj.dump());
 }
 
 void Pothos::Topology::_disconnect(
@@ -208,11 +448,13 @@ void Pothos::Topology::_disconnect(
     flow.dst = _impl->makePort(dst, dstName);
 
     //validate that the ports exists before disconnection
-    std::vector<std::string> outs = getConnectable(src).call("outputPortNames");
+    const auto srcConn = getConnectable(src);
+    const auto dstConn = getConnectable(dst);
+    const auto outs = getPortNames(srcConn, false);
     if (std::find(outs.begin(), outs.end(), srcName) == outs.end())
         throw Pothos::TopologyConnectError("Pothos::Topology::disconnect()", flow.src.toString() + " has no output port named " + srcName);
 
-    std::vector<std::string> ins = getConnectable(dst).call("inputPortNames");
+    const auto ins = getPortNames(dstConn, true);
     if (std::find(ins.begin(), ins.end(), dstName) == ins.end())
         throw Pothos::TopologyConnectError("Pothos::Topology::disconnect()", flow.dst.toString() + " has no input port named " + dstName);
 
@@ -225,10 +467,11 @@ void Pothos::Topology::_disconnect(
         Poco::format("this flow does not exist in the topology(%s)", flow.toString()));
 
     //perform auto-deletion, on a block this may or may not delete, on a topology this throws
-    try{getConnectable(src).get("_actor").call("autoDeleteOutput", srcName);}catch(const Exception &){}
-    try{getConnectable(dst).get("_actor").call("autoDeleteInput", dstName);}catch(const Exception &){}
+    autoPortChange(srcConn, srcName, false, false);
+    autoPortChange(dstConn, dstName, true, false);
 
     _impl->flows.erase(it);
+    _impl->flowsRevision++;
 }
 
 void Pothos::Topology::disconnectAll(const bool recursive)
@@ -253,56 +496,319 @@ void Pothos::Topology::disconnectAll(const bool recursive)
     //perform auto-deletion, on a block this may or may not delete, on a topology this throws
     for (const auto &flow : _impl->flows)
     {
-        if (flow.src.obj) try{getInternalBlock(flow.src.obj).get("_actor").call("autoDeleteOutput", flow.src.name);}catch(const Exception &){}
-        if (flow.dst.obj) try{getInternalBlock(flow.dst.obj).get("_actor").call("autoDeleteInput", flow.dst.name);}catch(const Exception &){}
+        if (flow.src.obj) autoPortChange(getInternalBlock(flow.src.obj), flow.src.name, false, false);
+        if (flow.dst.obj) autoPortChange(getInternalBlock(flow.dst.obj), flow.dst.name, true, false);
     }
 
     //clear our own local flows
     _impl->flows.clear();
+    _impl->flowsRevision++;
+}
+
+void Pothos::Topology::_replace(const Object &oldObj, const Object &newObj)
+{
+    if (not checkObj(oldObj)) throw Pothos::TopologyConnectError("Pothos::Topology::replace()",
+        "old object of type " + oldObj.toString());
+    if (not checkObj(newObj)) throw Pothos::TopologyConnectError("Pothos::Topology::replace()",
+        "new object of type " + newObj.toString());
+
+    const auto oldPort = _impl->makePort(oldObj, "");
+    const auto newPort = _impl->makePort(newObj, "");
+    if (not oldPort.obj or not newPort.obj) throw Pothos::TopologyConnectError("Pothos::Topology::replace()",
+        "cannot replace the topology itself");
+    if (oldPort.uid == newPort.uid) return;
+
+    //move the flows of the old object onto the ports of the new object
+    const auto newConn = getConnectable(newObj);
+    auto flows = _impl->flows;
+    size_t numMoved(0);
+    for (auto &flow : flows)
+    {
+        if (flow.src.uid != oldPort.uid and flow.dst.uid != oldPort.uid) continue;
+        numMoved++;
+        if (flow.src.uid == oldPort.uid)
+        {
+            autoPortChange(newConn, flow.src.name, false, true);
+            const auto outs = getPortNames(newConn, false);
+            if (std::find(outs.begin(), outs.end(), flow.src.name) == outs.end())
+                throw Pothos::TopologyConnectError("Pothos::Topology::replace()", newPort.objName + " has no output port named " + flow.src.name);
+            flow.src = _impl->makePort(newObj, flow.src.name);
+        }
+        if (flow.dst.uid == oldPort.uid)
+        {
+            autoPortChange(newConn, flow.dst.name, true, true);
+            const auto ins = getPortNames(newConn, true);
+            if (std::find(ins.begin(), ins.end(), flow.dst.name) == ins.end())
+                throw Pothos::TopologyConnectError("Pothos::Topology::replace()", newPort.objName + " has no input port named " + flow.dst.name);
+            flow.dst = _impl->makePort(newObj, flow.dst.name);
+        }
+    }
+    if (numMoved == 0) throw Pothos::TopologyConnectError("Pothos::Topology::replace()",
+        oldPort.objName + " is not connected in this topology");
+
+    //commit the new flows, or restore the old flows on failure
+    const auto oldFlows = _impl->flows;
+    _impl->flows = flows;
+    _impl->flowsRevision++;
+    try
+    {
+        this->commit();
+    }
+    catch (const Pothos::Exception &ex)
+    {
+        _impl->flows = oldFlows;
+        _impl->flowsRevision++;
+        try {this->commit();}
+        catch (const Pothos::Exception &ex2)
+        {
+            poco_error_f1(Poco::Logger::get("Pothos.Topology"), "replace() failed to restore the old flows: %s", ex2.displayText());
+        }
+        throw Pothos::TopologyConnectError("Pothos::Topology::replace()", ex.message());
+    }
+}
+
+static unsigned long long queryActivityCounter(const Pothos::Topology &t)
+{
+    return t._impl->activityNotifier->count();
 }
 
 bool Pothos::Topology::waitInactive(const double idleDuration, const double timeout)
 {
     //how long to sleep between idle checks?
     const std::chrono::nanoseconds idleDurationNs((long long)(idleDuration*1e9));
-    const std::chrono::nanoseconds pollSleepTime(idleDurationNs/3);
+    const std::chrono::nanoseconds pollSleepTime(idleDurationNs/4);
 
-    //get a list of blocks to poll for idle time
-    const auto blocks = getObjSetFromFlowList(_impl->activeFlatFlows);
+    //nothing to wait on when there are no active blocks
+    if (_impl->activeFlatFlows.empty()) return true;
 
-    //track block activity indicators and activity time stamps
-    std::vector<std::chrono::high_resolution_clock::time_point> lastActivityTime(blocks.size());
-    std::vector<int> lastActivityIndicator(blocks.size(), 0);
+    //the blocks signal the aggregate counter of the sub-topology that activated them,
+    //so sum one counter per environment rather than polling every block
+    auto queryActivity = [this](void)
+    {
+        unsigned long long total = _impl->activityNotifier->count();
+        for (const auto &pair : _impl->remoteTopologies)
+        {
+            total += pair.second.call<unsigned long long>("queryActivityCounter");
+        }
+        return total;
+    };
 
     //loop until exit time
     const auto entryTime = std::chrono::high_resolution_clock::now();
     const auto exitTime = entryTime + std::chrono::nanoseconds((long long)(timeout*1e9));
-    do
+    auto lastActivityTime = entryTime;
+    auto lastActivityCount = queryActivity();
+    while (true)
     {
-        //check each worker for idle time from the activity indicator
-        bool allIdle = true;
-        for (size_t i = 0; i < blocks.size(); i++)
+        //any activity restarts the idle duration
+        const auto activityCount = queryActivity();
+        const auto now = std::chrono::high_resolution_clock::now();
+        if (activityCount != lastActivityCount)
         {
-            const auto &block = blocks[i];
-            const int activityIndicator = block.get("_actor").call("queryActivityIndicator");
-            if (lastActivityIndicator[i] != activityIndicator)
-            {
-                lastActivityTime[i] = std::chrono::high_resolution_clock::now();
-                lastActivityIndicator[i] = activityIndicator;
-            }
-            const auto workerIdleDuration = std::chrono::high_resolution_clock::now() - std::max(entryTime, lastActivityTime[i]);
-            if (workerIdleDuration < idleDurationNs) allIdle = false;
+            lastActivityCount = activityCount;
+            lastActivityTime = now;
         }
 
         //all workers reached the max idle time specified
-        if (allIdle) return true;
+        const auto remaining = idleDurationNs - (now - lastActivityTime);
+        if (remaining <= std::chrono::nanoseconds::zero()) return true;
+
+        if (now >= exitTime and timeout != 0.0) return false; //timeout
+
+        //block until the idle duration could have elapsed
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(remaining, pollSleepTime));
+    }
+}
+
+/***********************************************************************
+ * Drain implementation
+ **********************************************************************/
+static std::string getBlockUid(const Pothos::Proxy &block)
+{
+    auto local = getLocalBlock(block);
+    if (local != nullptr) return local->uid();
+    return block.call<std::string>("uid");
+}
 
-        //idle time not reached on any workers, therefore sleep
-        else std::this_thread::sleep_for(pollSleepTime);
+static void setDrainStopped(const Pothos::Proxy &block, const bool stopped)
+{
+    auto local = getLocalActor(block);
+    if (local != nullptr) return local->setDrainStopped(stopped);
+    block.get("_actor").call("setDrainStopped", stopped);
+}
+
+static bool waitDrained(const Pothos::Proxy &block, const double timeout, const unsigned long long minBytes, const unsigned long long minMessages)
+{
+    auto local = getLocalActor(block);
+    if (local != nullptr) return local->waitDrained(timeout, minBytes, minMessages);
+    return block.get("_actor").call<bool>("waitDrained", timeout, minBytes, minMessages);
+}
+
+static unsigned long long getInputConsumed(const Pothos::Proxy &block, const bool messages)
+{
+    auto local = getLocalActor(block);
+    if (local != nullptr) return messages?local->getInputMessagesConsumed():local->getInputBytesConsumed();
+    return block.get("_actor").call<unsigned long long>(messages?"getInputMessagesConsumed":"getInputBytesConsumed");
+}
+
+bool Pothos::Topology::drain(const double timeout)
+{
+    const auto exitTime = std::chrono::steady_clock::now() + std::chrono::nanoseconds((long long)(timeout*1e9));
+
+    //the graph of the active blocks, where each pair of network blocks
+    //carries the flow from the sink in one process to the source in another
+    std::map<std::string, Pothos::Proxy> blocks;
+    std::map<std::string, std::set<std::string>> consumers;
+    std::set<std::string> fedBlocks;
+    std::map<std::string, std::string> pairedSinks;
+    for (const auto &flow : _impl->activeFlatFlows)
+    {
+        if (not flow.src.obj or not flow.dst.obj) continue;
+        blocks[flow.src.uid] = flow.src.obj;
+        blocks[flow.dst.uid] = flow.dst.obj;
+        consumers[flow.src.uid].insert(flow.dst.uid);
+        fedBlocks.insert(flow.dst.uid);
+    }
+    for (const auto &entry : _impl->srcToNetgressCache)
+    {
+        const auto &net = entry.second;
+        const std::vector<std::pair<Pothos::Proxy, Pothos::Proxy>> pairs{
+            {net.sink, net.source}, {net.labelSink, net.labelSource}, {net.creditSink, net.creditSource}};
+        for (const auto &pair : pairs)
+        {
+            if (not pair.first or not pair.second) continue;
+            const auto sinkUid = getBlockUid(pair.first);
+            const auto sourceUid = getBlockUid(pair.second);
+            if (blocks.count(sinkUid) == 0 or blocks.count(sourceUid) == 0) continue;
+            consumers[sinkUid].insert(sourceUid);
+            fedBlocks.insert(sourceUid);
+            pairedSinks[sourceUid] = sinkUid;
+        }
+    }
+
+    //drain in depth-first order from the sources,
+    //so the upstream blocks come first, except around feedback loops
+    std::vector<std::string> sources, order;
+    std::set<std::string> visited;
+    std::function<void(const std::string &)> visit = [&](const std::string &uid)
+    {
+        if (not visited.insert(uid).second) return;
+        for (const auto &consumer : consumers[uid]) visit(consumer);
+        order.push_back(uid);
+    };
+    for (const auto &pair : blocks)
+    {
+        if (fedBlocks.count(pair.first) == 0) sources.push_back(pair.first);
+    }
+    for (const auto &uid : sources) visit(uid);
+    for (const auto &pair : blocks) visit(pair.first); //blocks only in feedback loops
+    std::reverse(order.begin(), order.end());
+
+    //stop the sources, the remaining data flows through the design
+    for (const auto &uid : sources) setDrainStopped(blocks.at(uid), true);
+
+    for (const auto &uid : order)
+    {
+        double remaining = 0.0;
+        if (timeout != 0.0)
+        {
+            remaining = std::chrono::duration<double>(exitTime - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0.0) return false;
+        }
+
+        //a network source produces what its sink consumed
+        unsigned long long minBytes(0), minMessages(0);
+        const auto it = pairedSinks.find(uid);
+        if (it != pairedSinks.end())
+        {
+            minBytes = getInputConsumed(blocks.at(it->second), false);
+            minMessages = getInputConsumed(blocks.at(it->second), true);
+        }
+        if (not waitDrained(blocks.at(uid), remaining, minBytes, minMessages)) return false;
+    }
+    return true;
+}
+
+/***********************************************************************
+ * Run to completion implementation
+ **********************************************************************/
+/*!
+ * The minimum size of the default output buffers in a batch run.
+ * Larger transfers pay the per-buffer overhead less often,
+ * and the bytes in flight do not matter for offline processing.
+ */
+static const size_t BatchBufferSize = 1 << 20;
+
+static bool waitEndOfStream(const Pothos::Proxy &block, const double timeout)
+{
+    auto local = getLocalActor(block);
+    if (local != nullptr) return local->waitEndOfStream(timeout);
+    return block.get("_actor").call<bool>("waitEndOfStream", timeout);
+}
+
+bool Pothos::Topology::runToCompletion(const double timeout)
+{
+    const auto exitTime = std::chrono::steady_clock::now() + std::chrono::nanoseconds((long long)(timeout*1e9));
+    const auto remaining = [&](void)
+    {
+        if (timeout == 0.0) return 0.0;
+        return std::max(std::chrono::duration<double>(exitTime - std::chrono::steady_clock::now()).count(), 1e-9);
+    };
+
+    //spinning threads, one per core, never wait on a condition or a timeout
+    const auto threadPool = this->getThreadPool();
+    if (not threadPool)
+    {
+        ThreadPoolArgs args(std::max<size_t>(std::thread::hardware_concurrency(), 1));
+        args.yieldMode = "SPIN";
+        this->setThreadPool(ThreadPool(args));
+    }
+    _impl->batchBufferSize = BatchBufferSize;
+    _impl->batchConfigured = true;
+
+    bool completed = false;
+    POTHOS_EXCEPTION_TRY
+    {
+        this->commit();
+
+        //the sources are the blocks without upstream flows, except for network sources
+        std::set<std::string> fedBlocks;
+        for (const auto &flow : _impl->activeFlatFlows) fedBlocks.insert(flow.dst.uid);
+        for (const auto &entry : _impl->srcToNetgressCache)
+        {
+            for (const auto &source : {entry.second.source, entry.second.labelSource, entry.second.creditSource})
+            {
+                if (source) fedBlocks.insert(getBlockUid(source));
+            }
+        }
+        std::map<std::string, Pothos::Proxy> sources;
+        for (const auto &flow : _impl->activeFlatFlows)
+        {
+            if (flow.src.obj and fedBlocks.count(flow.src.uid) == 0) sources[flow.src.uid] = flow.src.obj;
+        }
+
+        //wait for the end of the streams, then for the data in flight
+        completed = true;
+        for (const auto &pair : sources)
+        {
+            if (not waitEndOfStream(pair.second, remaining())) completed = false;
+            if (not completed) break;
+        }
+        if (completed) completed = this->drain(remaining());
+    }
+    POTHOS_EXCEPTION_CATCH(const Exception &)
+    {
+        _impl->batchBufferSize = 0;
+        this->setThreadPool(threadPool);
+        throw;
     }
-    while (std::chrono::high_resolution_clock::now() < exitTime or timeout == 0.0);
 
-    return false; //timeout
+    //tear down the design, and restore the settings for the next commit
+    this->disconnectAll();
+    this->commit();
+    _impl->batchBufferSize = 0;
+    this->setThreadPool(threadPool);
+    return completed;
 }
 
 void Pothos::Topology::registerCallable(const std::string &name, const Callable &call)
@@ -337,8 +843,6 @@ static Pothos::ProxyVector getFlowsFromTopology(const Pothos::Topology &t)
     return flows;
 }
 
-std::vector<Port> resolvePortsFromTopology(const Pothos::Topology &t, const std::string &portName, const bool isSource);
-std::vector<Flow> resolveFlowsFromTopology(const Pothos::Topology &t);
 void topologySubCommit(Pothos::Topology &topology);
 
 static auto managedTopology = Pothos::ManagedClass()
@@ -348,10 +852,23 @@ static auto managedTopology = Pothos::ManagedClass()
     .registerStaticMethod<std::shared_ptr<Pothos::Topology>, const std::string &>(POTHOS_FCN_TUPLE(Pothos::Topology, make))
     .registerMethod("getFlows", &getFlowsFromTopology)
     .registerMethod("subCommit", &topologySubCommit)
+    .registerMethod("queryActivityCounter", &queryActivityCounter)
     .registerMethod("resolvePorts", &resolvePortsFromTopology)
     .registerMethod("resolveFlows", &resolveFlowsFromTopology)
+    .registerMethod("getFlowsRevision", &queryFlowsRevision)
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, setFusedGroup))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, getFusedGroups))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, setThreadPool))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, getThreadPool))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, setStatsLevel))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, getStatsLevel))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, setTraceEnabled))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, getTraceEnabled))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, setMemoryBudget))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, getMemoryBudget))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, setNetworkFlowArgs))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, getNetworkFlowArgs))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, setGlobalVariable))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, commit))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, disconnectAll))
     .registerMethod("disconnectAll", Pothos::Callable(&Pothos::Topology::disconnectAll).bind(false, 1))
@@ -359,10 +876,24 @@ static auto managedTopology = Pothos::ManagedClass()
     //and bind defaults into waitInactive for optional trailing arguments
     .registerMethod("waitInactive", Pothos::Callable(&Pothos::Topology::waitInactive).bind(1.0, 2))
     .registerMethod("waitInactive", Pothos::Callable(&Pothos::Topology::waitInactive).bind(1.0, 2).bind(0.1, 1))
-    .registerMethod("connect", &Pothos::Topology::_connect)
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, drain))
+    .registerMethod("drain", Pothos::Callable(&Pothos::Topology::drain).bind(1.0, 1))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, runToCompletion))
+    .registerMethod("runToCompletion", Pothos::Callable(&Pothos::Topology::runToCompletion).bind(0.0, 1))
+    .registerMethod("connect", (void(Pothos::Topology::*)(const Pothos::Object &, const std::string &, const Pothos::Object &, const std::string &))&Pothos::Topology::_connect)
+    .registerMethod("connect", (void(Pothos::Topology::*)(const Pothos::Object &, const std::string &, const Pothos::Object &, const std::string &, const std::string &))&Pothos::Topology::_connect)
     .registerMethod("disconnect", &Pothos::Topology::_disconnect)
+    .registerMethod("replace", &Pothos::Topology::_replace)
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, toDotMarkup))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, queryJSONStats))
+    .registerMethod("queryJSONStats", Pothos::Callable(&Pothos::Topology::queryJSONStats).bind("{}", 1))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, queryBottlenecks))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, dumpTrace))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, startStatsExport))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, stopStatsExport))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, queryMetrics))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, startMetricsServer))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, stopMetricsServer))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Topology, dumpJSON))
     .commit("Pothos/Topology");
 
@@ -1,12 +1,20 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/TopologyImpl.hpp"
+#include "Framework/ThreadEnvironment.hpp"
+#include "Framework/WorkerActor.hpp"
 #include <Pothos/Framework/Block.hpp>
 #include <Pothos/Framework/Exception.hpp>
+#include <Pothos/Proxy/Batch.hpp>
 #include <Poco/Format.h>
 #include <iostream>
+#include <unordered_set>
+#include <algorithm>
 #include <future>
+#include <functional>
+#include <map>
+#include <set>
 
 struct FutureInfo
 {
@@ -36,89 +44,190 @@ std::string collectFutureInfoErrors(const std::vector<FutureInfo> infoFutures)
 
 /***********************************************************************
  * helpers to deal with buffer managers
+ * The helpers call the actors directly for blocks in this process.
  **********************************************************************/
+static std::string getPortDomain(const Port &port, const bool isInput)
+{
+    auto block = getLocalBlock(port.obj);
+    if (block != nullptr) return isInput?block->input(port.name)->domain():block->output(port.name)->domain();
+    return port.obj.call(isInput?"input":"output", port.name).call("domain");
+}
+
 static std::string getBufferMode(const Port &port, const std::string &domain, const bool &isInput)
 {
+    auto local = getLocalActor(port.obj);
+    if (local != nullptr) return local->getBufferMode(port.name, domain, isInput);
     auto actor = port.obj.get("_actor");
     return actor.call("getBufferMode", port.name, domain, isInput);
 }
 
-static Pothos::Proxy getBufferManager(const Port &port, const std::string &domain, const bool &isInput)
+//! The manager is a local BufferManager::Sptr or a Proxy
+static Pothos::Object getBufferManager(const Port &port, const std::string &domain, const bool &isInput)
 {
+    auto local = getLocalActor(port.obj);
+    if (local != nullptr) return Pothos::Object(local->getBufferManager(port.name, domain, isInput));
     auto actor = port.obj.get("_actor");
-    return actor.call("getBufferManager", port.name, domain, isInput);
+    return Pothos::Object(actor.call("getBufferManager", port.name, domain, isInput));
 }
 
-static void setOutputBufferManager(const Port &src, const Pothos::Proxy &manager)
+static void setOutputBufferManager(const Port &src, const Pothos::Object &manager)
 {
-    src.obj.get("_actor").call("setOutputBufferManager", src.name, manager);
+    auto local = getLocalActor(src.obj);
+    if (local != nullptr and manager.type() == typeid(Pothos::BufferManager::Sptr))
+    {
+        return local->setOutputBufferManager(src.name, manager.extract<Pothos::BufferManager::Sptr>());
+    }
+    src.obj.get("_actor").call("setOutputBufferManager", src.name, getProxy(manager));
 }
 
-static void installBufferManagers(const std::vector<Flow> &flatFlows)
+static long getNodeAffinityHint(const std::vector<Port> &dsts)
 {
-    //map of a source port to all destination ports
-    std::unordered_map<Port, std::vector<Port>> srcs;
-    for (const auto &flow : flatFlows)
+    //all consumers must agree on a node for a useful hint
+    long node = -1;
+    for (size_t i = 0; i < dsts.size(); i++)
     {
-        for (const auto &subFlow : flatFlows)
-        {
-            if (subFlow.src == flow.src) srcs[flow.src].push_back(subFlow.dst);
-        }
+        auto local = getLocalActor(dsts[i].obj);
+        const long dstNode = (local != nullptr)?local->getNodeAffinityHint():
+            dsts[i].obj.get("_actor").call<long>("getNodeAffinityHint");
+        if (i == 0) node = dstNode;
+        else if (node != dstNode) return -1;
     }
+    return node;
+}
 
-    //result list is used to ack all install messages
-    std::vector<FutureInfo> infoFutures;
+static void setOutputNodeAffinityHint(const Port &src, const long node)
+{
+    auto local = getLocalActor(src.obj);
+    if (local != nullptr) return local->setOutputNodeAffinityHint(src.name, node);
+    src.obj.get("_actor").call("setOutputNodeAffinityHint", src.name, node);
+}
 
-    //for each source port -- install managers
-    for (const auto &pair : srcs)
+static size_t getReserveHint(const std::vector<Port> &dsts)
+{
+    //the largest downstream reserve decides the manager type
+    size_t numBytes = 0;
+    for (const auto &dst : dsts)
     {
-        auto src = pair.first;
-        auto dsts = pair.second;
-        auto dst = dsts.at(0);
-        Pothos::Proxy manager;
+        auto local = getLocalActor(dst.obj);
+        const size_t dstBytes = (local != nullptr)?local->getInputReserveBytes(dst.name):
+            dst.obj.get("_actor").call<size_t>("getInputReserveBytes", dst.name);
+        numBytes = std::max(numBytes, dstBytes);
+    }
+    return numBytes;
+}
 
-        std::string srcDomain = src.obj.call("output", src.name).call("domain");
-        std::string dstDomain = dst.obj.call("input", dst.name).call("domain");
+static void setOutputReserveHint(const Port &src, const size_t numBytes)
+{
+    auto local = getLocalActor(src.obj);
+    if (local != nullptr) return local->setOutputReserveHint(src.name, numBytes);
+    src.obj.get("_actor").call("setOutputReserveHint", src.name, numBytes);
+}
 
-        auto srcMode = getBufferMode(src, dstDomain, false);
-        auto dstMode = getBufferMode(dst, srcDomain, true);
+static bool getInPlaceHint(const std::vector<Port> &dsts)
+{
+    //any consumer that writes over its input in place asks for buffers of its own
+    for (const auto &dst : dsts)
+    {
+        auto local = getLocalActor(dst.obj);
+        const bool inPlace = (local != nullptr)?local->getInputInPlace(dst.name):
+            dst.obj.get("_actor").call<bool>("getInputInPlace", dst.name);
+        if (inPlace) return true;
+    }
+    return false;
+}
 
-        //check if the source provides a manager and install it to the source
-        if (srcMode == "CUSTOM")
-        {
-            manager = getBufferManager(src, dstDomain, false);
-        }
+static void setOutputInPlaceHint(const Port &src, const bool inPlace)
+{
+    auto local = getLocalActor(src.obj);
+    if (local != nullptr) return local->setOutputInPlaceHint(src.name, inPlace);
+    src.obj.get("_actor").call("setOutputInPlaceHint", src.name, inPlace);
+}
+
+static void installBufferManager(const Port &src, const std::vector<Port> &dsts)
+{
+    auto dst = dsts.at(0);
+    Pothos::Object manager;
+
+    const auto srcDomain = getPortDomain(src, false);
+    auto dstDomain = getPortDomain(dst, true);
+    auto srcMode = getBufferMode(src, dstDomain, false);
+
+    //the domain copiers of a fan-out share the source with the direct consumers,
+    //so the direct consumer whose domain the source accepts decides the manager
+    for (size_t i = 1; i < dsts.size() and srcMode == "ERROR"; i++)
+    {
+        dst = dsts[i];
+        dstDomain = getPortDomain(dst, true);
+        srcMode = getBufferMode(src, dstDomain, false);
+    }
+    auto dstMode = getBufferMode(dst, srcDomain, true);
+
+    //allocate source buffers on the NUMA node of the consumers
+    setOutputNodeAffinityHint(src, getNodeAffinityHint(dsts));
+
+    //check if the source provides a manager and install it to the source
+    if (srcMode == "CUSTOM")
+    {
+        manager = getBufferManager(src, dstDomain, false);
+    }
 
-        //check if the destination provides a manager and install it to the source
-        else if (dstMode == "CUSTOM")
+    //check if the destination provides a manager and install it to the source
+    else if (dstMode == "CUSTOM")
+    {
+        for (const auto &otherDst : dsts)
         {
-            for (const auto &otherDst : dsts)
+            if (otherDst == dst) continue;
+            const auto otherDstDomain = getPortDomain(otherDst, true);
+            if (getBufferMode(otherDst, srcDomain, true) != "ABDICATE" and not otherDstDomain.empty())
             {
-                if (otherDst == dst) continue;
-                std::string otherDstDomain = otherDst.obj.call("input", otherDst.name).call("domain");
-                if (getBufferMode(otherDst, srcDomain, true) != "ABDICATE" and not otherDstDomain.empty())
-                {
-                    throw Pothos::Exception("Pothos::Topology::installBufferManagers", Poco::format("%s->%s\n"
-                        "rectifyDomainFlows() logic does not /yet/ handle multiple destinations w/ custom buffer managers",
-                        src.toString(), otherDst.toString()));
-                }
+                throw Pothos::Exception("Pothos::Topology::installBufferManagers", Poco::format("%s->%s\n"
+                    "rectifyDomainFlows() logic does not /yet/ handle multiple destinations w/ custom buffer managers",
+                    src.toString(), otherDst.toString()));
             }
-            manager = getBufferManager(dst, srcDomain, true);
         }
+        manager = getBufferManager(dst, srcDomain, true);
+    }
 
-        //otherwise create a generic manager and install it to the source
-        else
-        {
-            assert(srcMode == "ABDICATE"); //this must be true if the previous logic was good
-            assert(dstMode == "ABDICATE");
-            manager = getBufferManager(src, dstDomain, false);
-        }
+    //otherwise create a generic manager and install it to the source
+    else
+    {
+        assert(srcMode == "ABDICATE"); //this must be true if the previous logic was good
+        assert(dstMode == "ABDICATE");
+
+        //downstream reserves select a circular manager to avoid accumulator copies,
+        //unless a consumer reuses the buffers in place for its own outputs
+        setOutputReserveHint(src, getReserveHint(dsts));
+        setOutputInPlaceHint(src, getInPlaceHint(dsts));
+        manager = getBufferManager(src, dstDomain, false);
+    }
 
-        std::shared_future<void> result(std::async(std::launch::async, setOutputBufferManager, src, manager));
-        infoFutures.push_back(FutureInfo(Poco::format("setOutputBufferManager(%s)", src.name), src.obj, result));
+    setOutputBufferManager(src, manager);
+}
+
+static void installBufferManagers(const std::vector<Flow> &newFlows, const std::vector<Flow> &flatFlows)
+{
+    //only sources with new flows need a new manager
+    std::unordered_set<Port> newSrcs;
+    for (const auto &flow : newFlows) newSrcs.insert(flow.src);
+
+    //map of a source port to all of its current destination ports
+    std::unordered_map<Port, std::vector<Port>> srcs;
+    for (const auto &flow : flatFlows)
+    {
+        if (newSrcs.count(flow.src) != 0) srcs[flow.src].push_back(flow.dst);
     }
 
-    //check all subscribe message results
+    //result list is used to ack all install messages
+    std::vector<FutureInfo> infoFutures;
+
+    //for each source port -- install managers concurrently
+    for (const auto &pair : srcs)
+    {
+        std::shared_future<void> result(std::async(std::launch::async, installBufferManager, pair.first, pair.second));
+        infoFutures.push_back(FutureInfo(Poco::format("installBufferManager(%s)", pair.first.name), pair.first.obj, result));
+    }
+
+    //check all install message results
     const auto errors = collectFutureInfoErrors(infoFutures);
     if (not errors.empty()) throw Pothos::TopologyConnectError(errors);
 }
@@ -128,6 +237,14 @@ static void installBufferManagers(const std::vector<Flow> &flatFlows)
  **********************************************************************/
 static void subscribePort(const Port &src, const Port &dst, const std::string &action)
 {
+    auto srcBlock = getLocalBlock(src.obj);
+    auto dstBlock = getLocalBlock(dst.obj);
+    if (srcBlock != nullptr and dstBlock != nullptr)
+    {
+        srcBlock->_actor->subscribeInput(action, src.name, dstBlock->input(dst.name));
+        dstBlock->_actor->subscribeOutput(action, dst.name, srcBlock->output(src.name));
+        return;
+    }
     {
         auto actor = src.obj.get("_actor");
         actor.call("subscribeInput", action, src.name, dst.obj.call("input", dst.name));
@@ -155,6 +272,71 @@ static void updateFlows(const std::vector<Flow> &flows, const std::string &actio
     if (not errors.empty()) throw Pothos::TopologyConnectError(errors);
 }
 
+/***********************************************************************
+ * Switch the destinations of a running source port in one step:
+ * The added destinations know the source before the source sends to them,
+ * the source replaces its subscribers with one locked call on its actor,
+ * and the removed destinations forget the source after it stops sending.
+ **********************************************************************/
+static void subscribeDst(const Port &src, const Port &dst, const std::string &action)
+{
+    auto srcBlock = getLocalBlock(src.obj);
+    auto dstBlock = getLocalBlock(dst.obj);
+    if (srcBlock != nullptr and dstBlock != nullptr) return dstBlock->_actor->subscribeOutput(action, dst.name, srcBlock->output(src.name));
+    dst.obj.get("_actor").call("subscribeOutput", action, dst.name, src.obj.call("output", src.name));
+}
+
+static void redirectPort(const Port &src, const std::vector<Port> &removes, const std::vector<Port> &adds)
+{
+    for (const auto &dst : adds) subscribeDst(src, dst, "add");
+
+    auto srcBlock = getLocalBlock(src.obj);
+    std::vector<Pothos::InputPort *> removeInputs, addInputs;
+    for (const auto &dst : removes)
+    {
+        auto dstBlock = getLocalBlock(dst.obj);
+        if (dstBlock != nullptr) removeInputs.push_back(dstBlock->input(dst.name));
+    }
+    for (const auto &dst : adds)
+    {
+        auto dstBlock = getLocalBlock(dst.obj);
+        if (dstBlock != nullptr) addInputs.push_back(dstBlock->input(dst.name));
+    }
+
+    if (srcBlock != nullptr and removeInputs.size() == removes.size() and addInputs.size() == adds.size())
+    {
+        srcBlock->_actor->resubscribeInputs(src.name, removeInputs, addInputs);
+    }
+    else //one call per destination through the proxy (adds first so the port is never without its consumers)
+    {
+        auto actor = src.obj.get("_actor");
+        for (const auto &dst : adds) actor.call("subscribeInput", "add", src.name, dst.obj.call("input", dst.name));
+        for (const auto &dst : removes) actor.call("subscribeInput", "remove", src.name, dst.obj.call("input", dst.name));
+    }
+
+    for (const auto &dst : removes) subscribeDst(src, dst, "remove");
+}
+
+static void redirectFlows(const std::vector<Flow> &removeFlows, const std::vector<Flow> &addFlows)
+{
+    //group the changes by source port
+    std::unordered_map<Port, std::pair<std::vector<Port>, std::vector<Port>>> srcs;
+    for (const auto &flow : removeFlows) srcs[flow.src].first.push_back(flow.dst);
+    for (const auto &flow : addFlows) srcs[flow.src].second.push_back(flow.dst);
+
+    //result list is used to ack all redirect messages
+    std::vector<FutureInfo> infoFutures;
+    for (const auto &pair : srcs)
+    {
+        std::shared_future<void> result(std::async(std::launch::async, redirectPort, pair.first, pair.second.first, pair.second.second));
+        infoFutures.push_back(FutureInfo(Poco::format("redirect(%s)", pair.first.name), pair.first.obj, result));
+    }
+
+    //check all redirect message results
+    const auto errors = collectFutureInfoErrors(infoFutures);
+    if (not errors.empty()) throw Pothos::TopologyConnectError(errors);
+}
+
 /***********************************************************************
  * complete pass-through flows
  **********************************************************************/
@@ -199,11 +381,116 @@ static std::vector<Flow> completePassThroughFlows(const std::vector<Flow> &flows
 /***********************************************************************
  * Sub Topology commit on flattened flows
  **********************************************************************/
+/*!
+ * Make a call on the actor of every block in the flows, one batch per environment.
+ * \throws Exception from the first call that failed
+ */
+template <typename... ArgsType>
+static void callActorsInBatches(const std::vector<Flow> &flows, const std::string &name, const ArgsType &... args)
+{
+    std::map<std::string, std::shared_ptr<Pothos::ProxyBatch>> batches;
+    std::vector<std::pair<std::shared_ptr<Pothos::ProxyBatch>, Pothos::ProxyBatchRef>> refs;
+    for (auto block : getObjSetFromFlowList(flows))
+    {
+        auto &batch = batches[block.getEnvironment()->getUniquePid()];
+        if (not batch) batch.reset(new Pothos::ProxyBatch(block.getEnvironment()));
+        const auto actorRef = batch->call(block, "get:_actor");
+        batch->discard(actorRef);
+        refs.emplace_back(batch, batch->call(actorRef, name, args...));
+        batch->discard(refs.back().second);
+    }
+    for (const auto &pair : batches) pair.second->execute();
+    for (const auto &ref : refs) ref.first->get(ref.second); //throws on error
+}
+
 static void setActiveState(const Pothos::Proxy &block, const bool state)
 {
+    auto local = getLocalActor(block);
+    if (local != nullptr and state) return local->setActiveStateOn();
+    if (local != nullptr) return local->setActiveStateOff();
     block.get("_actor").call(state?"setActiveStateOn":"setActiveStateOff");
 }
 
+/***********************************************************************
+ * Order the pool tasks by the dataflow:
+ * The blocks are ranked with a topological sort of the flows,
+ * so that the pool threads visit a producer before its consumers.
+ * Blocks in a feedback loop are ranked after the sorted blocks.
+ * The connected components are numbered for the sticky task order.
+ **********************************************************************/
+static void updateTaskOrders(const std::vector<Flow> &flatFlows)
+{
+    std::map<std::string, Pothos::Proxy> blocks;
+    std::map<std::string, std::set<std::string>> consumers;
+    std::map<std::string, size_t> numProducers;
+    std::map<std::string, std::string> parents;
+    for (const auto &block : getObjSetFromFlowList(flatFlows))
+    {
+        auto local = getLocalBlock(block);
+        const auto uid = (local != nullptr)?local->uid():block.call<std::string>("uid");
+        blocks[uid] = block;
+        numProducers[uid] = 0;
+        parents[uid] = uid;
+    }
+
+    //union-find for the connected components
+    std::function<std::string(const std::string &)> findRoot = [&](const std::string &uid)
+    {
+        const auto parent = parents.at(uid);
+        if (parent == uid) return uid;
+        return parents[uid] = findRoot(parent);
+    };
+
+    for (const auto &flow : flatFlows)
+    {
+        if (not flow.src.obj or not flow.dst.obj) continue;
+        if (flow.src.uid == flow.dst.uid) continue;
+        if (consumers[flow.src.uid].insert(flow.dst.uid).second) numProducers[flow.dst.uid]++;
+        parents[findRoot(flow.src.uid)] = findRoot(flow.dst.uid);
+    }
+
+    //topological sort with Kahn's algorithm, ties are broken by uid
+    std::vector<std::string> sorted;
+    std::set<std::string> ready;
+    for (const auto &pair : numProducers)
+    {
+        if (pair.second == 0) ready.insert(pair.first);
+    }
+    while (not ready.empty())
+    {
+        const auto uid = *ready.begin();
+        ready.erase(ready.begin());
+        sorted.push_back(uid);
+        for (const auto &consumer : consumers[uid])
+        {
+            if (--numProducers[consumer] == 0) ready.insert(consumer);
+        }
+    }
+    for (const auto &pair : numProducers)
+    {
+        if (pair.second != 0) sorted.push_back(pair.first);
+    }
+
+    //group the orders by the thread environment of each block
+    std::map<std::string, size_t> components;
+    std::map<std::shared_ptr<void>, std::map<void *, TaskOrder>> envOrders;
+    for (size_t rank = 0; rank < sorted.size(); rank++)
+    {
+        auto root = findRoot(sorted[rank]);
+        auto it = components.find(root);
+        if (it == components.end()) it = components.emplace(root, components.size()).first;
+        auto block = getLocalBlock(blocks.at(sorted[rank]));
+        if (block == nullptr) block = blocks.at(sorted[rank]).call<Pothos::Block *>("getPointer");
+        const auto threadPool = block->getThreadPool();
+        if (not threadPool) continue;
+        envOrders[threadPool.getContainer()][block] = TaskOrder{rank, it->second};
+    }
+    for (const auto &pair : envOrders)
+    {
+        std::static_pointer_cast<ThreadEnvironment>(pair.first)->setTaskOrders(pair.second);
+    }
+}
+
 void topologySubCommit(Pothos::Topology &topology)
 {
     auto &_impl = topology._impl;
@@ -212,50 +499,89 @@ void topologySubCommit(Pothos::Topology &topology)
 
     //new flows are in flat flows but not in current
     std::vector<Flow> newFlows;
+    const std::unordered_set<Flow> activeFlowSet(activeFlatFlows.begin(), activeFlatFlows.end());
     for (const auto &flow : flatFlows)
     {
-        if (std::find(activeFlatFlows.begin(), activeFlatFlows.end(), flow) == activeFlatFlows.end()) newFlows.push_back(flow);
+        if (activeFlowSet.count(flow) == 0) newFlows.push_back(flow);
     }
 
     //old flows are in current and not in flat flows
     std::vector<Flow> oldFlows;
-    for (const auto &flow : _impl->activeFlatFlows)
+    const std::unordered_set<Flow> flatFlowSet(flatFlows.begin(), flatFlows.end());
+    for (const auto &flow : activeFlatFlows)
     {
-        if (std::find(flatFlows.begin(), flatFlows.end(), flow) == flatFlows.end()) oldFlows.push_back(flow);
+        if (flatFlowSet.count(flow) == 0) oldFlows.push_back(flow);
     }
 
-    //add new data acceptors
-    updateFlows(newFlows, "add");
-
-    //remove old data acceptors
-    updateFlows(oldFlows, "remove");
+    //The blocks that are already running keep running through the change:
+    //flows from new blocks are subscribed and the new blocks activated off to the side,
+    //then each running source port switches to its new destinations in one step.
+    std::unordered_set<std::string> runningUids, keptUids;
+    for (const auto &flow : activeFlatFlows)
+    {
+        runningUids.insert(flow.src.uid);
+        runningUids.insert(flow.dst.uid);
+    }
+    for (const auto &flow : flatFlows)
+    {
+        keptUids.insert(flow.src.uid);
+        keptUids.insert(flow.dst.uid);
+    }
+    std::vector<Flow> freshFlows, addFlows, removeFlows, retiredFlows;
+    for (const auto &flow : newFlows)
+    {
+        if (runningUids.count(flow.src.uid) == 0) freshFlows.push_back(flow);
+        else addFlows.push_back(flow);
+    }
+    for (const auto &flow : oldFlows)
+    {
+        if (keptUids.count(flow.src.uid) != 0) removeFlows.push_back(flow);
+        else retiredFlows.push_back(flow);
+    }
 
-    //install buffer managers on sources for all new flows
-    //Sometimes this will replace previous buffer managers.
-    installBufferManagers(newFlows);
+    //add data acceptors and buffer managers to the sources that are not running yet
+    updateFlows(freshFlows, "add");
+    installBufferManagers(freshFlows, flatFlows);
 
-    //result list is used to ack all de/activate messages
-    std::vector<FutureInfo> infoFutures;
+    //order the pool tasks before the new blocks are activated
+    updateTaskOrders(flatFlows);
 
     //send activate to all new blocks not already in active flows
+    std::vector<FutureInfo> activateFutures;
     for (auto block : getObjSetFromFlowList(newFlows, activeFlatFlows))
     {
+        auto local = getLocalActor(block);
+        if (local != nullptr) local->setActivityNotifier(_impl->activityNotifier);
+        else block.get("_actor").call("setActivityNotifier", _impl->activityNotifier);
         std::shared_future<void> result(std::async(std::launch::async, setActiveState, block, true));
-        infoFutures.push_back(FutureInfo("activate()", block, result));
+        activateFutures.push_back(FutureInfo("activate()", block, result));
     }
 
+    //the new blocks are active before the running sources send to them
+    auto errors = collectFutureInfoErrors(activateFutures);
+
+    //switch the running sources to the new destinations,
+    //then install buffer managers for their new sets of destinations
+    //Sometimes this will replace previous buffer managers.
+    redirectFlows(removeFlows, addFlows);
+    installBufferManagers(addFlows, flatFlows);
+
+    //remove old data acceptors from the sources that stop
+    updateFlows(retiredFlows, "remove");
+
     //update current flows
     _impl->activeFlatFlows = flatFlows;
 
     //send deactivate to all old blocks not in current active flows
+    std::vector<FutureInfo> deactivateFutures;
     for (auto block : getObjSetFromFlowList(oldFlows, _impl->activeFlatFlows))
     {
         std::shared_future<void> result(std::async(std::launch::async, setActiveState, block, false));
-        infoFutures.push_back(FutureInfo("deactivate()", block, result));
+        deactivateFutures.push_back(FutureInfo("deactivate()", block, result));
     }
 
     //check all de/activate message results
-    const auto errors = collectFutureInfoErrors(infoFutures);
+    errors += collectFutureInfoErrors(deactivateFutures);
     if (not errors.empty()) throw Pothos::TopologyConnectError(errors);
 }
 
@@ -267,10 +593,39 @@ static void subCommitFutureTask(const Pothos::Proxy &proxy)
     proxy.call("subCommit");
 }
 
+static void subTopologyChangeTask(const Pothos::Proxy &proxy, const std::vector<std::pair<bool, Flow>> &changes)
+{
+    //all changes for an environment are sent in one batch
+    Pothos::ProxyBatch batch(proxy.getEnvironment());
+    std::vector<Pothos::ProxyBatchRef> refs;
+    for (const auto &change : changes)
+    {
+        const auto &flow = change.second;
+        refs.push_back(batch.call(proxy, change.first?"connect":"disconnect", flow.src.obj, flow.src.name, flow.dst.obj, flow.dst.name));
+        batch.discard(refs.back());
+    }
+    batch.execute();
+    for (const auto &ref : refs) batch.get(ref); //throws on error
+}
+
+std::shared_future<void> Pothos::Topology::commitAsync(void)
+{
+    //wait for the pending async commit so that they apply in the order of the calls
+    std::shared_future<void> previous = _impl->asyncCommit;
+    _impl->asyncCommit = std::async(std::launch::async, [this, previous](void)
+    {
+        if (previous.valid()) previous.wait();
+        this->commit();
+    }).share();
+    return _impl->asyncCommit;
+}
+
 void Pothos::Topology::commit(void)
 {
+    std::lock_guard<std::mutex> lock(_impl->commitMutex);
+
     //0) flatten the topology
-    auto squashedFlows = _impl->squashFlows(_impl->flows);
+    auto squashedFlows = _impl->squashFlowsCached();
 
     //1) complete the pass-through flows
     auto completeFlows = completePassThroughFlows(squashedFlows);
@@ -281,6 +636,9 @@ void Pothos::Topology::commit(void)
     //3) deal with domain crossing
     flatFlows = _impl->rectifyDomainFlows(flatFlows);
 
+    //4) check the fused groups before making any changes
+    const auto fusedGroups = _impl->checkFusedGroups(flatFlows);
+
     //create remote topologies for all environments
     for (const auto &obj : getObjSetFromFlowList(flatFlows))
     {
@@ -289,15 +647,84 @@ void Pothos::Topology::commit(void)
         _impl->remoteTopologies[upid] = obj.getEnvironment()->findProxy("Pothos/Topology").call("make");
     }
 
-    //clear connections on old topologies
-    for (const auto &pair : _impl->remoteTopologies) pair.second.call("disconnectAll");
-
-    //load each topology with connections from flat flows
+    //update the sub-topologies incrementally:
+    //only removed flows are disconnected and only new flows are connected,
+    //the changes are batched per environment and applied concurrently
+    std::map<std::string, std::vector<std::pair<bool, Flow>>> subTopologyChanges;
+    const std::unordered_set<Flow> flatFlowSet(flatFlows.begin(), flatFlows.end());
+    const std::unordered_set<Flow> subFlowSet(_impl->subTopologyFlows.begin(), _impl->subTopologyFlows.end());
+    for (const auto &flow : _impl->subTopologyFlows)
+    {
+        if (flatFlowSet.count(flow) != 0) continue;
+        subTopologyChanges[flow.src.obj.getEnvironment()->getUniquePid()].emplace_back(false, flow);
+    }
     for (const auto &flow : flatFlows)
     {
+        if (subFlowSet.count(flow) != 0) continue;
         auto upid = flow.src.obj.getEnvironment()->getUniquePid();
         assert(upid == flow.dst.obj.getEnvironment()->getUniquePid());
-        _impl->remoteTopologies[upid].call("connect", flow.src.obj, flow.src.name, flow.dst.obj, flow.dst.name);
+        subTopologyChanges[upid].emplace_back(true, flow);
+    }
+
+    std::vector<std::future<void>> changeFutures;
+    for (const auto &pair : subTopologyChanges)
+    {
+        changeFutures.push_back(std::async(std::launch::async, &subTopologyChangeTask,
+            _impl->remoteTopologies.at(pair.first), pair.second));
+    }
+
+    std::string changeErrors;
+    for (auto &future : changeFutures)
+    {
+        try {future.get();}
+        catch (const Exception &ex)
+        {
+            changeErrors.append(ex.message()+"\n");
+        }
+    }
+
+    //on error, the sub-topologies are reloaded from scratch on the next commit
+    if (not changeErrors.empty())
+    {
+        for (const auto &pair : _impl->remoteTopologies) pair.second.call("disconnectAll");
+        _impl->subTopologyFlows.clear();
+        throw Pothos::TopologyConnectError("Pothos::Topology::commit()", changeErrors);
+    }
+    _impl->subTopologyFlows = flatFlows;
+
+    //set thread pools for all blocks in this process
+    //before the sub-commit so buffer placement can use the affinity
+    if (this->getThreadPool()) for (auto block : getObjSetFromFlowList(flatFlows))
+    {
+        auto local = getLocalBlock(block);
+        if (local != nullptr) local->setThreadPool(this->getThreadPool());
+        else if (isLocalProxy(block)) block.call<Block *>("getPointer")->setThreadPool(this->getThreadPool());
+    }
+
+    //fuse the groups once the thread pools are set,
+    //and before the sub-commit installs the buffer managers
+    _impl->applyFusedGroups(fusedGroups, flatFlows);
+
+    //set the stats level and trace for all blocks in the design
+    if (not this->getStatsLevel().empty())
+    {
+        callActorsInBatches(flatFlows, "setStatsLevel", Pothos::Object(this->getStatsLevel()));
+    }
+    if (_impl->traceConfigured)
+    {
+        callActorsInBatches(flatFlows, "setTraceEnabled", Pothos::Object(_impl->traceEnabled));
+    }
+
+    //the default output buffers of a batch run, and back to normal afterwards
+    if (_impl->batchConfigured)
+    {
+        callActorsInBatches(flatFlows, "setBatchBufferSize", Pothos::Object(_impl->batchBufferSize));
+    }
+
+    //the blocks in each process share the account of this topology
+    if (_impl->memoryBudgetConfigured)
+    {
+        callActorsInBatches(flatFlows, "setMemoryBudget", Pothos::Object(this->uid()), Pothos::Object(_impl->memoryBudget));
     }
 
     //Call commit on all sub-topologies:
@@ -321,21 +748,16 @@ void Pothos::Topology::commit(void)
     }
     if (not errors.empty()) throw Pothos::TopologyConnectError("Pothos::Topology::commit()", errors);
 
-    //set thread pools for all blocks in this process
-    if (this->getThreadPool()) for (auto block : getObjSetFromFlowList(flatFlows))
-    {
-        if (block.getEnvironment()->getUniquePid() != Pothos::ProxyEnvironment::getLocalUniquePid()) continue; //is the block local?
-        block.call<Block *>("getPointer")->setThreadPool(this->getThreadPool());
-    }
-
     _impl->activeFlatFlows = flatFlows;
 
+    //stats queries look up the block names without dumping the topology
+    _impl->cacheBlockNames();
+
     //Remove disconnections from the cache if present
     //by only saving in the curretly in-use flows.
-    std::unordered_map<Port, std::pair<Pothos::Proxy, Pothos::Proxy>> newNetgressCache;
-    for (const auto &flow : completeFlows)
+    NetgressCache newNetgressCache;
+    for (const auto &port : _impl->netgressKeys)
     {
-        const auto port = envTagPort(flow.src, flow.dst);
         auto it = _impl->srcToNetgressCache.find(port);
         if (it == _impl->srcToNetgressCache.end()) continue;
         newNetgressCache[it->first] = it->second;
@@ -1,24 +1,77 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/TopologyImpl.hpp"
+#include <Pothos/Proxy/Batch.hpp>
+#include <functional>
 #include <future>
 #include <iostream>
 #include <algorithm>
 #include <map>
 
 /***********************************************************************
- * helpers to call into remote worker
+ * batched queries into the block environments
  **********************************************************************/
-static std::string getBufferMode(const Port &port, const std::string &domain, const bool &isInput)
+typedef std::function<Pothos::ProxyBatchRef(Pothos::ProxyBatch &, const size_t)> QueueQueryFcn;
+
+/*!
+ * Make a string-valued query for each port.
+ * The queries are made in one batch per environment,
+ * and the batches for each environment are made concurrently.
+ */
+static std::vector<std::string> batchPortQueries(const std::vector<Port> &ports, const QueueQueryFcn &queueQuery)
 {
-    auto actor = port.obj.get("_actor");
-    return actor.call("getBufferMode", port.name, domain, isInput);
+    std::map<std::string, std::vector<size_t>> envToIndexes;
+    for (size_t i = 0; i < ports.size(); i++)
+    {
+        envToIndexes[ports[i].obj.getEnvironment()->getUniquePid()].push_back(i);
+    }
+
+    std::vector<std::string> results(ports.size());
+    std::vector<std::future<void>> futures;
+    for (const auto &pair : envToIndexes)
+    {
+        const auto &indexes = pair.second;
+        futures.push_back(std::async(std::launch::async, [&ports, &queueQuery, &results, &indexes]
+        {
+            Pothos::ProxyBatch batch(ports[indexes.front()].obj.getEnvironment());
+            std::vector<Pothos::ProxyBatchRef> refs;
+            for (const auto i : indexes) refs.push_back(queueQuery(batch, i));
+            batch.execute();
+            for (size_t j = 0; j < indexes.size(); j++)
+            {
+                results[indexes[j]] = batch.get<std::string>(refs[j]);
+            }
+        }));
+    }
+    for (auto &future : futures) future.get();
+    return results;
 }
 
-static std::string getDomain(const Port &port, const bool &isInput)
+/***********************************************************************
+ * keys for the cached plan of the crossings
+ **********************************************************************/
+static std::string portKey(const Port &port, const bool isInput)
 {
-    return port.obj.call(isInput?"input":"output", port.name).call("domain");
+    return std::string(isInput?"in:":"out:") + port.uid + "\n" + port.name;
+}
+
+//! The key of a main port and its sub ports in any order
+static std::string crossingKey(const Port &mainPort, const std::vector<Port> &subPorts, const bool isInput)
+{
+    std::vector<std::string> subKeys;
+    for (const auto &subPort : subPorts) subKeys.push_back(portKey(subPort, not isInput));
+    std::sort(subKeys.begin(), subKeys.end());
+    auto key = portKey(mainPort, isInput);
+    for (const auto &subKey : subKeys) key += "\n\n" + subKey;
+    return key;
+}
+
+static std::shared_future<Pothos::Proxy> readyCopier(const Pothos::Proxy &copier)
+{
+    std::promise<Pothos::Proxy> promise;
+    promise.set_value(copier);
+    return promise.get_future();
 }
 
 /***********************************************************************
@@ -26,31 +79,36 @@ static std::string getDomain(const Port &port, const bool &isInput)
  **********************************************************************/
 
 /*!
- * Is this domain crossing possible between mainPort and all connected subPorts?
+ * The crossing between a main port and its connected sub ports in one domain.
+ * A main port with sub ports in several domains has one inspection per domain,
+ * so that copier blocks are only inserted on the flows that need them.
+ */
+struct DomainInspection
+{
+    Port mainPort;
+    std::vector<Port> subPorts;
+    bool isInput;
+    std::string mainDomain;
+    std::string subDomain;
+    size_t mainModeIndex;
+    std::vector<size_t> subModeIndexes;
+};
+
+/*!
+ * Is this domain crossing possible between mainPort and the subPorts of the domain?
  */
 static bool isDomainCrossingAcceptable(
-    const Port &mainPort,
-    const std::vector<Port> &subPorts,
-    const bool isInput
+    const DomainInspection &inspection,
+    const std::vector<std::string> &modes
 )
 {
-    auto mainDomain = getDomain(mainPort, isInput);
-
     bool allOthersAbdicate = true;
-    std::set<std::string> subDomains;
-    for (const auto &subPort : subPorts)
+    for (const auto index : inspection.subModeIndexes)
     {
-        subDomains.insert(getDomain(subPort, not isInput));
-        const auto subMode = getBufferMode(subPort, mainDomain, not isInput);
-        if (subMode != "ABDICATE") allOthersAbdicate = false;
+        if (modes[index] != "ABDICATE") allOthersAbdicate = false;
     }
 
-    //cant handle multiple domains
-    if (subDomains.size() > 1) return false;
-
-    assert(subDomains.size() == 1);
-    const auto subDomain = *subDomains.begin();
-    const auto mainMode = getBufferMode(mainPort, subDomain, isInput);
+    const auto &mainMode = modes[inspection.mainModeIndex];
 
     //error always means we make a copy block
     if (mainMode == "ERROR") return false;
@@ -62,7 +120,7 @@ static bool isDomainCrossingAcceptable(
     assert(mainMode == "CUSTOM");
 
     //cant handle custom with multiple upstream
-    if (isInput and mainMode == "CUSTOM" and subPorts.size() > 1) return false;
+    if (inspection.isInput and mainMode == "CUSTOM" and inspection.subPorts.size() > 1) return false;
 
     //if custom, the sub ports must abdicate
     if (mainMode == "CUSTOM" and not allOthersAbdicate) return false;
@@ -71,37 +129,252 @@ static bool isDomainCrossingAcceptable(
 }
 
 /*!
- * Get a copier block for a domain crossing between mainPort and all connected subPorts.
- * If the copier block is not needed to handle this domain crossing, return a null Proxy.
+ * Does every port in the crossing abdicate, so that a generic manager serves it?
  */
-static Pothos::Proxy getCopierForDomainCrossing(
-    const Port &mainPort,
-    const std::vector<Port> &subPorts,
-    const bool isInput
+static bool isDomainCrossingGeneric(
+    const DomainInspection &inspection,
+    const std::vector<std::string> &modes
 )
 {
-    if (isDomainCrossingAcceptable(mainPort, subPorts, isInput)) return Pothos::Proxy();
-    auto registry = mainPort.obj.getEnvironment()->findProxy("Pothos/BlockRegistry");
-    auto copier = registry.call("/blocks/copier");
+    if (modes[inspection.mainModeIndex] != "ABDICATE") return false;
+    for (const auto index : inspection.subModeIndexes)
+    {
+        if (modes[index] != "ABDICATE") return false;
+    }
+    return true;
+}
+
+/*!
+ * Select the acceptable crossings of a main port which connect directly.
+ * An output port has one buffer manager for all of its direct consumers:
+ * the crossing with the most consumers keeps the buffers of the port,
+ * and other crossings only join it when they all use a generic manager.
+ * An input port has a buffer manager per upstream port,
+ * except for a custom input manager which serves a single upstream.
+ * \param group the indexes of the inspections for one main port
+ * \return a flag for each inspection, true to connect directly
+ */
+static std::vector<bool> selectDirectCrossings(
+    const std::vector<DomainInspection> &inspections,
+    const std::vector<size_t> &group,
+    const std::vector<std::string> &modes
+)
+{
+    std::vector<bool> direct(group.size(), false);
+    std::vector<bool> acceptable(group.size());
+    for (size_t i = 0; i < group.size(); i++)
+    {
+        acceptable[i] = isDomainCrossingAcceptable(inspections[group[i]], modes);
+    }
+
+    if (inspections[group.front()].isInput)
+    {
+        bool haveCustom = false;
+        for (size_t i = 0; i < group.size(); i++)
+        {
+            if (not acceptable[i]) continue;
+            const bool isCustom = modes[inspections[group[i]].mainModeIndex] == "CUSTOM";
+            if (isCustom and haveCustom) continue;
+            haveCustom = haveCustom or isCustom;
+            direct[i] = true;
+        }
+        return direct;
+    }
+
+    //select the crossing with the most consumers, prefer the same domain on ties
+    size_t best = group.size();
+    for (size_t i = 0; i < group.size(); i++)
+    {
+        if (not acceptable[i]) continue;
+        if (best == group.size()) {best = i; continue;}
+        const auto &a = inspections[group[i]];
+        const auto &b = inspections[group[best]];
+        if (a.subPorts.size() > b.subPorts.size() or (a.subPorts.size() == b.subPorts.size() and
+            a.subDomain == a.mainDomain and b.subDomain != b.mainDomain)) best = i;
+    }
+    if (best == group.size()) return direct;
+    direct[best] = true;
+
+    //generic crossings share the generic manager of the selected crossing
+    if (not isDomainCrossingGeneric(inspections[group[best]], modes)) return direct;
+    for (size_t i = 0; i < group.size(); i++)
+    {
+        if (acceptable[i] and isDomainCrossingGeneric(inspections[group[i]], modes)) direct[i] = true;
+    }
+    return direct;
+}
+
+/*!
+ * Get a copier block for a domain crossing on the main port.
+ * The toolkits of the domains select a copier for the crossing,
+ * such as a staging block between host and device memory,
+ * otherwise the crossing uses the generic copier block.
+ */
+static Pothos::Proxy makeCopierForDomainCrossing(const DomainInspection &inspection)
+{
+    const auto &srcDomain = inspection.isInput?inspection.subDomain:inspection.mainDomain;
+    const auto &dstDomain = inspection.isInput?inspection.mainDomain:inspection.subDomain;
+
+    auto registry = inspection.mainPort.obj.getEnvironment()->findProxy("Pothos/BlockRegistry");
+    const auto path = registry.call<std::string>("findDomainCopier", srcDomain, dstDomain);
+    auto copier = registry.call(path);
     copier.call("setName", "DomainBridge");
     return copier;
 }
 
+//! The copier for each flow of a main port by sub port, null when the flow is direct
+typedef std::unordered_map<Port, std::unordered_map<Port, std::shared_future<Pothos::Proxy>>> PortCopierMap;
+
 /*!
- * Get a future for each port to inspect it for domain crossing.
+ * Inspect each port for domain crossing and get a future for the copiers.
+ * Flows that do not need a copier block have a future for a null Proxy,
+ * and the sub ports of one crossing share the future of a single copier.
+ * The crossings in the plan of the last commit reuse its copiers,
+ * and the ports with a cached domain are not queried again.
+ * All other domain and buffer mode queries are batched per environment.
  */
-static std::unordered_map<Port, std::shared_future<Pothos::Proxy>> domainInspection(
-    const std::unordered_map<Port, std::vector<Port>> &ports,
-    const bool isInput
+static void domainInspection(
+    const std::unordered_map<Port, std::vector<Port>> &allSrcs,
+    const std::unordered_map<Port, std::vector<Port>> &allDsts,
+    const std::unordered_map<std::string, std::unordered_map<Port, Pothos::Proxy>> &planCache,
+    std::unordered_map<std::string, std::string> &domainCache,
+    PortCopierMap &srcCopiers,
+    PortCopierMap &dstCopiers
 )
 {
-    std::unordered_map<Port, std::shared_future<Pothos::Proxy>> copiers;
-    for (const auto &pair : ports)
+    //apply the cached plan, and inspect the main ports without one
+    std::unordered_map<Port, std::vector<Port>> srcs, dsts;
+    auto applyPlan = [&](const std::unordered_map<Port, std::vector<Port>> &all, std::unordered_map<Port, std::vector<Port>> &inspect, PortCopierMap &copiers, const bool isInput)
+    {
+        for (const auto &pair : all)
+        {
+            auto it = planCache.find(crossingKey(pair.first, pair.second, isInput));
+            if (it == planCache.end()) inspect.insert(pair);
+            else for (const auto &subPort : pair.second)
+            {
+                copiers[pair.first][subPort] = readyCopier(it->second.at(subPort));
+            }
+        }
+    };
+    applyPlan(allSrcs, srcs, srcCopiers, false);
+    applyPlan(allDsts, dsts, dstCopiers, true);
+    if (srcs.empty() and dsts.empty()) return;
+
+    //query the domain of every port in the inspections without a cached domain
+    std::vector<Port> domainPorts;
+    std::vector<bool> domainIsInput;
+    auto addDomainQuery = [&](const Port &port, const bool isInput)
     {
-        copiers[pair.first] = std::async(std::launch::async,
-            &getCopierForDomainCrossing, pair.first, pair.second, isInput);
+        const auto key = portKey(port, isInput);
+        if (domainCache.count(key) != 0) return;
+        domainCache[key]; //reserve the entry, so the port is queried once
+        domainPorts.push_back(port);
+        domainIsInput.push_back(isInput);
+    };
+    for (const auto &pair : srcs)
+    {
+        addDomainQuery(pair.first, false);
+        for (const auto &subPort : pair.second) addDomainQuery(subPort, true);
+    }
+    for (const auto &pair : dsts)
+    {
+        addDomainQuery(pair.first, true);
+        for (const auto &subPort : pair.second) addDomainQuery(subPort, false);
+    }
+    std::vector<std::string> domains;
+    try
+    {
+        domains = batchPortQueries(domainPorts, [&](Pothos::ProxyBatch &batch, const size_t i)
+    {
+        const auto &port = domainPorts[i];
+        const auto portRef = batch.call(port.obj, domainIsInput[i]?"input":"output", port.name);
+        batch.discard(portRef);
+        const auto domainRef = batch.call(portRef, "domain");
+        batch.convert(domainRef);
+        return domainRef;
+    });
+    }
+    catch (...)
+    {
+        for (size_t i = 0; i < domainPorts.size(); i++) domainCache.erase(portKey(domainPorts[i], domainIsInput[i]));
+        throw;
+    }
+    for (size_t i = 0; i < domainPorts.size(); i++)
+    {
+        domainCache[portKey(domainPorts[i], domainIsInput[i])] = domains[i];
+    }
+    auto srcDomain = [&domainCache](const Port &port){return domainCache.at(portKey(port, false));};
+    auto dstDomain = [&domainCache](const Port &port){return domainCache.at(portKey(port, true));};
+
+    //determine the buffer mode queries for every main port and sub domain
+    std::vector<DomainInspection> inspections;
+    std::vector<std::vector<size_t>> inspectionGroups;
+    std::vector<Port> modePorts;
+    std::vector<std::string> modeDomains;
+    std::vector<bool> modeIsInput;
+    auto addModeQuery = [&](const Port &port, const std::string &domain, const bool isInput)
+    {
+        modePorts.push_back(port);
+        modeDomains.push_back(domain);
+        modeIsInput.push_back(isInput);
+        return modePorts.size()-1;
+    };
+    auto addInspections = [&](const Port &mainPort, const std::vector<Port> &subPorts, const bool isInput)
+    {
+        std::map<std::string, std::vector<Port>> domainToSubPorts;
+        for (const auto &subPort : subPorts)
+        {
+            domainToSubPorts[isInput?srcDomain(subPort):dstDomain(subPort)].push_back(subPort);
+        }
+
+        std::vector<size_t> group;
+        for (const auto &pair : domainToSubPorts)
+        {
+            DomainInspection inspection;
+            inspection.mainPort = mainPort;
+            inspection.subPorts = pair.second;
+            inspection.isInput = isInput;
+            inspection.mainDomain = isInput?dstDomain(mainPort):srcDomain(mainPort);
+            inspection.subDomain = pair.first;
+            for (const auto &subPort : inspection.subPorts)
+            {
+                inspection.subModeIndexes.push_back(addModeQuery(subPort, inspection.mainDomain, not isInput));
+            }
+            inspection.mainModeIndex = addModeQuery(mainPort, inspection.subDomain, isInput);
+            group.push_back(inspections.size());
+            inspections.push_back(inspection);
+        }
+        inspectionGroups.push_back(group);
+    };
+    for (const auto &pair : srcs) addInspections(pair.first, pair.second, false);
+    for (const auto &pair : dsts) addInspections(pair.first, pair.second, true);
+
+    //query all buffer modes
+    const auto modes = batchPortQueries(modePorts, [&](Pothos::ProxyBatch &batch, const size_t i)
+    {
+        const auto &port = modePorts[i];
+        const auto actorRef = batch.call(port.obj, "get:_actor");
+        batch.discard(actorRef);
+        const auto modeRef = batch.call(actorRef, "getBufferMode", port.name, modeDomains[i], bool(modeIsInput[i]));
+        batch.convert(modeRef);
+        return modeRef;
+    });
+
+    //make one copier block per crossing that does not connect directly
+    for (const auto &group : inspectionGroups)
+    {
+        const auto direct = selectDirectCrossings(inspections, group, modes);
+        for (size_t i = 0; i < group.size(); i++)
+        {
+            const auto &inspection = inspections[group[i]];
+            std::shared_future<Pothos::Proxy> copier;
+            if (direct[i]) copier = readyCopier(Pothos::Proxy());
+            else copier = std::async(std::launch::async, &makeCopierForDomainCrossing, inspection);
+
+            auto &copiers = (inspection.isInput?dstCopiers:srcCopiers)[inspection.mainPort];
+            for (const auto &subPort : inspection.subPorts) copiers[subPort] = copier;
+        }
     }
-    return copiers;
 }
 
 /***********************************************************************
@@ -113,22 +386,19 @@ std::vector<Flow> Pothos::Topology::Impl::rectifyDomainFlows(const std::vector<F
     std::unordered_map<Port, std::vector<Port>> srcs, dsts;
     for (const auto &flow : flatFlows)
     {
-        for (const auto &subFlow : flatFlows)
-        {
-            if (subFlow.src == flow.src) srcs[flow.src].push_back(subFlow.dst);
-            if (subFlow.dst == flow.dst) dsts[flow.dst].push_back(subFlow.src);
-        }
+        srcs[flow.src].push_back(flow.dst);
+        dsts[flow.dst].push_back(flow.src);
     }
 
     //get a list of ports with domain problems
-    auto badSrcsToCopier = domainInspection(srcs, false);
-    auto badDstsToCopier = domainInspection(dsts, true);
+    PortCopierMap badSrcsToCopier, badDstsToCopier;
+    domainInspection(srcs, dsts, crossingPlanCache, portDomainCache, badSrcsToCopier, badDstsToCopier);
 
     std::vector<Flow> domainSafeFlows;
     for (const auto &flow : flatFlows)
     {
-        auto srcCopier = badSrcsToCopier.at(flow.src).get();
-        auto dstCopier = badDstsToCopier.at(flow.dst).get();
+        auto srcCopier = badSrcsToCopier.at(flow.src).at(flow.dst).get();
+        auto dstCopier = badDstsToCopier.at(flow.dst).at(flow.src).get();
         Pothos::Proxy copier;
         if (srcCopier) copier = srcCopier;
         if (dstCopier) copier = dstCopier;
@@ -153,5 +423,26 @@ std::vector<Flow> Pothos::Topology::Impl::rectifyDomainFlows(const std::vector<F
         }
     }
 
+    //save the plan of this commit, dropping the ports that are not in use
+    std::unordered_map<std::string, std::string> newDomainCache;
+    std::unordered_map<std::string, std::unordered_map<Port, Pothos::Proxy>> newPlanCache;
+    auto savePlan = [&](const std::unordered_map<Port, std::vector<Port>> &all, const PortCopierMap &copiers, const bool isInput)
+    {
+        for (const auto &pair : all)
+        {
+            auto &plan = newPlanCache[crossingKey(pair.first, pair.second, isInput)];
+            for (const auto &subPort : pair.second) plan[subPort] = copiers.at(pair.first).at(subPort).get();
+
+            //every port of the flows is the main port of a crossing
+            const auto key = portKey(pair.first, isInput);
+            auto it = portDomainCache.find(key);
+            if (it != portDomainCache.end()) newDomainCache.insert(*it);
+        }
+    };
+    savePlan(srcs, badSrcsToCopier, false);
+    savePlan(dsts, badDstsToCopier, true);
+    portDomainCache = newDomainCache;
+    crossingPlanCache = newPlanCache;
+
     return domainSafeFlows;
 }
@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/TopologyImpl.hpp"
@@ -9,7 +9,11 @@
 #include <Poco/XML/XMLWriter.h>
 #include <Poco/AutoPtr.h>
 #include <Poco/NumberParser.h>
+#include <Poco/Format.h>
 #include <sstream>
+#include <algorithm> //min/max
+#include <map>
+#include <tuple>
 #include <json.hpp>
 
 using json = nlohmann::json;
@@ -82,12 +86,47 @@ static json getConnectedPortInfos(
     return filteredPortsInfo;
 }
 
+/*!
+ * Interpolate from azure for a ratio of 0.0 to red for a ratio of 1.0
+ */
+static std::string heatColor(const double ratio)
+{
+    const auto r = std::min(std::max(ratio, 0.0), 1.0);
+    const auto mix = [r](const int lo, const int hi){return int(lo + (hi-lo)*r);};
+    return Poco::format("#%02X%02X%02X", mix(0xF0, 0xFF), mix(0xFF, 0x30), mix(0xFF, 0x30));
+}
+
+typedef std::tuple<std::string, std::string, std::string, std::string> ConnKey;
+
+static ConnKey connKey(const json &obj)
+{
+    return ConnKey(
+        obj["srcId"].get<std::string>(), obj["srcName"].get<std::string>(),
+        obj["dstId"].get<std::string>(), obj["dstName"].get<std::string>());
+}
+
 std::string Pothos::Topology::toDotMarkup(const std::string &request)
 {
     //parse request arguments
     const auto configObj = json::parse(request.empty()?"{}":request);
     const auto portConfig = configObj.value<std::string>("port", "connected");
 
+    //optional bottleneck analysis to color the nodes and edges
+    std::map<std::string, double> blockUtilization;
+    std::map<ConnKey, json> connQueues;
+    if (configObj.value<bool>("bottlenecks", false))
+    {
+        const auto reportObj = json::parse(this->queryBottlenecks(request));
+        for (const auto &blockObj : reportObj["blocks"])
+        {
+            blockUtilization[blockObj["uid"].get<std::string>()] = blockObj["utilization"].get<double>();
+        }
+        for (const auto &queueObj : reportObj["queues"])
+        {
+            connQueues[connKey(queueObj)] = queueObj;
+        }
+    }
+
     //get a JSON dump of the topology
     const auto topObj = json::parse(this->dumpJSON(request));
     const auto connsArray = topObj["connections"];
@@ -133,11 +172,23 @@ std::string Pothos::Topology::toDotMarkup(const std::string &request)
             table->appendChild(tr);
             auto td = xmlDoc->createElement("td");
             td->setAttribute("border", "1");
-            td->setAttribute("bgcolor", "azure");
             tr->appendChild(td);
             std::string name = blockObj["name"];
             if (name.empty()) name = "Empty Name";
             td->appendChild(xmlDoc->createTextNode(name));
+
+            const auto utilIt = blockUtilization.find(blockId);
+            if (utilIt == blockUtilization.end()) td->setAttribute("bgcolor", "azure");
+            else
+            {
+                td->setAttribute("bgcolor", heatColor(utilIt->second));
+                auto utilTr = xmlDoc->createElement("tr");
+                table->appendChild(utilTr);
+                auto utilTd = xmlDoc->createElement("td");
+                utilTd->setAttribute("border", "0");
+                utilTr->appendChild(utilTd);
+                utilTd->appendChild(xmlDoc->createTextNode(Poco::format("%.0f%% busy", utilIt->second*100)));
+            }
         }
         if (not outputPorts.empty())
         {
@@ -165,6 +216,15 @@ std::string Pothos::Topology::toDotMarkup(const std::string &request)
         os << " -> ";
         os << std::hash<std::string>()(conn["dstId"].get<std::string>());
         os << ":__in__" << conn["dstName"].get<std::string>();
+        const auto queueIt = connQueues.find(connKey(conn));
+        if (queueIt != connQueues.end())
+        {
+            const auto fill = queueIt->second["queueFill"].get<double>();
+            os << " [color=\"" << heatColor(fill) << "\"";
+            os << ", penwidth=" << Poco::format("%.1f", 1.0 + 3.0*fill);
+            os << ", label=\"" << queueIt->second["enqueuedBytes"].get<unsigned long long>() << " B\"";
+            os << ", fontsize=8]";
+        }
         os << ";" << std::endl;
     }
 
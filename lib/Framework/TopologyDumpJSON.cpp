@@ -1,9 +1,10 @@
-// Copyright (c) 2015-2017 Josh Blum
+// Copyright (c) 2015-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/TopologyImpl.hpp>
 #include "Framework/TopologyImpl.hpp"
+#include "Framework/TopologyEncoding.hpp"
 #include <Pothos/Proxy.hpp>
 #include <json.hpp>
 
@@ -165,7 +166,7 @@ static json portInfoToObj(const Pothos::PortInfo &portInfo)
 std::string Pothos::Topology::dumpJSON(const std::string &request)
 {
     //extract input request
-    auto configObj = json::parse(request.empty()?"{}":request);
+    const auto configObj = json::parse(request.empty()?"{}":request);
     const std::string modeConfig = configObj.value("mode", "flat");
 
     //parse request into traversal arguments
@@ -218,8 +219,8 @@ std::string Pothos::Topology::dumpJSON(const std::string &request)
         //sub-topology info
         if (traverse and this->uid() != blockId) try
         {
-            std::string subDump = block.call("dumpJSON", "{\"mode\":\"top\"}");
-            auto subObj = json::parse(subDump);
+            std::string subDump = block.call("dumpJSON", "{\"mode\":\"top\", \"format\":\"cbor\"}");
+            auto subObj = decodeTopologyJSON(subDump);
             for (auto it = subObj.begin(); it != subObj.end(); ++it)
             {
                 blockObj[it.key()] = subObj[it.key()];
@@ -244,6 +245,21 @@ std::string Pothos::Topology::dumpJSON(const std::string &request)
     //recursive flatten when instructed
     while (flatten and flattenDump(topObj));
 
-    //return the string-formatted result
-    return topObj.dump(4);
+    //return the result in the requested format
+    return encodeTopologyJSON(topObj, configObj);
+}
+
+std::map<std::string, std::string> Pothos::Topology::Impl::cacheBlockNames(void)
+{
+    const auto flatObj = json::parse(self->dumpJSON("{\"mode\":\"flat\"}"));
+    const auto &flatBlocks = flatObj["blocks"];
+    std::map<std::string, std::string> names;
+    for (auto it = flatBlocks.begin(); it != flatBlocks.end(); ++it)
+    {
+        names[it.key()] = it.value()["name"].get<std::string>();
+    }
+
+    std::lock_guard<std::mutex> lock(blockNamesMutex);
+    blockNames = names;
+    return names;
 }
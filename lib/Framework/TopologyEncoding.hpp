@@ -0,0 +1,52 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Exception.hpp>
+#include <json.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*!
+ * Encode a JSON object in the format named by the "format" key of a request:
+ *  - "json": a JSON formatted string (the default)
+ *  - "cbor": the binary CBOR encoding, as bytes in the string
+ *  - "msgpack": the binary MessagePack encoding, as bytes in the string
+ * The binary encodings are smaller and much faster to parse
+ * for large topologies and stats shipped over remote proxies.
+ * \throws Pothos::InvalidArgumentException for an unknown format
+ */
+inline std::string encodeTopologyJSON(const nlohmann::json &obj, const nlohmann::json &requestObj)
+{
+    const std::string format = requestObj.value("format", "json");
+    if (format == "json") return obj.dump(4);
+    std::vector<uint8_t> bytes;
+    if (format == "cbor") bytes = nlohmann::json::to_cbor(obj);
+    else if (format == "msgpack") bytes = nlohmann::json::to_msgpack(obj);
+    else throw Pothos::InvalidArgumentException("encodeTopologyJSON()", "unknown format: " + format);
+    return std::string(bytes.begin(), bytes.end());
+}
+
+/*!
+ * Decode a JSON object from any encoding of encodeTopologyJSON().
+ * The encoding is detected from the leading byte of the object:
+ * CBOR maps are 0xa0-0xbb or 0xbf, MessagePack maps are 0x80-0x8f, 0xde, or 0xdf,
+ * and anything else is parsed as a JSON formatted string.
+ * \throws std::exception when the data cannot be decoded
+ */
+inline nlohmann::json decodeTopologyJSON(const std::string &data)
+{
+    if (data.empty()) return nlohmann::json::parse("{}");
+    const auto b0 = uint8_t(data.front());
+    if ((b0 >= 0xa0 and b0 <= 0xbb) or b0 == 0xbf)
+    {
+        return nlohmann::json::from_cbor(std::vector<uint8_t>(data.begin(), data.end()));
+    }
+    if ((b0 >= 0x80 and b0 <= 0x8f) or b0 == 0xde or b0 == 0xdf)
+    {
+        return nlohmann::json::from_msgpack(std::vector<uint8_t>(data.begin(), data.end()));
+    }
+    return nlohmann::json::parse(data);
+}
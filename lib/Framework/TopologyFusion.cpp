@@ -0,0 +1,285 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Framework/TopologyImpl.hpp"
+#include "Framework/ThreadEnvironment.hpp"
+#include <Pothos/Framework/Block.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Poco/Format.h>
+#include <Poco/Logger.h>
+#include <algorithm> //find/max
+#include <string>
+#include <set>
+
+/*!
+ * The number of output buffers on the connections inside of a fused group.
+ * The consumer executes right after the producer on the same thread,
+ * so the returned buffer is reused while its still in cache.
+ */
+static const size_t FusedNumBuffers = 2;
+
+/*!
+ * The largest repetitions of a member in one pass of a static schedule.
+ * Rates with a larger ratio are better served by the dynamic schedule.
+ */
+static const size_t MaxStaticRepetitions = 1 << 16;
+
+static size_t gcdOf(size_t a, size_t b)
+{
+    while (b != 0)
+    {
+        const size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/***********************************************************************
+ * The static schedule of a fused chain with fixed rate connections:
+ * Solve the balance equation reps[i]*produced = reps[i+1]*consumed
+ * over each connection between neighbors for the smallest repetitions,
+ * so that one pass leaves no elements behind on the connections.
+ * The repetitions are empty when any connection has a dynamic rate.
+ **********************************************************************/
+static std::vector<size_t> staticRepetitions(const std::vector<std::string> &uids, const std::vector<Flow> &flatFlows, std::string &error)
+{
+    std::vector<size_t> reps(uids.size(), 0);
+    reps.front() = 1;
+    for (size_t i = 0; i+1 < uids.size(); i++)
+    {
+        for (const auto &flow : flatFlows)
+        {
+            if (flow.src.uid != uids[i] or flow.dst.uid != uids[i+1]) continue;
+            const auto produced = flow.src.obj.call("output", flow.src.name).call<size_t>("staticRate");
+            const auto consumed = flow.dst.obj.call("input", flow.dst.name).call<size_t>("staticRate");
+            if (produced == 0 or consumed == 0) return std::vector<size_t>();
+
+            //the first connection to the next block sets its repetitions
+            if (reps[i+1] == 0)
+            {
+                const size_t g = gcdOf(reps[i]*produced, consumed);
+                for (size_t j = 0; j <= i; j++) reps[j] *= consumed/g;
+                reps[i+1] = reps[i]*produced/consumed;
+            }
+
+            //reduce to the smallest solution and check the bound
+            size_t g = 0;
+            for (size_t j = 0; j <= i+1; j++) g = gcdOf(g, reps[j]);
+            for (size_t j = 0; j <= i+1; j++) reps[j] /= g;
+            if (*std::max_element(reps.begin(), reps.end()) > MaxStaticRepetitions)
+            {
+                error = flow.toString() + " needs more than " + std::to_string(MaxStaticRepetitions) + " repetitions";
+                return std::vector<size_t>();
+            }
+
+            //other connections between the same neighbors must balance
+            if (reps[i]*produced != reps[i+1]*consumed)
+            {
+                error = flow.toString() + " has inconsistent static rates";
+                return std::vector<size_t>();
+            }
+        }
+    }
+    return reps;
+}
+
+/***********************************************************************
+ * A group of blocks fused into one task of their thread pool
+ **********************************************************************/
+struct FusedBlockGroup
+{
+    FusedBlockGroup(const std::vector<Pothos::Proxy> &proxies, const std::vector<Flow> &flatFlows)
+    {
+        for (const auto &proxy : proxies) blocks.push_back(proxy.call<Pothos::Block *>("getPointer"));
+        threadPool = blocks.front()->getThreadPool();
+
+        //fixed rate connections throughout the chain run a static schedule
+        std::vector<std::string> uids;
+        for (const auto &proxy : proxies) uids.push_back(proxy.call<std::string>("uid"));
+        std::string error;
+        repetitions = staticRepetitions(uids, flatFlows, error);
+
+        //limit the buffers on the connections inside of the group,
+        //a static schedule preallocates a buffer per repetition of the producer
+        for (const auto &flow : flatFlows)
+        {
+            const auto srcIt = std::find(uids.begin(), uids.end(), flow.src.uid);
+            if (srcIt == uids.end() or std::find(uids.begin(), uids.end(), flow.dst.uid) == uids.end()) continue;
+            if (std::find(hintedPorts.begin(), hintedPorts.end(), flow.src) != hintedPorts.end()) continue;
+            size_t numBuffers = FusedNumBuffers;
+            if (not repetitions.empty()) numBuffers = std::max(numBuffers, repetitions[srcIt-uids.begin()]+1);
+            flow.src.obj.get("_actor").call("setOutputBufferCountHint", flow.src.name, numBuffers);
+            hintedPorts.push_back(flow.src);
+        }
+
+        std::vector<void *> handles(blocks.begin(), blocks.end());
+        this->environment()->fuseTasks(this, handles, repetitions);
+    }
+
+    ~FusedBlockGroup(void)
+    {
+        this->environment()->unfuseTasks(this);
+        for (const auto &port : hintedPorts)
+        {
+            POTHOS_EXCEPTION_TRY
+            {
+                port.obj.get("_actor").call("setOutputBufferCountHint", port.name, size_t(0));
+            }
+            POTHOS_EXCEPTION_CATCH(const Pothos::Exception &ex)
+            {
+                poco_error_f2(Poco::Logger::get("Pothos.Topology.fusion"), "%s: %s", port.toString(), ex.displayText());
+            }
+        }
+    }
+
+    ThreadEnvironment *environment(void) const
+    {
+        return std::static_pointer_cast<ThreadEnvironment>(threadPool.getContainer()).get();
+    }
+
+    std::vector<Pothos::Block *> blocks;
+    Pothos::ThreadPool threadPool;
+    std::vector<Port> hintedPorts;
+    std::vector<size_t> repetitions;
+};
+
+/***********************************************************************
+ * Fused group configuration
+ **********************************************************************/
+void Pothos::Topology::setFusedGroup(const std::string &name, const std::vector<Object> &blocks)
+{
+    if (blocks.empty())
+    {
+        _impl->fusedGroups.erase(name);
+        return;
+    }
+
+    std::vector<Pothos::Proxy> proxies;
+    std::set<std::string> uids;
+    for (const auto &block : blocks)
+    {
+        proxies.push_back(getConnectable(block));
+        uids.insert(proxies.back().call<std::string>("uid"));
+    }
+    if (proxies.size() < 2) throw Pothos::InvalidArgumentException(
+        "Pothos::Topology::setFusedGroup("+name+")", "a fused group needs at least 2 blocks");
+    if (uids.size() != proxies.size()) throw Pothos::InvalidArgumentException(
+        "Pothos::Topology::setFusedGroup("+name+")", "a block is repeated in the group");
+    _impl->fusedGroups[name] = proxies;
+}
+
+std::vector<std::string> Pothos::Topology::getFusedGroups(void) const
+{
+    std::vector<std::string> names;
+    for (const auto &pair : _impl->fusedGroups) names.push_back(pair.first);
+    return names;
+}
+
+/***********************************************************************
+ * Check the fused groups against the flat flows before the commit
+ **********************************************************************/
+std::map<std::string, std::vector<Pothos::Proxy>> Pothos::Topology::Impl::checkFusedGroups(const std::vector<Flow> &flatFlows)
+{
+    std::map<std::string, std::vector<Pothos::Proxy>> activeGroups;
+    std::set<std::string> flowUids, fusedUids;
+    for (const auto &flow : flatFlows)
+    {
+        flowUids.insert(flow.src.uid);
+        flowUids.insert(flow.dst.uid);
+    }
+
+    for (const auto &pair : this->fusedGroups)
+    {
+        const auto &proxies = pair.second;
+        auto fail = [&pair](const std::string &why)
+        {
+            throw Pothos::TopologyConnectError("Pothos::Topology::commit()",
+                Poco::format("fused group %s: %s", pair.first, why));
+        };
+
+        //the group takes effect once all of the blocks are in the flows
+        std::vector<std::string> uids;
+        for (const auto &proxy : proxies) uids.push_back(proxy.call<std::string>("uid"));
+        const bool allInFlows = std::all_of(uids.begin(), uids.end(),
+            [&flowUids](const std::string &uid){return flowUids.count(uid) != 0;});
+        if (not allInFlows) continue;
+
+        //the blocks must be local and fused into a single group
+        for (size_t i = 0; i < proxies.size(); i++)
+        {
+            if (proxies[i].getEnvironment()->getUniquePid() != Pothos::ProxyEnvironment::getLocalUniquePid())
+                fail(proxies[i].call<std::string>("getName") + " is not in this process");
+            if (not fusedUids.insert(uids[i]).second)
+                fail(proxies[i].call<std::string>("getName") + " is in another fused group");
+        }
+
+        //the blocks must form a chain which only connects to the neighbors
+        std::vector<bool> linked(proxies.size(), false);
+        for (const auto &flow : flatFlows)
+        {
+            const auto srcIt = std::find(uids.begin(), uids.end(), flow.src.uid);
+            const auto dstIt = std::find(uids.begin(), uids.end(), flow.dst.uid);
+            if (srcIt == uids.end() and dstIt == uids.end()) continue;
+            if (srcIt != uids.end() and dstIt == srcIt+1)
+            {
+                linked[srcIt-uids.begin()] = true;
+                continue;
+            }
+            if (srcIt != uids.end() and srcIt+1 != uids.end()) fail(flow.toString() + " leaves the chain");
+            if (dstIt != uids.end() and dstIt != uids.begin()) fail(flow.toString() + " enters the chain");
+        }
+        for (size_t i = 0; i+1 < proxies.size(); i++)
+        {
+            if (not linked[i]) fail(proxies[i].call<std::string>("getName") + " is not connected to the next block");
+        }
+
+        //declared static rates must balance
+        std::string error;
+        staticRepetitions(uids, flatFlows, error);
+        if (not error.empty()) fail(error);
+
+        //the blocks must share one thread pool
+        const auto threadPool = this->threadPool?this->threadPool:proxies.front().call<Pothos::Block *>("getPointer")->getThreadPool();
+        if (not threadPool) fail("the blocks have no thread pool");
+        for (const auto &proxy : proxies)
+        {
+            if (not this->threadPool and not (proxy.call<Pothos::Block *>("getPointer")->getThreadPool() == threadPool))
+                fail(proxy.call<std::string>("getName") + " uses another thread pool");
+        }
+
+        activeGroups[pair.first] = proxies;
+    }
+    return activeGroups;
+}
+
+/***********************************************************************
+ * Fuse the active groups after the thread pools are set
+ **********************************************************************/
+void Pothos::Topology::Impl::applyFusedGroups(const std::map<std::string, std::vector<Pothos::Proxy>> &activeGroups, const std::vector<Flow> &flatFlows)
+{
+    //unfuse groups that are removed or changed
+    for (auto it = this->activeFusedGroups.begin(); it != this->activeFusedGroups.end();)
+    {
+        const auto groupIt = activeGroups.find(it->first);
+        bool same = groupIt != activeGroups.end() and groupIt->second.size() == it->second->blocks.size();
+        for (size_t i = 0; same and i < groupIt->second.size(); i++)
+        {
+            same = groupIt->second[i].call<Pothos::Block *>("getPointer") == it->second->blocks[i];
+        }
+        for (size_t i = 0; same and i < it->second->blocks.size(); i++)
+        {
+            same = it->second->blocks[i]->getThreadPool() == it->second->threadPool;
+        }
+        if (same) ++it;
+        else it = this->activeFusedGroups.erase(it);
+    }
+
+    //fuse the new groups
+    for (const auto &pair : activeGroups)
+    {
+        if (this->activeFusedGroups.count(pair.first) != 0) continue;
+        this->activeFusedGroups[pair.first].reset(new FusedBlockGroup(pair.second, flatFlows));
+    }
+}
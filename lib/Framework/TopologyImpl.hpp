@@ -1,11 +1,16 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #pragma once
 #include <Pothos/Framework/Topology.hpp>
+#include <Pothos/Framework/Block.hpp>
 #include "Framework/PortsAndFlows.hpp"
+#include "Framework/ActivityNotifier.hpp"
 #include <unordered_map>
+#include <atomic>
+#include <future>
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -20,20 +25,141 @@ static inline Port envTagPort(const Port &port, const Port &other)
     return envTagged;
 }
 
+struct StatsExporter;
+struct MetricsServer;
+struct FusedBlockGroup;
+struct JSONTopologyState;
+struct StatsDeltaState;
+
+//! The credit window of a network flow (see Topology::setNetworkFlowArgs())
+struct FlowCredits
+{
+    FlowCredits(void): bytes(0), buffers(16), adaptive(false), dropOldest(false){}
+    size_t bytes; //!< the most bytes in flight (0 disables credits)
+    size_t buffers; //!< the most buffers in flight
+    bool adaptive; //!< size the window from the round trip time and throughput
+    bool dropOldest; //!< drop the oldest data when the window is full
+};
+
+/*!
+ * Parsed policy for network flows (see Topology::setNetworkFlowArgs()).
+ * The constructor throws std::exception for malformed arguments.
+ */
+struct NetworkFlowArgs
+{
+    NetworkFlowArgs(const std::string &args = "");
+    size_t coalesceBytes;
+    double coalesceLatency;
+
+    //! The transport schemes in order of preference, tcp is always last
+    std::vector<std::string> transports;
+
+    //! Per flow transports by the source name "blockName[portName]"
+    std::map<std::string, std::vector<std::string>> flowTransports;
+
+    //! Relay fan-out to remote processes through a tree of this degree (0 for direct)
+    size_t relayFanout;
+
+    //! Carry the labels and messages on a second network flow
+    bool labelChannel;
+
+    //! The payload codec of every network flow: "none" or "auto"
+    std::string codec;
+
+    //! Per flow payload codecs by the source name "blockName[portName]"
+    std::map<std::string, std::string> flowCodecs;
+
+    //! The credit window of every network flow
+    FlowCredits credits;
+
+    //! Per flow credit windows by the source name "blockName[portName]"
+    std::map<std::string, FlowCredits> flowCredits;
+
+    //! Get the transports for the flow of the named source
+    const std::vector<std::string> &getTransports(const std::string &srcName) const;
+
+    //! Get the credit window for the flow of the named source
+    const FlowCredits &getCredits(const std::string &srcName) const;
+
+    //! Get the payload codec for the flow of the named source
+    const std::string &getCodec(const std::string &srcName) const;
+};
+
+/*!
+ * The blocks that carry a flow from a source port to another process.
+ * The optional coalescer is between the source port and the sink.
+ * The optional label channel splits the labels and messages from the payload
+ * ahead of the sink, and merges them back after the source.
+ * The optional credit gate ahead of the sink takes back the credits
+ * from the credit return after the source, on a reverse pair of network blocks.
+ * The optional encoder packs the payload right ahead of the sink,
+ * and the decoder restores it right after the source.
+ */
+struct NetgressBlocks
+{
+    Pothos::Proxy source;
+    Pothos::Proxy sink;
+    Pothos::Proxy coalescer;
+    Pothos::Proxy encoder;
+    Pothos::Proxy decoder;
+    Pothos::Proxy splitter;
+    Pothos::Proxy merger;
+    Pothos::Proxy labelSource;
+    Pothos::Proxy labelSink;
+    Pothos::Proxy creditGate;
+    Pothos::Proxy creditReturn;
+    Pothos::Proxy creditSource;
+    Pothos::Proxy creditSink;
+};
+
+typedef std::unordered_map<Port, NetgressBlocks> NetgressCache;
+
 /***********************************************************************
  * implementation guts
  **********************************************************************/
 struct Pothos::Topology::Impl
 {
-    Impl(Topology *self): self(self){}
+    Impl(Topology *self): self(self), traceEnabled(false), traceConfigured(false), memoryBudget(0), memoryBudgetConfigured(false), batchBufferSize(0), batchConfigured(false), activityNotifier(std::make_shared<ActivityNotifier>()),
+        flowsRevision(0), squashCacheValid(false), squashCacheRevision(0){}
     Topology *self;
     ThreadPool threadPool;
+    std::string statsLevel;
+    bool traceEnabled;
+    bool traceConfigured;
+    size_t memoryBudget;
+    bool memoryBudgetConfigured;
+    size_t batchBufferSize;
+    bool batchConfigured;
+    std::string networkFlowArgs;
+
+    //fused groups by name and the groups fused by the last commit
+    std::map<std::string, std::vector<Pothos::Proxy>> fusedGroups;
+    std::map<std::string, std::shared_ptr<FusedBlockGroup>> activeFusedGroups;
+    std::map<std::string, std::vector<Pothos::Proxy>> checkFusedGroups(const std::vector<Flow> &);
+    void applyFusedGroups(const std::map<std::string, std::vector<Pothos::Proxy>> &, const std::vector<Flow> &);
+
+    //! signaled by the blocks activated by this topology's sub-commit
+    std::shared_ptr<ActivityNotifier> activityNotifier;
+
+    //! commits run one at a time, the last async commit is waited on upon destruction
+    std::mutex commitMutex;
+    std::shared_future<void> asyncCommit;
     std::vector<Flow> flows;
     std::vector<Flow> activeFlatFlows;
-    std::unordered_map<Port, std::pair<Pothos::Proxy, Pothos::Proxy>> srcToNetgressCache;
-    std::vector<Flow> squashFlows(const std::vector<Flow> &);
+    NetgressCache srcToNetgressCache;
+    std::vector<Port> netgressKeys; //cache keys used by the last createNetworkFlows()
+    std::vector<Flow> squashFlows(const std::vector<Flow> &, std::vector<Pothos::Proxy> &);
     std::vector<Flow> createNetworkFlows(const std::vector<Flow> &);
     std::vector<Flow> rectifyDomainFlows(const std::vector<Flow> &);
+
+    /*!
+     * The domain crossing plan of the last commit (see TopologyDomainFlows.cpp).
+     * The port domains and the copier of each flow are cached per main port
+     * under a key of the port and its connected sub ports, so the commits
+     * only query the environments about the crossings that changed.
+     */
+    std::unordered_map<std::string, std::string> portDomainCache;
+    std::unordered_map<std::string, std::unordered_map<Port, Pothos::Proxy>> crossingPlanCache;
     std::vector<std::string> inputPortNames;
     std::vector<std::string> outputPortNames;
     std::map<std::string, PortInfo> inputPortInfo;
@@ -43,6 +169,44 @@ struct Pothos::Topology::Impl
     //! remote topology per unique environment
     std::map<std::string, Pothos::Proxy> remoteTopologies;
 
+    //! flat flows currently loaded into the remote topologies
+    std::vector<Flow> subTopologyFlows;
+
+    //! background stats exporter (see TopologyStatsExport.cpp)
+    std::shared_ptr<StatsExporter> statsExporter;
+
+    //! OpenMetrics HTTP server (see TopologyStatsExport.cpp)
+    std::shared_ptr<MetricsServer> metricsServer;
+
+    //! state of a topology made from JSON (see TopologyMakeJSON.cpp)
+    std::shared_ptr<JSONTopologyState> jsonState;
+
+    //! hierarchical block names by UID, cached at commit (see TopologyDumpJSON.cpp)
+    std::mutex blockNamesMutex;
+    std::map<std::string, std::string> blockNames;
+    std::map<std::string, std::string> cacheBlockNames(void);
+
+    //! delta streams of the stats to callers and from remote topologies (see TopologyStatsJSON.cpp)
+    std::mutex statsDeltaMutex;
+    std::shared_ptr<StatsDeltaState> statsDelta;
+
+    /*!
+     * Cache of the squashed flows and resolved ports (see TopologySquashFlows.cpp).
+     * The flows revision counts the connect and disconnect calls on this topology.
+     * The cache is current while the revisions of this topology
+     * and of the sub-topologies found by the squash are unchanged.
+     */
+    std::atomic<unsigned long long> flowsRevision;
+    std::mutex squashMutex;
+    bool squashCacheValid;
+    unsigned long long squashCacheRevision;
+    std::vector<Flow> squashCacheFlows;
+    std::vector<Pothos::Proxy> squashCacheSubTopologies;
+    std::map<std::pair<std::string, bool>, std::vector<Port>> squashCachePorts;
+    unsigned long long flowsRevisionNoLock(void);
+    bool squashCacheCurrentNoLock(void);
+    std::vector<Flow> squashFlowsCached(void);
+
     //! special utility function to make a port with knowledge of this topology
     Port makePort(const Pothos::Object &obj, const std::string &name) const;
     Port makePort(const Pothos::Proxy &obj, const std::string &name) const;
@@ -70,6 +234,64 @@ inline std::vector<Pothos::Proxy> getObjSetFromFlowList(const std::vector<Flow>
     return set;
 }
 
+/***********************************************************************
+ * Direct access to the objects of this process:
+ * Proxy calls convert every argument to and from Object,
+ * and look up the call by name in the managed class registry.
+ * The topology internals use the objects directly when they are local,
+ * and fall back to the proxy calls for objects in other processes.
+ **********************************************************************/
+inline bool isLocalProxy(const Pothos::Proxy &proxy)
+{
+    if (not proxy) return false;
+    const auto env = proxy.getEnvironment();
+    return env->getName() == "managed" and env->getUniquePid() == Pothos::ProxyEnvironment::getLocalUniquePid();
+}
+
+//! Get the block of a proxy in this process, or null
+inline Pothos::Block *getLocalBlock(const Pothos::Proxy &proxy)
+{
+    if (not isLocalProxy(proxy)) return nullptr;
+    const auto obj = proxy.toObject();
+    if (obj.type() == typeid(std::shared_ptr<Pothos::Block>)) return obj.extract<std::shared_ptr<Pothos::Block>>().get();
+    if (obj.type() == typeid(Pothos::Block *)) return obj.extract<Pothos::Block *>();
+    return nullptr;
+}
+
+//! Get the worker actor of a block proxy in this process, or null
+inline Pothos::WorkerActor *getLocalActor(const Pothos::Proxy &proxy)
+{
+    auto block = getLocalBlock(proxy);
+    return (block == nullptr)?nullptr:block->_actor.get();
+}
+
+//! Get the topology of a proxy in this process, or null
+inline Pothos::Topology *getLocalTopology(const Pothos::Proxy &proxy)
+{
+    if (not isLocalProxy(proxy)) return nullptr;
+    const auto obj = proxy.toObject();
+    if (obj.type() == typeid(std::shared_ptr<Pothos::Topology>)) return obj.extract<std::shared_ptr<Pothos::Topology>>().get();
+    if (obj.type() == typeid(Pothos::Topology *)) return obj.extract<Pothos::Topology *>();
+    return nullptr;
+}
+
+//! Get the block or topology of a proxy in this process, or null
+inline Pothos::Connectable *getLocalConnectable(const Pothos::Proxy &proxy)
+{
+    auto block = getLocalBlock(proxy);
+    if (block != nullptr) return block;
+    return getLocalTopology(proxy);
+}
+
+//! Resolve the block ports behind a port of the topology (typed, no proxy calls)
+std::vector<Port> resolvePortsFromTopology(const Pothos::Topology &t, const std::string &portName, const bool isSource);
+
+//! Resolve the flattened flows within the topology (typed, no proxy calls)
+std::vector<Flow> resolveFlowsFromTopology(const Pothos::Topology &t);
+
+//! Query the revision of the flows within the topology and its sub-topologies
+unsigned long long queryFlowsRevision(const Pothos::Topology &t);
+
 /***********************************************************************
  * Make a proxy if not already
  **********************************************************************/
@@ -85,6 +307,7 @@ inline Pothos::Proxy getProxy(const Pothos::Object &o)
 inline Pothos::Proxy getInternalBlock(const Pothos::Proxy &block)
 {
     if (not block) return block;
+    if (getLocalConnectable(block) != nullptr) return block;
     Pothos::Proxy internal;
     try
     {
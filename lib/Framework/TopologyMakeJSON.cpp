@@ -1,11 +1,19 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
-#include <Pothos/Framework/TopologyImpl.hpp>
+#include "Framework/TopologyImpl.hpp"
+#include "Framework/TopologyEncoding.hpp"
+#include "Framework/PlacementPlanner.hpp"
 #include <Pothos/Util/EvalEnvironment.hpp>
+#include <Pothos/System/HostInfo.hpp>
+#include <Pothos/Remote.hpp>
 #include <Pothos/Proxy.hpp>
 #include <Poco/Format.h>
+#include <algorithm> //find_if, min/max
+#include <atomic>
+#include <thread>
 #include <map>
+#include <set>
 #include <json.hpp>
 
 using json = nlohmann::json;
@@ -48,6 +56,17 @@ static std::vector<Pothos::Proxy> evalArgsArray(
     return Pothos::Object(args);
 }
 
+//! Convert the evaluated arguments for a call into another environment
+static std::vector<Pothos::Proxy> argsToEnvironment(
+    const std::vector<Pothos::Proxy> &args,
+    const Pothos::ProxyEnvironment::Sptr &env)
+{
+    if (args.empty() or args.front().getEnvironment() == env) return args;
+    std::vector<Pothos::Proxy> converted;
+    for (const auto &arg : args) converted.push_back(env->convertObjectToProxy(arg.toObject()));
+    return converted;
+}
+
 typedef std::vector<std::pair<std::string, json>> OrderedVarMap;
 
 static OrderedVarMap extractVariableMap(const json &obj, const std::string &key, const std::string &what)
@@ -82,13 +101,113 @@ static OrderedVarMap extractVariableMap(const json &obj, const std::string &key,
     return result;
 }
 
+/***********************************************************************
+ * dependency tracking for incremental updates
+ **********************************************************************/
+//! variable name to the names of the globals that it depends upon
+typedef std::map<std::string, std::set<std::string>> VarDepsMap;
+
+//! the globals that an argument depends upon through the registered variables
+static std::set<std::string> getGlobalDeps(
+    const Pothos::Util::EvalEnvironment &evaluator,
+    const VarDepsMap &varDeps,
+    const json &arg)
+{
+    std::set<std::string> deps;
+    const auto expr = arg.is_string()?arg.get<std::string>():arg.dump();
+    for (const auto &name : evaluator.getReferencedConstants(expr))
+    {
+        auto it = varDeps.find(name);
+        if (it != varDeps.end()) deps.insert(it->second.begin(), it->second.end());
+    }
+    return deps;
+}
+
+//! the globals that an array of arguments depends upon
+static std::set<std::string> getGlobalDeps(
+    const Pothos::Util::EvalEnvironment &evaluator,
+    const VarDepsMap &varDeps,
+    const json &argsArray,
+    const size_t offset)
+{
+    std::set<std::string> deps;
+    for (size_t i = offset; i < argsArray.size(); i++)
+    {
+        const auto deps_i = getGlobalDeps(evaluator, varDeps, argsArray.at(i));
+        deps.insert(deps_i.begin(), deps_i.end());
+    }
+    return deps;
+}
+
+/*!
+ * Load the evaluator with the globals followed by the locals,
+ * and record the globals that each of the variables depends upon.
+ */
+static void loadVariables(
+    Pothos::Util::EvalEnvironment &evaluator,
+    const OrderedVarMap &globals,
+    const OrderedVarMap &locals,
+    VarDepsMap &varDeps)
+{
+    for (size_t i = 0; i < globals.size() + locals.size(); i++)
+    {
+        const bool isGlobal = i < globals.size();
+        const auto &pair = isGlobal?globals[i]:locals[i-globals.size()];
+        auto deps = getGlobalDeps(evaluator, varDeps, pair.second);
+        if (isGlobal) deps.insert(pair.first);
+        const auto result = evalExpression(evaluator, pair.second);
+        evaluator.registerConstantObj(pair.first, result);
+        varDeps[pair.first] = deps;
+    }
+}
+
+/*!
+ * The state of a topology made from JSON that is kept for updates.
+ */
+struct JSONBlockState
+{
+    std::string id;
+    Pothos::Proxy block;
+    json blockObj;
+    std::set<std::string> ctorDeps; //!< globals of the constructor arguments
+    std::vector<std::set<std::string>> callDeps; //!< globals of each call
+};
+
+struct JSONTopologyState
+{
+    OrderedVarMap globals;
+    std::vector<JSONBlockState> blocks;
+    std::vector<std::shared_ptr<Pothos::RemoteClient>> clients; //!< connections to the hosts
+};
+
 /***********************************************************************
  * block factory - make blocks from JSON object
  **********************************************************************/
+static void makeBlockCall(
+    const Pothos::Proxy &block,
+    const std::string &id,
+    Pothos::Util::EvalEnvironment &evaluator,
+    const json &callArray)
+{
+    auto name = callArray[0].get<std::string>();
+    const auto callArgs = argsToEnvironment(evalArgsArray(evaluator, callArray, 1/*offset*/), block.getEnvironment());
+    try
+    {
+        block.getHandle()->call(name, callArgs.data(), callArgs.size());
+    }
+    catch (const Pothos::Exception &ex)
+    {
+        std::string argsStr;
+        for (const auto &arg : callArgs) argsStr += arg.toString() + (argsStr.empty()?"":", ");
+        throw Pothos::RuntimeException(Poco::format("%s.%s(%s)", id, name, argsStr), ex);
+    }
+}
+
 static Pothos::Proxy makeBlock(
     const Pothos::Proxy &registry,
     const OrderedVarMap &globals,
-    const json &blockObj)
+    const json &blockObj,
+    JSONBlockState &state)
 {
     const std::string id = blockObj["id"];
 
@@ -97,22 +216,17 @@ static Pothos::Proxy makeBlock(
     const std::string path = blockObj["path"];
 
     //parse the local variables
-    auto locals = extractVariableMap(blockObj, "locals", id+".locals");
+    const auto locals = extractVariableMap(blockObj, "locals", id+".locals");
 
-    //prepend globals into the local variable space
-    locals.insert(locals.begin(), globals.begin(), globals.end());
-
-    //load the evaluator with variables
+    //load the evaluator with the globals and then the locals
     Pothos::Util::EvalEnvironment evaluator;
-    for (const auto &pair : locals)
-    {
-        const auto result = evalExpression(evaluator, pair.second);
-        evaluator.registerConstantObj(pair.first, result);
-    }
+    VarDepsMap varDeps;
+    loadVariables(evaluator, globals, locals, varDeps);
 
     //load up the constructor args
     const auto &argsArray = blockObj.value("args", json::array());
-    const auto ctorArgs = evalArgsArray(evaluator, argsArray);
+    const auto ctorArgs = argsToEnvironment(evalArgsArray(evaluator, argsArray), registry.getEnvironment());
+    state.ctorDeps = getGlobalDeps(evaluator, varDeps, argsArray, 0);
 
     //create the block
     Pothos::Proxy block;
@@ -134,21 +248,186 @@ static Pothos::Proxy makeBlock(
     const auto &callsArray = blockObj.value("calls", json::array());
     for (const auto &callArray : callsArray)
     {
-        auto name = callArray[0].get<std::string>();
-        const auto callArgs = evalArgsArray(evaluator, callArray, 1/*offset*/);
-        try
+        makeBlockCall(block, id, evaluator, callArray);
+        state.callDeps.push_back(getGlobalDeps(evaluator, varDeps, callArray, 1/*offset*/));
+    }
+
+    state.id = id;
+    state.block = block;
+    state.blockObj = blockObj;
+    return block;
+}
+
+/***********************************************************************
+ * update a global variable - re-evaluate the dependent calls
+ **********************************************************************/
+void Pothos::Topology::setGlobalVariable(const std::string &name, const std::string &value)
+{
+    const auto state = _impl->jsonState;
+    if (not state) throw Pothos::InvalidArgumentException(
+        "Pothos::Topology::setGlobalVariable("+name+")", "topology was not made from JSON");
+
+    auto globals = state->globals;
+    auto it = std::find_if(globals.begin(), globals.end(),
+        [&name](const std::pair<std::string, json> &pair){return pair.first == name;});
+    if (it == globals.end()) throw Pothos::InvalidArgumentException(
+        "Pothos::Topology::setGlobalVariable("+name+")", "unknown global variable");
+    it->second = value;
+
+    //changing the constructor arguments would require new blocks
+    std::string ctorDependents;
+    for (const auto &blockState : state->blocks)
+    {
+        if (blockState.ctorDeps.count(name) == 0) continue;
+        ctorDependents += (ctorDependents.empty()?"":", ") + blockState.id;
+    }
+    if (not ctorDependents.empty()) throw Pothos::RuntimeException(
+        "Pothos::Topology::setGlobalVariable("+name+")",
+        "constructor arguments depend on this global: " + ctorDependents);
+    state->globals = globals;
+
+    //evaluate only the dependent calls and make them on the existing blocks
+    for (const auto &blockState : state->blocks)
+    {
+        const auto &callsArray = blockState.blockObj.value("calls", json::array());
+        std::vector<size_t> dependentCalls;
+        for (size_t i = 0; i < blockState.callDeps.size(); i++)
+        {
+            if (blockState.callDeps[i].count(name) != 0) dependentCalls.push_back(i);
+        }
+        if (dependentCalls.empty()) continue;
+
+        Pothos::Util::EvalEnvironment evaluator;
+        VarDepsMap varDeps;
+        const auto locals = extractVariableMap(blockState.blockObj, "locals", blockState.id+".locals");
+        loadVariables(evaluator, globals, locals, varDeps);
+        for (const auto i : dependentCalls)
         {
-            block.getHandle()->call(name, callArgs.data(), callArgs.size());
+            makeBlockCall(blockState.block, blockState.id, evaluator, callsArray.at(i));
         }
-        catch (const Pothos::Exception &ex)
+    }
+}
+
+/***********************************************************************
+ * placement of the blocks across hosts
+ **********************************************************************/
+struct JSONHost
+{
+    std::string name;
+    Pothos::ProxyEnvironment::Sptr env;
+    double capacity;
+};
+
+//! Connect to the hosts, an empty uri is the local process
+static std::vector<JSONHost> makeHosts(const json &hostsArray, const Pothos::ProxyEnvironment::Sptr &localEnv, JSONTopologyState &state)
+{
+    std::vector<JSONHost> hosts;
+    for (size_t i = 0; i < hostsArray.size(); i++)
+    {
+        const auto &hostObj = hostsArray.at(i);
+        const auto what = "hosts["+std::to_string(i)+"]";
+        if (not hostObj.is_object() or hostObj.count("name") == 0) throw Pothos::DataFormatException(
+            "Pothos::Topology::make()", what+" must be an object with a 'name' field");
+        JSONHost host;
+        host.name = hostObj["name"].get<std::string>();
+        const auto uri = hostObj.value<std::string>("uri", "");
+        if (uri.empty()) host.env = localEnv;
+        else
         {
-            std::string argsStr;
-            for (const auto &arg : callArgs) argsStr += arg.toString() + (argsStr.empty()?"":", ");
-            throw Pothos::RuntimeException(Poco::format("%s.%s(%s)", id, name, argsStr), ex);
+            std::shared_ptr<Pothos::RemoteClient> client(new Pothos::RemoteClient(uri));
+            host.env = client->makeEnvironment("managed");
+            state.clients.push_back(client);
         }
+
+        //the capacity defaults to the processor count of the host
+        if (hostObj.count("capacity") != 0) host.capacity = hostObj["capacity"].get<double>();
+        else host.capacity = double(host.env->findProxy("Pothos/System/HostInfo").call("get")
+            .convert<Pothos::System::HostInfo>().processorCount);
+        if (host.capacity <= 0.0) throw Pothos::DataFormatException(
+            "Pothos::Topology::make()", what+" capacity must be positive");
+        hosts.push_back(host);
     }
+    return hosts;
+}
 
-    return block;
+/*!
+ * Plan the host of each block from the optional placement hints:
+ * - "stats" the output of Topology::queryJSONStats() from a previous run,
+ *   the work time estimates the block costs, and the bytes produced
+ *   by each output port estimate the rates of the flows
+ * - "flowRates" the rates by the source "blockId[portName]", these override the stats
+ * - "balanceSlack" the allowed imbalance of the load between hosts (default 0.25)
+ * Blocks with a "host" field are pinned, a block "cost" field overrides the stats.
+ */
+static std::vector<size_t> planBlockHosts(const json &topObj, const json &blockArray, const std::vector<JSONHost> &hosts)
+{
+    const auto &placementObj = topObj.value("placement", json::object());
+    const auto &statsObj = placementObj.value("stats", json::object());
+    const auto &flowRatesObj = placementObj.value("flowRates", json::object());
+
+    //index the stats by the block name (which is the block id)
+    std::map<std::string, json> statsById;
+    for (auto it = statsObj.begin(); it != statsObj.end(); ++it)
+    {
+        if (it.value().is_object() and it.value().count("blockName") != 0)
+        {
+            statsById[it.value()["blockName"].get<std::string>()] = it.value();
+        }
+    }
+
+    PlacementProblem problem;
+    problem.balanceSlack = placementObj.value("balanceSlack", problem.balanceSlack);
+    std::map<std::string, size_t> blockIndexes;
+    for (size_t i = 0; i < blockArray.size(); i++)
+    {
+        const auto &blockObj = blockArray.at(i);
+        const auto id = blockObj["id"].get<std::string>();
+        blockIndexes[id] = i;
+
+        //the cost from the block, then the stats, otherwise uniform
+        double cost = 1.0;
+        const auto statsIt = statsById.find(id);
+        if (statsIt != statsById.end()) cost = std::max(1.0, statsIt->second.value("totalTimeWork", 0.0));
+        problem.blockCosts.push_back(blockObj.value("cost", cost));
+
+        long pin = -1;
+        const auto hostName = blockObj.value<std::string>("host", "");
+        for (size_t h = 0; h < hosts.size(); h++)
+        {
+            if (hosts[h].name == hostName) pin = long(h);
+        }
+        if (not hostName.empty() and pin == -1) throw Pothos::DataFormatException(
+            "Pothos::Topology::make()", "blocks["+id+"] unknown host = " + hostName);
+        problem.pinnedHosts.push_back(pin);
+    }
+    for (const auto &host : hosts) problem.hostCapacities.push_back(host.capacity);
+
+    //the rate of each connection between blocks
+    const auto &connArray = topObj.value("connections", json::array());
+    for (const auto &connArgs : connArray)
+    {
+        if (not connArgs.is_array() or connArgs.size() < 4) continue; //reported when connecting
+        if (not connArgs.at(0).is_string() or not connArgs.at(2).is_string()) continue;
+        const auto srcIt = blockIndexes.find(connArgs.at(0).get<std::string>());
+        const auto dstIt = blockIndexes.find(connArgs.at(2).get<std::string>());
+        if (srcIt == blockIndexes.end() or dstIt == blockIndexes.end()) continue;
+        const auto srcPort = connArgs.at(1).is_string()?connArgs.at(1).get<std::string>():connArgs.at(1).dump();
+
+        PlacementProblem::Flow flow;
+        flow.src = srcIt->second;
+        flow.dst = dstIt->second;
+        flow.rate = 1.0;
+        const auto statsIt = statsById.find(srcIt->first);
+        if (statsIt != statsById.end()) for (const auto &portStats : statsIt->second.value("outputStats", json::array()))
+        {
+            if (portStats.value<std::string>("portName", "") != srcPort) continue;
+            flow.rate = std::max(1.0, portStats.value("totalElements", 0.0)*portStats.value("dtypeSize", 1.0));
+        }
+        flow.rate = flowRatesObj.value(srcIt->first+"["+srcPort+"]", flow.rate);
+        problem.flows.push_back(flow);
+    }
+
+    return planPlacement(problem);
 }
 
 /***********************************************************************
@@ -160,7 +439,7 @@ std::shared_ptr<Pothos::Topology> Pothos::Topology::make(const std::string &json
     json topObj;
     try
     {
-        topObj = json::parse(jsonStr);
+        topObj = decodeTopologyJSON(jsonStr);
     }
     catch (const std::exception &ex)
     {
@@ -183,6 +462,8 @@ std::shared_ptr<Pothos::Topology> Pothos::Topology::make(const std::string &json
 
     //parse global variables
     const auto globals = extractVariableMap(topObj, "globals", "globals");
+    std::shared_ptr<JSONTopologyState> state(new JSONTopologyState());
+    state->globals = globals;
 
     //create the topology and add it to the blocks
     //the IDs 'self', 'this', and '' can be used
@@ -192,7 +473,14 @@ std::shared_ptr<Pothos::Topology> Pothos::Topology::make(const std::string &json
     blocks["this"] = env->makeProxy(topology);
     blocks[""] = env->makeProxy(topology);
 
-    //create the blocks
+    //set the optional stats level
+    const auto statsLevel = topObj.value<std::string>("statsLevel", "");
+    if (not statsLevel.empty()) topology->setStatsLevel(statsLevel);
+
+    //set the optional memory budget
+    if (topObj.count("memoryBudget") != 0) topology->setMemoryBudget(topObj["memoryBudget"].get<size_t>());
+
+    //check the block descriptions before making any blocks
     const auto &blockArray = topObj.value("blocks", json::array());
     for (size_t i = 0; i < blockArray.size(); i++)
     {
@@ -201,15 +489,82 @@ std::shared_ptr<Pothos::Topology> Pothos::Topology::make(const std::string &json
             "Pothos::Topology::make()", "blocks["+std::to_string(i)+"] must be an object");
         if (not blockObj.count("id")) throw Pothos::DataFormatException(
             "Pothos::Topology::make()", "blocks["+std::to_string(i)+"] missing 'id' field");
+    }
+
+    //plan the placement of the blocks on the optional hosts
+    std::vector<JSONHost> hosts = makeHosts(topObj.value("hosts", json::array()), env, *state);
+    std::vector<size_t> blockHosts;
+    std::vector<Pothos::Proxy> hostRegistries;
+    if (not hosts.empty())
+    {
+        blockHosts = planBlockHosts(topObj, blockArray, hosts);
+        for (const auto &host : hosts) hostRegistries.push_back(host.env->findProxy("Pothos/BlockRegistry"));
+    }
+
+    //create the blocks in parallel with a bounded number of workers,
+    //the blocks are independent until they are connected below
+    std::vector<Pothos::Proxy> madeBlocks(blockArray.size());
+    std::vector<std::exception_ptr> errors(blockArray.size());
+    state->blocks.resize(blockArray.size());
+    std::atomic<size_t> nextIndex(0);
+    auto worker = [&](void)
+    {
+        for (size_t i = nextIndex++; i < blockArray.size(); i = nextIndex++)
+        {
+            try
+            {
+                const auto &blockRegistry = hosts.empty()?registry:hostRegistries.at(blockHosts.at(i));
+                madeBlocks[i] = makeBlock(blockRegistry, globals, blockArray.at(i), state->blocks[i]);
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    const auto maxThreads = topObj.value<size_t>("makeThreads", 0);
+    const size_t numWorkers = std::min<size_t>(blockArray.size(),
+        (maxThreads != 0)?maxThreads:std::max<size_t>(std::thread::hardware_concurrency(), 1));
+    if (numWorkers <= 1) worker();
+    else
+    {
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < numWorkers; i++) workers.emplace_back(worker);
+        for (auto &thread : workers) thread.join();
+    }
+
+    //report the first failure in the order of the descriptions
+    for (const auto &error : errors)
+    {
+        if (error) std::rethrow_exception(error);
+    }
+
+    std::map<std::pair<Pothos::ProxyEnvironment::Sptr, std::string>, Pothos::Proxy> remoteThreadPools;
+    for (size_t i = 0; i < blockArray.size(); i++)
+    {
+        const auto &blockObj = blockArray.at(i);
         const auto id = blockObj["id"].get<std::string>();
-        blocks[id] = makeBlock(registry, globals, blockObj);
+        blocks[id] = madeBlocks[i];
 
-        //set the thread pool
+        //set the thread pool, blocks on other hosts get a pool of the same name there
         const auto threadPoolName = blockObj.value<std::string>("threadPool", "");
         auto threadPoolIt = threadPools.find(threadPoolName);
-        if (threadPoolIt != threadPools.end()) blocks[id].call("setThreadPool", threadPoolIt->second);
-        else if (not threadPoolName.empty()) throw Pothos::DataFormatException(
+        if (threadPoolIt == threadPools.end() and not threadPoolName.empty()) throw Pothos::DataFormatException(
             "Pothos::Topology::make()", "blocks["+id+"] unknown threadPool = " + threadPoolName);
+        const auto blockEnv = blocks[id].getEnvironment();
+        if (threadPoolIt != threadPools.end() and blockEnv != env)
+        {
+            auto &remotePool = remoteThreadPools[std::make_pair(blockEnv, threadPoolName)];
+            if (not remotePool) remotePool = blockEnv->findProxy("Pothos/ThreadPool")(
+                Pothos::ThreadPoolArgs(threadPoolObj.at(threadPoolName).dump()));
+            blocks[id].call("setThreadPool", remotePool);
+        }
+        else if (threadPoolIt != threadPools.end()) blocks[id].call("setThreadPool", threadPoolIt->second);
+
+        //set the scheduling priority
+        const auto priorityIt = blockObj.find("priority");
+        if (priorityIt != blockObj.end()) blocks[id].call("setSchedulingPriority", priorityIt->get<int>());
     }
 
     //create the topology and connect the blocks
@@ -219,8 +574,8 @@ std::shared_ptr<Pothos::Topology> Pothos::Topology::make(const std::string &json
         const auto &connArgs = connArray.at(i);
         if (not connArgs.is_array()) throw Pothos::DataFormatException(
             "Pothos::Topology::make()", "connections["+std::to_string(i)+"] must be an array");
-        if (connArgs.size() != 4) throw Pothos::DataFormatException(
-            "Pothos::Topology::make()", "connections["+std::to_string(i)+"] must be size 4");
+        if (connArgs.size() != 4 and connArgs.size() != 5) throw Pothos::DataFormatException(
+            "Pothos::Topology::make()", "connections["+std::to_string(i)+"] must be size 4 or 5");
 
         //get string value or dump the value to a string
         auto optStr = [](const json &v) -> std::string
@@ -240,9 +595,33 @@ std::shared_ptr<Pothos::Topology> Pothos::Topology::make(const std::string &json
         if (blocks.count(dstId) == 0) throw Pothos::DataFormatException(
             "Pothos::Topology::make()", "connections["+std::to_string(i)+"] no such ID: " + dstId);
 
-        //make the connection
-        topology->connect(blocks.at(srcId), srcPort, blocks.at(dstId), dstPort);
+        //make the connection with optional buffer arguments
+        if (connArgs.size() == 4) topology->connect(blocks.at(srcId), srcPort, blocks.at(dstId), dstPort);
+        else if (connArgs.at(4).is_object()) topology->connect(blocks.at(srcId), srcPort, blocks.at(dstId), dstPort, connArgs.at(4).dump());
+        else throw Pothos::DataFormatException(
+            "Pothos::Topology::make()", "connections["+std::to_string(i)+"] buffer arguments must be an object");
+    }
+
+    //fuse the optional groups of blocks
+    const auto &fusedGroupsObj = topObj.value("fusedGroups", json::object());
+    if (not fusedGroupsObj.is_object()) throw Pothos::DataFormatException(
+        "Pothos::Topology::make()", "fusedGroups must be an object");
+    for (auto it = fusedGroupsObj.begin(); it != fusedGroupsObj.end(); ++it)
+    {
+        if (not it.value().is_array()) throw Pothos::DataFormatException(
+            "Pothos::Topology::make()", "fusedGroups["+it.key()+"] must be an array");
+        std::vector<Pothos::Object> groupBlocks;
+        for (const auto &idObj : it.value())
+        {
+            const auto id = idObj.get<std::string>();
+            if (blocks.count(id) == 0) throw Pothos::DataFormatException(
+                "Pothos::Topology::make()", "fusedGroups["+it.key()+"] no such ID: " + id);
+            groupBlocks.emplace_back(blocks.at(id));
+        }
+        topology->setFusedGroup(it.key(), groupBlocks);
     }
 
+    //keep the state for updates with setGlobalVariable()
+    topology->_impl->jsonState = state;
     return topology;
 }
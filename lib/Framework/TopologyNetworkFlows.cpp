@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2015 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/TopologyImpl.hpp"
@@ -6,16 +6,172 @@
 #include <Pothos/Remote.hpp>
 #include <Poco/Net/SocketAddress.h>
 #include <Poco/URI.h>
+#include <Poco/Logger.h>
+#include <algorithm> //max
 #include <future>
+#include <json.hpp>
+
+using json = nlohmann::json;
+
+/***********************************************************************
+ * network flow policy arguments
+ **********************************************************************/
+//! Parse a transport string or array of strings, tcp is the last resort
+static std::vector<std::string> parseTransports(const json &value)
+{
+    std::vector<std::string> transports;
+    if (value.is_string()) transports.push_back(value.get<std::string>());
+    else if (value.is_array()) for (const auto &elem : value)
+    {
+        if (not elem.is_string()) throw std::invalid_argument("transport must be a string or an array of strings");
+        transports.push_back(elem.get<std::string>());
+    }
+    else throw std::invalid_argument("transport must be a string or an array of strings");
+    for (const auto &transport : transports)
+    {
+        if (transport.empty()) throw std::invalid_argument("transport must not be empty");
+    }
+    if (transports.empty() or transports.back() != "tcp") transports.push_back("tcp");
+    return transports;
+}
+
+//! Parse a payload codec name
+static std::string parseCodec(const json &value)
+{
+    if (not value.is_string()) throw std::invalid_argument("codec must be a string");
+    const auto codec = value.get<std::string>();
+    if (codec != "none" and codec != "auto") throw std::invalid_argument("codec must be \"none\" or \"auto\"");
+    return codec;
+}
+
+//! Parse a credit window object, the missing fields keep the defaults
+static FlowCredits parseCredits(const json &value, const FlowCredits &defaults)
+{
+    if (not value.is_object()) throw std::invalid_argument("credits must be a JSON object");
+    FlowCredits credits(defaults);
+    const auto bytes = value.value("bytes", double(credits.bytes));
+    const auto buffers = value.value("buffers", double(credits.buffers));
+    if (bytes < 0.0) throw std::invalid_argument("credits bytes must be non-negative");
+    if (buffers < 1.0) throw std::invalid_argument("credits buffers must be at least 1");
+    credits.bytes = size_t(bytes);
+    credits.buffers = size_t(buffers);
+    credits.adaptive = value.value("adaptive", credits.adaptive);
+    credits.dropOldest = value.value("dropOldest", credits.dropOldest);
+    return credits;
+}
+
+NetworkFlowArgs::NetworkFlowArgs(const std::string &args):
+    coalesceBytes(0),
+    coalesceLatency(0.001),
+    transports(1, "tcp"),
+    relayFanout(0),
+    labelChannel(false),
+    codec("none")
+{
+    if (args.empty()) return;
+    const auto topObj = json::parse(args);
+    if (not topObj.is_object()) throw std::invalid_argument("network flow arguments must be a JSON object");
+    const auto bytes = topObj.value("coalesceBytes", 0.0);
+    const auto latency = topObj.value("coalesceLatency", this->coalesceLatency);
+    if (bytes < 0.0) throw std::invalid_argument("coalesceBytes must be non-negative");
+    if (latency < 0.0) throw std::invalid_argument("coalesceLatency must be non-negative");
+    this->coalesceBytes = size_t(bytes);
+    this->coalesceLatency = latency;
+
+    const auto fanout = topObj.value("relayFanout", 0.0);
+    if (fanout < 0.0) throw std::invalid_argument("relayFanout must be non-negative");
+    this->relayFanout = size_t(fanout);
+    this->labelChannel = topObj.value("labelChannel", false);
+
+    if (topObj.count("transport") != 0) this->transports = parseTransports(topObj["transport"]);
+    if (topObj.count("flowTransports") != 0)
+    {
+        const auto &flowsObj = topObj["flowTransports"];
+        if (not flowsObj.is_object()) throw std::invalid_argument("flowTransports must be a JSON object");
+        for (auto it = flowsObj.begin(); it != flowsObj.end(); ++it)
+        {
+            this->flowTransports[it.key()] = parseTransports(it.value());
+        }
+    }
+
+    if (topObj.count("codec") != 0) this->codec = parseCodec(topObj["codec"]);
+    if (topObj.count("flowCodecs") != 0)
+    {
+        const auto &flowsObj = topObj["flowCodecs"];
+        if (not flowsObj.is_object()) throw std::invalid_argument("flowCodecs must be a JSON object");
+        for (auto it = flowsObj.begin(); it != flowsObj.end(); ++it)
+        {
+            this->flowCodecs[it.key()] = parseCodec(it.value());
+        }
+    }
+
+    if (topObj.count("credits") != 0) this->credits = parseCredits(topObj["credits"], this->credits);
+    if (topObj.count("flowCredits") != 0)
+    {
+        const auto &flowsObj = topObj["flowCredits"];
+        if (not flowsObj.is_object()) throw std::invalid_argument("flowCredits must be a JSON object");
+        for (auto it = flowsObj.begin(); it != flowsObj.end(); ++it)
+        {
+            this->flowCredits[it.key()] = parseCredits(it.value(), this->credits);
+        }
+    }
+}
+
+const std::vector<std::string> &NetworkFlowArgs::getTransports(const std::string &srcName) const
+{
+    const auto it = flowTransports.find(srcName);
+    if (it != flowTransports.end()) return it->second;
+    return transports;
+}
+
+const FlowCredits &NetworkFlowArgs::getCredits(const std::string &srcName) const
+{
+    const auto it = flowCredits.find(srcName);
+    if (it != flowCredits.end()) return it->second;
+    return credits;
+}
+
+const std::string &NetworkFlowArgs::getCodec(const std::string &srcName) const
+{
+    const auto it = flowCodecs.find(srcName);
+    if (it != flowCodecs.end()) return it->second;
+    return codec;
+}
+
+/***********************************************************************
+ * helpers to create shared memory iogress flows
+ **********************************************************************/
+static const size_t SHARED_MEMORY_FLOW_BYTES = 1 << 20;
+
+static NetgressBlocks createSharedMemoryFlow(const Flow &flow)
+{
+    //the sink creates the named memory, the source opens it by name
+    auto sinkEnv = flow.src.obj.getEnvironment();
+    auto sourceEnv = flow.dst.obj.getEnvironment();
+    auto shmSink = sinkEnv->findProxy("Pothos/BlockRegistry").call("/blocks/shared_memory_sink", SHARED_MEMORY_FLOW_BYTES);
+    const std::string memName = shmSink.call("getMemoryName");
+    auto shmSource = sourceEnv->findProxy("Pothos/BlockRegistry").call("/blocks/shared_memory_source", memName);
+
+    //return the pair of shared memory blocks
+    const auto name = flow.src.obj.call<std::string>("getName")+"["+flow.src.name+"]";
+    shmSink.call("setName", "ShmTo: "+name);
+    shmSource.call("setName", "ShmFrom: "+name);
+    NetgressBlocks blocks;
+    blocks.source = shmSource;
+    blocks.sink = shmSink;
+    return blocks;
+}
 
 /***********************************************************************
  * helpers to create network iogress flows
  **********************************************************************/
-std::pair<Pothos::Proxy, Pothos::Proxy> createNetworkFlow(const Flow &flow)
+//! Create a bound and connected pair of network blocks from the source to the destination process
+static NetgressBlocks createNetworkPair(const Flow &flow, const NetworkFlowArgs &args, const std::string &name)
 {
     //default behaviour: the sink binds, the source connects
     auto bindEnv = flow.src.obj.getEnvironment();
     auto connEnv = flow.dst.obj.getEnvironment();
+
     Pothos::Proxy netConn, netBind;
     auto netSink = std::ref(netBind);
     auto netSource = std::ref(netConn);
@@ -32,33 +188,163 @@ std::pair<Pothos::Proxy, Pothos::Proxy> createNetworkFlow(const Flow &flow)
         std::swap(netBindPath, netConnPath);
     }
 
-    //create the bind and connect source and sink blocks
+    //create the bind and connect source and sink blocks,
+    //try the transports in order, the network blocks reject unsupported schemes
     auto bindIp = Pothos::RemoteClient::lookupIpFromNodeId(bindEnv->getNodeId());
     assert(not bindIp.empty());
-    Poco::URI uri;
-    uri.setScheme("tcp");
-    uri.setHost(bindIp);
-    netBind = bindEnv->findProxy("Pothos/BlockRegistry").call(netBindPath, uri.toString(), "BIND");
-    const std::string connectPort = netBind.call("getActualPort");
-    uri.setPort(std::stoi(connectPort));
-    netConn = connEnv->findProxy("Pothos/BlockRegistry").call(netConnPath, uri.toString(), "CONNECT");
-
-    //return the pair of network blocks
+    const auto &transports = args.getTransports(name);
+    for (const auto &transport : transports)
+    {
+        POTHOS_EXCEPTION_TRY
+        {
+            Poco::URI uri;
+            uri.setScheme(transport);
+            uri.setHost(bindIp);
+            netBind = bindEnv->findProxy("Pothos/BlockRegistry").call(netBindPath, uri.toString(), "BIND");
+            const std::string connectPort = netBind.call("getActualPort");
+            uri.setPort(std::stoi(connectPort));
+            netConn = connEnv->findProxy("Pothos/BlockRegistry").call(netConnPath, uri.toString(), "CONNECT");
+            break;
+        }
+        POTHOS_EXCEPTION_CATCH(const Pothos::Exception &ex)
+        {
+            if (&transport == &transports.back()) throw;
+            poco_warning_f3(Poco::Logger::get("Pothos.Topology.createNetworkFlow"),
+                "%s transport failed for %s, trying the next transport: %s", transport, name, ex.displayText());
+            netBind = Pothos::Proxy();
+            netConn = Pothos::Proxy();
+        }
+    }
+
+    NetgressBlocks blocks;
+    blocks.source = netSource;
+    blocks.sink = netSink;
+    return blocks;
+}
+
+//! The lossless codec packs 16-bit integer and 32-bit float components
+static bool isCodecDType(const Pothos::DType &dtype)
+{
+    const size_t componentSize = dtype.elemSize()/(dtype.isComplex()?2:1);
+    if (dtype.isInteger() and dtype.isSigned() and componentSize == 2) return true;
+    if (dtype.isFloat() and componentSize == 4) return true;
+    return false;
+}
+
+static NetgressBlocks createNetworkFlow(const Flow &flow, const NetworkFlowArgs &args)
+{
+    //different processes on the same host share memory instead
+    if (flow.src.obj.getEnvironment()->getNodeId() == flow.dst.obj.getEnvironment()->getNodeId()) return createSharedMemoryFlow(flow);
+
+    //create the pair of network blocks
     const auto name = flow.src.obj.call<std::string>("getName")+"["+flow.src.name+"]";
-    netSink.get().call("setName", "NetTo: "+name);
-    netSource.get().call("setName", "NetFrom: "+name);
-    return std::make_pair(netSource, netSink);
+    auto blocks = createNetworkPair(flow, args, name);
+    blocks.sink.call("setName", "NetTo: "+name);
+    blocks.source.call("setName", "NetFrom: "+name);
+
+    //small buffers from the source port are coalesced before the network
+    if (args.coalesceBytes != 0)
+    {
+        blocks.coalescer = flow.src.obj.getEnvironment()->findProxy("Pothos/BlockRegistry").call(
+            "/blocks/buffer_coalescer", args.coalesceBytes, args.coalesceLatency);
+        blocks.coalescer.call("setName", "Coalesce: "+name);
+    }
+
+    //the automatic codec packs the stream types with unused component bits
+    if (args.getCodec(name) == "auto" and isCodecDType(
+        flow.src.obj.call("output", flow.src.name).call<Pothos::DType>("dtype")))
+    {
+        blocks.encoder = flow.src.obj.getEnvironment()->findProxy("Pothos/BlockRegistry").call("/blocks/lossless_encoder");
+        blocks.decoder = flow.dst.obj.getEnvironment()->findProxy("Pothos/BlockRegistry").call("/blocks/lossless_decoder");
+        blocks.encoder.call("setName", "Encode: "+name);
+        blocks.decoder.call("setName", "Decode: "+name);
+    }
+
+    //the labels and messages take a second pair of network blocks
+    if (args.labelChannel)
+    {
+        const auto labelPair = createNetworkPair(flow, args, name);
+        blocks.labelSink = labelPair.sink;
+        blocks.labelSource = labelPair.source;
+        blocks.labelSink.call("setName", "NetLabelsTo: "+name);
+        blocks.labelSource.call("setName", "NetLabelsFrom: "+name);
+        blocks.splitter = flow.src.obj.getEnvironment()->findProxy("Pothos/BlockRegistry").call("/blocks/label_channel_splitter");
+        blocks.merger = flow.dst.obj.getEnvironment()->findProxy("Pothos/BlockRegistry").call("/blocks/label_channel_merger");
+        blocks.splitter.call("setName", "LabelSplit: "+name);
+        blocks.merger.call("setName", "LabelMerge: "+name);
+    }
+
+    //the credits take a pair of network blocks in the reverse direction
+    const auto &credits = args.getCredits(name);
+    if (credits.bytes != 0)
+    {
+        Flow reverse;
+        reverse.src = flow.dst;
+        reverse.dst = flow.src;
+        const auto creditPair = createNetworkPair(reverse, args, name);
+        blocks.creditSink = creditPair.sink;
+        blocks.creditSource = creditPair.source;
+        blocks.creditSink.call("setName", "NetCreditsTo: "+name);
+        blocks.creditSource.call("setName", "NetCreditsFrom: "+name);
+        blocks.creditGate = flow.src.obj.getEnvironment()->findProxy("Pothos/BlockRegistry").call(
+            "/blocks/flow_credit_gate", credits.bytes, credits.buffers, credits.adaptive, credits.dropOldest);
+        blocks.creditReturn = flow.dst.obj.getEnvironment()->findProxy("Pothos/BlockRegistry").call("/blocks/flow_credit_return");
+        blocks.creditGate.call("setName", "CreditGate: "+name);
+        blocks.creditReturn.call("setName", "CreditReturn: "+name);
+    }
+    return blocks;
+}
+
+//! The block in the destination process that produces the restored payload stream
+static const Pothos::Proxy &netgressDecoded(const NetgressBlocks &blocks)
+{
+    return blocks.decoder?blocks.decoder:blocks.source;
+}
+
+//! The block in the destination process that produces the flow before the credit return
+static const Pothos::Proxy &netgressPayload(const NetgressBlocks &blocks)
+{
+    return blocks.merger?blocks.merger:netgressDecoded(blocks);
+}
+
+//! The block in the destination process that produces the flow on port "0"
+static const Pothos::Proxy &netgressOutput(const NetgressBlocks &blocks)
+{
+    return blocks.creditReturn?blocks.creditReturn:netgressPayload(blocks);
 }
 
 /***********************************************************************
  * network crossing implementation
  **********************************************************************/
+struct NetworkHop
+{
+    NetworkHop(void):
+        parent(-1)
+    {
+        return;
+    }
+
+    Flow flow; //the source port or parent relay, and the first destination
+    Port key; //the key of the iogress blocks in the cache
+    std::vector<Flow> dstFlows; //the flows into the destination process
+    long parent; //the hop which relays to this hop, -1 for the source port
+};
+
+//! The number of relays between the source and the hop at this index in the tree
+static size_t relayDepth(const size_t index, const size_t fanout)
+{
+    size_t depth = 0;
+    for (size_t i = index; i != 0; i = (i-1)/fanout) depth++;
+    return depth;
+}
+
 std::vector<Flow> Pothos::Topology::Impl::createNetworkFlows(const std::vector<Flow> &flatFlows)
 {
     std::vector<Flow> networkAwareFlows;
 
-    //locate all of the source endpoints
+    //locate all of the source endpoints, in order of the destination processes
     std::unordered_map<Port, std::vector<Flow>> srcToFlows;
+    std::unordered_map<Port, std::vector<Port>> srcToDstKeys;
     for (const auto &flow : flatFlows)
     {
         //same process, keep this flow as-is
@@ -67,43 +353,139 @@ std::vector<Flow> Pothos::Topology::Impl::createNetworkFlows(const std::vector<F
             networkAwareFlows.push_back(flow);
             continue;
         }
-        srcToFlows[envTagPort(flow.src, flow.dst)].push_back(flow);
+        const auto key = envTagPort(flow.src, flow.dst);
+        auto &flows = srcToFlows[key];
+        if (flows.empty()) srcToDstKeys[flow.src].push_back(key);
+        flows.push_back(flow);
     }
-    //look in the cache or create network iogress for every source endpoint
-    std::unordered_map<Port, std::shared_future<std::pair<Pothos::Proxy, Pothos::Proxy>>> srcToFutures;
-    for (const auto &pair : srcToFlows)
+
+    //plan one hop per destination process of each source endpoint:
+    //direct hops all start at the source port, otherwise the hops form a tree,
+    //where the network source of a parent hop relays the data to its children,
+    //so that the source port only sends the data to the first process once
+    const NetworkFlowArgs args(this->networkFlowArgs);
+    std::vector<std::vector<NetworkHop>> srcHops;
+    size_t maxDepth = 0;
+    for (const auto &pair : srcToDstKeys)
     {
-        assert(not pair.second.empty());
-        if (this->srcToNetgressCache.count(pair.first) != 0) continue;
-        srcToFutures[pair.first] = std::async(std::launch::async, &createNetworkFlow, pair.second.at(0));
+        srcHops.emplace_back();
+        auto &hops = srcHops.back();
+        for (size_t i = 0; i < pair.second.size(); i++)
+        {
+            NetworkHop hop;
+            hop.dstFlows = srcToFlows.at(pair.second[i]);
+            hop.flow = hop.dstFlows.at(0);
+            hop.key = pair.second[i];
+            if (args.relayFanout != 0 and i != 0) hop.parent = long((i-1)/args.relayFanout);
+            if (args.relayFanout != 0) maxDepth = std::max(maxDepth, relayDepth(i, args.relayFanout));
+            hops.push_back(hop);
+        }
     }
 
-    //load all futures into the cache
-    for (const auto &pair : srcToFutures)
+    //look in the cache or create network iogress for every hop,
+    //by depth in the tree, since a relay hop needs the blocks of its parent
+    this->netgressKeys.clear();
+    for (size_t depth = 0; depth <= maxDepth; depth++)
     {
-        this->srcToNetgressCache[pair.first] = pair.second.get();
+        std::unordered_map<Port, std::shared_future<NetgressBlocks>> srcToFutures;
+        for (auto &hops : srcHops)
+        {
+            for (size_t i = 0; i < hops.size(); i++)
+            {
+                auto &hop = hops[i];
+                if (args.relayFanout != 0 and relayDepth(i, args.relayFanout) != depth) continue;
+                if (hop.parent != -1)
+                {
+                    const auto &parentBlocks = this->srcToNetgressCache.at(hops[hop.parent].key);
+                    hop.flow.src = makePort(netgressOutput(parentBlocks), "0");
+                    hop.key = envTagPort(hop.flow.src, hop.flow.dst);
+                }
+                this->netgressKeys.push_back(hop.key);
+                if (this->srcToNetgressCache.count(hop.key) != 0) continue;
+                srcToFutures[hop.key] = std::async(std::launch::async, &createNetworkFlow, hop.flow, args);
+            }
+        }
+
+        //load all futures into the cache
+        for (const auto &pair : srcToFutures)
+        {
+            this->srcToNetgressCache[pair.first] = pair.second.get();
+        }
     }
 
     //append network flows from the cache
-    for (const auto &pair : srcToFlows)
+    for (const auto &hops : srcHops)
     {
-        assert(not pair.second.empty());
-        const auto &netBlocks = this->srcToNetgressCache.at(pair.first);
+        for (const auto &hop : hops)
+        {
+            const auto &netBlocks = this->srcToNetgressCache.at(hop.key);
 
-        //append the source to netSink flow
-        Flow srcFlow;
-        srcFlow.src = pair.second.at(0).src;
-        srcFlow.dst = makePort(netBlocks.second, "0");
-        networkAwareFlows.push_back(srcFlow);
+            //append the source or relay to netSink flow (through the optional splitter and coalescer)
+            Flow srcFlow;
+            srcFlow.src = hop.flow.src;
+            if (netBlocks.splitter)
+            {
+                srcFlow.dst = makePort(netBlocks.splitter, "0");
+                networkAwareFlows.push_back(srcFlow);
+                srcFlow.src = makePort(netBlocks.splitter, "0");
 
-        //append the netSource to dest flows
-        for (const auto &flow : pair.second)
-        {
-            assert(flow.src == srcFlow.src);
-            Flow dstFlow;
-            dstFlow.src = makePort(netBlocks.first, "0");
-            dstFlow.dst = flow.dst;
-            networkAwareFlows.push_back(dstFlow);
+                Flow labelsFlow;
+                labelsFlow.src = makePort(netBlocks.splitter, "labels");
+                labelsFlow.dst = makePort(netBlocks.labelSink, "0");
+                networkAwareFlows.push_back(labelsFlow);
+                labelsFlow.src = makePort(netBlocks.labelSource, "0");
+                labelsFlow.dst = makePort(netBlocks.merger, "labels");
+                networkAwareFlows.push_back(labelsFlow);
+
+                Flow payloadFlow;
+                payloadFlow.src = makePort(netgressDecoded(netBlocks), "0");
+                payloadFlow.dst = makePort(netBlocks.merger, "0");
+                networkAwareFlows.push_back(payloadFlow);
+            }
+            std::vector<Pothos::Proxy> sinkChain;
+            if (netBlocks.coalescer) sinkChain.push_back(netBlocks.coalescer);
+            if (netBlocks.creditGate) sinkChain.push_back(netBlocks.creditGate);
+            if (netBlocks.encoder) sinkChain.push_back(netBlocks.encoder);
+            sinkChain.push_back(netBlocks.sink);
+            for (const auto &block : sinkChain)
+            {
+                srcFlow.dst = makePort(block, "0");
+                networkAwareFlows.push_back(srcFlow);
+                srcFlow.src = makePort(block, "0");
+            }
+
+            //the decoder follows the netSource
+            if (netBlocks.decoder)
+            {
+                Flow decodeFlow;
+                decodeFlow.src = makePort(netBlocks.source, "0");
+                decodeFlow.dst = makePort(netBlocks.decoder, "0");
+                networkAwareFlows.push_back(decodeFlow);
+            }
+
+            //the credit return follows the netSource, and its credits flow back to the gate
+            if (netBlocks.creditReturn)
+            {
+                Flow creditFlow;
+                creditFlow.src = makePort(netgressPayload(netBlocks), "0");
+                creditFlow.dst = makePort(netBlocks.creditReturn, "0");
+                networkAwareFlows.push_back(creditFlow);
+                creditFlow.src = makePort(netBlocks.creditReturn, "credits");
+                creditFlow.dst = makePort(netBlocks.creditSink, "0");
+                networkAwareFlows.push_back(creditFlow);
+                creditFlow.src = makePort(netBlocks.creditSource, "0");
+                creditFlow.dst = makePort(netBlocks.creditGate, "credits");
+                networkAwareFlows.push_back(creditFlow);
+            }
+
+            //append the netSource to dest flows
+            for (const auto &flow : hop.dstFlows)
+            {
+                Flow dstFlow;
+                dstFlow.src = makePort(netgressOutput(netBlocks), "0");
+                dstFlow.dst = flow.dst;
+                networkAwareFlows.push_back(dstFlow);
+            }
         }
     }
 
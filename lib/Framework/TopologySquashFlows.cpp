@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/TopologyImpl.hpp"
@@ -11,8 +11,20 @@ static std::vector<Port> resolvePorts(const Port &port, const bool isSource);
 
 std::vector<Port> resolvePortsFromTopology(const Pothos::Topology &t, const std::string &portName, const bool isSource)
 {
+    //the resolved ports are cached while the squashed flows are current
+    auto &impl = *t._impl;
+    std::lock_guard<std::mutex> lock(impl.squashMutex);
+    const auto key = std::make_pair(portName, isSource);
+    const bool current = impl.squashCacheCurrentNoLock();
+    if (not current) impl.squashCachePorts.clear();
+    else
+    {
+        const auto it = impl.squashCachePorts.find(key);
+        if (it != impl.squashCachePorts.end()) return it->second;
+    }
+
     std::vector<Port> ports;
-    for (const auto &flow : t._impl->flows)
+    for (const auto &flow : impl.flows)
     {
         //recurse through sub topology flows
         std::vector<Port> subPorts;
@@ -28,6 +40,7 @@ std::vector<Port> resolvePortsFromTopology(const Pothos::Topology &t, const std:
         }
         ports.insert(ports.end(), subPorts.begin(), subPorts.end());
     }
+    if (current) impl.squashCachePorts[key] = ports;
     return ports;
 }
 
@@ -45,6 +58,15 @@ static std::vector<Port> resolvePorts(const Port &port, const bool isSource)
 {
     std::vector<Port> ports;
 
+    //local blocks and topologies are resolved without the proxy calls
+    if (getLocalBlock(port.obj) != nullptr)
+    {
+        ports.push_back(port);
+        return ports;
+    }
+    auto localTopology = getLocalTopology(port.obj);
+    if (localTopology != nullptr) return resolvePortsFromTopology(*localTopology, port.name, isSource);
+
     //resolve ports connected to the topology
     Pothos::Proxy subPorts;
     try
@@ -72,7 +94,13 @@ static std::vector<Port> resolvePorts(const Port &port, const bool isSource)
  **********************************************************************/
 std::vector<Flow> resolveFlowsFromTopology(const Pothos::Topology &t)
 {
-    return t._impl->squashFlows(t._impl->flows);
+    return t._impl->squashFlowsCached();
+}
+
+unsigned long long queryFlowsRevision(const Pothos::Topology &t)
+{
+    std::lock_guard<std::mutex> lock(t._impl->squashMutex);
+    return t._impl->flowsRevisionNoLock();
 }
 
 static Flow proxyToFlow(const Pothos::Proxy &flowProxy)
@@ -83,9 +111,20 @@ static Flow proxyToFlow(const Pothos::Proxy &flowProxy)
     return flow;
 }
 
-static std::vector<Flow> resolveFlows(const Pothos::Proxy &obj)
+//! Resolve the flows within a topology, returns false for a block
+static std::pair<bool, std::vector<Flow>> resolveFlows(const Pothos::Proxy &obj)
 {
-    std::vector<Flow> flows;
+    std::pair<bool, std::vector<Flow>> result(false, std::vector<Flow>());
+
+    //local blocks and topologies are resolved without the proxy calls
+    if (getLocalBlock(obj) != nullptr) return result;
+    auto localTopology = getLocalTopology(obj);
+    if (localTopology != nullptr)
+    {
+        result.first = true;
+        result.second = resolveFlowsFromTopology(*localTopology);
+        return result;
+    }
 
     //resolve flows within the topology
     Pothos::Proxy subFlows;
@@ -95,24 +134,32 @@ static std::vector<Flow> resolveFlows(const Pothos::Proxy &obj)
     }
     catch (const Pothos::Exception &)
     {
-        return flows;
+        return result;
     }
 
+    result.first = true;
     const size_t len = subFlows.call("size");
     for (size_t i = 0; i < len; i++)
     {
-        flows.push_back(proxyToFlow(subFlows.call("at", i)));
+        result.second.push_back(proxyToFlow(subFlows.call("at", i)));
     }
 
-    return flows;
+    return result;
 }
 
 /***********************************************************************
  * topology squash implementation
  **********************************************************************/
-std::vector<Flow> Pothos::Topology::Impl::squashFlows(const std::vector<Flow> &flows)
+static std::launch resolveLaunchPolicy(const Pothos::Proxy &obj)
 {
-    //spawn future to resolve ports per flow
+    return isLocalProxy(obj)?std::launch::deferred:std::launch::async;
+}
+
+std::vector<Flow> Pothos::Topology::Impl::squashFlows(const std::vector<Flow> &flows, std::vector<Pothos::Proxy> &subTopologies)
+{
+    //spawn future to resolve ports per flow:
+    //only the proxy calls into other processes run in parallel,
+    //the local objects are resolved in this thread when the future is read
     std::vector<std::shared_future<std::vector<Port>>> future_srcs, future_dsts;
     for (const auto &flow : flows)
     {
@@ -121,8 +168,8 @@ std::vector<Flow> Pothos::Topology::Impl::squashFlows(const std::vector<Flow> &f
         if (not flow.dst.obj) continue;
 
         //gather a list of sources and destinations on either end of this flow
-        future_srcs.push_back(std::async(std::launch::async, &resolvePorts, flow.src, true));
-        future_dsts.push_back(std::async(std::launch::async, &resolvePorts, flow.dst, false));
+        future_srcs.push_back(std::async(resolveLaunchPolicy(flow.src.obj), &resolvePorts, flow.src, true));
+        future_dsts.push_back(std::async(resolveLaunchPolicy(flow.dst.obj), &resolvePorts, flow.dst, false));
     }
 
     //get a list of objects
@@ -134,10 +181,10 @@ std::vector<Flow> Pothos::Topology::Impl::squashFlows(const std::vector<Flow> &f
     }
 
     //spawn futures to resolve sub-topology flows
-    std::vector<std::shared_future<std::vector<Flow>>> futureFlows;
+    std::vector<std::shared_future<std::pair<bool, std::vector<Flow>>>> futureFlows;
     for (const auto &pair : uidToObj)
     {
-        futureFlows.push_back(std::async(std::launch::async, &resolveFlows, pair.second));
+        futureFlows.push_back(std::async(resolveLaunchPolicy(pair.second), &resolveFlows, pair.second));
     }
 
     //create flat flows from futures
@@ -157,10 +204,13 @@ std::vector<Flow> Pothos::Topology::Impl::squashFlows(const std::vector<Flow> &f
             }
         }
     }
+    auto objIt = uidToObj.begin();
     for (const auto &futureFlow : futureFlows)
     {
-        const auto flows = futureFlow.get();
-        flatFlows.insert(flatFlows.end(), flows.begin(), flows.end());
+        const auto result = futureFlow.get();
+        if (result.first) subTopologies.push_back(objIt->second);
+        objIt++;
+        flatFlows.insert(flatFlows.end(), result.second.begin(), result.second.end());
     }
 
     //insert flows that pass through this topology in -> out
@@ -179,3 +229,38 @@ std::vector<Flow> Pothos::Topology::Impl::squashFlows(const std::vector<Flow> &f
 
     return flatFlows;
 }
+
+/***********************************************************************
+ * squashed flows cache implementation
+ **********************************************************************/
+unsigned long long Pothos::Topology::Impl::flowsRevisionNoLock(void)
+{
+    //the revisions only increase, so the sum changes on any change below
+    unsigned long long revision = flowsRevision;
+    for (const auto &subTopology : squashCacheSubTopologies)
+    {
+        auto localTopology = getLocalTopology(subTopology);
+        if (localTopology != nullptr) revision += queryFlowsRevision(*localTopology);
+        else revision += subTopology.call<unsigned long long>("getFlowsRevision");
+    }
+    return revision;
+}
+
+bool Pothos::Topology::Impl::squashCacheCurrentNoLock(void)
+{
+    return squashCacheValid and squashCacheRevision == this->flowsRevisionNoLock();
+}
+
+std::vector<Flow> Pothos::Topology::Impl::squashFlowsCached(void)
+{
+    std::lock_guard<std::mutex> lock(squashMutex);
+    if (this->squashCacheCurrentNoLock()) return squashCacheFlows;
+
+    squashCacheValid = false;
+    squashCachePorts.clear();
+    squashCacheSubTopologies.clear();
+    squashCacheFlows = this->squashFlows(flows, squashCacheSubTopologies);
+    squashCacheRevision = this->flowsRevisionNoLock();
+    squashCacheValid = true;
+    return squashCacheFlows;
+}
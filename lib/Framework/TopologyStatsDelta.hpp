@@ -0,0 +1,78 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <json.hpp>
+#include <cstdlib> //strtoul
+#include <string>
+
+/*!
+ * Make the delta between two samples of the stats object,
+ * where only the values that changed since the previous sample are kept:
+ *  - objects keep the changed keys, and removed keys are null
+ *  - arrays of the same size keep the changed entries, keyed by index
+ *  - anything else is the value of the next sample
+ * The stats values are never null, and arrays of port stats keep their type.
+ * \param prev the stats object of the previous sample
+ * \param next the stats object of the next sample
+ * \param [out] full set true when an array became an object,
+ *        which a delta cannot express, so the full sample must be sent
+ * \return the delta object for applyStatsDelta()
+ */
+inline nlohmann::json makeStatsDelta(const nlohmann::json &prev, const nlohmann::json &next, bool &full)
+{
+    if (prev.is_object() and next.is_object())
+    {
+        nlohmann::json delta(nlohmann::json::object());
+        for (auto it = next.begin(); it != next.end(); ++it)
+        {
+            const auto prevIt = prev.find(it.key());
+            if (prevIt == prev.end()) delta[it.key()] = it.value();
+            else if (*prevIt != it.value()) delta[it.key()] = makeStatsDelta(*prevIt, it.value(), full);
+        }
+        for (auto it = prev.begin(); it != prev.end(); ++it)
+        {
+            if (next.find(it.key()) == next.end()) delta[it.key()] = nullptr;
+        }
+        return delta;
+    }
+    if (prev.is_array() and next.is_array() and prev.size() == next.size())
+    {
+        nlohmann::json delta(nlohmann::json::object());
+        for (size_t i = 0; i < next.size(); i++)
+        {
+            if (prev[i] != next[i]) delta[std::to_string(i)] = makeStatsDelta(prev[i], next[i], full);
+        }
+        return delta;
+    }
+    if (prev.is_array() and next.is_object()) full = true;
+    return next;
+}
+
+/*!
+ * Apply a delta from makeStatsDelta() to the previous sample,
+ * so the result is the next sample.
+ * \param [in,out] base the stats object of the previous sample
+ * \param delta the delta from the previous to the next sample
+ */
+inline void applyStatsDelta(nlohmann::json &base, const nlohmann::json &delta)
+{
+    if (delta.is_object() and base.is_object())
+    {
+        for (auto it = delta.begin(); it != delta.end(); ++it)
+        {
+            if (it.value().is_null()) base.erase(it.key());
+            else applyStatsDelta(base[it.key()], it.value());
+        }
+    }
+    else if (delta.is_object() and base.is_array())
+    {
+        for (auto it = delta.begin(); it != delta.end(); ++it)
+        {
+            const size_t index = std::strtoul(it.key().c_str(), nullptr, 10);
+            if (index < base.size()) applyStatsDelta(base[index], it.value());
+        }
+    }
+    else base = delta;
+}
@@ -0,0 +1,435 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Framework/TopologyImpl.hpp"
+#include "Framework/WorkStatsSnapshot.hpp"
+#include "Framework/WorkStatsHistory.hpp"
+#include <Pothos/Framework/Exception.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Poco/Exception.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/ServerSocket.h>
+#include <condition_variable>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <json.hpp>
+
+using json = nlohmann::json;
+
+/***********************************************************************
+ * The published snapshot of one block with its names
+ **********************************************************************/
+struct StatsEntry
+{
+    std::string uid;
+    std::string blockName;
+    std::vector<std::string> inputNames;
+    std::vector<std::string> outputNames;
+    Pothos::Proxy block; //keeps the block and snapshot alive
+    std::shared_ptr<WorkStatsSnapshot> snapshot;
+    std::shared_ptr<WorkStatsHistory> history;
+};
+
+//! Gather the snapshots of the local blocks in the committed design
+static std::vector<StatsEntry> gatherStatsEntries(Pothos::Topology::Impl &impl)
+{
+    //hierarchical block names from the cache of the last commit
+    const auto names = impl.cacheBlockNames();
+
+    std::vector<StatsEntry> entries;
+    for (const auto &block : getObjSetFromFlowList(impl.activeFlatFlows))
+    {
+        if (block.getEnvironment()->getUniquePid() != Pothos::ProxyEnvironment::getLocalUniquePid()) continue; //is the block local?
+        StatsEntry entry;
+        entry.uid = block.call<std::string>("uid");
+        entry.blockName = block.call<std::string>("getName");
+        if (names.count(entry.uid) != 0) entry.blockName = names.at(entry.uid);
+        entry.block = block;
+        auto actor = block.get("_actor");
+        entry.inputNames = actor.call<std::vector<std::string>>("getStatsPortNames", true);
+        entry.outputNames = actor.call<std::vector<std::string>>("getStatsPortNames", false);
+        entry.snapshot = actor.call<std::shared_ptr<WorkStatsSnapshot>>("getStatsSnapshot");
+        entry.history = actor.call<std::shared_ptr<WorkStatsHistory>>("getStatsHistory");
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+/***********************************************************************
+ * Stats exporter reads the published snapshots without the actor lock
+ **********************************************************************/
+struct StatsExporter
+{
+    typedef StatsEntry Entry;
+
+    StatsExporter(const std::string &path, const double period, std::vector<Entry> &&entries):
+        out(path, std::ios::out | std::ios::app),
+        period(std::chrono::nanoseconds((long long)(period*1e9))),
+        entries(std::move(entries)),
+        done(false)
+    {
+        if (not out) throw Pothos::OpenFileException("Pothos::Topology::startStatsExport("+path+")", "failed to open");
+        thread = std::thread(&StatsExporter::run, this);
+    }
+
+    ~StatsExporter(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        cond.notify_one();
+        thread.join();
+    }
+
+    void run(void)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (not cond.wait_for(lock, period, [this]{return done;}))
+        {
+            this->exportLine();
+        }
+    }
+
+    void exportLine(void)
+    {
+        json stats(json::object());
+        for (const auto &entry : entries)
+        {
+            const auto data = entry.snapshot->read();
+            json blockStats;
+            blockStats["blockName"] = entry.blockName;
+            blockStats["numTaskCalls"] = data.numTaskCalls;
+            blockStats["numWorkCalls"] = data.numWorkCalls;
+            blockStats["stallPrepare"] = data.stallPrepare;
+            blockStats["stallNoTokens"] = data.stallNoTokens;
+            blockStats["stallMessagesFull"] = data.stallMessagesFull;
+            blockStats["stallNoOutputBuffer"] = data.stallNoOutputBuffer;
+            blockStats["stallReserve"] = data.stallReserve;
+            blockStats["totalTimeTask"] = data.totalTimeTask;
+            blockStats["totalTimeWork"] = data.totalTimeWork;
+            blockStats["totalTimePreWork"] = data.totalTimePreWork;
+            blockStats["totalTimePostWork"] = data.totalTimePostWork;
+            blockStats["memoryBytes"] = data.memoryBytes;
+
+            json inputStats(json::array());
+            for (size_t i = 0; i < data.numInputs; i++)
+            {
+                json portStats;
+                portStats["totalElements"] = data.inputElements[i];
+                portStats["totalBuffers"] = data.inputBuffers[i];
+                portStats["totalLabels"] = data.inputLabels[i];
+                portStats["totalMessages"] = data.inputMessages[i];
+                portStats["enqueuedBytes"] = data.inputQueueBytes[i];
+                inputStats.push_back(portStats);
+            }
+            if (not inputStats.empty()) blockStats["inputStats"] = inputStats;
+
+            json outputStats(json::array());
+            for (size_t i = 0; i < data.numOutputs; i++)
+            {
+                json portStats;
+                portStats["totalElements"] = data.outputElements[i];
+                portStats["totalBuffers"] = data.outputBuffers[i];
+                portStats["totalLabels"] = data.outputLabels[i];
+                portStats["totalMessages"] = data.outputMessages[i];
+                outputStats.push_back(portStats);
+            }
+            if (not outputStats.empty()) blockStats["outputStats"] = outputStats;
+
+            stats[entry.uid] = blockStats;
+        }
+
+        json line;
+        line["time"] = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        line["stats"] = stats;
+        out << line.dump() << std::endl;
+    }
+
+    std::ofstream out;
+    const std::chrono::nanoseconds period;
+    const std::vector<Entry> entries;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done;
+    std::thread thread;
+};
+
+/***********************************************************************
+ * Topology stats export API
+ **********************************************************************/
+void Pothos::Topology::startStatsExport(const std::string &path, const double period)
+{
+    this->stopStatsExport();
+
+    //gather the snapshots once, the exporter does not touch the actors
+    _impl->statsExporter.reset(new StatsExporter(path, period, gatherStatsEntries(*_impl)));
+}
+
+void Pothos::Topology::stopStatsExport(void)
+{
+    _impl->statsExporter.reset();
+}
+
+/***********************************************************************
+ * Stats history from the rings of the sampler thread
+ **********************************************************************/
+std::string Pothos::Topology::queryStatsHistory(const double seconds)
+{
+    json stats(json::object());
+    for (const auto &entry : gatherStatsEntries(*_impl))
+    {
+        json history(json::array());
+        for (const auto &rates : entry.history->read(seconds))
+        {
+            json interval;
+            interval["time"] = rates.time;
+            interval["taskCalls"] = rates.taskCalls;
+            interval["workCalls"] = rates.workCalls;
+            interval["inputElements"] = rates.inputElements;
+            interval["outputElements"] = rates.outputElements;
+            interval["workTime"] = rates.workTime;
+            interval["stalls"] = rates.stalls;
+            interval["queueBytes"] = rates.queueBytes;
+            history.push_back(interval);
+        }
+        json blockStats;
+        blockStats["blockName"] = entry.blockName;
+        blockStats["history"] = history;
+        stats[entry.uid] = blockStats;
+    }
+    return stats.dump();
+}
+
+/***********************************************************************
+ * OpenMetrics text format from the published snapshots
+ **********************************************************************/
+static std::string metricsLabelValue(const std::string &value)
+{
+    std::string out;
+    for (const auto ch : value)
+    {
+        if (ch == '\\') out += "\\\\";
+        else if (ch == '"') out += "\\\"";
+        else if (ch == '\n') out += "\\n";
+        else out += ch;
+    }
+    return out;
+}
+
+struct MetricFamily
+{
+    MetricFamily(std::ostream &os, const std::string &name, const std::string &type, const std::string &help):
+        os(os), name((type == "counter")?(name+"_total"):name)
+    {
+        os << "# TYPE " << name << " " << type << "\n";
+        os << "# HELP " << name << " " << help << "\n";
+    }
+
+    void sample(const std::string &labels, const double value)
+    {
+        os << name << "{" << labels << "} " << value << "\n";
+    }
+
+    void sample(const std::string &labels, const unsigned long long value)
+    {
+        os << name << "{" << labels << "} " << value << "\n";
+    }
+
+    std::ostream &os;
+    const std::string name;
+};
+
+static std::string makeMetricsText(const std::vector<StatsEntry> &entries)
+{
+    //read each snapshot once, so all families are from the same sample
+    std::vector<WorkStatsData> samples;
+    std::vector<std::string> blockLabels;
+    for (const auto &entry : entries)
+    {
+        samples.push_back(entry.snapshot->read());
+        blockLabels.push_back("uid=\"" + metricsLabelValue(entry.uid) + "\",block=\"" + metricsLabelValue(entry.blockName) + "\"");
+    }
+    auto portLabels = [&](const size_t i, const bool isInput, const size_t index)
+    {
+        const auto &names = isInput?entries[i].inputNames:entries[i].outputNames;
+        const auto name = (index < names.size())?names[index]:std::to_string(index);
+        return blockLabels[i] + ",direction=\"" + (isInput?"input":"output") + "\",port=\"" + metricsLabelValue(name) + "\"";
+    };
+
+    std::ostringstream os;
+    os.precision(17);
+    {
+        MetricFamily family(os, "pothos_block_task_calls", "counter", "Work tasks of the block");
+        for (size_t i = 0; i < entries.size(); i++) family.sample(blockLabels[i], samples[i].numTaskCalls);
+    }
+    {
+        MetricFamily family(os, "pothos_block_work_calls", "counter", "Calls to the block work()");
+        for (size_t i = 0; i < entries.size(); i++) family.sample(blockLabels[i], samples[i].numWorkCalls);
+    }
+    {
+        MetricFamily family(os, "pothos_block_stalls", "counter", "Work tasks that returned without calling work() by reason");
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const auto &data = samples[i];
+            family.sample(blockLabels[i] + ",reason=\"prepare\"", data.stallPrepare);
+            family.sample(blockLabels[i] + ",reason=\"noTokens\"", data.stallNoTokens);
+            family.sample(blockLabels[i] + ",reason=\"messagesFull\"", data.stallMessagesFull);
+            family.sample(blockLabels[i] + ",reason=\"noOutputBuffer\"", data.stallNoOutputBuffer);
+            family.sample(blockLabels[i] + ",reason=\"reserve\"", data.stallReserve);
+        }
+    }
+    {
+        MetricFamily family(os, "pothos_block_time_seconds", "counter", "Time spent in the work task by phase");
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const auto &data = samples[i];
+            family.sample(blockLabels[i] + ",phase=\"task\"", data.totalTimeTask/1e9);
+            family.sample(blockLabels[i] + ",phase=\"work\"", data.totalTimeWork/1e9);
+            family.sample(blockLabels[i] + ",phase=\"prework\"", data.totalTimePreWork/1e9);
+            family.sample(blockLabels[i] + ",phase=\"postwork\"", data.totalTimePostWork/1e9);
+        }
+    }
+    {
+        MetricFamily family(os, "pothos_block_memory_bytes", "gauge", "Shared buffer memory allocated by the block");
+        for (size_t i = 0; i < entries.size(); i++) family.sample(blockLabels[i], samples[i].memoryBytes);
+    }
+    {
+        MetricFamily family(os, "pothos_port_elements", "counter", "Elements consumed or produced by the stream port");
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            for (size_t j = 0; j < samples[i].numInputs; j++) family.sample(portLabels(i, true, j), samples[i].inputElements[j]);
+            for (size_t j = 0; j < samples[i].numOutputs; j++) family.sample(portLabels(i, false, j), samples[i].outputElements[j]);
+        }
+    }
+    {
+        MetricFamily family(os, "pothos_port_buffers", "counter", "Buffers consumed or produced by the stream port");
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            for (size_t j = 0; j < samples[i].numInputs; j++) family.sample(portLabels(i, true, j), samples[i].inputBuffers[j]);
+            for (size_t j = 0; j < samples[i].numOutputs; j++) family.sample(portLabels(i, false, j), samples[i].outputBuffers[j]);
+        }
+    }
+    {
+        MetricFamily family(os, "pothos_port_labels", "counter", "Labels consumed or produced by the stream port");
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            for (size_t j = 0; j < samples[i].numInputs; j++) family.sample(portLabels(i, true, j), samples[i].inputLabels[j]);
+            for (size_t j = 0; j < samples[i].numOutputs; j++) family.sample(portLabels(i, false, j), samples[i].outputLabels[j]);
+        }
+    }
+    {
+        MetricFamily family(os, "pothos_port_messages", "counter", "Messages consumed or produced by the stream port");
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            for (size_t j = 0; j < samples[i].numInputs; j++) family.sample(portLabels(i, true, j), samples[i].inputMessages[j]);
+            for (size_t j = 0; j < samples[i].numOutputs; j++) family.sample(portLabels(i, false, j), samples[i].outputMessages[j]);
+        }
+    }
+    {
+        MetricFamily family(os, "pothos_port_queue_bytes", "gauge", "Bytes enqueued on the input port");
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            for (size_t j = 0; j < samples[i].numInputs; j++) family.sample(portLabels(i, true, j), samples[i].inputQueueBytes[j]);
+        }
+    }
+    os << "# EOF\n";
+    return os.str();
+}
+
+std::string Pothos::Topology::queryMetrics(void)
+{
+    return makeMetricsText(gatherStatsEntries(*_impl));
+}
+
+/***********************************************************************
+ * Metrics server serves the text format over HTTP
+ **********************************************************************/
+struct MetricsRequestHandler : Poco::Net::HTTPRequestHandler
+{
+    MetricsRequestHandler(const std::shared_ptr<const std::vector<StatsEntry>> &entries):
+        entries(entries)
+    {
+        return;
+    }
+
+    void handleRequest(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+    {
+        const auto path = request.getURI().substr(0, request.getURI().find('?'));
+        if (path != "/metrics")
+        {
+            response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
+            response.send() << "Not Found\n";
+            return;
+        }
+        const auto text = makeMetricsText(*entries);
+        response.setContentType("application/openmetrics-text; version=1.0.0; charset=utf-8");
+        response.setContentLength(text.size());
+        response.send() << text;
+    }
+
+    const std::shared_ptr<const std::vector<StatsEntry>> entries;
+};
+
+struct MetricsRequestHandlerFactory : Poco::Net::HTTPRequestHandlerFactory
+{
+    MetricsRequestHandlerFactory(const std::shared_ptr<const std::vector<StatsEntry>> &entries):
+        entries(entries)
+    {
+        return;
+    }
+
+    Poco::Net::HTTPRequestHandler *createRequestHandler(const Poco::Net::HTTPServerRequest &)
+    {
+        return new MetricsRequestHandler(entries);
+    }
+
+    const std::shared_ptr<const std::vector<StatsEntry>> entries;
+};
+
+struct MetricsServer
+{
+    MetricsServer(const std::string &address, std::vector<StatsEntry> &&entries):
+        socket(Poco::Net::SocketAddress(address)),
+        server(new MetricsRequestHandlerFactory(std::make_shared<const std::vector<StatsEntry>>(std::move(entries))),
+            socket, new Poco::Net::HTTPServerParams())
+    {
+        server.start();
+    }
+
+    ~MetricsServer(void)
+    {
+        server.stopAll(true);
+    }
+
+    Poco::Net::ServerSocket socket;
+    Poco::Net::HTTPServer server;
+};
+
+std::string Pothos::Topology::startMetricsServer(const std::string &address)
+{
+    this->stopMetricsServer();
+
+    auto entries = gatherStatsEntries(*_impl);
+    try
+    {
+        _impl->metricsServer.reset(new MetricsServer(address, std::move(entries)));
+    }
+    catch (const Poco::Exception &ex)
+    {
+        throw Pothos::IOException("Pothos::Topology::startMetricsServer("+address+")", ex.displayText());
+    }
+    return _impl->metricsServer->socket.address().toString();
+}
+
+void Pothos::Topology::stopMetricsServer(void)
+{
+    _impl->metricsServer.reset();
+}
@@ -1,10 +1,18 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Framework/TopologyImpl.hpp>
 #include "Framework/TopologyImpl.hpp"
+#include "Framework/WorkerActor.hpp"
+#include "Framework/TopologyEncoding.hpp"
+#include "Framework/TopologyStatsDelta.hpp"
 #include <Pothos/Proxy.hpp>
+#include <algorithm> //sort
+#include <chrono>
+#include <thread>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <json.hpp>
 
 using json = nlohmann::json;
@@ -12,12 +20,25 @@ using json = nlohmann::json;
 /***********************************************************************
  * create JSON stats object
  **********************************************************************/
+static json queryTopologyStats(Pothos::Topology &topology);
+
 static json queryWorkStats(const Pothos::Proxy &block)
 {
-    //try recursive traversal
+    //local blocks and topologies are queried without the proxy calls and the encoding
+    auto localTopology = getLocalTopology(block);
+    if (localTopology != nullptr) return queryTopologyStats(*localTopology);
+    auto localActor = getLocalActor(block);
+    if (localActor != nullptr)
+    {
+        json topStats;
+        topStats[getLocalBlock(block)->uid()] = json::parse(localActor->queryWorkStats());
+        return topStats;
+    }
+
+    //try recursive traversal, sub-topologies can be remote: use the binary encoding
     try
     {
-        return json::parse(block.call<std::string>("queryJSONStats"));
+        return decodeTopologyJSON(block.call<std::string>("queryJSONStats", "{\"format\":\"cbor\"}"));
     }
     catch (const std::exception &) {}
 
@@ -29,15 +50,131 @@ static json queryWorkStats(const Pothos::Proxy &block)
     return topStats;
 }
 
-std::string Pothos::Topology::queryJSONStats(void)
+/***********************************************************************
+ * delta streams of the stats:
+ * A caller that polls the stats of a remote topology names a stream
+ * and sends the sequence number of the last reply that it merged.
+ * The remote topology keeps the stats of the last reply per stream,
+ * and replies with only the values that changed since then,
+ * or with the full stats when the caller is out of sequence.
+ **********************************************************************/
+struct RemoteStatsStream
 {
+    RemoteStatsStream(void): seq(0){}
+    std::mutex mutex; //serializes the polls, so replies merge in order
+    unsigned long long seq; //sequence number of the merged stats (0 for none)
     json stats;
+};
 
-    //query each block's work stats and key it with the UID
+struct StatsDeltaState
+{
+    //! the sequence number and stats of the last reply per caller stream
+    std::map<std::string, std::pair<unsigned long long, json>> sent;
+
+    //! the merged stats per remote topology environment
+    std::map<std::string, std::shared_ptr<RemoteStatsStream>> remotes;
+};
+
+static json queryRemoteStats(RemoteStatsStream &stream, const Pothos::Proxy &topology, const std::string &streamId)
+{
+    std::lock_guard<std::mutex> lock(stream.mutex);
+    json request;
+    request["format"] = "cbor";
+    request["delta"] = streamId;
+    request["seq"] = stream.seq;
+    const std::string requestStr(request.dump());
+    try
+    {
+        const auto reply = decodeTopologyJSON(topology.call<std::string>("queryJSONStats", requestStr));
+        if (reply.value("full", true)) stream.stats = reply["stats"];
+        else applyStatsDelta(stream.stats, reply["stats"]);
+        stream.seq = reply.value<unsigned long long>("seq", 0);
+    }
+    catch (...)
+    {
+        //start over with the full stats on the next poll
+        stream.seq = 0;
+        stream.stats = json();
+        throw;
+    }
+    return stream.stats;
+}
+
+static json queryRemoteWorkStats(std::shared_ptr<RemoteStatsStream> stream, const Pothos::Proxy &topology,
+    const std::string &streamId, const std::map<std::string, Pothos::Proxy> &blocks)
+{
+    //one poll of the topology in the remote environment covers all of its blocks
+    const auto envStats = queryRemoteStats(*stream, topology, streamId);
+    json stats(json::object());
+    for (const auto &pair : blocks)
+    {
+        const auto it = envStats.find(pair.first);
+        if (it != envStats.end())
+        {
+            stats[pair.first] = *it;
+            continue;
+        }
+
+        //the flat stats do not cover nested topologies or blocks from before the commit
+        const auto workStats = queryWorkStats(pair.second);
+        for (auto statsIt = workStats.begin(); statsIt != workStats.end(); ++statsIt)
+        {
+            stats[statsIt.key()] = statsIt.value();
+        }
+    }
+    return stats;
+}
+
+static std::shared_ptr<StatsDeltaState> getStatsDeltaState(Pothos::Topology::Impl &impl)
+{
+    std::lock_guard<std::mutex> lock(impl.statsDeltaMutex);
+    if (not impl.statsDelta) impl.statsDelta.reset(new StatsDeltaState());
+    return impl.statsDelta;
+}
+
+//! The stats of every block in the topology keyed by UID, with the hierarchical block names
+static json queryTopologyStats(Pothos::Topology &topology)
+{
+    auto &impl = *topology._impl;
+    const auto deltaState = getStatsDeltaState(impl);
+    json stats;
+
+    //the unique blocks by UID, and the blocks in remote environments
+    //with a sub-topology from the last commit are grouped by environment
+    std::map<std::string, Pothos::Proxy> blocks;
+    for (const auto &flow : impl.flows)
+    {
+        if (flow.src.obj) blocks[flow.src.uid] = flow.src.obj;
+        if (flow.dst.obj) blocks[flow.dst.uid] = flow.dst.obj;
+    }
+    std::map<std::string, std::map<std::string, Pothos::Proxy>> remoteBlocks;
     std::vector<std::shared_future<json>> results;
-    for (const auto &block : getObjSetFromFlowList(_impl->flows))
+    for (const auto &pair : blocks)
     {
-        results.push_back(std::async(std::launch::async, queryWorkStats, block));
+        const auto upid = pair.second.getEnvironment()->getUniquePid();
+        if (upid != Pothos::ProxyEnvironment::getLocalUniquePid() and impl.remoteTopologies.count(upid) != 0)
+        {
+            remoteBlocks[upid][pair.first] = pair.second;
+        }
+
+        //query each block's work stats and key it with the UID,
+        //only the proxy calls into other processes run in parallel
+        else results.push_back(std::async(isLocalProxy(pair.second)?
+            std::launch::deferred:std::launch::async, queryWorkStats, pair.second));
+    }
+
+    //poll each remote environment as a delta stream named by this topology
+    for (const auto &pair : remoteBlocks)
+    {
+        std::shared_ptr<RemoteStatsStream> stream;
+        {
+            std::lock_guard<std::mutex> lock(impl.statsDeltaMutex);
+            auto &remote = deltaState->remotes[pair.first];
+            if (not remote) remote.reset(new RemoteStatsStream());
+            stream = remote;
+        }
+        results.push_back(std::async(std::launch::async, queryRemoteWorkStats,
+            stream, impl.remoteTopologies.at(pair.first), topology.uid(), pair.second));
     }
 
     //wait on the futures and record to the object
@@ -50,15 +187,191 @@ std::string Pothos::Topology::queryJSONStats(void)
         }
     }
 
-    //use flat topology to get hierarchical block names
-    const auto flatTopologyObj = json::parse(this->dumpJSON());
-    const auto flatTopologyBlocks = flatTopologyObj["blocks"];
-    for (auto it = flatTopologyBlocks.begin(); it != flatTopologyBlocks.end(); ++it)
+    //hierarchical block names from the cache of the last commit,
+    //the cache is refreshed for blocks connected since the commit
+    std::map<std::string, std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(impl.blockNamesMutex);
+        names = impl.blockNames;
+    }
+    for (auto it = stats.begin(); it != stats.end(); ++it)
+    {
+        if (names.count(it.key()) != 0) continue;
+        names = impl.cacheBlockNames();
+        break;
+    }
+    for (auto it = stats.begin(); it != stats.end(); ++it)
+    {
+        const auto nameIt = names.find(it.key());
+        if (nameIt != names.end()) it.value()["blockName"] = nameIt->second;
+    }
+    return stats;
+}
+
+std::string Pothos::Topology::queryJSONStats(const std::string &request)
+{
+    const auto configObj = json::parse(request.empty()?"{}":request);
+    auto stats = queryTopologyStats(*this);
+
+    //reply to a delta stream with the changes since the last reply to the stream
+    const auto deltaIt = configObj.find("delta");
+    if (deltaIt != configObj.end())
+    {
+        const auto seq = configObj.value<unsigned long long>("seq", 0);
+        json reply;
+        const auto deltaState = getStatsDeltaState(*_impl);
+        std::lock_guard<std::mutex> lock(_impl->statsDeltaMutex);
+        auto &sent = deltaState->sent[deltaIt->get<std::string>()];
+        bool full = (seq == 0 or seq != sent.first);
+        if (not full) reply["stats"] = makeStatsDelta(sent.second, stats, full);
+        if (full) reply["stats"] = stats;
+        reply["full"] = full;
+        reply["seq"] = ++sent.first;
+        sent.second = std::move(stats);
+        return encodeTopologyJSON(reply, configObj);
+    }
+
+    //return the result in the requested format
+    return encodeTopologyJSON(stats, configObj);
+}
+
+/***********************************************************************
+ * bottleneck analysis from two stats samples
+ **********************************************************************/
+static double ticksToSeconds(const json &blockStats, const double ticks)
+{
+    const auto num = blockStats.value<double>("tickRatioNum", 1.0);
+    const auto den = blockStats.value<double>("tickRatioDen", 1e9);
+    return ticks*num/den;
+}
+
+static unsigned long long statsDelta(const json &stats0, const json &stats1, const std::string &key)
+{
+    const auto v0 = stats0.value<unsigned long long>(key, 0);
+    const auto v1 = stats1.value<unsigned long long>(key, 0);
+    return (v1 > v0)?(v1 - v0):0;
+}
+
+static json analyzeBlock(const json &stats0, const json &stats1)
+{
+    json blockObj;
+    blockObj["blockName"] = stats1["blockName"];
+
+    //utilization is the fraction of the wall time spent inside work()
+    const auto wallTicks = stats1.value<double>("timeStatsQuery", 0.0) - stats0.value<double>("timeStatsQuery", 0.0);
+    const auto workTicks = double(statsDelta(stats0, stats1, "totalTimeWork"));
+    const auto wallTime = ticksToSeconds(stats1, wallTicks);
+    blockObj["utilization"] = (wallTicks > 0.0)?std::min(workTicks/wallTicks, 1.0):0.0;
+    blockObj["workCallsPerSec"] = (wallTime > 0.0)?(statsDelta(stats0, stats1, "numWorkCalls")/wallTime):0.0;
+
+    //the most frequent stall reason tells what the block waits on
+    static const std::vector<std::pair<std::string, std::string>> stallKeys{
+        {"stallPrepare", "prepare"},
+        {"stallNoTokens", "noTokens"},
+        {"stallMessagesFull", "messagesFull"},
+        {"stallNoOutputBuffer", "noOutputBuffer"},
+        {"stallReserve", "reserve"}};
+    json stallsObj(json::object());
+    std::string stallReason("none");
+    unsigned long long maxStalls(0);
+    for (const auto &stallKey : stallKeys)
+    {
+        const auto stalls = statsDelta(stats0, stats1, stallKey.first);
+        stallsObj[stallKey.second] = stalls;
+        if (stalls <= maxStalls) continue;
+        maxStalls = stalls;
+        stallReason = stallKey.second;
+    }
+    blockObj["stalls"] = stallsObj;
+    blockObj["stallReason"] = stallReason;
+
+    //classify: stalls on outputs are backpressure from downstream,
+    //stalls on the input reserve are starvation from upstream
+    std::string state("idle");
+    if (blockObj["utilization"].get<double>() >= 0.5) state = "busy";
+    else if (stallReason == "noTokens" or stallReason == "messagesFull" or stallReason == "noOutputBuffer") state = "backpressured";
+    else if (stallReason == "reserve") state = "starved";
+    else if (stallReason == "prepare") state = "unprepared";
+    else if (statsDelta(stats0, stats1, "numWorkCalls") != 0) state = "running";
+    blockObj["state"] = state;
+    return blockObj;
+}
+
+std::string Pothos::Topology::queryBottlenecks(const std::string &request)
+{
+    const auto configObj = json::parse(request.empty()?"{}":request);
+    const auto interval = configObj.value<double>("interval", 0.1);
+
+    //sample the stats twice to measure the rates over the interval
+    const auto stats0 = json::parse(this->queryJSONStats());
+    std::this_thread::sleep_for(std::chrono::microseconds(long(interval*1e6)));
+    const auto stats1 = json::parse(this->queryJSONStats());
+
+    //per-block utilization and stall analysis
+    json blocksArray(json::array());
+    for (auto it = stats1.begin(); it != stats1.end(); ++it)
+    {
+        const auto it0 = stats0.find(it.key());
+        if (it0 == stats0.end()) continue;
+        auto blockObj = analyzeBlock(*it0, it.value());
+        blockObj["uid"] = it.key();
+        blocksArray.push_back(blockObj);
+    }
+    std::sort(blocksArray.begin(), blocksArray.end(), [](const json &a, const json &b)
+    {
+        return a["utilization"].get<double>() > b["utilization"].get<double>();
+    });
+
+    //queue depths on each flat connection from the destination input port
+    const auto topObj = json::parse(this->dumpJSON("{\"mode\":\"flat\"}"));
+    json queuesArray(json::array());
+    unsigned long long maxEnqueuedBytes(0);
+    for (const auto &conn : topObj["connections"])
+    {
+        const auto dstId = conn["dstId"].get<std::string>();
+        const auto dstName = conn["dstName"].get<std::string>();
+        if (not stats1.count(dstId) or not stats1[dstId].count("inputStats")) continue;
+        for (const auto &portStats : stats1[dstId]["inputStats"])
+        {
+            if (portStats["portName"].get<std::string>() != dstName) continue;
+            json queueObj;
+            queueObj["srcId"] = conn["srcId"];
+            queueObj["srcName"] = conn["srcName"];
+            queueObj["dstId"] = dstId;
+            queueObj["dstName"] = dstName;
+            queueObj["enqueuedBytes"] = portStats.value<unsigned long long>("enqueuedBytes", 0);
+            queueObj["enqueuedBuffers"] = portStats.value<unsigned long long>("enqueuedBuffers", 0);
+            queueObj["enqueuedMessages"] = portStats.value<unsigned long long>("enqueuedMessages", 0);
+            maxEnqueuedBytes = std::max(maxEnqueuedBytes, queueObj["enqueuedBytes"].get<unsigned long long>());
+            queuesArray.push_back(queueObj);
+        }
+    }
+
+    //the fill ratio is relative to the deepest queue in the topology
+    for (auto &queueObj : queuesArray)
+    {
+        const auto enqueuedBytes = queueObj["enqueuedBytes"].get<unsigned long long>();
+        queueObj["queueFill"] = (maxEnqueuedBytes == 0)?0.0:(double(enqueuedBytes)/maxEnqueuedBytes);
+    }
+    std::sort(queuesArray.begin(), queuesArray.end(), [](const json &a, const json &b)
+    {
+        return a["enqueuedBytes"].get<unsigned long long>() > b["enqueuedBytes"].get<unsigned long long>();
+    });
+
+    //the limiter is the busiest block that is not itself waiting on downstream
+    std::string limiter;
+    for (const auto &blockObj : blocksArray)
     {
-        if (not stats.count(it.key())) continue;
-        stats[it.key()]["blockName"] = it.value()["name"];
+        if (blockObj["utilization"].get<double>() == 0.0) break;
+        if (blockObj["state"].get<std::string>() == "backpressured") continue;
+        limiter = blockObj["uid"].get<std::string>();
+        break;
     }
 
-    //return the string-formatted result
-    return stats.dump(4);
+    json reportObj;
+    reportObj["interval"] = interval;
+    reportObj["limiter"] = limiter;
+    reportObj["blocks"] = blocksArray;
+    reportObj["queues"] = queuesArray;
+    return reportObj.dump(4);
 }
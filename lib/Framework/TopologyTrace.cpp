@@ -0,0 +1,56 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Framework/TopologyImpl.hpp>
+#include "Framework/TopologyImpl.hpp"
+#include <Pothos/Proxy.hpp>
+#include <future>
+#include <set>
+#include <json.hpp>
+
+using json = nlohmann::json;
+
+/***********************************************************************
+ * collect Chrome trace events
+ **********************************************************************/
+static json queryTraceEvents(const Pothos::Proxy &block)
+{
+    //try recursive traversal
+    try
+    {
+        return json::parse(block.call<std::string>("dumpTrace"))["traceEvents"];
+    }
+    catch (const std::exception &) {}
+
+    //otherwise, regular block, query the actor's events
+    auto actor = block.get("_actor");
+    return json::parse(actor.call<std::string>("queryTrace"));
+}
+
+std::string Pothos::Topology::dumpTrace(void)
+{
+    //query each block's events in parallel
+    std::vector<std::shared_future<json>> results;
+    for (const auto &block : getObjSetFromFlowList(_impl->flows))
+    {
+        results.push_back(std::async(std::launch::async, queryTraceEvents, block));
+    }
+
+    //merge the events, the thread name metadata is repeated per block
+    json traceEvents(json::array());
+    std::set<std::string> threadNames;
+    for (const auto &result : results)
+    {
+        for (const auto &event : result.get())
+        {
+            if (event.value("ph", "") == "M" and not threadNames.insert(
+                event["pid"].dump() + "/" + event["tid"].dump()).second) continue;
+            traceEvents.push_back(event);
+        }
+    }
+
+    json trace;
+    trace["traceEvents"] = traceEvents;
+    trace["displayTimeUnit"] = "ns";
+    return trace.dump();
+}
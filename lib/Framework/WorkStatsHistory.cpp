@@ -0,0 +1,150 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Framework/WorkStatsHistory.hpp"
+#include <condition_variable>
+#include <thread>
+
+/***********************************************************************
+ * The sampler thread visits every registered history once per second
+ **********************************************************************/
+class WorkStatsSampler
+{
+public:
+    static WorkStatsSampler &instance(void)
+    {
+        static WorkStatsSampler sampler;
+        return sampler;
+    }
+
+    void add(const std::shared_ptr<WorkStatsHistory> &history)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _histories.push_back(history);
+        if (not _thread.joinable()) _thread = std::thread(&WorkStatsSampler::run, this);
+    }
+
+private:
+    WorkStatsSampler(void):
+        _done(false)
+    {
+        return;
+    }
+
+    ~WorkStatsSampler(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done = true;
+        }
+        _cond.notify_one();
+        if (_thread.joinable()) _thread.join();
+    }
+
+    void run(void)
+    {
+        auto next = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            next += std::chrono::seconds(1);
+            if (_cond.wait_until(lock, next, [this]{return _done;})) break;
+
+            //take the live histories and forget the released ones
+            std::vector<std::shared_ptr<WorkStatsHistory>> live;
+            size_t n(0);
+            for (const auto &weak : _histories)
+            {
+                auto history = weak.lock();
+                if (not history) continue;
+                _histories[n++] = weak;
+                live.push_back(history);
+            }
+            _histories.resize(n);
+
+            //sample without the lock so registration is never blocked
+            lock.unlock();
+            for (const auto &history : live) history->sample();
+            live.clear();
+            lock.lock();
+        }
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    bool _done;
+    std::vector<std::weak_ptr<WorkStatsHistory>> _histories;
+    std::thread _thread;
+};
+
+/***********************************************************************
+ * The history ring implementation
+ **********************************************************************/
+std::shared_ptr<WorkStatsHistory> WorkStatsHistory::make(const std::shared_ptr<WorkStatsSnapshot> &snapshot)
+{
+    std::shared_ptr<WorkStatsHistory> history(new WorkStatsHistory(snapshot));
+    WorkStatsSampler::instance().add(history);
+    return history;
+}
+
+WorkStatsHistory::WorkStatsHistory(const std::shared_ptr<WorkStatsSnapshot> &snapshot):
+    _snapshot(snapshot),
+    _last(snapshot->read()),
+    _lastSample(std::chrono::steady_clock::now()),
+    _next(0)
+{
+    _ring.reserve(NUM_SAMPLES);
+}
+
+void WorkStatsHistory::sample(void)
+{
+    const auto data = _snapshot->read();
+    const auto now = std::chrono::steady_clock::now();
+    const auto elapsed = std::chrono::duration<double>(now - _lastSample).count();
+    if (elapsed <= 0.0) return;
+
+    auto rate = [elapsed](const unsigned long long next, const unsigned long long last)
+    {
+        return (next < last)?0.0:(double(next - last)/elapsed);
+    };
+    auto sum = [](const unsigned long long *values, const unsigned long long num)
+    {
+        unsigned long long total(0);
+        for (size_t i = 0; i < num; i++) total += values[i];
+        return total;
+    };
+
+    WorkStatsRates rates;
+    rates.time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    rates.taskCalls = rate(data.numTaskCalls, _last.numTaskCalls);
+    rates.workCalls = rate(data.numWorkCalls, _last.numWorkCalls);
+    rates.inputElements = rate(sum(data.inputElements, data.numInputs), sum(_last.inputElements, _last.numInputs));
+    rates.outputElements = rate(sum(data.outputElements, data.numOutputs), sum(_last.outputElements, _last.numOutputs));
+    rates.workTime = rate(data.totalTimeWork, _last.totalTimeWork)/1e9;
+    rates.stalls = rate(
+        data.stallPrepare+data.stallNoTokens+data.stallMessagesFull+data.stallNoOutputBuffer+data.stallReserve,
+        _last.stallPrepare+_last.stallNoTokens+_last.stallMessagesFull+_last.stallNoOutputBuffer+_last.stallReserve);
+    rates.queueBytes = sum(data.inputQueueBytes, data.numInputs);
+    _last = data;
+    _lastSample = now;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_ring.size() < NUM_SAMPLES) _ring.push_back(rates);
+    else _ring[_next] = rates;
+    _next = (_next + 1) % NUM_SAMPLES;
+}
+
+std::vector<WorkStatsRates> WorkStatsHistory::read(const double seconds) const
+{
+    const auto now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<WorkStatsRates> rates;
+    const size_t first = (_ring.size() < NUM_SAMPLES)?0:_next;
+    for (size_t i = 0; i < _ring.size(); i++)
+    {
+        const auto &entry = _ring[(first + i) % _ring.size()];
+        if (entry.time >= now - seconds) rates.push_back(entry);
+    }
+    return rates;
+}
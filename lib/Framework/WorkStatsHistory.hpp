@@ -0,0 +1,62 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include "Framework/WorkStatsSnapshot.hpp"
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+/*!
+ * The rates of one history interval, differenced from two snapshots.
+ * Rates are per second of the interval, the queue depth is the level
+ * at the end of the interval.
+ */
+struct WorkStatsRates
+{
+    double time; //!< the end of the interval in seconds since the epoch
+    double taskCalls; //!< work tasks per second
+    double workCalls; //!< calls to work() per second
+    double inputElements; //!< elements consumed per second on all stream inputs
+    double outputElements; //!< elements produced per second on all stream outputs
+    double workTime; //!< seconds spent in work() per second
+    double stalls; //!< work tasks per second that returned without calling work()
+    unsigned long long queueBytes; //!< bytes enqueued on all stream inputs
+};
+
+/*!
+ * A fixed-size ring of the recent rates of one block.
+ * The rates are sampled once per second by a single framework thread,
+ * which reads the lock-free snapshot that the block publishes,
+ * so the history is kept without external polling of the block.
+ */
+class WorkStatsHistory
+{
+public:
+    //! The number of intervals kept by the ring
+    static const size_t NUM_SAMPLES = 300;
+
+    /*!
+     * Make a history of the snapshot and register it with the sampler thread.
+     * The sampler holds a weak reference and forgets the history once released.
+     */
+    static std::shared_ptr<WorkStatsHistory> make(const std::shared_ptr<WorkStatsSnapshot> &snapshot);
+
+    //! Read the intervals that end within the last number of seconds, oldest first
+    std::vector<WorkStatsRates> read(const double seconds) const;
+
+    //! Difference the snapshot against the previous sample (sampler thread)
+    void sample(void);
+
+private:
+    WorkStatsHistory(const std::shared_ptr<WorkStatsSnapshot> &snapshot);
+
+    const std::shared_ptr<WorkStatsSnapshot> _snapshot;
+    WorkStatsData _last;
+    std::chrono::steady_clock::time_point _lastSample;
+    mutable std::mutex _mutex;
+    std::vector<WorkStatsRates> _ring;
+    size_t _next; //the ring index of the next sample
+};
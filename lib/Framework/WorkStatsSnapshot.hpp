@@ -0,0 +1,93 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <cstring> //memcpy
+#include <atomic>
+
+/*!
+ * The counters published by a WorkerActor after each work task.
+ * All fields are 64-bit words so the snapshot can copy them as atomics.
+ * Times are nanoseconds, time stamps are high_resolution_clock counts.
+ */
+struct WorkStatsData
+{
+    //! Port counters are kept for at most this many stream ports per direction
+    static const size_t MAX_PORTS = 16;
+
+    unsigned long long numTaskCalls;
+    unsigned long long numWorkCalls;
+    unsigned long long stallPrepare;
+    unsigned long long stallNoTokens;
+    unsigned long long stallMessagesFull;
+    unsigned long long stallNoOutputBuffer;
+    unsigned long long stallReserve;
+    unsigned long long totalTimeTask;
+    unsigned long long totalTimeWork;
+    unsigned long long totalTimePreWork;
+    unsigned long long totalTimePostWork;
+    unsigned long long memoryBytes;
+    unsigned long long numInputs;
+    unsigned long long numOutputs;
+    unsigned long long inputElements[MAX_PORTS];
+    unsigned long long inputBuffers[MAX_PORTS];
+    unsigned long long inputLabels[MAX_PORTS];
+    unsigned long long inputMessages[MAX_PORTS];
+    unsigned long long inputQueueBytes[MAX_PORTS];
+    unsigned long long outputElements[MAX_PORTS];
+    unsigned long long outputBuffers[MAX_PORTS];
+    unsigned long long outputLabels[MAX_PORTS];
+    unsigned long long outputMessages[MAX_PORTS];
+};
+
+/*!
+ * A sequence lock around WorkStatsData.
+ * The single writer (the work thread) never blocks,
+ * and readers retry until they copy a consistent snapshot.
+ * Readers never acquire the actor or stall the work thread.
+ */
+class WorkStatsSnapshot
+{
+public:
+    WorkStatsSnapshot(void):
+        _seq(0)
+    {
+        for (auto &word : _words) word.store(0, std::memory_order_relaxed);
+    }
+
+    //! Publish a new snapshot (single writer only)
+    void publish(const WorkStatsData &data)
+    {
+        unsigned long long words[NUM_WORDS];
+        std::memcpy(words, &data, sizeof(data));
+        const auto seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq+1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < NUM_WORDS; i++) _words[i].store(words[i], std::memory_order_relaxed);
+        _seq.store(seq+2, std::memory_order_release);
+    }
+
+    //! Read the latest consistent snapshot (any thread)
+    WorkStatsData read(void) const
+    {
+        unsigned long long words[NUM_WORDS];
+        while (true)
+        {
+            const auto seq0 = _seq.load(std::memory_order_acquire);
+            if ((seq0 & 1) != 0) continue; //write in progress
+            for (size_t i = 0; i < NUM_WORDS; i++) words[i] = _words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_seq.load(std::memory_order_relaxed) == seq0) break;
+        }
+        WorkStatsData data;
+        std::memcpy(&data, words, sizeof(data));
+        return data;
+    }
+
+private:
+    static const size_t NUM_WORDS = sizeof(WorkStatsData)/sizeof(unsigned long long);
+    static_assert(sizeof(WorkStatsData) % sizeof(unsigned long long) == 0, "WorkStatsData must be 64-bit words");
+    std::atomic<unsigned long long> _seq;
+    std::atomic<unsigned long long> _words[NUM_WORDS];
+};
@@ -2,11 +2,14 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/WorkerActor.hpp"
+#include "Framework/ThreadEnvironment.hpp"
 #include <Pothos/Framework/InputPortImpl.hpp>
 #include <Pothos/Framework/OutputPortImpl.hpp>
 #include <Pothos/Object/Containers.hpp>
+#include <Pothos/System/NumaInfo.hpp>
 #include <Poco/Format.h>
 #include <Poco/Logger.h>
+#include <Poco/Process.h>
 #include <cassert>
 #include <algorithm> //min/max
 #include <json.hpp>
@@ -16,19 +19,142 @@ using json = nlohmann::json;
 //! Helper routine to deal with automatically accumulating time durations
 struct TimeAccumulator
 {
-    inline TimeAccumulator(std::chrono::high_resolution_clock::duration &t):
-        t(t), start(std::chrono::high_resolution_clock::now())
+    inline TimeAccumulator(const Pothos::WorkerActor::StatsLevel level,
+        std::chrono::high_resolution_clock::duration &t, unsigned long long &c,
+        Pothos::Util::LatencyHistogram *hist = nullptr):
+        level(level), t(t), c(c), hist(hist), startCycles(0)
     {
-        return;
+        if (level == Pothos::WorkerActor::STATS_FULL) start = std::chrono::high_resolution_clock::now();
+        else if (level == Pothos::WorkerActor::STATS_CYCLES) startCycles = readCycleCounter();
     }
     inline ~TimeAccumulator(void)
     {
-        t += std::chrono::high_resolution_clock::now() - start;
+        if (level == Pothos::WorkerActor::STATS_FULL)
+        {
+            const auto delta = std::chrono::high_resolution_clock::now() - start;
+            t += delta;
+            if (hist != nullptr) hist->record(std::chrono::duration_cast<std::chrono::nanoseconds>(delta).count());
+        }
+        else if (level == Pothos::WorkerActor::STATS_CYCLES)
+        {
+            const auto delta = readCycleCounter() - startCycles;
+            c += delta;
+            if (hist != nullptr) hist->record((unsigned long long)(delta*cycleCounterPeriod()*1e9));
+        }
     }
+    const Pothos::WorkerActor::StatsLevel level;
     std::chrono::high_resolution_clock::duration &t;
-    const std::chrono::high_resolution_clock::time_point start;
+    unsigned long long &c;
+    Pothos::Util::LatencyHistogram *hist;
+    std::chrono::high_resolution_clock::time_point start;
+    unsigned long long startCycles;
+};
+
+//! Helper routine to accumulate the hardware counter deltas of the calling thread
+struct PerfAccumulator
+{
+    inline PerfAccumulator(const bool enabled, unsigned long long *totals):
+        totals(enabled?totals:nullptr)
+    {
+        if (this->totals == nullptr) return;
+        auto &counters = PerfCounters::current();
+        if (counters.read(start)) return;
+        this->totals = nullptr;
+
+        //log once per thread, the counters are not retried
+        static thread_local bool logged(false);
+        if (logged) return;
+        logged = true;
+        poco_warning(Poco::Logger::get("Pothos.WorkerActor"),
+            "Hardware performance counters unavailable (check perf_event_paranoid)");
+    }
+    inline ~PerfAccumulator(void)
+    {
+        if (totals == nullptr) return;
+        PerfCounters::Values end;
+        if (not PerfCounters::current().read(end)) return;
+        for (size_t i = 0; i < PerfCounters::NUM_EVENTS; i++) totals[i] += end.counts[i] - start.counts[i];
+    }
+    unsigned long long *totals;
+    PerfCounters::Values start;
 };
 
+//! Helper to signal the aggregate notifier once per task with activity
+struct ActivityGuard
+{
+    inline ActivityGuard(Pothos::WorkerActor *actor):
+        actor(actor), start(actor->activityIndicator.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    inline ~ActivityGuard(void)
+    {
+        if (actor->activityIndicator.load(std::memory_order_relaxed) != start) actor->notifyActivity();
+    }
+    Pothos::WorkerActor *actor;
+    const int start;
+};
+
+//! Convert a cycle counter delta into a clock duration
+static std::chrono::high_resolution_clock::duration cyclesToDuration(const unsigned long long cycles)
+{
+    if (cycles == 0) return std::chrono::high_resolution_clock::duration::zero();
+    return std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(
+        std::chrono::duration<double>(cycles*cycleCounterPeriod()));
+}
+
+//! Summarize a latency histogram with percentiles and the non-empty buckets
+static json histogramToJSON(const Pothos::Util::LatencyHistogram &hist)
+{
+    json histObj;
+    histObj["count"] = hist.count();
+    histObj["min"] = hist.min();
+    histObj["max"] = hist.max();
+    histObj["mean"] = (hist.count() == 0)?0.0:double(hist.sum())/hist.count();
+    histObj["p50"] = hist.percentile(50.0);
+    histObj["p90"] = hist.percentile(90.0);
+    histObj["p99"] = hist.percentile(99.0);
+    histObj["p999"] = hist.percentile(99.9);
+
+    //buckets as [lower bound, count] pairs
+    json buckets = json::array();
+    for (size_t i = 0; i < Pothos::Util::LatencyHistogram::NUM_BUCKETS; i++)
+    {
+        const auto count = hist.bucketCount(i);
+        if (count == 0) continue;
+        buckets.push_back(json::array({Pothos::Util::LatencyHistogram::bucketLowerBound(i), count}));
+    }
+    histObj["buckets"] = buckets;
+    return histObj;
+}
+
+/***********************************************************************
+ * stats level
+ **********************************************************************/
+void Pothos::WorkerActor::setStatsLevel(const std::string &level)
+{
+    StatsLevel newLevel;
+    const bool perfEnabled(level == "PERF");
+    if (level == "FULL" or perfEnabled) newLevel = STATS_FULL;
+    else if (level == "CYCLES") newLevel = STATS_CYCLES;
+    else if (level == "NONE") newLevel = STATS_NONE;
+    else throw Pothos::InvalidArgumentException("Pothos::WorkerActor::setStatsLevel("+level+")", "unknown stats level");
+
+    //calibrate the counter here rather than in the work task
+    if (newLevel == STATS_CYCLES) cycleCounterPeriod();
+
+    ActorInterfaceLock lock(this);
+    this->statsLevel = newLevel;
+    this->perfCountersEnabled = perfEnabled;
+}
+
+void Pothos::WorkerActor::setMemoryBudget(const std::string &accountName, const size_t budget)
+{
+    auto account = MemoryAccount::get(accountName);
+    account->setBudget(budget);
+    this->memoryAccount->setParent(account);
+}
+
 /***********************************************************************
  * buffer manager helpers
  **********************************************************************/
@@ -69,14 +195,98 @@ Pothos::BufferManager::Sptr Pothos::WorkerActor::getBufferManager(const std::str
 
 Pothos::BufferManager::Sptr Pothos::WorkerActor::getBufferManagerNoLock(const std::string &name, const std::string &domain, const bool isInput)
 {
+    //the memory of the managers is charged to this block
+    MemoryAccount::Scope memoryScope(this->memoryAccount);
+
     //check the cache for a manager thats still in use
     auto &weakMgr = bufferManagerCache[isInput][name][domain];
     auto m = weakMgr.lock();
 
+    //use the configured output port arguments or the defaults
+    std::string managerName("generic");
+    BufferManagerArgs args;
+    if (not isInput and outputBufferManagerArgs.count(name) != 0)
+    {
+        managerName = outputBufferManagerNames.at(name);
+        args = outputBufferManagerArgs.at(name);
+    }
+
+    //the flow selects the manager type when unconfigured or configured as "auto"
+    const bool autoSelect = not isInput and (outputBufferManagerArgs.count(name) == 0 or managerName == "auto");
+    if (managerName == "auto") managerName = "generic";
+
+    //a fused consumer runs right after the producer, so fewer buffers keep the data in cache
+    const auto countHint = outputBufferCountHints.find(name);
+    if (not isInput and outputBufferManagerArgs.count(name) == 0 and
+        countHint != outputBufferCountHints.end() and countHint->second != 0)
+    {
+        args.numBuffers = countHint->second;
+    }
+
+    //batch processing favors fewer and larger transfers over the latency
+    if (not isInput and outputBufferManagerArgs.count(name) == 0)
+    {
+        args.bufferSize = std::max(args.bufferSize, batchBufferSize);
+    }
+
+    //the auto-tuner replaces the geometry once it has measured the flow
+    const auto tunerIt = outputBufferTuners.find(name);
+    if (not isInput and tunerIt != outputBufferTuners.end()) tunerIt->second.apply(args);
+
+    //place the buffers on the consumer's NUMA node when unspecified
+    if (args.nodeAffinity < 0)
+    {
+        if (isInput) args.nodeAffinity = this->getNodeAffinityHintNoLock();
+        else if (outputNodeAffinityHints.count(name) != 0) args.nodeAffinity = outputNodeAffinityHints.at(name);
+    }
+
+    //Downstream reserves that a generic buffer could fragment are better served by a circular manager:
+    //the accumulator can present the reserve in place rather than copying it into a pool buffer.
+    //A typical producer chunk (the declared rate or else the buffer size) of whole reserves never fragments.
+    //A consumer that writes in place over its input needs buffers of its own, which the circular ring
+    //does not provide since contiguous regions are merged and released in order, so it keeps generic buffers,
+    //and the buffers lent downstream as outputs are made up for with additional buffers.
+    const auto reserveHint = outputReserveHints.find(name);
+    const size_t reserveBytes = (reserveHint != outputReserveHints.end())?reserveHint->second:0;
+    const auto inPlaceHint = outputInPlaceHints.find(name);
+    const bool inPlace = inPlaceHint != outputInPlaceHints.end() and inPlaceHint->second;
+    size_t chunkBytes = args.bufferSize;
+    if (not isInput)
+    {
+        const auto &port = *outputs.at(name);
+        if (port._staticRate != 0) chunkBytes = port._staticRate*port.dtype().size();
+    }
+    const bool reserveFits = reserveBytes != 0 and chunkBytes % reserveBytes == 0;
+    const bool useCircular = autoSelect and managerName == "generic" and
+        reserveBytes != 0 and not reserveFits and not inPlace;
+    if (useCircular)
+    {
+        managerName = "circular";
+        args.bufferSize = std::max(args.bufferSize, reserveBytes);
+    }
+    if (autoSelect and inPlace and outputBufferManagerArgs.count(name) == 0 and tunerIt == outputBufferTuners.end())
+    {
+        args.numBuffers *= 2;
+    }
+
     //try to get the manager and make one if its null
     if (not m) m = isInput? block->getInputBufferManager(name, domain) : block->getOutputBufferManager(name, domain);
-    if (not m) m = BufferManager::make("generic", BufferManagerArgs());
-    else if (not m->isInitialized()) m->init(BufferManagerArgs()); //TODO pass this in from somewhere
+    if (not m and useCircular)
+    {
+        POTHOS_EXCEPTION_TRY
+        {
+            m = BufferManager::make(managerName, args);
+        }
+        POTHOS_EXCEPTION_CATCH(const Exception &ex)
+        {
+            poco_warning_f3(Poco::Logger::get("Pothos.WorkerActor"), "%s[%s] circular buffer unavailable, using generic: %s",
+                block->getName(), name, ex.displayText());
+            managerName = "generic";
+        }
+    }
+    if (not m) m = BufferManager::make(managerName, args);
+    else if (not m->isInitialized()) m->init(args);
+    if (not isInput and tunerIt != outputBufferTuners.end()) tunerIt->second.installed(args);
 
     //store the new buffer manager to the cache
     weakMgr = m;
@@ -89,6 +299,174 @@ void Pothos::WorkerActor::setOutputBufferManager(const std::string &name, const
     outputs.at(name)->bufferManagerSetup(manager);
 }
 
+void Pothos::WorkerActor::setOutputBufferArgs(const std::string &name, const std::string &bufferArgs)
+{
+    ActorInterfaceLock lock(this);
+
+    if (outputs.count(name) == 0) throw PortAccessError("Pothos::WorkerActor::setOutputBufferArgs()",
+        Poco::format("%s has no output port named %s", block->getName(), name));
+
+    //the auto-tuner is configured per port, false removes it
+    auto argsObj = json::parse(bufferArgs);
+    const auto tuneIt = argsObj.find("autoTune");
+    if (tuneIt != argsObj.end())
+    {
+        if (tuneIt->is_boolean() and not tuneIt->get<bool>()) outputBufferTuners.erase(name);
+        else outputBufferTuners[name] = BufferAutoTuner(*tuneIt);
+        argsObj.erase(tuneIt);
+        if (argsObj.empty()) return;
+    }
+
+    //the token depth configures the port rather than the buffer manager
+    if (argsObj.count("tokenDepth") != 0)
+    {
+        outputs.at(name)->setTokenDepth(argsObj["tokenDepth"].get<size_t>());
+        argsObj.erase("tokenDepth");
+        if (argsObj.empty()) return;
+    }
+
+    outputBufferManagerNames[name] = argsObj.value<std::string>("type", "generic");
+    outputBufferManagerArgs[name] = BufferManagerArgs(argsObj.dump());
+
+    //forget cached managers so the next request uses the new arguments
+    bufferManagerCache[false][name].clear();
+}
+
+void Pothos::WorkerActor::setInputLossyDepth(const std::string &name, const size_t numBuffers)
+{
+    ActorInterfaceLock lock(this);
+
+    if (inputs.count(name) == 0) throw PortAccessError("Pothos::WorkerActor::setInputLossyDepth()",
+        Poco::format("%s has no input port named %s", block->getName(), name));
+
+    inputs.at(name)->setLossyDepth(numBuffers);
+}
+
+long Pothos::WorkerActor::getNodeAffinityHint(void)
+{
+    ActorInterfaceLock lock(this);
+    return this->getNodeAffinityHintNoLock();
+}
+
+long Pothos::WorkerActor::getNodeAffinityHintNoLock(void)
+{
+    const auto &threadPool = block->getThreadPool();
+    if (not threadPool) return -1;
+    const auto env = std::static_pointer_cast<ThreadEnvironment>(threadPool.getContainer());
+    const auto &args = env->getArgs();
+
+    //the AUTO affinity planner keeps the threads on one node
+    if (args.affinityMode == "AUTO") return env->getAutoAffinityNode();
+
+    //collect the NUMA nodes that the threads are affinitized to
+    std::set<size_t> nodes;
+    if (args.affinityMode == "NUMA")
+    {
+        nodes.insert(args.affinity.begin(), args.affinity.end());
+    }
+    if (args.affinityMode == "CPU")
+    {
+        for (const auto &info : Pothos::System::NumaInfo::get())
+        {
+            for (const auto &cpu : args.affinity)
+            {
+                if (std::find(info.cpus.begin(), info.cpus.end(), cpu) != info.cpus.end()) nodes.insert(info.nodeNumber);
+            }
+        }
+    }
+
+    //only a single node is a meaningful placement hint
+    if (nodes.size() != 1) return -1;
+    return long(*nodes.begin());
+}
+
+void Pothos::WorkerActor::setOutputNodeAffinityHint(const std::string &name, const long node)
+{
+    ActorInterfaceLock lock(this);
+
+    auto it = outputNodeAffinityHints.find(name);
+    if (it != outputNodeAffinityHints.end() and it->second == node) return;
+    outputNodeAffinityHints[name] = node;
+
+    //forget cached managers so the next request uses the new placement
+    bufferManagerCache[false][name].clear();
+}
+
+size_t Pothos::WorkerActor::getInputReserveBytes(const std::string &name)
+{
+    ActorInterfaceLock lock(this);
+
+    if (inputs.count(name) == 0) throw PortAccessError("Pothos::WorkerActor::getInputReserveBytes()",
+        Poco::format("%s has no input port named %s", block->getName(), name));
+
+    const auto &port = *inputs.at(name);
+    return port._reserveElements*port.dtype().size();
+}
+
+void Pothos::WorkerActor::setOutputReserveHint(const std::string &name, const size_t numBytes)
+{
+    ActorInterfaceLock lock(this);
+
+    auto it = outputReserveHints.find(name);
+    if (it != outputReserveHints.end() and it->second == numBytes) return;
+    outputReserveHints[name] = numBytes;
+
+    //forget cached managers so the next request uses the new manager type
+    bufferManagerCache[false][name].clear();
+}
+
+bool Pothos::WorkerActor::getInputInPlace(const std::string &name)
+{
+    ActorInterfaceLock lock(this);
+
+    if (inputs.count(name) == 0) throw PortAccessError("Pothos::WorkerActor::getInputInPlace()",
+        Poco::format("%s has no input port named %s", block->getName(), name));
+
+    //is the input lent to an output through read-before-write?
+    auto inPort = inputs.at(name).get();
+    for (const auto &pair : outputs)
+    {
+        const auto &ports = pair.second->_readBeforeWritePorts;
+        if (std::find(ports.begin(), ports.end(), inPort) != ports.end()) return true;
+    }
+    return false;
+}
+
+void Pothos::WorkerActor::setOutputInPlaceHint(const std::string &name, const bool inPlace)
+{
+    ActorInterfaceLock lock(this);
+
+    auto it = outputInPlaceHints.find(name);
+    if (it != outputInPlaceHints.end() and it->second == inPlace) return;
+    outputInPlaceHints[name] = inPlace;
+
+    //forget cached managers so the next request uses the new manager type
+    bufferManagerCache[false][name].clear();
+}
+
+void Pothos::WorkerActor::setOutputBufferCountHint(const std::string &name, const size_t numBuffers)
+{
+    ActorInterfaceLock lock(this);
+
+    auto it = outputBufferCountHints.find(name);
+    if (it != outputBufferCountHints.end() and it->second == numBuffers) return;
+    outputBufferCountHints[name] = numBuffers;
+
+    //forget cached managers so the next request uses the new buffer count
+    bufferManagerCache[false][name].clear();
+}
+
+void Pothos::WorkerActor::setBatchBufferSize(const size_t bufferSize)
+{
+    ActorInterfaceLock lock(this);
+
+    if (batchBufferSize == bufferSize) return;
+    batchBufferSize = bufferSize;
+
+    //forget cached managers so the next request uses the new buffer size
+    bufferManagerCache[false].clear();
+}
+
 void Pothos::WorkerActor::ensureOutputBufferManagerNoLock(const std::string &name)
 {
     auto &port = *this->outputs.at(name);
@@ -111,6 +489,50 @@ void Pothos::WorkerActor::ensureOutputBufferManagerNoLock(const std::string &nam
         Poco::format("%s[%s] has no buffer manager set", block->getName(), name));
 }
 
+void Pothos::WorkerActor::tuneOutputBuffers(void)
+{
+    for (auto &pair : outputBufferTuners)
+    {
+        const auto portIt = outputs.find(pair.first);
+        if (portIt == outputs.end()) continue;
+        auto &port = *portIt->second;
+        const auto totalBytes = port.totalElements()*port.dtype().size();
+        if (not pair.second.update(totalBytes, this->numWorkCalls, port._bufferStarvations)) continue;
+
+        //forget the cached managers so the next commit uses the tuned arguments
+        auto &cache = bufferManagerCache[false][pair.first];
+        std::string domain;
+        bool replaceLive(false);
+        for (const auto &entry : cache)
+        {
+            if (entry.second.lock() != port._bufferManager) continue;
+            domain = entry.first;
+            replaceLive = bufferModeCache[false][pair.first][domain] != "CUSTOM";
+        }
+        cache.clear();
+
+        //replace a manager that this actor made, while managers from the block or
+        //a downstream domain keep their geometry until the flow is connected again
+        if (not replaceLive) continue;
+        BufferManager::Sptr mgr;
+        POTHOS_EXCEPTION_TRY
+        {
+            mgr = this->getBufferManagerNoLock(pair.first, domain, false);
+        }
+        POTHOS_EXCEPTION_CATCH(const Exception &ex)
+        {
+            poco_warning_f3(Poco::Logger::get("Pothos.WorkerActor"), "%s[%s] buffer auto-tune failed: %s",
+                block->getName(), pair.first, ex.displayText());
+            continue;
+        }
+        port.bufferManagerSetup(mgr);
+
+        BufferManagerArgs tuned; pair.second.apply(tuned);
+        poco_debug_f4(Poco::Logger::get("Pothos.WorkerActor"), "%s[%s] buffer auto-tune: %z x %z bytes",
+            block->getName(), pair.first, tuned.numBuffers, tuned.bufferSize);
+    }
+}
+
 /***********************************************************************
  * port subscribe/unsubscribe
  **********************************************************************/
@@ -145,6 +567,38 @@ void Pothos::WorkerActor::subscribeInput(const std::string &action, const std::s
     this->updatePorts();
 }
 
+void Pothos::WorkerActor::resubscribeInputs(const std::string &myPortName, const std::vector<Pothos::InputPort *> &removes, const std::vector<Pothos::InputPort *> &adds)
+{
+    ActorInterfaceLock lock(this);
+
+    //validate the whole change before the subscribers list is modified
+    auto &subscribers = this->outputs.at(myPortName)->_subscribers;
+    auto newSubscribers = subscribers;
+    for (auto inputPort : removes)
+    {
+        auto it = std::find(newSubscribers.begin(), newSubscribers.end(), inputPort);
+        if (it == newSubscribers.end()) throw PortAccessError("Pothos::WorkerActor::resubscribeInputs()",
+            Poco::format("input %s subscription missing from output port %s", inputPort->name(), myPortName));
+        newSubscribers.erase(it);
+    }
+    for (auto inputPort : adds)
+    {
+        if (std::find(newSubscribers.begin(), newSubscribers.end(), inputPort) != newSubscribers.end())
+            throw PortAccessError("Pothos::WorkerActor::resubscribeInputs()",
+            Poco::format("input %s subscription exists in output port %s", inputPort->name(), myPortName));
+        newSubscribers.push_back(inputPort);
+    }
+    subscribers.swap(newSubscribers);
+
+    //empty subscribers, don't hold onto the buffer manager so it can be cleaned up
+    if (subscribers.empty()) bufferManagerTmpCache[false][myPortName].reset();
+
+    //when unsubscripted, ensure that we have a local buffer manager
+    if (subscribers.empty()) this->ensureOutputBufferManagerNoLock(myPortName);
+
+    this->updatePorts();
+}
+
 void Pothos::WorkerActor::subscribeOutput(const std::string &action, const std::string &myPortName, Pothos::OutputPort *outputPort)
 {
     ActorInterfaceLock lock(this);
@@ -187,11 +641,17 @@ void Pothos::WorkerActor::setActiveStateOn(void)
         this->ensureOutputBufferManagerNoLock(entry.first);
     }
 
+    //calls queued while inactive apply before activation
+    this->handleAsyncCalls();
+
     POTHOS_EXCEPTION_TRY
     {
+        this->drainStopped = false;
+        this->endOfStream = false;
         this->activeState = true;
         this->block->activate();
         this->activityIndicator.fetch_add(1, std::memory_order_relaxed);
+        this->notifyActivity();
     }
     POTHOS_EXCEPTION_CATCH(const Exception &ex)
     {
@@ -208,23 +668,150 @@ void Pothos::WorkerActor::setActiveStateOff(void)
     if (not this->activeState) return;
 
     this->activeState = false;
+    for (auto &pair : this->inputs) pair.second->_buffer.clear();
     this->block->deactivate();
     this->activityIndicator.fetch_add(1, std::memory_order_relaxed);
+    this->notifyActivity();
 }
 
 /***********************************************************************
  * work task dispatcher
  **********************************************************************/
+/***********************************************************************
+ * Topology drain
+ **********************************************************************/
+void Pothos::WorkerActor::setDrainStopped(const bool stopped)
+{
+    this->drainStopped = stopped;
+    this->flagExternalChange();
+}
+
+void Pothos::WorkerActor::setEndOfStream(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->drainMutex);
+        this->endOfStream = true;
+    }
+    this->drainCond.notify_all();
+}
+
+bool Pothos::WorkerActor::waitEndOfStream(const double timeout)
+{
+    const auto done = [this](void){return this->endOfStream.load();};
+    std::unique_lock<std::mutex> lock(this->drainMutex);
+    if (timeout <= 0.0)
+    {
+        this->drainCond.wait(lock, done);
+        return true;
+    }
+    return this->drainCond.wait_for(lock, std::chrono::nanoseconds((long long)(timeout*1e9)), done);
+}
+
+bool Pothos::WorkerActor::inputQueuesEmpty(void)
+{
+    for (const auto &pair : this->inputs)
+    {
+        auto &port = *pair.second;
+        if (not port.asyncMessagesEmpty() or not port.slotCallsEmpty()) return false;
+        std::lock_guard<Util::SpinLock> lock(port._bufferAccumulatorLock);
+        const auto handoff = port._bufferHandoff.load(std::memory_order_acquire);
+        if ((handoff != nullptr and not handoff->empty()) or not port._inputInlineMessages.empty() or not port._inlineMessages.empty()) return false;
+        if (port._bufferAccumulator.getTotalBytesAvailable() != 0) return false;
+    }
+    return true;
+}
+
+void Pothos::WorkerActor::notifyDrainWaiters(void)
+{
+    //an inactive block holds no data, its inputs were cleared
+    const bool idle = not this->activeState or (not this->drainRetask and this->inputQueuesEmpty());
+    unsigned long long outputMessages(0);
+    for (auto *port : this->streamOutputs) outputMessages += port->totalMessages();
+    {
+        std::lock_guard<std::mutex> lock(this->drainMutex);
+        this->drainTaskCount++;
+        this->drainLastIdle = idle;
+        this->drainOutputBytes = this->totalOutputBytes;
+        this->drainOutputMessages = outputMessages;
+    }
+    this->drainCond.notify_all();
+}
+
+bool Pothos::WorkerActor::waitDrained(const double timeout, const unsigned long long minOutputBytes, const unsigned long long minOutputMessages)
+{
+    const auto exitTime = std::chrono::steady_clock::now() + ((timeout > 0.0)?
+        std::chrono::nanoseconds((long long)(timeout*1e9)):
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::hours(24*365))); //forever
+    const auto drained = [&](void)
+    {
+        return drainLastIdle and drainOutputBytes >= minOutputBytes and drainOutputMessages >= minOutputMessages;
+    };
+
+    std::unique_lock<std::mutex> lock(this->drainMutex);
+    this->drainWaiters++;
+    bool result = false;
+    bool force = true;
+    while (true)
+    {
+        //force a task to check the current state, otherwise wait on the next task,
+        //which follows new input, and force another one when none runs shortly
+        const auto start = this->drainTaskCount;
+        if (force)
+        {
+            lock.unlock();
+            this->flagExternalChange();
+            lock.lock();
+        }
+        const auto waitTime = force?exitTime:std::min(exitTime, std::chrono::steady_clock::now()+std::chrono::milliseconds(1));
+        const bool ran = this->drainCond.wait_until(lock, waitTime, [&](void){return this->drainTaskCount != start;});
+        if (ran and drained())
+        {
+            result = true;
+            break;
+        }
+        if (std::chrono::steady_clock::now() >= exitTime) break;
+        force = not ran;
+    }
+    this->drainWaiters--;
+    return result;
+}
+
+unsigned long long Pothos::WorkerActor::getInputBytesConsumed(void)
+{
+    ActorInterfaceLock lock(this);
+    unsigned long long total(0);
+    for (auto *port : this->streamInputs) total += port->_totalBytesPopped;
+    return total;
+}
+
+unsigned long long Pothos::WorkerActor::getInputMessagesConsumed(void)
+{
+    ActorInterfaceLock lock(this);
+    unsigned long long total(0);
+    for (auto *port : this->streamInputs) total += port->totalMessages();
+    return total;
+}
+
 void Pothos::WorkerActor::workTask(void)
 {
+    this->handleAsyncCalls();
     if (not activeState) return;
-    if (not block->prepare()) return;
+    if (drainStopped.load(std::memory_order_relaxed)) return;
+    if (endOfStream.load(std::memory_order_relaxed)) return;
+    if (not block->prepare())
+    {
+        this->drainRetask = true;
+        this->recordStall(STALL_PREPARE);
+        return;
+    }
     this->numTaskCalls++;
-    TimeAccumulator taskTime(this->totalTimeTask);
+    ActivityGuard activityGuard(this);
+    const auto level = this->statsLevel.load(std::memory_order_relaxed);
+    TimeAccumulator taskTime(level, this->totalTimeTask, this->cyclesTask);
 
     //prework
     {
-        TimeAccumulator preWorkTime(this->totalTimePreWork);
+        TimeAccumulator preWorkTime(level, this->totalTimePreWork, this->cyclesPreWork);
         if (not this->preWorkTasks()) return;
     }
 
@@ -232,21 +819,76 @@ void Pothos::WorkerActor::workTask(void)
     POTHOS_EXCEPTION_TRY
     {
         this->numWorkCalls++;
-        TimeAccumulator workTime(this->totalTimeWork);
+        PerfAccumulator workPerf(this->perfCountersEnabled.load(std::memory_order_relaxed), this->perfWork);
+        TimeAccumulator workTime(level, this->totalTimeWork, this->cyclesWork, &this->workHistogram);
         block->work();
     }
     POTHOS_EXCEPTION_CATCH(const Exception &ex)
     {
-        poco_error_f2(Poco::Logger::get("Pothos.Block.work"), "%s: %s", block->getName(), ex.displayText());
+        static auto &logger = Poco::Logger::get("Pothos.Block.work");
+        std::string note;
+        if (this->logLimiter.allow("work:"+ex.displayText(), note))
+        {
+            poco_error_f3(logger, "%s: %s%s", block->getName(), ex.displayText(), note);
+        }
     }
 
     //postwork
     {
-        TimeAccumulator preWorkTime(this->totalTimePostWork);
+        TimeAccumulator postWorkTime(level, this->totalTimePostWork, this->cyclesPostWork);
         this->postWorkTasks();
     }
+    this->workArena.reset();
+    if (not this->outputBufferTuners.empty()) this->tuneOutputBuffers();
+
+    this->markTime(this->timeLastWork, this->cycleLastWork);
+    this->publishStatsSnapshot();
+}
+
+void Pothos::WorkerActor::publishStatsSnapshot(void)
+{
+    auto ns = [](const std::chrono::high_resolution_clock::duration &d)
+    {
+        return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    };
+
+    WorkStatsData data;
+    data.numTaskCalls = this->numTaskCalls;
+    data.numWorkCalls = this->numWorkCalls;
+    data.stallPrepare = this->numStalls[STALL_PREPARE];
+    data.stallNoTokens = this->numStalls[STALL_NO_TOKENS];
+    data.stallMessagesFull = this->numStalls[STALL_MESSAGES_FULL];
+    data.stallNoOutputBuffer = this->numStalls[STALL_NO_OUTPUT_BUFFER];
+    data.stallReserve = this->numStalls[STALL_RESERVE];
+    data.totalTimeTask = ns(this->totalTimeTask + cyclesToDuration(this->cyclesTask));
+    data.totalTimeWork = ns(this->totalTimeWork + cyclesToDuration(this->cyclesWork));
+    data.totalTimePreWork = ns(this->totalTimePreWork + cyclesToDuration(this->cyclesPreWork));
+    data.totalTimePostWork = ns(this->totalTimePostWork + cyclesToDuration(this->cyclesPostWork));
+    data.memoryBytes = this->memoryAccount->bytes();
+
+    data.numInputs = std::min<size_t>(this->streamInputs.size(), WorkStatsData::MAX_PORTS);
+    for (size_t i = 0; i < data.numInputs; i++)
+    {
+        auto &port = *this->streamInputs[i];
+        data.inputElements[i] = port.totalElements();
+        data.inputBuffers[i] = port.totalBuffers();
+        data.inputLabels[i] = port.totalLabels();
+        data.inputMessages[i] = port.totalMessages();
+        std::lock_guard<Util::SpinLock> lock(port._bufferAccumulatorLock);
+        data.inputQueueBytes[i] = port._bufferAccumulator.getTotalBytesAvailable();
+    }
+
+    data.numOutputs = std::min<size_t>(this->streamOutputs.size(), WorkStatsData::MAX_PORTS);
+    for (size_t i = 0; i < data.numOutputs; i++)
+    {
+        auto &port = *this->streamOutputs[i];
+        data.outputElements[i] = port.totalElements();
+        data.outputBuffers[i] = port.totalBuffers();
+        data.outputLabels[i] = port.totalLabels();
+        data.outputMessages[i] = port.totalMessages();
+    }
 
-    this->timeLastWork = std::chrono::high_resolution_clock::now();
+    this->statsSnapshot->publish(data);
 }
 
 /***********************************************************************
@@ -279,14 +921,78 @@ void Pothos::WorkerActor::handleSlotCalls(InputPort &port)
         }
         POTHOS_EXCEPTION_CATCH(const Exception &ex)
         {
-            poco_error_f3(Poco::Logger::get("Pothos.Block.callSlot"), "%s[%s]: %s", block->getName(), port.alias(), ex.displayText());
+            static auto &logger = Poco::Logger::get("Pothos.Block.callSlot");
+            std::string note;
+            if (this->logLimiter.allow("callSlot:"+port.name()+":"+ex.displayText(), note))
+            {
+                poco_error_f4(logger, "%s[%s]: %s%s", block->getName(), port.alias(), ex.displayText(), note);
+            }
         }
     }
 }
 
+/***********************************************************************
+ * asynchronous calls
+ **********************************************************************/
+void Pothos::WorkerActor::asyncCallsPush(const std::string &name, ObjectVector &&args, const bool coalesce)
+{
+    {
+        std::lock_guard<Util::SpinLock> lock(asyncCallsLock);
+        auto it = asyncCalls.end();
+        if (coalesce) it = std::find_if(asyncCalls.begin(), asyncCalls.end(),
+            [&name](const AsyncCall &call){return call.name == name;});
+
+        //a coalesced call keeps its place in the queue with the latest arguments
+        if (it != asyncCalls.end()) it->args = std::move(args);
+        else asyncCalls.push_back(AsyncCall{name, std::move(args)});
+    }
+    this->flagExternalChange();
+}
+
+void Pothos::WorkerActor::handleAsyncCalls(void)
+{
+    //take the queue at once, calls pushed from within a call run on the next task
+    std::deque<AsyncCall> calls;
+    {
+        std::lock_guard<Util::SpinLock> lock(asyncCallsLock);
+        if (asyncCalls.empty()) return;
+        calls.swap(asyncCalls);
+    }
+
+    for (const auto &call : calls)
+    {
+        POTHOS_EXCEPTION_TRY
+        {
+            block->opaqueCallHandler(call.name, call.args.data(), call.args.size());
+        }
+        POTHOS_EXCEPTION_CATCH(const Exception &ex)
+        {
+            static auto &logger = Poco::Logger::get("Pothos.Block.asyncCall");
+            std::string note;
+            if (this->logLimiter.allow("asyncCall:"+call.name+":"+ex.displayText(), note))
+            {
+                poco_error_f4(logger, "%s.%s(): %s%s", block->getName(), call.name, ex.displayText(), note);
+            }
+        }
+    }
+
+    //the calls may change the state of the block, so call work() again
+    this->flagInternalChange();
+    this->activityIndicator.fetch_add(1, std::memory_order_relaxed);
+}
+
 /***********************************************************************
  * pre-work
  **********************************************************************/
+bool Pothos::WorkerActor::subscriberMessagesFull(OutputPort &port)
+{
+    for (auto *subscriber : port._subscribers)
+    {
+        if (subscriber->messageQueuesFull()) return true;
+    }
+    return false;
+}
+
 bool Pothos::WorkerActor::preWorkTasks(void)
 {
     const size_t BIG = (1 << 30);
@@ -294,30 +1000,54 @@ bool Pothos::WorkerActor::preWorkTasks(void)
     //////////////// output state calculation ///////////////////
     block->_workInfo.minOutElements = BIG;
     block->_workInfo.minAllOutElements = BIG;
-    for (const auto &entry : this->outputs)
-    {
-        auto &port = *entry.second;
-        port._workEvents = 0;
 
-        //an empty token manager means that upstream blocks
-        //hold all of our message resources, we can't continue
-        if (port.tokenManagerEmpty()) return false;
+    //an empty token manager means that upstream blocks
+    //hold all of our message resources, we can't continue
+    //and a full downstream message queue holds back the producer
+    for (auto *port : this->signalOutputs)
+    {
+        port->_workEvents = 0;
+        if (not port->_packetPool.empty()) port->packetPoolRelease();
+        if (port->tokenManagerEmpty())
+        {
+            port->_tokenStarvations++;
+            return this->recordStall(STALL_NO_TOKENS);
+        }
+        if (this->subscriberMessagesFull(*port)) return this->recordStall(STALL_MESSAGES_FULL);
+    }
 
-        //signal ports don't use buffers, skip the code below
-        if (port.isSignal()) continue;
+    for (auto *portPtr : this->streamOutputs)
+    {
+        auto &port = *portPtr;
+        port._workEvents = 0;
+        if (not port._packetPool.empty()) port.packetPoolRelease();
+        if (port.tokenManagerEmpty())
+        {
+            port._tokenStarvations++;
+            return this->recordStall(STALL_NO_TOKENS);
+        }
+        if (port._totalMessages != 0 and this->subscriberMessagesFull(port)) return this->recordStall(STALL_MESSAGES_FULL);
 
         //is it ok to use the read-before-write optimization?
-        const auto tryRBW = port._readBeforeWritePort != nullptr and
-        port.dtype().size() == port._readBeforeWritePort->dtype().size();
-        if (tryRBW)
+        //an input buffer lent to another output has a higher use count
+        bool useRBW = false;
+        for (auto *inPort : port._readBeforeWritePorts)
         {
-            port._readBeforeWritePort->_buffer.clear();
-            port._readBeforeWritePort->bufferAccumulatorFront(port._buffer);
+            const size_t inSize = inPort->dtype().size();
+            if (port.dtype().size() > inSize) continue;
+            inPort->_buffer.clear();
+            inPort->bufferAccumulatorFront(port._buffer);
+            if (port._buffer.useCount() != 2) continue; //2 -> accumulator + this port
+            if (port._buffer.getEnd() > port._buffer.getBuffer().getEnd()) continue; //amalgamation
+
+            //one output element per input element, so a write never passes a read
+            port._buffer.length = (port._buffer.length/inSize)*port.dtype().size();
+            useRBW = port._buffer.length != 0;
+            if (useRBW) break;
         }
 
         //now determine the buffer provided to this port
-        if (tryRBW and port._buffer.useCount() == 2 and //2 -> accumulator + this port
-            port._buffer.getEnd() <= port._buffer.getBuffer().getEnd()) //no amalgamation
+        if (useRBW)
         {
             port._bufferFromManager = false;
         }
@@ -333,7 +1063,11 @@ bool Pothos::WorkerActor::preWorkTasks(void)
         }
         port._buffer.dtype = port.dtype(); //always copy from port's dtype setting
         port._elements = port._buffer.elements();
-        if (port._elements == 0) return false;
+        if (port._elements == 0)
+        {
+            port._bufferStarvations++;
+            return this->recordStall(STALL_NO_OUTPUT_BUFFER);
+        }
         port._pendingElements = 0;
         if (port.index() != -1)
         {
@@ -345,28 +1079,29 @@ bool Pothos::WorkerActor::preWorkTasks(void)
     }
 
     //////////////// input state calculation ///////////////////
-    bool hasBufferedPorts = false;
+    for (auto *port : this->slotInputs)
+    {
+        port->_workEvents = 0;
+        this->handleSlotCalls(*port);
+    }
+
+    const bool hasBufferedPorts = not this->streamInputs.empty();
     bool reserveReached = false;
     bool hasInputMessage = false;
     block->_workInfo.minInElements = BIG;
     block->_workInfo.minAllInElements = BIG;
-    for (const auto &entry : this->inputs)
+    for (auto *portPtr : this->streamInputs)
     {
-        auto &port = *entry.second;
+        auto &port = *portPtr;
         port._workEvents = 0;
-        if (port.isSlot())
-        {
-            this->handleSlotCalls(port);
-            continue;
-        }
-        hasBufferedPorts = true;
 
         //perform minimum reserve accumulator require to recover from possible element fragmentation
         const size_t requireElems = std::max<size_t>(1, port._reserveElements);
         port.bufferAccumulatorRequire(requireElems*port.dtype().size());
         port.bufferAccumulatorFront(port._buffer);
         port._elements = port._buffer.length/port.dtype().size();
-        if (port._elements >= port._reserveElements) reserveReached = true;
+        if (port._elements >= port._reserveElements and
+            (port._minBatchElements == 0 or this->inputBatchReady(port))) reserveReached = true;
         if (not port.asyncMessagesEmpty()) hasInputMessage = true;
         port._pendingElements = 0;
         port._labelIter = port._inlineMessages;
@@ -390,31 +1125,134 @@ bool Pothos::WorkerActor::preWorkTasks(void)
     //1) at least one reserve was met,
     //2) or a port has an input message,
     //3) or there are buffered input ports
-    return reserveReached or hasInputMessage or (not hasBufferedPorts);
+    if (reserveReached or hasInputMessage or (not hasBufferedPorts)) return true;
+    return this->recordStall(STALL_RESERVE);
+}
+
+bool Pothos::WorkerActor::inputBatchReady(InputPort &port)
+{
+    //a released batch stays ready until work() consumed it
+    if (port._totalElements < port._batchReleaseEnd) return true;
+
+    size_t available(0);
+    {
+        std::lock_guard<Util::SpinLock> lock(port._bufferAccumulatorLock);
+        port.bufferHandoffDrainNoLock();
+        available = port._bufferAccumulator.getTotalBytesAvailable()/port.dtype().size();
+    }
+    if (available >= port._minBatchElements or available == 0)
+    {
+        port._batchPending = false;
+        port._batchReleaseEnd = port._totalElements + available;
+        return available != 0;
+    }
+
+    //the deadline starts when the held elements are first seen
+    const auto now = std::chrono::steady_clock::now();
+    if (not port._batchPending)
+    {
+        port._batchPending = true;
+        port._batchDeadline = now + port._batchLatency;
+    }
+    if (port._batchLatency.count() != 0 and now >= port._batchDeadline)
+    {
+        port._batchPending = false;
+        port._batchReleaseEnd = port._totalElements + available;
+        return true;
+    }
+
+    //wake up for the deadline, new buffers wake the block as usual
+    if (port._batchLatency.count() != 0) block->scheduleWakeup(port._batchDeadline);
+    return false;
 }
 
 /***********************************************************************
  * post-work
  **********************************************************************/
+void Pothos::WorkerActor::postLabelsAndBuffers(OutputPort &port)
+{
+    //sort the posted labels in case the user posted out of order
+    auto &postedLabels = port._postedLabels;
+    auto &postedBuffers = port._postedBuffers;
+    if (postedLabels.empty() and postedBuffers.empty()) return;
+    if (not postedLabels.empty()) std::sort(postedLabels.begin(), postedLabels.end());
+    for (size_t i = 0; i < postedBuffers.size(); i++) this->totalOutputBytes += postedBuffers[i].length;
+
+    //share the posted buffers with every subscriber but the last in one pass,
+    //each buffer reference count is bumped once for all of the copies
+    const auto &subscribers = port._subscribers;
+    const size_t numShared = subscribers.empty()?0:(subscribers.size()-1);
+    if (numShared != 0 and not postedBuffers.empty())
+    {
+        auto &fanout = port._fanoutBuffers;
+        auto &copies = port._fanoutCopies;
+        if (fanout.size() < numShared) fanout.resize(numShared);
+        copies.resize(numShared);
+        for (size_t i = 0; i < postedBuffers.size(); i++)
+        {
+            postedBuffers[i].shareInto(copies.data(), numShared);
+            for (size_t j = 0; j < numShared; j++)
+            {
+                if (fanout[j].full()) fanout[j].set_capacity(std::max<size_t>(4, fanout[j].capacity()*2));
+                fanout[j].push_back(std::move(copies[j]));
+            }
+        }
+    }
+
+    //send the outgoing labels with buffers, the last subscriber takes the originals
+    for (size_t j = 0; j < subscribers.size(); j++)
+    {
+        const bool last = (j == numShared);
+        if (last) subscribers[j]->bufferLabelPush(true, postedLabels, postedBuffers);
+        else subscribers[j]->bufferLabelPush(false, postedLabels, port._fanoutBuffers[j]);
+    }
+
+    //wake each subscribing actor once after the entire batch is published
+    for (size_t j = 0; j < subscribers.size(); j++)
+    {
+        auto actor = subscribers[j]->_actor;
+        bool seen = false;
+        for (size_t k = 0; k < j and not seen; k++) seen = (subscribers[k]->_actor == actor);
+        if (not seen) actor->flagExternalChange();
+    }
+
+    //clear posted labels with buffers
+    postedLabels.clear();
+    postedBuffers.clear();
+}
+
 void Pothos::WorkerActor::postWorkTasks(void)
 {
+    //buffers released by this thread return to their producers in one batch
+    OutputPort::bufferManagerReturnsBegin();
+
     ///////////////////// input handling ////////////////////////
 
     size_t inputWorkEvents = 0;
 
-    for (const auto &entry : this->inputs)
+    for (auto *port : this->slotInputs)
     {
-        auto &port = *entry.second;
+        inputWorkEvents += port->_workEvents;
+    }
+
+    for (auto *portPtr : this->streamInputs)
+    {
+        auto &port = *portPtr;
         const size_t bytes = port._pendingElements*port.dtype().size();
 
         //propagate labels and delete old
+        //labels are sorted, so the consumed labels are at the front
         size_t numLabels = 0;
         auto &allLabels = port._inlineMessages;
-        for (size_t i = 0; i < allLabels.size(); i++)
+        if (port._pendingElements != 0)
         {
-            if (allLabels[i].index < port._pendingElements) numLabels++;
+            while (numLabels < allLabels.size() and allLabels[numLabels].index < port._pendingElements) numLabels++;
+
             //adjust labels index for new relative position
-            else allLabels[i].index -= port._pendingElements;
+            for (size_t i = numLabels; i < allLabels.size(); i++)
+            {
+                allLabels[i].index -= port._pendingElements;
+            }
         }
 
         if (numLabels != 0)
@@ -426,7 +1264,12 @@ void Pothos::WorkerActor::postWorkTasks(void)
             }
             POTHOS_EXCEPTION_CATCH(const Exception &ex)
             {
-                poco_error_f2(Poco::Logger::get("Pothos.Block.propagateLabels"), "%s: %s", block->getName(), ex.displayText());
+                static auto &logger = Poco::Logger::get("Pothos.Block.propagateLabels");
+                std::string note;
+                if (this->logLimiter.allow("propagateLabels:"+ex.displayText(), note))
+                {
+                    poco_error_f3(logger, "%s: %s%s", block->getName(), ex.displayText(), note);
+                }
             }
 
             allLabels.erase(allLabels.begin(), allLabels.begin()+numLabels);
@@ -438,7 +1281,11 @@ void Pothos::WorkerActor::postWorkTasks(void)
         {
             port.bufferAccumulatorPop(bytes);
         }
-        port._buffer.clear(); //clear reference
+
+        //clear the reference once the buffer is consumed,
+        //otherwise the accumulator still holds the remainder of this buffer,
+        //and keeping the reference makes the next front assignment free
+        if (bytes >= port._buffer.length) port._buffer.clear();
 
         //move consumed elements into total
         port._totalElements += port._pendingElements;
@@ -450,7 +1297,7 @@ void Pothos::WorkerActor::postWorkTasks(void)
     {
         this->flagInternalChange();
         this->activityIndicator.fetch_add(1, std::memory_order_relaxed);
-        this->timeLastConsumed = std::chrono::high_resolution_clock::now();
+        this->markTime(this->timeLastConsumed, this->cycleLastConsumed);
     }
 
     ///////////////////// output handling ////////////////////////
@@ -458,22 +1305,35 @@ void Pothos::WorkerActor::postWorkTasks(void)
 
     size_t outputWorkEvents = 0;
 
-    for (const auto &entry : this->outputs)
+    for (auto *port : this->signalOutputs)
     {
-        auto &port = *entry.second;
+        this->postLabelsAndBuffers(*port);
+        outputWorkEvents += port->_workEvents;
+    }
+
+    for (auto *portPtr : this->streamOutputs)
+    {
+        auto &port = *portPtr;
 
         //set the buffer length, send it, pop from manager, clear reference
         const size_t pendingBytes = port._pendingElements*port.buffer().dtype.size();
         if (pendingBytes != 0)
         {
             auto &buffer = port._buffer;
+            //the front buffer of a manager may be shorter than its managed buffer (circular ring)
+            const size_t availableBytes = std::min(buffer.length, buffer.getBuffer().getLength());
             buffer.length = pendingBytes;
             if (port._bufferFromManager)
             {
-                if (buffer.length > buffer.getBuffer().getLength())
+                if (buffer.length > availableBytes)
                 {
-                    poco_error_f4(Poco::Logger::get("Pothos.Block.produce"), "%s[%s] overproduced %z bytes, %z available",
-                        block->getName(), port.alias(), buffer.length, buffer.getBuffer().getLength());
+                    static auto &logger = Poco::Logger::get("Pothos.Block.produce");
+                    std::string note;
+                    if (this->logLimiter.allow("produce:"+port.name(), note))
+                    {
+                        poco_error(logger, Poco::format("%s[%s] overproduced %z bytes, %z available",
+                            block->getName(), port.alias(), buffer.length, availableBytes) + note);
+                    }
                 }
 
                 //Some buffer managers may reuse the remainder of the buffer based on how much is left.
@@ -505,25 +1365,7 @@ void Pothos::WorkerActor::postWorkTasks(void)
         }
 
         port._buffer.clear(); //clear reference
-
-        //sort the posted labels in case the user posted out of order
-        auto &postedLabels = port._postedLabels;
-        auto &postedBuffers = port._postedBuffers;
-        if (not postedLabels.empty()) std::sort(postedLabels.begin(), postedLabels.end());
-
-        //send the outgoing labels with buffers
-        if (not postedLabels.empty() or not postedBuffers.empty())
-        {
-            for (const auto &subscriber : port._subscribers)
-            {
-                const bool last = (&subscriber == &port._subscribers.back());
-                subscriber->bufferLabelPush(last, postedLabels, postedBuffers);
-            }
-        }
-
-        //clear posted labels with buffers
-        postedLabels.clear();
-        postedBuffers.clear();
+        this->postLabelsAndBuffers(port);
 
         //add produced bytes into total
         outputWorkEvents += port._workEvents;
@@ -534,8 +1376,10 @@ void Pothos::WorkerActor::postWorkTasks(void)
     {
         this->flagInternalChange();
         this->activityIndicator.fetch_add(1, std::memory_order_relaxed);
-        this->timeLastProduced = std::chrono::high_resolution_clock::now();
+        this->markTime(this->timeLastProduced, this->cycleLastProduced);
     }
+
+    OutputPort::bufferManagerReturnsEnd();
 }
 
 std::string Pothos::WorkerActor::queryWorkStats(void)
@@ -547,14 +1391,55 @@ std::string Pothos::WorkerActor::queryWorkStats(void)
     stats["blockName"] = block->getName();
     stats["numTaskCalls"] = this->numTaskCalls;
     stats["numWorkCalls"] = this->numWorkCalls;
-    stats["totalTimeTask"] = this->totalTimeTask.count();
-    stats["totalTimeWork"] = this->totalTimeWork.count();
-    stats["totalTimePreWork"] = this->totalTimePreWork.count();
-    stats["totalTimePostWork"] = this->totalTimePostWork.count();
-    stats["timeLastConsumed"] = this->timeLastConsumed.time_since_epoch().count();
-    stats["timeLastProduced"] = this->timeLastProduced.time_since_epoch().count();
-    stats["timeLastWork"] = this->timeLastWork.time_since_epoch().count();
-    stats["timeStatsQuery"] = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+
+    //the number of tasks that returned without calling work() per reason
+    stats["stallPrepare"] = this->numStalls[STALL_PREPARE];
+    stats["stallNoTokens"] = this->numStalls[STALL_NO_TOKENS];
+    stats["stallMessagesFull"] = this->numStalls[STALL_MESSAGES_FULL];
+    stats["stallNoOutputBuffer"] = this->numStalls[STALL_NO_OUTPUT_BUFFER];
+    stats["stallReserve"] = this->numStalls[STALL_RESERVE];
+
+    //totals include any time accumulated with the cycle counter
+    stats["totalTimeTask"] = (this->totalTimeTask + cyclesToDuration(this->cyclesTask)).count();
+    stats["totalTimeWork"] = (this->totalTimeWork + cyclesToDuration(this->cyclesWork)).count();
+    stats["totalTimePreWork"] = (this->totalTimePreWork + cyclesToDuration(this->cyclesPreWork)).count();
+    stats["totalTimePostWork"] = (this->totalTimePostWork + cyclesToDuration(this->cyclesPostWork)).count();
+
+    //cycle stamps are converted relative to the current time
+    const auto timeNow = std::chrono::high_resolution_clock::now();
+    const auto cycleNow = readCycleCounter();
+    auto lastTime = [&](const std::chrono::high_resolution_clock::time_point &t, const unsigned long long c)
+    {
+        if (c == 0) return t.time_since_epoch().count();
+        return std::max(t, timeNow - cyclesToDuration(cycleNow - c)).time_since_epoch().count();
+    };
+    stats["timeLastConsumed"] = lastTime(this->timeLastConsumed, this->cycleLastConsumed);
+    stats["timeLastProduced"] = lastTime(this->timeLastProduced, this->cycleLastProduced);
+    stats["timeLastWork"] = lastTime(this->timeLastWork, this->cycleLastWork);
+    stats["timeStatsQuery"] = timeNow.time_since_epoch().count();
+    stats["statsLevel"] = perfCountersEnabled?"PERF":(statsLevel == STATS_FULL)?"FULL":((statsLevel == STATS_CYCLES)?"CYCLES":"NONE");
+    stats["workHistogram"] = histogramToJSON(this->workHistogram);
+
+    //hardware counters around work(), zero unless the "PERF" level has counters
+    stats["workCycles"] = this->perfWork[PerfCounters::CYCLES];
+    stats["workInstructions"] = this->perfWork[PerfCounters::INSTRUCTIONS];
+    stats["workLLCMisses"] = this->perfWork[PerfCounters::LLC_MISSES];
+    stats["workBranchMisses"] = this->perfWork[PerfCounters::BRANCH_MISSES];
+
+    //values published by the block, read without the thread context
+    if (not this->publishedValues.indexes().empty())
+    {
+        const auto values = this->publishedValues.read();
+        json published;
+        for (const auto &pair : this->publishedValues.indexes()) published[pair.first] = values[pair.second];
+        stats["publishedValues"] = published;
+    }
+
+    //scheduler overhead of the thread pool that executes the block
+    if (block->getThreadPool()) stats["threadPool"] = json::parse(block->getThreadPool().queryStats());
+
+    //shared buffers allocated by the block and its buffer managers
+    stats["memory"] = json::parse(this->memoryAccount->toJSON());
 
     //resolution period ratio tells the consumer how to interpret the tick counts
     stats["tickRatioNum"] = std::chrono::high_resolution_clock::period::num;
@@ -562,10 +1447,9 @@ std::string Pothos::WorkerActor::queryWorkStats(void)
 
     //load the input port stats
     json inputStats;
-    for (const auto &name : block->inputPortNames())
+    for (auto *portPtr : this->streamInputs)
     {
-        auto &port = *this->inputs.at(name);
-        if (port.isSlot()) continue;
+        auto &port = *portPtr;
         json portStats;
         portStats["totalElements"] = port.totalElements();
         portStats["totalBuffers"] = port.totalBuffers();
@@ -573,9 +1457,12 @@ std::string Pothos::WorkerActor::queryWorkStats(void)
         portStats["totalMessages"] = port.totalMessages();
         portStats["dtypeSize"] = port.dtype().size();
         portStats["dtypeMarkup"] = port.dtype().toMarkup();
-        portStats["portName"] = name;
+        portStats["portName"] = port.name();
         portStats["portAlias"] = port.alias();
         portStats["reserveElements"] = port._reserveElements;
+        portStats["minBatchElements"] = port._minBatchElements;
+        static const Pothos::Util::LatencyHistogram emptyHistogram;
+        portStats["residencyHistogram"] = histogramToJSON(port._residencyHistogram?*port._residencyHistogram:emptyHistogram);
         {
             BufferChunk frontBuff; port.bufferAccumulatorFront(frontBuff);
             portStats["frontBytes"] = frontBuff.length;
@@ -585,6 +1472,13 @@ std::string Pothos::WorkerActor::queryWorkStats(void)
             portStats["enqueuedBytes"] = port._bufferAccumulator.getTotalBytesAvailable();
             portStats["enqueuedBuffers"] = port._bufferAccumulator.getUniqueManagedBufferCount();
             portStats["enqueuedLabels"] = port._inlineMessages.size()+port._inputInlineMessages.size();
+            portStats["totalBytesCopied"] = port._bufferAccumulator.getTotalBytesCopied();
+            portStats["totalPoolAllocations"] = port._bufferAccumulator.getTotalPoolAllocations();
+            portStats["pooledBytes"] = port._bufferAccumulator.getPooledBytes();
+            portStats["queueHighWaterMark"] = port._bufferAccumulator.getQueueHighWaterMark();
+            portStats["totalQueueResizes"] = port._bufferAccumulator.getTotalQueueResizes();
+            portStats["lossyDepth"] = port._lossyDepth.load();
+            portStats["totalBytesDropped"] = port._totalBytesDropped;
         }
         {
             std::lock_guard<Util::SpinLock> lockM(port._asyncMessagesLock);
@@ -596,10 +1490,9 @@ std::string Pothos::WorkerActor::queryWorkStats(void)
 
     //load the output port stats
     json outputStats;
-    for (const auto &name : block->outputPortNames())
+    for (auto *portPtr : this->streamOutputs)
     {
-        auto &port = *this->outputs.at(name);
-        if (port.isSignal()) continue;
+        auto &port = *portPtr;
         json portStats;
         portStats["totalElements"] = port.totalElements();
         portStats["totalBuffers"] = port.totalBuffers();
@@ -607,13 +1500,19 @@ std::string Pothos::WorkerActor::queryWorkStats(void)
         portStats["totalMessages"] = port.totalMessages();
         portStats["dtypeSize"] = port.dtype().size();
         portStats["dtypeMarkup"] = port.dtype().toMarkup();
-        portStats["portName"] = name;
+        portStats["portName"] = port.name();
         portStats["portAlias"] = port.alias();
         {
             BufferChunk frontBuff; port.bufferManagerFront(frontBuff);
             portStats["frontBytes"] = frontBuff.length;
         }
         portStats["tokensEmpty"] = port.tokenManagerEmpty();
+        portStats["tokenStarvations"] = port._tokenStarvations;
+        portStats["bufferStarvations"] = port._bufferStarvations;
+        const auto tunerIt = outputBufferTuners.find(port.name());
+        if (tunerIt != outputBufferTuners.end()) portStats["autoTune"] = tunerIt->second.toJSON();
+        portStats["totalPoolAllocations"] = port._bufferPool.getTotalAllocations();
+        portStats["pooledBytes"] = port._bufferPool.getPooledBytes();
         outputStats.push_back(portStats);
     }
     if (not outputStats.empty()) stats["outputStats"] = outputStats;
@@ -621,21 +1520,118 @@ std::string Pothos::WorkerActor::queryWorkStats(void)
     return stats.dump();
 }
 
+/***********************************************************************
+ * Scheduler trace in the Chrome trace event format
+ **********************************************************************/
+std::string Pothos::WorkerActor::queryTrace(void)
+{
+    const auto pid = int(Poco::Process::id());
+    const auto name = block->getName();
+    json events(json::array());
+    for (const auto &ring : schedulerTraceRings())
+    {
+        const auto records = ring->snapshot(static_cast<const ActorInterface *>(this));
+        if (records.empty()) continue;
+
+        json threadName;
+        threadName["ph"] = "M";
+        threadName["name"] = "thread_name";
+        threadName["pid"] = pid;
+        threadName["tid"] = ring->index;
+        threadName["args"]["name"] = ring->name();
+        events.push_back(threadName);
+
+        //end events without a begin were overwritten in the ring
+        size_t taskDepth(0), callDepth(0);
+        for (const auto &record : records)
+        {
+            json event;
+            event["pid"] = pid;
+            event["tid"] = ring->index;
+            event["ts"] = record.timeNs/1e3;
+            switch (record.event)
+            {
+            case TRACE_TASK_BEGIN:
+            case TRACE_CALL_BEGIN:
+                if (record.event == TRACE_TASK_BEGIN) taskDepth++;
+                else callDepth++;
+                event["ph"] = "B";
+                break;
+            case TRACE_TASK_END:
+            case TRACE_CALL_END:
+            {
+                auto &depth = (record.event == TRACE_TASK_END)?taskDepth:callDepth;
+                if (depth == 0) continue;
+                depth--;
+                event["ph"] = "E";
+                break;
+            }
+            case TRACE_STALL:
+            case TRACE_WAKE:
+                event["ph"] = "i";
+                event["s"] = "t";
+                event["args"]["block"] = name;
+                break;
+            }
+            switch (record.event)
+            {
+            case TRACE_TASK_BEGIN:
+            case TRACE_TASK_END: event["cat"] = "task"; event["name"] = name; break;
+            case TRACE_CALL_BEGIN:
+            case TRACE_CALL_END: event["cat"] = "call"; event["name"] = "call " + name; break;
+            case TRACE_STALL: event["cat"] = "stall"; event["name"] = std::string("stall ") + schedulerStallReasonName(record.reason); break;
+            case TRACE_WAKE: event["cat"] = "wake"; event["name"] = "wake " + name; break;
+            }
+            events.push_back(event);
+        }
+    }
+    return events.dump();
+}
+
 #include <Pothos/Managed.hpp>
 
+//the method tables are built when the class is first used by a proxy
+static Pothos::ManagedClass makeManagedWorkerActor(void)
+{
+    return Pothos::ManagedClass()
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setActiveStateOn))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setActiveStateOff))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, subscribeInput))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, subscribeOutput))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setDrainStopped))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, waitDrained))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, waitEndOfStream))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getInputBytesConsumed))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getInputMessagesConsumed))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getBufferMode))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getBufferManager))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setOutputBufferManager))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setOutputBufferArgs))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setInputLossyDepth))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getNodeAffinityHint))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setOutputNodeAffinityHint))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getInputReserveBytes))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setOutputReserveHint))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getInputInPlace))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setOutputInPlaceHint))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setOutputBufferCountHint))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setBatchBufferSize))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, autoAllocateInput))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, autoAllocateOutput))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, autoDeleteInput))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, autoDeleteOutput))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, queryActivityIndicator))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setActivityNotifier))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, queryWorkStats))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setStatsLevel))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setMemoryBudget))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getStatsSnapshot))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getStatsHistory))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getStatsPortNames))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setTraceEnabled))
+        .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, queryTrace));
+}
+
 static auto managedWorkerActor = Pothos::ManagedClass()
     .registerClass<Pothos::WorkerActor>()
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setActiveStateOn))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setActiveStateOff))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, subscribeInput))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, subscribeOutput))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getBufferMode))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, getBufferManager))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, setOutputBufferManager))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, autoAllocateInput))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, autoAllocateOutput))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, autoDeleteInput))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, autoDeleteOutput))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, queryActivityIndicator))
-    .registerMethod(POTHOS_FCN_TUPLE(Pothos::WorkerActor, queryWorkStats))
-    .commit("Pothos/WorkerActor");
+    .commitDeferred("Pothos/WorkerActor", &makeManagedWorkerActor);
@@ -1,14 +1,28 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #pragma once
 #include "Framework/ActorInterface.hpp"
+#include "Framework/CycleCounter.hpp"
+#include "Framework/PerfCounters.hpp"
+#include "Framework/WorkStatsSnapshot.hpp"
+#include "Framework/WorkStatsHistory.hpp"
+#include "Framework/PublishedValues.hpp"
+#include "Framework/ActivityNotifier.hpp"
+#include "Framework/LogRateLimiter.hpp"
+#include "Framework/BufferAutoTuner.hpp"
+#include <Pothos/Util/LatencyHistogram.hpp>
+#include <Pothos/Util/MonotonicArena.hpp>
 #include <Pothos/Framework/BlockImpl.hpp>
+#include <Pothos/Framework/MemoryAccount.hpp>
 #include <Pothos/Framework/Exception.hpp>
 #include <Poco/Format.h>
 #include <Poco/Logger.h>
 #include <atomic>
 #include <set>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 #include <iostream>
 
 /***********************************************************************
@@ -21,10 +35,36 @@ public:
         block(block),
         activeState(false),
         activityIndicator(0),
+        batchBufferSize(0),
         numTaskCalls(0),
-        numWorkCalls(0)
+        numWorkCalls(0),
+        statsLevel(STATS_FULL),
+        perfCountersEnabled(false),
+        cyclesTask(0),
+        cyclesWork(0),
+        cyclesPreWork(0),
+        cyclesPostWork(0),
+        cycleLastConsumed(0),
+        cycleLastProduced(0),
+        cycleLastWork(0),
+        statsSnapshot(std::make_shared<WorkStatsSnapshot>()),
+        statsHistory(WorkStatsHistory::make(statsSnapshot)),
+        memoryAccount(MemoryAccount::make("block")),
+        drainStopped(false),
+        endOfStream(false),
+        drainRetask(false),
+        drainWaiters(0),
+        totalOutputBytes(0),
+        drainTaskCount(0),
+        drainLastIdle(false),
+        drainOutputBytes(0),
+        drainOutputMessages(0)
     {
-        return;
+        for (auto &count : numStalls) count = 0;
+        for (auto &count : perfWork) count = 0;
+        //the cycle counter stamps buffer residency times in every stats level,
+        //calibrate it once here rather than from within a work thread
+        cycleCounterPeriod();
     }
 
     /*!
@@ -35,7 +75,13 @@ public:
     {
         if (this->workerThreadAcquire(waitEnabled))
         {
+            this->traceEvent(TRACE_TASK_BEGIN);
+            MemoryAccount::Scope memoryScope(this->memoryAccount);
+            this->drainRetask = false;
             this->workTask();
+            this->publishedValues.flush();
+            if (this->drainWaiters.load(std::memory_order_acquire) != 0) this->notifyDrainWaiters();
+            this->traceEvent(TRACE_TASK_END);
             this->workerThreadRelease();
             return true;
         }
@@ -53,8 +99,27 @@ public:
         return this->activityIndicator;
     }
 
+    /*!
+     * Set the topology's aggregate activity notifier.
+     * The notifier is signaled once per work task with activity
+     * and on activation state changes; set to null to disconnect.
+     */
+    void setActivityNotifier(const std::shared_ptr<ActivityNotifier> &notifier)
+    {
+        ActorInterfaceLock lock(this);
+        this->activityNotifier = notifier;
+    }
+
+    //! Signal the aggregate notifier (called from the work context)
+    void notifyActivity(void)
+    {
+        if (this->activityNotifier) this->activityNotifier->notify();
+    }
+
     /*!
      * Query the work stats as a JSON object.
+     * The work histogram and per input port residency histograms
+     * (postBuffer upstream to consumption) are in nanoseconds.
      * This call blocks the work thread context.
      * This call is made by the top level topology
      * to amalgamate stats from all blocks in the design.
@@ -65,16 +130,36 @@ public:
     Block *block;
     bool activeState;
     std::atomic<int> activityIndicator;
+    std::shared_ptr<ActivityNotifier> activityNotifier;
     std::set<std::string> automaticSlots;
     std::map<std::string, std::unique_ptr<InputPort>> inputs;
     std::map<std::string, std::unique_ptr<OutputPort>> outputs;
+
+    //flat port lists in allocation order, rebuilt by updatePorts() for the work loop
+    std::vector<InputPort *> streamInputs;
+    std::vector<InputPort *> slotInputs;
+    std::vector<OutputPort *> streamOutputs;
+    std::vector<OutputPort *> signalOutputs;
     std::map<bool, std::map<std::string, std::map<std::string, std::string>>> bufferModeCache;
     std::map<bool, std::map<std::string, Pothos::BufferManager::Sptr>> bufferManagerTmpCache;
     std::map<bool, std::map<std::string, std::map<std::string, std::weak_ptr<Pothos::BufferManager>>>> bufferManagerCache;
+    std::map<std::string, std::string> outputBufferManagerNames;
+    std::map<std::string, Pothos::BufferManagerArgs> outputBufferManagerArgs;
+    std::map<std::string, long> outputNodeAffinityHints;
+    std::map<std::string, size_t> outputReserveHints;
+    std::map<std::string, bool> outputInPlaceHints;
+    std::map<std::string, size_t> outputBufferCountHints;
+    size_t batchBufferSize; //minimum size of the default output buffers, 0 for none
+    std::map<std::string, BufferAutoTuner> outputBufferTuners;
+
+    ///////////////////// transient work memory ///////////////////////
+    //! scratch memory for the block's work() call, reset after post-work
+    Pothos::Util::MonotonicArena workArena;
 
     ///////////////////// work stats collection ///////////////////////
     unsigned long long numTaskCalls;
     unsigned long long numWorkCalls;
+    unsigned long long numStalls[NUM_STALL_REASONS];
     std::chrono::high_resolution_clock::duration totalTimeTask;
     std::chrono::high_resolution_clock::duration totalTimeWork;
     std::chrono::high_resolution_clock::duration totalTimePreWork;
@@ -83,11 +168,167 @@ public:
     std::chrono::high_resolution_clock::time_point timeLastProduced;
     std::chrono::high_resolution_clock::time_point timeLastWork;
 
+    //! timing level for the work stats, see setStatsLevel()
+    enum StatsLevel {STATS_FULL, STATS_CYCLES, STATS_NONE};
+    std::atomic<StatsLevel> statsLevel;
+    void setStatsLevel(const std::string &level);
+
+    //! work() durations in nanoseconds
+    Util::LatencyHistogram workHistogram;
+
+    //! hardware counter totals around work() in the "PERF" stats level
+    std::atomic<bool> perfCountersEnabled;
+    unsigned long long perfWork[PerfCounters::NUM_EVENTS];
+
+    //cycle counter totals and stamps used in the STATS_CYCLES level
+    unsigned long long cyclesTask;
+    unsigned long long cyclesWork;
+    unsigned long long cyclesPreWork;
+    unsigned long long cyclesPostWork;
+    unsigned long long cycleLastConsumed;
+    unsigned long long cycleLastProduced;
+    unsigned long long cycleLastWork;
+
+    //! record an activity time stamp according to the stats level
+    void markTime(std::chrono::high_resolution_clock::time_point &t, unsigned long long &c)
+    {
+        const auto level = statsLevel.load(std::memory_order_relaxed);
+        if (level == STATS_FULL) t = std::chrono::high_resolution_clock::now();
+        else if (level == STATS_CYCLES) c = readCycleCounter();
+    }
+
+    //! counters published after each work task for lock-free readers
+    std::shared_ptr<WorkStatsSnapshot> statsSnapshot;
+    void publishStatsSnapshot(void);
+    std::shared_ptr<WorkStatsSnapshot> getStatsSnapshot(void) const
+    {
+        return statsSnapshot;
+    }
+
+    //! recent per-second rates sampled from the snapshot
+    std::shared_ptr<WorkStatsHistory> statsHistory;
+    std::shared_ptr<WorkStatsHistory> getStatsHistory(void) const
+    {
+        return statsHistory;
+    }
+
+    //! the names of the stream ports in the order of the snapshot counters
+    std::vector<std::string> getStatsPortNames(const bool isInput)
+    {
+        ActorInterfaceLock lock(this);
+        std::vector<std::string> names;
+        if (isInput) for (auto *port : streamInputs) names.push_back(port->name());
+        else for (auto *port : streamOutputs) names.push_back(port->name());
+        return names;
+    }
+
+    //! values published by the block for lock-free readers
+    PublishedValues publishedValues;
+
+    //! the shared buffers allocated by the block and its buffer managers
+    MemoryAccount::Sptr memoryAccount;
+
+    //! charge the block's allocations to the named account with a budget (0 for none)
+    void setMemoryBudget(const std::string &accountName, const size_t budget);
+
+    ///////////////////// asynchronous calls ///////////////////////
+    //! a registered call queued by Block::opaqueAsyncCall()
+    struct AsyncCall
+    {
+        std::string name;
+        ObjectVector args;
+    };
+    Util::SpinLock asyncCallsLock;
+    std::deque<AsyncCall> asyncCalls;
+    void asyncCallsPush(const std::string &name, ObjectVector &&args, const bool coalesce);
+    void handleAsyncCalls(void);
+
+    ///////////////////// topology drain ///////////////////////
+    //! stop calling work() on a source block while the topology drains
+    std::atomic<bool> drainStopped;
+    void setDrainStopped(const bool stopped);
+
+    //! the source block produced all of its data and stopped calling work()
+    std::atomic<bool> endOfStream;
+    void setEndOfStream(void);
+
+    /*!
+     * Wait until the block signals the end of its stream.
+     * \param timeout the maximum number of seconds to wait (0.0 to wait forever)
+     * \return true at the end of the stream, false for timeout
+     */
+    bool waitEndOfStream(const double timeout);
+
+    //! the block asked to run again during this task (yield, wakeup, or not prepared)
+    bool drainRetask;
+
+    //! the number of threads in waitDrained(), tasks only notify when non-zero
+    std::atomic<int> drainWaiters;
+
+    //! the bytes posted on stream outputs (worker context)
+    unsigned long long totalOutputBytes;
+
+    //! the state after the last task, guarded by the drain mutex
+    std::mutex drainMutex;
+    std::condition_variable drainCond;
+    unsigned long long drainTaskCount;
+    bool drainLastIdle;
+    unsigned long long drainOutputBytes;
+    unsigned long long drainOutputMessages;
+
+    //! are the input queues empty of buffers, labels, messages, and slot calls? (worker context)
+    bool inputQueuesEmpty(void);
+
+    //! record the state after a task and wake the drain waiters (worker context)
+    void notifyDrainWaiters(void);
+
+    /*!
+     * Wait until a task completes with empty input queues, without asking to run again,
+     * and after the stream outputs posted at least the given totals.
+     * The wait is woken by the tasks of this actor rather than by polling.
+     * This call does not acquire the actor, it runs while the block works.
+     * \param timeout the maximum number of seconds to wait (0.0 to wait forever)
+     * \return true when drained, false for timeout
+     */
+    bool waitDrained(const double timeout, const unsigned long long minOutputBytes, const unsigned long long minOutputMessages);
+
+    //! the bytes consumed on all stream inputs
+    unsigned long long getInputBytesConsumed(void);
+
+    //! the messages consumed on all stream inputs
+    unsigned long long getInputMessagesConsumed(void);
+
+    ///////////////////// error logging ///////////////////////
+    //! repeated errors of this block are logged once per second
+    LogRateLimiter logLimiter;
+
+    ///////////////////// scheduler trace ///////////////////////
+    //! enable or disable recording into the scheduler trace
+    void setTraceEnabled(const bool enabled)
+    {
+        this->enableTrace(enabled);
+    }
+
+    /*!
+     * Query the scheduler trace events of this actor
+     * as a JSON array of Chrome trace format events.
+     * This call does not block the work thread context.
+     */
+    std::string queryTrace(void);
+
+    //! count a stall and record it into the trace, the return is for preWorkTasks()
+    bool recordStall(const SchedulerStallReason reason)
+    {
+        this->numStalls[reason]++;
+        this->traceEvent(TRACE_STALL, reason);
+        return false;
+    }
+
     ///////////////////// port setup methods ///////////////////////
     void allocateInput(const std::string &name, const DType &dtype, const std::string &domain);
     void allocateOutput(const std::string &name, const DType &dtype, const std::string &domain);
     void allocateSignal(const std::string &name);
-    void allocateSlot(const std::string &name);
+    void allocateSlot(const std::string &name, const bool latestOnly);
     template <typename PortsType, typename NamedPortsType, typename IndexedPortsType, typename PortNamesType>
     void allocatePort(PortsType &ports, NamedPortsType &namedPorts, IndexedPortsType &indexedPorts, PortNamesType &portNames,
         const std::string &name, const DType &dtype, const std::string &domain, const bool automatic = false);
@@ -103,7 +344,7 @@ public:
     void autoDeleteInput(const std::string &name);
     void autoDeleteOutput(const std::string &name);
 
-    //! call after making changes to ports
+    //! call after making changes to ports (rebuilds the flat port lists)
     void updatePorts(void);
 
     ///////////////////// topology helper methods ///////////////////////
@@ -111,15 +352,32 @@ public:
     void setActiveStateOff(void);
     void subscribeInput(const std::string &action, const std::string &myPortName, InputPort *subscriberPort);
     void subscribeOutput(const std::string &action, const std::string &myPortName, OutputPort *subscriberPort);
+    //! replace subscribers of an output port in one step, so the port never sends to a partial set (direct calls only)
+    void resubscribeInputs(const std::string &myPortName, const std::vector<InputPort *> &removes, const std::vector<InputPort *> &adds);
     std::string getBufferMode(const std::string &name, const std::string &domain, const bool isInput);
     BufferManager::Sptr getBufferManager(const std::string &name, const std::string &domain, const bool isInput);
     BufferManager::Sptr getBufferManagerNoLock(const std::string &name, const std::string &domain, const bool isInput);
     void setOutputBufferManager(const std::string &name, const BufferManager::Sptr &manager);
+    void setOutputBufferArgs(const std::string &name, const std::string &bufferArgs);
+    void setInputLossyDepth(const std::string &name, const size_t numBuffers);
+    long getNodeAffinityHint(void);
+    long getNodeAffinityHintNoLock(void);
+    void setOutputNodeAffinityHint(const std::string &name, const long node);
+    size_t getInputReserveBytes(const std::string &name);
+    void setOutputReserveHint(const std::string &name, const size_t numBytes);
+    bool getInputInPlace(const std::string &name);
+    void setOutputInPlaceHint(const std::string &name, const bool inPlace);
+    void setOutputBufferCountHint(const std::string &name, const size_t numBuffers);
+    void setBatchBufferSize(const size_t bufferSize);
     void ensureOutputBufferManagerNoLock(const std::string &name);
+    void tuneOutputBuffers(void);
 
     ///////////////////// work helper methods ///////////////////////
     void workTask(void);
     bool preWorkTasks(void);
+    bool inputBatchReady(InputPort &port);
+    bool subscriberMessagesFull(OutputPort &port);
     void postWorkTasks(void);
     void handleSlotCalls(InputPort &);
+    void postLabelsAndBuffers(OutputPort &);
 };
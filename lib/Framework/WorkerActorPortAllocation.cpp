@@ -1,10 +1,11 @@
-// Copyright (c) 2014-2016 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "Framework/WorkerActor.hpp"
 #include <cassert>
 #include <algorithm> //min/max
 #include <cctype> //isdigit
+#include <set>
 
 /***********************************************************************
  * misc helper methods
@@ -91,12 +92,16 @@ void Pothos::WorkerActor::allocateSignal(const std::string &name)
 {
     this->allocateOutput(name, "", "");
     this->outputs[name]->_isSignal = true;
+    this->updatePorts();
 }
 
-void Pothos::WorkerActor::allocateSlot(const std::string &name)
+void Pothos::WorkerActor::allocateSlot(const std::string &name, const bool latestOnly)
 {
-    this->allocateInput(name, "", "");
+    //an automatic slot already exists, only update the option
+    if (this->inputs.count(name) == 0) this->allocateInput(name, "", "");
     this->inputs[name]->_isSlot = true;
+    this->inputs[name]->_slotLatestOnly = latestOnly;
+    this->updatePorts();
 }
 
 void Pothos::WorkerActor::autoAllocateInput(const std::string &name)
@@ -109,11 +114,37 @@ void Pothos::WorkerActor::autoAllocateOutput(const std::string &name)
     this->autoAllocatePort(this->outputs, block->_namedOutputs, block->_indexedOutputs, block->_outputPortNames, name);
 }
 
+template <typename PortsType, typename PortNamesType, typename PortType>
+static void splitPorts(const PortsType &ports, const PortNamesType &portNames,
+    std::vector<PortType *> &streamPorts, std::vector<PortType *> &msgPorts, bool (PortType::*isMsgPort)(void) const)
+{
+    streamPorts.clear();
+    msgPorts.clear();
+    std::set<PortType *> added;
+    for (const auto &name : portNames)
+    {
+        auto it = ports.find(name);
+        if (it == ports.end()) continue;
+        PortType *port = it->second.get();
+        if (not added.insert(port).second) continue; //duplicate name
+        if ((port->*isMsgPort)()) msgPorts.push_back(port);
+        else streamPorts.push_back(port);
+    }
+}
+
 void Pothos::WorkerActor::updatePorts(void)
 {
     //resize the work info pointer arrays
     block->_workInfo.inputPointers.resize(block->_indexedInputs.size());
     block->_workInfo.outputPointers.resize(block->_indexedOutputs.size());
+
+    //the work loop scans flat lists rather than the port maps
+    splitPorts(this->inputs, block->_inputPortNames, this->streamInputs, this->slotInputs, &InputPort::isSlot);
+    splitPorts(this->outputs, block->_outputPortNames, this->streamOutputs, this->signalOutputs, &OutputPort::isSignal);
+
+    //name lookups from work() use hash tables rather than the ordered maps
+    block->_hashedInputs = std::unordered_map<std::string, InputPort *>(block->_namedInputs.begin(), block->_namedInputs.end());
+    block->_hashedOutputs = std::unordered_map<std::string, OutputPort *>(block->_namedOutputs.begin(), block->_namedOutputs.end());
 }
 
 /***********************************************************************
@@ -159,6 +190,7 @@ void Pothos::WorkerActor::autoDeletePort(const std::string &name, PortsType &por
 
     //remove from ports itself
     ports.erase(it);
+    this->updatePorts();
 }
 
 void Pothos::WorkerActor::autoDeleteInput(const std::string &name)
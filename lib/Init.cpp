@@ -1,17 +1,22 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Init.hpp>
 #include <Pothos/Exception.hpp>
 #include <Pothos/System/Paths.hpp>
 #include <Pothos/Plugin.hpp>
+#include "System/StartupProfile.hpp"
 #include <Poco/Path.h>
 #include <Poco/File.h>
 #include <Poco/Format.h>
+#include <chrono>
 
 //from lib/Framework/ConfLoader.cpp
 std::vector<Pothos::PluginPath> Pothos_ConfLoader_loadConfFiles(void);
 
+//from lib/Plugin/Loader.in.cpp
+void pluginLoaderUnloadOnDemand(void);
+
 /***********************************************************************
  * Singleton for initialization once per process
  **********************************************************************/
@@ -41,8 +46,18 @@ Pothos::InitSingleton &Pothos::InitSingleton::instance(void)
 void Pothos::InitSingleton::load(void)
 {
     if (not modules.empty()) return;
-    modules = PluginLoader::loadModules();
-    confLoadedPaths = Pothos_ConfLoader_loadConfFiles();
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    {
+        StartupProfileTimer timer("init", "PluginLoader::loadModules()");
+        modules = PluginLoader::loadModules();
+    }
+    {
+        StartupProfileTimer timer("init", "ConfLoader::loadConfFiles()");
+        confLoadedPaths = Pothos_ConfLoader_loadConfFiles();
+    }
+    if (not startupProfileEnabled()) return;
+    const auto elapsed = std::chrono::high_resolution_clock::now() - startTime;
+    startupProfileReport(std::chrono::duration<double>(elapsed).count());
 }
 
 void Pothos::InitSingleton::unload(void)
@@ -52,6 +67,7 @@ void Pothos::InitSingleton::unload(void)
         Pothos::PluginRegistry::remove(path);
     }
     confLoadedPaths.clear();
+    pluginLoaderUnloadOnDemand();
     modules.clear();
 }
 
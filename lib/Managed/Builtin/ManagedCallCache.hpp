@@ -0,0 +1,12 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+
+/*!
+ * Clear the resolved calls cached by ManagedProxyHandle::call().
+ * The registries for managed classes and conversions call this on changes,
+ * because either one can change which overload a call resolves to.
+ */
+void clearManagedCallCache(void);
@@ -1,14 +1,75 @@
-// Copyright (c) 2013-2016 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "ManagedProxy.hpp"
+#include "ManagedCallCache.hpp"
 #include <Pothos/Managed.hpp>
 #include <Pothos/Object.hpp>
 #include <Pothos/Util/TypeInfo.hpp>
+#include <Pothos/Util/SpinLockRW.hpp>
 #include <Poco/Format.h>
+#include <unordered_map>
+#include <functional> //hash
+#include <mutex>
+#include <vector>
 #include <cassert>
 #include <iostream>
 
+/***********************************************************************
+ * Cache of resolved calls:
+ * keyed by the class, the kind of call, the name, and the argument types,
+ * so that repeated calls skip the search through the overloads
+ **********************************************************************/
+struct ManagedCallKey
+{
+    size_t classHash;
+    int kind;
+    std::string name;
+    std::vector<size_t> argHashes;
+
+    bool operator==(const ManagedCallKey &other) const
+    {
+        return classHash == other.classHash and kind == other.kind and
+            name == other.name and argHashes == other.argHashes;
+    }
+};
+
+struct ManagedCallKeyHash
+{
+    size_t operator()(const ManagedCallKey &key) const
+    {
+        size_t h = key.classHash ^ (std::hash<std::string>()(key.name) + size_t(key.kind));
+        for (const auto argHash : key.argHashes) h ^= argHash + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+struct ManagedCallEntry
+{
+    Pothos::Callable call;
+    bool doOpaqueCall;
+    bool doWildcardCall;
+};
+
+static Pothos::Util::SpinLockRW &getCallCacheMutex(void)
+{
+    static Pothos::Util::SpinLockRW lock;
+    return lock;
+}
+
+typedef std::unordered_map<ManagedCallKey, ManagedCallEntry, ManagedCallKeyHash> ManagedCallCacheType;
+static ManagedCallCacheType &getCallCache(void)
+{
+    static ManagedCallCacheType cache;
+    return cache;
+}
+
+void clearManagedCallCache(void)
+{
+    std::lock_guard<Pothos::Util::SpinLockRW> lock(getCallCacheMutex());
+    getCallCache().clear();
+}
+
 ManagedProxyHandle::ManagedProxyHandle(std::shared_ptr<ManagedProxyEnvironment> env, const Pothos::Object &obj):
     env(env), obj(obj)
 {
@@ -52,36 +113,7 @@ Pothos::Proxy ManagedProxyHandle::call(const std::string &name, const Pothos::Pr
     }
 
     /*******************************************************************
-     * Step 2) extract the list of calls
-     ******************************************************************/
-    std::vector<Pothos::Callable> calls;
-    Pothos::Callable opaqueCall;
-    Pothos::Callable wildcardCall;
-
-    if (callConstructor)
-    {
-        calls = cls.getConstructors();
-        opaqueCall = cls.getOpaqueConstructor();
-    }
-    else if (callStaticMethod)
-    {
-        try {calls = cls.getStaticMethods(name);}
-        catch (const Pothos::ManagedClassNameError &){}
-        try {opaqueCall = cls.getOpaqueStaticMethod(name);}
-        catch (const Pothos::ManagedClassNameError &){}
-        wildcardCall = cls.getWildcardStaticMethod();
-    }
-    else if (callMethod)
-    {
-        try {calls = cls.getMethods(name);}
-        catch (const Pothos::ManagedClassNameError &){}
-        try {opaqueCall = cls.getOpaqueMethod(name);}
-        catch (const Pothos::ManagedClassNameError &){}
-        wildcardCall = cls.getWildcardMethod();
-    }
-
-    /*******************************************************************
-     * Step 3) create an argument list
+     * Step 2) create an argument list
      ******************************************************************/
     std::vector<Pothos::Object> argObjs;
 
@@ -126,57 +158,122 @@ Pothos::Proxy ManagedProxyHandle::call(const std::string &name, const Pothos::Pr
     if (callMethod) assert(not argObjs.empty());
 
     /*******************************************************************
-     * Step 3) find the best match for the call
+     * Step 3) lookup the cached match for these argument types
      ******************************************************************/
+    ManagedCallKey key;
+    key.kind = callConstructor?0:(callStaticMethod?1:2);
+    key.name = name;
+    key.classHash = 0;
+    try
+    {
+        key.classHash = callMethod?obj.type().hash_code():cls.type().hash_code();
+    }
+    catch (const Pothos::ManagedClassTypeError &){} //classes without a type are not cached
+    for (const auto &argObj : argObjs) key.argHashes.push_back(argObj.type().hash_code());
+
     Pothos::Callable call;
     bool doOpaqueCall = false;
     bool doWildcardCall = false;
-    for (const auto &c : calls)
+    if (key.classHash != 0)
     {
-        if (c.getNumArgs() != argObjs.size()) goto failMatch;
-        for (size_t a = 0; a < c.getNumArgs(); a++)
+        Pothos::Util::SpinLockRW::SharedLock lock(getCallCacheMutex());
+        auto it = getCallCache().find(key);
+        if (it != getCallCache().end())
         {
-            if (not argObjs[a].canConvert(c.type(a))) goto failMatch;
+            call = it->second.call;
+            doOpaqueCall = it->second.doOpaqueCall;
+            doWildcardCall = it->second.doWildcardCall;
         }
-        call = c;
-        failMatch: continue;
-    }
-    if (not call and opaqueCall)
-    {
-        doOpaqueCall = true;
-        call = opaqueCall;
-    }
-    if (not call and wildcardCall)
-    {
-        doWildcardCall = true;
-        call = wildcardCall;
     }
 
-    //attempt to make the call on a base class
-    //always try to call the base class first if there is a wildcard handler
-    if (callMethod and (not call or wildcardCall))
+    if (not call)
     {
-        for (const auto &toBase : cls.getBaseClassConverters())
+        /*******************************************************************
+         * Step 4) extract the list of calls
+         ******************************************************************/
+        std::vector<Pothos::Callable> calls;
+        Pothos::Callable opaqueCall;
+        Pothos::Callable wildcardCall;
+
+        if (callConstructor)
+        {
+            calls = cls.getConstructors();
+            opaqueCall = cls.getOpaqueConstructor();
+        }
+        else if (callStaticMethod)
+        {
+            try {calls = cls.getStaticMethods(name);}
+            catch (const Pothos::ManagedClassNameError &){}
+            try {opaqueCall = cls.getOpaqueStaticMethod(name);}
+            catch (const Pothos::ManagedClassNameError &){}
+            wildcardCall = cls.getWildcardStaticMethod();
+        }
+        else if (callMethod)
+        {
+            try {calls = cls.getMethods(name);}
+            catch (const Pothos::ManagedClassNameError &){}
+            try {opaqueCall = cls.getOpaqueMethod(name);}
+            catch (const Pothos::ManagedClassNameError &){}
+            wildcardCall = cls.getWildcardMethod();
+        }
+
+        /*******************************************************************
+         * Step 5) find the best match for the call
+         ******************************************************************/
+        for (const auto &c : calls)
         {
-            try
+            if (c.getNumArgs() != argObjs.size()) goto failMatch;
+            for (size_t a = 0; a < c.getNumArgs(); a++)
             {
-                return env->makeHandle(toBase.opaqueCall(&argObjs.at(0), 1)).getHandle()->call(name, localArgs.data(), localArgs.size());
+                if (not argObjs[a].canConvert(c.type(a))) goto failMatch;
             }
-            catch (const Pothos::ProxyHandleCallError &) {}
+            call = c;
+            failMatch: continue;
+        }
+        if (not call and opaqueCall)
+        {
+            doOpaqueCall = true;
+            call = opaqueCall;
+        }
+        if (not call and wildcardCall)
+        {
+            doWildcardCall = true;
+            call = wildcardCall;
         }
-    }
 
-    //searching base classes failed, so we can error out this way if calls are empty
-    if (calls.empty() and not opaqueCall and not wildcardCall)
-    {
-        throw Pothos::ProxyHandleCallError("ManagedProxyHandle::call("+name+")", "no available calls :" + obj.toString());
-    }
+        //attempt to make the call on a base class
+        //always try to call the base class first if there is a wildcard handler
+        if (callMethod and (not call or wildcardCall))
+        {
+            for (const auto &toBase : cls.getBaseClassConverters())
+            {
+                try
+                {
+                    return env->makeHandle(toBase.opaqueCall(&argObjs.at(0), 1)).getHandle()->call(name, localArgs.data(), localArgs.size());
+                }
+                catch (const Pothos::ProxyHandleCallError &) {}
+            }
+        }
+
+        //searching base classes failed, so we can error out this way if calls are empty
+        if (calls.empty() and not opaqueCall and not wildcardCall)
+        {
+            throw Pothos::ProxyHandleCallError("ManagedProxyHandle::call("+name+")", "no available calls :" + obj.toString());
+        }
 
-    //otherwise just assume there was no possible match for the given args
-    if (not call) throw Pothos::ProxyHandleCallError("ManagedProxyHandle::call("+name+")", "method match failed");
+        //otherwise just assume there was no possible match for the given args
+        if (not call) throw Pothos::ProxyHandleCallError("ManagedProxyHandle::call("+name+")", "method match failed");
+
+        //cache the match when the call does not depend on the base classes
+        if (key.classHash != 0 and call and not (callMethod and wildcardCall))
+        {
+            std::lock_guard<Pothos::Util::SpinLockRW> lock(getCallCacheMutex());
+            getCallCache()[key] = ManagedCallEntry{call, doOpaqueCall, doWildcardCall};
+        }
+    }
 
     /*******************************************************************
-     * Step 4) make the call
+     * Step 6) make the call
      ******************************************************************/
     Pothos::Object result;
     POTHOS_EXCEPTION_TRY
@@ -62,3 +62,96 @@ POTHOS_TEST_BLOCK("/proxy/managed/tests", test_containers)
     POTHOS_TEST_NOT_EQUAL(find1, resultDict.end());
     POTHOS_TEST_EQUAL(find1->second.convert<int>(), 2);
 }
+
+struct OverloadTester
+{
+    static std::string whichInt(int)
+    {
+        return "int";
+    }
+
+    static std::string whichString(const std::string &)
+    {
+        return "string";
+    }
+
+    static std::string whichReloaded(int)
+    {
+        return "reloaded";
+    }
+};
+
+POTHOS_TEST_BLOCK("/proxy/managed/tests", test_cached_call_resolution)
+{
+    Pothos::ManagedClass()
+        .registerClass<OverloadTester>()
+        .registerStaticMethod("which", &OverloadTester::whichInt)
+        .registerStaticMethod("which", &OverloadTester::whichString)
+        .commit("OverloadTester");
+
+    //repeated calls resolve the same overload for each argument type
+    auto env = Pothos::ProxyEnvironment::make("managed");
+    auto tester = env->findProxy("OverloadTester");
+    for (size_t i = 0; i < 3; i++)
+    {
+        POTHOS_TEST_EQUAL(tester.call("which", 42).convert<std::string>(), "int");
+        POTHOS_TEST_EQUAL(tester.call("which", std::string("hi")).convert<std::string>(), "string");
+    }
+
+    //re-registration of the class replaces the cached resolution
+    Pothos::ManagedClass::unload("OverloadTester");
+    Pothos::ManagedClass()
+        .registerClass<OverloadTester>()
+        .registerStaticMethod("which", &OverloadTester::whichReloaded)
+        .commit("OverloadTester");
+    tester = env->findProxy("OverloadTester");
+    POTHOS_TEST_EQUAL(tester.call("which", 42).convert<std::string>(), "reloaded");
+
+    Pothos::ManagedClass::unload("OverloadTester");
+}
+
+struct DeferredTester
+{
+    DeferredTester(const int value):
+        value(value){}
+
+    int getValue(void) const
+    {
+        return value;
+    }
+
+    int value;
+};
+
+static size_t numDeferredFactoryCalls = 0;
+
+static Pothos::ManagedClass makeDeferredTester(void)
+{
+    numDeferredFactoryCalls++;
+    return Pothos::ManagedClass()
+        .registerConstructor<DeferredTester, int>()
+        .registerMethod(POTHOS_FCN_TUPLE(DeferredTester, getValue));
+}
+
+POTHOS_TEST_BLOCK("/proxy/managed/tests", test_deferred_registration)
+{
+    numDeferredFactoryCalls = 0;
+    Pothos::ManagedClass()
+        .registerClass<DeferredTester>()
+        .commitDeferred("DeferredTester", &makeDeferredTester);
+
+    //the class is found by type without making the registrations
+    const auto cls = Pothos::ManagedClass::lookup(typeid(DeferredTester));
+    POTHOS_TEST_TRUE(cls.type() == typeid(DeferredTester));
+    POTHOS_TEST_EQUAL(numDeferredFactoryCalls, 0);
+
+    //the first use makes the registrations once
+    auto env = Pothos::ProxyEnvironment::make("managed");
+    auto tester = env->findProxy("DeferredTester").call("()", 42);
+    POTHOS_TEST_EQUAL(tester.call("getValue").convert<int>(), 42);
+    POTHOS_TEST_EQUAL(env->findProxy("DeferredTester")(7).call("getValue").convert<int>(), 7);
+    POTHOS_TEST_EQUAL(numDeferredFactoryCalls, 1);
+    POTHOS_TEST_EQUAL(cls.getConstructors().size(), 1);
+
+    Pothos::ManagedClass::unload("DeferredTester");
+}
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2014 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Plugin.hpp>
@@ -6,8 +6,11 @@
 #include <Pothos/Managed/Class.hpp>
 #include <Pothos/Managed/ClassImpl.hpp>
 #include <Pothos/Util/TypeInfo.hpp>
+#include "System/StartupProfile.hpp"
 #include <Poco/Format.h>
 #include <string>
+#include <memory>
+#include <mutex>
 #include <map>
 #include <vector>
 #include <cctype> //isalnum, tolower
@@ -29,6 +32,32 @@ struct Pothos::ManagedClass::Impl
 
     std::map<std::string, Pothos::Callable> opaqueMethods;
     Pothos::Callable wildcardMethod;
+
+    //deferred registration: the factory makes the complete class on first use
+    std::function<Pothos::ManagedClass(void)> factory;
+    std::shared_ptr<Impl> deferred;
+    std::mutex deferredMutex;
+
+    //the constructor and method registrations of this class
+    const Impl &registrations(void)
+    {
+        if (not factory) return *this;
+        const auto impl = std::atomic_load(&deferred);
+        if (impl) return *impl;
+
+        std::lock_guard<std::mutex> lock(deferredMutex);
+        if (not deferred)
+        {
+            const auto cls = factory();
+            if (referenceToWrapper and cls._impl->referenceToWrapper and
+                cls._impl->referenceToWrapper.type(0) != referenceToWrapper.type(0))
+            {
+                throw ManagedClassTypeError("Pothos::ManagedClass::commitDeferred()", "class type mismatch");
+            }
+            std::atomic_store(&deferred, cls._impl);
+        }
+        return *deferred;
+    }
 };
 
 Pothos::ManagedClass::ManagedClass(void):
@@ -205,6 +234,8 @@ static std::string typeToPluginPath(const std::type_info &type)
 
 Pothos::ManagedClass &Pothos::ManagedClass::commit(const std::string &classPath)
 {
+    StartupProfileTimer timer("managed", classPath);
+
     //register conversions for constructors that take one argument
     for (const auto &constructor : this->getConstructors())
     {
@@ -223,14 +254,25 @@ Pothos::ManagedClass &Pothos::ManagedClass::commit(const std::string &classPath)
     return *this;
 }
 
+Pothos::ManagedClass &Pothos::ManagedClass::commitDeferred(const std::string &classPath, const std::function<ManagedClass(void)> &factory)
+{
+    StartupProfileTimer timer("managed", classPath);
+
+    _impl->factory = factory;
+    PluginRegistry::add(
+        PluginPath("/managed").join(classPath),
+        dynamic_cast<ManagedClass &>(*this));
+    return *this;
+}
+
 void Pothos::ManagedClass::unload(const std::string &classPath)
 {
     //extract the managed class from the plugin tree
     auto plugin = PluginRegistry::get(PluginPath("/managed").join(classPath));
     auto &managedCls = plugin.getObject().extract<ManagedClass>();
 
-    //unload conversion constructors
-    for (const auto &constructor : managedCls.getConstructors())
+    //unload conversion constructors, which are not registered for deferred classes
+    if (not managedCls._impl->factory) for (const auto &constructor : managedCls.getConstructors())
     {
         if (constructor.getNumArgs() != 1) continue;
         Pothos::PluginRegistry::remove(
@@ -261,53 +303,57 @@ const Pothos::Callable &Pothos::ManagedClass::getSharedToWrapper(void) const
 
 const std::vector<Pothos::Callable> &Pothos::ManagedClass::getBaseClassConverters(void) const
 {
-    return _impl->baseConverters;
+    return _impl->registrations().baseConverters;
 }
 
 const std::vector<Pothos::Callable> &Pothos::ManagedClass::getConstructors(void) const
 {
-    return _impl->constructors;
+    return _impl->registrations().constructors;
 }
 
 const std::vector<Pothos::Callable> &Pothos::ManagedClass::getStaticMethods(const std::string &name) const
 {
-    auto it = _impl->staticMethods.find(name);
-    if (it != _impl->staticMethods.end()) return it->second;
+    const auto &regs = _impl->registrations();
+    auto it = regs.staticMethods.find(name);
+    if (it != regs.staticMethods.end()) return it->second;
     throw ManagedClassNameError("Pothos::ManagedClass::getStaticMethods("+name+")", "name not found");
 }
 
 const std::vector<Pothos::Callable> &Pothos::ManagedClass::getMethods(const std::string &name) const
 {
-    auto it = _impl->methods.find(name);
-    if (it != _impl->methods.end()) return it->second;
+    const auto &regs = _impl->registrations();
+    auto it = regs.methods.find(name);
+    if (it != regs.methods.end()) return it->second;
     throw ManagedClassNameError("Pothos::ManagedClass::getMethods("+name+")", "name not found");
 }
 
 const Pothos::Callable &Pothos::ManagedClass::getOpaqueConstructor(void) const
 {
-    return _impl->opaqueConstructor;
+    return _impl->registrations().opaqueConstructor;
 }
 
 const Pothos::Callable &Pothos::ManagedClass::getOpaqueStaticMethod(const std::string &name) const
 {
-    auto it = _impl->opaqueStaticMethods.find(name);
-    if (it != _impl->opaqueStaticMethods.end()) return it->second;
+    const auto &regs = _impl->registrations();
+    auto it = regs.opaqueStaticMethods.find(name);
+    if (it != regs.opaqueStaticMethods.end()) return it->second;
     throw ManagedClassNameError("Pothos::ManagedClass::getOpaqueStaticMethod("+name+")", "name not found");
 }
 
 const Pothos::Callable &Pothos::ManagedClass::getWildcardStaticMethod(void) const
 {
-    return _impl->wildcardStaticMethod;
+    return _impl->registrations().wildcardStaticMethod;
 }
 
 const Pothos::Callable &Pothos::ManagedClass::getOpaqueMethod(const std::string &name) const
 {
-    auto it = _impl->opaqueMethods.find(name);
-    if (it != _impl->opaqueMethods.end()) return it->second;
+    const auto &regs = _impl->registrations();
+    auto it = regs.opaqueMethods.find(name);
+    if (it != regs.opaqueMethods.end()) return it->second;
     throw ManagedClassNameError("Pothos::ManagedClass::getWildcardStaticMethod("+name+")", "name not found");
 }
 
 const Pothos::Callable &Pothos::ManagedClass::getWildcardMethod(void) const
 {
-    return _impl->wildcardMethod;
+    return _impl->registrations().wildcardMethod;
 }
@@ -1,6 +1,7 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "Managed/Builtin/ManagedCallCache.hpp"
 #include <Pothos/Managed/Class.hpp>
 #include <Pothos/Managed/Exception.hpp>
 #include <Pothos/Util/SpinLockRW.hpp>
@@ -8,6 +9,7 @@
 #include <Pothos/Callable.hpp>
 #include <Pothos/Plugin.hpp>
 #include <Poco/Logger.h>
+#include <vector>
 #include <mutex>
 #include <map>
 
@@ -40,7 +42,7 @@ static void handlePluginEvent(const Pothos::Plugin &plugin, const std::string &e
         if (plugin.getObject().type() != typeid(Pothos::ManagedClass)) return;
         const auto &reg = plugin.getObject().extract<Pothos::ManagedClass>();
 
-        std::lock_guard<Pothos::Util::SpinLockRW> lock(getMapMutex());
+        //the caller holds the map mutex
         if (event == "add")
         {
             getClassMap()[reg.type().hash_code()] = plugin;
@@ -61,12 +63,21 @@ static void handlePluginEvent(const Pothos::Plugin &plugin, const std::string &e
     }
 }
 
+//the classes of a module load arrive in one batch,
+//so the call cache is cleared once rather than per class
+static void handlePluginEvents(const std::vector<Pothos::Plugin> &plugins, const std::string &event)
+{
+    clearManagedCallCache();
+    std::lock_guard<Pothos::Util::SpinLockRW> lock(getMapMutex());
+    for (const auto &plugin : plugins) handlePluginEvent(plugin, event);
+}
+
 /***********************************************************************
  * Register event handler
  **********************************************************************/
 pothos_static_block(pothosManagedClassRegister)
 {
-    Pothos::PluginRegistry::addCall("/managed", &handlePluginEvent);
+    Pothos::PluginRegistry::addCall("/managed", &handlePluginEvents);
 }
 
 /***********************************************************************
@@ -0,0 +1,45 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Object.hpp>
+#include <Pothos/Benchmark.hpp>
+#include <string>
+
+POTHOS_BENCH_BLOCK("/object/bench", bench_object_create_int)
+{
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        const auto obj = Pothos::Object(int(i));
+        Pothos::BenchmarkState::doNotOptimize(obj);
+    }
+}
+
+POTHOS_BENCH_BLOCK("/object/bench", bench_object_create_string)
+{
+    const std::string value("a string too long for the small string buffer");
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        const auto obj = Pothos::Object(value);
+        Pothos::BenchmarkState::doNotOptimize(obj);
+    }
+}
+
+POTHOS_BENCH_BLOCK("/object/bench", bench_object_convert_int_to_double)
+{
+    const Pothos::Object obj(int(42));
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        const auto value = obj.convert<double>();
+        Pothos::BenchmarkState::doNotOptimize(value);
+    }
+}
+
+POTHOS_BENCH_BLOCK("/object/bench", bench_object_convert_int_to_string)
+{
+    const Pothos::Object obj(int(42));
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        const auto value = obj.convert<std::string>();
+        Pothos::BenchmarkState::doNotOptimize(value);
+    }
+}
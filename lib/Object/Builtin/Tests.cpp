@@ -4,9 +4,15 @@
 
 #include <Pothos/Object.hpp>
 #include <Pothos/Testing.hpp>
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Callable.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
+#include <functional> //std::hash
 #include <vector>
 #include <complex>
 #include <sstream>
+#include <string>
+#include <thread>
 
 class NeverHeardOfFooBar {};
 
@@ -60,6 +66,37 @@ POTHOS_TEST_BLOCK("/object/tests", test_object_mutable)
     POTHOS_TEST_THROWS(intObj.ref<int>(), Pothos::ObjectConvertError);
 }
 
+POTHOS_TEST_BLOCK("/object/tests", test_object_pool)
+{
+    //containers of mixed sizes are recycled through the pool
+    for (size_t round = 0; round < 3; round++)
+    {
+        std::vector<Pothos::Object> objs;
+        for (int i = 0; i < 1000; i++)
+        {
+            objs.emplace_back(i);
+            objs.emplace_back(std::complex<double>(i, -i));
+            objs.emplace_back(std::string(size_t(i % 100), 'x'));
+            objs.emplace_back(std::vector<int>(size_t(i % 10), i));
+        }
+        for (int i = 0; i < 1000; i++)
+        {
+            POTHOS_TEST_EQUAL(objs[4*i+0].extract<int>(), i);
+            POTHOS_TEST_EQUAL(objs[4*i+1].extract<std::complex<double>>(), std::complex<double>(i, -i));
+            POTHOS_TEST_EQUAL(objs[4*i+2].extract<std::string>().size(), size_t(i % 100));
+            POTHOS_TEST_EQUAL(objs[4*i+3].extract<std::vector<int>>().size(), size_t(i % 10));
+        }
+    }
+
+    //objects made on one thread can be released on another
+    std::vector<Pothos::Object> objs;
+    std::thread maker([&objs]{for (int i = 0; i < 1000; i++) objs.emplace_back(i);});
+    maker.join();
+    std::thread releaser([&objs]{objs.clear();});
+    releaser.join();
+    POTHOS_TEST_TRUE(objs.empty());
+}
+
 Pothos::Object someFunctionTakesObject(const Pothos::Object &obj)
 {
     return obj;
@@ -99,6 +136,36 @@ POTHOS_TEST_BLOCK("/object/tests", test_convert_numbers)
     POTHOS_TEST_THROWS(Pothos::Object(-1024).convert<char>(), Pothos::RangeException);
 }
 
+struct ConvertCacheTester
+{
+    int value;
+};
+
+static ConvertCacheTester intToConvertCacheTester(const int value)
+{
+    ConvertCacheTester tester;
+    tester.value = value;
+    return tester;
+}
+
+POTHOS_TEST_BLOCK("/object/tests", test_convert_path_cache)
+{
+    //the missing conversion is cached, then replaced when the plugin loads
+    Pothos::Object intObj(int(42));
+    POTHOS_TEST_FALSE(intObj.canConvert(typeid(ConvertCacheTester)));
+    Pothos::PluginRegistry::add("/object/convert/tests/int_to_convert_cache_tester", Pothos::Callable(&intToConvertCacheTester));
+    POTHOS_TEST_TRUE(intObj.canConvert(typeid(ConvertCacheTester)));
+    POTHOS_TEST_EQUAL(intObj.convert<ConvertCacheTester>().value, 42);
+
+    //a two step conversion through int
+    POTHOS_TEST_EQUAL(Pothos::Object(long(21)).convert<ConvertCacheTester>().value, 21);
+
+    //the cached conversion is removed with the plugin
+    Pothos::PluginRegistry::remove("/object/convert/tests/int_to_convert_cache_tester");
+    POTHOS_TEST_FALSE(intObj.canConvert(typeid(ConvertCacheTester)));
+    POTHOS_TEST_THROWS(intObj.convert<ConvertCacheTester>(), Pothos::ObjectConvertError);
+}
+
 POTHOS_TEST_BLOCK("/object/tests", test_convert_complex)
 {
     Pothos::Object complexObj(std::complex<double>(2, -3));
@@ -163,6 +230,27 @@ POTHOS_TEST_BLOCK("/object/tests", test_serialize_obj)
     POTHOS_TEST_EQUAL(int1.extract<int>(), 42);
 }
 
+POTHOS_TEST_BLOCK("/object/tests", test_serialize_memory)
+{
+    Pothos::Object str0(std::string("hello"));
+    Pothos::Object int0(42);
+    std::vector<char> buffer;
+    str0.serialize(buffer);
+    int0.serialize(buffer);
+
+    //objects are consumed one after the other from the buffer
+    Pothos::Object str1;
+    const auto n = str1.deserialize(buffer.data(), buffer.size());
+    Pothos::Object int1;
+    POTHOS_TEST_EQUAL(n+int1.deserialize(buffer.data()+n, buffer.size()-n), buffer.size());
+    POTHOS_TEST_EQUAL(str1.extract<std::string>(), "hello");
+    POTHOS_TEST_EQUAL(int1.extract<int>(), 42);
+
+    //a truncated buffer throws
+    Pothos::Object int2;
+    POTHOS_TEST_THROWS(int2.deserialize(buffer.data()+n, buffer.size()-n-1), Pothos::ObjectSerializeError);
+}
+
 POTHOS_TEST_BLOCK("/object/tests", test_compare_to)
 {
     Pothos::Object null0;
@@ -181,3 +269,26 @@ POTHOS_TEST_BLOCK("/object/tests", test_compare_to)
     POTHOS_TEST_GT(num0, num1);
     POTHOS_TEST_TRUE(num1 < num0);
 }
+
+POTHOS_TEST_BLOCK("/object/tests", test_builtin_hash_compare)
+{
+    //builtin hashes match std::hash
+    POTHOS_TEST_EQUAL(Pothos::Object(int(42)).hashCode(), std::hash<int>()(42));
+    POTHOS_TEST_EQUAL(Pothos::Object(std::string("hi")).hashCode(), std::hash<std::string>()("hi"));
+    POTHOS_TEST_EQUAL(Pothos::Object().hashCode(), Pothos::Object().hashCode());
+
+    //mixed number types compare by value
+    POTHOS_TEST_EQUAL(Pothos::Object(int(3)).compareTo(Pothos::Object(3.0f)), 0);
+    POTHOS_TEST_EQUAL(Pothos::Object(size_t(1)).compareTo(Pothos::Object(char(2))), -1);
+    POTHOS_TEST_EQUAL(Pothos::Object(2.5).compareTo(Pothos::Object(2ll)), +1);
+
+    //buffers compare and hash by the view of the memory
+    Pothos::BufferChunk buff(1024);
+    Pothos::BufferChunk view = buff;
+    view.address += 8;
+    view.length -= 8;
+    POTHOS_TEST_EQUAL(Pothos::Object(buff).compareTo(Pothos::Object(buff)), 0);
+    POTHOS_TEST_EQUAL(Pothos::Object(buff).hashCode(), Pothos::Object(buff).hashCode());
+    POTHOS_TEST_EQUAL(Pothos::Object(buff).compareTo(Pothos::Object(view)), -1);
+    POTHOS_TEST_THROWS(Pothos::Object(buff).compareTo(Pothos::Object(1)), Pothos::ObjectCompareError);
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Object/ObjectImpl.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
+#include <typeinfo>
+#include <string>
+
+/*!
+ * Call the visitor with the value of an object that holds a builtin type:
+ * the arithmetic types, std::string, or Pothos::BufferChunk.
+ * The hash and compare fast paths use this to skip the plugin registry.
+ * \return false when the object does not hold a builtin type
+ */
+template <typename Visitor>
+static inline bool visitBuiltinObject(const Pothos::Object &obj, Visitor &visitor)
+{
+    const auto &type = obj.type();
+    #define VISIT_BUILTIN_TYPE(T) if (type == typeid(T)) {visitor(obj.extract<T>()); return true;}
+    VISIT_BUILTIN_TYPE(double)
+    VISIT_BUILTIN_TYPE(int)
+    VISIT_BUILTIN_TYPE(std::string)
+    VISIT_BUILTIN_TYPE(Pothos::BufferChunk)
+    VISIT_BUILTIN_TYPE(long long)
+    VISIT_BUILTIN_TYPE(size_t)
+    VISIT_BUILTIN_TYPE(float)
+    VISIT_BUILTIN_TYPE(bool)
+    VISIT_BUILTIN_TYPE(char)
+    VISIT_BUILTIN_TYPE(signed char)
+    VISIT_BUILTIN_TYPE(unsigned char)
+    VISIT_BUILTIN_TYPE(signed short)
+    VISIT_BUILTIN_TYPE(unsigned short)
+    VISIT_BUILTIN_TYPE(unsigned int)
+    VISIT_BUILTIN_TYPE(signed long)
+    VISIT_BUILTIN_TYPE(unsigned long)
+    VISIT_BUILTIN_TYPE(unsigned long long)
+    #undef VISIT_BUILTIN_TYPE
+    return false;
+}
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "TypesHashCombine.hpp"
+#include "BuiltinTypes.hpp"
 #include <Pothos/Object/Object.hpp>
 #include <Pothos/Object/Exception.hpp>
 #include <Pothos/Util/SpinLockRW.hpp>
@@ -73,11 +74,75 @@ pothos_static_block(pothosObjectCompareRegister)
     Pothos::PluginRegistry::addCall("/object/compare", &handleComparePluginEvent);
 }
 
+/***********************************************************************
+ * Compare builtin types without the registry
+ **********************************************************************/
+struct BuiltinNumber
+{
+    BuiltinNumber(void):
+        isNumber(false),
+        value(0.0)
+    {
+        return;
+    }
+
+    template <typename T>
+    void operator()(const T &num)
+    {
+        isNumber = true;
+        value = double(num);
+    }
+
+    void operator()(const std::string &){}
+
+    void operator()(const Pothos::BufferChunk &){}
+
+    bool isNumber;
+    double value;
+};
+
+static bool compareBuiltin(const Pothos::Object &obj0, const Pothos::Object &obj1, int &result)
+{
+    const auto &type = obj0.type();
+    if (type == obj1.type())
+    {
+        if (not obj0)
+        {
+            result = 0;
+            return true;
+        }
+        if (type == typeid(std::string))
+        {
+            result = obj0.extract<std::string>().compare(obj1.extract<std::string>());
+            return true;
+        }
+        //buffers compare by the view of the memory
+        if (type == typeid(Pothos::BufferChunk))
+        {
+            const auto &b0 = obj0.extract<Pothos::BufferChunk>();
+            const auto &b1 = obj1.extract<Pothos::BufferChunk>();
+            result = Pothos::Util::compareTo(b0.address, b1.address);
+            if (result == 0) result = Pothos::Util::compareTo(b0.length, b1.length);
+            return true;
+        }
+    }
+
+    //numbers compare as doubles like the conversion fallback in compareTo()
+    BuiltinNumber n0, n1;
+    if (not visitBuiltinObject(obj0, n0) or not n0.isNumber) return false;
+    if (not visitBuiltinObject(obj1, n1) or not n1.isNumber) return false;
+    result = Pothos::Util::compareTo(n0.value, n1.value);
+    return true;
+}
+
 /***********************************************************************
  * The compare implementation
  **********************************************************************/
 int Pothos::Object::compareTo(const Pothos::Object &other) const
 {
+    int result = 0;
+    if (compareBuiltin(*this, other, result)) return result;
+
     //find the plugin in the map, it will be null if not found
     Pothos::Util::SpinLockRW::SharedLock lock(getMapMutex());
     auto it = getCompareMap().find(typesHashCombine(this->type(), other.type()));
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "TypesHashCombine.hpp"
+#include "Managed/Builtin/ManagedCallCache.hpp"
 #include <Pothos/Object/ObjectImpl.hpp>
 #include <Pothos/Object/Exception.hpp>
 #include <Pothos/Util/SpinLockRW.hpp>
@@ -10,6 +11,9 @@
 #include <Pothos/Plugin.hpp>
 #include <Poco/Logger.h>
 #include <Poco/Format.h>
+#include <unordered_map>
+#include <memory>
+#include <vector>
 #include <mutex>
 #include <set>
 #include <map>
@@ -38,6 +42,42 @@ static std::map<size_t, std::set<size_t>> &getConvertIoMap(void)
     return map;
 }
 
+/***********************************************************************
+ * Conversion path cache:
+ * the resolved chain of converters for each (input, output) type pair,
+ * including the empty chain when there is no conversion.
+ * Readers load an immutable snapshot of the table without locking,
+ * and a resolved pair is published in a new copy of the table.
+ * Plugin events bump the generation and clear the table,
+ * so that paths resolved against the old registry are not published.
+ **********************************************************************/
+typedef std::vector<Pothos::Callable> ConvertPath;
+typedef std::unordered_map<size_t, ConvertPath> ConvertPathTable;
+
+static std::shared_ptr<const ConvertPathTable> &getConvertPathTable(void)
+{
+    static std::shared_ptr<const ConvertPathTable> table(std::make_shared<ConvertPathTable>());
+    return table;
+}
+
+static std::mutex &getConvertPathMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static size_t &getConvertGeneration(void)
+{
+    static size_t generation(0);
+    return generation;
+}
+
+static void clearConvertPathTable(void)
+{
+    std::lock_guard<std::mutex> lock(getConvertPathMutex());
+    std::atomic_store(&getConvertPathTable(), std::shared_ptr<const ConvertPathTable>(std::make_shared<ConvertPathTable>()));
+}
+
 /***********************************************************************
  * Conversion registration handling
  **********************************************************************/
@@ -56,7 +96,7 @@ static void handleConvertPluginEvent(const Pothos::Plugin &plugin, const std::st
         const std::type_info &inputType = call.type(0);
         const std::type_info &outputType = call.type(-1);
 
-        std::lock_guard<Pothos::Util::SpinLockRW> lock(getMapMutex());
+        //the caller holds the map mutex
         if (event == "add")
         {
             getConvertMap()[typesHashCombine(inputType, outputType)] = plugin;
@@ -75,50 +115,103 @@ static void handleConvertPluginEvent(const Pothos::Plugin &plugin, const std::st
     }
 }
 
+//the converters of a module load arrive in one batch,
+//so the caches are cleared once rather than per converter
+static void handleConvertPluginEvents(const std::vector<Pothos::Plugin> &plugins, const std::string &event)
+{
+    clearManagedCallCache();
+    {
+        std::lock_guard<Pothos::Util::SpinLockRW> lock(getMapMutex());
+        for (const auto &plugin : plugins) handleConvertPluginEvent(plugin, event);
+        getConvertGeneration()++;
+    }
+    clearConvertPathTable();
+}
+
 /***********************************************************************
  * Register event handler
  **********************************************************************/
 pothos_static_block(pothosObjectConvertRegister)
 {
-    Pothos::PluginRegistry::addCall("/object/convert", &handleConvertPluginEvent);
+    Pothos::PluginRegistry::addCall("/object/convert", &handleConvertPluginEvents);
 }
 
 /***********************************************************************
- * The conversion implementation
+ * Conversion path resolution
  **********************************************************************/
-static Pothos::Object convertObject(const Pothos::Object &inputObj, const std::type_info &outputType)
+//a converter from the registry, removed plugins leave a null entry
+static Pothos::Callable findConverter(const size_t key)
+{
+    auto it = getConvertMap().find(key);
+    if (it == getConvertMap().end() or not it->second.getObject()) return Pothos::Callable();
+    return it->second.getObject().extract<Pothos::Callable>();
+}
+
+static ConvertPath resolveConvertPath(const std::type_info &srcType, const std::type_info &dstType, size_t &generation)
 {
-    //find the plugin in the map, it will be null if not found
     Pothos::Util::SpinLockRW::SharedLock lock(getMapMutex());
-    auto it = getConvertMap().find(typesHashCombine(inputObj.type(), outputType));
+    generation = getConvertGeneration();
+
+    //a direct conversion
+    const auto call = findConverter(typesHashCombine(srcType, dstType));
+    if (call) return ConvertPath(1, call);
 
     //try an intermediate conversion
-    if (it == getConvertMap().end())
+    auto itIo = getConvertIoMap().find(srcType.hash_code());
+    if (itIo != getConvertIoMap().end()) for (const size_t intermHash : itIo->second)
     {
-        auto itIo = getConvertIoMap().find(inputObj.type().hash_code());
-        if (itIo != getConvertIoMap().end()) for (const size_t intermHash : itIo->second)
-        {
-            auto it1 = getConvertMap().find(typesHashCombine(inputObj.type().hash_code(), intermHash));
-            auto it2 = getConvertMap().find(typesHashCombine(intermHash, outputType.hash_code()));
-            if (it1 != getConvertMap().end() and it2 != getConvertMap().end())
-            {
-                const auto &call1 = it1->second.getObject().extract<Pothos::Callable>();
-                const auto &call2 = it2->second.getObject().extract<Pothos::Callable>();
-                Pothos::Object intermediate = call1.opaqueCall(&inputObj, 1);
-                return call2.opaqueCall(&intermediate, 1);
-            }
-        }
+        const auto call1 = findConverter(typesHashCombine(srcType.hash_code(), intermHash));
+        const auto call2 = findConverter(typesHashCombine(intermHash, dstType.hash_code()));
+        if (call1 and call2) return ConvertPath{call1, call2};
+    }
+
+    return ConvertPath();
+}
+
+static ConvertPath lookupConvertPath(const std::type_info &srcType, const std::type_info &dstType)
+{
+    const auto key = typesHashCombine(srcType, dstType);
+    {
+        const auto table = std::atomic_load(&getConvertPathTable());
+        auto it = table->find(key);
+        if (it != table->end()) return it->second;
+    }
+
+    //resolve from the registry and publish a new table with the path
+    size_t generation(0);
+    auto path = resolveConvertPath(srcType, dstType, generation);
+    std::lock_guard<std::mutex> lock(getConvertPathMutex());
+    {
+        Pothos::Util::SpinLockRW::SharedLock mapLock(getMapMutex());
+        if (generation != getConvertGeneration()) return path;
     }
+    auto table = std::make_shared<ConvertPathTable>(*std::atomic_load(&getConvertPathTable()));
+    (*table)[key] = path;
+    std::atomic_store(&getConvertPathTable(), std::shared_ptr<const ConvertPathTable>(table));
+    return path;
+}
+
+/***********************************************************************
+ * The conversion implementation
+ **********************************************************************/
+static Pothos::Object convertObject(const Pothos::Object &inputObj, const std::type_info &outputType)
+{
+    const auto path = lookupConvertPath(inputObj.type(), outputType);
 
     //thow an error when the conversion is not supported
-    if (it == getConvertMap().end()) throw Pothos::ObjectConvertError(
+    if (path.empty()) throw Pothos::ObjectConvertError(
         "Pothos::Object::convert()",
         Poco::format("doesnt support %s to %s",
         inputObj.getTypeString(),
         Pothos::Util::typeInfoToString(outputType)));
 
-    const auto &call = it->second.getObject().extract<Pothos::Callable>();
-    return call.opaqueCall(&inputObj, 1);
+    Pothos::Object result = path.front().opaqueCall(&inputObj, 1);
+    for (size_t i = 1; i < path.size(); i++)
+    {
+        const auto intermediate = std::move(result);
+        result = path[i].opaqueCall(&intermediate, 1);
+    }
+    return result;
 }
 
 Pothos::Object Pothos::Object::convert(const std::type_info &type) const
@@ -137,20 +230,5 @@ bool Pothos::Object::canConvert(const std::type_info &type) const
 bool Pothos::Object::canConvert(const std::type_info &srcType, const std::type_info &dstType)
 {
     if (srcType == dstType) return true;
-    Pothos::Util::SpinLockRW::SharedLock lock(getMapMutex());
-    auto it = getConvertMap().find(typesHashCombine(srcType, dstType));
-
-    //try an intermediate conversion
-    if (it == getConvertMap().end())
-    {
-        auto itIo = getConvertIoMap().find(srcType.hash_code());
-        if (itIo != getConvertIoMap().end()) for (const size_t intermHash : itIo->second)
-        {
-            auto it1 = getConvertMap().find(typesHashCombine(srcType.hash_code(), intermHash));
-            auto it2 = getConvertMap().find(typesHashCombine(intermHash, dstType.hash_code()));
-            if (it1 != getConvertMap().end() and it2 != getConvertMap().end()) return true;
-        }
-    }
-
-    return (it != getConvertMap().end());
+    return not lookupConvertPath(srcType, dstType).empty();
 }
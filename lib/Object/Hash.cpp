@@ -1,6 +1,7 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "BuiltinTypes.hpp"
 #include <Pothos/Object/Object.hpp>
 #include <Pothos/Object/Exception.hpp>
 #include <Pothos/Util/SpinLockRW.hpp>
@@ -8,6 +9,7 @@
 #include <Pothos/Plugin.hpp>
 #include <Poco/Logger.h>
 #include <Poco/Format.h>
+#include <functional> //std::hash
 #include <mutex>
 #include <map>
 
@@ -67,11 +69,35 @@ pothos_static_block(pothosObjectHashFcnRegister)
     Pothos::PluginRegistry::addCall("/object/hash", &handleHashFcnPluginEvent);
 }
 
+/***********************************************************************
+ * Hash builtin types without the registry (same as the registered hashes)
+ **********************************************************************/
+struct BuiltinHasher
+{
+    template <typename T>
+    void operator()(const T &value)
+    {
+        hash = std::hash<T>()(value);
+    }
+
+    //buffers hash by the view of the memory
+    void operator()(const Pothos::BufferChunk &buff)
+    {
+        hash = std::hash<size_t>()(buff.address) ^ (std::hash<size_t>()(buff.length) << 1);
+    }
+
+    size_t hash;
+};
+
 /***********************************************************************
  * The hash code implementation
  **********************************************************************/
 size_t Pothos::Object::hashCode(void) const
 {
+    if (not *this) return typeid(NullObject).hash_code();
+    BuiltinHasher hasher;
+    if (visitBuiltinObject(*this, hasher)) return hasher.hash;
+
     //find the plugin in the map, it will be null if not found
     Pothos::Util::SpinLockRW::SharedLock lock(getMapMutex());
     auto it = getHashFcnMap().find(this->type().hash_code());
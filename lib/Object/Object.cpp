@@ -1,10 +1,11 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Object/ObjectImpl.hpp>
 #include <Pothos/Object/Exception.hpp>
 #include <Pothos/Util/TypeInfo.hpp>
 #include <Poco/Format.h>
+#include <new>
 #include <cassert>
 
 /***********************************************************************
@@ -36,6 +37,94 @@ Pothos::Detail::ObjectContainer::~ObjectContainer(void)
     return;
 }
 
+/***********************************************************************
+ * Object container pool:
+ * freed containers are kept in per-thread free lists by size class,
+ * containers freed on another thread join that thread's free lists,
+ * and each list is capped so the pool cannot grow without a bound
+ **********************************************************************/
+static const size_t POOL_BLOCK_ALIGN = 16;
+static const size_t POOL_NUM_CLASSES = 8; //up to 128 byte containers
+static const size_t POOL_MAX_BLOCKS = 256; //per size class
+
+struct ObjectContainerPool
+{
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    ObjectContainerPool(void)
+    {
+        for (size_t i = 0; i < POOL_NUM_CLASSES; i++)
+        {
+            freeLists[i] = nullptr;
+            numBlocks[i] = 0;
+        }
+    }
+
+    ~ObjectContainerPool(void);
+
+    FreeBlock *freeLists[POOL_NUM_CLASSES];
+    size_t numBlocks[POOL_NUM_CLASSES];
+};
+
+//set when the thread's pool is destroyed, an Object released afterwards
+//(by another thread-local or static destructor) uses the heap directly
+static thread_local bool poolDestroyed(false);
+
+ObjectContainerPool::~ObjectContainerPool(void)
+{
+    poolDestroyed = true;
+    for (size_t i = 0; i < POOL_NUM_CLASSES; i++)
+    {
+        while (freeLists[i] != nullptr)
+        {
+            auto block = freeLists[i];
+            freeLists[i] = block->next;
+            ::operator delete(block);
+        }
+    }
+}
+
+static ObjectContainerPool *getObjectContainerPool(void)
+{
+    if (poolDestroyed) return nullptr;
+    static thread_local ObjectContainerPool pool;
+    return &pool;
+}
+
+void *Pothos::Detail::ObjectContainer::operator new(const size_t size)
+{
+    const size_t sizeClass = (size+POOL_BLOCK_ALIGN-1)/POOL_BLOCK_ALIGN - 1;
+    if (sizeClass >= POOL_NUM_CLASSES) return ::operator new(size);
+
+    auto pool = getObjectContainerPool();
+    if (pool != nullptr and pool->freeLists[sizeClass] != nullptr)
+    {
+        auto block = pool->freeLists[sizeClass];
+        pool->freeLists[sizeClass] = block->next;
+        pool->numBlocks[sizeClass]--;
+        return block;
+    }
+
+    //blocks are allocated at the size class so any container of the class can reuse them
+    return ::operator new((sizeClass+1)*POOL_BLOCK_ALIGN);
+}
+
+void Pothos::Detail::ObjectContainer::operator delete(void *p, const size_t size)
+{
+    if (p == nullptr) return;
+    const size_t sizeClass = (size+POOL_BLOCK_ALIGN-1)/POOL_BLOCK_ALIGN - 1;
+    auto pool = (sizeClass < POOL_NUM_CLASSES)?getObjectContainerPool():nullptr;
+    if (pool == nullptr or pool->numBlocks[sizeClass] >= POOL_MAX_BLOCKS) return ::operator delete(p);
+
+    auto block = reinterpret_cast<ObjectContainerPool::FreeBlock *>(p);
+    block->next = pool->freeLists[sizeClass];
+    pool->freeLists[sizeClass] = block;
+    pool->numBlocks[sizeClass]++;
+}
+
 static void incr(Pothos::Detail::ObjectContainer *o)
 {
     if (o == nullptr) return;
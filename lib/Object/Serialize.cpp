@@ -1,10 +1,17 @@
-// Copyright (c) 2013-2016 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Object/Serialize.hpp>
 #include <Pothos/Object/Exception.hpp>
+#include <Pothos/Framework/Exception.hpp>
+#include "Framework/MappedFile.hpp"
+#include <fstream>
+#include <limits>
 #include <cassert>
 
+//platform specific page size implemented in SharedBufferUnix/Windows.cpp
+size_t sharedBufferPageSize(void);
+
 std::ostream &Pothos::Object::serialize(std::ostream &os) const
 {
     try
@@ -42,3 +49,87 @@ std::istream &Pothos::Object::deserialize(std::istream &is)
 
     return is;
 }
+
+/***********************************************************************
+ * Memory serialization
+ **********************************************************************/
+void Pothos::Object::serialize(std::vector<char> &buffer) const
+{
+    try
+    {
+        Pothos::Archive::OStreamArchiver oa(buffer);
+        oa << *this;
+    }
+    catch(const Pothos::ArchiveException &ex)
+    {
+        throw ObjectSerializeError("Pothos::Object::serialize("+this->toString()+")", ex.what());
+    }
+}
+
+size_t Pothos::Object::deserialize(const void *data, const size_t length)
+{
+    assert(not *this);
+
+    try
+    {
+        Pothos::Archive::IStreamArchiver ia(data, length);
+        ia >> *this;
+        return size_t(ia.bytesRead());
+    }
+    catch(const Pothos::ArchiveException &ex)
+    {
+        throw ObjectSerializeError("Pothos::Object::deserialize()", ex.what());
+    }
+    catch(const std::exception &ex)
+    {
+        throw ObjectSerializeError("Pothos::Object::deserialize()", ex.what());
+    }
+}
+
+/***********************************************************************
+ * File serialization
+ **********************************************************************/
+void Pothos::Object::serializeFile(const std::string &path) const
+{
+    std::ofstream os(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (not os) throw ObjectSerializeError("Pothos::Object::serializeFile("+path+")", "cannot open file");
+
+    try
+    {
+        Pothos::Archive::OStreamArchiver oa(os);
+        oa.setPayloadAlignment(sharedBufferPageSize());
+        oa << *this;
+    }
+    catch(const Pothos::ArchiveException &ex)
+    {
+        throw ObjectSerializeError("Pothos::Object::serializeFile("+this->toString()+")", ex.what());
+    }
+
+    os.close();
+    if (not os) throw ObjectSerializeError("Pothos::Object::serializeFile("+path+")", "write failed");
+}
+
+void Pothos::Object::deserializeFile(const std::string &path)
+{
+    assert(not *this);
+
+    try
+    {
+        auto file = MappedFile::open(path, false);
+        if (file->size() > std::numeric_limits<size_t>::max()) throw ObjectSerializeError(
+            "Pothos::Object::deserializeFile("+path+")", "file exceeds the address space");
+
+        //the views hold the container of the window, which holds the file
+        const auto window = file->map(0, size_t(file->size()));
+        Pothos::Archive::IStreamArchiver ia(reinterpret_cast<const void *>(window.getAddress()), window.getLength(), window.getContainer());
+        ia >> *this;
+    }
+    catch(const Pothos::ArchiveException &ex)
+    {
+        throw ObjectSerializeError("Pothos::Object::deserializeFile("+path+")", ex.what());
+    }
+    catch(const Pothos::SharedBufferError &ex)
+    {
+        throw ObjectSerializeError("Pothos::Object::deserializeFile("+path+")", ex.what());
+    }
+}
@@ -0,0 +1,26 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Benchmark.hpp>
+
+POTHOS_BENCH_BLOCK("/plugin/bench", bench_plugin_lookup)
+{
+    //look up the path of this benchmark, which is several nodes deep
+    const Pothos::PluginPath path("/plugin/bench/bench_plugin_lookup");
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        const auto plugin = Pothos::PluginRegistry::get(path);
+        Pothos::BenchmarkState::doNotOptimize(plugin);
+    }
+}
+
+POTHOS_BENCH_BLOCK("/plugin/bench", bench_plugin_path_lookup)
+{
+    //include the cost of parsing the path string
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        const auto plugin = Pothos::PluginRegistry::get("/plugin/bench/bench_plugin_path_lookup");
+        Pothos::BenchmarkState::doNotOptimize(plugin);
+    }
+}
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2016 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Plugin/Loader.hpp>
@@ -10,7 +10,13 @@
 #include <Poco/Logger.h>
 #include <Poco/Path.h>
 #include <Poco/File.h>
+#include <algorithm> //min/max
+#include <atomic>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 static std::vector<Poco::Path> getModulePaths(const Poco::Path &path)
 {
@@ -37,21 +43,194 @@ static std::vector<Poco::Path> getModulePaths(const Poco::Path &path)
     return paths;
 }
 
+void moduleLoaderCacheBatchBegin(void);
+void moduleLoaderCacheBatchEnd(void);
+bool moduleLoaderCacheGetPluginPaths(const std::string &modulePath, std::vector<std::string> &pluginPaths);
+void moduleLoaderCacheSetPluginPaths(const std::string &modulePath, const std::vector<std::string> &pluginPaths);
+void moduleLoaderSafeLoadProbe(const std::vector<std::string> &modulePaths);
+
+/***********************************************************************
+ * on-demand module loading
+ **********************************************************************/
+struct OnDemandIndex
+{
+    OnDemandIndex(const std::vector<std::string> &modulePaths):
+        modulePaths(modulePaths),
+        claimed(modulePaths.size(), false),
+        loaded(new std::atomic<bool>[modulePaths.size()])
+    {
+        for (size_t i = 0; i < modulePaths.size(); i++) loaded[i] = false;
+    }
+
+    const std::vector<std::string> modulePaths;
+    std::vector<bool> claimed; //protected by the loader mutex
+    std::unique_ptr<std::atomic<bool>[]> loaded; //set when the load completes
+
+    //plugin paths and their parent paths to indexes of the modules beneath
+    std::unordered_map<std::string, std::vector<size_t>> prefixes;
+};
+
+static std::shared_ptr<OnDemandIndex> &getOnDemandIndex(void)
+{
+    static std::shared_ptr<OnDemandIndex> index;
+    return index;
+}
+
+//recursive because loading a module calls into plugin event handlers
+static std::recursive_mutex &getOnDemandMutex(void)
+{
+    static std::recursive_mutex mutex;
+    return mutex;
+}
+
+static std::vector<Pothos::PluginModule> &getOnDemandModules(void)
+{
+    static std::vector<Pothos::PluginModule> modules;
+    return modules;
+}
+
+static bool isLazyModuleLoading(void)
+{
+    const auto lazy = Poco::Environment::get("POTHOS_LAZY_MODULES", "");
+    return lazy == "1" or lazy == "true";
+}
+
+/*!
+ * Load the deferred modules that register plugins at or beneath the path.
+ * Called by the registry readers before they look up the path.
+ */
+void pluginLoaderLoadOnDemand(const std::string &path)
+{
+    auto index = std::atomic_load(&getOnDemandIndex());
+    if (not index) return;
+    auto it = index->prefixes.find(path);
+    if (it == index->prefixes.end()) return;
+
+    //fast path: the modules beneath this path are already loaded
+    bool allLoaded = true;
+    for (const auto i : it->second) allLoaded = allLoaded and index->loaded[i];
+    if (allLoaded) return;
+
+    //concurrent readers wait here until the load completes
+    std::lock_guard<std::recursive_mutex> lock(getOnDemandMutex());
+    for (const auto i : it->second)
+    {
+        if (index->claimed[i]) continue;
+        index->claimed[i] = true;
+        poco_debug(Poco::Logger::get("Pothos.PluginLoader.load"), "on demand " + index->modulePaths[i]);
+        POTHOS_EXCEPTION_TRY
+        {
+            //the valid index implies that a safe load previously succeeded
+            getOnDemandModules().push_back(Pothos::PluginModule(index->modulePaths[i]));
+        }
+        POTHOS_EXCEPTION_CATCH (const Pothos::Exception &ex)
+        {
+            poco_error(Poco::Logger::get("Pothos.PluginLoader.load"), ex.displayText());
+        }
+        index->loaded[i] = true;
+    }
+}
+
+//! Release the deferred modules that were loaded on demand
+void pluginLoaderUnloadOnDemand(void)
+{
+    std::atomic_store(&getOnDemandIndex(), std::shared_ptr<OnDemandIndex>());
+    std::vector<Pothos::PluginModule> modules;
+    {
+        std::lock_guard<std::recursive_mutex> lock(getOnDemandMutex());
+        modules.swap(getOnDemandModules());
+    }
+    //unload in reverse order of the loads
+    while (not modules.empty()) modules.pop_back();
+}
+
+/***********************************************************************
+ * module loader implementation
+ **********************************************************************/
 std::vector<Pothos::PluginModule> Pothos::PluginLoader::loadModules(void)
 {
     const auto searchPaths = Pothos::System::getPothosModuleSearchPaths();
+    const bool lazy = isLazyModuleLoading();
 
-    //traverse the search paths and spawn futures
-    std::vector<std::future<Pothos::PluginModule>> futures;
+    //the safe load cache is read once and written once for the batch
+    moduleLoaderCacheBatchBegin();
+
+    //traverse the search paths to collect the modules,
+    //in lazy mode, modules with a valid plugin path index are deferred
+    std::vector<std::string> modulePaths, deferredPaths;
+    std::vector<std::vector<std::string>> deferredPluginPaths;
     for (const auto &searchPath : searchPaths)
     {
         for (const auto &path : getModulePaths(searchPath))
         {
-            futures.push_back(std::async(std::launch::async, &Pothos::PluginModule::safeLoad, path.toString()));
+            std::vector<std::string> pluginPaths;
+            if (lazy and moduleLoaderCacheGetPluginPaths(path.toString(), pluginPaths) and not pluginPaths.empty())
+            {
+                deferredPaths.push_back(path.toString());
+                deferredPluginPaths.push_back(pluginPaths);
+            }
+            else modulePaths.push_back(path.toString());
+        }
+    }
+
+    //probe the modules missing from the cache in one helper process,
+    //so the workers below only spawn a process for a module without a result
+    moduleLoaderSafeLoadProbe(modulePaths);
+
+    //a bounded number of workers claim modules in order,
+    //the results keep the order of the search paths
+    std::vector<std::future<Pothos::PluginModule>> futures;
+    std::vector<std::promise<Pothos::PluginModule>> promises(modulePaths.size());
+    for (auto &promise : promises) futures.push_back(promise.get_future());
+
+    std::atomic<size_t> nextIndex(0);
+    auto worker = [&](void)
+    {
+        for (size_t i = nextIndex++; i < modulePaths.size(); i = nextIndex++)
+        {
+            try
+            {
+                auto module = Pothos::PluginModule::safeLoad(modulePaths[i]);
+                moduleLoaderCacheSetPluginPaths(modulePaths[i], module.getPluginPaths());
+                promises[i].set_value(module);
+            }
+            catch (...)
+            {
+                promises[i].set_exception(std::current_exception());
+            }
+        }
+    };
+
+    const size_t numWorkers = std::min<size_t>(modulePaths.size(), std::max<size_t>(std::thread::hardware_concurrency(), 1));
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < numWorkers; i++) workers.emplace_back(worker);
+    for (auto &thread : workers) thread.join();
+    moduleLoaderCacheBatchEnd();
+
+    //publish the deferred modules once the others are loaded
+    if (not deferredPaths.empty())
+    {
+        std::shared_ptr<OnDemandIndex> index(new OnDemandIndex(deferredPaths));
+        for (size_t i = 0; i < deferredPaths.size(); i++)
+        {
+            for (const auto &pluginPath : deferredPluginPaths[i])
+            {
+                //the plugin path and each parent path, ending at the root
+                std::string prefix = pluginPath;
+                while (true)
+                {
+                    auto &indexes = index->prefixes[prefix.empty()?"/":prefix];
+                    if (indexes.empty() or indexes.back() != i) indexes.push_back(i);
+                    if (prefix.empty()) break;
+                    prefix.resize(prefix.find_last_of('/'));
+                }
+            }
         }
+        std::atomic_store(&getOnDemandIndex(), index);
+        poco_debug_f1(Poco::Logger::get("Pothos.PluginLoader.load"), "deferred %z modules until their plugins are requested", deferredPaths.size());
     }
 
-    //wait for completion of future module load
+    //collect the results of the module loads
     std::vector<PluginModule> modules;
     for (auto &future : futures)
     {
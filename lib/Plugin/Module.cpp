@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2018 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/System/Paths.hpp>
@@ -6,6 +6,7 @@
 #include <Pothos/Plugin/Registry.hpp>
 #include <Pothos/Plugin/Exception.hpp>
 #include <Pothos/Object.hpp> //pulls in full Object implementation
+#include "System/StartupProfile.hpp"
 #include <Poco/SharedLibrary.h>
 #include <Poco/Platform.h>
 #include <Poco/Logger.h>
@@ -46,6 +47,21 @@ struct ErrorMessageDisableGuard
  * Locking for plugin attach helper
  **********************************************************************/
 void registrySetActiveModuleLoading(const Pothos::PluginModule &module);
+void registryEventBatchBegin(void);
+void registryEventBatchEnd(void);
+
+//! Deliver the plugin events of the scope in one batch per handler
+struct RegistryEventBatch
+{
+    RegistryEventBatch(void)
+    {
+        registryEventBatchBegin();
+    }
+    ~RegistryEventBatch(void)
+    {
+        registryEventBatchEnd();
+    }
+};
 
 std::vector<std::string> getPluginPaths(const Pothos::PluginModule &module);
 
@@ -93,8 +109,12 @@ Pothos::PluginModule::PluginModule(const std::string &path):
         std::lock_guard<std::mutex> lock(getModuleMutex());
         registrySetActiveModuleLoading(*this);
         currentModuleVersion = &(_impl->version);
-        ErrorMessageDisableGuard emdg;
-        _impl->sharedLibrary.load(path);
+        {
+            RegistryEventBatch eventBatch;
+            ErrorMessageDisableGuard emdg;
+            StartupProfileTimer timer("module", path);
+            _impl->sharedLibrary.load(path);
+        }
         currentModuleVersion = nullptr;
         registrySetActiveModuleLoading(PluginModule());
         _impl->pluginPaths = ::getPluginPaths(*this);
@@ -112,9 +132,12 @@ Pothos::PluginModule::~PluginModule(void)
     if (not _impl->sharedLibrary.isLoaded()) return; //module not loaded
 
     poco_debug(Poco::Logger::get("Pothos.PluginModule.unload"), _impl->sharedLibrary.getPath());
-    for (const auto &pluginPath : this->getPluginPaths())
     {
-        PluginRegistry::remove(pluginPath);
+        RegistryEventBatch eventBatch;
+        for (const auto &pluginPath : this->getPluginPaths())
+        {
+            PluginRegistry::remove(pluginPath);
+        }
     }
     _impl->sharedLibrary.unload();
 }
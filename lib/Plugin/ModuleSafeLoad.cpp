@@ -1,17 +1,25 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/System/Paths.hpp>
 #include <Pothos/Plugin/Module.hpp>
 #include <Pothos/Plugin/Exception.hpp>
 #include <Pothos/Util/FileLock.hpp>
+#include "System/StartupProfile.hpp"
 #include <Poco/Process.h>
 #include <Poco/Pipe.h>
+#include <Poco/PipeStream.h>
+#include <Poco/Logger.h>
 #include <Poco/File.h>
 #include <Poco/Path.h>
 #include <Poco/AutoPtr.h>
 #include <Poco/Util/PropertyFileConfiguration.h>
+#include <Poco/StringTokenizer.h>
 #include <mutex>
+#include <map>
+#include <set>
+#include <memory>
+#include <vector>
 #include <cctype>
 
 //! The path used to cache the safe loads
@@ -65,13 +73,74 @@ static std::string escape(const std::string &in)
     return out;
 }
 
-//! Was a previous safe-load of this module successful?
-static bool previousLoadWasSuccessful(const std::string &modulePath)
+/***********************************************************************
+ * batched cache access during PluginLoader::loadModules()
+ **********************************************************************/
+struct LoaderCacheBatch
 {
-    std::lock_guard<std::mutex> mutexLock(getLoaderMutex());
+    LoaderCacheBatch(void):
+        depth(0){}
+    size_t depth;
+    Poco::AutoPtr<Poco::Util::PropertyFileConfiguration> cache;
+    std::map<std::string, std::string> pending; //entries to write back
+    std::set<std::string> failed; //modules that failed the batch probe
+};
+
+static LoaderCacheBatch &getLoaderCacheBatch(void)
+{
+    static LoaderCacheBatch batch;
+    return batch;
+}
+
+//! Load the cache file, the caller holds the loader mutex
+static Poco::AutoPtr<Poco::Util::PropertyFileConfiguration> loadLoaderCache(void)
+{
+    std::lock_guard<Pothos::Util::FileLock> fileLock(getLoaderFileLock());
+    Poco::AutoPtr<Poco::Util::PropertyFileConfiguration> cache(new Poco::Util::PropertyFileConfiguration());
+    try {cache->load(getModuleLoaderCachePath());} catch(...){}
+    return cache;
+}
+
+//! Merge entries into the cache file, the caller holds the loader mutex
+static void saveLoaderCache(const std::map<std::string, std::string> &entries)
+{
+    if (entries.empty()) return;
+    //reload under the file lock to keep entries written by other processes
     std::lock_guard<Pothos::Util::FileLock> fileLock(getLoaderFileLock());
     Poco::AutoPtr<Poco::Util::PropertyFileConfiguration> cache(new Poco::Util::PropertyFileConfiguration());
     try {cache->load(getModuleLoaderCachePath());} catch(...){}
+    for (const auto &entry : entries) cache->setString(entry.first, entry.second);
+    try {cache->save(getModuleLoaderCachePath());} catch(...){}
+}
+
+/*!
+ * Begin a batch of safe loads: the cache file is read once,
+ * and successful loads are written back once when the batch ends.
+ */
+void moduleLoaderCacheBatchBegin(void)
+{
+    std::lock_guard<std::mutex> mutexLock(getLoaderMutex());
+    auto &batch = getLoaderCacheBatch();
+    if (batch.depth++ == 0) batch.cache = loadLoaderCache();
+}
+
+void moduleLoaderCacheBatchEnd(void)
+{
+    std::lock_guard<std::mutex> mutexLock(getLoaderMutex());
+    auto &batch = getLoaderCacheBatch();
+    if (batch.depth == 0 or --batch.depth != 0) return;
+    saveLoaderCache(batch.pending);
+    batch.pending.clear();
+    batch.failed.clear();
+    batch.cache = nullptr;
+}
+
+//! Was a previous safe-load of this module successful?
+static bool previousLoadWasSuccessful(const std::string &modulePath)
+{
+    std::lock_guard<std::mutex> mutexLock(getLoaderMutex());
+    auto &batch = getLoaderCacheBatch();
+    auto cache = (batch.depth != 0)?batch.cache:loadLoaderCache();
 
     try
     {
@@ -89,15 +158,176 @@ static bool previousLoadWasSuccessful(const std::string &modulePath)
 static void markCurrentLoadSuccessful(const std::string &modulePath)
 {
     std::lock_guard<std::mutex> mutexLock(getLoaderMutex());
-    std::lock_guard<Pothos::Util::FileLock> fileLock(getLoaderFileLock());
-    Poco::AutoPtr<Poco::Util::PropertyFileConfiguration> cache(new Poco::Util::PropertyFileConfiguration());
-    try {cache->load(getModuleLoaderCachePath());} catch(...){}
+    std::map<std::string, std::string> entries;
+    entries[escape(Pothos::System::getPothosRuntimeLibraryPath())] = getLastModifiedTimeStr(Pothos::System::getPothosRuntimeLibraryPath());
+    entries[escape(modulePath)] = getLastModifiedTimeStr(modulePath);
 
-    auto libTime = getLastModifiedTimeStr(Pothos::System::getPothosRuntimeLibraryPath());
-    auto modTime = getLastModifiedTimeStr(modulePath);
-    cache->setString(escape(Pothos::System::getPothosRuntimeLibraryPath()), libTime);
-    cache->setString(escape(modulePath), modTime);
-    try {cache->save(getModuleLoaderCachePath());} catch(...){}
+    //defer the write until the end of the batch
+    auto &batch = getLoaderCacheBatch();
+    if (batch.depth == 0) return saveLoaderCache(entries);
+    batch.pending.insert(entries.begin(), entries.end());
+}
+
+/***********************************************************************
+ * plugin path index used by the on-demand loader
+ **********************************************************************/
+//! The cache key for the plugin paths of a module
+static std::string getPluginPathsKey(const std::string &modulePath)
+{
+    return "plugins"+escape(modulePath);
+}
+
+/*!
+ * Get the plugin paths that a module registered the last time it was loaded.
+ * The index is only valid when the module and runtime library are unchanged.
+ * \return true when a valid index was found
+ */
+bool moduleLoaderCacheGetPluginPaths(const std::string &modulePath, std::vector<std::string> &pluginPaths)
+{
+    if (not previousLoadWasSuccessful(modulePath)) return false;
+
+    std::lock_guard<std::mutex> mutexLock(getLoaderMutex());
+    auto &batch = getLoaderCacheBatch();
+    auto cache = (batch.depth != 0)?batch.cache:loadLoaderCache();
+    const auto key = getPluginPathsKey(modulePath);
+    if (not cache->has(key)) return false;
+
+    //plugin paths cannot contain spaces, so they are space separated
+    pluginPaths.clear();
+    Poco::StringTokenizer tok(cache->getString(key), " ", Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+    for (const auto &path : tok) pluginPaths.push_back(path);
+    return true;
+}
+
+//! Record the plugin paths that a module registered when it was loaded
+void moduleLoaderCacheSetPluginPaths(const std::string &modulePath, const std::vector<std::string> &pluginPaths)
+{
+    std::string value;
+    for (const auto &path : pluginPaths) value += (value.empty()?"":" ") + path;
+
+    std::lock_guard<std::mutex> mutexLock(getLoaderMutex());
+    auto &batch = getLoaderCacheBatch();
+    const auto key = getPluginPathsKey(modulePath);
+    std::map<std::string, std::string> entries;
+    entries[key] = value;
+
+    //only write when the index changed
+    auto cache = (batch.depth != 0)?batch.cache:loadLoaderCache();
+    if (cache->has(key) and cache->getString(key) == value) return;
+    if (batch.depth == 0) return saveLoaderCache(entries);
+    batch.pending.insert(entries.begin(), entries.end());
+}
+
+/***********************************************************************
+ * batch probe of the modules in one helper process
+ **********************************************************************/
+static const std::string probeLoading("Loading: ");
+static const std::string probeSuccess("Success: ");
+static const std::string probeFailure("Failure: ");
+
+//! Record that the batch probe of this module failed
+static void markProbeFailed(const std::string &modulePath)
+{
+    std::lock_guard<std::mutex> mutexLock(getLoaderMutex());
+    getLoaderCacheBatch().failed.insert(modulePath);
+}
+
+//! Did the batch probe of this module fail?
+static bool probeFailed(const std::string &modulePath)
+{
+    std::lock_guard<std::mutex> mutexLock(getLoaderMutex());
+    auto &batch = getLoaderCacheBatch();
+    return batch.depth != 0 and batch.failed.count(modulePath) != 0;
+}
+
+/*!
+ * Probe the modules without a successful safe load in the cache
+ * with one helper process, rather than one process per module.
+ * The helper loads the modules in order and reports each result,
+ * when the helper crashes, the module in progress is marked as failed,
+ * and a new helper continues with the modules after it.
+ * The results are written to the cache when the batch ends.
+ * Modules left without a result are probed on their own by safeLoad().
+ */
+void moduleLoaderSafeLoadProbe(const std::vector<std::string> &modulePaths)
+{
+    std::vector<std::string> remaining;
+    for (const auto &path : modulePaths)
+    {
+        if (not previousLoadWasSuccessful(path)) remaining.push_back(path);
+    }
+
+    //a single module is probed the same way by safeLoad()
+    while (remaining.size() > 1)
+    {
+        StartupProfileTimer timer("probe", std::to_string(remaining.size()) + " modules in one helper");
+        Poco::Process::Args args;
+        args.push_back("--probe-modules");
+        Poco::Pipe inPipe, outPipe, errPipe;
+        Poco::Process::Env env;
+        std::unique_ptr<Poco::ProcessHandle> ph;
+        try
+        {
+            ph.reset(new Poco::ProcessHandle(Poco::Process::launch(
+                Pothos::System::getPothosUtilExecutablePath(),
+                args, &inPipe, &outPipe, &errPipe, env)));
+        }
+        catch (const Poco::Exception &ex)
+        {
+            poco_warning(Poco::Logger::get("Pothos.PluginModule.safeLoad"), "batch probe: " + ex.displayText());
+            return;
+        }
+
+        //close the error pipe to not overfill and backup
+        errPipe.close();
+
+        //the helper reads the whole list before it loads any module
+        {
+            Poco::PipeOutputStream os(inPipe);
+            for (const auto &path : remaining) os << path << "\n";
+            os.close();
+        }
+
+        std::set<std::string> done;
+        std::string line, loading;
+        Poco::PipeInputStream is(outPipe);
+        while (std::getline(is, line))
+        {
+            if (line.compare(0, probeLoading.size(), probeLoading) == 0)
+            {
+                loading = line.substr(probeLoading.size());
+            }
+            else if (line.compare(0, probeSuccess.size(), probeSuccess) == 0)
+            {
+                markCurrentLoadSuccessful(line.substr(probeSuccess.size()));
+                done.insert(line.substr(probeSuccess.size()));
+                loading.clear();
+            }
+            else if (line.compare(0, probeFailure.size(), probeFailure) == 0)
+            {
+                markProbeFailed(line.substr(probeFailure.size()));
+                done.insert(line.substr(probeFailure.size()));
+                loading.clear();
+            }
+        }
+        ph->wait();
+
+        //the module in progress crashed the helper
+        if (not loading.empty())
+        {
+            poco_error(Poco::Logger::get("Pothos.PluginModule.safeLoad"), "crashed the batch probe: " + loading);
+            markProbeFailed(loading);
+            done.insert(loading);
+        }
+
+        std::vector<std::string> next;
+        for (const auto &path : remaining)
+        {
+            if (done.count(path) == 0) next.push_back(path);
+        }
+        if (next.size() == remaining.size()) break; //no progress, leave the rest to safeLoad()
+        remaining = next;
+    }
 }
 
 /***********************************************************************
@@ -106,6 +336,11 @@ static void markCurrentLoadSuccessful(const std::string &modulePath)
 Pothos::PluginModule Pothos::PluginModule::safeLoad(const std::string &path)
 {
     if (previousLoadWasSuccessful(path)) return PluginModule(path);
+    if (probeFailed(path))
+    {
+        throw Pothos::PluginModuleError("Pothos::PluginModule("+path+")", "failed safe load");
+    }
+    StartupProfileTimer timer("probe", path);
 
     const int success = 200;
 
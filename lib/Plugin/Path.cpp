@@ -1,62 +1,74 @@
-// Copyright (c) 2013-2016 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Plugin/Path.hpp>
 #include <Pothos/Plugin/Exception.hpp>
-#include <Poco/StringTokenizer.h>
 
-static void validatePathString(const std::string &path)
+//! Validate the path string and split it into the nodes between the slashes
+static std::vector<std::string> parsePathString(const std::string &path)
 {
-    if (path == "/") return; //root path is ok, but may be funny for tokenizer since it ends in /
-    bool first = true;
-    for (const auto &name : Poco::StringTokenizer(path, "/"))
+    std::vector<std::string> nodes;
+    if (path.empty()) return nodes;
+    if (path.front() != '/')
     {
-        if (first and not name.empty())
-        {
-            throw Pothos::PluginPathError("Pothos::PluginPath("+path+")", "must start with root slash");
-        }
-        if (not first and name.empty())
+        throw Pothos::PluginPathError("Pothos::PluginPath("+path+")", "must start with root slash");
+    }
+    if (path.size() == 1) return nodes; //root path
+
+    for (size_t begin = 1; begin <= path.size();)
+    {
+        auto end = path.find('/', begin);
+        if (end == std::string::npos) end = path.size();
+        if (end == begin)
         {
             throw Pothos::PluginPathError("Pothos::PluginPath("+path+")", "contains an empty name");
         }
-        for (size_t i = 0; i < name.size(); i++)
+        for (size_t i = begin; i < end; i++)
         {
-            if (name[i] >= 'A' and name[i] <= 'Z') continue;
-            if (name[i] >= 'a' and name[i] <= 'z') continue;
-            if (name[i] >= '0' and name[i] <= '9') continue;
-            if (name[i] == '_' or  name[i] == '-') continue;
+            const char ch = path[i];
+            if (ch >= 'A' and ch <= 'Z') continue;
+            if (ch >= 'a' and ch <= 'z') continue;
+            if (ch >= '0' and ch <= '9') continue;
+            if (ch == '_' or  ch == '-') continue;
             throw Pothos::PluginPathError("Pothos::PluginPath("+path+")", "contains non-alphanumeric-slashy-dashy name");
         }
-        first = false;
+        nodes.emplace_back(path, begin, end-begin);
+        begin = end+1;
     }
+    return nodes;
 }
 
 Pothos::PluginPath::PluginPath(void):
     _path("/")
 {
-    validatePathString(_path);
+    return;
 }
 
 Pothos::PluginPath::PluginPath(const std::string &path):
-    _path(path)
+    _path(path),
+    _nodes(parsePathString(_path))
 {
-    validatePathString(_path);
+    return;
 }
 
 Pothos::PluginPath::PluginPath(const PluginPath &path0, const PluginPath &path1):
     _path(path0._path + path1._path) //should always be valid because of individual PluginPath rules
 {
-    validatePathString(_path);
+    _nodes.reserve(path0._nodes.size() + path1._nodes.size());
+    _nodes.insert(_nodes.end(), path0._nodes.begin(), path0._nodes.end());
+    _nodes.insert(_nodes.end(), path1._nodes.begin(), path1._nodes.end());
 }
 
 Pothos::PluginPath::PluginPath(const char *path):
-    _path(path)
+    _path(path),
+    _nodes(parsePathString(_path))
 {
-    validatePathString(_path);
+    return;
 }
 
 Pothos::PluginPath::PluginPath(const PluginPath &path):
-    _path(path._path)
+    _path(path._path),
+    _nodes(path._nodes)
 {
     return;
 }
@@ -69,6 +81,7 @@ Pothos::PluginPath::~PluginPath(void)
 Pothos::PluginPath &Pothos::PluginPath::operator=(const PluginPath &path)
 {
     _path = path._path;
+    _nodes = path._nodes;
     return *this;
 }
 
@@ -78,15 +91,9 @@ Pothos::PluginPath Pothos::PluginPath::join(const std::string &subPath) const
     return PluginPath(this->toString() + joiner + subPath);
 }
 
-std::vector<std::string> Pothos::PluginPath::listNodes(void) const
+const std::vector<std::string> &Pothos::PluginPath::listNodes(void) const
 {
-    std::vector<std::string> pathNames;
-    Poco::StringTokenizer tok(_path, "/", Poco::StringTokenizer::TOK_IGNORE_EMPTY);
-    for (Poco::StringTokenizer::Iterator it = tok.begin(); it != tok.end(); it++)
-    {
-        pathNames.push_back(*it);
-    }
-    return pathNames;
+    return _nodes;
 }
 
 std::string Pothos::PluginPath::toString(void) const
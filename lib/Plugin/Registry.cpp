@@ -1,14 +1,21 @@
-// Copyright (c) 2013-2018 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Plugin/Registry.hpp>
 #include <Pothos/Plugin/Exception.hpp>
 #include <Pothos/Util/SpinLockRW.hpp>
 #include <Pothos/Callable.hpp> //gets call implementation
+#include "System/StartupProfile.hpp"
 #include <Poco/Logger.h>
 #include <cassert>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <utility> //pair
+#include <vector>
 
 /***********************************************************************
  * registry data structure
@@ -47,82 +54,380 @@ static RegistryEntry &getRegistryRoot(void)
     return regRoot;
 }
 
+//path string to every entry created by add(), the entries are never erased,
+//and the map nodes are stable, so the pointers remain valid for the process
+static std::unordered_map<std::string, RegistryEntry *> &getRegistryIndex(void)
+{
+    static std::unordered_map<std::string, RegistryEntry *> index;
+    return index;
+}
+
+//hashed lookup without creating entries, null when the path is missing
+//the caller must hold the registry mutex for the lifetime of the result
+static RegistryEntry *findRegistryEntry(const Pothos::PluginPath &path)
+{
+    if (path.listNodes().empty()) return &getRegistryRoot();
+    const auto &index = getRegistryIndex();
+    auto it = index.find(path.toString());
+    if (it == index.end()) return nullptr;
+    return it->second;
+}
+
 /***********************************************************************
- * plugin event handler
+ * registry snapshot for lock-free readers
  **********************************************************************/
-static bool canObjectHandleEvent(const Pothos::Object &obj)
+struct RegistrySnapshot
+{
+    size_t generation;
+
+    //path string to the plugin at that path
+    std::unordered_map<std::string, Pothos::Plugin> plugins;
+
+    //path string to the ordered sub-nodes that contain plugins,
+    //only paths with at least one plugin here or deeper are present
+    std::unordered_map<std::string, std::vector<std::string>> nodes;
+};
+
+//bumped by every modification, snapshots of an older generation are stale
+static std::atomic<size_t> &getRegistryGeneration(void)
+{
+    static std::atomic<size_t> generation(0);
+    return generation;
+}
+
+static std::shared_ptr<const RegistrySnapshot> &getRegistrySnapshot(void)
+{
+    static std::shared_ptr<const RegistrySnapshot> snapshot;
+    return snapshot;
+}
+
+//returns the number of plugins at and below the entry
+static size_t loadSnapshot(const Pothos::PluginPath &path, const RegistryEntry &entry, RegistrySnapshot &snapshot)
 {
-    if (obj.type() != typeid(Pothos::Callable)) return false; //its not a call
+    size_t count = 0;
+    const auto key = path.toString();
+    if (entry.hasPlugin)
+    {
+        snapshot.plugins.emplace(key, entry.plugin);
+        count++;
+    }
+    std::vector<std::string> nodes;
+    for (const auto &name : entry.nodeNamesOrdered)
+    {
+        const size_t subCount = loadSnapshot(path.join(name), entry.nodes.at(name), snapshot);
+        if (subCount != 0) nodes.push_back(name);
+        count += subCount;
+    }
+    if (count != 0) snapshot.nodes.emplace(key, std::move(nodes));
+    return count;
+}
+
+/*!
+ * Get a snapshot of the current registry or null when it is stale.
+ * Readers of a null snapshot fall back to the locked tree walk.
+ * Module loading interleaves many additions with a few reads,
+ * so a stale snapshot is only rebuilt after a number of locked reads
+ * proportional to its size; the rebuild cost stays amortized.
+ */
+static std::shared_ptr<const RegistrySnapshot> getCurrentSnapshot(void)
+{
+    auto snapshot = std::atomic_load(&getRegistrySnapshot());
+    if (snapshot and snapshot->generation == getRegistryGeneration().load()) return snapshot;
+
+    static std::atomic<size_t> staleReads(0);
+    if (snapshot and staleReads++ < snapshot->plugins.size()/16) return nullptr;
+
+    //one rebuild at a time, other readers use the locked walk meanwhile
+    static std::mutex rebuildMutex;
+    std::unique_lock<std::mutex> rebuildLock(rebuildMutex, std::try_to_lock);
+    if (not rebuildLock.owns_lock()) return nullptr;
+
+    //the generation cannot change while the shared lock is held
+    Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
+    std::shared_ptr<RegistrySnapshot> newSnapshot(new RegistrySnapshot());
+    newSnapshot->generation = getRegistryGeneration().load();
+    loadSnapshot(Pothos::PluginPath(), getRegistryRoot(), *newSnapshot);
+    std::atomic_store(&getRegistrySnapshot(), std::shared_ptr<const RegistrySnapshot>(newSnapshot));
+    staleReads = 0;
+    return newSnapshot;
+}
+
+/***********************************************************************
+ * plugin event handler:
+ * A handler is a plugin with a callable of the signature
+ * void(const Pothos::Plugin &, const std::string &event),
+ * or a batch handler of the signature
+ * void(const std::vector<Pothos::Plugin> &, const std::string &event),
+ * which is called once with the plugins of each run of the same event.
+ **********************************************************************/
+enum EventHandlerKind
+{
+    EVENT_HANDLER_NONE,
+    EVENT_HANDLER_SINGLE,
+    EVENT_HANDLER_BATCH,
+};
+
+static EventHandlerKind getEventHandlerKind(const Pothos::Object &obj)
+{
+    if (obj.type() != typeid(Pothos::Callable)) return EVENT_HANDLER_NONE; //its not a call
     const Pothos::Callable &call = obj.extract<Pothos::Callable>();
-    if (not call) return false; //its null
+    if (not call) return EVENT_HANDLER_NONE; //its null
     //check the signature
-    if (call.type(-1) != typeid(void)) return false;
-    if (call.getNumArgs() != 2) return false;
-    if (call.type(0) != typeid(Pothos::Plugin)) return false;
-    if (call.type(1) != typeid(std::string)) return false;
-    return true;
+    if (call.type(-1) != typeid(void)) return EVENT_HANDLER_NONE;
+    if (call.getNumArgs() != 2) return EVENT_HANDLER_NONE;
+    if (call.type(1) != typeid(std::string)) return EVENT_HANDLER_NONE;
+    if (call.type(0) == typeid(Pothos::Plugin)) return EVENT_HANDLER_SINGLE;
+    if (call.type(0) == typeid(std::vector<Pothos::Plugin>)) return EVENT_HANDLER_BATCH;
+    return EVENT_HANDLER_NONE;
 }
 
-static void callPluginEventHandler(const Pothos::Object &handler, const Pothos::Plugin &plugin, const std::string &event)
+static void callPluginEventHandler(const Pothos::Plugin &handler, const std::vector<Pothos::Plugin> &plugins, const std::string &event)
 {
-    if (not canObjectHandleEvent(handler)) return;
-    POTHOS_EXCEPTION_TRY
+    if (plugins.empty()) return;
+    const auto kind = getEventHandlerKind(handler.getObject());
+    if (kind == EVENT_HANDLER_NONE) return;
+    StartupProfileTimer timer("event", handler.getPath().toString());
+    const auto &call = handler.getObject().extract<Pothos::Callable>();
+    if (kind == EVENT_HANDLER_BATCH)
     {
-        handler.extract<Pothos::Callable>().call(plugin, event);
+        POTHOS_EXCEPTION_TRY
+        {
+            call.call(plugins, event);
+        }
+        POTHOS_EXCEPTION_CATCH(const Pothos::Exception &ex)
+        {
+            poco_error_f3(Poco::Logger::get("Pothos.PluginRegistry.handlePluginEvent"),
+            "exception %s, %z plugins, event %s", ex.displayText(), plugins.size(), event);
+        }
+        return;
     }
-    POTHOS_EXCEPTION_CATCH(const Pothos::Exception &ex)
+    for (const auto &plugin : plugins)
     {
-        poco_error_f3(Poco::Logger::get("Pothos.PluginRegistry.handlePluginEvent"),
-        "exception %s, plugin %s, event %s", ex.displayText(), plugin.toString(), event);
+        POTHOS_EXCEPTION_TRY
+        {
+            call.call(plugin, event);
+        }
+        POTHOS_EXCEPTION_CATCH(const Pothos::Exception &ex)
+        {
+            poco_error_f3(Poco::Logger::get("Pothos.PluginRegistry.handlePluginEvent"),
+            "exception %s, plugin %s, event %s", ex.displayText(), plugin.toString(), event);
+        }
     }
 }
 
+static void callPluginEventHandler(const Pothos::Plugin &handler, const Pothos::Plugin &plugin, const std::string &event)
+{
+    callPluginEventHandler(handler, std::vector<Pothos::Plugin>(1, plugin), event);
+}
+
+//walk the parent entries of a path from the root, the caller holds the registry mutex
+//returns false when the path was removed meanwhile
+template <typename Fcn>
+static bool walkParentEntries(const Pothos::PluginPath &path, Fcn &&fcn)
+{
+    const auto &pathNodes = path.listNodes();
+    const RegistryEntry *root = &getRegistryRoot();
+    for (size_t i = 0; i+1 < pathNodes.size(); i++)
+    {
+        fcn(root);
+        //next node in the tree at this node name
+        auto it = root->nodes.find(pathNodes[i]);
+        if (it == root->nodes.end()) return false;
+        root = &it->second;
+    }
+    fcn(root);
+    return true;
+}
+
 static void handlePluginEvent(const Pothos::Plugin &plugin, const std::string &event)
 {
-    const Pothos::PluginPath &path = plugin.getPath();
     std::vector<Pothos::Plugin> parentPlugins;
 
     //traverse the tree - store a list of parent plugins
     //we lock the mutex here for protection and make a plugin copy
     {
         Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
-        const std::vector<std::string> pathNodes = path.listNodes();
-        RegistryEntry *root = &getRegistryRoot();
-
-        for (size_t i = 0; i+1 < pathNodes.size(); i++)
+        if (not walkParentEntries(plugin.getPath(), [&parentPlugins](const RegistryEntry *entry)
         {
-            parentPlugins.insert(parentPlugins.begin(), root->plugin);
-            //next node in the tree at this node name
-            root = &root->nodes[pathNodes[i]];
-        }
-        parentPlugins.insert(parentPlugins.begin(), root->plugin);
+            parentPlugins.insert(parentPlugins.begin(), entry->plugin);
+        })) return; //removed meanwhile
     }
 
     //traverse back up the plugin tree -- calling all potential handlers
     for (size_t i = 0; i < parentPlugins.size(); i++)
     {
-        callPluginEventHandler(parentPlugins[i].getObject(), plugin, event);
+        callPluginEventHandler(parentPlugins[i], plugin, event);
     }
 }
 
 //if the plugin is an event handler, and it just got added,
-//then what we do is do the event add on all sub-tree plugins
-static void handleMissedSubTreeEvents(const Pothos::Object &handler, const Pothos::PluginPath &path)
+//then what we do is collect the "add" of all sub-tree plugins,
+//except the paths that will get the event from a pending batch
+static void collectMissedSubTreeEvents(const Pothos::PluginPath &path, const std::set<std::string> &skip, std::vector<Pothos::Plugin> &plugins)
 {
     for (const auto &subdir : Pothos::PluginRegistry::list(path))
     {
         auto subPath = path.join(subdir);
-        try
+        if (skip.count(subPath.toString()) == 0) try
         {
-            callPluginEventHandler(handler, Pothos::PluginRegistry::get(subPath), "add");
+            plugins.push_back(Pothos::PluginRegistry::get(subPath));
         }
         catch(const Pothos::PluginRegistryError &)
         {
         }
-        handleMissedSubTreeEvents(handler, subPath);
+        collectMissedSubTreeEvents(subPath, skip, plugins);
     }
 }
 
+static void handleMissedSubTreeEvents(const Pothos::Plugin &handler)
+{
+    if (getEventHandlerKind(handler.getObject()) == EVENT_HANDLER_NONE) return;
+    std::vector<Pothos::Plugin> plugins;
+    collectMissedSubTreeEvents(handler.getPath(), std::set<std::string>(), plugins);
+    callPluginEventHandler(handler, plugins, "add");
+}
+
+/***********************************************************************
+ * batched event dispatch during a module load:
+ * The events of the plugins added and removed by this thread
+ * are held until the outermost batch ends, and then each handler
+ * gets its events in order, grouped into runs of the same event.
+ * The tree is walked once under the lock for all of the events.
+ **********************************************************************/
+struct PluginEventBatch
+{
+    PluginEventBatch(void):
+        depth(0){}
+    size_t depth;
+    std::vector<std::pair<Pothos::Plugin, std::string>> events;
+};
+
+static PluginEventBatch &getPluginEventBatch(void)
+{
+    static thread_local PluginEventBatch batch;
+    return batch;
+}
+
+//! Hold the plugin events of this thread, and return true when it did
+static bool deferPluginEvent(const Pothos::Plugin &plugin, const std::string &event)
+{
+    auto &batch = getPluginEventBatch();
+    if (batch.depth == 0) return false;
+    batch.events.emplace_back(plugin, event);
+    return true;
+}
+
+struct PluginEventRuns
+{
+    Pothos::Plugin handler;
+    std::vector<std::pair<std::string, std::vector<Pothos::Plugin>>> runs;
+    void push(const Pothos::Plugin &plugin, const std::string &event)
+    {
+        if (runs.empty() or runs.back().first != event) runs.emplace_back(event, std::vector<Pothos::Plugin>());
+        runs.back().second.push_back(plugin);
+    }
+};
+
+static void dispatchPluginEvents(const std::vector<std::pair<Pothos::Plugin, std::string>> &events)
+{
+    //the index of the "add" event of the handlers added in this batch
+    std::map<std::string, size_t> handlerAdds;
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        if (events[i].second != "add") continue;
+        if (getEventHandlerKind(events[i].first.getObject()) == EVENT_HANDLER_NONE) continue;
+        handlerAdds[events[i].first.getPath().toString()] = i;
+    }
+
+    //a handler added in this batch first gets the plugins that were beneath it
+    std::vector<PluginEventRuns> handlers;
+    std::unordered_map<const RegistryEntry *, long> handlerIndexes; //-1 when not a handler
+    for (const auto &pair : handlerAdds)
+    {
+        std::set<std::string> skip;
+        for (size_t i = pair.second+1; i < events.size(); i++)
+        {
+            if (events[i].second == "add") skip.insert(events[i].first.getPath().toString());
+        }
+        std::vector<Pothos::Plugin> plugins;
+        collectMissedSubTreeEvents(events[pair.second].first.getPath(), skip, plugins);
+        handlers.emplace_back();
+        handlers.back().handler = events[pair.second].first;
+        for (const auto &plugin : plugins) handlers.back().push(plugin, "add");
+    }
+
+    //traverse the tree once for all events with the handlers of each event
+    {
+        Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            std::vector<long> eventHandlers;
+            if (not walkParentEntries(events[i].first.getPath(), [&](const RegistryEntry *entry)
+            {
+                auto it = handlerIndexes.find(entry);
+                if (it == handlerIndexes.end())
+                {
+                    long index = -1;
+                    if (entry->hasPlugin and getEventHandlerKind(entry->plugin.getObject()) != EVENT_HANDLER_NONE)
+                    {
+                        //the handlers added in this batch already have an entry from the replay
+                        for (size_t j = 0; j < handlers.size() and index < 0; j++)
+                        {
+                            if (handlers[j].handler.getPath() == entry->plugin.getPath()) index = long(j);
+                        }
+                        if (index < 0)
+                        {
+                            index = long(handlers.size());
+                            handlers.emplace_back();
+                            handlers.back().handler = entry->plugin;
+                        }
+                    }
+                    it = handlerIndexes.emplace(entry, index).first;
+                }
+                if (it->second >= 0) eventHandlers.push_back(it->second);
+            })) continue; //removed meanwhile
+
+            //deepest handler first, and only the events after the handler was added
+            for (auto it = eventHandlers.rbegin(); it != eventHandlers.rend(); ++it)
+            {
+                auto &runs = handlers[*it];
+                const auto addIt = handlerAdds.find(runs.handler.getPath().toString());
+                if (addIt != handlerAdds.end() and i <= addIt->second) continue;
+                runs.push(events[i].first, events[i].second);
+            }
+        }
+    }
+
+    //deliver the runs of events to each handler outside of the lock
+    for (const auto &handler : handlers)
+    {
+        for (const auto &run : handler.runs)
+        {
+            callPluginEventHandler(handler.handler, run.second, run.first);
+        }
+    }
+}
+
+/*!
+ * Begin a batch of plugin events for the calling thread.
+ * Called around the load of a module, so the handlers
+ * see the plugins of the module once the load completes.
+ */
+void registryEventBatchBegin(void)
+{
+    getPluginEventBatch().depth++;
+}
+
+//! End a batch of plugin events, the outermost end delivers the events
+void registryEventBatchEnd(void)
+{
+    auto &batch = getPluginEventBatch();
+    if (batch.depth == 0 or --batch.depth != 0) return;
+    std::vector<std::pair<Pothos::Plugin, std::string>> events;
+    events.swap(batch.events);
+    dispatchPluginEvents(events);
+}
+
 /***********************************************************************
  * active module implementation
  **********************************************************************/
@@ -140,6 +445,9 @@ void registrySetActiveModuleLoading(const Pothos::PluginModule &module)
 
 void updatePluginAssociation(const std::string &action, const Pothos::Plugin &plugin);
 
+//from lib/Plugin/Loader.in.cpp
+void pluginLoaderLoadOnDemand(const std::string &path);
+
 /***********************************************************************
  * Registry implementation
  **********************************************************************/
@@ -153,16 +461,24 @@ void Pothos::PluginRegistry::add(const Plugin &plugin_)
 
     {
         std::lock_guard<Pothos::Util::SpinLockRW> lock(getRegistryMutex());
-        const std::vector<std::string> pathNodes = path.listNodes();
-        RegistryEntry *root = &getRegistryRoot();
+        RegistryEntry *root = findRegistryEntry(path);
 
-        for (size_t i = 0; i < pathNodes.size(); i++)
+        //create the missing entries along the path and index them
+        if (root == nullptr)
         {
-            auto it = std::find(root->nodeNamesOrdered.begin(), root->nodeNamesOrdered.end(), pathNodes[i]);
-            if (it == root->nodeNamesOrdered.end()) root->nodeNamesOrdered.push_back(pathNodes[i]);
-
-            //next node in the tree at this node name
-            root = &root->nodes[pathNodes[i]];
+            const auto &pathNodes = path.listNodes();
+            std::string entryPath;
+            root = &getRegistryRoot();
+            for (size_t i = 0; i < pathNodes.size(); i++)
+            {
+                auto it = std::find(root->nodeNamesOrdered.begin(), root->nodeNamesOrdered.end(), pathNodes[i]);
+                if (it == root->nodeNamesOrdered.end()) root->nodeNamesOrdered.push_back(pathNodes[i]);
+
+                //next node in the tree at this node name
+                root = &root->nodes[pathNodes[i]];
+                entryPath += "/" + pathNodes[i];
+                getRegistryIndex().emplace(entryPath, root);
+            }
         }
 
         //throw if the root already has a plugin
@@ -179,31 +495,31 @@ void Pothos::PluginRegistry::add(const Plugin &plugin_)
         updatePluginAssociation("add", plugin);
         root->hasPlugin = true;
         root->plugin = plugin;
+        getRegistryGeneration()++;
     }
 
+    if (deferPluginEvent(plugin, "add")) return;
     handlePluginEvent(plugin, "add");
-    handleMissedSubTreeEvents(plugin.getObject(), plugin.getPath());
+    handleMissedSubTreeEvents(plugin);
 }
 
 Pothos::Plugin Pothos::PluginRegistry::get(const PluginPath &path)
 {
-    Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
-    const std::vector<std::string> pathNodes = path.listNodes();
-    RegistryEntry *root = &getRegistryRoot();
-
-    for (size_t i = 0; i < pathNodes.size(); i++)
+    pluginLoaderLoadOnDemand(path.toString());
+    auto snapshot = getCurrentSnapshot();
+    if (snapshot)
     {
-        //next node in the tree at this node name
-        root = &root->nodes[pathNodes[i]];
+        auto it = snapshot->plugins.find(path.toString());
+        if (it != snapshot->plugins.end()) return it->second;
     }
-
-    //throw if the root does not have a plugin
-    if (not root->hasPlugin)
+    else
     {
-        throw Pothos::PluginRegistryError("Pothos::PluginRegistry::get("+path.toString()+")", "plugin path not found");
+        Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
+        auto entry = findRegistryEntry(path);
+        if (entry != nullptr and entry->hasPlugin) return entry->plugin;
     }
 
-    return root->plugin;
+    throw Pothos::PluginRegistryError("Pothos::PluginRegistry::get("+path.toString()+")", "plugin path not found");
 }
 
 Pothos::Plugin Pothos::PluginRegistry::remove(const PluginPath &path)
@@ -213,17 +529,10 @@ Pothos::Plugin Pothos::PluginRegistry::remove(const PluginPath &path)
     Plugin plugin;
     {
         std::lock_guard<Pothos::Util::SpinLockRW> lock(getRegistryMutex());
-        const std::vector<std::string> pathNodes = path.listNodes();
-        RegistryEntry *root = &getRegistryRoot();
-
-        for (size_t i = 0; i < pathNodes.size(); i++)
-        {
-            //next node in the tree at this node name
-            root = &root->nodes[pathNodes[i]];
-        }
+        RegistryEntry *root = findRegistryEntry(path);
 
         //throw if the root does not have a plugin
-        if (not root->hasPlugin)
+        if (root == nullptr or not root->hasPlugin)
         {
             throw Pothos::PluginRegistryError("Pothos::PluginRegistry::remove("+path.toString()+")", "plugin path not found");
         }
@@ -233,58 +542,53 @@ Pothos::Plugin Pothos::PluginRegistry::remove(const PluginPath &path)
         updatePluginAssociation("remove", plugin);
         root->hasPlugin = false;
         root->plugin = Plugin(); //clears
+        getRegistryGeneration()++;
     }
 
-    handlePluginEvent(plugin, "remove");
+    if (not deferPluginEvent(plugin, "remove")) handlePluginEvent(plugin, "remove");
     return plugin;
 }
 
 bool Pothos::PluginRegistry::empty(const PluginPath &path)
 {
-    Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
-    const std::vector<std::string> pathNodes = path.listNodes();
-    RegistryEntry *root = &getRegistryRoot();
-
-    for (size_t i = 0; i < pathNodes.size(); i++)
-    {
-        //next node in the tree at this node name
-        root = &root->nodes[pathNodes[i]];
-    }
+    pluginLoaderLoadOnDemand(path.toString());
+    auto snapshot = getCurrentSnapshot();
+    if (snapshot) return snapshot->plugins.count(path.toString()) == 0;
 
-    return not root->hasPlugin;
+    Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
+    auto entry = findRegistryEntry(path);
+    return entry == nullptr or not entry->hasPlugin;
 }
 
 bool Pothos::PluginRegistry::exists(const PluginPath &path)
 {
-    Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
-    const std::vector<std::string> pathNodes = path.listNodes();
-    RegistryEntry *root = &getRegistryRoot();
-
-    for (size_t i = 0; i < pathNodes.size(); i++)
-    {
-        //next node in the tree at this node name
-        root = &root->nodes[pathNodes[i]];
-    }
+    pluginLoaderLoadOnDemand(path.toString());
+    auto snapshot = getCurrentSnapshot();
+    if (snapshot) return snapshot->nodes.count(path.toString()) != 0;
 
-    return root->getNumPlugins() != 0;
+    Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
+    auto entry = findRegistryEntry(path);
+    return entry != nullptr and entry->getNumPlugins() != 0;
 }
 
 std::vector<std::string> Pothos::PluginRegistry::list(const PluginPath &path)
 {
-    Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
-    const std::vector<std::string> pathNodes = path.listNodes();
-    RegistryEntry *root = &getRegistryRoot();
-
-    for (size_t i = 0; i < pathNodes.size(); i++)
+    pluginLoaderLoadOnDemand(path.toString());
+    auto snapshot = getCurrentSnapshot();
+    if (snapshot)
     {
-        //next node in the tree at this node name
-        root = &root->nodes[pathNodes[i]];
+        auto it = snapshot->nodes.find(path.toString());
+        if (it == snapshot->nodes.end()) return std::vector<std::string>();
+        return it->second;
     }
 
+    Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
     std::vector<std::string> nodes;
-    for (const auto &name : root->nodeNamesOrdered)
+    auto entry = findRegistryEntry(path);
+    if (entry == nullptr) return nodes;
+    for (const auto &name : entry->nodeNamesOrdered)
     {
-        if (root->nodes[name].getNumPlugins() != 0) nodes.push_back(name);
+        if (entry->nodes.at(name).getNumPlugins() != 0) nodes.push_back(name);
     }
     return nodes;
 }
@@ -314,6 +618,7 @@ static void loadInfoDump(const Pothos::PluginPath &path, const RegistryEntry &en
 
 Pothos::PluginRegistryInfoDump Pothos::PluginRegistry::dump(void)
 {
+    pluginLoaderLoadOnDemand(PluginPath().toString());
     Pothos::Util::SpinLockRW::SharedLock lock(getRegistryMutex());
     PluginRegistryInfoDump dump;
     loadInfoDump(PluginPath(), getRegistryRoot(), dump);
@@ -1,8 +1,9 @@
-// Copyright (c) 2013-2014 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Plugin/Static.hpp>
 #include <Pothos/Exception.hpp>
+#include "System/StartupProfile.hpp"
 #include <Poco/Logger.h>
 
 void Pothos::Detail::safeInit(const std::string &clientAbi, const std::string &name, InitFcn init)
@@ -15,6 +16,7 @@ void Pothos::Detail::safeInit(const std::string &clientAbi, const std::string &n
             name, clientAbi, Pothos::System::getAbiVersion());
         return;
     }
+    StartupProfileTimer timer("static", name);
     POTHOS_EXCEPTION_TRY
     {
         init();
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2014 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Plugin.hpp>
@@ -7,6 +7,8 @@
 #include <string>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 POTHOS_TEST_BLOCK("/plugin/tests", test_plugin_path)
 {
@@ -24,6 +26,19 @@ POTHOS_TEST_BLOCK("/plugin/tests", test_plugin_path)
     POTHOS_TEST_THROWS(Pothos::PluginPath("/foo-bar/my_module "), Pothos::PluginPathError);
     POTHOS_TEST_THROWS(Pothos::PluginPath("foo-bar/my_module"), Pothos::PluginPathError);
     POTHOS_TEST_THROWS(Pothos::PluginPath("/foo bar/my_module"), Pothos::PluginPathError);
+
+    //the nodes are carried through joins and copies
+    const Pothos::PluginPath joinedPath(Pothos::PluginPath("/blocks"), goodPath);
+    POTHOS_TEST_EQUAL(joinedPath.toString(), "/blocks/foo-bar/my_module");
+    POTHOS_TEST_EQUAL(joinedPath.listNodes().size(), 3);
+    POTHOS_TEST_EQUAL(joinedPath.listNodes()[0], "blocks");
+    POTHOS_TEST_EQUAL(joinedPath.listNodes()[2], "my_module");
+    const auto subPath = nullPath.join("foo").join("bar");
+    POTHOS_TEST_EQUAL(subPath.toString(), "/foo/bar");
+    POTHOS_TEST_EQUAL(subPath.listNodes().size(), 2);
+    Pothos::PluginPath copiedPath;
+    copiedPath = subPath;
+    POTHOS_TEST_EQUAL(copiedPath.listNodes()[1], "bar");
 }
 
 POTHOS_TEST_BLOCK("/plugin/tests", test_plugin_registry)
@@ -56,4 +71,122 @@ POTHOS_TEST_BLOCK("/plugin/tests", test_plugin_registry)
     POTHOS_TEST_THROWS(Pothos::PluginRegistry::add(Pothos::Plugin("/tests/t0")), Pothos::PluginRegistryError);
     POTHOS_TEST_THROWS(Pothos::PluginRegistry::get(Pothos::PluginPath("/tests")), Pothos::PluginRegistryError);
     POTHOS_TEST_THROWS(Pothos::PluginRegistry::remove(Pothos::PluginPath("/tests/foo")), Pothos::PluginRegistryError);
+    POTHOS_TEST_THROWS(Pothos::PluginRegistry::remove(Pothos::PluginPath("/tests/missing")), Pothos::PluginRegistryError);
+    POTHOS_TEST_FALSE(Pothos::PluginRegistry::exists(Pothos::PluginPath("/tests/missing")));
+}
+
+POTHOS_TEST_BLOCK("/plugin/tests", test_plugin_registry_readers)
+{
+    const Pothos::PluginPath root("/tests/registry_readers");
+    const size_t numPlugins = 100;
+
+    //concurrent readers while plugins are added and removed
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < 4; i++) readers.emplace_back([&]()
+    {
+        while (not done)
+        {
+            for (const auto &name : Pothos::PluginRegistry::list(root))
+            {
+                Pothos::PluginRegistry::exists(root.join(name));
+                Pothos::PluginRegistry::empty(root.join(name));
+            }
+        }
+    });
+
+    for (size_t i = 0; i < numPlugins; i++)
+    {
+        Pothos::PluginRegistry::add(Pothos::Plugin(root.join("p"+std::to_string(i))));
+    }
+    for (size_t i = 0; i < numPlugins; i += 2)
+    {
+        Pothos::PluginRegistry::remove(root.join("p"+std::to_string(i)));
+    }
+    done = true;
+    for (auto &reader : readers) reader.join();
+
+    //repeated reads see the final state in the order of addition
+    for (size_t pass = 0; pass < 3; pass++)
+    {
+        const auto names = Pothos::PluginRegistry::list(root);
+        POTHOS_TEST_EQUAL(names.size(), numPlugins/2);
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            const auto name = "p"+std::to_string(i*2+1);
+            POTHOS_TEST_EQUAL(names[i], name);
+            POTHOS_TEST_TRUE(Pothos::PluginRegistry::get(root.join(name)).getPath() == root.join(name));
+            POTHOS_TEST_FALSE(Pothos::PluginRegistry::empty(root.join(name)));
+        }
+        POTHOS_TEST_FALSE(Pothos::PluginRegistry::exists(root.join("p0")));
+        POTHOS_TEST_TRUE(Pothos::PluginRegistry::empty(root.join("p0")));
+        POTHOS_TEST_THROWS(Pothos::PluginRegistry::get(root.join("p0")), Pothos::PluginRegistryError);
+        POTHOS_TEST_FALSE(Pothos::PluginRegistry::exists(root.join("missing/deeper")));
+        POTHOS_TEST_TRUE(Pothos::PluginRegistry::list(root.join("missing")).empty());
+    }
+
+    for (size_t i = 1; i < numPlugins; i += 2)
+    {
+        Pothos::PluginRegistry::remove(root.join("p"+std::to_string(i)));
+    }
+    POTHOS_TEST_FALSE(Pothos::PluginRegistry::exists(root));
+}
+
+//from lib/Plugin/Registry.cpp
+void registryEventBatchBegin(void);
+void registryEventBatchEnd(void);
+
+static std::vector<std::string> &getTestEvents(void)
+{
+    static std::vector<std::string> events;
+    return events;
+}
+
+static void testEventHandler(const Pothos::Plugin &plugin, const std::string &event)
+{
+    getTestEvents().push_back(event+" "+plugin.getPath().toString());
+}
+
+static void testBatchEventHandler(const std::vector<Pothos::Plugin> &plugins, const std::string &event)
+{
+    getTestEvents().push_back(event+" batch of "+std::to_string(plugins.size()));
+}
+
+POTHOS_TEST_BLOCK("/plugin/tests", test_plugin_event_batch)
+{
+    const Pothos::PluginPath root("/tests/event_batch");
+    getTestEvents().clear();
+    Pothos::PluginRegistry::add(Pothos::Plugin(root.join("before")));
+
+    //the events are held until the batch ends
+    registryEventBatchBegin();
+    Pothos::PluginRegistry::addCall(root, &testEventHandler);
+    Pothos::PluginRegistry::addCall(root.join("batched"), &testBatchEventHandler);
+    Pothos::PluginRegistry::add(Pothos::Plugin(root.join("p0")));
+    Pothos::PluginRegistry::add(Pothos::Plugin(root.join("batched/p1")));
+    Pothos::PluginRegistry::add(Pothos::Plugin(root.join("batched/p2")));
+    POTHOS_TEST_TRUE(getTestEvents().empty());
+    registryEventBatchEnd();
+
+    //the handler added in the batch gets the plugin from before the batch,
+    //and each later event once, the batch handler gets one call per run
+    std::vector<std::string> expected;
+    expected.push_back("add "+root.join("before").toString());
+    expected.push_back("add "+root.join("batched").toString());
+    expected.push_back("add "+root.join("p0").toString());
+    expected.push_back("add "+root.join("batched/p1").toString());
+    expected.push_back("add "+root.join("batched/p2").toString());
+    expected.push_back("add batch of 2");
+    POTHOS_TEST_EQUALV(getTestEvents(), expected);
+
+    //without a batch, each event is delivered as it happens
+    getTestEvents().clear();
+    Pothos::PluginRegistry::remove(root.join("batched/p2"));
+    expected.clear();
+    expected.push_back("remove batch of 1");
+    expected.push_back("remove "+root.join("batched/p2").toString());
+    POTHOS_TEST_EQUALV(getTestEvents(), expected);
+
+    for (const auto &name : {"batched/p1", "p0", "batched", "before"}) Pothos::PluginRegistry::remove(root.join(name));
+    Pothos::PluginRegistry::remove(root);
 }
@@ -0,0 +1,152 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Proxy/Batch.hpp>
+#include <Pothos/Proxy/Environment.hpp>
+#include <Pothos/Proxy/Handle.hpp>
+#include <Pothos/Proxy/Exception.hpp>
+#include <Poco/Format.h>
+
+/***********************************************************************
+ * Default batch implementation makes each call in order
+ **********************************************************************/
+std::vector<Pothos::ProxyBatchResult> Pothos::ProxyEnvironment::callBatch(const std::vector<ProxyBatchCall> &calls)
+{
+    std::vector<ProxyBatchResult> results(calls.size());
+    for (size_t i = 0; i < calls.size(); i++)
+    {
+        const auto &call = calls[i];
+        auto &result = results[i];
+        try
+        {
+            //resolve the object to call on
+            Proxy proxy = call.proxy;
+            if (not proxy)
+            {
+                if (call.target >= i) throw ProxyHandleCallError("Pothos::ProxyEnvironment::callBatch()",
+                    Poco::format("call %z references result %z", i, call.target));
+                if (results[call.target].error) throw ProxyHandleCallError("Pothos::ProxyEnvironment::callBatch()",
+                    Poco::format("call %z references failed call %z", i, call.target));
+                proxy = results[call.target].result;
+            }
+
+            //resolve the arguments
+            std::vector<Proxy> args; args.reserve(call.args.size());
+            for (const auto &arg : call.args)
+            {
+                if (arg.type() == typeid(Proxy)) args.push_back(arg.extract<Proxy>());
+                else if (arg.type() == typeid(ProxyBatchRef))
+                {
+                    const auto index = arg.extract<ProxyBatchRef>().index;
+                    if (index >= i or results[index].error) throw ProxyHandleCallError("Pothos::ProxyEnvironment::callBatch()",
+                        Poco::format("call %z has a bad argument reference %z", i, index));
+                    args.push_back(results[index].result);
+                }
+                else args.push_back(this->convertObjectToProxy(arg));
+            }
+
+            result.result = proxy.getHandle()->call(call.name, args.data(), args.size());
+            if (call.resultMode == ProxyBatchCall::RESULT_LOCAL) result.local = this->convertProxyToObject(result.result);
+        }
+        catch (const Exception &ex)
+        {
+            result.error.reset(ex.clone());
+        }
+    }
+    return results;
+}
+
+/***********************************************************************
+ * ProxyBatch implementation
+ **********************************************************************/
+Pothos::ProxyBatch::ProxyBatch(const std::shared_ptr<ProxyEnvironment> &env):
+    _env(env)
+{
+    return;
+}
+
+void Pothos::ProxyBatch::convert(const ProxyBatchRef &ref)
+{
+    _calls.at(ref.index).resultMode = ProxyBatchCall::RESULT_LOCAL;
+}
+
+void Pothos::ProxyBatch::discard(const ProxyBatchRef &ref)
+{
+    _calls.at(ref.index).resultMode = ProxyBatchCall::RESULT_NONE;
+}
+
+size_t Pothos::ProxyBatch::size(void) const
+{
+    return _calls.size();
+}
+
+Pothos::ProxyBatchRef Pothos::ProxyBatch::queue(ProxyBatchCall &&call)
+{
+    _calls.push_back(std::move(call));
+    return ProxyBatchRef(_calls.size()-1);
+}
+
+void Pothos::ProxyBatch::execute(void)
+{
+    if (_results.size() == _calls.size()) return;
+
+    //references to earlier executed results become direct proxies
+    //(references to failed or discarded results fail the call)
+    std::vector<ProxyBatchCall> calls(_calls.begin()+_results.size(), _calls.end());
+    const auto offset = _results.size();
+    std::vector<size_t> failed;
+    for (size_t i = 0; i < calls.size(); i++)
+    {
+        auto &call = calls[i];
+        auto resolve = [&](const size_t index, Proxy &out) -> size_t
+        {
+            if (index >= offset) return index - offset;
+            const auto &result = _results[index];
+            if (result.error or _calls[index].resultMode == ProxyBatchCall::RESULT_NONE) failed.push_back(i);
+            else if (result.result) out = result.result;
+            else out = _env->convertObjectToProxy(result.local);
+            return i; //a self reference fails in the environment
+        };
+        if (not call.proxy) call.target = resolve(call.target, call.proxy);
+        for (auto &arg : call.args)
+        {
+            if (arg.type() != typeid(ProxyBatchRef)) continue;
+            Proxy proxy;
+            const auto index = resolve(arg.extract<ProxyBatchRef>().index, proxy);
+            if (proxy) arg = Object(proxy);
+            else arg = Object(ProxyBatchRef(index));
+        }
+    }
+
+    auto results = _env->callBatch(calls);
+    if (results.size() != calls.size()) throw ProxyHandleCallError("Pothos::ProxyBatch::execute()",
+        Poco::format("expected %z results, got %z", calls.size(), results.size()));
+    for (const auto i : failed)
+    {
+        results[i].result = Proxy();
+        results[i].error.reset(new ProxyHandleCallError("Pothos::ProxyBatch::execute()",
+            Poco::format("call %z references a failed or discarded call", offset+i)));
+    }
+    _results.insert(_results.end(), results.begin(), results.end());
+}
+
+Pothos::Proxy Pothos::ProxyBatch::get(const ProxyBatchRef &ref) const
+{
+    if (ref.index >= _results.size()) throw ProxyHandleCallError("Pothos::ProxyBatch::get()",
+        Poco::format("result %z not executed", ref.index));
+    const auto &result = _results[ref.index];
+    if (result.error) result.error->rethrow();
+    if (result.result) return result.result;
+    if (_calls[ref.index].resultMode == ProxyBatchCall::RESULT_LOCAL) return _env->convertObjectToProxy(result.local);
+    return result.result;
+}
+
+Pothos::Object Pothos::ProxyBatch::getLocal(const ProxyBatchRef &ref) const
+{
+    if (ref.index >= _results.size()) throw ProxyHandleCallError("Pothos::ProxyBatch::get()",
+        Poco::format("result %z not executed", ref.index));
+    const auto &result = _results[ref.index];
+    if (result.error) result.error->rethrow();
+    if (_calls[ref.index].resultMode != ProxyBatchCall::RESULT_LOCAL) return Object();
+    return result.local;
+}
@@ -1,6 +1,7 @@
-// Copyright (c) 2014-2018 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "Proxy/ProxyConvert.hpp"
 #include <Pothos/Object/Containers.hpp>
 #include <Pothos/Proxy.hpp>
 #include <Pothos/Plugin.hpp>
@@ -11,11 +12,15 @@
 template <typename OutType>
 std::vector<OutType> convertProxyVectorToNativeVector(const Pothos::ProxyVector &v)
 {
+    Pothos::ObjectVector objVec(v.size());
+    convertProxiesToObjects(v.data(), v.size(), objVec.data());
     std::vector<OutType> nativeVec;
-    nativeVec.reserve(v.size());
-    for (const auto &elem : v)
+    nativeVec.reserve(objVec.size());
+    for (const auto &elem : objVec)
     {
-        nativeVec.push_back(elem);
+        //elements of the output type are copied without a conversion lookup
+        if (elem.type() == typeid(OutType)) nativeVec.push_back(elem.extract<OutType>());
+        else nativeVec.push_back(elem.convert<OutType>());
     }
     return nativeVec;
 }
@@ -36,12 +41,8 @@ Pothos::ProxyVector convertNativeVectorToProxyVector(const std::vector<InType> &
 
 static Pothos::ObjectVector convertProxyVectorToObjectVector(const Pothos::ProxyVector &v)
 {
-    Pothos::ObjectVector objVec;
-    objVec.reserve(v.size());
-    for (const auto &elem : v)
-    {
-        objVec.push_back(elem.toObject());
-    }
+    Pothos::ObjectVector objVec(v.size());
+    convertProxiesToObjects(v.data(), v.size(), objVec.data());
     return objVec;
 }
 
@@ -0,0 +1,116 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Plugin.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Object/Containers.hpp>
+#include <Pothos/Callable.hpp>
+#include <vector>
+
+/***********************************************************************
+ * A minimal environment of boxed integers,
+ * which relies on the registered converters
+ **********************************************************************/
+class TestConvertEnvironment : public Pothos::ProxyEnvironment
+{
+public:
+    std::string getName(void) const
+    {
+        return "test_convert";
+    }
+
+    Pothos::Proxy findProxy(const std::string &)
+    {
+        return Pothos::Proxy();
+    }
+
+    void serialize(const Pothos::Proxy &, std::ostream &)
+    {
+        return;
+    }
+
+    Pothos::Proxy deserialize(std::istream &)
+    {
+        return Pothos::Proxy();
+    }
+};
+
+class TestConvertHandle : public Pothos::ProxyHandle
+{
+public:
+    TestConvertHandle(const Pothos::ProxyEnvironment::Sptr &env, const int value):
+        env(env), value(value){}
+
+    Pothos::ProxyEnvironment::Sptr getEnvironment(void) const
+    {
+        return env;
+    }
+
+    Pothos::Proxy call(const std::string &, const Pothos::Proxy *, const size_t)
+    {
+        return Pothos::Proxy();
+    }
+
+    int compareTo(const Pothos::Proxy &) const
+    {
+        return 0;
+    }
+
+    size_t hashCode(void) const
+    {
+        return size_t(value);
+    }
+
+    std::string toString(void) const
+    {
+        return std::to_string(value);
+    }
+
+    std::string getClassName(void) const
+    {
+        return "box";
+    }
+
+    const Pothos::ProxyEnvironment::Sptr env;
+    const int value;
+};
+
+static Pothos::Proxy convertIntToBox(Pothos::ProxyEnvironment::Sptr env, const int &value)
+{
+    return Pothos::Proxy(new TestConvertHandle(env, value));
+}
+
+static Pothos::Object convertBoxToInt(const Pothos::Proxy &proxy)
+{
+    return Pothos::Object(std::dynamic_pointer_cast<TestConvertHandle>(proxy.getHandle())->value);
+}
+
+POTHOS_TEST_BLOCK("/proxy/tests", test_proxy_convert_cache)
+{
+    Pothos::PluginRegistry::add("/proxy/converters/test_convert/int_to_box", Pothos::Callable(&convertIntToBox));
+    Pothos::PluginRegistry::add("/proxy/converters/test_convert/box_to_int",
+        Pothos::ProxyConvertPair("box", Pothos::Callable(&convertBoxToInt)));
+
+    auto env = Pothos::ProxyEnvironment::Sptr(new TestConvertEnvironment());
+    auto proxy = env->makeProxy(42);
+    POTHOS_TEST_EQUAL(proxy.getClassName(), "box");
+    POTHOS_TEST_EQUAL(proxy.convert<int>(), 42);
+
+    //the elements of a vector convert with one converter lookup
+    Pothos::ProxyVector proxyVec;
+    for (int i = 0; i < 100; i++) proxyVec.push_back(env->makeProxy(i));
+    const auto intVec = Pothos::Object(proxyVec).convert<std::vector<int>>();
+    POTHOS_TEST_EQUAL(intVec.size(), 100);
+    for (int i = 0; i < 100; i++) POTHOS_TEST_EQUAL(intVec[i], i);
+    const auto objVec = Pothos::Object(proxyVec).convert<Pothos::ObjectVector>();
+    POTHOS_TEST_EQUAL(objVec.size(), 100);
+    POTHOS_TEST_EQUAL(objVec[99].extract<int>(), 99);
+
+    //removed converters are no longer used
+    Pothos::PluginRegistry::remove("/proxy/converters/test_convert/int_to_box");
+    Pothos::PluginRegistry::remove("/proxy/converters/test_convert/box_to_int");
+    POTHOS_TEST_THROWS(env->makeProxy(42), Pothos::ProxyEnvironmentConvertError);
+    POTHOS_TEST_THROWS(proxy.convert<int>(), Pothos::ProxyEnvironmentConvertError);
+    POTHOS_TEST_THROWS(Pothos::Object(proxyVec).convert<std::vector<int>>(), Pothos::Exception);
+}
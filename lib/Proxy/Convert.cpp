@@ -1,60 +1,48 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "Proxy/ProxyConvert.hpp"
 #include <Pothos/Proxy/Environment.hpp>
 #include <Pothos/Proxy/Handle.hpp>
 #include <Pothos/Proxy/Exception.hpp>
-#include <Pothos/Util/SpinLockRW.hpp>
 #include <Pothos/Util/TypeInfo.hpp>
 #include <Pothos/Callable.hpp>
 #include <Pothos/Plugin.hpp>
 #include <Poco/Logger.h>
-#include <Poco/Hash.h>
-#include <iostream>
+#include <Poco/Format.h>
 #include <cassert>
+#include <memory>
 #include <mutex>
-#include <map>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
 
 /***********************************************************************
- * Global map structure for conversions
+ * Converter table:
+ * the converters of each environment by local type and proxy class name.
+ * Readers load an immutable snapshot of the table without locking,
+ * and plugin events publish a new copy of the table.
  **********************************************************************/
-static Pothos::Util::SpinLockRW &getMapToLocalMutex(void)
-{
-    static Pothos::Util::SpinLockRW lock;
-    return lock;
-}
-
-static Pothos::Util::SpinLockRW &getMapToProxyMutex(void)
-{
-    static Pothos::Util::SpinLockRW lock;
-    return lock;
-}
-
-typedef std::map<size_t, Pothos::Plugin> ConvertMapType;
+typedef std::unordered_map<std::string, ProxyEnvironmentConverters> ProxyConvertTable;
 
-static ConvertMapType &getConvertToLocalMap(void)
+static std::shared_ptr<const ProxyConvertTable> &getProxyConvertTable(void)
 {
-    static ConvertMapType map;
-    return map;
+    static std::shared_ptr<const ProxyConvertTable> table(std::make_shared<ProxyConvertTable>());
+    return table;
 }
 
-static ConvertMapType &getConvertToProxyMap(void)
+static std::mutex &getProxyConvertMutex(void)
 {
-    static ConvertMapType map;
-    return map;
+    static std::mutex mutex;
+    return mutex;
 }
 
-/***********************************************************************
- * hash functions
- **********************************************************************/
-static size_t hashIt(const std::string &name, const std::type_info &type)
-{
-    return type.hash_code() ^ Poco::hash(name);
-}
-
-static size_t hashIt(const std::string &name, const std::string &type)
+std::shared_ptr<const ProxyEnvironmentConverters> getProxyEnvironmentConverters(const std::string &name)
 {
-    return Poco::hash(type) ^ Poco::hash(name);
+    const auto table = std::atomic_load(&getProxyConvertTable());
+    auto it = table->find(name);
+    if (it == table->end()) return std::shared_ptr<const ProxyEnvironmentConverters>();
+    return std::shared_ptr<const ProxyEnvironmentConverters>(table, &it->second);
 }
 
 /***********************************************************************
@@ -83,7 +71,7 @@ static bool isConvertToProxy(const Pothos::Plugin &plugin)
 /***********************************************************************
  * Conversion registration handling
  **********************************************************************/
-static void handlePluginEvent(const Pothos::Plugin &plugin, const std::string &event)
+static void handlePluginEvent(ProxyConvertTable &table, const Pothos::Plugin &plugin, const std::string &event)
 {
     poco_debug_f2(Poco::Logger::get("Pothos.Proxy.handlePluginEvent"), "plugin %s, event %s", plugin.toString(), event);
 
@@ -98,28 +86,16 @@ static void handlePluginEvent(const Pothos::Plugin &plugin, const std::string &e
         if (isConvertToLocal(plugin))
         {
             const auto &pair = plugin.getObject().extract<Pothos::ProxyConvertPair>();
-            std::lock_guard<Pothos::Util::SpinLockRW> lock(getMapToLocalMutex());
-            if (event == "add")
-            {
-                getConvertToLocalMap()[hashIt(name, pair.first)] = plugin;
-            }
-            if (event == "remove")
-            {
-                getConvertToLocalMap()[hashIt(name, pair.first)] = Pothos::Plugin();
-            }
+            auto &toLocal = table[name].toLocal;
+            if (event == "add") toLocal[pair.first] = pair.second;
+            if (event == "remove") toLocal.erase(pair.first);
         }
         else if (isConvertToProxy(plugin))
         {
             const auto &callable = plugin.getObject().extract<Pothos::Callable>();
-            std::lock_guard<Pothos::Util::SpinLockRW> lock(getMapToProxyMutex());
-            if (event == "add")
-            {
-                getConvertToProxyMap()[hashIt(name, callable.type(1))] = plugin;
-            }
-            if (event == "remove")
-            {
-                getConvertToProxyMap()[hashIt(name, callable.type(1))] = Pothos::Plugin();
-            }
+            auto &toProxy = table[name].toProxy;
+            if (event == "add") toProxy[std::type_index(callable.type(1))] = callable;
+            if (event == "remove") toProxy.erase(std::type_index(callable.type(1)));
         }
         else
         {
@@ -133,12 +109,22 @@ static void handlePluginEvent(const Pothos::Plugin &plugin, const std::string &e
     }
 }
 
+//the converters of a module load arrive in one batch,
+//so the table is copied and published once rather than per converter
+static void handlePluginEvents(const std::vector<Pothos::Plugin> &plugins, const std::string &event)
+{
+    std::lock_guard<std::mutex> lock(getProxyConvertMutex());
+    auto table = std::make_shared<ProxyConvertTable>(*std::atomic_load(&getProxyConvertTable()));
+    for (const auto &plugin : plugins) handlePluginEvent(*table, plugin, event);
+    std::atomic_store(&getProxyConvertTable(), std::shared_ptr<const ProxyConvertTable>(table));
+}
+
 /***********************************************************************
  * Register event handler
  **********************************************************************/
 pothos_static_block(pothosProxyConvertRegister)
 {
-    Pothos::PluginRegistry::addCall("/proxy/converters", &handlePluginEvent);
+    Pothos::PluginRegistry::addCall("/proxy/converters", &handlePluginEvents);
 }
 
 /***********************************************************************
@@ -146,22 +132,25 @@ pothos_static_block(pothosProxyConvertRegister)
  **********************************************************************/
 Pothos::Proxy Pothos::ProxyEnvironment::convertObjectToProxy(const Pothos::Object &local)
 {
-    //find the plugin in the map, it will be null if not found
-    Pothos::Util::SpinLockRW::SharedLock lock(getMapToProxyMutex());
-    const size_t h = hashIt(this->getName(), local.type());
-    auto it = getConvertToProxyMap().find(h);
+    //find the converter in the table, it will be null if not found
+    const Pothos::Callable *callable = nullptr;
+    const auto converters = getProxyEnvironmentConverters(this->getName());
+    if (converters)
+    {
+        auto it = converters->toProxy.find(std::type_index(local.type()));
+        if (it != converters->toProxy.end()) callable = &it->second;
+    }
 
     //thow an error when the conversion is not supported
-    if (it == getConvertToProxyMap().end()) throw Pothos::ProxyEnvironmentConvertError(
+    if (callable == nullptr) throw Pothos::ProxyEnvironmentConvertError(
         "Pothos::ProxyEnvironment::convertObjectToProxy()",
         Poco::format("doesnt support Object of type %s to %s environment",
         local.getTypeString(), this->getName()));
 
-    const auto &callable = it->second.getObject().extract<Pothos::Callable>();
     Pothos::Object args[2];
     args[0] = Pothos::Object(this->shared_from_this());
     args[1] = local;
-    return std::move(callable.opaqueCall(args, 2).ref<Pothos::Proxy>());
+    return std::move(callable->opaqueCall(args, 2).ref<Pothos::Proxy>());
 }
 
 Pothos::Object Pothos::ProxyEnvironment::convertProxyToObject(const Pothos::Proxy &proxy_)
@@ -173,19 +162,77 @@ Pothos::Object Pothos::ProxyEnvironment::convertProxyToObject(const Pothos::Prox
         proxy = this->convertObjectToProxy(proxy.toObject());
     }
 
-    //find the plugin in the map, it will be null if not found
-    Pothos::Util::SpinLockRW::SharedLock lock(getMapToLocalMutex());
-    const size_t h = hashIt(this->getName(), proxy.getHandle()->getClassName());
-    auto it = getConvertToLocalMap().find(h);
+    //find the converter in the table, it will be null if not found
+    const Pothos::Callable *callable = nullptr;
+    const auto className = proxy.getHandle()->getClassName();
+    const auto converters = getProxyEnvironmentConverters(this->getName());
+    if (converters)
+    {
+        auto it = converters->toLocal.find(className);
+        if (it != converters->toLocal.end()) callable = &it->second;
+    }
 
     //thow an error when the conversion is not supported
-    if (it == getConvertToLocalMap().end()) throw Pothos::ProxyEnvironmentConvertError(
+    if (callable == nullptr) throw Pothos::ProxyEnvironmentConvertError(
         "Pothos::ProxyEnvironment::convertProxyToObject()",
         Poco::format("doesnt support environment %s type %s to Object",
-        this->getName(), std::string(proxy.getHandle()->getClassName())));
+        this->getName(), className));
 
-    const auto &callable = it->second.getObject().extract<Pothos::ProxyConvertPair>().second;
     Pothos::Object args[1];
     args[0] = Pothos::Object(proxy);
-    return callable.opaqueCall(args, 1);
+    return callable->opaqueCall(args, 1);
+}
+
+/***********************************************************************
+ * Bulk conversion of container elements
+ **********************************************************************/
+void convertProxiesToObjects(const Pothos::Proxy *proxies, const size_t num, Pothos::Object *objs)
+{
+    Pothos::ProxyEnvironment::Sptr env;
+    std::shared_ptr<const ProxyEnvironmentConverters> converters;
+    std::string className;
+    const Pothos::Callable *callable = nullptr;
+
+    for (size_t i = 0; i < num; i++)
+    {
+        //look up the converters once per run of the same environment
+        auto elemEnv = proxies[i]?proxies[i].getEnvironment():Pothos::ProxyEnvironment::Sptr();
+        if (not elemEnv)
+        {
+            objs[i] = proxies[i].toObject();
+            continue;
+        }
+        if (elemEnv != env)
+        {
+            env = std::move(elemEnv);
+            converters = getProxyEnvironmentConverters(env->getName());
+            callable = nullptr;
+        }
+
+        //environments without registered converters implement their own conversion
+        if (not converters)
+        {
+            objs[i] = proxies[i].toObject();
+            continue;
+        }
+
+        //look up the converter once per run of the same class
+        auto name = proxies[i].getHandle()->getClassName();
+        if (callable == nullptr or name != className)
+        {
+            auto it = converters->toLocal.find(name);
+            if (it == converters->toLocal.end())
+            {
+                callable = nullptr;
+                objs[i] = proxies[i].toObject(); //reports the unsupported conversion
+                continue;
+            }
+            className = std::move(name);
+            callable = &it->second;
+        }
+
+        Pothos::Object args[1];
+        args[0] = Pothos::Object(proxies[i]);
+        objs[i] = callable->opaqueCall(args, 1);
+    }
 }
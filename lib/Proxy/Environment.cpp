@@ -43,8 +43,13 @@ std::string Pothos::ProxyEnvironment::getUniquePid(void) const
 
 std::string Pothos::ProxyEnvironment::getLocalUniquePid(void)
 {
-    const auto info = Pothos::System::HostInfo::get();
-    return info.nodeName + "/" + info.nodeId + "/" + info.pid;
+    //the identity of the process does not change, query the host info once
+    static const std::string upid = []
+    {
+        const auto info = Pothos::System::HostInfo::get();
+        return info.nodeName + "/" + info.nodeId + "/" + info.pid;
+    }();
+    return upid;
 }
 
 std::string Pothos::ProxyEnvironment::getPeeringAddress(void)
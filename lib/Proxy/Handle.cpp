@@ -1,9 +1,32 @@
-// Copyright (c) 2013 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Proxy/Handle.hpp>
+#include <Pothos/Proxy/Environment.hpp>
+#include <vector>
 
 Pothos::ProxyHandle::~ProxyHandle(void)
 {
     return;
 }
+
+std::future<Pothos::Proxy> Pothos::ProxyHandle::callAsync(const std::string &name, const Object *args, const size_t numArgs)
+{
+    std::promise<Proxy> promise;
+    try
+    {
+        auto env = this->getEnvironment();
+        std::vector<Proxy> proxyArgs; proxyArgs.reserve(numArgs);
+        for (size_t i = 0; i < numArgs; i++)
+        {
+            if (args[i].type() == typeid(Proxy)) proxyArgs.push_back(args[i].extract<Proxy>());
+            else proxyArgs.push_back(env->convertObjectToProxy(args[i]));
+        }
+        promise.set_value(this->call(name, proxyArgs.data(), proxyArgs.size()));
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+    return promise.get_future();
+}
@@ -0,0 +1,33 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Callable.hpp>
+#include <Pothos/Proxy/Proxy.hpp>
+#include <Pothos/Object/Object.hpp>
+#include <unordered_map>
+#include <typeindex>
+#include <memory>
+#include <string>
+
+//! The converters registered under /proxy/converters for one environment
+struct ProxyEnvironmentConverters
+{
+    //local type to a proxy in the environment
+    std::unordered_map<std::type_index, Pothos::Callable> toProxy;
+
+    //proxy class name to a local object
+    std::unordered_map<std::string, Pothos::Callable> toLocal;
+};
+
+//! Get the converters of an environment by name, null when it has none
+std::shared_ptr<const ProxyEnvironmentConverters> getProxyEnvironmentConverters(const std::string &name);
+
+/*!
+ * Convert each proxy into a local object like Proxy::toObject(),
+ * but look up the environment converters once per run of proxies
+ * from the same environment and class, rather than once per element.
+ * Environments without registered converters use their own conversion.
+ */
+void convertProxiesToObjects(const Pothos::Proxy *proxies, const size_t num, Pothos::Object *objs);
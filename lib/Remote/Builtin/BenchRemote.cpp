@@ -0,0 +1,67 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Remote/RemoteProxyDatagram.hpp"
+#include <Pothos/Benchmark.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Remote.hpp>
+#include <Pothos/Util/Network.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
+#include <cstring> //memset
+#include <sstream>
+#include <string>
+
+/***********************************************************************
+ * Serialize and deserialize datagrams without the network
+ **********************************************************************/
+static void benchDatagramEncodeDecode(Pothos::BenchmarkState &state, const Pothos::Object &payload)
+{
+    Pothos::ObjectKwargs reqArgs;
+    reqArgs["action"] = Pothos::Object("call");
+    reqArgs["name"] = Pothos::Object("bench");
+    reqArgs["arg0"] = payload;
+
+    std::stringstream ss;
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        ss.str(std::string());
+        ss.clear();
+        sendDatagram(ss, reqArgs);
+        const auto replyArgs = recvDatagram(ss);
+        Pothos::BenchmarkState::doNotOptimize(replyArgs);
+    }
+}
+
+POTHOS_BENCH_BLOCK("/proxy/remote/bench", bench_datagram_small)
+{
+    benchDatagramEncodeDecode(state, Pothos::Object(int(42)));
+}
+
+POTHOS_BENCH_BLOCK("/proxy/remote/bench", bench_datagram_buffer)
+{
+    Pothos::BufferChunk buff(65536);
+    std::memset(buff.as<void *>(), 0, buff.length);
+    state.setBytesPerIteration(buff.length);
+    benchDatagramEncodeDecode(state, Pothos::Object(buff));
+}
+
+/***********************************************************************
+ * Request and reply round trip to a proxy server
+ **********************************************************************/
+POTHOS_BENCH_BLOCK("/proxy/remote/bench", bench_remote_round_trip)
+{
+    //exclude spawning the server and connecting to it
+    state.pauseTiming();
+    Pothos::RemoteServer server("tcp://"+Pothos::Util::getWildcardAddr());
+    Pothos::RemoteClient client("tcp://"+Pothos::Util::getLoopbackAddr(server.getActualPort()));
+    auto env = client.makeEnvironment("managed");
+    state.resumeTiming();
+
+    //each conversion is one request and reply datagram
+    for (size_t i = 0; i < state.iterations(); i++)
+    {
+        const auto proxy = env->makeProxy(int(i));
+        Pothos::BenchmarkState::doNotOptimize(proxy);
+    }
+    state.pauseTiming();
+}
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Testing.hpp>
@@ -7,12 +7,17 @@
 #include <Pothos/Remote.hpp>
 #include <Pothos/Managed.hpp>
 #include <Pothos/Util/Network.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
 #include <Poco/Pipe.h>
 #include <Poco/PipeStream.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/StreamSocket.h>
 #include <Poco/URI.h>
 #include <iostream>
 #include <future>
 #include <thread>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <complex>
 #include <algorithm>
@@ -146,6 +151,32 @@ POTHOS_TEST_BLOCK("/proxy/remote/tests", test_inception)
     auto clientHandle2 = env->findProxy("Pothos/RemoteClient")("tcp://"+Pothos::Util::getLoopbackAddr(actualPort2));
 }
 
+POTHOS_TEST_BLOCK("/proxy/remote/tests", test_server_pool)
+{
+    const auto uri = "tcp://"+Pothos::Util::getWildcardAddr();
+    Pothos::RemoteServerPool pool(uri, 1);
+
+    //wait for the background spawn
+    for (size_t i = 0; i < 100 and pool.getNumReady() == 0; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    POTHOS_TEST_EQUAL(pool.getNumReady(), size_t(1));
+
+    //an acquired server is ready to connect
+    auto server = pool.acquire();
+    POTHOS_TEST_TRUE(server);
+    Pothos::RemoteClient client("tcp://"+Pothos::Util::getLoopbackAddr(server.getActualPort()));
+    POTHOS_TEST_TRUE(client.makeEnvironment("managed"));
+
+    //spawn through the default pool by proxy
+    Pothos::RemoteServerPool::setDefault(pool);
+    auto env = Pothos::ProxyEnvironment::make("managed");
+    auto serverHandle = env->findProxy("Pothos/RemoteServerPool").call("spawn", uri);
+    POTHOS_TEST_TRUE(not serverHandle.call<std::string>("getActualPort").empty());
+    Pothos::RemoteServerPool::setDefault(Pothos::RemoteServerPool());
+}
+
 //! A thread to handle remote proxy requests
 static void runRemoteProxy(Poco::Pipe &p0, Poco::Pipe &p1)
 {
@@ -173,6 +204,60 @@ POTHOS_TEST_BLOCK("/proxy/remote/tests", test_remote)
     t0.join();
 }
 
+static void test_batch_runner(Pothos::ProxyEnvironment::Sptr env)
+{
+    Pothos::ManagedClass()
+        .registerConstructor<SuperBar, int>()
+        .registerMethod(POTHOS_FCN_TUPLE(SuperBar, setBar))
+        .registerMethod(POTHOS_FCN_TUPLE(SuperBar, getBar))
+        .commit("SuperBar");
+
+    auto superBarProxy = env->findProxy("SuperBar");
+
+    //chain calls on the results of earlier calls
+    Pothos::ProxyBatch batch(env);
+    const auto instance = batch.call(superBarProxy, "()", 21);
+    const auto bar0 = batch.call(instance, "getBar");
+    batch.call(instance, "setBar", 42);
+    const auto bar1 = batch.call(instance, "getBar");
+    batch.convert(bar1);
+    const auto other = batch.call(superBarProxy, "()", instance); //bad arg type
+    const auto otherBar = batch.call(other, "getBar");
+    batch.execute();
+
+    POTHOS_TEST_EQUAL(batch.size(), size_t(6));
+    POTHOS_TEST_EQUAL(batch.get<int>(bar0), 21);
+    POTHOS_TEST_EQUAL(batch.get<int>(bar1), 42);
+    POTHOS_TEST_EQUAL(batch.get(instance).call<int>("getBar"), 42);
+    POTHOS_TEST_THROWS(batch.get(other), Pothos::Exception);
+    POTHOS_TEST_THROWS(batch.get(otherBar), Pothos::Exception);
+
+    //reference results from an earlier execute
+    const auto bar2 = batch.call(instance, "getBar");
+    const auto temp = batch.call(superBarProxy, "()", bar1);
+    batch.discard(temp);
+    const auto bar3 = batch.call(temp, "getBar");
+    batch.execute();
+    POTHOS_TEST_EQUAL(batch.get<int>(bar2), 42);
+    POTHOS_TEST_EQUAL(batch.get<int>(bar3), 42);
+
+    Pothos::ManagedClass::unload("SuperBar");
+}
+
+POTHOS_TEST_BLOCK("/proxy/remote/tests", test_batch)
+{
+    //check that the test runs locally first
+    test_batch_runner(Pothos::ProxyEnvironment::make("managed"));
+
+    //and with the remote batch implementation
+    Poco::Pipe p0, p1;
+    Poco::PipeInputStream is(p1);
+    Poco::PipeOutputStream os(p0);
+    std::thread t0(&runRemoteProxy, std::ref(p0), std::ref(p1));
+    test_batch_runner(Pothos::RemoteClient::makeEnvironment(is, os, "managed"));
+    t0.join();
+}
+
 POTHOS_TEST_BLOCK("/proxy/remote/tests", test_server)
 {
     Pothos::RemoteServer server("tcp://"+Pothos::Util::getWildcardAddr());
@@ -230,3 +315,244 @@ POTHOS_TEST_BLOCK("/proxy/remote/tests", test_multithread_safe)
     //therefore to be safe, we unregister these classes now
     Pothos::ManagedClass::unload("EchoTester");
 }
+
+struct BlockingTester
+{
+    static std::atomic<bool> &released(void)
+    {
+        static std::atomic<bool> flag(false);
+        return flag;
+    }
+
+    //wait for another client thread to call release()
+    static bool wait(void)
+    {
+        for (size_t i = 0; i < 5000 and not released(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return released();
+    }
+
+    static void release(void)
+    {
+        released() = true;
+    }
+};
+
+POTHOS_TEST_BLOCK("/proxy/remote/tests", test_concurrent_requests)
+{
+    Pothos::ManagedClass()
+        .registerClass<BlockingTester>()
+        .registerStaticMethod(POTHOS_FCN_TUPLE(BlockingTester, wait))
+        .registerStaticMethod(POTHOS_FCN_TUPLE(BlockingTester, release))
+        .commit("BlockingTester");
+    Poco::Pipe p0, p1;
+    Poco::PipeInputStream is(p1);
+    Poco::PipeOutputStream os(p0);
+    std::thread t0(&runRemoteProxy, std::ref(p0), std::ref(p1));
+    {
+        auto env = Pothos::RemoteClient::makeEnvironment(is, os, "managed");
+        auto tester = env->findProxy("BlockingTester");
+
+        //a blocked call from one thread does not stall calls from another
+        auto waiter = std::async(std::launch::async, [tester]{return tester.call<bool>("wait");});
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        tester.call("release");
+        POTHOS_TEST_TRUE(waiter.get());
+    }
+    t0.join();
+
+    Pothos::ManagedClass::unload("BlockingTester");
+}
+
+static void runRemoteClientConversions(const std::string &uri)
+{
+    Pothos::RemoteClient client(uri);
+    auto env = client.makeEnvironment("managed");
+    for (int i = 0; i < 100; i++) POTHOS_TEST_EQUAL(env->makeProxy(i).convert<int>(), i);
+}
+
+POTHOS_TEST_BLOCK("/proxy/remote/tests", test_server_concurrent_clients)
+{
+    //many connections create and release objects on the server at once
+    Pothos::RemoteServer server("tcp://"+Pothos::Util::getWildcardAddr());
+    const auto uri = "tcp://"+Pothos::Util::getLoopbackAddr(server.getActualPort());
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < 8; i++)
+    {
+        futures.push_back(std::async(std::launch::async, &runRemoteClientConversions, uri));
+    }
+    for (auto &future : futures) future.get();
+}
+
+static void test_call_async_runner(Pothos::ProxyEnvironment::Sptr env)
+{
+    auto echoTester = env->findProxy("EchoTester");
+
+    //many calls from one thread in flight at once
+    std::vector<std::future<Pothos::Proxy>> futures;
+    std::vector<int> expected;
+    for (size_t i = 0; i < 100; i++)
+    {
+        expected.push_back(std::rand());
+        futures.push_back(echoTester.callAsync("echo", expected.back()));
+    }
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        POTHOS_TEST_EQUAL(expected[i], futures[i].get().convert<int>());
+    }
+
+    //errors are reported through the future
+    auto badFuture = echoTester.callAsync("noSuchMethod");
+    POTHOS_TEST_THROWS(badFuture.get(), Pothos::Exception);
+}
+
+POTHOS_TEST_BLOCK("/proxy/remote/tests", test_call_async)
+{
+    Pothos::ManagedClass()
+        .registerClass<EchoTester>()
+        .registerStaticMethod(POTHOS_FCN_TUPLE(EchoTester, echo))
+        .commit("EchoTester");
+
+    test_call_async_runner(Pothos::ProxyEnvironment::make("managed"));
+
+    Poco::Pipe p0, p1;
+    Poco::PipeInputStream is(p1);
+    Poco::PipeOutputStream os(p0);
+    std::thread t0(&runRemoteProxy, std::ref(p0), std::ref(p1));
+    test_call_async_runner(Pothos::RemoteClient::makeEnvironment(is, os, "managed"));
+    t0.join();
+
+    Pothos::ManagedClass::unload("EchoTester");
+}
+
+POTHOS_TEST_BLOCK("/proxy/remote/tests", test_large_datagram)
+{
+    Poco::Pipe p0, p1;
+    Poco::PipeInputStream is(p1);
+    Poco::PipeOutputStream os(p0);
+    std::thread t0(&runRemoteProxy, std::ref(p0), std::ref(p1));
+    {
+        auto env = Pothos::RemoteClient::makeEnvironment(is, os, "managed");
+
+        //a buffer larger than the stream buffers round trips intact
+        Pothos::BufferChunk buffer(typeid(int), 1024*1024);
+        for (size_t i = 0; i < buffer.elements(); i++) buffer.as<int *>()[i] = std::rand();
+        auto proxy = env->makeProxy(buffer);
+        const auto result = proxy.convert<Pothos::BufferChunk>();
+        POTHOS_TEST_EQUAL(result.length, buffer.length);
+        POTHOS_TEST_EQUALA(result.as<const int *>(), buffer.as<const int *>(), buffer.elements());
+
+        //the stream stays in sync after a large transfer
+        POTHOS_TEST_EQUAL(env->makeProxy(42).convert<int>(), 42);
+    }
+    t0.join();
+}
+
+POTHOS_TEST_BLOCK("/proxy/remote/tests", test_socket_stream)
+{
+    Poco::Net::ServerSocket serverSocket(Poco::Net::SocketAddress("127.0.0.1", 0));
+    Poco::Net::StreamSocket clientSocket(Poco::Net::SocketAddress("127.0.0.1", serverSocket.address().port()));
+    auto serverConn = serverSocket.acceptConnection();
+
+    //small stream buffers take the vectored send and the direct receive
+    typedef Pothos::RemoteSocketStream::NativeSocket NativeSocket;
+    Pothos::RemoteSocketStream os(NativeSocket(clientSocket.impl()->sockfd()), 64);
+    Pothos::RemoteSocketStream is(NativeSocket(serverConn.impl()->sockfd()), 64);
+
+    std::vector<char> large(100000);
+    for (auto &b : large) b = char(std::rand());
+    std::thread writer([&os, &large](void)
+    {
+        os.write("hello", 5);
+        os.write(large.data(), large.size());
+        os.put('x');
+        os.flush();
+    });
+
+    char hello[5];
+    is.read(hello, sizeof(hello));
+    std::vector<char> largeOut(large.size());
+    is.read(largeOut.data(), largeOut.size());
+    const auto x = is.get();
+    writer.join();
+    POTHOS_TEST_TRUE(is);
+    POTHOS_TEST_EQUAL(std::string(hello, sizeof(hello)), "hello");
+    POTHOS_TEST_EQUALV(large, largeOut);
+    POTHOS_TEST_EQUAL(x, 'x');
+
+    //a remote environment with socket options in the URI query
+    Pothos::RemoteServer server("tcp://"+Pothos::Util::getLoopbackAddr());
+    Pothos::RemoteClient client("tcp://"+Pothos::Util::getLoopbackAddr(server.getActualPort())+
+        "?sendBufferSize=262144&recvBufferSize=262144&streamBufferSize=1024");
+    auto env = client.makeEnvironment("managed");
+    POTHOS_TEST_EQUAL(env->makeProxy(42).convert<int>(), 42);
+    POTHOS_TEST_THROWS(Pothos::RemoteClient("tcp://"+Pothos::Util::getLoopbackAddr(server.getActualPort())+"?foo=1"), Pothos::RemoteClientError);
+}
+
+POTHOS_TEST_BLOCK("/proxy/remote/tests", test_remote_lanes)
+{
+    Pothos::RemoteServer server("tcp://"+Pothos::Util::getWildcardAddr());
+    Pothos::RemoteClient client("tcp://"+Pothos::Util::getLoopbackAddr(server.getActualPort()));
+    {
+        Pothos::ProxyEnvironmentArgs args;
+        args["lanes"] = "3";
+        args["laneBytes"] = "1024";
+        auto env = client.makeEnvironment("managed", args);
+
+        //large uploads on the bulk lanes while small calls use the priority lane
+        std::vector<std::future<Pothos::BufferChunk>> uploads;
+        std::vector<Pothos::BufferChunk> buffers;
+        for (size_t i = 0; i < 4; i++)
+        {
+            Pothos::BufferChunk buffer(typeid(int), 1024*1024);
+            for (size_t j = 0; j < buffer.elements(); j++) buffer.as<int *>()[j] = std::rand();
+            buffers.push_back(buffer);
+            uploads.push_back(std::async(std::launch::async, [env, buffer]{return env->makeProxy(buffer).convert<Pothos::BufferChunk>();}));
+        }
+        for (int i = 0; i < 100; i++) POTHOS_TEST_EQUAL(env->makeProxy(i).convert<int>(), i);
+
+        //each handle is made on a bulk lane and converted on the priority lane
+        for (size_t i = 0; i < uploads.size(); i++)
+        {
+            const auto result = uploads[i].get();
+            POTHOS_TEST_EQUAL(result.length, buffers[i].length);
+            POTHOS_TEST_EQUALA(result.as<const int *>(), buffers[i].as<const int *>(), buffers[i].elements());
+        }
+    }
+
+    //invalid lane args
+    Pothos::ProxyEnvironmentArgs badArgs;
+    badArgs["lanes"] = "many";
+    POTHOS_TEST_THROWS(client.makeEnvironment("managed", badArgs), Pothos::InvalidArgumentException);
+}
+
+POTHOS_TEST_BLOCK("/proxy/remote/tests", test_compressed_datagram)
+{
+    Poco::Pipe p0, p1;
+    Poco::PipeInputStream is(p1);
+    Poco::PipeOutputStream os(p0);
+    std::thread t0(&runRemoteProxy, std::ref(p0), std::ref(p1));
+    {
+        Pothos::ProxyEnvironmentArgs args;
+        args["compression"] = "zlib";
+        args["compressBytes"] = "1024";
+        auto env = Pothos::RemoteClient::makeEnvironment(is, os, "managed", args);
+
+        //a compressible buffer is compressed both ways
+        Pothos::BufferChunk buffer(typeid(int), 1024*1024);
+        for (size_t i = 0; i < buffer.elements(); i++) buffer.as<int *>()[i] = int(i % 100);
+        const auto result = env->makeProxy(buffer).convert<Pothos::BufferChunk>();
+        POTHOS_TEST_EQUAL(result.length, buffer.length);
+        POTHOS_TEST_EQUALA(result.as<const int *>(), buffer.as<const int *>(), buffer.elements());
+
+        //small datagrams are not compressed
+        POTHOS_TEST_EQUAL(env->makeProxy(42).convert<int>(), 42);
+
+        //unsupported compression types are rejected by the client
+        args["compression"] = "lzma";
+        POTHOS_TEST_THROWS(Pothos::RemoteClient::makeEnvironment(is, os, "managed", args), Pothos::InvalidArgumentException);
+    }
+    t0.join();
+}
@@ -1,14 +1,16 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "RemoteProxy.hpp"
 #include <Pothos/Remote.hpp>
+#include <Pothos/Remote/SocketStream.hpp>
 #include <Pothos/Util/SpinLockRW.hpp>
 #include <Poco/Net/StreamSocket.h>
-#include <Poco/Net/SocketStream.h>
 #include <Poco/URI.h>
 #include <future>
 #include <mutex>
 #include <map>
+#include <string>
 #include <cassert>
 
 /***********************************************************************
@@ -92,20 +94,68 @@ static Poco::Net::IPAddress dnsLookup(const std::string &host, const long timeou
     return ipAddr;
 }
 
+/***********************************************************************
+ * Socket options from the URI query
+ **********************************************************************/
+struct RemoteSocketOptions
+{
+    RemoteSocketOptions(void):
+        isLocal(false),
+        sendBufferSize(0),
+        recvBufferSize(0),
+        streamBufferSize(65536)
+    {
+        return;
+    }
+    bool isLocal; //a unix domain socket
+    int sendBufferSize; //zero for the system default
+    int recvBufferSize; //zero for the system default
+    size_t streamBufferSize;
+};
+
+static RemoteSocketOptions parseSocketOptions(const Poco::URI &uri)
+{
+    RemoteSocketOptions opts;
+    opts.isLocal = uri.getScheme() == "unix";
+    for (const auto &param : uri.getQueryParameters())
+    {
+        int value(-1);
+        try {value = std::stoi(param.second);}
+        catch (const std::exception &){}
+        if (value < 0) throw Pothos::InvalidArgumentException(param.first+" = "+param.second);
+        if (param.first == "sendBufferSize") opts.sendBufferSize = value;
+        else if (param.first == "recvBufferSize") opts.recvBufferSize = value;
+        else if (param.first == "streamBufferSize") opts.streamBufferSize = size_t(value);
+        else throw Pothos::InvalidArgumentException("unknown URI option "+param.first);
+    }
+    return opts;
+}
+
+static void configureSocket(Poco::Net::StreamSocket &sock, const RemoteSocketOptions &opts)
+{
+    if (not opts.isLocal) sock.setNoDelay(true);
+    if (opts.sendBufferSize != 0) sock.setSendBufferSize(opts.sendBufferSize);
+    if (opts.recvBufferSize != 0) sock.setReceiveBufferSize(opts.recvBufferSize);
+}
+
 /***********************************************************************
  * RemoteClient implementation
  **********************************************************************/
 struct Pothos::RemoteClient::Impl
 {
     Impl(const std::string &uriStr, const long timeoutUs):
-        socketStream(clientSocket),
         uriStr(uriStr)
     {
         //validate the URI
         POTHOS_EXCEPTION_TRY
         {
             Poco::URI uri(uriStr);
+            #ifdef POCO_OS_FAMILY_UNIX
+            if (uri.getScheme() != "tcp" and uri.getScheme() != "unix") throw InvalidArgumentException("unsupported URI scheme");
+            #else
             if (uri.getScheme() != "tcp") throw InvalidArgumentException("unsupported URI scheme");
+            #endif
+            this->opts = parseSocketOptions(uri);
         }
         POTHOS_EXCEPTION_CATCH(const Exception &ex)
         {
@@ -117,9 +167,13 @@ struct Pothos::RemoteClient::Impl
         auto port = uri.getPort();
         if (port == 0) port = std::stoi(RemoteServer::getLocatorPort());
 
-        //perform the dns lookup
+        //perform the dns lookup, or use the path of a unix domain socket
         try
         {
+            #ifdef POCO_OS_FAMILY_UNIX
+            if (opts.isLocal) this->sa = Poco::Net::SocketAddress(Poco::Net::SocketAddress::UNIX_LOCAL, uri.getPath());
+            else
+            #endif
             this->sa = Poco::Net::SocketAddress(dnsLookup(uri.getHost(), timeoutUs), port);
         }
         catch (const Poco::Exception &ex)
@@ -131,17 +185,28 @@ struct Pothos::RemoteClient::Impl
         try
         {
             clientSocket.connect(this->sa, Poco::Timespan(0, timeoutUs));
+            configureSocket(clientSocket, opts);
         }
         catch (const Poco::Exception &ex)
         {
             throw RemoteClientError("Pothos::RemoteClient("+uriStr+")", ex.displayText());
         }
 
-        clientSocket.setNoDelay(true);
+        socketStream.reset(new RemoteSocketStream(
+            RemoteSocketStream::NativeSocket(clientSocket.impl()->sockfd()), opts.streamBufferSize));
     }
+
+    //the peer address of the server for the node id table
+    Poco::Net::IPAddress hostAddress(void) const
+    {
+        if (opts.isLocal) return Poco::Net::IPAddress("127.0.0.1");
+        return sa.host();
+    }
+
     Poco::Net::StreamSocket clientSocket;
-    Poco::Net::SocketStream socketStream;
+    std::unique_ptr<RemoteSocketStream> socketStream;
     const std::string uriStr;
+    RemoteSocketOptions opts;
     Poco::Net::SocketAddress sa;
 };
 
@@ -170,15 +235,68 @@ Pothos::RemoteClient::operator bool(void) const
 std::iostream &Pothos::RemoteClient::getIoStream(void) const
 {
     assert(_impl);
-    return _impl->socketStream;
+    return *_impl->socketStream;
+}
+
+/*!
+ * The socket and stream for an additional lane to the server:
+ * the lane holds this as a reference for the lifetime of the environment.
+ */
+struct RemoteClientLane
+{
+    RemoteClientLane(const Poco::Net::SocketAddress &sa, const RemoteSocketOptions &opts):
+        clientSocket(sa)
+    {
+        configureSocket(clientSocket, opts);
+        socketStream.reset(new Pothos::RemoteSocketStream(
+            Pothos::RemoteSocketStream::NativeSocket(clientSocket.impl()->sockfd()), opts.streamBufferSize));
+    }
+    Poco::Net::StreamSocket clientSocket;
+    std::unique_ptr<Pothos::RemoteSocketStream> socketStream;
+};
+
+static size_t extractLaneArg(Pothos::ProxyEnvironmentArgs &args, const std::string &key, const size_t defaultValue)
+{
+    auto it = args.find(key);
+    if (it == args.end()) return defaultValue;
+    const auto value = it->second;
+    args.erase(it);
+    try
+    {
+        const auto result = std::stoll(value);
+        if (result >= 0) return size_t(result);
+    }
+    catch (const std::exception &){}
+    throw Pothos::InvalidArgumentException("Pothos::RemoteClient::makeEnvironment()", key+" = "+value);
 }
 
-Pothos::ProxyEnvironment::Sptr Pothos::RemoteClient::makeEnvironment(const std::string &name, const ProxyEnvironmentArgs &args)
+Pothos::ProxyEnvironment::Sptr Pothos::RemoteClient::makeEnvironment(const std::string &name, const ProxyEnvironmentArgs &args_)
 {
     assert(_impl);
+
+    //the lane args are for the client, the rest go to the server
+    auto args = args_;
+    const auto numLanes = extractLaneArg(args, "lanes", 1);
+    const auto laneBytes = extractLaneArg(args, "laneBytes", 65536);
+
     auto env = RemoteClient::makeEnvironment(this->getIoStream(), name, args);
+    auto remoteEnv = std::dynamic_pointer_cast<RemoteProxyEnvironment>(env);
+    remoteEnv->laneBytes = laneBytes;
+    for (size_t i = 1; i < numLanes; i++)
+    {
+        std::shared_ptr<RemoteClientLane> lane;
+        try
+        {
+            lane.reset(new RemoteClientLane(_impl->sa, _impl->opts));
+        }
+        catch (const Poco::Exception &ex)
+        {
+            throw RemoteClientError("Pothos::RemoteClient::makeEnvironment("+_impl->uriStr+")", ex.displayText());
+        }
+        remoteEnv->addLane(*lane->socketStream, *lane->socketStream, lane);
+    }
     env->holdRef(Object(*this));
-    updateNodeIdTable(env, _impl->sa.host()); //update the node id table with this remote host
+    updateNodeIdTable(env, _impl->hostAddress()); //update the node id table with this remote host
     return env;
 }
 
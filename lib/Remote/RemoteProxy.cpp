@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "RemoteProxy.hpp"
@@ -6,100 +6,200 @@
 #include <Pothos/Remote/Client.hpp>
 #include <Pothos/Plugin.hpp>
 #include <Poco/Logger.h>
+#include <Poco/Format.h>
 #include <iostream>
 #include <sstream>
 #include <thread>
+#include <algorithm> //max
 #include <cstdint>
 
-Pothos::ObjectKwargs RemoteProxyEnvironment::transact(const Pothos::ObjectKwargs &reqArgs_)
+/***********************************************************************
+ * Request and reply handling
+ **********************************************************************/
+RemoteProxyEnvironment::Lane::Lane(std::istream &is, std::ostream &os, std::shared_ptr<void> holder):
+    is(is), os(os), holder(holder), readerDone(false)
 {
-    if (not connectionActive)
+    return;
+}
+
+void RemoteProxyEnvironment::sendRequest(Lane &lane, Pothos::ObjectKwargs &reqArgs, const ReplyHandler &handler, const size_t payloadBytes)
+{
+    //register the handler before sending
+    const uint32_t seq = reqArgs.at("seq");
     {
-        throw Pothos::IOException("RemoteProxyEnvironment::transact()", "connection inactive");
+        std::lock_guard<std::mutex> lock(lane.replyMutex);
+        if (not connectionActive)
+        {
+            throw Pothos::IOException("RemoteProxyEnvironment::transact()", "connection inactive");
+        }
+        lane.pendingReplies[seq] = handler;
+        if (not lane.readerThread.joinable()) lane.readerThread = std::thread(&RemoteProxyEnvironment::readerLoop, this, &lane);
     }
-
-    //add the thread ID to the args
-    //tid must be a fixed size type so it doesn't get truncated through serialization
-    const auto tid = uint32_t(std::hash<std::thread::id>()(std::this_thread::get_id()));
-    auto reqArgs = reqArgs_;
-    reqArgs["tid"] = Pothos::Object(tid);
+    lane.replyCond.notify_one();
 
     //send request object over output stream
     POTHOS_EXCEPTION_TRY
     {
-        std::lock_guard<std::mutex> lock(osMutex);
-        sendDatagram(os, reqArgs);
+        std::lock_guard<std::mutex> lock(lane.osMutex);
+        sendDatagram(lane.os, reqArgs, payloadBytes, compressBytes);
     }
     POTHOS_EXCEPTION_CATCH(const Pothos::Exception &ex)
     {
         connectionActive = false;
+        ReplyHandler unsent;
+        {
+            std::lock_guard<std::mutex> lock(lane.replyMutex);
+            auto it = lane.pendingReplies.find(seq);
+            if (it != lane.pendingReplies.end()) unsent = std::move(it->second);
+            lane.pendingReplies.erase(seq);
+        }
         throw Pothos::IOException("RemoteProxyEnvironment::sendDatagram()", ex.message());
     }
+}
 
-    //wait for reply object
-    while (true)
+void RemoteProxyEnvironment::sendNoReply(Lane &lane, Pothos::ObjectKwargs &reqArgs)
+{
+    if (not connectionActive) return;
+    reqArgs["seq"] = Pothos::Object(uint32_t(nextSeq++));
+    POTHOS_EXCEPTION_TRY
+    {
+        std::lock_guard<std::mutex> lock(lane.osMutex);
+        sendDatagram(lane.os, reqArgs);
+    }
+    POTHOS_EXCEPTION_CATCH(const Pothos::Exception &ex)
     {
-        std::unique_lock<std::mutex> lock(isMutex);
+        poco_error(Poco::Logger::get("Pothos.RemoteProxyEnvironment"), "destructor threw: "+ex.displayText());
+    }
+}
 
-        //is there a reply in the cache?
-        auto it = tidToReply.find(tid);
-        if (it != tidToReply.end())
-        {
-            auto reply = it->second;
-            tidToReply.erase(it);
-            lock.unlock();
-            isCond.notify_all();
-            return reply;
-        }
+Pothos::ObjectKwargs RemoteProxyEnvironment::makeRequest(const Pothos::ObjectKwargs &reqArgs_)
+{
+    //add the sequence ID to the args,
+    //seq must be a fixed size type so it doesn't get truncated through serialization
+    auto reqArgs = reqArgs_;
+    reqArgs["seq"] = Pothos::Object(uint32_t(nextSeq++));
 
-        //a thread is blocking on the input stream wait here
-        if (isBlocking)
-        {
-            isCond.wait(lock);
-            continue; //reply may be available, return to loop start
-        }
+    //the server executes requests from the same thread in order
+    reqArgs["tid"] = Pothos::Object(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return reqArgs;
+}
+
+void RemoteProxyEnvironment::transactAsync(const Pothos::ObjectKwargs &reqArgs_, const ReplyHandler &handler)
+{
+    auto reqArgs = this->makeRequest(reqArgs_);
+    this->sendRequest(*lanes.front(), reqArgs, handler, 0);
+}
+
+Pothos::ObjectKwargs RemoteProxyEnvironment::transact(const Pothos::ObjectKwargs &reqArgs_)
+{
+    auto reqArgs = this->makeRequest(reqArgs_);
 
-        //Mark blocking and unlock while waiting on the input stream
-        //so that other threads can access the reply cache or wait.
-        isBlocking = true;
+    //large requests take the next bulk lane, the size is only counted once
+    Lane *lane = lanes.front().get();
+    size_t payloadBytes = 0;
+    if (lanes.size() > 1 or compressBytes != 0) payloadBytes = datagramPayloadBytes(reqArgs);
+    if (lanes.size() > 1)
+    {
+        if (payloadBytes >= laneBytes) lane = lanes[1 + (nextBulkLane++ % (lanes.size()-1))].get();
+    }
+
+    return this->transactOnLane(*lane, reqArgs, payloadBytes);
+}
+
+Pothos::ObjectKwargs RemoteProxyEnvironment::transactOnLane(Lane &lane, Pothos::ObjectKwargs &reqArgs, const size_t payloadBytes)
+{
+    auto promise = std::make_shared<std::promise<Pothos::ObjectKwargs>>();
+    auto future = promise->get_future();
+    this->sendRequest(lane, reqArgs, [promise](Pothos::ObjectKwargs &&reply, std::exception_ptr error)
+    {
+        if (error) promise->set_exception(error);
+        else promise->set_value(std::move(reply));
+    }, payloadBytes);
+    return future.get();
+}
+
+void RemoteProxyEnvironment::addLane(std::istream &is, std::ostream &os, std::shared_ptr<void> holder)
+{
+    lanes.emplace_back(new Lane(is, os, holder));
+}
+
+void RemoteProxyEnvironment::readerLoop(Lane *lane)
+{
+    const auto destroyed = readerDestroyed;
+    std::unique_lock<std::mutex> lock(lane->replyMutex);
+    while (true)
+    {
+        //only block on the input stream while replies are pending
+        lane->replyCond.wait(lock, [lane]{return lane->readerDone or not lane->pendingReplies.empty();});
+        if (lane->pendingReplies.empty()) return;
         lock.unlock();
+
         Pothos::ObjectKwargs replyArgs;
+        bool recvFailed = false;
+        std::string errorMsg;
         POTHOS_EXCEPTION_TRY
         {
-            replyArgs = recvDatagram(is);
+            replyArgs = recvDatagram(lane->is);
         }
         POTHOS_EXCEPTION_CATCH(const Pothos::Exception &ex)
         {
-            isBlocking = false;
-            isCond.notify_all();
-            connectionActive = false;
-            throw Pothos::IOException("RemoteProxyEnvironment::recvDatagram()", ex.message());
+            recvFailed = true;
+            errorMsg = ex.message();
         }
+
+        //the connection failed, fail all pending requests
         lock.lock();
-        isBlocking = false;
+        if (recvFailed)
+        {
+            connectionActive = false;
+            auto pending = std::move(lane->pendingReplies);
+            lane->pendingReplies.clear();
+            lock.unlock();
+            const auto error = std::make_exception_ptr(Pothos::IOException("RemoteProxyEnvironment::recvDatagram()", errorMsg));
+            for (auto &pair : pending) pair.second(Pothos::ObjectKwargs(), error);
+            return;
+        }
 
-        //this is our thread ID, reply args
-        const size_t replyTid(replyArgs.at("tid"));
-        if (replyTid == tid)
+        //dispatch the reply to the handler for its sequence ID
+        auto seqIt = replyArgs.find("seq");
+        auto it = (seqIt == replyArgs.end())?lane->pendingReplies.end():lane->pendingReplies.find(seqIt->second.convert<uint32_t>());
+        if (it == lane->pendingReplies.end())
         {
+            poco_error(Poco::Logger::get("Pothos.RemoteProxyEnvironment"), "reply without a pending request");
+            continue;
+        }
+        {
+            //the handler is destroyed unlocked: it may release remote handles
+            auto handler = std::move(it->second);
+            lane->pendingReplies.erase(it);
             lock.unlock();
-            isCond.notify_all();
-            return replyArgs;
+            handler(std::move(replyArgs), nullptr);
         }
+        if (*destroyed) return; //the handler released the environment
+        lock.lock();
+    }
+}
 
-        //otherwise store to the reply cache
-        tidToReply[replyTid] = replyArgs;
-        lock.unlock();
-        isCond.notify_all();
+void RemoteProxyEnvironment::stopReader(Lane &lane)
+{
+    {
+        std::lock_guard<std::mutex> lock(lane.replyMutex);
+        lane.readerDone = true;
     }
+    lane.replyCond.notify_one();
+    if (lane.readerThread.joinable()) lane.readerThread.join();
 }
 
 RemoteProxyEnvironment::RemoteProxyEnvironment(
     std::istream &is, std::ostream &os,
     const std::string &name, const Pothos::ProxyEnvironmentArgs &args
 ):
-    is(is), os(os), name(name), connectionActive(true), isBlocking(false)
+    name(name), connectionActive(true),
+    laneBytes(0), compressBytes(0), nextSeq(0), nextBulkLane(0),
+    readerDestroyed(std::make_shared<std::atomic<bool>>(false))
 {
+    lanes.emplace_back(new Lane(is, os, nullptr));
+
     //create request
     Pothos::ObjectKwargs req;
     for (const auto &entry : args)
@@ -109,12 +209,52 @@ RemoteProxyEnvironment::RemoteProxyEnvironment(
     req["action"] = Pothos::Object("RemoteProxyEnvironment");
     req["name"] = Pothos::Object(name);
 
-    auto reply = this->transact(req);
+    //request compressed datagrams, the client args are not passed to the server's environment
+    size_t compressBytes = 65536;
+    auto compressBytesIt = args.find("compressBytes");
+    if (compressBytesIt != args.end())
+    {
+        try
+        {
+            compressBytes = std::stoul(compressBytesIt->second);
+        }
+        catch (const std::exception &)
+        {
+            throw Pothos::InvalidArgumentException("RemoteProxyEnvironment()", "compressBytes = "+compressBytesIt->second);
+        }
+        req.erase("compressBytes");
+    }
+    auto compressionIt = args.find("compression");
+    if (compressionIt != args.end() and compressionIt->second != "none")
+    {
+        if (compressionIt->second != POTHOS_DATAGRAM_COMPRESSION) throw Pothos::InvalidArgumentException(
+            "RemoteProxyEnvironment()", "unsupported compression = "+compressionIt->second);
+        req["compressBytes"] = Pothos::Object(std::max<size_t>(compressBytes, 1));
+    }
+    else req.erase("compression");
+
+    Pothos::ObjectKwargs reply;
+    try
+    {
+        reply = this->transact(req);
+    }
+    catch (...)
+    {
+        this->stopReader(*lanes.front());
+        throw;
+    }
 
     //check for an error
     auto errorMsgIt = reply.find("errorMsg");
-    if (errorMsgIt != reply.end()) throw Pothos::ProxyEnvironmentFactoryError(
-        "RemoteProxyEnvironment()", errorMsgIt->second.extract<std::string>());
+    if (errorMsgIt != reply.end())
+    {
+        this->stopReader(*lanes.front());
+        throw Pothos::ProxyEnvironmentFactoryError(
+            "RemoteProxyEnvironment()", errorMsgIt->second.extract<std::string>());
+    }
+
+    //the server agreed to compressed datagrams
+    if (reply.count("compression") != 0) this->compressBytes = req.at("compressBytes");
 
     //set the remote ID for this env
     remoteID = reply["envID"];
@@ -125,19 +265,44 @@ RemoteProxyEnvironment::RemoteProxyEnvironment(
 
 RemoteProxyEnvironment::~RemoteProxyEnvironment(void)
 {
-    //create request
+    //create requests: bulk lanes close before the environment is removed
+    Pothos::ObjectKwargs laneReq;
+    laneReq["action"] = Pothos::Object("~RemoteProxyLane");
     Pothos::ObjectKwargs req;
     req["action"] = Pothos::Object("~RemoteProxyEnvironment");
     req["envID"] = Pothos::Object(this->remoteID);
 
-    try
+    //the last reference was released by a reply handler:
+    //the reader thread cannot wait on itself, so send without a reply
+    for (const auto &lane : lanes)
     {
-        this->transact(req);
+        if (lane->readerThread.get_id() != std::this_thread::get_id()) continue;
+        *readerDestroyed = true;
+        lane->readerThread.detach();
+        for (size_t i = 1; i < lanes.size(); i++)
+        {
+            this->sendNoReply(*lanes[i], laneReq);
+            this->stopReader(*lanes[i]);
+        }
+        this->sendNoReply(*lanes.front(), req);
+        this->stopReader(*lanes.front());
+        return;
     }
-    catch(const Pothos::Exception &ex)
+
+    for (size_t i = 1; i <= lanes.size(); i++)
     {
-        if (not this->connectionActive) return;
-        poco_error(Poco::Logger::get("Pothos.RemoteProxyEnvironment"), "destructor threw: "+ex.displayText());
+        auto &lane = *lanes[i % lanes.size()];
+        auto &request = (i == lanes.size())?req:laneReq;
+        request["seq"] = Pothos::Object(uint32_t(nextSeq++));
+        try
+        {
+            this->transactOnLane(lane, request, 0);
+        }
+        catch(const Pothos::Exception &ex)
+        {
+            if (this->connectionActive) poco_error(Poco::Logger::get("Pothos.RemoteProxyEnvironment"), "destructor threw: "+ex.displayText());
+        }
+        this->stopReader(lane);
     }
 }
 
@@ -219,6 +384,141 @@ Pothos::Object RemoteProxyEnvironment::convertProxyToObject(const Pothos::Proxy
     return reply["local"];
 }
 
+static Pothos::ObjectKwargs makeBatchArg(RemoteProxyEnvironment &env, const Pothos::Object &arg)
+{
+    Pothos::ObjectKwargs out;
+    if (arg.type() == typeid(Pothos::ProxyBatchRef))
+    {
+        out["ref"] = Pothos::Object(arg.extract<Pothos::ProxyBatchRef>().index);
+    }
+    else if (arg.type() == typeid(Pothos::Proxy))
+    {
+        out["handleID"] = Pothos::Object(env.getHandle(arg.extract<Pothos::Proxy>())->remoteID);
+    }
+    else out["local"] = arg;
+    return out;
+}
+
+static void unpackBatchResult(RemoteProxyEnvironment &env, const std::string &name, const Pothos::ObjectKwargs &replyResult, Pothos::ProxyBatchResult &result)
+{
+    auto handleIt = replyResult.find("handleID");
+    auto localIt = replyResult.find("local");
+    auto messageIt = replyResult.find("message");
+    auto errorMsgIt = replyResult.find("errorMsg");
+    if (handleIt != replyResult.end()) result.result = env.makeHandle(handleIt->second);
+    else if (localIt != replyResult.end()) result.local = localIt->second;
+    else if (messageIt != replyResult.end()) result.error.reset(
+        new Pothos::ProxyExceptionMessage(messageIt->second.extract<std::string>()));
+    else if (errorMsgIt != replyResult.end()) result.error.reset(new Pothos::ProxyHandleCallError(
+        "RemoteProxyEnvironment::callBatch("+name+")", errorMsgIt->second.extract<std::string>()));
+}
+
+std::vector<Pothos::ProxyBatchResult> RemoteProxyEnvironment::callBatch(const std::vector<Pothos::ProxyBatchCall> &calls)
+{
+    std::vector<Pothos::ProxyBatchResult> results(calls.size());
+
+    //create request, local arguments are converted on the server
+    Pothos::ObjectVector reqCalls;
+    for (size_t i = 0; i < calls.size(); i++)
+    {
+        const auto &call = calls[i];
+        Pothos::ObjectKwargs reqCall;
+        reqCall["name"] = Pothos::Object(call.name);
+        reqCall["resultMode"] = Pothos::Object(int(call.resultMode));
+        try
+        {
+            if (call.proxy) reqCall["handleID"] = Pothos::Object(this->getHandle(call.proxy)->remoteID);
+            else reqCall["target"] = Pothos::Object(call.target);
+            Pothos::ObjectVector args;
+            for (const auto &arg : call.args) args.emplace_back(makeBatchArg(*this, arg));
+            reqCall["args"] = Pothos::Object(args);
+        }
+        catch(const Pothos::Exception &ex)
+        {
+            //the server fails calls that reference an unresolved call
+            results[i].error.reset(new Pothos::ProxyHandleCallError("RemoteProxyEnvironment::callBatch("+call.name+")", ex.displayText()));
+            reqCall.erase("handleID");
+            reqCall["target"] = Pothos::Object(i);
+        }
+        reqCalls.emplace_back(reqCall);
+    }
+
+    Pothos::ObjectKwargs req;
+    req["action"] = Pothos::Object("callBatch");
+    req["envID"] = Pothos::Object(this->remoteID);
+    req["calls"] = Pothos::Object(reqCalls);
+
+    auto reply = this->transact(req);
+
+    //check for an error
+    auto errorMsgIt = reply.find("errorMsg");
+    if (errorMsgIt != reply.end()) throw Pothos::ProxyHandleCallError(
+        "RemoteProxyEnvironment::callBatch()", errorMsgIt->second.extract<std::string>());
+
+    //unpack the results for each call
+    const auto &replyResults = reply.at("results").extract<Pothos::ObjectVector>();
+    if (replyResults.size() != calls.size()) throw Pothos::ProxyHandleCallError("RemoteProxyEnvironment::callBatch()",
+        Poco::format("expected %z results, got %z", calls.size(), replyResults.size()));
+    for (size_t i = 0; i < calls.size(); i++)
+    {
+        if (results[i].error) continue; //keep the local error
+        unpackBatchResult(*this, calls[i].name, replyResults[i].extract<Pothos::ObjectKwargs>(), results[i]);
+    }
+
+    return results;
+}
+
+std::future<Pothos::Proxy> RemoteProxyEnvironment::callAsync(const size_t handleID, const std::string &name, const Pothos::Object *args, const size_t numArgs)
+{
+    //an async call is a batch of one call, local arguments are converted on the server
+    Pothos::ObjectKwargs reqCall;
+    reqCall["name"] = Pothos::Object(name);
+    reqCall["resultMode"] = Pothos::Object(int(Pothos::ProxyBatchCall::RESULT_PROXY));
+    reqCall["handleID"] = Pothos::Object(handleID);
+    Pothos::ObjectVector reqArgs;
+    for (size_t i = 0; i < numArgs; i++)
+    {
+        try
+        {
+            reqArgs.emplace_back(makeBatchArg(*this, args[i]));
+        }
+        catch(const std::exception &ex)
+        {
+            throw Pothos::ProxyHandleCallError("RemoteProxyHandle::callAsync("+name+")",
+                Poco::format("convert arg %z - %s", i, std::string(ex.what())));
+        }
+    }
+    reqCall["args"] = Pothos::Object(reqArgs);
+
+    Pothos::ObjectKwargs req;
+    req["action"] = Pothos::Object("callBatch");
+    req["envID"] = Pothos::Object(this->remoteID);
+    req["calls"] = Pothos::Object(Pothos::ObjectVector(1, Pothos::Object(reqCall)));
+
+    //the reply is unpacked on the reader thread
+    auto promise = std::make_shared<std::promise<Pothos::Proxy>>();
+    auto future = promise->get_future();
+    this->transactAsync(req, [this, promise, name](Pothos::ObjectKwargs &&reply, std::exception_ptr error)
+    {
+        try
+        {
+            if (error) std::rethrow_exception(error);
+            auto errorMsgIt = reply.find("errorMsg");
+            if (errorMsgIt != reply.end()) throw Pothos::ProxyHandleCallError(
+                "RemoteProxyEnvironment::callAsync("+name+")", errorMsgIt->second.extract<std::string>());
+            Pothos::ProxyBatchResult result;
+            unpackBatchResult(*this, name, reply.at("results").extract<Pothos::ObjectVector>().at(0).extract<Pothos::ObjectKwargs>(), result);
+            if (result.error) result.error->rethrow();
+            promise->set_value(result.result);
+        }
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
+
 /***********************************************************************
  * factory method
  **********************************************************************/
@@ -1,12 +1,20 @@
-// Copyright (c) 2013-2015 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #pragma once
 #include <Pothos/Config.hpp>
 #include <Pothos/Proxy.hpp>
 #include <Pothos/Object/Containers.hpp>
+#include <functional>
+#include <exception>
+#include <future>
+#include <thread>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <memory>
+#include <vector>
+#include <cstdint>
 
 class RemoteProxyHandle;
 
@@ -62,23 +70,72 @@ public:
         throw Pothos::ProxySerializeError("RemoteProxyEnvironment::deserialize()", "not supported");
     }
 
+    std::vector<Pothos::ProxyBatchResult> callBatch(const std::vector<Pothos::ProxyBatchCall> &calls);
+
+    std::future<Pothos::Proxy> callAsync(const size_t handleID, const std::string &name, const Pothos::Object *args, const size_t numArgs);
+
+    //! A reply handler is called from the reader thread with the reply or an exception
+    typedef std::function<void(Pothos::ObjectKwargs &&, std::exception_ptr)> ReplyHandler;
+
+    //! Send a request on the priority lane without waiting, the handler is called with the reply
+    void transactAsync(const Pothos::ObjectKwargs &request, const ReplyHandler &handler);
+
+    //! Send a request and wait for the reply, large requests use the bulk lanes
     Pothos::ObjectKwargs transact(const Pothos::ObjectKwargs &request);
 
+    /*!
+     * Add a bulk lane: another connection to the same server.
+     * Requests of at least laneBytes are sent over the bulk lanes,
+     * so large transfers do not stall small requests on the priority lane.
+     * The holder keeps the streams for the lane alive.
+     */
+    void addLane(std::istream &is, std::ostream &os, std::shared_ptr<void> holder);
+
     size_t remoteID;
     std::string upid;
     std::string nodeId;
     std::string peerAddr;
 
-    std::istream &is;
-    std::ostream &os;
     const std::string name;
-    bool connectionActive;
+    std::atomic<bool> connectionActive;
 
-    std::mutex osMutex;
-    std::mutex isMutex;
-    std::condition_variable isCond;
-    bool isBlocking;
-    std::map<size_t, Pothos::ObjectKwargs> tidToReply;
+    //one connection to the server:
+    //requests are sent under the output mutex,
+    //the reader thread reads replies while requests are pending,
+    //and matches them to handlers by the request's sequence ID
+    struct Lane
+    {
+        Lane(std::istream &is, std::ostream &os, std::shared_ptr<void> holder);
+        std::istream &is;
+        std::ostream &os;
+        std::shared_ptr<void> holder;
+        std::mutex osMutex;
+        std::mutex replyMutex;
+        std::condition_variable replyCond;
+        bool readerDone;
+        std::map<uint32_t, ReplyHandler> pendingReplies;
+        std::thread readerThread;
+    };
+
+    //lane 0 is the priority lane, and the only lane for async requests
+    //so that they stay in order; requests on different lanes are unordered
+    std::vector<std::shared_ptr<Lane>> lanes;
+    size_t laneBytes;
+
+    //requests of at least compressBytes are compressed when non-zero,
+    //which is enabled when the server agrees during the handshake
+    size_t compressBytes;
+    std::atomic<uint32_t> nextSeq;
+    std::atomic<size_t> nextBulkLane;
+    std::shared_ptr<std::atomic<bool>> readerDestroyed;
+
+private:
+    Pothos::ObjectKwargs makeRequest(const Pothos::ObjectKwargs &request);
+    void sendRequest(Lane &lane, Pothos::ObjectKwargs &request, const ReplyHandler &handler, const size_t payloadBytes);
+    Pothos::ObjectKwargs transactOnLane(Lane &lane, Pothos::ObjectKwargs &request, const size_t payloadBytes);
+    void sendNoReply(Lane &lane, Pothos::ObjectKwargs &request);
+    void readerLoop(Lane *lane);
+    void stopReader(Lane &lane);
 };
 
 /***********************************************************************
@@ -99,6 +156,8 @@ public:
 
     Pothos::Proxy call(const std::string &name, const Pothos::Proxy *args, const size_t numArgs);
 
+    std::future<Pothos::Proxy> callAsync(const std::string &name, const Pothos::Object *args, const size_t numArgs);
+
     int compareTo(const Pothos::Proxy &proxy) const;
     size_t hashCode(void) const;
     std::string toString(void) const;
@@ -1,14 +1,19 @@
-// Copyright (c) 2013-2015 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "RemoteProxyDatagram.hpp"
 #include <Pothos/Exception.hpp>
 #include <Poco/ByteOrder.h>
+#include <Poco/DeflatingStream.h>
+#include <Poco/InflatingStream.h>
+#include <sstream>
 #include <streambuf>
 #include <iostream>
 #include <cstdint>
-#include <algorithm> //min/max
 #include <cstring> //memcpy
+#include <algorithm> //min/max
+#include <exception>
+#include <vector>
 
 /***********************************************************************
  * Header structure and constants
@@ -20,6 +25,7 @@
     (uint32_t(str[3]) << 0)
 
 static const uint32_t PothosRPCHeaderWord = POTHOS_PACKET_WORD32("PRPC");
+static const uint32_t PothosRPCZHeaderWord = POTHOS_PACKET_WORD32("PRPZ");
 static const uint32_t PothosRPCTrailerWord = POTHOS_PACKET_WORD32("CPRP");
 
 struct PothosRPCHeader
@@ -33,169 +39,376 @@ struct PothosRPCTrailer
     uint32_t trailerWord;
 };
 
+//! Datagrams with smaller payloads are serialized through a memory buffer
+static const size_t MemoryDatagramMaxBytes = 1 << 20;
+
+//! A memory buffer that grew beyond this size is released after use
+static const size_t MemoryDatagramKeepBytes = 4 << 20;
+
+/*!
+ * The memory buffer for datagrams of the calling thread.
+ * The buffer is reused across calls to keep its allocation.
+ */
+static std::vector<char> &datagramBuffer(void)
+{
+    static thread_local std::vector<char> buffer;
+    return buffer;
+}
+
+static void releaseDatagramBuffer(std::vector<char> &buffer)
+{
+    buffer.clear();
+    if (buffer.capacity() > MemoryDatagramKeepBytes) std::vector<char>().swap(buffer);
+}
+
 /***********************************************************************
  * Serialization streambuf
  **********************************************************************/
+
+/*!
+ * Count the bytes written, and optionally pass them through to another streambuf.
+ * The datagram is serialized twice: first to count the payload bytes for the header,
+ * then straight into the output stream, so large payloads like BufferChunks
+ * are never copied into a temporary buffer.
+ */
 class PRPCDatagramObuf : public std::streambuf
 {
 public:
-    PRPCDatagramObuf(std::ostream &os, const Pothos::Object &data):
-        _bytesWritten(0),
-        _payloadData(1024)
+    PRPCDatagramObuf(std::streambuf *sb = nullptr):
+        _sb(sb),
+        _bytesWritten(0)
     {
-        //serialize to a temporary buffer
-        std::ostream oser(this);
-        data.serialize(oser);
-
-        //load the header and trailer
-        PothosRPCHeader header;
-        header.headerWord = Poco::ByteOrder::toNetwork(PothosRPCHeaderWord);
-        header.payloadBytes = Poco::ByteOrder::toNetwork(uint32_t(_bytesWritten));
-
-        PothosRPCTrailer trailer;
-        trailer.trailerWord = Poco::ByteOrder::toNetwork(PothosRPCTrailerWord);
-
-        //write to the output stream
-        os.write((const char *)&header, sizeof(header));
-        os.write(_payloadData.data(), _bytesWritten);
-        os.write((const char *)&trailer, sizeof(trailer));
-        os.flush();
-    }
-
-    void ensureSize(const std::streamsize count)
-    {
-        //resize temporary buffer to hold the msg
-        while (size_t(_bytesWritten + count) > _payloadData.size())
-        {
-            _payloadData.resize(_payloadData.size()*2);
-        }
+        return;
     }
 
     int_type overflow(int_type c)
     {
         if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::eof();
-        const char_type t = traits_type::to_char_type(c);
-        this->ensureSize(1);
-        _payloadData[_bytesWritten++] = t;
+        if (_sb != nullptr and traits_type::eq_int_type(_sb->sputc(traits_type::to_char_type(c)), traits_type::eof())) return traits_type::eof();
+        _bytesWritten++;
         return c;
     }
 
     std::streamsize xsputn(const char *s, std::streamsize count)
     {
-        this->ensureSize(count);
-
-        //append the message to the payload
-        std::memcpy(_payloadData.data()+_bytesWritten, s, count);
+        if (_sb != nullptr) count = _sb->sputn(s, count);
         _bytesWritten += count;
-
         return count;
     }
 
+    std::streamsize bytesWritten(void) const
+    {
+        return _bytesWritten;
+    }
+
 private:
+    std::streambuf *_sb;
     std::streamsize _bytesWritten;
-    std::vector<char_type> _payloadData;
 };
 
-/***********************************************************************
- * Deserialization streambuf
- **********************************************************************/
-class PRPCDatagramIbuf : public std::streambuf
+static std::streamsize countDatagram(const Pothos::Object &data)
 {
-public:
-    PRPCDatagramIbuf(std::istream &is, Pothos::Object &data):
-        _bytesRead(0)
+    PRPCDatagramObuf counter;
     {
-        //read the header
-        PothosRPCHeader header;
-        is.read((char *)&header, sizeof(header));
-        if (is.eof()) throw Pothos::IOException("recvDatagram()", "stream end");
-        if (not is) throw Pothos::IOException("recvDatagram()", "stream error");
+        std::ostream oser(&counter);
+        data.serialize(oser);
+    }
+    return counter.bytesWritten();
+}
 
-        //parse the header
-        if (Poco::ByteOrder::fromNetwork(header.headerWord) != PothosRPCHeaderWord)
-        {
-            throw Pothos::IOException("recvDatagram()", "headerWord fail");
-        }
-        _payloadData.resize(Poco::ByteOrder::fromNetwork(header.payloadBytes));
+/*!
+ * Serialize the entire datagram into the memory buffer,
+ * and write it to the output stream with a single write.
+ * The payload size is known after serialization, so the header is
+ * patched in place, and there is no counting pass over the payload.
+ */
+static void writeMemoryDatagram(std::ostream &os, const Pothos::Object &data, const size_t payloadBytesHint)
+{
+    auto &buffer = datagramBuffer();
+    buffer.reserve(sizeof(PothosRPCHeader) + payloadBytesHint + sizeof(PothosRPCTrailer));
+    buffer.resize(sizeof(PothosRPCHeader));
+    try
+    {
+        data.serialize(buffer);
+    }
+    catch (...)
+    {
+        releaseDatagramBuffer(buffer);
+        throw;
+    }
 
-        //read the payload
-        is.read(_payloadData.data(), _payloadData.size());
-        if (is.eof()) throw Pothos::IOException("recvDatagram()", "stream end");
-        if (not is) throw Pothos::IOException("recvDatagram()", "stream error");
+    //load the header and trailer
+    PothosRPCHeader header;
+    header.headerWord = Poco::ByteOrder::toNetwork(PothosRPCHeaderWord);
+    header.payloadBytes = Poco::ByteOrder::toNetwork(uint32_t(buffer.size() - sizeof(PothosRPCHeader)));
+    std::memcpy(buffer.data(), &header, sizeof(header));
 
-        //read the trailer
-        PothosRPCTrailer trailer;
-        is.read((char *)&trailer, sizeof(trailer));
-        if (is.eof()) throw Pothos::IOException("recvDatagram()", "stream end");
-        if (not is) throw Pothos::IOException("recvDatagram()", "stream error");
+    PothosRPCTrailer trailer;
+    trailer.trailerWord = Poco::ByteOrder::toNetwork(PothosRPCTrailerWord);
+    const auto trailerBytes = reinterpret_cast<const char *>(&trailer);
+    buffer.insert(buffer.end(), trailerBytes, trailerBytes+sizeof(trailer));
 
-        //parse the trailer
-        if (Poco::ByteOrder::fromNetwork(trailer.trailerWord) != PothosRPCTrailerWord)
-        {
-            throw Pothos::IOException("recvDatagram()", "trailerWord fail");
-        }
+    os.write(buffer.data(), buffer.size());
+    releaseDatagramBuffer(buffer);
+    os.flush();
+    if (not os) throw Pothos::IOException("sendDatagram()", "stream error");
+}
+
+static void writeDatagram(std::ostream &os, const Pothos::Object &data, const std::streamsize payloadBytes)
+{
+    //load the header and trailer
+    PothosRPCHeader header;
+    header.headerWord = Poco::ByteOrder::toNetwork(PothosRPCHeaderWord);
+    header.payloadBytes = Poco::ByteOrder::toNetwork(uint32_t(payloadBytes));
+
+    PothosRPCTrailer trailer;
+    trailer.trailerWord = Poco::ByteOrder::toNetwork(PothosRPCTrailerWord);
 
-        //deserialize from temporary buffer
-        std::istream iser(this);
-        data.deserialize(iser);
+    //write to the output stream, serializing the payload in place
+    os.write((const char *)&header, sizeof(header));
+    PRPCDatagramObuf payload(os.rdbuf());
+    {
+        std::ostream oser(&payload);
+        data.serialize(oser);
+    }
+    if (payload.bytesWritten() != payloadBytes)
+    {
+        os.setstate(std::ios::badbit);
+        throw Pothos::IOException("sendDatagram()", "payload write fail");
+    }
+    os.write((const char *)&trailer, sizeof(trailer));
+    os.flush();
+    if (not os) throw Pothos::IOException("sendDatagram()", "stream error");
+}
+
+static bool writeCompressedDatagram(std::ostream &os, const Pothos::Object &data, const std::streamsize payloadBytes)
+{
+    //compress the payload, the header needs the compressed size
+    std::ostringstream compressed;
+    {
+        Poco::DeflatingOutputStream deflater(compressed);
+        data.serialize(deflater);
+        deflater.close();
+    }
+    const auto buff = compressed.str();
+    if (std::streamsize(buff.size()) >= payloadBytes) return false; //incompressible
+
+    //load the header and trailer
+    PothosRPCHeader header;
+    header.headerWord = Poco::ByteOrder::toNetwork(PothosRPCZHeaderWord);
+    header.payloadBytes = Poco::ByteOrder::toNetwork(uint32_t(buff.size()));
+
+    PothosRPCTrailer trailer;
+    trailer.trailerWord = Poco::ByteOrder::toNetwork(PothosRPCTrailerWord);
+
+    os.write((const char *)&header, sizeof(header));
+    os.write(buff.data(), buff.size());
+    os.write((const char *)&trailer, sizeof(trailer));
+    os.flush();
+    if (not os) throw Pothos::IOException("sendDatagram()", "stream error");
+    return true;
+}
+
+/***********************************************************************
+ * Deserialization streambuf
+ **********************************************************************/
+
+/*!
+ * Read at most the payload bytes from another streambuf.
+ * The payload is deserialized directly from the input stream,
+ * so large payloads are read straight into their final storage.
+ */
+class PRPCDatagramIbuf : public std::streambuf
+{
+public:
+    PRPCDatagramIbuf(std::streambuf *sb, const std::streamsize payloadBytes):
+        _sb(sb),
+        _bytesLeft(payloadBytes),
+        _streamEnd(false)
+    {
+        return;
     }
 
     int_type underflow(void)
     {
-        if (this->showmanyc() == 0) return traits_type::eof();
-        const char c = _payloadData[_bytesRead];
-        return traits_type::to_int_type(c);
+        if (_bytesLeft == 0) return traits_type::eof();
+        const auto c = _sb->sgetc();
+        if (traits_type::eq_int_type(c, traits_type::eof())) _streamEnd = true;
+        return c;
     }
 
     int_type uflow(void)
     {
-        if (this->showmanyc() == 0) return traits_type::eof();
-        const char c = _payloadData[_bytesRead++];
-        return traits_type::to_int_type(c);
+        if (_bytesLeft == 0) return traits_type::eof();
+        const auto c = _sb->sbumpc();
+        if (traits_type::eq_int_type(c, traits_type::eof())) _streamEnd = true;
+        else _bytesLeft--;
+        return c;
     }
 
     std::streamsize showmanyc(void)
     {
-        return _payloadData.size()-_bytesRead;
+        return _bytesLeft;
     }
 
     int_type pbackfail(int_type c)
     {
         if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::eof();
-        if (_bytesRead == 0) return traits_type::eof(); //still at start
-        const char_type t = traits_type::to_char_type(c);
-        if (t != _payloadData[_bytesRead-1]) return traits_type::eof(); //wrong character
-        _bytesRead--;
-        return c;
+        const auto r = _sb->sputbackc(traits_type::to_char_type(c));
+        if (not traits_type::eq_int_type(r, traits_type::eof())) _bytesLeft++;
+        return r;
     }
 
     std::streamsize xsgetn(char *s, std::streamsize n)
     {
-        const auto available = this->showmanyc();
-        if (available == 0) return traits_type::eof();
-        n = std::min<std::streamsize>(n, available);
-        std::memcpy(s, _payloadData.data()+_bytesRead, n);
-        _bytesRead += n;
-        return n;
+        n = std::min<std::streamsize>(n, _bytesLeft);
+        if (n == 0) return 0;
+        const auto r = _sb->sgetn(s, n);
+        if (r < n) _streamEnd = true;
+        _bytesLeft -= r;
+        return r;
+    }
+
+    //! Skip any payload bytes that were not deserialized
+    void drain(void)
+    {
+        char buff[1024];
+        while (_bytesLeft != 0 and not _streamEnd)
+        {
+            this->xsgetn(buff, std::min<std::streamsize>(sizeof(buff), _bytesLeft));
+        }
+    }
+
+    bool streamEnd(void) const
+    {
+        return _streamEnd;
     }
 
 private:
-    std::streamsize _bytesRead;
-    std::vector<char_type> _payloadData;
+    std::streambuf *_sb;
+    std::streamsize _bytesLeft;
+    bool _streamEnd;
 };
 
+static void readMemoryDatagram(std::istream &is, Pothos::Object &data, const size_t payloadBytes)
+{
+    auto &buffer = datagramBuffer();
+    buffer.resize(payloadBytes + sizeof(PothosRPCTrailer));
+    is.read(buffer.data(), buffer.size());
+    if (is.eof()) throw Pothos::IOException("recvDatagram()", "stream end");
+    if (not is) throw Pothos::IOException("recvDatagram()", "stream error");
+
+    //parse the trailer
+    PothosRPCTrailer trailer;
+    std::memcpy(&trailer, buffer.data()+payloadBytes, sizeof(trailer));
+    if (Poco::ByteOrder::fromNetwork(trailer.trailerWord) != PothosRPCTrailerWord)
+    {
+        throw Pothos::IOException("recvDatagram()", "trailerWord fail");
+    }
+
+    //the entire datagram was read, so the stream stays in sync on error
+    try
+    {
+        data.deserialize(buffer.data(), payloadBytes);
+    }
+    catch (...)
+    {
+        releaseDatagramBuffer(buffer);
+        throw;
+    }
+    releaseDatagramBuffer(buffer);
+}
+
+static void readDatagram(std::istream &is, Pothos::Object &data)
+{
+    //read the header
+    PothosRPCHeader header;
+    is.read((char *)&header, sizeof(header));
+    if (is.eof()) throw Pothos::IOException("recvDatagram()", "stream end");
+    if (not is) throw Pothos::IOException("recvDatagram()", "stream error");
+
+    //parse the header
+    const auto headerWord = Poco::ByteOrder::fromNetwork(header.headerWord);
+    if (headerWord != PothosRPCHeaderWord and headerWord != PothosRPCZHeaderWord)
+    {
+        throw Pothos::IOException("recvDatagram()", "headerWord fail");
+    }
+
+    //read smaller payloads and the trailer with a single read,
+    //and deserialize the payload from the memory buffer
+    const size_t payloadBytes = Poco::ByteOrder::fromNetwork(header.payloadBytes);
+    if (headerWord == PothosRPCHeaderWord and payloadBytes < MemoryDatagramMaxBytes)
+    {
+        return readMemoryDatagram(is, data, payloadBytes);
+    }
+
+    //deserialize the payload from the input stream,
+    //on error the rest of the payload is skipped to keep the stream in sync
+    PRPCDatagramIbuf payload(is.rdbuf(), payloadBytes);
+    std::exception_ptr error;
+    try
+    {
+        std::istream iser(&payload);
+        if (headerWord == PothosRPCHeaderWord) data.deserialize(iser);
+        else
+        {
+            Poco::InflatingInputStream inflater(iser);
+            data.deserialize(inflater);
+        }
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    payload.drain();
+    if (payload.streamEnd()) throw Pothos::IOException("recvDatagram()", "stream end");
+
+    //read the trailer
+    PothosRPCTrailer trailer;
+    is.read((char *)&trailer, sizeof(trailer));
+    if (is.eof()) throw Pothos::IOException("recvDatagram()", "stream end");
+    if (not is) throw Pothos::IOException("recvDatagram()", "stream error");
+
+    //parse the trailer
+    if (Poco::ByteOrder::fromNetwork(trailer.trailerWord) != PothosRPCTrailerWord)
+    {
+        throw Pothos::IOException("recvDatagram()", "trailerWord fail");
+    }
+
+    if (error) std::rethrow_exception(error);
+}
+
 /***********************************************************************
  * Wrapper calls for datagram interface
  **********************************************************************/
 void sendDatagram(std::ostream &os, const Pothos::ObjectKwargs &reqArgs)
 {
     Pothos::Object request(reqArgs);
-    PRPCDatagramObuf(os, request);
+    writeMemoryDatagram(os, request, 0);
+}
+
+void sendDatagram(std::ostream &os, const Pothos::ObjectKwargs &reqArgs, const size_t payloadBytes_, const size_t compressBytes)
+{
+    Pothos::Object request(reqArgs);
+    if (payloadBytes_ == 0 and compressBytes == 0) return writeMemoryDatagram(os, request, 0);
+    const auto payloadBytes = (payloadBytes_ == 0)?countDatagram(request):std::streamsize(payloadBytes_);
+    if (compressBytes != 0 and payloadBytes >= std::streamsize(compressBytes) and
+        writeCompressedDatagram(os, request, payloadBytes)) return;
+
+    //large payloads stream straight into the output without a copy
+    if (payloadBytes < std::streamsize(MemoryDatagramMaxBytes)) writeMemoryDatagram(os, request, size_t(payloadBytes));
+    else writeDatagram(os, request, payloadBytes);
+}
+
+size_t datagramPayloadBytes(const Pothos::ObjectKwargs &reqArgs)
+{
+    Pothos::Object request(reqArgs);
+    return size_t(countDatagram(request));
 }
 
 Pothos::ObjectKwargs recvDatagram(std::istream &is)
 {
     Pothos::Object reply;
-    PRPCDatagramIbuf(is, reply);
+    readDatagram(is, reply);
     return std::move(reply.ref<Pothos::ObjectKwargs>());
 }
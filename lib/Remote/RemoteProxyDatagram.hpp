@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2015 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #pragma once
@@ -11,6 +11,24 @@
 void sendDatagram(std::ostream &os, const Pothos::ObjectKwargs &reqArgs);
 
 /*!
- * Deserialize a reply object from an input stream
+ * Serialize a request object given its counted payload size.
+ * Payloads of at least compressBytes are compressed when it is non-zero,
+ * the receiver must have negotiated support for compressed datagrams.
+ * \param payloadBytes the counted payload size or 0 to count it here
+ * \param compressBytes the compression threshold or 0 to disable
+ */
+void sendDatagram(std::ostream &os, const Pothos::ObjectKwargs &reqArgs, const size_t payloadBytes, const size_t compressBytes = 0);
+
+/*!
+ * Count the serialized payload bytes of a request object
+ */
+size_t datagramPayloadBytes(const Pothos::ObjectKwargs &reqArgs);
+
+/*!
+ * Deserialize a reply object from an input stream,
+ * compressed datagrams are decompressed as they are read
  */
 Pothos::ObjectKwargs recvDatagram(std::istream &is);
+
+//! The datagram compression supported by this build
+#define POTHOS_DATAGRAM_COMPRESSION "zlib"
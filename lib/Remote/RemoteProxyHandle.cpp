@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "RemoteProxy.hpp"
@@ -19,9 +19,10 @@ RemoteProxyHandle::~RemoteProxyHandle(void)
     req["action"] = Pothos::Object("~RemoteProxyHandle");
     req["handleID"] = Pothos::Object(this->remoteID);
 
+    //the release does not wait for the reply
     try
     {
-        env->transact(req);
+        env->transactAsync(req, [](Pothos::ObjectKwargs &&, std::exception_ptr){});
     }
     catch(const Pothos::Exception &ex)
     {
@@ -67,6 +68,11 @@ Pothos::Proxy RemoteProxyHandle::call(const std::string &name, const Pothos::Pro
     return env->makeHandle(reply["handleID"]);
 }
 
+std::future<Pothos::Proxy> RemoteProxyHandle::callAsync(const std::string &name, const Pothos::Object *args, const size_t numArgs)
+{
+    return env->callAsync(this->remoteID, name, args, numArgs);
+}
+
 int RemoteProxyHandle::compareTo(const Pothos::Proxy &proxy) const
 {
     std::shared_ptr<RemoteProxyHandle> handle;
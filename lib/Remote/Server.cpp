@@ -1,8 +1,9 @@
-// Copyright (c) 2013-2018 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Remote.hpp>
 #include <Pothos/System/Paths.hpp>
+#include "System/SyslogStream.hpp"
 #include <Poco/Pipe.h>
 #include <Poco/PipeStream.h>
 #include <Poco/Process.h>
@@ -11,7 +12,6 @@
 #include <Poco/Net/SocketAddress.h>
 #include <Poco/String.h>
 #include <Poco/Message.h>
-#include <Poco/Net/RemoteSyslogChannel.h>
 #include <functional>
 #include <thread>
 #include <cassert>
@@ -212,7 +212,7 @@ static void pipeToSyslogWorker(Poco::AutoPtr<Poco::Channel> channel, const Poco:
 void Pothos::RemoteServer::startSyslogForwarding(const std::string &addr, const std::string &source)
 {
     assert(_impl);
-    Poco::AutoPtr<Poco::Channel> channel(new Poco::Net::RemoteSyslogChannel(addr, ""/*empty name*/));
+    Poco::AutoPtr<Poco::Channel> channel(makeSyslogForwardingChannel(addr));
     _impl->outThread = std::thread(std::bind(&pipeToSyslogWorker, channel, _impl->outPipe, source));
     _impl->errThread = std::thread(std::bind(&pipeToSyslogWorker, channel, _impl->errPipe, source));
 }
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2017 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include "RemoteProxyDatagram.hpp"
@@ -9,61 +9,79 @@
 #include <Pothos/System/HostInfo.hpp>
 #include <Poco/Exception.h>
 #include <Poco/Bugcheck.h>
+#include <Poco/Format.h>
+#include <Poco/Logger.h>
 #include <iostream>
+#include <unordered_map>
+#include <condition_variable>
+#include <algorithm> //max
+#include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
 #include <mutex>
-#include <map>
 
 /***********************************************************************
- * Active objects on the server
+ * Active objects on the server:
+ * the table is sharded by ID so that calls from many connections
+ * only contend when they touch objects in the same shard,
+ * and IDs come from a monotonic counter, so an ID is never reused
  **********************************************************************/
-static std::mutex &getObjectsMutex(void)
+static const size_t NUM_OBJECT_SHARDS = 64;
+
+struct ServerObjectsShard
 {
-    static std::mutex mutex;
-    return mutex;
-}
+    std::mutex mutex;
+    std::unordered_map<size_t, Pothos::Object> map;
+};
 
-typedef std::map<size_t, Pothos::Object> ServerObjectsMapType;
-static ServerObjectsMapType &getObjectsMap(void)
+static ServerObjectsShard &getObjectsShard(const size_t id)
 {
-    static ServerObjectsMapType map;
-    return map;
+    static ServerObjectsShard shards[NUM_OBJECT_SHARDS];
+    return shards[id % NUM_OBJECT_SHARDS];
 }
 
 static Pothos::Object getNewObjectId(const Pothos::Object &obj)
 {
-    std::lock_guard<std::mutex> lock(getObjectsMutex());
-    static size_t id = 0;
-    getObjectsMap()[++id] = obj;
+    static std::atomic<size_t> nextId(0);
+    const size_t id = ++nextId;
+    auto &shard = getObjectsShard(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.map[id] = obj;
     return Pothos::Object(id);
 }
 
 static Pothos::Object getObjectAtId(const Pothos::Object &id)
 {
     const size_t key(id);
-    std::lock_guard<std::mutex> lock(getObjectsMutex());
-    return getObjectsMap()[key];
+    auto &shard = getObjectsShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) return Pothos::Object();
+    return it->second;
 }
 
 static void removeObjectAtId(const Pothos::Object &id)
 {
     const size_t key(id);
-    std::lock_guard<std::mutex> lock(getObjectsMutex());
-    getObjectsMap().erase(key);
+    auto &shard = getObjectsShard(key);
+    Pothos::Object obj; //released outside of the lock
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) return;
+    obj = std::move(it->second);
+    shard.map.erase(it);
 }
 
 /***********************************************************************
  * Handler implementation
  **********************************************************************/
-bool Pothos::RemoteHandler::runHandlerOnce(std::istream &is, std::ostream &os)
+static bool handleRequest(const std::string &_peerAddr, const Pothos::ObjectKwargs &reqArgs, Pothos::ObjectKwargs &replyArgs)
 {
     bool done = false;
 
-    //deserialize the request
-    const auto reqArgs = recvDatagram(is);
-
     //process the request and form the reply
-    Pothos::ObjectKwargs replyArgs;
-    replyArgs["tid"] = reqArgs.at("tid");
+    replyArgs["seq"] = reqArgs.at("seq");
     POTHOS_EXCEPTION_TRY
     {
         const auto &action = reqArgs.at("action").extract<std::string>();
@@ -73,12 +91,21 @@ bool Pothos::RemoteHandler::runHandlerOnce(std::istream &is, std::ostream &os)
             for (const auto &entry : reqArgs)
             {
                 if (entry.second.type() != typeid(std::string)) continue;
+                if (entry.first == "compression") continue;
                 envArgs[entry.first] = entry.second.extract<std::string>();
             }
             const auto &name = reqArgs.at("name").extract<std::string>();
             const auto &env = Pothos::ProxyEnvironment::make(name, envArgs);
             replyArgs["envID"] = getNewObjectId(Pothos::Object(env));
 
+            //agree to compressed datagrams when the client asks for a supported type
+            auto compressionIt = reqArgs.find("compression");
+            if (compressionIt != reqArgs.end() and reqArgs.count("compressBytes") != 0 and
+                compressionIt->second == std::string(POTHOS_DATAGRAM_COMPRESSION))
+            {
+                replyArgs["compression"] = compressionIt->second;
+            }
+
             //a unique process ID for this server
             const auto info = Pothos::System::HostInfo::get();
             replyArgs["upid"] = Pothos::Object(Pothos::ProxyEnvironment::getLocalUniquePid());
@@ -90,6 +117,10 @@ bool Pothos::RemoteHandler::runHandlerOnce(std::istream &is, std::ostream &os)
             removeObjectAtId(reqArgs.at("envID"));
             done = true;
         }
+        else if (action == "~RemoteProxyLane")
+        {
+            done = true;
+        }
         else if (action == "findProxy")
         {
             const auto &env = getObjectAtId(reqArgs.at("envID")).extract<Pothos::ProxyEnvironment::Sptr>();
@@ -139,6 +170,66 @@ bool Pothos::RemoteHandler::runHandlerOnce(std::istream &is, std::ostream &os)
                 replyArgs["message"] = Pothos::Object(ex.message());
             }
         }
+        else if (action == "callBatch")
+        {
+            const auto &env = getObjectAtId(reqArgs.at("envID")).extract<Pothos::ProxyEnvironment::Sptr>();
+            const auto &calls = reqArgs.at("calls").extract<Pothos::ObjectVector>();
+
+            //make each call in order, results are referenced by index
+            std::vector<Pothos::Proxy> results(calls.size());
+            Pothos::ObjectVector replyResults;
+            for (size_t i = 0; i < calls.size(); i++)
+            {
+                const auto &call = calls[i].extract<Pothos::ObjectKwargs>();
+                Pothos::ObjectKwargs replyResult;
+                try
+                {
+                    const auto &name = call.at("name").extract<std::string>();
+                    auto resolveRef = [&](const size_t index)
+                    {
+                        if (index >= i or not results[index]) throw Pothos::ProxyHandleCallError(
+                            "Pothos::RemoteHandler::callBatch("+name+")",
+                            Poco::format("call %z references failed call %z", i, index));
+                        return results[index];
+                    };
+
+                    //resolve the object to call on
+                    auto handleIt = call.find("handleID");
+                    const auto proxy = (handleIt != call.end())?
+                        getObjectAtId(handleIt->second).extract<Pothos::Proxy>():
+                        resolveRef(call.at("target"));
+
+                    //load the args
+                    std::vector<Pothos::Proxy> args;
+                    for (const auto &argObj : call.at("args").extract<Pothos::ObjectVector>())
+                    {
+                        const auto &arg = argObj.extract<Pothos::ObjectKwargs>();
+                        auto refIt = arg.find("ref");
+                        auto argHandleIt = arg.find("handleID");
+                        if (refIt != arg.end()) args.push_back(resolveRef(refIt->second));
+                        else if (argHandleIt != arg.end()) args.push_back(getObjectAtId(argHandleIt->second).extract<Pothos::Proxy>());
+                        else args.push_back(env->convertObjectToProxy(arg.at("local")));
+                    }
+
+                    //make the call
+                    //only store results that the client will hold a handle to
+                    results[i] = proxy.getHandle()->call(name, args.data(), args.size());
+                    const int resultMode = call.at("resultMode");
+                    if (resultMode == Pothos::ProxyBatchCall::RESULT_PROXY) replyResult["handleID"] = getNewObjectId(Pothos::Object(results[i]));
+                    if (resultMode == Pothos::ProxyBatchCall::RESULT_LOCAL) replyResult["local"] = env->convertProxyToObject(results[i]);
+                }
+                catch (const Pothos::ProxyExceptionMessage &ex)
+                {
+                    replyResult["message"] = Pothos::Object(ex.message());
+                }
+                catch (const Pothos::Exception &ex)
+                {
+                    replyResult["errorMsg"] = Pothos::Object(ex.displayText());
+                }
+                replyResults.emplace_back(replyResult);
+            }
+            replyArgs["results"] = Pothos::Object(replyResults);
+        }
         else if (action == "compareTo")
         {
             const auto &proxy = getObjectAtId(reqArgs.at("handleID")).extract<Pothos::Proxy>();
@@ -170,6 +261,161 @@ bool Pothos::RemoteHandler::runHandlerOnce(std::istream &is, std::ostream &os)
         replyArgs["errorMsg"] = Pothos::Object(ex.displayText());
     }
 
+    return done;
+}
+
+/***********************************************************************
+ * Request dispatcher:
+ * requests are executed on a pool of worker threads,
+ * requests with the same client thread ID are executed in order,
+ * and requests from different client threads execute concurrently.
+ * Replies are sent as each request completes.
+ **********************************************************************/
+class RemoteHandlerDispatcher
+{
+public:
+    RemoteHandlerDispatcher(const std::string &peerAddr, std::ostream &os):
+        _peerAddr(peerAddr),
+        _os(os),
+        _compressBytes(0),
+        _maxWorkers(std::max<size_t>(std::thread::hardware_concurrency(), 4)),
+        _idleWorkers(0),
+        _inFlight(0),
+        _shutdown(false)
+    {
+        return;
+    }
+
+    ~RemoteHandlerDispatcher(void)
+    {
+        this->drain();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _shutdown = true;
+        }
+        _workCond.notify_all();
+        for (auto &worker : _workers) worker.join();
+    }
+
+    //! Queue a request behind the other requests from its client thread
+    void dispatch(Pothos::ObjectKwargs &&reqArgs, const size_t tid)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _inFlight++;
+
+            //an entry exists while the client thread has requests in flight
+            auto it = _queues.find(tid);
+            if (it != _queues.end()) it->second.push_back(std::move(reqArgs));
+            else
+            {
+                _queues[tid].push_back(std::move(reqArgs));
+                _ready.push_back(tid);
+                if (_ready.size() > _idleWorkers and _workers.size() < _maxWorkers)
+                {
+                    _workers.emplace_back(&RemoteHandlerDispatcher::workerLoop, this);
+                }
+            }
+        }
+        _workCond.notify_one();
+    }
+
+    //! Wait for all requests in flight to complete
+    void drain(void)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _drainCond.wait(lock, [this]{return _inFlight == 0;});
+    }
+
+    //! Execute a request on the calling thread
+    bool handle(const Pothos::ObjectKwargs &reqArgs)
+    {
+        Pothos::ObjectKwargs replyArgs;
+        const bool done = handleRequest(_peerAddr, reqArgs, replyArgs);
+        std::lock_guard<std::mutex> lock(_osMutex);
+        sendDatagram(_os, replyArgs, 0, _compressBytes);
+
+        //replies after an agreed handshake are compressed above the client's threshold
+        if (replyArgs.count("compression") != 0) _compressBytes = reqArgs.at("compressBytes");
+        return done;
+    }
+
+private:
+    void workerLoop(void)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _idleWorkers++;
+            _workCond.wait(lock, [this]{return _shutdown or not _ready.empty();});
+            _idleWorkers--;
+            if (_ready.empty()) return;
+
+            //take the next request for a ready client thread
+            const auto tid = _ready.front();
+            _ready.pop_front();
+            auto &queue = _queues.at(tid);
+            const auto reqArgs = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+
+            //a failed reply means the connection is gone,
+            //the reader observes this when the next receive fails
+            POTHOS_EXCEPTION_TRY
+            {
+                this->handle(reqArgs);
+            }
+            POTHOS_EXCEPTION_CATCH(const Pothos::Exception &ex)
+            {
+                poco_error(Poco::Logger::get("Pothos.RemoteHandler"), ex.displayText());
+            }
+
+            //requeue the client thread behind the others when it has more requests
+            lock.lock();
+            auto it = _queues.find(tid);
+            if (it->second.empty()) _queues.erase(it);
+            else _ready.push_back(tid);
+            if (--_inFlight == 0) _drainCond.notify_all();
+        }
+    }
+
+    const std::string _peerAddr;
+    std::ostream &_os;
+    std::mutex _osMutex;
+    size_t _compressBytes;
+    const size_t _maxWorkers;
+
+    std::mutex _mutex;
+    std::condition_variable _workCond;
+    std::condition_variable _drainCond;
+    std::unordered_map<size_t, std::deque<Pothos::ObjectKwargs>> _queues;
+    std::deque<size_t> _ready;
+    std::vector<std::thread> _workers;
+    size_t _idleWorkers;
+    size_t _inFlight;
+    bool _shutdown;
+};
+
+static bool isShutdownRequest(const Pothos::ObjectKwargs &reqArgs)
+{
+    auto it = reqArgs.find("action");
+    if (it == reqArgs.end() or it->second.type() != typeid(std::string)) return false;
+    const auto &action = it->second.extract<std::string>();
+    return action == "~RemoteProxyEnvironment" or action == "~RemoteProxyLane";
+}
+
+/***********************************************************************
+ * Handler API
+ **********************************************************************/
+bool Pothos::RemoteHandler::runHandlerOnce(std::istream &is, std::ostream &os)
+{
+    //deserialize the request
+    const auto reqArgs = recvDatagram(is);
+
+    //process the request and form the reply
+    Pothos::ObjectKwargs replyArgs;
+    const bool done = handleRequest(_peerAddr, reqArgs, replyArgs);
+
     //serialize the reply
     sendDatagram(os, replyArgs);
 
@@ -189,10 +435,24 @@ Pothos::RemoteHandler::RemoteHandler(const std::string &peerAddr):
 
 void Pothos::RemoteHandler::runHandler(std::istream &is, std::ostream &os)
 {
+    RemoteHandlerDispatcher dispatcher(_peerAddr, os);
     bool done = false;
     while (is.good() and os.good() and not done)
     {
-        done = runHandlerOnce(is, os);
+        auto reqArgs = recvDatagram(is);
+
+        //requests with a client thread ID run on the worker pool,
+        //other requests and the shut-down actions run here in order
+        //once all of the requests in flight have completed
+        auto tidIt = reqArgs.find("tid");
+        if (tidIt != reqArgs.end() and not isShutdownRequest(reqArgs))
+        {
+            const size_t tid = tidIt->second;
+            dispatcher.dispatch(std::move(reqArgs), tid);
+            continue;
+        }
+        dispatcher.drain();
+        done = dispatcher.handle(reqArgs);
     }
 }
 
@@ -0,0 +1,162 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Remote.hpp>
+#include <Poco/Logger.h>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <cassert>
+
+struct Pothos::RemoteServerPool::Impl
+{
+    Impl(const std::string &uri, const size_t size):
+        uri(uri),
+        size(size),
+        done(false)
+    {
+        return;
+    }
+
+    ~Impl(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        cond.notify_all();
+        if (thread.joinable()) thread.join();
+    }
+
+    //! Keep the pool filled until done, retry after a failure to spawn
+    void refillLoop(void)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (not done)
+        {
+            if (ready.size() >= size)
+            {
+                cond.wait(lock);
+                continue;
+            }
+
+            lock.unlock();
+            RemoteServer server;
+            POTHOS_EXCEPTION_TRY
+            {
+                server = RemoteServer(uri);
+            }
+            POTHOS_EXCEPTION_CATCH(const Exception &ex)
+            {
+                poco_error_f2(Poco::Logger::get("Pothos.RemoteServerPool"), "spawn %s: %s", uri, ex.displayText());
+            }
+            lock.lock();
+
+            if (server) ready.push_back(server);
+            else cond.wait_for(lock, std::chrono::seconds(1));
+        }
+    }
+
+    const std::string uri;
+    const size_t size;
+    bool done;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<RemoteServer> ready;
+    std::thread thread;
+};
+
+Pothos::RemoteServerPool::RemoteServerPool(void)
+{
+    assert(not *this);
+}
+
+Pothos::RemoteServerPool::RemoteServerPool(const std::string &uri, const size_t size):
+    _impl(new Impl(uri, size))
+{
+    _impl->thread = std::thread(&Impl::refillLoop, _impl.get());
+}
+
+const std::string &Pothos::RemoteServerPool::getUri(void) const
+{
+    assert(_impl);
+    return _impl->uri;
+}
+
+Pothos::RemoteServerPool::operator bool(void) const
+{
+    return bool(_impl);
+}
+
+size_t Pothos::RemoteServerPool::getNumReady(void) const
+{
+    assert(_impl);
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    return _impl->ready.size();
+}
+
+Pothos::RemoteServer Pothos::RemoteServerPool::acquire(void)
+{
+    assert(_impl);
+    {
+        std::lock_guard<std::mutex> lock(_impl->mutex);
+        if (not _impl->ready.empty())
+        {
+            auto server = _impl->ready.front();
+            _impl->ready.pop_front();
+            _impl->cond.notify_all();
+            return server;
+        }
+    }
+
+    //none are ready, the cold start happens here
+    return RemoteServer(_impl->uri);
+}
+
+/***********************************************************************
+ * default pool for resident servers
+ **********************************************************************/
+static std::mutex &getDefaultPoolMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static Pothos::RemoteServerPool &getDefaultPool(void)
+{
+    static Pothos::RemoteServerPool pool;
+    return pool;
+}
+
+void Pothos::RemoteServerPool::setDefault(const RemoteServerPool &pool)
+{
+    std::lock_guard<std::mutex> lock(getDefaultPoolMutex());
+    getDefaultPool() = pool;
+}
+
+Pothos::RemoteServerPool Pothos::RemoteServerPool::getDefault(void)
+{
+    std::lock_guard<std::mutex> lock(getDefaultPoolMutex());
+    return getDefaultPool();
+}
+
+Pothos::RemoteServer Pothos::RemoteServerPool::spawn(const std::string &uri)
+{
+    auto pool = getDefault();
+    if (pool and pool.getUri() == uri) return pool.acquire();
+    return RemoteServer(uri);
+}
+
+#include <Pothos/Managed.hpp>
+
+static auto managedRemoteServerPool = Pothos::ManagedClass()
+    .registerConstructor<Pothos::RemoteServerPool>()
+    .registerConstructor<Pothos::RemoteServerPool, std::string, size_t>()
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::RemoteServerPool, getNumReady))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::RemoteServerPool, acquire))
+    .registerStaticMethod(POTHOS_FCN_TUPLE(Pothos::RemoteServerPool, setDefault))
+    .registerStaticMethod(POTHOS_FCN_TUPLE(Pothos::RemoteServerPool, getDefault))
+    .registerStaticMethod(POTHOS_FCN_TUPLE(Pothos::RemoteServerPool, spawn))
+    .commit("Pothos/RemoteServerPool");
@@ -0,0 +1,183 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Remote/SocketStream.hpp>
+#include <streambuf>
+#include <algorithm> //min/max
+#include <vector>
+#include <cstring> //memcpy
+#include <cerrno>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef Pothos::RemoteSocketStream::NativeSocket NativeSocket;
+
+/***********************************************************************
+ * Platform calls on the native socket
+ **********************************************************************/
+static long long sendVectored(const NativeSocket sock, const char *buff0, const size_t len0, const char *buff1, const size_t len1)
+{
+    #ifdef _WIN32
+    WSABUF bufs[2];
+    DWORD count(0), numSent(0);
+    if (len0 != 0) {bufs[count].buf = const_cast<char *>(buff0); bufs[count].len = ULONG(len0); count++;}
+    if (len1 != 0) {bufs[count].buf = const_cast<char *>(buff1); bufs[count].len = ULONG(len1); count++;}
+    if (WSASend(SOCKET(sock), bufs, count, &numSent, 0, nullptr, nullptr) != 0) return -1;
+    return numSent;
+    #else
+    iovec iov[2];
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    if (len0 != 0) {iov[msg.msg_iovlen].iov_base = const_cast<char *>(buff0); iov[msg.msg_iovlen].iov_len = len0; msg.msg_iovlen++;}
+    if (len1 != 0) {iov[msg.msg_iovlen].iov_base = const_cast<char *>(buff1); iov[msg.msg_iovlen].iov_len = len1; msg.msg_iovlen++;}
+    long long r(0);
+    do r = ::sendmsg(int(sock), &msg, MSG_NOSIGNAL);
+    while (r < 0 and errno == EINTR);
+    return r;
+    #endif
+}
+
+static long long recvSome(const NativeSocket sock, char *buff, const size_t len)
+{
+    #ifdef _WIN32
+    return ::recv(SOCKET(sock), buff, int(std::min<size_t>(len, 1 << 30)), 0);
+    #else
+    long long r(0);
+    do r = ::recv(int(sock), buff, len, 0);
+    while (r < 0 and errno == EINTR);
+    return r;
+    #endif
+}
+
+//! Send both buffers entirely, resuming after partial sends
+static bool sendAll(const NativeSocket sock, const char *buff0, size_t len0, const char *buff1, size_t len1)
+{
+    while (len0 + len1 != 0)
+    {
+        auto r = sendVectored(sock, buff0, len0, buff1, len1);
+        if (r <= 0) return false;
+        const auto n0 = std::min<size_t>(len0, size_t(r));
+        buff0 += n0; len0 -= n0; r -= n0;
+        buff1 += r; len1 -= size_t(r);
+    }
+    return true;
+}
+
+/***********************************************************************
+ * The stream buffer over the native socket
+ **********************************************************************/
+class RemoteSocketStreamBuf : public std::streambuf
+{
+public:
+    RemoteSocketStreamBuf(const NativeSocket sock, const size_t bufferSize):
+        _sock(sock),
+        _in(std::max<size_t>(bufferSize, 64)),
+        _out(std::max<size_t>(bufferSize, 64))
+    {
+        this->setg(_in.data(), _in.data(), _in.data());
+        this->setp(_out.data(), _out.data()+_out.size());
+    }
+
+protected:
+    int_type overflow(int_type c)
+    {
+        if (this->sync() != 0) return traits_type::eof();
+        if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+        *this->pptr() = traits_type::to_char_type(c);
+        this->pbump(1);
+        return c;
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n)
+    {
+        if (n <= this->epptr() - this->pptr())
+        {
+            std::memcpy(this->pptr(), s, size_t(n));
+            this->pbump(int(n));
+            return n;
+        }
+
+        //send the buffered bytes and the new bytes together
+        if (not sendAll(_sock, this->pbase(), size_t(this->pptr() - this->pbase()), s, size_t(n))) return 0;
+        this->setp(_out.data(), _out.data()+_out.size());
+        return n;
+    }
+
+    int sync(void)
+    {
+        const size_t pending = size_t(this->pptr() - this->pbase());
+        if (pending == 0) return 0;
+        if (not sendAll(_sock, this->pbase(), pending, nullptr, 0)) return -1;
+        this->setp(_out.data(), _out.data()+_out.size());
+        return 0;
+    }
+
+    int_type underflow(void)
+    {
+        if (this->gptr() < this->egptr()) return traits_type::to_int_type(*this->gptr());
+        const auto r = recvSome(_sock, _in.data(), _in.size());
+        if (r <= 0) return traits_type::eof();
+        this->setg(_in.data(), _in.data(), _in.data()+r);
+        return traits_type::to_int_type(*this->gptr());
+    }
+
+    std::streamsize xsgetn(char *s, std::streamsize n)
+    {
+        std::streamsize total(0);
+        while (total < n)
+        {
+            //copy out the buffered bytes first
+            const auto avail = std::min<std::streamsize>(this->egptr() - this->gptr(), n - total);
+            if (avail > 0)
+            {
+                std::memcpy(s+total, this->gptr(), size_t(avail));
+                this->gbump(int(avail));
+                total += avail;
+                continue;
+            }
+
+            //large reads are received straight into the caller's memory
+            if (size_t(n - total) >= _in.size())
+            {
+                const auto r = recvSome(_sock, s+total, size_t(n - total));
+                if (r <= 0) break;
+                total += r;
+                continue;
+            }
+
+            if (traits_type::eq_int_type(this->underflow(), traits_type::eof())) break;
+        }
+        return total;
+    }
+
+private:
+    const NativeSocket _sock;
+    std::vector<char> _in;
+    std::vector<char> _out;
+};
+
+/***********************************************************************
+ * The stream implementation
+ **********************************************************************/
+Pothos::RemoteSocketStream::RemoteSocketStream(const NativeSocket sock, const size_t bufferSize):
+    std::iostream(nullptr),
+    _buf(new RemoteSocketStreamBuf(sock, bufferSize))
+{
+    this->rdbuf(_buf.get());
+}
+
+Pothos::RemoteSocketStream::~RemoteSocketStream(void)
+{
+    _buf->pubsync();
+}
@@ -0,0 +1,169 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "System/AsyncLogChannel.hpp"
+#include <Pothos/Util/SPSCQueue.hpp>
+#include <chrono>
+#include <string>
+
+/*!
+ * The number of pending messages per logging thread.
+ * A thread that logs faster than the destination drops the excess.
+ */
+static const size_t RingCapacity = 1024;
+
+/*!
+ * The period that the flusher sleeps for when there is no work.
+ */
+static const std::chrono::milliseconds FlushPeriod(5);
+
+/***********************************************************************
+ * Per-thread ring of messages
+ **********************************************************************/
+struct AsyncLogRing
+{
+    AsyncLogRing(void):
+        queue(RingCapacity),
+        exited(false)
+    {
+        return;
+    }
+
+    Pothos::Util::SPSCQueue<Poco::Message> queue;
+    std::atomic<bool> exited; //the logging thread exited, remove once drained
+};
+
+/*!
+ * The rings of the calling thread keyed by channel id:
+ * The rings are marked as exited when the thread exits.
+ */
+struct AsyncLogThreadState
+{
+    std::vector<std::pair<size_t, std::shared_ptr<AsyncLogRing>>> rings;
+
+    ~AsyncLogThreadState(void)
+    {
+        for (const auto &pair : rings) pair.second->exited = true;
+    }
+};
+
+static size_t nextAsyncLogChannelId(void)
+{
+    static std::atomic<size_t> nextId(0);
+    return nextId++;
+}
+
+/***********************************************************************
+ * Async channel implementation
+ **********************************************************************/
+AsyncLogChannel::AsyncLogChannel(Poco::Channel *channel):
+    _channel(channel, true/*shared*/),
+    _id(nextAsyncLogChannelId()),
+    _running(false),
+    _dropped(0)
+{
+    return;
+}
+
+AsyncLogChannel::~AsyncLogChannel(void)
+{
+    this->close();
+}
+
+void AsyncLogChannel::open(void)
+{
+    std::lock_guard<std::mutex> lock(_ringsMutex);
+    if (_running) return;
+    _running = true;
+    _flusher = std::thread(&AsyncLogChannel::flusherLoop, this);
+}
+
+void AsyncLogChannel::close(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(_ringsMutex);
+        if (not _running) return;
+        _running = false;
+    }
+    _flusher.join();
+    this->flush();
+}
+
+void AsyncLogChannel::log(const Poco::Message &msg)
+{
+    //closed channel: log directly to the destination
+    if (not _running)
+    {
+        this->flush();
+        std::lock_guard<std::mutex> lock(_flushMutex);
+        _channel->log(msg);
+        return;
+    }
+
+    if (not this->getThreadRing()->queue.push(Poco::Message(msg))) _dropped++;
+}
+
+std::shared_ptr<AsyncLogRing> AsyncLogChannel::getThreadRing(void)
+{
+    static thread_local AsyncLogThreadState state;
+    for (const auto &pair : state.rings)
+    {
+        if (pair.first == _id) return pair.second;
+    }
+
+    //first message from this thread: register a new ring
+    std::shared_ptr<AsyncLogRing> ring(new AsyncLogRing());
+    {
+        std::lock_guard<std::mutex> lock(_ringsMutex);
+        _rings.push_back(ring);
+    }
+    state.rings.emplace_back(_id, ring);
+    return ring;
+}
+
+bool AsyncLogChannel::flush(void)
+{
+    std::unique_lock<std::mutex> lock(_flushMutex, std::defer_lock);
+    if (not lock.try_lock()) return false; //flushing in another thread
+
+    std::vector<std::shared_ptr<AsyncLogRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock0(_ringsMutex);
+        rings = _rings;
+    }
+
+    bool flushed = false;
+    Poco::Message msg;
+    for (const auto &ring : rings)
+    {
+        //check exited before draining so no message is left behind
+        const bool exited = ring->exited.load();
+        while (ring->queue.pop(msg))
+        {
+            _channel->log(msg);
+            flushed = true;
+        }
+        if (not exited) continue;
+        std::lock_guard<std::mutex> lock0(_ringsMutex);
+        for (auto it = _rings.begin(); it != _rings.end(); ++it)
+        {
+            if (*it != ring) continue;
+            _rings.erase(it);
+            break;
+        }
+    }
+
+    const auto dropped = _dropped.exchange(0);
+    if (dropped != 0) _channel->log(Poco::Message("Pothos.Logger",
+        "dropped " + std::to_string(dropped) + " log messages from full queues",
+        Poco::Message::PRIO_WARNING));
+    return flushed;
+}
+
+void AsyncLogChannel::flusherLoop(void)
+{
+    while (_running)
+    {
+        if (not this->flush()) std::this_thread::sleep_for(FlushPeriod);
+    }
+}
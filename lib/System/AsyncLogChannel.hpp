@@ -0,0 +1,57 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Poco/Channel.h>
+#include <Poco/Message.h>
+#include <Poco/AutoPtr.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+
+struct AsyncLogRing;
+
+/*!
+ * AsyncLogChannel forwards log messages to another channel from a flusher thread.
+ * Each logging thread pushes into its own lock-free ring of messages,
+ * so the caller never waits on the formatting or the I/O of the destination,
+ * which may be a console, a file, or a remote syslog over UDP.
+ * A message is dropped when the ring of its thread is full,
+ * and the flusher reports the number of dropped messages.
+ * Once closed, messages are logged directly to the destination.
+ */
+class AsyncLogChannel : public Poco::Channel
+{
+public:
+    //! Create an async channel that forwards to the given channel
+    AsyncLogChannel(Poco::Channel *channel);
+
+    //! Start the flusher thread
+    void open(void);
+
+    //! Stop the flusher thread and flush the pending messages
+    void close(void);
+
+    //! Enqueue a message from the calling thread
+    void log(const Poco::Message &msg);
+
+protected:
+    ~AsyncLogChannel(void);
+
+private:
+    std::shared_ptr<AsyncLogRing> getThreadRing(void);
+    void flusherLoop(void);
+    bool flush(void);
+
+    Poco::AutoPtr<Poco::Channel> _channel;
+    const size_t _id;
+    std::mutex _ringsMutex;
+    std::vector<std::shared_ptr<AsyncLogRing>> _rings;
+    std::mutex _flushMutex; //one consumer of the rings at a time
+    std::atomic<bool> _running;
+    std::atomic<unsigned long long> _dropped;
+    std::thread _flusher;
+};
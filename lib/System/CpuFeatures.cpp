@@ -0,0 +1,189 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/System/CpuFeatures.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define POTHOS_CPU_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h> //_xgetbv
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__linux__) && (defined(__aarch64__) || defined(__arm__))
+#include <sys/auxv.h>
+#endif
+
+/***********************************************************************
+ * Platform detection
+ **********************************************************************/
+#ifdef POTHOS_CPU_X86
+static void cpuid(const unsigned leaf, const unsigned subleaf, unsigned regs[4])
+{
+    #ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, int(leaf), int(subleaf));
+    for (size_t i = 0; i < 4; i++) regs[i] = unsigned(r[i]);
+    #else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+    #endif
+}
+
+static unsigned long long xgetbv0(void)
+{
+    #ifdef _MSC_VER
+    return _xgetbv(0);
+    #else
+    unsigned eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+    #endif
+}
+
+static void detectFeatures(Pothos::System::CpuFeatures &features)
+{
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const unsigned maxLeaf = regs[0];
+    if (maxLeaf < 1) return;
+
+    cpuid(1, 0, regs);
+    const unsigned ecx1 = regs[2];
+    features.sse4_1 = ((ecx1 >> 19) & 0x1) != 0;
+    features.sse4_2 = ((ecx1 >> 20) & 0x1) != 0;
+
+    //the extended registers also need to be saved by the OS
+    const bool osxsave = ((ecx1 >> 27) & 0x1) != 0;
+    const unsigned long long xcr0 = osxsave?xgetbv0():0;
+    const bool osYmm = (xcr0 & 0x6) == 0x6;
+    const bool osZmm = (xcr0 & 0xe6) == 0xe6;
+    features.avx = osYmm and ((ecx1 >> 28) & 0x1) != 0;
+
+    if (maxLeaf < 7) return;
+    cpuid(7, 0, regs);
+    const unsigned ebx7 = regs[1];
+    features.avx2 = osYmm and ((ebx7 >> 5) & 0x1) != 0;
+    features.avx512f = osZmm and ((ebx7 >> 16) & 0x1) != 0;
+}
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+
+static void detectFeatures(Pothos::System::CpuFeatures &features)
+{
+    //advanced simd is part of the base armv8-a architecture
+    features.neon = true;
+    #if defined(__linux__)
+    #ifndef HWCAP_SVE
+    #define HWCAP_SVE (1 << 22)
+    #endif
+    features.sve = (getauxval(AT_HWCAP) & HWCAP_SVE) != 0;
+    #endif
+}
+
+#elif defined(__arm__) || defined(_M_ARM)
+
+static void detectFeatures(Pothos::System::CpuFeatures &features)
+{
+    #if defined(__linux__)
+    #ifndef HWCAP_NEON
+    #define HWCAP_NEON (1 << 12)
+    #endif
+    features.neon = (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+    #elif defined(__ARM_NEON)
+    features.neon = true;
+    #else
+    (void)features;
+    #endif
+}
+
+#else
+
+static void detectFeatures(Pothos::System::CpuFeatures &)
+{
+    return;
+}
+
+#endif
+
+/***********************************************************************
+ * CpuFeatures implementation
+ **********************************************************************/
+Pothos::System::CpuFeatures::CpuFeatures(void):
+    sse4_1(false),
+    sse4_2(false),
+    avx(false),
+    avx2(false),
+    avx512f(false),
+    neon(false),
+    sve(false)
+{
+    return;
+}
+
+Pothos::System::CpuFeatures Pothos::System::CpuFeatures::get(void)
+{
+    static const CpuFeatures features = []
+    {
+        CpuFeatures f;
+        detectFeatures(f);
+        return f;
+    }();
+    return features;
+}
+
+std::vector<std::string> Pothos::System::CpuFeatures::ranking(void)
+{
+    return {"avx512f", "avx2", "avx", "sse4_2", "sse4_1", "sve", "neon"};
+}
+
+bool Pothos::System::CpuFeatures::has(const std::string &name) const
+{
+    if (name == "avx512f") return avx512f;
+    if (name == "avx2") return avx2;
+    if (name == "avx") return avx;
+    if (name == "sse4_2") return sse4_2;
+    if (name == "sse4_1") return sse4_1;
+    if (name == "sve") return sve;
+    if (name == "neon") return neon;
+    return false;
+}
+
+std::vector<std::string> Pothos::System::CpuFeatures::names(void) const
+{
+    std::vector<std::string> supported;
+    for (const auto &name : ranking())
+    {
+        if (this->has(name)) supported.push_back(name);
+    }
+    return supported;
+}
+
+#include <Pothos/Managed.hpp>
+#include <Pothos/Object/Serialize.hpp>
+
+static auto managedCpuFeatures = Pothos::ManagedClass()
+    .registerConstructor<Pothos::System::CpuFeatures>()
+    .registerStaticMethod(POTHOS_FCN_TUPLE(Pothos::System::CpuFeatures, get))
+    .registerStaticMethod(POTHOS_FCN_TUPLE(Pothos::System::CpuFeatures, ranking))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::System::CpuFeatures, has))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::System::CpuFeatures, names))
+    .commit("Pothos/System/CpuFeatures");
+
+namespace Pothos { namespace serialization {
+template <class Archive>
+void serialize(Archive &ar, Pothos::System::CpuFeatures &t, const unsigned int)
+{
+    ar & t.sse4_1;
+    ar & t.sse4_2;
+    ar & t.avx;
+    ar & t.avx2;
+    ar & t.avx512f;
+    ar & t.neon;
+    ar & t.sve;
+}
+}}
+
+POTHOS_OBJECT_SERIALIZE(Pothos::System::CpuFeatures)
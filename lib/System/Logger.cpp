@@ -1,7 +1,9 @@
-// Copyright (c) 2013-2016 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/System/Logger.hpp>
+#include "System/AsyncLogChannel.hpp"
+#include "System/SyslogStream.hpp"
 #include <Pothos/Util/Network.hpp>
 #include <Pothos/Plugin/Static.hpp> //static block
 #include <Poco/Logger.h>
@@ -17,9 +19,9 @@
 #include <Poco/FormattingChannel.h>
 #include <Poco/PatternFormatter.h>
 #include <Poco/SplitterChannel.h>
-#include <Poco/Net/RemoteSyslogChannel.h>
 #include <Poco/Net/RemoteSyslogListener.h>
 #include <Poco/Net/DatagramSocket.h>
+#include <Poco/Net/ServerSocket.h>
 #include <Poco/String.h>
 #include <Poco/AutoPtr.h>
 #include <Poco/URI.h>
@@ -37,6 +39,42 @@ static std::mutex &getSetupLoggerMutex(void)
     return mutex;
 }
 
+/***********************************************************************
+ * Async logging to the root channel:
+ * The async channel is closed at exit to flush the pending messages.
+ **********************************************************************/
+struct AsyncRootChannel
+{
+    ~AsyncRootChannel(void)
+    {
+        if (channel) channel->close();
+    }
+
+    Poco::AutoPtr<AsyncLogChannel> channel;
+};
+
+static AsyncRootChannel asyncRootChannel;
+
+/*!
+ * Set the root channel, wrapped by an async channel unless POTHOS_LOG_ASYNC=false.
+ * The async channel keeps the I/O of the destination out of the logging threads.
+ */
+static void setRootChannel(Poco::Channel *channel)
+{
+    if (asyncRootChannel.channel) asyncRootChannel.channel->close();
+    asyncRootChannel.channel = nullptr;
+
+    if (Poco::toLower(Poco::Environment::get("POTHOS_LOG_ASYNC", "true")) == "false")
+    {
+        Poco::Logger::get("").setChannel(channel);
+        return;
+    }
+
+    asyncRootChannel.channel = new AsyncLogChannel(channel);
+    asyncRootChannel.channel->open();
+    Poco::Logger::get("").setChannel(asyncRootChannel.channel.get());
+}
+
 /***********************************************************************
  * InterceptStream custom streambuf to redirect to logger
  **********************************************************************/
@@ -128,6 +166,7 @@ private:
  * Public System Logger API implementation
  **********************************************************************/
 static Poco::AutoPtr<Poco::Net::RemoteSyslogListener> listener;
+static std::unique_ptr<SyslogStreamListener> streamListener;
 
 std::string Pothos::System::Logger::startSyslogListener(void)
 {
@@ -135,17 +174,32 @@ std::string Pothos::System::Logger::startSyslogListener(void)
 
     if (not listener)
     {
-        //find an available udp port
+        //find a port that is available for both tcp and udp:
+        //tcp streams from this version, udp datagrams from older versions
         const auto addr = Poco::URI("udp://"+Pothos::Util::getWildcardAddr()).getHost();
-        Poco::Net::DatagramSocket sock(Poco::Net::SocketAddress(addr, 0));
-        const auto port = sock.address().port();
-        sock.close();
+        std::unique_ptr<Poco::Net::ServerSocket> serverSock;
+        for (size_t attempt = 0; not serverSock; attempt++)
+        {
+            serverSock.reset(new Poco::Net::ServerSocket(Poco::Net::SocketAddress(addr, 0)));
+            try
+            {
+                Poco::Net::DatagramSocket sock(Poco::Net::SocketAddress(addr, serverSock->address().port()));
+                sock.close();
+            }
+            catch (const Poco::Exception &)
+            {
+                if (attempt == 10) throw;
+                serverSock.reset();
+            }
+        }
+        const auto port = serverSock->address().port();
 
-        //create a new listener and feed it the root channel
+        //create new listeners and feed them the root channel
         //FIXME syslog listener always binds to IPv4...
         listener = new Poco::Net::RemoteSyslogListener(port);
         listener->addChannel(Poco::Logger::get("").getChannel());
         listener->open();
+        streamListener.reset(new SyslogStreamListener(*serverSock, Poco::Logger::get("").getChannel()));
     }
 
     //return the port number of the log service
@@ -156,16 +210,17 @@ void Pothos::System::Logger::stopSyslogListener(void)
 {
     std::lock_guard<std::mutex> lock(getSetupLoggerMutex());
     if (not listener) return;
+    streamListener.reset();
     listener->close();
     listener = nullptr;
 }
 
-static Poco::AutoPtr<Poco::Net::RemoteSyslogChannel> forwarder;
+static Poco::AutoPtr<Poco::Channel> forwarder;
 
 static void __startSyslogForwarding(const std::string &addr)
 {
-    forwarder = new Poco::Net::RemoteSyslogChannel(addr, ""/*empty name*/);
-    Poco::Logger::get("").setChannel(forwarder);
+    forwarder = makeSyslogForwardingChannel(addr);
+    setRootChannel(forwarder.get());
     Poco::Logger::get("").setLevel(Poco::Environment::get("POTHOS_LOG_LEVEL", "information"));
 
     //subprocesses will automatically forward to this address
@@ -232,7 +287,7 @@ static void __setupDefaultLogging(void)
     Poco::AutoPtr<Poco::Channel> formattingChannel(new Poco::FormattingChannel(formatter, channel));
     Poco::AutoPtr<Poco::SplitterChannel> splitterChannel(new Poco::SplitterChannel());
     splitterChannel->addChannel(formattingChannel);
-    Poco::Logger::get("").setChannel(splitterChannel);
+    setRootChannel(splitterChannel.get());
 
     //syslog forwarding when the address is specified
     const auto syslogAddr = Poco::Environment::get("POTHOS_SYSLOG_ADDR", "");
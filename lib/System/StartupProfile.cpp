@@ -0,0 +1,99 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "System/StartupProfile.hpp"
+#include <Poco/Environment.h>
+#include <Poco/Format.h>
+#include <Poco/Logger.h>
+#include <algorithm> //sort
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <utility> //pair
+#include <vector>
+#include <mutex>
+#include <map>
+
+struct StartupProfileEntry
+{
+    StartupProfileEntry(void): seconds(0.0), count(0){}
+    double seconds;
+    size_t count;
+};
+
+static std::mutex &getStartupProfileMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+//! The entries by category and name, repeated steps are summed
+static std::map<std::pair<std::string, std::string>, StartupProfileEntry> &getStartupProfileEntries(void)
+{
+    static std::map<std::pair<std::string, std::string>, StartupProfileEntry> entries;
+    return entries;
+}
+
+bool startupProfileEnabled(void)
+{
+    //read every time, so that a setting made before Pothos::init() applies
+    const auto value = Poco::Environment::get("POTHOS_STARTUP_PROFILE", "");
+    return not value.empty() and value != "0" and value != "false";
+}
+
+void startupProfileRecord(const std::string &category, const std::string &name, const double seconds)
+{
+    std::lock_guard<std::mutex> lock(getStartupProfileMutex());
+    auto &entry = getStartupProfileEntries()[std::make_pair(category, name)];
+    entry.seconds += seconds;
+    entry.count++;
+}
+
+void startupProfileReport(const double totalSeconds)
+{
+    std::map<std::pair<std::string, std::string>, StartupProfileEntry> entries;
+    {
+        std::lock_guard<std::mutex> lock(getStartupProfileMutex());
+        entries.swap(getStartupProfileEntries());
+    }
+
+    //the totals per category, and the steps sorted by the longest time
+    std::map<std::string, StartupProfileEntry> categories;
+    std::vector<std::pair<std::pair<std::string, std::string>, StartupProfileEntry>> sorted(entries.begin(), entries.end());
+    for (const auto &entry : sorted)
+    {
+        auto &category = categories[entry.first.first];
+        category.seconds += entry.second.seconds;
+        category.count += entry.second.count;
+    }
+    std::sort(sorted.begin(), sorted.end(), [](
+        const std::pair<std::pair<std::string, std::string>, StartupProfileEntry> &a,
+        const std::pair<std::pair<std::string, std::string>, StartupProfileEntry> &b)
+    {
+        return a.second.seconds > b.second.seconds;
+    });
+
+    std::ostringstream os;
+    os << Poco::format("Startup profile: %.3f seconds in Pothos::init()", totalSeconds) << std::endl;
+    os << "Totals per category (the static blocks and events run within the module loads):" << std::endl;
+    for (const auto &category : categories)
+    {
+        os << Poco::format("  %10.3f ms %6z  %s", category.second.seconds*1e3, category.second.count, category.first) << std::endl;
+    }
+    os << "Breakdown per step by the longest time:" << std::endl;
+    for (const auto &entry : sorted)
+    {
+        os << Poco::format("  %10.3f ms %6z  %-8s %s", entry.second.seconds*1e3, entry.second.count,
+            entry.first.first, entry.first.second) << std::endl;
+    }
+
+    const auto dest = Poco::Environment::get("POTHOS_STARTUP_PROFILE", "");
+    if (dest == "stdout") std::cout << os.str() << std::flush;
+    else if (dest == "1" or dest == "true" or dest == "stderr") std::cerr << os.str() << std::flush;
+    else
+    {
+        std::ofstream file(dest.c_str());
+        file << os.str();
+        if (not file) poco_error(Poco::Logger::get("Pothos.StartupProfile"), "failed to write " + dest);
+    }
+}
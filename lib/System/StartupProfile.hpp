@@ -0,0 +1,54 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <chrono>
+#include <string>
+
+/*!
+ * The startup profile records the wall time of each step of Pothos::init():
+ * the module loads, the static blocks, the conf files, the plugin event handlers,
+ * the managed class commits, and the safe load probes.
+ * The profile is enabled by the POTHOS_STARTUP_PROFILE environment variable,
+ * and the report is printed when Pothos::init() completes:
+ * "1" or "stderr" prints to stderr, "stdout" prints to stdout,
+ * and any other value is the path of a file to write.
+ */
+bool startupProfileEnabled(void);
+
+//! Record the wall time of a step by category and name (thread safe)
+void startupProfileRecord(const std::string &category, const std::string &name, const double seconds);
+
+//! Print the sorted breakdown of the recorded steps, and clear the records
+void startupProfileReport(const double totalSeconds);
+
+/*!
+ * Record the wall time of a scope in the startup profile.
+ * The timer does nothing when the profile is not enabled.
+ */
+class StartupProfileTimer
+{
+public:
+    StartupProfileTimer(const char *category, const std::string &name):
+        _enabled(startupProfileEnabled())
+    {
+        if (not _enabled) return;
+        _category = category;
+        _name = name;
+        _start = std::chrono::high_resolution_clock::now();
+    }
+
+    ~StartupProfileTimer(void)
+    {
+        if (not _enabled) return;
+        const auto elapsed = std::chrono::high_resolution_clock::now() - _start;
+        startupProfileRecord(_category, _name, std::chrono::duration<double>(elapsed).count());
+    }
+
+private:
+    const bool _enabled;
+    std::string _category;
+    std::string _name;
+    std::chrono::high_resolution_clock::time_point _start;
+};
@@ -0,0 +1,322 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "System/SyslogStream.hpp"
+#include <Poco/Net/RemoteSyslogChannel.h>
+#include <Poco/Net/TCPServerConnection.h>
+#include <Poco/Net/TCPServerConnectionFactory.h>
+#include <Poco/Exception.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Timespan.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+/*!
+ * The size of the pending buffer that blocks the logging threads.
+ */
+static const size_t MaxPendingBytes = 1 << 20;
+
+/*!
+ * The largest frame accepted by the listener.
+ * A larger length is not a log stream and the connection is closed.
+ */
+static const size_t MaxFrameBytes = 1 << 20;
+
+/*!
+ * Timeouts for the connection and the period between reconnects.
+ */
+static const long ConnectTimeoutSecs = 1;
+static const std::chrono::seconds ReconnectPeriod(1);
+
+/***********************************************************************
+ * Message framing
+ **********************************************************************/
+static std::string encodeFrame(const Poco::Message &msg)
+{
+    const auto payload = std::to_string(int(msg.getPriority())) + " " +
+        std::to_string(msg.getTime().epochMicroseconds()) + " " +
+        msg.getSource() + "\n" + msg.getText();
+    return std::to_string(payload.size()) + " " + payload;
+}
+
+/*!
+ * Decode the next complete frame of the buffer starting at pos.
+ * \return true when a message was decoded and pos was advanced
+ * \throws std::exception when the buffer is not a log stream
+ */
+static bool decodeFrame(const std::string &buff, size_t &pos, Poco::Message &msg)
+{
+    const auto lengthEnd = buff.find(' ', pos);
+    if (lengthEnd == std::string::npos)
+    {
+        if (buff.size()-pos > 20) throw std::invalid_argument("frame length");
+        return false;
+    }
+    const auto length = std::stoull(buff.substr(pos, lengthEnd-pos));
+    if (length > MaxFrameBytes) throw std::invalid_argument("frame length");
+    if (buff.size() < lengthEnd+1+length) return false;
+    const auto payload = buff.substr(lengthEnd+1, size_t(length));
+    pos = lengthEnd+1+size_t(length);
+
+    const auto prioEnd = payload.find(' ');
+    const auto timeEnd = payload.find(' ', prioEnd+1);
+    const auto sourceEnd = payload.find('\n', timeEnd+1);
+    if (prioEnd == std::string::npos or timeEnd == std::string::npos or sourceEnd == std::string::npos)
+    {
+        throw std::invalid_argument("frame payload");
+    }
+    const auto prio = std::stoi(payload.substr(0, prioEnd));
+    if (prio < Poco::Message::PRIO_FATAL or prio > Poco::Message::PRIO_TRACE) throw std::invalid_argument("frame priority");
+
+    msg.setPriority(Poco::Message::Priority(prio));
+    msg.setTime(Poco::Timestamp(Poco::Timestamp::TimeVal(std::stoll(payload.substr(prioEnd+1, timeEnd-prioEnd-1)))));
+    msg.setSource(payload.substr(timeEnd+1, sourceEnd-timeEnd-1));
+    msg.setText(payload.substr(sourceEnd+1));
+    return true;
+}
+
+static void sendAll(Poco::Net::StreamSocket &sock, const std::string &data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        const int ret = sock.sendBytes(data.data()+sent, int(std::min<size_t>(data.size()-sent, MaxPendingBytes)));
+        if (ret <= 0) throw Poco::IOException("SyslogStreamChannel::sendBytes()");
+        sent += size_t(ret);
+    }
+}
+
+/***********************************************************************
+ * Stream channel implementation
+ **********************************************************************/
+SyslogStreamChannel::SyslogStreamChannel(const Poco::Net::SocketAddress &addr):
+    _addr(addr),
+    _running(false),
+    _connected(false),
+    _dropped(0)
+{
+    _sock.connect(_addr, Poco::Timespan(ConnectTimeoutSecs, 0));
+    _connected = true;
+}
+
+SyslogStreamChannel::~SyslogStreamChannel(void)
+{
+    this->close();
+}
+
+void SyslogStreamChannel::open(void)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running) return;
+    _running = true;
+    _sender = std::thread(&SyslogStreamChannel::senderLoop, this);
+}
+
+void SyslogStreamChannel::close(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (not _running) return;
+        _running = false;
+    }
+    _cond.notify_all();
+    _sender.join();
+}
+
+void SyslogStreamChannel::log(const Poco::Message &msg)
+{
+    this->open(); //opened on demand like the other network channels
+    const auto frame = encodeFrame(msg);
+
+    //back-pressure: wait for the sender to drain the pending buffer
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cond.wait(lock, [this]{return _pending.size() < MaxPendingBytes or not _connected or not _running;});
+    if (not _connected or not _running)
+    {
+        _dropped++;
+        return;
+    }
+    _pending += frame;
+    _cond.notify_all();
+}
+
+bool SyslogStreamChannel::reconnect(void)
+{
+    try
+    {
+        _sock.close();
+        _sock = Poco::Net::StreamSocket();
+        _sock.connect(_addr, Poco::Timespan(ConnectTimeoutSecs, 0));
+        return true;
+    }
+    catch (const Poco::Exception &)
+    {
+        return false;
+    }
+}
+
+void SyslogStreamChannel::senderLoop(void)
+{
+    std::string batch;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        if (not _connected)
+        {
+            lock.unlock();
+            const bool ok = this->reconnect();
+            lock.lock();
+            _connected = ok;
+            if (not _running and not ok) break;
+            if (not ok) _cond.wait_for(lock, ReconnectPeriod, [this]{return not _running;});
+            continue;
+        }
+
+        if (_pending.empty() and _dropped == 0)
+        {
+            if (not _running) break;
+            _cond.wait(lock);
+            continue;
+        }
+
+        //everything logged since the last send goes out as one batch
+        batch.clear();
+        batch.swap(_pending);
+        if (_dropped != 0) batch += encodeFrame(Poco::Message("Pothos.Logger",
+            "dropped " + std::to_string(_dropped) + " log messages while disconnected",
+            Poco::Message::PRIO_WARNING));
+        _dropped = 0;
+        _cond.notify_all(); //wake the blocked logging threads
+
+        lock.unlock();
+        bool ok = true;
+        try
+        {
+            sendAll(_sock, batch);
+        }
+        catch (const Poco::Exception &)
+        {
+            ok = false;
+        }
+        lock.lock();
+        if (not ok) _connected = false;
+        _cond.notify_all();
+    }
+    _sock.close();
+}
+
+/***********************************************************************
+ * Stream listener implementation
+ **********************************************************************/
+class SyslogStreamConnection : public Poco::Net::TCPServerConnection
+{
+public:
+    SyslogStreamConnection(const Poco::Net::StreamSocket &sock, Poco::Channel *channel, const std::shared_ptr<std::atomic<bool>> &stopped):
+        Poco::Net::TCPServerConnection(sock),
+        _channel(channel, true/*shared*/),
+        _stopped(stopped)
+    {
+        return;
+    }
+
+    void run(void)
+    {
+        //the timeout checks for the stopped listener on an idle connection
+        this->socket().setReceiveTimeout(Poco::Timespan(1, 0));
+        std::string buff;
+        std::vector<char> chunk(64*1024);
+        Poco::Message msg;
+        try
+        {
+            while (not *_stopped)
+            {
+                int ret = 0;
+                try
+                {
+                    ret = this->socket().receiveBytes(chunk.data(), int(chunk.size()));
+                }
+                catch (const Poco::TimeoutException &)
+                {
+                    continue;
+                }
+                if (ret <= 0) return; //closed by the peer
+                buff.append(chunk.data(), size_t(ret));
+
+                size_t pos = 0;
+                while (decodeFrame(buff, pos, msg)) _channel->log(msg);
+                buff.erase(0, pos);
+            }
+        }
+        catch (const Poco::Exception &){} //connection lost
+        catch (const std::exception &){} //not a log stream
+    }
+
+private:
+    Poco::AutoPtr<Poco::Channel> _channel;
+    const std::shared_ptr<std::atomic<bool>> _stopped;
+};
+
+class SyslogStreamConnectionFactory : public Poco::Net::TCPServerConnectionFactory
+{
+public:
+    SyslogStreamConnectionFactory(Poco::Channel *channel, const std::shared_ptr<std::atomic<bool>> &stopped):
+        _channel(channel),
+        _stopped(stopped)
+    {
+        return;
+    }
+
+    Poco::Net::TCPServerConnection *createConnection(const Poco::Net::StreamSocket &sock)
+    {
+        return new SyslogStreamConnection(sock, _channel, _stopped);
+    }
+
+private:
+    Poco::Channel *_channel;
+    const std::shared_ptr<std::atomic<bool>> _stopped;
+};
+
+SyslogStreamListener::SyslogStreamListener(const Poco::Net::ServerSocket &sock, Poco::Channel *channel):
+    _channel(channel, true/*shared*/),
+    _stopped(std::make_shared<std::atomic<bool>>(false))
+{
+    _server.reset(new Poco::Net::TCPServer(new SyslogStreamConnectionFactory(_channel.get(), _stopped), sock));
+    _server->start();
+}
+
+SyslogStreamListener::~SyslogStreamListener(void)
+{
+    *_stopped = true;
+    _server->stop();
+}
+
+/***********************************************************************
+ * Forwarding channel factory
+ **********************************************************************/
+Poco::AutoPtr<Poco::Channel> makeSyslogForwardingChannel(const std::string &addr)
+{
+    std::string scheme, hostPort(addr);
+    const auto sep = addr.find("://");
+    if (sep != std::string::npos)
+    {
+        scheme = addr.substr(0, sep);
+        hostPort = addr.substr(sep+3);
+    }
+    if (not scheme.empty() and scheme != "tcp" and scheme != "udp")
+    {
+        throw Poco::InvalidArgumentException("makeSyslogForwardingChannel("+addr+")", "unsupported scheme");
+    }
+
+    if (scheme != "udp") try
+    {
+        return Poco::AutoPtr<Poco::Channel>(new SyslogStreamChannel(Poco::Net::SocketAddress(hostPort)));
+    }
+    catch (const Poco::Exception &)
+    {
+        if (scheme == "tcp") throw;
+    }
+    return Poco::AutoPtr<Poco::Channel>(new Poco::Net::RemoteSyslogChannel(hostPort, ""/*empty name*/));
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Poco/Channel.h>
+#include <Poco/Message.h>
+#include <Poco/AutoPtr.h>
+#include <Poco/Net/SocketAddress.h>
+#include <Poco/Net/StreamSocket.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/TCPServer.h>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <string>
+
+/*!
+ * SyslogStreamChannel forwards log messages to a SyslogStreamListener over TCP.
+ * Unlike the UDP syslog channel, a burst of messages is never lost:
+ * Messages are coalesced into a pending buffer that a sender thread
+ * writes to the socket in large batches, and the logging thread
+ * blocks when the pending buffer is full until the socket drains.
+ * Messages are dropped only when the connection was lost,
+ * in which case the channel reconnects in the background.
+ *
+ * Each message is framed with its length in octets (RFC 6587):
+ * "<length> <priority> <source>\n<text>"
+ */
+class SyslogStreamChannel : public Poco::Channel
+{
+public:
+    /*!
+     * Create a channel connected to the listener.
+     * \throws Poco::Exception when the listener cannot be reached
+     */
+    SyslogStreamChannel(const Poco::Net::SocketAddress &addr);
+
+    //! Start the sender thread
+    void open(void);
+
+    //! Stop the sender thread and send the pending messages
+    void close(void);
+
+    //! Enqueue a message, blocks when the pending buffer is full
+    void log(const Poco::Message &msg);
+
+protected:
+    ~SyslogStreamChannel(void);
+
+private:
+    void senderLoop(void);
+    bool reconnect(void);
+
+    const Poco::Net::SocketAddress _addr;
+    Poco::Net::StreamSocket _sock;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::string _pending;
+    bool _running;
+    bool _connected;
+    unsigned long long _dropped;
+    std::thread _sender;
+};
+
+/*!
+ * SyslogStreamListener accepts SyslogStreamChannel connections
+ * and logs the received messages into the given channel.
+ */
+class SyslogStreamListener
+{
+public:
+    //! Listen on the socket, log received messages to the channel
+    SyslogStreamListener(const Poco::Net::ServerSocket &sock, Poco::Channel *channel);
+
+    //! Stop the listener and close the connections
+    ~SyslogStreamListener(void);
+
+private:
+    Poco::AutoPtr<Poco::Channel> _channel;
+    std::shared_ptr<std::atomic<bool>> _stopped; //shared with the connections
+    std::unique_ptr<Poco::Net::TCPServer> _server;
+};
+
+/*!
+ * Create a channel that forwards to the syslog address.
+ * The address format is host:port, optionally with a tcp:// or udp:// scheme.
+ * Without a scheme, a TCP stream is preferred and a UDP syslog channel
+ * is used when the listener does not accept TCP (an older listener).
+ */
+Poco::AutoPtr<Poco::Channel> makeSyslogForwardingChannel(const std::string &addr);
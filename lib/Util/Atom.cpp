@@ -0,0 +1,71 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Util/Atom.hpp>
+#include <Pothos/Util/SpinLockRW.hpp>
+#include <unordered_map>
+#include <mutex>
+#include <ostream>
+
+/***********************************************************************
+ * The global atom table:
+ * Strings are the keys of a node based map so their addresses are stable.
+ * Lookups of existing atoms only take the shared lock.
+ **********************************************************************/
+struct AtomTable
+{
+    AtomTable(void)
+    {
+        ids.emplace(std::string(), 0);
+    }
+    Pothos::Util::SpinLockRW mutex;
+    std::unordered_map<std::string, size_t> ids;
+};
+
+static AtomTable &getAtomTable(void)
+{
+    static AtomTable table;
+    return table;
+}
+
+template <typename StrType>
+static const std::pair<const std::string, size_t> &internAtom(const StrType &str)
+{
+    auto &table = getAtomTable();
+    {
+        Pothos::Util::SpinLockRW::SharedLock lock(table.mutex);
+        auto it = table.ids.find(str);
+        if (it != table.ids.end()) return *it;
+    }
+    std::lock_guard<Pothos::Util::SpinLockRW> lock(table.mutex);
+    return *table.ids.emplace(str, table.ids.size()).first;
+}
+
+/***********************************************************************
+ * Atom implementation
+ **********************************************************************/
+Pothos::Util::Atom::Atom(void)
+{
+    //the empty atom is common, so skip the table after the first lookup
+    static const auto &entry = internAtom(std::string());
+    _str = &entry.first;
+    _id = entry.second;
+}
+
+Pothos::Util::Atom::Atom(const std::string &str)
+{
+    const auto &entry = internAtom(str);
+    _str = &entry.first;
+    _id = entry.second;
+}
+
+Pothos::Util::Atom::Atom(const char *str):
+    Atom(std::string(str))
+{
+    return;
+}
+
+std::ostream &Pothos::Util::operator<<(std::ostream &os, const Atom &atom)
+{
+    return os << atom.str();
+}
@@ -1,10 +1,12 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Util/BlockDescription.hpp>
 #include <Pothos/Exception.hpp>
 #include <Pothos/Plugin.hpp>
+#include <Pothos/System/Paths.hpp>
+#include <Pothos/System/Version.hpp>
 #include <Poco/String.h>
 #include <Poco/Format.h>
 #include <Poco/Path.h>
@@ -13,7 +15,11 @@
 #include <Poco/Types.h>
 #include <Poco/File.h>
 #include <Poco/Path.h>
+#include <Poco/Process.h>
 #include <fstream>
+#include <sstream>
+#include <iterator>
+#include <functional> //hash
 #include <vector>
 #include <string>
 #include <cassert>
@@ -499,30 +505,84 @@ static json parseCommentBlockForMarkup(const CodeBlock &commentBlock)
 }
 
 /***********************************************************************
- * parser interface
+ * Cache of parsed descriptions in the user data directory
  **********************************************************************/
-struct Pothos::Util::BlockDescriptionParser::Impl
+//! The cache file for the descriptions of a source file
+static std::string getDescriptionCachePath(const std::string &filePath)
 {
-    std::map<std::string, json> objects;
-    json array;
-    std::vector<std::string> factories;
-};
+    const auto absPath = Poco::Path(Poco::Path::expand(filePath)).absolute().toString();
+    Poco::Path path(Pothos::System::getUserDataPath());
+    path.append("BlockDescCache");
+    path.append(Poco::NumberFormatter::formatHex(std::hash<std::string>()(absPath), 16) + ".json");
+    return path.toString();
+}
 
-Pothos::Util::BlockDescriptionParser::BlockDescriptionParser(void):
-    _impl(new Impl())
+//! Identify the contents and the parser that produced the descriptions
+static std::string getDescriptionCacheKey(const std::string &contents)
 {
-    return;
+    return Pothos::System::getLibVersion() + ":" + Poco::NumberFormatter::formatHex(std::hash<std::string>()(contents), 16);
 }
 
-void Pothos::Util::BlockDescriptionParser::feedStream(std::istream &is)
+//! Load cached descriptions, false when missing or out of date
+static bool loadDescriptionCache(const std::string &cachePath, const std::string &key, json &objects)
+{
+    try
+    {
+        std::ifstream cacheFile(cachePath);
+        if (not cacheFile) return false;
+        const auto cache = json::parse(cacheFile);
+        if (cache.value("key", "") != key) return false;
+        objects = cache.at("objects");
+        return objects.is_array();
+    }
+    catch (const std::exception &){}
+    return false;
+}
+
+//! Save the descriptions, the cache is best effort and errors are ignored
+static void saveDescriptionCache(const std::string &cachePath, const std::string &key, const json &objects)
 {
+    try
+    {
+        json cache;
+        cache["key"] = key;
+        cache["objects"] = objects;
+        Poco::File(Poco::Path(cachePath).parent()).createDirectories();
+
+        //write then rename so concurrent readers never see a partial file
+        const auto tempPath = cachePath + "." + std::to_string(Poco::Process::id());
+        {
+            std::ofstream tempFile(tempPath);
+            tempFile << cache.dump();
+            if (not tempFile) return Poco::File(tempPath).remove();
+        }
+        Poco::File(tempPath).renameTo(cachePath);
+    }
+    catch (...){}
+}
+
+//! Parse the markup of every comment block into an array of descriptions
+static json parseDescriptions(std::istream &is)
+{
+    json objects(json::array());
     for (const auto &contiguousBlock : extractContiguousBlocks(is))
     {
         const auto obj = parseCommentBlockForMarkup(contiguousBlock);
-        if (obj.empty()) continue;
+        if (not obj.empty()) objects.push_back(obj);
+    }
+    return objects;
+}
 
+/***********************************************************************
+ * parser interface
+ **********************************************************************/
+
+struct Pothos::Util::BlockDescriptionParser::Impl
+{
+    void store(const json &obj)
+    {
         //store into the array of all description objects
-        _impl->array.push_back(obj);
+        array.push_back(obj);
 
         //get a list of all paths including aliases
         std::vector<std::string> paths;
@@ -535,10 +595,25 @@ void Pothos::Util::BlockDescriptionParser::feedStream(std::istream &is)
         //store mapping for each factory path
         for (const auto &path : paths)
         {
-            _impl->factories.push_back(path);
-            _impl->objects[path] = obj;
+            factories.push_back(path);
+            objects[path] = obj;
         }
     }
+
+    std::map<std::string, json> objects;
+    json array;
+    std::vector<std::string> factories;
+};
+
+Pothos::Util::BlockDescriptionParser::BlockDescriptionParser(void):
+    _impl(new Impl())
+{
+    return;
+}
+
+void Pothos::Util::BlockDescriptionParser::feedStream(std::istream &is)
+{
+    for (const auto &obj : parseDescriptions(is)) _impl->store(obj);
 }
 
 void Pothos::Util::BlockDescriptionParser::feedFilePath(const std::string &filePath)
@@ -551,14 +626,27 @@ void Pothos::Util::BlockDescriptionParser::feedFilePath(const std::string &fileP
     if (not inputFile)
         throw Pothos::OpenFileException(filePath);
 
-    try
-    {
-        this->feedStream(inputFile);
-    }
-    catch (const Pothos::Exception &ex)
+    //reading and hashing is cheap compared to parsing the markup
+    const std::string contents((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
+    const auto cachePath = getDescriptionCachePath(filePath);
+    const auto cacheKey = getDescriptionCacheKey(contents);
+
+    json objects;
+    if (not loadDescriptionCache(cachePath, cacheKey, objects))
     {
-        throw Pothos::SyntaxException("BlockDescriptionParser("+filePath+")", ex);
+        try
+        {
+            std::istringstream is(contents);
+            objects = parseDescriptions(is);
+        }
+        catch (const Pothos::Exception &ex)
+        {
+            throw Pothos::SyntaxException("BlockDescriptionParser("+filePath+")", ex);
+        }
+        saveDescriptionCache(cachePath, cacheKey, objects);
     }
+
+    for (const auto &obj : objects) _impl->store(obj);
 }
 
 std::vector<std::string> Pothos::Util::BlockDescriptionParser::listFactories(void) const
@@ -1,24 +1,141 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Plugin.hpp>
+#include <Poco/Logger.h>
 #include <json.hpp>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <map>
 
 using json = nlohmann::json;
 
+//! Cached device info is reused for this long before probing again
+static const std::chrono::seconds DEVICE_INFO_TTL(30);
+
+//! The longest wait for all of the device info plugins of one dump
+static const std::chrono::seconds DEVICE_INFO_TIMEOUT(3);
+
+/***********************************************************************
+ * Device info cache: the last result and the probe in flight per device
+ **********************************************************************/
+struct DeviceInfoEntry
+{
+    DeviceInfoEntry(void):
+        valid(false),
+        probes(0)
+    {
+        return;
+    }
+
+    bool valid;
+    json info;
+    std::chrono::steady_clock::time_point time;
+    std::shared_future<std::string> pending;
+    size_t probes; //identifies the pending probe
+};
+
+static std::mutex &getDeviceInfoMutex(void)
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::map<std::string, DeviceInfoEntry> &getDeviceInfoCache(void)
+{
+    static std::map<std::string, DeviceInfoEntry> cache;
+    return cache;
+}
+
+//! Call the info plugin in its own thread, a stuck driver never blocks the caller
+static std::shared_future<std::string> launchDeviceInfo(const Pothos::Plugin &plugin)
+{
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::shared_future<std::string> future(promise->get_future().share());
+    std::thread([plugin, promise]
+    {
+        try
+        {
+            const auto &call = plugin.getObject().extract<Pothos::Callable>();
+            promise->set_value(call.call<std::string>());
+        }
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    }).detach();
+    return future;
+}
+
 class DeviceInfoUtilsDumpJson
 {
 public:
     static std::string dump(void)
     {
-        json deviceObj;
+        return dumpRefresh(false);
+    }
+
+    static std::string dumpRefresh(const bool refresh)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto deadline = now + DEVICE_INFO_TIMEOUT;
+        std::unique_lock<std::mutex> lock(getDeviceInfoMutex());
+        auto &cache = getDeviceInfoCache();
+
+        //start probes for the expired devices, all plugins are queried in parallel
+        std::vector<std::string> deviceNames;
         for (const auto &deviceName : Pothos::PluginRegistry::list("/devices"))
         {
             auto path = Pothos::PluginPath("/devices").join(deviceName).join("info");
             if (not Pothos::PluginRegistry::exists(path)) continue;
-            const auto plugin = Pothos::PluginRegistry::get(path);
-            const auto &call = plugin.getObject().extract<Pothos::Callable>();
-            deviceObj.push_back(json::parse(call.call<std::string>()));
+            deviceNames.push_back(deviceName);
+            auto &entry = cache[deviceName];
+            const bool expired = refresh or not entry.valid or (now - entry.time) > DEVICE_INFO_TTL;
+            if (expired and not entry.pending.valid())
+            {
+                entry.pending = launchDeviceInfo(Pothos::PluginRegistry::get(path));
+                entry.probes++;
+            }
+        }
+
+        //collect the probes without holding the lock on the wait
+        for (const auto &deviceName : deviceNames)
+        {
+            auto pending = cache[deviceName].pending;
+            const size_t probe = cache[deviceName].probes;
+            if (not pending.valid()) continue;
+            lock.unlock();
+            const bool ready = pending.wait_until(deadline) == std::future_status::ready;
+            lock.lock();
+
+            auto &entry = cache[deviceName];
+            if (not ready)
+            {
+                poco_warning_f2(Poco::Logger::get("Pothos.DeviceInfoUtils"), "%s info timed out, %s",
+                    deviceName, std::string(entry.valid?"using the cached info":"skipped"));
+                continue;
+            }
+            if (entry.probes != probe or not entry.pending.valid()) continue; //collected by another caller
+            entry.pending = std::shared_future<std::string>();
+            try
+            {
+                entry.info = json::parse(pending.get());
+                entry.valid = true;
+                entry.time = std::chrono::steady_clock::now();
+            }
+            catch (const std::exception &ex)
+            {
+                poco_error_f2(Poco::Logger::get("Pothos.DeviceInfoUtils"), "%s info failed: %s", deviceName, std::string(ex.what()));
+            }
+        }
+
+        json deviceObj;
+        for (const auto &deviceName : deviceNames)
+        {
+            const auto &entry = cache[deviceName];
+            if (entry.valid) deviceObj.push_back(entry.info);
         }
         return deviceObj.dump();
     }
@@ -29,4 +146,5 @@ public:
 static auto managedDeviceInfoUtils = Pothos::ManagedClass()
     .registerClass<DeviceInfoUtilsDumpJson>()
     .registerStaticMethod("dumpJson", &DeviceInfoUtilsDumpJson::dump)
+    .registerStaticMethod("dumpJson", &DeviceInfoUtilsDumpJson::dumpRefresh)
     .commit("Pothos/Util/DeviceInfoUtils");
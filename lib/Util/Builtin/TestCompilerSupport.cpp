@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2016 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Testing.hpp>
@@ -25,3 +25,27 @@ POTHOS_TEST_BLOCK("/util/tests", test_compiler)
     auto out = compiler->compileCppModule(args);
     std::cout << out.size() << std::endl;
 }
+
+POTHOS_TEST_BLOCK("/util/tests", test_compiler_multiple_sources)
+{
+    const auto compiler = Pothos::Util::Compiler::make();
+
+    //write the sources to file, the vector comes from the precompiled header
+    Pothos::Util::CompilerArgs args;
+    for (size_t i = 0; i < 3; i++)
+    {
+        const auto sourcePath = compiler->createTempFile(".cpp");
+        std::ofstream outFile(sourcePath);
+        outFile << "int foo" << i << "(void){return std::vector<int>(" << i << ").size();}" << std::endl;
+        outFile.close();
+        args.sources.push_back(sourcePath);
+    }
+    args.precompiledHeaders.push_back("vector");
+
+    //compile the sources, twice to use the cached header
+    for (size_t i = 0; i < 2; i++)
+    {
+        const auto out = compiler->compileCppModule(args);
+        POTHOS_TEST_TRUE(not out.empty());
+    }
+}
@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
@@ -6,6 +6,12 @@
 #include <Pothos/Proxy.hpp>
 #include <Pothos/Proxy/Environment.hpp>
 #include <Pothos/Exception.hpp>
+#include <Pothos/Util/BlockDescription.hpp>
+#include <Pothos/Plugin.hpp>
+#include <Poco/TemporaryFile.h>
+#include <Poco/File.h>
+#include <atomic>
+#include <fstream>
 #include <iostream>
 #include <json.hpp>
 
@@ -24,3 +30,76 @@ POTHOS_TEST_BLOCK("/util/tests", test_doc_utils_dump_json)
     }
     json::parse(jsonStr); //should not throw
 }
+
+static void writeDocSource(const std::string &path, const std::string &title)
+{
+    std::ofstream os(path);
+    os << "// |PothosDoc " << title << std::endl;
+    os << "// |factory /tests/doc_cache_test()" << std::endl;
+    os << "struct DocCacheTest{};" << std::endl;
+}
+
+POTHOS_TEST_BLOCK("/util/tests", test_block_description_cache)
+{
+    const auto path = Poco::TemporaryFile::tempName() + ".cpp";
+    writeDocSource(path, "Doc Cache Test");
+
+    //the first parse fills the cache and the second one reads it
+    std::string firstJSON;
+    for (size_t pass = 0; pass < 2; pass++)
+    {
+        Pothos::Util::BlockDescriptionParser parser;
+        parser.feedFilePath(path);
+        POTHOS_TEST_EQUAL(parser.listFactories().size(), 1);
+        POTHOS_TEST_EQUAL(parser.listFactories()[0], "/tests/doc_cache_test");
+        const auto obj = json::parse(parser.getJSONObject("/tests/doc_cache_test"));
+        POTHOS_TEST_EQUAL(obj.value("name", ""), "Doc Cache Test");
+        if (pass == 0) firstJSON = parser.getJSONArray();
+        else POTHOS_TEST_EQUAL(parser.getJSONArray(), firstJSON);
+    }
+
+    //changed contents are parsed again
+    writeDocSource(path, "Doc Cache Changed");
+    Pothos::Util::BlockDescriptionParser parser;
+    parser.feedFilePath(path);
+    const auto obj = json::parse(parser.getJSONObject("/tests/doc_cache_test"));
+    POTHOS_TEST_EQUAL(obj.value("name", ""), "Doc Cache Changed");
+
+    Poco::File(path).remove();
+}
+
+static std::atomic<int> deviceInfoCalls(0);
+
+static std::string deviceInfoCounter(void)
+{
+    json info;
+    info["name"] = "Device Info Cache Test";
+    info["calls"] = ++deviceInfoCalls;
+    return info.dump();
+}
+
+POTHOS_TEST_BLOCK("/util/tests", test_device_info_cache)
+{
+    const Pothos::PluginPath path("/devices/tests_device_info_cache/info");
+    Pothos::PluginRegistry::addCall(path, &deviceInfoCounter);
+    auto env = Pothos::ProxyEnvironment::make("managed");
+    auto proxy = env->findProxy("Pothos/Util/DeviceInfoUtils");
+
+    auto findCalls = [](const std::string &jsonStr)
+    {
+        for (const auto &info : json::parse(jsonStr))
+        {
+            if (info.value("name", "") == "Device Info Cache Test") return info["calls"].get<int>();
+        }
+        return 0;
+    };
+
+    //the second dump is served from the cache
+    const int first = findCalls(proxy.call<std::string>("dumpJson"));
+    POTHOS_TEST_TRUE(first != 0);
+    POTHOS_TEST_EQUAL(findCalls(proxy.call<std::string>("dumpJson")), first);
+
+    //the refresh flag probes the plugin again
+    POTHOS_TEST_EQUAL(findCalls(proxy.call<std::string>("dumpJson", true)), first+1);
+    Pothos::PluginRegistry::remove(path);
+}
@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
@@ -7,8 +7,12 @@
 #include <Pothos/Framework.hpp>
 #include <Pothos/Exception.hpp>
 #include <Pothos/Object/Containers.hpp>
+#include <Pothos/Util/EvalEnvironment.hpp>
 #include <complex>
 #include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 POTHOS_TEST_BLOCK("/util/tests", test_eval_expression)
 {
@@ -204,6 +208,89 @@ POTHOS_TEST_BLOCK("/util/tests", test_eval_with_constants)
     }
 }
 
+POTHOS_TEST_BLOCK("/util/tests", test_eval_cached_results)
+{
+    auto env = Pothos::ProxyEnvironment::make("managed");
+    auto evalEnv = env->findProxy("Pothos/Util/EvalEnvironment")();
+
+    //repeated evaluations of the same expression
+    evalEnv.call<Pothos::Object>("registerConstantExpr", "x", "10");
+    for (size_t i = 0; i < 3; i++)
+    {
+        const auto result = evalEnv.call<Pothos::Object>("eval", "x*2 + 1");
+        POTHOS_TEST_EQUAL(int(result), 21);
+    }
+
+    //changing a constant invalidates the cached results
+    evalEnv.call<Pothos::Object>("registerConstantExpr", "x", "20");
+    POTHOS_TEST_EQUAL(int(evalEnv.call<Pothos::Object>("eval", "x*2 + 1")), 41);
+    evalEnv.call<Pothos::Object>("registerConstantObj", "x", Pothos::Object(30));
+    POTHOS_TEST_EQUAL(int(evalEnv.call<Pothos::Object>("eval", "x*2 + 1")), 61);
+    evalEnv.call<Pothos::Object>("unregisterConstant", "x");
+    POTHOS_TEST_THROWS(evalEnv.call<Pothos::Object>("eval", "x*2 + 1"), Pothos::Exception);
+
+    //separate environments do not share constants
+    auto otherEnv = env->findProxy("Pothos/Util/EvalEnvironment")();
+    otherEnv.call<Pothos::Object>("registerConstantExpr", "x", "1");
+    POTHOS_TEST_EQUAL(int(otherEnv.call<Pothos::Object>("eval", "x*2 + 1")), 3);
+    POTHOS_TEST_THROWS(evalEnv.call<Pothos::Object>("eval", "x*2 + 1"), Pothos::Exception);
+}
+
+POTHOS_TEST_BLOCK("/util/tests", test_eval_concurrent)
+{
+    auto evalEnv = Pothos::Util::EvalEnvironment::make();
+    evalEnv->registerConstantExpr("x", "10");
+
+    //concurrent evaluations with the shared constants
+    std::atomic<size_t> failures(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) threads.emplace_back([&evalEnv, &failures, t](void)
+    {
+        for (int i = 0; i < 100; i++)
+        {
+            const auto expr = "x*"+std::to_string(i)+" + "+std::to_string(t);
+            if (evalEnv->eval(expr).convert<int>() != 10*i + t) failures++;
+            const std::vector<int> vec = evalEnv->eval("[x, "+std::to_string(i)+"]");
+            if (vec.size() != 2 or vec[0] != 10 or vec[1] != i) failures++;
+        }
+    });
+    for (auto &thread : threads) thread.join();
+    POTHOS_TEST_EQUAL(failures.load(), 0);
+
+    //a change to the constants is seen by the parsers of other threads
+    evalEnv->registerConstantExpr("x", "20");
+    std::thread([&evalEnv, &failures](void)
+    {
+        if (evalEnv->eval("x + 1").convert<int>() != 21) failures++;
+    }).join();
+    POTHOS_TEST_EQUAL(failures.load(), 0);
+    POTHOS_TEST_EQUAL(evalEnv->eval("x + 1").convert<int>(), 21);
+}
+
+POTHOS_TEST_BLOCK("/util/tests", test_eval_constant_dependencies)
+{
+    Pothos::Util::EvalEnvironment evalEnv;
+    evalEnv.registerConstantExpr("x", "1");
+    evalEnv.registerConstantObj("y", Pothos::Object(2));
+    evalEnv.registerConstantExpr("z", "x + y*x");
+
+    //only registered names outside of string literals
+    const auto refs = evalEnv.getReferencedConstants("z + foo + \"x\" + y");
+    POTHOS_TEST_EQUAL(refs.size(), 2);
+    POTHOS_TEST_EQUAL(refs[0], "z");
+    POTHOS_TEST_EQUAL(refs[1], "y");
+
+    //dependencies recorded by registerConstantExpr
+    const auto deps = evalEnv.getConstantDependencies("z");
+    POTHOS_TEST_EQUAL(deps.size(), 2);
+    POTHOS_TEST_EQUAL(deps[0], "x");
+    POTHOS_TEST_EQUAL(deps[1], "y");
+    POTHOS_TEST_TRUE(evalEnv.getConstantDependencies("y").empty());
+
+    evalEnv.unregisterConstant("x");
+    POTHOS_TEST_TRUE(evalEnv.getReferencedConstants("x").empty());
+}
+
 POTHOS_TEST_BLOCK("/util/tests", test_eval_constant_obj)
 {
     auto env = Pothos::ProxyEnvironment::make("managed");
@@ -0,0 +1,44 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Util/LatencyHistogram.hpp>
+#include <memory>
+#include <initializer_list>
+
+POTHOS_TEST_BLOCK("/util/tests", test_latency_histogram)
+{
+    std::unique_ptr<Pothos::Util::LatencyHistogram> hist(new Pothos::Util::LatencyHistogram());
+    POTHOS_TEST_EQUAL(hist->count(), 0);
+    POTHOS_TEST_EQUAL(hist->percentile(50.0), 0);
+
+    //every bucket lower bound maps back to its own bucket
+    for (size_t i = 0; i < Pothos::Util::LatencyHistogram::NUM_BUCKETS; i++)
+    {
+        const auto lower = Pothos::Util::LatencyHistogram::bucketLowerBound(i);
+        POTHOS_TEST_EQUAL(Pothos::Util::LatencyHistogram::bucketIndex(lower), i);
+    }
+
+    //huge values are clamped into the last bucket
+    POTHOS_TEST_EQUAL(Pothos::Util::LatencyHistogram::bucketIndex(~0ull),
+        Pothos::Util::LatencyHistogram::NUM_BUCKETS-1);
+
+    //record 1 through 10000 and check the percentiles within the bucket error
+    for (unsigned long long i = 1; i <= 10000; i++) hist->record(i);
+    POTHOS_TEST_EQUAL(hist->count(), 10000);
+    POTHOS_TEST_EQUAL(hist->sum(), 10000ull*10001/2);
+    POTHOS_TEST_EQUAL(hist->min(), 1);
+    POTHOS_TEST_EQUAL(hist->max(), 10000);
+    for (const double p : {50.0, 90.0, 99.0, 99.9})
+    {
+        const auto expected = (unsigned long long)(p*100);
+        const auto actual = hist->percentile(p);
+        POTHOS_TEST_TRUE(actual <= expected);
+        POTHOS_TEST_TRUE(actual >= expected - expected/16);
+    }
+    POTHOS_TEST_EQUAL(hist->percentile(100.0), 9728); //lower bound of the bucket for 10000
+
+    hist->reset();
+    POTHOS_TEST_EQUAL(hist->count(), 0);
+    POTHOS_TEST_EQUAL(hist->min(), 0);
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Util/MonotonicArena.hpp>
+#include <cstdint>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/util/tests", test_monotonic_arena)
+{
+    Pothos::Util::MonotonicArena arena(256);
+    POTHOS_TEST_EQUAL(arena.capacity(), 0);
+
+    //aligned allocations from the first chunk
+    auto p0 = arena.allocate(3, 1);
+    auto p1 = arena.allocate(8, 8);
+    POTHOS_TEST_TRUE(p0 != nullptr);
+    POTHOS_TEST_EQUAL(reinterpret_cast<std::uintptr_t>(p1) % 8, 0);
+    POTHOS_TEST_EQUAL(arena.numChunks(), 1);
+    POTHOS_TEST_EQUAL(arena.used(), 11);
+
+    //overflow into more chunks, then coalesce upon reset
+    for (size_t i = 0; i < 10; i++) arena.allocate(100);
+    POTHOS_TEST_TRUE(arena.numChunks() > 1);
+    const size_t capacity = arena.capacity();
+    arena.reset();
+    POTHOS_TEST_EQUAL(arena.numChunks(), 1);
+    POTHOS_TEST_EQUAL(arena.capacity(), capacity);
+    POTHOS_TEST_EQUAL(arena.used(), 0);
+
+    //the same cycle fits into the coalesced chunk
+    arena.allocate(3, 1);
+    arena.allocate(8, 8);
+    for (size_t i = 0; i < 10; i++) arena.allocate(100);
+    POTHOS_TEST_EQUAL(arena.numChunks(), 1);
+    arena.reset();
+
+    //standard containers with the arena allocator
+    Pothos::Util::ArenaAllocator<int> allocator(arena);
+    std::vector<int, Pothos::Util::ArenaAllocator<int>> values(allocator);
+    for (int i = 0; i < 1000; i++) values.push_back(i);
+    for (int i = 0; i < 1000; i++) POTHOS_TEST_EQUAL(values[i], i);
+    POTHOS_TEST_TRUE(arena.used() >= 1000*sizeof(int));
+}
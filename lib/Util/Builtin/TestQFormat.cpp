@@ -0,0 +1,65 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Util/QFormat.hpp>
+#include <complex>
+#include <limits>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/util/tests", test_qformat_bulk)
+{
+    //odd length to exercise the vector body and the scalar tail
+    const size_t num = 37;
+    std::vector<float> in(num);
+    for (size_t i = 0; i < num; i++) in[i] = (float(i)-18.0f)/16.0f + 0.01f;
+
+    std::vector<int16_t> q16(num);
+    Pothos::Util::floatToQ(in.data(), q16.data(), num, 8);
+    std::vector<float> out(num);
+    Pothos::Util::fromQ(q16.data(), out.data(), num, 8);
+    for (size_t i = 0; i < num; i++)
+    {
+        POTHOS_TEST_EQUAL(q16[i], int16_t(std::nearbyint(in[i]*256.0f)));
+        POTHOS_TEST_CLOSE(out[i], in[i], 1.0f/256);
+    }
+
+    //round to nearest with ties to even
+    const float ties[8] = {0.5f, 1.5f, 2.5f, -0.5f, -1.5f, -2.5f, 0.49f, -0.51f};
+    const int16_t tiesOut[8] = {0, 2, 2, 0, -2, -2, 0, -1};
+    int16_t rounded[8];
+    Pothos::Util::floatToQ(ties, rounded, 8, 0);
+    for (size_t i = 0; i < 8; i++) POTHOS_TEST_EQUAL(rounded[i], tiesOut[i]);
+
+    //saturation and NaN to zero
+    const float extremes[8] = {1e9f, -1e9f, std::numeric_limits<float>::quiet_NaN(), 1.0f, 1e9f, -1e9f, 0.0f, -1.0f};
+    int16_t sat16[8];
+    int32_t sat32[8];
+    Pothos::Util::floatToQ(extremes, sat16, 8, 15);
+    Pothos::Util::floatToQ(extremes, sat32, 8, 31);
+    POTHOS_TEST_EQUAL(sat16[0], 32767);
+    POTHOS_TEST_EQUAL(sat16[1], -32768);
+    POTHOS_TEST_EQUAL(sat16[2], 0);
+    POTHOS_TEST_EQUAL(sat16[3], 32767);
+    POTHOS_TEST_EQUAL(sat16[7], -32768);
+    POTHOS_TEST_EQUAL(sat32[0], std::numeric_limits<int32_t>::max());
+    POTHOS_TEST_EQUAL(sat32[1], std::numeric_limits<int32_t>::min());
+    POTHOS_TEST_EQUAL(sat32[2], 0);
+    POTHOS_TEST_EQUAL(sat32[3], std::numeric_limits<int32_t>::max());
+    POTHOS_TEST_EQUAL(sat32[7], std::numeric_limits<int32_t>::min());
+
+    //complex variants convert each component
+    std::vector<std::complex<float>> cin(num);
+    for (size_t i = 0; i < num; i++) cin[i] = std::complex<float>(in[i], -in[i]);
+    std::vector<std::complex<int32_t>> cq32(num);
+    std::vector<std::complex<float>> cout(num);
+    Pothos::Util::floatToQ(cin.data(), cq32.data(), num, 16);
+    Pothos::Util::fromQ(cq32.data(), cout.data(), num, 16);
+    for (size_t i = 0; i < num; i++)
+    {
+        POTHOS_TEST_EQUAL(cq32[i].real(), int32_t(std::nearbyint(in[i]*65536.0f)));
+        POTHOS_TEST_EQUAL(cq32[i].imag(), int32_t(std::nearbyint(-in[i]*65536.0f)));
+        POTHOS_TEST_CLOSE(cout[i].real(), cin[i].real(), 1.0f/65536);
+        POTHOS_TEST_CLOSE(cout[i].imag(), cin[i].imag(), 1.0f/65536);
+    }
+}
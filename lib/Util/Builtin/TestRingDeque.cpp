@@ -1,4 +1,4 @@
-// Copyright (c) 2017-2017 Josh Blum
+// Copyright (c) 2017-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
@@ -141,3 +141,41 @@ POTHOS_TEST_BLOCK("/util/tests", test_ring_deque_copy)
         POTHOS_TEST_EQUAL(ring0[i], ring4[i]);
     }
 }
+
+POTHOS_TEST_BLOCK("/util/tests", test_ring_deque_bulk)
+{
+    //offset the front so the bulk push wraps around the storage
+    Pothos::Util::RingDeque<int> ring(8);
+    for (int i = 0; i < 5; i++) ring.push_back(-1);
+    ring.pop_front_n(5);
+    POTHOS_TEST_TRUE(ring.empty());
+
+    const int elems[6] = {0, 1, 2, 3, 4, 5};
+    ring.push_back_range(elems, 6);
+    POTHOS_TEST_EQUAL(ring.size(), 6);
+    for (int i = 0; i < 6; i++) POTHOS_TEST_EQUAL(ring[i], i);
+
+    //the spans hold every element in order
+    const auto front = ring.front_span();
+    const auto back = ring.back_span();
+    POTHOS_TEST_EQUAL(front.size, 3);
+    POTHOS_TEST_EQUAL(back.size, 3);
+    int expected = 0;
+    for (const auto &span : {front, back})
+    {
+        for (const auto &elem : span) POTHOS_TEST_EQUAL(elem, expected++);
+    }
+
+    ring.pop_front_n(4);
+    POTHOS_TEST_EQUAL(ring.front(), 4);
+    POTHOS_TEST_EQUAL(ring.front_span().size, 2);
+    POTHOS_TEST_EQUAL(ring.back_span().size, 0);
+
+    //non-trivial types take the element-wise path
+    Pothos::Util::RingDeque<std::string> strings(4);
+    const std::string strElems[3] = {"a", "b", "c"};
+    strings.push_back_range(strElems, 3);
+    strings.pop_front_n(2);
+    POTHOS_TEST_EQUAL(strings.size(), 1);
+    POTHOS_TEST_EQUAL(strings.front(), "c");
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Util/SPSCQueue.hpp>
+#include <string>
+#include <thread>
+
+POTHOS_TEST_BLOCK("/util/tests", test_spsc_queue)
+{
+    Pothos::Util::SPSCQueue<std::string> queue(10);
+    POTHOS_TEST_EQUAL(queue.capacity(), 16);
+    POTHOS_TEST_TRUE(queue.empty());
+
+    //fill with elements until full
+    for (size_t i = 0; i < 16; i++)
+    {
+        POTHOS_TEST_TRUE(queue.push(std::to_string(i)));
+        POTHOS_TEST_FALSE(queue.empty());
+    }
+    POTHOS_TEST_FALSE(queue.push(std::string("full")));
+
+    //pop in order
+    std::string elem;
+    for (size_t i = 0; i < 16; i++)
+    {
+        POTHOS_TEST_TRUE(queue.pop(elem));
+        POTHOS_TEST_EQUAL(elem, std::to_string(i));
+    }
+    POTHOS_TEST_TRUE(queue.empty());
+    POTHOS_TEST_FALSE(queue.pop(elem));
+
+    //concurrent producer and consumer
+    const size_t numElems = 10000;
+    Pothos::Util::SPSCQueue<size_t> ints(8);
+    std::thread producer([&ints, numElems]{
+        for (size_t i = 0; i < numElems;)
+        {
+            if (ints.push(i)) i++;
+            else std::this_thread::yield();
+        }
+    });
+    size_t next = 0;
+    bool inOrder = true;
+    while (next < numElems)
+    {
+        size_t val = 0;
+        if (not ints.pop(val))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if (val != next) inOrder = false;
+        next++;
+    }
+    producer.join();
+    POTHOS_TEST_TRUE(inOrder);
+    POTHOS_TEST_TRUE(ints.empty());
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Util/SpinLock.hpp>
+#include <Pothos/Util/SpinLockRW.hpp>
+#include <algorithm> //max
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/util/tests", test_spin_lock)
+{
+    Pothos::Util::SpinLock lock;
+    POTHOS_TEST_TRUE(lock.try_lock());
+    POTHOS_TEST_FALSE(lock.try_lock());
+    lock.unlock();
+    POTHOS_TEST_TRUE(lock.try_lock());
+    lock.unlock();
+
+    //more threads than cores to exercise the yield path
+    const size_t numThreads = 4*std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const size_t numIters = 10000;
+    size_t counter(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < numThreads; i++)
+    {
+        threads.emplace_back([&lock, &counter, numIters]{
+            for (size_t j = 0; j < numIters; j++)
+            {
+                std::lock_guard<Pothos::Util::SpinLock> lg(lock);
+                counter++;
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    POTHOS_TEST_EQUAL(counter, numThreads*numIters);
+}
+
+POTHOS_TEST_BLOCK("/util/tests", test_spin_lock_rw)
+{
+    Pothos::Util::SpinLockRW lock;
+
+    //shared locks are reentrant and exclude the writer
+    lock.lock_shared();
+    POTHOS_TEST_TRUE(lock.try_lock_shared());
+    POTHOS_TEST_FALSE(lock.try_lock());
+    lock.unlock_shared();
+    lock.unlock_shared();
+    POTHOS_TEST_TRUE(lock.try_lock());
+    POTHOS_TEST_FALSE(lock.try_lock_shared());
+    lock.unlock();
+
+    //writers make progress under a continuous load of readers
+    const size_t numReaders = 2*std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const size_t numWrites = 1000;
+    std::atomic<bool> done(false);
+    size_t value(0);
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < numReaders; i++)
+    {
+        readers.emplace_back([&lock, &done, &value]{
+            while (not done)
+            {
+                Pothos::Util::SpinLockRW::SharedLock lg(lock);
+                Pothos::Util::SpinLockRW::SharedLock nested(lock);
+                volatile size_t v = value; (void)v;
+            }
+        });
+    }
+    for (size_t i = 0; i < numWrites; i++)
+    {
+        std::lock_guard<Pothos::Util::SpinLockRW> lg(lock);
+        value++;
+    }
+    done = true;
+    for (auto &t : readers) t.join();
+    POTHOS_TEST_EQUAL(value, numWrites);
+}
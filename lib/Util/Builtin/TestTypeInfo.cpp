@@ -0,0 +1,21 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Util/TypeInfo.hpp>
+#include <string>
+#include <vector>
+
+POTHOS_TEST_BLOCK("/util/tests", test_type_info_to_string)
+{
+    POTHOS_TEST_EQUAL(Pothos::Util::typeInfoToString(typeid(std::string)), "std::string");
+    POTHOS_TEST_EQUAL(Pothos::Util::typeInfoToString(typeid(int)), "int");
+
+    //repeated lookups return the memoized name
+    const auto name = Pothos::Util::typeInfoToString(typeid(std::vector<double>));
+    POTHOS_TEST_TRUE(name.find("vector") != std::string::npos);
+    for (size_t i = 0; i < 100; i++)
+    {
+        POTHOS_TEST_EQUAL(Pothos::Util::typeInfoToString(typeid(std::vector<double>)), name);
+    }
+}
@@ -0,0 +1,25 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Util/UID.hpp>
+#include <string>
+#include <set>
+
+POTHOS_TEST_BLOCK("/util/tests", test_uid)
+{
+    const Pothos::Util::UID first;
+    POTHOS_TEST_EQUAL(first.uid().find("pothos://"), 0);
+
+    //every uid shares the process prefix and is unique
+    const auto prefix = first.uid().substr(0, first.uid().find_last_of('/')+1);
+    std::set<std::string> uids;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        const Pothos::Util::UID uid;
+        POTHOS_TEST_EQUAL(uid.uid().substr(0, prefix.size()), prefix);
+        uids.insert(uid.uid());
+    }
+    POTHOS_TEST_EQUAL(uids.size(), 1000);
+    POTHOS_TEST_TRUE(uids.count(first.uid()) == 0);
+}
@@ -0,0 +1,228 @@
+// Copyright (c) 2014-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Util/Builtin/UnixCompilerSupport.hpp"
+#include <Pothos/System.hpp>
+#include <Pothos/Util/FileLock.hpp>
+#include <Poco/Logger.h>
+#include <Poco/Pipe.h>
+#include <Poco/PipeStream.h>
+#include <Poco/Path.h>
+#include <Poco/File.h>
+#include <Poco/SharedLibrary.h>
+#include <Poco/NumberFormatter.h>
+#include <functional> //hash
+#include <algorithm> //min/max
+#include <iterator>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <mutex>
+
+UnixCompilerSupport::UnixCompilerSupport(
+    const std::string &name,
+    const std::string &executable,
+    const std::vector<std::string> &baseFlags,
+    const std::string &pchSuffix):
+    _name(name),
+    _executable(executable),
+    _baseFlags(baseFlags),
+    _pchSuffix(pchSuffix)
+{
+    return;
+}
+
+bool UnixCompilerSupport::test(void)
+{
+    Poco::Process::Args args;
+    args.push_back("--version");
+    Poco::Process::Env env;
+    Poco::Pipe outPipe;
+    Poco::ProcessHandle ph(Poco::Process::launch(
+        _executable, args, nullptr, &outPipe, &outPipe, env));
+
+    //the version identifies the cached precompiled headers of this compiler
+    Poco::PipeInputStream os(outPipe);
+    _version = std::string(std::istreambuf_iterator<char>(os), std::istreambuf_iterator<char>());
+    return ph.wait() == 0;
+}
+
+void UnixCompilerSupport::runCompiler(const Poco::Process::Args &args)
+{
+    //launch
+    Poco::Pipe inPipe, outPipe;
+    Poco::Process::Env env;
+    Poco::ProcessHandle ph(Poco::Process::launch(
+        _executable, args, &inPipe, &outPipe, &outPipe, env));
+
+    //read the output while the compiler runs, so a full pipe cannot block it
+    Poco::PipeInputStream errStream(outPipe);
+    const std::string errMsgBuff = std::string(
+        std::istreambuf_iterator<char>(errStream),
+        std::istreambuf_iterator<char>());
+
+    //handle error case
+    if (ph.wait() != 0)
+    {
+        throw Pothos::Exception(_name+"::compileCppModule", errMsgBuff);
+    }
+}
+
+std::string UnixCompilerSupport::precompileHeaders(const Poco::Process::Args &compileArgs, const Pothos::Util::CompilerArgs &args)
+{
+    if (args.precompiledHeaders.empty()) return "";
+    if (_version.empty()) this->test();
+
+    //the header is only valid for the exact compiler, install, and flags
+    std::string inputs(POTHOS_ABI_VERSION);
+    inputs += "\n" + Pothos::System::getLibVersion();
+    inputs += "\n" + Pothos::System::getPothosDevIncludePath();
+    inputs += "\n" + _executable + "\n" + _version;
+    for (const auto &arg : compileArgs) inputs += "\narg:" + arg;
+    for (const auto &header : args.precompiledHeaders) inputs += "\nheader:" + header;
+    const auto hash = Poco::NumberFormatter::formatHex(std::hash<std::string>()(inputs), 16);
+
+    Poco::Path pchDir(Pothos::System::getUserDataPath());
+    pchDir.append("pch");
+    pchDir.append(hash);
+    pchDir.makeDirectory();
+    Poco::File(pchDir).createDirectories();
+    const auto headerPath = Poco::Path(pchDir, "pch.hpp").toString();
+    const auto pchPath = headerPath + _pchSuffix;
+
+    //file lock for atomicity across processes
+    Pothos::Util::FileLock pchFileLock(Poco::Path(pchDir, "pch.lock").toString());
+    std::lock_guard<Pothos::Util::FileLock> fileLock(pchFileLock);
+    Poco::File pchFile(pchPath);
+    if (pchFile.exists() and pchFile.getSize() != 0) return headerPath;
+
+    //the wrapper header includes each header in order
+    {
+        std::ofstream header(headerPath);
+        header << "#pragma once" << std::endl;
+        for (const auto &include : args.precompiledHeaders)
+        {
+            header << "#include <" << include << ">" << std::endl;
+        }
+    }
+
+    //the wrapper is included without a precompiled header when the build fails
+    Poco::Process::Args pchArgs(compileArgs);
+    pchArgs.push_back("-x");
+    pchArgs.push_back("c++-header");
+    pchArgs.push_back(headerPath);
+    pchArgs.push_back("-o");
+    pchArgs.push_back(pchPath + ".tmp");
+    try
+    {
+        Poco::Logger::get("Pothos.Compiler").information("Precompile headers %s...", pchDir.toString());
+        this->runCompiler(pchArgs);
+        Poco::File(pchPath + ".tmp").moveTo(pchPath);
+    }
+    catch (const Pothos::Exception &ex)
+    {
+        Poco::Logger::get("Pothos.Compiler").warning("Precompiled headers failed: %s", ex.message());
+    }
+    return headerPath;
+}
+
+std::string UnixCompilerSupport::compileCppModule(const Pothos::Util::CompilerArgs &compilerArgs)
+{
+    //create the compile args
+    Poco::Process::Args compileArgs;
+    compileArgs.push_back("-std=c++11");
+    for (const auto &flag : _baseFlags)
+    {
+        compileArgs.push_back(flag);
+    }
+    compileArgs.push_back("-fPIC");
+    for (const auto &flag : compilerArgs.flags)
+    {
+        compileArgs.push_back(flag);
+    }
+
+    //add include paths
+    for (const auto &include : compilerArgs.includes)
+    {
+        compileArgs.push_back("-I");
+        compileArgs.push_back(include);
+    }
+
+    //the precompiled headers are included ahead of every source
+    Poco::Process::Args sourceArgs(compileArgs);
+    const auto pchHeader = this->precompileHeaders(compileArgs, compilerArgs);
+    if (not pchHeader.empty())
+    {
+        sourceArgs.push_back("-include");
+        sourceArgs.push_back(pchHeader);
+    }
+
+    //create temp out file
+    const auto outPath = this->createTempFile(Poco::SharedLibrary::suffix());
+
+    //compile and link a single source in one step
+    if (compilerArgs.sources.size() <= 1)
+    {
+        Poco::Process::Args args(sourceArgs);
+        args.push_back("-shared");
+        args.push_back("-x");
+        args.push_back("c++");
+        for (const auto &source : compilerArgs.sources)
+        {
+            args.push_back(source);
+        }
+        args.push_back("-x");
+        args.push_back("none");
+        for (const auto &library : compilerArgs.libraries)
+        {
+            args.push_back(library);
+        }
+        args.push_back("-o");
+        args.push_back(outPath);
+        this->runCompiler(args);
+        return outPath;
+    }
+
+    //compile each source into an object, in parallel
+    std::vector<std::string> objects;
+    for (size_t i = 0; i < compilerArgs.sources.size(); i++)
+    {
+        objects.push_back(this->createTempFile(".o"));
+    }
+    const size_t numJobs = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    for (size_t first = 0; first < compilerArgs.sources.size(); first += numJobs)
+    {
+        std::vector<std::future<void>> jobs;
+        const size_t last = std::min(first+numJobs, compilerArgs.sources.size());
+        for (size_t i = first; i < last; i++)
+        {
+            Poco::Process::Args args(sourceArgs);
+            args.push_back("-c");
+            args.push_back("-x");
+            args.push_back("c++");
+            args.push_back(compilerArgs.sources[i]);
+            args.push_back("-o");
+            args.push_back(objects[i]);
+            jobs.push_back(std::async(std::launch::async, &UnixCompilerSupport::runCompiler, this, args));
+        }
+        //wait on all jobs before reporting the first failure
+        for (auto &job : jobs) job.wait();
+        for (auto &job : jobs) job.get();
+    }
+
+    //link the objects into the module
+    Poco::Process::Args args(compileArgs);
+    args.push_back("-shared");
+    for (const auto &object : objects)
+    {
+        args.push_back(object);
+    }
+    for (const auto &library : compilerArgs.libraries)
+    {
+        args.push_back(library);
+    }
+    args.push_back("-o");
+    args.push_back(outPath);
+    this->runCompiler(args);
+    return outPath;
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2014-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Util/Compiler.hpp>
+#include <Poco/Process.h>
+#include <string>
+#include <vector>
+
+/***********************************************************************
+ * Common support for gcc-like compilers:
+ * Precompiled headers are built once per set of compiler inputs,
+ * and cached in the user data directory across processes.
+ * Multiple sources are compiled to objects in parallel, then linked.
+ **********************************************************************/
+class UnixCompilerSupport : public Pothos::Util::Compiler
+{
+public:
+
+    /*!
+     * Create a compiler wrapper.
+     * \param name the name used in error messages
+     * \param executable the compiler executable
+     * \param baseFlags flags used for both compiling and linking
+     * \param pchSuffix the suffix of the precompiled header beside the header
+     */
+    UnixCompilerSupport(
+        const std::string &name,
+        const std::string &executable,
+        const std::vector<std::string> &baseFlags,
+        const std::string &pchSuffix);
+
+    bool test(void);
+
+    std::string compileCppModule(const Pothos::Util::CompilerArgs &args);
+
+private:
+    //! Launch the compiler and throw with its output on failure
+    void runCompiler(const Poco::Process::Args &args);
+
+    //! Get the wrapper header of the precompiled headers to include, empty without headers
+    std::string precompileHeaders(const Poco::Process::Args &compileArgs, const Pothos::Util::CompilerArgs &args);
+
+    const std::string _name;
+    const std::string _executable;
+    const std::vector<std::string> _baseFlags;
+    const std::string _pchSuffix;
+    std::string _version;
+};
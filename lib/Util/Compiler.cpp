@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Util/Compiler.hpp>
@@ -39,6 +39,10 @@ Pothos::Util::CompilerArgs Pothos::Util::CompilerArgs::defaultDevEnv(void)
     //add devel environment includes
     args.includes.push_back(Pothos::System::getPothosDevIncludePath());
 
+    //the headers that take most of the parse time of a block
+    args.precompiledHeaders.push_back("Pothos/Framework.hpp");
+    args.precompiledHeaders.push_back("Pothos/Proxy.hpp");
+
     return args;
 }
 
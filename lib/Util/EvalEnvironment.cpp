@@ -1,4 +1,4 @@
-// Copyright (c) 2014-2017 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 //                    2020 Nicholas Corgan
 // SPDX-License-Identifier: BSL-1.0
 
@@ -17,10 +17,14 @@
 #include <Pothos/Object/Containers.hpp>
 #include <Pothos/Proxy.hpp>
 #include <Poco/String.h>
+#include <cctype>
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <iostream>
+#include <memory>
 #include <mutex>
 
 static const std::string mapTypeId("__map__");
@@ -123,11 +127,11 @@ static mup::Value objectToMupValue(const Pothos::Object &obj)
 }
 
 /***********************************************************************
- * Evaluator implementation
+ * Prototype parser with the packages already added
  **********************************************************************/
-struct Pothos::Util::EvalEnvironment::Impl
+struct MupPrototypeParser
 {
-    Impl(void):
+    MupPrototypeParser(void):
         p(0)
     {
         // Note: the parser object takes ownership of this pointer and will
@@ -148,62 +152,271 @@ struct Pothos::Util::EvalEnvironment::Impl
         p.DefineConst("False", false);
         p.DefineConst("j", std::complex<double>(0.0, 1.0));
     }
-    std::mutex parserMutex;
+    std::mutex mutex;
     mup::ParserX p;
 };
 
-std::shared_ptr<Pothos::Util::EvalEnvironment> Pothos::Util::EvalEnvironment::make(void)
+static MupPrototypeParser &getPrototypeParser(void)
 {
-    return std::shared_ptr<EvalEnvironment>(new EvalEnvironment());
+    static MupPrototypeParser prototype;
+    return prototype;
 }
 
-Pothos::Util::EvalEnvironment::EvalEnvironment(void):
-    _impl(new Impl())
+//! The copies share the reference counted callbacks of the prototype,
+//! the counts are not atomic, so parsers are copied and deleted under its mutex
+struct MupParserDeleter
 {
-    return;
+    void operator()(mup::ParserX *p) const
+    {
+        std::lock_guard<std::mutex> lock(getPrototypeParser().mutex);
+        delete p;
+    }
+};
+
+typedef std::unique_ptr<mup::ParserX, MupParserDeleter> MupParserPtr;
+
+//! Copy the prototype, much cheaper than adding the packages again
+static MupParserPtr copyPrototypeParser(void)
+{
+    auto &prototype = getPrototypeParser();
+    std::lock_guard<std::mutex> lock(prototype.mutex);
+    return MupParserPtr(new mup::ParserX(prototype.p));
 }
 
-void Pothos::Util::EvalEnvironment::registerConstantExpr(const std::string &key, const std::string &expr)
+/***********************************************************************
+ * Evaluator implementation:
+ * The constants are shared and protected by the mutex,
+ * and each thread evaluates with its own parser for this environment.
+ * A thread's parser catches up with the changes to the constants
+ * upon its next evaluation, so evaluations run concurrently.
+ **********************************************************************/
+struct Pothos::Util::EvalEnvironment::Impl :
+    std::enable_shared_from_this<Pothos::Util::EvalEnvironment::Impl>
 {
-    try
+    Impl(void):
+        serial(1)
     {
-        const auto result = objectToMupValue(this->eval(expr));
-        this->unregisterConstant(key);
-        _impl->p.DefineConst(key, result);
+        return;
     }
-    catch (const mup::ParserError &ex)
+
+    struct Constant
     {
-        throw Pothos::Exception("EvalEnvironment::eval("+expr+")", ex.GetMsg());
+        mup::Value value;
+        unsigned long long serial; //the environment serial upon definition
+        std::vector<std::string> deps;
+    };
+
+    struct ThreadParser
+    {
+        ThreadParser(void): serial(0){}
+        std::weak_ptr<Impl> owner;
+        unsigned long long serial; //the environment serial of the last sync
+        std::map<std::string, unsigned long long> defined; //constant names to serials
+        MupParserPtr p;
+    };
+
+    //get the calling thread's parser, synchronized with the constants
+    ThreadParser &getThreadParser(void);
+
+    //change the constants and invalidate the results, call with the mutex held
+    void changed(void)
+    {
+        serial++;
+        resultCache.clear();
     }
+
+    std::mutex mutex;
+    unsigned long long serial; //changes with every change to the constants
+
+    //evaluated results of parser expressions,
+    //cleared when constants change, protected by the mutex
+    std::unordered_map<std::string, Pothos::Object> resultCache;
+
+    //registered constant names to their values and dependencies
+    std::map<std::string, Constant> constants;
+};
+
+Pothos::Util::EvalEnvironment::Impl::ThreadParser &Pothos::Util::EvalEnvironment::Impl::getThreadParser(void)
+{
+    //parsers of this thread for each environment, the destroyed environments are dropped
+    static thread_local std::vector<ThreadParser> parsers;
+    for (auto it = parsers.begin(); it != parsers.end();)
+    {
+        if (it->owner.expired()) it = parsers.erase(it);
+        else ++it;
+    }
+
+    ThreadParser *tp(nullptr);
+    for (auto &parser : parsers)
+    {
+        if (parser.owner.lock().get() == this) tp = &parser;
+    }
+    if (tp == nullptr)
+    {
+        parsers.emplace_back();
+        tp = &parsers.back();
+        tp->owner = this->shared_from_this();
+        tp->p = copyPrototypeParser();
+    }
+
+    //catch up with the changed constants since the last sync
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tp->serial == serial) return *tp;
+    for (auto it = tp->defined.begin(); it != tp->defined.end();)
+    {
+        auto constant = constants.find(it->first);
+        if (constant != constants.end() and constant->second.serial == it->second) ++it;
+        else
+        {
+            tp->p->RemoveConst(it->first);
+            it = tp->defined.erase(it);
+        }
+    }
+    for (const auto &pair : constants)
+    {
+        if (tp->defined.count(pair.first) != 0) continue;
+        if (tp->p->IsConstDefined(pair.first)) tp->p->RemoveConst(pair.first); //overrides a builtin
+        tp->p->DefineConst(pair.first, pair.second.value);
+        tp->defined[pair.first] = pair.second.serial;
+    }
+    tp->serial = serial;
+    return *tp;
 }
 
-void Pothos::Util::EvalEnvironment::registerConstantObj(const std::string &key, const Pothos::Object &obj)
+/***********************************************************************
+ * validate the names of constants for the parser
+ **********************************************************************/
+static bool isValidConstantName(const std::string &name)
 {
-    try
+    if (name.empty() or std::isdigit(name.front())) return false;
+    for (const auto ch : name)
     {
-        const auto result = objectToMupValue(obj);
-        this->unregisterConstant(key);
-        _impl->p.DefineConst(key, result);
+        if (not std::isalnum(ch) and ch != '_') return false;
     }
-    catch (const mup::ParserError &ex)
+    return true;
+}
+
+//! The nesting depth of evaluations that use temporary constants
+static thread_local size_t tmpDepth(0);
+
+/***********************************************************************
+ * list the identifiers of an expression outside of string literals
+ **********************************************************************/
+static std::vector<std::string> listExprIdentifiers(const std::string &expr)
+{
+    std::vector<std::string> names;
+    size_t i = 0;
+    while (i < expr.size())
     {
-        throw Pothos::Exception("EvalEnvironment::registerConstantObj("+key+")", ex.GetMsg());
+        const auto ch = expr[i];
+
+        //skip string literals and their escapes
+        if (ch == '"')
+        {
+            for (i++; i < expr.size() and expr[i] != '"'; i++)
+            {
+                if (expr[i] == '\\') i++;
+            }
+            i++;
+        }
+
+        //skip numbers and their suffixes like 1e3 and 0x1F
+        else if (std::isdigit(ch) or ch == '.')
+        {
+            while (i < expr.size() and (std::isalnum(expr[i]) or expr[i] == '.' or expr[i] == '_')) i++;
+        }
+
+        else if (std::isalpha(ch) or ch == '_')
+        {
+            const auto start = i;
+            while (i < expr.size() and (std::isalnum(expr[i]) or expr[i] == '_')) i++;
+            names.push_back(expr.substr(start, i-start));
+        }
+
+        else i++;
     }
+    return names;
+}
+
+std::shared_ptr<Pothos::Util::EvalEnvironment> Pothos::Util::EvalEnvironment::make(void)
+{
+    return std::shared_ptr<EvalEnvironment>(new EvalEnvironment());
+}
+
+Pothos::Util::EvalEnvironment::EvalEnvironment(void):
+    _impl(new Impl())
+{
+    return;
+}
+
+void Pothos::Util::EvalEnvironment::registerConstantExpr(const std::string &key, const std::string &expr)
+{
+    if (not isValidConstantName(key)) throw Pothos::Exception("EvalEnvironment::registerConstantExpr("+key+")", "invalid constant name");
+    Impl::Constant constant;
+    constant.value = objectToMupValue(this->eval(expr));
+    constant.deps = this->getReferencedConstants(expr);
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    _impl->changed();
+    constant.serial = _impl->serial;
+    _impl->constants[key] = constant;
+}
+
+void Pothos::Util::EvalEnvironment::registerConstantObj(const std::string &key, const Pothos::Object &obj)
+{
+    if (not isValidConstantName(key)) throw Pothos::Exception("EvalEnvironment::registerConstantObj("+key+")", "invalid constant name");
+    Impl::Constant constant;
+    constant.value = objectToMupValue(obj);
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    _impl->changed();
+    constant.serial = _impl->serial;
+    _impl->constants[key] = constant;
 }
 
 void Pothos::Util::EvalEnvironment::unregisterConstant(const std::string &key)
 {
-    if (_impl->p.IsConstDefined(key)) _impl->p.RemoveConst(key);
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    if (_impl->constants.erase(key) == 0) return;
+    _impl->changed();
+}
+
+std::vector<std::string> Pothos::Util::EvalEnvironment::getReferencedConstants(const std::string &expr) const
+{
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    std::vector<std::string> names;
+    std::set<std::string> uniques;
+    for (const auto &name : listExprIdentifiers(expr))
+    {
+        if (_impl->constants.count(name) == 0) continue;
+        if (uniques.insert(name).second) names.push_back(name);
+    }
+    return names;
+}
+
+std::vector<std::string> Pothos::Util::EvalEnvironment::getConstantDependencies(const std::string &key) const
+{
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    auto it = _impl->constants.find(key);
+    if (it == _impl->constants.end()) return std::vector<std::string>();
+    return it->second.deps;
 }
 
 Pothos::Object Pothos::Util::EvalEnvironment::eval(const std::string &expr)
 {
     if (Poco::trim(expr).empty()) throw Pothos::Exception("EvalEnvironment::eval()", "expression is empty");
 
-    //handle multiple containers in top level
+    //handle multiple containers in top level:
+    //the containers become temporary constants of this thread's parser,
+    //named by the nesting depth so that nested evaluations do not collide
     const auto tokens = EvalEnvironment::splitExpr(expr);
     if (tokens.size() > 1)
     {
+        struct DepthGuard
+        {
+            DepthGuard(void){tmpDepth++;}
+            ~DepthGuard(void){tmpDepth--;}
+        } depthGuard;
+        const auto depth = tmpDepth;
+
         size_t index = 0;
         std::string newExpr;
         for (const auto &tok : tokens)
@@ -211,8 +424,18 @@ Pothos::Object Pothos::Util::EvalEnvironment::eval(const std::string &expr)
             if (tok.empty()) continue;
             if (tok.front() == '[' or tok.front() == '{')
             {
-                const std::string key = tmpTypeId + std::to_string(index++);
-                this->registerConstantObj(key, this->eval(tok));
+                const std::string key = tmpTypeId + std::to_string(depth) + "_" + std::to_string(index++);
+                const auto value = objectToMupValue(this->eval(tok));
+                try
+                {
+                    auto &parser = *_impl->getThreadParser().p;
+                    if (parser.IsConstDefined(key)) parser.RemoveConst(key);
+                    parser.DefineConst(key, value);
+                }
+                catch (const mup::ParserError &ex)
+                {
+                    throw Pothos::Exception("EvalEnvironment::eval("+expr+")", ex.GetMsg());
+                }
                 newExpr += key;
             }
             else
@@ -231,13 +454,29 @@ Pothos::Object Pothos::Util::EvalEnvironment::eval(const std::string &expr)
     const auto inBraces = expr.size() >= 2 and expr.front() == '{' and expr.back() == '}';
     if (inBraces) return this->_evalMap(expr);
 
-    //use the muparser
+    //the results with temporary constants are specific to this evaluation
+    const bool cacheable = expr.find(tmpTypeId) == std::string::npos;
+    if (cacheable)
+    {
+        std::lock_guard<std::mutex> lock(_impl->mutex);
+        auto it = _impl->resultCache.find(expr);
+        if (it != _impl->resultCache.end()) return it->second;
+    }
+
+    //use the muparser of this thread
     try
     {
-        std::lock_guard<std::mutex> lock(_impl->parserMutex);
-        _impl->p.SetExpr(expr);
-        mup::Value result = _impl->p.Eval();
-        return mupValueToObject(result);
+        auto &tp = _impl->getThreadParser();
+        tp.p->SetExpr(expr);
+        mup::Value result = tp.p->Eval();
+        const auto obj = mupValueToObject(result);
+
+        //cache unless the constants changed during the evaluation
+        std::lock_guard<std::mutex> lock(_impl->mutex);
+        if (not cacheable or tp.serial != _impl->serial) return obj;
+        if (_impl->resultCache.size() >= 1024) _impl->resultCache.clear();
+        _impl->resultCache.emplace(expr, obj);
+        return obj;
     }
     catch (const mup::ParserError &ex)
     {
@@ -298,4 +537,6 @@ static auto managedEvalEnvironment = Pothos::ManagedClass()
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Util::EvalEnvironment, registerConstantExpr))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Util::EvalEnvironment, registerConstantObj))
     .registerMethod(POTHOS_FCN_TUPLE(Pothos::Util::EvalEnvironment, unregisterConstant))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Util::EvalEnvironment, getReferencedConstants))
+    .registerMethod(POTHOS_FCN_TUPLE(Pothos::Util::EvalEnvironment, getConstantDependencies))
     .commit("Pothos/Util/EvalEnvironment");
@@ -0,0 +1,92 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Util/QFormat.hpp>
+#include "Framework/BufferConvertSIMD.hpp"
+#include <limits>
+
+/***********************************************************************
+ * Scalar fallbacks when there is no vectorized kernel
+ **********************************************************************/
+template <typename OutType>
+static void floatToQScalar(const float *in, OutType *out, const size_t num, const float scale, const bool saturate)
+{
+    static const OutType minOut = std::numeric_limits<OutType>::min();
+    static const OutType maxOut = std::numeric_limits<OutType>::max();
+    for (size_t i = 0; i < num; i++)
+    {
+        const float x = in[i]*scale;
+        if (not saturate) out[i] = OutType((long long)(std::nearbyint(x)));
+        else if (x >= float(maxOut)) out[i] = maxOut;
+        else if (x <= float(minOut)) out[i] = minOut;
+        else if (x != x) out[i] = 0; //NaN
+        else out[i] = OutType(std::nearbyint(x));
+    }
+}
+
+template <typename InType>
+static void fromQScalar(const InType *in, float *out, const size_t num, const float scale)
+{
+    for (size_t i = 0; i < num; i++) out[i] = float(in[i])*scale;
+}
+
+/***********************************************************************
+ * Bulk conversions: complex types are twice the primitives
+ **********************************************************************/
+template <typename OutType>
+static void floatToQBulk(const float *in, OutType *out, const size_t num, const int n, const bool saturate)
+{
+    static const auto kernel = getSimdBufferConvertScaledRound(Pothos::DType::of<float>(), Pothos::DType::of<OutType>());
+    const double scale = std::ldexp(1.0, n);
+    if (kernel != nullptr) kernel(in, out, num, scale, saturate);
+    else floatToQScalar(in, out, num, float(scale), saturate);
+}
+
+template <typename InType>
+static void fromQBulk(const InType *in, float *out, const size_t num, const int n)
+{
+    static const auto kernel = getSimdBufferConvertScaled(Pothos::DType::of<InType>(), Pothos::DType::of<float>());
+    const double scale = std::ldexp(1.0, -n);
+    if (kernel != nullptr) kernel(in, out, num, scale, false);
+    else fromQScalar(in, out, num, float(scale));
+}
+
+void Pothos::Util::floatToQ(const float *in, int16_t *out, const size_t num, const int n, const bool saturate)
+{
+    floatToQBulk(in, out, num, n, saturate);
+}
+
+void Pothos::Util::floatToQ(const float *in, int32_t *out, const size_t num, const int n, const bool saturate)
+{
+    floatToQBulk(in, out, num, n, saturate);
+}
+
+void Pothos::Util::floatToQ(const std::complex<float> *in, std::complex<int16_t> *out, const size_t num, const int n, const bool saturate)
+{
+    floatToQBulk(reinterpret_cast<const float *>(in), reinterpret_cast<int16_t *>(out), num*2, n, saturate);
+}
+
+void Pothos::Util::floatToQ(const std::complex<float> *in, std::complex<int32_t> *out, const size_t num, const int n, const bool saturate)
+{
+    floatToQBulk(reinterpret_cast<const float *>(in), reinterpret_cast<int32_t *>(out), num*2, n, saturate);
+}
+
+void Pothos::Util::fromQ(const int16_t *in, float *out, const size_t num, const int n)
+{
+    fromQBulk(in, out, num, n);
+}
+
+void Pothos::Util::fromQ(const int32_t *in, float *out, const size_t num, const int n)
+{
+    fromQBulk(in, out, num, n);
+}
+
+void Pothos::Util::fromQ(const std::complex<int16_t> *in, std::complex<float> *out, const size_t num, const int n)
+{
+    fromQBulk(reinterpret_cast<const int16_t *>(in), reinterpret_cast<float *>(out), num*2, n);
+}
+
+void Pothos::Util::fromQ(const std::complex<int32_t> *in, std::complex<float> *out, const size_t num, const int n)
+{
+    fromQBulk(reinterpret_cast<const int32_t *>(in), reinterpret_cast<float *>(out), num*2, n);
+}
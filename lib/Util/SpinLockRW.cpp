@@ -0,0 +1,135 @@
+// Copyright (c) 2020-2020 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Util/SpinLockRW.hpp>
+#include <Pothos/Util/SpinLock.hpp> //spinPause
+#include <algorithm> //find/copy/min
+
+/***********************************************************************
+ * Per-thread state:
+ * The reader slot is assigned round robin as threads first use a lock.
+ * The held list records the shared locks of this thread for reentrance;
+ * deeper nesting than the list capacity is treated as a new reader.
+ **********************************************************************/
+static std::atomic<size_t> nextReaderSlot(0);
+
+struct HeldSharedLocks
+{
+    enum : size_t {CAPACITY = 16};
+    HeldSharedLocks(void):
+        slot(nextReaderSlot.fetch_add(1, std::memory_order_relaxed)),
+        depth(0)
+    {
+        return;
+    }
+    bool contains(const void *lock) const
+    {
+        const auto end = locks+std::min<size_t>(depth, CAPACITY);
+        return std::find(locks, end, lock) != end;
+    }
+    const size_t slot;
+    size_t depth;
+    const void *locks[CAPACITY];
+};
+
+static thread_local HeldSharedLocks heldSharedLocks;
+
+//! Spin with an exponential pause back-off, then yield
+static void spinWait(size_t &backoff)
+{
+    if (backoff > 64) return std::this_thread::yield();
+    for (size_t i = 0; i < backoff; i++) Pothos::Util::spinPause();
+    backoff *= 2;
+}
+
+/***********************************************************************
+ * SpinLockRW implementation
+ **********************************************************************/
+Pothos::Util::SpinLockRW::SpinLockRW(void):
+    _writer(false)
+{
+    for (auto &reader : _readers) reader.count.store(0);
+}
+
+bool Pothos::Util::SpinLockRW::readersDrained(void) const noexcept
+{
+    for (const auto &reader : _readers)
+    {
+        if (reader.count.load(std::memory_order_seq_cst) != 0) return false;
+    }
+    return true;
+}
+
+bool Pothos::Util::SpinLockRW::try_lock_shared(void) noexcept
+{
+    auto &held = heldSharedLocks;
+    auto &reader = _readers[held.slot % NUM_READER_SLOTS];
+
+    //a reentrant reader already keeps the writer out
+    const bool reentrant = held.contains(this);
+    if (not reentrant and _writer.load(std::memory_order_relaxed)) return false;
+
+    //count the reader, then check that a writer did not arrive meanwhile
+    reader.count.fetch_add(1, std::memory_order_seq_cst);
+    if (not reentrant and _writer.load(std::memory_order_seq_cst))
+    {
+        reader.count.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    if (held.depth < HeldSharedLocks::CAPACITY) held.locks[held.depth] = this;
+    held.depth++;
+    return true;
+}
+
+void Pothos::Util::SpinLockRW::lock_shared(void) noexcept
+{
+    size_t backoff(1);
+    while (not this->try_lock_shared()) spinWait(backoff);
+}
+
+void Pothos::Util::SpinLockRW::unlock_shared(void) noexcept
+{
+    auto &held = heldSharedLocks;
+    const size_t depth = held.depth--;
+
+    //remove the most recent record of this lock from the held list
+    if (depth <= HeldSharedLocks::CAPACITY) for (size_t i = depth; i-- > 0;)
+    {
+        if (held.locks[i] != this) continue;
+        std::copy(held.locks+i+1, held.locks+depth, held.locks+i);
+        break;
+    }
+
+    _readers[held.slot % NUM_READER_SLOTS].count.fetch_sub(1, std::memory_order_release);
+}
+
+bool Pothos::Util::SpinLockRW::try_lock(void) noexcept
+{
+    bool expected = false;
+    if (not _writer.compare_exchange_strong(expected, true, std::memory_order_seq_cst)) return false;
+    if (this->readersDrained()) return true;
+    _writer.store(false, std::memory_order_release);
+    return false;
+}
+
+void Pothos::Util::SpinLockRW::lock(void) noexcept
+{
+    //claim the writer flag first so that new readers wait
+    size_t backoff(1);
+    bool expected = false;
+    while (not _writer.compare_exchange_weak(expected, true, std::memory_order_seq_cst))
+    {
+        expected = false;
+        spinWait(backoff);
+    }
+
+    //then wait for the current readers to leave
+    backoff = 1;
+    while (not this->readersDrained()) spinWait(backoff);
+}
+
+void Pothos::Util::SpinLockRW::unlock(void) noexcept
+{
+    _writer.store(false, std::memory_order_release);
+}
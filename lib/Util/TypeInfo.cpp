@@ -1,7 +1,12 @@
-// Copyright (c) 2013-2016 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Util/TypeInfo.hpp>
+#include <Pothos/Util/SpinLockRW.hpp>
+#include <typeindex>
+#include <unordered_map>
+#include <mutex>
+#include <cstdlib> //free
 
 //demangle support for pretty strings
 #ifdef __GNUG__
@@ -9,7 +14,7 @@
 #define HAVE_CXA_DEMANGLE
 #endif
 
-std::string Pothos::Util::typeInfoToString(const std::type_info &type)
+static std::string demangleTypeInfo(const std::type_info &type)
 {
     //Since std::string is used a lot and often has a complicated template name,
     //we just enforce returning a simple display name for the std::string type.
@@ -17,11 +22,44 @@ std::string Pothos::Util::typeInfoToString(const std::type_info &type)
 
     const char *name = type.name();
     #ifdef HAVE_CXA_DEMANGLE
-    char buff[1024];
-    size_t size = 1024;
     int status = -1;
-    char* res = abi::__cxa_demangle(name, buff, &size, &status);
-    if (status == 0) return std::string(res);
+    char* res = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0)
+    {
+        const std::string result(res);
+        std::free(res);
+        return result;
+    }
     #endif
     return name;
 }
+
+/***********************************************************************
+ * The names are memoized per type, since introspection of large designs
+ * requests the same port and argument types over and over again
+ **********************************************************************/
+static Pothos::Util::SpinLockRW &getTypeNameMutex(void)
+{
+    static Pothos::Util::SpinLockRW lock;
+    return lock;
+}
+
+static std::unordered_map<std::type_index, std::string> &getTypeNameCache(void)
+{
+    static std::unordered_map<std::type_index, std::string> cache;
+    return cache;
+}
+
+std::string Pothos::Util::typeInfoToString(const std::type_info &type)
+{
+    const std::type_index index(type);
+    {
+        Pothos::Util::SpinLockRW::SharedLock lock(getTypeNameMutex());
+        auto it = getTypeNameCache().find(index);
+        if (it != getTypeNameCache().end()) return it->second;
+    }
+
+    auto name = demangleTypeInfo(type);
+    std::lock_guard<Pothos::Util::SpinLockRW> lock(getTypeNameMutex());
+    return getTypeNameCache().emplace(index, std::move(name)).first->second;
+}
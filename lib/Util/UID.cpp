@@ -1,4 +1,4 @@
-// Copyright (c) 2014 Josh Blum
+// Copyright (c) 2014-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Util/UID.hpp>
@@ -7,16 +7,24 @@
 #include <Poco/Process.h>
 #include <Poco/Format.h>
 #include <atomic>
+#include <string>
 
 static std::atomic<unsigned long long> count;
 
-Pothos::Util::UID::UID(void):
-    _uid(Poco::URI("pothos", Poco::Environment::nodeName(), Poco::format(
-        "%s/%s/%s",
+//the host and process part of the uid is constant for the process,
+//so the node lookups and the URI formatting only happen once
+static const std::string &getUIDPrefix(void)
+{
+    static const std::string prefix(Poco::URI("pothos", Poco::Environment::nodeName(), Poco::format(
+        "%s/%s/",
         Poco::Environment::nodeId(),
-        std::to_string(Poco::Process::id()),
-        std::to_string(count.fetch_add(1, std::memory_order_relaxed))
-    )).toString())
+        std::to_string(Poco::Process::id())
+    )).toString());
+    return prefix;
+}
+
+Pothos::Util::UID::UID(void):
+    _uid(getUIDPrefix() + std::to_string(count.fetch_add(1, std::memory_order_relaxed)))
 {
     return;
 }
@@ -1,4 +1,4 @@
-// Copyright (c) 2013-2015 Josh Blum
+// Copyright (c) 2013-2020 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
 #include <Pothos/Config.hpp>
@@ -18,6 +18,18 @@ static FARPROC GetKernelProcAddress(LPCSTR lpProcName)
     return r;
 }
 
+/***********************************************************************
+ * delay load the kernelbase library
+ * newer memory APIs are only in kernelbase,
+ * a missing symbol is expected on older systems
+ **********************************************************************/
+static FARPROC GetKernelBaseProcAddress(LPCSTR lpProcName)
+{
+    static HMODULE hKernelBase = LoadLibrary("kernelbase.dll");
+    if (not hKernelBase) return nullptr;
+    return GetProcAddress(hKernelBase, lpProcName);
+}
+
 /***********************************************************************
  * set error mode with non-thread safe backup
  **********************************************************************/
@@ -79,6 +91,34 @@ LPVOID DL_MapViewOfFileExNuma(HANDLE hFileMappingObject, DWORD dwDesiredAccess,
     return fcn(hFileMappingObject, dwDesiredAccess, dwFileOffsetHigh, dwFileOffsetLow, dwNumberOfBytesToMap, lpBaseAddress, nndPreferred);
 }
 
+/***********************************************************************
+ * placeholder allocation -- null with ERROR_CALL_NOT_IMPLEMENTED when unsupported
+ * the extended parameters are not used, so they are passed as opaque pointers
+ **********************************************************************/
+PVOID DL_VirtualAlloc2(HANDLE Process, PVOID BaseAddress, SIZE_T Size, ULONG AllocationType, ULONG PageProtection)
+{
+    typedef PVOID (WINAPI * VirtualAlloc2_t)(HANDLE, PVOID, SIZE_T, ULONG, ULONG, PVOID, ULONG);
+    static auto fcn = (VirtualAlloc2_t)GetKernelBaseProcAddress("VirtualAlloc2");
+    if (not fcn)
+    {
+        SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
+        return nullptr;
+    }
+    return fcn(Process, BaseAddress, Size, AllocationType, PageProtection, nullptr, 0);
+}
+
+PVOID DL_MapViewOfFile3(HANDLE FileMapping, HANDLE Process, PVOID BaseAddress, ULONG64 Offset, SIZE_T ViewSize, ULONG AllocationType, ULONG PageProtection)
+{
+    typedef PVOID (WINAPI * MapViewOfFile3_t)(HANDLE, HANDLE, PVOID, ULONG64, SIZE_T, ULONG, ULONG, PVOID, ULONG);
+    static auto fcn = (MapViewOfFile3_t)GetKernelBaseProcAddress("MapViewOfFile3");
+    if (not fcn)
+    {
+        SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
+        return nullptr;
+    }
+    return fcn(FileMapping, Process, BaseAddress, Offset, ViewSize, AllocationType, PageProtection, nullptr, 0);
+}
+
 /***********************************************************************
  * get processor information
  **********************************************************************/